@@ -8,12 +8,14 @@ endif
 SPVTOOLS_SRC_FILES := \
 		source/assembly_grammar.cpp \
 		source/binary.cpp \
+		source/compressed_binary.cpp \
 		source/diagnostic.cpp \
 		source/disassemble.cpp \
 		source/ext_inst.cpp \
 		source/enum_string_mapping.cpp \
 		source/extensions.cpp \
 		source/libspirv.cpp \
+		source/module_reflection.cpp \
 		source/name_mapper.cpp \
 		source/opcode.cpp \
 		source/operand.cpp \
@@ -23,16 +25,20 @@ SPVTOOLS_SRC_FILES := \
 		source/spirv_endian.cpp \
 		source/spirv_optimizer_options.cpp \
 		source/spirv_target_env.cpp \
+		source/spirv_validation_cache.cpp \
 		source/spirv_validator_options.cpp \
 		source/table.cpp \
 		source/text.cpp \
 		source/text_handler.cpp \
 		source/util/bit_vector.cpp \
+		source/util/interestingness_cache.cpp \
+		source/util/parallel.cpp \
 		source/util/parse_number.cpp \
 		source/util/string_utils.cpp \
 		source/util/timer.cpp \
 		source/val/basic_block.cpp \
 		source/val/construct.cpp \
+		source/val/decoration_index.cpp \
 		source/val/function.cpp \
 		source/val/instruction.cpp \
 		source/val/validation_state.cpp \
@@ -79,9 +85,12 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/block_merge_pass.cpp \
 		source/opt/block_merge_util.cpp \
 		source/opt/build_module.cpp \
+		source/opt/call_graph.cpp \
+		source/opt/canonical_layout_pass.cpp \
 		source/opt/cfg.cpp \
 		source/opt/cfg_cleanup_pass.cpp \
 		source/opt/ccp_pass.cpp \
+		source/opt/cfg_snapshot.cpp \
 		source/opt/code_sink.cpp \
 		source/opt/combine_access_chains.cpp \
 		source/opt/compact_ids_pass.cpp \
@@ -92,7 +101,9 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/copy_prop_arrays.cpp \
 		source/opt/dead_branch_elim_pass.cpp \
 		source/opt/dead_insert_elim_pass.cpp \
+		source/opt/dead_store_elim_pass.cpp \
 		source/opt/dead_variable_elimination.cpp \
+		source/opt/debug_line_table.cpp \
 		source/opt/decompose_initialized_variables_pass.cpp \
 		source/opt/decoration_manager.cpp \
 		source/opt/debug_info_manager.cpp \
@@ -106,26 +117,34 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/eliminate_dead_members_pass.cpp \
 		source/opt/feature_manager.cpp \
 		source/opt/fix_storage_class.cpp \
+		source/opt/fixed_point_pass.cpp \
 		source/opt/flatten_decoration_pass.cpp \
 		source/opt/fold.cpp \
 		source/opt/folding_rules.cpp \
 		source/opt/fold_spec_constant_op_and_composite_pass.cpp \
 		source/opt/freeze_spec_constant_value_pass.cpp \
 		source/opt/function.cpp \
+		source/opt/function_pipeline_pass.cpp \
+		source/opt/function_result_cache.cpp \
 		source/opt/generate_webgpu_initializers_pass.cpp \
 		source/opt/graphics_robust_access_pass.cpp \
 		source/opt/if_conversion.cpp \
 		source/opt/inline_pass.cpp \
 		source/opt/inline_exhaustive_pass.cpp \
 		source/opt/inline_opaque_pass.cpp \
+		source/opt/inline_selective_pass.cpp \
 		source/opt/inst_bindless_check_pass.cpp \
+		source/opt/inst_block_profile_pass.cpp \
 		source/opt/inst_buff_addr_check_pass.cpp \
 		source/opt/inst_debug_printf_pass.cpp \
 		source/opt/instruction.cpp \
+		source/opt/instruction_arena.cpp \
 		source/opt/instruction_list.cpp \
+		source/opt/instruction_scheduling_pass.cpp \
 		source/opt/instrument_pass.cpp \
 		source/opt/ir_context.cpp \
 		source/opt/ir_loader.cpp \
+                source/opt/jump_threading_pass.cpp \
                 source/opt/legalize_vector_shuffle_pass.cpp \
 		source/opt/licm_pass.cpp \
 		source/opt/local_access_chain_convert_pass.cpp \
@@ -143,9 +162,11 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/loop_unswitch_pass.cpp \
 		source/opt/loop_utils.cpp \
 		source/opt/mem_pass.cpp \
+		source/opt/memory_ssa.cpp \
 		source/opt/merge_return_pass.cpp \
 		source/opt/module.cpp \
 		source/opt/optimizer.cpp \
+		source/opt/partial_redundancy_elimination.cpp \
 		source/opt/pass.cpp \
 		source/opt/pass_manager.cpp \
 		source/opt/private_to_local_pass.cpp \
@@ -153,6 +174,7 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/propagator.cpp \
 		source/opt/reduce_load_size.cpp \
 		source/opt/redundancy_elimination.cpp \
+		source/opt/reflection_analysis.cpp \
 		source/opt/register_pressure.cpp \
 		source/opt/relax_float_ops_pass.cpp \
 		source/opt/remove_duplicates_pass.cpp \
@@ -160,8 +182,11 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/scalar_analysis.cpp \
 		source/opt/scalar_analysis_simplification.cpp \
 		source/opt/scalar_replacement_pass.cpp \
+		source/opt/service.cpp \
 		source/opt/set_spec_constant_default_value_pass.cpp \
+		source/opt/shader_stats.cpp \
 		source/opt/simplification_pass.cpp \
+		source/opt/slp_vectorize_pass.cpp \
 		source/opt/split_invalid_unreachable_pass.cpp \
 		source/opt/ssa_rewrite_pass.cpp \
 		source/opt/strength_reduction_pass.cpp \
@@ -174,6 +199,7 @@ SPVTOOLS_OPT_SRC_FILES := \
 		source/opt/unify_const_pass.cpp \
 		source/opt/upgrade_memory_model.cpp \
 		source/opt/value_number_table.cpp \
+		source/opt/value_range_analysis.cpp \
 		source/opt/vector_dce.cpp \
 		source/opt/workaround1209.cpp \
 		source/opt/wrap_opkill.cpp
@@ -200,6 +200,13 @@ static const int kDebugInputBindingBuffAddr = 2;
 // This is the output buffer written by InstDebugPrintfPass.
 static const int kDebugOutputPrintfStream = 3;
 
+// This is the output buffer written by InstBlockProfilePass.  It has the same
+// layout as the other output buffers, but the element of Data[] at index i
+// counts the executions of the i-th block of the module, numbering the blocks
+// of all functions in the order they appear in the module.  The size member
+// is not written.
+static const int kDebugOutputBindingBlockProfile = 4;
+
 // Bindless Validation Input Buffer Format
 //
 // An input buffer for bindless validation consists of a single array of
@@ -76,6 +76,10 @@ typedef enum spv_result_t {
   SPV_ERROR_INVALID_DATA = -14,  // Indicates data rules validation failure.
   SPV_ERROR_MISSING_EXTENSION = -15,
   SPV_ERROR_WRONG_VERSION = -16,  // Indicates wrong SPIR-V version
+  // Indicates that the module exceeds the budget of the validator options.
+  SPV_ERROR_BUDGET_EXCEEDED = -17,
+  // Indicates that the cancellation function of the options stopped the work.
+  SPV_ERROR_CANCELLED = -18,
   SPV_FORCE_32_BIT_ENUM(spv_result_t)
 } spv_result_t;
 
@@ -385,6 +389,11 @@ typedef struct spv_binary_t {
   size_t wordCount;
 } spv_binary_t;
 
+typedef struct spv_compressed_binary_t {
+  uint8_t* data;
+  size_t size;
+} spv_compressed_binary_t;
+
 typedef struct spv_text_t {
   const char* str;
   size_t length;
@@ -414,10 +423,24 @@ typedef struct spv_reducer_options_t spv_reducer_options_t;
 
 typedef struct spv_fuzzer_options_t spv_fuzzer_options_t;
 
+typedef struct spv_validation_cache_t spv_validation_cache_t;
+
+// Hooks that allocate the binaries, texts and diagnostics the library returns.
+// |allocate| returns |size| bytes suitably aligned for any object, or null if
+// it cannot allocate them.  |deallocate| releases memory returned by
+// |allocate|.  Both are given |user_data|, and may be called from several
+// threads at the same time.
+typedef struct spv_allocator_t {
+  void* (*allocate)(void* user_data, size_t size);
+  void (*deallocate)(void* user_data, void* memory);
+  void* user_data;
+} spv_allocator_t;
+
 // Type Definitions
 
 typedef spv_const_binary_t* spv_const_binary;
 typedef spv_binary_t* spv_binary;
+typedef spv_compressed_binary_t* spv_compressed_binary;
 typedef spv_text_t* spv_text;
 typedef spv_position_t* spv_position;
 typedef spv_diagnostic_t* spv_diagnostic;
@@ -431,6 +454,47 @@ typedef spv_reducer_options_t* spv_reducer_options;
 typedef const spv_reducer_options_t* spv_const_reducer_options;
 typedef spv_fuzzer_options_t* spv_fuzzer_options;
 typedef const spv_fuzzer_options_t* spv_const_fuzzer_options;
+typedef spv_validation_cache_t* spv_validation_cache;
+
+// Returns true if the module identified by the null-terminated string |key|
+// is known to be valid.  |user_data| is the pointer given with the function to
+// spvValidationCacheSetBackend.
+typedef bool (*spv_validation_cache_lookup_fn)(void* user_data,
+                                               const char* key);
+
+// Records that the module identified by the null-terminated string |key| is
+// valid.  |user_data| is the pointer given with the function to
+// spvValidationCacheSetBackend.
+typedef void (*spv_validation_cache_store_fn)(void* user_data,
+                                              const char* key);
+
+// Receives the wall time in |seconds| of the stage of the validation named by
+// the null-terminated string |stage|, and the number of instructions it
+// checked.  |user_data| is the pointer given with the function to
+// spvValidatorOptionsSetStageReport.
+typedef void (*spv_validator_stage_report_fn)(void* user_data,
+                                              const char* stage,
+                                              double seconds,
+                                              size_t num_instructions);
+
+// Returns true if the validation, optimization or reduction that calls it
+// should stop as soon as possible, for example because its result is no longer
+// needed or its deadline has passed.  |user_data| is the pointer given with
+// the function.  It may be called from several threads at the same time.
+typedef bool (*spv_cancel_fn)(void* user_data);
+
+// A piece of work handed to an executor, to be called with |task_data|.
+typedef void (*spv_task_fn)(void* task_data);
+
+// Runs |task| with |task_data| exactly once, on any thread and before or after
+// returning, for example by queuing it in the thread pool of the embedding
+// application.  The tools use it to spread their work over threads instead of
+// starting threads of their own, and never wait for a task that has not
+// started, so the tasks may be queued behind work that waits for the tools.
+// |user_data| is the pointer given with the function.  It may be called from
+// several threads at the same time.
+typedef void (*spv_executor_fn)(void* user_data, spv_task_fn task,
+                                void* task_data);
 
 // Platform API
 
@@ -502,8 +566,31 @@ typedef enum {
   spv_validator_limit_max_control_flow_nesting_depth,
   spv_validator_limit_max_access_chain_indexes,
   spv_validator_limit_max_id_bound,
+  // The following limits are not limits of the SPIR-V specification, but a
+  // budget for validating untrusted modules.  They are checked before the
+  // module is parsed, and a module that exceeds one of them fails with
+  // SPV_ERROR_BUDGET_EXCEEDED.  None of them is limited by default.
+  spv_validator_limit_max_instructions,
+  spv_validator_limit_max_function_blocks,
+  // An estimate of the memory the validator needs for the instructions and
+  // ids of the module, in KiB.
+  spv_validator_limit_max_memory_kib,
 } spv_validator_limit;
 
+// The sets of checks the SPIR-V Validator can run.
+typedef enum {
+  // All the checks of the validator.
+  spv_validator_profile_full,
+  // Only the checks needed to safely process a module with the other tools or
+  // hand it to a driver: the binary and module layout, the definition and use
+  // of ids, the types and constants, the functions and function calls, the
+  // control flow graph, and the dominance of definitions over their uses.
+  // The checks of the individual instructions of the other sections of the
+  // specification, of decorations, block layouts, interfaces, built-ins and
+  // execution model limitations are skipped.
+  spv_validator_profile_structural,
+} spv_validator_profile;
+
 // Returns a string describing the given SPIR-V target environment.
 SPIRV_TOOLS_EXPORT const char* spvTargetEnvDescription(spv_target_env env);
 
@@ -511,6 +598,12 @@ SPIRV_TOOLS_EXPORT const char* spvTargetEnvDescription(spv_target_env env);
 // false and sets *env to SPV_ENV_UNIVERSAL_1_0.
 SPIRV_TOOLS_EXPORT bool spvParseTargetEnv(const char* s, spv_target_env* env);
 
+// Parses the name of a validator profile, "full" or "structural", in s into
+// *profile and returns true if successful.  If unparsable, returns false and
+// sets *profile to spv_validator_profile_full.
+SPIRV_TOOLS_EXPORT bool spvParseValidatorProfile(
+    const char* s, spv_validator_profile* profile);
+
 // Determines the target env value with the least features but which enables
 // the given Vulkan and SPIR-V versions. If such a target is supported, returns
 // true and writes the value to |env|, otherwise returns false.
@@ -534,6 +627,14 @@ SPIRV_TOOLS_EXPORT spv_context spvContextCreate(spv_target_env env);
 // Destroys the given context object.
 SPIRV_TOOLS_EXPORT void spvContextDestroy(spv_context context);
 
+// Makes the functions given |context| allocate the binaries, texts and
+// diagnostics they return with the hooks of |allocator|, or with the global
+// heap if |allocator| is null.  Those objects must then be released with
+// spvBinaryDestroyWithContext, spvTextDestroyWithContext and
+// spvDiagnosticDestroyWithContext, given a context with the same allocator.
+SPIRV_TOOLS_EXPORT void spvContextSetAllocator(
+    spv_context context, const spv_allocator_t* allocator);
+
 // Creates a Validator options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // spvValidatorOptionsDestroy.
@@ -624,6 +725,69 @@ SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetScalarBlockLayout(
 SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetSkipBlockLayout(
     spv_validator_options options, bool val);
 
+// Records the maximum number of threads the validator may use to check the
+// bodies of the functions of a module.  A value of 0 or 1 checks them on the
+// calling thread.  The diagnostics are the same for any number of threads.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetNumThreads(
+    spv_validator_options options, uint32_t num_threads);
+
+// Records the set of checks the validator should run.  The default is
+// spv_validator_profile_full.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetProfile(
+    spv_validator_options options, spv_validator_profile profile);
+
+// Records the function the validator calls after each stage of the
+// validation of a module, or null to call none.  The stages are reported in
+// the order they run, up to the one that finds the module invalid.  The checks
+// of the individual instructions are reported as one stage per group of
+// opcodes, whose time is summed over the threads checking the instructions.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetStageReport(
+    spv_validator_options options, spv_validator_stage_report_fn report,
+    void* user_data);
+
+// Records the cache of valid modules the validator should use, or null to use
+// none.  Validating a module with these options returns SPV_SUCCESS at once,
+// without any diagnostic, when the cache knows that the module is valid for the
+// same target environment and options.  Otherwise the module is validated, and
+// added to the cache if it is valid.  The cache must outlive its use by the
+// options.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetCache(
+    spv_validator_options options, spv_validation_cache cache);
+
+// Records the function the validator calls between stages and between
+// batches of instructions to know whether to stop, or null to call none.  A
+// validation that is stopped returns SPV_ERROR_CANCELLED.  |user_data| is
+// given to the function.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetCancel(
+    spv_validator_options options, spv_cancel_fn cancel, void* user_data);
+
+// Records the executor on whose tasks the validator checks the functions of
+// the module when it uses several threads, or null to start its own threads.
+// See spvValidatorOptionsSetNumThreads.  |user_data| is given to the executor.
+SPIRV_TOOLS_EXPORT void spvValidatorOptionsSetExecutor(
+    spv_validator_options options, spv_executor_fn executor, void* user_data);
+
+// Creates a cache of valid modules that keeps up to |capacity| of the most
+// recently used modules in memory.  Only the keys identifying the modules are
+// kept, not the modules.  The key of a module is a hash of its words, the
+// target environment and the validator options.  The hash is not
+// cryptographic, so the cache should only hold modules from trusted
+// producers.  The cache may be used from several threads at the same time.
+// The object remains valid until it is passed into spvValidationCacheDestroy.
+SPIRV_TOOLS_EXPORT spv_validation_cache spvValidationCacheCreate(
+    size_t capacity);
+
+// Destroys the given cache of valid modules.
+SPIRV_TOOLS_EXPORT void spvValidationCacheDestroy(spv_validation_cache cache);
+
+// Sets the persistent store the cache falls back to for modules that are not
+// in memory.  |lookup| is called for such modules, and |store| is called for
+// every module added to the cache.  Both receive |user_data|, and may be
+// called from several threads at the same time.  Either may be null.
+SPIRV_TOOLS_EXPORT void spvValidationCacheSetBackend(
+    spv_validation_cache cache, void* user_data,
+    spv_validation_cache_lookup_fn lookup, spv_validation_cache_store_fn store);
+
 // Creates an optimizer options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // |spvOptimizerOptionsDestroy|.
@@ -656,6 +820,21 @@ SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetPreserveBindings(
 SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetPreserveSpecConstants(
     spv_optimizer_options options, bool val);
 
+// Records whether the instructions of the module should be allocated from an
+// arena owned by the optimizer's IR context.  This makes building and
+// destroying the in-memory representation of a module cheaper.
+SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetUseInstructionArena(
+    spv_optimizer_options options, bool val);
+
+// Records the function the optimizer calls before each pass and before each
+// function a pass processes to know whether to stop, or null to call none.
+// An optimization that is stopped fails, with an error message saying it was
+// cancelled.  The function is also used by the validation that runs before the
+// optimization, unless the validator options have one of their own.
+// |user_data| is given to the function.
+SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetCancel(
+    spv_optimizer_options options, spv_cancel_fn cancel, void* user_data);
+
 // Creates a reducer options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // |spvReducerOptionsDestroy|.
@@ -683,6 +862,29 @@ SPIRV_TOOLS_EXPORT void spvReducerOptionsSetFailOnValidationError(
 SPIRV_TOOLS_EXPORT void spvReducerOptionsSetTargetFunction(
     spv_reducer_options options, uint32_t target_function);
 
+// Sets the structured construct that the reducer should target.  If set to
+// zero, no particular construct is targeted.  Otherwise |target_construct| is
+// the id of a block that heads a structured selection or loop in the target
+// function, or in some function if no target function is set, and reduction
+// passes that operate on blocks only consider blocks in that construct.  Other
+// passes remain restricted to the function containing the construct.
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetTargetConstruct(
+    spv_reducer_options options, uint32_t target_construct);
+
+// Sets the number of reduction candidates that the reducer should evaluate
+// concurrently.  If |num_jobs| is greater than one, the interestingness
+// function may be invoked from several threads at once and must therefore be
+// thread-safe.  The result of reduction does not depend on |num_jobs|.
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetNumJobs(
+    spv_reducer_options options, uint32_t num_jobs);
+
+// Records the function the reducer calls before each reduction step to know
+// whether to stop, or null to call none.  A reduction that is stopped returns
+// kCancelled, with the smallest interesting module found so far.  |user_data|
+// is given to the function.
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetCancel(
+    spv_reducer_options options, spv_cancel_fn cancel, void* user_data);
+
 // Creates a fuzzer options object with default options. Returns a valid
 // options object. The object remains valid until it is passed into
 // |spvFuzzerOptionsDestroy|.
@@ -712,6 +914,14 @@ SPIRV_TOOLS_EXPORT void spvFuzzerOptionsSetReplayRange(
 SPIRV_TOOLS_EXPORT void spvFuzzerOptionsSetShrinkerStepLimit(
     spv_fuzzer_options options, uint32_t shrinker_step_limit);
 
+// Sets the number of shrink attempts that the shrinker should evaluate
+// concurrently.  If |shrinker_num_jobs| is greater than one, the
+// interestingness function may be invoked from several threads at once and
+// must therefore be thread-safe.  The result of shrinking does not depend on
+// |shrinker_num_jobs|.
+SPIRV_TOOLS_EXPORT void spvFuzzerOptionsSetShrinkerNumJobs(
+    spv_fuzzer_options options, uint32_t shrinker_num_jobs);
+
 // Enables running the validator after every pass is applied during a fuzzing
 // run.
 SPIRV_TOOLS_EXPORT void spvFuzzerOptionsEnableFuzzerPassValidation(
@@ -742,10 +952,26 @@ SPIRV_TOOLS_EXPORT spv_result_t spvTextToBinaryWithOptions(
     const spv_const_context context, const char* text, const size_t length,
     const uint32_t options, spv_binary* binary, spv_diagnostic* diagnostic);
 
+// Like spvTextToBinaryWithOptions, but assembles the functions of the module
+// on up to num_threads threads.  The binary is the same as the one from
+// spvTextToBinaryWithOptions, and so are the ids, also with
+// SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS.  The module is assembled
+// serially if num_threads is at most 1, and if the text is invalid, so that
+// the same diagnostic is reported.
+SPIRV_TOOLS_EXPORT spv_result_t spvTextToBinaryParallel(
+    const spv_const_context context, const char* text, const size_t length,
+    const uint32_t options, const uint32_t num_threads, spv_binary* binary,
+    spv_diagnostic* diagnostic);
+
 // Frees an allocated text stream. This is a no-op if the text parameter
 // is a null pointer.
 SPIRV_TOOLS_EXPORT void spvTextDestroy(spv_text text);
 
+// Same as spvTextDestroy, for a text stream allocated with the allocator of
+// |context|.  See spvContextSetAllocator.
+SPIRV_TOOLS_EXPORT void spvTextDestroyWithContext(
+    const spv_const_context context, spv_text text);
+
 // Decodes the given SPIR-V binary representation to its assembly text. The
 // word_count parameter specifies the number of words for binary. The options
 // parameter is a bit field of spv_binary_to_text_options_t. Decoded text will
@@ -759,10 +985,52 @@ SPIRV_TOOLS_EXPORT spv_result_t spvBinaryToText(const spv_const_context context,
                                                 spv_text* text,
                                                 spv_diagnostic* diagnostic);
 
+// Like spvBinaryToText, but disassembles the functions of the module on up to
+// num_threads threads.  The decoded text is the same as the one from
+// spvBinaryToText.  The module is disassembled serially if num_threads is at
+// most 1, or if the options include SPV_BINARY_TO_TEXT_OPTION_PRINT or
+// SPV_BINARY_TO_TEXT_OPTION_COMMENT.
+SPIRV_TOOLS_EXPORT spv_result_t spvBinaryToTextParallel(
+    const spv_const_context context, const uint32_t* binary,
+    const size_t word_count, const uint32_t options, const uint32_t num_threads,
+    spv_text* text, spv_diagnostic* diagnostic);
+
 // Frees a binary stream from memory. This is a no-op if binary is a null
 // pointer.
 SPIRV_TOOLS_EXPORT void spvBinaryDestroy(spv_binary binary);
 
+// Same as spvBinaryDestroy, for a binary stream allocated with the allocator
+// of |context|.  See spvContextSetAllocator.
+SPIRV_TOOLS_EXPORT void spvBinaryDestroyWithContext(
+    const spv_const_context context, spv_binary binary);
+
+// Encodes the given SPIR-V binary, of word_count words in host endianness,
+// into a compact form for storage and transfer.  The module is not validated,
+// and is restored word for word by spvBinaryDecompress, given a library built
+// from the same SPIR-V grammar.  The compressed module is stored into
+// *compressed, which must be released with spvCompressedBinaryDestroy.  Any
+// error will be written into *diagnostic if diagnostic is non-null, otherwise
+// the context's message consumer will be used.
+SPIRV_TOOLS_EXPORT spv_result_t spvBinaryCompress(
+    const spv_const_context context, const uint32_t* binary,
+    const size_t word_count, spv_compressed_binary* compressed,
+    spv_diagnostic* diagnostic);
+
+// Decodes the size bytes at data, as written by spvBinaryCompress, into
+// *binary, which is allocated with the allocator of the context.  Fails if
+// the data is corrupt, or was compressed by a library built from a different
+// SPIR-V grammar.  Any error will be written into *diagnostic if diagnostic is
+// non-null, otherwise the context's message consumer will be used.
+SPIRV_TOOLS_EXPORT spv_result_t spvBinaryDecompress(
+    const spv_const_context context, const uint8_t* data, const size_t size,
+    spv_binary* binary, spv_diagnostic* diagnostic);
+
+// Frees a compressed binary returned by spvBinaryCompress for a context with
+// the same allocator as |context|.  This is a no-op if compressed is a null
+// pointer.
+SPIRV_TOOLS_EXPORT void spvCompressedBinaryDestroy(
+    const spv_const_context context, spv_compressed_binary compressed);
+
 // Validates a SPIR-V binary for correctness. Any errors will be written into
 // *diagnostic if diagnostic is non-null, otherwise the context's message
 // consumer will be used.
@@ -806,6 +1074,11 @@ spvDiagnosticCreate(const spv_position position, const char* message);
 // pointer.
 SPIRV_TOOLS_EXPORT void spvDiagnosticDestroy(spv_diagnostic diagnostic);
 
+// Same as spvDiagnosticDestroy, for a diagnostic object allocated with the
+// allocator of |context|.  See spvContextSetAllocator.
+SPIRV_TOOLS_EXPORT void spvDiagnosticDestroyWithContext(
+    const spv_const_context context, spv_diagnostic diagnostic);
+
 // Prints the diagnostic to stderr.
 SPIRV_TOOLS_EXPORT spv_result_t
 spvDiagnosticPrint(const spv_diagnostic diagnostic);
@@ -15,7 +15,13 @@
 #ifndef INCLUDE_SPIRV_TOOLS_LIBSPIRV_HPP_
 #define INCLUDE_SPIRV_TOOLS_LIBSPIRV_HPP_
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
+#include <future>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
 #include <vector>
@@ -59,6 +65,11 @@ class Context {
   // invoked once for each message communicated from the library.
   void SetMessageConsumer(MessageConsumer consumer);
 
+  // Makes the objects that the C API returns for this context be allocated
+  // with |allocator|, or with the global heap if |allocator| is null.  See
+  // spvContextSetAllocator.
+  void SetAllocator(const spv_allocator_t* allocator);
+
   // Returns the underlying spv_context.
   spv_context& CContext();
   const spv_context& CContext() const;
@@ -67,6 +78,115 @@ class Context {
   spv_context context_;
 };
 
+// A C++ wrapper around a cache of valid modules.  See
+// spvValidationCacheCreate.
+class ValidationCache {
+ public:
+  // A persistent store of the keys of valid modules.  Its methods may be
+  // called from several threads at the same time.
+  class Backend {
+   public:
+    virtual ~Backend() = default;
+
+    // Returns true if the module identified by |key| is known to be valid.
+    virtual bool Contains(const std::string& key) = 0;
+
+    // Records that the module identified by |key| is valid.
+    virtual void Insert(const std::string& key) = 0;
+  };
+
+  // Creates a cache that keeps up to |capacity| keys in memory.
+  explicit ValidationCache(size_t capacity)
+      : cache_(spvValidationCacheCreate(capacity)) {}
+  ~ValidationCache() { spvValidationCacheDestroy(cache_); }
+
+  ValidationCache(const ValidationCache&) = delete;
+  ValidationCache& operator=(const ValidationCache&) = delete;
+
+  // Allow implicit conversion to the underlying object.
+  operator spv_validation_cache() const { return cache_; }
+
+  // Makes the cache fall back to |backend| for the modules that are not in
+  // memory, or to no backend if |backend| is null.  The backend must outlive
+  // its use by the cache.
+  void SetBackend(Backend* backend) {
+    if (backend) {
+      spvValidationCacheSetBackend(cache_, backend, &BackendContains,
+                                   &BackendInsert);
+    } else {
+      spvValidationCacheSetBackend(cache_, nullptr, nullptr, nullptr);
+    }
+  }
+
+ private:
+  static bool BackendContains(void* backend, const char* key) {
+    return static_cast<Backend*>(backend)->Contains(key);
+  }
+  static void BackendInsert(void* backend, const char* key) {
+    static_cast<Backend*>(backend)->Insert(key);
+  }
+
+  spv_validation_cache cache_;
+};
+
+// Stops the validations, optimizations and reductions whose options it is
+// given to soon after |Cancel| is called, from any thread, or after its
+// deadline passes.  It must outlive that work.
+class Cancellation {
+ public:
+  Cancellation()
+      : cancelled_(false),
+        deadline_(std::numeric_limits<std::chrono::steady_clock::rep>::max()) {
+  }
+  Cancellation(const Cancellation&) = delete;
+  Cancellation& operator=(const Cancellation&) = delete;
+
+  // Requests the work to stop.
+  void Cancel() { cancelled_ = true; }
+
+  // Requests the work to stop once |deadline| has passed.
+  void SetDeadline(std::chrono::steady_clock::time_point deadline) {
+    deadline_ = deadline.time_since_epoch().count();
+  }
+
+  // Returns true if the work should stop.
+  bool IsCancelled() const {
+    return cancelled_ ||
+           std::chrono::steady_clock::now().time_since_epoch().count() >=
+               deadline_;
+  }
+
+  // The cancellation function of the options, whose user data is a
+  // |Cancellation|.
+  static bool Poll(void* cancellation) {
+    return static_cast<const Cancellation*>(cancellation)->IsCancelled();
+  }
+
+ private:
+  std::atomic<bool> cancelled_;
+  std::atomic<std::chrono::steady_clock::rep> deadline_;
+};
+
+// Runs the work that the tools would otherwise start threads for, such as
+// checking or optimizing functions in parallel and the asynchronous calls, on
+// the threads of the embedding application.  It must outlive that work.
+class Executor {
+ public:
+  virtual ~Executor() = default;
+
+  // Runs |task| exactly once, on any thread and before or after returning.
+  // The tools never wait for a task that has not started, so |task| may be
+  // queued behind work that waits for the tools.  It may be called from
+  // several threads at the same time.
+  virtual void Execute(std::function<void()> task) = 0;
+
+  // The executor function of the options, whose user data is an |Executor|.
+  static void Run(void* executor, spv_task_fn task, void* task_data) {
+    static_cast<Executor*>(executor)->Execute(
+        [task, task_data]() { task(task_data); });
+  }
+};
+
 // A RAII wrapper around a validator options object.
 class ValidatorOptions {
  public:
@@ -109,6 +229,45 @@ class ValidatorOptions {
     spvValidatorOptionsSetSkipBlockLayout(options_, val);
   }
 
+  // Checks the bodies of the functions of the module on up to |num_threads|
+  // threads.  The diagnostics are the same as with one thread.
+  void SetNumThreads(uint32_t num_threads) {
+    spvValidatorOptionsSetNumThreads(options_, num_threads);
+  }
+
+  // Selects the set of checks to run.  See spv_validator_profile.
+  void SetProfile(spv_validator_profile profile) {
+    spvValidatorOptionsSetProfile(options_, profile);
+  }
+
+  // Calls |report| with |user_data| after each stage of the validation.  See
+  // spvValidatorOptionsSetStageReport.
+  void SetStageReport(spv_validator_stage_report_fn report, void* user_data) {
+    spvValidatorOptionsSetStageReport(options_, report, user_data);
+  }
+
+  // Skips validating the modules that |cache| knows to be valid, and adds
+  // the valid modules to it.  A null |cache| disables caching.
+  void SetCache(spv_validation_cache cache) {
+    spvValidatorOptionsSetCache(options_, cache);
+  }
+
+  // Stops the validation with SPV_ERROR_CANCELLED when |cancellation| says
+  // so.  A null |cancellation| never stops it.
+  void SetCancellation(const Cancellation* cancellation) {
+    spvValidatorOptionsSetCancel(options_,
+                                 cancellation ? &Cancellation::Poll : nullptr,
+                                 const_cast<Cancellation*>(cancellation));
+  }
+
+  // Checks the functions of the module on the tasks of |executor| instead of
+  // on threads of the validator's own, when it uses several threads.  See
+  // spvValidatorOptionsSetExecutor.  A null |executor| starts threads.
+  void SetExecutor(Executor* executor) {
+    spvValidatorOptionsSetExecutor(
+        options_, executor ? &Executor::Run : nullptr, executor);
+  }
+
   // Records whether or not the validator should relax the rules on pointer
   // usage in logical addressing mode.
   //
@@ -176,6 +335,20 @@ class OptimizerOptions {
                                                 preserve_spec_constants);
   }
 
+  // Records whether the instructions of the module should be allocated from
+  // an arena.
+  void set_use_instruction_arena(bool use_instruction_arena) {
+    spvOptimizerOptionsSetUseInstructionArena(options_, use_instruction_arena);
+  }
+
+  // See spvOptimizerOptionsSetCancel.  A null |cancellation| never stops the
+  // optimization.
+  void set_cancellation(const Cancellation* cancellation) {
+    spvOptimizerOptionsSetCancel(options_,
+                                 cancellation ? &Cancellation::Poll : nullptr,
+                                 const_cast<Cancellation*>(cancellation));
+  }
+
  private:
   spv_optimizer_options options_;
 };
@@ -207,6 +380,24 @@ class ReducerOptions {
     spvReducerOptionsSetTargetFunction(options_, target_function);
   }
 
+  // See spvReducerOptionsSetTargetConstruct.
+  void set_target_construct(uint32_t target_construct) {
+    spvReducerOptionsSetTargetConstruct(options_, target_construct);
+  }
+
+  // See spvReducerOptionsSetNumJobs.
+  void set_num_jobs(uint32_t num_jobs) {
+    spvReducerOptionsSetNumJobs(options_, num_jobs);
+  }
+
+  // See spvReducerOptionsSetCancel.  A null |cancellation| never stops the
+  // reduction.
+  void set_cancellation(const Cancellation* cancellation) {
+    spvReducerOptionsSetCancel(options_,
+                               cancellation ? &Cancellation::Poll : nullptr,
+                               const_cast<Cancellation*>(cancellation));
+  }
+
  private:
   spv_reducer_options options_;
 };
@@ -242,6 +433,11 @@ class FuzzerOptions {
     spvFuzzerOptionsSetShrinkerStepLimit(options_, shrinker_step_limit);
   }
 
+  // See spvFuzzerOptionsSetShrinkerNumJobs.
+  void set_shrinker_num_jobs(uint32_t shrinker_num_jobs) {
+    spvFuzzerOptionsSetShrinkerNumJobs(options_, shrinker_num_jobs);
+  }
+
   // See spvFuzzerOptionsEnableFuzzerPassValidation.
   void enable_fuzzer_pass_validation() {
     spvFuzzerOptionsEnableFuzzerPassValidation(options_);
@@ -254,6 +450,76 @@ class FuzzerOptions {
   spv_fuzzer_options options_;
 };
 
+// A descriptor or push constant block declared by a module-scope variable,
+// as found by SpirvTools::Reflect.  The storage class is a SpvStorageClass.
+struct ReflectedResource {
+  uint32_t variable_id = 0;
+  uint32_t storage_class = 0;
+  // The type of each resource: the pointee type of the variable, less the
+  // arrays of resources around it.
+  uint32_t type_id = 0;
+  // The number of resources, which is the product of the lengths of the
+  // arrays stripped from |type_id|, or 0 if one of them is runtime sized or
+  // sized by a specialization constant.
+  uint32_t array_size = 1;
+  // Whether the variable is decorated with both a DescriptorSet and a
+  // Binding, which push constant blocks are not.
+  bool has_binding = false;
+  uint32_t set = 0;
+  uint32_t binding = 0;
+  // The OpName of the variable, if it has one.
+  std::string name;
+
+  bool operator==(const ReflectedResource& other) const;
+};
+
+// An entry point and the ids of its interface variables.  The execution
+// model is a SpvExecutionModel.
+struct ReflectedEntryPoint {
+  uint32_t function_id = 0;
+  uint32_t execution_model = 0;
+  std::string name;
+  std::vector<uint32_t> interface_ids;
+
+  bool operator==(const ReflectedEntryPoint& other) const;
+};
+
+// A specialization constant decorated with a SpecId.  |default_value| holds
+// the words of the literal value of an OpSpecConstant, and 1 or 0 for an
+// OpSpecConstantTrue or OpSpecConstantFalse.
+struct ReflectedSpecConstant {
+  uint32_t id = 0;
+  uint32_t spec_id = 0;
+  uint32_t type_id = 0;
+  std::vector<uint32_t> default_value;
+  std::string name;
+
+  bool operator==(const ReflectedSpecConstant& other) const;
+};
+
+// What an application needs to know about a module to create the pipeline
+// layouts and pipelines that use it.  Each list is in the order in which the
+// module declares its elements.
+struct ModuleReflection {
+  std::vector<ReflectedResource> resources;
+  std::vector<ReflectedEntryPoint> entry_points;
+  std::vector<ReflectedSpecConstant> spec_constants;
+
+  // Returns the resource bound to |binding| of descriptor set |set|, or
+  // nullptr if there is none.  If several variables alias the binding, the
+  // first one is returned.
+  const ReflectedResource* FindResource(uint32_t set, uint32_t binding) const;
+
+  // Returns the specialization constant with the SpecId |spec_id|, or nullptr
+  // if there is none.
+  const ReflectedSpecConstant* FindSpecConstant(uint32_t spec_id) const;
+
+  bool operator==(const ModuleReflection& other) const;
+  bool operator!=(const ModuleReflection& other) const {
+    return !(*this == other);
+  }
+};
+
 // C++ interface for SPIRV-Tools functionalities. It wraps the context
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for assembling, disassembling, and validating.
@@ -306,6 +572,11 @@ class SpirvTools {
   bool Assemble(const char* text, size_t text_size,
                 std::vector<uint32_t>* binary,
                 uint32_t options = kDefaultAssembleOption) const;
+  // Like the previous overload, but assembles the functions of the module on
+  // up to |num_threads| threads.  See spvTextToBinaryParallel.
+  bool Assemble(const char* text, size_t text_size,
+                std::vector<uint32_t>* binary, uint32_t options,
+                uint32_t num_threads) const;
 
   // Disassembles the given SPIR-V |binary| with the given |options| and writes
   // the assembly to |text|. Returns true on successful disassembling. |text|
@@ -316,6 +587,29 @@ class SpirvTools {
   bool Disassemble(const uint32_t* binary, size_t binary_size,
                    std::string* text,
                    uint32_t options = kDefaultDisassembleOption) const;
+  // Like the previous overload, but disassembles the functions of the module
+  // on up to |num_threads| threads.  See spvBinaryToTextParallel.
+  bool Disassemble(const uint32_t* binary, size_t binary_size,
+                   std::string* text, uint32_t options,
+                   uint32_t num_threads) const;
+
+  // Compresses the given SPIR-V |binary| and writes the result to
+  // |compressed|.  Returns true on success.  |compressed| will be kept
+  // untouched if compressing is unsuccessful.  See spvBinaryCompress.
+  bool Compress(const std::vector<uint32_t>& binary,
+                std::vector<uint8_t>* compressed) const;
+  // |binary_size| specifies the number of words in |binary|.
+  bool Compress(const uint32_t* binary, size_t binary_size,
+                std::vector<uint8_t>* compressed) const;
+
+  // Decompresses a module written by Compress and writes its words to
+  // |binary|.  Returns true on success.  |binary| will be kept untouched if
+  // decompressing is unsuccessful.  See spvBinaryDecompress.
+  bool Decompress(const std::vector<uint8_t>& compressed,
+                  std::vector<uint32_t>* binary) const;
+  // |compressed_size| specifies the number of bytes in |compressed|.
+  bool Decompress(const uint8_t* compressed, size_t compressed_size,
+                  std::vector<uint32_t>* binary) const;
 
   // Validates the given SPIR-V |binary|. Returns true if no issues are found.
   // Otherwise, returns false and communicates issues via the message consumer
@@ -342,6 +636,26 @@ class SpirvTools {
   // binary itself, or in the validator options.
   bool Validate(const uint32_t* binary, size_t binary_size,
                 spv_validator_options options) const;
+  // Like the previous overload, but validates |binary| on a task of the
+  // executor of |options| if it has one, and on a new thread otherwise, and
+  // returns the future of the result.  |options| is copied, but the objects
+  // it refers to, such as its cache and executor, and this object must
+  // outlive the validation.  The message consumer is called from the thread
+  // that validates.
+  std::future<bool> ValidateAsync(std::vector<uint32_t> binary,
+                                  spv_validator_options options) const;
+
+  // Finds the resources, entry points and specialization constants of the
+  // given SPIR-V |binary| of |binary_size| words, and writes them to
+  // |reflection|.  Only the instructions before the first function are
+  // parsed, and the module is not validated.  Returns true on success.
+  // |reflection| will be kept untouched if parsing is unsuccessful.
+  bool Reflect(const uint32_t* binary, size_t binary_size,
+               ModuleReflection* reflection) const;
+  bool Reflect(const std::vector<uint32_t>& binary,
+               ModuleReflection* reflection) const {
+    return Reflect(binary.data(), binary.size(), reflection);
+  }
 
   // Was this object successfully constructed.
   bool IsValid() const;
@@ -351,6 +665,134 @@ class SpirvTools {
   std::unique_ptr<Impl> impl_;  // Unique pointer to implementation data.
 };
 
+// A pull-style reader of the instructions of a SPIR-V binary.  This is an
+// alternative to the callbacks of spvBinaryParse: the caller asks for each
+// instruction in turn, and can stop, seek, or skip whole functions at any
+// point.
+//
+// For example, to look at the instructions before the first function:
+//
+//   BinaryReader reader(SPV_ENV_UNIVERSAL_1_5, binary.data(), binary.size());
+//   for (const spv_parsed_instruction_t& inst : reader) {
+//     if (inst.opcode == SpvOpFunction) break;
+//     ...
+//   }
+//   if (reader.status() != SPV_SUCCESS) { ... }
+//
+// The words of the parsed instructions are in the host native endianness, and
+// stay valid for the lifetime of the reader.  Their operands are only valid
+// until the next instruction is read.  The binary must outlive the reader.
+class BinaryReader {
+ public:
+  // An input iterator over the instructions of a reader.  Incrementing it
+  // reads the next instruction; it becomes equal to end() when there are no
+  // more instructions, or when reading one fails.
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = spv_parsed_instruction_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const spv_parsed_instruction_t*;
+    using reference = const spv_parsed_instruction_t&;
+
+    reference operator*() const { return reader_->instruction(); }
+    pointer operator->() const { return &reader_->instruction(); }
+
+    iterator& operator++() {
+      if (!reader_->Next()) reader_ = nullptr;
+      return *this;
+    }
+
+    bool operator==(const iterator& other) const {
+      return reader_ == other.reader_;
+    }
+    bool operator!=(const iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class BinaryReader;
+    explicit iterator(BinaryReader* reader) : reader_(reader) {}
+
+    BinaryReader* reader_;
+  };
+
+  // Constructs a reader of the given |binary| of |binary_size| words, using the
+  // grammar of the target environment |env|.  Nothing is parsed yet.
+  //
+  // The constructed instance will have an empty message consumer, which just
+  // ignores all messages from the library. Use SetMessageConsumer() to supply
+  // one if messages are of concern.
+  BinaryReader(spv_target_env env, const uint32_t* binary, size_t binary_size);
+  BinaryReader(spv_target_env env, const std::vector<uint32_t>& binary)
+      : BinaryReader(env, binary.data(), binary.size()) {}
+
+  // Disables copy/move constructor/assignment operations.
+  BinaryReader(const BinaryReader&) = delete;
+  BinaryReader(BinaryReader&&) = delete;
+  BinaryReader& operator=(const BinaryReader&) = delete;
+  BinaryReader& operator=(BinaryReader&&) = delete;
+
+  // Destructs this instance.
+  ~BinaryReader();
+
+  // Sets the message consumer to the given |consumer|. The |consumer| will be
+  // invoked once for each message communicated from the library.
+  void SetMessageConsumer(MessageConsumer consumer);
+
+  // Parses the header of the module, if it has not been parsed yet.  Returns
+  // true on success.  The other methods parse the header on demand, so calling
+  // this is only needed to look at the header before the first instruction.
+  bool ReadHeader();
+
+  // Returns the fields of the module header.  Only valid after the header has
+  // been parsed successfully.
+  uint32_t version() const;
+  uint32_t generator() const;
+  uint32_t id_bound() const;
+  uint32_t schema() const;
+
+  // Reads the instruction at the current position, and advances past it.
+  // Returns true on success.  Returns false if there are no more
+  // instructions, or if the instruction is invalid, in which case status()
+  // is an error code and a message is communicated to the message consumer.
+  bool Next();
+
+  // Returns the instruction read by the last successful call to Next().
+  const spv_parsed_instruction_t& instruction() const;
+
+  // Returns the word offset of the instruction read by the last successful
+  // call to Next().
+  size_t instruction_offset() const;
+
+  // Returns the word offset of the next instruction to be read.
+  size_t position() const;
+
+  // Moves the current position to the given |word_offset|, which must be the
+  // start of an instruction, or the end of the binary.  Returns true on
+  // success.  The instructions between the old and new position are not
+  // parsed, so later instructions whose parse depends on them, such as an
+  // OpConstant using a skipped type, fail to parse.
+  bool Seek(size_t word_offset);
+
+  // Advances past the remaining instructions of the current function, up to
+  // and including its OpFunctionEnd, without decoding their operands.  Call
+  // this after reading an OpFunction, or when positioned anywhere inside a
+  // function.  Returns true on success.
+  bool SkipFunction();
+
+  // Returns SPV_SUCCESS if no error occurred so far, or the error code of the
+  // failure that stopped the reader.
+  spv_result_t status() const;
+
+  // Reads the next instruction, and returns an iterator at it.  Returns end()
+  // if there is none.
+  iterator begin() { return Next() ? iterator(this) : end(); }
+  iterator end() { return iterator(nullptr); }
+
+ private:
+  struct Impl;  // Opaque struct for holding the data fields used by this class.
+  std::unique_ptr<Impl> impl_;  // Unique pointer to implementation data.
+};
+
 }  // namespace spvtools
 
 #endif  // INCLUDE_SPIRV_TOOLS_LIBSPIRV_HPP_
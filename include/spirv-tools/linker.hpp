@@ -17,10 +17,12 @@
 
 #include <cstdint>
 
+#include <future>
 #include <memory>
 #include <vector>
 
 #include "libspirv.hpp"
+#include "optimizer.hpp"
 
 namespace spvtools {
 
@@ -29,7 +31,10 @@ class LinkerOptions {
   LinkerOptions()
       : create_library_(false),
         verify_ids_(false),
-        allow_partial_linkage_(false) {}
+        allow_partial_linkage_(false),
+        num_threads_(1),
+        executor_(nullptr),
+        eliminate_dead_functions_(false) {}
 
   // Returns whether a library or an executable should be produced by the
   // linking phase.
@@ -63,10 +68,44 @@ class LinkerOptions {
     allow_partial_linkage_ = allow_partial_linkage;
   }
 
+  // Returns the number of threads over which the parsing and id shifting of
+  // the input modules are spread.
+  uint32_t GetNumThreads() const { return num_threads_; }
+
+  // Sets the number of threads over which the parsing and id shifting of the
+  // input modules are spread; 0 is treated as 1.  If more than one thread is
+  // used, the message consumer of the context must be thread-safe.  The
+  // linked module does not depend on the number of threads.
+  void SetNumThreads(uint32_t num_threads) { num_threads_ = num_threads; }
+
+  // Returns the executor on whose tasks the work spread over several threads
+  // runs, or null if the linker starts its own threads.
+  Executor* GetExecutor() const { return executor_; }
+
+  // Sets the executor on whose tasks the work spread over several threads
+  // runs, and on which LinkAsync() links.  A null |executor|, the default,
+  // starts threads instead.
+  void SetExecutor(Executor* executor) { executor_ = executor; }
+
+  // Returns whether functions that cannot be reached from an entry point, or
+  // from an exported function when creating a library, are removed from the
+  // linked module.
+  bool GetEliminateDeadFunctions() const { return eliminate_dead_functions_; }
+
+  // Sets whether functions that cannot be reached from an entry point, or
+  // from an exported function when creating a library, are removed from the
+  // linked module, as when statically linking against an archive.
+  void SetEliminateDeadFunctions(bool eliminate_dead_functions) {
+    eliminate_dead_functions_ = eliminate_dead_functions;
+  }
+
  private:
   bool create_library_;
   bool verify_ids_;
   bool allow_partial_linkage_;
+  uint32_t num_threads_;
+  Executor* executor_;
+  bool eliminate_dead_functions_;
 };
 
 // Links one or more SPIR-V modules into a new SPIR-V module. That is, combine
@@ -92,6 +131,77 @@ spv_result_t Link(const Context& context, const uint32_t* const* binaries,
                   std::vector<uint32_t>* linked_binary,
                   const LinkerOptions& options = LinkerOptions());
 
+// As the first Link() above, except that the modules are linked on a task of
+// the executor of |options| if it has one, and on a new thread otherwise, and
+// that the future of the result is returned.  |binaries| and |options| are
+// copied, but |context|, |linked_binary| and the executor must outlive the
+// linking.  The message consumer is called from the thread that links.
+std::future<spv_result_t> LinkAsync(
+    const Context& context, std::vector<std::vector<uint32_t>> binaries,
+    std::vector<uint32_t>* linked_binary,
+    const LinkerOptions& options = LinkerOptions());
+
+// As Link() above, except that the modules are already loaded, and that the
+// linked module is kept loaded in |linked_module| instead of being serialized,
+// so that it can be optimized and validated without being parsed again.  The
+// loaded modules are consumed by linking: they are left without a module,
+// whether linking succeeds or not.  All modules must have been loaded for the
+// target environment of |context|.
+spv_result_t Link(const Context& context,
+                  const std::vector<LoadedModule*>& modules,
+                  LoadedModule* linked_module,
+                  const LinkerOptions& options = LinkerOptions());
+
+class PreparedLibrary;
+
+// Links the library modules |binaries| into |library| once, so that |library|
+// can then be linked against many times without parsing, merging and
+// deduplicating those modules again.  The library is linked as if with
+// LinkerOptions::SetCreateLibrary(true), so that all of its exports are kept;
+// the other |options| apply as usual.  Fails for the same reasons as Link().
+spv_result_t PrepareLibrary(const Context& context,
+                            const std::vector<std::vector<uint32_t>>& binaries,
+                            PreparedLibrary* library,
+                            const LinkerOptions& options = LinkerOptions());
+
+// As Link() above, except that the modules of the prepared |library| are
+// linked in before |binaries|, which may then be empty.  |library| is not
+// modified, and can be used for later calls.
+spv_result_t Link(const Context& context, const PreparedLibrary& library,
+                  const std::vector<std::vector<uint32_t>>& binaries,
+                  std::vector<uint32_t>* linked_binary,
+                  const LinkerOptions& options = LinkerOptions());
+
+// Library modules that have been linked together ahead of time by
+// PrepareLibrary(), ready to be linked against repeatedly.
+class PreparedLibrary {
+ public:
+  PreparedLibrary();
+  ~PreparedLibrary();
+
+  PreparedLibrary(const PreparedLibrary&) = delete;
+  PreparedLibrary& operator=(const PreparedLibrary&) = delete;
+  PreparedLibrary(PreparedLibrary&&);
+  PreparedLibrary& operator=(PreparedLibrary&&);
+
+  // Returns true if PrepareLibrary() has succeeded on this library.
+  bool IsPrepared() const;
+
+ private:
+  friend spv_result_t PrepareLibrary(
+      const Context& context,
+      const std::vector<std::vector<uint32_t>>& binaries,
+      PreparedLibrary* library, const LinkerOptions& options);
+  friend spv_result_t Link(const Context& context,
+                           const PreparedLibrary& library,
+                           const std::vector<std::vector<uint32_t>>& binaries,
+                           std::vector<uint32_t>* linked_binary,
+                           const LinkerOptions& options);
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
 }  // namespace spvtools
 
 #endif  // INCLUDE_SPIRV_TOOLS_LINKER_HPP_
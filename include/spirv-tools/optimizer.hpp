@@ -15,6 +15,8 @@
 #ifndef INCLUDE_SPIRV_TOOLS_OPTIMIZER_HPP_
 #define INCLUDE_SPIRV_TOOLS_OPTIMIZER_HPP_
 
+#include <functional>
+#include <future>
 #include <memory>
 #include <ostream>
 #include <string>
@@ -29,6 +31,10 @@ namespace opt {
 class Pass;
 }
 
+class FunctionCache;
+class LinkerOptions;
+class LoadedModule;
+
 // C++ interface for SPIR-V optimization functionalities. It wraps the context
 // (including target environment and the corresponding SPIR-V grammar) and
 // provides methods for registering optimization passes and optimizing.
@@ -153,6 +159,13 @@ class Optimizer {
   //                  HLSL front-end.
   bool RegisterPassFromFlag(const std::string& flag);
 
+  // Registers a pass that runs the passes given by |flags| (see
+  // |RegisterPassesFromFlags|) over and over, until none of them changes the
+  // module or they have run |max_iterations| times.  Returns false, and
+  // registers nothing, if one of the flags is not valid.
+  bool RegisterFixedPointPasses(const std::vector<std::string>& flags,
+                                uint32_t max_iterations);
+
   // Validates that |flag| has a valid format.  Strings accepted:
   //
   // --pass_name[=pass_args]
@@ -211,6 +224,58 @@ class Optimizer {
            std::vector<uint32_t>* optimized_binary,
            const spv_optimizer_options opt_options) const;
 
+  // Same as above, except that the optimized binary is written to the
+  // |optimized_binary_capacity| words starting at |optimized_binary|, and its
+  // size in words to |optimized_binary_size|.  The module is written directly
+  // to that memory, which may overlap |original_binary|.  If the optimized
+  // binary does not fit, writes the size it needs to |optimized_binary_size|,
+  // reports an error and returns false.
+  bool Run(const uint32_t* original_binary, const size_t original_binary_size,
+           uint32_t* optimized_binary, const size_t optimized_binary_capacity,
+           size_t* optimized_binary_size,
+           const spv_optimizer_options opt_options) const;
+
+  // Same as above, except that the passes transform |module| in place, so
+  // that it can be handed to another optimizer, or validated, without being
+  // serialized and parsed again.  If |opt_options| asks for the module to be
+  // validated first, it is serialized for the validator, which reads words.
+  // Returns false if |module| is not loaded, fails to validate, or a pass
+  // fails, in which case |module| may be partially transformed.
+  bool Run(LoadedModule* module, const spv_optimizer_options opt_options) const;
+
+  // Starts optimizing |original_binary| as |Run| does with |opt_options|, on
+  // the executor of this optimizer, or on a new thread if it has none, and
+  // returns the future value |Run| returns.  |original_binary| and
+  // |opt_options| are copied, but this optimizer and |optimized_binary| must
+  // outlive the future, and this optimizer must not be changed or run again
+  // before the future is ready.
+  std::future<bool> RunAsync(std::vector<uint32_t> original_binary,
+                             std::vector<uint32_t>* optimized_binary,
+                             const spv_optimizer_options opt_options) const;
+
+  // Optimizes each module in |original_binaries| with the passes registered
+  // in this optimizer, as |Run| does with |opt_options|.  The i-th optimized
+  // module is written to the i-th element of |optimized_binaries|, and the
+  // i-th element of |results| is set to the value |Run| would return for it.
+  //
+  // Up to |num_threads| modules are optimized at the same time.  If
+  // |num_threads| is greater than 1, the message consumer must be safe to call
+  // from several threads.  The options set with |SetPrintAll|,
+  // |SetPrintChanged|, |SetTimeReport| and |SetValidateAfterAll| are not
+  // applied to the batch.
+  //
+  // A pass can only be run once, so the passes are registered again for each
+  // module from the flags that registered them in this optimizer.  Returns
+  // false without optimizing any module if a pass was registered by other
+  // means than a flag or the RegisterLegalizationPasses,
+  // RegisterPerformancePasses and RegisterSizePasses methods.  Otherwise
+  // returns true, even if some modules failed to optimize.
+  bool RunBatch(const std::vector<std::vector<uint32_t>>& original_binaries,
+                std::vector<std::vector<uint32_t>>* optimized_binaries,
+                std::vector<bool>* results,
+                const spv_optimizer_options opt_options,
+                uint32_t num_threads) const;
+
   // Returns a vector of strings with all the pass names added to this
   // optimizer's pass manager. These strings are valid until the associated
   // pass manager is destroyed.
@@ -221,15 +286,330 @@ class Optimizer {
   // output is sent to the |out| output stream.
   Optimizer& SetPrintAll(std::ostream* out);
 
-  // Sets the option to print the resource utilization of each pass. If |out|
-  // is null, then no output is generated. Otherwise, output is sent to the
-  // |out| output stream.
+  // Sets the option to print the disassembly of the module before the first
+  // pass, and then, after each pass that changes the module, only the
+  // functions it changed, along with the module-level instructions if any of
+  // them changed.  This is much cheaper than |SetPrintAll| on large modules.
+  // If |out| is null, then no output is generated.  Otherwise, output is sent
+  // to the |out| output stream.
+  Optimizer& SetPrintChanged(std::ostream* out);
+
+  // Sets the option to print the resource utilization of each pass, followed
+  // by the approximate memory used by the module and each analysis after each
+  // pass. If |out| is null, then no output is generated. Otherwise, output is
+  // sent to the |out| output stream.
   Optimizer& SetTimeReport(std::ostream* out);
 
+  // The hardware performance counters that |SetTimeReportCounters| can add to
+  // the resource utilization of each pass, as bits of a mask.
+  enum TimeReportCounter : uint32_t {
+    kTimeReportInstructions = 1 << 0,
+    kTimeReportCacheMisses = 1 << 1,
+    kTimeReportBranchMisses = 1 << 2,
+  };
+
+  // Sets the hardware counters that the report of |SetTimeReport| includes
+  // besides the times, as a mask of |TimeReportCounter|.  They are measured
+  // with perf_event_open() on Linux.  A counter that cannot be read, such as
+  // on other systems, is reported as "n/a".
+  Optimizer& SetTimeReportCounters(uint32_t counters);
+
+  // Sets the option to write a JSON report with, for every pass, its wall and
+  // CPU time, RSS delta, the number of instructions before and after it, the
+  // analyses it built with the time each took, whether it changed the module,
+  // and the approximate memory used by the module and each analysis after it.
+  // If |out| is null, then no report is generated.  Otherwise, the
+  // report is sent to the |out| output stream.
+  Optimizer& SetJsonTimeReport(std::ostream* out);
+
+  // Sets the option to write a trace in the Chrome trace event format, with a
+  // span for every pass and, nested in it, a span for every analysis the pass
+  // built.  If |out| is null, then no trace is generated.  Otherwise, the
+  // trace is sent to the |out| output stream.
+  Optimizer& SetTraceReport(std::ostream* out);
+
   // Sets the option to validate the module after each pass.
   Optimizer& SetValidateAfterAll(bool validate);
 
+  // Sets the option to skip a pass when a pass with the same name has
+  // already run on the module without changing it, and no pass has changed
+  // the module since.  Passes whose behavior depends on arguments are never
+  // skipped.
+  Optimizer& SetSkipUnchangedPasses(bool skip);
+
+  // Sets the maximum number of threads that passes may use to process the
+  // functions of the module at the same time.  The default is 1, which means
+  // all functions are processed on the calling thread.  Only some passes, such
+  // as local redundancy elimination, use more than one thread, and the result
+  // does not depend on the number of threads.
+  Optimizer& SetNumThreads(uint32_t num_threads);
+
+  // Sets the approximate memory, in bytes, that the module and its analyses
+  // should stay under between passes.  When a pass leaves them above it, the
+  // analyses cached for each function, such as the dominator trees and the
+  // loop descriptors, are dropped to be rebuilt when needed, and a warning is
+  // reported if the memory is still above the limit.  There is no limit if
+  // |max_memory| is 0, which is the default.
+  Optimizer& SetMaxMemory(size_t max_memory);
+
+  // The work that the passes of a run did.  Unlike times, the counts do not
+  // depend on the machine, so comparing them with the size of the module
+  // finds the inputs that make the passes superlinear.
+  struct WorkCounts {
+    // The number of instructions in the module before the passes ran.
+    size_t instructions = 0;
+    // The number of analyses the passes built, each time they built one.
+    size_t analysis_builds = 0;
+    // The number of use records the def-use managers added or removed,
+    // including while they were built.
+    size_t def_use_updates = 0;
+  };
+
+  // Makes each run of the passes write the work they did to |counts|, which
+  // must outlive this optimizer.  Nothing is counted if |counts| is nullptr,
+  // the default.
+  Optimizer& SetWorkCounts(WorkCounts* counts);
+
+  // Runs the work spread over several threads, such as the functions
+  // optimized in parallel, the batches, the searches and |RunAsync|, on the
+  // tasks of |executor| instead of new threads.  The validation done by the
+  // optimizer uses it too, unless its options have an executor of their own.
+  // |executor| must outlive the optimizer, and nullptr, the default, starts
+  // threads.
+  Optimizer& SetExecutor(Executor* executor);
+
+  // The number of times a block executed in a profile of the module.
+  struct BlockExecutionCount {
+    uint32_t function_id;  // The result id of the function of the block.
+    uint32_t block_id;     // The id of the label of the block.
+    uint64_t count;        // The number of executions of the block.
+  };
+
+  // Attaches |profile| to the modules optimized by this optimizer.  Passes
+  // that trade code size for speed, such as inlining and loop unrolling, skip
+  // the blocks that never executed in the profile.  Counts whose block is not
+  // in the named function of the module are ignored, and blocks without a
+  // count are treated as if there was no profile.  The counts can be
+  // collected with the pass created by |CreateInstBlockProfilePass|.
+  Optimizer& SetProfile(std::vector<BlockExecutionCount> profile);
+
+  // Makes the passes that run one function at a time, such as the ones in the
+  // middle of the legalization passes, reuse their results from |cache| for
+  // the functions they have seen in other modules, and record there the
+  // results for the functions they have not seen.  |cache| must outlive the
+  // runs of this optimizer, and can be shared by several optimizers.  Passing
+  // nullptr stops using a cache.
+  Optimizer& SetFunctionCache(FunctionCache* cache);
+
+  // Static estimates of the cost of running one entry point, meant to catch
+  // performance regressions.  The counts cover the functions called by the
+  // entry point, and weight each instruction by the expected number of
+  // executions of its block: the product of the trip counts of its loops,
+  // with 8 for unknown trip counts.
+  struct EntryPointStats {
+    std::string name;              // The name of the entry point.
+    uint32_t execution_model = 0;  // Its SpvExecutionModel.
+    double alu_instructions = 0;   // Instructions in no other group.
+    double memory_instructions = 0;   // Loads, stores, copies and atomics.
+    double texture_instructions = 0;  // Image samples, fetches, reads, writes.
+    double control_instructions = 0;  // Block terminators and calls.
+    double barriers = 0;              // Control and memory barriers.
+    double dynamic_branches = 0;      // Branches on non-constant values.
+    size_t max_live_registers = 0;    // Largest register pressure of a block.
+  };
+
+  // Writes to |stats| the stats of each entry point of the module in the
+  // |binary_size| words of |binary|, in the order of its OpEntryPoint
+  // instructions.  Returns false if the module cannot be built.
+  bool ComputeEntryPointStats(const uint32_t* binary, size_t binary_size,
+                              std::vector<EntryPointStats>* stats) const;
+
+  // The measure of an optimized module that |SearchPassFlags| minimizes.
+  enum class SearchCost {
+    kInstructionCount,  // The number of instructions of the module.
+    kRegisterPressure,  // The largest register pressure estimate of a block.
+    kCustom,            // The value returned by |SearchOptions::custom_cost|.
+  };
+
+  // The options of |SearchPassFlags|.
+  struct SearchOptions {
+    SearchCost cost = SearchCost::kInstructionCount;
+    // Returns the cost of the optimized module |binary| if |cost| is
+    // |SearchCost::kCustom|.  It must be safe to call from several threads if
+    // |num_threads| is greater than 1.
+    std::function<double(const std::vector<uint32_t>& binary)> custom_cost;
+    // The number of rounds of the search.
+    uint32_t num_rounds = 16;
+    // The number of candidates evaluated in each round.
+    uint32_t candidates_per_round = 8;
+    // The number of candidates evaluated at the same time.
+    uint32_t num_threads = 1;
+    // The seed of the pseudo-random changes to the candidates.  The search
+    // gives the same result for the same seed, whatever |num_threads| is.
+    uint32_t seed = 1;
+  };
+
+  // The result of |SearchPassFlags|.
+  struct SearchResult {
+    std::vector<std::string> flags;  // The best list of pass flags.
+    double cost = 0;                 // The cost of the module they produce.
+    std::vector<uint32_t> binary;    // The module they produce.
+  };
+
+  // Searches for a list of pass flags that optimizes |original_binary| to the
+  // lowest cost, as measured by |search_options|.  The search starts from the
+  // flags that registered the passes of this optimizer, or from -O if no pass
+  // was registered.  Recipes such as -O are kept as single flags.  Each round
+  // evaluates candidates made from the best list found so far by inserting,
+  // removing, replacing or swapping flags, including loop unrolling, scalar
+  // replacement and inlining flags with various parameters, and keeps the
+  // best candidate if it is cheaper.
+  //
+  // The module is built once and a copy of it is optimized for each
+  // candidate, as |Run| would with |opt_options|.  Candidates that fail to
+  // optimize or produce an invalid module are discarded.  Writes the best
+  // list, its cost and the module it produces to |result|.  Returns false if
+  // the module cannot be built, the starting list fails, or a pass was
+  // registered by other means than a flag.
+  bool SearchPassFlags(const uint32_t* original_binary,
+                       size_t original_binary_size,
+                       const spv_optimizer_options opt_options,
+                       const SearchOptions& search_options,
+                       SearchResult* result) const;
+
+ private:
+  friend class SpecializationCache;
+
+  struct Impl;                  // Opaque struct for holding internal data.
+  std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
+};
+
+// Produces variants of one generic module that differ only in the values of
+// their specialization constants, without building and optimizing the generic
+// module again for each variant.  The generic module is optimized once and
+// kept in memory.  Each variant is a copy of it in which the specialization
+// constants are set and frozen, followed by the passes that take advantage of
+// the new constants: spec constant folding, conditional constant propagation,
+// dead branch elimination and aggressive dead code elimination.
+//
+// |Specialize| does not change the cache, so it can be called from several
+// threads at the same time once the generic module is set, provided that the
+// message consumer is safe to call from several threads.
+class SpecializationCache {
+ public:
+  explicit SpecializationCache(spv_target_env env);
+  ~SpecializationCache();
+
+  // Sets the message consumer used while producing variants.  The generic
+  // module is optimized with the message consumer of its optimizer.
+  void SetMessageConsumer(MessageConsumer consumer);
+
+  // Builds |generic_binary| and optimizes it with the passes registered in
+  // |optimizer|, as |optimizer.Run| would with |opt_options|, and keeps the
+  // result as the generic module of this cache.  Each pass can only be run
+  // once, so |optimizer| should not be used to run its passes again.  Returns
+  // false and leaves the cache without a generic module if that fails.
+  bool SetGenericModule(const Optimizer& optimizer,
+                        const uint32_t* generic_binary,
+                        size_t generic_binary_size,
+                        const spv_optimizer_options opt_options);
+
+  // Writes to |variant_binary| the generic module specialized for
+  // |spec_values|, which maps SpecIds to the bit patterns of the values of
+  // their specialization constants.  Specialization constants that are not
+  // in |spec_values| are frozen to their default values.  Returns false if
+  // there is no generic module or a pass fails.
+  bool Specialize(
+      const std::unordered_map<uint32_t, std::vector<uint32_t>>& spec_values,
+      std::vector<uint32_t>* variant_binary) const;
+
+ private:
+  struct Impl;                  // Opaque struct for holding internal data.
+  std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
+};
+
+// The results of the passes of optimizers that run one function at a time, so
+// that the same functions in many modules, such as shared library functions,
+// are optimized once.  A function is the same as one in the cache if its
+// instructions, and the types, constants, variables and decorations they refer
+// to, are the same up to their ids, and the module has the same
+// capabilities, extensions and memory model.  The names of the entry points
+// do not matter.  The cached result is then
+// spliced into the module, with ids of that module, instead of running the
+// passes again.  The names of the ids the passes keep are kept.  Functions
+// with debug line or debug info instructions, and modules with decoration
+// groups, are not cached.
+//
+// The results depend on the target environment and on the options of the
+// optimizers, so one cache should only be used with one of each.  The
+// results are kept until the cache is cleared or destroyed.  All methods are
+// thread-safe, and the optimizers using a cache may run at the same time.
+class FunctionCache {
+ public:
+  FunctionCache();
+  ~FunctionCache();
+
+  FunctionCache(const FunctionCache&) = delete;
+  FunctionCache& operator=(const FunctionCache&) = delete;
+
+  // Returns the number of functions whose results are cached.
+  size_t size() const;
+
+  // Returns the number of times the result of a function was reused, and the
+  // number of times a function that could be cached was not found.
+  size_t num_hits() const;
+  size_t num_misses() const;
+
+  // Forgets all results, and resets the counts of hits and misses.
+  void Clear();
+
+ private:
+  friend class Optimizer;
+
+  struct Impl;                  // Opaque struct for holding internal data.
+  std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
+};
+
+// A module held in the in-memory form the optimizer works on.  Optimizers, the
+// linker and the validator can be run on it one after the other, so that it
+// is parsed once at the start and serialized once at the end, rather than at
+// each step.
+class LoadedModule {
+ public:
+  LoadedModule();
+  ~LoadedModule();
+
+  LoadedModule(const LoadedModule&) = delete;
+  LoadedModule& operator=(const LoadedModule&) = delete;
+  LoadedModule(LoadedModule&&);
+  LoadedModule& operator=(LoadedModule&&);
+
+  // Parses |binary| for |env| and keeps it as the module, replacing any
+  // module loaded before.  The binary is not validated.  Problems are reported
+  // to |consumer|, which is also used by |Validate|.  Returns false and leaves
+  // no module loaded if |binary| cannot be parsed.
+  bool Load(spv_target_env env, MessageConsumer consumer,
+            const uint32_t* binary, size_t binary_size);
+
+  // Returns true if a module is loaded.
+  bool IsLoaded() const;
+
+  // Writes the module to |binary|.  Returns false if no module is loaded.
+  bool ToBinary(std::vector<uint32_t>* binary) const;
+
+  // Validates the module for the environment it was loaded for, with
+  // |options|.  The validator reads words, so the module is serialized for
+  // it, but it is not parsed back.  Returns false if no module is loaded or
+  // the module is invalid.
+  bool Validate(const ValidatorOptions& options) const;
+
  private:
+  friend class Optimizer;
+  friend spv_result_t Link(const Context& context,
+                           const std::vector<LoadedModule*>& modules,
+                           LoadedModule* linked_module,
+                           const LinkerOptions& options);
+
   struct Impl;                  // Opaque struct for holding internal data.
   std::unique_ptr<Impl> impl_;  // Unique pointer to internal data.
 };
@@ -354,7 +734,9 @@ Optimizer::PassToken CreateEliminateDeadConstantPass();
 // Creates a strength-reduction pass.
 // A strength-reduction pass will look for opportunities to replace an
 // instruction with an equivalent and less expensive one.  For example,
-// multiplying by a power of 2 can be replaced by a bit shift.
+// multiplying by a power of 2 can be replaced by a bit shift, and multiplying
+// a loop induction variable by a constant can be replaced by a new induction
+// variable that is incremented on each iteration.
 Optimizer::PassToken CreateStrengthReductionPass();
 
 // Creates a block merge pass.
@@ -393,6 +775,19 @@ Optimizer::PassToken CreateInlineExhaustivePass();
 // point are not changed.
 Optimizer::PassToken CreateInlineOpaquePass();
 
+// Creates a selective inline pass.
+// A selective inline pass decides, for each function call in the entry point
+// call trees, whether inlining it is worth its cost.  Calls whose callee has
+// opaque parameter or return types are always inlined, as is the only call to
+// a function.  Other calls are inlined when the callee is small.  The size
+// limit is higher for calls in a loop and for calls with constant arguments.
+// Together, the calls inlined this way may not grow the functions of the
+// module by more than |growth_budget_percent| percent.  Callees are processed
+// before their callers, so calls inlined into a callee count towards its size.
+// Functions that are not in the call tree of an entry point are not changed.
+Optimizer::PassToken CreateInlineSelectivePass(
+    uint32_t growth_budget_percent = 20);
+
 // Creates a single-block local variable load/store elimination pass.
 // For every entry point function, do single block memory optimization of
 // function variables referenced only with non-access-chain loads and stores.
@@ -514,6 +909,19 @@ Optimizer::PassToken CreateInsertExtractElimPass();
 // inserts created by that pass.
 Optimizer::PassToken CreateDeadInsertElimPass();
 
+// Creates a dead store elimination pass.
+// This pass works on the memory SSA form of each function, for function scope,
+// private and workgroup memory.  Unlike the local store elimination passes, it
+// sees through access chains and across blocks.
+//
+// A load is replaced by the value of the store it reads from, when that store
+// writes exactly the same memory.  It is replaced by an earlier load of the
+// same memory when nothing may write it in between.  A store is removed when
+// the memory it writes is overwritten on every path before it may be read, or
+// when it writes a function scope variable that is never read again.  Volatile
+// accesses are left alone.
+Optimizer::PassToken CreateDeadStoreElimPass();
+
 // Create aggressive dead code elimination pass
 // This pass eliminates unused code from the module. In addition,
 // it detects and eliminates code which may have spurious uses but which do
@@ -640,6 +1048,50 @@ Optimizer::PassToken CreateLoopUnswitchPass();
 // paths leading to the instruction.  Those instructions are deleted.
 Optimizer::PassToken CreateRedundancyEliminationPass();
 
+// Create a partial redundancy elimination pass.
+// This pass looks at the merge blocks of structured selections for
+// instructions whose value is already computed on some of the paths reaching
+// them, as found by global value numbering.  The value is computed at the end
+// of the other predecessors, and the instruction is replaced by an OpPhi.  It
+// is only added to predecessors whose single successor is the merge block, so
+// no path computes it more often than before, and no new blocks are needed.
+// The value must already be available in at least half of the predecessors.
+Optimizer::PassToken CreatePartialRedundancyEliminationPass();
+
+// Create a jump threading pass.
+// This pass threads the value of a selection condition through the
+// selections that follow it.  Conditions are the same when they are the same
+// id, have the same value number, or are the logical negation of one another.
+//
+// A selection nested on one side of a selection on the same condition gets a
+// constant condition, which a later CreateDeadBranchElimPass() folds.  Two
+// successive selections on the same condition, where the merge block of the
+// first is the header of the second, are fused into a single selection: each
+// side of the first continues with the matching side of the second.  This is
+// only done when the second header has no code of its own, and each side of
+// the first reaches it through a single branch, so that no code has to be
+// duplicated and the result stays structured.
+Optimizer::PassToken CreateJumpThreadingPass();
+
+// Create an instruction scheduling pass.
+// This pass reorders the instructions inside each basic block to lower the
+// number of values live at the same time, as measured by the register
+// liveness analysis.  This helps drivers whose register allocators do poorly
+// on long blocks where values are defined far from their uses, such as the
+// blocks produced by loop unrolling.
+//
+// Instructions that access memory or synchronize keep their relative order,
+// except that non-volatile loads may be reordered with each other.  A block
+// is only changed if its new order needs fewer registers.
+Optimizer::PassToken CreateInstructionSchedulingPass();
+
+// Create a canonical layout pass.
+// This pass orders the module the way drivers parse it fastest: function
+// definitions come after the functions they call, the blocks of each function
+// are in structured order for shaders and in reverse post order otherwise, and
+// the result ids are renumbered from 1 in the order of their definitions.
+Optimizer::PassToken CreateCanonicalLayoutPass();
+
 // Create scalar replacement pass.
 // This pass replaces composite function scope variables with variables for each
 // element if those elements are accessed individually.  The parameter is a
@@ -689,6 +1141,18 @@ Optimizer::PassToken CreateSimplificationPass();
 // won't be unrolled. See CanPerformUnroll LoopUtils.h for more information.
 Optimizer::PassToken CreateLoopUnrollPass(bool fully_unroll, int factor = 0);
 
+// Create a heuristic loop unroller pass.
+// Creates a pass that unrolls every loop not marked with the "DontUnroll" loop
+// control mask, by a factor chosen for each loop.  It fully unrolls a loop
+// when the unrolled body is small enough, and otherwise tries partial factors
+// of 8, 4 and 2.  A factor is rejected if the estimated register pressure of
+// the unrolled body exceeds |max_register_pressure|, or if the code added by
+// all the unrolled loops would exceed |growth_budget_percent| percent of the
+// size of the functions in the module.  Only the loops accepted by
+// LoopUtils::CanPerformUnroll, which have a known trip count, are unrolled.
+Optimizer::PassToken CreateHeuristicLoopUnrollPass(
+    uint32_t growth_budget_percent = 25, uint32_t max_register_pressure = 64);
+
 // Create the SSA rewrite pass.
 // This pass converts load/store operations on function local variables into
 // operations on SSA IDs.  This allows SSA optimizers to act on these variables.
@@ -723,6 +1187,16 @@ Optimizer::PassToken CreateCopyPropagateArraysPass();
 // a pass of ADCE will be able to remove.
 Optimizer::PassToken CreateVectorDCEPass();
 
+// Create an SLP vectorization pass.
+// This pass looks for vectors built with OpCompositeConstruct from scalars
+// that are computed by the same arithmetic operations, lane by lane.  It
+// replaces the scalar operations with vector operations on the same operands.
+// The leaves of the trees become OpCompositeExtract sources, OpVectorShuffle
+// instructions, constant vectors or new composite constructions.  A tree is
+// rewritten only if it removes more instructions than the leaves add.  This
+// pays off on targets that execute vector arithmetic natively.
+Optimizer::PassToken CreateSLPVectorizePass();
+
 // Create a pass to reduce the size of loads.
 // This pass looks for loads of structures where only a few of its members are
 // used.  It replaces the loads feeding an OpExtract with an OpAccessChain and
@@ -762,9 +1236,24 @@ Optimizer::PassToken CreateCombineAccessChainsPass();
 // |input_length_enable| controls instrumentation of runtime descriptor array
 // references, and |input_init_enable| controls instrumentation of descriptor
 // initialization checking, both of which require input buffer support.
+// If |reuse_checks_enable| is true, a descriptor index or initialization
+// check that is dominated by an identical check of the same descriptor and
+// index reuses the earlier check's result instead of repeating it, and writes
+// no record of its own since any error has already been reported.
+// If |subgroup_stream_writes| is true and the module is SPIR-V 1.3 or later,
+// space for the output records of a subgroup is reserved with a single atomic
+// operation rather than one per invocation, reducing contention on the
+// output buffer size.
+// If |sample_period| is greater than one, only one in |sample_period|
+// eligible references is instrumented. If |sample_spec_id| is not negative,
+// every instrumented check is also gated on a boolean specialization constant
+// with that SpecId, true by default, so that checking can be switched off at
+// pipeline creation without re-instrumenting.
 Optimizer::PassToken CreateInstBindlessCheckPass(
     uint32_t desc_set, uint32_t shader_id, bool input_length_enable = false,
-    bool input_init_enable = false, bool input_buff_oob_enable = false);
+    bool input_init_enable = false, bool input_buff_oob_enable = false,
+    bool reuse_checks_enable = false, bool subgroup_stream_writes = false,
+    uint32_t sample_period = 1, int32_t sample_spec_id = -1);
 
 // Create a pass to instrument physical buffer address checking
 // This pass instruments all physical buffer address references to check that
@@ -785,8 +1274,22 @@ Optimizer::PassToken CreateInstBindlessCheckPass(
 // The instrumentation will read and write buffers in debug
 // descriptor set |desc_set|. It will write |shader_id| in each output record
 // to identify the shader module which generated the record.
-Optimizer::PassToken CreateInstBuffAddrCheckPass(uint32_t desc_set,
-                                                 uint32_t shader_id);
+// If |subgroup_stream_writes| is true and the module is SPIR-V 1.3 or later,
+// space for the output records of a subgroup is reserved with a single atomic
+// operation rather than one per invocation, reducing contention on the
+// output buffer size.
+// If |sample_period| is greater than one, only one in |sample_period|
+// eligible references is instrumented. If |sample_spec_id| is not negative,
+// every instrumented check is also gated on a boolean specialization constant
+// with that SpecId, true by default, so that checking can be switched off at
+// pipeline creation without re-instrumenting.
+// If |combine_checks| is true, references in the same block through the same
+// base pointer at constant offsets share one check covering all of their
+// bytes, and an error found by it is reported once, at the first reference.
+Optimizer::PassToken CreateInstBuffAddrCheckPass(
+    uint32_t desc_set, uint32_t shader_id, bool subgroup_stream_writes = false,
+    uint32_t sample_period = 1, int32_t sample_spec_id = -1,
+    bool combine_checks = false);
 
 // Create a pass to instrument OpDebugPrintf instructions.
 // This pass replaces all OpDebugPrintf instructions with instructions to write
@@ -797,8 +1300,26 @@ Optimizer::PassToken CreateInstBuffAddrCheckPass(uint32_t desc_set,
 // The instrumentation will write buffers in debug descriptor set |desc_set|.
 // It will write |shader_id| in each output record to identify the shader
 // module which generated the record.
-Optimizer::PassToken CreateInstDebugPrintfPass(uint32_t desc_set,
-                                               uint32_t shader_id);
+// If |subgroup_stream_writes| is true and the module is SPIR-V 1.3 or later,
+// space for the output records of a subgroup is reserved with a single atomic
+// operation rather than one per invocation, reducing contention on the
+// output buffer size.
+Optimizer::PassToken CreateInstDebugPrintfPass(
+    uint32_t desc_set, uint32_t shader_id, bool subgroup_stream_writes = false);
+
+// Create a pass to count the executions of the blocks of the module.
+// This pass adds to the start of every block an atomic increment of the
+// element of a special block profile output buffer that belongs to the block.
+// Blocks are numbered in the order they appear in the module, across all
+// functions.  The pass does not change the ids of the blocks, so the counts
+// of the instrumented module can be passed to |Optimizer::SetProfile| for
+// the original one.
+//
+// The instrumentation will write the buffer in debug descriptor set
+// |desc_set|, binding |kDebugOutputBindingBlockProfile|.  |shader_id| is
+// unused and only kept for symmetry with the other instrumentation passes.
+Optimizer::PassToken CreateInstBlockProfilePass(uint32_t desc_set,
+                                                uint32_t shader_id);
 
 // Create a pass to upgrade to the VulkanKHR memory model.
 // This pass upgrades the Logical GLSL450 memory model to Logical VulkanKHR.
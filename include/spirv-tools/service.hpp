@@ -0,0 +1,104 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef INCLUDE_SPIRV_TOOLS_SERVICE_HPP_
+#define INCLUDE_SPIRV_TOOLS_SERVICE_HPP_
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "libspirv.hpp"
+
+namespace spvtools {
+
+// Optimizes and validates modules on request, reusing its state from one
+// request to the next.  Meant to be hosted by a long-running process, such as
+// "spirv-opt --server", so that a build does not pay for starting a tool for
+// every shader.
+//
+// |Process| handles one request and may be called from several threads at
+// the same time.  |Serve| reads requests from a stream and handles them on a
+// pool of threads.  In a stream, requests and responses are sequences of
+// 32-bit words in the byte order of the host, where a string is its length in
+// bytes followed by its bytes:
+//
+//   request:  kind, number of flags, the flags as strings,
+//             number of words of the module, the words of the module
+//   response: status (0 for success, 1 for failure), the messages as a string,
+//             number of words of the module, the words of the module
+class Service {
+ public:
+  enum class RequestKind : uint32_t {
+    // Runs the passes of the flags, as |Optimizer::RegisterPassesFromFlags|
+    // accepts them, on the module.
+    kOptimize = 0,
+    // Validates the module.  No flags are accepted.
+    kValidate = 1,
+  };
+
+  struct Request {
+    RequestKind kind = RequestKind::kOptimize;
+    std::vector<std::string> flags;
+    std::vector<uint32_t> binary;
+  };
+
+  struct Response {
+    bool success = false;
+    // The messages emitted while handling the request, one per line.
+    std::string messages;
+    // The optimized module.  Empty for validation requests.
+    std::vector<uint32_t> binary;
+  };
+
+  // Creates a service for modules of |env| that handles up to |num_threads|
+  // requests of a stream at the same time.
+  Service(spv_target_env env, uint32_t num_threads);
+  ~Service();
+
+  Service(const Service&) = delete;
+  Service& operator=(const Service&) = delete;
+
+  // Sets the options of the validation requests, and of the validation the
+  // optimization requests run.  Unless |options| has a cache, the service
+  // keeps the modules it found valid in a cache of its own.  Must not be
+  // called while requests are handled.
+  void SetValidatorOptions(const ValidatorOptions& options);
+
+  // Sets the options of the optimization requests.  Their validator options
+  // are replaced by those of |SetValidatorOptions|.  Must not be called while
+  // requests are handled.
+  void SetOptimizerOptions(const OptimizerOptions& options);
+
+  // Handles |request|.
+  Response Process(const Request& request) const;
+
+  // Handles the requests read from |in| until its end, and writes their
+  // responses to |out| in the same order.  Each response is flushed as soon as
+  // it and the responses before it are done, so a client may wait for the
+  // response to a request before sending the next one.  Returns false if |in|
+  // ends in the middle of a request or |out| fails.
+  bool Serve(std::istream& in, std::ostream& out) const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace spvtools
+
+#endif  // INCLUDE_SPIRV_TOOLS_SERVICE_HPP_
@@ -19,7 +19,6 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
-#include <iterator>
 #include <limits>
 #include <string>
 #include <unordered_map>
@@ -33,6 +32,8 @@
 #include "source/operand.h"
 #include "source/spirv_constant.h"
 #include "source/spirv_endian.h"
+#include "source/util/id_map.h"
+#include "spirv-tools/libspirv.hpp"
 
 spv_result_t spvBinaryHeaderGet(const spv_const_binary binary,
                                 const spv_endianness_t endian,
@@ -84,33 +85,74 @@ class Parser {
   spv_result_t parse(const uint32_t* words, size_t num_words,
                      spv_diagnostic* diagnostic);
 
- private:
-  // All remaining methods work on the current module parse state.
+  // The following methods parse a module incrementally, as used by
+  // spvtools::BinaryReader.  The module state is kept until the next call to
+  // start or parse.
 
-  // Like the parse method, but works on the current module parse state.
-  spv_result_t parseModule();
+  // Starts the incremental parse of the specified binary SPIR-V module by
+  // parsing its header and issuing the parsed-header callback.  Returns
+  // SPV_SUCCESS on success.  Otherwise returns an error code and issues a
+  // diagnostic.
+  spv_result_t start(const uint32_t* words, size_t num_words,
+                     spv_diagnostic* diagnostic);
+
+  // Returns the header of the module being parsed.  Only valid after a
+  // successful start.
+  const spv_header_t& header() const { return _.header; }
+
+  // Returns the word offset of the next instruction to be parsed.
+  size_t position() const { return _.word_index; }
+
+  // Returns true if there are no more instructions to parse.
+  bool done() const { return _.word_index >= _.num_words; }
 
   // Parses an instruction at the current position of the binary.  Assumes
   // the header has been parsed, the endian has been set, and the word index is
   // still in range.  Advances the parsing position past the instruction, and
   // updates other parsing state for the current module.
-  // On success, returns SPV_SUCCESS and issues the parsed-instruction callback.
+  // On success, returns SPV_SUCCESS and writes the instruction to |inst|.  The
+  // operands of |inst| are only valid until the next instruction is parsed.
   // On failure, returns an error code and issues a diagnostic.
-  spv_result_t parseInstruction();
+  spv_result_t parseInstruction(spv_parsed_instruction_t* inst);
+
+  // Advances the parsing position past the instructions up to and including
+  // the next OpFunctionEnd, looking only at their first words.  Their operands
+  // are not decoded, so types, extended instruction imports and result IDs
+  // they define are not recorded.  Returns SPV_SUCCESS on success.  Otherwise
+  // returns an error code and issues a diagnostic.
+  spv_result_t skipFunction();
+
+  // Moves the parsing position to the given word offset, which is assumed to
+  // be the start of an instruction.  Returns SPV_SUCCESS if |word_index| is
+  // within the instruction stream of the module.  Otherwise returns an error
+  // code and issues a diagnostic.
+  spv_result_t seek(size_t word_index);
+
+ private:
+  // All remaining methods work on the current module parse state.
+
+  // Parses the header of the current module and sets up its parse state.
+  spv_result_t parseHeader();
+
+  // Like the parse method, but works on the current module parse state.
+  spv_result_t parseModule();
+
+  // Advances the parsing position past the instruction at the current
+  // position, looking only at its first word.  Assumes the same as
+  // parseInstruction.  On success, returns SPV_SUCCESS and writes the opcode
+  // of the skipped instruction to |opcode|.  On failure, returns an error code
+  // and issues a diagnostic.
+  spv_result_t skipInstruction(SpvOp* opcode);
 
   // Parses an instruction operand with the given type, for an instruction
-  // starting at inst_offset words into the SPIR-V binary.
-  // If the SPIR-V binary is the same endianness as the host, then the
-  // endian_converted_inst_words parameter is ignored.  Otherwise, this method
-  // appends the words for this operand, converted to host native endianness,
-  // to the end of endian_converted_inst_words.  This method also updates the
-  // expected_operands parameter, and the scalar members of the inst parameter.
+  // starting at inst_offset words into the SPIR-V binary.  This method also
+  // updates the expected_operands parameter, and the scalar members of the
+  // inst parameter.
   // On success, returns SPV_SUCCESS, advances past the operand, and pushes a
   // new entry on to the operands vector.  Otherwise returns an error code and
   // issues a diagnostic.
   spv_result_t parseOperand(size_t inst_offset, spv_parsed_instruction_t* inst,
                             const spv_operand_type_t type,
-                            std::vector<uint32_t>* endian_converted_inst_words,
                             std::vector<spv_parsed_operand_t>* operands,
                             spv_operand_pattern_t* expected_operands);
 
@@ -128,6 +170,14 @@ class Parser {
   void recordNumberType(size_t inst_offset,
                         const spv_parsed_instruction_t* inst);
 
+  // Records |type_id| as the type of the result |id|.  Returns false if |id|
+  // has already been defined.
+  bool recordTypeIdOf(uint32_t id, uint32_t type_id);
+
+  // Returns a pointer to the type recorded for the result |id|, or nullptr if
+  // |id| has not been defined.
+  const uint32_t* findTypeIdOf(uint32_t id) const;
+
   // Returns a diagnostic stream object initialized with current position in
   // the input stream, and for the given error code. Any data written to the
   // returned object will be propagated to the current parse's diagnostic
@@ -160,10 +210,11 @@ class Parser {
   // Returns the endian-corrected word at the current position.
   uint32_t peek() const { return peekAt(_.word_index); }
 
-  // Returns the endian-corrected word at the given position.
+  // Returns the endian-corrected word at the given position.  The module has
+  // already been converted to the host native endianness.
   uint32_t peekAt(size_t index) const {
     assert(index < _.num_words);
-    return spvFixWord(_.words[index], _.endian);
+    return _.words[index];
   }
 
   // Data members
@@ -191,11 +242,12 @@ class Parser {
           word_index(0),
           instruction_count(0),
           endian(),
-          requires_endian_conversion(false) {
+          original_words(words_arg),
+          header(),
+          dense_id_bound(0) {
       // Temporary storage for parser state within a single instruction.
       // Most instructions require fewer than 25 words or operands.
       operands.reserve(25);
-      endian_converted_words.reserve(25);
       expected_operands.reserve(25);
     }
     State() : State(0, 0, nullptr) {}
@@ -205,14 +257,23 @@ class Parser {
     size_t word_index;           // The current position in words.
     size_t instruction_count;    // The count of processed instructions
     spv_endianness_t endian;     // The endianness of the binary.
-    // Is the SPIR-V binary in a different endiannes from the host native
-    // endianness?
-    bool requires_endian_conversion;
+    // The words of the module, as given by the caller.  If the module is not
+    // in the host native endianness, then |words| points to a copy of them
+    // converted to the host native endianness, in |host_endian_words|.
+    const uint32_t* original_words;
+    std::vector<uint32_t> host_endian_words;
+    spv_header_t header;  // The parsed header of the module.
 
     // Maps a result ID to its type ID.  By convention:
     //  - a result ID that is a type definition maps to itself.
     //  - a result ID without a type maps to 0.  (E.g. for OpLabel)
-    std::unordered_map<uint32_t, uint32_t> id_to_type_id;
+    // The IDs below |dense_id_bound| are in |id_to_type_id|, which is indexed
+    // by ID.  The others, which can only come from an invalid ID bound or
+    // from IDs that are sparser than the words of the module, are in
+    // |sparse_id_to_type_id|.
+    size_t dense_id_bound;
+    spvtools::utils::IdMap<uint32_t> id_to_type_id;
+    std::unordered_map<uint32_t, uint32_t> sparse_id_to_type_id;
     // Maps a type ID to its number type description.
     std::unordered_map<uint32_t, NumberType> type_id_to_number_type_info;
     // Maps an ExtInstImport id to the extended instruction type.
@@ -221,7 +282,6 @@ class Parser {
 
     // Used by parseOperand
     std::vector<spv_parsed_operand_t> operands;
-    std::vector<uint32_t> endian_converted_words;
     spv_operand_pattern_t expected_operands;
   } _;
 };
@@ -238,7 +298,13 @@ spv_result_t Parser::parse(const uint32_t* words, size_t num_words,
   return result;
 }
 
-spv_result_t Parser::parseModule() {
+spv_result_t Parser::start(const uint32_t* words, size_t num_words,
+                           spv_diagnostic* diagnostic_arg) {
+  _ = State(words, num_words, diagnostic_arg);
+  return parseHeader();
+}
+
+spv_result_t Parser::parseHeader() {
   if (!_.words) return diagnostic() << "Missing module.";
 
   if (_.num_words < SPV_INDEX_INSTRUCTION)
@@ -251,16 +317,30 @@ spv_result_t Parser::parseModule() {
     return diagnostic() << "Invalid SPIR-V magic number '" << std::hex
                         << _.words[0] << "'.";
   }
-  _.requires_endian_conversion = !spvIsHostEndian(_.endian);
 
   // Process the header.
-  spv_header_t header;
+  spv_header_t& header = _.header;
   if (spvBinaryHeaderGet(&binary, _.endian, &header)) {
     // It turns out there is no way to trigger this error since the only
     // failure cases are already handled above, with better messages.
     return diagnostic(SPV_ERROR_INTERNAL)
            << "Internal error: unhandled header parse failure";
   }
+  // Every instruction defines at most one ID, so the module cannot have more
+  // IDs than words.  This bounds the storage of the ID table even if the
+  // header is corrupt.
+  _.dense_id_bound = std::min<size_t>(header.bound, _.num_words);
+  _.id_to_type_id.reserve(static_cast<uint32_t>(_.dense_id_bound));
+
+  // Convert the whole module to the host native endianness at once, rather
+  // than word by word while parsing.  Only literal strings, which are not
+  // converted, still need to be read from the original words.
+  if (!spvIsHostEndian(_.endian)) {
+    _.host_endian_words.resize(_.num_words);
+    spvFixWords(_.words, _.num_words, _.endian, _.host_endian_words.data());
+    _.words = _.host_endian_words.data();
+  }
+  header.instructions = _.words + SPV_INDEX_INSTRUCTION;
   if (parsed_header_fn_) {
     if (auto error = parsed_header_fn_(user_data_, _.endian, header.magic,
                                        header.version, header.generator,
@@ -269,10 +349,24 @@ spv_result_t Parser::parseModule() {
     }
   }
 
-  // Process the instructions.
   _.word_index = SPV_INDEX_INSTRUCTION;
-  while (_.word_index < _.num_words)
-    if (auto error = parseInstruction()) return error;
+  return SPV_SUCCESS;
+}
+
+spv_result_t Parser::parseModule() {
+  if (auto error = parseHeader()) return error;
+
+  // Process the instructions.
+  spv_parsed_instruction_t inst;
+  while (!done()) {
+    if (auto error = parseInstruction(&inst)) return error;
+
+    // Issue the callback.  The callee should know that all the storage in
+    // inst is transient, and will disappear immediately afterward.
+    if (parsed_instruction_fn_) {
+      if (auto error = parsed_instruction_fn_(user_data_, &inst)) return error;
+    }
+  }
 
   // Running off the end should already have been reported earlier.
   assert(_.word_index == _.num_words);
@@ -280,36 +374,74 @@ spv_result_t Parser::parseModule() {
   return SPV_SUCCESS;
 }
 
-spv_result_t Parser::parseInstruction() {
+spv_result_t Parser::skipInstruction(SpvOp* opcode) {
+  _.instruction_count++;
+
+  assert(_.word_index < _.num_words);
+  uint16_t inst_word_count = 0;
+  uint16_t inst_opcode = 0;
+  spvOpcodeSplit(peek(), &inst_word_count, &inst_opcode);
+  if (inst_word_count < 1) {
+    return diagnostic() << "Invalid instruction word count: "
+                        << inst_word_count;
+  }
+  if (_.word_index + inst_word_count > _.num_words) {
+    return diagnostic() << "End of input reached while skipping Op"
+                        << spvOpcodeString(inst_opcode) << " starting at word "
+                        << _.word_index << ": stated word count is "
+                        << inst_word_count << ".";
+  }
+
+  _.word_index += inst_word_count;
+  *opcode = static_cast<SpvOp>(inst_opcode);
+  return SPV_SUCCESS;
+}
+
+spv_result_t Parser::skipFunction() {
+  while (!done()) {
+    SpvOp opcode = SpvOpNop;
+    if (auto error = skipInstruction(&opcode)) return error;
+    if (opcode == SpvOpFunctionEnd) return SPV_SUCCESS;
+  }
+  return diagnostic() << "End of input reached while skipping a function: "
+                         "missing OpFunctionEnd.";
+}
+
+spv_result_t Parser::seek(size_t word_index) {
+  if (word_index < SPV_INDEX_INSTRUCTION || word_index > _.num_words) {
+    return diagnostic() << "Invalid word offset " << word_index
+                        << ": instructions are at word offsets "
+                        << SPV_INDEX_INSTRUCTION << " to " << _.num_words
+                        << ".";
+  }
+  _.word_index = word_index;
+  return SPV_SUCCESS;
+}
+
+spv_result_t Parser::parseInstruction(spv_parsed_instruction_t* inst) {
   _.instruction_count++;
 
   // The zero values for all members except for opcode are the
   // correct initial values.
-  spv_parsed_instruction_t inst = {};
+  *inst = {};
 
   const uint32_t first_word = peek();
 
-  // If the module's endianness is different from the host native endianness,
-  // then converted_words contains the the endian-translated words in the
-  // instruction.
-  _.endian_converted_words.clear();
-  _.endian_converted_words.push_back(first_word);
-
-  // After a successful parse of the instruction, the inst.operands member
+  // After a successful parse of the instruction, the inst->operands member
   // will point to this vector's storage.
   _.operands.clear();
 
   assert(_.word_index < _.num_words);
   // Decompose and check the first word.
   uint16_t inst_word_count = 0;
-  spvOpcodeSplit(first_word, &inst_word_count, &inst.opcode);
+  spvOpcodeSplit(first_word, &inst_word_count, &inst->opcode);
   if (inst_word_count < 1) {
     return diagnostic() << "Invalid instruction word count: "
                         << inst_word_count;
   }
   spv_opcode_desc opcode_desc;
-  if (grammar_.lookupOpcode(static_cast<SpvOp>(inst.opcode), &opcode_desc))
-    return diagnostic() << "Invalid opcode: " << inst.opcode;
+  if (grammar_.lookupOpcode(static_cast<SpvOp>(inst->opcode), &opcode_desc))
+    return diagnostic() << "Invalid opcode: " << inst->opcode;
 
   // Advance past the opcode word.  But remember the of the start
   // of the instruction.
@@ -324,9 +456,26 @@ spv_result_t Parser::parseInstruction() {
   // ExecutionMode), or for extended instructions that may have their
   // own operands depending on the selected extended instruction.
   _.expected_operands.clear();
-  for (auto i = 0; i < opcode_desc->numTypes; i++)
-    _.expected_operands.push_back(
-        opcode_desc->operandTypes[opcode_desc->numTypes - i - 1]);
+
+  // Instructions whose operands are all single-word ids, with one word per
+  // operand, are decoded without building the operand pattern.  This covers
+  // most arithmetic, load and store instructions.
+  const bool fixed_operands =
+      inst_word_count == opcode_desc->numTypes + 1 &&
+      spvOpcodeHasFixedIdOperands(opcode_desc);
+  if (fixed_operands) {
+    for (uint16_t i = 0; i < opcode_desc->numTypes; ++i) {
+      if (auto error = parseOperand(inst_offset, inst,
+                                    opcode_desc->operandTypes[i],
+                                    &_.operands, &_.expected_operands)) {
+        return error;
+      }
+    }
+  } else {
+    for (auto i = 0; i < opcode_desc->numTypes; i++)
+      _.expected_operands.push_back(
+          opcode_desc->operandTypes[opcode_desc->numTypes - i - 1]);
+  }
 
   while (_.word_index < inst_offset + inst_word_count) {
     const uint16_t inst_word_index = uint16_t(_.word_index - inst_offset);
@@ -342,9 +491,8 @@ spv_result_t Parser::parseInstruction() {
     spv_operand_type_t type =
         spvTakeFirstMatchableOperand(&_.expected_operands);
 
-    if (auto error =
-            parseOperand(inst_offset, &inst, type, &_.endian_converted_words,
-                         &_.operands, &_.expected_operands)) {
+    if (auto error = parseOperand(inst_offset, inst, type, &_.operands,
+                                  &_.expected_operands)) {
       return error;
     }
   }
@@ -365,39 +513,17 @@ spv_result_t Parser::parseInstruction() {
                         << " words instead.";
   }
 
-  // Check the computed length of the endian-converted words vector against
-  // the declared number of words in the instruction.  If endian conversion
-  // is required, then they should match.  If no endian conversion was
-  // performed, then the vector only contains the initial opcode/word-count
-  // word.
-  assert(!_.requires_endian_conversion ||
-         (inst_word_count == _.endian_converted_words.size()));
-  assert(_.requires_endian_conversion ||
-         (_.endian_converted_words.size() == 1));
-
-  recordNumberType(inst_offset, &inst);
-
-  if (_.requires_endian_conversion) {
-    // We must wait until here to set this pointer, because the vector might
-    // have been be resized while we accumulated its elements.
-    inst.words = _.endian_converted_words.data();
-  } else {
-    // If no conversion is required, then just point to the underlying binary.
-    // This saves time and space.
-    inst.words = _.words + inst_offset;
-  }
-  inst.num_words = inst_word_count;
+  recordNumberType(inst_offset, inst);
+
+  // Point to the underlying binary, which is in the host native endianness.
+  // This saves time and space.
+  inst->words = _.words + inst_offset;
+  inst->num_words = inst_word_count;
 
   // We must wait until here to set this pointer, because the vector might
   // have been be resized while we accumulated its elements.
-  inst.operands = _.operands.data();
-  inst.num_operands = uint16_t(_.operands.size());
-
-  // Issue the callback.  The callee should know that all the storage in inst
-  // is transient, and will disappear immediately afterward.
-  if (parsed_instruction_fn_) {
-    if (auto error = parsed_instruction_fn_(user_data_, &inst)) return error;
-  }
+  inst->operands = _.operands.data();
+  inst->num_operands = uint16_t(_.operands.size());
 
   return SPV_SUCCESS;
 }
@@ -405,7 +531,6 @@ spv_result_t Parser::parseInstruction() {
 spv_result_t Parser::parseOperand(size_t inst_offset,
                                   spv_parsed_instruction_t* inst,
                                   const spv_operand_type_t type,
-                                  std::vector<uint32_t>* words,
                                   std::vector<spv_parsed_operand_t>* operands,
                                   spv_operand_pattern_t* expected_operands) {
   const SpvOp opcode = static_cast<SpvOp>(inst->opcode);
@@ -430,10 +555,6 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
 
   const uint32_t word = peek();
 
-  // Do the words in this operand have to be converted to native endianness?
-  // True for all but literal strings.
-  bool convert_operand_endianness = true;
-
   switch (type) {
     case SPV_OPERAND_TYPE_TYPE_ID:
       if (!word)
@@ -447,15 +568,14 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
       inst->result_id = word;
       // Save the result ID to type ID mapping.
       // In the grammar, type ID always appears before result ID.
-      if (_.id_to_type_id.find(inst->result_id) != _.id_to_type_id.end())
-        return diagnostic(SPV_ERROR_INVALID_ID)
-               << "Id " << inst->result_id << " is defined more than once";
-      // Record it.
       // A regular value maps to its type.  Some instructions (e.g. OpLabel)
       // have no type Id, and will map to 0.  The result Id for a
       // type-generating instruction (e.g. OpTypeInt) maps to itself.
-      _.id_to_type_id[inst->result_id] =
-          spvOpcodeGeneratesType(opcode) ? inst->result_id : inst->type_id;
+      if (!recordTypeIdOf(inst->result_id, spvOpcodeGeneratesType(opcode)
+                                               ? inst->result_id
+                                               : inst->type_id))
+        return diagnostic(SPV_ERROR_INVALID_ID)
+               << "Id " << inst->result_id << " is defined more than once";
       break;
 
     case SPV_OPERAND_TYPE_ID:
@@ -542,13 +662,12 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
         // The literal operands have the same type as the value
         // referenced by the selector Id.
         const uint32_t selector_id = peekAt(inst_offset + 1);
-        const auto type_id_iter = _.id_to_type_id.find(selector_id);
-        if (type_id_iter == _.id_to_type_id.end() ||
-            type_id_iter->second == 0) {
+        const uint32_t* type_id_ptr = findTypeIdOf(selector_id);
+        if (type_id_ptr == nullptr || *type_id_ptr == 0) {
           return diagnostic() << "Invalid OpSwitch: selector id " << selector_id
                               << " has no type";
         }
-        uint32_t type_id = type_id_iter->second;
+        uint32_t type_id = *type_id_ptr;
 
         if (selector_id == type_id) {
           // Recall that by convention, a result ID that is a type definition
@@ -576,9 +695,8 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
 
     case SPV_OPERAND_TYPE_LITERAL_STRING:
     case SPV_OPERAND_TYPE_OPTIONAL_LITERAL_STRING: {
-      convert_operand_endianness = false;
       const char* string =
-          reinterpret_cast<const char*>(_.words + _.word_index);
+          reinterpret_cast<const char*>(_.original_words + _.word_index);
       // Compute the length of the string, but make sure we don't run off the
       // end of the input.
       const size_t remaining_input_bytes =
@@ -605,6 +723,16 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
       parsed_operand.num_words = uint16_t(string_num_words);
       parsed_operand.type = SPV_OPERAND_TYPE_LITERAL_STRING;
 
+      // Literal strings are not endian converted, so put back their original
+      // words in the converted module.
+      if (_.words != _.original_words) {
+        uint32_t* host_words = _.host_endian_words.data() + _.word_index;
+        std::copy(_.original_words + _.word_index,
+                  _.original_words + _.word_index + string_num_words,
+                  host_words);
+        string = reinterpret_cast<const char*>(host_words);
+      }
+
       if (SpvOpExtInstImport == opcode) {
         // Record the extended instruction type for the ID for this import.
         // There is only one string literal argument to OpExtInstImport,
@@ -735,21 +863,6 @@ spv_result_t Parser::parseOperand(size_t inst_offset,
   if (_.num_words < index_after_operand)
     return exhaustedInputDiagnostic(inst_offset, opcode, type);
 
-  if (_.requires_endian_conversion) {
-    // Copy instruction words.  Translate to native endianness as needed.
-    if (convert_operand_endianness) {
-      const spv_endianness_t endianness = _.endian;
-      std::transform(_.words + _.word_index, _.words + index_after_operand,
-                     std::back_inserter(*words),
-                     [endianness](const uint32_t raw_word) {
-                       return spvFixWord(raw_word, endianness);
-                     });
-    } else {
-      words->insert(words->end(), _.words + _.word_index,
-                    _.words + index_after_operand);
-    }
-  }
-
   // Advance past the operand.
   _.word_index = index_after_operand;
 
@@ -795,6 +908,22 @@ void Parser::recordNumberType(size_t inst_offset,
   }
 }
 
+bool Parser::recordTypeIdOf(uint32_t id, uint32_t type_id) {
+  if (id < _.dense_id_bound) {
+    return _.id_to_type_id.insert({id, type_id}).second;
+  }
+  return _.sparse_id_to_type_id.insert({id, type_id}).second;
+}
+
+const uint32_t* Parser::findTypeIdOf(uint32_t id) const {
+  if (id < _.dense_id_bound) {
+    auto iter = _.id_to_type_id.find(id);
+    return iter != _.id_to_type_id.end() ? &iter->second : nullptr;
+  }
+  auto iter = _.sparse_id_to_type_id.find(id);
+  return iter != _.sparse_id_to_type_id.end() ? &iter->second : nullptr;
+}
+
 }  // anonymous namespace
 
 spv_result_t spvBinaryParse(const spv_const_context context, void* user_data,
@@ -811,6 +940,96 @@ spv_result_t spvBinaryParse(const spv_const_context context, void* user_data,
   return parser.parse(code, num_words, diagnostic);
 }
 
+namespace spvtools {
+
+struct BinaryReader::Impl {
+  Impl(spv_target_env env, const uint32_t* binary_arg, size_t binary_size_arg)
+      : context(env),
+        parser(context.CContext(), nullptr, nullptr, nullptr),
+        binary(binary_arg),
+        binary_size(binary_size_arg) {}
+
+  // Parses the header if that has not been attempted yet.  Returns the status
+  // of the reader.
+  spv_result_t Start() {
+    if (!started) {
+      started = true;
+      status = parser.start(binary, binary_size, nullptr);
+    }
+    return status;
+  }
+
+  Context context;  // Provides the grammar and the message consumer.
+  Parser parser;
+  const uint32_t* binary;
+  size_t binary_size;
+  bool started = false;
+  spv_result_t status = SPV_SUCCESS;
+
+  // The last instruction read, and its word offset.
+  spv_parsed_instruction_t instruction = {};
+  size_t instruction_offset = 0;
+};
+
+BinaryReader::BinaryReader(spv_target_env env, const uint32_t* binary,
+                           size_t binary_size)
+    : impl_(new Impl(env, binary, binary_size)) {}
+
+BinaryReader::~BinaryReader() = default;
+
+void BinaryReader::SetMessageConsumer(MessageConsumer consumer) {
+  impl_->context.SetMessageConsumer(std::move(consumer));
+}
+
+bool BinaryReader::ReadHeader() { return impl_->Start() == SPV_SUCCESS; }
+
+uint32_t BinaryReader::version() const {
+  return impl_->parser.header().version;
+}
+
+uint32_t BinaryReader::generator() const {
+  return impl_->parser.header().generator;
+}
+
+uint32_t BinaryReader::id_bound() const {
+  return impl_->parser.header().bound;
+}
+
+uint32_t BinaryReader::schema() const { return impl_->parser.header().schema; }
+
+bool BinaryReader::Next() {
+  if (impl_->Start() != SPV_SUCCESS || impl_->parser.done()) return false;
+  impl_->instruction_offset = impl_->parser.position();
+  impl_->status = impl_->parser.parseInstruction(&impl_->instruction);
+  return impl_->status == SPV_SUCCESS;
+}
+
+const spv_parsed_instruction_t& BinaryReader::instruction() const {
+  return impl_->instruction;
+}
+
+size_t BinaryReader::instruction_offset() const {
+  return impl_->instruction_offset;
+}
+
+size_t BinaryReader::position() const { return impl_->parser.position(); }
+
+bool BinaryReader::Seek(size_t word_offset) {
+  if (impl_->Start() != SPV_SUCCESS) return false;
+  impl_->status = impl_->parser.seek(word_offset);
+  return impl_->status == SPV_SUCCESS;
+}
+
+bool BinaryReader::SkipFunction() {
+  if (impl_->Start() != SPV_SUCCESS) return false;
+  impl_->status = impl_->parser.skipFunction();
+  return impl_->status == SPV_SUCCESS;
+}
+
+spv_result_t BinaryReader::status() const { return impl_->status; }
+
+}  // namespace spvtools
+
 // TODO(dneto): This probably belongs in text.cpp since that's the only place
 // that a spv_binary_t value is created.
 void spvBinaryDestroy(spv_binary binary) {
@@ -820,6 +1039,14 @@ void spvBinaryDestroy(spv_binary binary) {
   }
 }
 
+void spvBinaryDestroyWithContext(const spv_const_context context,
+                                 spv_binary binary) {
+  if (binary) {
+    spvtools::DeleteOutputArray(context->allocator, binary->code);
+    spvtools::DeleteOutput(context->allocator, binary);
+  }
+}
+
 size_t spv_strnlen_s(const char* str, size_t strsz) {
   if (!str) return 0;
   for (size_t i = 0; i < strsz; i++) {
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <functional>
 #include <map>
+#include <queue>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -34,23 +35,15 @@ class CFA {
   using cbb_ptr = const BB*;
   using bb_iter = typename std::vector<BB*>::const_iterator;
   using get_blocks_func = std::function<const std::vector<BB*>*(const BB*)>;
+  using get_dominator_func = std::function<BB*(const BB*)>;
+  using get_depth_func = std::function<size_t(const BB*)>;
 
   struct block_info {
     cbb_ptr block;  ///< pointer to the block
     bb_iter iter;   ///< Iterator to the current child node being processed
+    bb_iter end;    ///< End of the successors of the block
   };
 
-  /// Returns true if a block with @p id is found in the @p work_list vector
-  ///
-  /// @param[in] work_list  Set of blocks visited in the the depth first
-  /// traversal
-  ///                       of the CFG
-  /// @param[in] id         The ID of the block being checked
-  ///
-  /// @return true if the edge work_list.back().block->id() => id is a back-edge
-  static bool FindInWorkList(const std::vector<block_info>& work_list,
-                             uint32_t id);
-
  public:
   /// @brief Depth first traversal starting from the \p entry BasicBlock
   ///
@@ -80,15 +73,18 @@ class CFA {
 
   /// @brief Calculates dominator edges for a set of blocks
   ///
-  /// Computes dominators using the algorithm of Cooper, Harvey, and Kennedy
-  /// "A Simple, Fast Dominance Algorithm", 2001.
+  /// Computes dominators using the Semi-NCA algorithm of Georgiadis, Tarjan
+  /// and Werneck, "Finding Dominators in Practice", 2006.  It is a simpler
+  /// variant of the Lengauer-Tarjan algorithm and runs in near-linear time
+  /// in the number of edges, working on arrays indexed by the position of the
+  /// blocks in the postorder vector.
   ///
   /// The algorithm assumes there is a unique root node (a node without
   /// predecessors), and it is therefore at the end of the postorder vector.
+  /// Predecessors that are not in the postorder vector are ignored.
   ///
   /// This function calculates the dominator edges for a set of blocks in the
   /// CFG.
-  /// Uses the dominator algorithm by Cooper et al.
   ///
   /// @param[in] postorder        A vector of blocks in post order traversal
   /// order
@@ -97,15 +93,114 @@ class CFA {
   /// a
   ///                             block
   ///
-  /// @return the dominator tree of the graph, as a vector of pairs of nodes.
-  /// The first node in the pair is a node in the graph. The second node in the
-  /// pair is its immediate dominator in the sense of Cooper et.al., where a
-  /// block
-  /// without predecessors (such as the root node) is its own immediate
-  /// dominator.
+  /// @return the dominator tree of the graph, as a vector of pairs of nodes,
+  /// in the order of the postorder vector.  The first node in the pair is a
+  /// node in the graph. The second node in the pair is its immediate
+  /// dominator, where the root node is its own immediate dominator.
   static std::vector<std::pair<BB*, BB*>> CalculateDominators(
       const std::vector<cbb_ptr>& postorder, get_blocks_func predecessor_func);
 
+  /// @brief Returns the postorder of a depth first traversal of a graph
+  ///
+  /// The blocks of the graph are numbered from 0 to |num_blocks| - 1, and
+  /// visited in the same order as DepthFirstTraversal would.
+  ///
+  /// @param[in] num_blocks   The number of blocks in the graph
+  /// @param[in] root         The block the traversal starts from
+  /// @param[in] successors   Callable returning a random access range of the
+  ///                         numbers of the successors of a block
+  template <class GetSuccessors>
+  static std::vector<size_t> Postorder(size_t num_blocks, size_t root,
+                                       GetSuccessors successors);
+
+  /// @brief Calculates the immediate dominators of a graph
+  ///
+  /// This is the Semi-NCA algorithm used by CalculateDominators, for graphs
+  /// whose blocks are numbered from 0 to |num_blocks| - 1.
+  ///
+  /// @param[in] num_blocks     The number of blocks in the graph
+  /// @param[in] root           The root of the graph
+  /// @param[in] successors     Callable returning a random access range of
+  ///                           the numbers of the successors of a block
+  /// @param[in] predecessors   Callable returning a range of the numbers of
+  ///                           the predecessors of a block
+  ///
+  /// @return the immediate dominator of each block, where the root is its
+  /// own immediate dominator and the blocks that the root does not reach
+  /// are |num_blocks|.
+  template <class GetSuccessors, class GetPredecessors>
+  static std::vector<size_t> CalculateDominatorIndices(
+      size_t num_blocks, size_t root, GetSuccessors successors,
+      GetPredecessors predecessors);
+
+  /// @brief Returns the nearest common dominator of two blocks
+  ///
+  /// @param[in] a, b             Blocks of the dominator tree
+  /// @param[in] dominator_func   Function returning the immediate dominator
+  ///                             of a block, or nullptr for the root
+  /// @param[in] depth_func       Function returning the depth of a block in
+  ///                             the dominator tree, the root being at 0
+  static BB* NearestCommonDominator(BB* a, BB* b,
+                                    get_dominator_func dominator_func,
+                                    get_depth_func depth_func);
+
+  /// @brief Calculates the dominator changes caused by an edge insertion
+  ///
+  /// Updates a dominator tree after the edge |from| -> |to| was added to the
+  /// CFG, using the depth-based search of Georgiadis, Italiano, Laura and
+  /// Santaroni, "An Experimental Study of Dynamic Dominators", 2016.  Only
+  /// the blocks reachable from |to| through blocks deeper than the nearest
+  /// common dominator of |from| and |to| are visited.
+  ///
+  /// Both |from| and |to| must be in the dominator tree: an edge leaving an
+  /// unreachable block changes nothing, and an edge to an unreachable block
+  /// changes the set of reachable blocks, which requires the tree to be
+  /// recomputed.
+  ///
+  /// @param[in] from, to         The inserted edge
+  /// @param[in] successor_func   Function returning the successors of a block
+  ///                             in the CFG, which includes the new edge
+  /// @param[in] dominator_func   Function returning the immediate dominator
+  ///                             of a block, or nullptr for the root
+  /// @param[in] depth_func       Function returning the depth of a block in
+  ///                             the dominator tree, the root being at 0
+  ///
+  /// @return the blocks whose immediate dominator changed, each paired with
+  /// its new immediate dominator.
+  static std::vector<std::pair<BB*, BB*>> DominatorsAfterEdgeInsertion(
+      BB* from, BB* to, get_blocks_func successor_func,
+      get_dominator_func dominator_func, get_depth_func depth_func);
+
+  /// @brief Calculates the dominator changes caused by an edge deletion
+  ///
+  /// Updates a dominator tree after the edge |from| -> |to| was removed from
+  /// the CFG.  The immediate dominators can only change in the subtree of
+  /// the nearest common dominator of |from| and |to|, so only that subtree
+  /// is recomputed.
+  ///
+  /// Both |from| and |to| must be in the dominator tree.
+  ///
+  /// @param[in] from, to           The deleted edge
+  /// @param[in] successor_func     Function returning the successors of a
+  ///                               block in the CFG, which no longer includes
+  ///                               the edge
+  /// @param[in] predecessor_func   Function returning the predecessors of a
+  ///                               block in the CFG
+  /// @param[in] dominator_func     Function returning the immediate dominator
+  ///                               of a block, or nullptr for the root and
+  ///                               the blocks that are not in the tree
+  /// @param[in] depth_func         Function returning the depth of a block in
+  ///                               the dominator tree, the root being at 0
+  /// @param[out] changes           The blocks of the recomputed subtree, each
+  ///                               paired with its immediate dominator
+  ///
+  /// @return false if |to| is no longer reachable, in which case the set of
+  /// reachable blocks changed and the tree must be recomputed.
+  static bool DominatorsAfterEdgeDeletion(
+      BB* from, BB* to, get_blocks_func successor_func,
+      get_blocks_func predecessor_func, get_dominator_func dominator_func,
+      get_depth_func depth_func, std::vector<std::pair<BB*, BB*>>* changes);
+
   // Computes a minimal set of root nodes required to traverse, in the forward
   // direction, the CFG represented by the given vector of blocks, and successor
   // and predecessor functions.  When considering adding two nodes, each having
@@ -124,136 +219,312 @@ class CFA {
       get_blocks_func succ_func, get_blocks_func pred_func);
 };
 
-template <class BB>
-bool CFA<BB>::FindInWorkList(const std::vector<block_info>& work_list,
-                             uint32_t id) {
-  for (auto& b : work_list) {
-    if (b.block->id() == id) return true;
-  }
-  return false;
-}
-
 template <class BB>
 void CFA<BB>::DepthFirstTraversal(
     const BB* entry, get_blocks_func successor_func,
     std::function<void(cbb_ptr)> preorder,
     std::function<void(cbb_ptr)> postorder,
     std::function<void(cbb_ptr, cbb_ptr)> backedge) {
-  std::unordered_set<uint32_t> processed;
+  /// Maps the ids of the processed blocks to whether the block is still in
+  /// |work_list|.
+  std::unordered_map<uint32_t, bool> processed;
 
   /// NOTE: work_list is the sequence of nodes from the root node to the node
   /// being processed in the traversal
   std::vector<block_info> work_list;
   work_list.reserve(10);
 
-  work_list.push_back({entry, std::begin(*successor_func(entry))});
-  preorder(entry);
-  processed.insert(entry->id());
+  const auto visit = [&](cbb_ptr block) {
+    preorder(block);
+    const std::vector<BB*>* successors = successor_func(block);
+    work_list.push_back(
+        {block, std::begin(*successors), std::end(*successors)});
+    processed[block->id()] = true;
+  };
+  visit(entry);
 
   while (!work_list.empty()) {
     block_info& top = work_list.back();
-    if (top.iter == end(*successor_func(top.block))) {
+    if (top.iter == top.end) {
       postorder(top.block);
+      processed[top.block->id()] = false;
       work_list.pop_back();
     } else {
       BB* child = *top.iter;
       top.iter++;
-      if (FindInWorkList(work_list, child->id())) {
+      const auto found = processed.find(child->id());
+      if (found == processed.end()) {
+        visit(child);
+      } else if (found->second) {
         backedge(top.block, child);
       }
-      if (processed.count(child->id()) == 0) {
-        preorder(child);
-        work_list.emplace_back(
-            block_info{child, std::begin(*successor_func(child))});
-        processed.insert(child->id());
+    }
+  }
+}
+
+template <class BB>
+template <class GetSuccessors>
+std::vector<size_t> CFA<BB>::Postorder(size_t num_blocks, size_t root,
+                                       GetSuccessors successors) {
+  std::vector<size_t> postorder;
+  postorder.reserve(num_blocks);
+  std::vector<bool> visited(num_blocks, false);
+  std::vector<std::pair<size_t, size_t>> stack;  // (block, next successor)
+  visited[root] = true;
+  stack.push_back({root, 0});
+  while (!stack.empty()) {
+    auto& top = stack.back();
+    const auto& succs = successors(top.first);
+    if (top.second == succs.size()) {
+      postorder.push_back(top.first);
+      stack.pop_back();
+      continue;
+    }
+    const size_t child = succs[top.second++];
+    if (visited[child]) continue;
+    visited[child] = true;
+    stack.push_back({child, 0});
+  }
+  return postorder;
+}
+
+template <class BB>
+template <class GetSuccessors, class GetPredecessors>
+std::vector<size_t> CFA<BB>::CalculateDominatorIndices(
+    size_t num_blocks, size_t root, GetSuccessors successors,
+    GetPredecessors predecessors) {
+  const size_t undefined = num_blocks;
+
+  // Number the blocks in the preorder of a depth first traversal from the
+  // root, and record the parent of each block in the spanning tree.  All the
+  // arrays below are indexed by preorder number.
+  std::vector<size_t> preorder_number(num_blocks, undefined);
+  std::vector<size_t> vertex;
+  std::vector<size_t> parent;
+  vertex.reserve(num_blocks);
+  parent.reserve(num_blocks);
+  {
+    std::vector<std::pair<size_t, size_t>> stack;  // (block, next successor)
+    preorder_number[root] = 0;
+    vertex.push_back(root);
+    parent.push_back(0);
+    stack.push_back({root, 0});
+    while (!stack.empty()) {
+      auto& top = stack.back();
+      const auto& succs = successors(top.first);
+      if (top.second == succs.size()) {
+        stack.pop_back();
+        continue;
       }
+      const size_t child = succs[top.second++];
+      if (preorder_number[child] != undefined) continue;
+      preorder_number[child] = vertex.size();
+      parent.push_back(preorder_number[top.first]);
+      vertex.push_back(child);
+      stack.push_back({child, 0});
+    }
+  }
+  const size_t num_reached = vertex.size();
+
+  // Compute semidominators, processing the blocks in reverse preorder.
+  // |ancestor| and |label| implement the link-eval forest with path
+  // compression; |ancestor| is |undefined| for the roots of the forest.
+  std::vector<size_t> semi(num_reached);
+  std::vector<size_t> label(num_reached);
+  std::vector<size_t> ancestor(num_reached, undefined);
+  for (size_t v = 0; v < num_reached; ++v) semi[v] = label[v] = v;
+  std::vector<size_t> path;
+  const auto eval = [&](size_t v) {
+    if (ancestor[v] == undefined) return v;
+    // Compress the path from |v| to the root of its tree, without recursion.
+    path.clear();
+    for (size_t u = v; ancestor[ancestor[u]] != undefined; u = ancestor[u]) {
+      path.push_back(u);
     }
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      const size_t u = *it;
+      const size_t a = ancestor[u];
+      if (semi[label[a]] < semi[label[u]]) label[u] = label[a];
+      ancestor[u] = ancestor[a];
+    }
+    return label[v];
+  };
+  for (size_t w = num_reached - 1; w > 0; --w) {
+    for (const size_t pred : predecessors(vertex[w])) {
+      const size_t v = preorder_number[pred];
+      if (v == undefined) continue;
+      const size_t u = eval(v);
+      if (semi[u] < semi[w]) semi[w] = semi[u];
+    }
+    ancestor[w] = parent[w];
+  }
+
+  // Derive the immediate dominators from the semidominators: the immediate
+  // dominator of a block is its nearest ancestor in the spanning tree whose
+  // preorder number is not above the block's semidominator.
+  std::vector<size_t> idom(parent);
+  for (size_t w = 1; w < num_reached; ++w) {
+    while (idom[w] > semi[w]) idom[w] = idom[idom[w]];
   }
+
+  std::vector<size_t> result(num_blocks, undefined);
+  for (size_t w = 0; w < num_reached; ++w) result[vertex[w]] = vertex[idom[w]];
+  return result;
 }
 
 template <class BB>
 std::vector<std::pair<BB*, BB*>> CFA<BB>::CalculateDominators(
     const std::vector<cbb_ptr>& postorder, get_blocks_func predecessor_func) {
-  struct block_detail {
-    size_t dominator;  ///< The index of blocks's dominator in post order array
-    size_t postorder_index;  ///< The index of the block in the post order array
-  };
-  const size_t undefined_dom = postorder.size();
+  const size_t num_blocks = postorder.size();
+  if (num_blocks == 0) return {};
+
+  // Blocks are identified by their index in |postorder| from here on.
+  std::unordered_map<cbb_ptr, size_t> postorder_index;
+  postorder_index.reserve(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) postorder_index[postorder[i]] = i;
+
+  // The predecessors and successors of each block, restricted to the blocks
+  // in |postorder|.
+  std::vector<std::vector<size_t>> preds(num_blocks);
+  std::vector<std::vector<size_t>> succs(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    for (const BB* pred : *predecessor_func(postorder[i])) {
+      const auto it = postorder_index.find(pred);
+      if (it == postorder_index.end()) continue;
+      preds[i].push_back(it->second);
+      succs[it->second].push_back(i);
+    }
+  }
+
+  const std::vector<size_t> idom = CalculateDominatorIndices(
+      num_blocks, num_blocks - 1,
+      [&succs](size_t i) -> const std::vector<size_t>& { return succs[i]; },
+      [&preds](size_t i) -> const std::vector<size_t>& { return preds[i]; });
+
+  std::vector<std::pair<bb_ptr, bb_ptr>> out;
+  out.reserve(num_blocks);
+  for (size_t i = 0; i < num_blocks; ++i) {
+    // NOTE: performing a const cast for convenient usage with
+    // UpdateImmediateDominators
+    // A block the root cannot reach is kept as its own immediate dominator.
+    const size_t dominator = idom[i] == num_blocks ? i : idom[i];
+    out.push_back({const_cast<BB*>(postorder[i]),
+                   const_cast<BB*>(postorder[dominator])});
+  }
+  return out;
+}
 
-  std::unordered_map<cbb_ptr, block_detail> idoms;
-  for (size_t i = 0; i < postorder.size(); i++) {
-    idoms[postorder[i]] = {undefined_dom, i};
+template <class BB>
+BB* CFA<BB>::NearestCommonDominator(BB* a, BB* b,
+                                    get_dominator_func dominator_func,
+                                    get_depth_func depth_func) {
+  size_t depth_a = depth_func(a);
+  size_t depth_b = depth_func(b);
+  for (; depth_a > depth_b; --depth_a) a = dominator_func(a);
+  for (; depth_b > depth_a; --depth_b) b = dominator_func(b);
+  while (a != b) {
+    a = dominator_func(a);
+    b = dominator_func(b);
   }
-  idoms[postorder.back()].dominator = idoms[postorder.back()].postorder_index;
-
-  bool changed = true;
-  while (changed) {
-    changed = false;
-    for (auto b = postorder.rbegin() + 1; b != postorder.rend(); ++b) {
-      const std::vector<BB*>& predecessors = *predecessor_func(*b);
-      // Find the first processed/reachable predecessor that is reachable
-      // in the forward traversal.
-      auto res = std::find_if(std::begin(predecessors), std::end(predecessors),
-                              [&idoms, undefined_dom](BB* pred) {
-                                return idoms.count(pred) &&
-                                       idoms[pred].dominator != undefined_dom;
-                              });
-      if (res == end(predecessors)) continue;
-      const BB* idom = *res;
-      size_t idom_idx = idoms[idom].postorder_index;
-
-      // all other predecessors
-      for (const auto* p : predecessors) {
-        if (idom == p) continue;
-        // Only consider nodes reachable in the forward traversal.
-        // Otherwise the intersection doesn't make sense and will never
-        // terminate.
-        if (!idoms.count(p)) continue;
-        if (idoms[p].dominator != undefined_dom) {
-          size_t finger1 = idoms[p].postorder_index;
-          size_t finger2 = idom_idx;
-          while (finger1 != finger2) {
-            while (finger1 < finger2) {
-              finger1 = idoms[postorder[finger1]].dominator;
-            }
-            while (finger2 < finger1) {
-              finger2 = idoms[postorder[finger2]].dominator;
-            }
-          }
-          idom_idx = finger1;
+  return a;
+}
+
+template <class BB>
+std::vector<std::pair<BB*, BB*>> CFA<BB>::DominatorsAfterEdgeInsertion(
+    BB* from, BB* to, get_blocks_func successor_func,
+    get_dominator_func dominator_func, get_depth_func depth_func) {
+  BB* nca = NearestCommonDominator(from, to, dominator_func, depth_func);
+  // Nothing changes if |to| dominates |from|, or if the new path to |to|
+  // goes through its immediate dominator.
+  if (nca == to || nca == dominator_func(to)) return {};
+
+  // A block is affected by the insertion, and then immediately dominated by
+  // |nca|, if it is reachable from |to| through blocks that are at least as
+  // deep as itself in the tree.  The candidates are processed from the
+  // deepest, each one searching for the shallower candidates it reaches.
+  const size_t nca_child_depth = depth_func(nca) + 1;
+  std::vector<BB*> candidates = {to};
+  // Pairs of depth and index in |candidates|.
+  std::priority_queue<std::pair<size_t, size_t>> bucket;
+  bucket.push({depth_func(to), 0});
+  std::unordered_set<cbb_ptr> visited = {to};
+  std::vector<std::pair<bb_ptr, bb_ptr>> changes;
+  std::vector<BB*> stack;
+  while (!bucket.empty()) {
+    const size_t depth = bucket.top().first;
+    BB* affected = candidates[bucket.top().second];
+    bucket.pop();
+    changes.push_back({affected, nca});
+
+    stack.push_back(affected);
+    while (!stack.empty()) {
+      const BB* block = stack.back();
+      stack.pop_back();
+      for (BB* succ : *successor_func(block)) {
+        const size_t succ_depth = depth_func(succ);
+        if (succ_depth <= nca_child_depth || !visited.insert(succ).second) {
+          continue;
+        }
+        if (succ_depth > depth) {
+          // Deeper blocks are not affected, but may lead to candidates.
+          stack.push_back(succ);
+        } else {
+          bucket.push({succ_depth, candidates.size()});
+          candidates.push_back(succ);
         }
-      }
-      if (idoms[*b].dominator != idom_idx) {
-        idoms[*b].dominator = idom_idx;
-        changed = true;
       }
     }
   }
+  return changes;
+}
 
-  std::vector<std::pair<bb_ptr, bb_ptr>> out;
-  for (auto idom : idoms) {
-    // NOTE: performing a const cast for convenient usage with
-    // UpdateImmediateDominators
-    out.push_back({const_cast<BB*>(std::get<0>(idom)),
-                   const_cast<BB*>(postorder[std::get<1>(idom).dominator])});
+template <class BB>
+bool CFA<BB>::DominatorsAfterEdgeDeletion(
+    BB* from, BB* to, get_blocks_func successor_func,
+    get_blocks_func predecessor_func, get_dominator_func dominator_func,
+    get_depth_func depth_func, std::vector<std::pair<BB*, BB*>>* changes) {
+  changes->clear();
+  BB* nca = NearestCommonDominator(from, to, dominator_func, depth_func);
+  // A simple path never uses an edge to a block dominating its source.
+  if (nca == to) return true;
+
+  if (dominator_func(to) == from) {
+    // |to| remains reachable only through a predecessor it does not dominate.
+    BB* root = to;
+    while (BB* dominator = dominator_func(root)) root = dominator;
+    bool reachable = false;
+    for (BB* pred : *predecessor_func(to)) {
+      if (pred != root && dominator_func(pred) == nullptr) continue;
+      if (NearestCommonDominator(pred, to, dominator_func, depth_func) != to) {
+        reachable = true;
+        break;
+      }
+    }
+    if (!reachable) return false;
   }
 
-  // Sort by postorder index to generate a deterministic ordering of edges.
-  std::sort(
-      out.begin(), out.end(),
-      [&idoms](const std::pair<bb_ptr, bb_ptr>& lhs,
-               const std::pair<bb_ptr, bb_ptr>& rhs) {
-        assert(lhs.first);
-        assert(lhs.second);
-        assert(rhs.first);
-        assert(rhs.second);
-        auto lhs_indices = std::make_pair(idoms[lhs.first].postorder_index,
-                                          idoms[lhs.second].postorder_index);
-        auto rhs_indices = std::make_pair(idoms[rhs.first].postorder_index,
-                                          idoms[rhs.second].postorder_index);
-        return lhs_indices < rhs_indices;
-      });
-  return out;
+  // The subtree of |nca| is made of the blocks it reaches through blocks
+  // deeper than itself.  Recompute the dominators within that subtree only.
+  const size_t depth = depth_func(nca);
+  std::unordered_map<cbb_ptr, std::vector<BB*>> subtree_successors;
+  const auto successors_in_subtree = [&](cbb_ptr block) {
+    const auto inserted = subtree_successors.emplace(block, std::vector<BB*>());
+    if (inserted.second) {
+      for (BB* succ : *successor_func(block)) {
+        if (depth_func(succ) > depth) inserted.first->second.push_back(succ);
+      }
+    }
+    return &inserted.first->second;
+  };
+  std::vector<cbb_ptr> postorder;
+  DepthFirstTraversal(
+      nca, successors_in_subtree, [](cbb_ptr) {},
+      [&postorder](cbb_ptr block) { postorder.push_back(block); },
+      [](cbb_ptr, cbb_ptr) {});
+  for (const auto& edge : CalculateDominators(postorder, predecessor_func)) {
+    if (edge.first != nca) changes->push_back(edge);
+  }
+  return true;
 }
 
 template <class BB>
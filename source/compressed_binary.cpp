@@ -0,0 +1,534 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A compact container for SPIR-V modules.  The words of each instruction are
+// coded as variable-length integers, with ids coded relative to the result id
+// of their instruction, so that most of them fit in a single byte.  Whether a
+// word is coded as an id, a literal or a string is chosen from the operands
+// the grammar gives to the opcode.  The grammar is only a guess at what each
+// word holds: any sequence of words is coded losslessly, even one that does
+// not match the grammar.
+//
+// The layout of a compressed module is:
+//   - the bytes of |kMagic|, then the format version byte |kFormatVersion|;
+//   - the fingerprint of the operand models, as 4 little-endian bytes;
+//   - the version, generator, bound and schema words of the module header,
+//     then the number of words of the module, each as a varint;
+//   - each instruction, as a varint key holding the opcode and word count,
+//     followed by the result id, if any, then the other operand words.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "source/diagnostic.h"
+#include "source/latest_version_spirv_header.h"
+#include "source/operand.h"
+#include "source/spirv_constant.h"
+#include "source/table.h"
+#include "spirv-tools/libspirv.h"
+
+namespace spvtools {
+namespace {
+
+const uint8_t kMagic[4] = {'S', 'P', 'V', 'C'};
+const uint8_t kFormatVersion = 1;
+
+// Word counts up to this value are packed into the key of an instruction.
+// Larger ones are coded as a varint after the key.
+const uint32_t kMaxPackedWordCount = 15;
+const uint32_t kWordCountBits = 4;
+
+// How an operand word is coded.
+enum class WordKind {
+  kLiteral,  // As a varint.
+  kId,       // As a zigzag varint of its distance to the reference id.
+  kString,   // As its 4 bytes, in little-endian order.
+};
+
+// The operand models of all the opcodes of the grammar, indexed by opcode.
+// They do not depend on the target environment, so that a module can be
+// decompressed for any environment.
+struct OpcodeModels {
+  OpcodeModels();
+
+  // Returns the description of |opcode|, or nullptr if it is unknown.
+  const spv_opcode_desc_t* Find(uint32_t opcode) const {
+    return opcode < descs.size() ? descs[opcode] : nullptr;
+  }
+
+  std::vector<const spv_opcode_desc_t*> descs;
+  // A hash of how the words of every opcode are coded.  Modules compressed
+  // with other models cannot be decompressed.
+  uint32_t fingerprint = 2166136261u;
+};
+
+// Returns the kind of the words of operands of |type|, for the types that are
+// not variable.
+WordKind KindOfType(spv_operand_type_t type) {
+  if (spvIsIdType(type) || type == SPV_OPERAND_TYPE_OPTIONAL_ID) {
+    return WordKind::kId;
+  }
+  if (type == SPV_OPERAND_TYPE_LITERAL_STRING ||
+      type == SPV_OPERAND_TYPE_OPTIONAL_LITERAL_STRING) {
+    return WordKind::kString;
+  }
+  return WordKind::kLiteral;
+}
+
+OpcodeModels::OpcodeModels() {
+  spv_opcode_table table = nullptr;
+  spvOpcodeTableGet(&table, SPV_ENV_UNIVERSAL_1_0);
+  uint32_t max_opcode = 0;
+  for (uint32_t i = 0; i < table->count; ++i) {
+    max_opcode = std::max(max_opcode, uint32_t(table->entries[i].opcode));
+  }
+  descs.assign(max_opcode + 1, nullptr);
+
+  auto hash = [this](uint32_t value) {
+    fingerprint = (fingerprint ^ value) * 16777619u;
+  };
+  for (uint32_t i = 0; i < table->count; ++i) {
+    const spv_opcode_desc_t& desc = table->entries[i];
+    // Aliases share the operands of the first entry of their opcode.
+    if (descs[desc.opcode]) continue;
+    descs[desc.opcode] = &desc;
+    hash(desc.opcode);
+    hash(uint32_t(desc.hasResult) << 1 | uint32_t(desc.hasType));
+    for (uint16_t j = 0; j < desc.numTypes; ++j) {
+      const spv_operand_type_t type = desc.operandTypes[j];
+      hash(spvOperandIsVariable(type) ? uint32_t(type) + 256
+                                      : uint32_t(KindOfType(type)));
+    }
+  }
+}
+
+const OpcodeModels& Models() {
+  static const OpcodeModels* models = new OpcodeModels();
+  return *models;
+}
+
+// Walks the operand types of an instruction along its words, and tells how
+// each word is coded.
+class OperandModel {
+ public:
+  explicit OperandModel(const spv_opcode_desc_t* desc) : desc_(desc) {}
+
+  // Returns the kind of the next word.  |Advance| must be called with the
+  // value of the word before the kind of the word after it is asked for.
+  WordKind Kind() const {
+    const spv_operand_type_t type = Type();
+    switch (type) {
+      case SPV_OPERAND_TYPE_VARIABLE_ID:
+        return WordKind::kId;
+      case SPV_OPERAND_TYPE_VARIABLE_LITERAL_INTEGER_ID:
+        return pair_phase_ ? WordKind::kId : WordKind::kLiteral;
+      case SPV_OPERAND_TYPE_VARIABLE_ID_LITERAL_INTEGER:
+        return pair_phase_ ? WordKind::kLiteral : WordKind::kId;
+      default:
+        return KindOfType(type);
+    }
+  }
+
+  // Moves past a word of value |word|.
+  void Advance(uint32_t word) {
+    const spv_operand_type_t type = Type();
+    if (spvOperandIsVariable(type)) {
+      // Variable operands repeat until the end of the instruction.
+      pair_phase_ = !pair_phase_;
+    } else if (KindOfType(type) != WordKind::kString || (word >> 24) == 0) {
+      // A string ends with the word holding its terminating null.
+      ++index_;
+    }
+  }
+
+ private:
+  spv_operand_type_t Type() const {
+    return desc_ && index_ < desc_->numTypes ? desc_->operandTypes[index_]
+                                             : SPV_OPERAND_TYPE_NONE;
+  }
+
+  const spv_opcode_desc_t* desc_;
+  uint16_t index_ = 0;       // The operand type of the next word.
+  bool pair_phase_ = false;  // Whether the next word ends a variable pair.
+};
+
+// Returns the index of the result id in an instruction of |desc| with
+// |word_count| words, or 0 if it has none.
+uint32_t ResultIndex(const spv_opcode_desc_t* desc, uint32_t word_count) {
+  if (!desc || !desc->hasResult) return 0;
+  const uint32_t index = desc->hasType ? 2 : 1;
+  return index < word_count ? index : 0;
+}
+
+uint32_t ZigZag(uint32_t difference) {
+  return (difference << 1) ^ (0u - (difference >> 31));
+}
+
+uint32_t UnZigZag(uint32_t code) { return (code >> 1) ^ (0u - (code & 1)); }
+
+class Encoder {
+ public:
+  explicit Encoder(std::vector<uint8_t>* out) : out_(out) {}
+
+  void Varint(uint32_t value) {
+    while (value >= 0x80) {
+      out_->push_back(uint8_t(value | 0x80));
+      value >>= 7;
+    }
+    out_->push_back(uint8_t(value));
+  }
+
+  void Byte(uint8_t byte) { out_->push_back(byte); }
+
+  void Bytes(uint32_t word) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      out_->push_back(uint8_t(word >> shift));
+    }
+  }
+
+ private:
+  std::vector<uint8_t>* out_;
+};
+
+class Decoder {
+ public:
+  Decoder(const uint8_t* data, size_t size)
+      : begin_(data), next_(data), end_(data + size) {}
+
+  // Reads |count| bytes and returns whether they are those of |bytes|.
+  bool Match(const uint8_t* bytes, size_t count) {
+    if (Remaining() < count || std::memcmp(next_, bytes, count) != 0) {
+      return false;
+    }
+    next_ += count;
+    return true;
+  }
+
+  // Reads a byte into |byte|.  Returns false if there is none.
+  bool Byte(uint8_t* byte) {
+    if (next_ == end_) return false;
+    *byte = *next_++;
+    return true;
+  }
+
+  // Reads a varint into |value|.  Returns false if there is none.
+  bool Varint(uint32_t* value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      if (next_ == end_) return false;
+      const uint8_t byte = *next_++;
+      result |= uint32_t(byte & 0x7f) << shift;
+      if (byte < 0x80) {
+        // The fifth byte only holds the top 4 bits of the value.
+        if (shift == 28 && byte > 0x0f) return false;
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Reads 4 little-endian bytes into |word|.  Returns false if there are
+  // fewer left.
+  bool Bytes(uint32_t* word) {
+    if (end_ - next_ < 4) return false;
+    *word = uint32_t(next_[0]) | uint32_t(next_[1]) << 8 |
+            uint32_t(next_[2]) << 16 | uint32_t(next_[3]) << 24;
+    next_ += 4;
+    return true;
+  }
+
+  bool AtEnd() const { return next_ == end_; }
+  size_t Remaining() const { return size_t(end_ - next_); }
+  size_t Offset() const { return size_t(next_ - begin_); }
+
+ private:
+  const uint8_t* begin_;
+  const uint8_t* next_;
+  const uint8_t* end_;
+};
+
+spv_result_t Compress(const MessageConsumer& consumer, const uint32_t* words,
+                      size_t num_words, std::vector<uint8_t>* out) {
+  spv_position_t position = {};
+  if (num_words < SPV_INDEX_INSTRUCTION ||
+      words[SPV_INDEX_MAGIC_NUMBER] != SpvMagicNumber) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "Expected a SPIR-V module in host endianness.";
+  }
+  if (num_words > std::numeric_limits<uint32_t>::max()) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "The module has too many words to be compressed.";
+  }
+
+  const OpcodeModels& models = Models();
+  out->assign(kMagic, kMagic + sizeof(kMagic));
+  Encoder encoder(out);
+  encoder.Byte(kFormatVersion);
+  encoder.Bytes(models.fingerprint);
+  for (size_t i = SPV_INDEX_VERSION_NUMBER; i < SPV_INDEX_INSTRUCTION; ++i) {
+    encoder.Varint(words[i]);
+  }
+  encoder.Varint(uint32_t(num_words));
+
+  uint32_t last_result_id = 0;
+  for (size_t i = SPV_INDEX_INSTRUCTION; i < num_words;) {
+    const uint32_t opcode = words[i] & 0xffff;
+    const uint32_t word_count = words[i] >> 16;
+    if (word_count == 0 || word_count > num_words - i) {
+      position.index = i;
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+             << "Invalid word count " << word_count << " at word " << i
+             << ".";
+    }
+    const uint32_t* inst = words + i;
+    i += word_count;
+
+    if (word_count < kMaxPackedWordCount) {
+      encoder.Varint(opcode << kWordCountBits | word_count);
+    } else {
+      encoder.Varint(opcode << kWordCountBits | kMaxPackedWordCount);
+      encoder.Varint(word_count - kMaxPackedWordCount);
+    }
+
+    const spv_opcode_desc_t* desc = models.Find(opcode);
+    const uint32_t result_index = ResultIndex(desc, word_count);
+    uint32_t reference_id = last_result_id + 1;
+    if (result_index) {
+      encoder.Varint(ZigZag(inst[result_index] - reference_id));
+      reference_id = last_result_id = inst[result_index];
+    }
+
+    OperandModel model(desc);
+    for (uint32_t j = 1; j < word_count; ++j) {
+      const uint32_t word = inst[j];
+      if (j != result_index) {
+        switch (model.Kind()) {
+          case WordKind::kLiteral:
+            encoder.Varint(word);
+            break;
+          case WordKind::kId:
+            encoder.Varint(ZigZag(reference_id - word));
+            break;
+          case WordKind::kString:
+            encoder.Bytes(word);
+            break;
+        }
+      }
+      model.Advance(word);
+    }
+  }
+  return SPV_SUCCESS;
+}
+
+// Reads the header of the compressed module read by |decoder|, up to and
+// including its number of words, into |header| and |num_words|.
+spv_result_t DecompressHeader(const MessageConsumer& consumer,
+                              Decoder* decoder,
+                              uint32_t header[SPV_INDEX_INSTRUCTION],
+                              uint32_t* num_words) {
+  spv_position_t position = {};
+  if (!decoder->Match(kMagic, sizeof(kMagic))) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "Not a compressed SPIR-V module.";
+  }
+  uint8_t format_version = 0;
+  uint32_t fingerprint = 0;
+  if (!decoder->Byte(&format_version) || format_version != kFormatVersion ||
+      !decoder->Bytes(&fingerprint)) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "Unsupported compressed SPIR-V format.";
+  }
+  if (fingerprint != Models().fingerprint) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "The module was compressed with a different SPIR-V grammar.";
+  }
+
+  header[SPV_INDEX_MAGIC_NUMBER] = SpvMagicNumber;
+  for (size_t i = SPV_INDEX_VERSION_NUMBER; i < SPV_INDEX_INSTRUCTION; ++i) {
+    if (!decoder->Varint(&header[i])) {
+      position.index = decoder->Offset();
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+             << "Truncated compressed module header.";
+    }
+  }
+  // Every word after the header takes at least one byte, which bounds the
+  // memory a corrupt module can ask for.
+  if (!decoder->Varint(num_words) || *num_words < SPV_INDEX_INSTRUCTION ||
+      *num_words - SPV_INDEX_INSTRUCTION > decoder->Remaining()) {
+    position.index = decoder->Offset();
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "Invalid word count in compressed module header.";
+  }
+  return SPV_SUCCESS;
+}
+
+// Decodes the instructions read by |decoder| into the |num_words| words of
+// |words|, after the header.
+spv_result_t DecompressInstructions(const MessageConsumer& consumer,
+                                    Decoder* decoder, uint32_t* words,
+                                    uint32_t num_words) {
+  const OpcodeModels& models = Models();
+  uint32_t last_result_id = 0;
+  uint32_t i = SPV_INDEX_INSTRUCTION;
+  for (; i < num_words && !decoder->AtEnd();) {
+    const size_t offset = decoder->Offset();
+    auto error = [&consumer, offset]() -> spv_result_t {
+      spv_position_t position = {};
+      position.index = offset;
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+             << "Corrupt compressed instruction at byte " << offset << ".";
+    };
+
+    uint32_t key = 0;
+    if (!decoder->Varint(&key)) return error();
+    const uint32_t opcode = key >> kWordCountBits;
+    uint32_t word_count = key & kMaxPackedWordCount;
+    if (word_count == kMaxPackedWordCount) {
+      uint32_t extra = 0;
+      if (!decoder->Varint(&extra)) return error();
+      word_count += extra;
+    }
+    if (opcode > 0xffff || word_count == 0 || word_count > 0xffff ||
+        word_count > num_words - i) {
+      return error();
+    }
+    uint32_t* inst = words + i;
+    i += word_count;
+    inst[0] = word_count << 16 | opcode;
+
+    const spv_opcode_desc_t* desc = models.Find(opcode);
+    const uint32_t result_index = ResultIndex(desc, word_count);
+    uint32_t reference_id = last_result_id + 1;
+    if (result_index) {
+      uint32_t code = 0;
+      if (!decoder->Varint(&code)) return error();
+      reference_id = last_result_id = reference_id + UnZigZag(code);
+      inst[result_index] = reference_id;
+    }
+
+    OperandModel model(desc);
+    for (uint32_t j = 1; j < word_count; ++j) {
+      if (j != result_index) {
+        uint32_t code = 0;
+        switch (model.Kind()) {
+          case WordKind::kLiteral:
+            if (!decoder->Varint(&inst[j])) return error();
+            break;
+          case WordKind::kId:
+            if (!decoder->Varint(&code)) return error();
+            inst[j] = reference_id - UnZigZag(code);
+            break;
+          case WordKind::kString:
+            if (!decoder->Bytes(&inst[j])) return error();
+            break;
+        }
+      }
+      model.Advance(inst[j]);
+    }
+  }
+
+  if (i != num_words || !decoder->AtEnd()) {
+    spv_position_t position = {};
+    position.index = decoder->Offset();
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "The compressed module does not have the " << num_words
+           << " words its header gives.";
+  }
+  return SPV_SUCCESS;
+}
+
+}  // namespace
+}  // namespace spvtools
+
+spv_result_t spvBinaryCompress(const spv_const_context context,
+                               const uint32_t* binary, const size_t word_count,
+                               spv_compressed_binary* compressed,
+                               spv_diagnostic* diagnostic) {
+  spv_context_t hijack_context = *context;
+  if (diagnostic) {
+    *diagnostic = nullptr;
+    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
+  }
+  if (!compressed) return SPV_ERROR_INVALID_POINTER;
+
+  std::vector<uint8_t> bytes;
+  spv_result_t result =
+      spvtools::Compress(hijack_context.consumer, binary, word_count, &bytes);
+  if (result != SPV_SUCCESS) return result;
+
+  const spv_allocator_t& allocator = hijack_context.allocator;
+  spv_compressed_binary output =
+      spvtools::NewOutput<spv_compressed_binary_t>(allocator);
+  if (!output) return SPV_ERROR_OUT_OF_MEMORY;
+  output->data = spvtools::NewOutputArray<uint8_t>(allocator, bytes.size());
+  if (!output->data) {
+    spvtools::DeleteOutput(allocator, output);
+    return SPV_ERROR_OUT_OF_MEMORY;
+  }
+  std::memcpy(output->data, bytes.data(), bytes.size());
+  output->size = bytes.size();
+  *compressed = output;
+  return SPV_SUCCESS;
+}
+
+spv_result_t spvBinaryDecompress(const spv_const_context context,
+                                 const uint8_t* data, const size_t size,
+                                 spv_binary* binary,
+                                 spv_diagnostic* diagnostic) {
+  spv_context_t hijack_context = *context;
+  if (diagnostic) {
+    *diagnostic = nullptr;
+    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, diagnostic);
+  }
+  if (!binary) return SPV_ERROR_INVALID_POINTER;
+
+  spvtools::Decoder decoder(data, size);
+  uint32_t header[SPV_INDEX_INSTRUCTION];
+  uint32_t num_words = 0;
+  spv_result_t result = spvtools::DecompressHeader(
+      hijack_context.consumer, &decoder, header, &num_words);
+  if (result != SPV_SUCCESS) return result;
+
+  const spv_allocator_t& allocator = hijack_context.allocator;
+  spv_binary output = spvtools::NewOutput<spv_binary_t>(allocator);
+  if (!output) return SPV_ERROR_OUT_OF_MEMORY;
+  output->code = spvtools::NewOutputArray<uint32_t>(allocator, num_words);
+  if (!output->code) {
+    spvtools::DeleteOutput(allocator, output);
+    return SPV_ERROR_OUT_OF_MEMORY;
+  }
+  output->wordCount = num_words;
+  std::memcpy(output->code, header, sizeof(header));
+  result = spvtools::DecompressInstructions(hijack_context.consumer, &decoder,
+                                            output->code, num_words);
+  if (result != SPV_SUCCESS) {
+    spvtools::DeleteOutputArray(allocator, output->code);
+    spvtools::DeleteOutput(allocator, output);
+    return result;
+  }
+  *binary = output;
+  return SPV_SUCCESS;
+}
+
+void spvCompressedBinaryDestroy(const spv_const_context context,
+                                spv_compressed_binary compressed) {
+  if (compressed) {
+    spvtools::DeleteOutputArray(context->allocator, compressed->data);
+    spvtools::DeleteOutput(context->allocator, compressed);
+  }
+}
@@ -26,25 +26,17 @@
 
 spv_diagnostic spvDiagnosticCreate(const spv_position position,
                                    const char* message) {
-  spv_diagnostic diagnostic = new spv_diagnostic_t;
-  if (!diagnostic) return nullptr;
-  size_t length = strlen(message) + 1;
-  diagnostic->error = new char[length];
-  if (!diagnostic->error) {
-    delete diagnostic;
-    return nullptr;
-  }
-  diagnostic->position = *position;
-  diagnostic->isTextSource = false;
-  memset(diagnostic->error, 0, length);
-  strncpy(diagnostic->error, message, length);
-  return diagnostic;
+  return spvtools::CreateDiagnostic({nullptr, nullptr, nullptr}, position,
+                                    message);
 }
 
 void spvDiagnosticDestroy(spv_diagnostic diagnostic) {
-  if (!diagnostic) return;
-  delete[] diagnostic->error;
-  delete diagnostic;
+  spvtools::DestroyDiagnostic({nullptr, nullptr, nullptr}, diagnostic);
+}
+
+void spvDiagnosticDestroyWithContext(const spv_const_context context,
+                                     spv_diagnostic diagnostic) {
+  spvtools::DestroyDiagnostic(context->allocator, diagnostic);
 }
 
 spv_result_t spvDiagnosticPrint(const spv_diagnostic diagnostic) {
@@ -71,17 +63,13 @@ spv_result_t spvDiagnosticPrint(const spv_diagnostic diagnostic) {
 namespace spvtools {
 
 DiagnosticStream::DiagnosticStream(DiagnosticStream&& other)
-    : stream_(),
+    : stream_(std::move(other.stream_)),
       position_(other.position_),
       consumer_(other.consumer_),
       disassembled_instruction_(std::move(other.disassembled_instruction_)),
       error_(other.error_) {
   // Prevent the other object from emitting output during destruction.
   other.error_ = SPV_FAILED_MATCH;
-  // Some platforms are missing support for std::ostringstream functionality,
-  // including:  move constructor, swap method.  Either would have been a
-  // better choice than copying the string.
-  stream_ << other.stream_.str();
 }
 
 DiagnosticStream::~DiagnosticStream() {
@@ -107,22 +95,49 @@ DiagnosticStream::~DiagnosticStream() {
         break;
     }
     if (disassembled_instruction_.size() > 0)
-      stream_ << std::endl << "  " << disassembled_instruction_ << std::endl;
+      *stream_ << std::endl << "  " << disassembled_instruction_ << std::endl;
+
+    consumer_(level, "input", position_, stream_->str().c_str());
+  }
+}
 
-    consumer_(level, "input", position_, stream_.str().c_str());
+spv_diagnostic CreateDiagnostic(const spv_allocator_t& allocator,
+                                const spv_position position,
+                                const char* message) {
+  spv_diagnostic diagnostic = NewOutput<spv_diagnostic_t>(allocator);
+  if (!diagnostic) return nullptr;
+  size_t length = strlen(message) + 1;
+  diagnostic->error = NewOutputArray<char>(allocator, length);
+  if (!diagnostic->error) {
+    DeleteOutput(allocator, diagnostic);
+    return nullptr;
   }
+  diagnostic->position = *position;
+  diagnostic->isTextSource = false;
+  memset(diagnostic->error, 0, length);
+  strncpy(diagnostic->error, message, length);
+  return diagnostic;
+}
+
+void DestroyDiagnostic(const spv_allocator_t& allocator,
+                       spv_diagnostic diagnostic) {
+  if (!diagnostic) return;
+  DeleteOutputArray(allocator, diagnostic->error);
+  DeleteOutput(allocator, diagnostic);
 }
 
 void UseDiagnosticAsMessageConsumer(spv_context context,
                                     spv_diagnostic* diagnostic) {
   assert(diagnostic && *diagnostic == nullptr);
 
-  auto create_diagnostic = [diagnostic](spv_message_level_t, const char*,
-                                        const spv_position_t& position,
-                                        const char* message) {
+  const spv_allocator_t allocator = context->allocator;
+  auto create_diagnostic = [diagnostic, allocator](
+                               spv_message_level_t, const char*,
+                               const spv_position_t& position,
+                               const char* message) {
     auto p = position;
-    spvDiagnosticDestroy(*diagnostic);  // Avoid memory leak.
-    *diagnostic = spvDiagnosticCreate(&p, message);
+    DestroyDiagnostic(allocator, *diagnostic);  // Avoid memory leak.
+    *diagnostic = CreateDiagnostic(allocator, &p, message);
   };
   SetContextMessageConsumer(context, std::move(create_diagnostic));
 }
@@ -15,6 +15,7 @@
 #ifndef SOURCE_DIAGNOSTIC_H_
 #define SOURCE_DIAGNOSTIC_H_
 
+#include <memory>
 #include <sstream>
 #include <string>
 
@@ -25,13 +26,15 @@ namespace spvtools {
 // A DiagnosticStream remembers the current position of the input and an error
 // code, and captures diagnostic messages via the left-shift operator.
 // If the error code is not SPV_FAILED_MATCH, then captured messages are
-// emitted during the destructor.
+// emitted during the destructor.  Without a consumer nothing is captured, so a
+// diagnostic costs no more than its error code.
 class DiagnosticStream {
  public:
   DiagnosticStream(spv_position_t position, const MessageConsumer& consumer,
                    const std::string& disassembled_instruction,
                    spv_result_t error)
-      : position_(position),
+      : stream_(consumer ? new std::ostringstream : nullptr),
+        position_(position),
         consumer_(consumer),
         disassembled_instruction_(disassembled_instruction),
         error_(error) {}
@@ -49,7 +52,7 @@ class DiagnosticStream {
   // Adds the given value to the diagnostic message to be written.
   template <typename T>
   DiagnosticStream& operator<<(const T& val) {
-    stream_ << val;
+    if (stream_) *stream_ << val;
     return *this;
   }
 
@@ -57,15 +60,27 @@ class DiagnosticStream {
   operator spv_result_t() { return error_; }
 
  private:
-  std::ostringstream stream_;
+  // The message, or nullptr if there is no consumer to emit it to.
+  std::unique_ptr<std::ostringstream> stream_;
   spv_position_t position_;
   MessageConsumer consumer_;  // Message consumer callback.
   std::string disassembled_instruction_;
   spv_result_t error_;
 };
 
+// Returns a diagnostic object for |message| at |position|, allocated with
+// |allocator|, or null if it cannot be allocated.
+spv_diagnostic CreateDiagnostic(const spv_allocator_t& allocator,
+                                const spv_position position,
+                                const char* message);
+
+// Destroys a diagnostic object returned by CreateDiagnostic with the same
+// |allocator|.  This is a no-op if |diagnostic| is null.
+void DestroyDiagnostic(const spv_allocator_t& allocator,
+                       spv_diagnostic diagnostic);
+
 // Changes the MessageConsumer in |context| to one that updates |diagnostic|
-// with the last message received.
+// with the last message received, allocated with the allocator of |context|.
 //
 // This function expects that |diagnostic| is not nullptr and its content is a
 // nullptr.
@@ -18,12 +18,16 @@
 // to text.
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstring>
-#include <iomanip>
+#include <iostream>
 #include <memory>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "source/assembly_grammar.h"
 #include "source/binary.h"
@@ -38,7 +42,9 @@
 #include "source/spirv_endian.h"
 #include "source/util/hex_float.h"
 #include "source/util/make_unique.h"
+#include "source/util/text_buffer.h"
 #include "spirv-tools/libspirv.h"
+#include "spirv-tools/libspirv.hpp"
 
 namespace {
 
@@ -55,9 +61,9 @@ class Disassembler {
                     ? kStandardIndent
                     : 0),
         comment_(spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_COMMENT, options)),
+        friendly_names_(
+            spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES, options)),
         text_(),
-        out_(print_ ? out_stream() : out_stream(text_)),
-        stream_(out_.get()),
         header_(!spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER, options)),
         show_byte_offset_(spvIsInBitfield(
             SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET, options)),
@@ -75,13 +81,23 @@ class Disassembler {
 
   // If not printing, populates text_result with the accumulated text.
   // Returns SPV_SUCCESS on success.
-  spv_result_t SaveTextResult(spv_text* text_result) const;
+  spv_result_t SaveTextResult(spv_const_context context,
+                              spv_text* text_result) const;
+
+  // Sets the byte offset of the next instruction.  This is used to disassemble
+  // a part of a module without going through its header.
+  void SetByteOffset(size_t byte_offset) { byte_offset_ = byte_offset; }
+
+  // Emits |text|, the disassembly of a part of the module, as is.
+  void EmitText(const spvtools::utils::TextBuffer& text) { text_.Append(text); }
+
+  // Returns the accumulated text, and leaves this disassembler without any.
+  // Only valid if not printing.
+  spvtools::utils::TextBuffer TakeText() { return std::move(text_); }
 
  private:
   enum { kStandardIndent = 15 };
 
-  using out_stream = spvtools::out_stream;
-
   // Emits an operand for the given instruction, where the instruction
   // is at offset words from the start of the binary.
   void EmitOperand(const spv_parsed_instruction_t& inst,
@@ -90,40 +106,56 @@ class Disassembler {
   // Emits a mask expression for the given mask word of the specified type.
   void EmitMaskOperand(const spv_operand_type_t type, const uint32_t word);
 
-  // Resets the output color, if color is turned on.
-  void ResetColor() {
-    if (color_) out_.get() << spvtools::clr::reset{print_};
+  // Emits |id| as "%" followed by its name, padded with leading spaces to
+  // |width| characters.
+  void EmitId(uint32_t id, size_t width = 0);
+
+  // Emits |count| spaces.
+  void EmitSpaces(int count) {
+    if (count > 0) text_.AppendRepeated(' ', static_cast<size_t>(count));
   }
-  // Sets the output to grey, if color is turned on.
-  void SetGrey() {
-    if (color_) out_.get() << spvtools::clr::grey{print_};
+
+  // If printing, writes the accumulated text to the standard output stream and
+  // clears it.
+  void FlushPrintedText() {
+    if (!print_) return;
+    std::cout.write(text_.data(), static_cast<std::streamsize>(text_.size()));
+    text_.Clear();
   }
-  // Sets the output to blue, if color is turned on.
-  void SetBlue() {
-    if (color_) out_.get() << spvtools::clr::blue{print_};
+
+  // Sets the output color to |Color|, if color is turned on.  On some
+  // platforms, the color of the console is changed when the color is
+  // converted to text, so the pending text is printed first.
+  template <typename Color>
+  void SetColor() {
+    if (!color_) return;
+    FlushPrintedText();
+    text_.Append(static_cast<const char*>(Color{print_}));
   }
+
+  // Resets the output color, if color is turned on.
+  void ResetColor() { SetColor<spvtools::clr::reset>(); }
+  // Sets the output to grey, if color is turned on.
+  void SetGrey() { SetColor<spvtools::clr::grey>(); }
+  // Sets the output to blue, if color is turned on.
+  void SetBlue() { SetColor<spvtools::clr::blue>(); }
   // Sets the output to yellow, if color is turned on.
-  void SetYellow() {
-    if (color_) out_.get() << spvtools::clr::yellow{print_};
-  }
+  void SetYellow() { SetColor<spvtools::clr::yellow>(); }
   // Sets the output to red, if color is turned on.
-  void SetRed() {
-    if (color_) out_.get() << spvtools::clr::red{print_};
-  }
+  void SetRed() { SetColor<spvtools::clr::red>(); }
   // Sets the output to green, if color is turned on.
-  void SetGreen() {
-    if (color_) out_.get() << spvtools::clr::green{print_};
-  }
+  void SetGreen() { SetColor<spvtools::clr::green>(); }
 
   const spvtools::AssemblyGrammar& grammar_;
   const bool print_;  // Should we also print to the standard output stream?
   const bool color_;  // Should we print in colour?
   const int indent_;  // How much to indent. 0 means don't indent
   const int comment_;        // Should we comment the source
-  spv_endianness_t endian_;  // The detected endianness of the binary.
-  std::stringstream text_;   // Captures the text, if not printing.
-  out_stream out_;  // The Output stream.  Either to text_ or standard output.
-  std::ostream& stream_;  // The output std::stream.
+  const bool friendly_names_;  // Are ids named by |name_mapper_|?
+  spv_endianness_t endian_;    // The detected endianness of the binary.
+  // Captures the text.  If printing, it only holds the text that is not yet
+  // written to the standard output stream.
+  spvtools::utils::TextBuffer text_;
   const bool header_;     // Should we output header as the leading comment?
   const bool show_byte_offset_;  // Should we print byte offset, in hex?
   size_t byte_offset_;           // The number of bytes processed so far.
@@ -141,19 +173,28 @@ spv_result_t Disassembler::HandleHeader(spv_endianness_t endian,
   if (header_) {
     const char* generator_tool =
         spvGeneratorStr(SPV_GENERATOR_TOOL_PART(generator));
-    stream_ << "; SPIR-V\n"
-            << "; Version: " << SPV_SPIRV_VERSION_MAJOR_PART(version) << "."
-            << SPV_SPIRV_VERSION_MINOR_PART(version) << "\n"
-            << "; Generator: " << generator_tool;
+    text_.Append("; SPIR-V\n; Version: ");
+    text_.AppendUnsigned(SPV_SPIRV_VERSION_MAJOR_PART(version));
+    text_.Append('.');
+    text_.AppendUnsigned(SPV_SPIRV_VERSION_MINOR_PART(version));
+    text_.Append("\n; Generator: ");
+    text_.Append(generator_tool);
     // For unknown tools, print the numeric tool value.
     if (0 == strcmp("Unknown", generator_tool)) {
-      stream_ << "(" << SPV_GENERATOR_TOOL_PART(generator) << ")";
+      text_.Append('(');
+      text_.AppendUnsigned(SPV_GENERATOR_TOOL_PART(generator));
+      text_.Append(')');
     }
     // Print the miscellaneous part of the generator word on the same
     // line as the tool name.
-    stream_ << "; " << SPV_GENERATOR_MISC_PART(generator) << "\n"
-            << "; Bound: " << id_bound << "\n"
-            << "; Schema: " << schema << "\n";
+    text_.Append("; ");
+    text_.AppendUnsigned(SPV_GENERATOR_MISC_PART(generator));
+    text_.Append("\n; Bound: ");
+    text_.AppendUnsigned(id_bound);
+    text_.Append("\n; Schema: ");
+    text_.AppendUnsigned(schema);
+    text_.Append('\n');
+    FlushPrintedText();
   }
 
   byte_offset_ = SPV_INDEX_INSTRUCTION * sizeof(uint32_t);
@@ -165,75 +206,93 @@ spv_result_t Disassembler::HandleInstruction(
     const spv_parsed_instruction_t& inst) {
   auto opcode = static_cast<SpvOp>(inst.opcode);
   if (comment_ && opcode == SpvOpFunction) {
-    stream_ << std::endl;
-    stream_ << std::string(indent_, ' ');
-    stream_ << "; Function " << name_mapper_(inst.result_id) << std::endl;
+    text_.Append('\n');
+    EmitSpaces(indent_);
+    text_.Append("; Function ");
+    text_.Append(name_mapper_(inst.result_id));
+    text_.Append('\n');
   }
   if (comment_ && !inserted_decoration_space_ &&
       spvOpcodeIsDecoration(opcode)) {
     inserted_decoration_space_ = true;
-    stream_ << std::endl;
-    stream_ << std::string(indent_, ' ');
-    stream_ << "; Annotations" << std::endl;
+    text_.Append('\n');
+    EmitSpaces(indent_);
+    text_.Append("; Annotations\n");
   }
   if (comment_ && !inserted_debug_space_ && spvOpcodeIsDebug(opcode)) {
     inserted_debug_space_ = true;
-    stream_ << std::endl;
-    stream_ << std::string(indent_, ' ');
-    stream_ << "; Debug Information" << std::endl;
+    text_.Append('\n');
+    EmitSpaces(indent_);
+    text_.Append("; Debug Information\n");
   }
   if (comment_ && !inserted_type_space_ && spvOpcodeGeneratesType(opcode)) {
     inserted_type_space_ = true;
-    stream_ << std::endl;
-    stream_ << std::string(indent_, ' ');
-    stream_ << "; Types, variables and constants" << std::endl;
+    text_.Append('\n');
+    EmitSpaces(indent_);
+    text_.Append("; Types, variables and constants\n");
   }
 
   if (inst.result_id) {
     SetBlue();
-    const std::string id_name = name_mapper_(inst.result_id);
-    if (indent_)
-      stream_ << std::setw(std::max(0, indent_ - 3 - int(id_name.size())));
-    stream_ << "%" << id_name;
+    // Align the "=" of all the instructions that fit in the indentation.
+    EmitId(inst.result_id, indent_ ? static_cast<size_t>(indent_ - 3) : 0);
     ResetColor();
-    stream_ << " = ";
+    text_.Append(" = ");
   } else {
-    stream_ << std::string(indent_, ' ');
+    EmitSpaces(indent_);
   }
 
-  stream_ << "Op" << spvOpcodeString(opcode);
+  text_.Append("Op");
+  text_.Append(spvOpcodeString(opcode));
 
   for (uint16_t i = 0; i < inst.num_operands; i++) {
     const spv_operand_type_t type = inst.operands[i].type;
     assert(type != SPV_OPERAND_TYPE_NONE);
     if (type == SPV_OPERAND_TYPE_RESULT_ID) continue;
-    stream_ << " ";
+    text_.Append(' ');
     EmitOperand(inst, i);
   }
 
   if (comment_ && opcode == SpvOpName) {
     const spv_parsed_operand_t& operand = inst.operands[0];
     const uint32_t word = inst.words[operand.offset];
-    stream_ << "  ; id %" << word;
+    text_.Append("  ; id %");
+    text_.AppendUnsigned(word);
   }
 
   if (show_byte_offset_) {
     SetGrey();
-    auto saved_flags = stream_.flags();
-    auto saved_fill = stream_.fill();
-    stream_ << " ; 0x" << std::setw(8) << std::hex << std::setfill('0')
-            << byte_offset_;
-    stream_.flags(saved_flags);
-    stream_.fill(saved_fill);
+    text_.Append(" ; 0x");
+    text_.AppendHex(byte_offset_, 8);
     ResetColor();
   }
 
   byte_offset_ += inst.num_words * sizeof(uint32_t);
 
-  stream_ << "\n";
+  text_.Append('\n');
+  FlushPrintedText();
   return SPV_SUCCESS;
 }
 
+void Disassembler::EmitId(uint32_t id, size_t width) {
+  if (friendly_names_) {
+    const std::string name = name_mapper_(id);
+    if (width > name.size() + 1) {
+      text_.AppendRepeated(' ', width - name.size() - 1);
+    }
+    text_.Append('%');
+    text_.Append(name);
+    return;
+  }
+  // Without friendly names, the name of an id is its number, which is
+  // formatted in place rather than through the name mapper.
+  size_t length = 1;
+  for (uint32_t rest = id; rest >= 10; rest /= 10) ++length;
+  if (width > length + 1) text_.AppendRepeated(' ', width - length - 1);
+  text_.Append('%');
+  text_.AppendUnsigned(id);
+}
+
 void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
                                const uint16_t operand_index) {
   assert(operand_index < inst.num_operands);
@@ -243,27 +302,27 @@ void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
     case SPV_OPERAND_TYPE_RESULT_ID:
       assert(false && "<result-id> is not supposed to be handled here");
       SetBlue();
-      stream_ << "%" << name_mapper_(word);
+      EmitId(word);
       break;
     case SPV_OPERAND_TYPE_ID:
     case SPV_OPERAND_TYPE_TYPE_ID:
     case SPV_OPERAND_TYPE_SCOPE_ID:
     case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
       SetYellow();
-      stream_ << "%" << name_mapper_(word);
+      EmitId(word);
       break;
     case SPV_OPERAND_TYPE_EXTENSION_INSTRUCTION_NUMBER: {
       spv_ext_inst_desc ext_inst;
       SetRed();
       if (grammar_.lookupExtInst(inst.ext_inst_type, word, &ext_inst) ==
           SPV_SUCCESS) {
-        stream_ << ext_inst->name;
+        text_.Append(ext_inst->name);
       } else {
         if (!spvExtInstIsNonSemantic(inst.ext_inst_type)) {
           assert(false && "should have caught this earlier");
         } else {
           // for non-semantic instruction sets we can just print the number
-          stream_ << word;
+          text_.AppendUnsigned(word);
         }
       }
     } break;
@@ -272,27 +331,33 @@ void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
       if (grammar_.lookupOpcode(SpvOp(word), &opcode_desc))
         assert(false && "should have caught this earlier");
       SetRed();
-      stream_ << opcode_desc->name;
+      text_.Append(opcode_desc->name);
     } break;
     case SPV_OPERAND_TYPE_LITERAL_INTEGER:
     case SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER: {
       SetRed();
-      spvtools::EmitNumericLiteral(&stream_, inst, operand);
+      spvtools::EmitNumericLiteral(&text_, inst, operand);
       ResetColor();
     } break;
     case SPV_OPERAND_TYPE_LITERAL_STRING: {
-      stream_ << "\"";
+      text_.Append('"');
       SetGreen();
       // Strings are always little-endian, and null-terminated.
       // Write out the characters, escaping as needed, and without copying
-      // the entire string.
+      // the entire string.  The runs of characters between the ones to escape
+      // are written at once.
       auto c_str = reinterpret_cast<const char*>(inst.words + operand.offset);
+      auto run = c_str;
       for (auto p = c_str; *p; ++p) {
-        if (*p == '"' || *p == '\\') stream_ << '\\';
-        stream_ << *p;
+        if (*p == '"' || *p == '\\') {
+          text_.Append(run, static_cast<size_t>(p - run));
+          text_.Append('\\');
+          run = p;
+        }
       }
+      text_.Append(run);
       ResetColor();
-      stream_ << '"';
+      text_.Append('"');
     } break;
     case SPV_OPERAND_TYPE_CAPABILITY:
     case SPV_OPERAND_TYPE_SOURCE_LANGUAGE:
@@ -330,7 +395,7 @@ void Disassembler::EmitOperand(const spv_parsed_instruction_t& inst,
       spv_operand_desc entry;
       if (grammar_.lookupOperand(operand.type, word, &entry))
         assert(false && "should have caught this earlier");
-      stream_ << entry->name;
+      text_.Append(entry->name);
     } break;
     case SPV_OPERAND_TYPE_FP_FAST_MATH_MODE:
     case SPV_OPERAND_TYPE_FUNCTION_CONTROL:
@@ -361,8 +426,8 @@ void Disassembler::EmitMaskOperand(const spv_operand_type_t type,
       spv_operand_desc entry;
       if (grammar_.lookupOperand(type, mask, &entry))
         assert(false && "should have caught this earlier");
-      if (num_emitted) stream_ << "|";
-      stream_ << entry->name;
+      if (num_emitted) text_.Append('|');
+      text_.Append(entry->name);
       num_emitted++;
     }
   }
@@ -371,19 +436,22 @@ void Disassembler::EmitMaskOperand(const spv_operand_type_t type,
     // of the 0 value. In many cases, that's "None".
     spv_operand_desc entry;
     if (SPV_SUCCESS == grammar_.lookupOperand(type, 0, &entry))
-      stream_ << entry->name;
+      text_.Append(entry->name);
   }
 }
 
-spv_result_t Disassembler::SaveTextResult(spv_text* text_result) const {
+spv_result_t Disassembler::SaveTextResult(spv_const_context context,
+                                          spv_text* text_result) const {
   if (!print_) {
-    size_t length = text_.str().size();
-    char* str = new char[length + 1];
+    const spv_allocator_t& allocator = context->allocator;
+    size_t length = text_.size();
+    char* str = spvtools::NewOutputArray<char>(allocator, length + 1);
     if (!str) return SPV_ERROR_OUT_OF_MEMORY;
-    strncpy(str, text_.str().c_str(), length + 1);
-    spv_text text = new spv_text_t();
+    memcpy(str, text_.data(), length);
+    str[length] = '\0';
+    spv_text text = spvtools::NewOutput<spv_text_t>(allocator);
     if (!text) {
-      delete[] str;
+      spvtools::DeleteOutputArray(allocator, str);
       return SPV_ERROR_OUT_OF_MEMORY;
     }
     text->str = str;
@@ -456,6 +524,97 @@ spv_result_t DisassembleTargetInstruction(
   return SPV_SUCCESS;
 }
 
+// Disassembles |code| like spvBinaryToText, but with the functions of the
+// module spread over up to |num_threads| threads.  The instructions before the
+// first function are disassembled first, and the function boundaries are found
+// by skipping over each function without decoding it.  Each worker then parses
+// the instructions before the first function, which define the types and
+// extended instruction sets the functions refer to, and disassembles whole
+// functions into their own buffers.  The buffers are concatenated in order, so
+// the text is the same as the one of the serial disassembler.
+//
+// Returns true and writes the text to |text_result| on success.  Returns false
+// without emitting any message if the module cannot be disassembled this way,
+// for example because it is invalid.  The caller should then disassemble it
+// serially, which reports the problem.
+bool DisassembleInParallel(spv_const_context context,
+                           const spvtools::AssemblyGrammar& grammar,
+                           const uint32_t* code, size_t word_count,
+                           uint32_t options,
+                           const spvtools::NameMapper& name_mapper,
+                           uint32_t num_threads, spv_text* text_result) {
+  const spv_const_binary_t binary = {code, word_count};
+  spv_endianness_t endian;
+  if (spvBinaryEndianness(&binary, &endian)) return false;
+
+  spvtools::BinaryReader reader(context->target_env, code, word_count);
+  if (!reader.ReadHeader()) return false;
+  Disassembler disassembler(grammar, options, name_mapper);
+  disassembler.HandleHeader(endian, reader.version(), reader.generator(),
+                            reader.id_bound(), reader.schema());
+
+  std::vector<size_t> function_offsets;
+  while (reader.Next()) {
+    if (reader.instruction().opcode == SpvOpFunction) {
+      function_offsets.push_back(reader.instruction_offset());
+      break;
+    }
+    if (disassembler.HandleInstruction(reader.instruction())) return false;
+  }
+  if (reader.status() != SPV_SUCCESS) return false;
+
+  if (!function_offsets.empty()) {
+    while (reader.SkipFunction() && reader.position() < word_count) {
+      function_offsets.push_back(reader.position());
+    }
+    if (reader.status() != SPV_SUCCESS) return false;
+  }
+  const size_t num_functions = function_offsets.size();
+  function_offsets.push_back(word_count);
+
+  std::vector<spvtools::utils::TextBuffer> function_texts(num_functions);
+  std::atomic<size_t> next_function(0);
+  std::atomic<bool> failed(false);
+  auto disassemble_functions = [&]() {
+    spvtools::BinaryReader function_reader(context->target_env, code,
+                                           word_count);
+    bool success = function_reader.ReadHeader();
+    while (success && function_reader.position() < function_offsets[0]) {
+      success = function_reader.Next();
+    }
+    for (size_t i = next_function++; success && !failed && i < num_functions;
+         i = next_function++) {
+      Disassembler function_disassembler(grammar, options, name_mapper);
+      function_disassembler.SetByteOffset(function_offsets[i] *
+                                          sizeof(uint32_t));
+      success = function_reader.Seek(function_offsets[i]);
+      while (success && function_reader.position() < function_offsets[i + 1]) {
+        success = function_reader.Next() &&
+                  function_disassembler.HandleInstruction(
+                      function_reader.instruction()) == SPV_SUCCESS;
+      }
+      function_texts[i] = function_disassembler.TakeText();
+    }
+    if (!success) failed = true;
+  };
+
+  const size_t num_workers = std::min<size_t>(num_threads, num_functions);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; ++i) {
+    workers.emplace_back(disassemble_functions);
+  }
+  if (num_functions > 0) disassemble_functions();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (failed) return false;
+
+  for (const auto& function_text : function_texts) {
+    disassembler.EmitText(function_text);
+  }
+  return disassembler.SaveTextResult(context, text_result) == SPV_SUCCESS;
+}
+
 }  // namespace
 
 spv_result_t spvBinaryToText(const spv_const_context context,
@@ -488,7 +647,45 @@ spv_result_t spvBinaryToText(const spv_const_context context,
     return error;
   }
 
-  return disassembler.SaveTextResult(pText);
+  return disassembler.SaveTextResult(&hijack_context, pText);
+}
+
+spv_result_t spvBinaryToTextParallel(const spv_const_context context,
+                                     const uint32_t* code,
+                                     const size_t wordCount,
+                                     const uint32_t options,
+                                     const uint32_t num_threads,
+                                     spv_text* pText,
+                                     spv_diagnostic* pDiagnostic) {
+  // Printing is done while disassembling, and comments depend on what
+  // precedes each instruction, so both need the serial disassembler.
+  if (num_threads <= 1 ||
+      spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_PRINT, options) ||
+      spvIsInBitfield(SPV_BINARY_TO_TEXT_OPTION_COMMENT, options)) {
+    return spvBinaryToText(context, code, wordCount, options, pText,
+                           pDiagnostic);
+  }
+
+  const spvtools::AssemblyGrammar grammar(context);
+  if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
+
+  // Generate friendly names for Ids if requested.  The name mapper is only
+  // read while disassembling, so the workers can share it.
+  std::unique_ptr<spvtools::FriendlyNameMapper> friendly_mapper;
+  spvtools::NameMapper name_mapper = spvtools::GetTrivialNameMapper();
+  if (options & SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES) {
+    friendly_mapper = spvtools::MakeUnique<spvtools::FriendlyNameMapper>(
+        context, code, wordCount);
+    name_mapper = friendly_mapper->GetNameMapper();
+  }
+
+  if (DisassembleInParallel(context, grammar, code, wordCount, options,
+                            name_mapper, num_threads, pText)) {
+    if (pDiagnostic) *pDiagnostic = nullptr;
+    return SPV_SUCCESS;
+  }
+  return spvBinaryToText(context, code, wordCount, options, pText,
+                         pDiagnostic);
 }
 
 std::string spvtools::spvInstructionBinaryToText(const spv_target_env env,
@@ -521,7 +718,7 @@ std::string spvtools::spvInstructionBinaryToText(const spv_target_env env,
 
   spv_text text = nullptr;
   std::string output;
-  if (disassembler.SaveTextResult(&text) == SPV_SUCCESS) {
+  if (disassembler.SaveTextResult(context, &text) == SPV_SUCCESS) {
     output.assign(text->str, text->str + text->length);
     // Drop trailing newline characters.
     while (!output.empty() && output.back() == '\n') output.pop_back();
@@ -15,6 +15,7 @@
 #include "source/ext_inst.h"
 
 #include <cstring>
+#include <vector>
 
 // DebugInfo extended instruction set.
 // See https://www.khronos.org/registry/spir-v/specs/1.0/DebugInfo.html
@@ -25,6 +26,7 @@
 #include "source/latest_version_opencl_std_header.h"
 #include "source/macro.h"
 #include "source/spirv_definition.h"
+#include "source/util/name_index.h"
 
 #include "debuginfo.insts.inc"
 #include "glsl.std.450.insts.inc"
@@ -161,9 +163,29 @@ spv_result_t spvExtInstTableNameLookup(const spv_ext_inst_table table,
   if (!table) return SPV_ERROR_INVALID_TABLE;
   if (!pEntry) return SPV_ERROR_INVALID_POINTER;
 
+  // The names of each extended instruction set of the static table are
+  // indexed on first use.  Other tables are searched linearly.
+  static const auto* indices = [] {
+    auto* result = new std::vector<spvtools::utils::NameIndex>();
+    result->reserve(kTable_1_0.count);
+    for (uint32_t groupIndex = 0; groupIndex < kTable_1_0.count; groupIndex++) {
+      const auto& group = kTable_1_0.groups[groupIndex];
+      result->emplace_back(group.entries, group.count);
+    }
+    return result;
+  }();
+
   for (uint32_t groupIndex = 0; groupIndex < table->count; groupIndex++) {
     const auto& group = table->groups[groupIndex];
     if (type != group.type) continue;
+    if (table == &kTable_1_0) {
+      size_t index = 0;
+      if ((*indices)[groupIndex].Find(name, strlen(name), &index)) {
+        *pEntry = &group.entries[index];
+        return SPV_SUCCESS;
+      }
+      continue;
+    }
     for (uint32_t index = 0; index < group.count; index++) {
       const auto& entry = group.entries[index];
       if (!strcmp(name, entry.name)) {
@@ -0,0 +1,141 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/available_instructions.h"
+
+#include <cassert>
+
+namespace spvtools {
+namespace fuzz {
+
+AvailableInstructions::AvailableInstructions(
+    opt::IRContext* ir_context,
+    const std::function<bool(opt::IRContext*, opt::Instruction*)>&
+        predicate) {
+  // Consider all global declarations.
+  for (auto& global : ir_context->module()->types_values()) {
+    if (predicate(ir_context, &global)) {
+      globals_.push_back(&global);
+    }
+  }
+
+  for (auto& function : *ir_context->module()) {
+    // Consider the function parameters.
+    auto& parameters = parameters_[&function];
+    function.ForEachParam(
+        [ir_context, &predicate, &parameters](opt::Instruction* param) {
+          if (predicate(ir_context, param)) {
+            parameters.push_back(param);
+          }
+        });
+
+    // Consider the reachable blocks.  Blocks in a function appear before all
+    // blocks they dominate, so the information for the immediate dominator of
+    // a block is always available when the block itself is reached.
+    const auto* dominator_analysis =
+        ir_context->GetDominatorAnalysis(&function);
+    for (auto& block : function) {
+      if (!dominator_analysis->IsReachable(&block)) {
+        continue;
+      }
+      auto& block_info = block_info_[&block];
+      block_info.parameters = &parameters;
+      auto* immediate_dominator =
+          dominator_analysis->ImmediateDominator(&block);
+      if (immediate_dominator == nullptr) {
+        block_info.immediate_dominator = nullptr;
+        block_info.num_available_at_entry =
+            static_cast<uint32_t>(globals_.size() + parameters.size());
+      } else {
+        assert(block_info_.count(immediate_dominator) &&
+               "Dominators must appear before the blocks they dominate.");
+        const auto& dominator_info = block_info_.at(immediate_dominator);
+        block_info.immediate_dominator = &dominator_info;
+        block_info.num_available_at_entry =
+            dominator_info.num_available_at_entry +
+            static_cast<uint32_t>(dominator_info.generated.size());
+      }
+      for (auto& inst : block) {
+        instruction_position_[&inst] = {
+            &block_info, static_cast<uint32_t>(block_info.generated.size())};
+        if (predicate(ir_context, &inst)) {
+          block_info.generated.push_back(&inst);
+        }
+      }
+    }
+  }
+}
+
+AvailableInstructions::AvailableBeforeInstruction
+AvailableInstructions::GetAvailableBeforeInstruction(
+    opt::Instruction* inst) const {
+  assert(IsIndexed(inst) && "The instruction must be in a reachable block.");
+  const auto& position = instruction_position_.at(inst);
+  return AvailableBeforeInstruction(
+      this, position.block_info,
+      position.block_info->num_available_at_entry +
+          position.num_generated_before);
+}
+
+opt::Instruction* AvailableInstructions::AvailableBeforeInstruction::operator[](
+    uint32_t index) const {
+  assert(index < size_ && "Index out of bounds.");
+  if (index < owner_->globals_.size()) {
+    return owner_->globals_[index];
+  }
+  const auto& parameters = *block_info_->parameters;
+  if (index < owner_->globals_.size() + parameters.size()) {
+    return parameters[index - owner_->globals_.size()];
+  }
+  // Find the outermost block in the dominator chain whose entry count does not
+  // exceed |index|; the instruction is then generated by that block.
+  auto* block_info = block_info_;
+  while (index < block_info->num_available_at_entry) {
+    block_info = block_info->immediate_dominator;
+    assert(block_info && "The globals and parameters should have been found.");
+  }
+  return block_info->generated[index - block_info->num_available_at_entry];
+}
+
+void AvailableInstructions::AvailableBeforeInstruction::ForEach(
+    const std::function<void(opt::Instruction*)>& f) const {
+  for (auto* global : owner_->globals_) {
+    f(global);
+  }
+  for (auto* parameter : *block_info_->parameters) {
+    f(parameter);
+  }
+  // Visit the blocks of the dominator chain outermost first, so that the
+  // instructions are visited in index order.
+  std::vector<const BlockInfo*> dominator_chain;
+  for (auto* block_info = block_info_; block_info != nullptr;
+       block_info = block_info->immediate_dominator) {
+    dominator_chain.push_back(block_info);
+  }
+  for (auto it = dominator_chain.rbegin(); it != dominator_chain.rend();
+       ++it) {
+    const auto* block_info = *it;
+    // Only a prefix of the innermost block is available.
+    const uint32_t num_generated =
+        block_info == block_info_
+            ? size_ - block_info->num_available_at_entry
+            : static_cast<uint32_t>(block_info->generated.size());
+    for (uint32_t i = 0; i < num_generated; i++) {
+      f(block_info->generated[i]);
+    }
+  }
+}
+
+}  // namespace fuzz
+}  // namespace spvtools
@@ -0,0 +1,149 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_FUZZ_AVAILABLE_INSTRUCTIONS_H_
+#define SOURCE_FUZZ_AVAILABLE_INSTRUCTIONS_H_
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/instruction.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace fuzz {
+
+// A class for efficiently querying the instructions satisfying a given
+// predicate that are available before a given instruction.  The module is
+// walked once, when the index is constructed; afterwards, the set of available
+// instructions at any point of a reachable block is represented implicitly, as
+// a prefix of the global instructions, the function parameters, the
+// instructions of the dominating blocks (outermost first) and the earlier
+// instructions of the block itself.
+//
+// The index is a snapshot: instructions added to the module after it has been
+// constructed are not known to it.  Since adding instructions does not change
+// which of the existing instructions dominate one another, the index remains
+// accurate for passes that only add instructions, as long as they only query
+// instructions that existed when it was built.
+class AvailableInstructions {
+  struct BlockInfo;
+
+ public:
+  // Captures the instructions that are available before a particular
+  // instruction.  Only valid while the AvailableInstructions object from which
+  // it was obtained is alive.
+  class AvailableBeforeInstruction {
+   public:
+    // Returns the number of instructions that are available.
+    uint32_t size() const { return size_; }
+
+    // Returns true if and only if |size()| is 0.
+    bool empty() const { return size_ == 0; }
+
+    // Requires |index| < |size()|.  Returns the |index|th available
+    // instruction.
+    opt::Instruction* operator[](uint32_t index) const;
+
+    // Invokes |f| on each available instruction, in index order.  This is
+    // cheaper than using the [] operator on every index, which walks the
+    // dominator tree for each lookup.
+    void ForEach(const std::function<void(opt::Instruction*)>& f) const;
+
+   private:
+    friend class AvailableInstructions;
+
+    AvailableBeforeInstruction(const AvailableInstructions* owner,
+                               const BlockInfo* block_info, uint32_t size)
+        : owner_(owner), block_info_(block_info), size_(size) {}
+
+    // The index from which this object was obtained.
+    const AvailableInstructions* owner_;
+
+    // The block containing the instruction.
+    const BlockInfo* block_info_;
+
+    // The number of available instructions.
+    uint32_t size_;
+  };
+
+  // Builds the index for all reachable blocks of |ir_context|, considering
+  // only those instructions that satisfy |predicate|.
+  AvailableInstructions(
+      opt::IRContext* ir_context,
+      const std::function<bool(opt::IRContext*, opt::Instruction*)>&
+          predicate);
+
+  AvailableInstructions(const AvailableInstructions&) = delete;
+  AvailableInstructions& operator=(const AvailableInstructions&) = delete;
+
+  // Requires that |inst| was in a reachable block when the index was
+  // constructed.  Returns the instructions satisfying the predicate that are
+  // available before |inst|.
+  AvailableBeforeInstruction GetAvailableBeforeInstruction(
+      opt::Instruction* inst) const;
+
+  // Returns true if and only if |inst| is known to the index, i.e. it was in a
+  // reachable block when the index was constructed.
+  bool IsIndexed(opt::Instruction* inst) const {
+    return instruction_position_.count(inst) != 0;
+  }
+
+ private:
+  // Availability information for a reachable block.
+  struct BlockInfo {
+    // The entry for the immediate dominator of the block, or null for the
+    // entry block of a function.
+    const BlockInfo* immediate_dominator;
+
+    // The parameters of the enclosing function that satisfy the predicate.
+    const std::vector<opt::Instruction*>* parameters;
+
+    // The number of instructions satisfying the predicate that are available
+    // on entry to the block: the globals, the parameters and the instructions
+    // of all strictly dominating blocks.
+    uint32_t num_available_at_entry;
+
+    // The instructions of the block that satisfy the predicate, in order.
+    std::vector<opt::Instruction*> generated;
+  };
+
+  // Where an instruction sits in the index: its block, and the number of
+  // instructions of the block before it that satisfy the predicate.
+  struct InstructionPosition {
+    const BlockInfo* block_info;
+    uint32_t num_generated_before;
+  };
+
+  // The global instructions that satisfy the predicate.
+  std::vector<opt::Instruction*> globals_;
+
+  // For each function, its parameters that satisfy the predicate.
+  std::unordered_map<const opt::Function*, std::vector<opt::Instruction*>>
+      parameters_;
+
+  // Availability information for each reachable block.
+  std::unordered_map<const opt::BasicBlock*, BlockInfo> block_info_;
+
+  // The position of every instruction of every reachable block.
+  std::unordered_map<const opt::Instruction*, InstructionPosition>
+      instruction_position_;
+};
+
+}  // namespace fuzz
+}  // namespace spvtools
+
+#endif  // SOURCE_FUZZ_AVAILABLE_INSTRUCTIONS_H_
@@ -15,9 +15,11 @@
 #ifndef SOURCE_FUZZ_EQUIVALENCE_RELATION_H_
 #define SOURCE_FUZZ_EQUIVALENCE_RELATION_H_
 
+#include <cassert>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
-#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "source/util/make_unique.h"
@@ -32,20 +34,21 @@ namespace fuzz {
 // of type |T|.
 //
 // A disjoint-set (a.k.a. union-find or merge-find) data structure is used to
-// represent the equivalence relation.  Path compression is used.  Union by
-// rank/size is not used.
+// represent the equivalence relation.  Path compression and union by rank are
+// used.
 //
-// Each disjoint set is represented as a tree, rooted at the representative
-// of the set.
+// Each value is identified by a dense index, in order of registration, and the
+// union-find forest is stored in vectors indexed by these indices.
 //
-// Getting the representative of a value simply requires chasing parent pointers
+// Getting the representative of a value simply requires chasing parent indices
 // from the value until you reach the root.
 //
 // Checking equivalence of two elements requires checking that the
 // representatives are equal.
 //
-// Traversing the tree rooted at a value's representative visits the value's
-// equivalence class.
+// The members of each equivalence class are also linked into a circular list,
+// and merging two classes splices their lists together.  Walking the list of a
+// value visits the value's equivalence class without allocating.
 //
 // |PointerHashT| and |PointerEqualsT| are used to define *equality* between
 // values, and otherwise are *not* used to define the equivalence relation
@@ -61,13 +64,29 @@ namespace fuzz {
 //
 // Each unique (up to equality) value added to the relation is copied into
 // |owned_values_|, so there is one canonical memory address per unique value.
-// Uniqueness is ensured by storing (and checking) a set of pointers to these
-// values in |value_set_|, which uses |PointerHashT| and |PointerEqualsT|.
-//
-// |parent_| and |children_| encode the equivalence relation, i.e., the trees.
+// Uniqueness is ensured by mapping pointers to these values to their indices
+// in |index_of_|, which uses |PointerHashT| and |PointerEqualsT|.
 template <typename T, typename PointerHashT, typename PointerEqualsT>
 class EquivalenceRelation {
  public:
+  EquivalenceRelation() = default;
+
+  // Constructs a deep copy of |other|: the values are copied, and the forest
+  // of the copy has the same shape as that of |other|.
+  EquivalenceRelation(const EquivalenceRelation& other)
+      : parent_(other.parent_),
+        rank_(other.rank_),
+        next_(other.next_),
+        size_(other.size_) {
+    for (auto& value : other.owned_values_) {
+      owned_values_.push_back(MakeUnique<T>(*value));
+      index_of_[owned_values_.back().get()] =
+          static_cast<uint32_t>(owned_values_.size() - 1);
+    }
+  }
+
+  EquivalenceRelation& operator=(const EquivalenceRelation&) = delete;
+
   // Requires that |value1| and |value2| are already registered in the
   // equivalence relation.  Merges the equivalence classes associated with
   // |value1| and |value2|.
@@ -77,26 +96,24 @@ class EquivalenceRelation {
     assert(Exists(value2) &&
            "Precondition: value2 must already be registered.");
 
-    // Look up canonical pointers to each of the values in the value pool.
-    const T* value1_ptr = *value_set_.find(&value1);
-    const T* value2_ptr = *value_set_.find(&value2);
-
-    // If the values turn out to be identical, they are already in the same
-    // equivalence class so there is nothing to do.
-    if (value1_ptr == value2_ptr) {
-      return;
-    }
-
     // Find the representative for each value's equivalence class, and if they
     // are not already in the same class, make one the parent of the other.
-    const T* representative1 = Find(value1_ptr);
-    const T* representative2 = Find(value2_ptr);
-    assert(representative1 && "Representatives should never be null.");
-    assert(representative2 && "Representatives should never be null.");
-    if (representative1 != representative2) {
-      parent_[representative1] = representative2;
-      children_[representative2].push_back(representative1);
+    // The class of |value2| absorbs that of |value1| unless the tree of the
+    // latter is deeper.
+    uint32_t representative1 = FindIndex(index_of_.at(&value1));
+    uint32_t representative2 = FindIndex(index_of_.at(&value2));
+    if (representative1 == representative2) {
+      return;
+    }
+    if (rank_[representative1] > rank_[representative2]) {
+      std::swap(representative1, representative2);
+    } else if (rank_[representative1] == rank_[representative2]) {
+      rank_[representative2]++;
     }
+    parent_[representative1] = representative2;
+    size_[representative2] += size_[representative1];
+    // Splice the circular member lists of the two classes.
+    std::swap(next_[representative1], next_[representative2]);
   }
 
   // Requires that |value| is not known to the equivalence relation. Registers
@@ -106,16 +123,17 @@ class EquivalenceRelation {
     assert(!Exists(value));
 
     // This relies on T having a copy constructor.
-    auto unique_pointer_to_value = MakeUnique<T>(value);
-    auto pointer_to_value = unique_pointer_to_value.get();
-    owned_values_.push_back(std::move(unique_pointer_to_value));
-    value_set_.insert(pointer_to_value);
+    const auto index = static_cast<uint32_t>(owned_values_.size());
+    owned_values_.push_back(MakeUnique<T>(value));
+    const T* pointer_to_value = owned_values_.back().get();
+    index_of_[pointer_to_value] = index;
 
-    // Initially say that the value is its own parent and that it has no
-    // children.
-    assert(pointer_to_value && "Representatives should never be null.");
-    parent_[pointer_to_value] = pointer_to_value;
-    children_[pointer_to_value] = std::vector<const T*>();
+    // Initially say that the value is its own parent and the only member of
+    // its class.
+    parent_.push_back(index);
+    rank_.push_back(0);
+    next_.push_back(index);
+    size_.push_back(1);
 
     return pointer_to_value;
   }
@@ -123,47 +141,62 @@ class EquivalenceRelation {
   // Returns exactly one representative per equivalence class.
   std::vector<const T*> GetEquivalenceClassRepresentatives() const {
     std::vector<const T*> result;
-    for (auto& value : owned_values_) {
-      if (parent_[value.get()] == value.get()) {
-        result.push_back(value.get());
+    for (uint32_t i = 0; i < parent_.size(); i++) {
+      if (parent_[i] == i) {
+        result.push_back(owned_values_[i].get());
       }
     }
     return result;
   }
 
   // Returns pointers to all values in the equivalence class of |value|, which
-  // must already be part of the equivalence relation.
+  // must already be part of the equivalence relation.  The representative of
+  // the class comes first.
   std::vector<const T*> GetEquivalenceClass(const T& value) const {
     assert(Exists(value));
 
+    const uint32_t representative = FindIndex(index_of_.at(&value));
     std::vector<const T*> result;
-
-    // Traverse the tree of values rooted at the representative of the
-    // equivalence class to which |value| belongs, and collect up all the values
-    // that are encountered.  This constitutes the whole equivalence class.
-    std::vector<const T*> stack;
-    stack.push_back(Find(*value_set_.find(&value)));
-    while (!stack.empty()) {
-      const T* item = stack.back();
-      result.push_back(item);
-      stack.pop_back();
-      for (auto child : children_[item]) {
-        stack.push_back(child);
-      }
-    }
+    result.reserve(size_[representative]);
+    ForEachInEquivalenceClass(
+        *owned_values_[representative],
+        [&result](const T* member) { result.push_back(member); });
     return result;
   }
 
+  // Applies |f| to a pointer to each value in the equivalence class of
+  // |value|, which must already be part of the equivalence relation, in the
+  // order used by GetEquivalenceClass.  Does not allocate.
+  template <typename FunctionT>
+  void ForEachInEquivalenceClass(const T& value, FunctionT f) const {
+    assert(Exists(value));
+
+    const uint32_t representative = FindIndex(index_of_.at(&value));
+    uint32_t member = representative;
+    do {
+      f(owned_values_[member].get());
+      member = next_[member];
+    } while (member != representative);
+  }
+
+  // Returns the number of values in the equivalence class of |value|, which
+  // must already be part of the equivalence relation.
+  uint32_t GetEquivalenceClassSize(const T& value) const {
+    assert(Exists(value));
+    return size_[FindIndex(index_of_.at(&value))];
+  }
+
   // Returns true if and only if |value1| and |value2| are in the same
   // equivalence class.  Both values must already be known to the equivalence
   // relation.
   bool IsEquivalent(const T& value1, const T& value2) const {
-    return Find(&value1) == Find(&value2);
+    return FindIndex(index_of_.at(&value1)) == FindIndex(index_of_.at(&value2));
   }
 
   // Returns all values known to be part of the equivalence relation.
   std::vector<const T*> GetAllKnownValues() const {
     std::vector<const T*> result;
+    result.reserve(owned_values_.size());
     for (auto& value : owned_values_) {
       result.push_back(value.get());
     }
@@ -173,7 +206,14 @@ class EquivalenceRelation {
   // Returns true if and only if |value| is known to be part of the equivalence
   // relation.
   bool Exists(const T& value) const {
-    return value_set_.find(&value) != value_set_.end();
+    return index_of_.find(&value) != index_of_.end();
+  }
+
+  // Returns the canonical pointer to |value|, which must already be known to
+  // the equivalence relation.
+  const T* GetCanonicalPointer(const T& value) const {
+    assert(Exists(value));
+    return owned_values_[index_of_.at(&value)].get();
   }
 
   // Returns the representative of the equivalence class of |value|, which must
@@ -181,61 +221,48 @@ class EquivalenceRelation {
   // in a classic union-find data structure.
   const T* Find(const T* value) const {
     assert(Exists(*value));
+    return owned_values_[FindIndex(index_of_.at(value))].get();
+  }
 
-    // Get the canonical pointer to the value from the value pool.
-    const T* known_value = *value_set_.find(value);
-    assert(parent_[known_value] && "Every known value should have a parent.");
-
-    // Compute the result by chasing parents until we find a value that is its
-    // own parent.
-    const T* result = known_value;
+ private:
+  // Returns the index of the representative of the value with index |index|,
+  // compressing the path from the value to the representative on the way.
+  uint32_t FindIndex(uint32_t index) const {
+    uint32_t result = index;
     while (parent_[result] != result) {
       result = parent_[result];
     }
-    assert(result && "Representatives should never be null.");
-
-    // At this point, |result| is the representative of the equivalence class.
-    // Now perform the 'path compression' optimization by doing another pass up
-    // the parent chain, setting the parent of each node to be the
-    // representative, and rewriting children correspondingly.
-    const T* current = known_value;
-    while (parent_[current] != result) {
-      const T* next = parent_[current];
-      parent_[current] = result;
-      children_[result].push_back(current);
-      auto child_iterator =
-          std::find(children_[next].begin(), children_[next].end(), current);
-      assert(child_iterator != children_[next].end() &&
-             "'next' is the parent of 'current', so 'current' should be a "
-             "child of 'next'");
-      children_[next].erase(child_iterator);
-      current = next;
+    while (parent_[index] != result) {
+      const uint32_t next = parent_[index];
+      parent_[index] = result;
+      index = next;
     }
     return result;
   }
 
- private:
-  // Maps every value to a parent.  The representative of an equivalence class
-  // is its own parent.  A value's representative can be found by walking its
-  // chain of ancestors.
+  // Maps every value index to the index of a parent.  The representative of
+  // an equivalence class is its own parent.
   //
   // Mutable because the intuitively const method, 'Find', performs path
   // compression.
-  mutable std::unordered_map<const T*, const T*> parent_;
+  mutable std::vector<uint32_t> parent_;
 
-  // Stores the children of each value.  This allows the equivalence class of
-  // a value to be calculated by traversing all descendents of the class's
-  // representative.
-  //
-  // Mutable because the intuitively const method, 'Find', performs path
-  // compression.
-  mutable std::unordered_map<const T*, std::vector<const T*>> children_;
+  // An upper bound on the height of the tree rooted at each representative.
+  std::vector<uint32_t> rank_;
+
+  // Links the members of each equivalence class into a circular list.
+  std::vector<uint32_t> next_;
+
+  // The number of members of the class of each representative; meaningless
+  // for other values.
+  std::vector<uint32_t> size_;
 
   // The values known to the equivalence relation are allocated in
-  // |owned_values_|, and |value_pool_| provides (via |PointerHashT| and
-  // |PointerEqualsT|) a means for mapping a value of interest to a pointer
-  // into an equivalent value in |owned_values_|.
-  std::unordered_set<const T*, PointerHashT, PointerEqualsT> value_set_;
+  // |owned_values_|, in order of registration, and |index_of_| provides (via
+  // |PointerHashT| and |PointerEqualsT|) a means for mapping a value of
+  // interest to the index of an equal value in |owned_values_|.
+  std::unordered_map<const T*, uint32_t, PointerHashT, PointerEqualsT>
+      index_of_;
   std::vector<std::unique_ptr<T>> owned_values_;
 };
 
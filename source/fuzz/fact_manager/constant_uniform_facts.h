@@ -30,6 +30,10 @@ class ConstantUniformFacts {
  public:
   explicit ConstantUniformFacts(opt::IRContext* ir_context);
 
+  // Constructs a copy of |other| that refers to |ir_context| instead.
+  ConstantUniformFacts(const ConstantUniformFacts& other,
+                       opt::IRContext* ir_context);
+
   // See method in FactManager which delegates to this method.
   bool MaybeAddFact(const protobufs::FactConstantUniform& fact);
 
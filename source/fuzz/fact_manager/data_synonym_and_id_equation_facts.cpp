@@ -55,6 +55,26 @@ DataSynonymAndIdEquationFacts::DataSynonymAndIdEquationFacts(
     opt::IRContext* ir_context)
     : ir_context_(ir_context) {}
 
+DataSynonymAndIdEquationFacts::DataSynonymAndIdEquationFacts(
+    const DataSynonymAndIdEquationFacts& other, opt::IRContext* ir_context)
+    : synonymous_(other.synonymous_),
+      closure_computation_required_(other.closure_computation_required_),
+      ir_context_(ir_context) {
+  // The equations refer to data descriptors owned by |other.synonymous_|, so
+  // they are rewritten to refer to the copies owned by |synonymous_|.
+  for (const auto& entry : other.id_equations_) {
+    OperationSet& equations =
+        id_equations_[synonymous_.GetCanonicalPointer(*entry.first)];
+    for (const auto& equation : entry.second) {
+      Operation copy = {equation.opcode, {}};
+      for (const auto* operand : equation.operands) {
+        copy.operands.push_back(synonymous_.GetCanonicalPointer(*operand));
+      }
+      equations.insert(std::move(copy));
+    }
+  }
+}
+
 bool DataSynonymAndIdEquationFacts::MaybeAddFact(
     const protobufs::FactDataSynonym& fact,
     const DeadBlockFacts& dead_block_facts,
@@ -507,14 +527,19 @@ void DataSynonymAndIdEquationFacts::ComputeClosureOfFacts(
     // Consider each class in the equivalence relation.
     for (auto representative :
          synonymous_.GetEquivalenceClassRepresentatives()) {
-      auto equivalence_class = synonymous_.GetEquivalenceClass(*representative);
-
-      if (equivalence_class.size() > maximum_equivalence_class_size) {
+      const uint32_t class_size =
+          synonymous_.GetEquivalenceClassSize(*representative);
+      if (class_size < 2) {
+        // There is no pair of data descriptors in this class to compare.
+        continue;
+      }
+      if (class_size > maximum_equivalence_class_size) {
         // This equivalence class is larger than the maximum size we are willing
         // to consider, so we skip it.  This potentially leads to missed fact
         // deductions, but avoids excessive runtime for closure computation.
         continue;
       }
+      auto equivalence_class = synonymous_.GetEquivalenceClass(*representative);
 
       // Consider every data descriptor in the equivalence class.
       for (auto dd1_it = equivalence_class.begin();
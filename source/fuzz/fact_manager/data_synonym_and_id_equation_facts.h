@@ -38,6 +38,10 @@ class DataSynonymAndIdEquationFacts {
  public:
   explicit DataSynonymAndIdEquationFacts(opt::IRContext* ir_context);
 
+  // Constructs a copy of |other| that refers to |ir_context| instead.
+  DataSynonymAndIdEquationFacts(const DataSynonymAndIdEquationFacts& other,
+                                opt::IRContext* ir_context);
+
   // See method in FactManager which delegates to this method. Returns true if
   // neither |fact.data1()| nor |fact.data2()| contain an
   // irrelevant id. Otherwise, returns false. |dead_block_facts| and
@@ -30,6 +30,9 @@ class DeadBlockFacts {
  public:
   explicit DeadBlockFacts(opt::IRContext* ir_context);
 
+  // Constructs a copy of |other| that refers to |ir_context| instead.
+  DeadBlockFacts(const DeadBlockFacts& other, opt::IRContext* ir_context);
+
   // Marks |fact.block_id()| as being dead. Returns true if |fact.block_id()|
   // represents a result id of some OpLabel instruction in |ir_context_|.
   // Returns false otherwise.
@@ -44,6 +44,12 @@ class FactManager {
  public:
   explicit FactManager(opt::IRContext* ir_context);
 
+  // Constructs a copy of |other| that refers to |ir_context| instead.
+  // |ir_context| must hold the same module as the one |other| refers to.  It
+  // may be null, in which case the copy must only be used to construct further
+  // copies.
+  FactManager(const FactManager& other, opt::IRContext* ir_context);
+
   // Adds all the facts from |facts|, checking them for validity with respect to
   // |ir_context_|. Warnings about invalid facts are communicated via
   // |message_consumer|; such facts are otherwise ignored.
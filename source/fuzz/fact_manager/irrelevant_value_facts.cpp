@@ -27,6 +27,13 @@ namespace fact_manager {
 IrrelevantValueFacts::IrrelevantValueFacts(opt::IRContext* ir_context)
     : ir_context_(ir_context) {}
 
+IrrelevantValueFacts::IrrelevantValueFacts(const IrrelevantValueFacts& other,
+                                            opt::IRContext* ir_context)
+    : pointers_to_irrelevant_pointees_ids_(
+          other.pointers_to_irrelevant_pointees_ids_),
+      irrelevant_ids_(other.irrelevant_ids_),
+      ir_context_(ir_context) {}
+
 bool IrrelevantValueFacts::MaybeAddFact(
     const protobufs::FactPointeeValueIsIrrelevant& fact,
     const DataSynonymAndIdEquationFacts& data_synonym_and_id_equation_facts) {
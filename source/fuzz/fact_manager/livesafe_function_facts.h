@@ -30,6 +30,10 @@ class LivesafeFunctionFacts {
  public:
   explicit LivesafeFunctionFacts(opt::IRContext* ir_context);
 
+  // Constructs a copy of |other| that refers to |ir_context| instead.
+  LivesafeFunctionFacts(const LivesafeFunctionFacts& other,
+                        opt::IRContext* ir_context);
+
   // See method in FactManager which delegates to this method. Returns true if
   // |fact.function_id()| is a result id of some non-entry-point function in
   // |ir_context_|. Returns false otherwise.
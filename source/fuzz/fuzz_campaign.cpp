@@ -0,0 +1,110 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/fuzz_campaign.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "source/fuzz/fuzzer_util.h"
+#include "source/opt/build_module.h"
+
+namespace spvtools {
+namespace fuzz {
+
+FuzzCampaign::FuzzCampaign(
+    spv_target_env target_env, MessageConsumer consumer,
+    const std::vector<uint32_t>& binary_in,
+    const protobufs::FactSequence& initial_facts,
+    const std::vector<std::vector<uint32_t>>& donor_binaries,
+    RandomGeneratorFactory random_generator_factory, bool enable_all_passes,
+    Fuzzer::RepeatedPassStrategy repeated_pass_strategy,
+    bool validate_after_each_fuzzer_pass,
+    spv_validator_options validator_options)
+    : target_env_(target_env),
+      consumer_(std::move(consumer)),
+      binary_in_(binary_in),
+      initial_facts_(initial_facts),
+      donor_binaries_(donor_binaries),
+      random_generator_factory_(std::move(random_generator_factory)),
+      enable_all_passes_(enable_all_passes),
+      repeated_pass_strategy_(repeated_pass_strategy),
+      validate_after_each_fuzzer_pass_(validate_after_each_fuzzer_pass),
+      validator_options_(validator_options) {}
+
+FuzzCampaign::~FuzzCampaign() = default;
+
+bool FuzzCampaign::Run(uint32_t first_seed, uint32_t num_runs,
+                       uint32_t num_jobs, const RunHandler& run_handler) {
+  // Guards both the messages and the handling of results, so that neither
+  // interleaves with the other.
+  std::mutex mutex;
+  MessageConsumer consumer = [this, &mutex](spv_message_level_t level,
+                                            const char* source,
+                                            const spv_position_t& position,
+                                            const char* message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (consumer_) {
+      consumer_(level, source, position, message);
+    }
+  };
+
+  // The suppliers are shared by all runs, but every call builds a new module.
+  std::vector<fuzzerutil::ModuleSupplier> donor_suppliers;
+  for (const auto& donor_binary : donor_binaries_) {
+    const std::vector<uint32_t>* binary = &donor_binary;
+    const spv_target_env target_env = target_env_;
+    donor_suppliers.emplace_back(
+        [binary, consumer, target_env]() -> std::unique_ptr<opt::IRContext> {
+          return BuildModule(target_env, consumer, binary->data(),
+                             binary->size());
+        });
+  }
+
+  // Each worker repeatedly claims the next run until all runs are claimed.
+  std::atomic<uint32_t> next_run(0);
+  std::atomic<bool> success(true);
+  auto worker = [&]() {
+    for (uint32_t run = next_run++; run < num_runs; run = next_run++) {
+      const uint32_t seed = first_seed + run;
+      Fuzzer fuzzer(target_env_, consumer, binary_in_, initial_facts_,
+                    donor_suppliers, random_generator_factory_(seed),
+                    enable_all_passes_, repeated_pass_strategy_,
+                    validate_after_each_fuzzer_pass_, validator_options_);
+      if (transformation_listener_factory_) {
+        fuzzer.SetTransformationListener(
+            transformation_listener_factory_(seed));
+      }
+      auto fuzz_result = fuzzer.Run();
+      if (fuzz_result.status != Fuzzer::FuzzerResultStatus::kComplete) {
+        success = false;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      run_handler(seed, std::move(fuzz_result));
+    }
+  };
+  std::vector<std::thread> workers;
+  for (uint32_t i = 0; i < std::min(num_jobs, num_runs); i++) {
+    workers.emplace_back(worker);
+  }
+  for (auto& worker_thread : workers) {
+    worker_thread.join();
+  }
+  return success;
+}
+
+}  // namespace fuzz
+}  // namespace spvtools
@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_FUZZ_FUZZ_CAMPAIGN_H_
+#define SOURCE_FUZZ_FUZZ_CAMPAIGN_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "source/fuzz/fuzzer.h"
+#include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
+#include "source/fuzz/random_generator.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace fuzz {
+
+// Runs the fuzzer a number of times on the same input, using successive seeds,
+// and spreads the runs over several threads.  The result of each run depends
+// only on its seed: neither the number of threads nor the order in which the
+// runs finish has any effect on it.
+class FuzzCampaign {
+ public:
+  // Creates the random generator for the run with the given seed.
+  using RandomGeneratorFactory =
+      std::function<std::unique_ptr<RandomGenerator>(uint32_t seed)>;
+
+  // Returns the listener, possibly empty, for the transformations of the run
+  // with the given seed.  It is invoked on the thread that performs the run,
+  // before the run starts.
+  using TransformationListenerFactory =
+      std::function<Fuzzer::TransformationListener(uint32_t seed)>;
+
+  // Invoked with the seed and the result of each run once the run finishes.
+  using RunHandler =
+      std::function<void(uint32_t seed, Fuzzer::FuzzerResult&& result)>;
+
+  // The donor modules are given as binaries, from which every run builds its
+  // own modules, because an IRContext cannot be shared between threads.
+  // Messages sent to |consumer| from different runs are never interleaved.
+  FuzzCampaign(spv_target_env target_env, MessageConsumer consumer,
+               const std::vector<uint32_t>& binary_in,
+               const protobufs::FactSequence& initial_facts,
+               const std::vector<std::vector<uint32_t>>& donor_binaries,
+               RandomGeneratorFactory random_generator_factory,
+               bool enable_all_passes,
+               Fuzzer::RepeatedPassStrategy repeated_pass_strategy,
+               bool validate_after_each_fuzzer_pass,
+               spv_validator_options validator_options);
+
+  // Disables copy/move constructor/assignment operations.
+  FuzzCampaign(const FuzzCampaign&) = delete;
+  FuzzCampaign(FuzzCampaign&&) = delete;
+  FuzzCampaign& operator=(const FuzzCampaign&) = delete;
+  FuzzCampaign& operator=(FuzzCampaign&&) = delete;
+
+  ~FuzzCampaign();
+
+  // Performs |num_runs| runs of the fuzzer, with seeds |first_seed|,
+  // |first_seed| + 1, and so on, on at most |num_jobs| threads.  The result of
+  // each run is passed to |run_handler|, whose invocations never overlap with
+  // each other or with messages sent to the consumer.  Returns true if and only
+  // if every run completed successfully.
+  bool Run(uint32_t first_seed, uint32_t num_runs, uint32_t num_jobs,
+           const RunHandler& run_handler);
+
+  // Causes the listener created by |factory| for each run performed by a
+  // subsequent call to Run() to be invoked on the transformations of that run.
+  void SetTransformationListenerFactory(
+      TransformationListenerFactory factory) {
+    transformation_listener_factory_ = std::move(factory);
+  }
+
+ private:
+  // Target environment.
+  const spv_target_env target_env_;
+
+  // Message consumer that will be invoked once for each message communicated
+  // from the library.
+  MessageConsumer consumer_;
+
+  // The initial binary to which fuzzing should be applied.
+  const std::vector<uint32_t>& binary_in_;
+
+  // Initial facts known to hold in advance of applying any transformations.
+  const protobufs::FactSequence& initial_facts_;
+
+  // The binaries of the modules whose contents can be donated into the module
+  // being fuzzed.
+  const std::vector<std::vector<uint32_t>>& donor_binaries_;
+
+  // Creates the random number generator of each run.
+  RandomGeneratorFactory random_generator_factory_;
+
+  // Determines whether all passes should be enabled, vs. having passes be
+  // probabilistically enabled.
+  bool enable_all_passes_;
+
+  // Controls which type of RepeatedPassManager object to create.
+  Fuzzer::RepeatedPassStrategy repeated_pass_strategy_;
+
+  // Determines whether the validator should be invoked after every fuzzer pass.
+  bool validate_after_each_fuzzer_pass_;
+
+  // Options to control validation.
+  spv_validator_options validator_options_;
+
+  // If set, creates the transformation listener of each run.
+  TransformationListenerFactory transformation_listener_factory_;
+};
+
+}  // namespace fuzz
+}  // namespace spvtools
+
+#endif  // SOURCE_FUZZ_FUZZ_CAMPAIGN_H_
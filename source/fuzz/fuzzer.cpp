@@ -15,6 +15,7 @@
 #include "source/fuzz/fuzzer.h"
 
 #include <cassert>
+#include <chrono>
 #include <memory>
 #include <numeric>
 
@@ -85,6 +86,7 @@
 #include "source/fuzz/fuzzer_pass_toggle_access_chain_instruction.h"
 #include "source/fuzz/fuzzer_pass_wrap_regions_in_selections.h"
 #include "source/fuzz/pass_management/repeated_pass_manager.h"
+#include "source/fuzz/pass_management/repeated_pass_manager_adaptive.h"
 #include "source/fuzz/pass_management/repeated_pass_manager_looped_with_recommendations.h"
 #include "source/fuzz/pass_management/repeated_pass_manager_random_with_recommendations.h"
 #include "source/fuzz/pass_management/repeated_pass_manager_simple.h"
@@ -155,12 +157,24 @@ void Fuzzer::MaybeAddFinalPass(std::vector<std::unique_ptr<FuzzerPass>>* passes,
 }
 
 bool Fuzzer::ApplyPassAndCheckValidity(
-    FuzzerPass* pass, const spvtools::SpirvTools& tools) const {
+    FuzzerPass* pass, const spvtools::SpirvTools& tools) {
+  const int num_transformations_before =
+      transformation_sequence_out_.transformation_size();
   pass->Apply();
-  if (validate_after_each_fuzzer_pass_) {
-    std::vector<uint32_t> binary_to_validate;
-    ir_context_->module()->ToBinary(&binary_to_validate, false);
-    if (!tools.Validate(&binary_to_validate[0], binary_to_validate.size(),
+  if (transformation_listener_) {
+    for (int i = num_transformations_before;
+         i < transformation_sequence_out_.transformation_size(); i++) {
+      transformation_listener_(transformation_sequence_out_.transformation(i));
+    }
+  }
+  // Fuzzer passes only change the module by applying transformations, so a
+  // pass that applied none leaves the module as valid as it was before.
+  if (validate_after_each_fuzzer_pass_ &&
+      transformation_sequence_out_.transformation_size() !=
+          num_transformations_before) {
+    binary_to_validate_.clear();
+    ir_context_->module()->ToBinary(&binary_to_validate_, false);
+    if (!tools.Validate(&binary_to_validate_[0], binary_to_validate_.size(),
                         validator_options_)) {
       consumer_(SPV_MSG_INFO, nullptr, {},
                 "Binary became invalid during fuzzing (set a breakpoint to "
@@ -319,16 +333,36 @@ Fuzzer::FuzzerResult Fuzzer::Run() {
           MakeUnique<RepeatedPassManagerRandomWithRecommendations>(
               fuzzer_context_.get(), &pass_instances, &pass_recommender);
       break;
+    case RepeatedPassStrategy::kAdaptive:
+      repeated_pass_manager = MakeUnique<RepeatedPassManagerAdaptive>(
+          fuzzer_context_.get(), &pass_instances);
+      break;
   }
 
   do {
-    if (!ApplyPassAndCheckValidity(repeated_pass_manager->ChoosePass(),
-                                   tools)) {
+    auto* pass = repeated_pass_manager->ChoosePass();
+    const int num_transformations_before =
+        transformation_sequence_out_.transformation_size();
+    const auto start_time = std::chrono::steady_clock::now();
+    if (!ApplyPassAndCheckValidity(pass, tools)) {
       return {Fuzzer::FuzzerResultStatus::kFuzzerPassLedToInvalidModule,
               std::vector<uint32_t>(), protobufs::TransformationSequence()};
     }
+    repeated_pass_manager->NotifyPassApplied(
+        pass,
+        static_cast<uint32_t>(
+            transformation_sequence_out_.transformation_size() -
+            num_transformations_before),
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      start_time)
+            .count());
   } while (ShouldContinueFuzzing());
 
+  const auto statistics = repeated_pass_manager->GetStatistics();
+  if (!statistics.empty()) {
+    consumer_(SPV_MSG_INFO, nullptr, {}, statistics.c_str());
+  }
+
   // Now apply some passes that it does not make sense to apply repeatedly,
   // as they do not unlock other passes.
   std::vector<std::unique_ptr<FuzzerPass>> final_passes;
@@ -15,6 +15,7 @@
 #ifndef SOURCE_FUZZ_FUZZER_H_
 #define SOURCE_FUZZ_FUZZER_H_
 
+#include <functional>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -50,13 +51,18 @@ class Fuzzer {
     protobufs::TransformationSequence applied_transformations;
   };
 
+  // A function that is invoked on transformations as the fuzzer applies them.
+  using TransformationListener =
+      std::function<void(const protobufs::Transformation&)>;
+
   // Each field of this enum corresponds to an available repeated pass
   // strategy, and is used to decide which kind of RepeatedPassManager object
   // to create.
   enum class RepeatedPassStrategy {
     kSimple,
     kRandomWithRecommendations,
-    kLoopedWithRecommendations
+    kLoopedWithRecommendations,
+    kAdaptive
   };
 
   Fuzzer(spv_target_env target_env, MessageConsumer consumer,
@@ -86,6 +92,14 @@ class Fuzzer {
   // transformation sequence.
   FuzzerResult Run();
 
+  // Causes |listener| to be invoked, in order, on each transformation that a
+  // subsequent call to Run() applies.  The listener is invoked after each
+  // fuzzer pass, before the module is validated, so that the transformations
+  // can be saved as fuzzing proceeds.
+  void SetTransformationListener(TransformationListener listener) {
+    transformation_listener_ = std::move(listener);
+  }
+
  private:
   // A convenience method to add a repeated fuzzer pass to |pass_instances| with
   // probability |percentage_chance_of_adding_pass|%, or with probability 100%
@@ -123,9 +137,10 @@ class Fuzzer {
 
   // Applies |pass|, which must be a pass constructed with |ir_context|, and
   // then returns true if and only if |ir_context| is valid.  |tools| is used to
-  // check validity.
+  // check validity.  Validation is skipped if |pass| applied no
+  // transformations.
   bool ApplyPassAndCheckValidity(FuzzerPass* pass,
-                                 const spvtools::SpirvTools& tools) const;
+                                 const spvtools::SpirvTools& tools);
 
   // Target environment.
   const spv_target_env target_env_;
@@ -160,6 +175,13 @@ class Fuzzer {
   // Options to control validation.
   spv_validator_options validator_options_;
 
+  // If set, invoked on each transformation as it is applied.
+  TransformationListener transformation_listener_;
+
+  // Storage for the binary that is validated after each fuzzer pass, kept
+  // between passes to reuse its allocation.
+  std::vector<uint32_t> binary_to_validate_;
+
   // The number of repeated fuzzer passes that have been applied is kept track
   // of, in order to enforce a hard limit on the number of times such passes
   // can be applied.
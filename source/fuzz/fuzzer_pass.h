@@ -64,6 +64,9 @@ class FuzzerPass {
   // Filters said instructions to return only those that satisfy the
   // |instruction_is_relevant| predicate.  This, for instance, could ignore all
   // instructions that have a particular decoration.
+  //
+  // This walks the dominator tree on every call; passes that query many
+  // program points should build an AvailableInstructions index instead.
   std::vector<opt::Instruction*> FindAvailableInstructions(
       opt::Function* function, opt::BasicBlock* block,
       const opt::BasicBlock::iterator& inst_it,
@@ -14,6 +14,7 @@
 
 #include "source/fuzz/fuzzer_pass_add_loads.h"
 
+#include "source/fuzz/available_instructions.h"
 #include "source/fuzz/fuzzer_util.h"
 #include "source/fuzz/transformation_load.h"
 
@@ -30,10 +31,35 @@ FuzzerPassAddLoads::FuzzerPassAddLoads(
 FuzzerPassAddLoads::~FuzzerPassAddLoads() = default;
 
 void FuzzerPassAddLoads::Apply() {
+  // Index the pointers we might think of loading from once, up front, rather
+  // than walking the dominator tree at every program point.  Loads that this
+  // pass adds are not pointers, so the index does not go stale.
+  const AvailableInstructions available_pointers(
+      GetIRContext(),
+      [](opt::IRContext* context, opt::Instruction* instruction) -> bool {
+        if (!instruction->result_id() || !instruction->type_id()) {
+          return false;
+        }
+        switch (instruction->opcode()) {
+          case SpvOpConstantNull:
+          case SpvOpUndef:
+            // Do not allow loading from a null or undefined pointer; this
+            // might be OK if the block is dead, but for now we conservatively
+            // avoid it.
+            return false;
+          default:
+            break;
+        }
+        return context->get_def_use_mgr()
+                   ->GetDef(instruction->type_id())
+                   ->opcode() == SpvOpTypePointer;
+      });
+
   ForEachInstructionWithInstructionDescriptor(
-      [this](opt::Function* function, opt::BasicBlock* block,
-             opt::BasicBlock::iterator inst_it,
-             const protobufs::InstructionDescriptor& instruction_descriptor)
+      [this, &available_pointers](
+          opt::Function* /*unused*/, opt::BasicBlock* /*unused*/,
+          opt::BasicBlock::iterator inst_it,
+          const protobufs::InstructionDescriptor& instruction_descriptor)
           -> void {
         assert(inst_it->opcode() ==
                    instruction_descriptor.target_instruction_opcode() &&
@@ -52,31 +78,9 @@ void FuzzerPassAddLoads::Apply() {
           return;
         }
 
-        std::vector<opt::Instruction*> relevant_instructions =
-            FindAvailableInstructions(
-                function, block, inst_it,
-                [](opt::IRContext* context,
-                   opt::Instruction* instruction) -> bool {
-                  if (!instruction->result_id() || !instruction->type_id()) {
-                    return false;
-                  }
-                  switch (instruction->opcode()) {
-                    case SpvOpConstantNull:
-                    case SpvOpUndef:
-                      // Do not allow loading from a null or undefined pointer;
-                      // this might be OK if the block is dead, but for now we
-                      // conservatively avoid it.
-                      return false;
-                    default:
-                      break;
-                  }
-                  return context->get_def_use_mgr()
-                             ->GetDef(instruction->type_id())
-                             ->opcode() == SpvOpTypePointer;
-                });
-
-        // At this point, |relevant_instructions| contains all the pointers
-        // we might think of loading from.
+        // These are all the pointers we might think of loading from.
+        const auto relevant_instructions =
+            available_pointers.GetAvailableBeforeInstruction(&*inst_it);
         if (relevant_instructions.empty()) {
           return;
         }
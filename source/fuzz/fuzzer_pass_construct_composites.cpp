@@ -16,6 +16,7 @@
 
 #include <memory>
 
+#include "source/fuzz/available_instructions.h"
 #include "source/fuzz/fuzzer_util.h"
 #include "source/fuzz/transformation_composite_construct.h"
 
@@ -41,12 +42,46 @@ void FuzzerPassConstructComposites::Apply() {
     }
   }
 
+  // Determines whether an instruction is suitable for making a synonym of.
+  auto can_be_component = [this](opt::IRContext* ir_context,
+                                 opt::Instruction* inst) {
+    if (!inst->result_id() || !inst->type_id()) {
+      return false;
+    }
+
+    // If the id is irrelevant, we can use it since it will not participate in
+    // DataSynonym fact. Otherwise, we should be able to produce a synonym out
+    // of the id.
+    return GetTransformationContext()->GetFactManager()->IdIsIrrelevant(
+               inst->result_id()) ||
+           fuzzerutil::CanMakeSynonymOf(ir_context, *GetTransformationContext(),
+                                        inst);
+  };
+
+  // Index the suitable instructions once, up front, rather than walking the
+  // dominator tree at every program point.
+  const AvailableInstructions available_instructions(GetIRContext(),
+                                                     can_be_component);
+
+  // The index does not know about the composites constructed by this pass.
+  // Those constructed earlier in the current block are available at every
+  // later point of the block, so they are tracked separately to allow them to
+  // be used as components of further composites.
+  opt::BasicBlock* current_block = nullptr;
+  std::vector<opt::Instruction*> constructed_in_current_block;
+
   ForEachInstructionWithInstructionDescriptor(
-      [this, &composite_type_ids](
-          opt::Function* function, opt::BasicBlock* block,
+      [this, &composite_type_ids, &can_be_component, &available_instructions,
+       &current_block, &constructed_in_current_block](
+          opt::Function* /*unused*/, opt::BasicBlock* block,
           opt::BasicBlock::iterator inst_it,
           const protobufs::InstructionDescriptor& instruction_descriptor)
           -> void {
+        if (block != current_block) {
+          current_block = block;
+          constructed_in_current_block.clear();
+        }
+
         // Check whether it is legitimate to insert a composite construction
         // before the instruction.
         if (!fuzzerutil::CanInsertOpcodeBeforeInstruction(
@@ -65,23 +100,13 @@ void FuzzerPassConstructComposites::Apply() {
         // program point) and suitable for making a synonym of, associate it
         // with the id of its result type.
         TypeIdToInstructions type_id_to_available_instructions;
-        auto available_instructions = FindAvailableInstructions(
-            function, block, inst_it,
-            [this](opt::IRContext* ir_context, opt::Instruction* inst) {
-              if (!inst->result_id() || !inst->type_id()) {
-                return false;
-              }
-
-              // If the id is irrelevant, we can use it since it will not
-              // participate in DataSynonym fact. Otherwise, we should be able
-              // to produce a synonym out of the id.
-              return GetTransformationContext()
-                         ->GetFactManager()
-                         ->IdIsIrrelevant(inst->result_id()) ||
-                     fuzzerutil::CanMakeSynonymOf(
-                         ir_context, *GetTransformationContext(), inst);
+        available_instructions.GetAvailableBeforeInstruction(&*inst_it)
+            .ForEach([this, &type_id_to_available_instructions](
+                         opt::Instruction* instruction) {
+              RecordAvailableInstruction(instruction,
+                                         &type_id_to_available_instructions);
             });
-        for (auto instruction : available_instructions) {
+        for (auto instruction : constructed_in_current_block) {
           RecordAvailableInstruction(instruction,
                                      &type_id_to_available_instructions);
         }
@@ -160,6 +185,12 @@ void FuzzerPassConstructComposites::Apply() {
         ApplyTransformation(TransformationCompositeConstruct(
             chosen_composite_type, constructor_arguments,
             instruction_descriptor, GetFuzzerContext()->GetFreshId()));
+
+        // The new composite has been inserted immediately before |inst_it|.
+        auto* new_composite = inst_it->PreviousNode();
+        if (can_be_component(GetIRContext(), new_composite)) {
+          constructed_in_current_block.push_back(new_composite);
+        }
       });
 }
 
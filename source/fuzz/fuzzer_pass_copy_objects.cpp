@@ -14,6 +14,7 @@
 
 #include "source/fuzz/fuzzer_pass_copy_objects.h"
 
+#include "source/fuzz/available_instructions.h"
 #include "source/fuzz/fuzzer_util.h"
 #include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
 #include "source/fuzz/transformation_add_synonym.h"
@@ -31,8 +32,19 @@ FuzzerPassCopyObjects::FuzzerPassCopyObjects(
 FuzzerPassCopyObjects::~FuzzerPassCopyObjects() = default;
 
 void FuzzerPassCopyObjects::Apply() {
+  // Index the instructions we might think of copying once, up front.  Copies
+  // that this pass adds are not themselves considered for copying.
+  const AvailableInstructions available_instructions(
+      GetIRContext(),
+      [this](opt::IRContext* ir_context, opt::Instruction* inst) {
+        return TransformationAddSynonym::IsInstructionValid(
+            ir_context, *GetTransformationContext(), inst,
+            protobufs::TransformationAddSynonym::COPY_OBJECT);
+      });
+
   ForEachInstructionWithInstructionDescriptor(
-      [this](opt::Function* function, opt::BasicBlock* block,
+      [this, &available_instructions](
+          opt::Function* /*unused*/, opt::BasicBlock* block,
              opt::BasicBlock::iterator inst_it,
              const protobufs::InstructionDescriptor& instruction_descriptor)
           -> void {
@@ -60,13 +72,8 @@ void FuzzerPassCopyObjects::Apply() {
           return;
         }
 
-        const auto relevant_instructions = FindAvailableInstructions(
-            function, block, inst_it,
-            [this](opt::IRContext* ir_context, opt::Instruction* inst) {
-              return TransformationAddSynonym::IsInstructionValid(
-                  ir_context, *GetTransformationContext(), inst,
-                  protobufs::TransformationAddSynonym::COPY_OBJECT);
-            });
+        const auto relevant_instructions =
+            available_instructions.GetAvailableBeforeInstruction(&*inst_it);
 
         // At this point, |relevant_instructions| contains all the instructions
         // we might think of copying.
@@ -14,9 +14,9 @@
 
 #include "source/fuzz/fuzzer_pass_donate_modules.h"
 
-#include <map>
 #include <queue>
 #include <set>
+#include <unordered_map>
 
 #include "source/fuzz/call_graph.h"
 #include "source/fuzz/instruction_message.h"
@@ -37,6 +37,7 @@
 #include "source/fuzz/transformation_add_type_pointer.h"
 #include "source/fuzz/transformation_add_type_struct.h"
 #include "source/fuzz/transformation_add_type_vector.h"
+#include "source/util/make_unique.h"
 
 namespace spvtools {
 namespace fuzz {
@@ -48,7 +49,8 @@ FuzzerPassDonateModules::FuzzerPassDonateModules(
     const std::vector<fuzzerutil::ModuleSupplier>& donor_suppliers)
     : FuzzerPass(ir_context, transformation_context, fuzzer_context,
                  transformations),
-      donor_suppliers_(donor_suppliers) {}
+      donor_suppliers_(donor_suppliers),
+      donors_(donor_suppliers.size()) {}
 
 FuzzerPassDonateModules::~FuzzerPassDonateModules() = default;
 
@@ -62,13 +64,8 @@ void FuzzerPassDonateModules::Apply() {
   // donating modules.
   do {
     // Choose a donor supplier at random, and get the module that it provides.
-    std::unique_ptr<opt::IRContext> donor_ir_context = donor_suppliers_.at(
-        GetFuzzerContext()->RandomIndex(donor_suppliers_))();
-    assert(donor_ir_context != nullptr && "Supplying of donor failed");
-    assert(fuzzerutil::IsValid(
-               donor_ir_context.get(),
-               GetTransformationContext()->GetValidatorOptions()) &&
-           "The donor module must be valid");
+    const Donor& donor =
+        GetDonor(GetFuzzerContext()->RandomIndex(donor_suppliers_));
     // Donate the supplied module.
     //
     // Randomly decide whether to make the module livesafe (see
@@ -77,13 +74,69 @@ void FuzzerPassDonateModules::Apply() {
     // functions cannot be transformed as if they were arbitrary dead code.
     bool make_livesafe = GetFuzzerContext()->ChoosePercentage(
         GetFuzzerContext()->ChanceOfMakingDonorLivesafe());
-    DonateSingleModule(donor_ir_context.get(), make_livesafe);
+    DonateSingleModule(donor.ir_context.get(),
+                       donor.functions_in_donation_order, make_livesafe);
   } while (GetFuzzerContext()->ChoosePercentage(
       GetFuzzerContext()->GetChanceOfDonatingAdditionalModule()));
 }
 
+const FuzzerPassDonateModules::Donor& FuzzerPassDonateModules::GetDonor(
+    uint32_t supplier_index) {
+  std::unique_ptr<Donor>& donor = donors_.at(supplier_index);
+  if (!donor) {
+    donor = MakeUnique<Donor>();
+    donor->ir_context = donor_suppliers_.at(supplier_index)();
+    assert(donor->ir_context != nullptr && "Supplying of donor failed");
+    assert(fuzzerutil::IsValid(
+               donor->ir_context.get(),
+               GetTransformationContext()->GetValidatorOptions()) &&
+           "The donor module must be valid");
+    donor->functions_in_donation_order =
+        GetFunctionsInDonationOrder(donor->ir_context.get());
+  }
+  return *donor;
+}
+
+std::vector<opt::Function*>
+FuzzerPassDonateModules::GetFunctionsInDonationOrder(
+    opt::IRContext* donor_ir_context) {
+  std::unordered_map<uint32_t, opt::Function*> functions;
+  for (auto& function : *donor_ir_context->module()) {
+    functions[function.result_id()] = &function;
+  }
+
+  // Get the ids of functions in the donor module, topologically sorted
+  // according to the donor's call graph.
+  auto topological_order =
+      CallGraph(donor_ir_context).GetFunctionsInTopologicalOrder();
+
+  // Donate the functions in reverse topological order.  This ensures that a
+  // function gets donated before any function that depends on it.  This allows
+  // donation of the functions to be separated into a number of transformations,
+  // each adding one function, such that every prefix of transformations leaves
+  // the module valid.
+  std::vector<opt::Function*> result;
+  result.reserve(topological_order.size());
+  for (auto function_id = topological_order.rbegin();
+       function_id != topological_order.rend(); ++function_id) {
+    assert(functions.count(*function_id) &&
+           "Function to be donated was not found.");
+    result.push_back(functions.at(*function_id));
+  }
+  return result;
+}
+
 void FuzzerPassDonateModules::DonateSingleModule(
     opt::IRContext* donor_ir_context, bool make_livesafe) {
+  DonateSingleModule(donor_ir_context,
+                     GetFunctionsInDonationOrder(donor_ir_context),
+                     make_livesafe);
+}
+
+void FuzzerPassDonateModules::DonateSingleModule(
+    opt::IRContext* donor_ir_context,
+    const std::vector<opt::Function*>& functions_in_donation_order,
+    bool make_livesafe) {
   // Check that the donated module has capabilities, supported by the recipient
   // module.
   for (const auto& capability_inst : donor_ir_context->capabilities()) {
@@ -111,12 +164,14 @@ void FuzzerPassDonateModules::DonateSingleModule(
   // (2) by mapping a donor instruction's result id to a freshly chosen id that
   //     is guaranteed to be different from any id already used by the recipient
   //     (or from any id already chosen to handle a previous donor id)
-  std::map<uint32_t, uint32_t> original_id_to_donated_id;
+  utils::IdMap<uint32_t> original_id_to_donated_id;
+  original_id_to_donated_id.reserve(donor_ir_context->module()->IdBound());
 
   HandleExternalInstructionImports(donor_ir_context,
                                    &original_id_to_donated_id);
   HandleTypesAndValues(donor_ir_context, &original_id_to_donated_id);
-  HandleFunctions(donor_ir_context, &original_id_to_donated_id, make_livesafe);
+  HandleFunctions(donor_ir_context, functions_in_donation_order,
+                  &original_id_to_donated_id, make_livesafe);
 
   // TODO(https://github.com/KhronosGroup/SPIRV-Tools/issues/3115) Handle some
   //  kinds of decoration.
@@ -148,7 +203,7 @@ SpvStorageClass FuzzerPassDonateModules::AdaptStorageClass(
 
 void FuzzerPassDonateModules::HandleExternalInstructionImports(
     opt::IRContext* donor_ir_context,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id) {
+    utils::IdMap<uint32_t>* original_id_to_donated_id) {
   // Consider every external instruction set import in the donor module.
   for (auto& donor_import : donor_ir_context->module()->ext_inst_imports()) {
     const auto& donor_import_name_words = donor_import.GetInOperand(0).words;
@@ -177,7 +232,7 @@ void FuzzerPassDonateModules::HandleExternalInstructionImports(
 
 void FuzzerPassDonateModules::HandleTypesAndValues(
     opt::IRContext* donor_ir_context,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id) {
+    utils::IdMap<uint32_t>* original_id_to_donated_id) {
   // Consider every type/global/constant/undef in the module.
   for (auto& type_or_value : donor_ir_context->module()->types_values()) {
     HandleTypeOrValue(type_or_value, original_id_to_donated_id);
@@ -186,7 +241,7 @@ void FuzzerPassDonateModules::HandleTypesAndValues(
 
 void FuzzerPassDonateModules::HandleTypeOrValue(
     const opt::Instruction& type_or_value,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id) {
+    utils::IdMap<uint32_t>* original_id_to_donated_id) {
   // The type/value instruction generates a result id, and we need to associate
   // the donor's result id with a new result id.  That new result id will either
   // be the id of some existing instruction, or a fresh id.  This variable
@@ -593,30 +648,9 @@ void FuzzerPassDonateModules::HandleTypeOrValue(
 
 void FuzzerPassDonateModules::HandleFunctions(
     opt::IRContext* donor_ir_context,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id,
-    bool make_livesafe) {
-  // Get the ids of functions in the donor module, topologically sorted
-  // according to the donor's call graph.
-  auto topological_order =
-      CallGraph(donor_ir_context).GetFunctionsInTopologicalOrder();
-
-  // Donate the functions in reverse topological order.  This ensures that a
-  // function gets donated before any function that depends on it.  This allows
-  // donation of the functions to be separated into a number of transformations,
-  // each adding one function, such that every prefix of transformations leaves
-  // the module valid.
-  for (auto function_id = topological_order.rbegin();
-       function_id != topological_order.rend(); ++function_id) {
-    // Find the function to be donated.
-    opt::Function* function_to_donate = nullptr;
-    for (auto& function : *donor_ir_context->module()) {
-      if (function.result_id() == *function_id) {
-        function_to_donate = &function;
-        break;
-      }
-    }
-    assert(function_to_donate && "Function to be donated was not found.");
-
+    const std::vector<opt::Function*>& functions_in_donation_order,
+    utils::IdMap<uint32_t>* original_id_to_donated_id, bool make_livesafe) {
+  for (opt::Function* function_to_donate : functions_in_donation_order) {
     if (!original_id_to_donated_id->count(
             function_to_donate->DefInst().GetSingleWordInOperand(1))) {
       // We were not able to donate this function's type, so we cannot donate
@@ -670,7 +704,7 @@ void FuzzerPassDonateModules::HandleFunctions(
 
 bool FuzzerPassDonateModules::CanDonateInstruction(
     opt::IRContext* donor_ir_context, const opt::Instruction& instruction,
-    const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+    const utils::IdMap<uint32_t>& original_id_to_donated_id,
     const std::set<uint32_t>& skipped_instructions) const {
   if (instruction.type_id() &&
       !original_id_to_donated_id.count(instruction.type_id())) {
@@ -798,7 +832,7 @@ bool FuzzerPassDonateModules::IsBasicType(
 
 void FuzzerPassDonateModules::HandleOpArrayLength(
     const opt::Instruction& instruction,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+    utils::IdMap<uint32_t>* original_id_to_donated_id,
     std::vector<protobufs::Instruction>* donated_instructions) const {
   assert(instruction.opcode() == SpvOpArrayLength &&
          "Precondition: instruction must be OpArrayLength.");
@@ -844,7 +878,7 @@ void FuzzerPassDonateModules::HandleOpArrayLength(
 
 void FuzzerPassDonateModules::HandleDifficultInstruction(
     const opt::Instruction& instruction,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+    utils::IdMap<uint32_t>* original_id_to_donated_id,
     std::vector<protobufs::Instruction>* donated_instructions,
     std::set<uint32_t>* skipped_instructions) {
   if (!instruction.result_id()) {
@@ -899,7 +933,7 @@ void FuzzerPassDonateModules::HandleDifficultInstruction(
 
 void FuzzerPassDonateModules::PrepareInstructionForDonation(
     const opt::Instruction& instruction, opt::IRContext* donor_ir_context,
-    std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+    utils::IdMap<uint32_t>* original_id_to_donated_id,
     std::vector<protobufs::Instruction>* donated_instructions) {
   // Get the instruction's input operands into donation-ready form,
   // remapping any id uses in the process.
@@ -975,7 +1009,7 @@ void FuzzerPassDonateModules::PrepareInstructionForDonation(
 
 bool FuzzerPassDonateModules::CreateLoopLimiterInfo(
     opt::IRContext* donor_ir_context, const opt::BasicBlock& loop_header,
-    const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+    const utils::IdMap<uint32_t>& original_id_to_donated_id,
     protobufs::LoopLimiterInfo* out) {
   assert(loop_header.IsLoopHeader() && "|loop_header| is not a loop header");
 
@@ -1064,7 +1098,7 @@ bool FuzzerPassDonateModules::CreateLoopLimiterInfo(
 
 bool FuzzerPassDonateModules::MaybeAddLivesafeFunction(
     const opt::Function& function_to_donate, opt::IRContext* donor_ir_context,
-    const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+    const utils::IdMap<uint32_t>& original_id_to_donated_id,
     const std::vector<protobufs::Instruction>& donated_instructions) {
   // Various types and constants must be in place for a function to be made
   // live-safe.  Add them if not already present.
@@ -15,10 +15,12 @@
 #ifndef SOURCE_FUZZ_FUZZER_PASS_DONATE_MODULES_H_
 #define SOURCE_FUZZ_FUZZER_PASS_DONATE_MODULES_H_
 
+#include <memory>
 #include <vector>
 
 #include "source/fuzz/fuzzer_pass.h"
 #include "source/fuzz/fuzzer_util.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace fuzz {
@@ -44,6 +46,34 @@ class FuzzerPassDonateModules : public FuzzerPass {
   void DonateSingleModule(opt::IRContext* donor_ir_context, bool make_livesafe);
 
  private:
+  // What the pass keeps of a donor module between donations, so that each
+  // donor is supplied, checked and analysed only once per fuzzing run, rather
+  // than each time it is donated.
+  struct Donor {
+    std::unique_ptr<opt::IRContext> ir_context;
+    // The functions of the donor in the order in which they are donated; see
+    // GetFunctionsInDonationOrder.
+    std::vector<opt::Function*> functions_in_donation_order;
+  };
+
+  // Returns the donor provided by the supplier at |supplier_index| in
+  // |donor_suppliers_|, which is called the first time only.
+  const Donor& GetDonor(uint32_t supplier_index);
+
+  // Returns the functions of |donor_ir_context|, which must not exhibit
+  // recursion, in reverse topological order of its call graph (leaves to
+  // root).  A function is thus donated before any function that calls it.
+  static std::vector<opt::Function*> GetFunctionsInDonationOrder(
+      opt::IRContext* donor_ir_context);
+
+  // Like the public DonateSingleModule, with the functions of
+  // |donor_ir_context| given in donation order by
+  // |functions_in_donation_order|.
+  void DonateSingleModule(
+      opt::IRContext* donor_ir_context,
+      const std::vector<opt::Function*>& functions_in_donation_order,
+      bool make_livesafe);
+
   // Adapts a storage class coming from a donor module so that it will work
   // in a recipient module, e.g. by changing Uniform to Private.
   static SpvStorageClass AdaptStorageClass(SpvStorageClass donor_storage_class);
@@ -54,7 +84,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // no such corresponding import is available.
   void HandleExternalInstructionImports(
       opt::IRContext* donor_ir_context,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id);
+      utils::IdMap<uint32_t>* original_id_to_donated_id);
 
   // Considers all types, globals, constants and undefs in |donor_ir_context|.
   // For each instruction, uses |original_to_donated_id| to map its result id to
@@ -64,23 +94,23 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // |original_id_to_donated_id|).
   void HandleTypesAndValues(
       opt::IRContext* donor_ir_context,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id);
+      utils::IdMap<uint32_t>* original_id_to_donated_id);
 
   // Helper method for HandleTypesAndValues, to handle a single type/value.
   void HandleTypeOrValue(
       const opt::Instruction& type_or_value,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id);
-
-  // Assumes that |donor_ir_context| does not exhibit recursion.  Considers the
-  // functions in |donor_ir_context|'s call graph in a reverse-topologically-
-  // sorted order (leaves-to-root), adding each function to the recipient
-  // module, rewritten to use fresh ids and using |original_id_to_donated_id| to
-  // remap ids.  The |make_livesafe| argument captures whether the functions in
-  // the module are required to be made livesafe before being added to the
-  // recipient.
-  void HandleFunctions(opt::IRContext* donor_ir_context,
-                       std::map<uint32_t, uint32_t>* original_id_to_donated_id,
-                       bool make_livesafe);
+      utils::IdMap<uint32_t>* original_id_to_donated_id);
+
+  // Considers the functions of |donor_ir_context| in the order given by
+  // |functions_in_donation_order| (see GetFunctionsInDonationOrder), adding
+  // each function to the recipient module, rewritten to use fresh ids and
+  // using |original_id_to_donated_id| to remap ids.  The |make_livesafe|
+  // argument captures whether the functions in the module are required to be
+  // made livesafe before being added to the recipient.
+  void HandleFunctions(
+      opt::IRContext* donor_ir_context,
+      const std::vector<opt::Function*>& functions_in_donation_order,
+      utils::IdMap<uint32_t>* original_id_to_donated_id, bool make_livesafe);
 
   // During donation we will have to ignore some instructions, e.g. because they
   // use opcodes that we cannot support or because they reference the ids of
@@ -89,7 +119,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // |donor_ir_context| can be donated.
   bool CanDonateInstruction(
       opt::IRContext* donor_ir_context, const opt::Instruction& instruction,
-      const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+      const utils::IdMap<uint32_t>& original_id_to_donated_id,
       const std::set<uint32_t>& skipped_instructions) const;
 
   // We treat the OpArrayLength instruction specially.  In the donor shader this
@@ -101,7 +131,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // instruction that copies the size of the fixed-size array.
   void HandleOpArrayLength(
       const opt::Instruction& instruction,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+      utils::IdMap<uint32_t>* original_id_to_donated_id,
       std::vector<protobufs::Instruction>* donated_instructions) const;
 
   // The instruction |instruction| is required to be an instruction that cannot
@@ -115,7 +145,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // managed by |original_id_to_donated_id|.
   void HandleDifficultInstruction(
       const opt::Instruction& instruction,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+      utils::IdMap<uint32_t>* original_id_to_donated_id,
       std::vector<protobufs::Instruction>* donated_instructions,
       std::set<uint32_t>* skipped_instructions);
 
@@ -125,7 +155,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // |donor_ir_context| to corresponding ids in the recipient module.
   void PrepareInstructionForDonation(
       const opt::Instruction& instruction, opt::IRContext* donor_ir_context,
-      std::map<uint32_t, uint32_t>* original_id_to_donated_id,
+      utils::IdMap<uint32_t>* original_id_to_donated_id,
       std::vector<protobufs::Instruction>* donated_instructions);
 
   // Tries to create a protobufs::LoopLimiterInfo given a loop header basic
@@ -134,7 +164,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // this function returns false.
   bool CreateLoopLimiterInfo(
       opt::IRContext* donor_ir_context, const opt::BasicBlock& loop_header,
-      const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+      const utils::IdMap<uint32_t>& original_id_to_donated_id,
       protobufs::LoopLimiterInfo* out);
 
   // Requires that |donated_instructions| represents a prepared version of the
@@ -147,7 +177,7 @@ class FuzzerPassDonateModules : public FuzzerPass {
   // donation was successful, false otherwise.
   bool MaybeAddLivesafeFunction(
       const opt::Function& function_to_donate, opt::IRContext* donor_ir_context,
-      const std::map<uint32_t, uint32_t>& original_id_to_donated_id,
+      const utils::IdMap<uint32_t>& original_id_to_donated_id,
       const std::vector<protobufs::Instruction>& donated_instructions);
 
   // Returns true if and only if |instruction| is a scalar, vector, matrix,
@@ -156,6 +186,9 @@ class FuzzerPassDonateModules : public FuzzerPass {
 
   // Functions that supply SPIR-V modules
   std::vector<fuzzerutil::ModuleSupplier> donor_suppliers_;
+
+  // The donors supplied so far, indexed like |donor_suppliers_|.
+  std::vector<std::unique_ptr<Donor>> donors_;
 };
 
 }  // namespace fuzz
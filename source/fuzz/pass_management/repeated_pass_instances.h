@@ -15,6 +15,9 @@
 #ifndef SOURCE_FUZZ_REPEATED_PASS_INSTANCES_H_
 #define SOURCE_FUZZ_REPEATED_PASS_INSTANCES_H_
 
+#include <string>
+#include <vector>
+
 #include "source/fuzz/fuzzer_pass_add_access_chains.h"
 #include "source/fuzz/fuzzer_pass_add_bit_instruction_synonyms.h"
 #include "source/fuzz/fuzzer_pass_add_composite_inserts.h"
@@ -75,7 +78,8 @@ namespace fuzz {
 // This class has a distinct member for each repeated fuzzer pass (i.e., a
 // fuzzer pass that it makes sense to run multiple times).  If a member is null
 // then we do not have an instance of that fuzzer pass, i.e. it is disabled.
-// The class also provides access to the set of passes that are enabled.
+// The class also provides access to the set of passes that are enabled, and to
+// their names.
 class RepeatedPassInstances {
 // This macro should be invoked below for every repeated fuzzer pass.  If a
 // repeated fuzzer pass is called FuzzerPassFoo then the macro invocation:
@@ -100,6 +104,7 @@ class RepeatedPassInstances {
     assert(NAME##_ == nullptr && "Attempt to set pass multiple times."); \
     NAME##_ = pass.get();                                                \
     passes_.push_back(std::move(pass));                                  \
+    pass_names_.push_back(#NAME);                                        \
   }                                                                      \
                                                                          \
  private:                                                                \
@@ -166,9 +171,16 @@ class RepeatedPassInstances {
     return passes_;
   }
 
+  // Yields the names of the registered passes, in the same order as
+  // GetPasses(); the name of FuzzerPassFoo is "Foo".
+  const std::vector<std::string>& GetPassNames() const { return pass_names_; }
+
  private:
   // The distinct fuzzer pass instances that have been registered via SetPass().
   std::vector<std::unique_ptr<FuzzerPass>> passes_;
+
+  // The names of the passes in |passes_|.
+  std::vector<std::string> pass_names_;
 };
 
 }  // namespace fuzz
@@ -23,5 +23,11 @@ RepeatedPassManager::RepeatedPassManager(FuzzerContext* fuzzer_context,
 
 RepeatedPassManager::~RepeatedPassManager() = default;
 
+void RepeatedPassManager::NotifyPassApplied(FuzzerPass* /*unused*/,
+                                            uint32_t /*unused*/,
+                                            double /*unused*/) {}
+
+std::string RepeatedPassManager::GetStatistics() const { return ""; }
+
 }  // namespace fuzz
 }  // namespace spvtools
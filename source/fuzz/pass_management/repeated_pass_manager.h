@@ -15,6 +15,8 @@
 #ifndef SOURCE_FUZZ_REPEATED_PASS_MANAGER_H_
 #define SOURCE_FUZZ_REPEATED_PASS_MANAGER_H_
 
+#include <string>
+
 #include "source/fuzz/fuzzer_context.h"
 #include "source/fuzz/fuzzer_pass.h"
 #include "source/fuzz/pass_management/repeated_pass_instances.h"
@@ -36,6 +38,16 @@ class RepeatedPassManager {
   // Returns the fuzzer pass instance that should be run next.
   virtual FuzzerPass* ChoosePass() = 0;
 
+  // Informs the manager that |pass|, which it previously chose, applied
+  // |num_transformations| transformations and took |seconds| to run.  The
+  // default implementation ignores this information.
+  virtual void NotifyPassApplied(FuzzerPass* pass, uint32_t num_transformations,
+                                 double seconds);
+
+  // Returns a human-readable summary of the passes that were run, or an empty
+  // string if the manager does not keep one (the default).
+  virtual std::string GetStatistics() const;
+
  protected:
   FuzzerContext* GetFuzzerContext() { return fuzzer_context_; }
 
@@ -0,0 +1,97 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/pass_management/repeated_pass_manager_adaptive.h"
+
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+
+namespace spvtools {
+namespace fuzz {
+
+namespace {
+
+// The percentage chance of choosing a pass uniformly at random, rather than
+// favoring the more productive of two passes.
+const uint32_t kChanceOfChoosingPassAtRandom = 20;
+
+// Added to the time taken by a pass when measuring its productivity, so that a
+// pass that happened to take no measurable time does not dominate.
+const double kMinimumSeconds = 1e-6;
+
+}  // namespace
+
+RepeatedPassManagerAdaptive::RepeatedPassManagerAdaptive(
+    FuzzerContext* fuzzer_context, RepeatedPassInstances* pass_instances)
+    : RepeatedPassManager(fuzzer_context, pass_instances) {
+  const auto& passes = GetPassInstances()->GetPasses();
+  statistics_.resize(passes.size());
+  for (uint32_t i = 0; i < static_cast<uint32_t>(passes.size()); i++) {
+    pass_index_[passes[i].get()] = i;
+    untried_passes_.push_back(i);
+  }
+}
+
+RepeatedPassManagerAdaptive::~RepeatedPassManagerAdaptive() = default;
+
+FuzzerPass* RepeatedPassManagerAdaptive::ChoosePass() {
+  auto& passes = GetPassInstances()->GetPasses();
+  if (!untried_passes_.empty()) {
+    return passes[GetFuzzerContext()->RemoveAtRandomIndex(&untried_passes_)]
+        .get();
+  }
+  auto first = GetFuzzerContext()->RandomIndex(passes);
+  if (GetFuzzerContext()->ChoosePercentage(kChanceOfChoosingPassAtRandom)) {
+    return passes[first].get();
+  }
+  auto second = GetFuzzerContext()->RandomIndex(passes);
+  return passes[GetProductivity(first) >= GetProductivity(second) ? first
+                                                                  : second]
+      .get();
+}
+
+void RepeatedPassManagerAdaptive::NotifyPassApplied(
+    FuzzerPass* pass, uint32_t num_transformations, double seconds) {
+  assert(pass_index_.count(pass) && "The pass must be an enabled pass.");
+  auto& statistics = statistics_[pass_index_.at(pass)];
+  statistics.num_runs++;
+  statistics.num_transformations += num_transformations;
+  statistics.seconds += seconds;
+}
+
+std::string RepeatedPassManagerAdaptive::GetStatistics() const {
+  const auto& pass_names = GetPassInstances()->GetPassNames();
+  std::stringstream result;
+  result << "Repeated pass statistics (runs, transformations, seconds, "
+            "transformations per second):";
+  for (uint32_t i = 0; i < static_cast<uint32_t>(statistics_.size()); i++) {
+    const auto& statistics = statistics_[i];
+    result << std::endl
+           << "  " << pass_names[i] << ": " << statistics.num_runs << ", "
+           << statistics.num_transformations << ", " << std::fixed
+           << std::setprecision(6) << statistics.seconds << ", "
+           << std::setprecision(1) << GetProductivity(i);
+  }
+  return result.str();
+}
+
+double RepeatedPassManagerAdaptive::GetProductivity(uint32_t pass_index) const {
+  const auto& statistics = statistics_[pass_index];
+  return static_cast<double>(statistics.num_transformations) /
+         (statistics.seconds + kMinimumSeconds);
+}
+
+}  // namespace fuzz
+}  // namespace spvtools
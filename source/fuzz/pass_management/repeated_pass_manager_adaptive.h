@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_FUZZ_REPEATED_PASS_MANAGER_ADAPTIVE_H_
+#define SOURCE_FUZZ_REPEATED_PASS_MANAGER_ADAPTIVE_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "source/fuzz/pass_management/repeated_pass_manager.h"
+
+namespace spvtools {
+namespace fuzz {
+
+// This repeated pass manager learns, during a run, which of the enabled passes
+// are productive, and favors them.  The productivity of a pass is the number of
+// transformations it has applied per second spent running it.
+//
+// Every enabled pass is first run once, in a random order.  After that, each
+// time a pass is requested the manager either picks an enabled pass uniformly
+// at random, so that passes whose productivity changes as the module grows are
+// revisited, or picks two enabled passes at random and chooses the more
+// productive of them.
+//
+// Because productivity is measured in wall-clock time, the passes that are
+// chosen do not depend on the random seed alone; the transformations that are
+// applied can still be replayed.
+class RepeatedPassManagerAdaptive : public RepeatedPassManager {
+ public:
+  RepeatedPassManagerAdaptive(FuzzerContext* fuzzer_context,
+                              RepeatedPassInstances* pass_instances);
+
+  ~RepeatedPassManagerAdaptive() override;
+
+  FuzzerPass* ChoosePass() override;
+
+  void NotifyPassApplied(FuzzerPass* pass, uint32_t num_transformations,
+                         double seconds) override;
+
+  // Returns one line per enabled pass giving the number of times it ran, the
+  // transformations it applied, the time it took and its productivity.
+  std::string GetStatistics() const override;
+
+ private:
+  // What is known about a pass so far.
+  struct PassStatistics {
+    uint32_t num_runs = 0;
+    uint64_t num_transformations = 0;
+    double seconds = 0.0;
+  };
+
+  // Returns the productivity of the pass with index |pass_index| in the
+  // sequence of enabled passes.
+  double GetProductivity(uint32_t pass_index) const;
+
+  // Maps each enabled pass to its index in the sequence of enabled passes.
+  std::unordered_map<const FuzzerPass*, uint32_t> pass_index_;
+
+  // The statistics for each enabled pass, by index.
+  std::vector<PassStatistics> statistics_;
+
+  // The indices of the passes that have not yet been chosen.
+  std::vector<uint32_t> untried_passes_;
+};
+
+}  // namespace fuzz
+}  // namespace spvtools
+
+#endif  // SOURCE_FUZZ_REPEATED_PASS_MANAGER_ADAPTIVE_H_
@@ -24,6 +24,7 @@
 #include "source/fuzz/transformation.h"
 #include "source/fuzz/transformation_context.h"
 #include "source/opt/build_module.h"
+#include "source/spirv_constant.h"
 #include "source/util/make_unique.h"
 
 namespace spvtools {
@@ -47,7 +48,11 @@ Replayer::Replayer(
 
 Replayer::~Replayer() = default;
 
-Replayer::ReplayerResult Replayer::Run() {
+Replayer::ReplayerResult Replayer::Run() { return Run(nullptr, 0, nullptr); }
+
+Replayer::ReplayerResult Replayer::Run(const Checkpoint* checkpoint,
+                                       uint32_t checkpoint_interval,
+                                       std::vector<Checkpoint>* checkpoints) {
   // Check compatibility between the library version being linked with and the
   // header files being used.
   GOOGLE_PROTOBUF_VERIFY_VERSION;
@@ -70,31 +75,43 @@ Replayer::ReplayerResult Replayer::Run() {
             nullptr, nullptr, protobufs::TransformationSequence()};
   }
 
-  // Initial binary should be valid.
-  if (!tools.Validate(&binary_in_[0], binary_in_.size(), validator_options_)) {
+  // Initial binary should be valid.  A checkpoint comes from a replay that
+  // has already checked this.
+  if (checkpoint == nullptr &&
+      !tools.Validate(&binary_in_[0], binary_in_.size(), validator_options_)) {
     consumer_(SPV_MSG_INFO, nullptr, {},
               "Initial binary is invalid; stopping.");
     return {Replayer::ReplayerResultStatus::kInitialBinaryInvalid, nullptr,
             nullptr, protobufs::TransformationSequence()};
   }
 
-  // Build the module from the input binary.
+  // Build the module from the input binary, or clone the module of the
+  // checkpoint.
   std::unique_ptr<opt::IRContext> ir_context =
-      BuildModule(target_env_, consumer_, binary_in_.data(), binary_in_.size());
+      checkpoint ? checkpoint->ir_context->Clone()
+                 : BuildModule(target_env_, consumer_, binary_in_.data(),
+                               binary_in_.size());
   assert(ir_context);
 
   // For replay validation, we track the last valid SPIR-V binary that was
   // observed. Initially this is the input binary.
   std::vector<uint32_t> last_valid_binary;
   if (validate_during_replay_) {
-    last_valid_binary = binary_in_;
+    if (checkpoint) {
+      ir_context->module()->ToBinary(&last_valid_binary, false);
+    } else {
+      last_valid_binary = binary_in_;
+    }
   }
+  // The binary validated after each transformation.  It swaps storage with
+  // |last_valid_binary| so that no allocation is needed per transformation.
+  std::vector<uint32_t> binary_to_validate;
 
   // We find the smallest id that is (a) not in use by the original module, and
   // (b) not used by any transformation in the sequence to be replayed.  This
   // serves as a starting id from which to issue overflow ids if they are
   // required during replay.
-  uint32_t first_overflow_id = ir_context->module()->id_bound();
+  uint32_t first_overflow_id = binary_in_[SPV_INDEX_BOUND];
   for (auto& transformation : transformation_sequence_in_.transformation()) {
     auto fresh_ids = Transformation::FromMessage(transformation)->GetFreshIds();
     if (!fresh_ids.empty()) {
@@ -104,12 +121,20 @@ Replayer::ReplayerResult Replayer::Run() {
     }
   }
 
+  // No overflow ids have been issued at a checkpoint, so a fresh overflow id
+  // source issues the same ids as a replay from the start would.
+  std::unique_ptr<FactManager> fact_manager =
+      checkpoint
+          ? MakeUnique<FactManager>(*checkpoint->fact_manager, ir_context.get())
+          : MakeUnique<FactManager>(ir_context.get());
   std::unique_ptr<TransformationContext> transformation_context =
       MakeUnique<TransformationContext>(
-          MakeUnique<FactManager>(ir_context.get()), validator_options_,
+          std::move(fact_manager), validator_options_,
           MakeUnique<CounterOverflowIdSource>(first_overflow_id));
-  transformation_context->GetFactManager()->AddInitialFacts(consumer_,
-                                                            initial_facts_);
+  if (checkpoint == nullptr) {
+    transformation_context->GetFactManager()->AddInitialFacts(consumer_,
+                                                              initial_facts_);
+  }
 
   // We track the largest id bound observed, to ensure that it only increases
   // as transformations are applied.
@@ -117,15 +142,41 @@ Replayer::ReplayerResult Replayer::Run() {
   (void)(max_observed_id_bound);  // Keep release-mode compilers happy.
 
   protobufs::TransformationSequence transformation_sequence_out;
+  if (checkpoint) {
+    transformation_sequence_out = checkpoint->applied_transformations;
+  }
 
   // Consider the transformation proto messages in turn.
-  uint32_t counter = 0;
-  for (auto& message : transformation_sequence_in_.transformation()) {
+  assert((checkpoints == nullptr || checkpoint_interval > 0) &&
+         "Checkpoints need a positive interval.");
+  uint32_t counter = checkpoint ? checkpoint->num_transformations : 0;
+  assert(counter <= num_transformations_to_apply_ &&
+         "The checkpoint is beyond the transformations to be applied.");
+  for (auto message_it =
+           transformation_sequence_in_.transformation().begin() + counter;
+       message_it != transformation_sequence_in_.transformation().end();
+       ++message_it) {
+    if (checkpoints && counter > 0 && counter % checkpoint_interval == 0 &&
+        transformation_context->GetOverflowIdSource()
+            ->GetIssuedOverflowIds()
+            .empty()) {
+      // Take a checkpoint of the state after the first |counter|
+      // transformations.
+      Checkpoint new_checkpoint;
+      new_checkpoint.num_transformations = counter;
+      new_checkpoint.ir_context = ir_context->Clone();
+      new_checkpoint.fact_manager = MakeUnique<FactManager>(
+          *transformation_context->GetFactManager(), nullptr);
+      new_checkpoint.applied_transformations = transformation_sequence_out;
+      checkpoints->push_back(std::move(new_checkpoint));
+    }
+
     if (counter >= num_transformations_to_apply_) {
       break;
     }
     counter++;
 
+    auto& message = *message_it;
     auto transformation = Transformation::FromMessage(message);
 
     // Check whether the transformation can be applied.
@@ -142,7 +193,7 @@ Replayer::ReplayerResult Replayer::Run() {
       max_observed_id_bound = ir_context->module()->id_bound();
 
       if (validate_during_replay_) {
-        std::vector<uint32_t> binary_to_validate;
+        binary_to_validate.clear();
         ir_context->module()->ToBinary(&binary_to_validate, false);
 
         // Check whether the latest transformation led to a valid binary.
@@ -156,7 +207,7 @@ Replayer::ReplayerResult Replayer::Run() {
         }
 
         // The binary was valid, so it becomes the latest valid binary.
-        last_valid_binary = std::move(binary_to_validate);
+        last_valid_binary.swap(binary_to_validate);
       }
     }
   }
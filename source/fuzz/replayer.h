@@ -18,6 +18,7 @@
 #include <memory>
 #include <vector>
 
+#include "source/fuzz/fact_manager/fact_manager.h"
 #include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
 #include "source/fuzz/transformation_context.h"
 #include "source/opt/ir_context.h"
@@ -46,6 +47,18 @@ class Replayer {
     protobufs::TransformationSequence applied_transformations;
   };
 
+  // The state of a replay after the first |num_transformations|
+  // transformations of a sequence have been considered.  A replay resumed
+  // from the checkpoint works on a clone of |ir_context|, and the facts refer
+  // to no module, so that the replay can be resumed from a checkpoint any
+  // number of times.
+  struct Checkpoint {
+    uint32_t num_transformations;
+    std::unique_ptr<opt::IRContext> ir_context;
+    std::unique_ptr<FactManager> fact_manager;
+    protobufs::TransformationSequence applied_transformations;
+  };
+
   Replayer(spv_target_env target_env, MessageConsumer consumer,
            const std::vector<uint32_t>& binary_in,
            const protobufs::FactSequence& initial_facts,
@@ -73,6 +86,21 @@ class Replayer {
   // sequence, and null pointers for the IR context and transformation context.
   ReplayerResult Run();
 
+  // Like Run(), except that if |checkpoint| is not null, replay resumes from
+  // |checkpoint| rather than starting from |binary_in_|.  The checkpoint must
+  // come from a replay of the same input, with the same initial facts and
+  // validation settings, of a sequence whose first
+  // |checkpoint->num_transformations| transformations are those of
+  // |transformation_sequence_in_|.  The result is then the same as that of
+  // Run().
+  //
+  // If |checkpoints| is not null, a checkpoint is appended to it after every
+  // |checkpoint_interval| transformations.  Checkpoints are only taken before
+  // any overflow id is issued, since the replay of another sequence may issue
+  // overflow ids starting from a different id.
+  ReplayerResult Run(const Checkpoint* checkpoint, uint32_t checkpoint_interval,
+                     std::vector<Checkpoint>* checkpoints);
+
  private:
   // Target environment.
   const spv_target_env target_env_;
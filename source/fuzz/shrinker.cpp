@@ -14,7 +14,9 @@
 
 #include "source/fuzz/shrinker.h"
 
+#include <algorithm>
 #include <sstream>
+#include <thread>
 
 #include "source/fuzz/pseudo_random_generator.h"
 #include "source/fuzz/replayer.h"
@@ -28,6 +30,11 @@ namespace fuzz {
 
 namespace {
 
+// The maximum number of checkpoints kept during a round of shrinking; each
+// shrink attempt resumes replay from the nearest checkpoint before the chunk
+// of transformations it removes.
+const uint32_t kMaxNumCheckpoints = 32;
+
 // A helper to get the size of a protobuf transformation sequence in a less
 // verbose manner.
 uint32_t NumRemainingTransformations(
@@ -68,19 +75,25 @@ Shrinker::Shrinker(
     const protobufs::TransformationSequence& transformation_sequence_in,
     const InterestingnessFunction& interestingness_function,
     uint32_t step_limit, bool validate_during_replay,
-    spv_validator_options validator_options)
+    spv_validator_options validator_options, uint32_t num_jobs)
     : target_env_(target_env),
       consumer_(std::move(consumer)),
       binary_in_(binary_in),
       initial_facts_(initial_facts),
       transformation_sequence_in_(transformation_sequence_in),
       interestingness_function_(interestingness_function),
+      interestingness_cache_(nullptr),
       step_limit_(step_limit),
       validate_during_replay_(validate_during_replay),
-      validator_options_(validator_options) {}
+      validator_options_(validator_options),
+      num_jobs_(std::max(num_jobs, 1u)) {}
 
 Shrinker::~Shrinker() = default;
 
+void Shrinker::SetInterestingnessCache(utils::InterestingnessCache* cache) {
+  interestingness_cache_ = cache;
+}
+
 Shrinker::ShrinkerResult Shrinker::Run() {
   // Check compatibility between the library version being linked with and the
   // header files being used.
@@ -127,7 +140,7 @@ Shrinker::ShrinkerResult Shrinker::Run() {
 
   // Check that the binary produced by applying the initial transformations is
   // indeed interesting.
-  if (!interestingness_function_(current_best_binary, 0)) {
+  if (!IsInteresting(current_best_binary, 0)) {
     consumer_(SPV_MSG_INFO, nullptr, {},
               "Initial binary is not interesting; stopping.");
     return {ShrinkerResultStatus::kInitialBinaryNotInteresting,
@@ -173,57 +186,112 @@ Shrinker::ShrinkerResult Shrinker::Run() {
                NumRemainingTransformations(current_best_transformations) &&
            "All transformations should be in some chunk.");
 
+    // Replay the current best transformations, taking checkpoints at chunk
+    // boundaries.  Removing a chunk does not affect the transformations before
+    // it, so a shrink attempt can resume from a checkpoint at or before the
+    // chunk it removes rather than replaying everything.  Since chunks are
+    // removed from the end, a successful attempt leaves the checkpoints before
+    // its chunk valid for the rest of the round.
+    std::vector<Replayer::Checkpoint> checkpoints;
+    const uint32_t chunks_per_checkpoint =
+        (num_chunks + kMaxNumCheckpoints - 1) / kMaxNumCheckpoints;
+    if (Replayer(target_env_, consumer_, binary_in_, initial_facts_,
+                 current_best_transformations,
+                 NumRemainingTransformations(current_best_transformations),
+                 validate_during_replay_, validator_options_)
+            .Run(nullptr, chunks_per_checkpoint * chunk_size, &checkpoints)
+            .status != Replayer::ReplayerResultStatus::kComplete) {
+      return {ShrinkerResultStatus::kReplayFailed, std::vector<uint32_t>(),
+              protobufs::TransformationSequence()};
+    }
+
     // We go through the transformations in reverse, in chunks of size
     // |chunk_size|, using |chunk_index| to track which chunk to try removing
     // next.  The loop exits early if we reach the shrinking step limit.
+    //
+    // Up to |num_jobs_| consecutive chunks are tried speculatively at once, so
+    // that their interestingness can be evaluated concurrently.  The attempts
+    // are then considered in order, exactly as if they had been made one at a
+    // time: the first interesting attempt is accepted and the remaining ones,
+    // which were derived from the previous best transformations, are
+    // discarded.  This makes the outcome independent of |num_jobs_|.
     for (int chunk_index = num_chunks - 1;
-         attempt < step_limit_ && chunk_index >= 0; chunk_index--) {
-      // Remove a chunk of transformations according to the current index and
-      // chunk size.
-      auto transformations_with_chunk_removed =
-          RemoveChunk(current_best_transformations,
-                      static_cast<uint32_t>(chunk_index), chunk_size);
-
-      // Replay the smaller sequence of transformations to get a next binary and
-      // transformation sequence. Note that the transformations arising from
-      // replay might be even smaller than the transformations with the chunk
-      // removed, because removing those transformations might make further
-      // transformations inapplicable.
-      auto replay_result =
-          Replayer(
-              target_env_, consumer_, binary_in_, initial_facts_,
-              transformations_with_chunk_removed,
-              static_cast<uint32_t>(
-                  transformations_with_chunk_removed.transformation_size()),
-              validate_during_replay_, validator_options_)
-              .Run();
-      if (replay_result.status != Replayer::ReplayerResultStatus::kComplete) {
-        // Replay should not fail; if it does, we need to abort shrinking.
-        return {ShrinkerResultStatus::kReplayFailed, std::vector<uint32_t>(),
-                protobufs::TransformationSequence()};
+         attempt < step_limit_ && chunk_index >= 0;) {
+      const uint32_t num_candidates =
+          std::min({num_jobs_, step_limit_ - attempt,
+                    static_cast<uint32_t>(chunk_index) + 1});
+      std::vector<std::vector<uint32_t>> candidate_binaries;
+      std::vector<protobufs::TransformationSequence> candidate_transformations;
+      for (uint32_t i = 0; i < num_candidates; i++) {
+        const uint32_t candidate_chunk_index =
+            static_cast<uint32_t>(chunk_index) - i;
+
+        // Remove a chunk of transformations according to the candidate index
+        // and chunk size.
+        auto transformations_with_chunk_removed = RemoveChunk(
+            current_best_transformations, candidate_chunk_index, chunk_size);
+
+        // Find the last checkpoint that is not beyond the removed chunk.
+        const Replayer::Checkpoint* checkpoint = nullptr;
+        for (auto& candidate : checkpoints) {
+          if (candidate.num_transformations >
+              candidate_chunk_index * chunk_size) {
+            break;
+          }
+          checkpoint = &candidate;
+        }
+
+        // Replay the smaller sequence of transformations to get a next binary
+        // and transformation sequence. Note that the transformations arising
+        // from replay might be even smaller than the transformations with the
+        // chunk removed, because removing those transformations might make
+        // further transformations inapplicable.
+        auto replay_result =
+            Replayer(
+                target_env_, consumer_, binary_in_, initial_facts_,
+                transformations_with_chunk_removed,
+                static_cast<uint32_t>(
+                    transformations_with_chunk_removed.transformation_size()),
+                validate_during_replay_, validator_options_)
+                .Run(checkpoint, 0, nullptr);
+        if (replay_result.status != Replayer::ReplayerResultStatus::kComplete) {
+          // Replay should not fail; if it does, we need to abort shrinking.
+          return {ShrinkerResultStatus::kReplayFailed, std::vector<uint32_t>(),
+                  protobufs::TransformationSequence()};
+        }
+
+        assert(NumRemainingTransformations(
+                   replay_result.applied_transformations) >=
+                   candidate_chunk_index * chunk_size &&
+               "Removing this chunk of transformations should not have an "
+               "effect on earlier chunks.");
+
+        std::vector<uint32_t> transformed_binary;
+        replay_result.transformed_module->module()->ToBinary(
+            &transformed_binary, false);
+        candidate_binaries.push_back(std::move(transformed_binary));
+        candidate_transformations.push_back(
+            std::move(replay_result.applied_transformations));
       }
 
-      assert(
-          NumRemainingTransformations(replay_result.applied_transformations) >=
-              chunk_index * chunk_size &&
-          "Removing this chunk of transformations should not have an effect "
-          "on earlier chunks.");
-
-      std::vector<uint32_t> transformed_binary;
-      replay_result.transformed_module->module()->ToBinary(&transformed_binary,
-                                                           false);
-      if (interestingness_function_(transformed_binary, attempt)) {
-        // If the binary arising from the smaller transformation sequence is
-        // interesting, this becomes our current best binary and transformation
-        // sequence.
-        current_best_binary = std::move(transformed_binary);
-        current_best_transformations =
-            std::move(replay_result.applied_transformations);
-        progress_this_round = true;
+      std::vector<bool> interesting =
+          EvaluateCandidates(candidate_binaries, attempt);
+      for (uint32_t i = 0; i < num_candidates; i++) {
+        // Either way, this was a shrink attempt, so increment our count of
+        // shrink attempts, and move on to the next chunk.
+        attempt++;
+        chunk_index--;
+        if (interesting[i]) {
+          // If the binary arising from the smaller transformation sequence is
+          // interesting, this becomes our current best binary and
+          // transformation sequence.
+          current_best_binary = std::move(candidate_binaries[i]);
+          current_best_transformations =
+              std::move(candidate_transformations[i]);
+          progress_this_round = true;
+          break;
+        }
       }
-      // Either way, this was a shrink attempt, so increment our count of shrink
-      // attempts.
-      attempt++;
     }
     if (!progress_this_round) {
       // If we didn't manage to remove any chunks at this chunk size, try a
@@ -258,6 +326,47 @@ Shrinker::ShrinkerResult Shrinker::Run() {
           std::move(current_best_transformations)};
 }
 
+std::vector<bool> Shrinker::EvaluateCandidates(
+    const std::vector<std::vector<uint32_t>>& candidates,
+    uint32_t attempt) const {
+  std::vector<bool> result(candidates.size(), false);
+  if (candidates.size() == 1) {
+    result[0] = IsInteresting(candidates[0], attempt);
+    return result;
+  }
+  // std::vector<bool> cannot be written to concurrently, so each worker
+  // records its verdict in a separate byte.
+  std::vector<char> verdicts(candidates.size(), 0);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    workers.emplace_back([this, &candidates, &verdicts, i, attempt]() {
+      verdicts[i] =
+          IsInteresting(candidates[i], attempt + static_cast<uint32_t>(i));
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (size_t i = 0; i < candidates.size(); i++) {
+    result[i] = verdicts[i] != 0;
+  }
+  return result;
+}
+
+bool Shrinker::IsInteresting(const std::vector<uint32_t>& binary,
+                             uint32_t counter) const {
+  if (!interestingness_cache_) {
+    return interestingness_function_(binary, counter);
+  }
+  const std::string digest = utils::InterestingnessCache::ComputeDigest(binary);
+  bool verdict;
+  if (!interestingness_cache_->Lookup(digest, &verdict)) {
+    verdict = interestingness_function_(binary, counter);
+    interestingness_cache_->Insert(digest, verdict);
+  }
+  return verdict;
+}
+
 uint32_t Shrinker::GetIdBound(const std::vector<uint32_t>& binary) const {
   // Build the module from the input binary.
   std::unique_ptr<opt::IRContext> ir_context =
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
+#include "source/util/interestingness_cache.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
@@ -52,6 +53,9 @@ class Shrinker {
   //
   // The notion of "interesting" depends on what properties of the binary or
   // tools that process the binary we are trying to maintain during shrinking.
+  //
+  // If the shrinker is constructed with more than one job, the function is
+  // invoked from several threads at once and must be thread-safe.
   using InterestingnessFunction = std::function<bool(
       const std::vector<uint32_t>& binary, uint32_t counter)>;
 
@@ -61,7 +65,7 @@ class Shrinker {
            const protobufs::TransformationSequence& transformation_sequence_in,
            const InterestingnessFunction& interestingness_function,
            uint32_t step_limit, bool validate_during_replay,
-           spv_validator_options validator_options);
+           spv_validator_options validator_options, uint32_t num_jobs);
 
   // Disables copy/move constructor/assignment operations.
   Shrinker(const Shrinker&) = delete;
@@ -71,6 +75,15 @@ class Shrinker {
 
   ~Shrinker();
 
+  // Sets a cache of interestingness verdicts, consulted before the
+  // interestingness function is invoked and updated with its results.  The
+  // cache is not owned, must outlive any call to Run, and may be shared with
+  // other shrinkers.  A null |cache|, the default, disables caching.
+  //
+  // Caching is only appropriate when the interestingness function gives the
+  // same verdict whenever it is invoked on the same binary.
+  void SetInterestingnessCache(utils::InterestingnessCache* cache);
+
   // Requires that when |transformation_sequence_in_| is applied to |binary_in_|
   // with initial facts |initial_facts_|, the resulting binary is interesting
   // according to |interestingness_function_|.
@@ -87,6 +100,18 @@ class Shrinker {
   ShrinkerResult Run();
 
  private:
+  // Evaluates the interestingness function on each of the |candidates|,
+  // concurrently if there are several, and returns the verdicts.  The i-th
+  // candidate is presented as shrink attempt |attempt| + i.
+  std::vector<bool> EvaluateCandidates(
+      const std::vector<std::vector<uint32_t>>& candidates,
+      uint32_t attempt) const;
+
+  // Returns the verdict of the interestingness function on |binary|, which is
+  // presented with |counter|, unless the verdict is already cached.
+  bool IsInteresting(const std::vector<uint32_t>& binary,
+                     uint32_t counter) const;
+
   // Returns the id bound for the given SPIR-V binary, which is assumed to be
   // valid.
   uint32_t GetIdBound(const std::vector<uint32_t>& binary) const;
@@ -110,6 +135,9 @@ class Shrinker {
   // Function that decides whether a given binary is interesting.
   const InterestingnessFunction& interestingness_function_;
 
+  // Optional cache of interestingness verdicts; not owned.
+  utils::InterestingnessCache* interestingness_cache_;
+
   // Step limit to decide when to terminate shrinking early.
   const uint32_t step_limit_;
 
@@ -119,6 +147,10 @@ class Shrinker {
 
   // Options to control validation.
   spv_validator_options validator_options_;
+
+  // The maximum number of shrink attempts whose interestingness is evaluated
+  // concurrently.
+  const uint32_t num_jobs_;
 };
 
 }  // namespace fuzz
@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/transformation_stream.h"
+
+#include <cstring>
+
+namespace spvtools {
+namespace fuzz {
+
+namespace {
+
+// A varint-encoded 32-bit size takes at most 5 bytes.
+const uint32_t kMaxVarintBytes = 5;
+
+}  // namespace
+
+const char kTransformationStreamMagic[4] = {'S', 'F', 'T', '1'};
+
+TransformationStreamWriter::TransformationStreamWriter(std::ostream* out)
+    : out_(out) {
+  out_->write(kTransformationStreamMagic, sizeof(kTransformationStreamMagic));
+  out_->flush();
+}
+
+bool TransformationStreamWriter::Write(
+    const protobufs::Transformation& transformation) {
+  buffer_.clear();
+  if (!transformation.SerializeToString(&buffer_)) {
+    return false;
+  }
+  char size_bytes[kMaxVarintBytes];
+  uint32_t num_size_bytes = 0;
+  auto size = static_cast<uint32_t>(buffer_.size());
+  do {
+    size_bytes[num_size_bytes] = static_cast<char>(size & 0x7f);
+    size >>= 7;
+    if (size) {
+      size_bytes[num_size_bytes] |= static_cast<char>(0x80);
+    }
+    num_size_bytes++;
+  } while (size);
+  out_->write(size_bytes, num_size_bytes);
+  out_->write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  out_->flush();
+  return out_->good();
+}
+
+TransformationStreamReader::TransformationStreamReader(std::istream* in)
+    : in_(in) {
+  char header[sizeof(kTransformationStreamMagic)];
+  in_->read(header, sizeof(header));
+  header_is_valid_ =
+      in_->gcount() == sizeof(header) &&
+      std::memcmp(header, kTransformationStreamMagic, sizeof(header)) == 0;
+}
+
+TransformationStreamReader::Status TransformationStreamReader::Next(
+    protobufs::Transformation* transformation) {
+  if (!header_is_valid_) {
+    return Status::kMalformed;
+  }
+  // Decode the size of the record.
+  uint32_t size = 0;
+  for (uint32_t i = 0;; i++) {
+    const int byte = in_->get();
+    if (byte == std::char_traits<char>::eof()) {
+      return i == 0 ? Status::kEndOfStream : Status::kTruncated;
+    }
+    if (i == kMaxVarintBytes) {
+      return Status::kMalformed;
+    }
+    size |= static_cast<uint32_t>(byte & 0x7f) << (7 * i);
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  buffer_.resize(size);
+  if (size > 0) {
+    in_->read(&buffer_[0], static_cast<std::streamsize>(size));
+    if (static_cast<uint32_t>(in_->gcount()) != size) {
+      return Status::kTruncated;
+    }
+  }
+  if (!transformation->ParseFromString(buffer_)) {
+    return Status::kMalformed;
+  }
+  return Status::kTransformationRead;
+}
+
+bool IsTransformationStream(std::istream* in) {
+  const auto position = in->tellg();
+  char header[sizeof(kTransformationStreamMagic)];
+  in->read(header, sizeof(header));
+  const bool result =
+      in->gcount() == sizeof(header) &&
+      std::memcmp(header, kTransformationStreamMagic, sizeof(header)) == 0;
+  in->clear();
+  in->seekg(position);
+  return result;
+}
+
+bool ReadTransformationStream(std::istream* in,
+                              protobufs::TransformationSequence* sequence,
+                              bool* truncated) {
+  *truncated = false;
+  TransformationStreamReader reader(in);
+  while (true) {
+    protobufs::Transformation transformation;
+    switch (reader.Next(&transformation)) {
+      case TransformationStreamReader::Status::kTransformationRead:
+        *sequence->add_transformation() = std::move(transformation);
+        break;
+      case TransformationStreamReader::Status::kEndOfStream:
+        return true;
+      case TransformationStreamReader::Status::kTruncated:
+        *truncated = true;
+        return true;
+      case TransformationStreamReader::Status::kMalformed:
+        return false;
+    }
+  }
+}
+
+}  // namespace fuzz
+}  // namespace spvtools
@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_FUZZ_TRANSFORMATION_STREAM_H_
+#define SOURCE_FUZZ_TRANSFORMATION_STREAM_H_
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
+
+namespace spvtools {
+namespace fuzz {
+
+// An append-only format for sequences of transformations, allowing a sequence
+// to be written as transformations are applied and read back one
+// transformation at a time.
+//
+// A stream starts with the four bytes of |kTransformationStreamMagic|, and is
+// followed by one record per transformation.  Each record is the size in bytes
+// of a serialized protobufs::Transformation message, encoded as a base-128
+// varint, followed by the serialized message itself.  A stream that was cut
+// short, e.g. because the process writing it crashed, can still be read up to
+// its last complete record.
+extern const char kTransformationStreamMagic[4];
+
+// Writes transformations to a stream in the above format.
+class TransformationStreamWriter {
+ public:
+  // Writes the stream header to |out|, which must outlive the writer.
+  explicit TransformationStreamWriter(std::ostream* out);
+
+  // Appends a record for |transformation| and flushes the stream, so that the
+  // record survives if the process subsequently crashes.  Returns false if
+  // writing failed.
+  bool Write(const protobufs::Transformation& transformation);
+
+  // Returns true if and only if no write to the stream has failed.
+  bool good() const { return out_->good(); }
+
+ private:
+  std::ostream* out_;
+
+  // Storage for the serialized transformation, kept between writes to reuse
+  // its allocation.
+  std::string buffer_;
+};
+
+// Reads transformations from a stream in the above format.
+class TransformationStreamReader {
+ public:
+  enum class Status {
+    kTransformationRead,
+    kEndOfStream,
+    kTruncated,
+    kMalformed,
+  };
+
+  // Consumes the stream header from |in|, which must outlive the reader.  If
+  // |in| does not start with the header, every call to Next() returns
+  // kMalformed.
+  explicit TransformationStreamReader(std::istream* in);
+
+  // Reads the next record into |transformation|.  Returns kEndOfStream if
+  // there are no more records, kTruncated if the stream ends part of the way
+  // through a record, and kMalformed if a record cannot be parsed.
+  Status Next(protobufs::Transformation* transformation);
+
+ private:
+  std::istream* in_;
+
+  // Whether the stream started with a valid header.
+  bool header_is_valid_;
+
+  // Storage for the serialized transformation, kept between reads to reuse its
+  // allocation.
+  std::string buffer_;
+};
+
+// Returns true if and only if the next bytes of |in| are the stream header.
+// The position of |in| is left unchanged.
+bool IsTransformationStream(std::istream* in);
+
+// Reads every complete record of the stream |in| into |sequence|.  Returns
+// false if a record is malformed.  A truncated final record is dropped; in
+// that case |*truncated| is set to true, and otherwise it is set to false.
+bool ReadTransformationStream(std::istream* in,
+                              protobufs::TransformationSequence* sequence,
+                              bool* truncated);
+
+}  // namespace fuzz
+}  // namespace spvtools
+
+#endif  // SOURCE_FUZZ_TRANSFORMATION_STREAM_H_
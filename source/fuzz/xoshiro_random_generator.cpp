@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/xoshiro_random_generator.h"
+
+#include <cassert>
+
+namespace spvtools {
+namespace fuzz {
+
+namespace {
+
+uint64_t RotateLeft(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+// One step of the splitmix64 generator, used to expand the seed into the
+// generator's state, as recommended by the authors of xoshiro256**.
+uint64_t SplitMix64(uint64_t* x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+}  // namespace
+
+XoshiroRandomGenerator::XoshiroRandomGenerator(uint32_t seed)
+    : bool_bits_(0), num_bool_bits_(0) {
+  uint64_t x = seed;
+  for (auto& word : state_) {
+    word = SplitMix64(&x);
+  }
+}
+
+XoshiroRandomGenerator::~XoshiroRandomGenerator() = default;
+
+uint64_t XoshiroRandomGenerator::Next() {
+  const uint64_t result = RotateLeft(state_[1] * 5, 7) * 9;
+  const uint64_t t = state_[1] << 17;
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+  state_[2] ^= t;
+  state_[3] = RotateLeft(state_[3], 45);
+  return result;
+}
+
+uint32_t XoshiroRandomGenerator::RandomUint32(uint32_t bound) {
+  assert(bound > 0 && "Bound must be positive");
+  // Scale 32 random bits to [0, bound) by multiplication, rejecting the few
+  // values that would bias the result.  The division needed to find them is
+  // only performed when a value lands near the bottom of a bucket.
+  uint64_t product = (Next() >> 32) * bound;
+  auto low = static_cast<uint32_t>(product);
+  if (low < bound) {
+    const uint32_t threshold = (0u - bound) % bound;
+    while (low < threshold) {
+      product = (Next() >> 32) * bound;
+      low = static_cast<uint32_t>(product);
+    }
+  }
+  return static_cast<uint32_t>(product >> 32);
+}
+
+uint64_t XoshiroRandomGenerator::RandomUint64(uint64_t bound) {
+  assert(bound > 0 && "Bound must be positive");
+  // Reject the values below 2^64 mod |bound|, so that the remaining range is a
+  // multiple of |bound|.
+  const uint64_t threshold = (0ull - bound) % bound;
+  uint64_t value;
+  do {
+    value = Next();
+  } while (value < threshold);
+  return value % bound;
+}
+
+uint32_t XoshiroRandomGenerator::RandomPercentage() {
+  // We use 101 because we want a result in the closed interval [0, 100], and
+  // RandomUint32 is not inclusive of its bound.
+  return RandomUint32(101);
+}
+
+bool XoshiroRandomGenerator::RandomBool() {
+  if (num_bool_bits_ == 0) {
+    bool_bits_ = Next();
+    num_bool_bits_ = 64;
+  }
+  const bool result = (bool_bits_ & 1) != 0;
+  bool_bits_ >>= 1;
+  num_bool_bits_--;
+  return result;
+}
+
+double XoshiroRandomGenerator::RandomDouble() {
+  // Use the top 53 bits, dividing by 2^53 - 1 so that both 0 and 1 can be
+  // produced.
+  return static_cast<double>(Next() >> 11) /
+         static_cast<double>((1ull << 53) - 1);
+}
+
+}  // namespace fuzz
+}  // namespace spvtools
@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_FUZZ_XOSHIRO_RANDOM_GENERATOR_H_
+#define SOURCE_FUZZ_XOSHIRO_RANDOM_GENERATOR_H_
+
+#include <cstdint>
+
+#include "source/fuzz/random_generator.h"
+
+namespace spvtools {
+namespace fuzz {
+
+// Generates random data using the xoshiro256** generator of Blackman and
+// Vigna, which is considerably cheaper per value than std::mt19937 and has a
+// much smaller state.  The sequence of values produced depends only on the
+// seed, so runs remain reproducible.
+//
+// Bounded integers are produced without division in the common case (Lemire,
+// 2019), and booleans are served from a buffer of bits drawn 64 at a time.
+class XoshiroRandomGenerator : public RandomGenerator {
+ public:
+  explicit XoshiroRandomGenerator(uint32_t seed);
+
+  ~XoshiroRandomGenerator() override;
+
+  uint32_t RandomUint32(uint32_t bound) override;
+
+  uint64_t RandomUint64(uint64_t bound) override;
+
+  uint32_t RandomPercentage() override;
+
+  bool RandomBool() override;
+
+  double RandomDouble() override;
+
+ private:
+  // Advances the generator and returns 64 random bits.
+  uint64_t Next();
+
+  uint64_t state_[4];
+
+  // Bits not yet used by RandomBool(), and how many of them remain.
+  uint64_t bool_bits_;
+  uint32_t num_bool_bits_;
+};
+
+}  // namespace fuzz
+}  // namespace spvtools
+
+#endif  // SOURCE_FUZZ_XOSHIRO_RANDOM_GENERATOR_H_
@@ -15,12 +15,15 @@
 #include "spirv-tools/libspirv.hpp"
 
 #include <iostream>
-
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "source/module_reflection.h"
+#include "source/spirv_validator_options.h"
 #include "source/table.h"
+#include "source/util/parallel.h"
 
 namespace spvtools {
 
@@ -44,6 +47,10 @@ void Context::SetMessageConsumer(MessageConsumer consumer) {
   SetContextMessageConsumer(context_, std::move(consumer));
 }
 
+void Context::SetAllocator(const spv_allocator_t* allocator) {
+  spvContextSetAllocator(context_, allocator);
+}
+
 spv_context& Context::CContext() { return context_; }
 
 const spv_context& Context::CContext() const { return context_; }
@@ -87,6 +94,20 @@ bool SpirvTools::Assemble(const char* text, const size_t text_size,
   return status == SPV_SUCCESS;
 }
 
+bool SpirvTools::Assemble(const char* text, const size_t text_size,
+                          std::vector<uint32_t>* binary, uint32_t options,
+                          uint32_t num_threads) const {
+  spv_binary spvbinary = nullptr;
+  spv_result_t status =
+      spvTextToBinaryParallel(impl_->context, text, text_size, options,
+                              num_threads, &spvbinary, nullptr);
+  if (status == SPV_SUCCESS) {
+    binary->assign(spvbinary->code, spvbinary->code + spvbinary->wordCount);
+  }
+  spvBinaryDestroy(spvbinary);
+  return status == SPV_SUCCESS;
+}
+
 bool SpirvTools::Disassemble(const std::vector<uint32_t>& binary,
                              std::string* text, uint32_t options) const {
   return Disassemble(binary.data(), binary.size(), text, options);
@@ -104,6 +125,56 @@ bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
   return status == SPV_SUCCESS;
 }
 
+bool SpirvTools::Disassemble(const uint32_t* binary, const size_t binary_size,
+                             std::string* text, uint32_t options,
+                             uint32_t num_threads) const {
+  spv_text spvtext = nullptr;
+  spv_result_t status =
+      spvBinaryToTextParallel(impl_->context, binary, binary_size, options,
+                              num_threads, &spvtext, nullptr);
+  if (status == SPV_SUCCESS) {
+    text->assign(spvtext->str, spvtext->str + spvtext->length);
+  }
+  spvTextDestroy(spvtext);
+  return status == SPV_SUCCESS;
+}
+
+bool SpirvTools::Compress(const std::vector<uint32_t>& binary,
+                          std::vector<uint8_t>* compressed) const {
+  return Compress(binary.data(), binary.size(), compressed);
+}
+
+bool SpirvTools::Compress(const uint32_t* binary, const size_t binary_size,
+                          std::vector<uint8_t>* compressed) const {
+  spv_compressed_binary spvcompressed = nullptr;
+  spv_result_t status = spvBinaryCompress(impl_->context, binary, binary_size,
+                                          &spvcompressed, nullptr);
+  if (status == SPV_SUCCESS) {
+    compressed->assign(spvcompressed->data,
+                       spvcompressed->data + spvcompressed->size);
+  }
+  spvCompressedBinaryDestroy(impl_->context, spvcompressed);
+  return status == SPV_SUCCESS;
+}
+
+bool SpirvTools::Decompress(const std::vector<uint8_t>& compressed,
+                            std::vector<uint32_t>* binary) const {
+  return Decompress(compressed.data(), compressed.size(), binary);
+}
+
+bool SpirvTools::Decompress(const uint8_t* compressed,
+                            const size_t compressed_size,
+                            std::vector<uint32_t>* binary) const {
+  spv_binary spvbinary = nullptr;
+  spv_result_t status = spvBinaryDecompress(
+      impl_->context, compressed, compressed_size, &spvbinary, nullptr);
+  if (status == SPV_SUCCESS) {
+    binary->assign(spvbinary->code, spvbinary->code + spvbinary->wordCount);
+  }
+  spvBinaryDestroyWithContext(impl_->context, spvbinary);
+  return status == SPV_SUCCESS;
+}
+
 bool SpirvTools::Validate(const std::vector<uint32_t>& binary) const {
   return Validate(binary.data(), binary.size());
 }
@@ -117,6 +188,12 @@ bool SpirvTools::Validate(const uint32_t* binary,
 bool SpirvTools::Validate(const uint32_t* binary, const size_t binary_size,
                           spv_validator_options options) const {
   spv_const_binary_t the_binary{binary, binary_size};
+  // Without a consumer the diagnostic would be dropped, so the validator is
+  // not asked for one and skips building its messages.
+  if (!impl_->context->consumer) {
+    return spvValidateWithOptions(impl_->context, options, &the_binary,
+                                  nullptr) == SPV_SUCCESS;
+  }
   spv_diagnostic diagnostic = nullptr;
   bool valid = spvValidateWithOptions(impl_->context, options, &the_binary,
                                       &diagnostic) == SPV_SUCCESS;
@@ -128,6 +205,33 @@ bool SpirvTools::Validate(const uint32_t* binary, const size_t binary_size,
   return valid;
 }
 
+std::future<bool> SpirvTools::ValidateAsync(
+    std::vector<uint32_t> binary, spv_validator_options options) const {
+  auto shared_binary =
+      std::make_shared<std::vector<uint32_t>>(std::move(binary));
+  auto shared_options = std::make_shared<spv_validator_options_t>(*options);
+  return utils::RunAsync<bool>(
+      options->executor, options->executor_data,
+      [this, shared_binary, shared_options]() {
+        return Validate(shared_binary->data(), shared_binary->size(),
+                        shared_options.get());
+      });
+}
+
+bool SpirvTools::Reflect(const uint32_t* binary, const size_t binary_size,
+                         ModuleReflection* reflection) const {
+  BinaryReader reader(impl_->context->target_env, binary, binary_size);
+  reader.SetMessageConsumer(impl_->context->consumer);
+  ModuleReflectionBuilder builder;
+  for (const spv_parsed_instruction_t& inst : reader) {
+    if (inst.opcode == SpvOpFunction) break;
+    builder.AddInstruction(inst.words, inst.num_words);
+  }
+  if (reader.status() != SPV_SUCCESS) return false;
+  *reflection = builder.TakeReflection();
+  return true;
+}
+
 bool SpirvTools::IsValid() const { return impl_->context != nullptr; }
 
 }  // namespace spvtools
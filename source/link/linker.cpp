@@ -15,8 +15,10 @@
 #include "spirv-tools/linker.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -30,12 +32,15 @@
 #include "source/opt/build_module.h"
 #include "source/opt/compact_ids_pass.h"
 #include "source/opt/decoration_manager.h"
+#include "source/opt/eliminate_dead_functions_pass.h"
 #include "source/opt/ir_loader.h"
+#include "source/opt/loaded_module.h"
 #include "source/opt/pass_manager.h"
 #include "source/opt/remove_duplicates_pass.h"
 #include "source/opt/type_manager.h"
 #include "source/spirv_target_env.h"
 #include "source/util/make_unique.h"
+#include "source/util/parallel.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
@@ -70,15 +75,26 @@ struct LinkageEntry {
 };
 using LinkageTable = std::vector<LinkageEntry>;
 
+// Invokes |f| on each index in [0, |count|), spreading the calls over up to
+// as many threads as |options| allows, on the tasks of its executor if it has
+// one.  Calls for different indices may run concurrently.  No call is started
+// once one has returned false, so with a single thread the indices after the
+// first failing one are not processed at all.
+void ForEachIndex(size_t count, const LinkerOptions& options,
+                  const std::function<bool(size_t)>& f);
+
 // Shifts the IDs used in each binary of |modules| so that they occupy a
 // disjoint range from the other binaries, and compute the new ID bound which
-// is returned in |max_id_bound|.
+// is returned in |max_id_bound|.  The offset of each module is known up front
+// from the ID bounds of those preceding it, so the modules are shifted
+// independently, using as many threads as |options| allows.
 //
 // Both |modules| and |max_id_bound| should not be null, and |modules| should
 // not be empty either. Furthermore |modules| should not contain any null
 // pointers.
 spv_result_t ShiftIdsInModules(const MessageConsumer& consumer,
                                std::vector<opt::Module*>* modules,
+                               const LinkerOptions& options,
                                uint32_t* max_id_bound);
 
 // Generates the header for the linked module and returns it in |header|.
@@ -147,8 +163,51 @@ spv_result_t RemoveLinkageSpecificInstructions(
 spv_result_t VerifyIds(const MessageConsumer& consumer,
                        opt::IRContext* linked_context);
 
+// Links |library_module|, if not null, and the modules of |ir_contexts| into
+// |linked|.  |library_module| is left unchanged, while the ids of the modules
+// of |ir_contexts| are shifted.  All modules must be for the target
+// environment of |context|.
+spv_result_t LinkContexts(const Context& context, Module* library_module,
+                          std::vector<std::unique_ptr<IRContext>>* ir_contexts,
+                          std::unique_ptr<IRContext>* linked,
+                          const LinkerOptions& options);
+
+// Links |library_module|, if not null, and the |num_binaries| modules given by
+// |binaries| and |binary_sizes| into |linked_binary|.  |library_module| is
+// left unchanged.
+spv_result_t LinkModules(const Context& context, Module* library_module,
+                         const uint32_t* const* binaries,
+                         const size_t* binary_sizes, size_t num_binaries,
+                         std::vector<uint32_t>* linked_binary,
+                         const LinkerOptions& options);
+
+void ForEachIndex(size_t count, const LinkerOptions& options,
+                  const std::function<bool(size_t)>& f) {
+  const size_t num_workers =
+      std::min<size_t>(std::max(options.GetNumThreads(), 1u), count);
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      if (!f(i)) return;
+    }
+    return;
+  }
+  // Indices are handed out one at a time, as the work per index can vary a
+  // lot.
+  std::atomic<size_t> next_index(0);
+  std::atomic<bool> failed(false);
+  Executor* executor = options.GetExecutor();
+  utils::RunOnWorkers(num_workers, executor ? &Executor::Run : nullptr,
+                      executor, [&next_index, &failed, count, &f]() {
+                        for (size_t i = next_index++; i < count && !failed;
+                             i = next_index++) {
+                          if (!f(i)) failed = true;
+                        }
+                      });
+}
+
 spv_result_t ShiftIdsInModules(const MessageConsumer& consumer,
                                std::vector<opt::Module*>* modules,
+                               const LinkerOptions& options,
                                uint32_t* max_id_bound) {
   spv_position_t position = {};
 
@@ -162,22 +221,31 @@ spv_result_t ShiftIdsInModules(const MessageConsumer& consumer,
     return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_DATA)
            << "|max_id_bound| of ShiftIdsInModules should not be null.";
 
+  std::vector<uint32_t> id_offsets(modules->size(), 0u);
   uint32_t id_bound = modules->front()->IdBound() - 1u;
-  for (auto module_iter = modules->begin() + 1; module_iter != modules->end();
-       ++module_iter) {
-    Module* module = *module_iter;
-    module->ForEachInst([&id_bound](Instruction* insn) {
-      insn->ForEachId([&id_bound](uint32_t* id) { *id += id_bound; });
-    });
-    id_bound += module->IdBound() - 1u;
+  for (size_t i = 1; i < modules->size(); ++i) {
+    id_offsets[i] = id_bound;
+    id_bound += (*modules)[i]->IdBound() - 1u;
     if (id_bound > 0x3FFFFF)
       return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_ID)
              << "The limit of IDs, 4194303, was exceeded:"
              << " " << id_bound << " is the current ID bound.";
-
-    // Invalidate the DefUseManager
-    module->context()->InvalidateAnalyses(opt::IRContext::kAnalysisDefUse);
   }
+
+  ForEachIndex(modules->size() - 1, options,
+               [modules, &id_offsets](size_t index) {
+                 Module* module = (*modules)[index + 1];
+                 const uint32_t id_offset = id_offsets[index + 1];
+                 module->ForEachInst([id_offset](Instruction* insn) {
+                   insn->ForEachId(
+                       [id_offset](uint32_t* id) { *id += id_offset; });
+                 });
+
+                 // Invalidate the DefUseManager
+                 module->context()->InvalidateAnalyses(
+                     opt::IRContext::kAnalysisDefUse);
+                 return true;
+               });
   ++id_bound;
   if (id_bound > 0x3FFFFF)
     return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_ID)
@@ -390,6 +458,16 @@ spv_result_t GetImportExportPairs(const MessageConsumer& consumer,
   std::vector<LinkageSymbolInfo> imports;
   std::unordered_map<std::string, std::vector<LinkageSymbolInfo>> exports;
 
+  // Index the functions once, rather than searching them for each function
+  // symbol: a library can export thousands of functions.
+  std::unordered_map<SpvId, const opt::Function*> functions;
+  // range-based for loop calls begin()/end(), but never cbegin()/cend(),
+  // which will not work here.
+  for (auto func_iter = linked_context.module()->cbegin();
+       func_iter != linked_context.module()->cend(); ++func_iter) {
+    functions.emplace(func_iter->result_id(), &*func_iter);
+  }
+
   // Figure out the imports and exports
   for (const auto& decoration : linked_context.annotations()) {
     if (decoration.opcode() != SpvOpDecorate ||
@@ -431,14 +509,12 @@ spv_result_t GetImportExportPairs(const MessageConsumer& consumer,
     } else if (def_inst->opcode() == SpvOpFunction) {
       symbol_info.type_id = def_inst->GetSingleWordInOperand(1u);
 
-      // range-based for loop calls begin()/end(), but never cbegin()/cend(),
-      // which will not work here.
-      for (auto func_iter = linked_context.module()->cbegin();
-           func_iter != linked_context.module()->cend(); ++func_iter) {
-        if (func_iter->result_id() != id) continue;
-        func_iter->ForEachParam([&symbol_info](const Instruction* inst) {
-          symbol_info.parameter_ids.push_back(inst->result_id());
-        });
+      const auto function = functions.find(id);
+      if (function != functions.end()) {
+        function->second->ForEachParam(
+            [&symbol_info](const Instruction* inst) {
+              symbol_info.parameter_ids.push_back(inst->result_id());
+            });
       }
     } else {
       return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
@@ -635,133 +711,295 @@ spv_result_t VerifyIds(const MessageConsumer& consumer,
   return SPV_SUCCESS;
 }
 
-}  // namespace
-
-spv_result_t Link(const Context& context,
-                  const std::vector<std::vector<uint32_t>>& binaries,
-                  std::vector<uint32_t>* linked_binary,
-                  const LinkerOptions& options) {
-  std::vector<const uint32_t*> binary_ptrs;
-  binary_ptrs.reserve(binaries.size());
-  std::vector<size_t> binary_sizes;
-  binary_sizes.reserve(binaries.size());
-
-  for (const auto& binary : binaries) {
-    binary_ptrs.push_back(binary.data());
-    binary_sizes.push_back(binary.size());
-  }
-
-  return Link(context, binary_ptrs.data(), binary_sizes.data(), binaries.size(),
-              linked_binary, options);
-}
-
-spv_result_t Link(const Context& context, const uint32_t* const* binaries,
-                  const size_t* binary_sizes, size_t num_binaries,
-                  std::vector<uint32_t>* linked_binary,
-                  const LinkerOptions& options) {
-  spv_position_t position = {};
+spv_result_t LinkContexts(const Context& context, Module* library_module,
+                          std::vector<std::unique_ptr<IRContext>>* ir_contexts,
+                          std::unique_ptr<IRContext>* linked,
+                          const LinkerOptions& options) {
   const spv_context& c_context = context.CContext();
   const MessageConsumer& consumer = c_context->consumer;
 
-  linked_binary->clear();
-  if (num_binaries == 0u)
-    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
-           << "No modules were given.";
-
-  std::vector<std::unique_ptr<IRContext>> ir_contexts;
   std::vector<Module*> modules;
-  modules.reserve(num_binaries);
-  for (size_t i = 0u; i < num_binaries; ++i) {
-    const uint32_t schema = binaries[i][4u];
-    if (schema != 0u) {
-      position.index = 4u;
-      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
-             << "Schema is non-zero for module " << i << ".";
-    }
-
-    std::unique_ptr<IRContext> ir_context = BuildModule(
-        c_context->target_env, consumer, binaries[i], binary_sizes[i]);
-    if (ir_context == nullptr)
-      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
-             << "Failed to build a module out of " << ir_contexts.size() << ".";
-    modules.push_back(ir_context->module());
-    ir_contexts.push_back(std::move(ir_context));
-  }
+  modules.reserve(ir_contexts->size() + 1);
+  // The library comes first, so that its ids are not shifted: it is only
+  // read, and can therefore be linked against again.
+  if (library_module != nullptr) modules.push_back(library_module);
+  for (auto& ir_context : *ir_contexts) modules.push_back(ir_context->module());
 
   // Phase 1: Shift the IDs used in each binary so that they occupy a disjoint
   //          range from the other binaries, and compute the new ID bound.
   uint32_t max_id_bound = 0u;
-  spv_result_t res = ShiftIdsInModules(consumer, &modules, &max_id_bound);
+  spv_result_t res =
+      ShiftIdsInModules(consumer, &modules, options, &max_id_bound);
   if (res != SPV_SUCCESS) return res;
 
   // Phase 2: Generate the header
   opt::ModuleHeader header;
   res = GenerateHeader(consumer, modules, max_id_bound, &header);
   if (res != SPV_SUCCESS) return res;
-  IRContext linked_context(c_context->target_env, consumer);
-  linked_context.module()->SetHeader(header);
+  auto linked_context = MakeUnique<IRContext>(c_context->target_env, consumer);
+  linked_context->module()->SetHeader(header);
 
   // Phase 3: Merge all the binaries into a single one.
   AssemblyGrammar grammar(c_context);
-  res = MergeModules(consumer, modules, grammar, &linked_context);
+  res = MergeModules(consumer, modules, grammar, linked_context.get());
   if (res != SPV_SUCCESS) return res;
 
   if (options.GetVerifyIds()) {
-    res = VerifyIds(consumer, &linked_context);
+    res = VerifyIds(consumer, linked_context.get());
     if (res != SPV_SUCCESS) return res;
   }
 
   // Phase 4: Find the import/export pairs
   LinkageTable linkings_to_do;
-  res = GetImportExportPairs(consumer, linked_context,
-                             *linked_context.get_def_use_mgr(),
-                             *linked_context.get_decoration_mgr(),
+  res = GetImportExportPairs(consumer, *linked_context,
+                             *linked_context->get_def_use_mgr(),
+                             *linked_context->get_decoration_mgr(),
                              options.GetAllowPartialLinkage(), &linkings_to_do);
   if (res != SPV_SUCCESS) return res;
 
   // Phase 5: Ensure the import and export have the same types and decorations.
-  res =
-      CheckImportExportCompatibility(consumer, linkings_to_do, &linked_context);
+  res = CheckImportExportCompatibility(consumer, linkings_to_do,
+                                       linked_context.get());
   if (res != SPV_SUCCESS) return res;
 
   // Phase 6: Remove duplicates
   PassManager manager;
   manager.SetMessageConsumer(consumer);
   manager.AddPass<RemoveDuplicatesPass>();
-  opt::Pass::Status pass_res = manager.Run(&linked_context);
+  opt::Pass::Status pass_res = manager.Run(linked_context.get());
   if (pass_res == opt::Pass::Status::Failure) return SPV_ERROR_INVALID_DATA;
 
   // Phase 7: Remove all names and decorations of import variables/functions
   for (const auto& linking_entry : linkings_to_do) {
-    linked_context.KillNamesAndDecorates(linking_entry.imported_symbol.id);
+    linked_context->KillNamesAndDecorates(linking_entry.imported_symbol.id);
     for (const auto parameter_id :
          linking_entry.imported_symbol.parameter_ids) {
-      linked_context.KillNamesAndDecorates(parameter_id);
+      linked_context->KillNamesAndDecorates(parameter_id);
     }
   }
 
   // Phase 8: Rematch import variables/functions to export variables/functions
   for (const auto& linking_entry : linkings_to_do) {
-    linked_context.ReplaceAllUsesWith(linking_entry.imported_symbol.id,
+    linked_context->ReplaceAllUsesWith(linking_entry.imported_symbol.id,
                                       linking_entry.exported_symbol.id);
   }
 
   // Phase 9: Remove linkage specific instructions, such as import/export
   // attributes, linkage capability, etc. if applicable
   res = RemoveLinkageSpecificInstructions(consumer, options, linkings_to_do,
-                                          linked_context.get_decoration_mgr(),
-                                          &linked_context);
+                                          linked_context->get_decoration_mgr(),
+                                          linked_context.get());
   if (res != SPV_SUCCESS) return res;
 
-  // Phase 10: Compact the IDs used in the module
+  // Phase 10: Remove the functions that nothing live calls.  Imports have
+  // been rematched to exports by now, so library functions that are only
+  // called through an import are kept.
+  if (options.GetEliminateDeadFunctions()) {
+    PassManager dead_function_manager;
+    dead_function_manager.SetMessageConsumer(consumer);
+    dead_function_manager.AddPass<opt::EliminateDeadFunctionsPass>();
+    pass_res = dead_function_manager.Run(linked_context.get());
+    if (pass_res == opt::Pass::Status::Failure) return SPV_ERROR_INVALID_DATA;
+  }
+
+  // Phase 11: Compact the IDs used in the module
   manager.AddPass<opt::CompactIdsPass>();
-  pass_res = manager.Run(&linked_context);
+  pass_res = manager.Run(linked_context.get());
   if (pass_res == opt::Pass::Status::Failure) return SPV_ERROR_INVALID_DATA;
 
-  // Phase 11: Output the module
-  linked_context.module()->ToBinary(linked_binary, true);
+  *linked = std::move(linked_context);
+  return SPV_SUCCESS;
+}
+
+spv_result_t LinkModules(const Context& context, Module* library_module,
+                         const uint32_t* const* binaries,
+                         const size_t* binary_sizes, size_t num_binaries,
+                         std::vector<uint32_t>* linked_binary,
+                         const LinkerOptions& options) {
+  spv_position_t position = {};
+  const spv_context& c_context = context.CContext();
+  const MessageConsumer& consumer = c_context->consumer;
+
+  linked_binary->clear();
+  if (num_binaries == 0u && library_module == nullptr)
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "No modules were given.";
 
+  for (size_t i = 0u; i < num_binaries; ++i) {
+    const uint32_t schema = binaries[i][4u];
+    if (schema != 0u) {
+      position.index = 4u;
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+             << "Schema is non-zero for module " << i << ".";
+    }
+  }
+
+  // The modules are independent of one another, so they are built
+  // concurrently.  Nothing is built after a module fails, so that the
+  // diagnostics are those of the first failure when there is a single thread.
+  std::vector<std::unique_ptr<IRContext>> ir_contexts(num_binaries);
+  ForEachIndex(num_binaries, options,
+               [&ir_contexts, c_context, &consumer, binaries,
+                binary_sizes](size_t i) {
+                 ir_contexts[i] =
+                     BuildModule(c_context->target_env, consumer, binaries[i],
+                                 binary_sizes[i]);
+                 return ir_contexts[i] != nullptr;
+               });
+  for (size_t i = 0u; i < num_binaries; ++i) {
+    if (ir_contexts[i] == nullptr)
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+             << "Failed to build a module out of " << i << ".";
+  }
+
+  std::unique_ptr<IRContext> linked_context;
+  spv_result_t res = LinkContexts(context, library_module, &ir_contexts,
+                                  &linked_context, options);
+  if (res != SPV_SUCCESS) return res;
+
+  linked_context->module()->ToBinary(linked_binary, true);
   return SPV_SUCCESS;
 }
 
+}  // namespace
+
+struct PreparedLibrary::Impl {
+  std::unique_ptr<IRContext> context;
+};
+
+PreparedLibrary::PreparedLibrary() = default;
+
+PreparedLibrary::~PreparedLibrary() = default;
+
+PreparedLibrary::PreparedLibrary(PreparedLibrary&&) = default;
+
+PreparedLibrary& PreparedLibrary::operator=(PreparedLibrary&&) = default;
+
+bool PreparedLibrary::IsPrepared() const {
+  return impl_ != nullptr && impl_->context != nullptr;
+}
+
+spv_result_t Link(const Context& context,
+                  const std::vector<std::vector<uint32_t>>& binaries,
+                  std::vector<uint32_t>* linked_binary,
+                  const LinkerOptions& options) {
+  std::vector<const uint32_t*> binary_ptrs;
+  binary_ptrs.reserve(binaries.size());
+  std::vector<size_t> binary_sizes;
+  binary_sizes.reserve(binaries.size());
+
+  for (const auto& binary : binaries) {
+    binary_ptrs.push_back(binary.data());
+    binary_sizes.push_back(binary.size());
+  }
+
+  return Link(context, binary_ptrs.data(), binary_sizes.data(), binaries.size(),
+              linked_binary, options);
+}
+
+spv_result_t Link(const Context& context, const uint32_t* const* binaries,
+                  const size_t* binary_sizes, size_t num_binaries,
+                  std::vector<uint32_t>* linked_binary,
+                  const LinkerOptions& options) {
+  return LinkModules(context, nullptr, binaries, binary_sizes, num_binaries,
+                     linked_binary, options);
+}
+
+std::future<spv_result_t> LinkAsync(
+    const Context& context, std::vector<std::vector<uint32_t>> binaries,
+    std::vector<uint32_t>* linked_binary, const LinkerOptions& options) {
+  auto shared_binaries = std::make_shared<std::vector<std::vector<uint32_t>>>(
+      std::move(binaries));
+  Executor* executor = options.GetExecutor();
+  return utils::RunAsync<spv_result_t>(
+      executor ? &Executor::Run : nullptr, executor,
+      [&context, shared_binaries, linked_binary, options]() {
+        return Link(context, *shared_binaries, linked_binary, options);
+      });
+}
+
+spv_result_t Link(const Context& context,
+                  const std::vector<LoadedModule*>& modules,
+                  LoadedModule* linked_module, const LinkerOptions& options) {
+  spv_position_t position = {};
+  const spv_context& c_context = context.CContext();
+  const MessageConsumer& consumer = c_context->consumer;
+
+  // The modules are consumed even if linking fails, since their ids may
+  // already have been shifted by then.
+  std::vector<std::unique_ptr<IRContext>> ir_contexts;
+  ir_contexts.reserve(modules.size());
+  for (LoadedModule* module : modules) {
+    ir_contexts.push_back(std::move(module->impl_->context));
+  }
+  linked_module->impl_->context.reset();
+
+  if (ir_contexts.empty())
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_BINARY)
+           << "No modules were given.";
+  for (size_t i = 0u; i < ir_contexts.size(); ++i) {
+    if (ir_contexts[i] == nullptr)
+      return DiagnosticStream(position, consumer, "", SPV_ERROR_INVALID_POINTER)
+             << "Module " << i << " is not loaded.";
+  }
+
+  std::unique_ptr<IRContext> linked_context;
+  spv_result_t res = LinkContexts(context, nullptr, &ir_contexts,
+                                  &linked_context, options);
+  if (res != SPV_SUCCESS) return res;
+
+  linked_module->impl_->env = c_context->target_env;
+  linked_module->impl_->consumer = consumer;
+  linked_module->impl_->context = std::move(linked_context);
+  return SPV_SUCCESS;
+}
+
+spv_result_t PrepareLibrary(const Context& context,
+                            const std::vector<std::vector<uint32_t>>& binaries,
+                            PreparedLibrary* library,
+                            const LinkerOptions& options) {
+  spv_position_t position = {};
+  const spv_context& c_context = context.CContext();
+  LinkerOptions library_options = options;
+  library_options.SetCreateLibrary(true);
+  std::vector<uint32_t> library_binary;
+  spv_result_t res = Link(context, binaries, &library_binary, library_options);
+  if (res != SPV_SUCCESS) return res;
+
+  std::unique_ptr<IRContext> library_context =
+      BuildModule(c_context->target_env, c_context->consumer,
+                  library_binary.data(), library_binary.size());
+  if (library_context == nullptr)
+    return DiagnosticStream(position, c_context->consumer, "",
+                            SPV_ERROR_INVALID_BINARY)
+           << "Failed to build the prepared library.";
+  library->impl_ = MakeUnique<PreparedLibrary::Impl>();
+  library->impl_->context = std::move(library_context);
+  return SPV_SUCCESS;
+}
+
+spv_result_t Link(const Context& context, const PreparedLibrary& library,
+                  const std::vector<std::vector<uint32_t>>& binaries,
+                  std::vector<uint32_t>* linked_binary,
+                  const LinkerOptions& options) {
+  spv_position_t position = {};
+  if (!library.IsPrepared())
+    return DiagnosticStream(position, context.CContext()->consumer, "",
+                            SPV_ERROR_INVALID_POINTER)
+           << "The library was not prepared.";
+
+  std::vector<const uint32_t*> binary_ptrs;
+  binary_ptrs.reserve(binaries.size());
+  std::vector<size_t> binary_sizes;
+  binary_sizes.reserve(binaries.size());
+  for (const auto& binary : binaries) {
+    binary_ptrs.push_back(binary.data());
+    binary_sizes.push_back(binary.size());
+  }
+
+  return LinkModules(context, library.impl_->context->module(),
+                     binary_ptrs.data(), binary_sizes.data(), binaries.size(),
+                     linked_binary, options);
+}
+
 }  // namespace spvtools
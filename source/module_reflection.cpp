@@ -0,0 +1,261 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/module_reflection.h"
+
+#include "source/latest_version_spirv_header.h"
+
+namespace spvtools {
+namespace {
+
+// Returns the literal string at the start of the |num_words| words at
+// |words|, and sets |*string_words| to the number of words it takes.
+std::string ReadString(const uint32_t* words, size_t num_words,
+                       size_t* string_words) {
+  std::string result;
+  for (size_t i = 0; i < num_words; ++i) {
+    for (uint32_t byte = 0; byte < 4; ++byte) {
+      char c = static_cast<char>((words[i] >> (8 * byte)) & 0xFF);
+      if (c == 0) {
+        *string_words = i + 1;
+        return result;
+      }
+      result += c;
+    }
+  }
+  *string_words = num_words;
+  return result;
+}
+
+// Returns true if the variables of |storage_class| are resources even
+// without a descriptor set and binding.
+bool IsResourceStorageClass(uint32_t storage_class) {
+  switch (storage_class) {
+    case SpvStorageClassUniformConstant:
+    case SpvStorageClassUniform:
+    case SpvStorageClassStorageBuffer:
+    case SpvStorageClassPushConstant:
+    case SpvStorageClassShaderRecordBufferNV:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool ReflectedResource::operator==(const ReflectedResource& other) const {
+  return variable_id == other.variable_id &&
+         storage_class == other.storage_class && type_id == other.type_id &&
+         array_size == other.array_size && has_binding == other.has_binding &&
+         set == other.set && binding == other.binding && name == other.name;
+}
+
+bool ReflectedEntryPoint::operator==(const ReflectedEntryPoint& other) const {
+  return function_id == other.function_id &&
+         execution_model == other.execution_model && name == other.name &&
+         interface_ids == other.interface_ids;
+}
+
+bool ReflectedSpecConstant::operator==(
+    const ReflectedSpecConstant& other) const {
+  return id == other.id && spec_id == other.spec_id &&
+         type_id == other.type_id && default_value == other.default_value &&
+         name == other.name;
+}
+
+const ReflectedResource* ModuleReflection::FindResource(
+    uint32_t set, uint32_t binding) const {
+  for (const ReflectedResource& resource : resources) {
+    if (resource.has_binding && resource.set == set &&
+        resource.binding == binding) {
+      return &resource;
+    }
+  }
+  return nullptr;
+}
+
+const ReflectedSpecConstant* ModuleReflection::FindSpecConstant(
+    uint32_t spec_id) const {
+  for (const ReflectedSpecConstant& spec_constant : spec_constants) {
+    if (spec_constant.spec_id == spec_id) return &spec_constant;
+  }
+  return nullptr;
+}
+
+bool ModuleReflection::operator==(const ModuleReflection& other) const {
+  return resources == other.resources && entry_points == other.entry_points &&
+         spec_constants == other.spec_constants;
+}
+
+void ModuleReflectionBuilder::AddInstruction(const uint32_t* words,
+                                             size_t num_words) {
+  if (num_words == 0) return;
+  const SpvOp opcode = static_cast<SpvOp>(words[0] & SpvOpCodeMask);
+  switch (opcode) {
+    case SpvOpEntryPoint:
+      if (num_words >= 4) {
+        ReflectedEntryPoint entry_point;
+        entry_point.execution_model = words[1];
+        entry_point.function_id = words[2];
+        size_t name_words = 0;
+        entry_point.name = ReadString(words + 3, num_words - 3, &name_words);
+        entry_point.interface_ids.assign(words + 3 + name_words,
+                                         words + num_words);
+        reflection_.entry_points.push_back(std::move(entry_point));
+      }
+      break;
+    case SpvOpName:
+      if (num_words >= 3) {
+        size_t name_words = 0;
+        names_[words[1]] = ReadString(words + 2, num_words - 2, &name_words);
+      }
+      break;
+    case SpvOpDecorate:
+      if (num_words >= 4) AddDecoration(words[1], words[2], words[3]);
+      break;
+    case SpvOpGroupDecorate:
+      if (num_words >= 2) {
+        auto group = decorations_.find(words[1]);
+        if (group == decorations_.end()) break;
+        const Decorations group_decorations = group->second;
+        for (size_t i = 2; i < num_words; ++i) {
+          if (group_decorations.has_set) {
+            AddDecoration(words[i], SpvDecorationDescriptorSet,
+                          group_decorations.set);
+          }
+          if (group_decorations.has_binding) {
+            AddDecoration(words[i], SpvDecorationBinding,
+                          group_decorations.binding);
+          }
+          if (group_decorations.has_spec_id) {
+            AddDecoration(words[i], SpvDecorationSpecId,
+                          group_decorations.spec_id);
+          }
+        }
+      }
+      break;
+    case SpvOpTypePointer:
+      if (num_words >= 4) pointee_types_[words[1]] = words[3];
+      break;
+    case SpvOpTypeArray:
+      if (num_words >= 4) {
+        auto length = constants_.find(words[3]);
+        array_types_[words[1]] = {
+            words[2], length == constants_.end() ? 0 : length->second};
+      }
+      break;
+    case SpvOpTypeRuntimeArray:
+      if (num_words >= 3) array_types_[words[1]] = {words[2], 0};
+      break;
+    case SpvOpConstant:
+      if (num_words >= 4) constants_[words[2]] = words[3];
+      break;
+    case SpvOpSpecConstantTrue:
+    case SpvOpSpecConstantFalse:
+      if (num_words >= 3) {
+        AddSpecConstant(words[1], words[2],
+                        {opcode == SpvOpSpecConstantTrue ? 1u : 0u});
+      }
+      break;
+    case SpvOpSpecConstant:
+      if (num_words >= 3) {
+        AddSpecConstant(words[1], words[2],
+                        std::vector<uint32_t>(words + 3, words + num_words));
+      }
+      break;
+    case SpvOpVariable:
+      if (num_words >= 4) AddVariable(words[1], words[2], words[3]);
+      break;
+    default:
+      break;
+  }
+}
+
+void ModuleReflectionBuilder::AddDecoration(uint32_t target,
+                                            uint32_t decoration,
+                                            uint32_t value) {
+  switch (decoration) {
+    case SpvDecorationDescriptorSet: {
+      Decorations& decorations = decorations_[target];
+      decorations.has_set = true;
+      decorations.set = value;
+      break;
+    }
+    case SpvDecorationBinding: {
+      Decorations& decorations = decorations_[target];
+      decorations.has_binding = true;
+      decorations.binding = value;
+      break;
+    }
+    case SpvDecorationSpecId: {
+      Decorations& decorations = decorations_[target];
+      decorations.has_spec_id = true;
+      decorations.spec_id = value;
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+void ModuleReflectionBuilder::AddVariable(uint32_t type_id, uint32_t result_id,
+                                          uint32_t storage_class) {
+  auto decorations = decorations_.find(result_id);
+  const bool has_binding = decorations != decorations_.end() &&
+                           decorations->second.has_set &&
+                           decorations->second.has_binding;
+  if (!has_binding && !IsResourceStorageClass(storage_class)) return;
+
+  ReflectedResource resource;
+  resource.variable_id = result_id;
+  resource.storage_class = storage_class;
+  auto pointee = pointee_types_.find(type_id);
+  resource.type_id = pointee == pointee_types_.end() ? 0 : pointee->second;
+  for (auto array = array_types_.find(resource.type_id);
+       array != array_types_.end();
+       array = array_types_.find(resource.type_id)) {
+    resource.type_id = array->second.first;
+    resource.array_size *= array->second.second;
+  }
+  if (has_binding) {
+    resource.has_binding = true;
+    resource.set = decorations->second.set;
+    resource.binding = decorations->second.binding;
+  }
+  resource.name = NameOf(result_id);
+  reflection_.resources.push_back(std::move(resource));
+}
+
+void ModuleReflectionBuilder::AddSpecConstant(
+    uint32_t type_id, uint32_t result_id, std::vector<uint32_t> default_value) {
+  auto decorations = decorations_.find(result_id);
+  if (decorations == decorations_.end() || !decorations->second.has_spec_id) {
+    return;
+  }
+  ReflectedSpecConstant spec_constant;
+  spec_constant.id = result_id;
+  spec_constant.spec_id = decorations->second.spec_id;
+  spec_constant.type_id = type_id;
+  spec_constant.default_value = std::move(default_value);
+  spec_constant.name = NameOf(result_id);
+  reflection_.spec_constants.push_back(std::move(spec_constant));
+}
+
+std::string ModuleReflectionBuilder::NameOf(uint32_t id) const {
+  auto name = names_.find(id);
+  return name == names_.end() ? std::string() : name->second;
+}
+
+}  // namespace spvtools
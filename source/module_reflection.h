@@ -0,0 +1,77 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_MODULE_REFLECTION_H_
+#define SOURCE_MODULE_REFLECTION_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+
+// Builds a ModuleReflection from the instructions of a module that come
+// before its first function.  They must be given to |AddInstruction| in the
+// order of the module, in which the names and decorations of the variables
+// and specialization constants come before their declarations.
+class ModuleReflectionBuilder {
+ public:
+  // Adds the instruction whose |num_words| words, starting with the one
+  // holding its opcode, are at |words|.  Instructions without anything to
+  // reflect are ignored.
+  void AddInstruction(const uint32_t* words, size_t num_words);
+
+  // Returns the reflection of the instructions added so far.
+  ModuleReflection TakeReflection() { return std::move(reflection_); }
+
+ private:
+  // The decorations of an id, or of a decoration group, that are reflected.
+  struct Decorations {
+    bool has_set = false;
+    bool has_binding = false;
+    bool has_spec_id = false;
+    uint32_t set = 0;
+    uint32_t binding = 0;
+    uint32_t spec_id = 0;
+  };
+
+  void AddDecoration(uint32_t target, uint32_t decoration, uint32_t value);
+  void AddVariable(uint32_t type_id, uint32_t result_id,
+                   uint32_t storage_class);
+  void AddSpecConstant(uint32_t type_id, uint32_t result_id,
+                       std::vector<uint32_t> default_value);
+
+  // Returns the name of |id|, or an empty string if it has none.
+  std::string NameOf(uint32_t id) const;
+
+  std::unordered_map<uint32_t, std::string> names_;
+  std::unordered_map<uint32_t, Decorations> decorations_;
+  // The pointee type of each pointer type.
+  std::unordered_map<uint32_t, uint32_t> pointee_types_;
+  // The element type and length of each array type.  The length of runtime
+  // arrays, and of arrays sized by specialization constants, is 0.
+  std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> array_types_;
+  // The low word of the value of each integer constant.
+  std::unordered_map<uint32_t, uint32_t> constants_;
+
+  ModuleReflection reflection_;
+};
+
+}  // namespace spvtools
+
+#endif  // SOURCE_MODULE_REFLECTION_H_
@@ -26,6 +26,8 @@
 
 #include "source/latest_version_spirv_header.h"
 #include "source/parsed_operand.h"
+#include "source/spirv_constant.h"
+#include "source/spirv_endian.h"
 
 namespace spvtools {
 namespace {
@@ -39,6 +41,27 @@ std::string to_string(uint32_t id) {
   return os.str();
 }
 
+// Returns the string of at most |max_size| bytes at |words|.
+std::string ToString(const uint32_t* words, size_t max_size) {
+  const char* chars = reinterpret_cast<const char*>(words);
+  return std::string(chars, std::find(chars, chars + max_size, '\0'));
+}
+
+// Sets |value| to the number written by |name|, if |name| is written the
+// way to_string writes numbers.  Returns false otherwise.
+bool ParseNumberName(const std::string& name, uint32_t* value) {
+  if (name.empty() || name.size() > 10 || (name[0] == '0' && name.size() > 1))
+    return false;
+  uint64_t result = 0;
+  for (const char c : name) {
+    if (c < '0' || c > '9') return false;
+    result = result * 10 + uint64_t(c - '0');
+  }
+  if (result > 0xFFFFFFFFu) return false;
+  *value = uint32_t(result);
+  return true;
+}
+
 }  // anonymous namespace
 
 NameMapper GetTrivialNameMapper() { return to_string; }
@@ -47,24 +70,52 @@ FriendlyNameMapper::FriendlyNameMapper(const spv_const_context context,
                                        const uint32_t* code,
                                        const size_t wordCount)
     : grammar_(AssemblyGrammar(context)) {
-  spv_diagnostic diag = nullptr;
-  // We don't care if the parse fails.
-  spvBinaryParse(context, this, code, wordCount, nullptr,
-                 ParseInstructionForwarder, &diag);
-  spvDiagnosticDestroy(diag);
+  if (!code || wordCount < SPV_INDEX_INSTRUCTION) return;
+  // A module of the other endianness is scanned from a swapped copy.
+  std::vector<uint32_t> swapped;
+  if (code[SPV_INDEX_MAGIC_NUMBER] != SpvMagicNumber) {
+    const spv_const_binary_t binary = {code, wordCount};
+    spv_endianness_t endian;
+    if (spvBinaryEndianness(&binary, &endian) != SPV_SUCCESS) return;
+    swapped.resize(wordCount);
+    spvFixWords(code, wordCount, endian, swapped.data());
+    code = swapped.data();
+  }
+  // Ids are only named by their number up to a bound proportional to the size
+  // of the module, so that a corrupt bound cannot take much memory.  Other
+  // ids have their name saved.
+  number_named_ids_.resize(
+      std::min<size_t>(code[SPV_INDEX_BOUND], wordCount * 64));
+
+  // We don't care if the module is malformed: the ids are named as far as
+  // it can be scanned.
+  for (size_t i = SPV_INDEX_INSTRUCTION; i < wordCount;) {
+    const uint32_t num_words = code[i] >> 16;
+    if (num_words == 0 || num_words > wordCount - i) break;
+    if (!ScanInstruction(code + i, num_words)) break;
+    i += num_words;
+  }
 }
 
 std::string FriendlyNameMapper::NameForId(uint32_t id) {
   auto iter = name_for_id_.find(id);
   if (iter == name_for_id_.end()) {
-    // It must have been an invalid module, so just return a trivial mapping.
-    // We don't care about uniqueness.
+    // Either the id is named by its number, or it must have been an invalid
+    // module, so just return a trivial mapping.  We don't care about
+    // uniqueness in the latter case.
     return to_string(id);
   } else {
-    return iter->second;
+    return *iter->second;
   }
 }
 
+bool FriendlyNameMapper::IsNameUsed(const std::string& name) const {
+  if (used_names_.count(name)) return true;
+  uint32_t id = 0;
+  return ParseNumberName(name, &id) && id < number_named_ids_.size() &&
+         number_named_ids_[id];
+}
+
 std::string FriendlyNameMapper::Sanitize(const std::string& suggested_name) {
   if (suggested_name.empty()) return "_";
   // Otherwise, replace invalid characters by '_'.
@@ -83,18 +134,32 @@ std::string FriendlyNameMapper::Sanitize(const std::string& suggested_name) {
 void FriendlyNameMapper::SaveName(uint32_t id,
                                   const std::string& suggested_name) {
   if (name_for_id_.find(id) != name_for_id_.end()) return;
+  if (id < number_named_ids_.size() && number_named_ids_[id]) return;
 
   const std::string sanitized_suggested_name = Sanitize(suggested_name);
   std::string name = sanitized_suggested_name;
-  auto inserted = used_names_.insert(name);
-  if (!inserted.second) {
+  if (IsNameUsed(name)) {
     const std::string base_name = sanitized_suggested_name + "_";
-    for (uint32_t index = 0; !inserted.second; ++index) {
+    for (uint32_t index = 0; IsNameUsed(name); ++index) {
       name = base_name + to_string(index);
-      inserted = used_names_.insert(name);
     }
   }
-  name_for_id_[id] = name;
+  if (name[0] >= '0' && name[0] <= '9') has_number_like_names_ = true;
+  name_for_id_[id] = &*used_names_.insert(std::move(name)).first;
+}
+
+void FriendlyNameMapper::SaveNumberName(uint32_t id) {
+  if (name_for_id_.find(id) != name_for_id_.end()) return;
+  // Only a debug name can have taken the number of the id.
+  if (has_number_like_names_ && used_names_.count(to_string(id))) {
+    SaveName(id, to_string(id));
+    return;
+  }
+  if (id < number_named_ids_.size()) {
+    number_named_ids_[id] = true;
+  } else {
+    SaveName(id, to_string(id));
+  }
 }
 
 void FriendlyNameMapper::SaveBuiltInName(uint32_t target_id,
@@ -167,12 +232,22 @@ void FriendlyNameMapper::SaveBuiltInName(uint32_t target_id,
 #undef CASE
 }
 
-spv_result_t FriendlyNameMapper::ParseInstruction(
-    const spv_parsed_instruction_t& inst) {
-  const auto result_id = inst.result_id;
-  switch (inst.opcode) {
+bool FriendlyNameMapper::ScanInstruction(const uint32_t* words,
+                                         uint32_t num_words) {
+  const SpvOp opcode = static_cast<SpvOp>(words[0] & 0xFFFF);
+  spv_opcode_desc desc = nullptr;
+  if (grammar_.lookupOpcode(opcode, &desc) != SPV_SUCCESS) return false;
+  const uint32_t result_index = desc->hasType ? 2 : 1;
+  if (desc->hasResult && num_words <= result_index) return false;
+  const auto result_id = desc->hasResult ? words[result_index] : 0;
+  // The number of words the instruction needs for the operands it is named
+  // from.
+  auto has_words = [num_words](uint32_t count) { return num_words >= count; };
+
+  switch (opcode) {
     case SpvOpName:
-      SaveName(inst.words[1], reinterpret_cast<const char*>(inst.words + 2));
+      if (!has_words(3)) return false;
+      SaveName(words[1], ToString(words + 2, (num_words - 2) * 4));
       break;
     case SpvOpDecorate:
       // Decorations come after OpName.  So OpName will take precedence over
@@ -180,9 +255,10 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       //
       // In theory, we should also handle OpGroupDecorate.  But that's unlikely
       // to occur.
-      if (inst.words[2] == SpvDecorationBuiltIn) {
-        assert(inst.num_words > 3);
-        SaveBuiltInName(inst.words[1], inst.words[3]);
+      if (!has_words(3)) return false;
+      if (words[2] == SpvDecorationBuiltIn) {
+        if (!has_words(4)) return false;
+        SaveBuiltInName(words[1], words[3]);
       }
       break;
     case SpvOpTypeVoid:
@@ -192,9 +268,10 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       SaveName(result_id, "bool");
       break;
     case SpvOpTypeInt: {
+      if (!has_words(4)) return false;
       std::string signedness;
       std::string root;
-      const auto bit_width = inst.words[2];
+      const auto bit_width = words[2];
       switch (bit_width) {
         case 8:
           root = "char";
@@ -213,11 +290,15 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
           signedness = "i";
           break;
       }
-      if (0 == inst.words[3]) signedness = "u";
+      if (0 == words[3]) signedness = "u";
       SaveName(result_id, signedness + root);
+      number_types_[result_id] = {
+          words[3] ? SPV_NUMBER_SIGNED_INT : SPV_NUMBER_UNSIGNED_INT,
+          bit_width};
     } break;
     case SpvOpTypeFloat: {
-      const auto bit_width = inst.words[2];
+      if (!has_words(3)) return false;
+      const auto bit_width = words[2];
       switch (bit_width) {
         case 16:
           SaveName(result_id, "half");
@@ -232,34 +313,40 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
           SaveName(result_id, std::string("fp") + to_string(bit_width));
           break;
       }
+      number_types_[result_id] = {SPV_NUMBER_FLOATING, bit_width};
     } break;
     case SpvOpTypeVector:
-      SaveName(result_id, std::string("v") + to_string(inst.words[3]) +
-                              NameForId(inst.words[2]));
+      if (!has_words(4)) return false;
+      SaveName(result_id, std::string("v") + to_string(words[3]) +
+                              NameForId(words[2]));
       break;
     case SpvOpTypeMatrix:
-      SaveName(result_id, std::string("mat") + to_string(inst.words[3]) +
-                              NameForId(inst.words[2]));
+      if (!has_words(4)) return false;
+      SaveName(result_id, std::string("mat") + to_string(words[3]) +
+                              NameForId(words[2]));
       break;
     case SpvOpTypeArray:
-      SaveName(result_id, std::string("_arr_") + NameForId(inst.words[2]) +
-                              "_" + NameForId(inst.words[3]));
+      if (!has_words(4)) return false;
+      SaveName(result_id, std::string("_arr_") + NameForId(words[2]) + "_" +
+                              NameForId(words[3]));
       break;
     case SpvOpTypeRuntimeArray:
-      SaveName(result_id,
-               std::string("_runtimearr_") + NameForId(inst.words[2]));
+      if (!has_words(3)) return false;
+      SaveName(result_id, std::string("_runtimearr_") + NameForId(words[2]));
       break;
     case SpvOpTypePointer:
+      if (!has_words(4)) return false;
       SaveName(result_id, std::string("_ptr_") +
                               NameForEnumOperand(SPV_OPERAND_TYPE_STORAGE_CLASS,
-                                                 inst.words[2]) +
-                              "_" + NameForId(inst.words[3]));
+                                                 words[2]) +
+                              "_" + NameForId(words[3]));
       break;
     case SpvOpTypePipe:
+      if (!has_words(3)) return false;
       SaveName(result_id,
                std::string("Pipe") +
                    NameForEnumOperand(SPV_OPERAND_TYPE_ACCESS_QUALIFIER,
-                                      inst.words[2]));
+                                      words[2]));
       break;
     case SpvOpTypeEvent:
       SaveName(result_id, "Event");
@@ -274,9 +361,10 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       SaveName(result_id, "Queue");
       break;
     case SpvOpTypeOpaque:
-      SaveName(result_id,
-               std::string("Opaque_") +
-                   Sanitize(reinterpret_cast<const char*>(inst.words + 2)));
+      if (!has_words(3)) return false;
+      SaveName(result_id, std::string("Opaque_") +
+                              Sanitize(ToString(words + 2,
+                                                (num_words - 2) * 4)));
       break;
     case SpvOpTypePipeStorage:
       SaveName(result_id, "PipeStorage");
@@ -296,14 +384,36 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       SaveName(result_id, "false");
       break;
     case SpvOpConstant: {
+      // The literal has the form the binary parser gives it, which depends on
+      // the type of the constant.
+      auto type = number_types_.find(words[1]);
+      if (type == number_types_.end()) return false;
+      const spv_number_kind_t kind = type->second.first;
+      const uint32_t bit_width = type->second.second;
+      if (num_words != 3 + (uint64_t(bit_width) + 31) / 32) return false;
+      spv_parsed_operand_t operand = {};
+      operand.offset = 3;
+      operand.num_words = uint16_t(num_words - 3);
+      operand.type = SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER;
+      operand.number_kind = kind;
+      operand.number_bit_width = bit_width;
+      spv_parsed_instruction_t inst = {};
+      inst.words = words;
+      inst.num_words = uint16_t(num_words);
+      inst.opcode = uint16_t(opcode);
+      inst.type_id = words[1];
+      inst.result_id = result_id;
+      inst.operands = &operand;
+      inst.num_operands = 1;
+
       std::ostringstream value;
-      EmitNumericLiteral(&value, inst, inst.operands[2]);
+      EmitNumericLiteral(&value, inst, operand);
       auto value_str = value.str();
       // Use 'n' to signify negative. Other invalid characters will be mapped
       // to underscore.
       for (auto& c : value_str)
         if (c == '-') c = 'n';
-      SaveName(result_id, NameForId(inst.type_id) + "_" + value_str);
+      SaveName(result_id, NameForId(words[1]) + "_" + value_str);
     } break;
     default:
       // If this instruction otherwise defines an Id, then save a mapping for
@@ -311,11 +421,10 @@ spv_result_t FriendlyNameMapper::ParseInstruction(
       // string something like "1" that might collide with this result_id.
       // We should only do this if a name hasn't already been registered by some
       // previous forward reference.
-      if (result_id && name_for_id_.find(result_id) == name_for_id_.end())
-        SaveName(result_id, to_string(result_id));
+      if (result_id) SaveNumberName(result_id);
       break;
   }
-  return SPV_SUCCESS;
+  return true;
 }
 
 std::string FriendlyNameMapper::NameForEnumOperand(spv_operand_type_t type,
@@ -19,6 +19,8 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "source/assembly_grammar.h"
 #include "spirv-tools/libspirv.h"
@@ -33,10 +35,15 @@ using NameMapper = std::function<std::string(uint32_t)>;
 // Returns a NameMapper which always maps an Id to its decimal representation.
 NameMapper GetTrivialNameMapper();
 
-// A FriendlyNameMapper parses a module upon construction.  If the parse is
-// successful, then the NameForId method maps an Id to a friendly name
+// A FriendlyNameMapper scans a module upon construction.  If the module is
+// well formed, then the NameForId method maps an Id to a friendly name
 // while also satisfying the constraints on a NameMapper.
 //
+// Only the ids that get a name other than their number, such as the types,
+// the constants and the ids with a debug name, have their name saved.  Most
+// ids are results of ordinary instructions, which are named by their number
+// when it is asked for.
+//
 // The mapping is friendly in the following sense:
 //  - If an Id has a debug name (via OpName), then that will be used when
 //    possible.
@@ -93,26 +100,37 @@ class FriendlyNameMapper {
   // has a name then this is a no-op.
   void SaveBuiltInName(uint32_t target_id, uint32_t built_in);
 
-  // Collects information from the given parsed instruction to populate
-  // name_for_id_.  Returns SPV_SUCCESS;
-  spv_result_t ParseInstruction(const spv_parsed_instruction_t& inst);
+  // Records that |id| is named by its number, unless the number is already
+  // the name of another id.
+  void SaveNumberName(uint32_t id);
 
-  // Forwards a parsed-instruction callback from the binary parser into the
-  // FriendlyNameMapper hidden inside the user_data parameter.
-  static spv_result_t ParseInstructionForwarder(
-      void* user_data, const spv_parsed_instruction_t* parsed_instruction) {
-    return reinterpret_cast<FriendlyNameMapper*>(user_data)->ParseInstruction(
-        *parsed_instruction);
-  }
+  // Returns true if |name| is the name of an id.
+  bool IsNameUsed(const std::string& name) const;
+
+  // Collects information from the instruction of |num_words| words at
+  // |words| to populate name_for_id_.  Returns false if the instruction is
+  // malformed, in which case the rest of the module is not scanned.
+  bool ScanInstruction(const uint32_t* words, uint32_t num_words);
 
   // Returns the friendly name for an enumerant.
   std::string NameForEnumOperand(spv_operand_type_t type, uint32_t word);
 
-  // Maps an id to its friendly name.  This will have an entry for each Id
-  // defined in the module.
-  std::unordered_map<uint32_t, std::string> name_for_id_;
-  // The set of names that have a mapping in name_for_id_;
+  // Maps an id to its friendly name, which is interned in used_names_.  This
+  // has an entry for each Id defined in the module that is not named by its
+  // number.
+  std::unordered_map<uint32_t, const std::string*> name_for_id_;
+  // The set of names that have a mapping in name_for_id_.
   std::unordered_set<std::string> used_names_;
+  // Whether each id is defined and named by its number.  Those names are not
+  // in used_names_.
+  std::vector<bool> number_named_ids_;
+  // Whether a name in used_names_ starts with a digit, and can therefore be
+  // the number of an id.
+  bool has_number_like_names_ = false;
+  // The number kind and bit width of the integer and floating point types,
+  // which give the form of the literals of the constants of those types.
+  std::unordered_map<uint32_t, std::pair<spv_number_kind_t, uint32_t>>
+      number_types_;
   // The assembly grammar for the current context.
   const AssemblyGrammar grammar_;
 };
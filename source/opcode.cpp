@@ -21,12 +21,15 @@
 
 #include <algorithm>
 #include <cstdlib>
+#include <functional>
+#include <vector>
 
 #include "source/instruction.h"
 #include "source/macro.h"
 #include "source/spirv_constant.h"
 #include "source/spirv_endian.h"
 #include "source/spirv_target_env.h"
+#include "source/util/name_index.h"
 #include "spirv-tools/libspirv.h"
 
 namespace {
@@ -40,6 +43,41 @@ struct OpcodeDescPtrLen {
 static const spv_opcode_table_t kOpcodeTable = {ARRAY_SIZE(kOpcodeTableEntries),
                                                 kOpcodeTableEntries};
 
+// Returns a table mapping each opcode value up to the largest one in
+// |kOpcodeTable| to one more than the index of its first entry, or to zero if
+// the value is not an opcode.
+const std::vector<uint16_t>* BuildOpcodeIndex() {
+  const uint32_t count = kOpcodeTable.count;
+  uint32_t max_opcode = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    const uint32_t opcode = kOpcodeTable.entries[i].opcode;
+    max_opcode = std::max(max_opcode, opcode);
+  }
+  auto* index = new std::vector<uint16_t>(max_opcode + 1, 0);
+  for (uint32_t i = count; i > 0; --i) {
+    const uint32_t opcode = kOpcodeTable.entries[i - 1].opcode;
+    (*index)[opcode] = static_cast<uint16_t>(i);
+  }
+  return index;
+}
+
+// Returns true if every operand of |entry| is a required single-word id.
+bool ComputeHasFixedIdOperands(const spv_opcode_desc_t& entry) {
+  for (uint16_t i = 0; i < entry.numTypes; ++i) {
+    switch (entry.operandTypes[i]) {
+      case SPV_OPERAND_TYPE_TYPE_ID:
+      case SPV_OPERAND_TYPE_RESULT_ID:
+      case SPV_OPERAND_TYPE_ID:
+      case SPV_OPERAND_TYPE_SCOPE_ID:
+      case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
 // Represents a vendor tool entry in the SPIR-V XML Regsitry.
 struct VendorTool {
   uint32_t value;
@@ -95,12 +133,23 @@ spv_result_t spvOpcodeTableNameLookup(spv_target_env env,
   if (!name || !pEntry) return SPV_ERROR_INVALID_POINTER;
   if (!table) return SPV_ERROR_INVALID_TABLE;
 
-  // TODO: This lookup of the Opcode table is suboptimal! Binary sort would be
-  // preferable but the table requires sorting on the Opcode name, but it's
-  // static const initialized and matches the order of the spec.
   const size_t nameLength = strlen(name);
+
+  // The table matches the order of the spec, so it cannot be searched by name.
+  // Instead, the names of the static table are indexed on first use, and the
+  // search starts at the first entry with the given name.  Other tables are
+  // searched from the start.
+  size_t firstIndex = 0;
+  if (table == &kOpcodeTable) {
+    static const auto* index = new spvtools::utils::NameIndex(
+        kOpcodeTable.entries, kOpcodeTable.count);
+    if (!index->Find(name, nameLength, &firstIndex))
+      return SPV_ERROR_INVALID_LOOKUP;
+  }
+
   const auto version = spvVersionForTargetEnv(env);
-  for (uint64_t opcodeIndex = 0; opcodeIndex < table->count; ++opcodeIndex) {
+  for (uint64_t opcodeIndex = firstIndex; opcodeIndex < table->count;
+       ++opcodeIndex) {
     const spv_opcode_desc_t& entry = table->entries[opcodeIndex];
     // We considers the current opcode as available as long as
     // 1. The target environment satisfies the minimal requirement of the
@@ -133,12 +182,25 @@ spv_result_t spvOpcodeTableValueLookup(spv_target_env env,
   const auto beg = table->entries;
   const auto end = table->entries + table->count;
 
-  spv_opcode_desc_t needle = {"",    opcode, 0, nullptr, 0,   {},
-                              false, false,  0, nullptr, ~0u, ~0u};
-
-  auto comp = [](const spv_opcode_desc_t& lhs, const spv_opcode_desc_t& rhs) {
-    return lhs.opcode < rhs.opcode;
-  };
+  // The static table is indexed directly by opcode value.  Other tables are
+  // binary searched.
+  const spv_opcode_desc_t* first = nullptr;
+  if (table == &kOpcodeTable) {
+    static const auto* index = BuildOpcodeIndex();
+    const uint32_t value = static_cast<uint32_t>(opcode);
+    if (value >= index->size() || (*index)[value] == 0)
+      return SPV_ERROR_INVALID_LOOKUP;
+    first = beg + (*index)[value] - 1;
+  } else {
+    spv_opcode_desc_t needle = {"",    opcode, 0, nullptr, 0,   {},
+                                false, false,  0, nullptr, ~0u, ~0u};
+
+    auto comp = [](const spv_opcode_desc_t& lhs,
+                   const spv_opcode_desc_t& rhs) {
+      return lhs.opcode < rhs.opcode;
+    };
+    first = std::lower_bound(beg, end, needle, comp);
+  }
 
   // We need to loop here because there can exist multiple symbols for the same
   // opcode value, and they can be introduced in different target environments,
@@ -146,8 +208,7 @@ spv_result_t spvOpcodeTableValueLookup(spv_target_env env,
   // Assumes the underlying table is already sorted ascendingly according to
   // opcode value.
   const auto version = spvVersionForTargetEnv(env);
-  for (auto it = std::lower_bound(beg, end, needle, comp);
-       it != end && it->opcode == opcode; ++it) {
+  for (auto it = first; it != end && it->opcode == opcode; ++it) {
     // We considers the current opcode as available as long as
     // 1. The target environment satisfies the minimal requirement of the
     //    opcode; or
@@ -166,6 +227,24 @@ spv_result_t spvOpcodeTableValueLookup(spv_target_env env,
   return SPV_ERROR_INVALID_LOOKUP;
 }
 
+bool spvOpcodeHasFixedIdOperands(spv_opcode_desc entry) {
+  // The answers for the static table are computed once.
+  static const auto* fixed = [] {
+    auto* result = new std::vector<bool>(kOpcodeTable.count);
+    for (uint32_t i = 0; i < kOpcodeTable.count; ++i) {
+      (*result)[i] = ComputeHasFixedIdOperands(kOpcodeTable.entries[i]);
+    }
+    return result;
+  }();
+
+  const std::less<spv_opcode_desc> less;
+  if (!less(entry, kOpcodeTable.entries) &&
+      less(entry, kOpcodeTable.entries + kOpcodeTable.count)) {
+    return (*fixed)[entry - kOpcodeTable.entries];
+  }
+  return ComputeHasFixedIdOperands(*entry);
+}
+
 void spvInstructionCopy(const uint32_t* words, const SpvOp opcode,
                         const uint16_t wordCount, const spv_endianness_t endian,
                         spv_instruction_t* pInst) {
@@ -48,6 +48,11 @@ spv_result_t spvOpcodeTableValueLookup(spv_target_env,
                                        const SpvOp opcode,
                                        spv_opcode_desc* entry);
 
+// Returns true if every operand of the opcode described by |entry| is a
+// required id that occupies one word, so an instruction with one word per
+// operand can be decoded without expanding an operand pattern.
+bool spvOpcodeHasFixedIdOperands(spv_opcode_desc entry);
+
 // Copies an instruction's word and fixes the endianness to host native. The
 // source instruction's stream/opcode/endianness is in the words/opcode/endian
 // parameter. The word_count parameter specifies the number of words to copy.
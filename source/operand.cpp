@@ -20,12 +20,14 @@
 #include <string.h>
 
 #include <algorithm>
+#include <vector>
 
 #include "DebugInfo.h"
 #include "OpenCLDebugInfo100.h"
 #include "source/macro.h"
 #include "source/spirv_constant.h"
 #include "source/spirv_target_env.h"
+#include "source/util/name_index.h"
 
 // For now, assume unified1 contains up to SPIR-V 1.3 and no later
 // SPIR-V version.
@@ -56,11 +58,29 @@ spv_result_t spvOperandTableNameLookup(spv_target_env env,
   if (!table) return SPV_ERROR_INVALID_TABLE;
   if (!name || !pEntry) return SPV_ERROR_INVALID_POINTER;
 
+  // The names of each operand type of the static table are indexed on first
+  // use, so the search of a group starts at the first entry with the given
+  // name.  Other tables are searched from the start of each group.
+  static const auto* indices = [] {
+    auto* result = new std::vector<spvtools::utils::NameIndex>();
+    result->reserve(kOperandTable.count);
+    for (uint64_t typeIndex = 0; typeIndex < kOperandTable.count; ++typeIndex) {
+      const auto& group = kOperandTable.types[typeIndex];
+      result->emplace_back(group.entries, group.count);
+    }
+    return result;
+  }();
+
   const auto version = spvVersionForTargetEnv(env);
   for (uint64_t typeIndex = 0; typeIndex < table->count; ++typeIndex) {
     const auto& group = table->types[typeIndex];
     if (type != group.type) continue;
-    for (uint64_t index = 0; index < group.count; ++index) {
+    size_t firstIndex = 0;
+    if (table == &kOperandTable &&
+        !(*indices)[typeIndex].Find(name, nameLength, &firstIndex)) {
+      continue;
+    }
+    for (uint64_t index = firstIndex; index < group.count; ++index) {
       const auto& entry = group.entries[index];
       // We consider the current operand as available as long as
       // 1. The target environment satisfies the minimal requirement of the
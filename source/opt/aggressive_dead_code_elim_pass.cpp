@@ -179,12 +179,10 @@ bool AggressiveDCEPass::IsTargetDead(Instruction* inst) {
 void AggressiveDCEPass::ProcessLoad(Function* func, uint32_t varId) {
   // Only process locals
   if (!IsLocalVar(varId)) return;
-  // Return if already processed
-  if (live_local_vars_.find(varId) != live_local_vars_.end()) return;
+  // Return if already processed, and cache varId as processed otherwise.
+  if (live_local_vars_.Set(varId)) return;
   // Mark all stores to varId as live
   AddStores(func, varId);
-  // Cache varId as processed
-  live_local_vars_.insert(varId);
 }
 
 bool AggressiveDCEPass::IsStructuredHeader(BasicBlock* bp,
@@ -202,25 +200,27 @@ bool AggressiveDCEPass::IsStructuredHeader(BasicBlock* bp,
 }
 
 void AggressiveDCEPass::ComputeBlock2HeaderMaps(
-    std::list<BasicBlock*>& structuredOrder) {
-  block2headerBranch_.clear();
-  header2nextHeaderBranch_.clear();
-  branch2merge_.clear();
-  structured_order_index_.clear();
-  std::stack<Instruction*> currentHeaderBranch;
-  currentHeaderBranch.push(nullptr);
+    Function* func, std::list<BasicBlock*>& structuredOrder) {
+  if (block_info_.size() < context()->module()->IdBound()) {
+    block_info_.resize(context()->module()->IdBound());
+  }
+  for (auto& blk : *func) {
+    block_info_[blk.id()] = BlockInfo();
+  }
+  std::stack<BasicBlock*> currentHeader;
+  currentHeader.push(nullptr);
   uint32_t currentMergeBlockId = 0;
   uint32_t index = 0;
   for (auto bi = structuredOrder.begin(); bi != structuredOrder.end();
        ++bi, ++index) {
-    structured_order_index_[*bi] = index;
+    BlockInfo& info = block_info_[(*bi)->id()];
+    info.structured_order_index = index;
     // If this block is the merge block of the current control construct,
     // we are leaving the current construct so we must update state
     if ((*bi)->id() == currentMergeBlockId) {
-      currentHeaderBranch.pop();
-      Instruction* chb = currentHeaderBranch.top();
-      if (chb != nullptr)
-        currentMergeBlockId = branch2merge_[chb]->GetSingleWordInOperand(0);
+      currentHeader.pop();
+      BasicBlock* ch = currentHeader.top();
+      if (ch != nullptr) currentMergeBlockId = ch->MergeBlockIdIfAny();
     }
     Instruction* mergeInst;
     Instruction* branchInst;
@@ -228,20 +228,27 @@ void AggressiveDCEPass::ComputeBlock2HeaderMaps(
     bool is_header =
         IsStructuredHeader(*bi, &mergeInst, &branchInst, &mergeBlockId);
     // Map header block to next enclosing header.
-    if (is_header) header2nextHeaderBranch_[*bi] = currentHeaderBranch.top();
+    if (is_header) {
+      info.merge = mergeInst;
+      if (currentHeader.top() != nullptr) {
+        info.next_header_branch = currentHeader.top()->terminator();
+        info.next_header_merge = currentHeader.top()->GetMergeInst();
+      }
+    }
     // If this is a loop header, update state first so the block will map to
     // itself.
     if (is_header && mergeInst->opcode() == SpvOpLoopMerge) {
-      currentHeaderBranch.push(branchInst);
-      branch2merge_[branchInst] = mergeInst;
+      currentHeader.push(*bi);
       currentMergeBlockId = mergeBlockId;
     }
     // Map the block to the current construct.
-    block2headerBranch_[*bi] = currentHeaderBranch.top();
+    if (currentHeader.top() != nullptr) {
+      info.header_branch = currentHeader.top()->terminator();
+      info.header_merge = currentHeader.top()->GetMergeInst();
+    }
     // If this is an if header, update state so following blocks map to the if.
     if (is_header && mergeInst->opcode() == SpvOpSelectionMerge) {
-      currentHeaderBranch.push(branchInst);
-      branch2merge_[branchInst] = mergeInst;
+      currentHeader.push(*bi);
       currentMergeBlockId = mergeBlockId;
     }
   }
@@ -262,21 +269,20 @@ void AggressiveDCEPass::AddBreaksAndContinuesToWorklist(
          mergeInst->opcode() == SpvOpLoopMerge);
 
   BasicBlock* header = context()->get_instr_block(mergeInst);
-  uint32_t headerIndex = structured_order_index_[header];
+  uint32_t headerIndex = block_info_[header->id()].structured_order_index;
   const uint32_t mergeId = mergeInst->GetSingleWordInOperand(0);
-  BasicBlock* merge = context()->get_instr_block(mergeId);
-  uint32_t mergeIndex = structured_order_index_[merge];
+  uint32_t mergeIndex = block_info_[mergeId].structured_order_index;
   get_def_use_mgr()->ForEachUser(
       mergeId, [headerIndex, mergeIndex, this](Instruction* user) {
         if (!user->IsBranch()) return;
-        BasicBlock* block = context()->get_instr_block(user);
-        uint32_t index = structured_order_index_[block];
+        const BlockInfo& info =
+            block_info_[context()->get_instr_block(user)->id()];
+        uint32_t index = info.structured_order_index;
         if (headerIndex < index && index < mergeIndex) {
           // This is a break from the loop.
           AddToWorklist(user);
           // Add branch's merge if there is one.
-          Instruction* userMerge = branch2merge_[user];
-          if (userMerge != nullptr) AddToWorklist(userMerge);
+          if (info.merge != nullptr) AddToWorklist(info.merge);
         }
       });
 
@@ -292,7 +298,8 @@ void AggressiveDCEPass::AddBreaksAndContinuesToWorklist(
     if (op == SpvOpBranchConditional || op == SpvOpSwitch) {
       // A conditional branch or switch can only be a continue if it does not
       // have a merge instruction or its merge block is not the continue block.
-      Instruction* hdrMerge = branch2merge_[user];
+      Instruction* hdrMerge =
+          block_info_[context()->get_instr_block(user)->id()].merge;
       if (hdrMerge != nullptr && hdrMerge->opcode() == SpvOpSelectionMerge) {
         uint32_t hdrMergeId =
             hdrMerge->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
@@ -303,10 +310,10 @@ void AggressiveDCEPass::AddBreaksAndContinuesToWorklist(
     } else if (op == SpvOpBranch) {
       // An unconditional branch can only be a continue if it is not
       // branching to its own merge block.
-      BasicBlock* blk = context()->get_instr_block(user);
-      Instruction* hdrBranch = block2headerBranch_[blk];
-      if (hdrBranch == nullptr) return;
-      Instruction* hdrMerge = branch2merge_[hdrBranch];
+      const BlockInfo& info =
+          block_info_[context()->get_instr_block(user)->id()];
+      if (info.header_branch == nullptr) return;
+      Instruction* hdrMerge = info.header_merge;
       if (hdrMerge->opcode() == SpvOpLoopMerge) return;
       uint32_t hdrMergeId =
           hdrMerge->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
@@ -330,7 +337,7 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
   // Compute map from block to controlling conditional branch
   std::list<BasicBlock*> structuredOrder;
   cfg()->ComputeStructuredOrder(func, &*func->begin(), &structuredOrder);
-  ComputeBlock2HeaderMaps(structuredOrder);
+  ComputeBlock2HeaderMaps(func, structuredOrder);
   bool modified = false;
   // Add instructions with external side effects to worklist. Also add branches
   // EXCEPT those immediately contained in an "if" selection construct or a loop
@@ -339,7 +346,7 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
   call_in_func_ = false;
   func_is_entry_point_ = false;
   private_stores_.clear();
-  live_local_vars_.clear();
+  live_local_vars_ = utils::BitVector();
   // Stacks to keep track of when we are inside an if- or loop-construct.
   // When immediately inside an if- or loop-construct, we do not initially
   // mark branches live. All other branches must be marked live.
@@ -427,7 +434,8 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
     for (auto& ps : private_stores_) AddToWorklist(ps);
   // Perform closure on live instruction set.
   while (!worklist_.empty()) {
-    Instruction* liveInst = worklist_.front();
+    Instruction* liveInst = worklist_.back();
+    worklist_.pop_back();
     // Add all operand instructions if not already live
     liveInst->ForEachInId([&liveInst, this](const uint32_t* iid) {
       Instruction* inInst = get_def_use_mgr()->GetDef(*iid);
@@ -443,19 +451,18 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
     // If in a structured if or loop construct, add the controlling
     // conditional branch and its merge.
     BasicBlock* blk = context()->get_instr_block(liveInst);
-    Instruction* branchInst = block2headerBranch_[blk];
-    if (branchInst != nullptr) {
-      AddToWorklist(branchInst);
-      Instruction* mergeInst = branch2merge_[branchInst];
-      AddToWorklist(mergeInst);
-    }
-    // If the block is a header, add the next outermost controlling
-    // conditional branch and its merge.
-    Instruction* nextBranchInst = header2nextHeaderBranch_[blk];
-    if (nextBranchInst != nullptr) {
-      AddToWorklist(nextBranchInst);
-      Instruction* mergeInst = branch2merge_[nextBranchInst];
-      AddToWorklist(mergeInst);
+    if (blk != nullptr) {
+      const BlockInfo& info = block_info_[blk->id()];
+      if (info.header_branch != nullptr) {
+        AddToWorklist(info.header_branch);
+        AddToWorklist(info.header_merge);
+      }
+      // If the block is a header, add the next outermost controlling
+      // conditional branch and its merge.
+      if (info.next_header_branch != nullptr) {
+        AddToWorklist(info.next_header_branch);
+        AddToWorklist(info.next_header_merge);
+      }
     }
     // If local load, add all variable's stores if variable not already live
     if (liveInst->opcode() == SpvOpLoad || liveInst->IsAtomicWithLoad()) {
@@ -544,7 +551,6 @@ bool AggressiveDCEPass::AggressiveDCE(Function* func) {
           get_def_use_mgr()->GetDef(liveInst->GetDebugInlinedAt());
       AddToWorklist(inlined_at);
     }
-    worklist_.pop();
   }
 
   // Kill dead instructions and remember dead blocks
@@ -684,8 +690,10 @@ Pass::Status AggressiveDCEPass::ProcessImpl() {
   // return unmodified.
   if (!AllExtensionsSupported()) return Status::SuccessWithoutChange;
 
-  // Eliminate Dead functions.
-  bool modified = EliminateDeadFunctions();
+  // Eliminate Dead functions.  When only one function is processed, the
+  // module-wide clean up is left to a later run over the whole module.
+  const bool whole_module = !context()->HasFunctionFilter();
+  bool modified = whole_module && EliminateDeadFunctions();
 
   InitializeModuleScopeLiveInstructions();
 
@@ -706,15 +714,15 @@ Pass::Status AggressiveDCEPass::ProcessImpl() {
 
   // Process module-level instructions. Now that all live instructions have
   // been marked, it is safe to remove dead global values.
-  modified |= ProcessGlobalValues();
+  if (whole_module) {
+    modified |= ProcessGlobalValues();
+  }
 
   assert((to_kill_.empty() || modified) &&
          "A dead instruction was identified, but no change recorded.");
 
   // Kill all dead instructions.
-  for (auto inst : to_kill_) {
-    context()->KillInst(inst);
-  }
+  context()->KillInsts(to_kill_);
 
   // Cleanup all CFG including all unreachable blocks.
   ProcessFunction cleanup = [this](Function* f) { return CFGCleanup(f); };
@@ -20,7 +20,6 @@
 #include <algorithm>
 #include <list>
 #include <map>
-#include <queue>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -79,7 +78,7 @@ class AggressiveDCEPass : public MemPass {
   // Add |inst| to worklist_ and live_insts_.
   void AddToWorklist(Instruction* inst) {
     if (!live_insts_.Set(inst->unique_id())) {
-      worklist_.push(inst);
+      worklist_.push_back(inst);
     }
   }
 
@@ -109,9 +108,10 @@ class AggressiveDCEPass : public MemPass {
   bool IsStructuredHeader(BasicBlock* bp, Instruction** mergeInst,
                           Instruction** branchInst, uint32_t* mergeBlockId);
 
-  // Initialize block2headerBranch_,  header2nextHeaderBranch_, and
-  // branch2merge_ using |structuredOrder| to order blocks.
-  void ComputeBlock2HeaderMaps(std::list<BasicBlock*>& structuredOrder);
+  // Initialize the entries of block_info_ for the blocks of |func| using
+  // |structuredOrder| to order blocks.
+  void ComputeBlock2HeaderMaps(Function* func,
+                               std::list<BasicBlock*>& structuredOrder);
 
   // Add branch to |labelId| to end of block |bp|.
   void AddBranch(uint32_t labelId, BasicBlock* bp);
@@ -153,26 +153,38 @@ class AggressiveDCEPass : public MemPass {
   // if it might have a side effect, either directly or indirectly.
   // If we don't know, then add it to this list.  Instructions are
   // removed from this list as the algorithm traces side effects,
-  // building up the live instructions set |live_insts_|.
-  std::queue<Instruction*> worklist_;
+  // building up the live instructions set |live_insts_|.  The live set does
+  // not depend on the order in which instructions are processed, so this is
+  // used as a stack.
+  std::vector<Instruction*> worklist_;
 
-  // Map from block to the branch instruction in the header of the most
-  // immediate controlling structured if or loop.  A loop header block points
-  // to its own branch instruction.  An if-selection block points to the branch
-  // of an enclosing construct's header, if one exists.
-  std::unordered_map<BasicBlock*, Instruction*> block2headerBranch_;
-
-  // Map from header block to the branch instruction in the header of the
-  // structured construct enclosing it.
+  // The structured control flow information of a block.
   // The liveness algorithm is designed to iteratively mark as live all
   // structured constructs enclosing a live instruction.
-  std::unordered_map<BasicBlock*, Instruction*> header2nextHeaderBranch_;
-
-  // Maps basic block to their index in the structured order traversal.
-  std::unordered_map<BasicBlock*, uint32_t> structured_order_index_;
-
-  // Map from branch to its associated merge instruction, if any
-  std::unordered_map<Instruction*, Instruction*> branch2merge_;
+  struct BlockInfo {
+    // The index of the block in the structured order traversal.
+    uint32_t structured_order_index = 0;
+
+    // The branch and merge instructions in the header of the most immediate
+    // controlling structured if or loop.  A loop header block points to its
+    // own branch instruction.  An if-selection block points to the branch of
+    // an enclosing construct's header, if one exists.
+    Instruction* header_branch = nullptr;
+    Instruction* header_merge = nullptr;
+
+    // For a header block, the branch and merge instructions in the header of
+    // the structured construct enclosing it.
+    Instruction* next_header_branch = nullptr;
+    Instruction* next_header_merge = nullptr;
+
+    // For a header block, its merge instruction.
+    Instruction* merge = nullptr;
+  };
+
+  // The structured control flow information of the blocks of the current
+  // function, indexed by block id.  Lookups in the liveness closure are then
+  // array accesses rather than hash map lookups.
+  std::vector<BlockInfo> block_info_;
 
   // Store instructions to variables of private storage
   std::vector<Instruction*> private_stores_;
@@ -180,8 +192,8 @@ class AggressiveDCEPass : public MemPass {
   // Live Instructions
   utils::BitVector live_insts_;
 
-  // Live Local Variables
-  std::unordered_set<uint32_t> live_local_vars_;
+  // Live Local Variables, indexed by id.
+  utils::BitVector live_local_vars_;
 
   // List of instructions to delete. Deletion is delayed until debug and
   // annotation instructions are processed.
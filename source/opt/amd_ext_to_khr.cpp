@@ -852,13 +852,13 @@ class AmdExtFoldingRules : public FoldingRules {
         context()->module()->GetExtInstImportId("SPV_AMD_shader_ballot");
 
     if (extension_id != 0) {
-      ext_rules_[{extension_id, AmdShaderBallotSwizzleInvocationsAMD}]
+      ext_rules_[extension_id][AmdShaderBallotSwizzleInvocationsAMD]
           .push_back(ReplaceSwizzleInvocations);
-      ext_rules_[{extension_id, AmdShaderBallotSwizzleInvocationsMaskedAMD}]
+      ext_rules_[extension_id][AmdShaderBallotSwizzleInvocationsMaskedAMD]
           .push_back(ReplaceSwizzleInvocationsMasked);
-      ext_rules_[{extension_id, AmdShaderBallotWriteInvocationAMD}].push_back(
+      ext_rules_[extension_id][AmdShaderBallotWriteInvocationAMD].push_back(
           ReplaceWriteInvocation);
-      ext_rules_[{extension_id, AmdShaderBallotMbcntAMD}].push_back(
+      ext_rules_[extension_id][AmdShaderBallotMbcntAMD].push_back(
           ReplaceMbcnt);
     }
 
@@ -866,23 +866,23 @@ class AmdExtFoldingRules : public FoldingRules {
         "SPV_AMD_shader_trinary_minmax");
 
     if (extension_id != 0) {
-      ext_rules_[{extension_id, FMin3AMD}].push_back(
+      ext_rules_[extension_id][FMin3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450FMin>);
-      ext_rules_[{extension_id, UMin3AMD}].push_back(
+      ext_rules_[extension_id][UMin3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450UMin>);
-      ext_rules_[{extension_id, SMin3AMD}].push_back(
+      ext_rules_[extension_id][SMin3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450SMin>);
-      ext_rules_[{extension_id, FMax3AMD}].push_back(
+      ext_rules_[extension_id][FMax3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450FMax>);
-      ext_rules_[{extension_id, UMax3AMD}].push_back(
+      ext_rules_[extension_id][UMax3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450UMax>);
-      ext_rules_[{extension_id, SMax3AMD}].push_back(
+      ext_rules_[extension_id][SMax3AMD].push_back(
           ReplaceTrinaryMinMax<GLSLstd450SMax>);
-      ext_rules_[{extension_id, FMid3AMD}].push_back(
+      ext_rules_[extension_id][FMid3AMD].push_back(
           ReplaceTrinaryMid<GLSLstd450FMin, GLSLstd450FMax, GLSLstd450FClamp>);
-      ext_rules_[{extension_id, UMid3AMD}].push_back(
+      ext_rules_[extension_id][UMid3AMD].push_back(
           ReplaceTrinaryMid<GLSLstd450UMin, GLSLstd450UMax, GLSLstd450UClamp>);
-      ext_rules_[{extension_id, SMid3AMD}].push_back(
+      ext_rules_[extension_id][SMid3AMD].push_back(
           ReplaceTrinaryMid<GLSLstd450SMin, GLSLstd450SMax, GLSLstd450SClamp>);
     }
 
@@ -890,11 +890,11 @@ class AmdExtFoldingRules : public FoldingRules {
         context()->module()->GetExtInstImportId("SPV_AMD_gcn_shader");
 
     if (extension_id != 0) {
-      ext_rules_[{extension_id, CubeFaceCoordAMD}].push_back(
+      ext_rules_[extension_id][CubeFaceCoordAMD].push_back(
           ReplaceCubeFaceCoord);
-      ext_rules_[{extension_id, CubeFaceIndexAMD}].push_back(
+      ext_rules_[extension_id][CubeFaceIndexAMD].push_back(
           ReplaceCubeFaceIndex);
-      ext_rules_[{extension_id, TimeAMD}].push_back(ReplaceTimeAMD);
+      ext_rules_[extension_id][TimeAMD].push_back(ReplaceTimeAMD);
     }
   }
 };
@@ -107,7 +107,7 @@ void BasicBlock::KillAllInsts(bool killLabel) {
 }
 
 void BasicBlock::ForEachSuccessorLabel(
-    const std::function<void(const uint32_t)>& f) const {
+    utils::FunctionRef<void(const uint32_t)> f) const {
   WhileEachSuccessorLabel([f](const uint32_t l) {
     f(l);
     return true;
@@ -115,7 +115,7 @@ void BasicBlock::ForEachSuccessorLabel(
 }
 
 bool BasicBlock::WhileEachSuccessorLabel(
-    const std::function<bool(const uint32_t)>& f) const {
+    utils::FunctionRef<bool(const uint32_t)> f) const {
   const auto br = &insts_.back();
   switch (br->opcode()) {
     case SpvOpBranch:
@@ -134,8 +134,7 @@ bool BasicBlock::WhileEachSuccessorLabel(
   }
 }
 
-void BasicBlock::ForEachSuccessorLabel(
-    const std::function<void(uint32_t*)>& f) {
+void BasicBlock::ForEachSuccessorLabel(utils::FunctionRef<void(uint32_t*)> f) {
   auto br = &insts_.back();
   switch (br->opcode()) {
     case SpvOpBranch: {
@@ -166,7 +165,7 @@ bool BasicBlock::IsSuccessor(const BasicBlock* block) const {
 }
 
 void BasicBlock::ForMergeAndContinueLabel(
-    const std::function<void(const uint32_t)>& f) {
+    utils::FunctionRef<void(const uint32_t)> f) {
   auto ii = insts_.end();
   --ii;
   if (ii == insts_.begin()) return;
@@ -279,6 +278,10 @@ BasicBlock* BasicBlock::SplitBasicBlock(IRContext* context, uint32_t label_id,
     });
   }
 
+  if (context->AreAnalysesValid(IRContext::kAnalysisStructuredCFG)) {
+    context->GetStructuredCFGAnalysis()->OnBlockSplit(this, new_block);
+  }
+
   return new_block;
 }
 
@@ -29,6 +29,7 @@
 #include "source/opt/instruction.h"
 #include "source/opt/instruction_list.h"
 #include "source/opt/iterator.h"
+#include "source/util/function_ref.h"
 
 namespace spvtools {
 namespace opt {
@@ -132,53 +133,74 @@ class BasicBlock {
 
   // Runs the given function |f| on each instruction in this basic block, and
   // optionally on the debug line instructions that might precede them.
-  inline void ForEachInst(const std::function<void(Instruction*)>& f,
+  inline void ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                           bool run_on_debug_line_insts = false);
-  inline void ForEachInst(const std::function<void(const Instruction*)>& f,
+  inline void ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                           bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on each instruction in this basic block, and
   // optionally on the debug line instructions that might precede them. If |f|
   // returns false, iteration is terminated and this function returns false.
-  inline bool WhileEachInst(const std::function<bool(Instruction*)>& f,
+  inline bool WhileEachInst(utils::FunctionRef<bool(Instruction*)> f,
                             bool run_on_debug_line_insts = false);
-  inline bool WhileEachInst(const std::function<bool(const Instruction*)>& f,
+  inline bool WhileEachInst(utils::FunctionRef<bool(const Instruction*)> f,
                             bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on each Phi instruction in this basic block,
   // and optionally on the debug line instructions that might precede them.
-  inline void ForEachPhiInst(const std::function<void(Instruction*)>& f,
+  inline void ForEachPhiInst(utils::FunctionRef<void(Instruction*)> f,
                              bool run_on_debug_line_insts = false);
 
   // Runs the given function |f| on each Phi instruction in this basic block,
   // and optionally on the debug line instructions that might precede them. If
   // |f| returns false, iteration is terminated and this function return false.
-  inline bool WhileEachPhiInst(const std::function<bool(Instruction*)>& f,
+  inline bool WhileEachPhiInst(utils::FunctionRef<bool(Instruction*)> f,
                                bool run_on_debug_line_insts = false);
 
   // Runs the given function |f| on each label id of each successor block
-  void ForEachSuccessorLabel(
-      const std::function<void(const uint32_t)>& f) const;
+  void ForEachSuccessorLabel(utils::FunctionRef<void(const uint32_t)> f) const;
 
   // Runs the given function |f| on each label id of each successor block.  If
   // |f| returns false, iteration is terminated and this function returns false.
   bool WhileEachSuccessorLabel(
-      const std::function<bool(const uint32_t)>& f) const;
+      utils::FunctionRef<bool(const uint32_t)> f) const;
 
   // Runs the given function |f| on each label id of each successor block.
   // Modifying the pointed value will change the branch taken by the basic
   // block. It is the caller responsibility to update or invalidate the CFG.
-  void ForEachSuccessorLabel(const std::function<void(uint32_t*)>& f);
+  void ForEachSuccessorLabel(utils::FunctionRef<void(uint32_t*)> f);
 
   // Returns true if |block| is a direct successor of |this|.
   bool IsSuccessor(const BasicBlock* block) const;
 
+  // Returns true if |a| comes before |b| in this block.  Both must be
+  // instructions of this block other than its label.  Takes constant time in
+  // most cases; see InstructionList::IsBefore.
+  bool IsBefore(const Instruction* a, const Instruction* b) {
+    return insts_.IsBefore(a, b);
+  }
+
   // Runs the given function |f| on the merge and continue label, if any
-  void ForMergeAndContinueLabel(const std::function<void(const uint32_t)>& f);
+  void ForMergeAndContinueLabel(utils::FunctionRef<void(const uint32_t)> f);
 
   // Returns true if this basic block has any Phi instructions.
-  bool HasPhiInstructions() {
-    return !WhileEachPhiInst([](Instruction*) { return false; });
+  bool HasPhiInstructions() const {
+    return !insts_.empty() && insts_.front().opcode() == SpvOpPhi;
+  }
+
+  // Returns an iterator to the first instruction of this block that is not an
+  // OpPhi, which is where the instructions that must follow the phis are
+  // inserted.  The phis are always at the start of the block, so the search
+  // only visits them.
+  iterator GetFirstNonPhi() {
+    iterator it = begin();
+    while (it != end() && it->opcode() == SpvOpPhi) ++it;
+    return it;
+  }
+  const_iterator GetFirstNonPhi() const {
+    const_iterator it = cbegin();
+    while (it != cend() && it->opcode() == SpvOpPhi) ++it;
+    return it;
   }
 
   // Return true if this block is a loop header block.
@@ -256,7 +278,7 @@ inline void BasicBlock::AddInstructions(BasicBlock* bp) {
 }
 
 inline bool BasicBlock::WhileEachInst(
-    const std::function<bool(Instruction*)>& f, bool run_on_debug_line_insts) {
+    utils::FunctionRef<bool(Instruction*)> f, bool run_on_debug_line_insts) {
   if (label_) {
     if (!label_->WhileEachInst(f, run_on_debug_line_insts)) return false;
   }
@@ -274,7 +296,7 @@ inline bool BasicBlock::WhileEachInst(
 }
 
 inline bool BasicBlock::WhileEachInst(
-    const std::function<bool(const Instruction*)>& f,
+    utils::FunctionRef<bool(const Instruction*)> f,
     bool run_on_debug_line_insts) const {
   if (label_) {
     if (!static_cast<const Instruction*>(label_.get())
@@ -289,7 +311,7 @@ inline bool BasicBlock::WhileEachInst(
   return true;
 }
 
-inline void BasicBlock::ForEachInst(const std::function<void(Instruction*)>& f,
+inline void BasicBlock::ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                                     bool run_on_debug_line_insts) {
   WhileEachInst(
       [&f](Instruction* inst) {
@@ -300,7 +322,7 @@ inline void BasicBlock::ForEachInst(const std::function<void(Instruction*)>& f,
 }
 
 inline void BasicBlock::ForEachInst(
-    const std::function<void(const Instruction*)>& f,
+    utils::FunctionRef<void(const Instruction*)> f,
     bool run_on_debug_line_insts) const {
   WhileEachInst(
       [&f](const Instruction* inst) {
@@ -311,7 +333,7 @@ inline void BasicBlock::ForEachInst(
 }
 
 inline bool BasicBlock::WhileEachPhiInst(
-    const std::function<bool(Instruction*)>& f, bool run_on_debug_line_insts) {
+    utils::FunctionRef<bool(Instruction*)> f, bool run_on_debug_line_insts) {
   if (insts_.empty()) {
     return true;
   }
@@ -327,7 +349,7 @@ inline bool BasicBlock::WhileEachPhiInst(
 }
 
 inline void BasicBlock::ForEachPhiInst(
-    const std::function<void(Instruction*)>& f, bool run_on_debug_line_insts) {
+    utils::FunctionRef<void(Instruction*)> f, bool run_on_debug_line_insts) {
   WhileEachPhiInst(
       [&f](Instruction* inst) {
         f(inst);
@@ -45,7 +45,8 @@ class BlockMergePass : public Pass {
            IRContext::kAnalysisInstrToBlockMapping |
            IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
            IRContext::kAnalysisNameMap | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisReflection |
+           IRContext::kAnalysisCallGraph | IRContext::kAnalysisStructuredCFG;
   }
 
  private:
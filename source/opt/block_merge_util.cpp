@@ -146,6 +146,10 @@ void MergeWithSuccessor(IRContext* context, Function* func,
   Instruction* merge_inst = bi->GetMergeInst();
   bool pred_is_header = IsHeader(&*bi);
 
+  if (context->AreAnalysesValid(IRContext::kAnalysisStructuredCFG)) {
+    context->GetStructuredCFGAnalysis()->OnMergeWithSuccessor(&*bi, lab_id);
+  }
+
   // Merge blocks.
   context->KillInst(br);
   auto sbi = bi;
@@ -175,10 +179,12 @@ void MergeWithSuccessor(IRContext* context, Function* func,
       // the validation error that OpLine is placed between OpLoopMerge
       // and OpBranchConditional.
       auto terminator = bi->terminator();
-      auto& vec = terminator->dbg_line_insts();
-      auto& new_vec = merge_inst->dbg_line_insts();
-      new_vec.insert(new_vec.end(), vec.begin(), vec.end());
-      terminator->clear_dbg_line_insts();
+      std::vector<DebugLine> lines = merge_inst->dbg_lines();
+      const auto& terminator_lines = terminator->dbg_lines();
+      lines.insert(lines.end(), terminator_lines.begin(),
+                   terminator_lines.end());
+      merge_inst->set_dbg_lines(lines);
+      terminator->clear_dbg_lines();
 
       // Move the merge instruction to just before the terminator.
       merge_inst->InsertBefore(terminator);
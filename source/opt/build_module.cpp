@@ -19,50 +19,82 @@
 
 #include "source/opt/ir_context.h"
 #include "source/opt/ir_loader.h"
-#include "source/table.h"
 #include "source/util/make_unique.h"
+#include "source/val/validation_state.h"
 
 namespace spvtools {
-namespace {
-
-// Sets the module header for IrLoader. Meets the interface requirement of
-// spvBinaryParse().
-spv_result_t SetSpvHeader(void* builder, spv_endianness_t, uint32_t magic,
-                          uint32_t version, uint32_t generator,
-                          uint32_t id_bound, uint32_t reserved) {
-  reinterpret_cast<opt::IrLoader*>(builder)->SetModuleHeader(
-      magic, version, generator, id_bound, reserved);
-  return SPV_SUCCESS;
-}
-
-// Processes a parsed instruction for IrLoader. Meets the interface requirement
-// of spvBinaryParse().
-spv_result_t SetSpvInst(void* builder, const spv_parsed_instruction_t* inst) {
-  if (reinterpret_cast<opt::IrLoader*>(builder)->AddInstruction(inst)) {
-    return SPV_SUCCESS;
-  }
-  return SPV_ERROR_INVALID_BINARY;
-}
-
-}  // namespace
 
 std::unique_ptr<opt::IRContext> BuildModule(spv_target_env env,
                                             MessageConsumer consumer,
                                             const uint32_t* binary,
                                             const size_t size) {
-  auto context = spvContextCreate(env);
-  SetContextMessageConsumer(context, consumer);
+  return BuildModule(env, consumer, binary, size,
+                     /* use_instruction_arena = */ false);
+}
 
+std::unique_ptr<opt::IRContext> BuildModule(spv_target_env env,
+                                            MessageConsumer consumer,
+                                            const uint32_t* binary,
+                                            const size_t size,
+                                            bool use_instruction_arena,
+                                            bool skip_debug_line_insts) {
   auto irContext = MakeUnique<opt::IRContext>(env, consumer);
+  if (use_instruction_arena) {
+    irContext->EnableInstructionArena();
+  }
+  opt::InstructionArena::Scope arena_scope(irContext->instruction_arena());
   opt::IrLoader loader(consumer, irContext->module());
+  loader.SetSkipDebugLineInsts(skip_debug_line_insts);
 
-  spv_result_t status = spvBinaryParse(context, &loader, binary, size,
-                                       SetSpvHeader, SetSpvInst, nullptr);
+  // Pull the instructions straight into the loader.
+  BinaryReader reader(env, binary, size);
+  reader.SetMessageConsumer(consumer);
+  bool success = reader.ReadHeader();
+  if (success) {
+    loader.SetModuleHeader(SpvMagicNumber, reader.version(),
+                           reader.generator(), reader.id_bound(),
+                           reader.schema());
+    while (success && reader.Next()) {
+      success = loader.AddInstruction(&reader.instruction());
+    }
+    success = success && reader.status() == SPV_SUCCESS;
+  }
   loader.EndModule();
 
-  spvContextDestroy(context);
+  return success ? std::move(irContext) : nullptr;
+}
+
+std::unique_ptr<opt::IRContext> BuildModule(
+    spv_target_env env, MessageConsumer consumer, const uint32_t* binary,
+    size_t size, const val::ValidationState_t& vstate,
+    bool use_instruction_arena, bool skip_debug_line_insts) {
+  auto irContext = MakeUnique<opt::IRContext>(env, consumer);
+  if (use_instruction_arena) {
+    irContext->EnableInstructionArena();
+  }
+  opt::InstructionArena::Scope arena_scope(irContext->instruction_arena());
+  opt::IrLoader loader(consumer, irContext->module());
+  loader.SetSkipDebugLineInsts(skip_debug_line_insts);
+
+  // The validator kept every instruction it parsed, so only the header is
+  // read from |binary|.
+  BinaryReader reader(env, binary, size);
+  reader.SetMessageConsumer(consumer);
+  bool success = reader.ReadHeader();
+  if (success) {
+    loader.SetModuleHeader(SpvMagicNumber, reader.version(),
+                           reader.generator(), reader.id_bound(),
+                           reader.schema());
+    for (const auto& inst : vstate.ordered_instructions()) {
+      if (!loader.AddInstruction(&inst.c_inst())) {
+        success = false;
+        break;
+      }
+    }
+  }
+  loader.EndModule();
 
-  return status == SPV_SUCCESS ? std::move(irContext) : nullptr;
+  return success ? std::move(irContext) : nullptr;
 }
 
 std::unique_ptr<opt::IRContext> BuildModule(spv_target_env env,
@@ -23,6 +23,9 @@
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
+namespace val {
+class ValidationState_t;
+}  // namespace val
 
 // Builds an Module returns the owning IRContext from the given SPIR-V
 // |binary|. |size| specifies number of words in |binary|. The |binary| will be
@@ -33,6 +36,26 @@ std::unique_ptr<opt::IRContext> BuildModule(spv_target_env env,
                                             const uint32_t* binary,
                                             size_t size);
 
+// Same as above, but if |use_instruction_arena| is true, the instruction arena
+// of the returned IRContext is enabled and all instructions of the module are
+// allocated from it.  If |skip_debug_line_insts| is true, the OpLine and
+// OpNoLine instructions of |binary| are dropped instead of being attached to
+// the instructions they precede, and the module records that it dropped them.
+std::unique_ptr<opt::IRContext> BuildModule(spv_target_env env,
+                                            MessageConsumer consumer,
+                                            const uint32_t* binary,
+                                            size_t size,
+                                            bool use_instruction_arena,
+                                            bool skip_debug_line_insts = false);
+
+// Same as above, but the instructions are taken from |vstate|, which holds the
+// result of validating |binary|, instead of being parsed again.  Only the
+// header of |binary| is read.
+std::unique_ptr<opt::IRContext> BuildModule(
+    spv_target_env env, MessageConsumer consumer, const uint32_t* binary,
+    size_t size, const val::ValidationState_t& vstate,
+    bool use_instruction_arena, bool skip_debug_line_insts);
+
 // Builds an Module and returns the owning IRContext from the given
 // SPIR-V assembly |text|.  The |text| will be encoded according to the given
 // target |env|. Returns nullptr if errors occur and sends the errors to
@@ -0,0 +1,311 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/call_graph.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
+
+namespace spvtools {
+namespace opt {
+
+CallGraph::CallGraph(IRContext* context) : context_(context) {
+  for (auto& function : *context->module()) {
+    GetNode(&function);
+  }
+}
+
+const std::vector<Instruction*>& CallGraph::GetCallSites(
+    const Function* function) {
+  Update();
+  return GetNode(function)->calls;
+}
+
+const std::vector<uint32_t>& CallGraph::GetCallees(const Function* function) {
+  Update();
+  return GetNode(function)->callees;
+}
+
+const std::vector<uint32_t>& CallGraph::GetCallers(uint32_t function_id) {
+  Update();
+  auto iter = nodes_.find(function_id);
+  if (iter == nodes_.end()) return no_functions_;
+  return iter->second.callers;
+}
+
+const std::vector<std::vector<uint32_t>>&
+CallGraph::GetStronglyConnectedComponents() {
+  Update();
+  if (!components_valid_) {
+    ComputeComponents();
+  }
+  return components_;
+}
+
+std::vector<uint32_t> CallGraph::GetFunctionsInTopologicalOrder() {
+  std::vector<uint32_t> order;
+  for (const auto& component : GetStronglyConnectedComponents()) {
+    order.insert(order.end(), component.begin(), component.end());
+  }
+  return order;
+}
+
+bool CallGraph::IsRecursive(const Function* function) {
+  const std::vector<uint32_t>& callees = GetCallees(function);
+  const uint32_t function_id = function->result_id();
+  if (std::find(callees.begin(), callees.end(), function_id) !=
+      callees.end()) {
+    return true;
+  }
+  const auto& components = GetStronglyConnectedComponents();
+  auto iter = component_of_.find(function_id);
+  return iter != component_of_.end() && components[iter->second].size() > 1;
+}
+
+bool CallGraph::HasRecursion() {
+  for (const auto& component : GetStronglyConnectedComponents()) {
+    if (component.size() > 1) return true;
+    const std::vector<uint32_t>& callees = nodes_[component[0]].callees;
+    if (std::find(callees.begin(), callees.end(), component[0]) !=
+        callees.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CallGraph::AddFunction(Function* function) { GetNode(function); }
+
+void CallGraph::RemoveFunction(uint32_t function_id) {
+  auto iter = nodes_.find(function_id);
+  if (iter == nodes_.end()) return;
+  Node& node = iter->second;
+  for (uint32_t callee : node.callees) {
+    std::vector<uint32_t>& callers = nodes_[callee].callers;
+    callers.erase(std::remove(callers.begin(), callers.end(), function_id),
+                  callers.end());
+  }
+  for (const Instruction* call : node.calls) {
+    auto call_iter = call_to_caller_.find(call);
+    if (call_iter != call_to_caller_.end() &&
+        call_iter->second == function_id) {
+      call_to_caller_.erase(call_iter);
+    }
+  }
+  if (node.callers.empty()) {
+    nodes_.erase(iter);
+  } else {
+    // The function is still called, so the node stays as a callee without a
+    // function.
+    node.function = nullptr;
+    node.calls.clear();
+    node.callees.clear();
+    node.modified = false;
+  }
+  components_valid_ = false;
+}
+
+void CallGraph::MarkModified(const Function* function) {
+  auto iter = nodes_.find(function->result_id());
+  if (iter == nodes_.end()) return;
+  Node& node = iter->second;
+  if (node.function == nullptr || node.modified) return;
+  node.modified = true;
+  modified_functions_.push_back(function->result_id());
+}
+
+void CallGraph::RemoveCall(const Instruction* call) {
+  auto iter = call_to_caller_.find(call);
+  if (iter == call_to_caller_.end()) return;
+  Node& node = nodes_[iter->second];
+  call_to_caller_.erase(iter);
+  if (node.function != nullptr) {
+    MarkModified(node.function);
+  }
+}
+
+Function* CallGraph::GetCaller(const Instruction* call) const {
+  auto iter = call_to_caller_.find(call);
+  if (iter == call_to_caller_.end()) return nullptr;
+  return nodes_.at(iter->second).function;
+}
+
+size_t CallGraph::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(nodes_) +
+                 utils::MemoryUsage(call_to_caller_) +
+                 utils::MemoryUsage(modified_functions_) +
+                 utils::MemoryUsage(components_) +
+                 utils::MemoryUsage(component_of_);
+  for (const auto& entry : nodes_) {
+    bytes += utils::MemoryUsage(entry.second.calls) +
+             utils::MemoryUsage(entry.second.callees) +
+             utils::MemoryUsage(entry.second.callers);
+  }
+  for (const auto& component : components_) {
+    bytes += utils::MemoryUsage(component);
+  }
+  return bytes;
+}
+
+CallGraph::Node* CallGraph::GetNode(const Function* function) {
+  const uint32_t function_id = function->result_id();
+  Node* node = &nodes_[function_id];
+  if (node->function == nullptr) {
+    node->function = const_cast<Function*>(function);
+    AnalyzeCalls(function_id, node);
+    components_valid_ = false;
+  }
+  return node;
+}
+
+void CallGraph::Update() {
+  for (uint32_t function_id : modified_functions_) {
+    auto iter = nodes_.find(function_id);
+    if (iter != nodes_.end() && iter->second.modified) {
+      AnalyzeCalls(function_id, &iter->second);
+    }
+  }
+  modified_functions_.clear();
+}
+
+void CallGraph::AnalyzeCalls(uint32_t function_id, Node* node) {
+  for (const Instruction* call : node->calls) {
+    auto iter = call_to_caller_.find(call);
+    if (iter != call_to_caller_.end() && iter->second == function_id) {
+      call_to_caller_.erase(iter);
+    }
+  }
+  node->calls.clear();
+  node->modified = false;
+
+  std::vector<uint32_t> old_callees;
+  old_callees.swap(node->callees);
+  std::unordered_set<uint32_t> seen;
+  for (auto& block : *node->function) {
+    for (auto& inst : block) {
+      if (inst.opcode() != SpvOpFunctionCall) continue;
+      node->calls.push_back(&inst);
+      call_to_caller_[&inst] = function_id;
+      const uint32_t callee = inst.GetSingleWordInOperand(0);
+      if (seen.insert(callee).second) {
+        node->callees.push_back(callee);
+      }
+    }
+  }
+  if (node->callees == old_callees) return;
+
+  // |nodes_| may grow below, but the nodes it holds do not move.
+  for (uint32_t callee : old_callees) {
+    std::vector<uint32_t>& callers = nodes_[callee].callers;
+    callers.erase(std::remove(callers.begin(), callers.end(), function_id),
+                  callers.end());
+  }
+  for (uint32_t callee : node->callees) {
+    std::vector<uint32_t>& callers = nodes_[callee].callers;
+    auto iter = std::lower_bound(callers.begin(), callers.end(), function_id);
+    if (iter == callers.end() || *iter != function_id) {
+      callers.insert(iter, function_id);
+    }
+  }
+  components_valid_ = false;
+}
+
+void CallGraph::ComputeComponents() {
+  // Functions that were added to the module without going through the
+  // IRContext do not have a node yet.
+  std::vector<uint32_t> functions;
+  for (auto& function : *context_->module()) {
+    GetNode(&function);
+    functions.push_back(function.result_id());
+  }
+
+  components_.clear();
+  component_of_.clear();
+
+  // An iterative version of Tarjan's algorithm.  The components are found
+  // callees first, so they are reversed at the end.
+  struct Frame {
+    uint32_t function_id;
+    size_t next_callee;
+  };
+  std::unordered_map<uint32_t, uint32_t> index;
+  std::unordered_map<uint32_t, uint32_t> low_link;
+  std::unordered_set<uint32_t> on_stack;
+  std::vector<uint32_t> stack;
+  std::vector<Frame> frames;
+  uint32_t next_index = 0;
+
+  for (uint32_t root : functions) {
+    if (index.count(root)) continue;
+    index[root] = low_link[root] = next_index++;
+    stack.push_back(root);
+    on_stack.insert(root);
+    frames.push_back({root, 0});
+
+    while (!frames.empty()) {
+      Frame& frame = frames.back();
+      const uint32_t function_id = frame.function_id;
+      const std::vector<uint32_t>& callees = nodes_[function_id].callees;
+      if (frame.next_callee < callees.size()) {
+        const uint32_t callee = callees[frame.next_callee++];
+        auto callee_node = nodes_.find(callee);
+        if (callee_node == nodes_.end() ||
+            callee_node->second.function == nullptr) {
+          continue;
+        }
+        auto callee_index = index.find(callee);
+        if (callee_index == index.end()) {
+          index[callee] = low_link[callee] = next_index++;
+          stack.push_back(callee);
+          on_stack.insert(callee);
+          frames.push_back({callee, 0});
+        } else if (on_stack.count(callee)) {
+          low_link[function_id] =
+              std::min(low_link[function_id], callee_index->second);
+        }
+        continue;
+      }
+
+      frames.pop_back();
+      if (!frames.empty()) {
+        const uint32_t caller = frames.back().function_id;
+        low_link[caller] = std::min(low_link[caller], low_link[function_id]);
+      }
+      if (low_link[function_id] != index[function_id]) continue;
+
+      components_.emplace_back();
+      uint32_t member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        on_stack.erase(member);
+        components_.back().push_back(member);
+      } while (member != function_id);
+    }
+  }
+
+  std::reverse(components_.begin(), components_.end());
+  for (uint32_t i = 0; i < components_.size(); ++i) {
+    for (uint32_t function_id : components_[i]) {
+      component_of_[function_id] = i;
+    }
+  }
+  components_valid_ = true;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,131 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_CALL_GRAPH_H_
+#define SOURCE_OPT_CALL_GRAPH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+class Function;
+class Instruction;
+class IRContext;
+
+// The call graph of a module: for each function, the OpFunctionCall
+// instructions it contains, the functions it calls and the functions that call
+// it.  Recursion is allowed; the strongly connected components of the graph
+// are computed on demand.
+//
+// The graph is kept up to date one function at a time.  Functions whose calls
+// may have changed are marked as modified, and their calls are collected again
+// the next time the graph is queried.
+class CallGraph {
+ public:
+  explicit CallGraph(IRContext* context);
+
+  // Returns the OpFunctionCall instructions in |function|, in the order they
+  // appear in the function.
+  const std::vector<Instruction*>& GetCallSites(const Function* function);
+
+  // Returns the ids of the functions |function| calls directly, in the order
+  // of their first call in |function|.
+  const std::vector<uint32_t>& GetCallees(const Function* function);
+
+  // Returns the ids of the functions that directly call the function
+  // |function_id|, in increasing order.
+  const std::vector<uint32_t>& GetCallers(uint32_t function_id);
+
+  // Returns the strongly connected components of the graph.  A function that
+  // does not take part in a recursion is a component on its own.  The
+  // components are in topological order: those of the callers of a function
+  // that are not in its component come before its own.
+  const std::vector<std::vector<uint32_t>>& GetStronglyConnectedComponents();
+
+  // Returns the ids of all of the functions in an order in which callers come
+  // before their callees, apart from the calls within a recursion.
+  std::vector<uint32_t> GetFunctionsInTopologicalOrder();
+
+  // Returns true if |function| can call itself, directly or indirectly.
+  bool IsRecursive(const Function* function);
+
+  // Returns true if any function of the module is recursive.
+  bool HasRecursion();
+
+  // Adds |function|, which was just added to the module, to the graph.
+  void AddFunction(Function* function);
+
+  // Removes the function |function_id| from the graph.
+  void RemoveFunction(uint32_t function_id);
+
+  // Records that the calls made by |function| may have changed.
+  void MarkModified(const Function* function);
+
+  // Records that |call| is about to be removed from the function that
+  // contains it.  Does nothing if |call| is not known to the graph.
+  void RemoveCall(const Instruction* call);
+
+  // Returns the function that contains |call|, or nullptr if |call| is not
+  // known to the graph.
+  Function* GetCaller(const Instruction* call) const;
+
+  // Returns an estimate of the memory, in bytes, that the analysis uses.
+  size_t MemoryUsage() const;
+
+ private:
+  struct Node {
+    Function* function = nullptr;
+    std::vector<Instruction*> calls;
+    std::vector<uint32_t> callees;
+    std::vector<uint32_t> callers;
+    bool modified = false;
+  };
+
+  // Returns the node of |function|, and adds it to the graph if it is not
+  // already there.
+  Node* GetNode(const Function* function);
+
+  // Collects the calls of every modified function again.
+  void Update();
+
+  // Collects the calls made by the function of |node| again, and updates the
+  // callers of its old and new callees.
+  void AnalyzeCalls(uint32_t function_id, Node* node);
+
+  // Computes |components_| and |component_of_| with Tarjan's algorithm.
+  void ComputeComponents();
+
+  IRContext* context_;
+  std::unordered_map<uint32_t, Node> nodes_;
+  // The function that contains each call.
+  std::unordered_map<const Instruction*, uint32_t> call_to_caller_;
+  // The ids of the functions whose node is marked as modified.
+  std::vector<uint32_t> modified_functions_;
+  // The strongly connected components, and the index in |components_| of the
+  // component of each function.  Only valid if |components_valid_| is true.
+  std::vector<std::vector<uint32_t>> components_;
+  std::unordered_map<uint32_t, uint32_t> component_of_;
+  bool components_valid_ = false;
+  // Returned for the functions that are not in the graph.
+  const std::vector<uint32_t> no_functions_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_CALL_GRAPH_H_
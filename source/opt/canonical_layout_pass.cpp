@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/canonical_layout_pass.h"
+
+#include <list>
+
+#include "source/opt/call_graph.h"
+#include "source/opt/compact_ids_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status CanonicalLayoutPass::Process() {
+  bool modified = ReorderFunctions();
+  for (auto& function : *get_module()) {
+    modified |= ReorderBlocks(&function);
+  }
+
+  CompactIdsPass compact_ids(/* in_definition_order = */ true);
+  compact_ids.SetMessageConsumer(consumer());
+  Status status = compact_ids.Run(context());
+  if (status == Status::Failure) return Status::Failure;
+  if (status == Status::SuccessWithChange) modified = true;
+
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+bool CanonicalLayoutPass::ReorderFunctions() {
+  std::vector<Function*> order;
+  std::unordered_set<uint32_t> visited;
+  // Declarations must come before all of the definitions.
+  for (auto& function : *get_module()) {
+    if (function.begin() == function.end()) {
+      order.push_back(&function);
+      visited.insert(function.result_id());
+    }
+  }
+  for (auto& function : *get_module()) {
+    AddFunctionAfterCallees(&function, &visited, &order);
+  }
+  return get_module()->ReorderFunctions(order);
+}
+
+void CanonicalLayoutPass::AddFunctionAfterCallees(
+    Function* function, std::unordered_set<uint32_t>* visited,
+    std::vector<Function*>* order) {
+  if (!visited->insert(function->result_id()).second) return;
+  CallGraph* call_graph = context()->GetCallGraph();
+  // Copy the callees, since the call graph may update its nodes when queried.
+  const std::vector<uint32_t> callees = call_graph->GetCallees(function);
+  for (uint32_t callee_id : callees) {
+    Function* callee = context()->GetFunction(callee_id);
+    if (callee != nullptr) AddFunctionAfterCallees(callee, visited, order);
+  }
+  order->push_back(function);
+}
+
+bool CanonicalLayoutPass::ReorderBlocks(Function* function) {
+  if (function->begin() == function->end()) return false;
+
+  std::vector<BasicBlock*> order;
+  if (context()->get_feature_mgr()->HasCapability(SpvCapabilityShader)) {
+    std::list<BasicBlock*> structured_order;
+    context()->cfg()->ComputeStructuredOrder(function, &*function->begin(),
+                                             &structured_order);
+    order.assign(structured_order.begin(), structured_order.end());
+  } else {
+    context()->cfg()->ForEachBlockInReversePostOrder(
+        &*function->begin(),
+        [&order](BasicBlock* block) { order.push_back(block); });
+  }
+  return function->ReorderBasicBlocks(order);
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,62 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_CANONICAL_LAYOUT_PASS_H_
+#define SOURCE_OPT_CANONICAL_LAYOUT_PASS_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// This pass lays out the module in the order that drivers parse fastest:
+//
+//   - The function definitions are ordered so that callees come before their
+//     callers, apart from the calls within a recursion.  Function declarations
+//     stay first.  Functions that are not ordered by a call keep their order.
+//   - The reachable blocks of each function are put in structured order for
+//     shaders, and in reverse post order otherwise.  Unreachable blocks keep
+//     their order at the end of the function.
+//   - The result ids are renumbered from 1 in the order of their definitions,
+//     as by CompactIdsPass.
+class CanonicalLayoutPass : public Pass {
+ public:
+  const char* name() const override { return "canonical-layout"; }
+  Status Process() override;
+
+ private:
+  // Reorders the functions of the module.  Returns true if their order
+  // changed.
+  bool ReorderFunctions();
+
+  // Appends |function| to |order| after the functions it calls that are not
+  // in |visited|.
+  void AddFunctionAfterCallees(Function* function,
+                               std::unordered_set<uint32_t>* visited,
+                               std::vector<Function*>* order);
+
+  // Reorders the blocks of |function|.  Returns true if their order changed.
+  bool ReorderBlocks(Function* function);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_CANONICAL_LAYOUT_PASS_H_
@@ -315,6 +315,7 @@ bool CCPPass::PropagateConstants(Function* fp) {
 
 void CCPPass::Initialize() {
   const_mgr_ = context()->get_constant_mgr();
+  values_.reserve(context()->module()->IdBound());
 
   // Populate the constant table with values from constant declarations in the
   // module.  The values of each OpConstant declaration is the identity
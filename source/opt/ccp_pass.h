@@ -16,7 +16,6 @@
 #define SOURCE_OPT_CCP_PASS_H_
 
 #include <memory>
-#include <unordered_map>
 
 #include "source/opt/constants.h"
 #include "source/opt/function.h"
@@ -24,6 +23,7 @@
 #include "source/opt/mem_pass.h"
 #include "source/opt/module.h"
 #include "source/opt/propagator.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -41,7 +41,8 @@ class CCPPass : public MemPass {
            IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
            IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
            IRContext::kAnalysisNameMap | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisReflection |
+           IRContext::kAnalysisCallGraph;
   }
 
  private:
@@ -101,7 +102,7 @@ class CCPPass : public MemPass {
   // SSA ID is found to have a varying value, it will have an entry in this
   // table that maps to the special SSA id kVaryingSSAId.  These values are
   // never replaced in the IR, they are used by CCP during propagation.
-  std::unordered_map<uint32_t, uint32_t> values_;
+  utils::IdMap<uint32_t> values_;
 
   // Propagator engine used.
   std::unique_ptr<SSAPropagator> propagator_;
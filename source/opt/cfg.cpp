@@ -21,6 +21,7 @@
 #include "source/opt/ir_builder.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/module.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
@@ -39,6 +40,7 @@ CFG::CFG(Module* module)
           new Instruction(module->context(), SpvOpLabel, 0, 0, {}))),
       pseudo_exit_block_(std::unique_ptr<Instruction>(new Instruction(
           module->context(), SpvOpLabel, 0, kMaxResultId, {}))) {
+  label2preds_.reserve(module->IdBound());
   for (auto& fn : *module) {
     for (auto& blk : fn) {
       RegisterBlock(&blk);
@@ -56,6 +58,32 @@ void CFG::AddEdges(BasicBlock* blk) {
       [blk_id, this](const uint32_t succ_id) { AddEdge(blk_id, succ_id); });
 }
 
+void CFG::RebuildFunction(Function* func) {
+  // Clear all of the predecessor lists first, since registering a block adds
+  // it to the lists of its successors.
+  std::unordered_set<uint32_t> block_ids;
+  for (auto& blk : *func) {
+    label2preds_.erase(blk.id());
+    block_ids.insert(blk.id());
+  }
+
+  // The blocks that were removed are not dereferenced, since they may have
+  // been deleted.  They cannot be in the predecessor list of a block that is
+  // still in |func| once it has been registered again.
+  std::unordered_set<uint32_t>& registered = function_blocks_[func];
+  for (uint32_t blk_id : registered) {
+    if (block_ids.count(blk_id)) continue;
+    id2block_.erase(blk_id);
+    label2preds_.erase(blk_id);
+  }
+  registered.clear();
+  block2structured_succs_.clear();
+
+  for (auto& blk : *func) {
+    RegisterBlock(&blk);
+  }
+}
+
 void CFG::RemoveNonExistingEdges(uint32_t blk_id) {
   std::vector<uint32_t> updated_pred_list;
   for (uint32_t id : preds(blk_id)) {
@@ -220,10 +248,7 @@ BasicBlock* CFG::SplitLoopHeader(BasicBlock* bb) {
 
   // Create the new header bb basic bb.
   // Leave the phi instructions behind.
-  auto iter = bb->begin();
-  while (iter->opcode() == SpvOpPhi) {
-    ++iter;
-  }
+  auto iter = bb->GetFirstNonPhi();
 
   BasicBlock* new_header = bb->SplitBasicBlock(context, new_header_id, iter);
   context->AnalyzeDefUse(new_header->GetLabelInst());
@@ -295,7 +320,19 @@ BasicBlock* CFG::SplitLoopHeader(BasicBlock* bb) {
   context->set_instr_block(bb->terminator(), bb);
   label2preds_[new_header->id()].push_back(bb->id());
 
+  // Keep the dominator trees that have been built up to date, one change to
+  // the control flow at a time.
+  context->UpdateDominatorAnalyses(
+      fn, [bb, new_header](DominatorAnalysisBase* analysis) {
+        analysis->SplitBlock(bb, new_header);
+      });
+
   // Update the latch to branch to the new header.
+  label2preds_[new_header->id()].push_back(latch_block->id());
+  context->UpdateDominatorAnalyses(
+      fn, [this, fn, latch_block, new_header](DominatorAnalysisBase* analysis) {
+        analysis->InsertEdge(*this, fn, latch_block, new_header);
+      });
   latch_block->ForEachSuccessorLabel([bb, new_header_id](uint32_t* id) {
     if (*id == bb->id()) {
       *id = new_header_id;
@@ -303,13 +340,16 @@ BasicBlock* CFG::SplitLoopHeader(BasicBlock* bb) {
   });
   Instruction* latch_branch = latch_block->terminator();
   context->AnalyzeUses(latch_branch);
-  label2preds_[new_header->id()].push_back(latch_block->id());
 
   auto& block_preds = label2preds_[bb->id()];
   auto latch_pos =
       std::find(block_preds.begin(), block_preds.end(), latch_block->id());
   assert(latch_pos != block_preds.end() && "The cfg was invalid.");
   block_preds.erase(latch_pos);
+  context->UpdateDominatorAnalyses(
+      fn, [this, fn, bb, latch_block](DominatorAnalysisBase* analysis) {
+        analysis->DeleteEdge(*this, fn, latch_block, bb);
+      });
 
   // Update the loop descriptors
   if (context->AreAnalysesValid(IRContext::kAnalysisLoopAnalysis)) {
@@ -334,5 +374,18 @@ BasicBlock* CFG::SplitLoopHeader(BasicBlock* bb) {
   return new_header;
 }
 
+size_t CFG::MemoryUsage() const {
+  size_t bytes =
+      utils::MemoryUsage(label2preds_) + utils::MemoryUsage(id2block_) +
+      utils::MemoryUsage(function_blocks_);
+  for (const auto& preds : label2preds_) {
+    bytes += utils::MemoryUsage(preds.second);
+  }
+  for (const auto& blocks : function_blocks_) {
+    bytes += utils::MemoryUsage(blocks.second);
+  }
+  return bytes;
+}
+
 }  // namespace opt
 }  // namespace spvtools
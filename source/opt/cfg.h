@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "source/opt/basic_block.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -91,9 +92,20 @@ class CFG {
            "Basic blocks must have a terminator before registering.");
     uint32_t blk_id = blk->id();
     id2block_[blk_id] = blk;
+    if (blk->GetParent()) function_blocks_[blk->GetParent()].insert(blk_id);
     AddEdges(blk);
   }
 
+  // Returns true if the block with id |blk_id| is in the CFG.
+  bool HasBlock(uint32_t blk_id) const { return id2block_.count(blk_id) != 0; }
+
+  // Recomputes the predecessors of all of the blocks in |func|, registers any
+  // blocks that are new, and forgets the blocks registered for |func| that
+  // are no longer in it.  The rest of the CFG is not affected, since no edge
+  // crosses a function boundary.  Every block in |func| must have a
+  // terminator.
+  void RebuildFunction(Function* func);
+
   // Removes from the CFG any mapping for the basic block id |blk_id|.
   void ForgetBlock(const BasicBlock* blk) {
     id2block_.erase(blk->id());
@@ -136,6 +148,10 @@ class CFG {
   // loop pointer could not be created.
   BasicBlock* SplitLoopHeader(BasicBlock* bb);
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // CFG, not counting the blocks it refers to.
+  size_t MemoryUsage() const;
+
  private:
   // Compute structured successors for function |func|. A block's structured
   // successors are the blocks it branches to together with its declared merge
@@ -169,10 +185,16 @@ class CFG {
   BasicBlock pseudo_exit_block_;
 
   // Map from block's label id to its predecessor blocks ids
-  std::unordered_map<uint32_t, std::vector<uint32_t>> label2preds_;
+  utils::IdMap<std::vector<uint32_t>> label2preds_;
 
   // Map from block's label id to block.
   std::unordered_map<uint32_t, BasicBlock*> id2block_;
+
+  // Map from function to the label ids of the blocks registered for it.  The
+  // blocks removed from a function may have been deleted, so they can only
+  // be found through their ids when the function is rebuilt.
+  std::unordered_map<const Function*, std::unordered_set<uint32_t>>
+      function_blocks_;
 };
 
 }  // namespace opt
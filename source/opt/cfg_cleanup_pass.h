@@ -31,7 +31,7 @@ class CFGCleanupPass : public MemPass {
 
   IRContext::Analysis GetPreservedAnalyses() override {
     return IRContext::kAnalysisDefUse | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisStructuredCFG;
   }
 };
 
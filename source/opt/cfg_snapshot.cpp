@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/cfg_snapshot.h"
+
+#include "source/cfa.h"
+#include "source/opt/function.h"
+
+namespace spvtools {
+namespace opt {
+
+constexpr uint32_t CFGSnapshot::kInvalidIndex;
+
+CFGSnapshot::CFGSnapshot(const Function& f) : num_reachable_(0) {
+  // Number the blocks in function order first.
+  std::vector<BasicBlock*> function_order;
+  std::unordered_map<uint32_t, uint32_t> position;
+  for (const BasicBlock& bb : f) {
+    position[bb.id()] = static_cast<uint32_t>(function_order.size());
+    function_order.push_back(const_cast<BasicBlock*>(&bb));
+  }
+  const uint32_t num_blocks = static_cast<uint32_t>(function_order.size());
+  if (num_blocks == 0) {
+    successor_offsets_.push_back(0);
+    predecessor_offsets_.push_back(0);
+    return;
+  }
+
+  // Decode the terminators once.
+  std::vector<std::vector<uint32_t>> succs(num_blocks);
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    const BasicBlock* bb = function_order[i];
+    bb->ForEachSuccessorLabel([&position, &succs, i](uint32_t id) {
+      const auto it = position.find(id);
+      if (it != position.end()) succs[i].push_back(it->second);
+    });
+  }
+
+  // Renumber the blocks: the reachable ones in reverse post-order, then the
+  // others in function order.
+  std::vector<uint32_t> number(num_blocks, kInvalidIndex);
+  const std::vector<size_t> postorder = CFA<BasicBlock>::Postorder(
+      num_blocks, 0,
+      [&succs](size_t i) -> const std::vector<uint32_t>& { return succs[i]; });
+  uint32_t next = 0;
+  for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+    number[*it] = next++;
+  }
+  num_reachable_ = next;
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    if (number[i] == kInvalidIndex) number[i] = next++;
+  }
+
+  // |order| maps the new numbers back to the function order.
+  std::vector<uint32_t> order(num_blocks);
+  blocks_.resize(num_blocks);
+  index_.reserve(num_blocks);
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    order[number[i]] = i;
+    blocks_[number[i]] = function_order[i];
+    index_[function_order[i]->id()] = number[i];
+  }
+
+  // Lay out the successors by block number.
+  successor_offsets_.reserve(num_blocks + 1);
+  successor_offsets_.push_back(0);
+  for (uint32_t n = 0; n < num_blocks; ++n) {
+    for (uint32_t succ : succs[order[n]]) successors_.push_back(number[succ]);
+    successor_offsets_.push_back(static_cast<uint32_t>(successors_.size()));
+  }
+
+  // Lay out the predecessors by block number, each list in function order.
+  predecessor_offsets_.assign(num_blocks + 1, 0);
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    for (uint32_t succ : succs[i]) ++predecessor_offsets_[number[succ] + 1];
+  }
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    predecessor_offsets_[i + 1] += predecessor_offsets_[i];
+  }
+  predecessors_.resize(successors_.size());
+  std::vector<uint32_t> fill(predecessor_offsets_.begin(),
+                             predecessor_offsets_.end() - 1);
+  for (uint32_t i = 0; i < num_blocks; ++i) {
+    for (uint32_t succ : succs[i]) {
+      predecessors_[fill[number[succ]]++] = number[i];
+    }
+  }
+}
+
+}  // namespace opt
+}  // namespace spvtools
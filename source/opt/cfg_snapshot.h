@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_CFG_SNAPSHOT_H_
+#define SOURCE_OPT_CFG_SNAPSHOT_H_
+
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/util/span.h"
+
+namespace spvtools {
+namespace opt {
+
+class Function;
+
+// A snapshot of the control flow graph of a function, laid out for fast
+// traversals.  The blocks are numbered densely: the blocks reachable from the
+// entry come first, in reverse post-order, followed by the unreachable blocks
+// in function order.  The successors and predecessors of all the blocks are
+// stored in two flat arrays, so walking the graph neither decodes terminators
+// nor looks up ids.
+//
+// The snapshot is not updated when the function changes: it must be rebuilt
+// after any change to the control flow.
+class CFGSnapshot {
+ public:
+  // The number returned for a block that is not in the snapshot.
+  static constexpr uint32_t kInvalidIndex =
+      std::numeric_limits<uint32_t>::max();
+
+  explicit CFGSnapshot(const Function& f);
+
+  // Returns the number of blocks of the function.
+  uint32_t size() const { return static_cast<uint32_t>(blocks_.size()); }
+
+  // Returns the number of blocks reachable from the entry.  These are the
+  // blocks numbered from 0 to num_reachable() - 1.
+  uint32_t num_reachable() const { return num_reachable_; }
+
+  // Returns true if the block numbered |index| is reachable from the entry.
+  bool IsReachable(uint32_t index) const { return index < num_reachable_; }
+
+  // Returns the block numbered |index|.
+  BasicBlock* block(uint32_t index) const { return blocks_[index]; }
+
+  // Returns the number of the block with the label |id|, or |kInvalidIndex|
+  // if the function has no such block.
+  uint32_t index(uint32_t id) const {
+    const auto it = index_.find(id);
+    return it == index_.end() ? kInvalidIndex : it->second;
+  }
+
+  // Returns the blocks reachable from the entry, in reverse post-order.
+  utils::Span<BasicBlock* const> ReversePostOrder() const {
+    return {blocks_.data(), num_reachable_};
+  }
+
+  // Returns the numbers of the successors of the block numbered |index|, in
+  // the order of its terminator.
+  utils::Span<const uint32_t> successors(uint32_t index) const {
+    return {successors_.data() + successor_offsets_[index],
+            successor_offsets_[index + 1] - successor_offsets_[index]};
+  }
+
+  // Returns the numbers of the predecessors of the block numbered |index|, in
+  // function order.
+  utils::Span<const uint32_t> predecessors(uint32_t index) const {
+    return {predecessors_.data() + predecessor_offsets_[index],
+            predecessor_offsets_[index + 1] - predecessor_offsets_[index]};
+  }
+
+ private:
+  // The blocks, by number.
+  std::vector<BasicBlock*> blocks_;
+  // The number of each block label.
+  std::unordered_map<uint32_t, uint32_t> index_;
+  uint32_t num_reachable_;
+  // The successors of block |i| are
+  // successors_[successor_offsets_[i]..successor_offsets_[i + 1]), and
+  // likewise for the predecessors.
+  std::vector<uint32_t> successor_offsets_;
+  std::vector<uint32_t> successors_;
+  std::vector<uint32_t> predecessor_offsets_;
+  std::vector<uint32_t> predecessors_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_CFG_SNAPSHOT_H_
@@ -26,6 +26,9 @@ namespace spvtools {
 namespace opt {
 
 Pass::Status CodeSinkingPass::Process() {
+  checked_for_uniform_sync_ = false;
+  has_possible_store_.clear();
+
   bool modified = false;
   for (Function& function : *get_module()) {
     cfg()->ForEachBlockInPostOrder(function.entry().get(),
@@ -39,10 +42,17 @@ Pass::Status CodeSinkingPass::Process() {
 }
 
 bool CodeSinkingPass::SinkInstructionsInBB(BasicBlock* bb) {
-  bool modified = false;
+  // Visit the instructions from last to first, so that the users of an
+  // instruction in |bb| have already been sunk when it is visited. Moving an
+  // instruction invalidates the iterators, so take a copy first.
+  std::vector<Instruction*> insts;
   for (auto inst = bb->rbegin(); inst != bb->rend(); ++inst) {
-    if (SinkInstruction(&*inst)) {
-      inst = bb->rbegin();
+    insts.push_back(&*inst);
+  }
+
+  bool modified = false;
+  for (Instruction* inst : insts) {
+    if (SinkInstruction(inst)) {
       modified = true;
     }
   }
@@ -59,10 +69,7 @@ bool CodeSinkingPass::SinkInstruction(Instruction* inst) {
   }
 
   if (BasicBlock* target_bb = FindNewBasicBlockFor(inst)) {
-    Instruction* pos = &*target_bb->begin();
-    while (pos->opcode() == SpvOpPhi) {
-      pos = pos->NextNode();
-    }
+    Instruction* pos = &*target_bb->GetFirstNonPhi();
 
     inst->InsertBefore(pos);
     context()->set_instr_block(inst, target_bb);
@@ -273,17 +280,25 @@ bool CodeSinkingPass::HasPossibleStore(Instruction* var_inst) {
          var_inst->opcode() == SpvOpAccessChain ||
          var_inst->opcode() == SpvOpPtrAccessChain);
 
-  return get_def_use_mgr()->WhileEachUser(var_inst, [this](Instruction* use) {
-    switch (use->opcode()) {
-      case SpvOpStore:
-        return true;
-      case SpvOpAccessChain:
-      case SpvOpPtrAccessChain:
-        return HasPossibleStore(use);
-      default:
-        return false;
-    }
-  });
+  auto cached = has_possible_store_.find(var_inst->result_id());
+  if (cached != has_possible_store_.end()) {
+    return cached->second;
+  }
+
+  bool has_store =
+      get_def_use_mgr()->WhileEachUser(var_inst, [this](Instruction* use) {
+        switch (use->opcode()) {
+          case SpvOpStore:
+            return true;
+          case SpvOpAccessChain:
+          case SpvOpPtrAccessChain:
+            return HasPossibleStore(use);
+          default:
+            return false;
+        }
+      });
+  has_possible_store_[var_inst->result_id()] = has_store;
+  return has_store;
 }
 
 bool CodeSinkingPass::IntersectsPath(uint32_t start, uint32_t end,
@@ -99,6 +99,11 @@ class CodeSinkingPass : public Pass {
   // Cache of whether or not the module has a memory sync on uniform storage.
   // only valid if |check_for_uniform_sync_| is true.
   bool has_uniform_sync_;
+
+  // Cache of the results of |HasPossibleStore|, indexed by the id of the
+  // variable or access chain.  Code sinking does not move stores, so the
+  // entries stay valid while the pass runs.
+  std::unordered_map<uint32_t, bool> has_possible_store_;
 };
 
 }  // namespace opt
@@ -15,7 +15,7 @@
 #include "source/opt/compact_ids_pass.h"
 
 #include <cassert>
-#include <unordered_map>
+#include <vector>
 
 #include "source/opt/ir_context.h"
 
@@ -23,36 +23,50 @@ namespace spvtools {
 namespace opt {
 namespace {
 
-// Returns the remapped id of |id| from |result_id_mapping|. If the remapped
-// id does not exist, adds a new one to |result_id_mapping| and returns it.
-uint32_t GetRemappedId(
-    std::unordered_map<uint32_t, uint32_t>* result_id_mapping, uint32_t id) {
-  auto it = result_id_mapping->find(id);
-  if (it == result_id_mapping->end()) {
-    const uint32_t new_id =
-        static_cast<uint32_t>(result_id_mapping->size()) + 1;
-    const auto insertion_result = result_id_mapping->emplace(id, new_id);
-    it = insertion_result.first;
-    assert(insertion_result.second);
+// Returns the remapped id of |id| from |result_id_mapping|, which is indexed
+// by id and holds 0 for ids that have not been remapped yet. If the remapped
+// id does not exist, assigns |*num_ids| + 1 to it, increments |*num_ids| and
+// returns the new id.
+uint32_t GetRemappedId(std::vector<uint32_t>* result_id_mapping,
+                       uint32_t* num_ids, uint32_t id) {
+  if (id >= result_id_mapping->size()) {
+    // Ids should be below the id bound, but are remapped all the same.
+    result_id_mapping->resize(id + 1, 0);
   }
-  return it->second;
+  uint32_t& new_id = (*result_id_mapping)[id];
+  if (new_id == 0) {
+    new_id = ++*num_ids;
+  }
+  return new_id;
 }
 
 }  // namespace
 
 Pass::Status CompactIdsPass::Process() {
   bool modified = false;
-  std::unordered_map<uint32_t, uint32_t> result_id_mapping;
+  // Ids are dense enough that a table indexed by id beats a hash map.
+  std::vector<uint32_t> result_id_mapping(context()->module()->IdBound(), 0);
+  uint32_t num_ids = 0;
+
+  if (in_definition_order_) {
+    context()->module()->ForEachInst(
+        [&result_id_mapping, &num_ids](Instruction* inst) {
+          if (inst->HasResultId()) {
+            GetRemappedId(&result_id_mapping, &num_ids, inst->result_id());
+          }
+        },
+        true);
+  }
 
   context()->module()->ForEachInst(
-      [&result_id_mapping, &modified](Instruction* inst) {
+      [&result_id_mapping, &num_ids, &modified](Instruction* inst) {
         auto operand = inst->begin();
         while (operand != inst->end()) {
           const auto type = operand->type;
           if (spvIsIdType(type)) {
             assert(operand->words.size() == 1);
             uint32_t& id = operand->words[0];
-            uint32_t new_id = GetRemappedId(&result_id_mapping, id);
+            uint32_t new_id = GetRemappedId(&result_id_mapping, &num_ids, id);
             if (id != new_id) {
               modified = true;
               id = new_id;
@@ -69,7 +83,8 @@ Pass::Status CompactIdsPass::Process() {
 
         uint32_t scope_id = inst->GetDebugScope().GetLexicalScope();
         if (scope_id != kNoDebugScope) {
-          uint32_t new_id = GetRemappedId(&result_id_mapping, scope_id);
+          uint32_t new_id =
+              GetRemappedId(&result_id_mapping, &num_ids, scope_id);
           if (scope_id != new_id) {
             inst->UpdateLexicalScope(new_id);
             modified = true;
@@ -77,7 +92,8 @@ Pass::Status CompactIdsPass::Process() {
         }
         uint32_t inlinedat_id = inst->GetDebugInlinedAt();
         if (inlinedat_id != kNoInlinedAt) {
-          uint32_t new_id = GetRemappedId(&result_id_mapping, inlinedat_id);
+          uint32_t new_id =
+              GetRemappedId(&result_id_mapping, &num_ids, inlinedat_id);
           if (inlinedat_id != new_id) {
             inst->UpdateDebugInlinedAt(new_id);
             modified = true;
@@ -86,9 +102,7 @@ Pass::Status CompactIdsPass::Process() {
       },
       true);
 
-  if (modified)
-    context()->module()->SetIdBound(
-        static_cast<uint32_t>(result_id_mapping.size() + 1));
+  if (modified) context()->module()->SetIdBound(num_ids + 1);
 
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
 }
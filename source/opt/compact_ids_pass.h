@@ -25,6 +25,13 @@ namespace opt {
 // See optimizer.hpp for documentation.
 class CompactIdsPass : public Pass {
  public:
+  // If |in_definition_order| is true, the result ids are numbered in the order
+  // of their definitions, rather than in the order in which they first appear
+  // in the module, so that the ids used before their definition, such as those
+  // of the entry points, do not come first.
+  explicit CompactIdsPass(bool in_definition_order = false)
+      : in_definition_order_(in_definition_order) {}
+
   const char* name() const override { return "compact-ids"; }
   Status Process() override;
 
@@ -34,6 +41,9 @@ class CompactIdsPass : public Pass {
            IRContext::kAnalysisDominatorAnalysis |
            IRContext::kAnalysisLoopAnalysis;
   }
+
+ private:
+  const bool in_definition_order_;
 };
 
 }  // namespace opt
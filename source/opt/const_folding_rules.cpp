@@ -1201,52 +1201,52 @@ void ConstantFoldingRules::AddFoldingRules() {
   uint32_t ext_inst_glslstd450_id =
       feature_manager->GetExtInstImportId_GLSLstd450();
   if (ext_inst_glslstd450_id != 0) {
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FMix}].push_back(FoldFMix());
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450SMin}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FMix].push_back(FoldFMix());
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450SMin].push_back(
         FoldFPBinaryOp(FoldMin));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450UMin}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450UMin].push_back(
         FoldFPBinaryOp(FoldMin));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FMin}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FMin].push_back(
         FoldFPBinaryOp(FoldMin));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450SMax}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450SMax].push_back(
         FoldFPBinaryOp(FoldMax));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450UMax}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450UMax].push_back(
         FoldFPBinaryOp(FoldMax));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FMax}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FMax].push_back(
         FoldFPBinaryOp(FoldMax));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450UClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450UClamp].push_back(
         FoldClamp1);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450UClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450UClamp].push_back(
         FoldClamp2);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450UClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450UClamp].push_back(
         FoldClamp3);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450SClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450SClamp].push_back(
         FoldClamp1);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450SClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450SClamp].push_back(
         FoldClamp2);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450SClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450SClamp].push_back(
         FoldClamp3);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FClamp].push_back(
         FoldClamp1);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FClamp].push_back(
         FoldClamp2);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FClamp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FClamp].push_back(
         FoldClamp3);
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Sin}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Sin].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::sin)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Cos}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Cos].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::cos)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Tan}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Tan].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::tan)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Asin}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Asin].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::asin)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Acos}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Acos].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::acos)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Atan}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Atan].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::atan)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Exp}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Exp].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::exp)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Log}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Log].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::log)));
 
 #ifdef __ANDROID__
@@ -1254,22 +1254,22 @@ void ConstantFoldingRules::AddFoldingRules() {
     // (no std::exp2/log2). ::exp2 is available from C99 but ::log2 isn't
     // available up until ABI 18 so we use a shim
     auto log2_shim = [](double v) -> double { return log(v) / log(2.0); };
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Exp2}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Exp2].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(::exp2)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Log2}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Log2].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(log2_shim)));
 #else
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Exp2}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Exp2].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::exp2)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Log2}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Log2].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::log2)));
 #endif
 
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Sqrt}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Sqrt].push_back(
         FoldFPUnaryOp(FoldFTranscendentalUnary(std::sqrt)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Atan2}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Atan2].push_back(
         FoldFPBinaryOp(FoldFTranscendentalBinary(std::atan2)));
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450Pow}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450Pow].push_back(
         FoldFPBinaryOp(FoldFTranscendentalBinary(std::pow)));
   }
 }
@@ -15,10 +15,10 @@
 #ifndef SOURCE_OPT_CONST_FOLDING_RULES_H_
 #define SOURCE_OPT_CONST_FOLDING_RULES_H_
 
-#include <unordered_map>
 #include <vector>
 
 #include "source/opt/constants.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -54,23 +54,8 @@ using ConstantFoldingRule = std::function<const analysis::Constant*(
 
 class ConstantFoldingRules {
  protected:
-  // The |Key| and |Value| structs are used to by-pass a "decorated name length
-  // exceeded, name was truncated" warning on VS2013 and VS2015.
-  struct Key {
-    uint32_t instruction_set;
-    uint32_t opcode;
-  };
-
-  friend bool operator<(const Key& a, const Key& b) {
-    if (a.instruction_set < b.instruction_set) {
-      return true;
-    }
-    if (a.instruction_set > b.instruction_set) {
-      return false;
-    }
-    return a.opcode < b.opcode;
-  }
-
+  // The |Value| struct is used to by-pass a "decorated name length exceeded,
+  // name was truncated" warning on VS2013 and VS2015.
   struct Value {
     std::vector<ConstantFoldingRule> value;
     void push_back(ConstantFoldingRule rule) { value.push_back(rule); }
@@ -94,11 +79,12 @@ class ConstantFoldingRules {
         return it->second.value;
       }
     } else {
-      uint32_t ext_inst_id = inst->GetSingleWordInOperand(0);
-      uint32_t ext_opcode = inst->GetSingleWordInOperand(1);
-      auto it = ext_rules_.find({ext_inst_id, ext_opcode});
-      if (it != ext_rules_.end()) {
-        return it->second.value;
+      auto set_it = ext_rules_.find(inst->GetSingleWordInOperand(0));
+      if (set_it != ext_rules_.end()) {
+        auto it = set_it->second.find(inst->GetSingleWordInOperand(1));
+        if (it != set_it->second.end()) {
+          return it->second.value;
+        }
       }
     }
     return empty_vector_;
@@ -110,10 +96,11 @@ class ConstantFoldingRules {
  protected:
   // |rules[opcode]| is the set of rules that can be applied to instructions
   // with |opcode| as the opcode.
-  std::unordered_map<uint32_t, Value> rules_;
+  utils::IdMap<Value> rules_;
 
-  // The folding rules for extended instructions.
-  std::map<Key, Value> ext_rules_;
+  // |ext_rules_[set][opcode]| is the set of rules that can be applied to the
+  // extended instructions |opcode| of the instruction set imported as |set|.
+  utils::IdMap<utils::IdMap<Value>> ext_rules_;
 
  private:
   // The context that the instruction to be folded will be a part of.
@@ -14,15 +14,50 @@
 
 #include "source/opt/constants.h"
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
 namespace analysis {
 
+namespace {
+
+void AddPointerToHash(std::u32string* h, const void* p) {
+  uint64_t ptr_val = reinterpret_cast<uint64_t>(p);
+  h->push_back(static_cast<uint32_t>(ptr_val >> 32));
+  h->push_back(static_cast<uint32_t>(ptr_val));
+}
+
+}  // namespace
+
+size_t Constant::ComputeHashValue() const {
+  std::u32string h;
+  AddPointerToHash(&h, type());
+  if (const auto scalar = AsScalarConstant()) {
+    for (const auto& w : scalar->words()) {
+      h.push_back(w);
+    }
+  } else if (const auto composite = AsCompositeConstant()) {
+    const auto& components = composite->GetComponents();
+    h.reserve(h.size() + 2 * components.size());
+    for (const auto& c : components) {
+      AddPointerToHash(&h, c);
+    }
+  } else if (AsNullConstant()) {
+    h.push_back(0);
+  } else {
+    assert(false &&
+           "Tried to compute the hash value of an invalid Constant instance.");
+  }
+
+  return std::hash<std::u32string>()(h);
+}
+
 float Constant::GetFloat() const {
   assert(type()->AsFloat() != nullptr && type()->AsFloat()->width() == 32);
 
@@ -146,7 +181,14 @@ ConstantManager::ConstantManager(IRContext* ctx) : ctx_(ctx) {
   // Populate the constant table with values from constant declarations in the
   // module.  The values of each OpConstant declaration is the identity
   // assignment (i.e., each constant is its own value).
-  for (const auto& inst : ctx_->module()->GetConstants()) {
+  id_to_const_val_.reserve(ctx_->module()->IdBound());
+  MapInsts(ctx_->module()->GetConstants());
+}
+
+void ConstantManager::MapInsts(const std::vector<Instruction*>& insts) {
+  const_pool_.reserve(const_pool_.size() + insts.size());
+  owned_constants_.reserve(owned_constants_.size() + insts.size());
+  for (Instruction* inst : insts) {
     MapInst(inst);
   }
 }
@@ -423,6 +465,14 @@ std::vector<const analysis::Constant*> Constant::GetVectorComponents(
   return components;
 }
 
+size_t ConstantManager::MemoryUsage() const {
+  return utils::MemoryUsage(id_to_const_val_) +
+         utils::MemoryUsage(const_val_to_id_) +
+         utils::MemoryUsage(const_pool_) +
+         utils::MemoryUsage(owned_constants_) +
+         owned_constants_.size() * sizeof(Constant);
+}
+
 }  // namespace analysis
 }  // namespace opt
 }  // namespace spvtools
@@ -27,6 +27,7 @@
 #include "source/opt/type_manager.h"
 #include "source/opt/types.h"
 #include "source/util/hex_float.h"
+#include "source/util/id_map.h"
 #include "source/util/make_unique.h"
 
 namespace spvtools {
@@ -134,11 +135,32 @@ class Constant {
   std::vector<const Constant*> GetVectorComponents(
       ConstantManager* const_mgr) const;
 
+  // Returns a hash of the type, words and components of this constant.  The
+  // value is computed on the first call and reused afterwards, so a constant
+  // must not be modified once it has been hashed.
+  size_t HashValue() const {
+    if (!has_hash_value_) {
+      hash_value_ = ComputeHashValue();
+      has_hash_value_ = true;
+    }
+    return hash_value_;
+  }
+
  protected:
-  Constant(const Type* ty) : type_(ty) {}
+  Constant(const Type* ty)
+      : type_(ty), hash_value_(0), has_hash_value_(false) {}
 
   // The type of this constant.
   const Type* type_;
+
+ private:
+  // Returns the structural hash of this constant.  Components of composite
+  // constants are hashed by address, since they are owned by the pool.
+  size_t ComputeHashValue() const;
+
+  // The cached result of |ComputeHashValue|, valid if |has_hash_value_|.
+  mutable size_t hash_value_;
+  mutable bool has_hash_value_;
 };
 
 // Abstract class for scalar type constants.
@@ -446,32 +468,8 @@ class NullConstant : public Constant {
 // Hash function for Constant instances. Use the structure of the constant as
 // the key.
 struct ConstantHash {
-  void add_pointer(std::u32string* h, const void* p) const {
-    uint64_t ptr_val = reinterpret_cast<uint64_t>(p);
-    h->push_back(static_cast<uint32_t>(ptr_val >> 32));
-    h->push_back(static_cast<uint32_t>(ptr_val));
-  }
-
   size_t operator()(const Constant* const_val) const {
-    std::u32string h;
-    add_pointer(&h, const_val->type());
-    if (const auto scalar = const_val->AsScalarConstant()) {
-      for (const auto& w : scalar->words()) {
-        h.push_back(w);
-      }
-    } else if (const auto composite = const_val->AsCompositeConstant()) {
-      for (const auto& c : composite->GetComponents()) {
-        add_pointer(&h, c);
-      }
-    } else if (const_val->AsNullConstant()) {
-      h.push_back(0);
-    } else {
-      assert(
-          false &&
-          "Tried to compute the hash value of an invalid Constant instance.");
-    }
-
-    return std::hash<std::u32string>()(h);
+    return const_val->HashValue();
   }
 };
 
@@ -611,6 +609,11 @@ class ConstantManager {
     return false;
   }
 
+  // Records the constant values of all of |insts| as |MapInst| does.  The
+  // constant pool is grown once for the whole batch, which avoids repeated
+  // rehashing when a module declares many constants.
+  void MapInsts(const std::vector<Instruction*>& insts);
+
   void RemoveId(uint32_t id) {
     auto it = id_to_const_val_.find(id);
     if (it != id_to_const_val_.end()) {
@@ -633,6 +636,11 @@ class ConstantManager {
   // Returns the id of a 32-bit signed integer constant with value |val|.
   uint32_t GetSIntConst(int32_t val);
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // manager, counting each constant at the size
+  // of the |Constant| base class.
+  size_t MemoryUsage() const;
+
  private:
   // Creates a Constant instance with the given type and a vector of constant
   // defining words. Returns a unique pointer to the created Constant instance
@@ -683,7 +691,7 @@ class ConstantManager {
   // Constant instances. All Normal Constants in the module, either
   // existing ones before optimization or the newly generated ones, should have
   // their Constant instance stored and their result id registered in this map.
-  std::unordered_map<uint32_t, const Constant*> id_to_const_val_;
+  utils::IdMap<const Constant*> id_to_const_val_;
 
   // A mapping from the Constant instance of Normal Constants to their
   // result id in the module. This is a mirror map of |id_to_const_val_|. All
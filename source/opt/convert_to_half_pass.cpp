@@ -98,6 +98,18 @@ void ConvertToHalfPass::GenConvert(uint32_t* val_idp, uint32_t width,
   uint32_t ty_id = val_inst->type_id();
   uint32_t nty_id = EquivFloatTypeId(ty_id, width);
   if (nty_id == ty_id) return;
+  // Converting the same value for each of its uses would leave many
+  // identical conversions, so reuse one that dominates |inst|.
+  Instruction*& prev_cvt_inst = converts_[{*val_idp, width}];
+  if (prev_cvt_inst != nullptr) {
+    BasicBlock* bb = context()->get_instr_block(inst);
+    if (context()
+            ->GetDominatorAnalysis(bb->GetParent())
+            ->Dominates(prev_cvt_inst, inst)) {
+      *val_idp = prev_cvt_inst->result_id();
+      return;
+    }
+  }
   Instruction* cvt_inst;
   InstructionBuilder builder(
       context(), inst,
@@ -106,6 +118,7 @@ void ConvertToHalfPass::GenConvert(uint32_t* val_idp, uint32_t width,
     cvt_inst = builder.AddNullaryOp(nty_id, SpvOpUndef);
   else
     cvt_inst = builder.AddUnaryOp(nty_id, SpvOpFConvert, *val_idp);
+  prev_cvt_inst = cvt_inst;
   *val_idp = cvt_inst->result_id();
 }
 
@@ -309,6 +322,7 @@ bool ConvertToHalfPass::CloseRelaxInst(Instruction* inst) {
 }
 
 bool ConvertToHalfPass::ProcessFunction(Function* func) {
+  converts_.clear();
   // Do a closure of Relaxed on composite and phi instructions
   bool changed = true;
   while (changed) {
@@ -465,6 +479,7 @@ void ConvertToHalfPass::Initialize() {
   };
   relaxed_ids_set_.clear();
   converted_ids_.clear();
+  converts_.clear();
 }
 
 }  // namespace opt
@@ -16,6 +16,9 @@
 #ifndef LIBSPIRV_OPT_CONVERT_TO_HALF_PASS_H_
 #define LIBSPIRV_OPT_CONVERT_TO_HALF_PASS_H_
 
+#include <map>
+#include <utility>
+
 #include "source/opt/ir_builder.h"
 #include "source/opt/pass.h"
 
@@ -70,7 +73,9 @@ class ConvertToHalfPass : public Pass {
   uint32_t EquivFloatTypeId(uint32_t ty_id, uint32_t width);
 
   // Append instructions to builder to convert value |*val_idp| to type
-  // |ty_id| but with |width|. Set |*val_idp| to the new id.
+  // |ty_id| but with |width|. Set |*val_idp| to the new id. An earlier
+  // conversion of the same value to |width| that dominates |inst| is reused
+  // instead.
   void GenConvert(uint32_t* val_idp, uint32_t width, Instruction* inst);
 
   // Remove RelaxedPrecision decoration of |id|.
@@ -140,6 +145,9 @@ class ConvertToHalfPass : public Pass {
 
   // Ids of all converted instructions
   std::unordered_set<uint32_t> converted_ids_;
+  // Conversions generated in the current function, indexed by the id of the
+  // value converted and the width it is converted to
+  std::map<std::pair<uint32_t, uint32_t>, Instruction*> converts_;
 };
 
 }  // namespace opt
@@ -14,9 +14,11 @@
 
 #include "source/opt/copy_prop_arrays.h"
 
+#include <unordered_set>
 #include <utility>
 
 #include "source/opt/ir_builder.h"
+#include "source/util/make_unique.h"
 
 namespace spvtools {
 namespace opt {
@@ -39,6 +41,7 @@ bool IsOpenCL100DebugDeclareOrValue(Instruction* di) {
 
 Pass::Status CopyPropagateArrays::Process() {
   bool modified = false;
+  ClearCaches();
   for (Function& function : *get_module()) {
     BasicBlock* entry_bb = &*function.begin();
 
@@ -62,6 +65,7 @@ Pass::Status CopyPropagateArrays::Process() {
         if (CanUpdateUses(&*var_inst, source_object->GetPointerTypeId(this))) {
           modified = true;
           PropagateObject(&*var_inst, source_object.get(), store_inst);
+          ClearCaches();
         }
       }
     }
@@ -153,40 +157,78 @@ Instruction* CopyPropagateArrays::BuildNewAccessChain(
 }
 
 bool CopyPropagateArrays::HasNoStores(Instruction* ptr_inst) {
-  return get_def_use_mgr()->WhileEachUser(ptr_inst, [this](Instruction* use) {
-    if (use->opcode() == SpvOpLoad) {
-      return true;
-    } else if (use->opcode() == SpvOpAccessChain) {
-      return HasNoStores(use);
-    } else if (use->IsDecoration() || use->opcode() == SpvOpName) {
-      return true;
-    } else if (use->opcode() == SpvOpStore) {
-      return false;
-    } else if (use->opcode() == SpvOpImageTexelPointer) {
-      return true;
-    }
-    // Some other instruction.  Be conservative.
-    return false;
-  });
+  auto cached = has_no_stores_.find(ptr_inst->result_id());
+  if (cached != has_no_stores_.end()) return cached->second;
+
+  const bool has_no_stores =
+      get_def_use_mgr()->WhileEachUser(ptr_inst, [this](Instruction* use) {
+        if (use->opcode() == SpvOpLoad) {
+          return true;
+        } else if (use->opcode() == SpvOpAccessChain) {
+          return HasNoStores(use);
+        } else if (use->IsDecoration() || use->opcode() == SpvOpName) {
+          return true;
+        } else if (use->opcode() == SpvOpStore) {
+          return false;
+        } else if (use->opcode() == SpvOpImageTexelPointer) {
+          return true;
+        }
+        // Some other instruction.  Be conservative.
+        return false;
+      });
+  has_no_stores_[ptr_inst->result_id()] = has_no_stores;
+  return has_no_stores;
 }
 
 bool CopyPropagateArrays::HasValidReferencesOnly(Instruction* ptr_inst,
                                                  Instruction* store_inst) {
+  std::vector<Instruction*> loads;
+  if (!FindReferences(ptr_inst, store_inst, &loads)) {
+    return false;
+  }
+
   BasicBlock* store_block = context()->get_instr_block(store_inst);
   DominatorAnalysis* dominator_analysis =
       context()->GetDominatorAnalysis(store_block->GetParent());
 
+  // The loads in the same block as |store_inst| are dominated by it if they
+  // come after it.  The instructions after it are gathered once, instead of
+  // walking the block for each load.
+  std::unordered_set<const Instruction*> after_store;
+  bool found_after_store = false;
+  for (Instruction* load : loads) {
+    BasicBlock* load_block = context()->get_instr_block(load);
+    if (load_block != store_block) {
+      if (!dominator_analysis->Dominates(store_block, load_block)) {
+        return false;
+      }
+      continue;
+    }
+    if (!found_after_store) {
+      for (const Instruction* inst = store_inst->NextNode(); inst != nullptr;
+           inst = inst->NextNode()) {
+        after_store.insert(inst);
+      }
+      found_after_store = true;
+    }
+    if (after_store.count(load) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CopyPropagateArrays::FindReferences(Instruction* ptr_inst,
+                                         Instruction* store_inst,
+                                         std::vector<Instruction*>* loads) {
   return get_def_use_mgr()->WhileEachUser(
-      ptr_inst,
-      [this, store_inst, dominator_analysis, ptr_inst](Instruction* use) {
+      ptr_inst, [this, store_inst, ptr_inst, loads](Instruction* use) {
         if (use->opcode() == SpvOpLoad ||
             use->opcode() == SpvOpImageTexelPointer) {
-          // TODO: If there are many load in the same BB as |store_inst| the
-          // time to do the multiple traverses can add up.  Consider collecting
-          // those loads and doing a single traversal.
-          return dominator_analysis->Dominates(store_inst, use);
+          loads->push_back(use);
+          return true;
         } else if (use->opcode() == SpvOpAccessChain) {
-          return HasValidReferencesOnly(use, store_inst);
+          return FindReferences(use, store_inst, loads);
         } else if (use->IsDecoration() || use->opcode() == SpvOpName) {
           return true;
         } else if (use->opcode() == SpvOpStore) {
@@ -204,6 +246,22 @@ bool CopyPropagateArrays::HasValidReferencesOnly(Instruction* ptr_inst,
 
 std::unique_ptr<CopyPropagateArrays::MemoryObject>
 CopyPropagateArrays::GetSourceObjectIfAny(uint32_t result) {
+  auto cached = source_objects_.find(result);
+  if (cached != source_objects_.end()) {
+    if (!cached->second) return nullptr;
+    return MakeUnique<MemoryObject>(*cached->second);
+  }
+
+  // The caller may change the memory object it gets, so the cache keeps its
+  // own copy.
+  std::unique_ptr<MemoryObject> source = BuildSourceObject(result);
+  std::unique_ptr<MemoryObject>& entry = source_objects_[result];
+  if (source) entry = MakeUnique<MemoryObject>(*source);
+  return source;
+}
+
+std::unique_ptr<CopyPropagateArrays::MemoryObject>
+CopyPropagateArrays::BuildSourceObject(uint32_t result) {
   Instruction* result_inst = context()->get_def_use_mgr()->GetDef(result);
 
   switch (result_inst->opcode()) {
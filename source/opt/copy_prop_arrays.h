@@ -16,6 +16,7 @@
 #define SOURCE_OPT_COPY_PROP_ARRAYS_H_
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "source/opt/mem_pass.h"
@@ -159,10 +160,21 @@ class CopyPropagateArrays : public MemPass {
   // are dominated by |store_inst|.
   bool HasValidReferencesOnly(Instruction* ptr_inst, Instruction* store_inst);
 
+  // Returns true if all of the references to |ptr_inst| can be rewritten,
+  // ignoring where they are.  The references that must be dominated by
+  // |store_inst|, directly or through access chains, are added to |loads|.
+  bool FindReferences(Instruction* ptr_inst, Instruction* store_inst,
+                      std::vector<Instruction*>* loads);
+
   // Returns a memory object that at one time was equivalent to the value in
   // |result|.  If no such memory object exists, the return value is |nullptr|.
+  // The result is memoized in |source_objects_|.
   std::unique_ptr<MemoryObject> GetSourceObjectIfAny(uint32_t result);
 
+  // Returns the memory object of |result| that GetSourceObjectIfAny returns,
+  // without looking at |source_objects_| for |result| itself.
+  std::unique_ptr<MemoryObject> BuildSourceObject(uint32_t result);
+
   // Returns the memory object that is loaded by |load_inst|.  If a memory
   // object cannot be identified, the return value is |nullptr|.  The opcode of
   // |load_inst| must be |OpLoad|.
@@ -196,9 +208,16 @@ class CopyPropagateArrays : public MemPass {
   bool IsPointerToArrayType(uint32_t type_id);
 
   // Returns true of there are not stores using |ptr_inst| or something derived
-  // from it.
+  // from it.  The result is memoized in |has_no_stores_|.
   bool HasNoStores(Instruction* ptr_inst);
 
+  // Forgets the memoized results of GetSourceObjectIfAny and HasNoStores.
+  // They must be forgotten whenever the uses of a variable are rewritten.
+  void ClearCaches() {
+    source_objects_.clear();
+    has_no_stores_.clear();
+  }
+
   // Creates an |OpAccessChain| instruction whose result is a pointer the memory
   // represented by |source|.  The new instruction will be placed before
   // |insertion_point|.  |insertion_point| must be part of a function.  Returns
@@ -227,6 +246,15 @@ class CopyPropagateArrays : public MemPass {
   // same way the indexes are used in an |OpCompositeExtract| instruction.
   uint32_t GetMemberTypeId(uint32_t id,
                            const std::vector<uint32_t>& access_chain) const;
+
+  // The memory object of each result id for which GetSourceObjectIfAny was
+  // called, or |nullptr| if it has none.  The same values are looked at for
+  // several variables, e.g. when a loaded array is stored to several function
+  // variables.
+  std::unordered_map<uint32_t, std::unique_ptr<MemoryObject>> source_objects_;
+
+  // Whether HasNoStores is true for each pointer id for which it was called.
+  std::unordered_map<uint32_t, bool> has_no_stores_;
 };
 
 }  // namespace opt
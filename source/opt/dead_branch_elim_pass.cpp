@@ -484,7 +484,14 @@ Pass::Status DeadBranchElimPass::Process() {
     if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
   // Process all entry point functions
   ProcessFunction pfn = [this](Function* fp) {
-    return EliminateDeadBranches(fp);
+    if (!EliminateDeadBranches(fp)) return false;
+    // Only the control flow of |fp| has changed, so the CFG, dominator and
+    // loop analyses of the other functions are still valid.
+    context()->InvalidateAnalyses(IRContext::kAnalysisCFG |
+                                      IRContext::kAnalysisDominatorAnalysis |
+                                      IRContext::kAnalysisLoopAnalysis,
+                                  fp);
+    return true;
   };
   bool modified = context()->ProcessReachableCallTree(pfn);
   if (modified) FixBlockOrder();
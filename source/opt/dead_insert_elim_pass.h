@@ -46,7 +46,8 @@ class DeadInsertElimPass : public MemPass {
            IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
            IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
            IRContext::kAnalysisNameMap | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisReflection |
+           IRContext::kAnalysisCallGraph;
   }
 
  private:
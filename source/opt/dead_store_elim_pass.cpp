@@ -0,0 +1,237 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/dead_store_elim_pass.h"
+
+#include <unordered_map>
+
+#include "source/opcode.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kLoadPointerInIdx = 0;
+const uint32_t kLoadMemoryAccessInIdx = 1;
+const uint32_t kStorePointerInIdx = 0;
+const uint32_t kStoreObjectInIdx = 1;
+const uint32_t kStoreMemoryAccessInIdx = 2;
+const uint32_t kCopyMemorySourceInIdx = 1;
+const uint32_t kVariableInitializerInIdx = 1;
+const uint32_t kAtomicPointerInIdx = 0;
+
+}  // namespace
+
+bool DeadStoreElimPass::IsCandidateStorageClass(uint32_t storage_class) {
+  switch (storage_class) {
+    case SpvStorageClassFunction:
+    case SpvStorageClassPrivate:
+    case SpvStorageClassWorkgroup:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool DeadStoreElimPass::IsVolatile(const Instruction& inst) {
+  uint32_t mask_idx = inst.opcode() == SpvOpLoad ? kLoadMemoryAccessInIdx
+                                                 : kStoreMemoryAccessInIdx;
+  if (inst.NumInOperands() <= mask_idx) return false;
+  return (inst.GetSingleWordInOperand(mask_idx) &
+          SpvMemoryAccessVolatileMask) != 0;
+}
+
+bool DeadStoreElimPass::MayRead(const MemorySSA& memory_ssa,
+                                const MemoryAccess& access,
+                                uint32_t ptr_id) const {
+  if (access.IsPhi() || access.IsLiveOnEntry()) return true;
+
+  const Instruction* inst = access.inst();
+  switch (inst->opcode()) {
+    case SpvOpStore:
+    case SpvOpVariable:
+      return false;
+    case SpvOpLoad:
+      return memory_ssa.MayAlias(
+          inst->GetSingleWordInOperand(kLoadPointerInIdx), ptr_id);
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized:
+      return memory_ssa.MayAlias(
+          inst->GetSingleWordInOperand(kCopyMemorySourceInIdx), ptr_id);
+    default:
+      if (spvOpcodeIsAtomicOp(inst->opcode())) {
+        return memory_ssa.MayAlias(
+            inst->GetSingleWordInOperand(kAtomicPointerInIdx), ptr_id);
+      }
+      // Calls and barriers.
+      return true;
+  }
+}
+
+uint32_t DeadStoreElimPass::GetStoredValue(const MemorySSA& memory_ssa,
+                                           const MemoryAccess& def,
+                                           uint32_t ptr_id) const {
+  if (!def.IsDef() || def.IsLiveOnEntry()) return 0;
+
+  const Instruction* inst = def.inst();
+  if (inst->opcode() == SpvOpStore && !IsVolatile(*inst) &&
+      memory_ssa.MustAlias(inst->GetSingleWordInOperand(kStorePointerInIdx),
+                           ptr_id)) {
+    return inst->GetSingleWordInOperand(kStoreObjectInIdx);
+  }
+  if (inst->opcode() == SpvOpVariable &&
+      memory_ssa.MustAlias(inst->result_id(), ptr_id)) {
+    return inst->GetSingleWordInOperand(kVariableInitializerInIdx);
+  }
+  return 0;
+}
+
+void DeadStoreElimPass::FindForwardedLoads(
+    Function* func, const MemorySSA& memory_ssa,
+    std::vector<std::pair<Instruction*, uint32_t>>* forwarded) const {
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(func);
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+
+  // The loads that are kept, by the access that clobbers them.  The dominator
+  // tree order makes sure a load is visited after the loads dominating it.
+  std::unordered_map<const MemoryAccess*, std::vector<Instruction*>> loads;
+  for (DominatorTreeNode& node : dom->GetDomTree()) {
+    for (Instruction& inst : *node.bb_) {
+      if (inst.opcode() != SpvOpLoad || IsVolatile(inst)) continue;
+      MemoryAccess* use = memory_ssa.GetAccess(&inst);
+      if (use == nullptr || !IsCandidateStorageClass(use->storage_class())) {
+        continue;
+      }
+
+      uint32_t ptr_id = inst.GetSingleWordInOperand(kLoadPointerInIdx);
+      MemoryAccess* clobber = memory_ssa.GetClobberingAccess(use);
+      std::vector<Instruction*>& clobbered_loads = loads[clobber];
+      uint32_t value = GetStoredValue(memory_ssa, *clobber, ptr_id);
+      if (value == 0) {
+        // Nothing between the clobbering access and |inst| writes the memory,
+        // so a dominating load of it after that access reads the same value.
+        for (Instruction* load : clobbered_loads) {
+          if (memory_ssa.MustAlias(
+                  load->GetSingleWordInOperand(kLoadPointerInIdx), ptr_id) &&
+              dom->Dominates(load, &inst)) {
+            value = load->result_id();
+            break;
+          }
+        }
+      }
+
+      if (value != 0 &&
+          def_use_mgr->GetDef(value)->type_id() == inst.type_id()) {
+        forwarded->emplace_back(&inst, value);
+      } else {
+        clobbered_loads.push_back(&inst);
+      }
+    }
+  }
+}
+
+bool DeadStoreElimPass::IsOverwritten(const MemorySSA& memory_ssa,
+                                      const MemoryAccess& def) const {
+  uint32_t ptr_id = def.inst()->GetSingleWordInOperand(kStorePointerInIdx);
+  std::vector<uint32_t> indices;
+  const Instruction* base = memory_ssa.GetBase(ptr_id, &indices);
+  bool is_local = def.storage_class() == SpvStorageClassFunction &&
+                  base->opcode() == SpvOpVariable;
+
+  // Follows the chain of defs as long as there is a single one after
+  // |current|, and nothing may read the memory in between.  Any join in the
+  // control flow shows up as a phi.
+  const MemoryAccess* current = &def;
+  while (true) {
+    const MemoryAccess* next = nullptr;
+    for (const MemoryAccess* user : current->users()) {
+      if (user->IsPhi()) return false;
+      if (user->IsUse()) {
+        if (MayRead(memory_ssa, *user, ptr_id)) return false;
+        continue;
+      }
+      if (next != nullptr) return false;
+      next = user;
+    }
+
+    // The memory is not accessed again until the function returns.
+    if (next == nullptr) return is_local;
+
+    if (MayRead(memory_ssa, *next, ptr_id)) return false;
+    const Instruction* next_inst = next->inst();
+    if (next_inst->opcode() == SpvOpStore && !IsVolatile(*next_inst) &&
+        memory_ssa.MustAlias(
+            next_inst->GetSingleWordInOperand(kStorePointerInIdx), ptr_id)) {
+      return true;
+    }
+    if (memory_ssa.MayClobber(next, ptr_id)) return false;
+    current = next;
+  }
+}
+
+bool DeadStoreElimPass::ProcessFunction(Function* func) {
+  MemorySSA* memory_ssa = context()->GetMemorySSA(func);
+
+  std::vector<std::pair<Instruction*, uint32_t>> forwarded;
+  FindForwardedLoads(func, *memory_ssa, &forwarded);
+
+  std::vector<Instruction*> dead_stores;
+  for (BasicBlock& bb : *func) {
+    for (Instruction& inst : bb) {
+      if (inst.opcode() != SpvOpStore || IsVolatile(inst)) continue;
+      MemoryAccess* def = memory_ssa->GetAccess(&inst);
+      if (def != nullptr && IsCandidateStorageClass(def->storage_class()) &&
+          IsOverwritten(*memory_ssa, *def)) {
+        dead_stores.push_back(&inst);
+      }
+    }
+  }
+
+  if (forwarded.empty() && dead_stores.empty()) return false;
+
+  // The memory SSA form is dropped as soon as an access is killed, so all the
+  // changes are found first.  A forwarded value can be a load that has been
+  // replaced itself.
+  std::unordered_map<uint32_t, uint32_t> replacements;
+  for (auto& load_and_value : forwarded) {
+    Instruction* load = load_and_value.first;
+    uint32_t value = load_and_value.second;
+    for (auto it = replacements.find(value); it != replacements.end();
+         it = replacements.find(value)) {
+      value = it->second;
+    }
+    replacements[load->result_id()] = value;
+    context()->KillNamesAndDecorates(load->result_id());
+    context()->ReplaceAllUsesWith(load->result_id(), value);
+    context()->KillInst(load);
+  }
+  for (Instruction* store : dead_stores) {
+    context()->KillInst(store);
+  }
+  return true;
+}
+
+Pass::Status DeadStoreElimPass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    // Removing loads and stores can make more of them redundant.
+    while (ProcessFunction(&func)) {
+      modified = true;
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
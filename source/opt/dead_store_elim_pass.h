@@ -0,0 +1,83 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
+#define SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/memory_ssa.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class DeadStoreElimPass : public Pass {
+ public:
+  const char* name() const override { return "eliminate-dead-stores"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse | IRContext::kAnalysisCFG |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisDecorations |
+           IRContext::kAnalysisDominatorAnalysis | IRContext::kAnalysisNameMap |
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes |
+           IRContext::kAnalysisReflection | IRContext::kAnalysisCallGraph;
+  }
+
+ private:
+  // Returns true if memory of |storage_class| is handled by the pass.
+  static bool IsCandidateStorageClass(uint32_t storage_class);
+
+  // Returns true if the memory operands of the load or store |inst| make it
+  // volatile.
+  static bool IsVolatile(const Instruction& inst);
+
+  // Returns true if |access| may read the memory pointed to by |ptr_id|.
+  bool MayRead(const MemorySSA& memory_ssa, const MemoryAccess& access,
+               uint32_t ptr_id) const;
+
+  // Returns the id of the value the def |def| is known to write to |ptr_id|,
+  // or 0 if it is not known.
+  uint32_t GetStoredValue(const MemorySSA& memory_ssa, const MemoryAccess& def,
+                          uint32_t ptr_id) const;
+
+  // Adds to |forwarded| the loads of |func| whose value is known, paired with
+  // that value.  The value is either the one of a store, or the result of
+  // another load of the same memory.
+  void FindForwardedLoads(Function* func, const MemorySSA& memory_ssa,
+                          std::vector<std::pair<Instruction*, uint32_t>>*
+                              forwarded) const;
+
+  // Returns true if the memory written by the store |def| is overwritten on
+  // every path before it may be read.  For function scope variables, reaching
+  // the end of the function also counts as overwriting it.
+  bool IsOverwritten(const MemorySSA& memory_ssa,
+                     const MemoryAccess& def) const;
+
+  // Forwards loads and removes dead stores in |func| once.  Returns true if
+  // |func| was changed.
+  bool ProcessFunction(Function* func);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_DEAD_STORE_ELIM_PASS_H_
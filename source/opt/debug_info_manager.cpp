@@ -17,10 +17,10 @@
 #include <cassert>
 
 #include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
 
 // Constants for OpenCL.DebugInfo.100 extension instructions.
 
-static const uint32_t kOpLineOperandLineIndex = 1;
 static const uint32_t kLineOperandIndexDebugFunction = 7;
 static const uint32_t kLineOperandIndexDebugLexicalBlock = 5;
 static const uint32_t kDebugFunctionOperandFunctionIndex = 13;
@@ -77,7 +77,8 @@ bool IsEmptyDebugExpression(Instruction* instr) {
 
 }  // namespace
 
-DebugInfoManager::DebugInfoManager(IRContext* c) : context_(c) {
+DebugInfoManager::DebugInfoManager(IRContext* c)
+    : context_(c), debug_scope_users_analyzed_(false) {
   AnalyzeDebugInsts(*c->module());
 }
 
@@ -126,7 +127,7 @@ void DebugInfoManager::RegisterDbgDeclare(uint32_t var_id,
   }
 }
 
-uint32_t DebugInfoManager::CreateDebugInlinedAt(const Instruction* line,
+uint32_t DebugInfoManager::CreateDebugInlinedAt(const DebugLine* line,
                                                 const DebugScope& scope) {
   if (context()->get_feature_mgr()->GetExtInstImportId_OpenCL100DebugInfo() ==
       0)
@@ -162,7 +163,7 @@ uint32_t DebugInfoManager::CreateDebugInlinedAt(const Instruction* line,
         break;
     }
   } else {
-    line_number = line->GetSingleWordOperand(kOpLineOperandLineIndex);
+    line_number = line->line;
   }
 
   uint32_t result_id = context()->TakeNextId();
@@ -571,6 +572,13 @@ bool DebugInfoManager::IsDebugDeclare(Instruction* instr) {
 void DebugInfoManager::ReplaceAllUsesInDebugScopeWithPredicate(
     uint32_t before, uint32_t after,
     const std::function<bool(Instruction*)>& predicate) {
+  if (!debug_scope_users_analyzed_) {
+    // Only debug instructions can be scopes or inlined-at operands, so there
+    // is nothing to replace, and no reason to build the maps, otherwise.
+    if (GetDbgInst(before) == nullptr) return;
+    AnalyzeDebugScopeUsers();
+  }
+
   auto scope_id_to_users_itr = scope_id_to_users_.find(before);
   if (scope_id_to_users_itr != scope_id_to_users_.end()) {
     for (Instruction* inst : scope_id_to_users_itr->second) {
@@ -601,7 +609,7 @@ void DebugInfoManager::ClearDebugScopeAndInlinedAtUses(Instruction* inst) {
   }
 }
 
-void DebugInfoManager::AnalyzeDebugInst(Instruction* inst) {
+void DebugInfoManager::RegisterDebugScopeUser(Instruction* inst) {
   if (inst->GetDebugScope().GetLexicalScope() != kNoDebugScope) {
     auto& users = scope_id_to_users_[inst->GetDebugScope().GetLexicalScope()];
     users.insert(inst);
@@ -610,6 +618,17 @@ void DebugInfoManager::AnalyzeDebugInst(Instruction* inst) {
     auto& users = inlinedat_id_to_users_[inst->GetDebugInlinedAt()];
     users.insert(inst);
   }
+}
+
+void DebugInfoManager::AnalyzeDebugScopeUsers() {
+  if (debug_scope_users_analyzed_) return;
+  debug_scope_users_analyzed_ = true;
+  context()->module()->ForEachInst(
+      [this](Instruction* inst) { RegisterDebugScopeUser(inst); });
+}
+
+void DebugInfoManager::AnalyzeDebugInst(Instruction* inst) {
+  if (debug_scope_users_analyzed_) RegisterDebugScopeUser(inst);
 
   if (!inst->IsOpenCL100DebugInstr()) return;
 
@@ -703,6 +722,15 @@ void DebugInfoManager::AnalyzeDebugInsts(Module& module) {
   deref_operation_ = nullptr;
   debug_info_none_inst_ = nullptr;
   empty_debug_expr_inst_ = nullptr;
+
+  // Every OpenCL.DebugInfo.100 instruction, including a DebugDeclare or
+  // DebugValue in a function, refers to the debug info section.  With the
+  // section empty, e.g. after debug info was stripped, there is nothing to
+  // analyze.
+  if (module.ext_inst_debuginfo_begin() == module.ext_inst_debuginfo_end()) {
+    return;
+  }
+
   module.ForEachInst([this](Instruction* cpi) { AnalyzeDebugInst(cpi); });
 
   // Move |empty_debug_expr_inst_| to the beginning of the debug instruction
@@ -802,6 +830,19 @@ void DebugInfoManager::ClearDebugInfo(Instruction* instr) {
   }
 }
 
+size_t DebugInfoManager::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(id_to_dbg_inst_) +
+                 utils::MemoryUsage(fn_id_to_dbg_fn_);
+  for (const auto* users :
+       {&var_id_to_dbg_decl_, &scope_id_to_users_, &inlinedat_id_to_users_}) {
+    bytes += utils::MemoryUsage(*users);
+    for (const auto& id_users : *users) {
+      bytes += utils::MemoryUsage(id_users.second);
+    }
+  }
+  return bytes;
+}
+
 }  // namespace analysis
 }  // namespace opt
 }  // namespace spvtools
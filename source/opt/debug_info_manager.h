@@ -34,10 +34,10 @@ namespace analysis {
 class DebugInlinedAtContext {
  public:
   explicit DebugInlinedAtContext(Instruction* call_inst)
-      : call_inst_line_(call_inst->dbg_line_inst()),
+      : call_inst_line_(call_inst->dbg_line()),
         call_inst_scope_(call_inst->GetDebugScope()) {}
 
-  const Instruction* GetLineOfCallInstruction() { return call_inst_line_; }
+  const DebugLine* GetLineOfCallInstruction() { return call_inst_line_; }
   const DebugScope& GetScopeOfCallInstruction() { return call_inst_scope_; }
   // Puts the DebugInlinedAt chain that is generated for the callee instruction
   // whose DebugInlinedAt of DebugScope is |callee_instr_inlined_at| into
@@ -56,7 +56,7 @@ class DebugInlinedAtContext {
  private:
   // The line information of the function call instruction that will be
   // replaced by the callee function.
-  const Instruction* call_inst_line_;
+  const DebugLine* call_inst_line_;
 
   // The scope information of the function call instruction that will be
   // replaced by the callee function.
@@ -92,7 +92,7 @@ class DebugInfoManager {
   // line number of |line| if |line| is not nullptr. Otherwise, its line operand
   // is the line number of lexical scope of |scope|. Its Scope and Inlined
   // operands are Scope and Inlined of |scope|.
-  uint32_t CreateDebugInlinedAt(const Instruction* line,
+  uint32_t CreateDebugInlinedAt(const DebugLine* line,
                                 const DebugScope& scope);
 
   // Clones DebugExpress instruction |dbg_expr| and add Deref Operation
@@ -181,6 +181,10 @@ class DebugInfoManager {
   // DebugInlinedAt |inst| from |inlinedat_id_to_users_|.
   void ClearDebugScopeAndInlinedAtUses(Instruction* inst);
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // manager, not counting the instructions it refers to.
+  size_t MemoryUsage() const;
+
  private:
   IRContext* context() { return context_; }
 
@@ -188,6 +192,16 @@ class DebugInfoManager {
   // populates data structures in this class.
   void AnalyzeDebugInsts(Module& module);
 
+  // Records |inst| as a user of its DebugScope and DebugInlinedAt in
+  // |scope_id_to_users_| and |inlinedat_id_to_users_|.
+  void RegisterDebugScopeUser(Instruction* inst);
+
+  // Populates |scope_id_to_users_| and |inlinedat_id_to_users_| from every
+  // instruction in the module, if that has not been done yet.  These maps are
+  // only needed to replace scope and inlined-at ids, so they are built on the
+  // first such request rather than with the rest of the analysis.
+  void AnalyzeDebugScopeUsers();
+
   // Returns the debug instruction whose id is |id|. Returns |nullptr| if one
   // does not exists.
   Instruction* GetDbgInst(uint32_t id);
@@ -246,6 +260,11 @@ class DebugInfoManager {
   std::unordered_map<uint32_t, std::unordered_set<Instruction*>>
       inlinedat_id_to_users_;
 
+  // True once |scope_id_to_users_| and |inlinedat_id_to_users_| have been
+  // populated by |AnalyzeDebugScopeUsers|.  Until then both maps are empty
+  // and are not updated.
+  bool debug_scope_users_analyzed_;
+
   // DebugOperation whose OpCode is OpenCLDebugInfo100Deref.
   Instruction* deref_operation_;
 
@@ -0,0 +1,53 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/debug_line_table.h"
+
+#include <cassert>
+#include <limits>
+
+namespace spvtools {
+namespace opt {
+
+DebugLineTable::DebugLineTable() { sequences_.emplace_back(); }
+
+uint32_t DebugLineTable::Intern(const std::vector<DebugLine>& lines) {
+  if (lines.empty()) return 0;
+
+  const size_t hash = Hash(lines);
+  const auto range = indices_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (sequences_[it->second] == lines) return it->second;
+  }
+
+  assert(sequences_.size() < std::numeric_limits<uint32_t>::max() &&
+         "Too many sequences of debug lines.");
+  const uint32_t index = static_cast<uint32_t>(sequences_.size());
+  sequences_.push_back(lines);
+  indices_.emplace(hash, index);
+  return index;
+}
+
+size_t DebugLineTable::Hash(const std::vector<DebugLine>& lines) {
+  size_t hash = lines.size();
+  for (const auto& line : lines) {
+    for (uint32_t word : {line.file, line.line, line.column}) {
+      hash = hash * 31 + word;
+    }
+  }
+  return hash;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_DEBUG_LINE_TABLE_H_
+#define SOURCE_OPT_DEBUG_LINE_TABLE_H_
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+// A line-related debug instruction attached to an instruction: either an
+// OpLine, with the id of the OpString of its file name, its line and its
+// column, or an OpNoLine, whose |file| is 0.
+struct DebugLine {
+  uint32_t file;
+  uint32_t line;
+  uint32_t column;
+
+  // Returns true if this is an OpNoLine.
+  bool IsNoLine() const { return file == 0; }
+
+  friend bool operator==(const DebugLine& a, const DebugLine& b) {
+    return a.file == b.file && a.line == b.line && a.column == b.column;
+  }
+  friend bool operator!=(const DebugLine& a, const DebugLine& b) {
+    return !(a == b);
+  }
+};
+
+// The sequences of line-related debug instructions attached to the
+// instructions of a module.  Each distinct sequence is kept once, and an
+// instruction refers to its sequence by a 32-bit index, so that the many
+// instructions of a module compiled with debug information that share their
+// lines do not each keep a copy of them.  The index 0 refers to the empty
+// sequence.
+//
+// The sequences are never removed, and their storage does not move, so a
+// reference to a sequence stays valid as long as the table.
+class DebugLineTable {
+ public:
+  DebugLineTable();
+
+  DebugLineTable(const DebugLineTable&) = delete;
+  DebugLineTable& operator=(const DebugLineTable&) = delete;
+
+  // Returns the index of the sequence |lines|, adding it to the table if it is
+  // not there yet.
+  uint32_t Intern(const std::vector<DebugLine>& lines);
+
+  // Returns the sequence with index |index|.
+  const std::vector<DebugLine>& Get(uint32_t index) const {
+    return sequences_[index];
+  }
+
+  // Returns the number of distinct sequences in the table, including the
+  // empty one.
+  size_t size() const { return sequences_.size(); }
+
+ private:
+  // Returns a hash of |lines|.
+  static size_t Hash(const std::vector<DebugLine>& lines);
+
+  // The sequences, by index.
+  std::deque<std::vector<DebugLine>> sequences_;
+
+  // The indices of the sequences, by hash.
+  std::unordered_multimap<size_t, uint32_t> indices_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_DEBUG_LINE_TABLE_H_
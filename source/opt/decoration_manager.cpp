@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
 
 namespace {
 using InstructionVector = std::vector<const spvtools::opt::Instruction*>;
@@ -187,6 +188,15 @@ std::vector<const Instruction*> DecorationManager::GetDecorationsFor(
 
 bool DecorationManager::HaveTheSameDecorations(uint32_t id1,
                                                uint32_t id2) const {
+  if (id1 == id2) return true;
+
+  // Ids the manager has never seen decorated have no decorations to compare.
+  // This is the common case for value numbering, so avoid building the sets.
+  if (id_to_decoration_insts_.find(id1) == id_to_decoration_insts_.end() &&
+      id_to_decoration_insts_.find(id2) == id_to_decoration_insts_.end()) {
+    return true;
+  }
+
   const InstructionVector decorations_for1 = GetDecorationsFor(id1, false);
   const InstructionVector decorations_for2 = GetDecorationsFor(id2, false);
 
@@ -347,6 +357,8 @@ bool DecorationManager::AreDecorationsTheSame(const Instruction* inst1,
 void DecorationManager::AnalyzeDecorations() {
   if (!module_) return;
 
+  id_to_decoration_insts_.reserve(module_->IdBound());
+
   // For each group and instruction, collect all their decoration instructions.
   for (Instruction& inst : module_->annotations()) {
     AddDecoration(&inst);
@@ -457,22 +469,44 @@ std::vector<T> DecorationManager::InternalGetDecorationsFor(
 bool DecorationManager::WhileEachDecoration(
     uint32_t id, uint32_t decoration,
     std::function<bool(const Instruction&)> f) {
-  for (const Instruction* inst : GetDecorationsFor(id, true)) {
-    switch (inst->opcode()) {
-      case SpvOpMemberDecorate:
-        if (inst->GetSingleWordInOperand(2) == decoration) {
-          if (!f(*inst)) return false;
-        }
-        break;
-      case SpvOpDecorate:
-      case SpvOpDecorateId:
-      case SpvOpDecorateStringGOOGLE:
-        if (inst->GetSingleWordInOperand(1) == decoration) {
-          if (!f(*inst)) return false;
+  const auto ids_iter = id_to_decoration_insts_.find(id);
+  if (ids_iter == id_to_decoration_insts_.end()) return true;
+
+  // Walks the decorations in place rather than through |GetDecorationsFor|,
+  // which would copy them first.
+  const auto process_direct_decorations =
+      [decoration, &f](const std::vector<Instruction*>& direct_decorations) {
+        for (const Instruction* inst : direct_decorations) {
+          switch (inst->opcode()) {
+            case SpvOpMemberDecorate:
+              if (inst->GetSingleWordInOperand(2) == decoration) {
+                if (!f(*inst)) return false;
+              }
+              break;
+            case SpvOpDecorate:
+            case SpvOpDecorateId:
+            case SpvOpDecorateStringGOOGLE:
+              if (inst->GetSingleWordInOperand(1) == decoration) {
+                if (!f(*inst)) return false;
+              }
+              break;
+            default:
+              assert(false && "Unexpected decoration instruction");
+          }
         }
-        break;
-      default:
-        assert(false && "Unexpected decoration instruction");
+        return true;
+      };
+
+  const TargetData& target_data = ids_iter->second;
+  if (!process_direct_decorations(target_data.direct_decorations)) {
+    return false;
+  }
+  for (const Instruction* inst : target_data.indirect_decorations) {
+    const uint32_t group_id = inst->GetSingleWordInOperand(0u);
+    const auto group_iter = id_to_decoration_insts_.find(group_id);
+    assert(group_iter != id_to_decoration_insts_.end() && "Unknown group ID");
+    if (!process_direct_decorations(group_iter->second.direct_decorations)) {
+      return false;
     }
   }
   return true;
@@ -613,6 +647,16 @@ bool operator==(const DecorationManager& lhs, const DecorationManager& rhs) {
   return lhs.id_to_decoration_insts_ == rhs.id_to_decoration_insts_;
 }
 
+size_t DecorationManager::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(id_to_decoration_insts_);
+  for (const auto& target : id_to_decoration_insts_) {
+    bytes += utils::MemoryUsage(target.second.direct_decorations) +
+             utils::MemoryUsage(target.second.indirect_decorations) +
+             utils::MemoryUsage(target.second.decorate_insts);
+  }
+  return bytes;
+}
+
 }  // namespace analysis
 }  // namespace opt
 }  // namespace spvtools
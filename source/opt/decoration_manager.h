@@ -22,6 +22,7 @@
 
 #include "source/opt/instruction.h"
 #include "source/opt/module.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -92,6 +93,8 @@ class DecorationManager {
   // |f| is run on each decoration instruction for |id| with decoration
   // |decoration|. Processed are all decorations which target |id| either
   // directly or indirectly by Decoration Groups.
+  //
+  // As for |WhileEachDecoration|, |f| must not add or remove decorations.
   void ForEachDecoration(uint32_t id, uint32_t decoration,
                          std::function<void(const Instruction&)> f);
 
@@ -99,6 +102,9 @@ class DecorationManager {
   // |decoration|. Processes all decoration which target |id| either directly or
   // indirectly through decoration groups. If |f| returns false, iteration is
   // terminated and this function returns false.
+  //
+  // The decorations are visited in place, so |f| must not add or remove
+  // decorations.
   bool WhileEachDecoration(uint32_t id, uint32_t decoration,
                            std::function<bool(const Instruction&)> f);
 
@@ -137,6 +143,10 @@ class DecorationManager {
     return !(lhs == rhs);
   }
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // manager, not counting the instructions it refers to.
+  size_t MemoryUsage() const;
+
  private:
   // Analyzes the defs and uses in the given |module| and populates data
   // structures in this class. Does nothing if |module| is nullptr.
@@ -186,7 +196,7 @@ class DecorationManager {
   // referencing that id, be it directly (SpvOpDecorate, SpvOpMemberDecorate
   // and SpvOpDecorateId), or indirectly (SpvOpGroupDecorate,
   // SpvOpMemberGroupDecorate).
-  std::unordered_map<uint32_t, TargetData> id_to_decoration_insts_;
+  utils::IdMap<TargetData> id_to_decoration_insts_;
   // The enclosing module.
   Module* module_;
 };
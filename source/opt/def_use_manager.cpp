@@ -14,23 +14,27 @@
 
 #include "source/opt/def_use_manager.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "source/opt/log.h"
 #include "source/opt/reflect.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
 namespace analysis {
 
 void DefUseManager::AnalyzeInstDef(Instruction* inst) {
+  ClearUnchangedMarks(inst);
   const uint32_t def_id = inst->result_id();
   if (def_id != 0) {
-    auto iter = id_to_def_.find(def_id);
-    if (iter != id_to_def_.end()) {
+    if (def_id >= id_to_def_.size()) {
+      id_to_def_.resize(def_id + 1, nullptr);
+    } else if (id_to_def_[def_id] != nullptr) {
       // Clear the original instruction that defining the same result id of the
       // new instruction.
-      ClearInst(iter->second);
+      ClearInst(id_to_def_[def_id]);
     }
     id_to_def_[def_id] = inst;
   } else {
@@ -42,6 +46,7 @@ void DefUseManager::AnalyzeInstUse(Instruction* inst) {
   // Create entry for the given instruction. Note that the instruction may
   // not have any in-operands. In such cases, we still need a entry for those
   // instructions so this manager knows it has seen the instruction later.
+  ClearUnchangedMarks(inst);
   auto* used_ids = &inst_to_used_ids_[inst];
   if (used_ids->size()) {
     EraseUseRecordsOfOperandIds(inst);
@@ -57,9 +62,8 @@ void DefUseManager::AnalyzeInstUse(Instruction* inst) {
       case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
       case SPV_OPERAND_TYPE_SCOPE_ID: {
         uint32_t use_id = inst->GetSingleWordOperand(i);
-        Instruction* def = GetDef(use_id);
-        assert(def && "Definition is not registered.");
-        id_to_users_.insert(UserEntry(def, inst));
+        assert(GetDef(use_id) && "Definition is not registered.");
+        AddUser(use_id, inst);
         used_ids->push_back(use_id);
       } break;
       default:
@@ -75,65 +79,134 @@ void DefUseManager::AnalyzeInstDefUse(Instruction* inst) {
 
 void DefUseManager::UpdateDefUse(Instruction* inst) {
   const uint32_t def_id = inst->result_id();
-  if (def_id != 0) {
-    auto iter = id_to_def_.find(def_id);
-    if (iter == id_to_def_.end()) {
-      AnalyzeInstDef(inst);
-    }
+  if (def_id != 0 && GetDef(def_id) == nullptr) {
+    AnalyzeInstDef(inst);
   }
   AnalyzeInstUse(inst);
 }
 
 Instruction* DefUseManager::GetDef(uint32_t id) {
-  auto iter = id_to_def_.find(id);
-  if (iter == id_to_def_.end()) return nullptr;
-  return iter->second;
+  if (id >= id_to_def_.size()) return nullptr;
+  return id_to_def_[id];
 }
 
 const Instruction* DefUseManager::GetDef(uint32_t id) const {
-  const auto iter = id_to_def_.find(id);
-  if (iter == id_to_def_.end()) return nullptr;
-  return iter->second;
+  if (id >= id_to_def_.size()) return nullptr;
+  return id_to_def_[id];
 }
 
-DefUseManager::IdToUsersMap::const_iterator DefUseManager::UsersBegin(
-    const Instruction* def) const {
-  return id_to_users_.lower_bound(
-      UserEntry(const_cast<Instruction*>(def), nullptr));
+void DefUseManager::AddUser(uint32_t id, Instruction* user) {
+  ++num_updates_;
+  if (id >= id_to_users_.size()) {
+    id_to_users_.resize(id + 1);
+  }
+  UserList& list = id_to_users_[id];
+  auto& entries = list.entries;
+  const uint32_t uid = user->unique_id();
+
+  // Most users are analyzed in order of creation, so they go at the end.
+  if (entries.empty() || entries.back().first < uid) {
+    entries.emplace_back(uid, user);
+    return;
+  }
+
+  auto iter = std::lower_bound(
+      entries.begin(), entries.end(), uid,
+      [](const std::pair<uint32_t, Instruction*>& entry, uint32_t value) {
+        return entry.first < value;
+      });
+  if (iter != entries.end() && iter->first == uid) {
+    if (iter->second == nullptr) {
+      iter->second = user;
+      --list.num_removed;
+    }
+    return;
+  }
+  entries.emplace(iter, uid, user);
+  ++list.version;
 }
 
-bool DefUseManager::UsersNotEnd(const IdToUsersMap::const_iterator& iter,
-                                const IdToUsersMap::const_iterator& cached_end,
-                                const Instruction* inst) const {
-  return (iter != cached_end && iter->first == inst);
+void DefUseManager::RemoveUser(uint32_t id, const Instruction* user) {
+  ++num_updates_;
+  if (id >= id_to_users_.size()) return;
+  UserList& list = id_to_users_[id];
+  auto& entries = list.entries;
+  const uint32_t uid = user->unique_id();
+
+  auto iter = std::lower_bound(
+      entries.begin(), entries.end(), uid,
+      [](const std::pair<uint32_t, Instruction*>& entry, uint32_t value) {
+        return entry.first < value;
+      });
+  if (iter == entries.end() || iter->first != uid || iter->second != user) {
+    return;
+  }
+  iter->second = nullptr;
+  ++list.num_removed;
+
+  if (list.num_removed == entries.size()) {
+    entries.clear();
+    list.num_removed = 0;
+    ++list.version;
+  } else if (2 * list.num_removed > entries.size()) {
+    entries.erase(
+        std::remove_if(entries.begin(), entries.end(),
+                       [](const std::pair<uint32_t, Instruction*>& entry) {
+                         return entry.second == nullptr;
+                       }),
+        entries.end());
+    list.num_removed = 0;
+    ++list.version;
+  }
 }
 
-bool DefUseManager::UsersNotEnd(const IdToUsersMap::const_iterator& iter,
-                                const Instruction* inst) const {
-  return UsersNotEnd(iter, id_to_users_.end(), inst);
+bool DefUseManager::WhileEachUserOfId(
+    uint32_t id, utils::FunctionRef<bool(Instruction*)> f) const {
+  const UserList* list = GetUserList(id);
+  if (list == nullptr) return true;
+
+  // |f| is allowed to change the users of |id|, and may even cause
+  // |id_to_users_| to be reallocated, so the list is looked up again after
+  // every call. If entries were moved, the position of the next user is found
+  // again from the unique id of the last user visited.
+  uint32_t version = list->version;
+  size_t index = 0;
+  while (index < list->entries.size()) {
+    Instruction* user = list->entries[index].second;
+    const uint32_t uid = list->entries[index].first;
+    if (user != nullptr && !f(user)) return false;
+
+    list = GetUserList(id);
+    if (list->version != version) {
+      version = list->version;
+      index = std::upper_bound(list->entries.begin(), list->entries.end(), uid,
+                               [](uint32_t value,
+                                  const std::pair<uint32_t, Instruction*>&
+                                      entry) { return value < entry.first; }) -
+              list->entries.begin();
+    } else {
+      ++index;
+    }
+  }
+  return true;
 }
 
 bool DefUseManager::WhileEachUser(
-    const Instruction* def, const std::function<bool(Instruction*)>& f) const {
+    const Instruction* def, utils::FunctionRef<bool(Instruction*)> f) const {
   // Ensure that |def| has been registered.
   assert(def && (!def->HasResultId() || def == GetDef(def->result_id())) &&
          "Definition is not registered.");
   if (!def->HasResultId()) return true;
-
-  auto end = id_to_users_.end();
-  for (auto iter = UsersBegin(def); UsersNotEnd(iter, end, def); ++iter) {
-    if (!f(iter->second)) return false;
-  }
-  return true;
+  return WhileEachUserOfId(def->result_id(), f);
 }
 
 bool DefUseManager::WhileEachUser(
-    uint32_t id, const std::function<bool(Instruction*)>& f) const {
+    uint32_t id, utils::FunctionRef<bool(Instruction*)> f) const {
   return WhileEachUser(GetDef(id), f);
 }
 
 void DefUseManager::ForEachUser(
-    const Instruction* def, const std::function<void(Instruction*)>& f) const {
+    const Instruction* def, utils::FunctionRef<void(Instruction*)> f) const {
   WhileEachUser(def, [&f](Instruction* user) {
     f(user);
     return true;
@@ -141,41 +214,40 @@ void DefUseManager::ForEachUser(
 }
 
 void DefUseManager::ForEachUser(
-    uint32_t id, const std::function<void(Instruction*)>& f) const {
+    uint32_t id, utils::FunctionRef<void(Instruction*)> f) const {
   ForEachUser(GetDef(id), f);
 }
 
 bool DefUseManager::WhileEachUse(
     const Instruction* def,
-    const std::function<bool(Instruction*, uint32_t)>& f) const {
+    utils::FunctionRef<bool(Instruction*, uint32_t)> f) const {
   // Ensure that |def| has been registered.
   assert(def && (!def->HasResultId() || def == GetDef(def->result_id())) &&
          "Definition is not registered.");
   if (!def->HasResultId()) return true;
 
-  auto end = id_to_users_.end();
-  for (auto iter = UsersBegin(def); UsersNotEnd(iter, end, def); ++iter) {
-    Instruction* user = iter->second;
+  const uint32_t def_id = def->result_id();
+  return WhileEachUserOfId(def_id, [def_id, &f](Instruction* user) {
     for (uint32_t idx = 0; idx != user->NumOperands(); ++idx) {
       const Operand& op = user->GetOperand(idx);
       if (op.type != SPV_OPERAND_TYPE_RESULT_ID && spvIsIdType(op.type)) {
-        if (def->result_id() == op.words[0]) {
+        if (def_id == op.words[0]) {
           if (!f(user, idx)) return false;
         }
       }
     }
-  }
-  return true;
+    return true;
+  });
 }
 
 bool DefUseManager::WhileEachUse(
-    uint32_t id, const std::function<bool(Instruction*, uint32_t)>& f) const {
+    uint32_t id, utils::FunctionRef<bool(Instruction*, uint32_t)> f) const {
   return WhileEachUse(GetDef(id), f);
 }
 
 void DefUseManager::ForEachUse(
     const Instruction* def,
-    const std::function<void(Instruction*, uint32_t)>& f) const {
+    utils::FunctionRef<void(Instruction*, uint32_t)> f) const {
   WhileEachUse(def, [&f](Instruction* user, uint32_t index) {
     f(user, index);
     return true;
@@ -183,14 +255,18 @@ void DefUseManager::ForEachUse(
 }
 
 void DefUseManager::ForEachUse(
-    uint32_t id, const std::function<void(Instruction*, uint32_t)>& f) const {
+    uint32_t id, utils::FunctionRef<void(Instruction*, uint32_t)> f) const {
   ForEachUse(GetDef(id), f);
 }
 
 uint32_t DefUseManager::NumUsers(const Instruction* def) const {
-  uint32_t count = 0;
-  ForEachUser(def, [&count](Instruction*) { ++count; });
-  return count;
+  // Ensure that |def| has been registered.
+  assert(def && (!def->HasResultId() || def == GetDef(def->result_id())) &&
+         "Definition is not registered.");
+  if (!def->HasResultId()) return 0;
+  const UserList* list = GetUserList(def->result_id());
+  if (list == nullptr) return 0;
+  return static_cast<uint32_t>(list->entries.size() - list->num_removed);
 }
 
 uint32_t DefUseManager::NumUsers(uint32_t id) const {
@@ -220,8 +296,34 @@ std::vector<Instruction*> DefUseManager::GetAnnotations(uint32_t id) const {
   return annos;
 }
 
+DefUseManager::IdToDefMap DefUseManager::id_to_defs() const {
+  IdToDefMap result;
+  for (uint32_t id = 0; id < id_to_def_.size(); ++id) {
+    if (id_to_def_[id] != nullptr) {
+      result[id] = id_to_def_[id];
+    }
+  }
+  return result;
+}
+
+DefUseManager::IdToUsersMap DefUseManager::id_to_users() const {
+  IdToUsersMap result;
+  for (uint32_t id = 0; id < id_to_users_.size(); ++id) {
+    Instruction* def = id_to_def_.size() > id ? id_to_def_[id] : nullptr;
+    if (def == nullptr) continue;
+    for (const auto& entry : id_to_users_[id].entries) {
+      if (entry.second != nullptr) {
+        result.insert(UserEntry(def, entry.second));
+      }
+    }
+  }
+  return result;
+}
+
 void DefUseManager::AnalyzeDefUse(Module* module) {
   if (!module) return;
+  id_to_def_.resize(module->IdBound(), nullptr);
+  id_to_users_.resize(module->IdBound());
   // Analyze all the defs before any uses to catch forward references.
   module->ForEachInst(
       std::bind(&DefUseManager::AnalyzeInstDef, this, std::placeholders::_1));
@@ -233,15 +335,14 @@ void DefUseManager::ClearInst(Instruction* inst) {
   auto iter = inst_to_used_ids_.find(inst);
   if (iter != inst_to_used_ids_.end()) {
     EraseUseRecordsOfOperandIds(inst);
-    if (inst->result_id() != 0) {
+    const uint32_t def_id = inst->result_id();
+    if (def_id != 0 && GetDef(def_id) == inst) {
       // Remove all uses of this inst.
-      auto users_begin = UsersBegin(inst);
-      auto end = id_to_users_.end();
-      auto new_end = users_begin;
-      for (; UsersNotEnd(new_end, end, inst); ++new_end) {
-      }
-      id_to_users_.erase(users_begin, new_end);
-      id_to_def_.erase(inst->result_id());
+      UserList& list = id_to_users_[def_id];
+      list.entries.clear();
+      list.num_removed = 0;
+      ++list.version;
+      id_to_def_[def_id] = nullptr;
     }
   }
 }
@@ -249,32 +350,32 @@ void DefUseManager::ClearInst(Instruction* inst) {
 void DefUseManager::EraseUseRecordsOfOperandIds(const Instruction* inst) {
   // Go through all ids used by this instruction, remove this instruction's
   // uses of them.
+  ClearUnchangedMarks(inst);
   auto iter = inst_to_used_ids_.find(inst);
   if (iter != inst_to_used_ids_.end()) {
     for (auto use_id : iter->second) {
-      id_to_users_.erase(
-          UserEntry(GetDef(use_id), const_cast<Instruction*>(inst)));
+      RemoveUser(use_id, inst);
     }
     inst_to_used_ids_.erase(inst);
   }
 }
 
+void DefUseManager::ClearUnchangedMarks(const Instruction* inst) {
+  if (!has_unchanged_marks_) return;
+  unchanged_.Clear(inst->unique_id());
+  const UserList* users = GetUserList(inst->result_id());
+  if (users == nullptr) return;
+  for (const auto& entry : users->entries) {
+    unchanged_.Clear(entry.first);
+  }
+}
+
 bool operator==(const DefUseManager& lhs, const DefUseManager& rhs) {
-  if (lhs.id_to_def_ != rhs.id_to_def_) {
+  if (lhs.id_to_defs() != rhs.id_to_defs()) {
     return false;
   }
 
-  if (lhs.id_to_users_ != rhs.id_to_users_) {
-    for (auto p : lhs.id_to_users_) {
-      if (rhs.id_to_users_.count(p) == 0) {
-        return false;
-      }
-    }
-    for (auto p : rhs.id_to_users_) {
-      if (lhs.id_to_users_.count(p) == 0) {
-        return false;
-      }
-    }
+  if (lhs.id_to_users() != rhs.id_to_users()) {
     return false;
   }
 
@@ -294,6 +395,19 @@ bool operator==(const DefUseManager& lhs, const DefUseManager& rhs) {
   return true;
 }
 
+size_t DefUseManager::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(id_to_def_) +
+                 utils::MemoryUsage(id_to_users_) +
+                 utils::MemoryUsage(inst_to_used_ids_);
+  for (const auto& users : id_to_users_) {
+    bytes += utils::MemoryUsage(users.entries);
+  }
+  for (const auto& used_ids : inst_to_used_ids_) {
+    bytes += utils::MemoryUsage(used_ids.second);
+  }
+  return bytes;
+}
+
 }  // namespace analysis
 }  // namespace opt
 }  // namespace spvtools
@@ -23,6 +23,8 @@
 
 #include "source/opt/instruction.h"
 #include "source/opt/module.h"
+#include "source/util/bit_vector.h"
+#include "source/util/function_ref.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
@@ -94,6 +96,11 @@ struct UserEntryLess {
 };
 
 // A class for analyzing and managing defs and uses in an Module.
+//
+// Definitions and users are stored in vectors indexed by result id. The users
+// of each definition are kept in a compact list ordered by the unique id of
+// the user, so iteration visits users in the same order as an ordered set
+// would.
 class DefUseManager {
  public:
   using IdToDefMap = std::unordered_map<uint32_t, Instruction*>;
@@ -134,9 +141,9 @@ class DefUseManager {
   //
   // |def| (or |id|) must be registered as a definition.
   void ForEachUser(const Instruction* def,
-                   const std::function<void(Instruction*)>& f) const;
+                   utils::FunctionRef<void(Instruction*)> f) const;
   void ForEachUser(uint32_t id,
-                   const std::function<void(Instruction*)>& f) const;
+                   utils::FunctionRef<void(Instruction*)> f) const;
 
   // Runs the given function |f| on each unique user instruction of |def| (or
   // |id|). If |f| returns false, iteration is terminated and this function
@@ -147,9 +154,9 @@ class DefUseManager {
   //
   // |def| (or |id|) must be registered as a definition.
   bool WhileEachUser(const Instruction* def,
-                     const std::function<bool(Instruction*)>& f) const;
+                     utils::FunctionRef<bool(Instruction*)> f) const;
   bool WhileEachUser(uint32_t id,
-                     const std::function<bool(Instruction*)>& f) const;
+                     utils::FunctionRef<bool(Instruction*)> f) const;
 
   // Runs the given function |f| on each unique use of |def| (or
   // |id|).
@@ -160,10 +167,10 @@ class DefUseManager {
   // |def| (or |id|) must be registered as a definition.
   void ForEachUse(
       const Instruction* def,
-      const std::function<void(Instruction*, uint32_t operand_index)>& f) const;
+      utils::FunctionRef<void(Instruction*, uint32_t operand_index)> f) const;
   void ForEachUse(
       uint32_t id,
-      const std::function<void(Instruction*, uint32_t operand_index)>& f) const;
+      utils::FunctionRef<void(Instruction*, uint32_t operand_index)> f) const;
 
   // Runs the given function |f| on each unique use of |def| (or
   // |id|). If |f| returns false, iteration is terminated and this function
@@ -175,10 +182,10 @@ class DefUseManager {
   // |def| (or |id|) must be registered as a definition.
   bool WhileEachUse(
       const Instruction* def,
-      const std::function<bool(Instruction*, uint32_t operand_index)>& f) const;
+      utils::FunctionRef<bool(Instruction*, uint32_t operand_index)> f) const;
   bool WhileEachUse(
       uint32_t id,
-      const std::function<bool(Instruction*, uint32_t operand_index)>& f) const;
+      utils::FunctionRef<bool(Instruction*, uint32_t operand_index)> f) const;
 
   // Returns the number of users of |def| (or |id|).
   uint32_t NumUsers(const Instruction* def) const;
@@ -195,10 +202,12 @@ class DefUseManager {
   // instructions which decorate the decoration group will not be returned.
   std::vector<Instruction*> GetAnnotations(uint32_t id) const;
 
-  // Returns the map from ids to their def instructions.
-  const IdToDefMap& id_to_defs() const { return id_to_def_; }
-  // Returns the map from instructions to their users.
-  const IdToUsersMap& id_to_users() const { return id_to_users_; }
+  // Returns a map from ids to their def instructions. The map is built on
+  // each call, so it should not be used in performance critical code.
+  IdToDefMap id_to_defs() const;
+  // Returns the set of all (definition, user) pairs. The set is built on each
+  // call, so it should not be used in performance critical code.
+  IdToUsersMap id_to_users() const;
 
   // Clear the internal def-use record of the given instruction |inst|. This
   // method will update the use information of the operand ids of |inst|. The
@@ -219,34 +228,86 @@ class DefUseManager {
   // uses.
   void UpdateDefUse(Instruction* inst);
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // manager, not counting the instructions it refers to.
+  size_t MemoryUsage() const;
+
+  // Returns the number of times a use record was added or removed since this
+  // manager was created, including while building it.
+  size_t num_updates() const { return num_updates_; }
+
+  // Marks |inst| as unchanged.  The mark is removed as soon as the definition
+  // or the uses of |inst| are analyzed again or cleared, or those of the
+  // definition of one of the ids it uses are.  Passes use it to remember that
+  // they have already looked at |inst| and found nothing to do.  Changes that
+  // are not reported to this manager do not remove the mark.
+  void MarkUnchanged(const Instruction* inst) {
+    unchanged_.Set(inst->unique_id());
+    has_unchanged_marks_ = true;
+  }
+
+  // Returns true if |inst| is marked unchanged.
+  bool IsMarkedUnchanged(const Instruction* inst) const {
+    return has_unchanged_marks_ && unchanged_.Get(inst->unique_id());
+  }
+
  private:
   using InstToUsedIdsMap =
       std::unordered_map<const Instruction*, std::vector<uint32_t>>;
 
-  // Returns the first location that {|def|, nullptr} could be inserted into the
-  // users map without violating ordering.
-  IdToUsersMap::const_iterator UsersBegin(const Instruction* def) const;
+  // The users of a single definition, ordered by the unique id of the user.
+  // Removing a user only clears its entry, so removal never has to shift the
+  // list. Cleared entries are compacted away once they make up more than half
+  // of the list.
+  struct UserList {
+    // Pairs of (unique id of the user, user). The user is null if it has been
+    // removed.
+    std::vector<std::pair<uint32_t, Instruction*>> entries;
+    // The number of entries whose user is null.
+    uint32_t num_removed = 0;
+    // Incremented every time entries are moved within |entries|, so that
+    // iterations in progress know they have to find their position again.
+    uint32_t version = 0;
+  };
+
+  // Records that |user| uses the definition with result id |id|.
+  void AddUser(uint32_t id, Instruction* user);
+
+  // Removes the record that |user| uses the definition with result id |id|.
+  void RemoveUser(uint32_t id, const Instruction* user);
+
+  // Returns the list of users of the definition with result id |id|, or
+  // nullptr if there is none.
+  const UserList* GetUserList(uint32_t id) const {
+    return id < id_to_users_.size() ? &id_to_users_[id] : nullptr;
+  }
+
+  // Runs |f| on each user of the definition with result id |id|, in order of
+  // unique id. Iteration stops and false is returned as soon as |f| returns
+  // false. |f| may add or remove users of |id|; users added with a larger
+  // unique id than the current one will be visited.
+  bool WhileEachUserOfId(uint32_t id,
+                         utils::FunctionRef<bool(Instruction*)> f) const;
 
-  // Returns true if |iter| has not reached the end of |def|'s users.
-  //
-  // In the first version |iter| is compared against the end of the map for
-  // validity before other checks. In the second version, |iter| is compared
-  // against |cached_end| for validity before other checks. This allows caching
-  // the map's end which is a performance improvement on some platforms.
-  bool UsersNotEnd(const IdToUsersMap::const_iterator& iter,
-                   const Instruction* def) const;
-  bool UsersNotEnd(const IdToUsersMap::const_iterator& iter,
-                   const IdToUsersMap::const_iterator& cached_end,
-                   const Instruction* def) const;
+  // Removes the unchanged marks of |inst| and of the users of its result id.
+  void ClearUnchangedMarks(const Instruction* inst);
 
   // Analyzes the defs and uses in the given |module| and populates data
   // structures in this class. Does nothing if |module| is nullptr.
   void AnalyzeDefUse(Module* module);
 
-  IdToDefMap id_to_def_;      // Mapping from ids to their definitions
-  IdToUsersMap id_to_users_;  // Mapping from ids to their users
+  // Mapping from ids to their definitions. Null if the id has no definition.
+  std::vector<Instruction*> id_to_def_;
+  // Mapping from ids to their users.
+  std::vector<UserList> id_to_users_;
   // Mapping from instructions to the ids used in the instruction.
   InstToUsedIdsMap inst_to_used_ids_;
+  // The number of calls to AddUser and RemoveUser.
+  size_t num_updates_ = 0;
+  // The unique ids of the instructions marked unchanged.
+  utils::BitVector unchanged_;
+  // True if any instruction was ever marked unchanged.
+  bool has_unchanged_marks_ = false;
 };
 
 }  // namespace analysis
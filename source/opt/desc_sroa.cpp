@@ -24,6 +24,7 @@ Pass::Status DescriptorScalarReplacement::Process() {
 
   std::vector<Instruction*> vars_to_kill;
 
+  PlanBindings();
   for (Instruction& var : context()->types_values()) {
     if (IsCandidate(&var)) {
       modified = true;
@@ -53,26 +54,7 @@ bool DescriptorScalarReplacement::IsCandidate(Instruction* var) {
     return false;
   }
 
-  uint32_t var_type_id = ptr_type_inst->GetSingleWordInOperand(1);
-  Instruction* var_type_inst =
-      context()->get_def_use_mgr()->GetDef(var_type_id);
-  if (var_type_inst->opcode() != SpvOpTypeArray &&
-      var_type_inst->opcode() != SpvOpTypeStruct) {
-    return false;
-  }
-
-  // All structures with descriptor assignments must be replaced by variables,
-  // one for each of their members - with the exceptions of buffers.
-  // Buffers are represented as structures, but we shouldn't replace a buffer
-  // with its elements. All buffers have offset decorations for members of their
-  // structure types.
-  bool has_offset_decoration = false;
-  context()->get_decoration_mgr()->ForEachDecoration(
-      var_type_inst->result_id(), SpvDecorationOffset,
-      [&has_offset_decoration](const Instruction&) {
-        has_offset_decoration = true;
-      });
-  if (has_offset_decoration) {
+  if (!IsCandidateType(ptr_type_inst->GetSingleWordInOperand(1))) {
     return false;
   }
 
@@ -99,6 +81,48 @@ bool DescriptorScalarReplacement::IsCandidate(Instruction* var) {
   return true;
 }
 
+bool DescriptorScalarReplacement::IsCandidateType(uint32_t type_id) {
+  Instruction* type_inst = context()->get_def_use_mgr()->GetDef(type_id);
+  if (type_inst->opcode() != SpvOpTypeArray &&
+      type_inst->opcode() != SpvOpTypeStruct) {
+    return false;
+  }
+
+  // All structures with descriptor assignments must be replaced by variables,
+  // one for each of their members - with the exceptions of buffers.
+  // Buffers are represented as structures, but we shouldn't replace a buffer
+  // with its elements. All buffers have offset decorations for members of their
+  // structure types.
+  bool has_offset_decoration = false;
+  context()->get_decoration_mgr()->ForEachDecoration(
+      type_id, SpvDecorationOffset,
+      [&has_offset_decoration](const Instruction&) {
+        has_offset_decoration = true;
+      });
+  return !has_offset_decoration;
+}
+
+void DescriptorScalarReplacement::PlanBindings() {
+  for (const ReflectedResource& resource :
+       context()->GetReflectionAnalysis()->resources()) {
+    if (!resource.has_binding ||
+        IsCandidate(get_def_use_mgr()->GetDef(resource.variable_id))) {
+      continue;
+    }
+    used_bindings_[resource.set].insert(resource.binding);
+  }
+}
+
+uint32_t DescriptorScalarReplacement::AssignBinding(uint32_t set,
+                                                    uint32_t binding) {
+  std::set<uint32_t>& used = used_bindings_[set];
+  if (!used.insert(binding).second) {
+    binding = *used.rbegin() + 1;
+    used.insert(binding);
+  }
+  return binding;
+}
+
 bool DescriptorScalarReplacement::ReplaceCandidate(Instruction* var) {
   std::vector<Instruction*> access_chain_work_list;
   std::vector<Instruction*> load_work_list;
@@ -279,8 +303,27 @@ uint32_t DescriptorScalarReplacement::CreateReplacementVariable(
 
   // Copy all of the decorations to the new variable.  The only difference is
   // the Binding decoration needs to be adjusted.
-  for (auto old_decoration :
-       get_decoration_mgr()->GetDecorationsFor(var->result_id(), true)) {
+  auto decorations = decorations_.find(var->result_id());
+  if (decorations == decorations_.end()) {
+    decorations =
+        decorations_
+            .emplace(var->result_id(), get_decoration_mgr()->GetDecorationsFor(
+                                           var->result_id(), true))
+            .first;
+  }
+  uint32_t set = 0;
+  for (const Instruction* old_decoration : decorations->second) {
+    if (old_decoration->GetSingleWordInOperand(1u) ==
+        SpvDecorationDescriptorSet) {
+      set = old_decoration->GetSingleWordInOperand(2u);
+    }
+  }
+
+  // The bindings of a replacement variable that is replaced in turn are not
+  // used: its own replacement variables are given bindings from the same
+  // range.
+  const bool is_replaced = IsCandidateType(element_type_id);
+  for (const Instruction* old_decoration : decorations->second) {
     assert(old_decoration->opcode() == SpvOpDecorate);
     std::unique_ptr<Instruction> new_decoration(
         old_decoration->Clone(context()));
@@ -300,6 +343,9 @@ uint32_t DescriptorScalarReplacement::CreateReplacementVariable(
               pointee_type_inst->GetSingleWordInOperand(i));
         }
       }
+      if (!is_replaced) {
+        new_binding = AssignBinding(set, new_binding);
+      }
       new_decoration->SetInOperand(2, {new_binding});
     }
     context()->AddAnnotationInst(std::move(new_decoration));
@@ -345,14 +391,19 @@ uint32_t DescriptorScalarReplacement::CreateReplacementVariable(
 
 uint32_t DescriptorScalarReplacement::GetNumBindingsUsedByType(
     uint32_t type_id) {
+  auto cached = num_bindings_used_by_type_.find(type_id);
+  if (cached != num_bindings_used_by_type_.end()) return cached->second;
+
   Instruction* type_inst = get_def_use_mgr()->GetDef(type_id);
 
   // If it's a pointer, look at the underlying type.
   if (type_inst->opcode() == SpvOpTypePointer) {
-    type_id = type_inst->GetSingleWordInOperand(1);
-    type_inst = get_def_use_mgr()->GetDef(type_id);
+    type_inst = get_def_use_mgr()->GetDef(type_inst->GetSingleWordInOperand(1));
   }
 
+  // All other types are considered to take up 1 binding number.
+  uint32_t num_bindings = 1;
+
   // Arrays consume N*M binding numbers where N is the array length, and M is
   // the number of bindings used by each array element.
   if (type_inst->opcode() == SpvOpTypeArray) {
@@ -363,20 +414,20 @@ uint32_t DescriptorScalarReplacement::GetNumBindingsUsedByType(
     // OpTypeArray's length must always be a constant
     assert(length_const != nullptr);
     uint32_t num_elems = length_const->GetU32();
-    return num_elems * GetNumBindingsUsedByType(element_type_id);
+    num_bindings = num_elems * GetNumBindingsUsedByType(element_type_id);
   }
 
   // The number of bindings consumed by a structure is the sum of the bindings
   // used by its members.
   if (type_inst->opcode() == SpvOpTypeStruct) {
-    uint32_t sum = 0;
+    num_bindings = 0;
     for (uint32_t i = 0; i < type_inst->NumInOperands(); i++)
-      sum += GetNumBindingsUsedByType(type_inst->GetSingleWordInOperand(i));
-    return sum;
+      num_bindings +=
+          GetNumBindingsUsedByType(type_inst->GetSingleWordInOperand(i));
   }
 
-  // All other types are considered to take up 1 binding number.
-  return 1;
+  num_bindings_used_by_type_[type_id] = num_bindings;
+  return num_bindings;
 }
 
 bool DescriptorScalarReplacement::ReplaceLoadedValue(Instruction* var,
@@ -18,6 +18,7 @@
 #include <cstdio>
 #include <memory>
 #include <queue>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -50,6 +51,20 @@ class DescriptorScalarReplacement : public Pass {
   // descriptor array.  These are the variables that we want to replace.
   bool IsCandidate(Instruction* var);
 
+  // Returns true if a descriptor variable that points to |type_id| is
+  // replaced: |type_id| is an array or a structure that is not a buffer.
+  bool IsCandidateType(uint32_t type_id);
+
+  // Records the descriptor set and the binding of every descriptor that is not
+  // replaced, so that the bindings of the replacement variables do not collide
+  // with them.
+  void PlanBindings();
+
+  // Returns |binding| if no other descriptor uses it in the descriptor set
+  // |set|, and otherwise the binding after the largest one used in |set|.  The
+  // returned binding is then used.
+  uint32_t AssignBinding(uint32_t set, uint32_t binding);
+
   // Replaces all references to |var| by new variables, one for each element of
   // the array |var|.  The binding for the new variables corresponding to
   // element i will be the binding of |var| plus i.  Returns true if successful.
@@ -84,7 +99,8 @@ class DescriptorScalarReplacement : public Pass {
   // element of |var|.
   uint32_t CreateReplacementVariable(Instruction* var, uint32_t idx);
 
-  // Returns the number of bindings used by the given |type_id|.
+  // Returns the number of bindings used by the given |type_id|.  The result is
+  // memoized in |num_bindings_used_by_type_|.
   // All types are considered to use 1 binding slot, except:
   // 1- A pointer type consumes as many binding numbers as its pointee.
   // 2- An array of size N consumes N*M binding numbers, where M is the number
@@ -99,6 +115,18 @@ class DescriptorScalarReplacement : public Pass {
   // array |var|. If the entry is |0|, then the variable has not been
   // created yet.
   std::map<Instruction*, std::vector<uint32_t>> replacement_variables_;
+
+  // The decorations of each replaced variable, which are copied to each of its
+  // replacement variables.
+  std::unordered_map<uint32_t, std::vector<Instruction*>> decorations_;
+
+  // The bindings used in each descriptor set, by the descriptors that are not
+  // replaced and by the replacement variables created so far.
+  std::unordered_map<uint32_t, std::set<uint32_t>> used_bindings_;
+
+  // The number of bindings used by each type for which
+  // GetNumBindingsUsedByType was called.
+  std::unordered_map<uint32_t, uint32_t> num_bindings_used_by_type_;
 };
 
 }  // namespace opt
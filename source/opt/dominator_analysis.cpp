@@ -67,6 +67,13 @@ bool DominatorAnalysisBase::Dominates(Instruction* a, Instruction* b) const {
   if (current->opcode() == SpvOpLabel) {
     return true;
   }
+  if (other->opcode() == SpvOpLabel) {
+    return false;
+  }
+
+  if (bb_a) {
+    return bb_a->IsBefore(current, other);
+  }
 
   while ((current = current->NextNode())) {
     if (current == other) {
@@ -33,6 +33,24 @@ class DominatorAnalysisBase {
     tree_.InitializeTree(cfg, f);
   }
 
+  // Updates the tree after a change to the control flow of |f|, instead of
+  // rebuilding it.  See the functions of the same names in DominatorTree.
+  inline void InsertEdge(const CFG& cfg, const Function* f, BasicBlock* from,
+                         BasicBlock* to) {
+    tree_.InsertEdge(cfg, f, from, to);
+  }
+  inline void DeleteEdge(const CFG& cfg, const Function* f, BasicBlock* from,
+                         BasicBlock* to) {
+    tree_.DeleteEdge(cfg, f, from, to);
+  }
+  inline void SplitBlock(BasicBlock* block, BasicBlock* new_block) {
+    tree_.SplitBlock(block, new_block);
+  }
+  inline void MergeBlocks(BasicBlock* block, BasicBlock* merged) {
+    tree_.MergeBlocks(block, merged);
+  }
+  inline void RemoveBlock(BasicBlock* bb) { tree_.RemoveBlock(bb); }
+
   // Returns true if BasicBlock |a| dominates BasicBlock |b|.
   inline bool Dominates(const BasicBlock* a, const BasicBlock* b) const {
     if (!a || !b) return false;
@@ -15,21 +15,25 @@
 #include <iostream>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 #include "source/cfa.h"
+#include "source/opt/cfg_snapshot.h"
 #include "source/opt/dominator_tree.h"
 #include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
+#include "source/util/span.h"
 
 // Calculates the dominator or postdominator tree for a given function.
-// 1 - Compute the successors and predecessors for each BasicBlock. We add a
-// placeholder node for the start node or for postdominators the exit. This node
-// will point to all entry or all exit nodes.
-// 2 - Using the CFA::DepthFirstTraversal get a depth first postordered list of
-// all BasicBlocks. Using the successors (or for postdominator, predecessors)
-// calculated in step 1 to traverse the tree.
-// 3 - Pass the list calculated in step 2 to the CFA::CalculateDominators using
-// the predecessors list (or for postdominator, successors). This will give us a
-// vector of BB pairs. Each BB and its immediate dominator.
+// 1 - Take a CFGSnapshot of the function, which numbers the BasicBlocks and
+// lays out their successors and predecessors. We add a placeholder node for
+// the start node or for postdominators the exit. This node will point to all
+// entry or all exit nodes.
+// 2 - Pass the numbered graph to CFA::CalculateDominatorIndices, using the
+// successors and predecessors (or for postdominator, the predecessors and
+// successors). This will give us the immediate dominator of each BB.
+// 3 - Using CFA::Postorder, list each BB and its immediate dominator in a
+// depth first postorder from the placeholder node.
 // 4 - Using the list from 3 use those edges to build a tree of
 // DominatorTreeNodes. Each node containing a link to the parent dominator and
 // children which are dominated.
@@ -62,158 +66,80 @@ static void DepthFirstSearch(const BBType* bb, SuccessorLambda successors,
   CFA<BBType>::DepthFirstTraversal(bb, successors, pre, post, nop_backedge);
 }
 
-// Wrapper around CFA::DepthFirstTraversal to provide an interface to perform
-// depth first search on generic BasicBlock types. This overload is for only
-// performing user defined post order.
-//
-// BBType - BasicBlock type. Will either be BasicBlock or DominatorTreeNode
-// SuccessorLambda - Lamdba matching the signature of 'const
-// std::vector<BBType>*(const BBType *A)'. Will return a vector of the nodes
-// succeding BasicBlock A.
-// PostLambda - Lamdba matching the signature of 'void (const BBType*)' will be
-// called on each node traversed after their children.
-template <typename BBType, typename SuccessorLambda, typename PostLambda>
-static void DepthFirstSearchPostOrder(const BBType* bb,
-                                      SuccessorLambda successors,
-                                      PostLambda post) {
-  // Ignore preorder operation.
-  auto nop_preorder = [](const BBType*) {};
-  DepthFirstSearch(bb, successors, nop_preorder, post);
-}
-
-// Small type trait to get the function class type.
-template <typename BBType>
-struct GetFunctionClass {
-  using FunctionType = Function;
-};
-
-// Helper class to compute predecessors and successors for each Basic Block in a
-// function. Through GetPredFunctor and GetSuccessorFunctor it provides an
-// interface to get the successor and predecessor lists for each basic
-// block. This is required by the DepthFirstTraversal and ComputeDominator
-// functions which take as parameter an std::function returning the successors
-// and predecessors respectively.
-//
-// When computing the post-dominator tree, all edges are inverted. So successors
-// returned by this class will be predecessors in the original CFG.
-template <typename BBType>
-class BasicBlockSuccessorHelper {
-  // This should eventually become const BasicBlock.
-  using BasicBlock = BBType;
-  using Function = typename GetFunctionClass<BBType>::FunctionType;
-
-  using BasicBlockListTy = std::vector<BasicBlock*>;
-  using BasicBlockMapTy = std::map<const BasicBlock*, BasicBlockListTy>;
-
+// Provides the successors and predecessors of the blocks of a function to
+// the incremental updates of a (post-)dominator tree.  Unlike a CFGSnapshot,
+// it does not lay out the whole graph: the lists are built on demand from the
+// CFG predecessors and the block terminators, so they reflect the current
+// state of the function.
+class IncrementalUpdateHelper {
  public:
-  // For compliance with the dominance tree computation, entry nodes are
-  // connected to a single placeholder node.
-  BasicBlockSuccessorHelper(Function& func,
-                            const BasicBlock* placeholder_start_node,
-                            bool post);
-
-  // CFA::CalculateDominators requires std::vector<BasicBlock*>.
   using GetBlocksFunction =
       std::function<const std::vector<BasicBlock*>*(const BasicBlock*)>;
 
-  // Returns the list of predecessor functions.
-  GetBlocksFunction GetPredFunctor() {
+  IncrementalUpdateHelper(const CFG& cfg, const Function* f, bool post)
+      : cfg_(cfg), function_(f), invert_graph_(post) {}
+
+  // Returns the successors of a block in the graph of the tree.
+  GetBlocksFunction GetSuccessorFunctor() {
     return [this](const BasicBlock* bb) {
-      BasicBlockListTy* v = &this->predecessors_[bb];
-      return v;
+      return invert_graph_ ? Predecessors(bb) : Successors(bb);
     };
   }
 
-  // Returns a vector of the list of successor nodes from a given node.
-  GetBlocksFunction GetSuccessorFunctor() {
+  // Returns the predecessors of a block in the graph of the tree.
+  GetBlocksFunction GetPredFunctor() {
     return [this](const BasicBlock* bb) {
-      BasicBlockListTy* v = &this->successors_[bb];
-      return v;
+      return invert_graph_ ? Successors(bb) : Predecessors(bb);
     };
   }
 
  private:
-  bool invert_graph_;
-  BasicBlockMapTy successors_;
-  BasicBlockMapTy predecessors_;
-
-  // Build the successors and predecessors map for each basic blocks |f|.
-  // If |invert_graph_| is true, all edges are reversed (successors becomes
-  // predecessors and vice versa).
-  // For convenience, the start of the graph is |placeholder_start_node|.
-  // The dominator tree construction requires a unique entry node, which cannot
-  // be guaranteed for the postdominator graph. The |placeholder_start_node| BB
-  // is here to gather all entry nodes.
-  void CreateSuccessorMap(Function& f,
-                          const BasicBlock* placeholder_start_node);
-};
-
-template <typename BBType>
-BasicBlockSuccessorHelper<BBType>::BasicBlockSuccessorHelper(
-    Function& func, const BasicBlock* placeholder_start_node, bool invert)
-    : invert_graph_(invert) {
-  CreateSuccessorMap(func, placeholder_start_node);
-}
-
-template <typename BBType>
-void BasicBlockSuccessorHelper<BBType>::CreateSuccessorMap(
-    Function& f, const BasicBlock* placeholder_start_node) {
-  std::map<uint32_t, BasicBlock*> id_to_BB_map;
-  auto GetSuccessorBasicBlock = [&f, &id_to_BB_map](uint32_t successor_id) {
-    BasicBlock*& Succ = id_to_BB_map[successor_id];
-    if (!Succ) {
-      for (BasicBlock& BBIt : f) {
-        if (successor_id == BBIt.id()) {
-          Succ = &BBIt;
-          break;
-        }
+  // Returns the successors of |bb| in the CFG, augmented with the pseudo entry
+  // block, or with the pseudo exit block for a post-dominator tree.
+  const std::vector<BasicBlock*>* Successors(const BasicBlock* bb) {
+    auto inserted = successors_.emplace(bb, std::vector<BasicBlock*>());
+    std::vector<BasicBlock*>& list = inserted.first->second;
+    if (!inserted.second) return &list;
+    if (cfg_.IsPseudoEntryBlock(const_cast<BasicBlock*>(bb))) {
+      list.push_back(function_->entry().get());
+    } else if (!cfg_.IsPseudoExitBlock(const_cast<BasicBlock*>(bb))) {
+      bb->ForEachSuccessorLabel(
+          [this, &list](uint32_t id) { list.push_back(cfg_.block(id)); });
+      if (!bb->hasSuccessor() && invert_graph_) {
+        list.push_back(const_cast<BasicBlock*>(cfg_.pseudo_exit_block()));
       }
     }
-    return Succ;
-  };
+    return &list;
+  }
 
-  if (invert_graph_) {
-    // For the post dominator tree, we see the inverted graph.
-    // successors_ in the inverted graph are the predecessors in the CFG.
-    // The tree construction requires 1 entry point, so we add a placeholder
-    // node that is connected to all function exiting basic blocks. An exiting
-    // basic block is a block with an OpKill, OpUnreachable, OpReturn,
-    // OpReturnValue, or OpTerminateInvocation  as terminator instruction.
-    for (BasicBlock& bb : f) {
-      if (bb.hasSuccessor()) {
-        BasicBlockListTy& pred_list = predecessors_[&bb];
-        const auto& const_bb = bb;
-        const_bb.ForEachSuccessorLabel(
-            [this, &pred_list, &bb,
-             &GetSuccessorBasicBlock](const uint32_t successor_id) {
-              BasicBlock* succ = GetSuccessorBasicBlock(successor_id);
-              // Inverted graph: our successors in the CFG
-              // are our predecessors in the inverted graph.
-              this->successors_[succ].push_back(&bb);
-              pred_list.push_back(succ);
-            });
-      } else {
-        successors_[placeholder_start_node].push_back(&bb);
-        predecessors_[&bb].push_back(
-            const_cast<BasicBlock*>(placeholder_start_node));
+  // Returns the predecessors of |bb| in the CFG, augmented with the pseudo
+  // entry block, or with the pseudo exit block for a post-dominator tree.
+  const std::vector<BasicBlock*>* Predecessors(const BasicBlock* bb) {
+    auto inserted = predecessors_.emplace(bb, std::vector<BasicBlock*>());
+    std::vector<BasicBlock*>& list = inserted.first->second;
+    if (!inserted.second) return &list;
+    if (cfg_.IsPseudoExitBlock(const_cast<BasicBlock*>(bb))) {
+      for (const BasicBlock& block : *function_) {
+        if (!block.hasSuccessor()) {
+          list.push_back(const_cast<BasicBlock*>(&block));
+        }
       }
+    } else if (!cfg_.IsPseudoEntryBlock(const_cast<BasicBlock*>(bb))) {
+      if (bb == function_->entry().get() && !invert_graph_) {
+        list.push_back(const_cast<BasicBlock*>(cfg_.pseudo_entry_block()));
+      }
+      for (uint32_t id : cfg_.preds(bb->id())) list.push_back(cfg_.block(id));
     }
-  } else {
-    successors_[placeholder_start_node].push_back(f.entry().get());
-    predecessors_[f.entry().get()].push_back(
-        const_cast<BasicBlock*>(placeholder_start_node));
-    for (BasicBlock& bb : f) {
-      BasicBlockListTy& succ_list = successors_[&bb];
-
-      const auto& const_bb = bb;
-      const_bb.ForEachSuccessorLabel([&](const uint32_t successor_id) {
-        BasicBlock* succ = GetSuccessorBasicBlock(successor_id);
-        succ_list.push_back(succ);
-        predecessors_[succ].push_back(&bb);
-      });
-    }
+    return &list;
   }
-}
+
+  const CFG& cfg_;
+  const Function* function_;
+  bool invert_graph_;
+  std::unordered_map<const BasicBlock*, std::vector<BasicBlock*>> successors_;
+  std::unordered_map<const BasicBlock*, std::vector<BasicBlock*>>
+      predecessors_;
+};
 
 }  // namespace
 
@@ -292,35 +218,60 @@ DominatorTreeNode* DominatorTree::GetOrInsertNode(BasicBlock* bb) {
 void DominatorTree::GetDominatorEdges(
     const Function* f, const BasicBlock* placeholder_start_node,
     std::vector<std::pair<BasicBlock*, BasicBlock*>>* edges) {
-  // Each time the depth first traversal calls the postorder callback
-  // std::function we push that node into the postorder vector to create our
-  // postorder list.
-  std::vector<const BasicBlock*> postorder;
-  auto postorder_function = [&](const BasicBlock* b) {
-    postorder.push_back(b);
+  // The blocks of |f| are numbered by the snapshot, and the placeholder node
+  // that the tree is rooted at comes after them.  For a post-dominator tree,
+  // all edges are inverted: the successors of a block are its predecessors in
+  // the CFG, and the placeholder node leads to all the exiting blocks (those
+  // ending with an OpKill, OpUnreachable, OpReturn, OpReturnValue, or
+  // OpTerminateInvocation) in function order.
+  const CFGSnapshot snapshot(*f);
+  const uint32_t num_blocks = snapshot.size();
+  const uint32_t placeholder = num_blocks;
+  const uint32_t placeholder_list[] = {placeholder};
+  std::vector<uint32_t> placeholder_successors;
+  if (postdominator_) {
+    for (const BasicBlock& bb : *f) {
+      if (!bb.hasSuccessor()) {
+        placeholder_successors.push_back(snapshot.index(bb.id()));
+      }
+    }
+  } else {
+    placeholder_successors.push_back(snapshot.index(f->entry()->id()));
+  }
+
+  const auto successors = [&](size_t i) -> utils::Span<const uint32_t> {
+    if (i == placeholder) return placeholder_successors;
+    const uint32_t block = static_cast<uint32_t>(i);
+    return postdominator_ ? snapshot.predecessors(block)
+                          : snapshot.successors(block);
+  };
+  // The only predecessor that matters for the entry (or an exiting block) is
+  // the placeholder node, since it dominates everything.
+  const auto predecessors = [&](size_t i) -> utils::Span<const uint32_t> {
+    if (i == placeholder) return {};
+    const uint32_t block = static_cast<uint32_t>(i);
+    if (postdominator_) {
+      if (!snapshot.block(block)->hasSuccessor()) return placeholder_list;
+      return snapshot.successors(block);
+    }
+    if (block == placeholder_successors[0]) return placeholder_list;
+    return snapshot.predecessors(block);
   };
 
-  // CFA::CalculateDominators requires std::vector<BasicBlock*>
-  // BB are derived from F, so we need to const cast it at some point
-  // no modification is made on F.
-  BasicBlockSuccessorHelper<BasicBlock> helper{
-      *const_cast<Function*>(f), placeholder_start_node, postdominator_};
-
-  // The successor function tells DepthFirstTraversal how to move to successive
-  // nodes by providing an interface to get a list of successor nodes from any
-  // given node.
-  auto successor_functor = helper.GetSuccessorFunctor();
-
-  // The predecessor functor does the same as the successor functor
-  // but for all nodes preceding a given node.
-  auto predecessor_functor = helper.GetPredFunctor();
-
-  // If we're building a post dominator tree we traverse the tree in reverse
-  // using the predecessor function in place of the successor function and vice
-  // versa.
-  DepthFirstSearchPostOrder(placeholder_start_node, successor_functor,
-                            postorder_function);
-  *edges = CFA<BasicBlock>::CalculateDominators(postorder, predecessor_functor);
+  const std::vector<size_t> idom = CFA<BasicBlock>::CalculateDominatorIndices(
+      num_blocks + 1, placeholder, successors, predecessors);
+
+  // List the edges in the postorder of the traversal from the placeholder
+  // node, which determines the order of the children in the tree.
+  const auto block = [&](size_t i) {
+    return i == placeholder ? const_cast<BasicBlock*>(placeholder_start_node)
+                            : snapshot.block(static_cast<uint32_t>(i));
+  };
+  edges->clear();
+  for (const size_t i :
+       CFA<BasicBlock>::Postorder(num_blocks + 1, placeholder, successors)) {
+    edges->push_back({block(i), block(idom[i])});
+  }
 }
 
 void DominatorTree::InitializeTree(const CFG& cfg, const Function* f) {
@@ -360,7 +311,9 @@ void DominatorTree::InitializeTree(const CFG& cfg, const Function* f) {
 void DominatorTree::ResetDFNumbering() {
   int index = 0;
   auto preFunc = [&index](const DominatorTreeNode* node) {
-    const_cast<DominatorTreeNode*>(node)->dfs_num_pre_ = ++index;
+    DominatorTreeNode* mutable_node = const_cast<DominatorTreeNode*>(node);
+    mutable_node->dfs_num_pre_ = ++index;
+    mutable_node->depth_ = node->parent_ ? node->parent_->depth_ + 1 : 0;
   };
 
   auto postFunc = [&index](const DominatorTreeNode* node) {
@@ -372,6 +325,137 @@ void DominatorTree::ResetDFNumbering() {
   for (auto root : roots_) DepthFirstSearch(root, getSucc, preFunc, postFunc);
 }
 
+void DominatorTree::SetParent(DominatorTreeNode* node,
+                              DominatorTreeNode* parent) {
+  if (node->parent_ == parent) return;
+  if (node->parent_) {
+    auto& siblings = node->parent_->children_;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+  }
+  node->parent_ = parent;
+  if (parent) parent->children_.push_back(node);
+}
+
+void DominatorTree::ApplyDominatorChanges(
+    const std::vector<std::pair<BasicBlock*, BasicBlock*>>& changes) {
+  for (const auto& change : changes) {
+    SetParent(GetTreeNode(change.first), GetTreeNode(change.second));
+  }
+  ResetDFNumbering();
+}
+
+void DominatorTree::InsertEdge(const CFG& cfg, const Function* f,
+                               BasicBlock* from, BasicBlock* to) {
+  if (postdominator_) {
+    // If |to| is the only successor of |from|, |from| may have had no
+    // successor, and then it was connected to the pseudo exit block by an
+    // edge that is now gone.
+    bool had_no_successor = true;
+    const BasicBlock* const_from = from;
+    const_from->ForEachSuccessorLabel([to, &had_no_successor](uint32_t id) {
+      if (id != to->id()) had_no_successor = false;
+    });
+    if (had_no_successor) {
+      InitializeTree(cfg, f);
+      return;
+    }
+    std::swap(from, to);
+  }
+
+  // An edge from an unreachable block does not change the dominators, but an
+  // edge to an unreachable block changes the reachable blocks.
+  if (!GetTreeNode(from)) return;
+  if (!GetTreeNode(to)) {
+    InitializeTree(cfg, f);
+    return;
+  }
+
+  IncrementalUpdateHelper helper(cfg, f, postdominator_);
+  ApplyDominatorChanges(CFA<BasicBlock>::DominatorsAfterEdgeInsertion(
+      from, to, helper.GetSuccessorFunctor(),
+      [this](const BasicBlock* bb) { return ImmediateDominator(bb); },
+      [this](const BasicBlock* bb) { return GetTreeNode(bb->id())->depth_; }));
+}
+
+void DominatorTree::DeleteEdge(const CFG& cfg, const Function* f,
+                               BasicBlock* from, BasicBlock* to) {
+  if (postdominator_) {
+    // A block left without successor is connected to the pseudo exit block.
+    if (!from->hasSuccessor()) {
+      InitializeTree(cfg, f);
+      return;
+    }
+    std::swap(from, to);
+  }
+
+  // The edge could not be used to reach |to| if it starts in an unreachable
+  // block.
+  if (!GetTreeNode(from) || !GetTreeNode(to)) return;
+
+  IncrementalUpdateHelper helper(cfg, f, postdominator_);
+  std::vector<std::pair<BasicBlock*, BasicBlock*>> changes;
+  if (!CFA<BasicBlock>::DominatorsAfterEdgeDeletion(
+          from, to, helper.GetSuccessorFunctor(), helper.GetPredFunctor(),
+          [this](const BasicBlock* bb) { return ImmediateDominator(bb); },
+          [this](const BasicBlock* bb) {
+            return GetTreeNode(bb->id())->depth_;
+          },
+          &changes)) {
+    // |to| became unreachable, along with all the blocks it dominates.
+    InitializeTree(cfg, f);
+    return;
+  }
+  ApplyDominatorChanges(changes);
+}
+
+void DominatorTree::SplitBlock(BasicBlock* block, BasicBlock* new_block) {
+  DominatorTreeNode* node = GetTreeNode(block);
+  if (!node) return;
+  DominatorTreeNode* new_node = GetOrInsertNode(new_block);
+  if (postdominator_) {
+    // |new_block| post-dominates |block|, and nothing else changes.
+    DominatorTreeNode* parent = node->parent_;
+    SetParent(node, new_node);
+    SetParent(new_node, parent);
+  } else {
+    // |new_block| dominates everything |block| strictly dominated.
+    for (DominatorTreeNode* child : node->children_) child->parent_ = new_node;
+    new_node->children_.swap(node->children_);
+    SetParent(new_node, node);
+  }
+  ResetDFNumbering();
+}
+
+void DominatorTree::MergeBlocks(BasicBlock* block, BasicBlock* merged) {
+  DominatorTreeNode* merged_node = GetTreeNode(merged);
+  if (!merged_node) return;
+  DominatorTreeNode* node = GetTreeNode(block);
+  // The merged block takes the place of the parent of the two nodes, which is
+  // |block| in a dominator tree and |merged| in a post-dominator tree.
+  if (postdominator_) SetParent(node, merged_node->parent_);
+  SetParent(merged_node, nullptr);
+  for (DominatorTreeNode* child : merged_node->children_) {
+    child->parent_ = node;
+    node->children_.push_back(child);
+  }
+  nodes_.erase(merged->id());
+  ResetDFNumbering();
+}
+
+void DominatorTree::RemoveBlock(BasicBlock* bb) {
+  DominatorTreeNode* node = GetTreeNode(bb);
+  if (!node) return;
+  assert(node->parent_ && "Cannot remove the root of the tree.");
+  DominatorTreeNode* parent = node->parent_;
+  SetParent(node, nullptr);
+  for (DominatorTreeNode* child : node->children_) {
+    child->parent_ = parent;
+    parent->children_.push_back(child);
+  }
+  nodes_.erase(bb->id());
+  ResetDFNumbering();
+}
+
 void DominatorTree::DumpTreeAsDot(std::ostream& out_stream) const {
   out_stream << "digraph {\n";
   Visit([&out_stream](const DominatorTreeNode* node) {
@@ -394,5 +478,13 @@ void DominatorTree::DumpTreeAsDot(std::ostream& out_stream) const {
   out_stream << "}\n";
 }
 
+size_t DominatorTree::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(roots_) + utils::MemoryUsage(nodes_);
+  for (const auto& node : nodes_) {
+    bytes += utils::MemoryUsage(node.second.children_);
+  }
+  return bytes;
+}
+
 }  // namespace opt
 }  // namespace spvtools
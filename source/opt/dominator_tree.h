@@ -35,7 +35,8 @@ struct DominatorTreeNode {
         parent_(nullptr),
         children_({}),
         dfs_num_pre_(-1),
-        dfs_num_post_(-1) {}
+        dfs_num_post_(-1),
+        depth_(0) {}
 
   using iterator = std::vector<DominatorTreeNode*>::iterator;
   using const_iterator = std::vector<DominatorTreeNode*>::const_iterator;
@@ -86,6 +87,10 @@ struct DominatorTreeNode {
   // first nodes postorder index.
   int dfs_num_pre_;
   int dfs_num_post_;
+
+  // The depth of the node in the tree, the root being at 0.  Like the indexes
+  // above, it is computed by DominatorTree::ResetDFNumbering.
+  size_t depth_;
 };
 
 // A class representing a tree of BasicBlocks in a given function, where each
@@ -276,6 +281,40 @@ class DominatorTree {
   // Recomputes the DF numbering of the tree.
   void ResetDFNumbering();
 
+  // The following functions update the tree after a change to the control
+  // flow of the function |f| it was built for, instead of rebuilding it. Each
+  // of them must be called right after the change, once |cfg| has been
+  // updated, and before any other change to the control flow is made.
+
+  // Updates the tree after the edge |from| -> |to| has been added to |f|.
+  // The edge is reversed in a post-dominator tree.
+  void InsertEdge(const CFG& cfg, const Function* f, BasicBlock* from,
+                  BasicBlock* to);
+
+  // Updates the tree after the edge |from| -> |to| has been removed from |f|.
+  void DeleteEdge(const CFG& cfg, const Function* f, BasicBlock* from,
+                  BasicBlock* to);
+
+  // Updates the tree after |new_block| has been split from the end of
+  // |block|: |block| must now branch only to |new_block|, which must have
+  // taken over the successors of |block|.
+  void SplitBlock(BasicBlock* block, BasicBlock* new_block);
+
+  // Updates the tree for |merged| being merged into |block|: |block| must be
+  // the only predecessor of |merged|, and |merged| its only successor.  It
+  // must be called before |merged| is deleted.
+  void MergeBlocks(BasicBlock* block, BasicBlock* merged);
+
+  // Removes |bb| from the tree.  |bb| must be unreachable from the entry of
+  // the function, and so must be the blocks it (post-)dominates, which are
+  // moved to the immediate (post-)dominator of |bb| until they are removed
+  // as well.
+  void RemoveBlock(BasicBlock* bb);
+
+  // Returns an approximation of the number of bytes of memory used by this
+  // tree, not counting the blocks it refers to.
+  size_t MemoryUsage() const;
+
  private:
   // Wrapper function which gets the list of pairs of each BasicBlocks to its
   // immediately  dominating BasicBlock and stores the result in the the edges
@@ -289,6 +328,14 @@ class DominatorTree {
       const Function* f, const BasicBlock* dummy_start_node,
       std::vector<std::pair<BasicBlock*, BasicBlock*>>* edges);
 
+  // Makes |parent| the parent of |node|.
+  void SetParent(DominatorTreeNode* node, DominatorTreeNode* parent);
+
+  // Applies the changes computed by an incremental update of the tree,
+  // given as pairs of a basic block and its new immediate dominator.
+  void ApplyDominatorChanges(
+      const std::vector<std::pair<BasicBlock*, BasicBlock*>>& changes);
+
   // The roots of the tree.
   std::vector<DominatorTreeNode*> roots_;
 
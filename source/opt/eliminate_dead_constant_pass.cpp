@@ -93,9 +93,9 @@ Pass::Status EliminateDeadConstantPass::Process() {
   }
 
   // Turn all dead instructions and uses of them to nop
-  for (auto* dc : dead_consts) {
-    context()->KillDef(dc->result_id());
-  }
+  const std::vector<Instruction*> to_kill(dead_consts.begin(),
+                                          dead_consts.end());
+  context()->KillInsts(to_kill);
   return dead_consts.empty() ? Status::SuccessWithoutChange
                              : Status::SuccessWithChange;
 }
@@ -14,6 +14,9 @@
 
 #include "eliminate_dead_functions_util.h"
 
+#include <unordered_set>
+#include <vector>
+
 namespace spvtools {
 namespace opt {
 
@@ -23,9 +26,11 @@ Module::iterator EliminateFunction(IRContext* context,
                                    Module::iterator* func_iter) {
   bool first_func = *func_iter == context->module()->begin();
   bool seen_func_end = false;
+  std::vector<Instruction*> to_kill;
   (*func_iter)
       ->ForEachInst(
-          [context, first_func, func_iter, &seen_func_end](Instruction* inst) {
+          [context, first_func, func_iter, &seen_func_end,
+           &to_kill](Instruction* inst) {
             if (inst->opcode() == SpvOpFunctionEnd) {
               seen_func_end = true;
             }
@@ -45,11 +50,25 @@ Module::iterator EliminateFunction(IRContext* context,
               }
               inst->ToNop();
             } else {
-              context->KillNonSemanticInfo(inst);
-              context->KillInst(inst);
+              to_kill.push_back(inst);
             }
           },
-          true, true);
+          /* run_on_debug_line_insts = */ false,
+          /* run_on_non_semantic_insts = */ true);
+
+  // The non-semantic instruction trees that use the instructions of the
+  // function die with them.
+  std::unordered_set<Instruction*> dead(to_kill.begin(), to_kill.end());
+  for (size_t i = 0; i < to_kill.size(); ++i) {
+    if (!to_kill[i]->HasResultId()) continue;
+    context->get_def_use_mgr()->ForEachUser(
+        to_kill[i], [&dead, &to_kill](Instruction* user) {
+          if (user->IsNonSemanticInstruction() && dead.insert(user).second) {
+            to_kill.push_back(user);
+          }
+        });
+  }
+  context->KillInsts(to_kill);
   return func_iter->Erase();
 }
 
@@ -29,6 +29,8 @@ Pass::Status EliminateDeadMembersPass::Process() {
   if (!context()->get_feature_mgr()->HasCapability(SpvCapabilityShader))
     return Status::SuccessWithoutChange;
 
+  used_members_.clear();
+  fully_used_types_.clear();
   FindLiveMembers();
   if (RemoveDeadMembers()) {
     return Status::SuccessWithChange;
@@ -140,6 +142,11 @@ void EliminateDeadMembersPass::MarkTypeAsFullyUsed(uint32_t type_id) {
     return;
   }
 
+  // Stores of the same struct are common, so only walk each type once.
+  if (!fully_used_types_.insert(type_id).second) {
+    return;
+  }
+
   // Mark every member of the current struct as used.
   for (uint32_t i = 0; i < type_inst->NumInOperands(); ++i) {
     used_members_[type_id].insert(i);
@@ -272,15 +279,11 @@ bool EliminateDeadMembersPass::RemoveDeadMembers() {
   bool modified = false;
 
   // First update all of the OpTypeStruct instructions.
-  get_module()->ForEachInst([&modified, this](Instruction* inst) {
-    switch (inst->opcode()) {
-      case SpvOpTypeStruct:
-        modified |= UpdateOpTypeStruct(inst);
-        break;
-      default:
-        break;
+  for (auto& inst : get_module()->types_values()) {
+    if (inst.opcode() == SpvOpTypeStruct) {
+      modified |= UpdateOpTypeStruct(&inst);
     }
-  });
+  }
 
   // Now update all of the instructions that reference the OpTypeStructs.
   get_module()->ForEachInst([&modified, this](Instruction* inst) {
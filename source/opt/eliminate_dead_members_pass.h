@@ -15,6 +15,10 @@
 #ifndef SOURCE_OPT_ELIMINATE_DEAD_MEMBERS_PASS_H_
 #define SOURCE_OPT_ELIMINATE_DEAD_MEMBERS_PASS_H_
 
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "source/opt/def_use_manager.h"
 #include "source/opt/function.h"
 #include "source/opt/mem_pass.h"
@@ -136,6 +140,11 @@ class EliminateDeadMembersPass : public MemPass {
   // A map from a type id to a set of indices representing the members of the
   // type that are used, and must be kept.
   std::unordered_map<uint32_t, std::set<uint32_t>> used_members_;
+
+  // The ids of the struct types that |MarkTypeAsFullyUsed| already visited.
+  // All of their members, and the members of their subtypes, are in
+  // |used_members_|.
+  std::unordered_set<uint32_t> fully_used_types_;
   void MarkStructOperandsAsFullyUsed(const Instruction* inst);
   void MarkPointeeTypeAsFullUsed(uint32_t ptr_type_id);
 };
@@ -0,0 +1,37 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/fixed_point_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status FixedPointPass::Process() {
+  Status status = Status::SuccessWithoutChange;
+  for (uint32_t iteration = 0; iteration < max_iterations_; ++iteration) {
+    bool modified = false;
+    for (auto& pass : create_passes_()) {
+      pass->SetMessageConsumer(consumer());
+      Status one_status = pass->Run(context());
+      if (one_status == Status::Failure) return Status::Failure;
+      if (one_status == Status::SuccessWithChange) modified = true;
+    }
+    if (!modified) break;
+    status = Status::SuccessWithChange;
+  }
+  return status;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,61 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_FIXED_POINT_PASS_H_
+#define SOURCE_OPT_FIXED_POINT_PASS_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class FixedPointPass : public Pass {
+ public:
+  // Returns new instances of the passes in the group, in the order in which
+  // they run.
+  using PassGroupFactory = std::function<std::vector<std::unique_ptr<Pass>>()>;
+
+  // Creates a pass that runs the passes created by |create_passes| until none
+  // of them changes the module, or until they have run |max_iterations|
+  // times.
+  FixedPointPass(PassGroupFactory create_passes, uint32_t max_iterations)
+      : create_passes_(std::move(create_passes)),
+        max_iterations_(max_iterations) {}
+
+  const char* name() const override { return "fixed-point"; }
+  Status Process() override;
+
+  // The passes in the group invalidate the analyses they do not preserve as
+  // they run.
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::Analysis(IRContext::kAnalysisEnd - 1);
+  }
+
+  // The group of passes is not part of the name.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
+ private:
+  PassGroupFactory create_passes_;
+  uint32_t max_iterations_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_FIXED_POINT_PASS_H_
@@ -280,7 +280,7 @@ uint32_t InstructionFolder::FoldScalars(
 }
 
 bool InstructionFolder::FoldBinaryIntegerOpToConstant(
-    Instruction* inst, const std::function<uint32_t(uint32_t)>& id_map,
+    Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map,
     uint32_t* result) const {
   SpvOp opcode = inst->opcode();
   analysis::ConstantManager* const_manger = context_->get_constant_mgr();
@@ -464,7 +464,7 @@ bool InstructionFolder::FoldBinaryIntegerOpToConstant(
 }
 
 bool InstructionFolder::FoldBinaryBooleanOpToConstant(
-    Instruction* inst, const std::function<uint32_t(uint32_t)>& id_map,
+    Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map,
     uint32_t* result) const {
   SpvOp opcode = inst->opcode();
   analysis::ConstantManager* const_manger = context_->get_constant_mgr();
@@ -512,7 +512,7 @@ bool InstructionFolder::FoldBinaryBooleanOpToConstant(
 }
 
 bool InstructionFolder::FoldIntegerOpToConstant(
-    Instruction* inst, const std::function<uint32_t(uint32_t)>& id_map,
+    Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map,
     uint32_t* result) const {
   assert(IsFoldableOpcode(inst->opcode()) &&
          "Unhandled instruction opcode in FoldScalars");
@@ -624,7 +624,7 @@ bool InstructionFolder::IsFoldableConstant(
 }
 
 Instruction* InstructionFolder::FoldInstructionToConstant(
-    Instruction* inst, std::function<uint32_t(uint32_t)> id_map) const {
+    Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map) const {
   analysis::ConstantManager* const_mgr = context_->get_constant_mgr();
 
   if (!inst->IsFoldableByFoldScalar() &&
@@ -647,7 +647,8 @@ Instruction* InstructionFolder::FoldInstructionToConstant(
   });
 
   const analysis::Constant* folded_const = nullptr;
-  for (auto rule : GetConstantFoldingRules().GetRulesForInstruction(inst)) {
+  for (const ConstantFoldingRule& rule :
+       GetConstantFoldingRules().GetRulesForInstruction(inst)) {
     folded_const = rule(context_, inst, constants);
     if (folded_const != nullptr) {
       Instruction* const_inst =
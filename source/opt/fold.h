@@ -22,6 +22,7 @@
 #include "source/opt/constants.h"
 #include "source/opt/def_use_manager.h"
 #include "source/opt/folding_rules.h"
+#include "source/util/function_ref.h"
 
 namespace spvtools {
 namespace opt {
@@ -96,7 +97,7 @@ class InstructionFolder {
   // constant, but the instruction itself has not been updated yet.  This can
   // map those ids to the appropriate constants.
   Instruction* FoldInstructionToConstant(
-      Instruction* inst, std::function<uint32_t(uint32_t)> id_map) const;
+      Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map) const;
   // Returns true if |inst| can be folded into a simpler instruction.
   // If |inst| can be simplified, |inst| is overwritten with the simplified
   // instruction reusing the same result id.
@@ -153,7 +154,7 @@ class InstructionFolder {
   // for the instruction are any integer (signed or unsigned) with 32-bits or
   // less, or a boolean value.
   bool FoldBinaryIntegerOpToConstant(
-      Instruction* inst, const std::function<uint32_t(uint32_t)>& id_map,
+      Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map,
       uint32_t* result) const;
 
   // Returns true if |inst| is a binary operation on two boolean values, and
@@ -161,7 +162,7 @@ class InstructionFolder {
   // to a constant boolean value when the ids have been replaced using |id_map|.
   // If |inst| can be folded, the result value is returned in |*result|.
   bool FoldBinaryBooleanOpToConstant(
-      Instruction* inst, const std::function<uint32_t(uint32_t)>& id_map,
+      Instruction* inst, utils::FunctionRef<uint32_t(uint32_t)> id_map,
       uint32_t* result) const;
 
   // Returns true if |inst| can be folded to an constant when the ids have been
@@ -169,7 +170,7 @@ class InstructionFolder {
   // not, |result| is unchanged.  It is assumed that not all operands are
   // constant.  Those cases are handled by |FoldScalar|.
   bool FoldIntegerOpToConstant(Instruction* inst,
-                               const std::function<uint32_t(uint32_t)>& id_map,
+                               utils::FunctionRef<uint32_t(uint32_t)> id_map,
                                uint32_t* result) const;
 
   IRContext* context_;
@@ -47,7 +47,13 @@ Pass::Status FoldSpecConstantOpAndCompositePass::Process() {
   // will be processed before its dependee Spec Constant. When we encounter
   // the dependee Spec Constants, all its dependent constants must have been
   // processed and all its dependent Spec Constants should have been folded if
-  // possible.
+  // possible.  A single traversal therefore folds every spec constant whose
+  // value can be determined.
+  //
+  // The folded spec constants are deleted together after the traversal, so
+  // that their names and decorations are removed in one sweep over the module.
+  to_kill_.clear();
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
   Module::inst_iterator next_inst = context()->types_values_begin();
   for (Module::inst_iterator inst_iter = next_inst;
        // Need to re-evaluate the end iterator since we may modify the list of
@@ -62,9 +68,8 @@ Pass::Status FoldSpecConstantOpAndCompositePass::Process() {
     // used in OpSpecConstant{Composite|Op} instructions.
     // TODO(qining): If the constant or its type has decoration, we may need
     // to skip it.
-    if (context()->get_constant_mgr()->GetType(inst) &&
-        !context()->get_constant_mgr()->GetType(inst)->decoration_empty())
-      continue;
+    const analysis::Type* type = const_mgr->GetType(inst);
+    if (type && !type->decoration_empty()) continue;
     switch (SpvOp opcode = inst->opcode()) {
       // Records the values of Normal Constants.
       case SpvOp::SpvOpConstantTrue:
@@ -79,16 +84,20 @@ Pass::Status FoldSpecConstantOpAndCompositePass::Process() {
         // all of its components are Normal Constants already, the Spec
         // Constant will be turned in to a Normal Constant. In that case, a
         // Constant instance should also be created successfully and recorded
-        // in the id_to_const_val_ and const_val_to_id_ mapps.
-        if (auto const_value =
-                context()->get_constant_mgr()->GetConstantFromInst(inst)) {
-          // Need to replace the OpSpecConstantComposite instruction with a
-          // corresponding OpConstantComposite instruction.
-          if (opcode == SpvOp::SpvOpSpecConstantComposite) {
-            inst->SetOpcode(SpvOp::SpvOpConstantComposite);
-            modified = true;
-          }
-          context()->get_constant_mgr()->MapConstantToInst(const_value, inst);
+        // in the id_to_const_val_ and const_val_to_id_ mapps. Constants the
+        // manager already recorded are reused rather than rebuilt, which
+        // matters for composites with many components.
+        const analysis::Constant* const_value =
+            const_mgr->FindDeclaredConstant(inst->result_id());
+        if (const_value == nullptr) {
+          const_value = const_mgr->GetConstantFromInst(inst);
+          if (const_value) const_mgr->MapConstantToInst(const_value, inst);
+        }
+        // Need to replace the OpSpecConstantComposite instruction with a
+        // corresponding OpConstantComposite instruction.
+        if (const_value && opcode == SpvOp::SpvOpSpecConstantComposite) {
+          inst->SetOpcode(SpvOp::SpvOpConstantComposite);
+          modified = true;
         }
         break;
       }
@@ -106,6 +115,8 @@ Pass::Status FoldSpecConstantOpAndCompositePass::Process() {
         break;
     }
   }
+  context()->KillInsts(to_kill_);
+  to_kill_.clear();
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
 }
 
@@ -135,12 +146,12 @@ bool FoldSpecConstantOpAndCompositePass::ProcessOpSpecConstantOp(
   }
   if (!folded_inst) return false;
 
-  // Replace the original constant with the new folded constant, kill the
-  // original constant.
+  // Replace the original constant with the new folded constant.  The original
+  // constant is killed at the end of the pass.
   uint32_t new_id = folded_inst->result_id();
   uint32_t old_id = inst->result_id();
   context()->ReplaceAllUsesWith(old_id, new_id);
-  context()->KillDef(old_id);
+  to_kill_.push_back(inst);
   return true;
 }
 
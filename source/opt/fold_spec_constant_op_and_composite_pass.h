@@ -49,9 +49,9 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
   // will be inserted before the OpSpecConstantOp instruction pointed by the
   // instruction iterator. The instruction iterator, which is passed by
   // pointer, will still point to the original OpSpecConstantOp instruction. If
-  // folding is done successfully, the original OpSpecConstantOp instruction
-  // will be changed to Nop and new folded instruction will be inserted before
-  // it.
+  // folding is done successfully, the uses of the original OpSpecConstantOp
+  // instruction are replaced by the new folded instruction, which is inserted
+  // before it, and the original instruction is added to |to_kill_|.
   bool ProcessOpSpecConstantOp(Module::inst_iterator* pos);
 
   // Returns the result of folding the OpSpecConstantOp instruction
@@ -74,6 +74,9 @@ class FoldSpecConstantOpAndCompositePass : public Pass {
   //
   // |type| must be a composite type.
   uint32_t GetTypeComponent(uint32_t type, uint32_t element) const;
+
+  // The folded spec constants, which are deleted at the end of the pass.
+  std::vector<Instruction*> to_kill_;
 };
 
 }  // namespace opt
@@ -2529,7 +2529,7 @@ void FoldingRules::AddFoldingRules() {
   uint32_t ext_inst_glslstd450_id =
       feature_manager->GetExtInstImportId_GLSLstd450();
   if (ext_inst_glslstd450_id != 0) {
-    ext_rules_[{ext_inst_glslstd450_id, GLSLstd450FMix}].push_back(
+    ext_rules_[ext_inst_glslstd450_id][GLSLstd450FMix].push_back(
         RedundantFMix());
   }
 }
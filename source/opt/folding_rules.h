@@ -16,10 +16,10 @@
 #define SOURCE_OPT_FOLDING_RULES_H_
 
 #include <cstdint>
-#include <unordered_map>
 #include <vector>
 
 #include "source/opt/constants.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -70,11 +70,12 @@ class FoldingRules {
         return it->second;
       }
     } else {
-      uint32_t ext_inst_id = inst->GetSingleWordInOperand(0);
-      uint32_t ext_opcode = inst->GetSingleWordInOperand(1);
-      auto it = ext_rules_.find({ext_inst_id, ext_opcode});
-      if (it != ext_rules_.end()) {
-        return it->second;
+      auto set_it = ext_rules_.find(inst->GetSingleWordInOperand(0));
+      if (set_it != ext_rules_.end()) {
+        auto it = set_it->second.find(inst->GetSingleWordInOperand(1));
+        if (it != set_it->second.end()) {
+          return it->second;
+        }
       }
     }
     return empty_vector_;
@@ -86,26 +87,12 @@ class FoldingRules {
   virtual void AddFoldingRules();
 
  protected:
-  // The folding rules for core instructions.
-  std::unordered_map<uint32_t, FoldingRuleSet> rules_;
-
-  // The folding rules for extended instructions.
-  struct Key {
-    uint32_t instruction_set;
-    uint32_t opcode;
-  };
-
-  friend bool operator<(const Key& a, const Key& b) {
-    if (a.instruction_set < b.instruction_set) {
-      return true;
-    }
-    if (a.instruction_set > b.instruction_set) {
-      return false;
-    }
-    return a.opcode < b.opcode;
-  }
+  // The folding rules for core instructions, indexed by opcode.
+  utils::IdMap<FoldingRuleSet> rules_;
 
-  std::map<Key, FoldingRuleSet> ext_rules_;
+  // The folding rules for extended instructions, indexed by the id of the
+  // extended instruction set, and then by the extended opcode.
+  utils::IdMap<utils::IdMap<FoldingRuleSet>> ext_rules_;
 
  private:
   IRContext* context_;
@@ -56,7 +56,7 @@ Function* Function::Clone(IRContext* ctx) const {
   return clone;
 }
 
-void Function::ForEachInst(const std::function<void(Instruction*)>& f,
+void Function::ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                            bool run_on_debug_line_insts,
                            bool run_on_non_semantic_insts) {
   WhileEachInst(
@@ -67,7 +67,7 @@ void Function::ForEachInst(const std::function<void(Instruction*)>& f,
       run_on_debug_line_insts, run_on_non_semantic_insts);
 }
 
-void Function::ForEachInst(const std::function<void(const Instruction*)>& f,
+void Function::ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                            bool run_on_debug_line_insts,
                            bool run_on_non_semantic_insts) const {
   WhileEachInst(
@@ -78,7 +78,7 @@ void Function::ForEachInst(const std::function<void(const Instruction*)>& f,
       run_on_debug_line_insts, run_on_non_semantic_insts);
 }
 
-bool Function::WhileEachInst(const std::function<bool(Instruction*)>& f,
+bool Function::WhileEachInst(utils::FunctionRef<bool(Instruction*)> f,
                              bool run_on_debug_line_insts,
                              bool run_on_non_semantic_insts) {
   if (def_inst_) {
@@ -125,7 +125,7 @@ bool Function::WhileEachInst(const std::function<bool(Instruction*)>& f,
   return true;
 }
 
-bool Function::WhileEachInst(const std::function<bool(const Instruction*)>& f,
+bool Function::WhileEachInst(utils::FunctionRef<bool(const Instruction*)> f,
                              bool run_on_debug_line_insts,
                              bool run_on_non_semantic_insts) const {
   if (def_inst_) {
@@ -174,14 +174,14 @@ bool Function::WhileEachInst(const std::function<bool(const Instruction*)>& f,
   return true;
 }
 
-void Function::ForEachParam(const std::function<void(Instruction*)>& f,
+void Function::ForEachParam(utils::FunctionRef<void(Instruction*)> f,
                             bool run_on_debug_line_insts) {
   for (auto& param : params_)
     static_cast<Instruction*>(param.get())
         ->ForEachInst(f, run_on_debug_line_insts);
 }
 
-void Function::ForEachParam(const std::function<void(const Instruction*)>& f,
+void Function::ForEachParam(utils::FunctionRef<void(const Instruction*)> f,
                             bool run_on_debug_line_insts) const {
   for (const auto& param : params_)
     static_cast<const Instruction*>(param.get())
@@ -189,7 +189,7 @@ void Function::ForEachParam(const std::function<void(const Instruction*)>& f,
 }
 
 void Function::ForEachDebugInstructionsInHeader(
-    const std::function<void(Instruction*)>& f) {
+    utils::FunctionRef<void(Instruction*)> f) {
   if (debug_insts_in_header_.empty()) return;
 
   Instruction* di = &debug_insts_in_header_.front();
@@ -241,15 +241,7 @@ bool Function::HasEarlyReturn() const {
 
 bool Function::IsRecursive() const {
   IRContext* ctx = blocks_.front()->GetLabel()->context();
-  IRContext::ProcessFunction mark_visited = [this](Function* fp) {
-    return fp == this;
-  };
-
-  // Process the call tree from all of the function called by |this|.  If it get
-  // back to |this|, then we have a recursive function.
-  std::queue<uint32_t> roots;
-  ctx->AddCalls(this, &roots);
-  return ctx->ProcessCallTreeFromRoots(mark_visited, &roots);
+  return ctx->GetCallGraph()->IsRecursive(this);
 }
 
 std::ostream& operator<<(std::ostream& str, const Function& func) {
@@ -25,6 +25,7 @@
 #include "source/opt/basic_block.h"
 #include "source/opt/instruction.h"
 #include "source/opt/iterator.h"
+#include "source/util/function_ref.h"
 
 namespace spvtools {
 namespace opt {
@@ -69,6 +70,13 @@ class Function {
   // contained in this function.
   inline void MoveBasicBlockToAfter(uint32_t id, BasicBlock* ip);
 
+  // Moves the blocks of |order| to the front of the function, in that order.
+  // The other blocks follow in their current order.  Returns true if the order
+  // of the blocks changed.
+  bool ReorderBasicBlocks(const std::vector<BasicBlock*>& order) {
+    return ReorderUptrVector(&blocks_, order);
+  }
+
   // Delete all basic blocks that contain no instructions.
   inline void RemoveEmptyBlocks();
 
@@ -122,35 +130,35 @@ class Function {
   // Runs the given function |f| on instructions in this function, in order,
   // and optionally on debug line instructions that might precede them and
   // non-semantic instructions that succceed the function.
-  void ForEachInst(const std::function<void(Instruction*)>& f,
+  void ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                    bool run_on_debug_line_insts = false,
                    bool run_on_non_semantic_insts = false);
-  void ForEachInst(const std::function<void(const Instruction*)>& f,
+  void ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                    bool run_on_debug_line_insts = false,
                    bool run_on_non_semantic_insts = false) const;
   // Runs the given function |f| on instructions in this function, in order,
   // and optionally on debug line instructions that might precede them and
   // non-semantic instructions that succeed the function.  If |f| returns
   // false, iteration is terminated and this function returns false.
-  bool WhileEachInst(const std::function<bool(Instruction*)>& f,
+  bool WhileEachInst(utils::FunctionRef<bool(Instruction*)> f,
                      bool run_on_debug_line_insts = false,
                      bool run_on_non_semantic_insts = false);
-  bool WhileEachInst(const std::function<bool(const Instruction*)>& f,
+  bool WhileEachInst(utils::FunctionRef<bool(const Instruction*)> f,
                      bool run_on_debug_line_insts = false,
                      bool run_on_non_semantic_insts = false) const;
 
   // Runs the given function |f| on each parameter instruction in this function,
   // in order, and optionally on debug line instructions that might precede
   // them.
-  void ForEachParam(const std::function<void(const Instruction*)>& f,
+  void ForEachParam(utils::FunctionRef<void(const Instruction*)> f,
                     bool run_on_debug_line_insts = false) const;
-  void ForEachParam(const std::function<void(Instruction*)>& f,
+  void ForEachParam(utils::FunctionRef<void(Instruction*)> f,
                     bool run_on_debug_line_insts = false);
 
   // Runs the given function |f| on each debug instruction in this function's
   // header in order.
   void ForEachDebugInstructionsInHeader(
-      const std::function<void(Instruction*)>& f);
+      utils::FunctionRef<void(Instruction*)> f);
 
   BasicBlock* InsertBasicBlockAfter(std::unique_ptr<BasicBlock>&& new_block,
                                     BasicBlock* position);
@@ -0,0 +1,92 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/function_pipeline_pass.h"
+
+#include <unordered_set>
+
+#include "source/opt/function_result_cache.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+Pass::Status FunctionPipelinePass::Process() {
+  // The passes do not add or remove functions while the filter is set, so the
+  // functions can be collected up front.
+  std::vector<Function*> functions;
+  for (auto& fn : *get_module()) {
+    functions.push_back(&fn);
+  }
+
+  FunctionResultCache* cache =
+      recipe_.empty() ? nullptr : context()->function_cache();
+  std::vector<uint32_t> prefix;
+  if (cache && !FunctionResultCache::ComputeModulePrefix(context(), recipe_,
+                                                         &prefix)) {
+    cache = nullptr;
+  }
+
+  // The functions called from an entry point are found again after a
+  // function changes, since it may have stopped calling some of them.
+  std::unordered_set<const Function*> reachable;
+  bool reachable_is_stale = true;
+  ProcessFunction add_reachable = [&reachable](Function* fn) {
+    reachable.insert(fn);
+    return false;
+  };
+
+  Status status = Status::SuccessWithoutChange;
+  for (Function* fn : functions) {
+    if (cache && reachable_is_stale) {
+      reachable.clear();
+      context()->ProcessEntryPointCallTree(add_reachable);
+      reachable_is_stale = false;
+    }
+    FunctionResultCache::Signature signature;
+    if (!cache || !FunctionResultCache::ComputeSignature(
+                      context(), prefix, *fn, reachable.count(fn) != 0,
+                      &signature)) {
+      status = CombineStatus(status, RunPasses(fn));
+    } else {
+      Status fn_status = Status::SuccessWithoutChange;
+      if (!cache->Replay(context(), signature, fn, &fn_status)) {
+        fn_status = RunPasses(fn);
+        if (fn_status != Status::Failure) {
+          cache->Record(context(), std::move(signature), *fn,
+                        fn_status == Status::SuccessWithChange);
+        }
+      }
+      status = CombineStatus(status, fn_status);
+      if (fn_status == Status::SuccessWithChange) reachable_is_stale = true;
+    }
+    if (status == Status::Failure) break;
+  }
+  return status;
+}
+
+Pass::Status FunctionPipelinePass::RunPasses(Function* fn) {
+  Status status = Status::SuccessWithoutChange;
+  context()->set_function_filter(fn);
+  for (auto& pass : create_passes_()) {
+    pass->SetMessageConsumer(consumer());
+    status = CombineStatus(status, pass->Run(context()));
+    if (status == Status::Failure) break;
+  }
+  context()->set_function_filter(nullptr);
+  return status;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_FUNCTION_PIPELINE_PASS_H_
+#define SOURCE_OPT_FUNCTION_PIPELINE_PASS_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// Runs a group of function-local passes one function at a time: every pass in
+// the group is applied to the first function, then every pass to the second
+// function, and so on.  The result is the same as running each pass on the
+// whole module in turn, but a function stays hot in the cache while it is
+// transformed, and the analyses each pass preserves are reused by the next.
+//
+// The passes run with a function filter set on the context (see
+// |IRContext::set_function_filter|), so they skip their module-wide steps,
+// such as the removal of dead globals by ADCE.  Those steps are left to a pass
+// over the whole module that follows this one.
+//
+// If the group has a recipe name and the context has a function cache (see
+// |IRContext::set_function_cache|), the result of the group on each function
+// is recorded in the cache under that name, and replayed rather than computed
+// again on the same functions of the modules that follow.  The name must tell
+// apart the groups of passes that can make different results.
+class FunctionPipelinePass : public Pass {
+ public:
+  // Returns new instances of the passes in the group, in the order in which
+  // they run.
+  using PassGroupFactory = std::function<std::vector<std::unique_ptr<Pass>>()>;
+
+  explicit FunctionPipelinePass(PassGroupFactory create_passes,
+                                std::string recipe = "")
+      : create_passes_(std::move(create_passes)), recipe_(std::move(recipe)) {}
+
+  const char* name() const override { return "function-pipeline"; }
+  Status Process() override;
+
+  // The passes in the group invalidate the analyses they do not preserve as
+  // they run.
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::Analysis(IRContext::kAnalysisEnd - 1);
+  }
+
+  // The group of passes is not part of the name.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
+ private:
+  // Runs the passes of the group on |fn| alone.
+  Status RunPasses(Function* fn);
+
+  PassGroupFactory create_passes_;
+  // The name under which the results are cached, or "" if they are not.
+  std::string recipe_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_FUNCTION_PIPELINE_PASS_H_
@@ -0,0 +1,578 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/function_result_cache.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include "source/opcode.h"
+#include "source/operand.h"
+#include "source/opt/function.h"
+#include "source/opt/ir_context.h"
+#include "source/util/make_unique.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// The references of a recorded result are tagged with their kind in their
+// top two bits.
+const uint32_t kRefKindMask = 3u << 30;
+const uint32_t kOldRef = 0u << 30;     // A canonical id of the signature.
+const uint32_t kGlobalRef = 1u << 30;  // An |Entry::globals| instruction.
+const uint32_t kNewRef = 2u << 30;     // An id new to the function.
+const uint32_t kNoRef = ~0u;
+
+// Appends to |words| the opcode and the operands of |inst|, replacing each id
+// operand by the result of |map_id|.
+template <typename MapId>
+void AppendInstruction(const Instruction& inst, MapId map_id,
+                       std::vector<uint32_t>* words) {
+  words->push_back(static_cast<uint32_t>(inst.opcode()) |
+                   (inst.NumOperands() << 16));
+  for (const Operand& operand : inst) {
+    words->push_back(static_cast<uint32_t>(operand.type) |
+                     (static_cast<uint32_t>(operand.words.size()) << 16));
+    if (spvIsIdType(operand.type)) {
+      words->push_back(map_id(operand.words[0]));
+    } else {
+      words->insert(words->end(), operand.words.begin(), operand.words.end());
+    }
+  }
+}
+
+// Returns true if |inst| is an extended instruction whose semantics do not
+// come from its operands alone, such as debug info.
+bool IsDebugOrNonSemanticExtInst(IRContext* context, const Instruction& inst) {
+  if (inst.opcode() != SpvOpExtInst) return false;
+  const Instruction* set =
+      context->get_def_use_mgr()->GetDef(inst.GetSingleWordInOperand(0));
+  const std::string name = set->GetInOperand(0).AsString();
+  return name.compare(0, 12, "NonSemantic.") == 0 ||
+         name.find("DebugInfo") != std::string::npos;
+}
+
+// Builds the canonical form of one function.
+class SignatureBuilder {
+ public:
+  SignatureBuilder(IRContext* context,
+                   FunctionResultCache::Signature* signature)
+      : context_(context), signature_(signature) {}
+
+  // Writes the canonical form of |function|, after |prefix|.  |reachable|
+  // tells whether |function| is called from an entry point.  Returns false
+  // if |function| cannot be cached.
+  bool Build(const std::vector<uint32_t>& prefix, const Function& function,
+             bool reachable) {
+    function.ForEachInst(
+        [this](const Instruction* inst) {
+          if (inst->result_id()) local_ids_.insert(inst->result_id());
+        },
+        /* run_on_debug_line_insts = */ false,
+        /* run_on_non_semantic_insts = */ true);
+
+    std::vector<uint32_t>& words = signature_->words;
+    words = prefix;
+    words.push_back(reachable);
+    const uint32_t function_id = function.result_id();
+    for (const Instruction& inst : context_->module()->entry_points()) {
+      if (inst.GetSingleWordInOperand(1) != function_id) continue;
+      // The name of the entry point makes no difference to the passes.
+      words.push_back(SpvOpEntryPoint | (inst.NumInOperands() << 16));
+      words.push_back(inst.GetSingleWordInOperand(0));
+      for (uint32_t i = 3; i < inst.NumInOperands(); ++i) {
+        words.push_back(CanonicalId(inst.GetSingleWordInOperand(i)));
+      }
+    }
+    for (const Instruction& inst : context_->module()->execution_modes()) {
+      if (inst.GetSingleWordInOperand(0) == function_id) Append(inst, &words);
+    }
+    bool cacheable = function.WhileEachInst(
+        [this, &words](const Instruction* inst) {
+          if (inst->has_dbg_lines() ||
+              inst->GetDebugScope().GetLexicalScope() != kNoDebugScope ||
+              IsDebugOrNonSemanticExtInst(context_, *inst)) {
+            return false;
+          }
+          Append(*inst, &words);
+          return true;
+        },
+        /* run_on_debug_line_insts = */ false,
+        /* run_on_non_semantic_insts = */ true);
+    if (!cacheable) return false;
+
+    // Add the definitions of the module-level instructions and the
+    // decorations, which may refer to more ids, until every id referred to
+    // has been described.
+    std::vector<uint32_t> globals;
+    analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+    analysis::DecorationManager* decoration_mgr =
+        context_->get_decoration_mgr();
+    for (uint32_t index = 0; index < signature_->ids.size(); ++index) {
+      const uint32_t id = signature_->ids[index];
+      if (!signature_->is_local[index]) {
+        const Instruction* def = def_use_mgr->GetDef(id);
+        if (def == nullptr) return false;
+        Append(*def, &globals);
+      }
+      uint32_t num_decorations = 0;
+      for (const Instruction* decoration :
+           decoration_mgr->GetDecorationsFor(id, true)) {
+        Append(*decoration, &globals);
+        ++num_decorations;
+      }
+      if (num_decorations && signature_->is_local[index]) {
+        signature_->local_decoration_counts[index] = num_decorations;
+      }
+    }
+    words.push_back(static_cast<uint32_t>(globals.size()));
+    words.insert(words.end(), globals.begin(), globals.end());
+    return true;
+  }
+
+ private:
+  // Returns the canonical id of |id|, numbering it if it is the first
+  // reference to it.
+  uint32_t CanonicalId(uint32_t id) {
+    auto result = canonical_ids_.insert(
+        {id, static_cast<uint32_t>(signature_->ids.size())});
+    if (result.second) {
+      signature_->ids.push_back(id);
+      signature_->is_local.push_back(local_ids_.count(id) != 0);
+    }
+    return result.first->second;
+  }
+
+  void Append(const Instruction& inst, std::vector<uint32_t>* words) {
+    AppendInstruction(inst, [this](uint32_t id) { return CanonicalId(id); },
+                      words);
+  }
+
+  IRContext* context_;
+  FunctionResultCache::Signature* signature_;
+  // The canonical id of each id referred to so far.
+  std::unordered_map<uint32_t, uint32_t> canonical_ids_;
+  // The ids defined by the function.
+  std::unordered_set<uint32_t> local_ids_;
+};
+
+}  // namespace
+
+// Records the result of the recipe on a function.  The ids of the
+// instructions of the function are replaced by references to the canonical
+// ids of the signature, to the module-level instructions the recipe added or
+// started using, or to ids new to the function.
+class FunctionResultCache::Recorder {
+ public:
+  Recorder(IRContext* context, const Signature& signature, Entry* entry)
+      : context_(context), signature_(signature), entry_(entry) {
+    for (uint32_t index = 0; index < signature.ids.size(); ++index) {
+      refs_[signature.ids[index]] = kOldRef | index;
+    }
+  }
+
+  // Records |function| in the entry.  Returns false if it cannot be
+  // replayed.
+  bool Record(const Function& function) {
+    function.ForEachInst(
+        [this](const Instruction* inst) {
+          if (inst->result_id()) local_ids_.insert(inst->result_id());
+        },
+        /* run_on_debug_line_insts = */ false,
+        /* run_on_non_semantic_insts = */ true);
+
+    for (const BasicBlock& block : function) {
+      entry_->blocks.emplace_back();
+      std::vector<RecordedInstruction>* insts = &entry_->blocks.back();
+      bool recorded =
+          block.WhileEachInst([this, insts](const Instruction* inst) {
+            if (inst->has_dbg_lines() ||
+                inst->GetDebugScope().GetLexicalScope() != kNoDebugScope) {
+              return false;
+            }
+            insts->emplace_back();
+            return RecordInstruction(*inst, &insts->back());
+          });
+      if (!recorded) return false;
+    }
+
+    // The ids new to the function keep their decorations, but they cannot be
+    // given names.  The new ids their decorations refer to are defined by the
+    // function, so they are already numbered.
+    analysis::DecorationManager* decoration_mgr =
+        context_->get_decoration_mgr();
+    for (uint32_t id : new_ids_) {
+      auto names = context_->GetNames(id);
+      if (names.begin() != names.end()) return false;
+      for (const Instruction* decoration :
+           decoration_mgr->GetDecorationsFor(id, true)) {
+        entry_->decorations.emplace_back();
+        if (!RecordInstruction(*decoration, &entry_->decorations.back())) {
+          return false;
+        }
+      }
+    }
+
+    // The decorations of the ids the recipe kept must not have changed, since
+    // they are not replayed.
+    for (uint32_t index = 0; index < signature_.ids.size(); ++index) {
+      if (!signature_.is_local[index]) continue;
+      const uint32_t id = signature_.ids[index];
+      if (!local_ids_.count(id)) {
+        entry_->removed_ids.push_back(index);
+        continue;
+      }
+      auto it = signature_.local_decoration_counts.find(index);
+      const size_t num_decorations =
+          it == signature_.local_decoration_counts.end() ? 0 : it->second;
+      if (decoration_mgr->GetDecorationsFor(id, true).size() !=
+          num_decorations) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Sets |ref| to the reference for |id|, recording the module-level
+  // instruction that defines it if needed.  Returns false if there cannot be
+  // a reference to |id|.
+  bool GetRef(uint32_t id, uint32_t* ref) {
+    auto it = refs_.find(id);
+    if (it != refs_.end()) {
+      *ref = it->second;
+      return true;
+    }
+    if (local_ids_.count(id)) {
+      *ref = kNewRef | entry_->num_new_ids++;
+      refs_[id] = *ref;
+      new_ids_.push_back(id);
+      return true;
+    }
+    return RecordGlobal(id, ref);
+  }
+
+  // Records the type and the operands of |inst| in |recorded|.
+  bool RecordOperands(const Instruction& inst, RecordedInstruction* recorded) {
+    recorded->opcode = inst.opcode();
+    recorded->type_ref = kNoRef;
+    recorded->result_ref = kNoRef;
+    if (inst.type_id() && !GetRef(inst.type_id(), &recorded->type_ref)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
+      recorded->in_operands.push_back(inst.GetInOperand(i));
+      Operand& operand = recorded->in_operands.back();
+      if (spvIsIdType(operand.type) &&
+          !GetRef(operand.words[0], &operand.words[0])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Records |inst|, an instruction of the function or a decoration.
+  bool RecordInstruction(const Instruction& inst,
+                         RecordedInstruction* recorded) {
+    if (!RecordOperands(inst, recorded)) return false;
+    return !inst.result_id() || GetRef(inst.result_id(), &recorded->result_ref);
+  }
+
+  // Records the module-level instruction that defines |id|, which the
+  // signature does not refer to.  Only undecorated types, constants and
+  // undefined values that can be found again or added to another module can
+  // be recorded.
+  bool RecordGlobal(uint32_t id, uint32_t* ref) {
+    const Instruction* def = context_->get_def_use_mgr()->GetDef(id);
+    if (def == nullptr) return false;
+    const SpvOp opcode = def->opcode();
+    const bool is_type = spvOpcodeGeneratesType(opcode) &&
+                         opcode != SpvOpTypeStruct &&
+                         opcode != SpvOpTypeForwardPointer;
+    const bool is_value = spvOpcodeIsConstantOrUndef(opcode) &&
+                          !spvOpcodeIsSpecConstant(opcode);
+    if ((!is_type && !is_value) ||
+        !context_->get_decoration_mgr()->GetDecorationsFor(id, true).empty()) {
+      return false;
+    }
+
+    // The instructions it refers to come first.
+    RecordedInstruction recorded;
+    if (!RecordOperands(*def, &recorded)) return false;
+    *ref = kGlobalRef | static_cast<uint32_t>(entry_->globals.size());
+    recorded.result_ref = *ref;
+    refs_[id] = *ref;
+    entry_->globals.push_back(std::move(recorded));
+    return true;
+  }
+
+  IRContext* context_;
+  const Signature& signature_;
+  Entry* entry_;
+  // The reference for each id referred to so far.
+  std::unordered_map<uint32_t, uint32_t> refs_;
+  // The ids defined by the function after the recipe.
+  std::unordered_set<uint32_t> local_ids_;
+  // The ids new to the function, in the order of their references.
+  std::vector<uint32_t> new_ids_;
+};
+
+size_t FunctionResultCache::WordsHash::operator()(
+    const std::vector<uint32_t>& words) const {
+  // 64-bit FNV-1a, applied to whole words.
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint32_t word : words) {
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+bool FunctionResultCache::ComputeModulePrefix(IRContext* context,
+                                              const std::string& recipe,
+                                              std::vector<uint32_t>* prefix) {
+  // The decorations of a group cannot be told apart from those of its
+  // members when the recipe copies them.
+  for (const Instruction& inst : context->module()->annotations()) {
+    if (inst.opcode() == SpvOpDecorationGroup) return false;
+  }
+
+  prefix->clear();
+  prefix->push_back(static_cast<uint32_t>(recipe.size()));
+  prefix->insert(prefix->end(), recipe.begin(), recipe.end());
+  prefix->push_back(context->preserve_bindings());
+  prefix->push_back(context->preserve_spec_constants());
+  // The remaining module-level settings have no ids.
+  auto no_ids = [](uint32_t id) { return id; };
+  for (const Instruction& inst : context->module()->capabilities()) {
+    AppendInstruction(inst, no_ids, prefix);
+  }
+  for (const Instruction& inst : context->module()->extensions()) {
+    AppendInstruction(inst, no_ids, prefix);
+  }
+  if (const Instruction* memory_model = context->module()->GetMemoryModel()) {
+    AppendInstruction(*memory_model, no_ids, prefix);
+  }
+  return true;
+}
+
+bool FunctionResultCache::ComputeSignature(IRContext* context,
+                                           const std::vector<uint32_t>& prefix,
+                                           const Function& function,
+                                           bool reachable,
+                                           Signature* signature) {
+  *signature = Signature();
+  return SignatureBuilder(context, signature)
+      .Build(prefix, function, reachable);
+}
+
+bool FunctionResultCache::Replay(IRContext* context,
+                                 const Signature& signature,
+                                 Function* function, Pass::Status* status) {
+  std::shared_ptr<const Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(signature.words);
+    if (it == entries_.end()) {
+      ++num_misses_;
+      return false;
+    }
+    ++num_hits_;
+    entry = it->second;
+  }
+
+  if (!entry->changed) {
+    *status = Pass::Status::SuccessWithoutChange;
+  } else if (ApplyEntry(context, signature, *entry, function)) {
+    *status = Pass::Status::SuccessWithChange;
+  } else {
+    *status = Pass::Status::Failure;
+  }
+  return true;
+}
+
+void FunctionResultCache::Record(IRContext* context, Signature&& signature,
+                                 const Function& function, bool changed) {
+  auto entry = MakeUnique<Entry>();
+  entry->changed = changed;
+  if (changed && !Recorder(context, signature, entry.get()).Record(function)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.emplace(std::move(signature.words), std::move(entry));
+}
+
+bool FunctionResultCache::ApplyEntry(IRContext* context,
+                                     const Signature& signature,
+                                     const Entry& entry, Function* function) {
+  std::vector<uint32_t> global_ids;
+  std::vector<uint32_t> new_ids(entry.num_new_ids);
+  auto map_ref = [&signature, &global_ids, &new_ids](uint32_t ref) {
+    if (ref == kNoRef) return 0u;
+    const uint32_t index = ref & ~kRefKindMask;
+    switch (ref & kRefKindMask) {
+      case kOldRef:
+        return signature.ids[index];
+      case kGlobalRef:
+        return global_ids[index];
+      default:
+        return new_ids[index];
+    }
+  };
+  auto map_operands = [&map_ref](const RecordedInstruction& recorded) {
+    Instruction::OperandList operands = recorded.in_operands;
+    for (Operand& operand : operands) {
+      if (spvIsIdType(operand.type)) {
+        operand.words[0] = map_ref(operand.words[0]);
+      }
+    }
+    return operands;
+  };
+
+  // Find the module-level instructions the result refers to, or add them.
+  analysis::DecorationManager* decoration_mgr = context->get_decoration_mgr();
+  bool added_globals = false;
+  for (const RecordedInstruction& recorded : entry.globals) {
+    const uint32_t type_id = map_ref(recorded.type_ref);
+    Instruction::OperandList operands = map_operands(recorded);
+    uint32_t id = 0;
+    for (const Instruction& inst : context->types_values()) {
+      if (inst.opcode() != recorded.opcode || inst.type_id() != type_id ||
+          inst.NumInOperands() != operands.size() ||
+          !decoration_mgr->GetDecorationsFor(inst.result_id(), true).empty()) {
+        continue;
+      }
+      bool same = true;
+      for (uint32_t i = 0; same && i < operands.size(); ++i) {
+        same = inst.GetInOperand(i) == operands[i];
+      }
+      if (same) {
+        id = inst.result_id();
+        break;
+      }
+    }
+    if (id == 0) {
+      id = context->TakeNextId();
+      if (id == 0) return false;
+      auto inst = MakeUnique<Instruction>(context, recorded.opcode, type_id, id,
+                                          operands);
+      if (spvOpcodeGeneratesType(recorded.opcode)) {
+        context->AddType(std::move(inst));
+      } else {
+        context->AddGlobalValue(std::move(inst));
+      }
+      added_globals = true;
+    }
+    global_ids.push_back(id);
+  }
+  for (uint32_t& id : new_ids) {
+    id = context->TakeNextId();
+    if (id == 0) return false;
+  }
+
+  // Remove the names and decorations of the ids the recipe removed, and then
+  // the blocks of the function.
+  for (uint32_t index : entry.removed_ids) {
+    context->KillNamesAndDecorates(signature.ids[index]);
+  }
+  const bool update_def_use =
+      context->AreAnalysesValid(IRContext::kAnalysisDefUse);
+  analysis::DefUseManager* def_use_mgr =
+      update_def_use ? context->get_def_use_mgr() : nullptr;
+  if (update_def_use) {
+    for (BasicBlock& block : *function) {
+      block.ForEachInst(
+          [def_use_mgr](Instruction* inst) { def_use_mgr->ClearInst(inst); });
+    }
+  }
+  for (auto it = function->begin(); it != function->end();) {
+    it = it.Erase();
+  }
+
+  // Add the blocks of the result.
+  std::vector<Instruction*> new_insts;
+  for (const std::vector<RecordedInstruction>& recorded_block : entry.blocks) {
+    std::unique_ptr<BasicBlock> block;
+    for (const RecordedInstruction& recorded : recorded_block) {
+      auto inst = MakeUnique<Instruction>(
+          context, recorded.opcode, map_ref(recorded.type_ref),
+          map_ref(recorded.result_ref), map_operands(recorded));
+      new_insts.push_back(inst.get());
+      if (block == nullptr) {
+        block = MakeUnique<BasicBlock>(std::move(inst));
+      } else {
+        block->AddInstruction(std::move(inst));
+      }
+    }
+    block->SetParent(function);
+    function->AddBasicBlock(std::move(block));
+  }
+  if (update_def_use) {
+    for (Instruction* inst : new_insts) def_use_mgr->AnalyzeInstDef(inst);
+    for (Instruction* inst : new_insts) def_use_mgr->AnalyzeInstUse(inst);
+    // The names and decorations of the ids the recipe kept lost their uses
+    // when the old definitions were cleared.
+    for (Instruction* inst : new_insts) {
+      const uint32_t id = inst->result_id();
+      if (id == 0) continue;
+      for (auto& name : context->GetNames(id)) {
+        def_use_mgr->AnalyzeInstUse(name.second);
+      }
+      for (Instruction* decoration :
+           decoration_mgr->GetDecorationsFor(id, true)) {
+        def_use_mgr->AnalyzeInstUse(decoration);
+      }
+    }
+  }
+
+  for (const RecordedInstruction& recorded : entry.decorations) {
+    context->AddAnnotationInst(MakeUnique<Instruction>(
+        context, recorded.opcode, 0, 0, map_operands(recorded)));
+  }
+
+  IRContext::Analysis preserved = IRContext::kAnalysisDefUse |
+                                  IRContext::kAnalysisDecorations |
+                                  IRContext::kAnalysisNameMap;
+  if (!added_globals) {
+    preserved |= IRContext::kAnalysisTypes | IRContext::kAnalysisConstants;
+  }
+  context->InvalidateAnalysesExceptFor(preserved);
+  return true;
+}
+
+size_t FunctionResultCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t FunctionResultCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+size_t FunctionResultCache::num_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+void FunctionResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  num_hits_ = 0;
+  num_misses_ = 0;
+}
+
+}  // namespace opt
+}  // namespace spvtools
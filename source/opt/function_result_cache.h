@@ -0,0 +1,178 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_FUNCTION_RESULT_CACHE_H_
+#define SOURCE_OPT_FUNCTION_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/instruction.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+class Function;
+class IRContext;
+
+// Remembers what a group of function-local passes made of the functions it
+// was run on, so that the same function in another module is not analyzed and
+// optimized again.  The group of passes is identified by a recipe name chosen
+// by its user, such as the |FunctionPipelinePass| of the legalization passes.
+//
+// A function is identified by its canonical form: its instructions, and the
+// module-level instructions and decorations they refer to, directly or not,
+// with ids numbered in the order in which they are first referred to.  The
+// capabilities, extensions and memory model of the module, and the entry
+// points and execution modes of the function, and whether it is called from an
+// entry point, are part of it as well.  Two
+// functions with the same canonical form are the same function up to their
+// ids, so whatever the passes did to the first one is replayed on the second
+// one with its ids, and ids taken from the second module for the new
+// instructions.  The names of the ids are not part of the canonical form and
+// are kept.
+//
+// This is only sound if the passes of the recipe look at nothing else: they
+// must not use the contents of the functions called by the function, nor the
+// other settings of the context, such as an attached profile.  Functions
+// with debug line or debug info instructions, and modules with decoration
+// groups, are never cached.
+//
+// All methods are thread-safe, so that the cache can be shared by the modules
+// optimized at the same time.
+class FunctionResultCache {
+ public:
+  // The canonical form of a function of a module.
+  struct Signature {
+    // The canonical form, which identifies the function in the cache.
+    std::vector<uint32_t> words;
+    // The id in the module of each canonical id, in canonical order.
+    std::vector<uint32_t> ids;
+    // Whether each canonical id is defined by the function itself.
+    std::vector<bool> is_local;
+    // The number of decorations of each canonical id defined by the function
+    // that has decorations.
+    std::unordered_map<uint32_t, uint32_t> local_decoration_counts;
+  };
+
+  FunctionResultCache() : num_hits_(0), num_misses_(0) {}
+
+  // Disables copy/move constructor/assignment operations.
+  FunctionResultCache(const FunctionResultCache&) = delete;
+  FunctionResultCache(FunctionResultCache&&) = delete;
+  FunctionResultCache& operator=(const FunctionResultCache&) = delete;
+  FunctionResultCache& operator=(FunctionResultCache&&) = delete;
+
+  // Writes to |prefix| the part of the canonical form of the functions of the
+  // module of |context| that they share: |recipe| and the module-level
+  // settings.  Returns false if no function of the module can be cached.
+  static bool ComputeModulePrefix(IRContext* context, const std::string& recipe,
+                                  std::vector<uint32_t>* prefix);
+
+  // Writes to |signature| the canonical form of |function|, starting with
+  // |prefix| as computed by |ComputeModulePrefix|.  |reachable| tells whether
+  // |function| is called from an entry point, since many passes only process
+  // those functions.  Returns false if |function| cannot be cached.
+  static bool ComputeSignature(IRContext* context,
+                               const std::vector<uint32_t>& prefix,
+                               const Function& function, bool reachable,
+                               Signature* signature);
+
+  // If the result of the recipe has been recorded for a function with the
+  // canonical form |signature|, replays it on |function|, which must be the
+  // function |signature| was computed for, sets |status| to the status of the
+  // recipe, and returns true.  |status| is a failure if the module runs out of
+  // ids.  Returns false if no result has been recorded.
+  bool Replay(IRContext* context, const Signature& signature,
+              Function* function, Pass::Status* status);
+
+  // Records |function| as the result of the recipe on the function whose
+  // canonical form was |signature| before the recipe ran, with |changed|
+  // telling whether the recipe changed the module.  Nothing is recorded if
+  // the result cannot be replayed, such as when the recipe created global
+  // variables.
+  void Record(IRContext* context, Signature&& signature,
+              const Function& function, bool changed);
+
+  // Returns the number of recorded results.
+  size_t size() const;
+  // Returns the number of calls to |Replay| that found a result, and the
+  // number that did not.
+  size_t num_hits() const;
+  size_t num_misses() const;
+
+  // Forgets all recorded results.
+  void clear();
+
+ private:
+  // The words of an instruction recorded in a result, with the ids replaced by
+  // references (see |Entry|).
+  struct RecordedInstruction {
+    SpvOp opcode;
+    uint32_t type_ref;
+    uint32_t result_ref;
+    Instruction::OperandList in_operands;
+  };
+
+  // The recorded result of the recipe on a function.  The ids of the
+  // instructions are references: the canonical ids of the function before the
+  // recipe, module-level instructions the recipe added or started using, and
+  // ids new to the function.  |kNoRef| stands for no type or result id.
+  struct Entry {
+    // Whether the recipe changed the module.  Nothing else is recorded if it
+    // did not.
+    bool changed = false;
+    // The module-level instructions the recipe added or started using, in an
+    // order in which each one refers only to the ones before it.
+    std::vector<RecordedInstruction> globals;
+    // The number of ids new to the function.
+    uint32_t num_new_ids = 0;
+    // The blocks of the function, each starting with its OpLabel.
+    std::vector<std::vector<RecordedInstruction>> blocks;
+    // The decorations of the ids new to the function.
+    std::vector<RecordedInstruction> decorations;
+    // The canonical ids defined by the function that the recipe removed.
+    std::vector<uint32_t> removed_ids;
+  };
+
+  // Records the result of the recipe on a function in |entry|.
+  class Recorder;
+
+  // Replays |entry| on |function|, whose canonical form is |signature|, with
+  // the ids of its module.  Returns false if the module runs out of ids.
+  static bool ApplyEntry(IRContext* context, const Signature& signature,
+                         const Entry& entry, Function* function);
+
+  // Hashes the canonical form of a function.
+  struct WordsHash {
+    size_t operator()(const std::vector<uint32_t>& words) const;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::vector<uint32_t>, std::shared_ptr<const Entry>,
+                     WordsHash>
+      entries_;
+  size_t num_hits_;
+  size_t num_misses_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_FUNCTION_RESULT_CACHE_H_
@@ -269,6 +269,9 @@ void GraphicsRobustAccessPass::ClampIndicesForAccessChain(
   auto* type_mgr = context()->get_type_mgr();
   const bool have_int64_cap =
       context()->get_feature_mgr()->HasCapability(SpvCapabilityInt64);
+  const BasicBlock* block = context()->get_instr_block(&inst);
+  ValueRangeAnalysis* value_range =
+      context()->GetValueRangeAnalysis(block->GetParent());
 
   // Replaces one of the OpAccessChain index operands with a new value.
   // Updates def-use analysis.
@@ -298,7 +301,8 @@ void GraphicsRobustAccessPass::ClampIndicesForAccessChain(
   // |count| then no change is made.
   auto clamp_to_literal_count =
       [&inst, this, &constant_mgr, &type_mgr, have_int64_cap, &replace_index,
-       &clamp_index](uint32_t operand_index, uint64_t count) -> spv_result_t {
+       block, value_range](uint32_t operand_index,
+                           uint64_t count) -> spv_result_t {
     Instruction* index_inst =
         this->GetDef(inst.GetSingleWordOperand(operand_index));
     const auto* index_type =
@@ -367,6 +371,19 @@ void GraphicsRobustAccessPass::ClampIndicesForAccessChain(
                              GetValueForType(maxval, maxval_type));
       }
     } else {
+      // If the index is already known to be in range, there is nothing to
+      // do.
+      if (value_range->IsInRange(index_inst, block, 0, int64_t(maxval))) {
+        return SPV_SUCCESS;
+      }
+      // Reuse the clamp of the same index by an earlier access chain in this
+      // block.
+      const auto clamp_key = std::make_tuple(
+          block->id(), index_inst->result_id(), maxval_width, maxval);
+      auto clamped = module_status_.clamped_indices.find(clamp_key);
+      if (clamped != module_status_.clamped_indices.end()) {
+        return replace_index(operand_index, clamped->second);
+      }
       // Generate a clamp instruction.
       assert(maxval >= 1);
       assert(index_width <= 64);  // Otherwise, already returned above.
@@ -396,9 +413,12 @@ void GraphicsRobustAccessPass::ClampIndicesForAccessChain(
       }
 
       // Finally, clamp the index.
-      return clamp_index(operand_index, index_inst,
-                         GetValueForType(0, maxval_type),
-                         GetValueForType(maxval, maxval_type));
+      auto* clamp_inst = MakeSClampInst(*type_mgr, index_inst,
+                                        GetValueForType(0, maxval_type),
+                                        GetValueForType(maxval, maxval_type),
+                                        &inst);
+      module_status_.clamped_indices[clamp_key] = clamp_inst;
+      return replace_index(operand_index, clamp_inst);
     }
     return SPV_SUCCESS;
   };
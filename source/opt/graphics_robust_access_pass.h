@@ -16,6 +16,7 @@
 #define SOURCE_OPT_GRAPHICS_ROBUST_ACCESS_PASS_H_
 
 #include <map>
+#include <tuple>
 #include <unordered_map>
 
 #include "constants.h"
@@ -147,6 +148,11 @@ class GraphicsRobustAccessPass : public Pass {
     // The id of the GLSL.std.450 extended instruction set.  Zero if it does
     // not exist.
     uint32_t glsl_insts_id = 0;
+    // Map from the block id, index id, bit width and maximum value of a
+    // clamped index to the clamp instruction, for reuse by later access
+    // chains in the same block.
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t, uint64_t>, Instruction*>
+        clamped_indices;
   } module_status_;
 };
 
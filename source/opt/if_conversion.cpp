@@ -39,10 +39,7 @@ Pass::Status IfConversion::Process() {
       if (!CheckBlock(&block, dominators, &common)) continue;
 
       // Get an insertion point.
-      auto iter = block.begin();
-      while (iter != block.end() && iter->opcode() == SpvOpPhi) {
-        ++iter;
-      }
+      auto iter = block.GetFirstNonPhi();
 
       InstructionBuilder builder(
           context(), &*iter,
@@ -25,8 +25,12 @@ Pass::Status InlineExhaustivePass::InlineExhaustive(Function* func) {
   bool modified = false;
   // Using block iterators here because of block erasures and insertions.
   for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    // Calls in blocks that never executed in the profile are not worth the
+    // code size, unless they must be inlined to legalize the module.
+    bool cold_block = context()->IsColdBlock(&*bi);
     for (auto ii = bi->begin(); ii != bi->end();) {
-      if (IsInlinableFunctionCall(&*ii)) {
+      if (IsInlinableFunctionCall(&*ii) &&
+          (!cold_block || HasOpaqueArgsOrReturn(&*ii))) {
         // Inline call.
         std::vector<std::unique_ptr<BasicBlock>> newBlocks;
         std::vector<std::unique_ptr<Instruction>> newVars;
@@ -28,6 +28,7 @@
 static const int kSpvFunctionCallFunctionId = 2;
 static const int kSpvFunctionCallArgumentId = 3;
 static const int kSpvReturnValueId = 0;
+static const int kSpvTypePointerTypeIdInIdx = 1;
 
 namespace spvtools {
 namespace opt {
@@ -85,14 +86,14 @@ void InlinePass::AddLoopMerge(uint32_t merge_id, uint32_t continue_id,
 
 void InlinePass::AddStore(uint32_t ptr_id, uint32_t val_id,
                           std::unique_ptr<BasicBlock>* block_ptr,
-                          const Instruction* line_inst,
+                          const DebugLine* line,
                           const DebugScope& dbg_scope) {
   std::unique_ptr<Instruction> newStore(
       new Instruction(context(), SpvOpStore, 0, 0,
                       {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {ptr_id}},
                        {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {val_id}}}));
-  if (line_inst != nullptr) {
-    newStore->dbg_line_insts().push_back(*line_inst);
+  if (line != nullptr) {
+    newStore->AddDbgLine(*line);
   }
   newStore->SetDebugScope(dbg_scope);
   (*block_ptr)->AddInstruction(std::move(newStore));
@@ -100,13 +101,13 @@ void InlinePass::AddStore(uint32_t ptr_id, uint32_t val_id,
 
 void InlinePass::AddLoad(uint32_t type_id, uint32_t resultId, uint32_t ptr_id,
                          std::unique_ptr<BasicBlock>* block_ptr,
-                         const Instruction* line_inst,
+                         const DebugLine* line,
                          const DebugScope& dbg_scope) {
   std::unique_ptr<Instruction> newLoad(
       new Instruction(context(), SpvOpLoad, type_id, resultId,
                       {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {ptr_id}}}));
-  if (line_inst != nullptr) {
-    newLoad->dbg_line_insts().push_back(*line_inst);
+  if (line != nullptr) {
+    newLoad->AddDbgLine(*line);
   }
   newLoad->SetDebugScope(dbg_scope);
   (*block_ptr)->AddInstruction(std::move(newLoad));
@@ -140,7 +141,7 @@ uint32_t InlinePass::GetFalseId() {
 
 void InlinePass::MapParams(
     Function* calleeFn, BasicBlock::iterator call_inst_itr,
-    std::unordered_map<uint32_t, uint32_t>* callee2caller) {
+    utils::IdMap<uint32_t>* callee2caller) {
   int param_idx = 0;
   calleeFn->ForEachParam(
       [&call_inst_itr, &param_idx, &callee2caller](const Instruction* cpi) {
@@ -153,7 +154,7 @@ void InlinePass::MapParams(
 
 bool InlinePass::CloneAndMapLocals(
     Function* calleeFn, std::vector<std::unique_ptr<Instruction>>* new_vars,
-    std::unordered_map<uint32_t, uint32_t>* callee2caller,
+    utils::IdMap<uint32_t>* callee2caller,
     analysis::DebugInlinedAtContext* inlined_at_ctx) {
   auto callee_block_itr = calleeFn->begin();
   auto callee_var_itr = callee_block_itr->begin();
@@ -276,7 +277,7 @@ void InlinePass::MoveInstsBeforeEntryBlock(
 
 std::unique_ptr<BasicBlock> InlinePass::AddGuardBlock(
     std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
-    std::unordered_map<uint32_t, uint32_t>* callee2caller,
+    utils::IdMap<uint32_t>* callee2caller,
     std::unique_ptr<BasicBlock> new_blk_ptr, uint32_t entry_blk_label_id) {
   const auto guard_block_id = context()->TakeNextId();
   if (guard_block_id == 0) {
@@ -294,7 +295,7 @@ std::unique_ptr<BasicBlock> InlinePass::AddGuardBlock(
 }
 
 InstructionList::iterator InlinePass::AddStoresForVariableInitializers(
-    const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+    const utils::IdMap<uint32_t>& callee2caller,
     analysis::DebugInlinedAtContext* inlined_at_ctx,
     std::unique_ptr<BasicBlock>* new_blk_ptr,
     UptrVectorIterator<BasicBlock> callee_first_block_itr) {
@@ -311,7 +312,7 @@ InstructionList::iterator InlinePass::AddStoresForVariableInitializers(
       // The initializer must be a constant or global value.  No mapped
       // should be used.
       uint32_t val_id = callee_itr->GetSingleWordInOperand(1);
-      AddStore(new_var_id, val_id, new_blk_ptr, callee_itr->dbg_line_inst(),
+      AddStore(new_var_id, val_id, new_blk_ptr, callee_itr->dbg_line(),
                context()->get_debug_info_mgr()->BuildDebugScope(
                    callee_itr->GetDebugScope(), inlined_at_ctx));
     }
@@ -328,8 +329,8 @@ InstructionList::iterator InlinePass::AddStoresForVariableInitializers(
 }
 
 bool InlinePass::InlineSingleInstruction(
-    const std::unordered_map<uint32_t, uint32_t>& callee2caller,
-    BasicBlock* new_blk_ptr, const Instruction* inst, uint32_t dbg_inlined_at) {
+    const utils::IdMap<uint32_t>& callee2caller, BasicBlock* new_blk_ptr,
+    const Instruction* inst, uint32_t dbg_inlined_at) {
   // If we have return, it must be at the end of the callee. We will handle
   // it at the end.
   if (inst->opcode() == SpvOpReturnValue || inst->opcode() == SpvOpReturn)
@@ -362,7 +363,7 @@ bool InlinePass::InlineSingleInstruction(
 }
 
 std::unique_ptr<BasicBlock> InlinePass::InlineReturn(
-    const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+    const utils::IdMap<uint32_t>& callee2caller,
     std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
     std::unique_ptr<BasicBlock> new_blk_ptr,
     analysis::DebugInlinedAtContext* inlined_at_ctx, Function* calleeFn,
@@ -375,7 +376,7 @@ std::unique_ptr<BasicBlock> InlinePass::InlineReturn(
     if (mapItr != callee2caller.end()) {
       valId = mapItr->second;
     }
-    AddStore(returnVarId, valId, &new_blk_ptr, inst->dbg_line_inst(),
+    AddStore(returnVarId, valId, &new_blk_ptr, inst->dbg_line(),
              context()->get_debug_info_mgr()->BuildDebugScope(
                  inst->GetDebugScope(), inlined_at_ctx));
   }
@@ -399,7 +400,7 @@ std::unique_ptr<BasicBlock> InlinePass::InlineReturn(
 }
 
 bool InlinePass::InlineEntryBlock(
-    const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+    const utils::IdMap<uint32_t>& callee2caller,
     std::unique_ptr<BasicBlock>* new_blk_ptr,
     UptrVectorIterator<BasicBlock> callee_first_block,
     analysis::DebugInlinedAtContext* inlined_at_ctx) {
@@ -421,7 +422,7 @@ bool InlinePass::InlineEntryBlock(
 
 std::unique_ptr<BasicBlock> InlinePass::InlineBasicBlocks(
     std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
-    const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+    const utils::IdMap<uint32_t>& callee2caller,
     std::unique_ptr<BasicBlock> new_blk_ptr,
     analysis::DebugInlinedAtContext* inlined_at_ctx, Function* calleeFn) {
   auto callee_block_itr = calleeFn->begin();
@@ -506,7 +507,7 @@ bool InlinePass::GenInlineCode(
     UptrVectorIterator<BasicBlock> call_block_itr) {
   // Map from all ids in the callee to their equivalent id in the caller
   // as callee instructions are copied into caller.
-  std::unordered_map<uint32_t, uint32_t> callee2caller;
+  utils::IdMap<uint32_t> callee2caller;
   // Pre-call same-block insts
   std::unordered_map<uint32_t, Instruction*> preCallSB;
   // Post-call same-block op ids
@@ -577,16 +578,22 @@ bool InlinePass::GenInlineCode(
     }
   }
 
-  calleeFn->WhileEachInst([&callee2caller, this](const Instruction* cpi) {
-    // Create set of callee result ids. Used to detect forward references
+  // Create set of callee result ids. Used to detect forward references.  The
+  // new ids are taken all at once.
+  std::vector<uint32_t> callee_result_ids;
+  calleeFn->ForEachInst([&callee2caller,
+                         &callee_result_ids](const Instruction* cpi) {
     const uint32_t rid = cpi->result_id();
     if (rid != 0 && callee2caller.find(rid) == callee2caller.end()) {
-      const uint32_t nid = context()->TakeNextId();
-      if (nid == 0) return false;
-      callee2caller[rid] = nid;
+      callee_result_ids.push_back(rid);
     }
-    return true;
   });
+  if (!callee_result_ids.empty()) {
+    uint32_t nid = context()->TakeNextIdRange(
+        static_cast<uint32_t>(callee_result_ids.size()));
+    if (nid == 0) return false;
+    for (uint32_t rid : callee_result_ids) callee2caller[rid] = nid++;
+  }
 
   // Inline DebugClare instructions in the callee's header.
   calleeFn->ForEachDebugInstructionsInHeader(
@@ -618,7 +625,7 @@ bool InlinePass::GenInlineCode(
     const uint32_t resId = call_inst_itr->result_id();
     assert(resId != 0);
     AddLoad(calleeTypeId, resId, returnVarId, &new_blk_ptr,
-            call_inst_itr->dbg_line_inst(), call_inst_itr->GetDebugScope());
+            call_inst_itr->dbg_line(), call_inst_itr->GetDebugScope());
   } else {
     // Even though it is very unlikely, it is possible that the result id of
     // the void-function call is used, so we need to generate an instruction
@@ -658,12 +665,15 @@ bool InlinePass::IsInlinableFunctionCall(const Instruction* inst) {
   if (early_return_funcs_.find(calleeFnId) != early_return_funcs_.end()) {
     // We rely on the merge-return pass to handle the early return case
     // in advance.
-    std::string message =
-        "The function '" + id2function_[calleeFnId]->DefInst().PrettyPrint() +
-        "' could not be inlined because the return instruction "
-        "is not at the end of the function. This could be fixed by "
-        "running merge-return before inlining.";
-    consumer()(SPV_MSG_WARNING, "", {0, 0, 0}, message.c_str());
+    if (consumer()) {
+      std::string message =
+          "The function '" +
+          id2function_[calleeFnId]->DefInst().PrettyPrint() +
+          "' could not be inlined because the return instruction "
+          "is not at the end of the function. This could be fixed by "
+          "running merge-return before inlining.";
+      consumer()(SPV_MSG_WARNING, "", {0, 0, 0}, message.c_str());
+    }
     return false;
   }
 
@@ -754,6 +764,43 @@ bool InlinePass::IsInlinableFunction(Function* func) {
   return true;
 }
 
+bool InlinePass::IsOpaqueType(uint32_t typeId) {
+  const Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  switch (typeInst->opcode()) {
+    case SpvOpTypeSampler:
+    case SpvOpTypeImage:
+    case SpvOpTypeSampledImage:
+      return true;
+    case SpvOpTypePointer:
+      return IsOpaqueType(
+          typeInst->GetSingleWordInOperand(kSpvTypePointerTypeIdInIdx));
+    default:
+      break;
+  }
+  // TODO(greg-lunarg): Handle arrays containing opaque type
+  if (typeInst->opcode() != SpvOpTypeStruct) return false;
+  // Return true if any member is opaque
+  return !typeInst->WhileEachInId([this](const uint32_t* tid) {
+    if (IsOpaqueType(*tid)) return false;
+    return true;
+  });
+}
+
+bool InlinePass::HasOpaqueArgsOrReturn(const Instruction* callInst) {
+  // Check return type
+  if (IsOpaqueType(callInst->type_id())) return true;
+  // Check args
+  int icnt = 0;
+  return !callInst->WhileEachInId([&icnt, this](const uint32_t* iid) {
+    if (icnt > 0) {
+      const Instruction* argInst = get_def_use_mgr()->GetDef(*iid);
+      if (IsOpaqueType(argInst->type_id())) return false;
+    }
+    ++icnt;
+    return true;
+  });
+}
+
 bool InlinePass::ContainsKillOrTerminateInvocation(Function* func) const {
   return !func->WhileEachInst([](Instruction* inst) {
     const auto opcode = inst->opcode();
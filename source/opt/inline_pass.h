@@ -28,6 +28,7 @@
 #include "source/opt/decoration_manager.h"
 #include "source/opt/module.h"
 #include "source/opt/pass.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -60,12 +61,12 @@ class InlinePass : public Pass {
   // Add store of valId to ptrId to end of block block_ptr.
   void AddStore(uint32_t ptrId, uint32_t valId,
                 std::unique_ptr<BasicBlock>* block_ptr,
-                const Instruction* line_inst, const DebugScope& dbg_scope);
+                const DebugLine* line, const DebugScope& dbg_scope);
 
   // Add load of ptrId into resultId to end of block block_ptr.
   void AddLoad(uint32_t typeId, uint32_t resultId, uint32_t ptrId,
                std::unique_ptr<BasicBlock>* block_ptr,
-               const Instruction* line_inst, const DebugScope& dbg_scope);
+               const DebugLine* line, const DebugScope& dbg_scope);
 
   // Return new label.
   std::unique_ptr<Instruction> NewLabel(uint32_t label_id);
@@ -77,12 +78,12 @@ class InlinePass : public Pass {
 
   // Map callee params to caller args
   void MapParams(Function* calleeFn, BasicBlock::iterator call_inst_itr,
-                 std::unordered_map<uint32_t, uint32_t>* callee2caller);
+                 utils::IdMap<uint32_t>* callee2caller);
 
   // Clone and map callee locals.  Return true if successful.
   bool CloneAndMapLocals(Function* calleeFn,
                          std::vector<std::unique_ptr<Instruction>>* new_vars,
-                         std::unordered_map<uint32_t, uint32_t>* callee2caller,
+                         utils::IdMap<uint32_t>* callee2caller,
                          analysis::DebugInlinedAtContext* inlined_at_ctx);
 
   // Create return variable for callee clone code.  The return type of
@@ -128,6 +129,12 @@ class InlinePass : public Pass {
   // Return true if |inst| is a function call that can be inlined.
   bool IsInlinableFunctionCall(const Instruction* inst);
 
+  // Return true if |typeId| is or contains opaque type
+  bool IsOpaqueType(uint32_t typeId);
+
+  // Return true if function call |callInst| has opaque argument or return type
+  bool HasOpaqueArgsOrReturn(const Instruction* callInst);
+
   // Return true if |func| has no return in a loop. The current analysis
   // requires structured control flow, so return false if control flow not
   // structured ie. module is not a shader.
@@ -185,25 +192,24 @@ class InlinePass : public Pass {
   // |new_blocks|.
   std::unique_ptr<BasicBlock> AddGuardBlock(
       std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
-      std::unordered_map<uint32_t, uint32_t>* callee2caller,
+      utils::IdMap<uint32_t>* callee2caller,
       std::unique_ptr<BasicBlock> new_blk_ptr, uint32_t entry_blk_label_id);
 
   // Add store instructions for initializers of variables.
   InstructionList::iterator AddStoresForVariableInitializers(
-      const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+      const utils::IdMap<uint32_t>& callee2caller,
       analysis::DebugInlinedAtContext* inlined_at_ctx,
       std::unique_ptr<BasicBlock>* new_blk_ptr,
       UptrVectorIterator<BasicBlock> callee_block_itr);
 
   // Inlines a single instruction of the callee function.
   bool InlineSingleInstruction(
-      const std::unordered_map<uint32_t, uint32_t>& callee2caller,
-      BasicBlock* new_blk_ptr, const Instruction* inst,
-      uint32_t dbg_inlined_at);
+      const utils::IdMap<uint32_t>& callee2caller, BasicBlock* new_blk_ptr,
+      const Instruction* inst, uint32_t dbg_inlined_at);
 
   // Inlines the return instruction of the callee function.
   std::unique_ptr<BasicBlock> InlineReturn(
-      const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+      const utils::IdMap<uint32_t>& callee2caller,
       std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
       std::unique_ptr<BasicBlock> new_blk_ptr,
       analysis::DebugInlinedAtContext* inlined_at_ctx, Function* calleeFn,
@@ -211,7 +217,7 @@ class InlinePass : public Pass {
 
   // Inlines the entry block of the callee function.
   bool InlineEntryBlock(
-      const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+      const utils::IdMap<uint32_t>& callee2caller,
       std::unique_ptr<BasicBlock>* new_blk_ptr,
       UptrVectorIterator<BasicBlock> callee_first_block,
       analysis::DebugInlinedAtContext* inlined_at_ctx);
@@ -220,7 +226,7 @@ class InlinePass : public Pass {
   // block.
   std::unique_ptr<BasicBlock> InlineBasicBlocks(
       std::vector<std::unique_ptr<BasicBlock>>* new_blocks,
-      const std::unordered_map<uint32_t, uint32_t>& callee2caller,
+      const utils::IdMap<uint32_t>& callee2caller,
       std::unique_ptr<BasicBlock> new_blk_ptr,
       analysis::DebugInlinedAtContext* inlined_at_ctx, Function* calleeFn);
 
@@ -0,0 +1,205 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/inline_selective_pass.h"
+
+#include <iterator>
+#include <utility>
+
+#include "source/opcode.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+
+// The largest callee, in instructions, that is inlined at a call site outside
+// of a loop whose arguments are not constants.
+const uint32_t kInlineThreshold = 40;
+
+// The factor applied to |kInlineThreshold| for calls in a loop.
+const uint32_t kLoopThresholdFactor = 2;
+
+// The number of instructions added to the threshold for each constant
+// argument, which folding is likely to remove from the inlined code.
+const uint32_t kConstantArgumentBonus = 10;
+
+}  // namespace
+
+uint32_t InlineSelectivePass::FunctionSize(const Function& func) {
+  uint32_t size = 0;
+  for (const auto& bb : func) {
+    size += static_cast<uint32_t>(std::distance(bb.begin(), bb.end()));
+  }
+  return size;
+}
+
+void InlineSelectivePass::AddCalleesFirst(Function* func,
+                                          std::unordered_set<uint32_t>* visited,
+                                          std::vector<Function*>* order) {
+  if (!visited->insert(func->result_id()).second) return;
+  func->ForEachInst([this, visited, order](Instruction* inst) {
+    if (inst->opcode() != SpvOpFunctionCall) return;
+    auto it = id2function_.find(
+        inst->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx));
+    if (it != id2function_.end()) AddCalleesFirst(it->second, visited, order);
+  });
+  order->push_back(func);
+}
+
+bool InlineSelectivePass::ShouldInline(const Instruction* call_inst,
+                                       bool in_loop) {
+  // Calls with opaque arguments or results must be inlined for the module to
+  // be legal, whatever their cost.
+  if (HasOpaqueArgsOrReturn(call_inst)) return true;
+
+  // When this is the only call, the callee becomes dead once it is inlined, so
+  // the module does not grow.
+  const uint32_t callee_id =
+      call_inst->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+  if (call_count_[callee_id] == 1) return true;
+
+  uint32_t threshold = kInlineThreshold;
+  if (in_loop) threshold *= kLoopThresholdFactor;
+  for (uint32_t i = kFunctionCallFunctionIdInIdx + 1;
+       i < call_inst->NumInOperands(); ++i) {
+    const Instruction* arg_inst =
+        get_def_use_mgr()->GetDef(call_inst->GetSingleWordInOperand(i));
+    if (spvOpcodeIsConstant(arg_inst->opcode())) {
+      threshold += kConstantArgumentBonus;
+    }
+  }
+
+  const uint32_t callee_size = function_size_[callee_id];
+  if (callee_size > threshold) return false;
+
+  // The call instruction itself goes away.
+  const uint64_t growth = callee_size > 0 ? callee_size - 1 : 0;
+  if (growth > remaining_budget_) return false;
+  remaining_budget_ -= growth;
+  return true;
+}
+
+void InlineSelectivePass::SelectCalls(Function* func) {
+  uint32_t size = function_size_[func->result_id()];
+  for (auto& bb : *func) {
+    const bool in_loop =
+        context()->GetStructuredCFGAnalysis()->ContainingLoop(bb.id()) != 0;
+    for (auto& inst : bb) {
+      if (!IsInlinableFunctionCall(&inst)) continue;
+      if (!ShouldInline(&inst, in_loop)) continue;
+      calls_to_inline_.insert(inst.result_id());
+      const uint32_t callee_size = function_size_[inst.GetSingleWordInOperand(
+          kFunctionCallFunctionIdInIdx)];
+      if (callee_size > 0) size += callee_size - 1;
+    }
+  }
+  function_size_[func->result_id()] = size;
+}
+
+Pass::Status InlineSelectivePass::InlineSelected(Function* func) {
+  bool modified = false;
+  // Using block iterators here because of block erasures and insertions.
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    for (auto ii = bi->begin(); ii != bi->end();) {
+      if (ii->opcode() == SpvOpFunctionCall &&
+          calls_to_inline_.count(ii->result_id()) != 0) {
+        // Inline call.
+        std::vector<std::unique_ptr<BasicBlock>> newBlocks;
+        std::vector<std::unique_ptr<Instruction>> newVars;
+        if (!GenInlineCode(&newBlocks, &newVars, ii, bi)) {
+          return Status::Failure;
+        }
+        // If call block is replaced with more than one block, point
+        // succeeding phis at new last block.
+        if (newBlocks.size() > 1) UpdateSucceedingPhis(newBlocks);
+
+        // We need to kill the name and decorations for the call, which
+        // will be deleted.
+        context()->KillNamesAndDecorates(&*ii);
+
+        // Replace old calling block with new block(s).
+        bi = bi.Erase();
+        for (auto& bb : newBlocks) {
+          bb->SetParent(func);
+        }
+        bi = bi.InsertBefore(&newBlocks);
+        // Insert new function variables.
+        if (newVars.size() > 0)
+          func->begin()->begin().InsertBefore(std::move(newVars));
+        // Restart inlining at beginning of calling block.
+        ii = bi->begin();
+        modified = true;
+      } else {
+        ++ii;
+      }
+    }
+  }
+  return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
+}
+
+InlineSelectivePass::InlineSelectivePass(uint32_t growth_budget_percent)
+    : growth_budget_percent_(growth_budget_percent), remaining_budget_(0) {}
+
+Pass::Status InlineSelectivePass::Process() {
+  InitializeInline();
+  function_size_.clear();
+  call_count_.clear();
+  calls_to_inline_.clear();
+
+  uint64_t module_size = 0;
+  for (auto& func : *get_module()) {
+    const uint32_t size = FunctionSize(func);
+    function_size_[func.result_id()] = size;
+    module_size += size;
+    func.ForEachInst([this](Instruction* inst) {
+      if (inst->opcode() == SpvOpFunctionCall) {
+        ++call_count_[inst->GetSingleWordInOperand(
+            kFunctionCallFunctionIdInIdx)];
+      }
+    });
+  }
+  remaining_budget_ = module_size * growth_budget_percent_ / 100;
+
+  // Entry points are called from outside the module, so they never become
+  // dead.  Visit their call trees callees first, so that the size of a callee
+  // includes the calls inlined into it when its callers are processed.
+  std::vector<Function*> order;
+  std::unordered_set<uint32_t> visited;
+  for (auto& entry_point : get_module()->entry_points()) {
+    const uint32_t func_id =
+        entry_point.GetSingleWordInOperand(kEntryPointFunctionIdInIdx);
+    ++call_count_[func_id];
+    auto it = id2function_.find(func_id);
+    if (it != id2function_.end()) AddCalleesFirst(it->second, &visited, &order);
+  }
+
+  // All decisions are made before the module changes, while the structured
+  // CFG analysis is still valid.
+  for (Function* func : order) {
+    SelectCalls(func);
+  }
+
+  Status status = Status::SuccessWithoutChange;
+  for (Function* func : order) {
+    status = CombineStatus(status, InlineSelected(func));
+    if (status == Status::Failure) break;
+  }
+  return status;
+}
+
+}  // namespace opt
+}  // namespace spvtools
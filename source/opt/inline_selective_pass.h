@@ -0,0 +1,82 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INLINE_SELECTIVE_PASS_H_
+#define SOURCE_OPT_INLINE_SELECTIVE_PASS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/inline_pass.h"
+#include "source/opt/module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class InlineSelectivePass : public InlinePass {
+ public:
+  explicit InlineSelectivePass(uint32_t growth_budget_percent);
+  Status Process() override;
+
+  const char* name() const override { return "inline-entry-points-selective"; }
+
+  // The behavior of the pass depends on its growth budget.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
+ private:
+  // Returns the number of instructions in the blocks of |func|.
+  static uint32_t FunctionSize(const Function& func);
+
+  // Adds the functions in the call tree of |func| to |order|, callees before
+  // their callers.  |visited| holds the ids of the functions already added.
+  void AddCalleesFirst(Function* func, std::unordered_set<uint32_t>* visited,
+                       std::vector<Function*>* order);
+
+  // Returns true if the call |call_inst|, in a block that is in a loop if
+  // |in_loop| is true, is worth inlining.  Charges the growth it causes to
+  // the remaining budget.
+  bool ShouldInline(const Instruction* call_inst, bool in_loop);
+
+  // Decides which calls in |func| are inlined and adds their result ids to
+  // |calls_to_inline_|.  The callees of |func| must have been processed
+  // already, so that their sizes account for the calls inlined into them.
+  void SelectCalls(Function* func);
+
+  // Inlines the calls in |func| that were selected by |SelectCalls|.
+  Status InlineSelected(Function* func);
+
+  // The code growth allowed, as a percentage of the size of the functions in
+  // the module.
+  uint32_t growth_budget_percent_;
+
+  // The number of instructions that the remaining calls may still add.
+  uint64_t remaining_budget_;
+
+  // The size of each function once the calls selected in it are inlined.
+  std::unordered_map<uint32_t, uint32_t> function_size_;
+
+  // The number of calls to each function in the module.
+  std::unordered_map<uint32_t, uint32_t> call_count_;
+
+  // The result ids of the calls to inline.
+  std::unordered_set<uint32_t> calls_to_inline_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INLINE_SELECTIVE_PASS_H_
@@ -16,6 +16,9 @@
 
 #include "inst_bindless_check_pass.h"
 
+#include "source/opt/cfg.h"
+#include "source/opt/dominator_analysis.h"
+
 namespace {
 
 // Input Operand Indices
@@ -421,6 +424,7 @@ void InstBindlessCheckPass::GenCheckCode(
   std::unique_ptr<Instruction> merge_label(NewLabel(merge_blk_id));
   std::unique_ptr<Instruction> valid_label(NewLabel(valid_blk_id));
   std::unique_ptr<Instruction> invalid_label(NewLabel(invalid_blk_id));
+  check_id = GenSampleGateCode(check_id, &builder);
   (void)builder.AddConditionalBranch(check_id, valid_blk_id, invalid_blk_id,
                                      merge_blk_id, SpvSelectionControlMaskNone);
   // Gen valid bounds branch
@@ -433,19 +437,23 @@ void InstBindlessCheckPass::GenCheckCode(
   // Gen invalid block
   new_blk_ptr.reset(new BasicBlock(std::move(invalid_label)));
   builder.SetInsertPoint(&*new_blk_ptr);
-  uint32_t u_index_id = GenUintCastCode(ref->desc_idx_id, &builder);
-  if (offset_id != 0)
-    GenDebugStreamWrite(uid2offset_[ref->ref_inst->unique_id()], stage_idx,
-                        {error_id, u_index_id, offset_id, length_id}, &builder);
-  else if (buffer_bounds_enabled_)
-    // So all error modes will use same debug stream write function
-    GenDebugStreamWrite(
-        uid2offset_[ref->ref_inst->unique_id()], stage_idx,
-        {error_id, u_index_id, length_id, builder.GetUintConstantId(0)},
-        &builder);
-  else
-    GenDebugStreamWrite(uid2offset_[ref->ref_inst->unique_id()], stage_idx,
-                        {error_id, u_index_id, length_id}, &builder);
+  // An error already reported by a dominating check is not written again.
+  if (error_id != 0) {
+    uint32_t u_index_id = GenUintCastCode(ref->desc_idx_id, &builder);
+    if (offset_id != 0)
+      GenDebugStreamWrite(uid2offset_[ref->ref_inst->unique_id()], stage_idx,
+                          {error_id, u_index_id, offset_id, length_id},
+                          &builder);
+    else if (buffer_bounds_enabled_)
+      // So all error modes will use same debug stream write function
+      GenDebugStreamWrite(
+          uid2offset_[ref->ref_inst->unique_id()], stage_idx,
+          {error_id, u_index_id, length_id, builder.GetUintConstantId(0)},
+          &builder);
+    else
+      GenDebugStreamWrite(uid2offset_[ref->ref_inst->unique_id()], stage_idx,
+                          {error_id, u_index_id, length_id}, &builder);
+  }
   // Remember last invalid block id
   uint32_t last_invalid_blk_id = new_blk_ptr->GetLabelInst()->result_id();
   // Gen zero for invalid  reference
@@ -498,6 +506,15 @@ void InstBindlessCheckPass::GenDescIdxCheckCode(
              desc_type_inst->opcode() != SpvOpTypeRuntimeArray) {
     return;
   }
+  // If a dominating check of the same index has already been generated,
+  // reuse its result.
+  uint32_t orig_blk_id = 0;
+  uint32_t check_id = 0;
+  if (reuse_checks_enabled_) {
+    orig_blk_id = GetOriginalBlockId(ref_block_itr->id());
+    check_id = FindDominatingCheck(ref.var_id, ref.desc_idx_id, orig_blk_id);
+  }
+  if (!SampleSite()) return;
   // Move original block's preceding instructions into first new block
   std::unique_ptr<BasicBlock> new_blk_ptr;
   MovePreludeCode(ref_inst_itr, ref_block_itr, &new_blk_ptr);
@@ -505,24 +522,30 @@ void InstBindlessCheckPass::GenDescIdxCheckCode(
       context(), &*new_blk_ptr,
       IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
   new_blocks->push_back(std::move(new_blk_ptr));
-  uint32_t error_id = builder.GetUintConstantId(kInstErrorBindlessBounds);
-  // If length id not yet set, descriptor array is runtime size so
-  // generate load of length from stage's debug input buffer.
-  if (length_id == 0) {
-    assert(desc_type_inst->opcode() == SpvOpTypeRuntimeArray &&
-           "unexpected bindless type");
-    length_id = GenDebugReadLength(ref.var_id, &builder);
+  uint32_t error_id = 0;
+  if (check_id == 0) {
+    error_id = builder.GetUintConstantId(kInstErrorBindlessBounds);
+    // If length id not yet set, descriptor array is runtime size so
+    // generate load of length from stage's debug input buffer.
+    if (length_id == 0) {
+      assert(desc_type_inst->opcode() == SpvOpTypeRuntimeArray &&
+             "unexpected bindless type");
+      length_id = GenDebugReadLength(ref.var_id, &builder);
+    }
+    // Generate full runtime bounds test code with true branch
+    // being full reference and false branch being debug output and zero
+    // for the referenced value.
+    Instruction* ult_inst = builder.AddBinaryOp(GetBoolId(), SpvOpULessThan,
+                                                ref.desc_idx_id, length_id);
+    check_id = ult_inst->result_id();
+    if (reuse_checks_enabled_)
+      RecordCheck(ref.var_id, ref.desc_idx_id, orig_blk_id, check_id);
   }
-  // Generate full runtime bounds test code with true branch
-  // being full reference and false branch being debug output and zero
-  // for the referenced value.
-  Instruction* ult_inst = builder.AddBinaryOp(GetBoolId(), SpvOpULessThan,
-                                              ref.desc_idx_id, length_id);
-  GenCheckCode(ult_inst->result_id(), error_id, 0u, length_id, stage_idx, &ref,
-               new_blocks);
+  GenCheckCode(check_id, error_id, 0u, length_id, stage_idx, &ref, new_blocks);
   // Move original block's remaining code into remainder/merge block and add
   // to new blocks
   BasicBlock* back_blk_ptr = &*new_blocks->back();
+  if (reuse_checks_enabled_) new_block2orig_[back_blk_ptr->id()] = orig_blk_id;
   MovePostludeCode(ref_block_itr, back_blk_ptr);
 }
 
@@ -550,6 +573,13 @@ void InstBindlessCheckPass::GenDescInitCheckCode(
   }
   // If initialization check and not enabled, return
   if (init_check && !desc_init_enabled_) return;
+  // Only initialization checks can be reused, as bounds checks depend on the
+  // bytes referenced.
+  bool reuse_check = init_check && reuse_checks_enabled_;
+  uint32_t orig_blk_id = 0;
+  if (reuse_checks_enabled_)
+    orig_blk_id = GetOriginalBlockId(ref_block_itr->id());
+  if (!SampleSite()) return;
   // Move original block's preceding instructions into first new block
   std::unique_ptr<BasicBlock> new_blk_ptr;
   MovePreludeCode(ref_inst_itr, ref_block_itr, &new_blk_ptr);
@@ -564,21 +594,33 @@ void InstBindlessCheckPass::GenDescInitCheckCode(
   // Read initialization/bounds from debug input buffer. If index id not yet
   // set, binding is single descriptor, so set index to constant 0.
   if (ref.desc_idx_id == 0) ref.desc_idx_id = builder.GetUintConstantId(0u);
-  uint32_t init_id = GenDebugReadInit(ref.var_id, ref.desc_idx_id, &builder);
-  // Generate runtime initialization/bounds test code with true branch
-  // being full reference and false branch being debug output and zero
-  // for the referenced value.
-  Instruction* ult_inst =
-      builder.AddBinaryOp(GetBoolId(), SpvOpULessThan, ref_id, init_id);
-  uint32_t error =
-      init_check ? kInstErrorBindlessUninit : kInstErrorBindlessBuffOOB;
-  uint32_t error_id = builder.GetUintConstantId(error);
-  GenCheckCode(ult_inst->result_id(), error_id, init_check ? 0 : ref_id,
-               init_check ? builder.GetUintConstantId(0u) : init_id, stage_idx,
-               &ref, new_blocks);
+  uint32_t check_id =
+      reuse_check
+          ? FindDominatingCheck(ref.var_id, ref.desc_idx_id, orig_blk_id)
+          : 0;
+  if (check_id != 0) {
+    GenCheckCode(check_id, 0u, 0u, 0u, stage_idx, &ref, new_blocks);
+  } else {
+    uint32_t init_id = GenDebugReadInit(ref.var_id, ref.desc_idx_id, &builder);
+    // Generate runtime initialization/bounds test code with true branch
+    // being full reference and false branch being debug output and zero
+    // for the referenced value.
+    Instruction* ult_inst =
+        builder.AddBinaryOp(GetBoolId(), SpvOpULessThan, ref_id, init_id);
+    if (reuse_check)
+      RecordCheck(ref.var_id, ref.desc_idx_id, orig_blk_id,
+                  ult_inst->result_id());
+    uint32_t error =
+        init_check ? kInstErrorBindlessUninit : kInstErrorBindlessBuffOOB;
+    uint32_t error_id = builder.GetUintConstantId(error);
+    GenCheckCode(ult_inst->result_id(), error_id, init_check ? 0 : ref_id,
+                 init_check ? builder.GetUintConstantId(0u) : init_id,
+                 stage_idx, &ref, new_blocks);
+  }
   // Move original block's remaining code into remainder/merge block and add
   // to new blocks
   BasicBlock* back_blk_ptr = &*new_blocks->back();
+  if (reuse_checks_enabled_) new_block2orig_[back_blk_ptr->id()] = orig_blk_id;
   MovePostludeCode(ref_block_itr, back_blk_ptr);
 }
 
@@ -588,17 +630,69 @@ void InstBindlessCheckPass::InitializeInstBindlessCheck() {
   // If runtime array length support enabled, create variable mappings. Length
   // support is always enabled if descriptor init check is enabled.
   if (desc_idx_enabled_ || buffer_bounds_enabled_)
-    for (auto& anno : get_module()->annotations())
-      if (anno.opcode() == SpvOpDecorate) {
-        if (anno.GetSingleWordInOperand(1u) == SpvDecorationDescriptorSet)
-          var2desc_set_[anno.GetSingleWordInOperand(0u)] =
-              anno.GetSingleWordInOperand(2u);
-        else if (anno.GetSingleWordInOperand(1u) == SpvDecorationBinding)
-          var2binding_[anno.GetSingleWordInOperand(0u)] =
-              anno.GetSingleWordInOperand(2u);
+    for (const auto& resource : context()->GetReflectionAnalysis()->resources())
+      if (resource.has_binding) {
+        var2desc_set_[resource.variable_id] = resource.set;
+        var2binding_[resource.variable_id] = resource.binding;
       }
 }
 
+void InstBindlessCheckPass::InitializeCheckReuse() {
+  block2dom_order_.clear();
+  new_block2orig_.clear();
+  checks_.clear();
+  // Earlier sweeps may have changed the control flow, so build a fresh CFG.
+  CFG cfg(get_module());
+  for (auto& func : *get_module()) {
+    DominatorAnalysis dom;
+    dom.InitializeTree(cfg, &func);
+    for (auto& blk : func) {
+      const DominatorTreeNode* node = dom.GetDomTree().GetTreeNode(blk.id());
+      if (node != nullptr)
+        block2dom_order_[blk.id()] =
+            std::make_pair(node->dfs_num_pre_, node->dfs_num_post_);
+    }
+  }
+}
+
+uint32_t InstBindlessCheckPass::GetOriginalBlockId(uint32_t blk_id) {
+  auto itr = new_block2orig_.find(blk_id);
+  return itr == new_block2orig_.end() ? blk_id : itr->second;
+}
+
+bool InstBindlessCheckPass::OriginalBlockDominates(uint32_t a_id,
+                                                   uint32_t b_id) {
+  if (a_id == b_id) return true;
+  auto a_itr = block2dom_order_.find(a_id);
+  auto b_itr = block2dom_order_.find(b_id);
+  // Blocks unknown to the dominator tree, such as unreachable blocks, are
+  // only known to dominate themselves.
+  if (a_itr == block2dom_order_.end() || b_itr == block2dom_order_.end())
+    return false;
+  return a_itr->second.first < b_itr->second.first &&
+         a_itr->second.second > b_itr->second.second;
+}
+
+uint32_t InstBindlessCheckPass::FindDominatingCheck(uint32_t var_id,
+                                                    uint32_t desc_idx_id,
+                                                    uint32_t orig_blk_id) {
+  auto itr = checks_.find(
+      std::make_tuple(curr_func_->result_id(), var_id, desc_idx_id));
+  if (itr == checks_.end()) return 0;
+  // Checks are generated in program order, so a check computed earlier in
+  // the same original block precedes the reference.
+  for (auto& check : itr->second)
+    if (OriginalBlockDominates(check.first, orig_blk_id)) return check.second;
+  return 0;
+}
+
+void InstBindlessCheckPass::RecordCheck(uint32_t var_id, uint32_t desc_idx_id,
+                                        uint32_t orig_blk_id,
+                                        uint32_t check_id) {
+  checks_[std::make_tuple(curr_func_->result_id(), var_id, desc_idx_id)]
+      .push_back(std::make_pair(orig_blk_id, check_id));
+}
+
 Pass::Status InstBindlessCheckPass::ProcessImpl() {
   // Perform bindless bounds check on each entry point function in module
   InstProcessFunction pfn =
@@ -608,6 +702,7 @@ Pass::Status InstBindlessCheckPass::ProcessImpl() {
         return GenDescIdxCheckCode(ref_inst_itr, ref_block_itr, stage_idx,
                                    new_blocks);
       };
+  if (reuse_checks_enabled_) InitializeCheckReuse();
   bool modified = InstProcessEntryPointCallTree(pfn);
   if (desc_init_enabled_ || buffer_bounds_enabled_) {
     // Perform descriptor initialization check on each entry point function in
@@ -619,6 +714,7 @@ Pass::Status InstBindlessCheckPass::ProcessImpl() {
       return GenDescInitCheckCode(ref_inst_itr, ref_block_itr, stage_idx,
                                   new_blocks);
     };
+    if (reuse_checks_enabled_) InitializeCheckReuse();
     modified |= InstProcessEntryPointCallTree(pfn);
   }
   return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
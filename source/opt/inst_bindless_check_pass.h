@@ -17,6 +17,12 @@
 #ifndef LIBSPIRV_OPT_INST_BINDLESS_CHECK_PASS_H_
 #define LIBSPIRV_OPT_INST_BINDLESS_CHECK_PASS_H_
 
+#include <map>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "instrument_pass.h"
 
 namespace spvtools {
@@ -34,18 +40,31 @@ class InstBindlessCheckPass : public InstrumentPass {
       : InstrumentPass(desc_set, shader_id, kInstValidationIdBindless, false),
         desc_idx_enabled_(desc_idx_enable),
         desc_init_enabled_(desc_init_enable),
-        buffer_bounds_enabled_(false) {}
+        buffer_bounds_enabled_(false),
+        reuse_checks_enabled_(false) {}
 
-  // New interface supporting buffer overrun checking
+  // New interface supporting buffer overrun checking. If |reuse_checks| is
+  // true, a descriptor index or initialization check that is dominated by an
+  // identical check reuses that check's result and reports no error itself.
+  // If |subgroup_stream_writes| is true, error records are reserved once per
+  // subgroup. See InstrumentPass::SetSampling for |sample_period| and
+  // |sample_spec_id|.
   InstBindlessCheckPass(uint32_t desc_set, uint32_t shader_id,
                         bool desc_idx_enable, bool desc_init_enable,
-                        bool buffer_bounds_enable)
+                        bool buffer_bounds_enable, bool reuse_checks = false,
+                        bool subgroup_stream_writes = false,
+                        uint32_t sample_period = 1,
+                        int32_t sample_spec_id = -1)
       : InstrumentPass(
             desc_set, shader_id, kInstValidationIdBindless,
-            desc_idx_enable || desc_init_enable || buffer_bounds_enable),
+            desc_idx_enable || desc_init_enable || buffer_bounds_enable,
+            subgroup_stream_writes),
         desc_idx_enabled_(desc_idx_enable),
         desc_init_enabled_(desc_init_enable),
-        buffer_bounds_enabled_(buffer_bounds_enable) {}
+        buffer_bounds_enabled_(buffer_bounds_enable),
+        reuse_checks_enabled_(reuse_checks) {
+    SetSampling(sample_period, sample_spec_id);
+  }
 
   ~InstBindlessCheckPass() override = default;
 
@@ -164,7 +183,8 @@ class InstBindlessCheckPass : public InstrumentPass {
   // block which does original reference |ref|. Generate invalid block which
   // writes debug error output utilizing |ref|, |error_id|, |length_id| and
   // |stage_idx|. Generate merge block for valid and invalid branches. Kill
-  // original reference.
+  // original reference. If |error_id| is 0, the error has already been
+  // reported by a dominating check, so the invalid block writes no record.
   void GenCheckCode(uint32_t check_id, uint32_t error_id, uint32_t offset_id,
                     uint32_t length_id, uint32_t stage_idx, ref_analysis* ref,
                     std::vector<std::unique_ptr<BasicBlock>>* new_blocks);
@@ -172,6 +192,31 @@ class InstBindlessCheckPass : public InstrumentPass {
   // Initialize state for instrumenting bindless checking
   void InitializeInstBindlessCheck();
 
+  // Forget all recorded checks and compute the dominator tree order of every
+  // block in the module, in preparation for a sweep of instrumentation.
+  void InitializeCheckReuse();
+
+  // Return the id of the block, present at the start of the current sweep,
+  // from which the block with |blk_id| was split. This is |blk_id| itself if
+  // that block is not new.
+  uint32_t GetOriginalBlockId(uint32_t blk_id);
+
+  // Return true if original block |a_id| dominates original block |b_id|,
+  // as far as is known.
+  bool OriginalBlockDominates(uint32_t a_id, uint32_t b_id);
+
+  // Return the id of a recorded check of index |desc_idx_id| into descriptor
+  // variable |var_id| that dominates original block |orig_blk_id| of the
+  // current function. Return 0 if there is none.
+  uint32_t FindDominatingCheck(uint32_t var_id, uint32_t desc_idx_id,
+                               uint32_t orig_blk_id);
+
+  // Record that the boolean |check_id|, computed in a piece of original block
+  // |orig_blk_id|, holds if index |desc_idx_id| into descriptor variable
+  // |var_id| is valid.
+  void RecordCheck(uint32_t var_id, uint32_t desc_idx_id, uint32_t orig_blk_id,
+                   uint32_t check_id);
+
   // Apply GenDescIdxCheckCode to every instruction in module. Then apply
   // GenDescInitCheckCode to every instruction in module.
   Pass::Status ProcessImpl();
@@ -185,6 +230,24 @@ class InstBindlessCheckPass : public InstrumentPass {
   // Enable instrumentation of buffer overrun checking
   bool buffer_bounds_enabled_;
 
+  // Enable reuse of dominating descriptor index and initialization checks
+  bool reuse_checks_enabled_;
+
+  // Mapping from each block present at the start of the current sweep to its
+  // pre- and post-order numbers in the dominator tree of its function
+  std::unordered_map<uint32_t, std::pair<int, int>> block2dom_order_;
+
+  // Mapping from each block created by the current sweep to the original
+  // block it was split from
+  std::unordered_map<uint32_t, uint32_t> new_block2orig_;
+
+  // Mapping from function, descriptor variable and index to the checks of
+  // that index generated by the current sweep, each given by the original
+  // block in which it is computed and the id of its boolean result
+  std::map<std::tuple<uint32_t, uint32_t, uint32_t>,
+           std::vector<std::pair<uint32_t, uint32_t>>>
+      checks_;
+
   // Mapping from variable to descriptor set
   std::unordered_map<uint32_t, uint32_t> var2desc_set_;
 
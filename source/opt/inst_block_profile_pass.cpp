@@ -0,0 +1,54 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/inst_block_profile_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+void InstBlockProfilePass::GenBlockCounterCode(BasicBlock* block,
+                                               uint32_t block_idx) {
+  auto insert_point = block->begin();
+  while (insert_point->opcode() == SpvOpPhi ||
+         insert_point->opcode() == SpvOpVariable) {
+    ++insert_point;
+  }
+  InstructionBuilder builder(
+      context(), &*insert_point,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  Instruction* counter_ptr_inst = builder.AddTernaryOp(
+      GetOutputBufferPtrId(), SpvOpAccessChain, GetOutputBufferId(),
+      builder.GetUintConstantId(kDebugOutputDataOffset),
+      builder.GetUintConstantId(block_idx));
+  uint32_t mask_none_id = builder.GetUintConstantId(SpvMemoryAccessMaskNone);
+  uint32_t scope_invok_id = builder.GetUintConstantId(SpvScopeInvocation);
+  (void)builder.AddQuadOp(GetUintId(), SpvOpAtomicIAdd,
+                          counter_ptr_inst->result_id(), scope_invok_id,
+                          mask_none_id, builder.GetUintConstantId(1));
+}
+
+Pass::Status InstBlockProfilePass::Process() {
+  InitializeInstrument();
+  uint32_t block_idx = 0;
+  for (auto& func : *get_module()) {
+    for (auto& block : func) {
+      GenBlockCounterCode(&block, block_idx++);
+    }
+  }
+  return block_idx == 0 ? Status::SuccessWithoutChange
+                        : Status::SuccessWithChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
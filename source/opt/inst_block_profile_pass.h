@@ -0,0 +1,55 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INST_BLOCK_PROFILE_PASS_H_
+#define SOURCE_OPT_INST_BLOCK_PROFILE_PASS_H_
+
+#include "source/opt/instrument_pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// This pass counts the executions of every basic block in the module.  At the
+// start of each block it atomically increments the element of the block
+// profile output buffer that belongs to the block.  Blocks are numbered in
+// the order they appear in the module, across all functions.  No block is
+// split or renamed, so the ids of the instrumented module match the ids of
+// the original one, and the counts can be fed back to the optimizer with
+// Optimizer::SetProfile.
+class InstBlockProfilePass : public InstrumentPass {
+ public:
+  // For test harness only
+  InstBlockProfilePass()
+      : InstrumentPass(7, 23, kInstValidationIdBlockProfile) {}
+  // For all other interfaces
+  InstBlockProfilePass(uint32_t desc_set, uint32_t shader_id)
+      : InstrumentPass(desc_set, shader_id, kInstValidationIdBlockProfile) {}
+
+  ~InstBlockProfilePass() override = default;
+
+  // See optimizer.hpp for pass user documentation.
+  Status Process() override;
+
+  const char* name() const override { return "inst-block-profile-pass"; }
+
+ private:
+  // Adds the counter increment for the block with index |block_idx| to
+  // |block|, after its OpPhi and OpVariable instructions.
+  void GenBlockCounterCode(BasicBlock* block, uint32_t block_idx);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INST_BLOCK_PROFILE_PASS_H_
@@ -16,6 +16,9 @@
 
 #include "inst_buff_addr_check_pass.h"
 
+#include <algorithm>
+#include <iterator>
+
 namespace spvtools {
 namespace opt {
 
@@ -72,6 +75,7 @@ void InstBuffAddrCheckPass::GenCheckCode(
   std::unique_ptr<Instruction> merge_label(NewLabel(merge_blk_id));
   std::unique_ptr<Instruction> valid_label(NewLabel(valid_blk_id));
   std::unique_ptr<Instruction> invalid_label(NewLabel(invalid_blk_id));
+  check_id = GenSampleGateCode(check_id, &builder);
   (void)builder.AddConditionalBranch(check_id, valid_blk_id, invalid_blk_id,
                                      merge_blk_id, SpvSelectionControlMaskNone);
   // Gen valid branch
@@ -84,18 +88,21 @@ void InstBuffAddrCheckPass::GenCheckCode(
   // Gen invalid block
   new_blk_ptr.reset(new BasicBlock(std::move(invalid_label)));
   builder.SetInsertPoint(&*new_blk_ptr);
-  // Convert uptr from uint64 to 2 uint32
-  Instruction* lo_uptr_inst =
-      builder.AddUnaryOp(GetUintId(), SpvOpUConvert, ref_uptr_id);
-  Instruction* rshift_uptr_inst =
-      builder.AddBinaryOp(GetUint64Id(), SpvOpShiftRightLogical, ref_uptr_id,
-                          builder.GetUintConstantId(32));
-  Instruction* hi_uptr_inst = builder.AddUnaryOp(GetUintId(), SpvOpUConvert,
-                                                 rshift_uptr_inst->result_id());
-  GenDebugStreamWrite(
-      uid2offset_[ref_inst->unique_id()], stage_idx,
-      {error_id, lo_uptr_inst->result_id(), hi_uptr_inst->result_id()},
-      &builder);
+  // An error already reported by a combined check is not written again.
+  if (error_id != 0) {
+    // Convert uptr from uint64 to 2 uint32
+    Instruction* lo_uptr_inst =
+        builder.AddUnaryOp(GetUintId(), SpvOpUConvert, ref_uptr_id);
+    Instruction* rshift_uptr_inst =
+        builder.AddBinaryOp(GetUint64Id(), SpvOpShiftRightLogical,
+                            ref_uptr_id, builder.GetUintConstantId(32));
+    Instruction* hi_uptr_inst = builder.AddUnaryOp(
+        GetUintId(), SpvOpUConvert, rshift_uptr_inst->result_id());
+    GenDebugStreamWrite(
+        uid2offset_[ref_inst->unique_id()], stage_idx,
+        {error_id, lo_uptr_inst->result_id(), hi_uptr_inst->result_id()},
+        &builder);
+  }
   // Gen zero for invalid load. If pointer type, need to convert uint64
   // zero to pointer; cannot create ConstantNull of pointer type.
   uint32_t null_id = 0;
@@ -151,6 +158,97 @@ uint32_t InstBuffAddrCheckPass::GetTypeLength(uint32_t type_id) {
   }
 }
 
+uint32_t InstBuffAddrCheckPass::GetReferenceLength(Instruction* ref_inst) {
+  analysis::DefUseManager* du_mgr = get_def_use_mgr();
+  Instruction* ref_ptr_inst =
+      du_mgr->GetDef(ref_inst->GetSingleWordInOperand(0));
+  Instruction* ref_ptr_ty_inst = du_mgr->GetDef(ref_ptr_inst->type_id());
+  return GetTypeLength(ref_ptr_ty_inst->GetSingleWordInOperand(1));
+}
+
+bool InstBuffAddrCheckPass::GetConstantOffset(Instruction* ptr_inst,
+                                              uint32_t* base_id,
+                                              uint32_t* offset) {
+  if (ptr_inst->opcode() != SpvOpAccessChain) return false;
+  analysis::DefUseManager* du_mgr = get_def_use_mgr();
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  analysis::DecorationManager* deco_mgr = get_decoration_mgr();
+  *base_id = ptr_inst->GetSingleWordInOperand(0);
+  Instruction* base_ty_inst =
+      du_mgr->GetDef(du_mgr->GetDef(*base_id)->type_id());
+  uint32_t type_id = base_ty_inst->GetSingleWordInOperand(1);
+  *offset = 0;
+  for (uint32_t i = 1; i < ptr_inst->NumInOperands(); ++i) {
+    const analysis::Constant* idx_const =
+        const_mgr->FindDeclaredConstant(ptr_inst->GetSingleWordInOperand(i));
+    if (idx_const == nullptr || idx_const->AsIntConstant() == nullptr)
+      return false;
+    uint32_t idx = idx_const->GetU32();
+    Instruction* type_inst = du_mgr->GetDef(type_id);
+    uint32_t elem_offset = 0;
+    bool found = false;
+    switch (type_inst->opcode()) {
+      case SpvOpTypeStruct:
+        deco_mgr->ForEachDecoration(
+            type_id, SpvDecorationOffset,
+            [idx, &elem_offset, &found](const Instruction& deco) {
+              if (deco.GetSingleWordInOperand(1) != idx) return;
+              elem_offset = deco.GetSingleWordInOperand(3);
+              found = true;
+            });
+        type_id = type_inst->GetSingleWordInOperand(idx);
+        break;
+      case SpvOpTypeArray:
+      case SpvOpTypeRuntimeArray:
+        deco_mgr->ForEachDecoration(
+            type_id, SpvDecorationArrayStride,
+            [idx, &elem_offset, &found](const Instruction& deco) {
+              elem_offset = idx * deco.GetSingleWordInOperand(2);
+              found = true;
+            });
+        type_id = type_inst->GetSingleWordInOperand(0);
+        break;
+      case SpvOpTypeVector:
+        type_id = type_inst->GetSingleWordInOperand(0);
+        elem_offset = idx * GetTypeLength(type_id);
+        found = true;
+        break;
+      default:
+        break;
+    }
+    if (!found) return false;
+    *offset += elem_offset;
+  }
+  return true;
+}
+
+uint32_t InstBuffAddrCheckPass::GetCombinedLength(
+    BasicBlock::iterator ref_inst_itr,
+    UptrVectorIterator<BasicBlock> ref_block_itr, uint32_t base_id,
+    uint32_t offset) {
+  analysis::DefUseManager* du_mgr = get_def_use_mgr();
+  uint32_t end = offset + GetReferenceLength(&*ref_inst_itr);
+  for (auto ii = std::next(ref_inst_itr); ii != ref_block_itr->end(); ++ii) {
+    // Stop at calls, which may not return; the references after them might
+    // never be executed.
+    if (ii->opcode() == SpvOpFunctionCall) break;
+    if (!IsPhysicalBuffAddrReference(&*ii)) continue;
+    uint32_t ref_base_id;
+    uint32_t ref_offset;
+    Instruction* ptr_inst = du_mgr->GetDef(ii->GetSingleWordInOperand(0));
+    if (!GetConstantOffset(ptr_inst, &ref_base_id, &ref_offset) ||
+        ref_base_id != base_id || ref_offset < offset)
+      continue;
+    end = std::max(end, ref_offset + GetReferenceLength(&*ii));
+  }
+  return end - offset;
+}
+
+uint32_t InstBuffAddrCheckPass::GetOriginalBlockId(uint32_t blk_id) {
+  auto orig = new_block2orig_.find(blk_id);
+  return orig == new_block2orig_.end() ? blk_id : orig->second;
+}
+
 void InstBuffAddrCheckPass::AddParam(uint32_t type_id,
                                      std::vector<uint32_t>* param_vec,
                                      std::unique_ptr<Function>* input_func) {
@@ -346,6 +444,7 @@ uint32_t InstBuffAddrCheckPass::GetSearchAndTestFuncId() {
 }
 
 uint32_t InstBuffAddrCheckPass::GenSearchAndTest(Instruction* ref_inst,
+                                                 uint32_t ref_len,
                                                  InstructionBuilder* builder,
                                                  uint32_t* ref_uptr_id) {
   // Enable Int64 if necessary
@@ -362,12 +461,6 @@ uint32_t InstBuffAddrCheckPass::GenSearchAndTest(Instruction* ref_inst,
   Instruction* ref_uptr_inst =
       builder->AddUnaryOp(GetUint64Id(), SpvOpConvertPtrToU, ref_ptr_id);
   *ref_uptr_id = ref_uptr_inst->result_id();
-  // Compute reference length in bytes
-  analysis::DefUseManager* du_mgr = get_def_use_mgr();
-  Instruction* ref_ptr_inst = du_mgr->GetDef(ref_ptr_id);
-  uint32_t ref_ptr_ty_id = ref_ptr_inst->type_id();
-  Instruction* ref_ptr_ty_inst = du_mgr->GetDef(ref_ptr_ty_id);
-  uint32_t ref_len = GetTypeLength(ref_ptr_ty_inst->GetSingleWordInOperand(1));
   uint32_t ref_len_id = builder->GetUintConstantId(ref_len);
   // Gen call to search and test function
   const std::vector<uint32_t> args = {GetSearchAndTestFuncId(), *ref_uptr_id,
@@ -386,6 +479,31 @@ void InstBuffAddrCheckPass::GenBuffAddrCheckCode(
   // save components. If not, return.
   Instruction* ref_inst = &*ref_inst_itr;
   if (!IsPhysicalBuffAddrReference(ref_inst)) return;
+  if (!SampleSite()) return;
+  uint32_t ref_len = GetReferenceLength(ref_inst);
+  // If combining checks, look for an earlier check in the same block which
+  // covers this reference. If there is none, extend this reference's check
+  // to cover the following references through the same base pointer.
+  uint32_t orig_blk_id = 0;
+  uint32_t base_id = 0;
+  uint32_t offset = 0;
+  uint32_t valid_id = 0;
+  Instruction* ptr_inst =
+      get_def_use_mgr()->GetDef(ref_inst->GetSingleWordInOperand(0));
+  bool combine = combine_checks_enabled_ &&
+                 GetConstantOffset(ptr_inst, &base_id, &offset);
+  if (combine) {
+    orig_blk_id = GetOriginalBlockId(ref_block_itr->id());
+    for (const RangeCheck& range_check : blk2checks_[orig_blk_id]) {
+      if (range_check.base_id == base_id && range_check.lo <= offset &&
+          offset + ref_len <= range_check.hi) {
+        valid_id = range_check.check_id;
+        break;
+      }
+    }
+    if (valid_id == 0)
+      ref_len = GetCombinedLength(ref_inst_itr, ref_block_itr, base_id, offset);
+  }
   // Move original block's preceding instructions into first new block
   std::unique_ptr<BasicBlock> new_blk_ptr;
   MovePreludeCode(ref_inst_itr, ref_block_itr, &new_blk_ptr);
@@ -393,19 +511,31 @@ void InstBuffAddrCheckPass::GenBuffAddrCheckCode(
       context(), &*new_blk_ptr,
       IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
   new_blocks->push_back(std::move(new_blk_ptr));
-  uint32_t error_id = builder.GetUintConstantId(kInstErrorBuffAddrUnallocRef);
-  // Generate code to do search and test if all bytes of reference
-  // are within a listed buffer. Return reference pointer converted to uint64.
-  uint32_t ref_uptr_id;
-  uint32_t valid_id = GenSearchAndTest(ref_inst, &builder, &ref_uptr_id);
-  // Generate test of search results with true branch
-  // being full reference and false branch being debug output and zero
-  // for the referenced value.
-  GenCheckCode(valid_id, error_id, ref_uptr_id, stage_idx, ref_inst,
-               new_blocks);
+  if (valid_id != 0) {
+    // The reference is known valid if the covering check passed. Otherwise
+    // the error has already been reported.
+    GenCheckCode(valid_id, 0u, 0u, stage_idx, ref_inst, new_blocks);
+  } else {
+    uint32_t error_id =
+        builder.GetUintConstantId(kInstErrorBuffAddrUnallocRef);
+    // Generate code to do search and test if all bytes of reference
+    // are within a listed buffer. Return reference pointer converted to
+    // uint64.
+    uint32_t ref_uptr_id;
+    valid_id = GenSearchAndTest(ref_inst, ref_len, &builder, &ref_uptr_id);
+    if (combine)
+      blk2checks_[orig_blk_id].push_back(
+          {base_id, offset, offset + ref_len, valid_id});
+    // Generate test of search results with true branch
+    // being full reference and false branch being debug output and zero
+    // for the referenced value.
+    GenCheckCode(valid_id, error_id, ref_uptr_id, stage_idx, ref_inst,
+                 new_blocks);
+  }
   // Move original block's remaining code into remainder/merge block and add
   // to new blocks
   BasicBlock* back_blk_ptr = &*new_blocks->back();
+  if (combine) new_block2orig_[back_blk_ptr->id()] = orig_blk_id;
   MovePostludeCode(ref_block_itr, back_blk_ptr);
 }
 
@@ -414,6 +544,8 @@ void InstBuffAddrCheckPass::InitInstBuffAddrCheck() {
   InitializeInstrument();
   // Initialize class
   search_test_func_id_ = 0;
+  blk2checks_.clear();
+  new_block2orig_.clear();
 }
 
 Pass::Status InstBuffAddrCheckPass::ProcessImpl() {
@@ -17,6 +17,9 @@
 #ifndef LIBSPIRV_OPT_INST_BUFFER_ADDRESS_PASS_H_
 #define LIBSPIRV_OPT_INST_BUFFER_ADDRESS_PASS_H_
 
+#include <unordered_map>
+#include <vector>
+
 #include "instrument_pass.h"
 
 namespace spvtools {
@@ -29,8 +32,20 @@ namespace opt {
 class InstBuffAddrCheckPass : public InstrumentPass {
  public:
   // Preferred interface
-  InstBuffAddrCheckPass(uint32_t desc_set, uint32_t shader_id)
-      : InstrumentPass(desc_set, shader_id, kInstValidationIdBuffAddr) {}
+  // See InstrumentPass::SetSampling for |sample_period| and
+  // |sample_spec_id|. If |combine_checks| is true, references in the same
+  // block through the same base pointer at constant offsets share a single
+  // check of all the bytes they reference.
+  InstBuffAddrCheckPass(uint32_t desc_set, uint32_t shader_id,
+                        bool subgroup_stream_writes = false,
+                        uint32_t sample_period = 1,
+                        int32_t sample_spec_id = -1,
+                        bool combine_checks = false)
+      : InstrumentPass(desc_set, shader_id, kInstValidationIdBuffAddr, false,
+                       subgroup_stream_writes),
+        combine_checks_enabled_(combine_checks) {
+    SetSampling(sample_period, sample_spec_id);
+  }
 
   ~InstBuffAddrCheckPass() override = default;
 
@@ -44,6 +59,27 @@ class InstBuffAddrCheckPass : public InstrumentPass {
   // or physical pointer.
   uint32_t GetTypeLength(uint32_t type_id);
 
+  // Return byte length of the value referenced by |ref_inst|.
+  uint32_t GetReferenceLength(Instruction* ref_inst);
+
+  // If |ptr_inst| is an access chain whose indices are all constants, return
+  // true, setting |*base_id| to its base pointer and |*offset| to the byte
+  // offset of the result from that base. Otherwise return false.
+  bool GetConstantOffset(Instruction* ptr_inst, uint32_t* base_id,
+                         uint32_t* offset);
+
+  // Return the byte length from |offset| which must be checked at the
+  // reference |ref_inst_itr| through |base_id| so that the check also covers
+  // the following references in the same block through |base_id| at constant
+  // offsets of at least |offset|.
+  uint32_t GetCombinedLength(BasicBlock::iterator ref_inst_itr,
+                             UptrVectorIterator<BasicBlock> ref_block_itr,
+                             uint32_t base_id, uint32_t offset);
+
+  // Return the id of the block in the original module from which
+  // instrumentation generated block |blk_id|.
+  uint32_t GetOriginalBlockId(uint32_t blk_id);
+
   // Add |type_id| param to |input_func| and add id to |param_vec|.
   void AddParam(uint32_t type_id, std::vector<uint32_t>* param_vec,
                 std::unique_ptr<Function>* input_func);
@@ -52,10 +88,11 @@ class InstBuffAddrCheckPass : public InstrumentPass {
   uint32_t GetSearchAndTestFuncId();
 
   // Generate code into |builder| to do search of the BDA debug input buffer
-  // for the buffer used by |ref_inst| and test that all bytes of reference
-  // are within the buffer. Returns id of boolean value which is true if
-  // search and test is successful, false otherwise.
-  uint32_t GenSearchAndTest(Instruction* ref_inst, InstructionBuilder* builder,
+  // for the buffer used by |ref_inst| and test that the |ref_len| bytes from
+  // the reference are within the buffer. Returns id of boolean value which is
+  // true if search and test is successful, false otherwise.
+  uint32_t GenSearchAndTest(Instruction* ref_inst, uint32_t ref_len,
+                            InstructionBuilder* builder,
                             uint32_t* ref_uptr_id);
 
   // This function does checking instrumentation on a single
@@ -107,8 +144,9 @@ class InstBuffAddrCheckPass : public InstrumentPass {
   // or invalid reference blocks. Generate valid reference block which does
   // original reference |ref_inst|. Then generate invalid reference block which
   // writes debug error output utilizing |ref_inst|, |error_id| and
-  // |stage_idx|. Generate merge block for valid and invalid reference blocks.
-  // Kill original reference.
+  // |stage_idx|. If |error_id| is zero, no error is written as it has already
+  // been reported. Generate merge block for valid and invalid reference
+  // blocks. Kill original reference.
   void GenCheckCode(uint32_t check_id, uint32_t error_id, uint32_t length_id,
                     uint32_t stage_idx, Instruction* ref_inst,
                     std::vector<std::unique_ptr<BasicBlock>>* new_blocks);
@@ -121,6 +159,24 @@ class InstBuffAddrCheckPass : public InstrumentPass {
 
   // Id of search and test function, if already gen'd, else zero.
   uint32_t search_test_func_id_;
+
+  // Share checks between references through the same base pointer.
+  bool combine_checks_enabled_;
+
+  // A check |check_id| that the bytes [lo, hi) from base pointer |base_id|
+  // are within a buffer.
+  struct RangeCheck {
+    uint32_t base_id;
+    uint32_t lo;
+    uint32_t hi;
+    uint32_t check_id;
+  };
+
+  // Map from original block id to the range checks generated in it.
+  std::unordered_map<uint32_t, std::vector<RangeCheck>> blk2checks_;
+
+  // Map from generated block id to the original block it continues.
+  std::unordered_map<uint32_t, uint32_t> new_block2orig_;
 };
 
 }  // namespace opt
@@ -30,8 +30,10 @@ class InstDebugPrintfPass : public InstrumentPass {
   // For test harness only
   InstDebugPrintfPass() : InstrumentPass(7, 23, kInstValidationIdDebugPrintf) {}
   // For all other interfaces
-  InstDebugPrintfPass(uint32_t desc_set, uint32_t shader_id)
-      : InstrumentPass(desc_set, shader_id, kInstValidationIdDebugPrintf) {}
+  InstDebugPrintfPass(uint32_t desc_set, uint32_t shader_id,
+                      bool subgroup_stream_writes = false)
+      : InstrumentPass(desc_set, shader_id, kInstValidationIdDebugPrintf,
+                       false, subgroup_stream_writes) {}
 
   ~InstDebugPrintfPass() override = default;
 
@@ -14,13 +14,17 @@
 
 #include "source/opt/instruction.h"
 
+#include <algorithm>
 #include <initializer_list>
+#include <limits>
 
 #include "OpenCLDebugInfo100.h"
 #include "source/disassemble.h"
 #include "source/opt/fold.h"
+#include "source/opt/instruction_arena.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/reflect.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
@@ -39,9 +43,47 @@ const uint32_t kDebugScopeNumWords = 7;
 const uint32_t kDebugScopeNumWordsWithoutInlinedAt = 6;
 const uint32_t kDebugNoScopeNumWords = 5;
 
+// Indices of the file, line and column in the in-operands of OpLine.
+const uint32_t kLineFileInIdx = 0;
+const uint32_t kLineLineInIdx = 1;
+const uint32_t kLineColumnInIdx = 2;
+
 // Number of operands of an OpBranchConditional instruction
 // with weights.
 const uint32_t kOpBranchConditionalWithWeightsNumOperands = 5;
+
+// Appends the operands of the parsed instruction |inst| to |operands|.  The
+// words of each operand are copied straight from the binary into its operand
+// storage, which holds short operands inline.
+void AppendParsedOperands(const spv_parsed_instruction_t& inst,
+                          Instruction::OperandStorage* operands) {
+  operands->reserve(operands->size() + inst.num_operands);
+  for (uint32_t i = 0; i < inst.num_operands; ++i) {
+    const auto& current_payload = inst.operands[i];
+    const uint32_t* first_word = inst.words + current_payload.offset;
+    Operand::OperandData words;
+    words.insert(words.end(), first_word,
+                 first_word + current_payload.num_words);
+    operands->emplace_back(current_payload.type, std::move(words));
+  }
+}
+}  // namespace
+
+void* Instruction::operator new(size_t size) {
+  return InstructionArena::Allocate(size);
+}
+
+void Instruction::operator delete(void* ptr) { InstructionArena::Free(ptr); }
+
+namespace {
+// Returns the debug line that the OpLine or OpNoLine |inst| stands for.
+DebugLine GetDebugLine(const Instruction& inst) {
+  assert(IsDebugLineInst(inst.opcode()));
+  if (inst.opcode() == SpvOpNoLine) return {0, 0, 0};
+  return {inst.GetSingleWordInOperand(kLineFileInIdx),
+          inst.GetSingleWordInOperand(kLineLineInIdx),
+          inst.GetSingleWordInOperand(kLineColumnInIdx)};
+}
 }  // namespace
 
 Instruction::Instruction(IRContext* c)
@@ -51,6 +93,8 @@ Instruction::Instruction(IRContext* c)
       has_type_id_(false),
       has_result_id_(false),
       unique_id_(c->TakeNextUniqueId()),
+      list_order_(0),
+      dbg_lines_index_(0),
       dbg_scope_(kNoDebugScope, kNoInlinedAt) {}
 
 Instruction::Instruction(IRContext* c, SpvOp op)
@@ -60,6 +104,8 @@ Instruction::Instruction(IRContext* c, SpvOp op)
       has_type_id_(false),
       has_result_id_(false),
       unique_id_(c->TakeNextUniqueId()),
+      list_order_(0),
+      dbg_lines_index_(0),
       dbg_scope_(kNoDebugScope, kNoInlinedAt) {}
 
 Instruction::Instruction(IRContext* c, const spv_parsed_instruction_t& inst,
@@ -69,16 +115,19 @@ Instruction::Instruction(IRContext* c, const spv_parsed_instruction_t& inst,
       has_type_id_(inst.type_id != 0),
       has_result_id_(inst.result_id != 0),
       unique_id_(c->TakeNextUniqueId()),
-      dbg_line_insts_(std::move(dbg_line)),
+      list_order_(0),
+      dbg_lines_index_(0),
       dbg_scope_(kNoDebugScope, kNoInlinedAt) {
   assert((!IsDebugLineInst(opcode_) || dbg_line.empty()) &&
          "Op(No)Line attaching to Op(No)Line found");
-  for (uint32_t i = 0; i < inst.num_operands; ++i) {
-    const auto& current_payload = inst.operands[i];
-    std::vector<uint32_t> words(
-        inst.words + current_payload.offset,
-        inst.words + current_payload.offset + current_payload.num_words);
-    operands_.emplace_back(current_payload.type, std::move(words));
+  AppendParsedOperands(inst, &operands_);
+  if (!dbg_line.empty()) {
+    std::vector<DebugLine> lines;
+    lines.reserve(dbg_line.size());
+    for (const auto& line_inst : dbg_line) {
+      lines.push_back(GetDebugLine(line_inst));
+    }
+    set_dbg_lines(lines);
   }
 }
 
@@ -89,14 +138,10 @@ Instruction::Instruction(IRContext* c, const spv_parsed_instruction_t& inst,
       has_type_id_(inst.type_id != 0),
       has_result_id_(inst.result_id != 0),
       unique_id_(c->TakeNextUniqueId()),
+      list_order_(0),
+      dbg_lines_index_(0),
       dbg_scope_(dbg_scope) {
-  for (uint32_t i = 0; i < inst.num_operands; ++i) {
-    const auto& current_payload = inst.operands[i];
-    std::vector<uint32_t> words(
-        inst.words + current_payload.offset,
-        inst.words + current_payload.offset + current_payload.num_words);
-    operands_.emplace_back(current_payload.type, std::move(words));
-  }
+  AppendParsedOperands(inst, &operands_);
 }
 
 Instruction::Instruction(IRContext* c, SpvOp op, uint32_t ty_id,
@@ -107,7 +152,9 @@ Instruction::Instruction(IRContext* c, SpvOp op, uint32_t ty_id,
       has_type_id_(ty_id != 0),
       has_result_id_(res_id != 0),
       unique_id_(c->TakeNextUniqueId()),
+      list_order_(0),
       operands_(),
+      dbg_lines_index_(0),
       dbg_scope_(kNoDebugScope, kNoInlinedAt) {
   if (has_type_id_) {
     operands_.emplace_back(spv_operand_type_t::SPV_OPERAND_TYPE_TYPE_ID,
@@ -122,25 +169,24 @@ Instruction::Instruction(IRContext* c, SpvOp op, uint32_t ty_id,
 
 Instruction::Instruction(Instruction&& that)
     : utils::IntrusiveNodeBase<Instruction>(),
+      context_(that.context_),
       opcode_(that.opcode_),
       has_type_id_(that.has_type_id_),
       has_result_id_(that.has_result_id_),
       unique_id_(that.unique_id_),
+      list_order_(0),
       operands_(std::move(that.operands_)),
-      dbg_line_insts_(std::move(that.dbg_line_insts_)),
-      dbg_scope_(that.dbg_scope_) {
-  for (auto& i : dbg_line_insts_) {
-    i.dbg_scope_ = that.dbg_scope_;
-  }
-}
+      dbg_lines_index_(that.dbg_lines_index_),
+      dbg_scope_(that.dbg_scope_) {}
 
 Instruction& Instruction::operator=(Instruction&& that) {
+  context_ = that.context_;
   opcode_ = that.opcode_;
   has_type_id_ = that.has_type_id_;
   has_result_id_ = that.has_result_id_;
   unique_id_ = that.unique_id_;
   operands_ = std::move(that.operands_);
-  dbg_line_insts_ = std::move(that.dbg_line_insts_);
+  dbg_lines_index_ = that.dbg_lines_index_;
   dbg_scope_ = that.dbg_scope_;
   return *this;
 }
@@ -150,17 +196,105 @@ Instruction* Instruction::Clone(IRContext* c) const {
   clone->opcode_ = opcode_;
   clone->has_type_id_ = has_type_id_;
   clone->has_result_id_ = has_result_id_;
-  clone->unique_id_ = c->TakeNextUniqueId();
   clone->operands_ = operands_;
-  clone->dbg_line_insts_ = dbg_line_insts_;
+  if (c == context_) {
+    clone->dbg_lines_index_ = dbg_lines_index_;
+  } else if (has_dbg_lines()) {
+    clone->set_dbg_lines(dbg_lines());
+  }
   clone->dbg_scope_ = dbg_scope_;
   return clone;
 }
 
-uint32_t Instruction::GetSingleWordOperand(uint32_t index) const {
-  const auto& words = GetOperand(index).words;
-  assert(words.size() == 1 && "expected the operand only taking one word");
-  return words.front();
+const std::vector<DebugLine>& Instruction::dbg_lines() const {
+  static const std::vector<DebugLine>* const kNoLines =
+      new std::vector<DebugLine>();
+  if (!has_dbg_lines()) return *kNoLines;
+  return context_->debug_line_table().Get(dbg_lines_index_);
+}
+
+void Instruction::set_dbg_lines(const std::vector<DebugLine>& lines) {
+  if (lines.empty()) {
+    dbg_lines_index_ = 0;
+    return;
+  }
+  assert(context_ != nullptr && "Debug lines need a context.");
+  dbg_lines_index_ = context_->debug_line_table().Intern(lines);
+}
+
+void Instruction::AddDbgLine(const DebugLine& line) {
+  std::vector<DebugLine> lines = dbg_lines();
+  lines.push_back(line);
+  set_dbg_lines(lines);
+}
+
+Instruction Instruction::MakeDbgLineInst(const DebugLine& line,
+                                         bool take_unique_id) const {
+  Instruction line_inst;
+  line_inst.context_ = context_;
+  line_inst.opcode_ = line.IsNoLine() ? SpvOpNoLine : SpvOpLine;
+  if (take_unique_id) line_inst.unique_id_ = context_->TakeNextUniqueId();
+  if (!line.IsNoLine()) {
+    line_inst.operands_.emplace_back(SPV_OPERAND_TYPE_ID,
+                                     Operand::OperandData{line.file});
+    line_inst.operands_.emplace_back(SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                                     Operand::OperandData{line.line});
+    line_inst.operands_.emplace_back(SPV_OPERAND_TYPE_LITERAL_INTEGER,
+                                     Operand::OperandData{line.column});
+  }
+  line_inst.dbg_scope_ = dbg_scope_;
+  return line_inst;
+}
+
+bool Instruction::WhileEachInst(utils::FunctionRef<bool(Instruction*)> f,
+                                bool run_on_debug_line_insts) {
+  if (run_on_debug_line_insts && has_dbg_lines()) {
+    const std::vector<DebugLine>& old_lines = dbg_lines();
+    std::vector<DebugLine> new_lines;
+    new_lines.reserve(old_lines.size());
+    bool keep_going = true;
+    for (const DebugLine& line : old_lines) {
+      if (!keep_going) {
+        new_lines.push_back(line);
+        continue;
+      }
+      Instruction line_inst = MakeDbgLineInst(line, true);
+      keep_going = f(&line_inst);
+      if (IsDebugLineInst(line_inst.opcode())) {
+        new_lines.push_back(GetDebugLine(line_inst));
+      }
+    }
+    if (new_lines != old_lines) set_dbg_lines(new_lines);
+    if (!keep_going) return false;
+  }
+  return f(this);
+}
+
+bool Instruction::WhileEachInst(utils::FunctionRef<bool(const Instruction*)> f,
+                                bool run_on_debug_line_insts) const {
+  if (run_on_debug_line_insts) {
+    for (const DebugLine& line : dbg_lines()) {
+      const Instruction line_inst = MakeDbgLineInst(line, false);
+      if (!f(&line_inst)) return false;
+    }
+  }
+  return f(this);
+}
+
+void Instruction::OnInsertedInList(Instruction* next) {
+  // The bounds of the list count as numbers smaller and larger than those of
+  // all the instructions.
+  const uint32_t lower =
+      previous_node_->is_sentinel_ ? 0 : previous_node_->list_order_;
+  const uint32_t upper =
+      next->is_sentinel_ ? std::numeric_limits<uint32_t>::max()
+                         : next->list_order_;
+  if ((lower == 0 && !previous_node_->is_sentinel_) || upper == 0 ||
+      upper <= lower + 1) {
+    list_order_ = 0;
+    return;
+  }
+  list_order_ = lower + (upper - lower) / 2;
 }
 
 uint32_t Instruction::NumInOperandWords() const {
@@ -181,11 +315,19 @@ bool Instruction::HasBranchWeights() const {
 
 void Instruction::ToBinaryWithoutAttachedDebugInsts(
     std::vector<uint32_t>* binary) const {
+  const size_t offset = binary->size();
+  binary->resize(offset + 1 + NumOperandWords());
+  ToBinaryWithoutAttachedDebugInsts(binary->data() + offset);
+}
+
+uint32_t* Instruction::ToBinaryWithoutAttachedDebugInsts(
+    uint32_t* binary) const {
   const uint32_t num_words = 1 + NumOperandWords();
-  binary->push_back((num_words << 16) | static_cast<uint16_t>(opcode_));
+  *binary++ = (num_words << 16) | static_cast<uint16_t>(opcode_);
   for (const auto& operand : operands_) {
-    binary->insert(binary->end(), operand.words.begin(), operand.words.end());
+    binary = std::copy(operand.words.begin(), operand.words.end(), binary);
   }
+  return binary;
 }
 
 void Instruction::ReplaceOperands(const OperandList& new_operands) {
@@ -503,9 +645,6 @@ uint32_t Instruction::GetTypeComponent(uint32_t element) const {
 
 void Instruction::UpdateLexicalScope(uint32_t scope) {
   dbg_scope_.SetLexicalScope(scope);
-  for (auto& i : dbg_line_insts_) {
-    i.dbg_scope_.SetLexicalScope(scope);
-  }
   if (!IsDebugLineInst(opcode()) &&
       context()->AreAnalysesValid(IRContext::kAnalysisDebugInfo)) {
     context()->get_debug_info_mgr()->AnalyzeDebugInst(this);
@@ -514,9 +653,6 @@ void Instruction::UpdateLexicalScope(uint32_t scope) {
 
 void Instruction::UpdateDebugInlinedAt(uint32_t new_inlined_at) {
   dbg_scope_.SetInlinedAt(new_inlined_at);
-  for (auto& i : dbg_line_insts_) {
-    i.dbg_scope_.SetInlinedAt(new_inlined_at);
-  }
   if (!IsDebugLineInst(opcode()) &&
       context()->AreAnalysesValid(IRContext::kAnalysisDebugInfo)) {
     context()->get_debug_info_mgr()->AnalyzeDebugInst(this);
@@ -525,9 +661,8 @@ void Instruction::UpdateDebugInlinedAt(uint32_t new_inlined_at) {
 
 void Instruction::UpdateDebugInfoFrom(const Instruction* from) {
   if (from == nullptr) return;
-  clear_dbg_line_insts();
-  if (!from->dbg_line_insts().empty())
-    dbg_line_insts().push_back(from->dbg_line_insts()[0]);
+  clear_dbg_lines();
+  if (from->has_dbg_lines()) AddDbgLine(*from->dbg_line());
   SetDebugScope(from->GetDebugScope());
   if (!IsDebugLineInst(opcode()) &&
       context()->AreAnalysesValid(IRContext::kAnalysisDebugInfo)) {
@@ -936,29 +1071,46 @@ bool Instruction::IsNonSemanticInstruction() const {
   return import_name.find("NonSemantic.") == 0;
 }
 
+uint32_t DebugScope::GetNumWords() const {
+  if (GetLexicalScope() == kNoDebugScope) return kDebugNoScopeNumWords;
+  if (GetInlinedAt() == kNoInlinedAt) {
+    return kDebugScopeNumWordsWithoutInlinedAt;
+  }
+  return kDebugScopeNumWords;
+}
+
 void DebugScope::ToBinary(uint32_t type_id, uint32_t result_id,
                           uint32_t ext_set,
                           std::vector<uint32_t>* binary) const {
-  uint32_t num_words = kDebugScopeNumWords;
-  OpenCLDebugInfo100Instructions dbg_opcode = OpenCLDebugInfo100DebugScope;
-  if (GetLexicalScope() == kNoDebugScope) {
-    num_words = kDebugNoScopeNumWords;
-    dbg_opcode = OpenCLDebugInfo100DebugNoScope;
-  } else if (GetInlinedAt() == kNoInlinedAt) {
-    num_words = kDebugScopeNumWordsWithoutInlinedAt;
-  }
-  std::vector<uint32_t> operands = {
-      (num_words << 16) | static_cast<uint16_t>(SpvOpExtInst),
-      type_id,
-      result_id,
-      ext_set,
-      static_cast<uint32_t>(dbg_opcode),
-  };
-  binary->insert(binary->end(), operands.begin(), operands.end());
+  const size_t offset = binary->size();
+  binary->resize(offset + GetNumWords());
+  ToBinary(type_id, result_id, ext_set, binary->data() + offset);
+}
+
+uint32_t* DebugScope::ToBinary(uint32_t type_id, uint32_t result_id,
+                               uint32_t ext_set, uint32_t* binary) const {
+  const uint32_t num_words = GetNumWords();
+  const OpenCLDebugInfo100Instructions dbg_opcode =
+      GetLexicalScope() == kNoDebugScope ? OpenCLDebugInfo100DebugNoScope
+                                         : OpenCLDebugInfo100DebugScope;
+  *binary++ = (num_words << 16) | static_cast<uint16_t>(SpvOpExtInst);
+  *binary++ = type_id;
+  *binary++ = result_id;
+  *binary++ = ext_set;
+  *binary++ = static_cast<uint32_t>(dbg_opcode);
   if (GetLexicalScope() != kNoDebugScope) {
-    binary->push_back(GetLexicalScope());
-    if (GetInlinedAt() != kNoInlinedAt) binary->push_back(GetInlinedAt());
+    *binary++ = GetLexicalScope();
+    if (GetInlinedAt() != kNoInlinedAt) *binary++ = GetInlinedAt();
+  }
+  return binary;
+}
+
+size_t Instruction::MemoryUsage() const {
+  size_t bytes = sizeof(Instruction) + utils::MemoryUsage(operands_);
+  for (const auto& operand : operands_) {
+    bytes += utils::MemoryUsage(operand.words);
   }
+  return bytes;
 }
 
 }  // namespace opt
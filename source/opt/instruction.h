@@ -27,7 +27,9 @@
 #include "source/latest_version_spirv_header.h"
 #include "source/opcode.h"
 #include "source/operand.h"
+#include "source/opt/debug_line_table.h"
 #include "source/opt/reflect.h"
+#include "source/util/function_ref.h"
 #include "source/util/ilist_node.h"
 #include "source/util/small_vector.h"
 #include "spirv-tools/libspirv.h"
@@ -139,11 +141,21 @@ class DebugScope {
   uint32_t GetInlinedAt() const { return inlined_at_; }
   void SetInlinedAt(uint32_t at) { inlined_at_ = at; }
 
+  // Returns the number of words of the DebugScope or DebugNoScope
+  // instruction for this scope.
+  uint32_t GetNumWords() const;
+
   // Pushes the binary segments for this DebugScope instruction into
   // the back of *|binary|.
   void ToBinary(uint32_t type_id, uint32_t result_id, uint32_t ext_set,
                 std::vector<uint32_t>* binary) const;
 
+  // Writes the binary segments for this DebugScope instruction to |binary|,
+  // which must have room for GetNumWords() words.  Returns the position past
+  // the last word written.
+  uint32_t* ToBinary(uint32_t type_id, uint32_t result_id, uint32_t ext_set,
+                     uint32_t* binary) const;
+
  private:
   // The result id of the lexical scope in which this debug scope is
   // contained. The value is kNoDebugScope if there is no scope.
@@ -163,8 +175,12 @@ class DebugScope {
 class Instruction : public utils::IntrusiveNodeBase<Instruction> {
  public:
   using OperandList = std::vector<Operand>;
-  using iterator = OperandList::iterator;
-  using const_iterator = OperandList::const_iterator;
+  // The operands of an instruction.  An instruction holds up to four operands
+  // in itself, and an operand up to two words, so reading the operands of most
+  // instructions follows no pointer to another allocation.
+  using OperandStorage = utils::SmallVector<Operand, 4>;
+  using iterator = OperandStorage::iterator;
+  using const_iterator = OperandStorage::const_iterator;
 
   // Creates a default OpNop instruction.
   // This exists solely for containers that can't do without. Should be removed.
@@ -175,6 +191,8 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
         has_type_id_(false),
         has_result_id_(false),
         unique_id_(0),
+        list_order_(0),
+        dbg_lines_index_(0),
         dbg_scope_(kNoDebugScope, kNoInlinedAt) {}
 
   // Creates a default OpNop instruction.
@@ -207,6 +225,11 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
 
   virtual ~Instruction() = default;
 
+  // Instructions are allocated from the current InstructionArena of the
+  // calling thread, if there is one, and from the heap otherwise.
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr);
+
   // Returns a newly allocated instruction that has the same operands, result,
   // and type as |this|.  The new instruction is not linked into any list.
   // It is the responsibility of the caller to make sure that the storage is
@@ -232,24 +255,27 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
     assert(unique_id_ != 0);
     return unique_id_;
   }
-  // Returns the vector of line-related debug instructions attached to this
-  // instruction and the caller can directly modify them.
-  std::vector<Instruction>& dbg_line_insts() { return dbg_line_insts_; }
-  const std::vector<Instruction>& dbg_line_insts() const {
-    return dbg_line_insts_;
-  }
-
-  const Instruction* dbg_line_inst() const {
-    return dbg_line_insts_.empty() ? nullptr : &dbg_line_insts_[0];
+  // Returns the line-related debug instructions attached to this
+  // instruction, in order.  They are kept in the debug line table of the
+  // context, so the reference stays valid after the lines of this instruction
+  // change.
+  const std::vector<DebugLine>& dbg_lines() const;
+  bool has_dbg_lines() const { return dbg_lines_index_ != 0; }
+
+  // Returns the first line-related debug instruction attached to this
+  // instruction, or nullptr if there is none.
+  const DebugLine* dbg_line() const {
+    return has_dbg_lines() ? &dbg_lines().front() : nullptr;
   }
 
   // Clear line-related debug instructions attached to this instruction.
-  void clear_dbg_line_insts() { dbg_line_insts_.clear(); }
+  void clear_dbg_lines() { dbg_lines_index_ = 0; }
 
   // Set line-related debug instructions.
-  void set_dbg_line_insts(const std::vector<Instruction>& lines) {
-    dbg_line_insts_ = lines;
-  }
+  void set_dbg_lines(const std::vector<DebugLine>& lines);
+
+  // Appends |line| to the line-related debug instructions.
+  void AddDbgLine(const DebugLine& line);
 
   // Same semantics as in the base class except the list the InstructionList
   // containing |pos| will now assume ownership of |this|.
@@ -273,6 +299,9 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   uint32_t NumOperandWords() const {
     return NumInOperandWords() + TypeResultIdCount();
   }
+  // Returns an approximation of the number of bytes of memory used by this
+  // instruction and its operands.
+  size_t MemoryUsage() const;
   // Gets the |index|-th logical operand.
   inline Operand& GetOperand(uint32_t index);
   inline const Operand& GetOperand(uint32_t index) const;
@@ -283,7 +312,7 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   // Gets the |index|-th logical operand as a single SPIR-V word. This method is
   // not expected to be used with logical operands consisting of multiple SPIR-V
   // words.
-  uint32_t GetSingleWordOperand(uint32_t index) const;
+  inline uint32_t GetSingleWordOperand(uint32_t index) const;
   // Sets the |index|-th in-operand's data to the given |data|.
   inline void SetInOperand(uint32_t index, Operand::OperandData&& data);
   // Sets the |index|-th operand's data to the given |data|.
@@ -315,7 +344,7 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   }
   // Insert an operand before the |index|-th operand
   void InsertOperand(uint32_t index, Operand&& operand) {
-    operands_.insert(operands_.begin() + index, operand);
+    operands_.insert(operands_.begin() + index, &operand, &operand + 1);
   }
 
   // The following methods are similar to the above, but are for in operands.
@@ -345,46 +374,50 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   // Runs the given function |f| on this instruction and optionally on the
   // preceding debug line instructions.  The function will always be run
   // if this is itself a debug line instruction.
-  inline void ForEachInst(const std::function<void(Instruction*)>& f,
+  //
+  // The debug line instructions are not stored as instructions, so |f| gets
+  // a temporary instruction for each of them.  Changes |f| makes to one are
+  // stored back into the lines of this instruction, and the line is dropped if
+  // |f| turned it into another opcode, such as OpNop.
+  inline void ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                           bool run_on_debug_line_insts = false);
-  inline void ForEachInst(const std::function<void(const Instruction*)>& f,
+  inline void ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                           bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on this instruction and optionally on the
-  // preceding debug line instructions.  The function will always be run
-  // if this is itself a debug line instruction. If |f| returns false,
-  // iteration is terminated and this function returns false.
-  inline bool WhileEachInst(const std::function<bool(Instruction*)>& f,
-                            bool run_on_debug_line_insts = false);
-  inline bool WhileEachInst(const std::function<bool(const Instruction*)>& f,
-                            bool run_on_debug_line_insts = false) const;
+  // preceding debug line instructions, as |ForEachInst| does.  The function
+  // will always be run if this is itself a debug line instruction. If |f|
+  // returns false, iteration is terminated and this function returns false.
+  bool WhileEachInst(utils::FunctionRef<bool(Instruction*)> f,
+                     bool run_on_debug_line_insts = false);
+  bool WhileEachInst(utils::FunctionRef<bool(const Instruction*)> f,
+                     bool run_on_debug_line_insts = false) const;
 
   // Runs the given function |f| on all operand ids.
   //
   // |f| should not transform an ID into 0, as 0 is an invalid ID.
-  inline void ForEachId(const std::function<void(uint32_t*)>& f);
-  inline void ForEachId(const std::function<void(const uint32_t*)>& f) const;
+  inline void ForEachId(utils::FunctionRef<void(uint32_t*)> f);
+  inline void ForEachId(utils::FunctionRef<void(const uint32_t*)> f) const;
 
   // Runs the given function |f| on all "in" operand ids.
-  inline void ForEachInId(const std::function<void(uint32_t*)>& f);
-  inline void ForEachInId(const std::function<void(const uint32_t*)>& f) const;
+  inline void ForEachInId(utils::FunctionRef<void(uint32_t*)> f);
+  inline void ForEachInId(utils::FunctionRef<void(const uint32_t*)> f) const;
 
   // Runs the given function |f| on all "in" operand ids. If |f| returns false,
   // iteration is terminated and this function returns false.
-  inline bool WhileEachInId(const std::function<bool(uint32_t*)>& f);
-  inline bool WhileEachInId(
-      const std::function<bool(const uint32_t*)>& f) const;
+  inline bool WhileEachInId(utils::FunctionRef<bool(uint32_t*)> f);
+  inline bool WhileEachInId(utils::FunctionRef<bool(const uint32_t*)> f) const;
 
   // Runs the given function |f| on all "in" operands.
-  inline void ForEachInOperand(const std::function<void(uint32_t*)>& f);
+  inline void ForEachInOperand(utils::FunctionRef<void(uint32_t*)> f);
   inline void ForEachInOperand(
-      const std::function<void(const uint32_t*)>& f) const;
+      utils::FunctionRef<void(const uint32_t*)> f) const;
 
   // Runs the given function |f| on all "in" operands. If |f| returns false,
   // iteration is terminated and this function return false.
-  inline bool WhileEachInOperand(const std::function<bool(uint32_t*)>& f);
+  inline bool WhileEachInOperand(utils::FunctionRef<bool(uint32_t*)> f);
   inline bool WhileEachInOperand(
-      const std::function<bool(const uint32_t*)>& f) const;
+      utils::FunctionRef<bool(const uint32_t*)> f) const;
 
   // Returns true if it's an OpBranchConditional instruction
   // with branch weights.
@@ -396,6 +429,11 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   // Pushes the binary segments for this instruction into the back of *|binary|.
   void ToBinaryWithoutAttachedDebugInsts(std::vector<uint32_t>* binary) const;
 
+  // Writes the binary segments for this instruction to |binary|, which must
+  // have room for 1 + NumOperandWords() words.  Returns the position past the
+  // last word written.
+  uint32_t* ToBinaryWithoutAttachedDebugInsts(uint32_t* binary) const;
+
   // Replaces the operands to the instruction with |new_operands|. The caller
   // is responsible for building a complete and valid list of operands for
   // this instruction.
@@ -577,22 +615,40 @@ class Instruction : public utils::IntrusiveNodeBase<Instruction> {
   // instruction that samples a image, reads an image, or writes to an image.
   bool IsValidBaseImage() const;
 
+  // Numbers |this| between the previous instruction and |next|, if there is
+  // room for it, and otherwise leaves its number unknown.  See |list_order_|.
+  void OnInsertedInList(Instruction* next);
+
+  // Returns an OpLine or OpNoLine instruction for |line|, in the debug scope
+  // of this instruction.  It only takes a unique id from the context if
+  // |take_unique_id| is true: read-only walks run on every ToBinary, and ids
+  // taken there would keep growing the tables indexed by unique id.
+  Instruction MakeDbgLineInst(const DebugLine& line,
+                              bool take_unique_id) const;
+
   IRContext* context_;  // IR Context
   SpvOp opcode_;        // Opcode
   bool has_type_id_;    // True if the instruction has a type id
   bool has_result_id_;  // True if the instruction has a result id
   uint32_t unique_id_;  // Unique instruction id
+  // The number of the instruction in its list, or 0 if it is unknown.  The
+  // known numbers increase along the list, so that InstructionList::IsBefore
+  // compares them, after numbering the list again if one is unknown.
+  uint32_t list_order_;
   // All logical operands, including result type id and result id.
-  OperandList operands_;
-  // Opline and OpNoLine instructions preceding this instruction. Note that for
-  // Instructions representing OpLine or OpNonLine itself, this field should be
-  // empty.
-  std::vector<Instruction> dbg_line_insts_;
+  OperandStorage operands_;
+  // The index in the debug line table of the context of the OpLine and
+  // OpNoLine instructions preceding this instruction, or 0 if there are none.
+  // Note that for Instructions representing OpLine or OpNonLine itself, there
+  // should be none.
+  uint32_t dbg_lines_index_;
 
   // DebugScope that wraps this instruction.
   DebugScope dbg_scope_;
 
   friend InstructionList;
+  friend utils::IntrusiveNodeBase<Instruction>;
+  friend utils::IntrusiveList<Instruction>;
 };
 
 // Pretty-prints |inst| to |str| and returns |str|.
@@ -625,6 +681,12 @@ inline const Operand& Instruction::GetOperand(uint32_t index) const {
   return operands_[index];
 }
 
+inline uint32_t Instruction::GetSingleWordOperand(uint32_t index) const {
+  const auto& words = GetOperand(index).words;
+  assert(words.size() == 1 && "expected the operand only taking one word");
+  return words.front();
+}
+
 inline void Instruction::AddOperand(Operand&& operand) {
   operands_.push_back(std::move(operand));
 }
@@ -665,9 +727,6 @@ inline void Instruction::SetResultId(uint32_t res_id) {
 
 inline void Instruction::SetDebugScope(const DebugScope& scope) {
   dbg_scope_ = scope;
-  for (auto& i : dbg_line_insts_) {
-    i.dbg_scope_ = scope;
-  }
 }
 
 inline void Instruction::SetResultType(uint32_t ty_id) {
@@ -696,28 +755,7 @@ inline void Instruction::ToNop() {
   operands_.clear();
 }
 
-inline bool Instruction::WhileEachInst(
-    const std::function<bool(Instruction*)>& f, bool run_on_debug_line_insts) {
-  if (run_on_debug_line_insts) {
-    for (auto& dbg_line : dbg_line_insts_) {
-      if (!f(&dbg_line)) return false;
-    }
-  }
-  return f(this);
-}
-
-inline bool Instruction::WhileEachInst(
-    const std::function<bool(const Instruction*)>& f,
-    bool run_on_debug_line_insts) const {
-  if (run_on_debug_line_insts) {
-    for (auto& dbg_line : dbg_line_insts_) {
-      if (!f(&dbg_line)) return false;
-    }
-  }
-  return f(this);
-}
-
-inline void Instruction::ForEachInst(const std::function<void(Instruction*)>& f,
+inline void Instruction::ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                                      bool run_on_debug_line_insts) {
   WhileEachInst(
       [&f](Instruction* inst) {
@@ -728,7 +766,7 @@ inline void Instruction::ForEachInst(const std::function<void(Instruction*)>& f,
 }
 
 inline void Instruction::ForEachInst(
-    const std::function<void(const Instruction*)>& f,
+    utils::FunctionRef<void(const Instruction*)> f,
     bool run_on_debug_line_insts) const {
   WhileEachInst(
       [&f](const Instruction* inst) {
@@ -738,19 +776,18 @@ inline void Instruction::ForEachInst(
       run_on_debug_line_insts);
 }
 
-inline void Instruction::ForEachId(const std::function<void(uint32_t*)>& f) {
+inline void Instruction::ForEachId(utils::FunctionRef<void(uint32_t*)> f) {
   for (auto& operand : operands_)
     if (spvIsIdType(operand.type)) f(&operand.words[0]);
 }
 
 inline void Instruction::ForEachId(
-    const std::function<void(const uint32_t*)>& f) const {
+    utils::FunctionRef<void(const uint32_t*)> f) const {
   for (const auto& operand : operands_)
     if (spvIsIdType(operand.type)) f(&operand.words[0]);
 }
 
-inline bool Instruction::WhileEachInId(
-    const std::function<bool(uint32_t*)>& f) {
+inline bool Instruction::WhileEachInId(utils::FunctionRef<bool(uint32_t*)> f) {
   for (auto& operand : operands_) {
     if (spvIsInIdType(operand.type) && !f(&operand.words[0])) {
       return false;
@@ -760,7 +797,7 @@ inline bool Instruction::WhileEachInId(
 }
 
 inline bool Instruction::WhileEachInId(
-    const std::function<bool(const uint32_t*)>& f) const {
+    utils::FunctionRef<bool(const uint32_t*)> f) const {
   for (const auto& operand : operands_) {
     if (spvIsInIdType(operand.type) && !f(&operand.words[0])) {
       return false;
@@ -769,23 +806,19 @@ inline bool Instruction::WhileEachInId(
   return true;
 }
 
-inline void Instruction::ForEachInId(const std::function<void(uint32_t*)>& f) {
-  WhileEachInId([&f](uint32_t* id) {
-    f(id);
-    return true;
-  });
+inline void Instruction::ForEachInId(utils::FunctionRef<void(uint32_t*)> f) {
+  for (auto& operand : operands_)
+    if (spvIsInIdType(operand.type)) f(&operand.words[0]);
 }
 
 inline void Instruction::ForEachInId(
-    const std::function<void(const uint32_t*)>& f) const {
-  WhileEachInId([&f](const uint32_t* id) {
-    f(id);
-    return true;
-  });
+    utils::FunctionRef<void(const uint32_t*)> f) const {
+  for (const auto& operand : operands_)
+    if (spvIsInIdType(operand.type)) f(&operand.words[0]);
 }
 
 inline bool Instruction::WhileEachInOperand(
-    const std::function<bool(uint32_t*)>& f) {
+    utils::FunctionRef<bool(uint32_t*)> f) {
   for (auto& operand : operands_) {
     switch (operand.type) {
       case SPV_OPERAND_TYPE_RESULT_ID:
@@ -800,7 +833,7 @@ inline bool Instruction::WhileEachInOperand(
 }
 
 inline bool Instruction::WhileEachInOperand(
-    const std::function<bool(const uint32_t*)>& f) const {
+    utils::FunctionRef<bool(const uint32_t*)> f) const {
   for (const auto& operand : operands_) {
     switch (operand.type) {
       case SPV_OPERAND_TYPE_RESULT_ID:
@@ -815,7 +848,7 @@ inline bool Instruction::WhileEachInOperand(
 }
 
 inline void Instruction::ForEachInOperand(
-    const std::function<void(uint32_t*)>& f) {
+    utils::FunctionRef<void(uint32_t*)> f) {
   WhileEachInOperand([&f](uint32_t* operand) {
     f(operand);
     return true;
@@ -823,7 +856,7 @@ inline void Instruction::ForEachInOperand(
 }
 
 inline void Instruction::ForEachInOperand(
-    const std::function<void(const uint32_t*)>& f) const {
+    utils::FunctionRef<void(const uint32_t*)> f) const {
   WhileEachInOperand([&f](const uint32_t* operand) {
     f(operand);
     return true;
@@ -0,0 +1,130 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/instruction_arena.h"
+
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// The alignment of the storage returned by the global operator new, and of
+// the slots of an arena.
+const size_t kSlotAlignment = alignof(std::max_align_t);
+
+// The objects allocated from an arena are preceded by a header holding the
+// arena.  The header is smaller than |kSlotAlignment|, so these objects are
+// never aligned to it, while the objects allocated from the heap always are.
+// That is how |Free| tells them apart, without adding a header to the heap
+// allocations.
+const size_t kHeaderSize = sizeof(InstructionArena*) > alignof(Instruction)
+                               ? sizeof(InstructionArena*)
+                               : alignof(Instruction);
+static_assert(kHeaderSize % alignof(Instruction) == 0,
+              "Instructions after the header would not be aligned");
+static_assert(kHeaderSize < kSlotAlignment,
+              "Arena objects could not be told apart from heap objects");
+
+// The size of the slots handed out by an arena, including the header.
+const size_t kSlotSize =
+    ((kHeaderSize + sizeof(Instruction) + kSlotAlignment - 1) /
+     kSlotAlignment) *
+    kSlotAlignment;
+
+bool IsFromArena(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % kSlotAlignment != 0;
+}
+
+// The number of slots in each chunk the arena obtains from the system.
+const size_t kSlotsPerChunk = 512;
+const size_t kChunkSize = kSlotSize * kSlotsPerChunk;
+
+thread_local InstructionArena* current_arena = nullptr;
+
+}  // namespace
+
+InstructionArena::Scope::Scope(InstructionArena* arena)
+    : previous_(current_arena) {
+  current_arena = arena;
+}
+
+InstructionArena::Scope::~Scope() { current_arena = previous_; }
+
+InstructionArena::InstructionArena()
+    : next_offset_(kChunkSize), free_list_(nullptr), num_live_objects_(0) {}
+
+InstructionArena::~InstructionArena() {
+  assert(num_live_objects_ == 0 &&
+         "Instructions allocated in the arena have not been destroyed.");
+}
+
+InstructionArena* InstructionArena::Current() { return current_arena; }
+
+size_t InstructionArena::num_reserved_bytes() const {
+  return chunks_.size() * kChunkSize;
+}
+
+void* InstructionArena::Allocate(size_t size) {
+  InstructionArena* arena = current_arena;
+  if (arena == nullptr || size != sizeof(Instruction)) {
+    void* ptr = ::operator new(size);
+    assert(!IsFromArena(ptr) && "The heap returned misaligned storage.");
+    return ptr;
+  }
+  char* block = static_cast<char*>(arena->AllocateSlot());
+  *reinterpret_cast<InstructionArena**>(block) = arena;
+  return block + kHeaderSize;
+}
+
+void InstructionArena::Free(void* ptr) {
+  if (ptr == nullptr) return;
+  if (!IsFromArena(ptr)) {
+    ::operator delete(ptr);
+    return;
+  }
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  (*reinterpret_cast<InstructionArena**>(block))->ReleaseSlot(block);
+}
+
+void* InstructionArena::AllocateSlot() {
+  ++num_live_objects_;
+  if (free_list_ != nullptr) {
+    FreeNode* slot = free_list_;
+    free_list_ = slot->next;
+    return slot;
+  }
+  if (next_offset_ + kSlotSize > kChunkSize) {
+    chunks_.emplace_back(new char[kChunkSize]);
+    next_offset_ = 0;
+  }
+  void* slot = chunks_.back().get() + next_offset_;
+  next_offset_ += kSlotSize;
+  return slot;
+}
+
+void InstructionArena::ReleaseSlot(void* slot) {
+  assert(num_live_objects_ > 0);
+  --num_live_objects_;
+  FreeNode* free_slot = static_cast<FreeNode*>(slot);
+  free_slot->next = free_list_;
+  free_list_ = free_slot;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INSTRUCTION_ARENA_H_
+#define SOURCE_OPT_INSTRUCTION_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+// An arena that provides the storage for |Instruction| objects.
+//
+// Storage is handed out from large chunks with a bump pointer, and storage
+// that is freed is kept on a free list to be reused.  The chunks are only
+// returned to the system when the arena is destroyed, so every instruction
+// allocated from an arena must be destroyed before the arena is.
+//
+// Instructions are allocated from the arena that is current on the calling
+// thread (see |Scope|), or from the heap if there is none.  Every arena
+// allocation records the arena it came from, so instructions from different
+// arenas, or from the heap, can be freed the same way with |delete|.  Heap
+// allocations cost nothing more than a plain |new|.
+class InstructionArena {
+ public:
+  // Makes |arena| the current arena of the calling thread for the lifetime of
+  // the scope object.  |arena| can be nullptr, in which case instructions are
+  // allocated from the heap.  Scopes can be nested.
+  class Scope {
+   public:
+    explicit Scope(InstructionArena* arena);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    InstructionArena* previous_;
+  };
+
+  InstructionArena();
+  ~InstructionArena();
+
+  InstructionArena(const InstructionArena&) = delete;
+  InstructionArena& operator=(const InstructionArena&) = delete;
+
+  // Returns the current arena of the calling thread, or nullptr if there is
+  // none.
+  static InstructionArena* Current();
+
+  // Returns storage for an object of |size| bytes.  The storage comes from the
+  // current arena if there is one and |size| is the size of an |Instruction|.
+  // Otherwise it comes from the heap.
+  static void* Allocate(size_t size);
+
+  // Frees storage returned by |Allocate|.  Does nothing if |ptr| is nullptr.
+  static void Free(void* ptr);
+
+  // Returns the number of objects allocated from this arena that have not yet
+  // been freed.
+  size_t num_live_objects() const { return num_live_objects_; }
+
+  // Returns the number of bytes this arena has obtained from the system.
+  size_t num_reserved_bytes() const;
+
+ private:
+  // A freed slot in the arena.  The free list is threaded through the slots.
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  // Returns a slot of the arena's fixed slot size.
+  void* AllocateSlot();
+
+  // Returns |slot| to the free list.
+  void ReleaseSlot(void* slot);
+
+  // The chunks of memory obtained from the system.
+  std::vector<std::unique_ptr<char[]>> chunks_;
+
+  // The offset of the first unused byte of the last chunk.
+  size_t next_offset_;
+
+  // The head of the list of freed slots.
+  FreeNode* free_list_;
+
+  // The number of live objects allocated from this arena.
+  size_t num_live_objects_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INSTRUCTION_ARENA_H_
@@ -14,6 +14,9 @@
 
 #include "source/opt/instruction_list.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace spvtools {
 namespace opt {
 
@@ -32,5 +35,24 @@ InstructionList::iterator InstructionList::iterator::InsertBefore(
   i.get()->InsertBefore(node_);
   return iterator(i.release());
 }
+
+bool InstructionList::IsBefore(const Instruction* a, const Instruction* b) {
+  if (a->list_order_ == 0 || b->list_order_ == 0) NumberInstructions();
+  assert(a->list_order_ != 0 && b->list_order_ != 0 &&
+         "The instructions are not in the list.");
+  return a->list_order_ < b->list_order_;
+}
+
+void InstructionList::NumberInstructions() {
+  uint64_t count = 0;
+  for (auto i = begin(); i != end(); ++i) ++count;
+  const uint64_t step = std::max<uint64_t>(
+      1, std::numeric_limits<uint32_t>::max() / (count + 1));
+  uint64_t order = 0;
+  for (auto& inst : *this) {
+    order += step;
+    inst.list_order_ = static_cast<uint32_t>(order);
+  }
+}
 }  // namespace opt
 }  // namespace spvtools
@@ -25,6 +25,7 @@
 #include "source/latest_version_spirv_header.h"
 #include "source/operand.h"
 #include "source/opt/instruction.h"
+#include "source/util/function_ref.h"
 #include "source/util/ilist.h"
 #include "spirv-tools/libspirv.h"
 
@@ -112,9 +113,15 @@ class InstructionList : public utils::IntrusiveList<Instruction> {
   // Same as in the base class, except it will delete the data as well.
   inline void clear();
 
+  // Returns true if |a| comes before |b| in this list.  Both must be in the
+  // list.  This compares the numbers the instructions keep of their position,
+  // so it takes constant time, unless so many instructions were inserted at
+  // the same place since the list was last numbered that it is numbered again.
+  bool IsBefore(const Instruction* a, const Instruction* b);
+
   // Runs the given function |f| on the instructions in the list and optionally
   // on the preceding debug line instructions.
-  inline void ForEachInst(const std::function<void(Instruction*)>& f,
+  inline void ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                           bool run_on_debug_line_insts) {
     auto next = begin();
     for (auto i = next; i != end(); i = next) {
@@ -122,6 +129,12 @@ class InstructionList : public utils::IntrusiveList<Instruction> {
       i->ForEachInst(f, run_on_debug_line_insts);
     }
   }
+
+ private:
+  // Numbers the instructions of the list in order, evenly spread over the
+  // numbers an instruction can keep, to leave room for the instructions
+  // inserted later.
+  void NumberInstructions();
 };
 
 InstructionList::~InstructionList() { clear(); }
@@ -0,0 +1,225 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/instruction_scheduling_pass.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "source/opcode.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kLoadMemoryAccessInIdx = 1;
+
+// Returns true if |inst| is a load that may be reordered with other loads.
+bool IsReorderableLoad(const Instruction* inst) {
+  if (inst->opcode() != SpvOpLoad) return false;
+  if (inst->NumInOperands() <= kLoadMemoryAccessInIdx) return true;
+  return (inst->GetSingleWordInOperand(kLoadMemoryAccessInIdx) &
+          SpvMemoryAccessVolatileMask) == 0;
+}
+
+}  // namespace
+
+bool InstructionSchedulingPass::IsRegister(uint32_t id) {
+  Instruction* def = get_def_use_mgr()->GetDef(id);
+  if (def == nullptr) return false;
+  switch (def->opcode()) {
+    case SpvOpFunctionParameter:
+      return true;
+    case SpvOpLabel:
+    case SpvOpUndef:
+    case SpvOpVariable:
+      return false;
+    default:
+      return !spvOpcodeIsConstant(def->opcode()) &&
+             context()->get_instr_block(def) != nullptr;
+  }
+}
+
+std::vector<uint32_t> InstructionSchedulingPass::GetRegisterOperands(
+    const Instruction* inst) {
+  std::vector<uint32_t> operands;
+  inst->ForEachInId([this, &operands](const uint32_t* id) {
+    if (IsRegister(*id) &&
+        std::find(operands.begin(), operands.end(), *id) == operands.end()) {
+      operands.push_back(*id);
+    }
+  });
+  return operands;
+}
+
+size_t InstructionSchedulingPass::GetMaxPressure(
+    const std::vector<Instruction*>& order, LiveSet live) {
+  size_t max_pressure = live.size();
+  for (Instruction* inst : order) {
+    if (inst->HasResultId()) {
+      live.insert(inst->result_id());
+      max_pressure = std::max(max_pressure, live.size());
+      live.erase(inst->result_id());
+    }
+    for (uint32_t id : GetRegisterOperands(inst)) live.insert(id);
+    max_pressure = std::max(max_pressure, live.size());
+  }
+  return max_pressure;
+}
+
+bool InstructionSchedulingPass::ScheduleBlock(
+    BasicBlock* bb, const RegisterLiveness::RegionRegisterLiveness& liveness) {
+  // The phis and variables stay at the start of the block, and the merge and
+  // branch at its end.  Everything in between may be reordered.
+  Instruction* end = bb->GetMergeInst();
+  if (end == nullptr) end = bb->terminator();
+  std::vector<Instruction*> insts;
+  std::unordered_map<const Instruction*, size_t> index;
+  for (Instruction& inst : *bb) {
+    if (&inst == end) break;
+    if (inst.opcode() == SpvOpPhi || inst.opcode() == SpvOpVariable) continue;
+    index[&inst] = insts.size();
+    insts.push_back(&inst);
+  }
+  if (insts.size() < 3) return false;
+
+  // |preds[i]| are the instructions that must come before the |i|th one, and
+  // |num_succs[i]| the number of those that must come after it.
+  std::vector<std::vector<size_t>> preds(insts.size());
+  std::vector<size_t> num_succs(insts.size(), 0);
+  auto add_dependence = [&preds, &num_succs](size_t from, size_t to) {
+    preds[to].push_back(from);
+    ++num_succs[from];
+  };
+  const size_t kNone = insts.size();
+  size_t last_write = kNone;
+  std::vector<size_t> reads_since_last_write;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    Instruction* inst = insts[i];
+    inst->ForEachInId([this, &index, &add_dependence, i](const uint32_t* id) {
+      auto it = index.find(get_def_use_mgr()->GetDef(*id));
+      if (it != index.end()) add_dependence(it->second, i);
+    });
+    if (context()->IsCombinatorInstruction(inst)) continue;
+
+    // Memory and barrier instructions are ordered with each other.
+    if (last_write != kNone) add_dependence(last_write, i);
+    if (IsReorderableLoad(inst)) {
+      reads_since_last_write.push_back(i);
+    } else {
+      for (size_t read : reads_since_last_write) add_dependence(read, i);
+      reads_since_last_write.clear();
+      last_write = i;
+    }
+  }
+
+  LiveSet live_out;
+  for (Instruction* inst : liveness.live_out_) {
+    if (IsRegister(inst->result_id())) live_out.insert(inst->result_id());
+  }
+  for (uint32_t id : GetRegisterOperands(bb->terminator())) {
+    live_out.insert(id);
+  }
+
+  // |operands[i]| are the register operands of the |i|th instruction, and
+  // |users[id]| the instructions that use |id|.
+  std::vector<std::vector<uint32_t>> operands(insts.size());
+  std::unordered_map<uint32_t, std::vector<size_t>> users;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    operands[i] = GetRegisterOperands(insts[i]);
+    for (uint32_t id : operands[i]) users[id].push_back(i);
+  }
+
+  // |delta[i]| is the change in the number of live values if the |i|th
+  // instruction is placed next.  It only goes down as values become live, so
+  // it is updated for the definition and the users of each new live value.
+  LiveSet live = live_out;
+  std::vector<int> delta(insts.size(), 0);
+  for (size_t i = 0; i < insts.size(); ++i) {
+    if (live.count(insts[i]->result_id())) delta[i] = -1;
+    for (uint32_t id : operands[i]) {
+      if (!live.count(id)) ++delta[i];
+    }
+  }
+  auto make_live = [this, &live, &users, &index, &delta](uint32_t id) {
+    if (!live.insert(id).second) return;
+    auto users_it = users.find(id);
+    if (users_it != users.end()) {
+      for (size_t user : users_it->second) --delta[user];
+    }
+    auto def_it = index.find(get_def_use_mgr()->GetDef(id));
+    if (def_it != index.end()) --delta[def_it->second];
+  };
+
+  // Schedules bottom up, placing the ready instruction that increases the
+  // number of live values the least.  Ties go to the one that comes last in
+  // the original order, so that the order is kept when nothing is gained.
+  std::vector<Instruction*> schedule;
+  std::vector<size_t> ready;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    if (num_succs[i] == 0) ready.push_back(i);
+  }
+  while (!ready.empty()) {
+    size_t best = 0;
+    for (size_t r = 1; r < ready.size(); ++r) {
+      if (delta[ready[r]] < delta[ready[best]] ||
+          (delta[ready[r]] == delta[ready[best]] && ready[r] > ready[best])) {
+        best = r;
+      }
+    }
+
+    size_t i = ready[best];
+    ready.erase(ready.begin() + best);
+    Instruction* inst = insts[i];
+    schedule.push_back(inst);
+    // No user of the result is left to be placed, so only |delta[i]| would
+    // depend on it.
+    live.erase(inst->result_id());
+    for (uint32_t id : operands[i]) make_live(id);
+    for (size_t pred : preds[i]) {
+      if (--num_succs[pred] == 0) ready.push_back(pred);
+    }
+  }
+  assert(schedule.size() == insts.size() && "Cycle in the dependences.");
+
+  std::vector<Instruction*> original(insts.rbegin(), insts.rend());
+  if (GetMaxPressure(schedule, live_out) >=
+      GetMaxPressure(original, live_out)) {
+    return false;
+  }
+
+  for (auto it = schedule.rbegin(); it != schedule.rend(); ++it) {
+    (*it)->InsertBefore(end);
+  }
+  return true;
+}
+
+Pass::Status InstructionSchedulingPass::Process() {
+  bool modified = false;
+  for (Function& func : *get_module()) {
+    if (func.begin() == func.end()) continue;
+    const RegisterLiveness* liveness =
+        context()->GetLivenessAnalysis()->Get(&func);
+    for (BasicBlock& bb : func) {
+      const RegisterLiveness::RegionRegisterLiveness* bb_liveness =
+          liveness->Get(&bb);
+      if (bb_liveness == nullptr) continue;
+      modified |= ScheduleBlock(&bb, *bb_liveness);
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
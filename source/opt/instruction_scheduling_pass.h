@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_INSTRUCTION_SCHEDULING_PASS_H_
+#define SOURCE_OPT_INSTRUCTION_SCHEDULING_PASS_H_
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+#include "source/opt/register_pressure.h"
+
+namespace spvtools {
+namespace opt {
+
+// This pass reorders the instructions of each basic block to lower the
+// maximum number of values live at the same time in the block.
+//
+// The blocks are list scheduled bottom up: among the instructions whose users
+// in the block have all been placed, the one that adds the fewest live values
+// is placed next.  The values live on exit of the block are given by
+// RegisterLiveness.  Instructions that are not combinators keep their
+// relative order, except that non-volatile loads may move past each other.
+// A block is only rewritten when its new order needs fewer registers.
+class InstructionSchedulingPass : public Pass {
+ public:
+  const char* name() const override { return "schedule-instructions"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisNameMap |
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes;
+  }
+
+ private:
+  using LiveSet = std::unordered_set<uint32_t>;
+
+  // Reorders the instructions of |bb|, whose liveness is |liveness|.  Returns
+  // true if |bb| was changed.
+  bool ScheduleBlock(
+      BasicBlock* bb,
+      const RegisterLiveness::RegionRegisterLiveness& liveness);
+
+  // Returns the maximum number of values live while executing |order|, which
+  // is a list of instructions given bottom up, when |live| are the values live
+  // after the last of them.
+  size_t GetMaxPressure(const std::vector<Instruction*>& order, LiveSet live);
+
+  // Returns the ids of the values used by |inst| that take a register, without
+  // duplicates.
+  std::vector<uint32_t> GetRegisterOperands(const Instruction* inst);
+
+  // Returns true if |id| is a value of the function that takes a register.
+  bool IsRegister(uint32_t id);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_INSTRUCTION_SCHEDULING_PASS_H_
@@ -412,6 +412,8 @@ uint32_t InstrumentPass::GetOutputBufferBinding() {
       return kDebugOutputBindingStream;
     case kInstValidationIdDebugPrintf:
       return kDebugOutputPrintfStream;
+    case kInstValidationIdBlockProfile:
+      return kDebugOutputBindingBlockProfile;
     default:
       assert(false && "unexpected validation id");
   }
@@ -704,15 +706,24 @@ uint32_t InstrumentPass::GetStreamWriteFunctionId(uint32_t stage_idx,
     Instruction* obuf_curr_sz_ac_inst =
         builder.AddBinaryOp(buf_uint_ptr_id, SpvOpAccessChain, buf_id,
                             builder.GetUintConstantId(kDebugOutputSizeOffset));
-    // Fetch the current debug buffer written size atomically, adding the
-    // size of the record to be written.
-    uint32_t obuf_record_sz_id = builder.GetUintConstantId(obuf_record_sz);
-    uint32_t mask_none_id = builder.GetUintConstantId(SpvMemoryAccessMaskNone);
-    uint32_t scope_invok_id = builder.GetUintConstantId(SpvScopeInvocation);
-    Instruction* obuf_curr_sz_inst = builder.AddQuadOp(
-        GetUintId(), SpvOpAtomicIAdd, obuf_curr_sz_ac_inst->result_id(),
-        scope_invok_id, mask_none_id, obuf_record_sz_id);
-    uint32_t obuf_curr_sz_id = obuf_curr_sz_inst->result_id();
+    uint32_t obuf_curr_sz_id = 0;
+    if (subgroup_stream_writes_ &&
+        get_module()->version() >= SPV_SPIRV_VERSION_WORD(1, 3)) {
+      obuf_curr_sz_id = GenSubgroupReserveCode(
+          obuf_record_sz, obuf_curr_sz_ac_inst->result_id(), &*output_func,
+          &new_blk_ptr, &builder);
+    } else {
+      // Fetch the current debug buffer written size atomically, adding the
+      // size of the record to be written.
+      uint32_t obuf_record_sz_id = builder.GetUintConstantId(obuf_record_sz);
+      uint32_t mask_none_id =
+          builder.GetUintConstantId(SpvMemoryAccessMaskNone);
+      uint32_t scope_invok_id = builder.GetUintConstantId(SpvScopeInvocation);
+      Instruction* obuf_curr_sz_inst = builder.AddQuadOp(
+          GetUintId(), SpvOpAtomicIAdd, obuf_curr_sz_ac_inst->result_id(),
+          scope_invok_id, mask_none_id, obuf_record_sz_id);
+      obuf_curr_sz_id = obuf_curr_sz_inst->result_id();
+    }
     // Compute new written size
     Instruction* obuf_new_sz_inst =
         builder.AddBinaryOp(GetUintId(), SpvOpIAdd, obuf_curr_sz_id,
@@ -766,6 +777,104 @@ uint32_t InstrumentPass::GetStreamWriteFunctionId(uint32_t stage_idx,
   return param2output_func_id_[param_cnt];
 }
 
+uint32_t InstrumentPass::GenSubgroupReserveCode(
+    uint32_t obuf_record_sz, uint32_t obuf_curr_sz_ac_id,
+    Function* output_func, std::unique_ptr<BasicBlock>* new_blk_ptr,
+    InstructionBuilder* builder) {
+  context()->AddCapability(SpvCapabilityGroupNonUniform);
+  context()->AddCapability(SpvCapabilityGroupNonUniformBallot);
+  uint32_t scope_subgroup_id = builder->GetUintConstantId(SpvScopeSubgroup);
+  // Find this invocation's rank among the active invocations of the
+  // subgroup, and how many of them there are.
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  const analysis::Constant* true_const = const_mgr->GetConstant(
+      context()->get_type_mgr()->GetType(GetBoolId()), {1u});
+  uint32_t true_id = const_mgr->GetDefiningInstruction(true_const)->result_id();
+  Instruction* ballot_inst =
+      builder->AddBinaryOp(GetVec4UintId(), SpvOpGroupNonUniformBallot,
+                           scope_subgroup_id, true_id);
+  auto gen_bit_count = [this, builder, scope_subgroup_id, ballot_inst](
+                           SpvGroupOperation group_op) {
+    std::unique_ptr<Instruction> count_inst(new Instruction(
+        context(), SpvOpGroupNonUniformBallotBitCount, GetUintId(),
+        TakeNextId(),
+        {{SPV_OPERAND_TYPE_ID, {scope_subgroup_id}},
+         {SPV_OPERAND_TYPE_GROUP_OPERATION, {uint32_t(group_op)}},
+         {SPV_OPERAND_TYPE_ID, {ballot_inst->result_id()}}}));
+    return builder->AddInstruction(std::move(count_inst))->result_id();
+  };
+  uint32_t rank_id = gen_bit_count(SpvGroupOperationExclusiveScan);
+  uint32_t count_id = gen_bit_count(SpvGroupOperationReduce);
+  Instruction* total_sz_inst =
+      builder->AddBinaryOp(GetUintId(), SpvOpIMul, count_id,
+                           builder->GetUintConstantId(obuf_record_sz));
+  // Let one invocation reserve space for the records of all of them.
+  Instruction* elect_inst = builder->AddUnaryOp(
+      GetBoolId(), SpvOpGroupNonUniformElect, scope_subgroup_id);
+  uint32_t test_blk_id = (*new_blk_ptr)->id();
+  uint32_t reserve_blk_id = TakeNextId();
+  uint32_t join_blk_id = TakeNextId();
+  std::unique_ptr<Instruction> reserve_label(NewLabel(reserve_blk_id));
+  std::unique_ptr<Instruction> join_label(NewLabel(join_blk_id));
+  (void)builder->AddConditionalBranch(elect_inst->result_id(), reserve_blk_id,
+                                      join_blk_id, join_blk_id,
+                                      SpvSelectionControlMaskNone);
+  (*new_blk_ptr)->SetParent(output_func);
+  output_func->AddBasicBlock(std::move(*new_blk_ptr));
+  *new_blk_ptr = MakeUnique<BasicBlock>(std::move(reserve_label));
+  builder->SetInsertPoint(&**new_blk_ptr);
+  uint32_t mask_none_id = builder->GetUintConstantId(SpvMemoryAccessMaskNone);
+  uint32_t scope_invok_id = builder->GetUintConstantId(SpvScopeInvocation);
+  Instruction* base_sz_inst = builder->AddQuadOp(
+      GetUintId(), SpvOpAtomicIAdd, obuf_curr_sz_ac_id, scope_invok_id,
+      mask_none_id, total_sz_inst->result_id());
+  (void)builder->AddBranch(join_blk_id);
+  (*new_blk_ptr)->SetParent(output_func);
+  output_func->AddBasicBlock(std::move(*new_blk_ptr));
+  // Share the reserved space, ordering records by rank.
+  *new_blk_ptr = MakeUnique<BasicBlock>(std::move(join_label));
+  builder->SetInsertPoint(&**new_blk_ptr);
+  Instruction* phi_inst = builder->AddPhi(
+      GetUintId(), {base_sz_inst->result_id(), reserve_blk_id,
+                    builder->GetUintConstantId(0u), test_blk_id});
+  Instruction* first_sz_inst =
+      builder->AddBinaryOp(GetUintId(), SpvOpGroupNonUniformBroadcastFirst,
+                           scope_subgroup_id, phi_inst->result_id());
+  Instruction* rank_sz_inst =
+      builder->AddBinaryOp(GetUintId(), SpvOpIMul, rank_id,
+                           builder->GetUintConstantId(obuf_record_sz));
+  Instruction* curr_sz_inst =
+      builder->AddBinaryOp(GetUintId(), SpvOpIAdd, first_sz_inst->result_id(),
+                           rank_sz_inst->result_id());
+  return curr_sz_inst->result_id();
+}
+
+bool InstrumentPass::SampleSite() {
+  if (sample_period_ <= 1) return true;
+  return sample_site_cnt_++ % sample_period_ == 0;
+}
+
+uint32_t InstrumentPass::GenSampleGateCode(uint32_t check_id,
+                                           InstructionBuilder* builder) {
+  if (sample_spec_id_ < 0) return check_id;
+  if (sample_gate_id_ == 0) {
+    uint32_t bool_id = GetBoolId();
+    sample_gate_id_ = TakeNextId();
+    std::unique_ptr<Instruction> gate_inst(new Instruction(
+        context(), SpvOpSpecConstantTrue, bool_id, sample_gate_id_, {}));
+    context()->AddGlobalValue(std::move(gate_inst));
+    get_decoration_mgr()->AddDecorationVal(
+        sample_gate_id_, SpvDecorationSpecId,
+        static_cast<uint32_t>(sample_spec_id_));
+  }
+  // A check passes whenever the gate is off.
+  Instruction* skip_inst =
+      builder->AddUnaryOp(GetBoolId(), SpvOpLogicalNot, sample_gate_id_);
+  Instruction* gated_inst = builder->AddBinaryOp(
+      GetBoolId(), SpvOpLogicalOr, check_id, skip_inst->result_id());
+  return gated_inst->result_id();
+}
+
 uint32_t InstrumentPass::GetDirectReadFunctionId(uint32_t param_cnt) {
   uint32_t func_id = param2input_func_id_[param_cnt];
   if (func_id != 0) return func_id;
@@ -939,7 +1048,10 @@ bool InstrumentPass::InstProcessCallTreeFromRoots(InstProcessFunction& pfn,
       Function* fn = id2function_.at(fi);
       // Add calls first so we don't add new output function
       context()->AddCalls(fn, roots);
-      modified = InstrumentFunction(fn, stage_idx, pfn) || modified;
+      if (InstrumentFunction(fn, stage_idx, pfn)) {
+        modified = true;
+        context()->AnalyzeCalls(fn);
+      }
     }
   }
   return modified;
@@ -1013,6 +1125,8 @@ void InstrumentPass::InitializeInstrument() {
   void_id_ = 0;
   storage_buffer_ext_defined_ = false;
   uint32_rarr_ty_ = nullptr;
+  sample_site_cnt_ = 0;
+  sample_gate_id_ = 0;
   uint64_rarr_ty_ = nullptr;
 
   // clear collections
@@ -1077,7 +1191,7 @@ void InstrumentPass::InitializeInstrument() {
   }
   for (auto& i : module->types_values()) {
     module_offset += 1;
-    module_offset += static_cast<uint32_t>(i.dbg_line_insts().size());
+    module_offset += static_cast<uint32_t>(i.dbg_lines().size());
   }
 
   auto curr_fn = get_module()->begin();
@@ -1090,7 +1204,7 @@ void InstrumentPass::InitializeInstrument() {
       // Count label
       module_offset += 1;
       for (auto& inst : blk) {
-        module_offset += static_cast<uint32_t>(inst.dbg_line_insts().size());
+        module_offset += static_cast<uint32_t>(inst.dbg_lines().size());
         uid2offset_[inst.unique_id()] = module_offset;
         module_offset += 1;
       }
@@ -62,6 +62,7 @@ namespace opt {
 static const uint32_t kInstValidationIdBindless = 0;
 static const uint32_t kInstValidationIdBuffAddr = 1;
 static const uint32_t kInstValidationIdDebugPrintf = 2;
+static const uint32_t kInstValidationIdBlockProfile = 3;
 
 class InstrumentPass : public Pass {
   using cbb_ptr = const BasicBlock*;
@@ -79,22 +80,49 @@ class InstrumentPass : public Pass {
            IRContext::kAnalysisBuiltinVarId | IRContext::kAnalysisConstants;
   }
 
+  // The instrumentation depends on the arguments of the pass.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
  protected:
   // Create instrumentation pass for |validation_id| which utilizes descriptor
   // set |desc_set| for debug input and output buffers and writes |shader_id|
   // into debug output records. |opt_direct_reads| indicates that the pass
   // will see direct input buffer reads and should prepare to optimize them.
+  // |subgroup_stream_writes| indicates that space for output records should
+  // be reserved once per subgroup rather than once per invocation.
   InstrumentPass(uint32_t desc_set, uint32_t shader_id, uint32_t validation_id,
-                 bool opt_direct_reads = false)
+                 bool opt_direct_reads = false,
+                 bool subgroup_stream_writes = false)
       : Pass(),
         desc_set_(desc_set),
         shader_id_(shader_id),
         validation_id_(validation_id),
-        opt_direct_reads_(opt_direct_reads) {}
+        opt_direct_reads_(opt_direct_reads),
+        subgroup_stream_writes_(subgroup_stream_writes),
+        sample_period_(1),
+        sample_spec_id_(-1) {}
+
+  // Only instrument every |sample_period|th eligible site. If
+  // |sample_spec_id| is not negative, also gate every instrumented check on a
+  // boolean specialization constant with that SpecId, true by default. When
+  // it is specialized to false, checks always pass and can be folded away.
+  void SetSampling(uint32_t sample_period, int32_t sample_spec_id) {
+    sample_period_ = sample_period;
+    sample_spec_id_ = sample_spec_id;
+  }
 
   // Initialize state for instrumentation of module.
   void InitializeInstrument();
 
+  // Return true if the next eligible site should be instrumented according to
+  // the sampling period.
+  bool SampleSite();
+
+  // Return the id of |check_id| gated by the sampling specialization constant,
+  // generating code into |builder| if needed. If no gate is enabled, return
+  // |check_id|.
+  uint32_t GenSampleGateCode(uint32_t check_id, InstructionBuilder* builder);
+
   // Call |pfn| on all instructions in all functions in the call tree of the
   // entry points in |module|. If code is generated for an instruction, replace
   // the instruction's block with the new blocks that are generated. Continue
@@ -286,6 +314,18 @@ class InstrumentPass : public Pass {
   uint32_t GetStreamWriteFunctionId(uint32_t stage_idx,
                                     uint32_t val_spec_param_cnt);
 
+  // Generate code into |builder|, whose block is |*new_blk_ptr|, to reserve
+  // |obuf_record_sz| words of the debug output buffer for each active
+  // invocation of the subgroup, using a single atomic add on the buffer size
+  // at |obuf_curr_sz_ac_id| per subgroup. Completed blocks are added to
+  // |output_func| and |*new_blk_ptr| and |builder| are left at a new block.
+  // Return the id of the offset of this invocation's record.
+  uint32_t GenSubgroupReserveCode(uint32_t obuf_record_sz,
+                                  uint32_t obuf_curr_sz_ac_id,
+                                  Function* output_func,
+                                  std::unique_ptr<BasicBlock>* new_blk_ptr,
+                                  InstructionBuilder* builder);
+
   // Return id for input function taking |param_cnt| uint32 parameters. Define
   // if it doesn't exist.
   uint32_t GetDirectReadFunctionId(uint32_t param_cnt);
@@ -463,6 +503,23 @@ class InstrumentPass : public Pass {
   // Optimize direct debug input buffer reads. Specifically, move all such
   // reads with constant args to first block and reuse them.
   bool opt_direct_reads_;
+
+  // Reserve debug output buffer space for all records of a subgroup with a
+  // single atomic operation, using subgroup ballots. Only done if the module
+  // is SPIR-V 1.3 or later.
+  bool subgroup_stream_writes_;
+
+  // Instrument one in this many eligible sites.
+  uint32_t sample_period_;
+
+  // SpecId of the constant gating instrumented checks, or -1 for no gate.
+  int32_t sample_spec_id_;
+
+  // Number of eligible sites seen so far.
+  uint32_t sample_site_cnt_;
+
+  // id of the specialization constant gating instrumented checks
+  uint32_t sample_gate_id_;
 };
 
 }  // namespace opt
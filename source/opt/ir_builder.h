@@ -552,6 +552,7 @@ class InstructionBuilder {
     Instruction* insn_ptr = &*insert_before_.InsertBefore(std::move(insn));
     UpdateInstrToBlockMapping(insn_ptr);
     UpdateDefUseMgr(insn_ptr);
+    UpdateCallGraph(insn_ptr);
     return insn_ptr;
   }
 
@@ -616,6 +617,18 @@ class InstructionBuilder {
       GetContext()->set_instr_block(insn, parent_);
   }
 
+  // Tells the context that the calls of the function |insn| was added to have
+  // changed, if |insn| is a function call.  The call graph is always kept up
+  // to date, because it is cheap to do so.
+  inline void UpdateCallGraph(Instruction* insn) {
+    if (insn->opcode() != SpvOpFunctionCall) return;
+    if (parent_ && parent_->GetParent()) {
+      GetContext()->AnalyzeCalls(parent_->GetParent());
+    } else {
+      GetContext()->InvalidateAnalyses(IRContext::kAnalysisCallGraph);
+    }
+  }
+
   IRContext* context_;
   BasicBlock* parent_;
   InsertionPointTy insert_before_;
@@ -14,13 +14,17 @@
 
 #include "source/opt/ir_context.h"
 
+#include <atomic>
 #include <cstring>
+#include <initializer_list>
 
 #include "OpenCLDebugInfo100.h"
 #include "source/latest_version_glsl_std_450_header.h"
 #include "source/opt/log.h"
 #include "source/opt/mem_pass.h"
 #include "source/opt/reflect.h"
+#include "source/util/memory_usage.h"
+#include "source/util/parallel.h"
 
 namespace {
 
@@ -88,6 +92,130 @@ void IRContext::BuildInvalidAnalyses(IRContext::Analysis set) {
   if (set & kAnalysisDebugInfo) {
     BuildDebugInfoManager();
   }
+  if (set & kAnalysisMemorySSA) {
+    ResetMemorySSA();
+  }
+  if (set & kAnalysisValueRange) {
+    ResetValueRangeAnalysis();
+  }
+  if (set & kAnalysisReflection) {
+    BuildReflectionAnalysis();
+  }
+  if (set & kAnalysisCallGraph) {
+    BuildCallGraph();
+  }
+}
+
+const char* IRContext::GetAnalysisName(IRContext::Analysis analysis) {
+  switch (analysis) {
+    case kAnalysisDefUse:
+      return "def-use";
+    case kAnalysisInstrToBlockMapping:
+      return "instr-to-block";
+    case kAnalysisDecorations:
+      return "decorations";
+    case kAnalysisCombinators:
+      return "combinators";
+    case kAnalysisCFG:
+      return "cfg";
+    case kAnalysisDominatorAnalysis:
+      return "dominators";
+    case kAnalysisLoopAnalysis:
+      return "loops";
+    case kAnalysisNameMap:
+      return "names";
+    case kAnalysisScalarEvolution:
+      return "scalar-evolution";
+    case kAnalysisRegisterPressure:
+      return "register-pressure";
+    case kAnalysisValueNumberTable:
+      return "value-numbers";
+    case kAnalysisStructuredCFG:
+      return "structured-cfg";
+    case kAnalysisBuiltinVarId:
+      return "builtin-var-ids";
+    case kAnalysisIdToFuncMapping:
+      return "id-to-function";
+    case kAnalysisConstants:
+      return "constants";
+    case kAnalysisTypes:
+      return "types";
+    case kAnalysisDebugInfo:
+      return "debug-info";
+    case kAnalysisMemorySSA:
+      return "memory-ssa";
+    case kAnalysisValueRange:
+      return "value-ranges";
+    case kAnalysisReflection:
+      return "reflection";
+    case kAnalysisCallGraph:
+      return "call-graph";
+    default:
+      return "unknown";
+  }
+}
+
+size_t IRContext::MemoryStats::Total() const {
+  size_t total = module;
+  for (const auto& analysis : analyses) total += analysis.second;
+  return total;
+}
+
+IRContext::MemoryStats IRContext::GetMemoryStats() const {
+  MemoryStats stats;
+  stats.module = module_->MemoryUsage();
+  auto add = [&stats](Analysis analysis, size_t bytes) {
+    stats.analyses.emplace_back(analysis, bytes);
+  };
+  if (AreAnalysesValid(kAnalysisDefUse) && def_use_mgr_) {
+    add(kAnalysisDefUse, def_use_mgr_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
+    add(kAnalysisInstrToBlockMapping, utils::MemoryUsage(instr_to_block_));
+  }
+  if (AreAnalysesValid(kAnalysisDecorations) && decoration_mgr_) {
+    add(kAnalysisDecorations, decoration_mgr_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisCFG) && cfg_) {
+    add(kAnalysisCFG, cfg_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisDominatorAnalysis)) {
+    size_t bytes = utils::MemoryUsage(dominator_trees_) +
+                   utils::MemoryUsage(post_dominator_trees_);
+    for (const auto& tree : dominator_trees_) {
+      bytes += tree.second.GetDomTree().MemoryUsage();
+    }
+    for (const auto& tree : post_dominator_trees_) {
+      bytes += tree.second.GetDomTree().MemoryUsage();
+    }
+    add(kAnalysisDominatorAnalysis, bytes);
+  }
+  if (AreAnalysesValid(kAnalysisNameMap) && id_to_name_) {
+    add(kAnalysisNameMap, utils::MemoryUsage(*id_to_name_));
+  }
+  if (AreAnalysesValid(kAnalysisScalarEvolution) &&
+      scalar_evolution_analysis_) {
+    add(kAnalysisScalarEvolution, scalar_evolution_analysis_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisIdToFuncMapping)) {
+    add(kAnalysisIdToFuncMapping, utils::MemoryUsage(id_to_func_));
+  }
+  if (AreAnalysesValid(kAnalysisConstants) && constant_mgr_) {
+    add(kAnalysisConstants, constant_mgr_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisTypes) && type_mgr_) {
+    add(kAnalysisTypes, type_mgr_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisDebugInfo) && debug_info_mgr_) {
+    add(kAnalysisDebugInfo, debug_info_mgr_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisReflection) && reflection_analysis_) {
+    add(kAnalysisReflection, reflection_analysis_->MemoryUsage());
+  }
+  if (AreAnalysesValid(kAnalysisCallGraph) && call_graph_) {
+    add(kAnalysisCallGraph, call_graph_->MemoryUsage());
+  }
+  return stats;
 }
 
 void IRContext::InvalidateAnalysesExceptFor(
@@ -112,7 +240,27 @@ void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate) {
     analyses_to_invalidate |= kAnalysisDominatorAnalysis;
   }
 
+  // The memory SSA form is built over the dominator tree.
+  if (analyses_to_invalidate & kAnalysisDominatorAnalysis) {
+    analyses_to_invalidate |= kAnalysisMemorySSA;
+  }
+
+  // The scalar evolution analysis refers to the loops of the loop descriptors.
+  if (analyses_to_invalidate & kAnalysisLoopAnalysis) {
+    analyses_to_invalidate |= kAnalysisScalarEvolution;
+  }
+
+  // Value ranges are derived from the definitions of values, and from the
+  // loops and dominators bounding induction variables.
+  if (analyses_to_invalidate &
+      (kAnalysisDefUse | kAnalysisDominatorAnalysis | kAnalysisLoopAnalysis)) {
+    analyses_to_invalidate |= kAnalysisValueRange;
+  }
+
   if (analyses_to_invalidate & kAnalysisDefUse) {
+    if (def_use_mgr_) {
+      work_counts_.def_use_updates += def_use_mgr_->num_updates();
+    }
     def_use_mgr_.reset(nullptr);
   }
   if (analyses_to_invalidate & kAnalysisInstrToBlockMapping) {
@@ -122,13 +270,15 @@ void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate) {
     decoration_mgr_.reset(nullptr);
   }
   if (analyses_to_invalidate & kAnalysisCombinators) {
-    combinator_ops_.clear();
+    combinator_ops_ = utils::BitVector();
+    ext_combinator_ops_.clear();
   }
   if (analyses_to_invalidate & kAnalysisBuiltinVarId) {
     builtin_var_id_map_.clear();
   }
   if (analyses_to_invalidate & kAnalysisCFG) {
     cfg_.reset(nullptr);
+    functions_with_stale_cfg_.clear();
   }
   if (analyses_to_invalidate & kAnalysisDominatorAnalysis) {
     dominator_trees_.clear();
@@ -156,10 +306,73 @@ void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate) {
   if (analyses_to_invalidate & kAnalysisDebugInfo) {
     debug_info_mgr_.reset(nullptr);
   }
+  if (analyses_to_invalidate & kAnalysisMemorySSA) {
+    memory_ssa_.clear();
+  }
+  if (analyses_to_invalidate & kAnalysisValueRange) {
+    value_ranges_.clear();
+  }
+  if (analyses_to_invalidate & kAnalysisReflection) {
+    reflection_analysis_.reset(nullptr);
+  }
+  if (analyses_to_invalidate & kAnalysisCallGraph) {
+    call_graph_.reset(nullptr);
+  }
 
   valid_analyses_ = Analysis(valid_analyses_ & ~analyses_to_invalidate);
 }
 
+void IRContext::InvalidateAnalyses(IRContext::Analysis analyses_to_invalidate,
+                                   const Function* f) {
+  const Analysis kPerFunctionAnalyses =
+      kAnalysisCFG | kAnalysisDominatorAnalysis | kAnalysisLoopAnalysis |
+      kAnalysisMemorySSA | kAnalysisValueRange;
+  Analysis module_analyses =
+      Analysis(analyses_to_invalidate & ~kPerFunctionAnalyses);
+  // The scalar evolution analysis may refer to the loops of |f|.
+  if (analyses_to_invalidate & kAnalysisLoopAnalysis) {
+    module_analyses |= kAnalysisScalarEvolution;
+  }
+  if (module_analyses != kAnalysisNone) {
+    InvalidateAnalyses(module_analyses);
+  }
+
+  // As for the whole module, the dominator analysis of |f| depends on its CFG.
+  if (analyses_to_invalidate & kAnalysisCFG) {
+    analyses_to_invalidate |= kAnalysisDominatorAnalysis;
+    if (AreAnalysesValid(kAnalysisCFG)) {
+      functions_with_stale_cfg_.insert(f);
+    }
+  }
+  if (analyses_to_invalidate & kAnalysisDominatorAnalysis) {
+    analyses_to_invalidate |= kAnalysisMemorySSA | kAnalysisValueRange;
+    dominator_trees_.erase(f);
+    post_dominator_trees_.erase(f);
+  }
+  if (analyses_to_invalidate & kAnalysisLoopAnalysis) {
+    analyses_to_invalidate |= kAnalysisValueRange;
+    loop_descriptors_.erase(f);
+  }
+  if (analyses_to_invalidate & kAnalysisMemorySSA) {
+    memory_ssa_.erase(f);
+  }
+  if (analyses_to_invalidate & kAnalysisValueRange) {
+    value_ranges_.erase(f);
+  }
+}
+
+void IRContext::UpdateStaleCFG() {
+  // Functions that have been removed from the module since they were
+  // invalidated are skipped, since this only looks at the functions that are
+  // still in the module.
+  for (auto& fn : *module()) {
+    if (functions_with_stale_cfg_.count(&fn)) {
+      cfg_->RebuildFunction(&fn);
+    }
+  }
+  functions_with_stale_cfg_.clear();
+}
+
 Instruction* IRContext::KillInst(Instruction* inst) {
   if (!inst) {
     return nullptr;
@@ -169,11 +382,74 @@ Instruction* IRContext::KillInst(Instruction* inst) {
 
   KillOperandFromDebugInstructions(inst);
 
+  return KillInstWithoutReferences(inst);
+}
+
+void IRContext::KillInsts(utils::Span<Instruction* const> insts) {
+  // Names and annotations are killed first, so that the sweeps below do not
+  // find the ones in |insts| again.
+  std::vector<Instruction*> others;
+  others.reserve(insts.size());
+  std::unordered_set<uint32_t> dead_ids;
+  std::unordered_set<uint32_t> dead_functions;
+  std::unordered_set<uint32_t> dead_globals;
+  for (Instruction* inst : insts) {
+    const SpvOp opcode = inst->opcode();
+    if (IsDebug2Inst(opcode) || IsAnnotationInst(opcode)) {
+      KillInst(inst);
+      continue;
+    }
+    others.push_back(inst);
+    const uint32_t id = inst->result_id();
+    if (id == 0) continue;
+    dead_ids.insert(id);
+    if (opcode == SpvOpFunction) {
+      dead_functions.insert(id);
+    } else if (opcode == SpvOpVariable || IsConstantInst(opcode)) {
+      dead_globals.insert(id);
+    }
+  }
+
+  if (!dead_ids.empty()) {
+    std::vector<Instruction*> dead_names;
+    for (auto& name : module()->debugs2()) {
+      if (dead_ids.count(name.GetSingleWordInOperand(0))) {
+        dead_names.push_back(&name);
+      }
+    }
+    for (Instruction* name : dead_names) KillInst(name);
+
+    // Without a decoration manager, look for the dead ids that are decorated
+    // first, so that one is only built if it has something to remove.
+    std::unordered_set<uint32_t> decorated_ids;
+    if (AreAnalysesValid(kAnalysisDecorations)) {
+      decorated_ids = dead_ids;
+    } else {
+      for (const auto& annotation : module()->annotations()) {
+        annotation.ForEachInId([&dead_ids, &decorated_ids](const uint32_t* id) {
+          if (dead_ids.count(*id)) decorated_ids.insert(*id);
+        });
+      }
+    }
+    if (!decorated_ids.empty()) {
+      analysis::DecorationManager* dec_mgr = get_decoration_mgr();
+      for (uint32_t id : decorated_ids) dec_mgr->RemoveDecorationsFrom(id);
+    }
+  }
+
+  if (!dead_functions.empty() || !dead_globals.empty()) {
+    KillOperandsFromDebugInstructions(dead_functions, dead_globals);
+  }
+
+  for (Instruction* inst : others) KillInstWithoutReferences(inst);
+}
+
+Instruction* IRContext::KillInstWithoutReferences(Instruction* inst) {
   if (AreAnalysesValid(kAnalysisDefUse)) {
     get_def_use_mgr()->ClearInst(inst);
   }
   if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
-    instr_to_block_.erase(inst);
+    instr_to_block_.erase(inst->unique_id());
   }
   if (AreAnalysesValid(kAnalysisDecorations)) {
     if (inst->IsDecoration()) {
@@ -184,6 +460,42 @@ Instruction* IRContext::KillInst(Instruction* inst) {
     get_debug_info_mgr()->ClearDebugScopeAndInlinedAtUses(inst);
     get_debug_info_mgr()->ClearDebugInfo(inst);
   }
+  if (AreAnalysesValid(kAnalysisValueNumberTable)) {
+    vn_table_->RemoveInstruction(inst);
+  }
+  if (AreAnalysesValid(kAnalysisMemorySSA)) {
+    // The memory SSA forms are not updated, so the ones with an access for
+    // |inst| are dropped and rebuilt on demand.
+    for (auto it = memory_ssa_.begin(); it != memory_ssa_.end();) {
+      if (it->second->HasAccesses(inst)) {
+        it = memory_ssa_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (AreAnalysesValid(kAnalysisValueRange) && inst->result_id() != 0) {
+    // Ranges computed from |inst| are dropped with it and rebuilt on demand.
+    for (auto it = value_ranges_.begin(); it != value_ranges_.end();) {
+      if (it->second->HasRange(inst)) {
+        it = value_ranges_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  InvalidateReflectionFor(*inst);
+  if (AreAnalysesValid(kAnalysisStructuredCFG) &&
+      inst->opcode() == SpvOpLabel) {
+    struct_cfg_analysis_->RemoveBlock(inst->result_id());
+  }
+  if (AreAnalysesValid(kAnalysisCallGraph)) {
+    if (inst->opcode() == SpvOpFunctionCall) {
+      call_graph_->RemoveCall(inst);
+    } else if (inst->opcode() == SpvOpFunction) {
+      call_graph_->RemoveFunction(inst->result_id());
+    }
+  }
   if (type_mgr_ && IsTypeInst(inst->opcode())) {
     type_mgr_->RemoveId(inst->result_id());
   }
@@ -274,11 +586,15 @@ bool IRContext::ReplaceAllUsesWithPredicate(
         }
       });
 
+  // The uses of an instruction are visited consecutively, so each user is
+  // forgotten before its first use is updated, and analyzed again after its
+  // last one.
   Instruction* prev = nullptr;
   for (auto p : uses_to_update) {
     Instruction* user = p.first;
     uint32_t index = p.second;
-    if (prev == nullptr || prev != user) {
+    if (prev != user) {
+      if (prev != nullptr) AnalyzeUses(prev);
       ForgetUses(user);
       prev = user;
     }
@@ -305,11 +621,61 @@ bool IRContext::ReplaceAllUsesWithPredicate(
       // Make the modification in the instruction.
       user->SetInOperand(in_operand_pos, {after});
     }
-    AnalyzeUses(user);
   }
+  if (prev != nullptr) AnalyzeUses(prev);
   return true;
 }
 
+bool IRContext::ReplaceAllUsesWith(
+    const std::unordered_map<uint32_t, uint32_t>& replacements) {
+  std::vector<Instruction*> users;
+  std::unordered_set<Instruction*> seen_users;
+  bool changed = false;
+  for (const auto& replacement : replacements) {
+    const uint32_t before = replacement.first;
+    const uint32_t after = replacement.second;
+    if (before == after) continue;
+    changed = true;
+
+    if (AreAnalysesValid(kAnalysisDebugInfo)) {
+      get_debug_info_mgr()->ReplaceAllUsesInDebugScopeWithPredicate(
+          before, after, [](Instruction*) { return true; });
+    }
+
+    // Ensure that |after| has been registered as def.
+    assert(get_def_use_mgr()->GetDef(after) &&
+           "'after' is not a registered def.");
+    assert(replacements.count(after) == 0 &&
+           "'after' is replaced by another id.");
+
+    get_def_use_mgr()->ForEachUser(
+        before, [&users, &seen_users](Instruction* user) {
+          if (seen_users.insert(user).second) users.push_back(user);
+        });
+  }
+
+  for (Instruction* user : users) {
+    ForgetUses(user);
+    // Rewrites the same operands that the def-use manager records as uses.
+    for (uint32_t i = 0; i < user->NumOperands(); ++i) {
+      Operand& operand = user->GetOperand(i);
+      switch (operand.type) {
+        case SPV_OPERAND_TYPE_ID:
+        case SPV_OPERAND_TYPE_TYPE_ID:
+        case SPV_OPERAND_TYPE_MEMORY_SEMANTICS_ID:
+        case SPV_OPERAND_TYPE_SCOPE_ID: {
+          auto it = replacements.find(operand.words[0]);
+          if (it != replacements.end()) operand.words[0] = it->second;
+        } break;
+        default:
+          break;
+      }
+    }
+    AnalyzeUses(user);
+  }
+  return changed;
+}
+
 bool IRContext::IsConsistent() {
 #ifndef SPIRV_CHECK_CONTEXT
   return true;
@@ -356,6 +722,24 @@ bool IRContext::IsConsistent() {
     }
   }
 
+  if (AreAnalysesValid(kAnalysisReflection)) {
+    ReflectionAnalysis current(this);
+    if (current.reflection() != reflection_analysis_->reflection()) {
+      return false;
+    }
+  }
+
+  if (AreAnalysesValid(kAnalysisCallGraph)) {
+    CallGraph current(this);
+    for (auto& fn : *module()) {
+      if (current.GetCallees(&fn) != call_graph_->GetCallees(&fn) ||
+          current.GetCallers(fn.result_id()) !=
+              call_graph_->GetCallers(fn.result_id())) {
+        return false;
+      }
+    }
+  }
+
   if (feature_mgr_ != nullptr) {
     FeatureManager current(grammar_);
     current.Analyze(module());
@@ -399,6 +783,35 @@ void IRContext::AnalyzeUses(Instruction* inst) {
       (inst->opcode() == SpvOpName || inst->opcode() == SpvOpMemberName)) {
     id_to_name_->insert({inst->GetSingleWordInOperand(0), inst});
   }
+  if (inst->opcode() == SpvOpFunctionCall) {
+    UpdateCallGraphFor(inst, nullptr);
+  }
+}
+
+void IRContext::AnalyzeCalls(const Function* fn) {
+  if (AreAnalysesValid(kAnalysisCallGraph)) {
+    call_graph_->MarkModified(fn);
+  }
+}
+
+void IRContext::UpdateCallGraphFor(Instruction* inst, BasicBlock* block) {
+  if (!AreAnalysesValid(kAnalysisCallGraph)) return;
+
+  // The call may be leaving the function it was in, and entering another one.
+  Function* old_caller = call_graph_->GetCaller(inst);
+  if (old_caller != nullptr) {
+    call_graph_->MarkModified(old_caller);
+  }
+  if (block == nullptr && AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
+    block = get_instr_block(inst);
+  }
+  Function* new_caller = block != nullptr ? block->GetParent() : nullptr;
+  if (new_caller != nullptr) {
+    call_graph_->MarkModified(new_caller);
+  } else if (old_caller == nullptr) {
+    // There is no way to know which function the call is in.
+    InvalidateAnalyses(kAnalysisCallGraph);
+  }
 }
 
 void IRContext::KillNamesAndDecorates(uint32_t id) {
@@ -454,169 +867,198 @@ void IRContext::KillOperandFromDebugInstructions(Instruction* inst) {
   }
 }
 
+void IRContext::KillOperandsFromDebugInstructions(
+    const std::unordered_set<uint32_t>& functions,
+    const std::unordered_set<uint32_t>& globals) {
+  for (auto it = module()->ext_inst_debuginfo_begin();
+       it != module()->ext_inst_debuginfo_end(); ++it) {
+    uint32_t operand_index = 0;
+    const std::unordered_set<uint32_t>* dead = nullptr;
+    switch (it->GetOpenCL100DebugOpcode()) {
+      case OpenCLDebugInfo100DebugFunction:
+        operand_index = kDebugFunctionOperandFunctionIndex;
+        dead = &functions;
+        break;
+      case OpenCLDebugInfo100DebugGlobalVariable:
+        operand_index = kDebugGlobalVariableOperandVariableIndex;
+        dead = &globals;
+        break;
+      default:
+        continue;
+    }
+    auto& operand = it->GetOperand(operand_index);
+    if (dead->count(operand.words[0])) {
+      operand.words[0] = get_debug_info_mgr()->GetDebugInfoNone()->result_id();
+      get_def_use_mgr()->AnalyzeInstUse(&*it);
+    }
+  }
+}
+
 void IRContext::AddCombinatorsForCapability(uint32_t capability) {
   if (capability == SpvCapabilityShader) {
-    combinator_ops_[0].insert({SpvOpNop,
-                               SpvOpUndef,
-                               SpvOpConstant,
-                               SpvOpConstantTrue,
-                               SpvOpConstantFalse,
-                               SpvOpConstantComposite,
-                               SpvOpConstantSampler,
-                               SpvOpConstantNull,
-                               SpvOpTypeVoid,
-                               SpvOpTypeBool,
-                               SpvOpTypeInt,
-                               SpvOpTypeFloat,
-                               SpvOpTypeVector,
-                               SpvOpTypeMatrix,
-                               SpvOpTypeImage,
-                               SpvOpTypeSampler,
-                               SpvOpTypeSampledImage,
-                               SpvOpTypeAccelerationStructureNV,
-                               SpvOpTypeAccelerationStructureKHR,
-                               SpvOpTypeRayQueryProvisionalKHR,
-                               SpvOpTypeArray,
-                               SpvOpTypeRuntimeArray,
-                               SpvOpTypeStruct,
-                               SpvOpTypeOpaque,
-                               SpvOpTypePointer,
-                               SpvOpTypeFunction,
-                               SpvOpTypeEvent,
-                               SpvOpTypeDeviceEvent,
-                               SpvOpTypeReserveId,
-                               SpvOpTypeQueue,
-                               SpvOpTypePipe,
-                               SpvOpTypeForwardPointer,
-                               SpvOpVariable,
-                               SpvOpImageTexelPointer,
-                               SpvOpLoad,
-                               SpvOpAccessChain,
-                               SpvOpInBoundsAccessChain,
-                               SpvOpArrayLength,
-                               SpvOpVectorExtractDynamic,
-                               SpvOpVectorInsertDynamic,
-                               SpvOpVectorShuffle,
-                               SpvOpCompositeConstruct,
-                               SpvOpCompositeExtract,
-                               SpvOpCompositeInsert,
-                               SpvOpCopyObject,
-                               SpvOpTranspose,
-                               SpvOpSampledImage,
-                               SpvOpImageSampleImplicitLod,
-                               SpvOpImageSampleExplicitLod,
-                               SpvOpImageSampleDrefImplicitLod,
-                               SpvOpImageSampleDrefExplicitLod,
-                               SpvOpImageSampleProjImplicitLod,
-                               SpvOpImageSampleProjExplicitLod,
-                               SpvOpImageSampleProjDrefImplicitLod,
-                               SpvOpImageSampleProjDrefExplicitLod,
-                               SpvOpImageFetch,
-                               SpvOpImageGather,
-                               SpvOpImageDrefGather,
-                               SpvOpImageRead,
-                               SpvOpImage,
-                               SpvOpImageQueryFormat,
-                               SpvOpImageQueryOrder,
-                               SpvOpImageQuerySizeLod,
-                               SpvOpImageQuerySize,
-                               SpvOpImageQueryLevels,
-                               SpvOpImageQuerySamples,
-                               SpvOpConvertFToU,
-                               SpvOpConvertFToS,
-                               SpvOpConvertSToF,
-                               SpvOpConvertUToF,
-                               SpvOpUConvert,
-                               SpvOpSConvert,
-                               SpvOpFConvert,
-                               SpvOpQuantizeToF16,
-                               SpvOpBitcast,
-                               SpvOpSNegate,
-                               SpvOpFNegate,
-                               SpvOpIAdd,
-                               SpvOpFAdd,
-                               SpvOpISub,
-                               SpvOpFSub,
-                               SpvOpIMul,
-                               SpvOpFMul,
-                               SpvOpUDiv,
-                               SpvOpSDiv,
-                               SpvOpFDiv,
-                               SpvOpUMod,
-                               SpvOpSRem,
-                               SpvOpSMod,
-                               SpvOpFRem,
-                               SpvOpFMod,
-                               SpvOpVectorTimesScalar,
-                               SpvOpMatrixTimesScalar,
-                               SpvOpVectorTimesMatrix,
-                               SpvOpMatrixTimesVector,
-                               SpvOpMatrixTimesMatrix,
-                               SpvOpOuterProduct,
-                               SpvOpDot,
-                               SpvOpIAddCarry,
-                               SpvOpISubBorrow,
-                               SpvOpUMulExtended,
-                               SpvOpSMulExtended,
-                               SpvOpAny,
-                               SpvOpAll,
-                               SpvOpIsNan,
-                               SpvOpIsInf,
-                               SpvOpLogicalEqual,
-                               SpvOpLogicalNotEqual,
-                               SpvOpLogicalOr,
-                               SpvOpLogicalAnd,
-                               SpvOpLogicalNot,
-                               SpvOpSelect,
-                               SpvOpIEqual,
-                               SpvOpINotEqual,
-                               SpvOpUGreaterThan,
-                               SpvOpSGreaterThan,
-                               SpvOpUGreaterThanEqual,
-                               SpvOpSGreaterThanEqual,
-                               SpvOpULessThan,
-                               SpvOpSLessThan,
-                               SpvOpULessThanEqual,
-                               SpvOpSLessThanEqual,
-                               SpvOpFOrdEqual,
-                               SpvOpFUnordEqual,
-                               SpvOpFOrdNotEqual,
-                               SpvOpFUnordNotEqual,
-                               SpvOpFOrdLessThan,
-                               SpvOpFUnordLessThan,
-                               SpvOpFOrdGreaterThan,
-                               SpvOpFUnordGreaterThan,
-                               SpvOpFOrdLessThanEqual,
-                               SpvOpFUnordLessThanEqual,
-                               SpvOpFOrdGreaterThanEqual,
-                               SpvOpFUnordGreaterThanEqual,
-                               SpvOpShiftRightLogical,
-                               SpvOpShiftRightArithmetic,
-                               SpvOpShiftLeftLogical,
-                               SpvOpBitwiseOr,
-                               SpvOpBitwiseXor,
-                               SpvOpBitwiseAnd,
-                               SpvOpNot,
-                               SpvOpBitFieldInsert,
-                               SpvOpBitFieldSExtract,
-                               SpvOpBitFieldUExtract,
-                               SpvOpBitReverse,
-                               SpvOpBitCount,
-                               SpvOpPhi,
-                               SpvOpImageSparseSampleImplicitLod,
-                               SpvOpImageSparseSampleExplicitLod,
-                               SpvOpImageSparseSampleDrefImplicitLod,
-                               SpvOpImageSparseSampleDrefExplicitLod,
-                               SpvOpImageSparseSampleProjImplicitLod,
-                               SpvOpImageSparseSampleProjExplicitLod,
-                               SpvOpImageSparseSampleProjDrefImplicitLod,
-                               SpvOpImageSparseSampleProjDrefExplicitLod,
-                               SpvOpImageSparseFetch,
-                               SpvOpImageSparseGather,
-                               SpvOpImageSparseDrefGather,
-                               SpvOpImageSparseTexelsResident,
-                               SpvOpImageSparseRead,
-                               SpvOpSizeOf});
+    for (SpvOp op : {SpvOpNop,
+                     SpvOpUndef,
+                     SpvOpConstant,
+                     SpvOpConstantTrue,
+                     SpvOpConstantFalse,
+                     SpvOpConstantComposite,
+                     SpvOpConstantSampler,
+                     SpvOpConstantNull,
+                     SpvOpTypeVoid,
+                     SpvOpTypeBool,
+                     SpvOpTypeInt,
+                     SpvOpTypeFloat,
+                     SpvOpTypeVector,
+                     SpvOpTypeMatrix,
+                     SpvOpTypeImage,
+                     SpvOpTypeSampler,
+                     SpvOpTypeSampledImage,
+                     SpvOpTypeAccelerationStructureNV,
+                     SpvOpTypeAccelerationStructureKHR,
+                     SpvOpTypeRayQueryProvisionalKHR,
+                     SpvOpTypeArray,
+                     SpvOpTypeRuntimeArray,
+                     SpvOpTypeStruct,
+                     SpvOpTypeOpaque,
+                     SpvOpTypePointer,
+                     SpvOpTypeFunction,
+                     SpvOpTypeEvent,
+                     SpvOpTypeDeviceEvent,
+                     SpvOpTypeReserveId,
+                     SpvOpTypeQueue,
+                     SpvOpTypePipe,
+                     SpvOpTypeForwardPointer,
+                     SpvOpVariable,
+                     SpvOpImageTexelPointer,
+                     SpvOpLoad,
+                     SpvOpAccessChain,
+                     SpvOpInBoundsAccessChain,
+                     SpvOpArrayLength,
+                     SpvOpVectorExtractDynamic,
+                     SpvOpVectorInsertDynamic,
+                     SpvOpVectorShuffle,
+                     SpvOpCompositeConstruct,
+                     SpvOpCompositeExtract,
+                     SpvOpCompositeInsert,
+                     SpvOpCopyObject,
+                     SpvOpTranspose,
+                     SpvOpSampledImage,
+                     SpvOpImageSampleImplicitLod,
+                     SpvOpImageSampleExplicitLod,
+                     SpvOpImageSampleDrefImplicitLod,
+                     SpvOpImageSampleDrefExplicitLod,
+                     SpvOpImageSampleProjImplicitLod,
+                     SpvOpImageSampleProjExplicitLod,
+                     SpvOpImageSampleProjDrefImplicitLod,
+                     SpvOpImageSampleProjDrefExplicitLod,
+                     SpvOpImageFetch,
+                     SpvOpImageGather,
+                     SpvOpImageDrefGather,
+                     SpvOpImageRead,
+                     SpvOpImage,
+                     SpvOpImageQueryFormat,
+                     SpvOpImageQueryOrder,
+                     SpvOpImageQuerySizeLod,
+                     SpvOpImageQuerySize,
+                     SpvOpImageQueryLevels,
+                     SpvOpImageQuerySamples,
+                     SpvOpConvertFToU,
+                     SpvOpConvertFToS,
+                     SpvOpConvertSToF,
+                     SpvOpConvertUToF,
+                     SpvOpUConvert,
+                     SpvOpSConvert,
+                     SpvOpFConvert,
+                     SpvOpQuantizeToF16,
+                     SpvOpBitcast,
+                     SpvOpSNegate,
+                     SpvOpFNegate,
+                     SpvOpIAdd,
+                     SpvOpFAdd,
+                     SpvOpISub,
+                     SpvOpFSub,
+                     SpvOpIMul,
+                     SpvOpFMul,
+                     SpvOpUDiv,
+                     SpvOpSDiv,
+                     SpvOpFDiv,
+                     SpvOpUMod,
+                     SpvOpSRem,
+                     SpvOpSMod,
+                     SpvOpFRem,
+                     SpvOpFMod,
+                     SpvOpVectorTimesScalar,
+                     SpvOpMatrixTimesScalar,
+                     SpvOpVectorTimesMatrix,
+                     SpvOpMatrixTimesVector,
+                     SpvOpMatrixTimesMatrix,
+                     SpvOpOuterProduct,
+                     SpvOpDot,
+                     SpvOpIAddCarry,
+                     SpvOpISubBorrow,
+                     SpvOpUMulExtended,
+                     SpvOpSMulExtended,
+                     SpvOpAny,
+                     SpvOpAll,
+                     SpvOpIsNan,
+                     SpvOpIsInf,
+                     SpvOpLogicalEqual,
+                     SpvOpLogicalNotEqual,
+                     SpvOpLogicalOr,
+                     SpvOpLogicalAnd,
+                     SpvOpLogicalNot,
+                     SpvOpSelect,
+                     SpvOpIEqual,
+                     SpvOpINotEqual,
+                     SpvOpUGreaterThan,
+                     SpvOpSGreaterThan,
+                     SpvOpUGreaterThanEqual,
+                     SpvOpSGreaterThanEqual,
+                     SpvOpULessThan,
+                     SpvOpSLessThan,
+                     SpvOpULessThanEqual,
+                     SpvOpSLessThanEqual,
+                     SpvOpFOrdEqual,
+                     SpvOpFUnordEqual,
+                     SpvOpFOrdNotEqual,
+                     SpvOpFUnordNotEqual,
+                     SpvOpFOrdLessThan,
+                     SpvOpFUnordLessThan,
+                     SpvOpFOrdGreaterThan,
+                     SpvOpFUnordGreaterThan,
+                     SpvOpFOrdLessThanEqual,
+                     SpvOpFUnordLessThanEqual,
+                     SpvOpFOrdGreaterThanEqual,
+                     SpvOpFUnordGreaterThanEqual,
+                     SpvOpShiftRightLogical,
+                     SpvOpShiftRightArithmetic,
+                     SpvOpShiftLeftLogical,
+                     SpvOpBitwiseOr,
+                     SpvOpBitwiseXor,
+                     SpvOpBitwiseAnd,
+                     SpvOpNot,
+                     SpvOpBitFieldInsert,
+                     SpvOpBitFieldSExtract,
+                     SpvOpBitFieldUExtract,
+                     SpvOpBitReverse,
+                     SpvOpBitCount,
+                     SpvOpPhi,
+                     SpvOpImageSparseSampleImplicitLod,
+                     SpvOpImageSparseSampleExplicitLod,
+                     SpvOpImageSparseSampleDrefImplicitLod,
+                     SpvOpImageSparseSampleDrefExplicitLod,
+                     SpvOpImageSparseSampleProjImplicitLod,
+                     SpvOpImageSparseSampleProjExplicitLod,
+                     SpvOpImageSparseSampleProjDrefImplicitLod,
+                     SpvOpImageSparseSampleProjDrefExplicitLod,
+                     SpvOpImageSparseFetch,
+                     SpvOpImageSparseGather,
+                     SpvOpImageSparseDrefGather,
+                     SpvOpImageSparseTexelsResident,
+                     SpvOpImageSparseRead,
+                     SpvOpSizeOf}) {
+      combinator_ops_.Set(op);
+    }
   }
 }
 
@@ -626,92 +1068,127 @@ void IRContext::AddCombinatorsForExtension(Instruction* extension) {
   const char* extension_name =
       reinterpret_cast<const char*>(&extension->GetInOperand(0).words[0]);
   if (!strcmp(extension_name, "GLSL.std.450")) {
-    combinator_ops_[extension->result_id()] = {GLSLstd450Round,
-                                               GLSLstd450RoundEven,
-                                               GLSLstd450Trunc,
-                                               GLSLstd450FAbs,
-                                               GLSLstd450SAbs,
-                                               GLSLstd450FSign,
-                                               GLSLstd450SSign,
-                                               GLSLstd450Floor,
-                                               GLSLstd450Ceil,
-                                               GLSLstd450Fract,
-                                               GLSLstd450Radians,
-                                               GLSLstd450Degrees,
-                                               GLSLstd450Sin,
-                                               GLSLstd450Cos,
-                                               GLSLstd450Tan,
-                                               GLSLstd450Asin,
-                                               GLSLstd450Acos,
-                                               GLSLstd450Atan,
-                                               GLSLstd450Sinh,
-                                               GLSLstd450Cosh,
-                                               GLSLstd450Tanh,
-                                               GLSLstd450Asinh,
-                                               GLSLstd450Acosh,
-                                               GLSLstd450Atanh,
-                                               GLSLstd450Atan2,
-                                               GLSLstd450Pow,
-                                               GLSLstd450Exp,
-                                               GLSLstd450Log,
-                                               GLSLstd450Exp2,
-                                               GLSLstd450Log2,
-                                               GLSLstd450Sqrt,
-                                               GLSLstd450InverseSqrt,
-                                               GLSLstd450Determinant,
-                                               GLSLstd450MatrixInverse,
-                                               GLSLstd450ModfStruct,
-                                               GLSLstd450FMin,
-                                               GLSLstd450UMin,
-                                               GLSLstd450SMin,
-                                               GLSLstd450FMax,
-                                               GLSLstd450UMax,
-                                               GLSLstd450SMax,
-                                               GLSLstd450FClamp,
-                                               GLSLstd450UClamp,
-                                               GLSLstd450SClamp,
-                                               GLSLstd450FMix,
-                                               GLSLstd450IMix,
-                                               GLSLstd450Step,
-                                               GLSLstd450SmoothStep,
-                                               GLSLstd450Fma,
-                                               GLSLstd450FrexpStruct,
-                                               GLSLstd450Ldexp,
-                                               GLSLstd450PackSnorm4x8,
-                                               GLSLstd450PackUnorm4x8,
-                                               GLSLstd450PackSnorm2x16,
-                                               GLSLstd450PackUnorm2x16,
-                                               GLSLstd450PackHalf2x16,
-                                               GLSLstd450PackDouble2x32,
-                                               GLSLstd450UnpackSnorm2x16,
-                                               GLSLstd450UnpackUnorm2x16,
-                                               GLSLstd450UnpackHalf2x16,
-                                               GLSLstd450UnpackSnorm4x8,
-                                               GLSLstd450UnpackUnorm4x8,
-                                               GLSLstd450UnpackDouble2x32,
-                                               GLSLstd450Length,
-                                               GLSLstd450Distance,
-                                               GLSLstd450Cross,
-                                               GLSLstd450Normalize,
-                                               GLSLstd450FaceForward,
-                                               GLSLstd450Reflect,
-                                               GLSLstd450Refract,
-                                               GLSLstd450FindILsb,
-                                               GLSLstd450FindSMsb,
-                                               GLSLstd450FindUMsb,
-                                               GLSLstd450InterpolateAtCentroid,
-                                               GLSLstd450InterpolateAtSample,
-                                               GLSLstd450InterpolateAtOffset,
-                                               GLSLstd450NMin,
-                                               GLSLstd450NMax,
-                                               GLSLstd450NClamp};
+    utils::BitVector& ops = ext_combinator_ops_[extension->result_id()];
+    for (uint32_t op : {GLSLstd450Round,
+                     GLSLstd450RoundEven,
+                     GLSLstd450Trunc,
+                     GLSLstd450FAbs,
+                     GLSLstd450SAbs,
+                     GLSLstd450FSign,
+                     GLSLstd450SSign,
+                     GLSLstd450Floor,
+                     GLSLstd450Ceil,
+                     GLSLstd450Fract,
+                     GLSLstd450Radians,
+                     GLSLstd450Degrees,
+                     GLSLstd450Sin,
+                     GLSLstd450Cos,
+                     GLSLstd450Tan,
+                     GLSLstd450Asin,
+                     GLSLstd450Acos,
+                     GLSLstd450Atan,
+                     GLSLstd450Sinh,
+                     GLSLstd450Cosh,
+                     GLSLstd450Tanh,
+                     GLSLstd450Asinh,
+                     GLSLstd450Acosh,
+                     GLSLstd450Atanh,
+                     GLSLstd450Atan2,
+                     GLSLstd450Pow,
+                     GLSLstd450Exp,
+                     GLSLstd450Log,
+                     GLSLstd450Exp2,
+                     GLSLstd450Log2,
+                     GLSLstd450Sqrt,
+                     GLSLstd450InverseSqrt,
+                     GLSLstd450Determinant,
+                     GLSLstd450MatrixInverse,
+                     GLSLstd450ModfStruct,
+                     GLSLstd450FMin,
+                     GLSLstd450UMin,
+                     GLSLstd450SMin,
+                     GLSLstd450FMax,
+                     GLSLstd450UMax,
+                     GLSLstd450SMax,
+                     GLSLstd450FClamp,
+                     GLSLstd450UClamp,
+                     GLSLstd450SClamp,
+                     GLSLstd450FMix,
+                     GLSLstd450IMix,
+                     GLSLstd450Step,
+                     GLSLstd450SmoothStep,
+                     GLSLstd450Fma,
+                     GLSLstd450FrexpStruct,
+                     GLSLstd450Ldexp,
+                     GLSLstd450PackSnorm4x8,
+                     GLSLstd450PackUnorm4x8,
+                     GLSLstd450PackSnorm2x16,
+                     GLSLstd450PackUnorm2x16,
+                     GLSLstd450PackHalf2x16,
+                     GLSLstd450PackDouble2x32,
+                     GLSLstd450UnpackSnorm2x16,
+                     GLSLstd450UnpackUnorm2x16,
+                     GLSLstd450UnpackHalf2x16,
+                     GLSLstd450UnpackSnorm4x8,
+                     GLSLstd450UnpackUnorm4x8,
+                     GLSLstd450UnpackDouble2x32,
+                     GLSLstd450Length,
+                     GLSLstd450Distance,
+                     GLSLstd450Cross,
+                     GLSLstd450Normalize,
+                     GLSLstd450FaceForward,
+                     GLSLstd450Reflect,
+                     GLSLstd450Refract,
+                     GLSLstd450FindILsb,
+                     GLSLstd450FindSMsb,
+                     GLSLstd450FindUMsb,
+                     GLSLstd450InterpolateAtCentroid,
+                     GLSLstd450InterpolateAtSample,
+                     GLSLstd450InterpolateAtOffset,
+                     GLSLstd450NMin,
+                     GLSLstd450NMax,
+                     GLSLstd450NClamp}) {
+      ops.Set(op);
+    }
   } else {
     // Map the result id to the empty set.
-    combinator_ops_[extension->result_id()];
+    ext_combinator_ops_[extension->result_id()];
   }
 }
 
+std::unique_ptr<IRContext> IRContext::Clone() const {
+  std::unique_ptr<IRContext> clone(
+      new IRContext(syntax_context_->target_env, consumer_));
+  if (instruction_arena_) {
+    clone->EnableInstructionArena();
+  }
+  {
+    // The instructions of the copy come from the arena of the copy, if any.
+    InstructionArena::Scope arena_scope(clone->instruction_arena());
+    clone->module_ = module_->Clone(clone.get());
+  }
+  clone->max_id_bound_ = max_id_bound_;
+  clone->preserve_bindings_ = preserve_bindings_;
+  clone->preserve_spec_constants_ = preserve_spec_constants_;
+  clone->block_counts_ = block_counts_;
+  clone->num_threads_ = num_threads_;
+  clone->function_cache_ = function_cache_;
+  clone->executor_ = executor_;
+  clone->executor_data_ = executor_data_;
+  if (AreAnalysesValid(kAnalysisCombinators)) {
+    clone->combinator_ops_ = combinator_ops_;
+    clone->ext_combinator_ops_ = ext_combinator_ops_;
+    clone->valid_analyses_ |= kAnalysisCombinators;
+  }
+  if (AreAnalysesValid(kAnalysisBuiltinVarId)) {
+    clone->builtin_var_id_map_ = builtin_var_id_map_;
+    clone->valid_analyses_ |= kAnalysisBuiltinVarId;
+  }
+  return clone;
+}
+
 void IRContext::InitializeCombinators() {
+  AnalysisBuildTimer timer(this, kAnalysisCombinators);
   get_feature_mgr()->GetCapabilities()->ForEach(
       [this](SpvCapability cap) { AddCombinatorsForCapability(cap); });
 
@@ -743,6 +1220,7 @@ LoopDescriptor* IRContext::GetLoopDescriptor(const Function* f) {
   std::unordered_map<const Function*, LoopDescriptor>::iterator it =
       loop_descriptors_.find(f);
   if (it == loop_descriptors_.end()) {
+    AnalysisBuildTimer timer(this, kAnalysisLoopAnalysis);
     return &loop_descriptors_
                 .emplace(std::make_pair(f, LoopDescriptor(this, f)))
                 .first->second;
@@ -780,6 +1258,7 @@ void IRContext::AddVarToEntryPoints(uint32_t var_id) {
     if (!found) {
       e.AddOperand({SPV_OPERAND_TYPE_ID, {var_id}});
       get_def_use_mgr()->AnalyzeInstDefUse(&e);
+      InvalidateReflectionFor(e);
     }
   }
 }
@@ -861,10 +1340,9 @@ uint32_t IRContext::GetBuiltinInputVarId(uint32_t builtin) {
 }
 
 void IRContext::AddCalls(const Function* func, std::queue<uint32_t>* todo) {
-  for (auto bi = func->begin(); bi != func->end(); ++bi)
-    for (auto ii = bi->begin(); ii != bi->end(); ++ii)
-      if (ii->opcode() == SpvOpFunctionCall)
-        todo->push(ii->GetSingleWordInOperand(0));
+  for (uint32_t callee : GetCallGraph()->GetCallees(func)) {
+    todo->push(callee);
+  }
 }
 
 bool IRContext::ProcessEntryPointCallTree(ProcessFunction& pfn) {
@@ -912,30 +1390,72 @@ bool IRContext::ProcessCallTreeFromRoots(ProcessFunction& pfn,
   bool modified = false;
   std::unordered_set<uint32_t> done;
 
-  while (!roots->empty()) {
+  while (!roots->empty() && !IsCancelled()) {
     const uint32_t fi = roots->front();
     roots->pop();
     if (done.insert(fi).second) {
       Function* fn = GetFunction(fi);
       assert(fn && "Trying to process a function that does not exist.");
-      modified = pfn(fn) || modified;
+      if (!IsFunctionFilteredOut(fn) && pfn(fn)) {
+        modified = true;
+        AnalyzeCalls(fn);
+      }
       AddCalls(fn, roots);
     }
   }
   return modified;
 }
 
+bool IRContext::ProcessFunctionsInParallel(const StagedProcessFunction& pfn,
+                                           Analysis analyses) {
+  // Build the analyses up front, so that |pfn| never builds them on demand
+  // from several threads.
+  BuildInvalidAnalyses(analyses);
+
+  std::vector<Function*> functions;
+  for (auto& fn : *module()) {
+    if (!IsFunctionFilteredOut(&fn)) {
+      functions.push_back(&fn);
+    }
+  }
+
+  std::vector<std::function<bool()>> changes(functions.size());
+  std::atomic<size_t> next_function(0);
+  auto process_functions = [&functions, &changes, &next_function, &pfn,
+                            this]() {
+    for (size_t i = next_function++; i < functions.size() && !IsCancelled();
+         i = next_function++) {
+      changes[i] = pfn(functions[i]);
+    }
+  };
+
+  size_t num_workers = std::min<size_t>(num_threads_, functions.size());
+  utils::RunOnWorkers(num_workers, executor_, executor_data_,
+                      process_functions);
+
+  // Apply the changes in the order of the functions, so that the result does
+  // not depend on the number of threads.
+  bool modified = false;
+  for (auto& change : changes) {
+    if (change) {
+      modified = change() || modified;
+    }
+  }
+  return modified;
+}
+
 void IRContext::EmitErrorMessage(std::string message, Instruction* inst) {
   if (!consumer()) {
     return;
   }
 
+  const DebugLine* line = nullptr;
   Instruction* line_inst = inst;
   while (line_inst != nullptr) {  // Stop at the beginning of the basic block.
-    if (!line_inst->dbg_line_insts().empty()) {
-      line_inst = &line_inst->dbg_line_insts().back();
-      if (line_inst->opcode() == SpvOpNoLine) {
-        line_inst = nullptr;
+    if (line_inst->has_dbg_lines()) {
+      line = &line_inst->dbg_lines().back();
+      if (line->IsNoLine()) {
+        line = nullptr;
       }
       break;
     }
@@ -945,14 +1465,13 @@ void IRContext::EmitErrorMessage(std::string message, Instruction* inst) {
   uint32_t line_number = 0;
   uint32_t col_number = 0;
   char* source = nullptr;
-  if (line_inst != nullptr) {
-    Instruction* file_name =
-        get_def_use_mgr()->GetDef(line_inst->GetSingleWordInOperand(0));
+  if (line != nullptr) {
+    Instruction* file_name = get_def_use_mgr()->GetDef(line->file);
     source = reinterpret_cast<char*>(&file_name->GetInOperand(0).words[0]);
 
     // Get the line number and column number.
-    line_number = line_inst->GetSingleWordInOperand(1);
-    col_number = line_inst->GetSingleWordInOperand(2);
+    line_number = line->line;
+    col_number = line->column;
   }
 
   message +=
@@ -968,12 +1487,43 @@ DominatorAnalysis* IRContext::GetDominatorAnalysis(const Function* f) {
   }
 
   if (dominator_trees_.find(f) == dominator_trees_.end()) {
+    AnalysisBuildTimer timer(this, kAnalysisDominatorAnalysis);
     dominator_trees_[f].InitializeTree(*cfg(), f);
   }
 
   return &dominator_trees_[f];
 }
 
+// Gets the memory SSA form of function |f|.
+MemorySSA* IRContext::GetMemorySSA(Function* f) {
+  if (!AreAnalysesValid(kAnalysisMemorySSA)) {
+    ResetMemorySSA();
+  }
+
+  std::unique_ptr<MemorySSA>& memory_ssa = memory_ssa_[f];
+  if (!memory_ssa) {
+    AnalysisBuildTimer timer(this, kAnalysisMemorySSA);
+    memory_ssa = MakeUnique<MemorySSA>(this, f);
+  }
+
+  return memory_ssa.get();
+}
+
+// Gets the value range analysis of function |f|.
+ValueRangeAnalysis* IRContext::GetValueRangeAnalysis(const Function* f) {
+  if (!AreAnalysesValid(kAnalysisValueRange)) {
+    ResetValueRangeAnalysis();
+  }
+
+  std::unique_ptr<ValueRangeAnalysis>& value_range = value_ranges_[f];
+  if (!value_range) {
+    AnalysisBuildTimer timer(this, kAnalysisValueRange);
+    value_range = MakeUnique<ValueRangeAnalysis>(this, f);
+  }
+
+  return value_range.get();
+}
+
 // Gets the postdominator analysis for function |f|.
 PostDominatorAnalysis* IRContext::GetPostDominatorAnalysis(const Function* f) {
   if (!AreAnalysesValid(kAnalysisDominatorAnalysis)) {
@@ -981,12 +1531,25 @@ PostDominatorAnalysis* IRContext::GetPostDominatorAnalysis(const Function* f) {
   }
 
   if (post_dominator_trees_.find(f) == post_dominator_trees_.end()) {
+    AnalysisBuildTimer timer(this, kAnalysisDominatorAnalysis);
     post_dominator_trees_[f].InitializeTree(*cfg(), f);
   }
 
   return &post_dominator_trees_[f];
 }
 
+void IRContext::UpdateDominatorAnalyses(
+    const Function* f,
+    const std::function<void(DominatorAnalysisBase*)>& update) {
+  if (!AreAnalysesValid(kAnalysisDominatorAnalysis)) return;
+  auto dominators = dominator_trees_.find(f);
+  if (dominators != dominator_trees_.end()) update(&dominators->second);
+  auto post_dominators = post_dominator_trees_.find(f);
+  if (post_dominators != post_dominator_trees_.end()) {
+    update(&post_dominators->second);
+  }
+}
+
 bool IRContext::CheckCFG() {
   std::unordered_map<uint32_t, std::vector<uint32_t>> real_preds;
   if (!AreAnalysesValid(kAnalysisCFG)) {
@@ -16,6 +16,7 @@
 #define SOURCE_OPT_IR_CONTEXT_H_
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -27,26 +28,37 @@
 #include <vector>
 
 #include "source/assembly_grammar.h"
+#include "source/opt/call_graph.h"
 #include "source/opt/cfg.h"
 #include "source/opt/constants.h"
 #include "source/opt/debug_info_manager.h"
+#include "source/opt/debug_line_table.h"
 #include "source/opt/decoration_manager.h"
 #include "source/opt/def_use_manager.h"
 #include "source/opt/dominator_analysis.h"
 #include "source/opt/feature_manager.h"
 #include "source/opt/fold.h"
+#include "source/opt/instruction_arena.h"
 #include "source/opt/loop_descriptor.h"
+#include "source/opt/memory_ssa.h"
 #include "source/opt/module.h"
+#include "source/opt/reflection_analysis.h"
 #include "source/opt/register_pressure.h"
 #include "source/opt/scalar_analysis.h"
 #include "source/opt/struct_cfg_analysis.h"
 #include "source/opt/type_manager.h"
 #include "source/opt/value_number_table.h"
+#include "source/opt/value_range_analysis.h"
+#include "source/util/bit_vector.h"
+#include "source/util/id_map.h"
 #include "source/util/make_unique.h"
+#include "source/util/span.h"
 
 namespace spvtools {
 namespace opt {
 
+class FunctionResultCache;
+
 class IRContext {
  public:
   // Available analyses.
@@ -80,10 +92,39 @@ class IRContext {
     kAnalysisConstants = 1 << 14,
     kAnalysisTypes = 1 << 15,
     kAnalysisDebugInfo = 1 << 16,
-    kAnalysisEnd = 1 << 17
+    kAnalysisMemorySSA = 1 << 17,
+    kAnalysisValueRange = 1 << 18,
+    kAnalysisReflection = 1 << 19,
+    kAnalysisCallGraph = 1 << 20,
+    kAnalysisEnd = 1 << 21
   };
 
   using ProcessFunction = std::function<bool(Function*)>;
+  // Examines a function without modifying the module, and returns a function
+  // that applies the changes it found.  The returned function returns true if
+  // it modified the module.  It may be empty if there is nothing to change.
+  using StagedProcessFunction =
+      std::function<std::function<bool()>(Function*)>;
+  // An analysis that was built: when the build started, and the time it took,
+  // in seconds.
+  struct AnalysisBuild {
+    Analysis analysis;
+    std::chrono::steady_clock::time_point start;
+    double time;
+  };
+  // A list of the analyses that were built, in the order their builds
+  // finished.
+  using AnalysisBuildLog = std::vector<AnalysisBuild>;
+  // The approximate memory used by the module of a context and by its valid
+  // analyses, in bytes.
+  struct MemoryStats {
+    size_t module = 0;
+    // The valid analyses that could be measured, and the memory of each.
+    std::vector<std::pair<Analysis, size_t>> analyses;
+
+    // Returns the memory used by the module and all of the analyses.
+    size_t Total() const;
+  };
 
   friend inline Analysis operator|(Analysis lhs, Analysis rhs);
   friend inline Analysis& operator|=(Analysis& lhs, Analysis rhs);
@@ -95,6 +136,7 @@ class IRContext {
       : syntax_context_(spvContextCreate(env)),
         grammar_(syntax_context_),
         unique_id_(0),
+        instruction_arena_(nullptr),
         module_(new Module()),
         consumer_(std::move(c)),
         def_use_mgr_(nullptr),
@@ -104,7 +146,15 @@ class IRContext {
         id_to_name_(nullptr),
         max_id_bound_(kDefaultMaxIdBound),
         preserve_bindings_(false),
-        preserve_spec_constants_(false) {
+        preserve_spec_constants_(false),
+        num_threads_(1),
+        function_filter_(nullptr),
+        function_cache_(nullptr),
+        cancel_(nullptr),
+        cancel_data_(nullptr),
+        executor_(nullptr),
+        executor_data_(nullptr),
+        analysis_build_log_(nullptr) {
     SetContextMessageConsumer(syntax_context_, consumer_);
     module_->SetContext(this);
   }
@@ -113,6 +163,7 @@ class IRContext {
       : syntax_context_(spvContextCreate(env)),
         grammar_(syntax_context_),
         unique_id_(0),
+        instruction_arena_(nullptr),
         module_(std::move(m)),
         consumer_(std::move(c)),
         def_use_mgr_(nullptr),
@@ -121,7 +172,15 @@ class IRContext {
         id_to_name_(nullptr),
         max_id_bound_(kDefaultMaxIdBound),
         preserve_bindings_(false),
-        preserve_spec_constants_(false) {
+        preserve_spec_constants_(false),
+        num_threads_(1),
+        function_filter_(nullptr),
+        function_cache_(nullptr),
+        cancel_(nullptr),
+        cancel_data_(nullptr),
+        executor_(nullptr),
+        executor_data_(nullptr),
+        analysis_build_log_(nullptr) {
     SetContextMessageConsumer(syntax_context_, consumer_);
     module_->SetContext(this);
     InitializeCombinators();
@@ -129,6 +188,13 @@ class IRContext {
 
   ~IRContext() { spvContextDestroy(syntax_context_); }
 
+  // Returns a new context holding a deep copy of the module of this context,
+  // with the same result ids and settings.  This is much cheaper than
+  // serializing the module and building it again.  Of the analyses, only those
+  // that do not refer to instructions (the combinators and the built-in
+  // variable ids) are copied; the others are rebuilt on demand.
+  std::unique_ptr<IRContext> Clone() const;
+
   Module* module() const { return module_.get(); }
 
   // Returns a vector of pointers to constant-creation instructions in this
@@ -263,6 +329,24 @@ class IRContext {
     return struct_cfg_analysis_.get();
   }
 
+  // Returns a pointer to the reflection analysis of the module.  If the
+  // analysis is invalid, it is rebuilt first.
+  ReflectionAnalysis* GetReflectionAnalysis() {
+    if (!AreAnalysesValid(kAnalysisReflection)) {
+      BuildReflectionAnalysis();
+    }
+    return reflection_analysis_.get();
+  }
+
+  // Returns a pointer to the call graph of the module.  If the call graph is
+  // invalid, it is rebuilt first.
+  CallGraph* GetCallGraph() {
+    if (!AreAnalysesValid(kAnalysisCallGraph)) {
+      BuildCallGraph();
+    }
+    return call_graph_.get();
+  }
+
   // Returns a pointer to a liveness analysis.  If the liveness analysis is
   // invalid, it is rebuilt first.
   LivenessAnalysis* GetLivenessAnalysis() {
@@ -278,7 +362,7 @@ class IRContext {
     if (!AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
       BuildInstrToBlockMapping();
     }
-    auto entry = instr_to_block_.find(instr);
+    auto entry = instr_to_block_.find(instr->unique_id());
     return (entry != instr_to_block_.end()) ? entry->second : nullptr;
   }
 
@@ -295,7 +379,10 @@ class IRContext {
   // invalid.
   void set_instr_block(Instruction* inst, BasicBlock* block) {
     if (AreAnalysesValid(kAnalysisInstrToBlockMapping)) {
-      instr_to_block_[inst] = block;
+      instr_to_block_[inst->unique_id()] = block;
+    }
+    if (inst->opcode() == SpvOpFunctionCall) {
+      UpdateCallGraphFor(inst, block);
     }
   }
 
@@ -348,6 +435,19 @@ class IRContext {
     return scalar_evolution_analysis_.get();
   }
 
+  // Makes the scalar evolution analysis, if it is valid, forget what it has
+  // computed for |loop| and the loops around and inside it. A transformation
+  // that only changes |loop| can call this and then preserve
+  // kAnalysisScalarEvolution, so the other loops are not analysed again. Must
+  // be called before |loop| is destroyed. The trip count cached in |loop| is
+  // forgotten as well.
+  void ForgetScalarEvolutionOfLoop(const Loop* loop) {
+    loop->InvalidateTripCountInfo();
+    if (AreAnalysesValid(kAnalysisScalarEvolution)) {
+      scalar_evolution_analysis_->ForgetLoop(loop);
+    }
+  }
+
   // Build the map from the ids to the OpName and OpMemberName instruction
   // associated with it.
   inline void BuildIdToNameMap();
@@ -380,6 +480,13 @@ class IRContext {
   // Invalidates the analyses marked in |analyses_to_invalidate|.
   void InvalidateAnalyses(Analysis analyses_to_invalidate);
 
+  // Invalidates the analyses marked in |analyses_to_invalidate| for the
+  // function |f| only.  The CFG, dominator and loop analyses are kept per
+  // function, so those of the other functions remain valid, and those of |f|
+  // are rebuilt the next time they are requested.  Any other analysis in
+  // |analyses_to_invalidate| is invalidated for the whole module.
+  void InvalidateAnalyses(Analysis analyses_to_invalidate, const Function* f);
+
   // Deletes the instruction defining the given |id|. Returns true on
   // success, false if the given |id| is not defined at all. This method also
   // erases the name, decorations, and defintion of |id|.
@@ -403,11 +510,20 @@ class IRContext {
   // instruction exists.
   Instruction* KillInst(Instruction* inst);
 
+  // Deletes the instructions in |insts|, as |KillInst| would one at a time.
+  // The names and decorations of their result ids, and the operands of debug
+  // instructions that refer to them, are removed in one sweep over the module
+  // instead of once per instruction.  Each instruction must appear at most
+  // once in |insts|.
+  void KillInsts(utils::Span<Instruction* const> insts);
+
   // Removes the non-semantic instruction tree that uses |inst|'s result id.
   void KillNonSemanticInfo(Instruction* inst);
 
   // Returns true if all of the given analyses are valid.
-  bool AreAnalysesValid(Analysis set) { return (set & valid_analyses_) == set; }
+  bool AreAnalysesValid(Analysis set) const {
+    return (set & valid_analyses_) == set;
+  }
 
   // Replaces all uses of |before| id with |after| id. Returns true if any
   // replacement happens. This method does not kill the definition of the
@@ -417,6 +533,17 @@ class IRContext {
   // |before| and |after| must be registered definitions in the DefUseManager.
   bool ReplaceAllUsesWith(uint32_t before, uint32_t after);
 
+  // Replaces all uses of each id in |replacements| with the id it is mapped
+  // to. Each user is updated and re-analyzed once, however many of its
+  // operands are replaced, so this is cheaper than a sequence of calls to
+  // |ReplaceAllUsesWith| on bulk rewrites. Returns true if any replacement
+  // happens. This method does not kill the definitions of the replaced ids.
+  //
+  // All of the ids must be registered definitions in the DefUseManager, and
+  // an id that replaces another one must not be replaced itself.
+  bool ReplaceAllUsesWith(
+      const std::unordered_map<uint32_t, uint32_t>& replacements);
+
   // Replace all uses of |before| id with |after| id if those uses
   // (instruction) return true for |predicate|. Returns true if
   // any replacement happens. This method does not kill the definition of the
@@ -443,6 +570,11 @@ class IRContext {
   // will be updated accordingly.
   void AnalyzeUses(Instruction* inst);
 
+  // Informs the IRContext that the calls made by |fn| may have changed.  If the
+  // call graph is valid, it looks at the calls of |fn| again the next time it
+  // is queried.
+  void AnalyzeCalls(const Function* fn);
+
   // Kill all name and decorate ops targeting |id|.
   void KillNamesAndDecorates(uint32_t id);
 
@@ -452,6 +584,18 @@ class IRContext {
   // Change operands of debug instruction to DebugInfoNone.
   void KillOperandFromDebugInstructions(Instruction* inst);
 
+  // Changes the operands of debug instructions that refer to the functions in
+  // |functions| or to the global variables and constants in |globals| to
+  // DebugInfoNone.
+  void KillOperandsFromDebugInstructions(
+      const std::unordered_set<uint32_t>& functions,
+      const std::unordered_set<uint32_t>& globals);
+
+  // Deletes |inst| as |KillInst| does, except for the names, decorations and
+  // debug instruction operands that refer to its result id, which the caller
+  // removes.
+  Instruction* KillInstWithoutReferences(Instruction* inst);
+
   // Returns the next unique id for use by an instruction.
   inline uint32_t TakeNextUniqueId() {
     assert(unique_id_ != std::numeric_limits<uint32_t>::max());
@@ -460,6 +604,11 @@ class IRContext {
     return ++unique_id_;
   }
 
+  // Returns the table of the line-related debug instructions attached to the
+  // instructions of the module.
+  DebugLineTable& debug_line_table() { return debug_line_table_; }
+  const DebugLineTable& debug_line_table() const { return debug_line_table_; }
+
   // Returns true if |inst| is a combinator in the current context.
   // |combinator_ops_| is built if it has not been already.
   inline bool IsCombinatorInstruction(const Instruction* inst) {
@@ -470,11 +619,12 @@ class IRContext {
     const uint32_t kExtInstInstructionInIndx = 1;
 
     if (inst->opcode() != SpvOpExtInst) {
-      return combinator_ops_[0].count(inst->opcode()) != 0;
+      return combinator_ops_.Get(inst->opcode());
     } else {
       uint32_t set = inst->GetSingleWordInOperand(kExtInstSetIdInIndx);
       uint32_t op = inst->GetSingleWordInOperand(kExtInstInstructionInIndx);
-      return combinator_ops_[set].count(op) != 0;
+      auto it = ext_combinator_ops_.find(set);
+      return it != ext_combinator_ops_.end() && it->second.Get(op);
     }
   }
 
@@ -482,6 +632,8 @@ class IRContext {
   CFG* cfg() {
     if (!AreAnalysesValid(kAnalysisCFG)) {
       BuildCFG();
+    } else if (!functions_with_stale_cfg_.empty()) {
+      UpdateStaleCFG();
     }
     return cfg_.get();
   }
@@ -505,6 +657,19 @@ class IRContext {
     post_dominator_trees_.erase(f);
   }
 
+  // Gets the memory SSA form of function |f|.
+  MemorySSA* GetMemorySSA(Function* f);
+
+  // Gets the value range analysis of function |f|.
+  ValueRangeAnalysis* GetValueRangeAnalysis(const Function* f);
+
+  // Calls |update| on the dominator and post-dominator analyses of |f| that
+  // have been built, so that they can be kept valid through a change to the
+  // control flow of |f| rather than rebuilt.
+  void UpdateDominatorAnalyses(
+      const Function* f,
+      const std::function<void(DominatorAnalysisBase*)>& update);
+
   // Return the next available SSA id and increment it.  Returns 0 if the
   // maximum SSA id has been reached.
   inline uint32_t TakeNextId() {
@@ -518,6 +683,20 @@ class IRContext {
     return next_id;
   }
 
+  // Returns the first of |count| consecutive SSA ids, and takes all of them.
+  // Returns 0 if there are not that many ids left.  Passes that create many
+  // ids at once use this instead of calling |TakeNextId| in a loop.
+  inline uint32_t TakeNextIdRange(uint32_t count) {
+    uint32_t first_id = module()->TakeNextIdRange(count);
+    if (first_id == 0) {
+      if (consumer()) {
+        std::string message = "ID overflow. Try running compact-ids.";
+        consumer()(SPV_MSG_ERROR, "", {0, 0, 0}, message.c_str());
+      }
+    }
+    return first_id;
+  }
+
   FeatureManager* get_feature_mgr() {
     if (!feature_mgr_.get()) {
       AnalyzeFeatures();
@@ -542,8 +721,33 @@ class IRContext {
   }
 
   uint32_t max_id_bound() const { return max_id_bound_; }
+
+  // Returns the number of ids that can still be taken before the id bound
+  // reaches |max_id_bound|.  Passes that need many new ids should check this
+  // before they start changing the module, instead of failing part of the way
+  // through.
+  uint32_t NumIdsRemaining() const {
+    const uint32_t bound = module()->id_bound();
+    return bound < max_id_bound_ ? max_id_bound_ - bound : 0;
+  }
   void set_max_id_bound(uint32_t new_bound) { max_id_bound_ = new_bound; }
 
+  // Creates the instruction arena of this context, if it does not exist yet.
+  // Instructions created while the arena is current (see
+  // |InstructionArena::Scope|) are allocated from it, and the arena releases
+  // all of its memory at once when the context is destroyed.
+  void EnableInstructionArena() {
+    if (!instruction_arena_) {
+      instruction_arena_ = MakeUnique<InstructionArena>();
+    }
+  }
+
+  // Returns the instruction arena of this context, or nullptr if it has not
+  // been enabled.
+  InstructionArena* instruction_arena() const {
+    return instruction_arena_.get();
+  }
+
   bool preserve_bindings() const { return preserve_bindings_; }
   void set_preserve_bindings(bool should_preserve_bindings) {
     preserve_bindings_ = should_preserve_bindings;
@@ -554,6 +758,119 @@ class IRContext {
     preserve_spec_constants_ = should_preserve_spec_constants;
   }
 
+  // Records that the block whose label is |block_id| executed |count| times
+  // in the profile attached to the module.
+  void SetBlockExecutionCount(uint32_t block_id, uint64_t count) {
+    block_counts_[block_id] = count;
+  }
+
+  // Returns true if a profile with at least one block count is attached to
+  // the module.
+  bool HasProfile() const { return !block_counts_.empty(); }
+
+  // Returns true and sets |count| to the number of executions of |block| if
+  // the profile has a count for it.  Blocks created after the profile was
+  // attached have no count.
+  bool GetBlockExecutionCount(const BasicBlock* block, uint64_t* count) const {
+    auto it = block_counts_.find(block->id());
+    if (it == block_counts_.end()) return false;
+    *count = it->second;
+    return true;
+  }
+
+  // Returns true if the profile says that |block| never executed.  Blocks
+  // without a count are not cold, so passes treat them as they would without
+  // a profile.
+  bool IsColdBlock(const BasicBlock* block) const {
+    uint64_t count = 0;
+    return GetBlockExecutionCount(block, &count) && count == 0;
+  }
+
+  // Sets the log to which the analyses are appended when they are built.  No
+  // log is kept if |log| is nullptr.  The time of an analysis includes the
+  // time of any analysis it built in turn.
+  void set_analysis_build_log(AnalysisBuildLog* log) {
+    analysis_build_log_ = log;
+  }
+
+  // Returns a short name for the single analysis |analysis|, such as
+  // "def-use".
+  static const char* GetAnalysisName(Analysis analysis);
+
+  // Returns the approximate memory used by the module and by each of the
+  // valid analyses that can measure it.  The loop descriptors, the memory SSA
+  // forms and the other analyses that cannot are left out.  It walks every
+  // instruction and analysis, so it is meant for reports rather than for
+  // every pass.
+  MemoryStats GetMemoryStats() const;
+
+  // Counts of the work done on the module since the context was created.
+  // Unlike times, they do not depend on the machine, so they can tell the
+  // inputs for which the work grows faster than the module.
+  struct WorkCounts {
+    // The number of analyses built, each time they were built.
+    size_t analysis_builds = 0;
+    // The number of use records the def-use managers added or removed,
+    // including while they were built.
+    size_t def_use_updates = 0;
+  };
+  WorkCounts GetWorkCounts() const {
+    WorkCounts counts = work_counts_;
+    if (def_use_mgr_) counts.def_use_updates += def_use_mgr_->num_updates();
+    return counts;
+  }
+
+  // Returns the maximum number of threads |ProcessFunctionsInParallel| may
+  // use.
+  uint32_t num_threads() const { return num_threads_; }
+  void set_num_threads(uint32_t num_threads) {
+    num_threads_ = std::max(num_threads, 1u);
+  }
+
+  // Restricts the functions that passes process to |function|.  While a filter
+  // is set, the |Process*| methods below skip every other function, and passes
+  // that walk the functions of the module themselves must skip the functions
+  // for which |IsFunctionFilteredOut| is true.  Passes with module-wide steps,
+  // such as removing dead functions or globals, skip those steps.  Passing
+  // nullptr removes the filter.
+  void set_function_filter(const Function* function) {
+    function_filter_ = function;
+  }
+  bool HasFunctionFilter() const { return function_filter_ != nullptr; }
+  bool IsFunctionFilteredOut(const Function* function) const {
+    return function_filter_ != nullptr && function != function_filter_;
+  }
+
+  // Sets the cache in which the groups of function-local passes run by
+  // |FunctionPipelinePass| record their results, and from which they replay
+  // them, or nullptr to run them on every function.  The cache can be shared
+  // by several contexts.
+  void set_function_cache(FunctionResultCache* cache) {
+    function_cache_ = cache;
+  }
+  FunctionResultCache* function_cache() const { return function_cache_; }
+
+  // Sets the function that says whether the optimization should stop, and
+  // the data it is given, or nullptr to never stop.  While it says so, the
+  // |Process*| methods below stop processing functions, and the pass manager
+  // fails before the next pass.
+  void set_cancel(spv_cancel_fn cancel, void* data) {
+    cancel_ = cancel;
+    cancel_data_ = data;
+  }
+  bool IsCancelled() const { return cancel_ && cancel_(cancel_data_); }
+  spv_cancel_fn cancel() const { return cancel_; }
+  void* cancel_data() const { return cancel_data_; }
+
+  // Sets the executor on whose tasks |ProcessFunctionsInParallel| processes
+  // the functions, and the data it is given, or nullptr to start threads.
+  void set_executor(spv_executor_fn executor, void* data) {
+    executor_ = executor;
+    executor_data_ = data;
+  }
+  spv_executor_fn executor() const { return executor_; }
+  void* executor_data() const { return executor_data_; }
+
   // Return id of input variable only decorated with |builtin|, if in module.
   // Create variable and return its id otherwise. If builtin not currently
   // supported, return 0.
@@ -596,25 +913,71 @@ class IRContext {
   bool ProcessCallTreeFromRoots(ProcessFunction& pfn,
                                 std::queue<uint32_t>* roots);
 
+  // Applies |pfn| to every function in the module, on up to |num_threads()|
+  // threads at the same time, and then runs the changes returned by |pfn| one
+  // at a time, in the order of the functions in the module.  Returns true if
+  // any of the changes returns true.
+  //
+  // The analyses in |analyses| are built before |pfn| is first called.  While
+  // |pfn| runs it may only read the module and those analyses: it must not
+  // modify the module or any analysis, create instructions or take ids.  All
+  // modifications belong in the changes it returns.
+  bool ProcessFunctionsInParallel(const StagedProcessFunction& pfn,
+                                  Analysis analyses);
+
   // Emmits a error message to the message consumer indicating the error
   // described by |message| occurred in |inst|.
   void EmitErrorMessage(std::string message, Instruction* inst);
 
  private:
+  // Appends |analysis| and the time between the construction and the
+  // destruction of the timer to the analysis build log of |context|, if it
+  // has one.
+  class AnalysisBuildTimer {
+   public:
+    AnalysisBuildTimer(IRContext* context, Analysis analysis)
+        : context_(context), analysis_(analysis) {
+      ++context_->work_counts_.analysis_builds;
+      if (context_->analysis_build_log_) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+    ~AnalysisBuildTimer() {
+      if (context_->analysis_build_log_) {
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start_;
+        context_->analysis_build_log_->push_back(
+            {analysis_, start_, elapsed.count()});
+      }
+    }
+
+   private:
+    IRContext* context_;
+    Analysis analysis_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
   // Builds the def-use manager from scratch, even if it was already valid.
   void BuildDefUseManager() {
+    AnalysisBuildTimer timer(this, kAnalysisDefUse);
+    if (def_use_mgr_) {
+      work_counts_.def_use_updates += def_use_mgr_->num_updates();
+    }
     def_use_mgr_ = MakeUnique<analysis::DefUseManager>(module());
     valid_analyses_ = valid_analyses_ | kAnalysisDefUse;
   }
 
   // Builds the instruction-block map for the whole module.
   void BuildInstrToBlockMapping() {
+    AnalysisBuildTimer timer(this, kAnalysisInstrToBlockMapping);
     instr_to_block_.clear();
+    instr_to_block_.reserve(unique_id_ + 1);
     for (auto& fn : *module_) {
       for (auto& block : fn) {
-        block.ForEachInst([this, &block](Instruction* inst) {
-          instr_to_block_[inst] = &block;
-        });
+        if (Instruction* label = block.GetLabelInst()) {
+          instr_to_block_[label->unique_id()] = &block;
+        }
+        for (auto& inst : block) instr_to_block_[inst.unique_id()] = &block;
       }
     }
     valid_analyses_ = valid_analyses_ | kAnalysisInstrToBlockMapping;
@@ -622,6 +985,7 @@ class IRContext {
 
   // Builds the instruction-function map for the whole module.
   void BuildIdToFuncMapping() {
+    AnalysisBuildTimer timer(this, kAnalysisIdToFuncMapping);
     id_to_func_.clear();
     for (auto& fn : *module_) {
       id_to_func_[fn.result_id()] = &fn;
@@ -630,22 +994,31 @@ class IRContext {
   }
 
   void BuildDecorationManager() {
+    AnalysisBuildTimer timer(this, kAnalysisDecorations);
     decoration_mgr_ = MakeUnique<analysis::DecorationManager>(module());
     valid_analyses_ = valid_analyses_ | kAnalysisDecorations;
   }
 
   void BuildCFG() {
+    AnalysisBuildTimer timer(this, kAnalysisCFG);
     cfg_ = MakeUnique<CFG>(module());
+    functions_with_stale_cfg_.clear();
     valid_analyses_ = valid_analyses_ | kAnalysisCFG;
   }
 
+  // Rebuilds the part of the CFG of the functions whose CFG was invalidated
+  // by |InvalidateAnalyses(Analysis, const Function*)|.
+  void UpdateStaleCFG();
+
   void BuildScalarEvolutionAnalysis() {
+    AnalysisBuildTimer timer(this, kAnalysisScalarEvolution);
     scalar_evolution_analysis_ = MakeUnique<ScalarEvolutionAnalysis>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisScalarEvolution;
   }
 
   // Builds the liveness analysis from scratch, even if it was already valid.
   void BuildRegPressureAnalysis() {
+    AnalysisBuildTimer timer(this, kAnalysisRegisterPressure);
     reg_pressure_ = MakeUnique<LivenessAnalysis>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisRegisterPressure;
   }
@@ -653,6 +1026,7 @@ class IRContext {
   // Builds the value number table analysis from scratch, even if it was already
   // valid.
   void BuildValueNumberTable() {
+    AnalysisBuildTimer timer(this, kAnalysisValueNumberTable);
     vn_table_ = MakeUnique<ValueNumberTable>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisValueNumberTable;
   }
@@ -660,13 +1034,44 @@ class IRContext {
   // Builds the structured CFG analysis from scratch, even if it was already
   // valid.
   void BuildStructuredCFGAnalysis() {
+    AnalysisBuildTimer timer(this, kAnalysisStructuredCFG);
     struct_cfg_analysis_ = MakeUnique<StructuredCFGAnalysis>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisStructuredCFG;
   }
 
+  // Builds the reflection analysis from scratch, even if it was already
+  // valid.
+  void BuildReflectionAnalysis() {
+    AnalysisBuildTimer timer(this, kAnalysisReflection);
+    reflection_analysis_ = MakeUnique<ReflectionAnalysis>(this);
+    valid_analyses_ = valid_analyses_ | kAnalysisReflection;
+  }
+
+  // Builds the call graph from scratch, even if it was already valid.
+  void BuildCallGraph() {
+    AnalysisBuildTimer timer(this, kAnalysisCallGraph);
+    call_graph_ = MakeUnique<CallGraph>(this);
+    valid_analyses_ = valid_analyses_ | kAnalysisCallGraph;
+  }
+
+  // Updates the call graph, if it is valid, for the function call |inst|,
+  // which may have been added, changed, or moved to |block|.  |block| may be
+  // nullptr if it is not known.
+  void UpdateCallGraphFor(Instruction* inst, BasicBlock* block);
+
+  // Invalidates the reflection analysis if adding or removing |inst| may
+  // change it.
+  void InvalidateReflectionFor(const Instruction& inst) {
+    if (AreAnalysesValid(kAnalysisReflection) &&
+        reflection_analysis_->IsAffectedBy(inst)) {
+      InvalidateAnalyses(kAnalysisReflection);
+    }
+  }
+
   // Builds the constant manager from scratch, even if it was already
   // valid.
   void BuildConstantManager() {
+    AnalysisBuildTimer timer(this, kAnalysisConstants);
     constant_mgr_ = MakeUnique<analysis::ConstantManager>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisConstants;
   }
@@ -674,6 +1079,7 @@ class IRContext {
   // Builds the type manager from scratch, even if it was already
   // valid.
   void BuildTypeManager() {
+    AnalysisBuildTimer timer(this, kAnalysisTypes);
     type_mgr_ = MakeUnique<analysis::TypeManager>(consumer(), this);
     valid_analyses_ = valid_analyses_ | kAnalysisTypes;
   }
@@ -681,6 +1087,7 @@ class IRContext {
   // Builds the debug information manager from scratch, even if it was
   // already valid.
   void BuildDebugInfoManager() {
+    AnalysisBuildTimer timer(this, kAnalysisDebugInfo);
     debug_info_mgr_ = MakeUnique<analysis::DebugInfoManager>(this);
     valid_analyses_ = valid_analyses_ | kAnalysisDebugInfo;
   }
@@ -701,6 +1108,20 @@ class IRContext {
     valid_analyses_ = valid_analyses_ | kAnalysisLoopAnalysis;
   }
 
+  // Removes all computed memory SSA forms.
+  void ResetMemorySSA() {
+    // Clear the cache.
+    memory_ssa_.clear();
+    valid_analyses_ = valid_analyses_ | kAnalysisMemorySSA;
+  }
+
+  // Removes all computed value range analyses.
+  void ResetValueRangeAnalysis() {
+    // Clear the cache.
+    value_ranges_.clear();
+    valid_analyses_ = valid_analyses_ | kAnalysisValueRange;
+  }
+
   // Removes all computed loop descriptors.
   void ResetBuiltinAnalysis() {
     // Clear the cache.
@@ -752,6 +1173,16 @@ class IRContext {
   // Therefore, 0 is not a valid unique id for an instruction.
   uint32_t unique_id_;
 
+  // The line-related debug instructions attached to the instructions of
+  // |module_|.  Like the instructions, it must not be modified while
+  // |ProcessFunctionsInParallel| runs the analysis stage of a pass.
+  DebugLineTable debug_line_table_;
+
+  // The arena from which the instructions of |module_| are allocated, if
+  // enabled.  It must be declared before |module_| so that it is destroyed
+  // after all of the instructions.
+  std::unique_ptr<InstructionArena> instruction_arena_;
+
   // The module being processed within this IR context.
   std::unique_ptr<Module> module_;
 
@@ -765,12 +1196,12 @@ class IRContext {
   std::unique_ptr<analysis::DecorationManager> decoration_mgr_;
   std::unique_ptr<FeatureManager> feature_mgr_;
 
-  // A map from instructions to the basic block they belong to. This mapping is
-  // built on-demand when get_instr_block() is called.
+  // A map from the unique ids of instructions to the basic block they belong
+  // to. This mapping is built on-demand when get_instr_block() is called.
   //
   // NOTE: Do not traverse this map. Ever. Use the function and basic block
   // iterators to traverse instructions.
-  std::unordered_map<Instruction*, BasicBlock*> instr_to_block_;
+  utils::IdMap<BasicBlock*> instr_to_block_;
 
   // A map from ids to the function they define. This mapping is
   // built on-demand when GetFunction() is called.
@@ -783,8 +1214,12 @@ class IRContext {
   Analysis valid_analyses_;
 
   // Opcodes of shader capability core executable instructions
-  // without side-effect.
-  std::unordered_map<uint32_t, std::unordered_set<uint32_t>> combinator_ops_;
+  // without side-effect, indexed by opcode.
+  utils::BitVector combinator_ops_;
+
+  // The extended instructions without side-effect of each imported
+  // instruction set, indexed by instruction number.
+  std::unordered_map<uint32_t, utils::BitVector> ext_combinator_ops_;
 
   // Opcodes of shader capability core executable instructions
   // without side-effect.
@@ -793,6 +1228,9 @@ class IRContext {
   // The CFG for all the functions in |module_|.
   std::unique_ptr<CFG> cfg_;
 
+  // The functions whose part of |cfg_| is out of date.
+  std::unordered_set<const Function*> functions_with_stale_cfg_;
+
   // Each function in the module will create its own dominator tree. We cache
   // the result so it doesn't need to be rebuilt each time.
   std::map<const Function*, DominatorAnalysis> dominator_trees_;
@@ -801,6 +1239,19 @@ class IRContext {
   // Cache of loop descriptors for each function.
   std::unordered_map<const Function*, LoopDescriptor> loop_descriptors_;
 
+  // Cache of the memory SSA form of each function.
+  std::unordered_map<const Function*, std::unique_ptr<MemorySSA>> memory_ssa_;
+
+  // Cache of the value range analysis of each function.
+  std::unordered_map<const Function*, std::unique_ptr<ValueRangeAnalysis>>
+      value_ranges_;
+
+  // The resources, entry points and specialization constants of |module_|.
+  std::unique_ptr<ReflectionAnalysis> reflection_analysis_;
+
+  // The call graph of |module_|.
+  std::unique_ptr<CallGraph> call_graph_;
+
   // Constant manager for |module_|.
   std::unique_ptr<analysis::ConstantManager> constant_mgr_;
 
@@ -834,6 +1285,36 @@ class IRContext {
   // Whether all specialization constants within |module_|
   // should be preserved.
   bool preserve_spec_constants_;
+
+  // The execution count of each block in the attached profile, keyed by the
+  // id of the block label.
+  std::unordered_map<uint32_t, uint64_t> block_counts_;
+
+  // The maximum number of threads used by |ProcessFunctionsInParallel|.
+  uint32_t num_threads_;
+
+  // The only function passes may process, or nullptr if they may process all
+  // of them.
+  const Function* function_filter_;
+
+  // The cache of the results of the function pipelines, or nullptr.
+  FunctionResultCache* function_cache_;
+
+  // The function that says whether the optimization should stop, and the data
+  // it is given.
+  spv_cancel_fn cancel_;
+  void* cancel_data_;
+
+  // The executor on whose tasks the functions are processed in parallel, and
+  // the data it is given.
+  spv_executor_fn executor_;
+  void* executor_data_;
+
+  // The log of the analyses built by this context, or nullptr if none is kept.
+  AnalysisBuildLog* analysis_build_log_;
+
+  // The work done on the module, less the def-use updates of |def_use_mgr_|.
+  WorkCounts work_counts_;
 };
 
 inline IRContext::Analysis operator|(IRContext::Analysis lhs,
@@ -1057,6 +1538,7 @@ void IRContext::SetMemoryModel(std::unique_ptr<Instruction>&& m) {
 }
 
 void IRContext::AddEntryPoint(std::unique_ptr<Instruction>&& e) {
+  InvalidateReflectionFor(*e);
   module()->AddEntryPoint(std::move(e));
 }
 
@@ -1076,6 +1558,7 @@ void IRContext::AddDebug2Inst(std::unique_ptr<Instruction>&& d) {
       id_to_name_->insert({d->GetSingleWordInOperand(0), d.get()});
     }
   }
+  InvalidateReflectionFor(*d);
   module()->AddDebug2Inst(std::move(d));
 }
 
@@ -1094,6 +1577,7 @@ void IRContext::AddAnnotationInst(std::unique_ptr<Instruction>&& a) {
   if (AreAnalysesValid(kAnalysisDefUse)) {
     get_def_use_mgr()->AnalyzeInstDefUse(a.get());
   }
+  InvalidateReflectionFor(*a);
   module()->AddAnnotationInst(std::move(a));
 }
 
@@ -1108,10 +1592,14 @@ void IRContext::AddGlobalValue(std::unique_ptr<Instruction>&& v) {
   if (AreAnalysesValid(kAnalysisDefUse)) {
     get_def_use_mgr()->AnalyzeInstDefUse(&*v);
   }
+  InvalidateReflectionFor(*v);
   module()->AddGlobalValue(std::move(v));
 }
 
 void IRContext::AddFunction(std::unique_ptr<Function>&& f) {
+  if (AreAnalysesValid(kAnalysisCallGraph)) {
+    call_graph_->AddFunction(f.get());
+  }
   module()->AddFunction(std::move(f));
 }
 
@@ -1119,6 +1607,9 @@ void IRContext::AnalyzeDefUse(Instruction* inst) {
   if (AreAnalysesValid(kAnalysisDefUse)) {
     get_def_use_mgr()->AnalyzeInstDefUse(inst);
   }
+  if (inst->opcode() == SpvOpFunctionCall) {
+    UpdateCallGraphFor(inst, nullptr);
+  }
 }
 
 void IRContext::UpdateDefUse(Instruction* inst) {
@@ -1128,6 +1619,7 @@ void IRContext::UpdateDefUse(Instruction* inst) {
 }
 
 void IRContext::BuildIdToNameMap() {
+  AnalysisBuildTimer timer(this, kAnalysisNameMap);
   id_to_name_ = MakeUnique<std::multimap<uint32_t, Instruction*>>();
   for (Instruction& debug_inst : debugs2()) {
     if (debug_inst.opcode() == SpvOpMemberName ||
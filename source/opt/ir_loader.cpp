@@ -35,12 +35,17 @@ IrLoader::IrLoader(const MessageConsumer& consumer, Module* m)
       module_(m),
       source_("<instruction>"),
       inst_index_(0),
+      skip_debug_line_insts_(false),
       last_dbg_scope_(kNoDebugScope, kNoInlinedAt) {}
 
 bool IrLoader::AddInstruction(const spv_parsed_instruction_t* inst) {
   ++inst_index_;
   const auto opcode = static_cast<SpvOp>(inst->opcode);
   if (IsDebugLineInst(opcode)) {
+    if (skip_debug_line_insts_) {
+      module()->SetDroppedDebugLineInsts();
+      return true;
+    }
     dbg_line_info_.push_back(
         Instruction(module()->context(), *inst, last_dbg_scope_));
     return true;
@@ -48,6 +48,11 @@ class IrLoader {
 
   Module* module() const { return module_; }
 
+  // Sets whether OpLine and OpNoLine instructions are dropped rather than
+  // attached to the instructions that follow them.  This saves building them
+  // when they are going to be stripped anyway.
+  void SetSkipDebugLineInsts(bool skip) { skip_debug_line_insts_ = skip; }
+
   // Sets the fields in the module's header to the given parameters.
   void SetModuleHeader(uint32_t magic, uint32_t version, uint32_t generator,
                        uint32_t bound, uint32_t reserved) {
@@ -78,6 +83,8 @@ class IrLoader {
   std::unique_ptr<BasicBlock> block_;
   // Line related debug instructions accumulated thus far.
   std::vector<Instruction> dbg_line_info_;
+  // Whether OpLine and OpNoLine instructions are dropped.
+  bool skip_debug_line_insts_;
 
   // The last DebugScope information that IrLoader::AddInstruction() handled.
   DebugScope last_dbg_scope_;
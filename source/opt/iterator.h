@@ -19,6 +19,7 @@
 #include <iterator>
 #include <memory>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -266,6 +267,32 @@ typename FilterIterator<SubIterator, Predicate>::Range MakeFilterIteratorRange(
       MakeFilterIterator(end, end, predicate));
 }
 
+// Reorders |items| so that the elements of |order| come first, in that order,
+// followed by the other items in their current order.  The elements of |order|
+// must be distinct and owned by |items|.  Returns true if the order changed.
+template <typename T>
+bool ReorderUptrVector(std::vector<std::unique_ptr<T>>* items,
+                       const std::vector<T*>& order) {
+  std::unordered_map<const T*, size_t> index;
+  for (size_t i = 0; i < items->size(); ++i) index[(*items)[i].get()] = i;
+
+  bool changed = false;
+  std::vector<std::unique_ptr<T>> reordered;
+  reordered.reserve(items->size());
+  for (T* item : order) {
+    const size_t i = index.at(item);
+    changed |= i != reordered.size();
+    reordered.push_back(std::move((*items)[i]));
+  }
+  for (auto& item : *items) {
+    if (!item) continue;
+    changed |= index.at(item.get()) != reordered.size();
+    reordered.push_back(std::move(item));
+  }
+  items->swap(reordered);
+  return changed;
+}
+
 template <typename VT, bool IC>
 inline UptrVectorIterator<VT, IC>& UptrVectorIterator<VT, IC>::operator++() {
   ++iterator_;
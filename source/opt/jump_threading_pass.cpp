@@ -0,0 +1,290 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/jump_threading_pass.h"
+
+#include <vector>
+
+#include "source/opt/struct_cfg_analysis.h"
+#include "source/opt/value_number_table.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kSelectionMergeMergeBlockInIdx = 0;
+const uint32_t kBranchCondConditionInIdx = 0;
+const uint32_t kBranchCondTrueLabelInIdx = 1;
+const uint32_t kBranchCondFalseLabelInIdx = 2;
+const uint32_t kLogicalNotOperandInIdx = 0;
+
+// Returns true if |bb| is the header of a selection on a boolean condition.
+bool IsConditionalSelectionHeader(const BasicBlock& bb) {
+  const Instruction* merge = bb.GetMergeInst();
+  return merge != nullptr && merge->opcode() == SpvOpSelectionMerge &&
+         bb.tail()->opcode() == SpvOpBranchConditional;
+}
+
+// Returns the label of the successor of the conditional branch |branch| taken
+// when its condition is |value|.
+uint32_t GetSuccessor(const Instruction* branch, bool value) {
+  return branch->GetSingleWordInOperand(value ? kBranchCondTrueLabelInIdx
+                                              : kBranchCondFalseLabelInIdx);
+}
+
+}  // namespace
+
+bool JumpThreadingPass::AreEquivalentConditions(uint32_t a, uint32_t b,
+                                                bool* negated) {
+  *negated = false;
+  if (a == b) return true;
+
+  const ValueNumberTable* vn_table = context()->GetValueNumberTable();
+  uint32_t a_value = vn_table->GetValueNumber(a);
+  if (a_value != 0 && a_value == vn_table->GetValueNumber(b)) return true;
+
+  bool inner_negated = false;
+  Instruction* a_inst = get_def_use_mgr()->GetDef(a);
+  if (a_inst->opcode() == SpvOpLogicalNot &&
+      AreEquivalentConditions(
+          a_inst->GetSingleWordInOperand(kLogicalNotOperandInIdx), b,
+          &inner_negated)) {
+    *negated = !inner_negated;
+    return true;
+  }
+  Instruction* b_inst = get_def_use_mgr()->GetDef(b);
+  if (b_inst->opcode() == SpvOpLogicalNot &&
+      AreEquivalentConditions(
+          a, b_inst->GetSingleWordInOperand(kLogicalNotOperandInIdx),
+          &inner_negated)) {
+    *negated = !inner_negated;
+    return true;
+  }
+  return false;
+}
+
+BasicBlock* JumpThreadingPass::GetExclusiveSuccessor(BasicBlock* header,
+                                                     bool value) {
+  const Instruction* branch = header->terminator();
+  uint32_t successor = GetSuccessor(branch, value);
+  if (successor == GetSuccessor(branch, !value) ||
+      successor == header->MergeBlockIdIfAny() ||
+      cfg()->preds(successor).size() != 1) {
+    return nullptr;
+  }
+  return cfg()->block(successor);
+}
+
+bool JumpThreadingPass::FoldKnownConditions(Function* func) {
+  // A condition is known on the side of a selection that is only entered from
+  // its header.
+  struct KnownCondition {
+    uint32_t condition;
+    BasicBlock* successor;
+    bool value;
+  };
+  std::vector<KnownCondition> known_conditions;
+  std::vector<BasicBlock*> headers;
+  for (BasicBlock& bb : *func) {
+    if (!IsConditionalSelectionHeader(bb)) continue;
+    headers.push_back(&bb);
+    uint32_t condition =
+        bb.terminator()->GetSingleWordInOperand(kBranchCondConditionInIdx);
+    for (bool value : {true, false}) {
+      if (BasicBlock* successor = GetExclusiveSuccessor(&bb, value)) {
+        known_conditions.push_back({condition, successor, value});
+      }
+    }
+  }
+
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(func);
+  analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+  analysis::Bool temp;
+  const analysis::Bool* bool_type =
+      context()->get_type_mgr()->GetRegisteredType(&temp)->AsBool();
+
+  bool modified = false;
+  for (BasicBlock* header : headers) {
+    Instruction* branch = header->terminator();
+    uint32_t condition =
+        branch->GetSingleWordInOperand(kBranchCondConditionInIdx);
+    if (const_mgr->FindDeclaredConstant(condition) != nullptr) continue;
+
+    for (const KnownCondition& known : known_conditions) {
+      bool negated = false;
+      if (!dom->Dominates(known.successor, header) ||
+          !AreEquivalentConditions(condition, known.condition, &negated)) {
+        continue;
+      }
+
+      // The branch itself is left for dead branch elimination to fold.
+      const analysis::Constant* value =
+          const_mgr->GetConstant(bool_type, {known.value != negated});
+      Instruction* value_inst = const_mgr->GetDefiningInstruction(value);
+      branch->SetInOperand(kBranchCondConditionInIdx,
+                           {value_inst->result_id()});
+      get_def_use_mgr()->AnalyzeInstUse(branch);
+      modified = true;
+      break;
+    }
+  }
+  return modified;
+}
+
+bool JumpThreadingPass::FuseWithNextSelection(Function* func,
+                                              BasicBlock* header) {
+  uint32_t next_id = header->MergeBlockIdIfAny();
+  BasicBlock* next = cfg()->block(next_id);
+  if (!IsConditionalSelectionHeader(*next) ||
+      context()->GetStructuredCFGAnalysis()->IsContinueBlock(next_id)) {
+    return false;
+  }
+
+  // |next| must not close any construct other than the selection of |header|.
+  Instruction* merge = header->GetMergeInst();
+  if (!get_def_use_mgr()->WhileEachUser(
+          next->GetLabelInst(), [merge](Instruction* user) {
+            return user == merge || (user->opcode() != SpvOpSelectionMerge &&
+                                     user->opcode() != SpvOpLoopMerge);
+          })) {
+    return false;
+  }
+
+  Instruction* branch = header->terminator();
+  Instruction* next_branch = next->terminator();
+  bool negated = false;
+  if (!AreEquivalentConditions(
+          next_branch->GetSingleWordInOperand(kBranchCondConditionInIdx),
+          branch->GetSingleWordInOperand(kBranchCondConditionInIdx),
+          &negated)) {
+    return false;
+  }
+
+  // |next| goes away, so it must not compute anything used elsewhere.
+  for (Instruction& inst : *next) {
+    if (&inst == next_branch || &inst == next->GetMergeInst()) continue;
+    if (inst.opcode() == SpvOpPhi ||
+        !context()->IsCombinatorInstruction(&inst)) {
+      return false;
+    }
+    if (!get_def_use_mgr()->WhileEachUser(
+            &inst, [this, next](Instruction* user) {
+              return context()->get_instr_block(user) == next;
+            })) {
+      return false;
+    }
+  }
+
+  // The successors of |next|, indexed by the value of the condition of
+  // |header|.  They must be entered only from |next|, so that they can be
+  // entered from a side of |header| instead.
+  uint32_t next_merge_id = next->MergeBlockIdIfAny();
+  uint32_t next_successors[2] = {GetSuccessor(next_branch, negated),
+                                 GetSuccessor(next_branch, !negated)};
+  if (next_successors[0] == next_successors[1]) return false;
+  for (uint32_t successor : next_successors) {
+    if (successor != next_merge_id && cfg()->preds(successor).size() != 1) {
+      return false;
+    }
+  }
+
+  // Finds the side of |header| each predecessor of |next| is on.  Each side
+  // may reach |next| through a single unconditional branch, so the new edges
+  // keep the selection structured.
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(func);
+  std::vector<uint32_t> side_preds[2];
+  for (uint32_t pred_id : cfg()->preds(next_id)) {
+    int side = -1;
+    if (pred_id == header->id()) {
+      side = GetSuccessor(branch, true) == next_id ? 1 : 0;
+    } else if (cfg()->block(pred_id)->tail()->opcode() == SpvOpBranch) {
+      for (int value = 0; value < 2; ++value) {
+        BasicBlock* successor = GetExclusiveSuccessor(header, value != 0);
+        if (successor != nullptr && dom->Dominates(successor->id(), pred_id)) {
+          side = value;
+        }
+      }
+    }
+    if (side < 0 || !side_preds[side].empty()) return false;
+    side_preds[side].push_back(pred_id);
+  }
+
+  for (int value = 0; value < 2; ++value) {
+    uint32_t successor_id = next_successors[value];
+    for (uint32_t pred_id : side_preds[value]) {
+      Instruction* terminator = cfg()->block(pred_id)->terminator();
+      terminator->ForEachInId([next_id, successor_id](uint32_t* id) {
+        if (*id == next_id) *id = successor_id;
+      });
+      get_def_use_mgr()->AnalyzeInstUse(terminator);
+    }
+
+    // The phis of the successor get their values from the side instead of
+    // from |next|.
+    cfg()->block(successor_id)->ForEachPhiInst(
+        [this, next_id, &side_preds, value](Instruction* phi) {
+          Instruction::OperandList operands;
+          for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+            uint32_t incoming = phi->GetSingleWordInOperand(i);
+            uint32_t parent = phi->GetSingleWordInOperand(i + 1);
+            if (parent != next_id) {
+              operands.push_back({SPV_OPERAND_TYPE_ID, {incoming}});
+              operands.push_back({SPV_OPERAND_TYPE_ID, {parent}});
+              continue;
+            }
+            for (uint32_t pred_id : side_preds[value]) {
+              operands.push_back({SPV_OPERAND_TYPE_ID, {incoming}});
+              operands.push_back({SPV_OPERAND_TYPE_ID, {pred_id}});
+            }
+          }
+          phi->SetInOperands(std::move(operands));
+          get_def_use_mgr()->AnalyzeInstUse(phi);
+        });
+  }
+
+  merge->SetInOperand(kSelectionMergeMergeBlockInIdx, {next_merge_id});
+  get_def_use_mgr()->AnalyzeInstUse(merge);
+
+  auto next_it = func->FindBlock(next_id);
+  next_it->KillAllInsts(true);
+  next_it.Erase();
+  return true;
+}
+
+bool JumpThreadingPass::ProcessFunction(Function* func) {
+  bool modified = FoldKnownConditions(func);
+
+  // Fusing selections changes the CFG, so the analyses are rebuilt before
+  // looking for the next one.
+  for (BasicBlock& bb : *func) {
+    if (IsConditionalSelectionHeader(bb) && FuseWithNextSelection(func, &bb)) {
+      context()->InvalidateAnalysesExceptFor(GetPreservedAnalyses());
+      return true;
+    }
+  }
+  return modified;
+}
+
+Pass::Status JumpThreadingPass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    while (ProcessFunction(&func)) {
+      modified = true;
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
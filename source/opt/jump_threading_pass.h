@@ -0,0 +1,68 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_JUMP_THREADING_PASS_H_
+#define SOURCE_OPT_JUMP_THREADING_PASS_H_
+
+#include <cstdint>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class JumpThreadingPass : public Pass {
+ public:
+  const char* name() const override { return "jump-threading"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisDecorations | IRContext::kAnalysisNameMap |
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes |
+           IRContext::kAnalysisReflection | IRContext::kAnalysisCallGraph;
+  }
+
+ private:
+  // Returns true if the boolean values |a| and |b| are known to be equal, or
+  // to be opposite, in which case |negated| is set.
+  bool AreEquivalentConditions(uint32_t a, uint32_t b, bool* negated);
+
+  // Returns the successor of the selection header |header| on the side given
+  // by |value|, if that successor is only reached from |header|.  Returns null
+  // otherwise.
+  BasicBlock* GetExclusiveSuccessor(BasicBlock* header, bool value);
+
+  // Replaces the conditions of the selections in |func| that are known from a
+  // dominating selection on the same condition.  Returns true if |func| was
+  // changed.
+  bool FoldKnownConditions(Function* func);
+
+  // Fuses the selection headed by |header| with the selection headed by its
+  // merge block, if they branch on the same condition.  Returns true if they
+  // were fused.
+  bool FuseWithNextSelection(Function* func, BasicBlock* header);
+
+  // Threads the branches of |func| once.  Returns true if |func| was changed.
+  bool ProcessFunction(Function* func);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_JUMP_THREADING_PASS_H_
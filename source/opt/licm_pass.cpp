@@ -85,7 +85,12 @@ Pass::Status LICMPass::AnalyseAndHoistFromBB(
   bool modified = false;
   std::function<bool(Instruction*)> hoist_inst =
       [this, &loop, &modified](Instruction* inst) {
-        if (loop->ShouldHoistInstruction(this->context(), inst)) {
+        // Loads are only hoisted from memory that the loop cannot modify.
+        const bool should_hoist =
+            inst->opcode() == SpvOpLoad
+                ? IsHoistableLoad(loop, inst)
+                : loop->ShouldHoistInstruction(this->context(), inst);
+        if (should_hoist) {
           if (!HoistInstruction(loop, inst)) {
             return false;
           }
@@ -118,6 +123,34 @@ bool LICMPass::IsImmediatelyContainedInLoop(Loop* loop, Function* f,
   return loop == (*loop_descriptor)[bb->id()];
 }
 
+bool LICMPass::IsHoistableLoad(Loop* loop, Instruction* inst) {
+  if (inst->opcode() != SpvOpLoad) return false;
+  const uint32_t kLoadMemoryAccessInIdx = 1;
+  if (inst->NumInOperands() > kLoadMemoryAccessInIdx &&
+      (inst->GetSingleWordInOperand(kLoadMemoryAccessInIdx) &
+       SpvMemoryAccessVolatileMask)) {
+    return false;
+  }
+  if (!loop->AreAllOperandsOutsideLoop(context(), inst) ||
+      !inst->IsReadOnlyLoad()) {
+    return false;
+  }
+
+  // Only accept addresses made of access chains with constant indices, which
+  // cannot go out of bounds when the load is executed speculatively.
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  Instruction* ptr = def_use_mgr->GetDef(inst->GetSingleWordInOperand(0));
+  while (ptr->opcode() == SpvOpAccessChain ||
+         ptr->opcode() == SpvOpInBoundsAccessChain) {
+    for (uint32_t i = 1; i < ptr->NumInOperands(); ++i) {
+      Instruction* index = def_use_mgr->GetDef(ptr->GetSingleWordInOperand(i));
+      if (index->opcode() != SpvOpConstant) return false;
+    }
+    ptr = def_use_mgr->GetDef(ptr->GetSingleWordInOperand(0));
+  }
+  return ptr->opcode() == SpvOpVariable;
+}
+
 bool LICMPass::HoistInstruction(Loop* loop, Instruction* inst) {
   // TODO(1841): Handle failure to create pre-header.
   BasicBlock* pre_header_bb = loop->GetOrCreatePreHeaderBlock();
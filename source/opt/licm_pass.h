@@ -61,6 +61,12 @@ class LICMPass : public Pass {
   // Returns true if |bb| is immediately contained in |loop|
   bool IsImmediatelyContainedInLoop(Loop* loop, Function* f, BasicBlock* bb);
 
+  // Returns true if |inst| is a load from read-only memory that can be hoisted
+  // out of |loop|: its address does not depend on the loop, it is not
+  // volatile, and the address is formed with constant indices only, so the
+  // load is safe to execute even on iterations that would not reach it.
+  bool IsHoistableLoad(Loop* loop, Instruction* inst);
+
   // Move the instruction to the preheader of |loop|.
   // This method will update the instruction to block mapping for the context
   bool HoistInstruction(Loop* loop, Instruction* inst);
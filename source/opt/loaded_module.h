@@ -0,0 +1,36 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_LOADED_MODULE_H_
+#define SOURCE_OPT_LOADED_MODULE_H_
+
+#include <memory>
+
+#include "source/opt/ir_context.h"
+#include "spirv-tools/optimizer.hpp"
+
+namespace spvtools {
+
+// The internal data of a |LoadedModule|, shared by the optimizer and the
+// linker, which both work on the module in place.
+struct LoadedModule::Impl {
+  spv_target_env env = SPV_ENV_UNIVERSAL_1_0;  // Environment of the module.
+  MessageConsumer consumer;  // Consumer of the messages about the module.
+  // The module, or nullptr if no module is loaded.
+  std::unique_ptr<opt::IRContext> context;
+};
+
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_LOADED_MODULE_H_
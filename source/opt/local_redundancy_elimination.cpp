@@ -14,39 +14,80 @@
 
 #include "source/opt/local_redundancy_elimination.h"
 
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "source/opt/value_number_table.h"
 
 namespace spvtools {
 namespace opt {
 
 Pass::Status LocalRedundancyEliminationPass::Process() {
-  bool modified = false;
-  ValueNumberTable vnTable(context());
+  // The table is kept up to date as redundant instructions are killed, so it
+  // is still valid after the pass.  Every function is numbered before the
+  // functions are examined, so that the examination only reads the table and
+  // does not build any analysis.
+  ValueNumberTable* vnTable = context()->GetValueNumberTable();
+  vnTable->NumberAllValues();
 
-  for (auto& func : *get_module()) {
-    for (auto& bb : func) {
+  IRContext::StagedProcessFunction pfn =
+      [this, vnTable](Function* func) -> std::function<bool()> {
+    std::vector<std::pair<Instruction*, uint32_t>> redundant;
+    for (auto& bb : *func) {
       // Keeps track of all ids that contain a given value number. We keep
       // track of multiple values because they could have the same value, but
       // different decorations.
       std::map<uint32_t, uint32_t> value_to_ids;
-      if (EliminateRedundanciesInBB(&bb, vnTable, &value_to_ids))
-        modified = true;
+      FindRedundanciesInBB(&bb, *vnTable, &value_to_ids, &redundant);
     }
-  }
+    if (redundant.empty()) {
+      return nullptr;
+    }
+    return [this, redundant]() {
+      for (const auto& inst_and_id : redundant) {
+        RemoveRedundantInstruction(inst_and_id.first, inst_and_id.second);
+      }
+      return true;
+    };
+  };
+
+  bool modified = context()->ProcessFunctionsInParallel(
+      pfn, IRContext::kAnalysisValueNumberTable);
   return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
 }
 
 bool LocalRedundancyEliminationPass::EliminateRedundanciesInBB(
     BasicBlock* block, const ValueNumberTable& vnTable,
     std::map<uint32_t, uint32_t>* value_to_ids) {
-  bool modified = false;
+  // Some instructions of |block| may not be numbered yet, e.g. if they were
+  // added after their function was numbered.  Numbering them in order gives
+  // them the value numbers they would get if they were numbered while looking
+  // for redundancies.
+  block->ForEachInst([&vnTable](Instruction* inst) {
+    if (inst->result_id() != 0) {
+      vnTable.GetValueNumber(inst);
+    }
+  });
+  std::vector<std::pair<Instruction*, uint32_t>> redundant;
+  FindRedundanciesInBB(block, vnTable, value_to_ids, &redundant);
+  for (const auto& inst_and_id : redundant) {
+    RemoveRedundantInstruction(inst_and_id.first, inst_and_id.second);
+  }
+  return !redundant.empty();
+}
 
-  auto func = [this, &vnTable, &modified, value_to_ids](Instruction* inst) {
+void LocalRedundancyEliminationPass::FindRedundanciesInBB(
+    BasicBlock* block, const ValueNumberTable& vnTable,
+    std::map<uint32_t, uint32_t>* value_to_ids,
+    std::vector<std::pair<Instruction*, uint32_t>>* redundant) {
+  auto func = [&vnTable, value_to_ids, redundant](Instruction* inst) {
     if (inst->result_id() == 0) {
       return;
     }
 
-    uint32_t value = vnTable.GetValueNumber(inst);
+    uint32_t value = vnTable.FindValueNumber(inst->result_id());
 
     if (value == 0) {
       return;
@@ -54,14 +95,17 @@ bool LocalRedundancyEliminationPass::EliminateRedundanciesInBB(
 
     auto candidate = value_to_ids->insert({value, inst->result_id()});
     if (!candidate.second) {
-      context()->KillNamesAndDecorates(inst);
-      context()->ReplaceAllUsesWith(inst->result_id(), candidate.first->second);
-      context()->KillInst(inst);
-      modified = true;
+      redundant->push_back({inst, candidate.first->second});
     }
   };
   block->ForEachInst(func);
-  return modified;
+}
+
+void LocalRedundancyEliminationPass::RemoveRedundantInstruction(
+    Instruction* inst, uint32_t replacement_id) {
+  context()->KillNamesAndDecorates(inst);
+  context()->ReplaceAllUsesWith(inst->result_id(), replacement_id);
+  context()->KillInst(inst);
 }
 }  // namespace opt
 }  // namespace spvtools
@@ -16,6 +16,8 @@
 #define SOURCE_OPT_LOCAL_REDUNDANCY_ELIMINATION_H_
 
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "source/opt/ir_context.h"
 #include "source/opt/pass.h"
@@ -36,21 +38,23 @@ class LocalRedundancyEliminationPass : public Pass {
   const char* name() const override { return "local-redundancy-elimination"; }
   Status Process() override;
 
+  bool ProcessesFunctionsInParallel() const override { return true; }
+
   IRContext::Analysis GetPreservedAnalyses() override {
     return IRContext::kAnalysisDefUse |
            IRContext::kAnalysisInstrToBlockMapping |
            IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
            IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
            IRContext::kAnalysisNameMap | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisValueNumberTable |
+           IRContext::kAnalysisReflection | IRContext::kAnalysisCallGraph;
   }
 
  protected:
   // Deletes instructions in |block| whose value is in |value_to_ids| or is
   // computed earlier in |block|.
   //
-  // |vnTable| must have computed a value number for every result id defined
-  // in |bb|.
+  // |vnTable| gives the value number of the result ids defined in |block|.
   //
   // |value_to_ids| is a map from value number to ids.  If {vn, id} is in
   // |value_to_ids| then vn is the value number of id, and the definition of id
@@ -60,6 +64,21 @@ class LocalRedundancyEliminationPass : public Pass {
   bool EliminateRedundanciesInBB(BasicBlock* block,
                                  const ValueNumberTable& vnTable,
                                  std::map<uint32_t, uint32_t>* value_to_ids);
+
+  // Appends to |redundant| the instructions that |EliminateRedundanciesInBB|
+  // deletes from |block|, each with the id that replaces its result, without
+  // changing the module.  The parameters are the same as for
+  // |EliminateRedundanciesInBB|, except that |vnTable| must already number the
+  // instructions of |block|: it is only read, and instructions without a value
+  // number, such as the label, are skipped.
+  void FindRedundanciesInBB(
+      BasicBlock* block, const ValueNumberTable& vnTable,
+      std::map<uint32_t, uint32_t>* value_to_ids,
+      std::vector<std::pair<Instruction*, uint32_t>>* redundant);
+
+  // Replaces the uses of the result of |inst| by |replacement_id|, and kills
+  // |inst|.
+  void RemoveRedundantInstruction(Instruction* inst, uint32_t replacement_id);
 };
 
 }  // namespace opt
@@ -93,6 +93,9 @@ template <typename... Args>
 void Logf(const MessageConsumer& consumer, spv_message_level_t level,
           const char* source, const spv_position_t& position,
           const char* format, Args&&... args) {
+  // Do not format a message that nobody receives.
+  if (consumer == nullptr) return;
+
 #if defined(_MSC_VER) && _MSC_VER < 1900
 // Sadly, snprintf() is not supported until Visual Studio 2015!
 #define snprintf _snprintf
@@ -274,10 +274,8 @@ bool LoopDependenceAnalysis::GetDependence(const Instruction* source,
     auto source_subscript = std::get<0>(*(*it).begin());
     auto destination_subscript = std::get<1>(*(*it).begin());
 
-    SENode* source_node = scalar_evolution_.SimplifyExpression(
-        scalar_evolution_.AnalyzeInstruction(source_subscript));
-    SENode* destination_node = scalar_evolution_.SimplifyExpression(
-        scalar_evolution_.AnalyzeInstruction(destination_subscript));
+    SENode* source_node = GetSubscriptNode(source_subscript);
+    SENode* destination_node = GetSubscriptNode(destination_subscript);
 
     // Check the loops are in a form we support.
     auto subscript_pair = std::make_pair(source_node, destination_node);
@@ -356,10 +354,8 @@ bool LoopDependenceAnalysis::GetDependence(const Instruction* source,
       auto source_subscript = std::get<0>(elem);
       auto destination_subscript = std::get<1>(elem);
 
-      SENode* source_node = scalar_evolution_.SimplifyExpression(
-          scalar_evolution_.AnalyzeInstruction(source_subscript));
-      SENode* destination_node = scalar_evolution_.SimplifyExpression(
-          scalar_evolution_.AnalyzeInstruction(destination_subscript));
+      SENode* source_node = GetSubscriptNode(source_subscript);
+      SENode* destination_node = GetSubscriptNode(destination_subscript);
 
       coupled_subscripts.push_back({source_node, destination_node});
     }
@@ -23,6 +23,7 @@
 #include <ostream>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -417,6 +418,11 @@ class LoopDependenceAnalysis {
   // access defined by the access chain |instruction|.
   std::vector<Instruction*> GetSubscripts(const Instruction* instruction);
 
+  // Returns the simplified scalar evolution of the subscript |subscript|.  The
+  // result is computed once per subscript, as every pair of accesses tested
+  // needs it.
+  SENode* GetSubscriptNode(Instruction* subscript);
+
   // Delta test as described in Figure 3 of 'Practical Dependence
   // Testing' by Gina Goff, Ken Kennedy, and Chau-Wen Tseng from PLDI '91.
   bool DeltaTest(
@@ -463,6 +469,12 @@ class LoopDependenceAnalysis {
   // Stores all the constraints created by the analysis.
   std::list<std::unique_ptr<Constraint>> constraints_;
 
+  // The simplified scalar evolution of each subscript analysed so far.
+  std::unordered_map<const Instruction*, SENode*> subscript_nodes_;
+
+  // Whether each loop tested so far is supported by the analysis.
+  std::unordered_map<const Loop*, bool> supported_loops_;
+
   // Returns true if independence can be proven and false if it can't be proven.
   bool ZIVTest(const std::pair<SENode*, SENode*>& subscript_pair);
 
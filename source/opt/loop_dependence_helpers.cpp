@@ -424,8 +424,7 @@ void LoopDependenceAnalysis::MarkUnsusedDistanceEntriesAsIrrelevant(
   std::set<const Loop*> used_loops{};
 
   for (Instruction* source_inst : source_subscripts) {
-    SENode* source_node = scalar_evolution_.SimplifyExpression(
-        scalar_evolution_.AnalyzeInstruction(source_inst));
+    SENode* source_node = GetSubscriptNode(source_inst);
     std::vector<SERecurrentNode*> recurrent_nodes =
         source_node->CollectRecurrentNodes();
     for (SERecurrentNode* recurrent_node : recurrent_nodes) {
@@ -434,8 +433,7 @@ void LoopDependenceAnalysis::MarkUnsusedDistanceEntriesAsIrrelevant(
   }
 
   for (Instruction* destination_inst : destination_subscripts) {
-    SENode* destination_node = scalar_evolution_.SimplifyExpression(
-        scalar_evolution_.AnalyzeInstruction(destination_inst));
+    SENode* destination_node = GetSubscriptNode(destination_inst);
     std::vector<SERecurrentNode*> recurrent_nodes =
         destination_node->CollectRecurrentNodes();
     for (SERecurrentNode* recurrent_node : recurrent_nodes) {
@@ -452,27 +450,34 @@ void LoopDependenceAnalysis::MarkUnsusedDistanceEntriesAsIrrelevant(
 }
 
 bool LoopDependenceAnalysis::IsSupportedLoop(const Loop* loop) {
+  auto cached = supported_loops_.find(loop);
+  if (cached != supported_loops_.end()) return cached->second;
+
+  bool supported = false;
   std::vector<Instruction*> inductions{};
   loop->GetInductionVariables(inductions);
-  if (inductions.size() != 1) {
-    return false;
-  }
-  Instruction* induction = inductions[0];
-  SENode* induction_node = scalar_evolution_.SimplifyExpression(
-      scalar_evolution_.AnalyzeInstruction(induction));
-  if (!induction_node->AsSERecurrentNode()) {
-    return false;
-  }
-  SENode* induction_step =
-      induction_node->AsSERecurrentNode()->GetCoefficient();
-  if (!induction_step->AsSEConstantNode()) {
-    return false;
-  }
-  if (!(induction_step->AsSEConstantNode()->FoldToSingleValue() == 1 ||
-        induction_step->AsSEConstantNode()->FoldToSingleValue() == -1)) {
-    return false;
-  }
-  return true;
+  if (inductions.size() == 1) {
+    SENode* induction_node = scalar_evolution_.SimplifyExpression(
+        scalar_evolution_.AnalyzeInstruction(inductions[0]));
+    SERecurrentNode* recurrent = induction_node->AsSERecurrentNode();
+    SEConstantNode* induction_step =
+        recurrent ? recurrent->GetCoefficient()->AsSEConstantNode() : nullptr;
+    supported = induction_step &&
+                (induction_step->FoldToSingleValue() == 1 ||
+                 induction_step->FoldToSingleValue() == -1);
+  }
+  supported_loops_[loop] = supported;
+  return supported;
+}
+
+SENode* LoopDependenceAnalysis::GetSubscriptNode(Instruction* subscript) {
+  auto cached = subscript_nodes_.find(subscript);
+  if (cached != subscript_nodes_.end()) return cached->second;
+
+  SENode* node = scalar_evolution_.SimplifyExpression(
+      scalar_evolution_.AnalyzeInstruction(subscript));
+  subscript_nodes_[subscript] = node;
+  return node;
 }
 
 void LoopDependenceAnalysis::PrintDebug(std::string debug_msg) {
@@ -286,6 +286,7 @@ BasicBlock* Loop::GetOrCreatePreHeaderBlock() {
 void Loop::SetContinueBlock(BasicBlock* continue_block) {
   assert(IsInsideLoop(continue_block));
   loop_continue_ = continue_block;
+  InvalidateTripCountInfo();
 }
 
 void Loop::SetLatchBlock(BasicBlock* latch) {
@@ -327,6 +328,7 @@ void Loop::SetPreHeaderBlock(BasicBlock* preheader) {
            "block");
   }
   loop_preheader_ = preheader;
+  InvalidateTripCountInfo();
 }
 
 BasicBlock* Loop::FindLatchBlock() {
@@ -517,10 +519,17 @@ LoopDescriptor::LoopDescriptor(IRContext* context, const Function* f)
 LoopDescriptor::~LoopDescriptor() { ClearLoops(); }
 
 void LoopDescriptor::PopulateList(IRContext* context, const Function* f) {
-  DominatorAnalysis* dom_analysis = context->GetDominatorAnalysis(f);
-
   ClearLoops();
 
+  // A function without loop headers has no loop, so there is no need to build
+  // its dominator tree. Most functions are in this case.
+  if (std::none_of(f->begin(), f->end(),
+                   [](const BasicBlock& bb) { return bb.IsLoopHeader(); })) {
+    return;
+  }
+
+  DominatorAnalysis* dom_analysis = context->GetDominatorAnalysis(f);
+
   // Post-order traversal of the dominator tree to find all the OpLoopMerge
   // instructions.
   DominatorTree& dom_tree = dom_analysis->GetDomTree();
@@ -855,8 +864,10 @@ void Loop::GetInductionVariables(
   }
 }
 
-Instruction* Loop::FindConditionVariable(
-    const BasicBlock* condition_block) const {
+Instruction* Loop::FindConditionVariable(const BasicBlock* condition_block,
+                                         size_t* iterations,
+                                         int64_t* step_amount,
+                                         int64_t* init_value) const {
   // Find the branch instruction.
   const Instruction& branch_inst = *condition_block->ctail();
 
@@ -912,7 +923,8 @@ Instruction* Loop::FindConditionVariable(
         return nullptr;
       }
 
-      if (!FindNumberOfIterations(variable_inst, &branch_inst, nullptr))
+      if (!FindNumberOfIterations(variable_inst, &branch_inst, iterations,
+                                  step_amount, init_value))
         return nullptr;
       induction = variable_inst;
     }
@@ -921,6 +933,22 @@ Instruction* Loop::FindConditionVariable(
   return induction;
 }
 
+const Loop::TripCountInfo& Loop::GetTripCountInfo() const {
+  if (trip_count_info_valid_) {
+    return trip_count_info_;
+  }
+  trip_count_info_ = TripCountInfo();
+  trip_count_info_valid_ = true;
+
+  trip_count_info_.condition_block = FindConditionBlock();
+  if (trip_count_info_.condition_block) {
+    trip_count_info_.induction = FindConditionVariable(
+        trip_count_info_.condition_block, &trip_count_info_.iterations,
+        &trip_count_info_.step, &trip_count_info_.init);
+  }
+  return trip_count_info_;
+}
+
 bool LoopDescriptor::CreatePreHeaderBlocksIfMissing() {
   auto modified = false;
 
@@ -46,6 +46,23 @@ class Loop {
   using const_iterator = ChildrenList::const_iterator;
   using BasicBlockListTy = std::unordered_set<uint32_t>;
 
+  // The exit condition of a loop and the number of times the loop runs, as
+  // found by |GetTripCountInfo|.
+  struct TripCountInfo {
+    // The block whose conditional branch exits the loop, as returned by
+    // |FindConditionBlock|.
+    BasicBlock* condition_block = nullptr;
+    // The induction variable tested by the exit condition, as returned by
+    // |FindConditionVariable|.  It is nullptr if there is no condition block or
+    // if the number of iterations is unknown.
+    Instruction* induction = nullptr;
+    // The number of iterations, and the step and initial value of |induction|.
+    // Only meaningful if |induction| is not nullptr.
+    size_t iterations = 0;
+    int64_t step = 0;
+    int64_t init = 0;
+  };
+
   explicit Loop(IRContext* context)
       : context_(context),
         loop_header_(nullptr),
@@ -71,7 +88,10 @@ class Loop {
   // OpLoopMerge instruction.
   inline BasicBlock* GetHeaderBlock() { return loop_header_; }
   inline const BasicBlock* GetHeaderBlock() const { return loop_header_; }
-  inline void SetHeaderBlock(BasicBlock* header) { loop_header_ = header; }
+  inline void SetHeaderBlock(BasicBlock* header) {
+    loop_header_ = header;
+    InvalidateTripCountInfo();
+  }
 
   // Updates the OpLoopMerge instruction to reflect the current state of the
   // loop.
@@ -207,6 +227,7 @@ class Loop {
   void AddBasicBlock(uint32_t id) {
     for (Loop* loop = this; loop != nullptr; loop = loop->parent_) {
       loop->loop_basic_blocks_.insert(id);
+      loop->InvalidateTripCountInfo();
     }
   }
 
@@ -216,13 +237,17 @@ class Loop {
   void RemoveBasicBlock(uint32_t bb_id) {
     for (Loop* loop = this; loop != nullptr; loop = loop->parent_) {
       loop->loop_basic_blocks_.erase(bb_id);
+      loop->InvalidateTripCountInfo();
     }
   }
 
   // Removes all the basic blocks from the set of basic blocks within the loop.
   // This does not affect any of the stored pointers to the header, preheader,
   // merge, or continue blocks.
-  void ClearBlocks() { loop_basic_blocks_.clear(); }
+  void ClearBlocks() {
+    loop_basic_blocks_.clear();
+    InvalidateTripCountInfo();
+  }
 
   // Adds the Basic Block |bb| this loop and its parents.
   void AddBasicBlockToLoop(const BasicBlock* bb) {
@@ -237,8 +262,26 @@ class Loop {
 
   // This function uses the |condition| to find the induction variable which is
   // used by the loop condition within the loop. This only works if the loop is
-  // bound by a single condition and single induction variable.
-  Instruction* FindConditionVariable(const BasicBlock* condition) const;
+  // bound by a single condition and single induction variable.  The number of
+  // iterations, the step value and the initial value of the induction variable
+  // are stored in the optional output parameters, as by
+  // |FindNumberOfIterations|.
+  Instruction* FindConditionVariable(const BasicBlock* condition,
+                                     size_t* iterations = nullptr,
+                                     int64_t* step_amount = nullptr,
+                                     int64_t* init_value = nullptr) const;
+
+  // Returns the condition block, the induction variable and the number of
+  // iterations of the loop.  They are computed on the first call, and kept
+  // until the blocks of the loop change or |InvalidateTripCountInfo| is
+  // called.
+  const TripCountInfo& GetTripCountInfo() const;
+
+  // Forgets the trip count computed by |GetTripCountInfo|.  Transformations
+  // that change the exit condition or the induction variables of the loop
+  // must call it, directly or through
+  // |IRContext::ForgetScalarEvolutionOfLoop|.
+  void InvalidateTripCountInfo() const { trip_count_info_valid_ = false; }
 
   // Returns the number of iterations within a loop when given the |induction|
   // variable and the loop |condition| check. It stores the found number of
@@ -391,9 +434,15 @@ class Loop {
 
   // Sets |latch| as the loop unique latch block. No checks are performed
   // here.
-  inline void SetLatchBlockImpl(BasicBlock* latch) { loop_latch_ = latch; }
+  inline void SetLatchBlockImpl(BasicBlock* latch) {
+    loop_latch_ = latch;
+    InvalidateTripCountInfo();
+  }
   // Sets |merge| as the loop merge block. No checks are performed here.
-  inline void SetMergeBlockImpl(BasicBlock* merge) { loop_merge_ = merge; }
+  inline void SetMergeBlockImpl(BasicBlock* merge) {
+    loop_merge_ = merge;
+    InvalidateTripCountInfo();
+  }
 
   // Each differnt loop |condition| affects how we calculate the number of
   // iterations using the |condition_value|, |init_value|, and |step_values| of
@@ -406,6 +455,10 @@ class Loop {
   // the iterators.
   bool loop_is_marked_for_removal_;
 
+  // The result of |GetTripCountInfo|, if |trip_count_info_valid_| is true.
+  mutable TripCountInfo trip_count_info_;
+  mutable bool trip_count_info_valid_ = false;
+
   // This is only to allow LoopDescriptor::placeholder_top_loop_ to add top
   // level loops as child.
   friend class LoopDescriptor;
@@ -418,8 +418,10 @@ Loop* LoopFissionImpl::SplitLoop() {
 }
 
 LoopFissionPass::LoopFissionPass(const size_t register_threshold_to_split,
-                                 bool split_multiple_times)
-    : split_multiple_times_(split_multiple_times) {
+                                 bool split_multiple_times,
+                                 bool estimate_register_pressure)
+    : split_multiple_times_(split_multiple_times),
+      estimate_register_pressure_(estimate_register_pressure) {
   // Split if the number of registers in the loop exceeds
   // |register_threshold_to_split|.
   split_criteria_ =
@@ -429,20 +431,24 @@ LoopFissionPass::LoopFissionPass(const size_t register_threshold_to_split,
       };
 }
 
-LoopFissionPass::LoopFissionPass() : split_multiple_times_(false) {
-  // Split by default.
-  split_criteria_ = [](const RegisterLiveness::RegionRegisterLiveness&) {
-    return true;
-  };
+LoopFissionPass::LoopFissionPass()
+    : split_multiple_times_(false), estimate_register_pressure_(false) {
+  // Split by default, leaving |split_criteria_| empty.
 }
 
 bool LoopFissionPass::ShouldSplitLoop(const Loop& loop, IRContext* c) {
-  LivenessAnalysis* analysis = c->GetLivenessAnalysis();
+  // Without a criteria there is no need for the register pressure.
+  if (!split_criteria_) return true;
 
   RegisterLiveness::RegionRegisterLiveness liveness{};
 
-  Function* function = loop.GetHeaderBlock()->GetParent();
-  analysis->Get(function)->ComputeLoopRegisterPressure(loop, &liveness);
+  if (estimate_register_pressure_) {
+    RegisterLiveness::EstimateLoopRegisterPressure(c, loop, &liveness);
+  } else {
+    LivenessAnalysis* analysis = c->GetLivenessAnalysis();
+    Function* function = loop.GetHeaderBlock()->GetParent();
+    analysis->Get(function)->ComputeLoopRegisterPressure(loop, &liveness);
+  }
 
   return split_criteria_(liveness);
 }
@@ -46,17 +46,27 @@ class LoopFissionPass : public Pass {
   // Split the loop if the number of registers used in the loop exceeds
   // |register_threshold_to_split|. |split_multiple_times| flag determines
   // whether or not the pass should split loops after already splitting them
-  // once.
+  // once. If |estimate_register_pressure| is true, the register pressure of a
+  // loop is estimated from the loop alone (see
+  // RegisterLiveness::EstimateLoopRegisterPressure) rather than taken from the
+  // liveness of the whole function.
   LoopFissionPass(size_t register_threshold_to_split,
-                  bool split_multiple_times = true);
+                  bool split_multiple_times = true,
+                  bool estimate_register_pressure = false);
 
   // Split loops whose register pressure meets the criteria of |functor|.
   LoopFissionPass(FissionCriteriaFunction functor,
-                  bool split_multiple_times = true)
-      : split_criteria_(functor), split_multiple_times_(split_multiple_times) {}
+                  bool split_multiple_times = true,
+                  bool estimate_register_pressure = false)
+      : split_criteria_(functor),
+        split_multiple_times_(split_multiple_times),
+        estimate_register_pressure_(estimate_register_pressure) {}
 
   const char* name() const override { return "loop-fission"; }
 
+  // The behavior of the pass depends on its arguments.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
   Pass::Status Process() override;
 
   // Checks if |loop| meets the register pressure criteria to be split.
@@ -64,12 +74,18 @@ class LoopFissionPass : public Pass {
 
  private:
   // Functor to run in ShouldSplitLoop to determine if the register pressure
-  // criteria is met for splitting the loop.
+  // criteria is met for splitting the loop. If empty, every loop is split and
+  // no register pressure is computed.
   FissionCriteriaFunction split_criteria_;
 
   // Flag designating whether or not we should also split the result of
   // previously split loops if they meet the register presure criteria.
   bool split_multiple_times_;
+
+  // Flag designating whether the register pressure handed to
+  // |split_criteria_| is estimated per loop instead of computed for the whole
+  // function.
+  bool estimate_register_pressure_;
 };
 
 }  // namespace opt
@@ -710,6 +710,8 @@ void LoopFusion::Fuse() {
 
   loop_1_->ClearBlocks();
 
+  context_->ForgetScalarEvolutionOfLoop(loop_0_);
+  context_->ForgetScalarEvolutionOfLoop(loop_1_);
   ld->RemoveLoop(loop_1_);
 
   // Kill unnessecary instructions and remove all empty blocks.
@@ -723,7 +725,8 @@ void LoopFusion::Fuse() {
   context_->InvalidateAnalysesExceptFor(
       IRContext::Analysis::kAnalysisInstrToBlockMapping |
       IRContext::Analysis::kAnalysisLoopAnalysis |
-      IRContext::Analysis::kAnalysisDefUse | IRContext::Analysis::kAnalysisCFG);
+      IRContext::Analysis::kAnalysisDefUse | IRContext::Analysis::kAnalysisCFG |
+      IRContext::Analysis::kAnalysisScalarEvolution);
 }
 
 }  // namespace opt
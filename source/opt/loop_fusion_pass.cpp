@@ -41,23 +41,16 @@ bool LoopFusionPass::ProcessFunction(Function* function) {
   // sure to return Status::SuccessWithChange in that case.
   auto modified = ld.CreatePreHeaderBlocksIfMissing();
 
-  // TODO(tremmelg): Could the only loop that |loop| could possibly be fused be
-  // picked out so don't have to check every loop
-  for (auto& loop_0 : ld) {
-    for (auto& loop_1 : ld) {
-      LoopFusion fusion(context(), &loop_0, &loop_1);
-
-      if (fusion.AreCompatible() && fusion.IsLegal()) {
-        RegisterLiveness liveness(context(), function);
-        RegisterLiveness::RegionRegisterLiveness reg_pressure{};
-        liveness.SimulateFusion(loop_0, loop_1, &reg_pressure);
-
-        if (reg_pressure.used_registers_ <= max_registers_per_loop_) {
-          fusion.Fuse();
-          // Recurse, as the current iterators will have been invalidated.
-          ProcessFunction(function);
-          return true;
-        }
+  // Fusion keeps the loop descriptor up to date, but removes a loop from it,
+  // so start over after each fusion.
+  bool fused = true;
+  while (fused) {
+    fused = false;
+    for (auto& loop_0 : ld) {
+      Loop* loop_1 = FindAdjacentLoop(ld, &loop_0);
+      if (loop_1 != nullptr && FuseIfProfitable(function, &loop_0, loop_1)) {
+        fused = modified = true;
+        break;
       }
     }
   }
@@ -65,5 +58,38 @@ bool LoopFusionPass::ProcessFunction(Function* function) {
   return modified;
 }
 
+Loop* LoopFusionPass::FindAdjacentLoop(const LoopDescriptor& ld, Loop* loop) {
+  // |LoopFusion::AreCompatible| allows at most one block between the merge
+  // block of |loop| and the pre-header of the next loop, so follow at most
+  // two unconditional branches looking for a loop header.
+  BasicBlock* block = loop->GetMergeBlock();
+  for (int i = 0; i < 2 && block != nullptr; ++i) {
+    const Instruction* branch = block->terminator();
+    if (branch->opcode() != SpvOpBranch) return nullptr;
+    uint32_t target_id = branch->GetSingleWordInOperand(0);
+    Loop* target_loop = ld[target_id];
+    if (target_loop != nullptr && target_loop != loop &&
+        target_loop->GetHeaderBlock()->id() == target_id) {
+      return target_loop;
+    }
+    block = context()->cfg()->block(target_id);
+  }
+  return nullptr;
+}
+
+bool LoopFusionPass::FuseIfProfitable(Function* function, Loop* loop_0,
+                                      Loop* loop_1) {
+  LoopFusion fusion(context(), loop_0, loop_1);
+  if (!fusion.AreCompatible() || !fusion.IsLegal()) return false;
+
+  RegisterLiveness liveness(context(), function);
+  RegisterLiveness::RegionRegisterLiveness reg_pressure{};
+  liveness.SimulateFusion(*loop_0, *loop_1, &reg_pressure);
+  if (reg_pressure.used_registers_ > max_registers_per_loop_) return false;
+
+  fusion.Fuse();
+  return true;
+}
+
 }  // namespace opt
 }  // namespace spvtools
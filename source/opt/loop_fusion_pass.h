@@ -15,6 +15,7 @@
 #ifndef SOURCE_OPT_LOOP_FUSION_PASS_H_
 #define SOURCE_OPT_LOOP_FUSION_PASS_H_
 
+#include "source/opt/loop_descriptor.h"
 #include "source/opt/pass.h"
 
 namespace spvtools {
@@ -31,6 +32,9 @@ class LoopFusionPass : public Pass {
 
   const char* name() const override { return "loop-fusion"; }
 
+  // The behavior of the pass depends on its arguments.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
   // Processes the given |module|. Returns Status::Failure if errors occur when
   // processing. Returns the corresponding Status::Success if processing is
   // succesful to indicate whether changes have been made to the modue.
@@ -41,6 +45,16 @@ class LoopFusionPass : public Pass {
   // too many registers.
   bool ProcessFunction(Function* function);
 
+  // Returns the loop that immediately follows |loop| in |ld| and could be
+  // fused with it, or nullptr if there is none. Only the loop whose header
+  // is reached from the merge block of |loop| can be adjacent to it.
+  Loop* FindAdjacentLoop(const LoopDescriptor& ld, Loop* loop);
+
+  // Fuses |loop_1| into |loop_0| in |function| if they are compatible, legal
+  // to fuse and the fused loop won't use too many registers. Returns true if
+  // the loops were fused.
+  bool FuseIfProfitable(Function* function, Loop* loop_0, Loop* loop_1);
+
   // The maximum number of registers a fused loop is allowed to use.
   size_t max_registers_per_loop_;
 };
@@ -468,9 +468,11 @@ void LoopPeeling::PeelBefore(uint32_t peel_factor) {
         context_->get_def_use_mgr()->AnalyzeInstUse(phi);
       });
 
+  context_->ForgetScalarEvolutionOfLoop(loop_);
   context_->InvalidateAnalysesExceptFor(
       IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping |
-      IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisCFG);
+      IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisCFG |
+      IRContext::kAnalysisScalarEvolution);
 }
 
 void LoopPeeling::PeelAfter(uint32_t peel_factor) {
@@ -560,9 +562,11 @@ void LoopPeeling::PeelAfter(uint32_t peel_factor) {
         def_use_mgr->AnalyzeInstUse(phi);
       });
 
+  context_->ForgetScalarEvolutionOfLoop(loop_);
   context_->InvalidateAnalysesExceptFor(
       IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping |
-      IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisCFG);
+      IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisCFG |
+      IRContext::kAnalysisScalarEvolution);
 }
 
 Pass::Status LoopPeelingPass::Process() {
@@ -629,23 +633,12 @@ std::pair<bool, Loop*> LoopPeelingPass::ProcessLoop(Loop* loop,
   // Default values for bailing out.
   std::pair<bool, Loop*> bail_out{false, nullptr};
 
-  BasicBlock* exit_block = loop->FindConditionBlock();
-  if (!exit_block) {
-    return bail_out;
-  }
-
-  Instruction* exiting_iv = loop->FindConditionVariable(exit_block);
-  if (!exiting_iv) {
-    return bail_out;
-  }
-  size_t iterations = 0;
-  if (!loop->FindNumberOfIterations(exiting_iv, &*exit_block->tail(),
-                                    &iterations)) {
-    return bail_out;
-  }
-  if (!iterations) {
+  const Loop::TripCountInfo& trip_count = loop->GetTripCountInfo();
+  if (!trip_count.induction || !trip_count.iterations) {
     return bail_out;
   }
+  BasicBlock* exit_block = trip_count.condition_block;
+  size_t iterations = trip_count.iterations;
 
   Instruction* canonical_induction_variable = nullptr;
 
@@ -14,6 +14,8 @@
 
 #include "source/opt/loop_unroller.h"
 
+#include <algorithm>
+#include <iterator>
 #include <limits>
 #include <map>
 #include <memory>
@@ -23,6 +25,7 @@
 
 #include "source/opt/ir_builder.h"
 #include "source/opt/loop_utils.h"
+#include "source/opt/register_pressure.h"
 
 // Implements loop util unrolling functionality for fully and partially
 // unrolling loops. Given a factor it will duplicate the loop that many times,
@@ -73,6 +76,13 @@ static const uint32_t kLoopControlDontUnrollIndex = 2;
 // Operand index of the loop control parameter of the OpLoopMerge.
 static const uint32_t kLoopControlIndex = 2;
 
+// The largest unroll factor the heuristic mode uses for partial unrolling.
+static const size_t kMaxHeuristicUnrollFactor = 8;
+
+// The largest number of instructions in the body of a loop unrolled by the
+// heuristic mode.
+static const size_t kMaxUnrolledLoopSize = 256;
+
 // This utility class encapsulates some of the state we need to maintain between
 // loop unrolls. Specifically it maintains key blocks and the induction variable
 // in the current loop duplication step and the blocks from the previous one.
@@ -348,25 +358,28 @@ static uint32_t GetPhiIndexFromLabel(const BasicBlock* block,
 }
 
 void LoopUnrollerUtilsImpl::Init(Loop* loop) {
-  loop_condition_block_ = loop->FindConditionBlock();
-
-  // When we reinit the second loop during PartiallyUnrollResidualFactor we need
-  // to use the cached value from the duplicate step as the dominator tree
-  // basded solution, loop->FindConditionBlock, requires all the nodes to be
-  // connected up with the correct branches. They won't be at this point.
-  if (!loop_condition_block_) {
+  // Reuse the trip count found by LoopUtils::CanPerformUnroll.
+  const Loop::TripCountInfo& trip_count = loop->GetTripCountInfo();
+  if (trip_count.induction) {
+    loop_condition_block_ = trip_count.condition_block;
+    loop_induction_variable_ = trip_count.induction;
+    number_of_loop_iterations_ = trip_count.iterations;
+    loop_step_value_ = trip_count.step;
+    loop_init_value_ = trip_count.init;
+  } else {
+    // When we reinit the second loop during PartiallyUnrollResidualFactor we
+    // need to use the cached value from the duplicate step as the dominator
+    // tree basded solution, loop->FindConditionBlock, requires all the nodes
+    // to be connected up with the correct branches. They won't be at this
+    // point.
     loop_condition_block_ = state_.new_condition_block;
-  }
-  assert(loop_condition_block_);
-
-  loop_induction_variable_ = loop->FindConditionVariable(loop_condition_block_);
-  assert(loop_induction_variable_);
+    assert(loop_condition_block_);
 
-  bool found = loop->FindNumberOfIterations(
-      loop_induction_variable_, &*loop_condition_block_->ctail(),
-      &number_of_loop_iterations_, &loop_step_value_, &loop_init_value_);
-  (void)found;  // To silence unused variable warning on release builds.
-  assert(found);
+    loop_induction_variable_ = loop->FindConditionVariable(
+        loop_condition_block_, &number_of_loop_iterations_, &loop_step_value_,
+        &loop_init_value_);
+    assert(loop_induction_variable_);
+  }
 
   // Blocks are stored in an unordered set of ids in the loop class, we need to
   // create the dominator ordered list.
@@ -431,8 +444,10 @@ void LoopUnrollerUtilsImpl::PartiallyUnrollResidualFactor(Loop* loop,
   AddBlocksToFunction(loop->GetMergeBlock());
 
   // Reset the usedef analysis.
+  context_->ForgetScalarEvolutionOfLoop(loop);
   context_->InvalidateAnalysesExceptFor(
-      IRContext::Analysis::kAnalysisLoopAnalysis);
+      IRContext::Analysis::kAnalysisLoopAnalysis |
+      IRContext::Analysis::kAnalysisScalarEvolution);
   analysis::DefUseManager* def_use_manager = context_->get_def_use_mgr();
 
   // The loop condition.
@@ -503,8 +518,10 @@ void LoopUnrollerUtilsImpl::PartiallyUnrollResidualFactor(Loop* loop,
                                             replace_use_outside_of_loop);
   }
 
+  context_->ForgetScalarEvolutionOfLoop(loop);
   context_->InvalidateAnalysesExceptFor(
-      IRContext::Analysis::kAnalysisLoopAnalysis);
+      IRContext::Analysis::kAnalysisLoopAnalysis |
+      IRContext::Analysis::kAnalysisScalarEvolution);
 
   context_->ReplaceAllUsesWith(loop->GetMergeBlock()->id(), new_merge_id);
 
@@ -552,10 +569,12 @@ void LoopUnrollerUtilsImpl::RemoveDeadInstructions() {
 }
 
 void LoopUnrollerUtilsImpl::ReplaceInductionUseWithFinalValue(Loop* loop) {
+  context_->ForgetScalarEvolutionOfLoop(loop);
   context_->InvalidateAnalysesExceptFor(
       IRContext::Analysis::kAnalysisLoopAnalysis |
       IRContext::Analysis::kAnalysisDefUse |
-      IRContext::Analysis::kAnalysisInstrToBlockMapping);
+      IRContext::Analysis::kAnalysisInstrToBlockMapping |
+      IRContext::Analysis::kAnalysisScalarEvolution);
 
   std::vector<Instruction*> inductions;
   loop->GetInductionVariables(inductions);
@@ -596,9 +615,11 @@ void LoopUnrollerUtilsImpl::FullyUnroll(Loop* loop) {
 
   RemoveDeadInstructions();
   // Invalidate all analyses.
+  context_->ForgetScalarEvolutionOfLoop(loop);
   context_->InvalidateAnalysesExceptFor(
       IRContext::Analysis::kAnalysisLoopAnalysis |
-      IRContext::Analysis::kAnalysisDefUse);
+      IRContext::Analysis::kAnalysisDefUse |
+      IRContext::Analysis::kAnalysisScalarEvolution);
 }
 
 void LoopUnrollerUtilsImpl::KillDebugDeclares(BasicBlock* bb) {
@@ -750,7 +771,7 @@ void LoopUnrollerUtilsImpl::FoldConditionBlock(BasicBlock* condition_block,
   uint32_t new_target = old_branch.GetSingleWordOperand(operand_label);
 
   DebugScope scope = old_branch.GetDebugScope();
-  const std::vector<Instruction> lines = old_branch.dbg_line_insts();
+  const std::vector<DebugLine> lines = old_branch.dbg_lines();
 
   context_->KillInst(&old_branch);
   // Add the new unconditional branch to the merge block.
@@ -760,7 +781,7 @@ void LoopUnrollerUtilsImpl::FoldConditionBlock(BasicBlock* condition_block,
           IRContext::Analysis::kAnalysisInstrToBlockMapping);
   Instruction* new_branch = builder.AddBranch(new_target);
 
-  new_branch->set_dbg_line_insts(lines);
+  new_branch->set_dbg_lines(lines);
   new_branch->SetDebugScope(scope);
 }
 
@@ -957,6 +978,7 @@ void LoopUnrollerUtilsImpl::PartiallyUnroll(Loop* loop, size_t factor) {
   AddBlocksToLoop(loop);
   AddBlocksToFunction(loop->GetMergeBlock());
   RemoveDeadInstructions();
+  loop->InvalidateTripCountInfo();
 }
 
 /*
@@ -977,18 +999,12 @@ bool LoopUtils::CanPerformUnroll() {
     return false;
   }
 
-  // Find check the loop has a condition we can find and evaluate.
-  const BasicBlock* condition = loop_->FindConditionBlock();
-  if (!condition) return false;
-
-  // Check that we can find and process the induction variable.
-  const Instruction* induction = loop_->FindConditionVariable(condition);
+  // Check the loop has a condition we can find and evaluate, that we can find
+  // and process the induction variable, and that we can find the number of
+  // loop iterations.
+  const Instruction* induction = loop_->GetTripCountInfo().induction;
   if (!induction || induction->opcode() != SpvOpPhi) return false;
 
-  // Check that we can find the number of loop iterations.
-  if (!loop_->FindNumberOfIterations(induction, &*condition->ctail(), nullptr))
-    return false;
-
   // Make sure the latch block is a unconditional branch to the header
   // block.
   const Instruction& branch = *loop_->GetLatchBlock()->ctail();
@@ -1092,12 +1108,90 @@ void LoopUtils::Finalize() {
  *
  */
 
+size_t LoopUnroller::ChooseUnrollFactor(const Loop& loop) {
+  // Do not spend the budget on a loop that never ran in the profile.
+  if (context()->IsColdBlock(loop.GetHeaderBlock())) return 1;
+
+  const Loop::TripCountInfo& trip_count_info = loop.GetTripCountInfo();
+  if (!trip_count_info.induction || trip_count_info.iterations < 2) {
+    return 1;
+  }
+  const size_t trip_count = trip_count_info.iterations;
+
+  size_t body_size = 0;
+  for (uint32_t label_id : loop.GetBlocks()) {
+    const BasicBlock* bb = context()->cfg()->block(label_id);
+    body_size += std::distance(bb->begin(), bb->end());
+  }
+
+  // The values live into the loop are shared by the copies of the body, and
+  // the others are counted once per copy, as if the copies were interleaved.
+  RegisterLiveness::RegionRegisterLiveness liveness;
+  RegisterLiveness::EstimateLoopRegisterPressure(context(), loop, &liveness);
+  const size_t shared_registers =
+      std::min(liveness.live_in_.size(), liveness.used_registers_);
+  const size_t copied_registers = liveness.used_registers_ - shared_registers;
+
+  // Try a full unroll first, then decreasing partial factors.  A partial
+  // factor that does not divide the trip count needs a copy of the loop for
+  // the remaining iterations.
+  for (size_t factor = trip_count; factor > 1;
+       factor = (factor == trip_count)
+                    ? std::min(trip_count - 1, kMaxHeuristicUnrollFactor)
+                    : factor / 2) {
+    if (factor * body_size > kMaxUnrolledLoopSize) continue;
+    if (shared_registers + factor * copied_registers >
+        heuristics_.max_register_pressure) {
+      continue;
+    }
+    const size_t copies =
+        (factor == trip_count || trip_count % factor == 0) ? factor - 1
+                                                           : factor;
+    const uint64_t growth = copies * body_size;
+    if (growth > remaining_budget_) continue;
+    // Each copied instruction and label may need a new id.
+    if (growth + copies * loop.GetBlocks().size() >
+        context()->NumIdsRemaining()) {
+      continue;
+    }
+    remaining_budget_ -= growth;
+    return factor;
+  }
+  return 1;
+}
+
 Pass::Status LoopUnroller::Process() {
+  if (use_heuristics_) {
+    uint64_t module_size = 0;
+    for (Function& f : *context()->module()) {
+      for (BasicBlock& bb : f) {
+        module_size += std::distance(bb.begin(), bb.end());
+      }
+    }
+    remaining_budget_ = module_size * heuristics_.growth_budget_percent / 100;
+  }
+
   bool changed = false;
   for (Function& f : *context()->module()) {
     LoopDescriptor* LD = context()->GetLoopDescriptor(&f);
     for (Loop& loop : *LD) {
       LoopUtils loop_utils{context(), &loop};
+      if (use_heuristics_) {
+        const Instruction* merge_inst =
+            loop.GetHeaderBlock()->GetLoopMergeInst();
+        if (!merge_inst ||
+            (merge_inst->GetSingleWordInOperand(kLoopControlIndex) &
+             SpvLoopControlDontUnrollMask) ||
+            !loop_utils.CanPerformUnroll()) {
+          continue;
+        }
+        const size_t factor = ChooseUnrollFactor(loop);
+        if (factor == 1) continue;
+        loop_utils.PartiallyUnroll(factor);
+        changed = true;
+        continue;
+      }
+
       if (!loop.HasUnrollLoopControl() || !loop_utils.CanPerformUnroll()) {
         continue;
       }
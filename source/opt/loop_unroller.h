@@ -15,6 +15,9 @@
 #ifndef SOURCE_OPT_LOOP_UNROLLER_H_
 #define SOURCE_OPT_LOOP_UNROLLER_H_
 
+#include <cstdint>
+
+#include "source/opt/loop_descriptor.h"
 #include "source/opt/pass.h"
 
 namespace spvtools {
@@ -22,12 +25,46 @@ namespace opt {
 
 class LoopUnroller : public Pass {
  public:
-  LoopUnroller() : Pass(), fully_unroll_(true), unroll_factor_(0) {}
+  // The limits within which the heuristic mode chooses the unroll factor of
+  // each loop.
+  struct Heuristics {
+    // The number of instructions that unrolling may add to the module, as a
+    // percentage of the size of its functions.
+    uint32_t growth_budget_percent;
+    // The largest estimated register pressure of an unrolled loop.
+    uint32_t max_register_pressure;
+  };
+
+  LoopUnroller()
+      : Pass(),
+        fully_unroll_(true),
+        unroll_factor_(0),
+        use_heuristics_(false),
+        heuristics_(),
+        remaining_budget_(0) {}
   LoopUnroller(bool fully_unroll, int unroll_factor)
-      : Pass(), fully_unroll_(fully_unroll), unroll_factor_(unroll_factor) {}
+      : Pass(),
+        fully_unroll_(fully_unroll),
+        unroll_factor_(unroll_factor),
+        use_heuristics_(false),
+        heuristics_(),
+        remaining_budget_(0) {}
+  // Unrolls every loop that is not marked DontUnroll by a factor chosen from
+  // the size of its body, its trip count and its estimated register pressure,
+  // within the limits of |heuristics|.
+  explicit LoopUnroller(const Heuristics& heuristics)
+      : Pass(),
+        fully_unroll_(false),
+        unroll_factor_(0),
+        use_heuristics_(true),
+        heuristics_(heuristics),
+        remaining_budget_(0) {}
 
   const char* name() const override { return "loop-unroll"; }
 
+  // The behavior of the pass depends on its arguments.
+  bool CanSkipIfModuleUnchanged() const override { return false; }
+
   Status Process() override;
 
   IRContext::Analysis GetPreservedAnalyses() override {
@@ -39,8 +76,19 @@ class LoopUnroller : public Pass {
   }
 
  private:
+  // Returns the factor by which the heuristic mode unrolls |loop|, which must
+  // pass |LoopUtils::CanPerformUnroll|, and charges the code it adds to
+  // |remaining_budget_|.  A factor of at least the trip count means that
+  // |loop| is fully unrolled.  Returns 1 if |loop| is left as it is, which
+  // is always the case if its header never executed in the profile.
+  size_t ChooseUnrollFactor(const Loop& loop);
+
   bool fully_unroll_;
   int unroll_factor_;
+  bool use_heuristics_;
+  Heuristics heuristics_;
+  // The number of instructions the heuristic mode may still add.
+  uint64_t remaining_budget_;
 };
 
 }  // namespace opt
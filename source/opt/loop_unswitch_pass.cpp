@@ -88,6 +88,27 @@ class LoopUnswitch {
     return switch_block_;
   }
 
+  // Returns the number of instructions unswitching |loop_| adds to the
+  // function: the loop is cloned once for each value of the condition except
+  // the one the original loop is specialized for.
+  size_t GetCodeGrowth() {
+    assert(CanUnswitchLoop() &&
+           "Cannot unswitch if there is not constant condition");
+    const Instruction* iv_condition = switch_block_->terminator();
+    size_t num_clones = 1;
+    if (iv_condition->opcode() == SpvOpSwitch) {
+      num_clones = (iv_condition->NumInOperands() - 2) / 2;
+    }
+
+    CFG& cfg = *context_->cfg();
+    size_t loop_size = 0;
+    for (uint32_t bb_id : loop_->GetBlocks()) {
+      cfg.block(bb_id)->ForEachInst(
+          [&loop_size](const Instruction*) { ++loop_size; });
+    }
+    return num_clones * loop_size;
+  }
+
   // Return the iterator to the basic block |bb|.
   Function::iterator FindBasicBlockPosition(BasicBlock* bb_to_find) {
     Function::iterator it = function_->FindBlock(bb_to_find->id());
@@ -591,6 +612,12 @@ bool LoopUnswitchPass::ProcessFunction(Function* f) {
 
   LoopDescriptor& loop_descriptor = *context()->GetLoopDescriptor(f);
 
+  // Each unswitch clones a loop, and the clones keep the other invariant
+  // conditions, so the growth of the function has to be bounded.
+  size_t function_size = 0;
+  f->ForEachInst([&function_size](const Instruction*) { ++function_size; });
+  const size_t max_function_size = kMaxGrowthFactor * function_size;
+
   bool loop_changed = true;
   while (loop_changed) {
     loop_changed = false;
@@ -602,6 +629,9 @@ bool LoopUnswitchPass::ProcessFunction(Function* f) {
 
       LoopUnswitch unswitcher(context(), f, &loop, &loop_descriptor);
       while (unswitcher.CanUnswitchLoop()) {
+        size_t code_growth = unswitcher.GetCodeGrowth();
+        if (function_size + code_growth > max_function_size) break;
+        function_size += code_growth;
         if (!loop.IsLCSSA()) {
           LoopUtils(context(), &loop).MakeLoopClosedSSA();
         }
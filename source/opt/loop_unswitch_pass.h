@@ -23,7 +23,9 @@ namespace opt {
 
 // Implements the loop unswitch optimization.
 // The loop unswitch hoists invariant "if" statements if the conditions are
-// constant within the loop and clones the loop for each branch.
+// constant within the loop and clones the loop for each branch. Loops are no
+// longer unswitched once that would make a function more than
+// |kMaxGrowthFactor| times its original size.
 class LoopUnswitchPass : public Pass {
  public:
   const char* name() const override { return "loop-unswitch"; }
@@ -34,6 +36,10 @@ class LoopUnswitchPass : public Pass {
   Pass::Status Process() override;
 
  private:
+  // The maximum size of a function after unswitching, relative to its size
+  // before.
+  static constexpr size_t kMaxGrowthFactor = 4;
+
   bool ProcessFunction(Function* f);
 };
 
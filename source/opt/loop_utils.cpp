@@ -557,14 +557,27 @@ Loop* LoopUtils::CloneLoop(
 
   CFG& cfg = *context_->cfg();
 
+  // Take the ids of all of the clones at once.
+  uint32_t num_ids = 0;
+  for (BasicBlock* old_bb : ordered_loop_blocks) {
+    ++num_ids;
+    for (const Instruction& old_inst : *old_bb) {
+      if (old_inst.HasResultId()) ++num_ids;
+    }
+  }
+  // TODO(1841): Handle id overflow.
+  uint32_t next_id = num_ids ? context_->TakeNextIdRange(num_ids) : 0;
+  auto take_id = [&next_id]() { return next_id == 0 ? 0 : next_id++; };
+  // Every block and every result id of the loop gets one entry.
+  cloning_result->value_map_.reserve(num_ids);
+
   // Clone and place blocks in a SPIR-V compliant order (dominators first).
   for (BasicBlock* old_bb : ordered_loop_blocks) {
     // For each basic block in the loop, we clone it and register the mapping
     // between old and new ids.
     BasicBlock* new_bb = old_bb->Clone(context_);
     new_bb->SetParent(&function_);
-    // TODO(1841): Handle id overflow.
-    new_bb->GetLabelInst()->SetResultId(context_->TakeNextId());
+    new_bb->GetLabelInst()->SetResultId(take_id());
     def_use_mgr->AnalyzeInstDef(new_bb->GetLabelInst());
     context_->set_instr_block(new_bb->GetLabelInst(), new_bb);
     cloning_result->cloned_bb_.emplace_back(new_bb);
@@ -579,8 +592,7 @@ Loop* LoopUtils::CloneLoop(
          new_inst != new_bb->end(); ++new_inst, ++old_inst) {
       cloning_result->ptr_map_[&*new_inst] = &*old_inst;
       if (new_inst->HasResultId()) {
-        // TODO(1841): Handle id overflow.
-        new_inst->SetResultId(context_->TakeNextId());
+        new_inst->SetResultId(take_id());
         cloning_result->value_map_[old_inst->result_id()] =
             new_inst->result_id();
 
@@ -22,6 +22,7 @@
 
 #include "source/opt/ir_context.h"
 #include "source/opt/loop_descriptor.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 
@@ -47,7 +48,7 @@ class LoopUtils {
  public:
   // Holds a auxiliary results of the loop cloning procedure.
   struct LoopCloningResult {
-    using ValueMapTy = std::unordered_map<uint32_t, uint32_t>;
+    using ValueMapTy = utils::IdMap<uint32_t>;
     using BlockMapTy = std::unordered_map<uint32_t, BasicBlock*>;
     using PtrMap = std::unordered_map<Instruction*, Instruction*>;
 
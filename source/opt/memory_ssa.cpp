@@ -0,0 +1,502 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/memory_ssa.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "source/opcode.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kLoadPointerInIdx = 0;
+const uint32_t kStorePointerInIdx = 0;
+const uint32_t kCopyMemoryTargetInIdx = 0;
+const uint32_t kCopyMemorySourceInIdx = 1;
+const uint32_t kAtomicPointerInIdx = 0;
+const uint32_t kVariableStorageClassInIdx = 0;
+const uint32_t kVariableInitializerInIdx = 1;
+const uint32_t kAccessChainPtrInIdx = 0;
+const uint32_t kCopyObjectOperandInIdx = 0;
+const uint32_t kTypePointerStorageClassInIdx = 0;
+
+// Returns true if |inst| may write any memory.
+bool IsOpaqueDef(const Instruction& inst) {
+  switch (inst.opcode()) {
+    case SpvOpFunctionCall:
+    case SpvOpControlBarrier:
+    case SpvOpMemoryBarrier:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Compares the indices |a| and |b|.  Returns 1 if they are scalar constants
+// of the same width holding different values, -1 if they are the same id or
+// hold the same value, and 0 if that is not known.
+int CompareIndices(IRContext* context, uint32_t a, uint32_t b) {
+  if (a == b) return -1;
+  Instruction* a_inst = context->get_def_use_mgr()->GetDef(a);
+  Instruction* b_inst = context->get_def_use_mgr()->GetDef(b);
+  if (a_inst->opcode() != SpvOpConstant || b_inst->opcode() != SpvOpConstant) {
+    return 0;
+  }
+  if (a_inst->NumInOperands() != b_inst->NumInOperands()) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < a_inst->NumInOperands(); ++i) {
+    if (a_inst->GetSingleWordInOperand(i) !=
+        b_inst->GetSingleWordInOperand(i)) {
+      return 1;
+    }
+  }
+  return -1;
+}
+
+}  // namespace
+
+MemorySSA::MemorySSA(IRContext* context, Function* function)
+    : context_(context), function_(function), next_version_(1) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  CFG* cfg = context_->cfg();
+  for (DominatorTreeNode& node : dom->GetDomTree()) {
+    if (node.bb_ == nullptr || cfg->IsPseudoEntryBlock(node.bb_)) continue;
+    blocks_.push_back(node.bb_);
+  }
+
+  for (BasicBlock* bb : blocks_) {
+    for (const Instruction& inst : *bb) {
+      CollectStorageClasses(inst);
+    }
+  }
+
+  for (uint32_t storage_class : storage_classes_) {
+    accesses_.emplace_back(new MemoryAccess(MemoryAccess::Kind::kDef, 0,
+                                            storage_class, nullptr, nullptr));
+    live_on_entry_.push_back(accesses_.back().get());
+  }
+
+  for (BasicBlock* bb : blocks_) {
+    for (Instruction& inst : *bb) {
+      if (CreateAccesses(&inst, bb)) {
+        block_insts_[bb].push_back(&inst);
+      }
+    }
+  }
+
+  PlacePhis();
+  Rename();
+}
+
+int MemorySSA::ClassIndex(uint32_t storage_class) const {
+  auto it = std::find(storage_classes_.begin(), storage_classes_.end(),
+                      storage_class);
+  if (it == storage_classes_.end()) return -1;
+  return static_cast<int>(it - storage_classes_.begin());
+}
+
+uint32_t MemorySSA::GetPointerStorageClass(uint32_t ptr_id) const {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  Instruction* ptr = def_use_mgr->GetDef(ptr_id);
+  if (ptr == nullptr || ptr->type_id() == 0) return SpvStorageClassMax;
+  Instruction* type = def_use_mgr->GetDef(ptr->type_id());
+  if (type->opcode() != SpvOpTypePointer) return SpvStorageClassMax;
+  return type->GetSingleWordInOperand(kTypePointerStorageClassInIdx);
+}
+
+uint32_t MemorySSA::GetPointerId(const Instruction* inst) {
+  switch (inst->opcode()) {
+    case SpvOpLoad:
+      return inst->GetSingleWordInOperand(kLoadPointerInIdx);
+    case SpvOpStore:
+      return inst->GetSingleWordInOperand(kStorePointerInIdx);
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized:
+      return inst->GetSingleWordInOperand(kCopyMemoryTargetInIdx);
+    case SpvOpVariable:
+      return inst->result_id();
+    default:
+      if (spvOpcodeIsAtomicOp(inst->opcode())) {
+        return inst->GetSingleWordInOperand(kAtomicPointerInIdx);
+      }
+      return 0;
+  }
+}
+
+void MemorySSA::CollectStorageClasses(const Instruction& inst) {
+  std::vector<uint32_t> pointers;
+  switch (inst.opcode()) {
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized:
+      pointers.push_back(inst.GetSingleWordInOperand(kCopyMemoryTargetInIdx));
+      pointers.push_back(inst.GetSingleWordInOperand(kCopyMemorySourceInIdx));
+      break;
+    case SpvOpVariable:
+      if (inst.NumInOperands() > kVariableInitializerInIdx) {
+        pointers.push_back(inst.result_id());
+      }
+      break;
+    case SpvOpFunctionCall:
+      // The memory pointed to by the arguments may be accessed by the callee
+      // even if the caller does not access it.
+      inst.ForEachInId([&pointers](const uint32_t* id) {
+        pointers.push_back(*id);
+      });
+      break;
+    default:
+      if (uint32_t ptr_id = GetPointerId(&inst)) pointers.push_back(ptr_id);
+      break;
+  }
+
+  for (uint32_t ptr_id : pointers) {
+    uint32_t storage_class = GetPointerStorageClass(ptr_id);
+    if (storage_class != SpvStorageClassMax && ClassIndex(storage_class) < 0) {
+      storage_classes_.push_back(storage_class);
+    }
+  }
+}
+
+MemoryAccess* MemorySSA::NewAccess(MemoryAccess::Kind kind,
+                                   uint32_t storage_class, Instruction* inst,
+                                   BasicBlock* block) {
+  // Uses get the version of their defining access when renaming.
+  uint32_t version = kind == MemoryAccess::Kind::kUse ? 0 : next_version_++;
+  accesses_.emplace_back(
+      new MemoryAccess(kind, version, storage_class, inst, block));
+  MemoryAccess* access = accesses_.back().get();
+  if (inst != nullptr) inst_accesses_[inst].push_back(access);
+  return access;
+}
+
+bool MemorySSA::CreateAccesses(Instruction* inst, BasicBlock* block) {
+  if (IsOpaqueDef(*inst)) {
+    for (uint32_t storage_class : storage_classes_) {
+      NewAccess(MemoryAccess::Kind::kDef, storage_class, inst, block);
+    }
+    return !storage_classes_.empty();
+  }
+
+  switch (inst->opcode()) {
+    case SpvOpLoad:
+    case SpvOpAtomicLoad:
+      NewAccess(MemoryAccess::Kind::kUse,
+                GetPointerStorageClass(GetPointerId(inst)), inst, block);
+      return true;
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized: {
+      uint32_t target_class = GetPointerStorageClass(GetPointerId(inst));
+      uint32_t source_class = GetPointerStorageClass(
+          inst->GetSingleWordInOperand(kCopyMemorySourceInIdx));
+      if (source_class != target_class) {
+        NewAccess(MemoryAccess::Kind::kUse, source_class, inst, block);
+      }
+      NewAccess(MemoryAccess::Kind::kDef, target_class, inst, block);
+      return true;
+    }
+    case SpvOpVariable:
+      if (inst->NumInOperands() <= kVariableInitializerInIdx) return false;
+      NewAccess(MemoryAccess::Kind::kDef,
+                inst->GetSingleWordInOperand(kVariableStorageClassInIdx), inst,
+                block);
+      return true;
+    default:
+      break;
+  }
+
+  if (inst->opcode() == SpvOpStore || spvOpcodeIsAtomicOp(inst->opcode())) {
+    NewAccess(MemoryAccess::Kind::kDef,
+              GetPointerStorageClass(GetPointerId(inst)), inst, block);
+    return true;
+  }
+  return false;
+}
+
+void MemorySSA::PlacePhis() {
+  if (storage_classes_.empty()) return;
+
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  CFG* cfg = context_->cfg();
+
+  // Computes the dominance frontier of each block: a join block is in the
+  // frontier of every block from one of its predecessors up to, but excluding,
+  // its immediate dominator.
+  std::unordered_map<const BasicBlock*, std::vector<BasicBlock*>> frontiers;
+  for (BasicBlock* bb : blocks_) {
+    const std::vector<uint32_t>& preds = cfg->preds(bb->id());
+    if (preds.size() < 2) continue;
+    BasicBlock* idom = dom->ImmediateDominator(bb);
+    for (uint32_t pred_id : preds) {
+      if (!dom->IsReachable(pred_id)) continue;
+      BasicBlock* runner = cfg->block(pred_id);
+      while (runner != nullptr && runner != idom) {
+        std::vector<BasicBlock*>& frontier = frontiers[runner];
+        if (std::find(frontier.begin(), frontier.end(), bb) ==
+            frontier.end()) {
+          frontier.push_back(bb);
+        }
+        runner = dom->ImmediateDominator(runner);
+      }
+    }
+  }
+
+  for (BasicBlock* bb : blocks_) {
+    phis_[bb].resize(storage_classes_.size(), nullptr);
+  }
+
+  for (size_t ci = 0; ci < storage_classes_.size(); ++ci) {
+    std::vector<BasicBlock*> worklist;
+    std::unordered_map<const BasicBlock*, bool> has_def;
+    for (BasicBlock* bb : blocks_) {
+      auto insts = block_insts_.find(bb);
+      if (insts == block_insts_.end()) continue;
+      for (Instruction* inst : insts->second) {
+        MemoryAccess* access = GetAccess(inst, storage_classes_[ci]);
+        if (access != nullptr && access->IsDef()) {
+          has_def[bb] = true;
+          worklist.push_back(bb);
+          break;
+        }
+      }
+    }
+
+    while (!worklist.empty()) {
+      BasicBlock* bb = worklist.back();
+      worklist.pop_back();
+      auto frontier = frontiers.find(bb);
+      if (frontier == frontiers.end()) continue;
+      for (BasicBlock* join : frontier->second) {
+        MemoryAccess*& phi = phis_[join][ci];
+        if (phi != nullptr) continue;
+        phi = NewAccess(MemoryAccess::Kind::kPhi, storage_classes_[ci],
+                        nullptr, join);
+        if (!has_def[join]) {
+          has_def[join] = true;
+          worklist.push_back(join);
+        }
+      }
+    }
+  }
+}
+
+void MemorySSA::Rename() {
+  if (storage_classes_.empty()) return;
+
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  CFG* cfg = context_->cfg();
+
+  // The dominator tree order visits the immediate dominator of a block before
+  // the block, so its exit accesses are known.
+  for (BasicBlock* bb : blocks_) {
+    BasicBlock* idom = dom->ImmediateDominator(bb);
+    bool has_idom = idom != nullptr && !cfg->IsPseudoEntryBlock(idom);
+    std::vector<MemoryAccess*> current =
+        has_idom ? exits_[idom] : live_on_entry_;
+    const std::vector<MemoryAccess*>& phis = phis_[bb];
+    for (size_t ci = 0; ci < storage_classes_.size(); ++ci) {
+      if (phis[ci] != nullptr) current[ci] = phis[ci];
+    }
+
+    auto insts = block_insts_.find(bb);
+    if (insts != block_insts_.end()) {
+      for (Instruction* inst : insts->second) {
+        for (MemoryAccess* access : inst_accesses_[inst]) {
+          int ci = ClassIndex(access->storage_class());
+          MemoryAccess* defining = current[ci];
+          access->defining_access_ = defining;
+          defining->users_.push_back(access);
+          if (access->IsUse()) {
+            access->version_ = defining->version_;
+          } else {
+            current[ci] = access;
+          }
+        }
+      }
+    }
+    exits_[bb] = std::move(current);
+  }
+
+  for (BasicBlock* bb : blocks_) {
+    const std::vector<MemoryAccess*>& phis = phis_[bb];
+    for (size_t ci = 0; ci < storage_classes_.size(); ++ci) {
+      MemoryAccess* phi = phis[ci];
+      if (phi == nullptr) continue;
+      for (uint32_t pred_id : cfg->preds(bb->id())) {
+        if (!dom->IsReachable(pred_id)) continue;
+        MemoryAccess* incoming = exits_[cfg->block(pred_id)][ci];
+        phi->incoming_.emplace_back(pred_id, incoming);
+        incoming->users_.push_back(phi);
+      }
+    }
+  }
+}
+
+MemoryAccess* MemorySSA::GetAccess(const Instruction* inst,
+                                   uint32_t storage_class) const {
+  auto it = inst_accesses_.find(inst);
+  if (it == inst_accesses_.end()) return nullptr;
+  for (MemoryAccess* access : it->second) {
+    if (access->storage_class() == storage_class) return access;
+  }
+  return nullptr;
+}
+
+MemoryAccess* MemorySSA::GetAccess(const Instruction* inst) const {
+  assert((inst->opcode() == SpvOpLoad || inst->opcode() == SpvOpStore) &&
+         "Expecting a load or a store.");
+  auto it = inst_accesses_.find(inst);
+  if (it == inst_accesses_.end()) return nullptr;
+  return it->second.front();
+}
+
+MemoryAccess* MemorySSA::GetPhi(const BasicBlock* block,
+                                uint32_t storage_class) const {
+  int ci = ClassIndex(storage_class);
+  auto it = phis_.find(block);
+  if (ci < 0 || it == phis_.end()) return nullptr;
+  return it->second[ci];
+}
+
+MemoryAccess* MemorySSA::GetExitAccess(const BasicBlock* block,
+                                       uint32_t storage_class) const {
+  int ci = ClassIndex(storage_class);
+  auto it = exits_.find(block);
+  if (ci < 0 || it == exits_.end()) return nullptr;
+  return it->second[ci];
+}
+
+MemoryAccess* MemorySSA::GetLiveOnEntry(uint32_t storage_class) const {
+  int ci = ClassIndex(storage_class);
+  if (ci < 0) return nullptr;
+  return live_on_entry_[ci];
+}
+
+MemoryAccess* MemorySSA::GetClobberingAccess(const MemoryAccess* use) const {
+  assert(use->IsUse() && "Expecting a use.");
+  const Instruction* inst = use->inst();
+  uint32_t ptr_id = GetPointerId(inst);
+  if (inst->opcode() == SpvOpCopyMemory ||
+      inst->opcode() == SpvOpCopyMemorySized) {
+    ptr_id = inst->GetSingleWordInOperand(kCopyMemorySourceInIdx);
+  }
+
+  std::unordered_set<const MemoryAccess*> visited;
+  return WalkToClobber(use->defining_access(), ptr_id, &visited);
+}
+
+MemoryAccess* MemorySSA::WalkToClobber(
+    MemoryAccess* access, uint32_t ptr_id,
+    std::unordered_set<const MemoryAccess*>* visited) const {
+  while (access->IsDef() && !access->IsLiveOnEntry() &&
+         !MayClobber(access, ptr_id)) {
+    access = access->defining_access();
+  }
+  if (!access->IsPhi() || !visited->insert(access).second) return access;
+
+  // The paths going around a loop back to the phi do not write the memory, so
+  // only the other ones matter.
+  MemoryAccess* clobber = nullptr;
+  for (const auto& pred_and_incoming : access->incoming()) {
+    MemoryAccess* incoming_clobber =
+        WalkToClobber(pred_and_incoming.second, ptr_id, visited);
+    if (incoming_clobber == access) continue;
+    if (clobber != nullptr && clobber != incoming_clobber) return access;
+    clobber = incoming_clobber;
+  }
+  return clobber != nullptr ? clobber : access;
+}
+
+bool MemorySSA::MayClobber(const MemoryAccess* def, uint32_t ptr_id) const {
+  if (!def->IsDef() || def->IsLiveOnEntry() || IsOpaqueDef(*def->inst())) {
+    return true;
+  }
+  return MayAlias(GetPointerId(def->inst()), ptr_id);
+}
+
+const Instruction* MemorySSA::GetBase(uint32_t ptr_id,
+                                      std::vector<uint32_t>* indices) const {
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  Instruction* ptr = def_use_mgr->GetDef(ptr_id);
+  while (true) {
+    switch (ptr->opcode()) {
+      case SpvOpAccessChain:
+      case SpvOpInBoundsAccessChain: {
+        std::vector<uint32_t> chain_indices;
+        for (uint32_t i = kAccessChainPtrInIdx + 1; i < ptr->NumInOperands();
+             ++i) {
+          chain_indices.push_back(ptr->GetSingleWordInOperand(i));
+        }
+        indices->insert(indices->begin(), chain_indices.begin(),
+                        chain_indices.end());
+        ptr = def_use_mgr->GetDef(
+            ptr->GetSingleWordInOperand(kAccessChainPtrInIdx));
+        break;
+      }
+      case SpvOpCopyObject:
+        ptr = def_use_mgr->GetDef(
+            ptr->GetSingleWordInOperand(kCopyObjectOperandInIdx));
+        break;
+      default:
+        return ptr;
+    }
+  }
+}
+
+bool MemorySSA::MayAlias(uint32_t ptr_a, uint32_t ptr_b) const {
+  if (ptr_a == ptr_b) return true;
+
+  std::vector<uint32_t> indices_a;
+  std::vector<uint32_t> indices_b;
+  const Instruction* base_a = GetBase(ptr_a, &indices_a);
+  const Instruction* base_b = GetBase(ptr_b, &indices_b);
+  if (base_a != base_b) {
+    return base_a->opcode() != SpvOpVariable ||
+           base_b->opcode() != SpvOpVariable;
+  }
+
+  // Accesses through the same variable are disjoint if they differ at any
+  // level of the composite, whatever the indices at the other levels.
+  size_t common = std::min(indices_a.size(), indices_b.size());
+  for (size_t i = 0; i < common; ++i) {
+    if (CompareIndices(context_, indices_a[i], indices_b[i]) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool MemorySSA::MustAlias(uint32_t ptr_a, uint32_t ptr_b) const {
+  if (ptr_a == ptr_b) return true;
+
+  std::vector<uint32_t> indices_a;
+  std::vector<uint32_t> indices_b;
+  const Instruction* base_a = GetBase(ptr_a, &indices_a);
+  const Instruction* base_b = GetBase(ptr_b, &indices_b);
+  if (base_a != base_b || indices_a.size() != indices_b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < indices_a.size(); ++i) {
+    if (CompareIndices(context_, indices_a[i], indices_b[i]) >= 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace opt
+}  // namespace spvtools
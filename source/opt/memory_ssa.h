@@ -0,0 +1,252 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_MEMORY_SSA_H_
+#define SOURCE_OPT_MEMORY_SSA_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+class IRContext;
+
+// A memory access in the memory SSA form of a function.  Each access belongs to
+// the chain of a single storage class.  A def may modify memory of that storage
+// class, a use only reads it, and a phi merges the versions reaching a block
+// with several predecessors.
+class MemoryAccess {
+ public:
+  enum class Kind { kDef, kUse, kPhi };
+
+  MemoryAccess(Kind kind, uint32_t version, uint32_t storage_class,
+               Instruction* inst, BasicBlock* block)
+      : kind_(kind),
+        version_(version),
+        storage_class_(storage_class),
+        inst_(inst),
+        block_(block),
+        defining_access_(nullptr) {}
+
+  Kind kind() const { return kind_; }
+  bool IsDef() const { return kind_ == Kind::kDef; }
+  bool IsUse() const { return kind_ == Kind::kUse; }
+  bool IsPhi() const { return kind_ == Kind::kPhi; }
+
+  // Returns true if this is the def standing for the memory state on entry to
+  // the function.
+  bool IsLiveOnEntry() const { return kind_ == Kind::kDef && !block_; }
+
+  // The version of memory this access produces, or reads for a use.  Versions
+  // are unique within a function, except that the memory on entry is version 0
+  // in every storage class.
+  uint32_t version() const { return version_; }
+  uint32_t storage_class() const { return storage_class_; }
+
+  // Returns the instruction of the access.  This is null for the live on entry
+  // def and for phis.
+  Instruction* inst() const { return inst_; }
+
+  // Returns the block containing the access.  This is null for the live on
+  // entry def.
+  BasicBlock* block() const { return block_; }
+
+  // Returns the access producing the memory version this access reads.  It is
+  // null for phis and for the live on entry def.
+  MemoryAccess* defining_access() const { return defining_access_; }
+
+  // Returns the incoming accesses of a phi, paired with the id of the
+  // predecessor they come from.
+  const std::vector<std::pair<uint32_t, MemoryAccess*>>& incoming() const {
+    return incoming_;
+  }
+
+  // Returns the accesses whose defining access is this one, and the phis having
+  // it as an incoming access.
+  const std::vector<MemoryAccess*>& users() const { return users_; }
+
+ private:
+  friend class MemorySSA;
+
+  Kind kind_;
+  uint32_t version_;
+  uint32_t storage_class_;
+  Instruction* inst_;
+  BasicBlock* block_;
+  MemoryAccess* defining_access_;
+  std::vector<std::pair<uint32_t, MemoryAccess*>> incoming_;
+  std::vector<MemoryAccess*> users_;
+};
+
+// The memory SSA form of a function.  Memory is split into one chain of
+// versions per storage class accessed in the function:
+//
+//  - OpStore, OpCopyMemory (on the target) and the atomics that write memory
+//    are defs.  So is an OpVariable with an initializer.
+//  - OpLoad, OpCopyMemory (on the source) and OpAtomicLoad are uses.  An
+//    OpCopyMemory within a single storage class only gets the def.
+//  - OpFunctionCall, OpControlBarrier and OpMemoryBarrier are defs in every
+//    chain, since they may modify any memory.
+//
+// Phis are placed on the iterated dominance frontier of the defs, as for
+// values.  Blocks that are not reachable get no accesses.
+//
+// The analysis is not updated as the function changes.  A pass that modifies
+// one of the instructions above must not preserve it.
+class MemorySSA {
+ public:
+  MemorySSA(IRContext* context, Function* function);
+
+  MemorySSA(const MemorySSA&) = delete;
+  MemorySSA& operator=(const MemorySSA&) = delete;
+
+  // Returns the access of |inst| in the chain of |storage_class|, or null if
+  // |inst| does not access memory of that storage class.
+  MemoryAccess* GetAccess(const Instruction* inst,
+                          uint32_t storage_class) const;
+
+  // Returns the only access of |inst|, which must be a load or a store, or null
+  // if it has none.
+  MemoryAccess* GetAccess(const Instruction* inst) const;
+
+  // Returns the phi of |storage_class| at the start of |block|, or null if
+  // there is none.
+  MemoryAccess* GetPhi(const BasicBlock* block, uint32_t storage_class) const;
+
+  // Returns the last def or phi of |storage_class| reaching the end of
+  // |block|, or null if |block| is unreachable or the storage class is not
+  // accessed in the function.
+  MemoryAccess* GetExitAccess(const BasicBlock* block,
+                              uint32_t storage_class) const;
+
+  // Returns the def standing for the memory of |storage_class| on entry to the
+  // function, or null if the storage class is not accessed.
+  MemoryAccess* GetLiveOnEntry(uint32_t storage_class) const;
+
+  // Returns the nearest def or phi above |use| that may write the memory |use|
+  // reads.  Defs writing memory that does not alias it are skipped.  A phi is
+  // looked through when the walks from all its incoming accesses, other than
+  // those coming back to it, lead to the same access.
+  MemoryAccess* GetClobberingAccess(const MemoryAccess* use) const;
+
+  // Returns true if the def |def| may write memory pointed to by the pointer
+  // |ptr_id|.
+  bool MayClobber(const MemoryAccess* def, uint32_t ptr_id) const;
+
+  // Returns true if the pointers |ptr_a| and |ptr_b| may point to overlapping
+  // memory.  Two pointers do not alias when they are based on different
+  // variables, or on the same variable through constant indices that differ.
+  bool MayAlias(uint32_t ptr_a, uint32_t ptr_b) const;
+
+  // Returns true if the pointers |ptr_a| and |ptr_b| point to the same memory.
+  // This is the case when they walk the same indices from the same base.
+  bool MustAlias(uint32_t ptr_a, uint32_t ptr_b) const;
+
+  // Returns the instruction the pointer |ptr_id| is based on and adds to
+  // |indices| the indices walked from it, outermost first.  Access chains and
+  // copies are looked through.
+  const Instruction* GetBase(uint32_t ptr_id,
+                             std::vector<uint32_t>* indices) const;
+
+  // Returns true if |inst| has an access in any storage class.
+  bool HasAccesses(const Instruction* inst) const {
+    return inst_accesses_.count(inst) != 0;
+  }
+
+  // Returns the storage classes accessed in the function.
+  const std::vector<uint32_t>& storage_classes() const {
+    return storage_classes_;
+  }
+
+  // Returns the storage class of the pointer |ptr_id|.
+  uint32_t GetPointerStorageClass(uint32_t ptr_id) const;
+
+  // Returns the id of the pointer |inst| reads or writes, or 0 if |inst| is
+  // not a memory access through a single pointer.  For OpCopyMemory this is
+  // the target.
+  static uint32_t GetPointerId(const Instruction* inst);
+
+ private:
+  // Returns the index of |storage_class| in |storage_classes_|, or -1 if it is
+  // not accessed.
+  int ClassIndex(uint32_t storage_class) const;
+
+  // Adds the storage classes of the pointers |inst| accesses to
+  // |storage_classes_|.
+  void CollectStorageClasses(const Instruction& inst);
+
+  // Creates the accesses of |inst| in |block|, and returns true if there are
+  // any.
+  bool CreateAccesses(Instruction* inst, BasicBlock* block);
+
+  // Creates a new access and returns it.
+  MemoryAccess* NewAccess(MemoryAccess::Kind kind, uint32_t storage_class,
+                          Instruction* inst, BasicBlock* block);
+
+  // Places the phis according to the dominance frontiers of the blocks with
+  // defs.
+  void PlacePhis();
+
+  // Links every access to its defining access, walking the dominator tree.
+  void Rename();
+
+  // Returns the clobbering access of |ptr_id| at or above |access|.  |visited|
+  // holds the phis that have been entered already, which are returned as is.
+  MemoryAccess* WalkToClobber(
+      MemoryAccess* access, uint32_t ptr_id,
+      std::unordered_set<const MemoryAccess*>* visited) const;
+
+  IRContext* context_;
+  Function* function_;
+
+  // The accessed storage classes, in order of first appearance.
+  std::vector<uint32_t> storage_classes_;
+
+  // All the accesses, owned by the analysis.
+  std::vector<std::unique_ptr<MemoryAccess>> accesses_;
+
+  // The live on entry def of each storage class, by class index.
+  std::vector<MemoryAccess*> live_on_entry_;
+
+  // The accesses of each instruction.
+  std::unordered_map<const Instruction*, std::vector<MemoryAccess*>>
+      inst_accesses_;
+
+  // The reachable blocks, in dominator tree order, and the memory accessing
+  // instructions of each of them in order.
+  std::vector<BasicBlock*> blocks_;
+  std::unordered_map<const BasicBlock*, std::vector<Instruction*>>
+      block_insts_;
+
+  // The phis and exit accesses of each block, by class index.
+  std::unordered_map<const BasicBlock*, std::vector<MemoryAccess*>> phis_;
+  std::unordered_map<const BasicBlock*, std::vector<MemoryAccess*>> exits_;
+
+  // The next version to assign.
+  uint32_t next_version_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_MEMORY_SSA_H_
@@ -136,6 +136,16 @@ bool MergeReturnPass::ProcessStructured(
     GenerateState(block);
   }
 
+  // Index the blocks so that membership tests and insertions into |order| do
+  // not need a linear scan.  Functions with many returns would otherwise be
+  // quadratic in the number of blocks.
+  std::unordered_set<BasicBlock*> original_returns(return_blocks.begin(),
+                                                   return_blocks.end());
+  order_positions_.clear();
+  for (auto it = order.begin(); it != order.end(); ++it) {
+    order_positions_[*it] = it;
+  }
+
   state_.clear();
   state_.emplace_back(nullptr, nullptr);
   std::unordered_set<BasicBlock*> predicated;
@@ -151,8 +161,7 @@ bool MergeReturnPass::ProcessStructured(
     }
 
     // Predicate successors of the original return blocks as necessary.
-    if (std::find(return_blocks.begin(), return_blocks.end(), block) !=
-        return_blocks.end()) {
+    if (original_returns.count(block)) {
       if (!PredicateBlocks(block, &predicated, &order)) {
         return false;
       }
@@ -162,9 +171,14 @@ bool MergeReturnPass::ProcessStructured(
     GenerateState(block);
   }
 
+  order_positions_.clear();
+
   // We have not kept the dominator tree up-to-date.
-  // Invalidate it at this point to make sure it will be rebuilt.
+  // Invalidate it at this point to make sure it will be rebuilt.  Adding the
+  // phi nodes does not change the CFG, so the rebuilt tree is still valid when
+  // the pass finishes.
   context()->RemoveDominatorAnalysis(function);
+  context()->RemovePostDominatorAnalysis(function);
   AddNewPhiNodes();
   return true;
 }
@@ -339,10 +353,7 @@ void MergeReturnPass::CreatePhiNodesForInst(BasicBlock* merge_block,
       std::unique_ptr<Instruction> regen_inst(inst.Clone(context()));
       uint32_t new_id = TakeNextId();
       regen_inst->SetResultId(new_id);
-      Instruction* insert_pos = &*merge_block->begin();
-      while (insert_pos->opcode() == SpvOpPhi) {
-        insert_pos = insert_pos->NextNode();
-      }
+      Instruction* insert_pos = &*merge_block->GetFirstNonPhi();
       new_phi = insert_pos->InsertBefore(std::move(regen_inst));
       get_def_use_mgr()->AnalyzeInstDefUse(new_phi);
       context()->set_instr_block(new_phi, merge_block);
@@ -454,10 +465,7 @@ bool MergeReturnPass::BreakFromConstruct(
   }
 
   // Leave the phi instructions behind.
-  auto iter = block->begin();
-  while (iter->opcode() == SpvOpPhi) {
-    ++iter;
-  }
+  auto iter = block->GetFirstNonPhi();
 
   // Forget about the edges leaving block.  They will be removed.
   cfg()->RemoveSuccessorEdges(block);
@@ -707,6 +715,17 @@ void MergeReturnPass::MergeReturnBlocks(
   }
 
   get_def_use_mgr()->AnalyzeInstDefUse(ret_block_iter->GetLabelInst());
+
+  // Keep the CFG current so that it can be preserved.  The dominator trees of
+  // |function| are stale and are rebuilt on demand.
+  if (context()->AreAnalysesValid(IRContext::kAnalysisCFG)) {
+    cfg()->RegisterBlock(final_return_block_);
+    for (auto block : return_blocks) {
+      cfg()->AddEdge(block->id(), return_id);
+    }
+  }
+  context()->RemoveDominatorAnalysis(function);
+  context()->RemovePostDominatorAnalysis(function);
 }
 
 void MergeReturnPass::AddNewPhiNodes() {
@@ -763,10 +782,13 @@ void MergeReturnPass::RecordImmediateDominators(Function* function) {
 void MergeReturnPass::InsertAfterElement(BasicBlock* element,
                                          BasicBlock* new_element,
                                          std::list<BasicBlock*>* list) {
-  auto pos = std::find(list->begin(), list->end(), element);
+  auto pos_iter = order_positions_.find(element);
+  auto pos = pos_iter != order_positions_.end()
+                 ? pos_iter->second
+                 : std::find(list->begin(), list->end(), element);
   assert(pos != list->end());
   ++pos;
-  list->insert(pos, new_element);
+  order_positions_[new_element] = list->insert(pos, new_element);
 }
 
 void MergeReturnPass::AddSingleCaseSwitchAroundFunction() {
@@ -15,6 +15,7 @@
 #ifndef SOURCE_OPT_MERGE_RETURN_PASS_H_
 #define SOURCE_OPT_MERGE_RETURN_PASS_H_
 
+#include <list>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -106,7 +107,8 @@ class MergeReturnPass : public MemPass {
   Status Process() override;
 
   IRContext::Analysis GetPreservedAnalyses() override {
-    return IRContext::kAnalysisConstants | IRContext::kAnalysisTypes;
+    return IRContext::kAnalysisConstants | IRContext::kAnalysisTypes |
+           IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis;
   }
 
  private:
@@ -269,7 +271,8 @@ class MergeReturnPass : public MemPass {
   StructuredControlState& CurrentState() { return state_.back(); }
 
   // Inserts |new_element| into |list| after the first occurrence of |element|.
-  // |element| must be in |list| at least once.
+  // |element| must be in |list| at least once.  The position is looked up in
+  // |order_positions_| when |element| has been recorded there.
   void InsertAfterElement(BasicBlock* element, BasicBlock* new_element,
                           std::list<BasicBlock*>* list);
 
@@ -329,6 +332,11 @@ class MergeReturnPass : public MemPass {
   // processing structured blocks and used to properly construct OpPhi
   // instructions.
   std::unordered_set<uint32_t> return_blocks_;
+
+  // The position of each block in the structured order being predicated, so
+  // that new blocks can be inserted after it in constant time.
+  std::unordered_map<BasicBlock*, std::list<BasicBlock*>::iterator>
+      order_positions_;
 };
 
 }  // namespace opt
@@ -15,16 +15,56 @@
 #include "source/opt/module.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <iterator>
 #include <ostream>
 
 #include "source/operand.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/reflect.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
 
+std::unique_ptr<Module> Module::Clone(IRContext* context) const {
+  std::unique_ptr<Module> clone(new Module());
+  clone->SetContext(context);
+  clone->header_ = header_;
+  auto clone_list = [context](const InstructionList& from,
+                              InstructionList* to) {
+    for (auto& inst : from) {
+      to->push_back(std::unique_ptr<Instruction>(inst.Clone(context)));
+    }
+  };
+  clone_list(capabilities_, &clone->capabilities_);
+  clone_list(extensions_, &clone->extensions_);
+  clone_list(ext_inst_imports_, &clone->ext_inst_imports_);
+  if (memory_model_) {
+    clone->memory_model_.reset(memory_model_->Clone(context));
+  }
+  clone_list(entry_points_, &clone->entry_points_);
+  clone_list(execution_modes_, &clone->execution_modes_);
+  clone_list(debugs1_, &clone->debugs1_);
+  clone_list(debugs2_, &clone->debugs2_);
+  clone_list(debugs3_, &clone->debugs3_);
+  clone_list(ext_inst_debuginfo_, &clone->ext_inst_debuginfo_);
+  clone_list(annotations_, &clone->annotations_);
+  clone_list(types_values_, &clone->types_values_);
+  clone->functions_.reserve(functions_.size());
+  for (auto& function : functions_) {
+    clone->AddFunction(std::unique_ptr<Function>(function->Clone(context)));
+  }
+  for (auto& dbg_line_inst : trailing_dbg_line_info_) {
+    std::unique_ptr<Instruction> line(dbg_line_inst.Clone(context));
+    clone->trailing_dbg_line_info_.push_back(*line);
+  }
+  clone->contains_debug_scope_ = contains_debug_scope_;
+  clone->dropped_debug_line_insts_ = dropped_debug_line_insts_;
+  return clone;
+}
+
 uint32_t Module::TakeNextIdBound() {
   if (context()) {
     if (id_bound() >= context()->max_id_bound()) {
@@ -37,6 +77,19 @@ uint32_t Module::TakeNextIdBound() {
   return header_.bound++;
 }
 
+uint32_t Module::TakeNextIdRange(uint32_t count) {
+  assert(count != 0 && "An id range cannot be empty.");
+  const uint32_t max_bound =
+      context() ? context()->max_id_bound() : kDefaultMaxIdBound;
+  if (id_bound() >= max_bound || count > max_bound - id_bound()) {
+    return 0;
+  }
+
+  const uint32_t first_id = header_.bound;
+  header_.bound += count;
+  return first_id;
+}
+
 std::vector<Instruction*> Module::GetTypes() {
   std::vector<Instruction*> type_insts;
   for (auto& inst : types_values_) {
@@ -83,7 +136,7 @@ void Module::AddGlobalValue(SpvOp opcode, uint32_t result_id,
   AddGlobalValue(std::move(newGlobal));
 }
 
-void Module::ForEachInst(const std::function<void(Instruction*)>& f,
+void Module::ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                          bool run_on_debug_line_insts) {
 #define DELEGATE(list) list.ForEachInst(f, run_on_debug_line_insts)
   DELEGATE(capabilities_);
@@ -105,7 +158,7 @@ void Module::ForEachInst(const std::function<void(Instruction*)>& f,
 #undef DELEGATE
 }
 
-void Module::ForEachInst(const std::function<void(const Instruction*)>& f,
+void Module::ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                          bool run_on_debug_line_insts) const {
 #define DELEGATE(i) i.ForEachInst(f, run_on_debug_line_insts)
   for (auto& i : capabilities_) DELEGATE(i);
@@ -133,35 +186,73 @@ void Module::ForEachInst(const std::function<void(const Instruction*)>& f,
 #undef DELEGATE
 }
 
+size_t Module::GetBinarySize(bool skip_nop) const {
+  size_t num_words = 5;  // The header.
+  DebugScope last_scope(kNoDebugScope, kNoInlinedAt);
+  ForEachInst(
+      [skip_nop, &last_scope, &num_words](const Instruction* i) {
+        if (skip_nop && i->IsNop()) return;
+        const auto& scope = i->GetDebugScope();
+        if (scope != last_scope) {
+          num_words += scope.GetNumWords();
+          last_scope = scope;
+        }
+        num_words += 1 + i->NumOperandWords();
+      },
+      true);
+  return num_words;
+}
+
+size_t Module::MemoryUsage() const {
+  size_t bytes = 0;
+  ForEachInst([&bytes](const Instruction* i) { bytes += i->MemoryUsage(); },
+              true);
+  bytes += utils::MemoryUsage(functions_);
+  for (const auto& function : functions_) {
+    const size_t num_blocks =
+        static_cast<size_t>(std::distance(function->begin(), function->end()));
+    bytes += sizeof(Function) +
+             num_blocks * (sizeof(std::unique_ptr<BasicBlock>) +
+                           sizeof(BasicBlock));
+  }
+  return bytes;
+}
+
 void Module::ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const {
-  binary->push_back(header_.magic_number);
-  binary->push_back(header_.version);
+  // Size the binary once, then write the instructions in place.
+  const size_t offset = binary->size();
+  binary->resize(offset + GetBinarySize(skip_nop));
+  ToBinary(binary->data() + offset, skip_nop);
+}
+
+void Module::ToBinary(uint32_t* binary, bool skip_nop) const {
+  *binary++ = header_.magic_number;
+  *binary++ = header_.version;
   // TODO(antiagainst): should we change the generator number?
-  binary->push_back(header_.generator);
-  binary->push_back(header_.bound);
-  binary->push_back(header_.reserved);
+  *binary++ = header_.generator;
+  uint32_t* bound = binary++;
+  *binary++ = header_.reserved;
 
-  size_t bound_idx = binary->size() - 2;
   DebugScope last_scope(kNoDebugScope, kNoInlinedAt);
-  auto write_inst = [binary, skip_nop, &last_scope,
+  auto write_inst = [&binary, skip_nop, &last_scope,
                      this](const Instruction* i) {
     if (!(skip_nop && i->IsNop())) {
       const auto& scope = i->GetDebugScope();
       if (scope != last_scope) {
         // Emit DebugScope |scope| to |binary|.
         auto dbg_inst = ext_inst_debuginfo_.begin();
-        scope.ToBinary(dbg_inst->type_id(), context()->TakeNextId(),
-                       dbg_inst->GetSingleWordOperand(2), binary);
+        binary = scope.ToBinary(dbg_inst->type_id(), context()->TakeNextId(),
+                                dbg_inst->GetSingleWordOperand(2), binary);
         last_scope = scope;
       }
 
-      i->ToBinaryWithoutAttachedDebugInsts(binary);
+      binary = i->ToBinaryWithoutAttachedDebugInsts(binary);
     }
   };
   ForEachInst(write_inst, true);
 
   // We create new instructions for DebugScope. The bound must be updated.
-  binary->data()[bound_idx] = header_.bound;
+  *bound = header_.bound;
 }
 
 uint32_t Module::ComputeIdBound() const {
@@ -24,6 +24,7 @@
 #include "source/opt/function.h"
 #include "source/opt/instruction.h"
 #include "source/opt/iterator.h"
+#include "source/util/function_ref.h"
 
 namespace spvtools {
 namespace opt {
@@ -49,7 +50,10 @@ class Module {
   using const_inst_iterator = InstructionList::const_iterator;
 
   // Creates an empty module with zero'd header.
-  Module() : header_({}), contains_debug_scope_(false) {}
+  Module()
+      : header_({}),
+        contains_debug_scope_(false),
+        dropped_debug_line_insts_(false) {}
 
   // Sets the header to the given |header|.
   void SetHeader(const ModuleHeader& header) { header_ = header; }
@@ -61,7 +65,7 @@ class Module {
   }
 
   // Returns the Id bound.
-  uint32_t IdBound() { return header_.bound; }
+  uint32_t IdBound() const { return header_.bound; }
 
   // Returns the current Id bound and increases it to the next available value.
   // If the id bound has already reached its maximum value, then 0 is returned.
@@ -71,6 +75,11 @@ class Module {
   // TODO(1841): Update the uses to check for a 0 return value.
   uint32_t TakeNextIdBound();
 
+  // Returns the first of |count| consecutive ids, and increases the id bound
+  // past the last of them.  If the id bound cannot grow by |count|, then 0 is
+  // returned and the bound is left unchanged.  |count| must be positive.
+  uint32_t TakeNextIdRange(uint32_t count);
+
   // Appends a capability instruction to this module.
   inline void AddCapability(std::unique_ptr<Instruction> c);
 
@@ -119,10 +128,23 @@ class Module {
   // Appends a function to this module.
   inline void AddFunction(std::unique_ptr<Function> f);
 
+  // Moves the functions of |order| to the front of the module, in that order.
+  // The other functions follow in their current order.  Returns true if the
+  // order of the functions changed.
+  bool ReorderFunctions(const std::vector<Function*>& order) {
+    return ReorderUptrVector(&functions_, order);
+  }
+
   // Sets |contains_debug_scope_| as true.
   inline void SetContainsDebugScope();
   inline bool ContainsDebugScope() { return contains_debug_scope_; }
 
+  // Sets |dropped_debug_line_insts_| as true.
+  inline void SetDroppedDebugLineInsts();
+  inline bool DroppedDebugLineInsts() const {
+    return dropped_debug_line_insts_;
+  }
+
   // Returns a vector of pointers to type-declaration instructions in this
   // module.
   std::vector<Instruction*> GetTypes();
@@ -237,15 +259,27 @@ class Module {
 
   // Invokes function |f| on all instructions in this module, and optionally on
   // the debug line instructions that precede them.
-  void ForEachInst(const std::function<void(Instruction*)>& f,
+  void ForEachInst(utils::FunctionRef<void(Instruction*)> f,
                    bool run_on_debug_line_insts = false);
-  void ForEachInst(const std::function<void(const Instruction*)>& f,
+  void ForEachInst(utils::FunctionRef<void(const Instruction*)> f,
                    bool run_on_debug_line_insts = false) const;
 
+  // Returns the number of words ToBinary writes for this module.  If
+  // |skip_nop| is true, the OpNop instructions are not counted.
+  size_t GetBinarySize(bool skip_nop) const;
+
+  // Returns an approximation of the number of bytes of memory used by the
+  // instructions, blocks and functions of this module.
+  size_t MemoryUsage() const;
+
   // Pushes the binary segments for this instruction into the back of *|binary|.
   // If |skip_nop| is true and this is a OpNop, do nothing.
   void ToBinary(std::vector<uint32_t>* binary, bool skip_nop) const;
 
+  // Same as above, but writes the binary to |binary|, which must have room for
+  // GetBinarySize(skip_nop) words.
+  void ToBinary(uint32_t* binary, bool skip_nop) const;
+
   // Returns 1 more than the maximum Id value mentioned in the module.
   uint32_t ComputeIdBound() const;
 
@@ -256,6 +290,10 @@ class Module {
   // Returns 0 if not found.
   uint32_t GetExtInstImportId(const char* extstr);
 
+  // Returns a deep copy of this module whose instructions belong to |context|.
+  // Result ids are preserved.
+  std::unique_ptr<Module> Clone(IRContext* context) const;
+
   // Sets the associated context for this module
   void SetContext(IRContext* c) { context_ = c; }
 
@@ -303,6 +341,9 @@ class Module {
 
   // This module contains DebugScope or DebugNoScope.
   bool contains_debug_scope_;
+
+  // OpLine or OpNoLine instructions were dropped while loading this module.
+  bool dropped_debug_line_insts_;
 };
 
 // Pretty-prints |module| to |str|. Returns |str|.
@@ -366,6 +407,10 @@ inline void Module::AddFunction(std::unique_ptr<Function> f) {
 
 inline void Module::SetContainsDebugScope() { contains_debug_scope_ = true; }
 
+inline void Module::SetDroppedDebugLineInsts() {
+  dropped_debug_line_insts_ = true;
+}
+
 inline Module::inst_iterator Module::capability_begin() {
   return capabilities_.begin();
 }
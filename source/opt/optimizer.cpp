@@ -14,21 +14,34 @@
 
 #include "spirv-tools/optimizer.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <functional>
 #include <memory>
+#include <random>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "source/opt/build_module.h"
+#include "source/opt/function_result_cache.h"
 #include "source/opt/graphics_robust_access_pass.h"
+#include "source/opt/loaded_module.h"
 #include "source/opt/log.h"
 #include "source/opt/pass_manager.h"
 #include "source/opt/passes.h"
+#include "source/opt/shader_stats.h"
 #include "source/spirv_optimizer_options.h"
+#include "source/table.h"
 #include "source/util/make_unique.h"
+#include "source/util/parallel.h"
 #include "source/util/string_utils.h"
+#include "source/util/timer.h"
+#include "source/val/validate.h"
+#include "source/val/validation_state.h"
 
 namespace spvtools {
 
@@ -55,11 +68,125 @@ Optimizer::PassToken& Optimizer::PassToken::operator=(PassToken&& that) {
 
 Optimizer::PassToken::~PassToken() {}
 
+namespace {
+
+// Returns a pass that runs the function-local passes of the legalization
+// recipe one function at a time.  They are the passes that used to be
+// registered one by one, in the same order, except that the module-wide clean
+// up of ADCE is left to the pass that follows the pipeline.
+Optimizer::PassToken CreateLegalizationFunctionPipeline() {
+  auto create_passes = []() {
+    std::vector<std::unique_ptr<opt::Pass>> passes;
+    // Propagate the value stored to the loads in very simple cases.
+    passes.push_back(MakeUnique<opt::LocalSingleBlockLoadStoreElimPass>());
+    passes.push_back(MakeUnique<opt::LocalSingleStoreElimPass>());
+    passes.push_back(MakeUnique<opt::AggressiveDCEPass>());
+    // Split up aggregates so they are easier to deal with.
+    passes.push_back(MakeUnique<opt::ScalarReplacementPass>(0));
+    // Remove loads and stores so everything is in intermediate values.
+    // Takes care of copy propagation of non-members.
+    passes.push_back(MakeUnique<opt::LocalSingleBlockLoadStoreElimPass>());
+    passes.push_back(MakeUnique<opt::LocalSingleStoreElimPass>());
+    passes.push_back(MakeUnique<opt::AggressiveDCEPass>());
+    passes.push_back(MakeUnique<opt::SSARewritePass>());
+    return passes;
+  };
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::FunctionPipelinePass>(create_passes, "legalization"));
+}
+
+}  // namespace
+
 struct Optimizer::Impl {
   explicit Impl(spv_target_env env) : target_env(env), pass_manager() {}
 
+  // Records that the passes registered during the lifetime of this object are
+  // registered on behalf of |flag|.  Only the outermost flag is recorded, and
+  // it is dropped again if it did not register any pass.
+  class FlagScope {
+   public:
+    FlagScope(Impl* impl, const std::string& flag)
+        : impl_(impl), num_passes_(impl->pass_manager.NumPasses()) {
+      if (impl_->flag_depth++ == 0) impl_->pass_flags.push_back(flag);
+    }
+    ~FlagScope() {
+      if (--impl_->flag_depth == 0 &&
+          impl_->pass_manager.NumPasses() == num_passes_) {
+        impl_->pass_flags.pop_back();
+      }
+    }
+
+   private:
+    Impl* impl_;
+    size_t num_passes_;
+  };
+
+  // Validates |original_binary| if requested by |opt_options| and builds its
+  // module with the settings of |opt_options| and of this optimizer.  Returns
+  // nullptr if either step fails.
+  std::unique_ptr<opt::IRContext> Build(const uint32_t* original_binary,
+                                        size_t original_binary_size,
+                                        spv_optimizer_options opt_options);
+
+  // Applies the settings of |opt_options| and of this optimizer to the module
+  // in |context|, as |Build| does for the modules it builds.
+  void Configure(opt::IRContext* context, spv_optimizer_options opt_options);
+
+  // Builds the module of |original_binary| as |Build| does and runs the
+  // passes of |pass_manager| on it.  Returns the optimized module, or nullptr
+  // if any of those steps fails.  Sets |changed| to whether the module may
+  // differ from |original_binary|.
+  std::unique_ptr<opt::IRContext> Optimize(const uint32_t* original_binary,
+                                           size_t original_binary_size,
+                                           spv_optimizer_options opt_options,
+                                           bool* changed);
+
   spv_target_env target_env;      // Target environment.
   opt::PassManager pass_manager;  // Internal implementation pass manager.
+
+  // The flags that register the same passes as the ones in |pass_manager|.
+  std::vector<std::string> pass_flags;
+  // True if a pass has been registered that is not described by |pass_flags|.
+  bool has_passes_without_flag = false;
+  // The number of |FlagScope| objects that currently exist.
+  uint32_t flag_depth = 0;
+  // The block execution counts attached to the optimized modules.
+  std::vector<BlockExecutionCount> profile;
+  // The executor on whose tasks the work spread over several threads runs,
+  // or nullptr to start threads.
+  Executor* executor = nullptr;
+  // Where to write the work done by each run of the passes, or nullptr.
+  WorkCounts* work_counts = nullptr;
+  // The cache of the results of the function pipelines, or nullptr.
+  opt::FunctionResultCache* function_cache = nullptr;
+
+  // Runs the registered passes on |context| with |opt_options|, and records
+  // the work they did in |work_counts| if it is set.
+  opt::Pass::Status RunPasses(opt::IRContext* context,
+                              spv_optimizer_options opt_options) {
+    pass_manager.SetValidatorOptions(&opt_options->val_options_);
+    pass_manager.SetTargetEnv(target_env);
+    if (!work_counts) return pass_manager.Run(context);
+
+    size_t instructions = 0;
+    context->module()->ForEachInst(
+        [&instructions](const opt::Instruction*) { ++instructions; });
+    const opt::IRContext::WorkCounts before = context->GetWorkCounts();
+    auto status = pass_manager.Run(context);
+    const opt::IRContext::WorkCounts after = context->GetWorkCounts();
+    work_counts->instructions = instructions;
+    work_counts->analysis_builds =
+        after.analysis_builds - before.analysis_builds;
+    work_counts->def_use_updates =
+        after.def_use_updates - before.def_use_updates;
+    return status;
+  }
+
+  // Runs |work| as |utils::RunOnWorkers| does, on |executor| if it is set.
+  void RunOnWorkers(size_t num_workers, const std::function<void()>& work) {
+    utils::RunOnWorkers(num_workers, executor ? &Executor::Run : nullptr,
+                        executor, work);
+  }
 };
 
 Optimizer::Optimizer(spv_target_env env) : impl_(new Impl(env)) {}
@@ -79,6 +206,7 @@ const MessageConsumer& Optimizer::consumer() const {
 }
 
 Optimizer& Optimizer::RegisterPass(PassToken&& p) {
+  if (impl_->flag_depth == 0) impl_->has_passes_without_flag = true;
   // Change to use the pass manager's consumer.
   p.impl_->pass->SetMessageConsumer(consumer());
   impl_->pass_manager.AddPass(std::move(p.impl_->pass));
@@ -107,57 +235,52 @@ Optimizer& Optimizer::RegisterPass(PassToken&& p) {
 // problem.  The optimization we use are all used to either do copy propagation
 // or enable more copy propagation.
 Optimizer& Optimizer::RegisterLegalizationPasses() {
-  return
-      // Wrap OpKill instructions so all other code can be inlined.
-      RegisterPass(CreateWrapOpKillPass())
-          // Remove unreachable block so that merge return works.
-          .RegisterPass(CreateDeadBranchElimPass())
-          // Merge the returns so we can inline.
-          .RegisterPass(CreateMergeReturnPass())
-          // Make sure uses and definitions are in the same function.
-          .RegisterPass(CreateInlineExhaustivePass())
-          // Make private variable function scope
-          .RegisterPass(CreateEliminateDeadFunctionsPass())
-          .RegisterPass(CreatePrivateToLocalPass())
-          // Fix up the storage classes that DXC may have purposely generated
-          // incorrectly.  All functions are inlined, and a lot of dead code has
-          // been removed.
-          .RegisterPass(CreateFixStorageClassPass())
-          // Propagate the value stored to the loads in very simple cases.
-          .RegisterPass(CreateLocalSingleBlockLoadStoreElimPass())
-          .RegisterPass(CreateLocalSingleStoreElimPass())
-          .RegisterPass(CreateAggressiveDCEPass())
-          // Split up aggregates so they are easier to deal with.
-          .RegisterPass(CreateScalarReplacementPass(0))
-          // Remove loads and stores so everything is in intermediate values.
-          // Takes care of copy propagation of non-members.
-          .RegisterPass(CreateLocalSingleBlockLoadStoreElimPass())
-          .RegisterPass(CreateLocalSingleStoreElimPass())
-          .RegisterPass(CreateAggressiveDCEPass())
-          .RegisterPass(CreateLocalMultiStoreElimPass())
-          .RegisterPass(CreateAggressiveDCEPass())
-          // Propagate constants to get as many constant conditions on branches
-          // as possible.
-          .RegisterPass(CreateCCPPass())
-          .RegisterPass(CreateLoopUnrollPass(true))
-          .RegisterPass(CreateDeadBranchElimPass())
-          // Copy propagate members.  Cleans up code sequences generated by
-          // scalar replacement.  Also important for removing OpPhi nodes.
-          .RegisterPass(CreateSimplificationPass())
-          .RegisterPass(CreateAggressiveDCEPass())
-          .RegisterPass(CreateCopyPropagateArraysPass())
-          // May need loop unrolling here see
-          // https://github.com/Microsoft/DirectXShaderCompiler/pull/930
-          // Get rid of unused code that contain traces of illegal code
-          // or unused references to unbound external objects
-          .RegisterPass(CreateVectorDCEPass())
-          .RegisterPass(CreateDeadInsertElimPass())
-          .RegisterPass(CreateReduceLoadSizePass())
-          .RegisterPass(CreateAggressiveDCEPass());
+  Impl::FlagScope flag_scope(impl_.get(), "--legalize-hlsl");
+  // Wrap OpKill instructions so all other code can be inlined.
+  RegisterPass(CreateWrapOpKillPass())
+      // Remove unreachable block so that merge return works.
+      .RegisterPass(CreateDeadBranchElimPass())
+      // Merge the returns so we can inline.
+      .RegisterPass(CreateMergeReturnPass())
+      // Make sure uses and definitions are in the same function.
+      .RegisterPass(CreateInlineExhaustivePass())
+      // Make private variable function scope
+      .RegisterPass(CreateEliminateDeadFunctionsPass())
+      .RegisterPass(CreatePrivateToLocalPass())
+      // Fix up the storage classes that DXC may have purposely generated
+      // incorrectly.  All functions are inlined, and a lot of dead code has
+      // been removed.
+      .RegisterPass(CreateFixStorageClassPass())
+      // Forward stores to loads, split up aggregates and rewrite the function
+      // variables into SSA.  These passes only look at one function at a time,
+      // so they are fused and run function by function.
+      .RegisterPass(CreateLegalizationFunctionPipeline())
+      // Remove the dead functions and globals the pipeline leaves behind.
+      .RegisterPass(CreateAggressiveDCEPass())
+      // Propagate constants to get as many constant conditions on branches
+      // as possible.
+      .RegisterPass(CreateCCPPass())
+      .RegisterPass(CreateLoopUnrollPass(true))
+      .RegisterPass(CreateDeadBranchElimPass())
+      // Copy propagate members.  Cleans up code sequences generated by
+      // scalar replacement.  Also important for removing OpPhi nodes.
+      .RegisterPass(CreateSimplificationPass())
+      .RegisterPass(CreateAggressiveDCEPass())
+      .RegisterPass(CreateCopyPropagateArraysPass())
+      // May need loop unrolling here see
+      // https://github.com/Microsoft/DirectXShaderCompiler/pull/930
+      // Get rid of unused code that contain traces of illegal code
+      // or unused references to unbound external objects
+      .RegisterPass(CreateVectorDCEPass())
+      .RegisterPass(CreateDeadInsertElimPass())
+      .RegisterPass(CreateReduceLoadSizePass())
+      .RegisterPass(CreateAggressiveDCEPass());
+  return *this;
 }
 
 Optimizer& Optimizer::RegisterPerformancePasses() {
-  return RegisterPass(CreateWrapOpKillPass())
+  Impl::FlagScope flag_scope(impl_.get(), "-O");
+  RegisterPass(CreateWrapOpKillPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateMergeReturnPass())
       .RegisterPass(CreateInlineExhaustivePass())
@@ -178,6 +301,7 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
       .RegisterPass(CreateLoopUnrollPass(true))
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateRedundancyEliminationPass())
+      .RegisterPass(CreatePartialRedundancyEliminationPass())
       .RegisterPass(CreateCombineAccessChainsPass())
       .RegisterPass(CreateSimplificationPass())
       .RegisterPass(CreateScalarReplacementPass())
@@ -199,11 +323,15 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
       .RegisterPass(CreateRedundancyEliminationPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateBlockMergePass())
-      .RegisterPass(CreateSimplificationPass());
+      .RegisterPass(CreateSimplificationPass())
+      .RegisterPass(CreateInstructionSchedulingPass())
+      .RegisterPass(CreateCanonicalLayoutPass());
+  return *this;
 }
 
 Optimizer& Optimizer::RegisterSizePasses() {
-  return RegisterPass(CreateWrapOpKillPass())
+  Impl::FlagScope flag_scope(impl_.get(), "-Os");
+  RegisterPass(CreateWrapOpKillPass())
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateMergeReturnPass())
       .RegisterPass(CreateInlineExhaustivePass())
@@ -236,6 +364,7 @@ Optimizer& Optimizer::RegisterSizePasses() {
       .RegisterPass(CreateSimplificationPass())
       .RegisterPass(CreateAggressiveDCEPass())
       .RegisterPass(CreateCFGCleanupPass());
+  return *this;
 }
 
 Optimizer& Optimizer::RegisterVulkanToWebGPUPasses() {
@@ -265,6 +394,29 @@ bool Optimizer::RegisterPassesFromFlags(const std::vector<std::string>& flags) {
   return true;
 }
 
+bool Optimizer::RegisterFixedPointPasses(const std::vector<std::string>& flags,
+                                         uint32_t max_iterations) {
+  // Check the flags once, so that errors are reported when registering.
+  {
+    Optimizer optimizer(impl_->target_env);
+    optimizer.SetMessageConsumer(consumer());
+    if (!optimizer.RegisterPassesFromFlags(flags)) return false;
+  }
+
+  // Passes can only be run once, so every iteration gets new instances.
+  spv_target_env env = impl_->target_env;
+  MessageConsumer c = consumer();
+  auto create_passes = [env, c, flags]() {
+    Optimizer optimizer(env);
+    optimizer.SetMessageConsumer(c);
+    optimizer.RegisterPassesFromFlags(flags);
+    return optimizer.impl_->pass_manager.ReleasePasses();
+  };
+  RegisterPass(PassToken(
+      MakeUnique<opt::FixedPointPass>(create_passes, max_iterations)));
+  return true;
+}
+
 bool Optimizer::FlagHasValidForm(const std::string& flag) const {
   if (flag == "-O" || flag == "-Os") {
     return true;
@@ -284,6 +436,7 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
   if (!FlagHasValidForm(flag)) {
     return false;
   }
+  Impl::FlagScope flag_scope(impl_.get(), flag);
 
   // Split flags of the form --pass_name=pass_args.
   auto p = utils::SplitFlagArgs(flag);
@@ -331,6 +484,24 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateInlineExhaustivePass());
   } else if (pass_name == "inline-entry-points-opaque") {
     RegisterPass(CreateInlineOpaquePass());
+  } else if (pass_name == "inline-entry-points-selective") {
+    if (pass_args.size() == 0) {
+      RegisterPass(CreateInlineSelectivePass());
+    } else {
+      int budget = -1;
+      if (pass_args.find_first_not_of("0123456789") == std::string::npos) {
+        budget = atoi(pass_args.c_str());
+      }
+
+      if (budget >= 0) {
+        RegisterPass(CreateInlineSelectivePass(budget));
+      } else {
+        Error(consumer(), nullptr, {},
+              "--inline-entry-points-selective must have no arguments or a "
+              "non-negative integer argument");
+        return false;
+      }
+    }
   } else if (pass_name == "combine-access-chains") {
     RegisterPass(CreateCombineAccessChainsPass());
   } else if (pass_name == "convert-local-access-chains") {
@@ -363,6 +534,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateEliminateDeadConstantPass());
   } else if (pass_name == "eliminate-dead-inserts") {
     RegisterPass(CreateDeadInsertElimPass());
+  } else if (pass_name == "eliminate-dead-stores") {
+    RegisterPass(CreateDeadStoreElimPass());
   } else if (pass_name == "eliminate-dead-variables") {
     RegisterPass(CreateDeadVariableEliminationPass());
   } else if (pass_name == "eliminate-dead-members") {
@@ -407,6 +580,14 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateReduceLoadSizePass());
   } else if (pass_name == "redundancy-elimination") {
     RegisterPass(CreateRedundancyEliminationPass());
+  } else if (pass_name == "partial-redundancy-elimination") {
+    RegisterPass(CreatePartialRedundancyEliminationPass());
+  } else if (pass_name == "jump-threading") {
+    RegisterPass(CreateJumpThreadingPass());
+  } else if (pass_name == "schedule-instructions") {
+    RegisterPass(CreateInstructionSchedulingPass());
+  } else if (pass_name == "canonical-layout") {
+    RegisterPass(CreateCanonicalLayoutPass());
   } else if (pass_name == "private-to-local") {
     RegisterPass(CreatePrivateToLocalPass());
   } else if (pass_name == "remove-duplicates") {
@@ -442,6 +623,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateRelaxFloatOpsPass());
   } else if (pass_name == "inst-debug-printf") {
     RegisterPass(CreateInstDebugPrintfPass(7, 23));
+  } else if (pass_name == "inst-block-profile") {
+    RegisterPass(CreateInstBlockProfilePass(7, 23));
   } else if (pass_name == "simplify-instructions") {
     RegisterPass(CreateSimplificationPass());
   } else if (pass_name == "ssa-rewrite") {
@@ -476,6 +659,8 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
     RegisterPass(CreateUpgradeMemoryModelPass());
   } else if (pass_name == "vector-dce") {
     RegisterPass(CreateVectorDCEPass());
+  } else if (pass_name == "slp-vectorize") {
+    RegisterPass(CreateSLPVectorizePass());
   } else if (pass_name == "loop-unroll-partial") {
     int factor = (pass_args.size() > 0) ? atoi(pass_args.c_str()) : 0;
     if (factor > 0) {
@@ -485,6 +670,24 @@ bool Optimizer::RegisterPassFromFlag(const std::string& flag) {
             "--loop-unroll-partial must have a positive integer argument");
       return false;
     }
+  } else if (pass_name == "loop-unroll-heuristic") {
+    if (pass_args.size() == 0) {
+      RegisterPass(CreateHeuristicLoopUnrollPass());
+    } else {
+      int budget = -1;
+      if (pass_args.find_first_not_of("0123456789") == std::string::npos) {
+        budget = atoi(pass_args.c_str());
+      }
+
+      if (budget >= 0) {
+        RegisterPass(CreateHeuristicLoopUnrollPass(budget));
+      } else {
+        Error(consumer(), nullptr, {},
+              "--loop-unroll-heuristic must have no arguments or a "
+              "non-negative integer argument");
+        return false;
+      }
+    }
   } else if (pass_name == "loop-peeling") {
     RegisterPass(CreateLoopPeelingPass());
   } else if (pass_name == "loop-peeling-threshold") {
@@ -555,59 +758,475 @@ bool Optimizer::Run(const uint32_t* original_binary,
              opt_options);
 }
 
-bool Optimizer::Run(const uint32_t* original_binary,
-                    const size_t original_binary_size,
-                    std::vector<uint32_t>* optimized_binary,
-                    const spv_optimizer_options opt_options) const {
-  spvtools::SpirvTools tools(impl_->target_env);
-  tools.SetMessageConsumer(impl_->pass_manager.consumer());
-  if (opt_options->run_validator_ &&
-      !tools.Validate(original_binary, original_binary_size,
-                      &opt_options->val_options_)) {
-    return false;
+std::unique_ptr<opt::IRContext> Optimizer::Impl::Build(
+    const uint32_t* original_binary, size_t original_binary_size,
+    spv_optimizer_options opt_options) {
+  // The module is built from the instructions the validator parsed, so a
+  // module that is validated is parsed only once.  A module the validation
+  // cache knows to be valid is not parsed by the validator at all.
+  //
+  // The validation stops with the optimization, unless it has a cancellation
+  // function of its own, and likewise uses the executor of this optimizer.
+  // The options must outlive |vstate|.
+  spv_validator_options_t val_options = opt_options->val_options_;
+  if (!val_options.cancel) {
+    val_options.cancel = opt_options->cancel_;
+    val_options.cancel_data = opt_options->cancel_data_;
+  }
+  if (!val_options.executor && executor) {
+    val_options.executor = &Executor::Run;
+    val_options.executor_data = executor;
+  }
+  std::unique_ptr<val::ValidationState_t> vstate;
+  if (opt_options->run_validator_) {
+    spv_context val_context = spvContextCreate(target_env);
+    SetContextMessageConsumer(val_context, pass_manager.consumer());
+    const spv_result_t result = val::ValidateWithOptionsAndKeepValidationState(
+        val_context, &val_options, original_binary, original_binary_size,
+        /* pDiagnostic = */ nullptr, &vstate);
+    spvContextDestroy(val_context);
+    if (result != SPV_SUCCESS) return nullptr;
   }
 
-  std::unique_ptr<opt::IRContext> context = BuildModule(
-      impl_->target_env, consumer(), original_binary, original_binary_size);
-  if (context == nullptr) return false;
+  std::unique_ptr<opt::IRContext> context =
+      vstate ? BuildModule(target_env, pass_manager.consumer(),
+                           original_binary, original_binary_size, *vstate,
+                           opt_options->use_instruction_arena_,
+                           pass_manager.CanSkipDebugLineInstsOnLoad())
+             : BuildModule(target_env, pass_manager.consumer(),
+                           original_binary, original_binary_size,
+                           opt_options->use_instruction_arena_,
+                           pass_manager.CanSkipDebugLineInstsOnLoad());
+  if (context == nullptr) return nullptr;
+
+  Configure(context.get(), opt_options);
+  return context;
+}
 
+void Optimizer::Impl::Configure(opt::IRContext* context,
+                                spv_optimizer_options opt_options) {
   context->set_max_id_bound(opt_options->max_id_bound_);
   context->set_preserve_bindings(opt_options->preserve_bindings_);
   context->set_preserve_spec_constants(opt_options->preserve_spec_constants_);
+  context->set_cancel(opt_options->cancel_, opt_options->cancel_data_);
+  context->set_executor(executor ? &Executor::Run : nullptr, executor);
+  context->set_function_cache(function_cache);
+  if (!profile.empty()) {
+    std::unordered_map<uint32_t, uint32_t> block_functions;
+    for (auto& func : *context->module()) {
+      for (auto& block : func) block_functions[block.id()] = func.result_id();
+    }
+    for (const auto& entry : profile) {
+      auto it = block_functions.find(entry.block_id);
+      if (it != block_functions.end() && it->second == entry.function_id) {
+        context->SetBlockExecutionCount(entry.block_id, entry.count);
+      }
+    }
+  }
+}
+
+std::unique_ptr<opt::IRContext> Optimizer::Impl::Optimize(
+    const uint32_t* original_binary, size_t original_binary_size,
+    spv_optimizer_options opt_options, bool* changed) {
+  std::unique_ptr<opt::IRContext> context =
+      Build(original_binary, original_binary_size, opt_options);
+  if (context == nullptr) return nullptr;
 
-  impl_->pass_manager.SetValidatorOptions(&opt_options->val_options_);
-  impl_->pass_manager.SetTargetEnv(impl_->target_env);
-  auto status = impl_->pass_manager.Run(context.get());
+  auto status = RunPasses(context.get(), opt_options);
 
   if (status == opt::Pass::Status::Failure) {
-    return false;
+    return nullptr;
   }
 
+  // The module no longer matches the original binary if its OpLine and OpNoLine
+  // instructions were dropped while building it.
+  *changed = status == opt::Pass::Status::SuccessWithChange ||
+             context->module()->DroppedDebugLineInsts();
+  return context;
+}
+
+namespace {
+
 #ifndef NDEBUG
+// Checks that the module in |context| still matches |original_binary|, as it
+// should if the passes reported no change.  |optimized_binary| is the binary
+// of the module without its OpNop instructions, or nullptr if it overwrote
+// |original_binary|.  This does not serialize the module again: the contents
+// are only compared when the module has no OpNop instruction to skip, and
+// otherwise only the size is checked.
+void CheckUnchangedBinary(opt::IRContext* context,
+                          const uint32_t* original_binary,
+                          size_t original_binary_size,
+                          const uint32_t* optimized_binary,
+                          size_t optimized_binary_size) {
   // We do not keep the result id of DebugScope in struct DebugScope.
   // Instead, we assign random ids for them, which results in integrity
   // check failures. We want to skip the integrity check when the module
   // contains DebugScope instructions.
-  if (status == opt::Pass::Status::SuccessWithoutChange &&
-      !context->module()->ContainsDebugScope()) {
-    std::vector<uint32_t> optimized_binary_with_nop;
-    context->module()->ToBinary(&optimized_binary_with_nop,
-                                /* skip_nop = */ false);
-    assert(optimized_binary_with_nop.size() == original_binary_size &&
-           "Binary size unexpectedly changed despite the optimizer saying "
-           "there was no change");
-    assert(memcmp(optimized_binary_with_nop.data(), original_binary,
-                  original_binary_size) == 0 &&
+  if (context->module()->ContainsDebugScope()) return;
+  assert(context->module()->GetBinarySize(/* skip_nop = */ false) ==
+             original_binary_size &&
+         "Binary size unexpectedly changed despite the optimizer saying "
+         "there was no change");
+  if (optimized_binary && optimized_binary_size == original_binary_size) {
+    assert(memcmp(optimized_binary, original_binary,
+                  original_binary_size * sizeof(uint32_t)) == 0 &&
            "Binary content unexpectedly changed despite the optimizer saying "
            "there was no change");
   }
+}
 #endif  // !NDEBUG
 
+}  // namespace
+
+bool Optimizer::Run(const uint32_t* original_binary,
+                    const size_t original_binary_size,
+                    std::vector<uint32_t>* optimized_binary,
+                    const spv_optimizer_options opt_options) const {
+  bool changed = false;
+  std::unique_ptr<opt::IRContext> context = impl_->Optimize(
+      original_binary, original_binary_size, opt_options, &changed);
+  if (context == nullptr) return false;
+
   // Note that |original_binary| and |optimized_binary| may share the same
-  // buffer and the below will invalidate |original_binary|.
-  optimized_binary->clear();
+  // buffer, so the module is written to a new buffer, which replaces the old
+  // one afterwards.
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, /* skip_nop = */ true);
+#ifndef NDEBUG
+  if (!changed) {
+    CheckUnchangedBinary(context.get(), original_binary, original_binary_size,
+                         binary.data(), binary.size());
+  }
+#endif  // !NDEBUG
+  *optimized_binary = std::move(binary);
+
+  return true;
+}
+
+bool Optimizer::Run(const uint32_t* original_binary,
+                    const size_t original_binary_size,
+                    uint32_t* optimized_binary,
+                    const size_t optimized_binary_capacity,
+                    size_t* optimized_binary_size,
+                    const spv_optimizer_options opt_options) const {
+  bool changed = false;
+  std::unique_ptr<opt::IRContext> context = impl_->Optimize(
+      original_binary, original_binary_size, opt_options, &changed);
+  if (context == nullptr) return false;
+
+  *optimized_binary_size = context->module()->GetBinarySize(true);
+  if (*optimized_binary_size > optimized_binary_capacity) {
+    Error(consumer(), nullptr, {},
+          ("The optimized binary needs " +
+           std::to_string(*optimized_binary_size) + " words, but only " +
+           std::to_string(optimized_binary_capacity) + " are available")
+              .c_str());
+    return false;
+  }
+
+#ifndef NDEBUG
+  // Whether writing the optimized binary overwrites |original_binary|.
+  const std::less<const uint32_t*> less;
+  const bool overlap =
+      less(optimized_binary, original_binary + original_binary_size) &&
+      less(original_binary, optimized_binary + *optimized_binary_size);
+#endif  // !NDEBUG
   context->module()->ToBinary(optimized_binary, /* skip_nop = */ true);
+#ifndef NDEBUG
+  if (!changed) {
+    CheckUnchangedBinary(context.get(), original_binary, original_binary_size,
+                         overlap ? nullptr : optimized_binary,
+                         *optimized_binary_size);
+  }
+#endif  // !NDEBUG
+
+  return true;
+}
+
+bool Optimizer::Run(LoadedModule* module,
+                    const spv_optimizer_options opt_options) const {
+  if (!module->IsLoaded()) {
+    Error(consumer(), nullptr, {}, "No module to optimize");
+    return false;
+  }
+  opt::IRContext* context = module->impl_->context.get();
+
+  if (opt_options->run_validator_) {
+    std::vector<uint32_t> binary;
+    context->module()->ToBinary(&binary, /* skip_nop = */ false);
+    spvtools::SpirvTools tools(impl_->target_env);
+    tools.SetMessageConsumer(consumer());
+    if (!tools.Validate(binary.data(), binary.size(),
+                        &opt_options->val_options_)) {
+      return false;
+    }
+  }
+
+  // The passes report to the consumer of this optimizer, as they do for the
+  // modules it builds itself, and the module keeps its own consumer after.
+  impl_->Configure(context, opt_options);
+  MessageConsumer module_consumer = context->consumer();
+  context->SetMessageConsumer(consumer());
+  auto status = impl_->RunPasses(context, opt_options);
+  context->SetMessageConsumer(std::move(module_consumer));
+
+  return status != opt::Pass::Status::Failure;
+}
+
+bool Optimizer::RunBatch(
+    const std::vector<std::vector<uint32_t>>& original_binaries,
+    std::vector<std::vector<uint32_t>>* optimized_binaries,
+    std::vector<bool>* results, const spv_optimizer_options opt_options,
+    uint32_t num_threads) const {
+  if (impl_->has_passes_without_flag) {
+    Error(consumer(), nullptr, {},
+          "RunBatch requires all passes to be registered from flags");
+    return false;
+  }
 
+  optimized_binaries->assign(original_binaries.size(), {});
+  results->assign(original_binaries.size(), false);
+
+  // Passes can only be run once, so every module gets its own pass manager.
+  // Each result is written to its own element, so no locking is needed.
+  std::vector<char> succeeded(original_binaries.size(), 0);
+  std::atomic<size_t> next_module(0);
+  auto optimize_modules = [&]() {
+    for (size_t i = next_module++; i < original_binaries.size();
+         i = next_module++) {
+      Optimizer optimizer(impl_->target_env);
+      optimizer.SetMessageConsumer(consumer());
+      optimizer.SetExecutor(impl_->executor);
+      optimizer.RegisterPassesFromFlags(impl_->pass_flags);
+      const auto& binary = original_binaries[i];
+      succeeded[i] = optimizer.Run(binary.data(), binary.size(),
+                                   &(*optimized_binaries)[i], opt_options);
+    }
+  };
+
+  size_t num_workers = std::min<size_t>(std::max(num_threads, 1u),
+                                        original_binaries.size());
+  impl_->RunOnWorkers(num_workers, optimize_modules);
+
+  for (size_t i = 0; i < succeeded.size(); ++i) {
+    (*results)[i] = succeeded[i] != 0;
+  }
+  return true;
+}
+
+bool Optimizer::ComputeEntryPointStats(
+    const uint32_t* binary, size_t binary_size,
+    std::vector<EntryPointStats>* stats) const {
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(impl_->target_env, consumer(), binary, binary_size);
+  if (context == nullptr) return false;
+
+  stats->clear();
+  for (const auto& entry_stats : opt::ComputeEntryPointStats(context.get())) {
+    EntryPointStats public_stats;
+    public_stats.name = entry_stats.name;
+    public_stats.execution_model = entry_stats.execution_model;
+    public_stats.alu_instructions = entry_stats.alu_instructions;
+    public_stats.memory_instructions = entry_stats.memory_instructions;
+    public_stats.texture_instructions = entry_stats.texture_instructions;
+    public_stats.control_instructions = entry_stats.control_instructions;
+    public_stats.barriers = entry_stats.barriers;
+    public_stats.dynamic_branches = entry_stats.dynamic_branches;
+    public_stats.max_live_registers = entry_stats.max_live_registers;
+    stats->push_back(std::move(public_stats));
+  }
+  return true;
+}
+
+namespace {
+
+// The flags that |Optimizer::SearchPassFlags| adds to its candidates.  Flags
+// with parameters appear once for each parameter the search tries.
+const char* const kSearchFlags[] = {
+    "--ccp",
+    "--code-sink",
+    "--combine-access-chains",
+    "--convert-local-access-chains",
+    "--copy-propagate-arrays",
+    "--eliminate-dead-branches",
+    "--eliminate-dead-code-aggressive",
+    "--eliminate-local-multi-store",
+    "--eliminate-local-single-block",
+    "--eliminate-local-single-store",
+    "--if-conversion",
+    "--inline-entry-points-exhaustive",
+    "--inline-entry-points-selective=25",
+    "--inline-entry-points-selective=100",
+    "--inline-entry-points-selective=400",
+    "--jump-threading",
+    "--local-redundancy-elimination",
+    "--loop-invariant-code-motion",
+    "--loop-peeling",
+    "--loop-unroll",
+    "--loop-unroll-heuristic",
+    "--loop-unroll-partial=2",
+    "--loop-unroll-partial=4",
+    "--loop-unroll-partial=8",
+    "--merge-blocks",
+    "--merge-return",
+    "--private-to-local",
+    "--redundancy-elimination",
+    "--scalar-replacement=0",
+    "--scalar-replacement=50",
+    "--scalar-replacement=100",
+    "--scalar-replacement=400",
+    "--simplify-instructions",
+    "--ssa-rewrite",
+    "--vector-dce",
+};
+
+// Returns a copy of |flags| with one random change: a flag of |kSearchFlags|
+// is inserted, or a flag is removed, replaced by one of |kSearchFlags| or
+// swapped with the next one.
+std::vector<std::string> MutateSearchFlags(std::vector<std::string> flags,
+                                           std::mt19937* rng) {
+  auto random_index = [rng](size_t size) {
+    return std::uniform_int_distribution<size_t>(0, size - 1)(*rng);
+  };
+  auto random_search_flag = [&random_index]() {
+    return std::string(kSearchFlags[random_index(
+        sizeof(kSearchFlags) / sizeof(kSearchFlags[0]))]);
+  };
+
+  const size_t change = flags.empty() ? 0 : random_index(4);
+  if (change == 1 && flags.size() > 1) {
+    flags.erase(flags.begin() + random_index(flags.size()));
+  } else if (change == 2) {
+    flags[random_index(flags.size())] = random_search_flag();
+  } else if (change == 3 && flags.size() > 1) {
+    const size_t i = random_index(flags.size() - 1);
+    std::swap(flags[i], flags[i + 1]);
+  } else {
+    const size_t position = random_index(flags.size() + 1);
+    flags.insert(flags.begin() + position, random_search_flag());
+  }
+  return flags;
+}
+
+// Returns the cost of the module in |context|, whose binary is |binary|, as
+// measured by |search_options|.
+double GetSearchCost(opt::IRContext* context,
+                     const std::vector<uint32_t>& binary,
+                     const Optimizer::SearchOptions& search_options) {
+  switch (search_options.cost) {
+    case Optimizer::SearchCost::kInstructionCount: {
+      size_t count = 0;
+      context->module()->ForEachInst(
+          [&count](const opt::Instruction*) { ++count; });
+      return static_cast<double>(count);
+    }
+    case Optimizer::SearchCost::kRegisterPressure: {
+      size_t pressure = 0;
+      opt::LivenessAnalysis* liveness = context->GetLivenessAnalysis();
+      for (auto& func : *context->module()) {
+        const opt::RegisterLiveness* func_liveness = liveness->Get(&func);
+        for (auto& block : func) {
+          const auto* block_liveness = func_liveness->Get(&block);
+          if (block_liveness == nullptr) continue;
+          pressure = std::max(pressure, block_liveness->used_registers_);
+        }
+      }
+      return static_cast<double>(pressure);
+    }
+    case Optimizer::SearchCost::kCustom:
+      break;
+  }
+  return search_options.custom_cost(binary);
+}
+
+}  // namespace
+
+bool Optimizer::SearchPassFlags(const uint32_t* original_binary,
+                                size_t original_binary_size,
+                                const spv_optimizer_options opt_options,
+                                const SearchOptions& search_options,
+                                SearchResult* result) const {
+  if (impl_->has_passes_without_flag) {
+    Error(consumer(), nullptr, {},
+          "SearchPassFlags requires all passes to be registered from flags");
+    return false;
+  }
+  if (search_options.cost == SearchCost::kCustom &&
+      !search_options.custom_cost) {
+    Error(consumer(), nullptr, {}, "No custom cost function to search with");
+    return false;
+  }
+
+  std::unique_ptr<opt::IRContext> module =
+      impl_->Build(original_binary, original_binary_size, opt_options);
+  if (module == nullptr) return false;
+
+  // Optimizes a copy of |module| with the flags of |candidate|, and sets its
+  // binary and cost.  Returns false if the flags fail to optimize the module
+  // or produce an invalid one.  Only reads |module|, so candidates can be
+  // evaluated at the same time.
+  auto evaluate = [this, &module, opt_options,
+                   &search_options](SearchResult* candidate) {
+    Optimizer optimizer(impl_->target_env);
+    if (!optimizer.RegisterPassesFromFlags(candidate->flags)) return false;
+    std::unique_ptr<opt::IRContext> context = module->Clone();
+    opt::PassManager& pass_manager = optimizer.impl_->pass_manager;
+    pass_manager.SetValidatorOptions(&opt_options->val_options_);
+    pass_manager.SetTargetEnv(impl_->target_env);
+    if (pass_manager.Run(context.get()) == opt::Pass::Status::Failure) {
+      return false;
+    }
+    std::vector<uint32_t>& binary = candidate->binary;
+    context->module()->ToBinary(&binary, /* skip_nop = */ true);
+    SpirvTools tools(impl_->target_env);
+    if (opt_options->run_validator_ &&
+        !tools.Validate(binary.data(), binary.size(),
+                        &opt_options->val_options_)) {
+      return false;
+    }
+    candidate->cost = GetSearchCost(context.get(), binary, search_options);
+    return true;
+  };
+
+  SearchResult best;
+  best.flags = impl_->pass_flags;
+  if (best.flags.empty()) best.flags.push_back("-O");
+  if (!evaluate(&best)) {
+    Error(consumer(), nullptr, {}, "The starting pass flags failed");
+    return false;
+  }
+
+  // The candidates of a round are all made before any is evaluated, so the
+  // result does not depend on the order in which the threads finish.
+  std::mt19937 rng(search_options.seed);
+  const size_t num_candidates = search_options.candidates_per_round;
+  for (uint32_t round = 0; round < search_options.num_rounds; ++round) {
+    std::vector<SearchResult> candidates(num_candidates);
+    for (auto& candidate : candidates) {
+      candidate.flags = MutateSearchFlags(best.flags, &rng);
+    }
+
+    std::vector<char> succeeded(num_candidates, 0);
+    std::atomic<size_t> next_candidate(0);
+    auto evaluate_candidates = [&]() {
+      for (size_t i = next_candidate++; i < num_candidates;
+           i = next_candidate++) {
+        succeeded[i] = evaluate(&candidates[i]);
+      }
+    };
+    size_t num_workers = std::min<size_t>(
+        std::max(search_options.num_threads, 1u), num_candidates);
+    impl_->RunOnWorkers(num_workers, evaluate_candidates);
+
+    for (size_t i = 0; i < num_candidates; ++i) {
+      if (succeeded[i] && candidates[i].cost < best.cost) {
+        best = std::move(candidates[i]);
+      }
+    }
+  }
+
+  *result = std::move(best);
   return true;
 }
 
@@ -616,16 +1235,208 @@ Optimizer& Optimizer::SetPrintAll(std::ostream* out) {
   return *this;
 }
 
+Optimizer& Optimizer::SetPrintChanged(std::ostream* out) {
+  impl_->pass_manager.SetPrintChanged(out);
+  return *this;
+}
+
 Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
   impl_->pass_manager.SetTimeReport(out);
   return *this;
 }
 
+Optimizer& Optimizer::SetTimeReportCounters(uint32_t counters) {
+  uint32_t hardware_counters = 0;
+  if (counters & kTimeReportInstructions) {
+    hardware_counters |= utils::kHardwareCounterInstructions;
+  }
+  if (counters & kTimeReportCacheMisses) {
+    hardware_counters |= utils::kHardwareCounterCacheMisses;
+  }
+  if (counters & kTimeReportBranchMisses) {
+    hardware_counters |= utils::kHardwareCounterBranchMisses;
+  }
+  impl_->pass_manager.SetTimeReportCounters(hardware_counters);
+  return *this;
+}
+
+Optimizer& Optimizer::SetJsonTimeReport(std::ostream* out) {
+  impl_->pass_manager.SetJsonTimeReport(out);
+  return *this;
+}
+
+Optimizer& Optimizer::SetTraceReport(std::ostream* out) {
+  impl_->pass_manager.SetTraceReport(out);
+  return *this;
+}
+
+Optimizer& Optimizer::SetSkipUnchangedPasses(bool skip) {
+  impl_->pass_manager.SetSkipUnchangedPasses(skip);
+  return *this;
+}
+
 Optimizer& Optimizer::SetValidateAfterAll(bool validate) {
   impl_->pass_manager.SetValidateAfterAll(validate);
   return *this;
 }
 
+Optimizer& Optimizer::SetNumThreads(uint32_t num_threads) {
+  impl_->pass_manager.SetNumThreads(num_threads);
+  return *this;
+}
+
+Optimizer& Optimizer::SetWorkCounts(WorkCounts* counts) {
+  impl_->work_counts = counts;
+  return *this;
+}
+
+Optimizer& Optimizer::SetExecutor(Executor* executor) {
+  impl_->executor = executor;
+  return *this;
+}
+
+std::future<bool> Optimizer::RunAsync(
+    std::vector<uint32_t> original_binary,
+    std::vector<uint32_t>* optimized_binary,
+    const spv_optimizer_options opt_options) const {
+  auto shared_binary =
+      std::make_shared<std::vector<uint32_t>>(std::move(original_binary));
+  auto shared_options = std::make_shared<spv_optimizer_options_t>(*opt_options);
+  return utils::RunAsync<bool>(
+      impl_->executor ? &Executor::Run : nullptr, impl_->executor,
+      [this, shared_binary, optimized_binary, shared_options]() {
+        return Run(shared_binary->data(), shared_binary->size(),
+                   optimized_binary, shared_options.get());
+      });
+}
+
+Optimizer& Optimizer::SetMaxMemory(size_t max_memory) {
+  impl_->pass_manager.SetMaxMemory(max_memory);
+  return *this;
+}
+
+Optimizer& Optimizer::SetProfile(std::vector<BlockExecutionCount> profile) {
+  impl_->profile = std::move(profile);
+  return *this;
+}
+
+struct FunctionCache::Impl {
+  opt::FunctionResultCache cache;  // The results, keyed by canonical function.
+};
+
+Optimizer& Optimizer::SetFunctionCache(FunctionCache* cache) {
+  impl_->function_cache = cache ? &cache->impl_->cache : nullptr;
+  return *this;
+}
+
+FunctionCache::FunctionCache() : impl_(new Impl()) {}
+
+FunctionCache::~FunctionCache() {}
+
+size_t FunctionCache::size() const { return impl_->cache.size(); }
+
+size_t FunctionCache::num_hits() const { return impl_->cache.num_hits(); }
+
+size_t FunctionCache::num_misses() const { return impl_->cache.num_misses(); }
+
+void FunctionCache::Clear() { impl_->cache.clear(); }
+
+struct SpecializationCache::Impl {
+  explicit Impl(spv_target_env env) : target_env(env) {}
+
+  spv_target_env target_env;  // Target environment.
+  MessageConsumer consumer;   // Message consumer of the variant passes.
+  // The optimized generic module, or nullptr if it has not been set.
+  std::unique_ptr<opt::IRContext> generic_module;
+};
+
+SpecializationCache::SpecializationCache(spv_target_env env)
+    : impl_(new Impl(env)) {}
+
+SpecializationCache::~SpecializationCache() {}
+
+void SpecializationCache::SetMessageConsumer(MessageConsumer consumer) {
+  impl_->consumer = std::move(consumer);
+}
+
+bool SpecializationCache::SetGenericModule(
+    const Optimizer& optimizer, const uint32_t* generic_binary,
+    size_t generic_binary_size, const spv_optimizer_options opt_options) {
+  bool changed = false;
+  impl_->generic_module = optimizer.impl_->Optimize(
+      generic_binary, generic_binary_size, opt_options, &changed);
+  return impl_->generic_module != nullptr;
+}
+
+bool SpecializationCache::Specialize(
+    const std::unordered_map<uint32_t, std::vector<uint32_t>>& spec_values,
+    std::vector<uint32_t>* variant_binary) const {
+  if (impl_->generic_module == nullptr) {
+    Error(impl_->consumer, nullptr, {}, "No generic module to specialize");
+    return false;
+  }
+
+  // Only the passes that can make use of the frozen values are run again.
+  std::unique_ptr<opt::IRContext> context = impl_->generic_module->Clone();
+  opt::PassManager pass_manager;
+  pass_manager.SetMessageConsumer(impl_->consumer);
+  pass_manager.SetTargetEnv(impl_->target_env);
+  pass_manager.AddPass<opt::SetSpecConstantDefaultValuePass>(spec_values);
+  pass_manager.AddPass<opt::FreezeSpecConstantValuePass>();
+  pass_manager.AddPass<opt::FoldSpecConstantOpAndCompositePass>();
+  pass_manager.AddPass<opt::CCPPass>();
+  pass_manager.AddPass<opt::DeadBranchElimPass>();
+  pass_manager.AddPass<opt::AggressiveDCEPass>();
+  if (pass_manager.Run(context.get()) == opt::Pass::Status::Failure) {
+    return false;
+  }
+
+  variant_binary->clear();
+  context->module()->ToBinary(variant_binary, /* skip_nop = */ true);
+  return true;
+}
+
+LoadedModule::LoadedModule() : impl_(new Impl()) {}
+
+LoadedModule::~LoadedModule() {}
+
+LoadedModule::LoadedModule(LoadedModule&& that) : impl_(new Impl()) {
+  std::swap(impl_, that.impl_);
+}
+
+LoadedModule& LoadedModule::operator=(LoadedModule&& that) {
+  std::swap(impl_, that.impl_);
+  return *this;
+}
+
+bool LoadedModule::Load(spv_target_env env, MessageConsumer consumer,
+                        const uint32_t* binary, size_t binary_size) {
+  impl_->env = env;
+  impl_->consumer = consumer;
+  impl_->context = BuildModule(env, std::move(consumer), binary, binary_size);
+  return impl_->context != nullptr;
+}
+
+bool LoadedModule::IsLoaded() const { return impl_->context != nullptr; }
+
+bool LoadedModule::ToBinary(std::vector<uint32_t>* binary) const {
+  if (!IsLoaded()) return false;
+  binary->clear();
+  impl_->context->module()->ToBinary(binary, /* skip_nop = */ true);
+  return true;
+}
+
+bool LoadedModule::Validate(const ValidatorOptions& options) const {
+  std::vector<uint32_t> binary;
+  if (!ToBinary(&binary)) {
+    Error(impl_->consumer, nullptr, {}, "No module to validate");
+    return false;
+  }
+  spvtools::SpirvTools tools(impl_->env);
+  tools.SetMessageConsumer(impl_->consumer);
+  return tools.Validate(binary.data(), binary.size(), options);
+}
+
 Optimizer::PassToken CreateNullPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::NullPass>());
 }
@@ -717,6 +1528,12 @@ Optimizer::PassToken CreateInlineOpaquePass() {
       MakeUnique<opt::InlineOpaquePass>());
 }
 
+Optimizer::PassToken CreateInlineSelectivePass(
+    uint32_t growth_budget_percent) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InlineSelectivePass>(growth_budget_percent));
+}
+
 Optimizer::PassToken CreateLocalAccessChainConvertPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::LocalAccessChainConvertPass>());
@@ -742,6 +1559,11 @@ Optimizer::PassToken CreateDeadInsertElimPass() {
       MakeUnique<opt::DeadInsertElimPass>());
 }
 
+Optimizer::PassToken CreateDeadStoreElimPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::DeadStoreElimPass>());
+}
+
 Optimizer::PassToken CreateDeadBranchElimPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::DeadBranchElimPass>());
@@ -824,6 +1646,21 @@ Optimizer::PassToken CreateRedundancyEliminationPass() {
       MakeUnique<opt::RedundancyEliminationPass>());
 }
 
+Optimizer::PassToken CreatePartialRedundancyEliminationPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::PartialRedundancyEliminationPass>());
+}
+
+Optimizer::PassToken CreateJumpThreadingPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::JumpThreadingPass>());
+}
+
+Optimizer::PassToken CreateInstructionSchedulingPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InstructionSchedulingPass>());
+}
+
 Optimizer::PassToken CreateRemoveDuplicatesPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::RemoveDuplicatesPass>());
@@ -868,6 +1705,13 @@ Optimizer::PassToken CreateLoopUnrollPass(bool fully_unroll, int factor) {
       MakeUnique<opt::LoopUnroller>(fully_unroll, factor));
 }
 
+Optimizer::PassToken CreateHeuristicLoopUnrollPass(
+    uint32_t growth_budget_percent, uint32_t max_register_pressure) {
+  return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::LoopUnroller>(
+      opt::LoopUnroller::Heuristics{growth_budget_percent,
+                                    max_register_pressure}));
+}
+
 Optimizer::PassToken CreateSSARewritePass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::SSARewritePass>());
@@ -882,6 +1726,11 @@ Optimizer::PassToken CreateVectorDCEPass() {
   return MakeUnique<Optimizer::PassToken::Impl>(MakeUnique<opt::VectorDCE>());
 }
 
+Optimizer::PassToken CreateSLPVectorizePass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::SLPVectorizePass>());
+}
+
 Optimizer::PassToken CreateReduceLoadSizePass() {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::ReduceLoadSize>());
@@ -901,23 +1750,42 @@ Optimizer::PassToken CreateInstBindlessCheckPass(uint32_t desc_set,
                                                  uint32_t shader_id,
                                                  bool input_length_enable,
                                                  bool input_init_enable,
-                                                 bool input_buff_oob_enable) {
+                                                 bool input_buff_oob_enable,
+                                                 bool reuse_checks_enable,
+                                                 bool subgroup_stream_writes,
+                                                 uint32_t sample_period,
+                                                 int32_t sample_spec_id) {
   return MakeUnique<Optimizer::PassToken::Impl>(
       MakeUnique<opt::InstBindlessCheckPass>(
           desc_set, shader_id, input_length_enable, input_init_enable,
-          input_buff_oob_enable));
+          input_buff_oob_enable, reuse_checks_enable, subgroup_stream_writes,
+          sample_period, sample_spec_id));
 }
 
 Optimizer::PassToken CreateInstDebugPrintfPass(uint32_t desc_set,
-                                               uint32_t shader_id) {
+                                               uint32_t shader_id,
+                                               bool subgroup_stream_writes) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InstDebugPrintfPass>(desc_set, shader_id,
+                                           subgroup_stream_writes));
+}
+
+Optimizer::PassToken CreateInstBlockProfilePass(uint32_t desc_set,
+                                                uint32_t shader_id) {
   return MakeUnique<Optimizer::PassToken::Impl>(
-      MakeUnique<opt::InstDebugPrintfPass>(desc_set, shader_id));
+      MakeUnique<opt::InstBlockProfilePass>(desc_set, shader_id));
 }
 
 Optimizer::PassToken CreateInstBuffAddrCheckPass(uint32_t desc_set,
-                                                 uint32_t shader_id) {
+                                                 uint32_t shader_id,
+                                                 bool subgroup_stream_writes,
+                                                 uint32_t sample_period,
+                                                 int32_t sample_spec_id,
+                                                 bool combine_checks) {
   return MakeUnique<Optimizer::PassToken::Impl>(
-      MakeUnique<opt::InstBuffAddrCheckPass>(desc_set, shader_id));
+      MakeUnique<opt::InstBuffAddrCheckPass>(
+          desc_set, shader_id, subgroup_stream_writes, sample_period,
+          sample_spec_id, combine_checks));
 }
 
 Optimizer::PassToken CreateConvertRelaxedToHalfPass() {
@@ -979,4 +1847,9 @@ Optimizer::PassToken CreateAmdExtToKhrPass() {
       MakeUnique<opt::AmdExtensionToKhrPass>());
 }
 
+Optimizer::PassToken CreateCanonicalLayoutPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::CanonicalLayoutPass>());
+}
+
 }  // namespace spvtools
@@ -0,0 +1,212 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/partial_redundancy_elimination.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "source/opt/struct_cfg_analysis.h"
+
+namespace spvtools {
+namespace opt {
+
+bool PartialRedundancyEliminationPass::IsCandidate(
+    const Instruction& inst) const {
+  if (inst.result_id() == 0 || inst.type_id() == 0) return false;
+  if (!context()->IsCombinatorInstruction(&inst)) return false;
+
+  switch (inst.opcode()) {
+    // Moving loads and images is not worth the trouble, and phis are what
+    // this pass creates.
+    case SpvOpPhi:
+    case SpvOpLoad:
+    case SpvOpSampledImage:
+    case SpvOpImage:
+    case SpvOpVariable:
+      return false;
+    default:
+      break;
+  }
+
+  // Only values that an OpPhi can merge in any addressing model.
+  switch (get_def_use_mgr()->GetDef(inst.type_id())->opcode()) {
+    case SpvOpTypeBool:
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Instruction* PartialRedundancyEliminationPass::FindAvailable(
+    const ValueToInsts& value_to_insts, uint32_t value, const Instruction* inst,
+    BasicBlock* block) const {
+  auto insts = value_to_insts.find(value);
+  if (insts == value_to_insts.end()) return nullptr;
+
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(block->GetParent());
+  for (Instruction* candidate : insts->second) {
+    if (candidate != inst &&
+        dom->Dominates(context()->get_instr_block(candidate), block)) {
+      return candidate;
+    }
+  }
+  return nullptr;
+}
+
+bool PartialRedundancyEliminationPass::EliminateInMerge(
+    BasicBlock* merge, const ValueNumberTable& vn_table,
+    ValueToInsts* value_to_insts, bool* modified) {
+  const std::vector<uint32_t>& preds = cfg()->preds(merge->id());
+  if (preds.size() < 2) return true;
+
+  DominatorAnalysis* dom = context()->GetDominatorAnalysis(merge->GetParent());
+  std::vector<BasicBlock*> pred_blocks;
+  for (uint32_t pred_id : preds) {
+    if (!dom->IsReachable(pred_id)) return true;
+    pred_blocks.push_back(cfg()->block(pred_id));
+  }
+
+  std::vector<Instruction*> candidates;
+  for (Instruction& inst : *merge) {
+    if (IsCandidate(inst)) candidates.push_back(&inst);
+  }
+
+  for (Instruction* inst : candidates) {
+    uint32_t value = vn_table.GetValueNumber(inst);
+    if (value == 0) continue;
+
+    // The operands must be available at the end of the predecessors, so
+    // they cannot be defined in |merge| itself.
+    bool operands_available =
+        inst->WhileEachInId([this, merge](const uint32_t* id) {
+          return context()->get_instr_block(*id) != merge;
+        });
+    if (!operands_available) continue;
+
+    // The value is only recomputed where |inst| would be executed anyway: at
+    // the end of predecessors whose only successor is |merge|.  To bound the
+    // code growth, it must already be available in at least as many
+    // predecessors as those it is added to.
+    std::vector<Instruction*> available;
+    size_t missing = 0;
+    bool can_insert = true;
+    for (BasicBlock* pred : pred_blocks) {
+      Instruction* available_inst =
+          FindAvailable(*value_to_insts, value, inst, pred);
+      available.push_back(available_inst);
+      if (available_inst != nullptr) continue;
+      ++missing;
+      if (pred->tail()->opcode() != SpvOpBranch ||
+          pred->GetMergeInst() != nullptr) {
+        can_insert = false;
+      }
+    }
+    if (!can_insert || missing > pred_blocks.size() - missing) continue;
+
+    uint32_t replacement = 0;
+    if (missing == 0 && std::all_of(available.begin(), available.end(),
+                                    [&available](const Instruction* i) {
+                                      return i == available.front();
+                                    })) {
+      // The value is fully redundant with a computation dominating |merge|.
+      replacement = available.front()->result_id();
+    } else {
+      for (size_t i = 0; i < pred_blocks.size(); ++i) {
+        if (available[i] != nullptr) continue;
+        uint32_t clone_id = TakeNextId();
+        if (clone_id == 0) return false;
+        std::unique_ptr<Instruction> clone(inst->Clone(context()));
+        clone->SetResultId(clone_id);
+        Instruction* added = pred_blocks[i]->tail()->InsertBefore(
+            std::move(clone));
+        get_def_use_mgr()->AnalyzeInstDefUse(added);
+        context()->set_instr_block(added, pred_blocks[i]);
+        get_decoration_mgr()->CloneDecorations(inst->result_id(), clone_id);
+        (*value_to_insts)[value].push_back(added);
+        available[i] = added;
+      }
+
+      replacement = TakeNextId();
+      if (replacement == 0) return false;
+      Instruction::OperandList phi_operands;
+      for (size_t i = 0; i < pred_blocks.size(); ++i) {
+        phi_operands.push_back(
+            {SPV_OPERAND_TYPE_ID, {available[i]->result_id()}});
+        phi_operands.push_back({SPV_OPERAND_TYPE_ID, {preds[i]}});
+      }
+      std::unique_ptr<Instruction> phi(new Instruction(
+          context(), SpvOpPhi, inst->type_id(), replacement, phi_operands));
+      Instruction* added = merge->begin()->InsertBefore(std::move(phi));
+      get_def_use_mgr()->AnalyzeInstDefUse(added);
+      context()->set_instr_block(added, merge);
+    }
+
+    std::vector<Instruction*>& insts = (*value_to_insts)[value];
+    insts.erase(std::find(insts.begin(), insts.end(), inst));
+    context()->KillNamesAndDecorates(inst);
+    context()->ReplaceAllUsesWith(inst->result_id(), replacement);
+    context()->KillInst(inst);
+    *modified = true;
+  }
+  return true;
+}
+
+Pass::Status PartialRedundancyEliminationPass::ProcessFunction(Function* func) {
+  const ValueNumberTable& vn_table = *context()->GetValueNumberTable();
+  StructuredCFGAnalysis* struct_cfg = context()->GetStructuredCFGAnalysis();
+
+  ValueToInsts value_to_insts;
+  for (BasicBlock& bb : *func) {
+    for (Instruction& inst : bb) {
+      if (!IsCandidate(inst)) continue;
+      uint32_t value = vn_table.GetValueNumber(&inst);
+      if (value != 0) value_to_insts[value].push_back(&inst);
+    }
+  }
+
+  // Visiting the merges in dominator order makes the computations added for
+  // one merge available to the merges it dominates.  Loop headers are left to
+  // LICM.
+  bool modified = false;
+  DominatorTree& dom_tree = context()->GetDominatorAnalysis(func)->GetDomTree();
+  for (DominatorTreeNode& node : dom_tree) {
+    BasicBlock* bb = node.bb_;
+    if (!struct_cfg->IsMergeBlock(bb->id()) || bb->GetLoopMergeInst()) {
+      continue;
+    }
+    if (!EliminateInMerge(bb, vn_table, &value_to_insts, &modified)) {
+      return Status::Failure;
+    }
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+Pass::Status PartialRedundancyEliminationPass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    Status status = ProcessFunction(&func);
+    if (status == Status::Failure) return Status::Failure;
+    modified |= status == Status::SuccessWithChange;
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
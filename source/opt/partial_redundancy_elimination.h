@@ -0,0 +1,73 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
+#define SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/pass.h"
+#include "source/opt/value_number_table.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class PartialRedundancyEliminationPass : public Pass {
+ public:
+  const char* name() const override {
+    return "partial-redundancy-elimination";
+  }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse | IRContext::kAnalysisCFG |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisDecorations |
+           IRContext::kAnalysisDominatorAnalysis |
+           IRContext::kAnalysisStructuredCFG | IRContext::kAnalysisNameMap |
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes;
+  }
+
+ private:
+  // The instructions of a function computing each value number.
+  using ValueToInsts = std::unordered_map<uint32_t, std::vector<Instruction*>>;
+
+  // Returns true if |inst| computes a value that can be recomputed anywhere it
+  // is available, and merged with an OpPhi.
+  bool IsCandidate(const Instruction& inst) const;
+
+  // Returns an instruction of |value_to_insts| with the value number |value|,
+  // other than |inst|, that is available at the end of |block|, or null if
+  // there is none.
+  Instruction* FindAvailable(const ValueToInsts& value_to_insts, uint32_t value,
+                             const Instruction* inst, BasicBlock* block) const;
+
+  // Removes the partial redundancies of the instructions in the merge block
+  // |merge|.  Returns false if it ran out of ids.  Sets |modified| if
+  // |merge| was changed.
+  bool EliminateInMerge(BasicBlock* merge, const ValueNumberTable& vn_table,
+                        ValueToInsts* value_to_insts, bool* modified);
+
+  // Removes the partial redundancies of |func|.
+  Status ProcessFunction(Function* func);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_PARTIAL_REDUNDANCY_ELIMINATION_H_
@@ -106,6 +106,22 @@ class Pass {
     return IRContext::kAnalysisNone;
   }
 
+  // Returns true if the pass manager may skip this pass when a pass with the
+  // same name has already run without changing the module, and the module has
+  // not changed since.  This holds for any pass whose result only depends on
+  // the module and its name.  Passes that behave differently depending on
+  // arguments that are not part of their name must return false.
+  virtual bool CanSkipIfModuleUnchanged() const { return true; }
+
+  // Returns true if this pass only changes the functions it processes, one at
+  // a time, and examines them with |IRContext::ProcessFunctionsInParallel|.
+  // The pass manager only lets such passes use more than one thread.
+  virtual bool ProcessesFunctionsInParallel() const { return false; }
+
+  // Returns true if this pass removes every OpLine and OpNoLine instruction
+  // from the module, whatever else it does.
+  virtual bool RemovesDebugLineInsts() const { return false; }
+
   // Return type id for |ptrInst|'s pointee
   uint32_t GetPointeeTypeId(const Instruction* ptrInst) const;
 
@@ -14,21 +14,322 @@
 
 #include "source/opt/pass_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <ctime>
 #include <iostream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "source/opt/ir_context.h"
+#include "source/spirv_constant.h"
+#include "source/spirv_validator_options.h"
 #include "source/util/timer.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
 
 namespace opt {
+namespace {
+
+// What the JSON time report records about a pass.
+struct PassReport {
+  std::string name;
+  std::chrono::steady_clock::time_point start;
+  double wall_time = -1;
+  double cpu_time = -1;
+  long rss_delta = -1;
+  size_t instructions_before = 0;
+  size_t instructions_after = 0;
+  bool changed = false;
+  IRContext::AnalysisBuildLog analysis_builds;
+  // The memory used by the module and its analyses after the pass.
+  IRContext::MemoryStats memory;
+};
+
+// Measures the resources used between calls to |Start| and |Stop|.  The RSS
+// is only measured when timers are enabled, and is -1 otherwise.
+class PassResourceMeter {
+ public:
+#if defined(SPIRV_TIMER_ENABLED)
+  PassResourceMeter() : timer_(nullptr, /* measure_mem_usage = */ true) {}
+
+  void Start() { timer_.Start(); }
+
+  void Stop(PassReport* report) {
+    timer_.Stop();
+    report->wall_time = timer_.WallTime();
+    report->cpu_time = timer_.CPUTime();
+    report->rss_delta = timer_.RSS();
+  }
+
+ private:
+  utils::Timer timer_;
+#else
+  void Start() {
+    wall_start_ = std::chrono::steady_clock::now();
+    cpu_start_ = std::clock();
+  }
+
+  void Stop(PassReport* report) {
+    std::chrono::duration<double> wall_time =
+        std::chrono::steady_clock::now() - wall_start_;
+    report->wall_time = wall_time.count();
+    report->cpu_time =
+        static_cast<double>(std::clock() - cpu_start_) / CLOCKS_PER_SEC;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point wall_start_;
+  std::clock_t cpu_start_;
+#endif
+};
+
+size_t CountInstructions(Module* module) {
+  size_t count = 0;
+  module->ForEachInst([&count](const Instruction*) { ++count; });
+  return count;
+}
+
+// Writes |reports| to |out| as a JSON object.
+void PrintJsonTimeReport(std::ostream* out,
+                         const std::vector<PassReport>& reports) {
+  *out << "{\n  \"passes\": [";
+  const char* pass_separator = "\n";
+  for (const auto& report : reports) {
+    *out << pass_separator << "    {\n"
+         << "      \"name\": \"" << report.name << "\",\n"
+         << "      \"wall_time\": " << report.wall_time << ",\n"
+         << "      \"cpu_time\": " << report.cpu_time << ",\n"
+         << "      \"rss_delta\": " << report.rss_delta << ",\n"
+         << "      \"instructions_before\": " << report.instructions_before
+         << ",\n"
+         << "      \"instructions_after\": " << report.instructions_after
+         << ",\n"
+         << "      \"changed\": " << (report.changed ? "true" : "false")
+         << ",\n"
+         << "      \"analysis_builds\": [";
+    const char* build_separator = "";
+    for (const auto& build : report.analysis_builds) {
+      *out << build_separator << "{\"analysis\": \""
+           << IRContext::GetAnalysisName(build.analysis)
+           << "\", \"time\": " << build.time << "}";
+      build_separator = ", ";
+    }
+    *out << "],\n"
+         << "      \"memory\": {\"module\": " << report.memory.module;
+    for (const auto& analysis : report.memory.analyses) {
+      *out << ", \"" << IRContext::GetAnalysisName(analysis.first)
+           << "\": " << analysis.second;
+    }
+    *out << "}\n    }";
+    pass_separator = ",\n";
+  }
+  *out << "\n  ]\n}" << std::endl;
+}
+
+// Writes to |out| the memory used by the module and its analyses after each
+// pass of |reports|, in kilobytes.
+void PrintMemoryReport(std::ostream* out,
+                       const std::vector<PassReport>& reports) {
+  *out << "Memory after each pass (kB):\n";
+  for (const auto& report : reports) {
+    *out << report.name << ": " << report.memory.Total() / 1024
+         << " (module " << report.memory.module / 1024;
+    for (const auto& analysis : report.memory.analyses) {
+      *out << ", " << IRContext::GetAnalysisName(analysis.first) << " "
+           << analysis.second / 1024;
+    }
+    *out << ")\n";
+  }
+  out->flush();
+}
+
+// The analyses that are invalidated when the memory limit is exceeded.  They
+// are cached per function, so they are rebuilt only for the functions later
+// passes look at, unlike the module-wide managers.
+const IRContext::Analysis kAnalysesDroppedUnderMemoryPressure =
+    IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
+    IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisScalarEvolution |
+    IRContext::kAnalysisRegisterPressure |
+    IRContext::kAnalysisValueNumberTable | IRContext::kAnalysisStructuredCFG |
+    IRContext::kAnalysisMemorySSA | IRContext::kAnalysisValueRange;
+
+// Writes one complete event of the Chrome trace event format to |out|, which
+// started |start| seconds after the trace did and lasted |duration| seconds.
+void PrintTraceEvent(std::ostream* out, const char* separator,
+                     const char* category, const std::string& name,
+                     double start, double duration) {
+  *out << separator << "\n    {\"name\": \"" << name << "\", \"cat\": \""
+       << category << "\", \"ph\": \"X\", \"ts\": " << start * 1e6
+       << ", \"dur\": " << duration * 1e6 << ", \"pid\": 0, \"tid\": 0}";
+}
+
+// Writes |reports| to |out| in the Chrome trace event format, with a span for
+// each pass containing a span for each analysis the pass built.  The times are
+// relative to |trace_start|.
+void PrintTraceReport(std::ostream* out,
+                      std::chrono::steady_clock::time_point trace_start,
+                      const std::vector<PassReport>& reports) {
+  auto seconds_since_start = [trace_start](
+                                 std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration<double>(time - trace_start).count();
+  };
+  *out << "{\"traceEvents\": [";
+  const char* separator = "";
+  for (const auto& report : reports) {
+    PrintTraceEvent(out, separator, "pass", report.name,
+                    seconds_since_start(report.start), report.wall_time);
+    separator = ",";
+    for (const auto& build : report.analysis_builds) {
+      PrintTraceEvent(out, separator, "analysis",
+                      IRContext::GetAnalysisName(build.analysis),
+                      seconds_since_start(build.start), build.time);
+    }
+  }
+  *out << "\n]}" << std::endl;
+}
+
+// The binary of a module, split into its module-level instructions and its
+// functions.
+struct ModuleLayout {
+  // A function: its result id, and the range [begin, end) of its words.
+  struct FunctionRange {
+    uint32_t id;
+    size_t begin;
+    size_t end;
+  };
+
+  std::vector<uint32_t> binary;
+  // The number of module-level instructions, which precede the functions,
+  // and the end of their words.
+  size_t num_globals = 0;
+  size_t globals_end = 0;
+  std::vector<FunctionRange> functions;
+};
+
+// Writes the binary of the module of |context| to |layout|, and finds the
+// words of each function in it.
+void GetModuleLayout(IRContext* context, ModuleLayout* layout) {
+  layout->binary.clear();
+  layout->functions.clear();
+  layout->num_globals = 0;
+  context->module()->ToBinary(&layout->binary, false);
+  const std::vector<uint32_t>& binary = layout->binary;
+  layout->globals_end = binary.size();
+  size_t index = SPV_INDEX_INSTRUCTION;
+  while (index < binary.size()) {
+    const uint32_t num_words = binary[index] >> 16;
+    const uint32_t opcode = binary[index] & 0xFFFF;
+    if (num_words == 0) break;
+    if (opcode == SpvOpFunction && index + 2 < binary.size()) {
+      if (layout->functions.empty()) layout->globals_end = index;
+      layout->functions.push_back({binary[index + 2], index, binary.size()});
+    } else if (layout->functions.empty()) {
+      ++layout->num_globals;
+    }
+    index += num_words;
+    if (opcode == SpvOpFunctionEnd && !layout->functions.empty()) {
+      layout->functions.back().end = index;
+    }
+  }
+}
+
+// Writes to |out| which functions and module-level instructions of the module
+// changed from |before| to |after|, and the disassembly of those that did.
+// The functions are matched by their result id.  Only the instructions that
+// are printed are disassembled, besides the module-level instructions that
+// the disassembler needs to print the functions.
+void PrintChangedFunctions(const ModuleLayout& before,
+                           const ModuleLayout& after, const char* pass_name,
+                           std::ostream* out) {
+  auto same_words = [](const ModuleLayout& a, size_t a_begin, size_t a_end,
+                       const ModuleLayout& b, size_t b_begin, size_t b_end) {
+    return a_end - a_begin == b_end - b_begin &&
+           std::equal(a.binary.begin() + a_begin, a.binary.begin() + a_end,
+                      b.binary.begin() + b_begin);
+  };
+  const bool globals_changed =
+      !same_words(before, SPV_INDEX_INSTRUCTION, before.globals_end, after,
+                  SPV_INDEX_INSTRUCTION, after.globals_end);
+
+  std::unordered_map<uint32_t, const ModuleLayout::FunctionRange*> old_ranges;
+  for (const auto& function : before.functions) {
+    old_ranges[function.id] = &function;
+  }
+
+  // The binary to disassemble: the module-level instructions, followed by
+  // the functions that changed.
+  std::vector<uint32_t> changed_binary(
+      after.binary.begin(), after.binary.begin() + after.globals_end);
+  std::vector<uint32_t> changed;
+  for (const auto& function : after.functions) {
+    auto old_range = old_ranges.find(function.id);
+    if (old_range != old_ranges.end()) {
+      const ModuleLayout::FunctionRange* old_function = old_range->second;
+      old_ranges.erase(old_range);
+      if (same_words(before, old_function->begin, old_function->end, after,
+                     function.begin, function.end)) {
+        continue;
+      }
+    }
+    changed.push_back(function.id);
+    changed_binary.insert(changed_binary.end(),
+                          after.binary.begin() + function.begin,
+                          after.binary.begin() + function.end);
+  }
+  std::vector<uint32_t> removed;
+  for (const auto& function : before.functions) {
+    if (old_ranges.count(function.id)) removed.push_back(function.id);
+  }
+
+  *out << "; IR after pass " << pass_name;
+  if (globals_changed) *out << ", module-level instructions changed";
+  if (!changed.empty()) {
+    *out << ", changed functions";
+    for (uint32_t id : changed) *out << " %" << id;
+  }
+  if (!removed.empty()) {
+    *out << ", removed functions";
+    for (uint32_t id : removed) *out << " %" << id;
+  }
+  if (!globals_changed && changed.empty() && removed.empty()) {
+    *out << ", no change";
+  }
+  *out << "\n";
+
+  if (globals_changed || !changed.empty()) {
+    SpirvTools t(SPV_ENV_UNIVERSAL_1_2);
+    std::string disassembly;
+    t.Disassemble(changed_binary, &disassembly,
+                  SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+    // Each instruction is on a line of its own, so the module-level
+    // instructions that did not change are skipped by their count.
+    size_t start = 0;
+    if (!globals_changed) {
+      for (size_t i = 0; i < after.num_globals && start != std::string::npos;
+           ++i) {
+        start = disassembly.find('\n', start);
+        if (start != std::string::npos) ++start;
+      }
+    }
+    if (start != std::string::npos) *out << disassembly.substr(start);
+  }
+  *out << std::endl;
+}
+
+}  // namespace
 
 Pass::Status PassManager::Run(IRContext* context) {
   auto status = Pass::Status::SuccessWithoutChange;
 
+  // Instructions created by the passes come from the context's arena, if it
+  // has one.
+  InstructionArena::Scope arena_scope(context->instruction_arena());
+
   // If print_all_stream_ is not null, prints the disassembly of the module
   // to that stream, with the given preamble and optionally the pass name.
   auto print_disassembly = [&context, this](const char* preamble, Pass* pass) {
@@ -43,32 +344,191 @@ Pass::Status PassManager::Run(IRContext* context) {
     }
   };
 
-  SPIRV_TIMER_DESCRIPTION(time_report_stream_, /* measure_mem_usage = */ true);
+  // If print_changed_stream_ is not null, prints the disassembly of the whole
+  // module before the first pass, and keeps the layout of the module after
+  // the last pass that changed it.
+  ModuleLayout last_layout;
+  if (print_changed_stream_) {
+    GetModuleLayout(context, &last_layout);
+    SpirvTools t(SPV_ENV_UNIVERSAL_1_2);
+    std::string disassembly;
+    t.Disassemble(last_layout.binary, &disassembly, 0);
+    *print_changed_stream_ << "; IR before first pass\n"
+                           << disassembly << std::endl;
+  }
+
+  // If json_time_report_stream_, trace_stream_ or time_report_stream_ is not
+  // null, prints the reports of the passes that have run to that stream.
+  std::vector<PassReport> reports;
+  const bool collect_reports = json_time_report_stream_ != nullptr ||
+                               trace_stream_ != nullptr ||
+                               time_report_stream_ != nullptr;
+  const auto trace_start = std::chrono::steady_clock::now();
+  auto print_json_time_report = [&reports, &trace_start, this]() {
+    if (json_time_report_stream_) {
+      PrintJsonTimeReport(json_time_report_stream_, reports);
+    }
+    if (trace_stream_) {
+      PrintTraceReport(trace_stream_, trace_start, reports);
+    }
+    if (time_report_stream_) {
+      PrintMemoryReport(time_report_stream_, reports);
+    }
+  };
+
+  // If max_memory_ is set and the module and its analyses use more memory,
+  // invalidates the analyses that are cheapest to rebuild.  Returns the
+  // memory used by the module and its analyses, which is only measured if it
+  // is needed for a limit or a report.
+  auto limit_memory = [&context, collect_reports, this](Pass* pass) {
+    IRContext::MemoryStats stats;
+    if (max_memory_ == 0 && !collect_reports) return stats;
+    stats = context->GetMemoryStats();
+    if (max_memory_ == 0 || stats.Total() <= max_memory_) return stats;
+    context->InvalidateAnalyses(kAnalysesDroppedUnderMemoryPressure);
+    stats = context->GetMemoryStats();
+    if (stats.Total() > max_memory_ && consumer()) {
+      std::string msg = "The module and its analyses use ";
+      msg += std::to_string(stats.Total());
+      msg += " bytes after pass ";
+      msg += pass->name();
+      msg += ", more than the limit of ";
+      msg += std::to_string(max_memory_);
+      msg += " bytes";
+      spv_position_t null_pos{0, 0, 0};
+      consumer()(SPV_MSG_WARNING, "", null_pos, msg.c_str());
+    }
+    return stats;
+  };
+
+  // The names of the passes that have run without changing the module since it
+  // was last changed.
+  std::unordered_set<std::string> unchanged_passes;
+
+  // If validate_after_all_ is set, validates the module.  The validator checks
+  // the functions on as many threads, and the same executor, as the passes.
+  // The binary is kept between calls to reuse its storage.
+  std::vector<uint32_t> binary;
+  spv_validator_options_t val_options =
+      val_options_ ? *val_options_ : spv_validator_options_t();
+  val_options.num_threads = num_threads_;
+  if (!val_options.cancel) {
+    val_options.cancel = context->cancel();
+    val_options.cancel_data = context->cancel_data();
+  }
+  if (!val_options.executor) {
+    val_options.executor = context->executor();
+    val_options.executor_data = context->executor_data();
+  }
+  auto validate_module = [&context, &binary, &val_options, this]() {
+    spvtools::SpirvTools tools(target_env_);
+    tools.SetMessageConsumer(consumer());
+    binary.clear();
+    context->module()->ToBinary(&binary, true);
+    return tools.Validate(binary.data(), binary.size(), &val_options);
+  };
+
+  // If the optimization was cancelled, reports it and returns true.  The
+  // module may have been left half processed by the last pass, so it must not
+  // be used.
+  auto cancelled = [&context, this](const char* when, Pass* pass) {
+    if (!context->IsCancelled()) return false;
+    if (consumer()) {
+      std::string msg = "The optimization was cancelled ";
+      msg += when;
+      msg += " pass ";
+      msg += pass->name();
+      spv_position_t null_pos{0, 0, 0};
+      consumer()(SPV_MSG_ERROR, "", null_pos, msg.c_str());
+    }
+    return true;
+  };
+
+  // Whether the module has been validated since it was last changed.  A pass
+  // that does not change the module leaves it as valid as it was, so it does
+  // not need to be validated again.
+  bool module_validated = false;
+
+  SPIRV_TIMER_DESCRIPTION(time_report_stream_, /* measure_mem_usage = */ true,
+                          time_report_counters_);
   for (auto& pass : passes_) {
+    if (skip_unchanged_passes_ && pass->CanSkipIfModuleUnchanged() &&
+        unchanged_passes.count(pass->name())) {
+      pass.reset(nullptr);
+      continue;
+    }
+
+    if (cancelled("before", pass.get())) {
+      print_json_time_report();
+      return Pass::Status::Failure;
+    }
+
     print_disassembly("; IR before pass ", pass.get());
-    SPIRV_TIMER_SCOPED(time_report_stream_, (pass ? pass->name() : ""), true);
+    SPIRV_TIMER_SCOPED(time_report_stream_, (pass ? pass->name() : ""), true,
+                       time_report_counters_);
+
+    PassReport report;
+    PassResourceMeter meter;
+    if (collect_reports) {
+      report.name = pass->name();
+      report.instructions_before = CountInstructions(context->module());
+      context->set_analysis_build_log(&report.analysis_builds);
+      report.start = std::chrono::steady_clock::now();
+      meter.Start();
+    }
+    context->set_num_threads(
+        pass->ProcessesFunctionsInParallel() ? num_threads_ : 1);
     const auto one_status = pass->Run(context);
-    if (one_status == Pass::Status::Failure) return one_status;
-    if (one_status == Pass::Status::SuccessWithChange) status = one_status;
+    if (collect_reports) {
+      meter.Stop(&report);
+      context->set_analysis_build_log(nullptr);
+      report.instructions_after = CountInstructions(context->module());
+      report.changed = one_status == Pass::Status::SuccessWithChange;
+    }
+    if (one_status != Pass::Status::Failure) {
+      report.memory = limit_memory(pass.get());
+    }
+    if (collect_reports) reports.push_back(std::move(report));
 
-    if (validate_after_all_) {
-      spvtools::SpirvTools tools(target_env_);
-      tools.SetMessageConsumer(consumer());
-      std::vector<uint32_t> binary;
-      context->module()->ToBinary(&binary, true);
-      if (!tools.Validate(binary.data(), binary.size(), val_options_)) {
-        std::string msg = "Validation failed after pass ";
-        msg += pass->name();
-        spv_position_t null_pos{0, 0, 0};
-        consumer()(SPV_MSG_INTERNAL_ERROR, "", null_pos, msg.c_str());
+    if (one_status == Pass::Status::Failure ||
+        cancelled("during", pass.get())) {
+      print_json_time_report();
+      return Pass::Status::Failure;
+    }
+    if (one_status == Pass::Status::SuccessWithChange) {
+      status = one_status;
+      unchanged_passes.clear();
+      module_validated = false;
+      if (print_changed_stream_) {
+        ModuleLayout layout;
+        GetModuleLayout(context, &layout);
+        PrintChangedFunctions(last_layout, layout, pass->name(),
+                              print_changed_stream_);
+        last_layout = std::move(layout);
+      }
+    } else {
+      unchanged_passes.insert(pass->name());
+    }
+
+    if (validate_after_all_ && !module_validated) {
+      if (!validate_module()) {
+        if (consumer()) {
+          std::string msg = "Validation failed after pass ";
+          msg += pass->name();
+          spv_position_t null_pos{0, 0, 0};
+          consumer()(SPV_MSG_INTERNAL_ERROR, "", null_pos, msg.c_str());
+        }
+        print_json_time_report();
         return Pass::Status::Failure;
       }
+      module_validated = true;
     }
 
     // Reset the pass to free any memory used by the pass.
     pass.reset(nullptr);
   }
   print_disassembly("; IR after last pass", nullptr);
+  print_json_time_report();
 
   // Set the Id bound in the header in case a pass forgot to do so.
   //
@@ -43,10 +43,17 @@ class PassManager {
   PassManager()
       : consumer_(nullptr),
         print_all_stream_(nullptr),
+        print_changed_stream_(nullptr),
         time_report_stream_(nullptr),
+        time_report_counters_(0),
+        json_time_report_stream_(nullptr),
+        trace_stream_(nullptr),
         target_env_(SPV_ENV_UNIVERSAL_1_2),
         val_options_(nullptr),
-        validate_after_all_(false) {}
+        validate_after_all_(false),
+        num_threads_(1),
+        skip_unchanged_passes_(false),
+        max_memory_(0) {}
 
   // Sets the message consumer to the given |consumer|.
   void SetMessageConsumer(MessageConsumer c) { consumer_ = std::move(c); }
@@ -64,9 +71,24 @@ class PassManager {
   // Returns a pointer to the |index|th pass added.
   inline Pass* GetPass(uint32_t index) const;
 
+  // Removes all of the passes from the pass manager and returns them, in the
+  // order in which they were added.
+  std::vector<std::unique_ptr<Pass>> ReleasePasses() {
+    return std::move(passes_);
+  }
+
   // Returns the message consumer.
   inline const MessageConsumer& consumer() const;
 
+  // Returns true if the module can be built without its OpLine and OpNoLine
+  // instructions: the first pass removes them anyway, and nothing looks at the
+  // module before that pass runs.
+  bool CanSkipDebugLineInstsOnLoad() const {
+    return !passes_.empty() && passes_.front()->RemovesDebugLineInsts() &&
+           print_all_stream_ == nullptr && print_changed_stream_ == nullptr &&
+           json_time_report_stream_ == nullptr && trace_stream_ == nullptr;
+  }
+
   // Runs all passes on the given |module|. Returns Status::Failure if errors
   // occur when processing using one of the registered passes. All passes
   // registered after the error-reporting pass will be skipped. Returns the
@@ -84,6 +106,16 @@ class PassManager {
     return *this;
   }
 
+  // Sets the option to print the disassembly of the module before the first
+  // pass, and then, after each pass that changes the module, only the
+  // functions that it changed, preceded by the module-level instructions if
+  // it changed any of them.  Output is written to |out| if that is not null.
+  // No output is generated if |out| is null.
+  PassManager& SetPrintChanged(std::ostream* out) {
+    print_changed_stream_ = out;
+    return *this;
+  }
+
   // Sets the option to print the resource utilization of each pass. Output is
   // written to |out| if that is not null. No output is generated if |out| is
   // null.
@@ -92,6 +124,32 @@ class PassManager {
     return *this;
   }
 
+  // Sets the hardware counters the resource utilization of each pass
+  // includes, as a mask of |utils::HardwareCounter|.  The counters that
+  // cannot be read on this system are reported as "n/a".
+  PassManager& SetTimeReportCounters(uint32_t counters) {
+    time_report_counters_ = counters;
+    return *this;
+  }
+
+  // Sets the option to write a JSON report of the resource utilization of
+  // each pass, the instruction counts before and after it, and the analyses it
+  // had to build.  The report is written to |out| if that is not null.  No
+  // report is generated if |out| is null.
+  PassManager& SetJsonTimeReport(std::ostream* out) {
+    json_time_report_stream_ = out;
+    return *this;
+  }
+
+  // Sets the option to write a trace of the passes, and of the analyses each
+  // pass built within it, in the Chrome trace event format.  The trace can be
+  // loaded in chrome://tracing or Perfetto.  It is written to |out| if that is
+  // not null.  No trace is generated if |out| is null.
+  PassManager& SetTraceReport(std::ostream* out) {
+    trace_stream_ = out;
+    return *this;
+  }
+
   // Sets the target environment for validation.
   PassManager& SetTargetEnv(spv_target_env env) {
     target_env_ = env;
@@ -110,6 +168,33 @@ class PassManager {
     return *this;
   }
 
+  // Sets the option to skip a pass if a pass with the same name has already
+  // run without changing the module, and no pass has changed the module
+  // since.  See |Pass::CanSkipIfModuleUnchanged|.
+  PassManager& SetSkipUnchangedPasses(bool skip) {
+    skip_unchanged_passes_ = skip;
+    return *this;
+  }
+
+  // Sets the maximum number of threads the passes may use to process
+  // functions in parallel.  See |IRContext::ProcessFunctionsInParallel|.
+  // Only the passes for which |Pass::ProcessesFunctionsInParallel| is true
+  // use more than one thread.
+  PassManager& SetNumThreads(uint32_t num_threads) {
+    num_threads_ = num_threads;
+    return *this;
+  }
+
+  // Sets the memory, in bytes, that the module and its analyses should stay
+  // under between passes, as measured by |IRContext::GetMemoryStats|.  After
+  // a pass that leaves them above it, the analyses that are cached per
+  // function are invalidated, and a warning is reported if that was not
+  // enough.  There is no limit if |max_memory| is 0.
+  PassManager& SetMaxMemory(size_t max_memory) {
+    max_memory_ = max_memory;
+    return *this;
+  }
+
  private:
   // Consumer for messages.
   MessageConsumer consumer_;
@@ -118,15 +203,33 @@ class PassManager {
   // The output stream to write disassembly to before each pass, and after
   // the last pass.  If this is null, no output is generated.
   std::ostream* print_all_stream_;
+  // The output stream to write the disassembly of the functions changed by
+  // each pass to.  If this is null, no output is generated.
+  std::ostream* print_changed_stream_;
   // The output stream to write the resource utilization of each pass. If this
   // is null, no output is generated.
   std::ostream* time_report_stream_;
+  // The mask of the hardware counters in the resource utilization of each
+  // pass.
+  uint32_t time_report_counters_;
+  // The output stream to write the JSON report of each pass to. If this is
+  // null, no report is generated.
+  std::ostream* json_time_report_stream_;
+  // The output stream to write the trace of the passes to. If this is null,
+  // no trace is generated.
+  std::ostream* trace_stream_;
   // The target environment.
   spv_target_env target_env_;
   // The validator options (used when validating each pass).
   spv_validator_options val_options_;
   // Controls whether validation occurs after every pass.
   bool validate_after_all_;
+  // The maximum number of threads the passes may use.
+  uint32_t num_threads_;
+  // Controls whether passes that cannot change the module are skipped.
+  bool skip_unchanged_passes_;
+  // The memory limit between passes, in bytes, or 0 if there is none.
+  size_t max_memory_;
 };
 
 inline void PassManager::AddPass(std::unique_ptr<Pass> pass) {
@@ -20,6 +20,7 @@
 #include "source/opt/aggressive_dead_code_elim_pass.h"
 #include "source/opt/amd_ext_to_khr.h"
 #include "source/opt/block_merge_pass.h"
+#include "source/opt/canonical_layout_pass.h"
 #include "source/opt/ccp_pass.h"
 #include "source/opt/cfg_cleanup_pass.h"
 #include "source/opt/code_sink.h"
@@ -29,6 +30,7 @@
 #include "source/opt/copy_prop_arrays.h"
 #include "source/opt/dead_branch_elim_pass.h"
 #include "source/opt/dead_insert_elim_pass.h"
+#include "source/opt/dead_store_elim_pass.h"
 #include "source/opt/dead_variable_elimination.h"
 #include "source/opt/decompose_initialized_variables_pass.h"
 #include "source/opt/desc_sroa.h"
@@ -36,17 +38,23 @@
 #include "source/opt/eliminate_dead_functions_pass.h"
 #include "source/opt/eliminate_dead_members_pass.h"
 #include "source/opt/fix_storage_class.h"
+#include "source/opt/fixed_point_pass.h"
 #include "source/opt/flatten_decoration_pass.h"
 #include "source/opt/fold_spec_constant_op_and_composite_pass.h"
 #include "source/opt/freeze_spec_constant_value_pass.h"
+#include "source/opt/function_pipeline_pass.h"
 #include "source/opt/generate_webgpu_initializers_pass.h"
 #include "source/opt/graphics_robust_access_pass.h"
 #include "source/opt/if_conversion.h"
 #include "source/opt/inline_exhaustive_pass.h"
 #include "source/opt/inline_opaque_pass.h"
+#include "source/opt/inline_selective_pass.h"
 #include "source/opt/inst_bindless_check_pass.h"
+#include "source/opt/inst_block_profile_pass.h"
 #include "source/opt/inst_buff_addr_check_pass.h"
 #include "source/opt/inst_debug_printf_pass.h"
+#include "source/opt/instruction_scheduling_pass.h"
+#include "source/opt/jump_threading_pass.h"
 #include "source/opt/legalize_vector_shuffle_pass.h"
 #include "source/opt/licm_pass.h"
 #include "source/opt/local_access_chain_convert_pass.h"
@@ -60,6 +68,7 @@
 #include "source/opt/loop_unswitch_pass.h"
 #include "source/opt/merge_return_pass.h"
 #include "source/opt/null_pass.h"
+#include "source/opt/partial_redundancy_elimination.h"
 #include "source/opt/private_to_local_pass.h"
 #include "source/opt/process_lines_pass.h"
 #include "source/opt/reduce_load_size.h"
@@ -70,6 +79,7 @@
 #include "source/opt/scalar_replacement_pass.h"
 #include "source/opt/set_spec_constant_default_value_pass.h"
 #include "source/opt/simplification_pass.h"
+#include "source/opt/slp_vectorize_pass.h"
 #include "source/opt/split_invalid_unreachable_pass.h"
 #include "source/opt/ssa_rewrite_pass.h"
 #include "source/opt/strength_reduction_pass.h"
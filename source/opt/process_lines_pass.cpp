@@ -20,15 +20,6 @@
 #include <unordered_set>
 #include <vector>
 
-namespace {
-
-// Input Operand Indices
-static const int kSpvLineFileInIdx = 0;
-static const int kSpvLineLineInIdx = 1;
-static const int kSpvLineColInIdx = 2;
-
-}  // anonymous namespace
-
 namespace spvtools {
 namespace opt {
 
@@ -73,29 +64,22 @@ bool ProcessLinesPass::ProcessLines() {
 bool ProcessLinesPass::PropagateLine(Instruction* inst, uint32_t* file_id,
                                      uint32_t* line, uint32_t* col) {
   bool modified = false;
-  // only the last debug instruction needs to be considered
-  auto line_itr = inst->dbg_line_insts().rbegin();
   // if no line instructions, propagate previous info
-  if (line_itr == inst->dbg_line_insts().rend()) {
+  if (!inst->has_dbg_lines()) {
     // if no current line info, add OpNoLine, else OpLine
     if (*file_id == 0)
-      inst->dbg_line_insts().push_back(Instruction(context(), SpvOpNoLine));
+      inst->AddDbgLine({0, 0, 0});
     else
-      inst->dbg_line_insts().push_back(Instruction(
-          context(), SpvOpLine, 0, 0,
-          {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {*file_id}},
-           {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {*line}},
-           {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {*col}}}));
+      inst->AddDbgLine({*file_id, *line, *col});
     modified = true;
   } else {
-    // else pre-existing line instruction, so update source line info
-    if (line_itr->opcode() == SpvOpNoLine) {
-      *file_id = 0;
-    } else {
-      assert(line_itr->opcode() == SpvOpLine && "unexpected debug inst");
-      *file_id = line_itr->GetSingleWordInOperand(kSpvLineFileInIdx);
-      *line = line_itr->GetSingleWordInOperand(kSpvLineLineInIdx);
-      *col = line_itr->GetSingleWordInOperand(kSpvLineColInIdx);
+    // else pre-existing line instruction, so update source line info; only
+    // the last debug instruction needs to be considered
+    const DebugLine& last_line = inst->dbg_lines().back();
+    *file_id = last_line.file;
+    if (!last_line.IsNoLine()) {
+      *line = last_line.line;
+      *col = last_line.column;
     }
   }
   return modified;
@@ -104,41 +88,39 @@ bool ProcessLinesPass::PropagateLine(Instruction* inst, uint32_t* file_id,
 bool ProcessLinesPass::EliminateDeadLines(Instruction* inst, uint32_t* file_id,
                                           uint32_t* line, uint32_t* col) {
   // If no debug line instructions, return without modifying lines
-  if (inst->dbg_line_insts().empty()) return false;
+  if (!inst->has_dbg_lines()) return false;
   // Only the last debug instruction needs to be considered; delete all others
-  bool modified = inst->dbg_line_insts().size() > 1;
-  Instruction last_inst = inst->dbg_line_insts().back();
-  inst->dbg_line_insts().clear();
+  bool modified = inst->dbg_lines().size() > 1;
+  const DebugLine last_line = inst->dbg_lines().back();
+  inst->clear_dbg_lines();
   // If last line is OpNoLine
-  if (last_inst.opcode() == SpvOpNoLine) {
+  if (last_line.IsNoLine()) {
     // If no propagated line info, throw away redundant OpNoLine
     if (*file_id == 0) {
       modified = true;
       // Else replace OpNoLine and propagate no line info
     } else {
-      inst->dbg_line_insts().push_back(last_inst);
+      inst->AddDbgLine(last_line);
       *file_id = 0;
     }
   } else {
     // Else last line is OpLine
-    assert(last_inst.opcode() == SpvOpLine && "unexpected debug inst");
     // If propagated info matches last line, throw away last line
-    if (*file_id == last_inst.GetSingleWordInOperand(kSpvLineFileInIdx) &&
-        *line == last_inst.GetSingleWordInOperand(kSpvLineLineInIdx) &&
-        *col == last_inst.GetSingleWordInOperand(kSpvLineColInIdx)) {
+    if (*file_id == last_line.file && *line == last_line.line &&
+        *col == last_line.column) {
       modified = true;
     } else {
       // Else replace last line and propagate line info
-      *file_id = last_inst.GetSingleWordInOperand(kSpvLineFileInIdx);
-      *line = last_inst.GetSingleWordInOperand(kSpvLineLineInIdx);
-      *col = last_inst.GetSingleWordInOperand(kSpvLineColInIdx);
-      inst->dbg_line_insts().push_back(last_inst);
+      *file_id = last_line.file;
+      *line = last_line.line;
+      *col = last_line.column;
+      inst->AddDbgLine(last_line);
     }
   }
   return modified;
 }
 
-ProcessLinesPass::ProcessLinesPass(uint32_t func_id) {
+ProcessLinesPass::ProcessLinesPass(uint32_t func_id) : func_id_(func_id) {
   if (func_id == kLinesPropagateLines) {
     line_process_func_ = [this](Instruction* inst, uint32_t* file_id,
                                 uint32_t* line, uint32_t* col) {
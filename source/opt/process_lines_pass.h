@@ -41,7 +41,10 @@ class ProcessLinesPass : public Pass {
   ProcessLinesPass(uint32_t func_id);
   ~ProcessLinesPass() override = default;
 
-  const char* name() const override { return "propagate-lines"; }
+  const char* name() const override {
+    return func_id_ == kLinesPropagateLines ? "propagate-lines"
+                                            : "eliminate-dead-lines";
+  }
 
   // See optimizer.hpp for this pass' user documentation.
   Status Process() override;
@@ -79,6 +82,9 @@ class ProcessLinesPass : public Pass {
   // A function that calls either PropagateLine or EliminateDeadLines.
   // Initialized by the class constructor.
   LineProcessFunction line_process_func_;
+
+  // Which of the two functions |line_process_func_| calls.
+  uint32_t func_id_;
 };
 
 }  // namespace opt
@@ -14,6 +14,8 @@
 
 #include "source/opt/propagator.h"
 
+#include <algorithm>
+
 namespace spvtools {
 namespace opt {
 
@@ -67,19 +69,30 @@ bool SSAPropagator::IsPhiArgExecutable(Instruction* phi, uint32_t i) const {
   return IsEdgeExecutable(Edge(in_bb, phi_bb));
 }
 
-bool SSAPropagator::SetStatus(Instruction* inst, PropStatus status) {
-  bool has_old_status = false;
-  PropStatus old_status = kVarying;
-  if (HasStatus(inst)) {
-    has_old_status = true;
-    old_status = Status(inst);
+uint32_t SSAPropagator::EdgeIndex(uint32_t block_index,
+                                  const Edge& edge) const {
+  if (block_index == kNoBlock) return kNoBlock;
+  for (uint32_t i = block_edges_[block_index];
+       i < block_edges_[block_index + 1]; ++i) {
+    if (succ_edges_[i].dest == edge.dest) return i;
   }
+  return kNoBlock;
+}
+
+bool SSAPropagator::SetStatus(Instruction* inst, PropStatus status) {
+  InstState* state = GetState(inst);
+  assert(state && "Simulated an instruction outside the function.");
+  bool has_old_status = state->has_status;
+  PropStatus old_status = has_old_status ? state->status : kVarying;
 
   assert((!has_old_status || old_status <= status) &&
          "Invalid lattice transition");
 
   bool status_changed = !has_old_status || (old_status != status);
-  if (status_changed) statuses_[inst] = status;
+  if (status_changed) {
+    state->has_status = true;
+    state->status = status;
+  }
 
   return status_changed;
 }
@@ -107,9 +120,10 @@ bool SSAPropagator::Simulate(Instruction* instr) {
     // If |instr| is a block terminator, add all the control edges out of its
     // block.
     if (instr->IsBlockTerminator()) {
-      BasicBlock* block = ctx_->get_instr_block(instr);
-      for (const auto& e : bb_succs_.at(block)) {
-        AddControlEdge(e);
+      const uint32_t block_index = BlockIndex(ctx_->get_instr_block(instr));
+      for (const Edge* e = SuccEdgesBegin(block_index);
+           e != SuccEdgesEnd(block_index); ++e) {
+        AddControlEdge(*e);
       }
     }
     return false;
@@ -198,8 +212,9 @@ bool SSAPropagator::Simulate(BasicBlock* block) {
 
     // If this block has exactly one successor, mark the edge to its successor
     // as executable.
-    if (bb_succs_.at(block).size() == 1) {
-      AddControlEdge(bb_succs_.at(block).at(0));
+    const uint32_t block_index = BlockIndex(block);
+    if (SuccEdgesEnd(block_index) - SuccEdgesBegin(block_index) == 1) {
+      AddControlEdge(*SuccEdgesBegin(block_index));
     }
   }
 
@@ -207,33 +222,45 @@ bool SSAPropagator::Simulate(BasicBlock* block) {
 }
 
 void SSAPropagator::Initialize(Function* fn) {
-  // Compute predecessor and successor blocks for every block in |fn|'s CFG.
+  // The state of the instructions is kept in an array covering the range of
+  // the unique ids of the instructions of |fn|.
+  uint32_t min_id = ~0u;
+  uint32_t max_id = 0;
+  fn->ForEachInst([&min_id, &max_id](Instruction* inst) {
+    min_id = std::min(min_id, inst->unique_id());
+    max_id = std::max(max_id, inst->unique_id());
+  });
+  first_unique_id_ = min_id;
+  inst_states_.assign(max_id - min_id + 1, InstState());
+
+  // Compute the successor edges of every block in |fn|'s CFG.
   // TODO(dnovillo): Move this to CFG and always build them. Alternately,
   // move it to IRContext and build CFG preds/succs on-demand.
-  bb_succs_[ctx_->cfg()->pseudo_entry_block()].push_back(
-      Edge(ctx_->cfg()->pseudo_entry_block(), fn->entry().get()));
-
+  succ_edges_.clear();
+  block_edges_.clear();
+  uint32_t block_index = 0;
   for (auto& block : *fn) {
+    GetState(block.GetLabelInst())->block_index = block_index++;
+    block_edges_.push_back(static_cast<uint32_t>(succ_edges_.size()));
     const auto& const_block = block;
     const_block.ForEachSuccessorLabel([this, &block](const uint32_t label_id) {
       BasicBlock* succ_bb =
           ctx_->get_instr_block(get_def_use_mgr()->GetDef(label_id));
-      bb_succs_[&block].push_back(Edge(&block, succ_bb));
-      bb_preds_[succ_bb].push_back(Edge(succ_bb, &block));
+      succ_edges_.push_back(Edge(&block, succ_bb));
     });
     if (block.IsReturnOrAbort()) {
-      bb_succs_[&block].push_back(
-          Edge(&block, ctx_->cfg()->pseudo_exit_block()));
-      bb_preds_[ctx_->cfg()->pseudo_exit_block()].push_back(
-          Edge(ctx_->cfg()->pseudo_exit_block(), &block));
+      succ_edges_.push_back(Edge(&block, ctx_->cfg()->pseudo_exit_block()));
     }
   }
+  block_edges_.push_back(static_cast<uint32_t>(succ_edges_.size()));
 
-  // Add the edges out of the entry block to seed the propagator.
-  const auto& entry_succs = bb_succs_[ctx_->cfg()->pseudo_entry_block()];
-  for (const auto& e : entry_succs) {
-    AddControlEdge(e);
-  }
+  simulated_blocks_ = utils::BitVector(block_index + 1);
+  executable_edges_ =
+      utils::BitVector(static_cast<uint32_t>(succ_edges_.size()) + 1);
+
+  // Seed the propagator with the entry block, which is the only successor of
+  // the pseudo entry block.
+  blocks_.push(fn->entry().get());
 }
 
 bool SSAPropagator::Run(Function* fn) {
@@ -17,14 +17,12 @@
 
 #include <functional>
 #include <queue>
-#include <set>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "source/opt/ir_context.h"
 #include "source/opt/module.h"
+#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
@@ -200,12 +198,16 @@ class SSAPropagator {
 
   // Returns true if |inst| has a recorded status. This will be true once |inst|
   // has been simulated once.
-  bool HasStatus(Instruction* inst) const { return statuses_.count(inst); }
+  bool HasStatus(Instruction* inst) const {
+    const InstState* state = GetState(inst);
+    return state && state->has_status;
+  }
 
   // Returns the current propagation status of |inst|. Assumes
   // |HasStatus(inst)| returns true.
   PropStatus Status(Instruction* inst) const {
-    return statuses_.find(inst)->second;
+    assert(HasStatus(inst));
+    return GetState(inst)->status;
   }
 
   // Records the propagation status |status| for |inst|. Returns true if the
@@ -213,9 +215,57 @@ class SSAPropagator {
   bool SetStatus(Instruction* inst, PropStatus status);
 
  private:
+  // The propagation state of an instruction.
+  struct InstState {
+    // The index of the block defined by the instruction in |block_edges_|,
+    // or |kNoBlock| if the instruction is not a label of the function.
+    uint32_t block_index = kNoBlock;
+    PropStatus status = kNotInteresting;
+    bool has_status = false;
+    // True if the instruction should not be simulated again because it has
+    // been found to be in the kVarying state.
+    bool do_not_simulate = false;
+  };
+
+  static const uint32_t kNoBlock = ~0u;
+
   // Initialize processing.
   void Initialize(Function* fn);
 
+  // Returns the state of |inst|, or nullptr if |inst| is not in the range of
+  // instructions tracked for the function being propagated.
+  InstState* GetState(const Instruction* inst) {
+    const uint32_t index = inst->unique_id() - first_unique_id_;
+    return index < inst_states_.size() ? &inst_states_[index] : nullptr;
+  }
+  const InstState* GetState(const Instruction* inst) const {
+    const uint32_t index = inst->unique_id() - first_unique_id_;
+    return index < inst_states_.size() ? &inst_states_[index] : nullptr;
+  }
+
+  // Returns the index of |block| in |block_edges_|, or |kNoBlock| if |block|
+  // is not in the function being propagated.
+  uint32_t BlockIndex(const BasicBlock* block) const {
+    if (block == nullptr) return kNoBlock;
+    const InstState* state = GetState(block->GetLabelInst());
+    if (state == nullptr) return kNoBlock;
+    return state->block_index;
+  }
+
+  // Returns the index in |succ_edges_| of the first successor edge of the
+  // block with index |block_index| that is equal to |edge|, or |kNoBlock| if
+  // there is none.
+  uint32_t EdgeIndex(uint32_t block_index, const Edge& edge) const;
+
+  // Returns the range of successor edges of the block with index
+  // |block_index|.
+  const Edge* SuccEdgesBegin(uint32_t block_index) const {
+    return succ_edges_.data() + block_edges_[block_index];
+  }
+  const Edge* SuccEdgesEnd(uint32_t block_index) const {
+    return succ_edges_.data() + block_edges_[block_index + 1];
+  }
+
   // Simulate the execution |block| by calling |visit_fn_| on every instruction
   // in it.
   bool Simulate(BasicBlock* block);
@@ -228,31 +278,40 @@ class SSAPropagator {
 
   // Returns true if |instr| should be simulated again.
   bool ShouldSimulateAgain(Instruction* instr) const {
-    return do_not_simulate_.find(instr) == do_not_simulate_.end();
+    const InstState* state = GetState(instr);
+    return !state || !state->do_not_simulate;
   }
 
   // Add |instr| to the set of instructions not to simulate again.
-  void DontSimulateAgain(Instruction* instr) { do_not_simulate_.insert(instr); }
+  void DontSimulateAgain(Instruction* instr) {
+    InstState* state = GetState(instr);
+    assert(state && "Simulated an instruction outside the function.");
+    state->do_not_simulate = true;
+  }
 
   // Returns true if |block| has been simulated already.
   bool BlockHasBeenSimulated(BasicBlock* block) const {
-    return simulated_blocks_.find(block) != simulated_blocks_.end();
+    const uint32_t index = BlockIndex(block);
+    return index != kNoBlock && simulated_blocks_.Get(index);
   }
 
   // Marks block |block| as simulated.
   void MarkBlockSimulated(BasicBlock* block) {
-    simulated_blocks_.insert(block);
+    simulated_blocks_.Set(BlockIndex(block));
   }
 
   // Marks |edge| as executable.  Returns false if the edge was already marked
   // as executable.
   bool MarkEdgeExecutable(const Edge& edge) {
-    return executable_edges_.insert(edge).second;
+    const uint32_t index = EdgeIndex(BlockIndex(edge.source), edge);
+    assert(index != kNoBlock && "Edge is not in the function.");
+    return !executable_edges_.Set(index);
   }
 
   // Returns true if |edge| has been marked as executable.
   bool IsEdgeExecutable(const Edge& edge) const {
-    return executable_edges_.find(edge) != executable_edges_.end();
+    const uint32_t index = EdgeIndex(BlockIndex(edge.source), edge);
+    return index != kNoBlock && executable_edges_.Get(index);
   }
 
   // Returns a pointer to the def-use manager for |ctx_|.
@@ -284,28 +343,27 @@ class SSAPropagator {
   // Blocks to simulate.
   std::queue<BasicBlock*> blocks_;
 
-  // Blocks simulated during propagation.
-  std::unordered_set<BasicBlock*> simulated_blocks_;
+  // The smallest unique id of the instructions of the function being
+  // propagated.
+  uint32_t first_unique_id_ = 0;
 
-  // Set of instructions that should not be simulated again because they have
-  // been found to be in the kVarying state.
-  std::unordered_set<Instruction*> do_not_simulate_;
+  // The state of every instruction whose unique id is in the range of the
+  // unique ids of the function, indexed by unique id minus
+  // |first_unique_id_|.
+  std::vector<InstState> inst_states_;
 
-  // Map between a basic block and its predecessor edges.
-  // TODO(dnovillo): Move this to CFG and always build them. Alternately,
-  // move it to IRContext and build CFG preds/succs on-demand.
-  std::unordered_map<BasicBlock*, std::vector<Edge>> bb_preds_;
+  // The successor edges of all the blocks of the function, grouped by block.
+  std::vector<Edge> succ_edges_;
 
-  // Map between a basic block and its successor edges.
-  // TODO(dnovillo): Move this to CFG and always build them. Alternately,
-  // move it to IRContext and build CFG preds/succs on-demand.
-  std::unordered_map<BasicBlock*, std::vector<Edge>> bb_succs_;
+  // The successor edges of the block with index |i| are those in
+  // |succ_edges_| from index |block_edges_[i]| to |block_edges_[i + 1]|.
+  std::vector<uint32_t> block_edges_;
 
-  // Set of executable CFG edges.
-  std::set<Edge> executable_edges_;
+  // Blocks simulated during propagation, by block index.
+  utils::BitVector simulated_blocks_;
 
-  // Tracks instruction propagation status.
-  std::unordered_map<Instruction*, SSAPropagator::PropStatus> statuses_;
+  // Executable CFG edges, by index in |succ_edges_|.
+  utils::BitVector executable_edges_;
 };
 
 std::ostream& operator<<(std::ostream& str,
@@ -21,7 +21,9 @@ namespace opt {
 
 Pass::Status RedundancyEliminationPass::Process() {
   bool modified = false;
-  ValueNumberTable vnTable(context());
+  // The table is kept up to date as redundant instructions are killed, so it
+  // is still valid after the pass.
+  const ValueNumberTable& vnTable = *context()->GetValueNumberTable();
 
   for (auto& func : *get_module()) {
     // Build the dominator tree for this function. It is how the code is
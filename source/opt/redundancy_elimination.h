@@ -34,11 +34,14 @@ class RedundancyEliminationPass : public LocalRedundancyEliminationPass {
   const char* name() const override { return "redundancy-elimination"; }
   Status Process() override;
 
+  // The functions are processed one after the other, on the calling thread.
+  bool ProcessesFunctionsInParallel() const override { return false; }
+
  protected:
   // Removes for all total redundancies in the function starting at |bb|.
   //
-  // |vnTable| must have computed a value number for every result id defined
-  // in the function containing |bb|.
+  // |vnTable| gives the value number of the result ids defined in the
+  // function containing |bb|.
   //
   // |value_to_ids| is a map from value number to ids.  If {vn, id} is in
   // |value_to_ids| then vn is the value number of id, and the defintion of id
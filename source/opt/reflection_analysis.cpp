@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/reflection_analysis.h"
+
+#include <vector>
+
+#include "source/module_reflection.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/reflect.h"
+#include "source/util/memory_usage.h"
+
+namespace spvtools {
+namespace opt {
+
+ReflectionAnalysis::ReflectionAnalysis(IRContext* context) {
+  // The builder is given the instructions in the order of a binary, in which
+  // the names and decorations come before the values they apply to.
+  ModuleReflectionBuilder builder;
+  std::vector<uint32_t> words;
+  auto add = [&builder, &words](const Instruction& inst) {
+    words.clear();
+    inst.ToBinaryWithoutAttachedDebugInsts(&words);
+    builder.AddInstruction(words.data(), words.size());
+  };
+  Module* module = context->module();
+  for (const auto& inst : module->entry_points()) add(inst);
+  for (const auto& inst : module->debugs2()) add(inst);
+  for (const auto& inst : module->annotations()) add(inst);
+  for (const auto& inst : module->types_values()) add(inst);
+  reflection_ = builder.TakeReflection();
+
+  for (size_t i = 0; i < reflection_.resources.size(); ++i) {
+    resource_indices_[reflection_.resources[i].variable_id] = i;
+  }
+}
+
+const ReflectedResource* ReflectionAnalysis::GetResource(
+    uint32_t variable_id) const {
+  auto index = resource_indices_.find(variable_id);
+  if (index == resource_indices_.end()) return nullptr;
+  return &reflection_.resources[index->second];
+}
+
+bool ReflectionAnalysis::IsAffectedBy(const Instruction& inst) const {
+  switch (inst.opcode()) {
+    case SpvOpEntryPoint:
+    case SpvOpGroupDecorate:
+      return true;
+    case SpvOpName: {
+      // Names are mostly added and removed for the ids of instructions in
+      // functions, which are not reflected.
+      const uint32_t id = inst.GetSingleWordInOperand(0);
+      if (resource_indices_.count(id)) return true;
+      for (const auto& spec_constant : reflection_.spec_constants) {
+        if (spec_constant.id == id) return true;
+      }
+      return false;
+    }
+    case SpvOpDecorate:
+      switch (inst.GetSingleWordInOperand(1)) {
+        case SpvDecorationDescriptorSet:
+        case SpvDecorationBinding:
+        case SpvDecorationSpecId:
+          return true;
+        default:
+          return false;
+      }
+    case SpvOpVariable:
+      return inst.GetSingleWordInOperand(0) != SpvStorageClassFunction;
+    default:
+      return IsSpecConstantInst(inst.opcode());
+  }
+}
+
+size_t ReflectionAnalysis::MemoryUsage() const {
+  size_t bytes = utils::MemoryUsage(reflection_.resources) +
+                 utils::MemoryUsage(reflection_.entry_points) +
+                 utils::MemoryUsage(reflection_.spec_constants) +
+                 utils::MemoryUsage(resource_indices_);
+  for (const auto& resource : reflection_.resources) {
+    bytes += resource.name.capacity();
+  }
+  for (const auto& entry_point : reflection_.entry_points) {
+    bytes += entry_point.name.capacity() +
+             utils::MemoryUsage(entry_point.interface_ids);
+  }
+  for (const auto& spec_constant : reflection_.spec_constants) {
+    bytes += spec_constant.name.capacity() +
+             utils::MemoryUsage(spec_constant.default_value);
+  }
+  return bytes;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_REFLECTION_ANALYSIS_H_
+#define SOURCE_OPT_REFLECTION_ANALYSIS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace opt {
+
+class Instruction;
+class IRContext;
+
+// An analysis that lists the resources, entry point interfaces and
+// specialization constants of a module, as SpirvTools::Reflect does for a
+// binary, so that passes do not have to look for them in the decorations and
+// global values each time.
+class ReflectionAnalysis {
+ public:
+  explicit ReflectionAnalysis(IRContext* context);
+
+  const ModuleReflection& reflection() const { return reflection_; }
+  const std::vector<ReflectedResource>& resources() const {
+    return reflection_.resources;
+  }
+  const std::vector<ReflectedEntryPoint>& entry_points() const {
+    return reflection_.entry_points;
+  }
+  const std::vector<ReflectedSpecConstant>& spec_constants() const {
+    return reflection_.spec_constants;
+  }
+
+  // Returns the resource declared by the variable |variable_id|, or nullptr
+  // if it does not declare one.
+  const ReflectedResource* GetResource(uint32_t variable_id) const;
+
+  // Returns the resource bound to |binding| of descriptor set |set|, or
+  // nullptr if there is none.
+  const ReflectedResource* GetResource(uint32_t set, uint32_t binding) const {
+    return reflection_.FindResource(set, binding);
+  }
+
+  // Returns the specialization constant with the SpecId |spec_id|, or nullptr
+  // if there is none.
+  const ReflectedSpecConstant* GetSpecConstant(uint32_t spec_id) const {
+    return reflection_.FindSpecConstant(spec_id);
+  }
+
+  // Returns true if adding or removing |inst| may change the reflection of
+  // the module.
+  bool IsAffectedBy(const Instruction& inst) const;
+
+  // Returns an estimate of the memory, in bytes, that the analysis uses.
+  size_t MemoryUsage() const;
+
+ private:
+  ModuleReflection reflection_;
+  // The index in |reflection_.resources| of the resource of each variable.
+  std::unordered_map<uint32_t, size_t> resource_indices_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_REFLECTION_ANALYSIS_H_
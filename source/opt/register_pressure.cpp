@@ -23,6 +23,7 @@
 #include "source/opt/function.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/iterator.h"
+#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
@@ -334,6 +335,144 @@ void RegisterLiveness::ComputeLoopRegisterPressure(
   }
 }
 
+void RegisterLiveness::EstimateLoopRegisterPressure(
+    IRContext* context, const Loop& loop,
+    RegionRegisterLiveness* loop_reg_pressure) {
+  loop_reg_pressure->Clear();
+
+  CFG& cfg = *context->cfg();
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  // Give a dense index to every register defined or used in the loop.
+  std::unordered_map<const Instruction*, uint32_t> value_index;
+  std::vector<Instruction*> values;
+  const auto number_value = [&value_index, &values](Instruction* insn) {
+    if (value_index.emplace(insn, static_cast<uint32_t>(values.size()))
+            .second) {
+      values.push_back(insn);
+    }
+  };
+  for (uint32_t bb_id : loop.GetBlocks()) {
+    for (Instruction& insn : *cfg.block(bb_id)) {
+      if (CreatesRegisterUsage(&insn)) number_value(&insn);
+      insn.ForEachInId([def_use_mgr, &number_value](uint32_t* id) {
+        Instruction* insn_op = def_use_mgr->GetDef(*id);
+        if (CreatesRegisterUsage(insn_op)) number_value(insn_op);
+      });
+    }
+  }
+  if (values.empty()) return;
+
+  const uint32_t num_values = static_cast<uint32_t>(values.size());
+  const auto count = [num_values](const utils::BitVector& bits) {
+    size_t n = 0;
+    for (uint32_t i = 0; i < num_values; ++i) {
+      if (bits.Get(i)) ++n;
+    }
+    return n;
+  };
+
+  // Registers defined in the loop and used after it are live on every exit.
+  utils::BitVector escaping(num_values);
+  for (uint32_t i = 0; i < num_values; ++i) {
+    Instruction* value = values[i];
+    BasicBlock* def_bb = context->get_instr_block(value);
+    if (def_bb == nullptr || !loop.IsInsideLoop(def_bb)) continue;
+    // Phi users outside the loop are handled as phi operands of the exits.
+    const bool used_only_in_loop =
+        def_use_mgr->WhileEachUser(value, [context, &loop](Instruction* user) {
+          BasicBlock* user_bb = context->get_instr_block(user);
+          return user_bb == nullptr || user->opcode() == SpvOpPhi ||
+                 loop.IsInsideLoop(user_bb);
+        });
+    if (!used_only_in_loop) escaping.Set(i);
+  }
+
+  // Start each block with the registers its successors need: phi operands
+  // coming from it, and the escaping registers if it exits the loop.
+  std::unordered_map<uint32_t, utils::BitVector> block_out;
+  std::unordered_map<uint32_t, utils::BitVector> block_in;
+  for (uint32_t bb_id : loop.GetBlocks()) {
+    utils::BitVector& live_out =
+        block_out.emplace(bb_id, utils::BitVector(num_values)).first->second;
+    block_in.emplace(bb_id, utils::BitVector(num_values));
+    const BasicBlock* bb = cfg.block(bb_id);
+    bb->ForEachSuccessorLabel([&](uint32_t succ_id) {
+      if (!loop.IsInsideLoop(succ_id)) live_out.Or(escaping);
+      cfg.block(succ_id)->ForEachPhiInst([&](const Instruction* phi) {
+        for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
+          if (phi->GetSingleWordInOperand(i + 1) != bb_id) continue;
+          auto it = value_index.find(
+              def_use_mgr->GetDef(phi->GetSingleWordInOperand(i)));
+          if (it != value_index.end()) live_out.Set(it->second);
+        }
+      });
+    });
+  }
+
+  // Iterate the backward data-flow to a fixed point.  Registers defined by a
+  // block's phis are live into it, but are not live out of its predecessors.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t bb_id : loop.GetBlocks()) {
+      BasicBlock* bb = cfg.block(bb_id);
+      utils::BitVector& live_out = block_out.at(bb_id);
+      const BasicBlock* cbb = bb;
+      cbb->ForEachSuccessorLabel([&](uint32_t succ_id) {
+        if (!loop.IsInsideLoop(succ_id)) return;
+        utils::BitVector succ_in = block_in.at(succ_id);
+        cfg.block(succ_id)->ForEachPhiInst([&](const Instruction* phi) {
+          succ_in.Clear(value_index.at(phi));
+        });
+        if (live_out.Or(succ_in)) changed = true;
+      });
+
+      utils::BitVector live_in = live_out;
+      for (Instruction& insn : make_range(bb->rbegin(), bb->rend())) {
+        if (insn.opcode() == SpvOpPhi) {
+          live_in.Set(value_index.at(&insn));
+          continue;
+        }
+        if (CreatesRegisterUsage(&insn)) live_in.Clear(value_index.at(&insn));
+        insn.ForEachInId([&](uint32_t* id) {
+          auto it = value_index.find(def_use_mgr->GetDef(*id));
+          if (it != value_index.end()) live_in.Set(it->second);
+        });
+      }
+      if (block_in.at(bb_id).Or(live_in)) changed = true;
+    }
+  }
+
+  // Find the peak pressure of each block, walking it backward from its
+  // live-out set as |EvaluateRegisterRequirements| does.
+  for (uint32_t bb_id : loop.GetBlocks()) {
+    BasicBlock* bb = cfg.block(bb_id);
+    const utils::BitVector& live_out = block_out.at(bb_id);
+    size_t reg_count = count(live_out);
+    size_t used_registers = reg_count;
+    utils::BitVector die_in_block(num_values);
+    for (Instruction& insn : make_range(bb->rbegin(), bb->rend())) {
+      if (insn.opcode() == SpvOpPhi) break;
+      insn.ForEachInId([&](uint32_t* id) {
+        auto it = value_index.find(def_use_mgr->GetDef(*id));
+        if (it == value_index.end() || live_out.Get(it->second)) return;
+        if (!die_in_block.Set(it->second)) reg_count++;
+      });
+      used_registers = std::max(used_registers, reg_count);
+      if (CreatesRegisterUsage(&insn) && reg_count > 0) reg_count--;
+    }
+    loop_reg_pressure->used_registers_ =
+        std::max(loop_reg_pressure->used_registers_, used_registers);
+  }
+
+  const utils::BitVector& header_in = block_in.at(loop.GetHeaderBlock()->id());
+  for (uint32_t i = 0; i < num_values; ++i) {
+    if (header_in.Get(i)) loop_reg_pressure->live_in_.insert(values[i]);
+    if (escaping.Get(i)) loop_reg_pressure->live_out_.insert(values[i]);
+  }
+}
+
 void RegisterLiveness::SimulateFusion(
     const Loop& l1, const Loop& l2, RegionRegisterLiveness* sim_result) const {
   sim_result->Clear();
@@ -133,6 +133,19 @@ class RegisterLiveness {
   void ComputeLoopRegisterPressure(const Loop& loop,
                                    RegionRegisterLiveness* reg_pressure) const;
 
+  // Estimates the register pressure of |loop| without the liveness of the rest
+  // of its function, and stores the result into |reg_pressure|. The liveness
+  // is computed with bit vectors over the values used or defined in the loop,
+  // so this is much cheaper than building a RegisterLiveness for the function.
+  //
+  // The estimate ignores values that are live across the loop without being
+  // used in it, so |used_registers_| can be lower than the one given by
+  // |ComputeLoopRegisterPressure|. The live-out set only holds values defined
+  // in the loop, and |registers_classes_| is left empty.
+  static void EstimateLoopRegisterPressure(
+      IRContext* context, const Loop& loop,
+      RegionRegisterLiveness* reg_pressure);
+
   // Estimate the register pressure for the |l1| and |l2| as if they were making
   // one unique loop. The result is stored into |simulation_result|.
   void SimulateFusion(const Loop& l1, const Loop& l2,
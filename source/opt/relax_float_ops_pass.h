@@ -35,7 +35,7 @@ class RelaxFloatOpsPass : public Pass {
   // See optimizer.hpp for pass user documentation.
   Status Process() override;
 
-  const char* name() const override { return "convert-to-half-pass"; }
+  const char* name() const override { return "relax-float-ops-pass"; }
 
  private:
   // Return true if |inst| can have the RelaxedPrecision decoration applied
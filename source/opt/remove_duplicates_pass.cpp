@@ -23,7 +23,6 @@
 #include <vector>
 
 #include "source/opcode.h"
-#include "source/opt/decoration_manager.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/reflect.h"
 
@@ -98,7 +97,12 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 
   analysis::TypeManager type_manager(context()->consumer(), context());
 
-  std::vector<Instruction*> visited_types;
+  // Every type kept so far, mapped to its id.  Types are looked up by their
+  // structural hash, so each type is checked in (amortized) constant time
+  // rather than against every type kept before it.
+  std::unordered_map<const analysis::Type*, SpvId, analysis::HashTypePointer,
+                     analysis::CompareTypePointers>
+      visited_types;
   std::vector<analysis::ForwardPointer> visited_forward_pointers;
   std::vector<Instruction*> to_delete;
   for (auto* i = &*context()->types_values_begin(); i; i = i->NextNode()) {
@@ -111,25 +115,12 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 
     if (!is_i_forward_pointer) {
       // Is the current type equal to one of the types we have already visited?
-      SpvId id_to_keep = 0u;
       analysis::Type* i_type = type_manager.GetType(i->result_id());
       assert(i_type);
-      // TODO(dneto0): Use a trie to avoid quadratic behaviour? Extract the
-      // ResultIdTrie from unify_const_pass.cpp for this.
-      for (auto j : visited_types) {
-        analysis::Type* j_type = type_manager.GetType(j->result_id());
-        assert(j_type);
-        if (*i_type == *j_type) {
-          id_to_keep = j->result_id();
-          break;
-        }
-      }
-
-      if (id_to_keep == 0u) {
-        // This is a never seen before type, keep it around.
-        visited_types.emplace_back(i);
-      } else {
+      auto res = visited_types.emplace(i_type, i->result_id());
+      if (!res.second) {
         // The same type has already been seen before, remove this one.
+        const SpvId id_to_keep = res.first->second;
         context()->KillNamesAndDecorates(i->result_id());
         context()->ReplaceAllUsesWith(i->result_id(), id_to_keep);
         modified = true;
@@ -179,25 +170,35 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes() const {
 bool RemoveDuplicatesPass::RemoveDuplicateDecorations() const {
   bool modified = false;
 
-  std::vector<const Instruction*> visited_decorations;
+  // Every decoration kept so far, keyed by its opcode and in-operands
+  // (target included), so that each decoration is checked in constant time.
+  std::unordered_set<std::u32string> visited_decorations;
 
-  analysis::DecorationManager decoration_manager(context()->module());
   for (auto* i = &*context()->annotation_begin(); i;) {
-    // Is the current decoration equal to one of the decorations we have
-    // already visited?
+    // Only decorations applied directly to a target can be duplicates; group
+    // decorations are always kept.
     bool already_visited = false;
-    // TODO(dneto0): Use a trie to avoid quadratic behaviour? Extract the
-    // ResultIdTrie from unify_const_pass.cpp for this.
-    for (const Instruction* j : visited_decorations) {
-      if (decoration_manager.AreDecorationsTheSame(&*i, j, false)) {
-        already_visited = true;
+    switch (i->opcode()) {
+      case SpvOpDecorate:
+      case SpvOpMemberDecorate:
+      case SpvOpDecorateId:
+      case SpvOpDecorateStringGOOGLE: {
+        std::u32string key(1, i->opcode());
+        for (uint32_t in_idx = 0; in_idx < i->NumInOperands(); ++in_idx) {
+          const Operand& operand = i->GetInOperand(in_idx);
+          key.push_back(operand.type);
+          key.push_back(static_cast<uint32_t>(operand.words.size()));
+          key.append(operand.words.begin(), operand.words.end());
+        }
+        already_visited = !visited_decorations.insert(std::move(key)).second;
         break;
       }
+      default:
+        break;
     }
 
     if (!already_visited) {
       // This is a never seen before decoration, keep it around.
-      visited_decorations.emplace_back(&*i);
       i = i->NextNode();
     } else {
       // The same decoration has already been seen before, remove this one.
@@ -20,6 +20,7 @@
 #include <utility>
 
 #include "source/opt/ir_context.h"
+#include "source/util/memory_usage.h"
 
 // Transforms a given scalar operation instruction into a DAG representation.
 //
@@ -48,11 +49,28 @@ namespace opt {
 
 uint32_t SENode::NumberOfNodes = 0;
 
+const size_t SENodeArena::kBlockSize;
+
+SENodeArena::~SENodeArena() {
+  for (auto itr = nodes_.rbegin(); itr != nodes_.rend(); ++itr) {
+    (*itr)->~SENode();
+  }
+}
+
+void* SENodeArena::Allocate(size_t size, size_t alignment) {
+  size_t offset = (block_used_ + alignment - 1) & ~(alignment - 1);
+  if (offset + size > kBlockSize) {
+    blocks_.emplace_back(new char[kBlockSize]);
+    offset = 0;
+  }
+  block_used_ = offset + size;
+  return blocks_.back().get() + offset;
+}
+
 ScalarEvolutionAnalysis::ScalarEvolutionAnalysis(IRContext* context)
     : context_(context), pretend_equal_{} {
   // Create and cached the CantComputeNode.
-  cached_cant_compute_ =
-      GetCachedOrAdd(std::unique_ptr<SECantCompute>(new SECantCompute(this)));
+  cached_cant_compute_ = GetCachedOrAdd(CreateUncachedNode<SECantCompute>());
 }
 
 SENode* ScalarEvolutionAnalysis::CreateNegation(SENode* operand) {
@@ -62,14 +80,13 @@ SENode* ScalarEvolutionAnalysis::CreateNegation(SENode* operand) {
   if (operand->GetType() == SENode::Constant) {
     return CreateConstant(-operand->AsSEConstantNode()->FoldToSingleValue());
   }
-  std::unique_ptr<SENode> negation_node{new SENegative(this)};
+  SENode* negation_node = CreateUncachedNode<SENegative>();
   negation_node->AddChild(operand);
-  return GetCachedOrAdd(std::move(negation_node));
+  return GetCachedOrAdd(negation_node);
 }
 
 SENode* ScalarEvolutionAnalysis::CreateConstant(int64_t integer) {
-  return GetCachedOrAdd(
-      std::unique_ptr<SENode>(new SEConstantNode(this, integer)));
+  return GetCachedOrAdd(CreateUncachedNode<SEConstantNode>(integer));
 }
 
 SENode* ScalarEvolutionAnalysis::CreateRecurrentExpression(
@@ -87,12 +104,11 @@ SENode* ScalarEvolutionAnalysis::CreateRecurrentExpression(
     loop_to_use = loop;
   }
 
-  std::unique_ptr<SERecurrentNode> phi_node{
-      new SERecurrentNode(this, loop_to_use)};
+  SERecurrentNode* phi_node = CreateUncachedNode<SERecurrentNode>(loop_to_use);
   phi_node->AddOffset(offset);
   phi_node->AddCoefficient(coefficient);
 
-  return GetCachedOrAdd(std::move(phi_node));
+  return GetCachedOrAdd(phi_node);
 }
 
 SENode* ScalarEvolutionAnalysis::AnalyzeMultiplyOp(
@@ -121,12 +137,12 @@ SENode* ScalarEvolutionAnalysis::CreateMultiplyNode(SENode* operand_1,
                           operand_2->AsSEConstantNode()->FoldToSingleValue());
   }
 
-  std::unique_ptr<SENode> multiply_node{new SEMultiplyNode(this)};
+  SENode* multiply_node = CreateUncachedNode<SEMultiplyNode>();
 
   multiply_node->AddChild(operand_1);
   multiply_node->AddChild(operand_2);
 
-  return GetCachedOrAdd(std::move(multiply_node));
+  return GetCachedOrAdd(multiply_node);
 }
 
 SENode* ScalarEvolutionAnalysis::CreateSubtraction(SENode* operand_1,
@@ -154,12 +170,12 @@ SENode* ScalarEvolutionAnalysis::CreateAddNode(SENode* operand_1,
   if (operand_1->IsCantCompute() || operand_2->IsCantCompute())
     return CreateCantComputeNode();
 
-  std::unique_ptr<SENode> add_node{new SEAddNode(this)};
+  SENode* add_node = CreateUncachedNode<SEAddNode>();
 
   add_node->AddChild(operand_1);
   add_node->AddChild(operand_2);
 
-  return GetCachedOrAdd(std::move(add_node));
+  return GetCachedOrAdd(add_node);
 }
 
 SENode* ScalarEvolutionAnalysis::AnalyzeInstruction(const Instruction* inst) {
@@ -269,6 +285,7 @@ SENode* ScalarEvolutionAnalysis::AnalyzePhiInstruction(const Instruction* phi) {
 
   // Get the innermost loop which this block belongs to.
   Loop* loop = (*loop_descriptor)[basic_block->id()];
+  if (loop) phis_in_loop_[loop].push_back(phi);
 
   // If the loop doesn't exist or doesn't have a preheader or latch block, exit
   // out.
@@ -282,14 +299,15 @@ SENode* ScalarEvolutionAnalysis::AnalyzePhiInstruction(const Instruction* phi) {
   } else {
     loop_to_use = loop;
   }
-  std::unique_ptr<SERecurrentNode> phi_node{
-      new SERecurrentNode(this, loop_to_use)};
+  SERecurrentNode* phi_node = CreateUncachedNode<SERecurrentNode>(loop_to_use);
 
   // We add the node to this map to allow it to be returned before the node is
   // fully built. This is needed as the subsequent call to AnalyzeInstruction
   // could lead back to this |phi| instruction so we return the pointer
-  // immediately in AnalyzeInstruction to break the recursion.
-  recurrent_node_map_[phi] = phi_node.get();
+  // immediately in AnalyzeInstruction to break the recursion. The node stays
+  // alive in the arena even if an equal node is found in the cache, so the
+  // nodes built meanwhile can safely refer to it.
+  recurrent_node_map_[phi] = phi_node;
 
   // Traverse the operands of the instruction an create new nodes for each one.
   for (uint32_t i = 0; i < phi->NumInOperands(); i += 2) {
@@ -334,7 +352,7 @@ SENode* ScalarEvolutionAnalysis::AnalyzePhiInstruction(const Instruction* phi) {
         return recurrent_node_map_[phi] = CreateCantComputeNode();
 
       // If the phi operand is not the same phi node exit out.
-      if (phi_operand != phi_node.get())
+      if (phi_operand != phi_node)
         return recurrent_node_map_[phi] = CreateCantComputeNode();
 
       if (!IsLoopInvariant(loop, step_node))
@@ -346,14 +364,13 @@ SENode* ScalarEvolutionAnalysis::AnalyzePhiInstruction(const Instruction* phi) {
 
   // Once the node is fully built we update the map with the version from the
   // cache (if it has already been added to the cache).
-  return recurrent_node_map_[phi] = GetCachedOrAdd(std::move(phi_node));
+  return recurrent_node_map_[phi] = GetCachedOrAdd(phi_node);
 }
 
 SENode* ScalarEvolutionAnalysis::CreateValueUnknownNode(
     const Instruction* inst) {
-  std::unique_ptr<SEValueUnknown> load_node{
-      new SEValueUnknown(this, inst->result_id())};
-  return GetCachedOrAdd(std::move(load_node));
+  return GetCachedOrAdd(
+      CreateUncachedNode<SEValueUnknown>(inst->result_id()));
 }
 
 SENode* ScalarEvolutionAnalysis::CreateCantComputeNode() {
@@ -361,16 +378,79 @@ SENode* ScalarEvolutionAnalysis::CreateCantComputeNode() {
 }
 
 // Add the created node into the cache of nodes. If it already exists return it.
-SENode* ScalarEvolutionAnalysis::GetCachedOrAdd(
-    std::unique_ptr<SENode> prospective_node) {
-  auto itr = node_cache_.find(prospective_node);
-  if (itr != node_cache_.end()) {
-    return (*itr).get();
+SENode* ScalarEvolutionAnalysis::GetCachedOrAdd(SENode* prospective_node) {
+  return *node_cache_.insert(prospective_node).first;
+}
+
+void ScalarEvolutionAnalysis::ForgetLoop(const Loop* loop) {
+  std::unordered_set<const Loop*> forgotten_loops;
+  for (const Loop* parent = loop; parent; parent = parent->GetParent()) {
+    forgotten_loops.insert(parent);
+  }
+  std::vector<const Loop*> nested_loops(loop->begin(), loop->end());
+  while (!nested_loops.empty()) {
+    const Loop* nested_loop = nested_loops.back();
+    nested_loops.pop_back();
+    forgotten_loops.insert(nested_loop);
+    nested_loops.insert(nested_loops.end(), nested_loop->begin(),
+                        nested_loop->end());
+  }
+
+  for (const Loop* forgotten_loop : forgotten_loops) {
+    auto phis = phis_in_loop_.find(forgotten_loop);
+    if (phis == phis_in_loop_.end()) continue;
+    for (const Instruction* phi : phis->second) {
+      recurrent_node_map_.erase(phi);
+    }
+    phis_in_loop_.erase(phis);
+  }
+
+  for (auto itr = pretend_equal_.begin(); itr != pretend_equal_.end();) {
+    if (forgotten_loops.count(itr->first) ||
+        forgotten_loops.count(itr->second)) {
+      itr = pretend_equal_.erase(itr);
+    } else {
+      ++itr;
+    }
   }
 
-  SENode* raw_ptr_to_node = prospective_node.get();
-  node_cache_.insert(std::move(prospective_node));
-  return raw_ptr_to_node;
+  // The nodes and the recurrences of the other loops referring to the
+  // forgotten loops are dropped as well, e.g. the induction variable of a loop
+  // starting from the final value of the induction variable of the loop before
+  // it.
+  std::unordered_map<const SENode*, bool> memo;
+  for (auto itr = node_cache_.begin(); itr != node_cache_.end();) {
+    if (RefersToLoops(*itr, forgotten_loops, &memo)) {
+      itr = node_cache_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+  for (auto itr = recurrent_node_map_.begin();
+       itr != recurrent_node_map_.end();) {
+    if (RefersToLoops(itr->second, forgotten_loops, &memo)) {
+      itr = recurrent_node_map_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+}
+
+bool ScalarEvolutionAnalysis::RefersToLoops(
+    const SENode* node, const std::unordered_set<const Loop*>& loops,
+    std::unordered_map<const SENode*, bool>* memo) const {
+  auto itr = memo->find(node);
+  if (itr != memo->end()) return itr->second;
+
+  bool refers = false;
+  if (const SERecurrentNode* recurrent = node->AsSERecurrentNode()) {
+    refers = loops.count(recurrent->GetLoop()) != 0;
+  }
+  for (const SENode* child : *node) {
+    if (refers) break;
+    refers = RefersToLoops(child, loops, memo);
+  }
+  return (*memo)[node] = refers;
 }
 
 bool ScalarEvolutionAnalysis::IsLoopInvariant(const Loop* loop,
@@ -421,12 +501,12 @@ SENode* ScalarEvolutionAnalysis::UpdateChildNode(SENode* parent,
     }
   }
 
-  std::unique_ptr<SENode> add_node{new SEAddNode(this)};
+  SENode* add_node = CreateUncachedNode<SEAddNode>();
   for (SENode* child : new_children) {
     add_node->AddChild(child);
   }
 
-  return SimplifyExpression(GetCachedOrAdd(std::move(add_node)));
+  return SimplifyExpression(GetCachedOrAdd(add_node));
 }
 
 // Rebuild the |node| eliminating, if it exists, the recurrent term which
@@ -455,12 +535,12 @@ SENode* ScalarEvolutionAnalysis::BuildGraphWithoutRecurrentTerm(
     }
   }
 
-  std::unique_ptr<SENode> add_node{new SEAddNode(this)};
+  SENode* add_node = CreateUncachedNode<SEAddNode>();
   for (SENode* child : new_children) {
     add_node->AddChild(child);
   }
 
-  return SimplifyExpression(GetCachedOrAdd(std::move(add_node)));
+  return SimplifyExpression(GetCachedOrAdd(add_node));
 }
 
 // Return the recurrent term belonging to |loop| if it appears in the graph
@@ -629,10 +709,6 @@ size_t SENodeHash::operator()(const SENode* node) const {
 }
 
 // This overload is the actual overload used by the node_cache_ set.
-size_t SENodeHash::operator()(const std::unique_ptr<SENode>& node) const {
-  return this->operator()(node.get());
-}
-
 void SENode::DumpDot(std::ostream& out, bool recurse) const {
   size_t unique_id = std::hash<const SENode*>{}(this);
   out << unique_id << " [label=\"" << AsString() << " ";
@@ -984,5 +1060,10 @@ std::pair<SExpression, int64_t> SExpression::operator/(
   return {scev_->CreateCantComputeNode(), 0};
 }
 
+size_t ScalarEvolutionAnalysis::MemoryUsage() const {
+  return utils::MemoryUsage(recurrent_node_map_) + node_arena_.MemoryUsage() +
+         utils::MemoryUsage(node_cache_) + utils::MemoryUsage(pretend_equal_);
+}
+
 }  // namespace opt
 }  // namespace spvtools
@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -87,9 +88,26 @@ class ScalarEvolutionAnalysis {
   // ValueUnknown nodes (such as a load instruction).
   SENode* SimplifyExpression(SENode* node);
 
-  // Add |prospective_node| into the cache and return a raw pointer to it. If
-  // |prospective_node| is already in the cache just return the raw pointer.
-  SENode* GetCachedOrAdd(std::unique_ptr<SENode> prospective_node);
+  // Returns a new node of type |T| constructed from this analysis and |args|.
+  // The node is allocated from the arena of this analysis and lives as long as
+  // the analysis does, but it is not hash-consed until it is passed to
+  // GetCachedOrAdd.
+  template <typename T, typename... Args>
+  T* CreateUncachedNode(Args&&... args) {
+    return node_arena_.New<T>(this, std::forward<Args>(args)...);
+  }
+
+  // Add |prospective_node| into the cache and return it. If an equal node is
+  // already in the cache, return that node instead. |prospective_node| must
+  // come from CreateUncachedNode.
+  SENode* GetCachedOrAdd(SENode* prospective_node);
+
+  // Forgets what has been computed for the phis of |loop|, of the loops nested
+  // in it and of the loops enclosing it, and removes from the cache the nodes
+  // referring to any of these loops. This allows the rest of the cache to be
+  // kept when a transformation only changes |loop|. Must be called before
+  // |loop| is destroyed.
+  void ForgetLoop(const Loop* loop);
 
   // Checks that the graph starting from |node| is invariant to the |loop|.
   bool IsLoopInvariant(const Loop* loop, const SENode* node) const;
@@ -127,6 +145,10 @@ class ScalarEvolutionAnalysis {
     pretend_equal_[std::get<1>(loop_pair)] = std::get<0>(loop_pair);
   }
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // analysis, including its nodes.
+  size_t MemoryUsage() const;
+
  private:
   SENode* AnalyzeConstant(const Instruction* inst);
 
@@ -139,32 +161,44 @@ class ScalarEvolutionAnalysis {
 
   SENode* AnalyzePhiInstruction(const Instruction* phi);
 
+  // Returns true if the graph starting from |node| contains a recurrent
+  // expression with respect to one of |loops|. |memo| caches the answer for
+  // the nodes already visited.
+  bool RefersToLoops(const SENode* node,
+                     const std::unordered_set<const Loop*>& loops,
+                     std::unordered_map<const SENode*, bool>* memo) const;
+
   IRContext* context_;
 
   // A map of instructions to SENodes. This is used to track recurrent
   // expressions as they are added when analyzing instructions. Recurrent
   // expressions come from phi nodes which by nature can include recursion so we
   // check if nodes have already been built when analyzing instructions.
-  std::map<const Instruction*, SENode*> recurrent_node_map_;
+  std::unordered_map<const Instruction*, SENode*> recurrent_node_map_;
+
+  // The phis in |recurrent_node_map_| grouped by the loop containing them, so
+  // that ForgetLoop does not need to look at the phis, which may have been
+  // killed.
+  std::unordered_map<const Loop*, std::vector<const Instruction*>>
+      phis_in_loop_;
 
   // On creation we create and cache the CantCompute node so we not need to
   // perform a needless create step.
   SENode* cached_cant_compute_;
 
-  // Helper functor to allow two unique_ptr to nodes to be compare. Only
-  // needed
+  // Helper functor to allow two pointers to nodes to be compared. Only needed
   // for the unordered_set implementation.
   struct NodePointersEquality {
-    bool operator()(const std::unique_ptr<SENode>& lhs,
-                    const std::unique_ptr<SENode>& rhs) const {
+    bool operator()(const SENode* lhs, const SENode* rhs) const {
       return *lhs == *rhs;
     }
   };
 
-  // Cache of nodes. All pointers to the nodes are references to the memory
-  // managed by they set.
-  std::unordered_set<std::unique_ptr<SENode>, SENodeHash, NodePointersEquality>
-      node_cache_;
+  // Owns every node created by this analysis, cached or not.
+  SENodeArena node_arena_;
+
+  // Cache of nodes. The nodes are owned by |node_arena_|.
+  std::unordered_set<SENode*, SENodeHash, NodePointersEquality> node_cache_;
 
   // Loops that should be considered the same for performing analysis for loop
   // fusion.
@@ -17,7 +17,9 @@
 
 #include <algorithm>
 #include <memory>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "source/opt/tree_iterator.h"
@@ -207,10 +209,52 @@ class SENode {
 // the type (as a string), the literal value of any constants, and the child
 // pointers which are assumed to be unique.
 struct SENodeHash {
-  size_t operator()(const std::unique_ptr<SENode>& node) const;
   size_t operator()(const SENode* node) const;
 };
 
+// Owns the nodes of a ScalarEvolutionAnalysis. Nodes are bump allocated from
+// fixed size blocks and are all destroyed with the arena, so creating a node,
+// even one that turns out to be already cached, costs no heap allocation of
+// its own.
+class SENodeArena {
+ public:
+  SENodeArena() : block_used_(kBlockSize) {}
+  SENodeArena(const SENodeArena&) = delete;
+  SENodeArena& operator=(const SENodeArena&) = delete;
+  ~SENodeArena();
+
+  // Constructs a |T| from |args| in the arena and returns it.
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    static_assert(sizeof(T) <= kBlockSize, "Node does not fit in a block.");
+    T* node = new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    nodes_.push_back(node);
+    return node;
+  }
+
+  // Returns the number of nodes allocated from the arena.
+  size_t size() const { return nodes_.size(); }
+
+  // Returns the number of bytes of memory used by the blocks of the arena and
+  // the list of its nodes.
+  size_t MemoryUsage() const {
+    return blocks_.size() * kBlockSize + nodes_.capacity() * sizeof(SENode*);
+  }
+
+ private:
+  static const size_t kBlockSize = 4096;
+
+  // Returns |size| bytes aligned to |alignment| from the current block,
+  // starting a new block if it is full.
+  void* Allocate(size_t size, size_t alignment);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  // The number of bytes used in the last block of |blocks_|.
+  size_t block_used_;
+  std::vector<SENode*> nodes_;
+};
+
 // A node representing a constant integer.
 class SEConstantNode : public SENode {
  public:
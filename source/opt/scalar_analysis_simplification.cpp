@@ -286,8 +286,8 @@ void SENodeSimplifyImpl::GatherAccumulatorsFromChildNodes(SENode* new_node,
 
 SERecurrentNode* SENodeSimplifyImpl::UpdateCoefficient(
     SERecurrentNode* recurrent, int64_t coefficient_update) const {
-  std::unique_ptr<SERecurrentNode> new_recurrent_node{new SERecurrentNode(
-      recurrent->GetParentAnalysis(), recurrent->GetLoop())};
+  SERecurrentNode* new_recurrent_node =
+      analysis_.CreateUncachedNode<SERecurrentNode>(recurrent->GetLoop());
 
   SENode* new_coefficient = analysis_.CreateMultiplyNode(
       recurrent->GetCoefficient(),
@@ -307,16 +307,15 @@ SERecurrentNode* SENodeSimplifyImpl::UpdateCoefficient(
 
   new_recurrent_node->AddCoefficient(new_coefficient);
 
-  return analysis_.GetCachedOrAdd(std::move(new_recurrent_node))
-      ->AsSERecurrentNode();
+  return analysis_.GetCachedOrAdd(new_recurrent_node)->AsSERecurrentNode();
 }
 
 // Simplify all the terms in the polynomial function.
 SENode* SENodeSimplifyImpl::SimplifyPolynomial() {
-  std::unique_ptr<SENode> new_add{new SEAddNode(node_->GetParentAnalysis())};
+  SENode* new_add = analysis_.CreateUncachedNode<SEAddNode>();
 
   // Traverse the graph and gather the accumulators from it.
-  GatherAccumulatorsFromChildNodes(new_add.get(), node_, false);
+  GatherAccumulatorsFromChildNodes(new_add, node_, false);
 
   // Fold all the constants into a single constant node.
   if (constant_accumulator_ != 0) {
@@ -367,11 +366,11 @@ SENode* SENodeSimplifyImpl::SimplifyPolynomial() {
     return analysis_.CreateConstant(0);
   }
 
-  return analysis_.GetCachedOrAdd(std::move(new_add));
+  return analysis_.GetCachedOrAdd(new_add);
 }
 
 SENode* SENodeSimplifyImpl::FoldRecurrentAddExpressions(SENode* root) {
-  std::unique_ptr<SEAddNode> new_node{new SEAddNode(&analysis_)};
+  SEAddNode* new_node = analysis_.CreateUncachedNode<SEAddNode>();
 
   // A mapping of loops to the list of recurrent expressions which are with
   // respect to those loops.
@@ -410,8 +409,8 @@ SENode* SENodeSimplifyImpl::FoldRecurrentAddExpressions(SENode* root) {
         pair.second;
     const Loop* loop = pair.first;
 
-    std::unique_ptr<SENode> new_coefficient{new SEAddNode(&analysis_)};
-    std::unique_ptr<SENode> new_offset{new SEAddNode(&analysis_)};
+    SENode* new_coefficient = analysis_.CreateUncachedNode<SEAddNode>();
+    SENode* new_offset = analysis_.CreateUncachedNode<SEAddNode>();
 
     for (auto node_pair : recurrent_expressions) {
       SERecurrentNode* node = node_pair.first;
@@ -427,14 +426,13 @@ SENode* SENodeSimplifyImpl::FoldRecurrentAddExpressions(SENode* root) {
       }
     }
 
-    std::unique_ptr<SERecurrentNode> new_recurrent{
-        new SERecurrentNode(&analysis_, loop)};
+    SERecurrentNode* new_recurrent =
+        analysis_.CreateUncachedNode<SERecurrentNode>(loop);
 
     SENode* new_coefficient_simplified =
-        analysis_.SimplifyExpression(new_coefficient.get());
+        analysis_.SimplifyExpression(new_coefficient);
 
-    SENode* new_offset_simplified =
-        analysis_.SimplifyExpression(new_offset.get());
+    SENode* new_offset_simplified = analysis_.SimplifyExpression(new_offset);
 
     if (new_coefficient_simplified->GetType() == SENode::Constant &&
         new_coefficient_simplified->AsSEConstantNode()->FoldToSingleValue() ==
@@ -445,7 +443,7 @@ SENode* SENodeSimplifyImpl::FoldRecurrentAddExpressions(SENode* root) {
     new_recurrent->AddCoefficient(new_coefficient_simplified);
     new_recurrent->AddOffset(new_offset_simplified);
 
-    new_node->AddChild(analysis_.GetCachedOrAdd(std::move(new_recurrent)));
+    new_node->AddChild(analysis_.GetCachedOrAdd(new_recurrent));
   }
 
   // If we only have one child in the add just return that.
@@ -453,7 +451,7 @@ SENode* SENodeSimplifyImpl::FoldRecurrentAddExpressions(SENode* root) {
     return new_node->GetChild(0);
   }
 
-  return analysis_.GetCachedOrAdd(std::move(new_node));
+  return analysis_.GetCachedOrAdd(new_node);
 }
 
 SENode* SENodeSimplifyImpl::EliminateZeroCoefficientRecurrents(SENode* node) {
@@ -482,25 +480,24 @@ SENode* SENodeSimplifyImpl::EliminateZeroCoefficientRecurrents(SENode* node) {
 
   if (!has_change) return node;
 
-  std::unique_ptr<SENode> new_add{new SEAddNode(node_->GetParentAnalysis())};
+  SENode* new_add = analysis_.CreateUncachedNode<SEAddNode>();
 
   for (SENode* child : new_children) {
     new_add->AddChild(child);
   }
 
-  return analysis_.GetCachedOrAdd(std::move(new_add));
+  return analysis_.GetCachedOrAdd(new_add);
 }
 
 SENode* SENodeSimplifyImpl::SimplifyRecurrentAddExpression(
     SERecurrentNode* recurrent_expr) {
   const std::vector<SENode*>& children = node_->GetChildren();
 
-  std::unique_ptr<SERecurrentNode> recurrent_node{new SERecurrentNode(
-      recurrent_expr->GetParentAnalysis(), recurrent_expr->GetLoop())};
+  SERecurrentNode* recurrent_node =
+      analysis_.CreateUncachedNode<SERecurrentNode>(recurrent_expr->GetLoop());
 
   // Create and simplify the new offset node.
-  std::unique_ptr<SENode> new_offset{
-      new SEAddNode(recurrent_expr->GetParentAnalysis())};
+  SENode* new_offset = analysis_.CreateUncachedNode<SEAddNode>();
   new_offset->AddChild(recurrent_expr->GetOffset());
 
   for (SENode* child : children) {
@@ -510,19 +507,19 @@ SENode* SENodeSimplifyImpl::SimplifyRecurrentAddExpression(
   }
 
   // Simplify the new offset.
-  SENode* simplified_child = analysis_.SimplifyExpression(new_offset.get());
+  SENode* simplified_child = analysis_.SimplifyExpression(new_offset);
 
   // If the child can be simplified, add the simplified form otherwise, add it
   // via the usual caching mechanism.
   if (simplified_child->GetType() != SENode::CanNotCompute) {
     recurrent_node->AddOffset(simplified_child);
   } else {
-    recurrent_expr->AddOffset(analysis_.GetCachedOrAdd(std::move(new_offset)));
+    recurrent_expr->AddOffset(analysis_.GetCachedOrAdd(new_offset));
   }
 
   recurrent_node->AddCoefficient(recurrent_expr->GetCoefficient());
 
-  return analysis_.GetCachedOrAdd(std::move(recurrent_node));
+  return analysis_.GetCachedOrAdd(recurrent_node);
 }
 
 /*
@@ -35,6 +35,7 @@ namespace opt {
 Pass::Status ScalarReplacementPass::Process() {
   Status status = Status::SuccessWithoutChange;
   for (auto& f : *get_module()) {
+    if (context()->IsFunctionFilteredOut(&f)) continue;
     Status functionStatus = ProcessFunction(&f);
     if (functionStatus == Status::Failure)
       return functionStatus;
@@ -82,8 +83,12 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
   }
 
   std::vector<Instruction*> dead;
+  // The loads and access chains that are replaced, mapped to the ids that
+  // replace them.  Their uses are updated in one batch once all of the users
+  // of |inst| have been visited.
+  std::unordered_map<uint32_t, uint32_t> replaced_ids;
   bool replaced_all_uses = get_def_use_mgr()->WhileEachUser(
-      inst, [this, &replacements, &dead](Instruction* user) {
+      inst, [this, &replacements, &dead, &replaced_ids](Instruction* user) {
         if (user->GetOpenCL100DebugOpcode() == OpenCLDebugInfo100DebugDeclare) {
           if (ReplaceWholeDebugDeclare(user, replacements)) {
             dead.push_back(user);
@@ -101,7 +106,7 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
         if (!IsAnnotationInst(user->opcode())) {
           switch (user->opcode()) {
             case SpvOpLoad:
-              if (ReplaceWholeLoad(user, replacements)) {
+              if (ReplaceWholeLoad(user, replacements, &replaced_ids)) {
                 dead.push_back(user);
               } else {
                 return false;
@@ -116,7 +121,7 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
               break;
             case SpvOpAccessChain:
             case SpvOpInBoundsAccessChain:
-              if (ReplaceAccessChain(user, replacements))
+              if (ReplaceAccessChain(user, replacements, &replaced_ids))
                 dead.push_back(user);
               else
                 return false;
@@ -131,6 +136,7 @@ Pass::Status ScalarReplacementPass::ReplaceVariable(
         }
         return true;
       });
+  context()->ReplaceAllUsesWith(replaced_ids);
 
   if (replaced_all_uses) {
     dead.push_back(inst);
@@ -215,7 +221,8 @@ bool ScalarReplacementPass::ReplaceWholeDebugValue(
 }
 
 bool ScalarReplacementPass::ReplaceWholeLoad(
-    Instruction* load, const std::vector<Instruction*>& replacements) {
+    Instruction* load, const std::vector<Instruction*>& replacements,
+    std::unordered_map<uint32_t, uint32_t>* replaced_ids) {
   // Replaces the load of the entire composite with a load from each replacement
   // variable followed by a composite construction.
   BasicBlock* block = context()->get_instr_block(load);
@@ -268,7 +275,7 @@ bool ScalarReplacementPass::ReplaceWholeLoad(
   get_def_use_mgr()->AnalyzeInstDefUse(&*where);
   where->UpdateDebugInfoFrom(load);
   context()->set_instr_block(&*where, block);
-  context()->ReplaceAllUsesWith(load->result_id(), compositeId);
+  (*replaced_ids)[load->result_id()] = compositeId;
   return true;
 }
 
@@ -323,7 +330,8 @@ bool ScalarReplacementPass::ReplaceWholeStore(
 }
 
 bool ScalarReplacementPass::ReplaceAccessChain(
-    Instruction* chain, const std::vector<Instruction*>& replacements) {
+    Instruction* chain, const std::vector<Instruction*>& replacements,
+    std::unordered_map<uint32_t, uint32_t>* replaced_ids) {
   // Replaces the access chain with either another access chain (with one fewer
   // indexes) or a direct use of the replacement variable.
   uint32_t indexId = chain->GetSingleWordInOperand(1u);
@@ -359,10 +367,10 @@ bool ScalarReplacementPass::ReplaceAccessChain(
       auto iter = chainIter.InsertBefore(std::move(replacementChain));
       get_def_use_mgr()->AnalyzeInstDefUse(&*iter);
       context()->set_instr_block(&*iter, context()->get_instr_block(chain));
-      context()->ReplaceAllUsesWith(chain->result_id(), replacementId);
+      (*replaced_ids)[chain->result_id()] = replacementId;
     } else {
       // Replace with a use of the variable.
-      context()->ReplaceAllUsesWith(chain->result_id(), var->result_id());
+      (*replaced_ids)[chain->result_id()] = var->result_id();
     }
   }
 
@@ -373,15 +381,13 @@ bool ScalarReplacementPass::CreateReplacementVariables(
     Instruction* inst, std::vector<Instruction*>* replacements) {
   Instruction* type = GetStorageType(inst);
 
-  std::unique_ptr<std::unordered_set<int64_t>> components_used =
-      GetUsedComponents(inst);
-
   uint32_t elem = 0;
   switch (type->opcode()) {
-    case SpvOpTypeStruct:
+    case SpvOpTypeStruct: {
+      const bool some_unused = GetUsedComponents(inst, type->NumInOperands());
       type->ForEachInOperand(
-          [this, inst, &elem, replacements, &components_used](uint32_t* id) {
-            if (!components_used || components_used->count(elem)) {
+          [this, inst, &elem, replacements, some_unused](uint32_t* id) {
+            if (!some_unused || used_components_[elem]) {
               CreateVariable(*id, inst, elem, replacements);
             } else {
               replacements->push_back(CreateNullConstant(*id));
@@ -389,9 +395,12 @@ bool ScalarReplacementPass::CreateReplacementVariables(
             elem++;
           });
       break;
-    case SpvOpTypeArray:
-      for (uint32_t i = 0; i != GetArrayLength(type); ++i) {
-        if (!components_used || components_used->count(i)) {
+    }
+    case SpvOpTypeArray: {
+      const uint32_t length = GetArrayLength(type);
+      const bool some_unused = GetUsedComponents(inst, length);
+      for (uint32_t i = 0; i != length; ++i) {
+        if (!some_unused || used_components_[i]) {
           CreateVariable(type->GetSingleWordInOperand(0u), inst, i,
                          replacements);
         } else {
@@ -400,6 +409,7 @@ bool ScalarReplacementPass::CreateReplacementVariables(
         }
       }
       break;
+    }
 
     case SpvOpTypeMatrix:
     case SpvOpTypeVector:
@@ -892,33 +902,28 @@ bool ScalarReplacementPass::IsLargerThanSizeLimit(uint64_t length) const {
   return length > max_num_elements_;
 }
 
-std::unique_ptr<std::unordered_set<int64_t>>
-ScalarReplacementPass::GetUsedComponents(Instruction* inst) {
-  std::unique_ptr<std::unordered_set<int64_t>> result(
-      new std::unordered_set<int64_t>());
+bool ScalarReplacementPass::GetUsedComponents(Instruction* inst,
+                                              uint32_t num_components) {
+  used_components_.assign(num_components, false);
+  auto mark_used = [this, num_components](int64_t index) {
+    if (index >= 0 && index < num_components) used_components_[index] = true;
+  };
 
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
 
-  def_use_mgr->WhileEachUser(inst, [&result, def_use_mgr,
-                                    this](Instruction* use) {
+  return def_use_mgr->WhileEachUser(inst, [&mark_used, def_use_mgr,
+                                           this](Instruction* use) {
     switch (use->opcode()) {
       case SpvOpLoad: {
         // Look for extract from the load.
-        std::vector<uint32_t> t;
-        if (def_use_mgr->WhileEachUser(use, [&t](Instruction* use2) {
-              if (use2->opcode() != SpvOpCompositeExtract ||
-                  use2->NumInOperands() <= 1) {
-                return false;
-              }
-              t.push_back(use2->GetSingleWordInOperand(1));
-              return true;
-            })) {
-          result->insert(t.begin(), t.end());
+        return def_use_mgr->WhileEachUser(use, [&mark_used](Instruction* use2) {
+          if (use2->opcode() != SpvOpCompositeExtract ||
+              use2->NumInOperands() <= 1) {
+            return false;
+          }
+          mark_used(use2->GetSingleWordInOperand(1));
           return true;
-        } else {
-          result.reset(nullptr);
-          return false;
-        }
+        });
       }
       case SpvOpName:
       case SpvOpMemberName:
@@ -934,22 +939,18 @@ ScalarReplacementPass::GetUsedComponents(Instruction* inst) {
         const analysis::Constant* index_const =
             const_mgr->FindDeclaredConstant(index_id);
         if (index_const) {
-          result->insert(index_const->GetSignExtendedValue());
+          mark_used(index_const->GetSignExtendedValue());
           return true;
         } else {
           // Could be any element.  Assuming all are used.
-          result.reset(nullptr);
           return false;
         }
       }
       default:
         // We do not know what is happening.  Have to assume the worst.
-        result.reset(nullptr);
         return false;
     }
   });
-
-  return result;
 }
 
 Instruction* ScalarReplacementPass::CreateNullConstant(uint32_t type_id) {
@@ -19,7 +19,6 @@
 #include <memory>
 #include <queue>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include "source/opt/function.h"
@@ -186,11 +185,14 @@ class ScalarReplacementPass : public Pass {
   // Replaces the load to the entire composite.
   //
   // Generates a load for each replacement variable and then creates a new
-  // composite by combining all of the loads.
+  // composite by combining all of the loads.  The uses of |load| are not
+  // replaced: the id of the new composite is recorded for |load| in
+  // |replaced_ids|, so that the caller replaces them all at once.
   //
   // |load| must be a load.  Returns true if successful.
   bool ReplaceWholeLoad(Instruction* load,
-                        const std::vector<Instruction*>& replacements);
+                        const std::vector<Instruction*>& replacements,
+                        std::unordered_map<uint32_t, uint32_t>* replaced_ids);
 
   // Replaces the store to the entire composite.
   //
@@ -216,16 +218,18 @@ class ScalarReplacementPass : public Pass {
 
   // Replaces an access chain to the composite variable with either a direct use
   // of the appropriate replacement variable or another access chain with the
-  // replacement variable as the base and one fewer indexes. Returns true if
-  // successful.
+  // replacement variable as the base and one fewer indexes. As with
+  // |ReplaceWholeLoad|, the uses of |chain| are only recorded in
+  // |replaced_ids|. Returns true if successful.
   bool ReplaceAccessChain(Instruction* chain,
-                          const std::vector<Instruction*>& replacements);
+                          const std::vector<Instruction*>& replacements,
+                          std::unordered_map<uint32_t, uint32_t>* replaced_ids);
 
-  // Returns a set containing the which components of the result of |inst| are
-  // potentially used.  If the return value is |nullptr|, then every components
-  // is possibly used.
-  std::unique_ptr<std::unordered_set<int64_t>> GetUsedComponents(
-      Instruction* inst);
+  // Sets the first |num_components| entries of |used_components_| to flag the
+  // components of the result of |inst| that are potentially used.  Returns
+  // false if every component is possibly used, in which case the contents of
+  // |used_components_| are unspecified.
+  bool GetUsedComponents(Instruction* inst, uint32_t num_components);
 
   // Returns an instruction defining a null constant with type |type_id|.  If
   // one already exists, it is returned.  Otherwise a new one is created.
@@ -245,6 +249,10 @@ class ScalarReplacementPass : public Pass {
   // that we will be willing to split.
   bool IsLargerThanSizeLimit(uint64_t length) const;
 
+  // The components found to be used by |GetUsedComponents|.  It is reused for
+  // every variable, so the analysis does not allocate per variable.
+  std::vector<bool> used_components_;
+
   // Limit on the number of members in an object that will be replaced.
   // 0 means there is no limit.
   uint32_t max_num_elements_;
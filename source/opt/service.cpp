@@ -0,0 +1,293 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "spirv-tools/service.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "source/spirv_optimizer_options.h"
+#include "source/spirv_validator_options.h"
+#include "source/table.h"
+#include "spirv-tools/optimizer.hpp"
+
+namespace spvtools {
+namespace {
+
+// The biggest flag and module a stream may hold.  Anything bigger is taken
+// for a corrupt stream rather than allocated.
+const uint32_t kMaxFlagBytes = 1u << 16;
+const uint32_t kMaxFlags = 1u << 16;
+const uint32_t kMaxModuleWords = 1u << 28;
+
+// The number of modules the service remembers to be valid.
+const size_t kCacheCapacity = 4096;
+
+// Returns a consumer that appends the messages it receives to |messages|, in
+// the format of the command-line tools.
+MessageConsumer CaptureMessages(std::string* messages) {
+  return [messages](spv_message_level_t level, const char*,
+                    const spv_position_t& position, const char* message) {
+    const char* prefix = nullptr;
+    switch (level) {
+      case SPV_MSG_FATAL:
+      case SPV_MSG_INTERNAL_ERROR:
+      case SPV_MSG_ERROR:
+        prefix = "error";
+        break;
+      case SPV_MSG_WARNING:
+        prefix = "warning";
+        break;
+      case SPV_MSG_INFO:
+        prefix = "info";
+        break;
+      default:
+        return;
+    }
+    std::ostringstream line;
+    line << prefix << ": line " << position.index << ": " << message << "\n";
+    messages->append(line.str());
+  };
+}
+
+bool ReadWord(std::istream& in, uint32_t* word) {
+  in.read(reinterpret_cast<char*>(word), sizeof(*word));
+  return in.gcount() == static_cast<std::streamsize>(sizeof(*word));
+}
+
+bool ReadString(std::istream& in, std::string* str) {
+  uint32_t size = 0;
+  if (!ReadWord(in, &size) || size > kMaxFlagBytes) return false;
+  str->resize(size);
+  if (size == 0) return true;
+  in.read(&(*str)[0], size);
+  return in.gcount() == static_cast<std::streamsize>(size);
+}
+
+enum class ReadStatus { kRequest, kEnd, kInvalid };
+
+// Reads the next request of |in| into |request|.
+ReadStatus ReadRequest(std::istream& in, Service::Request* request) {
+  if (in.peek() == std::istream::traits_type::eof()) return ReadStatus::kEnd;
+
+  uint32_t kind = 0;
+  if (!ReadWord(in, &kind)) return ReadStatus::kInvalid;
+  request->kind = static_cast<Service::RequestKind>(kind);
+
+  uint32_t num_flags = 0;
+  if (!ReadWord(in, &num_flags) || num_flags > kMaxFlags) {
+    return ReadStatus::kInvalid;
+  }
+  request->flags.resize(num_flags);
+  for (std::string& flag : request->flags) {
+    if (!ReadString(in, &flag)) return ReadStatus::kInvalid;
+  }
+
+  uint32_t num_words = 0;
+  if (!ReadWord(in, &num_words) || num_words > kMaxModuleWords) {
+    return ReadStatus::kInvalid;
+  }
+  request->binary.resize(num_words);
+  if (num_words == 0) return ReadStatus::kRequest;
+  const std::streamsize num_bytes = num_words * sizeof(uint32_t);
+  in.read(reinterpret_cast<char*>(request->binary.data()), num_bytes);
+  return in.gcount() == num_bytes ? ReadStatus::kRequest
+                                  : ReadStatus::kInvalid;
+}
+
+void WriteWord(std::ostream& out, uint32_t word) {
+  out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+bool WriteResponse(std::ostream& out, const Service::Response& response) {
+  WriteWord(out, response.success ? 0 : 1);
+  WriteWord(out, static_cast<uint32_t>(response.messages.size()));
+  out.write(response.messages.data(), response.messages.size());
+  WriteWord(out, static_cast<uint32_t>(response.binary.size()));
+  out.write(reinterpret_cast<const char*>(response.binary.data()),
+            response.binary.size() * sizeof(uint32_t));
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+}  // namespace
+
+struct Service::Impl {
+  Impl(spv_target_env target_env, uint32_t threads)
+      : env(target_env),
+        num_threads(threads == 0 ? 1 : threads),
+        context(spvContextCreate(target_env)),
+        cache(kCacheCapacity) {
+    SyncOptions();
+  }
+  ~Impl() { spvContextDestroy(context); }
+
+  // Makes the validator options use the cache of the service unless they
+  // have one, and gives them to the optimizer options.
+  void SyncOptions() {
+    if (!validator_options.cache) validator_options.cache = cache;
+    optimizer_options.val_options_ = validator_options;
+  }
+
+  const spv_target_env env;
+  const uint32_t num_threads;
+  spv_context context;
+  ValidationCache cache;
+  spv_validator_options_t validator_options;
+  spv_optimizer_options_t optimizer_options;
+};
+
+Service::Service(spv_target_env env, uint32_t num_threads)
+    : impl_(new Impl(env, num_threads)) {}
+
+Service::~Service() = default;
+
+void Service::SetValidatorOptions(const ValidatorOptions& options) {
+  impl_->validator_options = *static_cast<spv_validator_options>(options);
+  impl_->SyncOptions();
+}
+
+void Service::SetOptimizerOptions(const OptimizerOptions& options) {
+  impl_->optimizer_options = *static_cast<spv_optimizer_options>(options);
+  impl_->SyncOptions();
+}
+
+Service::Response Service::Process(const Request& request) const {
+  Response response;
+  MessageConsumer consumer = CaptureMessages(&response.messages);
+
+  switch (request.kind) {
+    case RequestKind::kOptimize: {
+      Optimizer optimizer(impl_->env);
+      optimizer.SetMessageConsumer(consumer);
+      if (!optimizer.RegisterPassesFromFlags(request.flags)) break;
+      response.success =
+          optimizer.Run(request.binary.data(), request.binary.size(),
+                        &response.binary, &impl_->optimizer_options);
+      break;
+    }
+    case RequestKind::kValidate: {
+      if (!request.flags.empty()) {
+        response.messages = "error: validation requests take no flags\n";
+        break;
+      }
+      // The context is shared by all requests, so each one gets a copy that
+      // reports to its own consumer.
+      spv_context_t context = *impl_->context;
+      context.consumer = consumer;
+      spv_const_binary_t binary = {request.binary.data(),
+                                   request.binary.size()};
+      response.success =
+          spvValidateWithOptions(&context, &impl_->validator_options, &binary,
+                                 nullptr) == SPV_SUCCESS;
+      break;
+    }
+    default:
+      response.messages = "error: unknown request kind " +
+                          std::to_string(static_cast<uint32_t>(request.kind)) +
+                          "\n";
+      break;
+  }
+  return response;
+}
+
+bool Service::Serve(std::istream& in, std::ostream& out) const {
+  struct Slot {
+    Request request;
+    Response response;
+    bool done = false;
+  };
+
+  // Requests are processed in any order, but answered in the order they were
+  // read.  |pending| holds the requests that are not answered yet, and
+  // |queued| those that are not processed yet.  Reading stops while too many
+  // requests are pending, so a fast client cannot exhaust memory.
+  const size_t max_pending = 4 * impl_->num_threads;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::shared_ptr<Slot>> pending;
+  std::deque<std::shared_ptr<Slot>> queued;
+  bool reading = true;
+  bool write_failed = false;
+
+  auto process = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      changed.wait(lock, [&]() { return !queued.empty() || !reading; });
+      if (queued.empty()) return;
+      std::shared_ptr<Slot> slot = queued.front();
+      queued.pop_front();
+      lock.unlock();
+      Response response = Process(slot->request);
+      lock.lock();
+      slot->response = std::move(response);
+      slot->done = true;
+      changed.notify_all();
+    }
+  };
+
+  auto write = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      changed.wait(lock, [&]() {
+        return (!pending.empty() && pending.front()->done) ||
+               (pending.empty() && !reading);
+      });
+      if (pending.empty()) return;
+      std::shared_ptr<Slot> slot = pending.front();
+      pending.pop_front();
+      changed.notify_all();
+      lock.unlock();
+      bool written = !write_failed && WriteResponse(out, slot->response);
+      lock.lock();
+      if (!written) write_failed = true;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (uint32_t i = 0; i < impl_->num_threads; ++i) {
+    workers.emplace_back(process);
+  }
+  std::thread writer(write);
+
+  bool complete = true;
+  while (true) {
+    auto slot = std::make_shared<Slot>();
+    ReadStatus status = ReadRequest(in, &slot->request);
+    if (status != ReadStatus::kRequest) {
+      complete = status == ReadStatus::kEnd;
+      break;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return pending.size() < max_pending; });
+    pending.push_back(slot);
+    queued.push_back(std::move(slot));
+    changed.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    reading = false;
+  }
+  changed.notify_all();
+  for (std::thread& worker : workers) worker.join();
+  writer.join();
+  return complete && !write_failed;
+}
+
+}  // namespace spvtools
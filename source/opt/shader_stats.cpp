@@ -0,0 +1,187 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/shader_stats.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "source/opcode.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// The trip count assumed for a loop whose trip count is not known.
+const double kUnknownTripCount = 8;
+
+// The function calls are followed no deeper than this, which only matters
+// for invalid modules with recursion.
+const uint32_t kMaxCallDepth = 64;
+
+bool IsTextureOp(SpvOp opcode) {
+  if (spvOpcodeIsImageSample(opcode)) return true;
+  switch (opcode) {
+    case SpvOpImageFetch:
+    case SpvOpImageGather:
+    case SpvOpImageDrefGather:
+    case SpvOpImageRead:
+    case SpvOpImageWrite:
+    case SpvOpImageSparseFetch:
+    case SpvOpImageSparseGather:
+    case SpvOpImageSparseDrefGather:
+    case SpvOpImageSparseRead:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsMemoryOp(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpLoad:
+    case SpvOpStore:
+    case SpvOpCopyMemory:
+    case SpvOpCopyMemorySized:
+      return true;
+    default:
+      return spvOpcodeIsAtomicOp(opcode);
+  }
+}
+
+// Returns true if |inst| does not stand for any work of its own.
+bool IsFree(const Instruction& inst) {
+  switch (inst.opcode()) {
+    case SpvOpNop:
+    case SpvOpPhi:
+    case SpvOpVariable:
+    case SpvOpUndef:
+    case SpvOpSelectionMerge:
+    case SpvOpLoopMerge:
+      return true;
+    default:
+      return inst.IsOpenCL100DebugInstr();
+  }
+}
+
+// Accumulates the stats of one entry point.
+class StatsBuilder {
+ public:
+  StatsBuilder(IRContext* context, EntryPointStats* stats)
+      : context_(context), stats_(stats) {}
+
+  // Adds the instructions of |func| with weight |weight|, and those of the
+  // functions it calls.
+  void AddFunction(Function* func, double weight, uint32_t depth) {
+    if (depth > kMaxCallDepth) return;
+    LoopDescriptor* loops = context_->GetLoopDescriptor(func);
+    const RegisterLiveness* liveness =
+        context_->GetLivenessAnalysis()->Get(func);
+    for (auto& block : *func) {
+      const double block_weight =
+          weight * GetLoopNestWeight((*loops)[block.id()]);
+      if (const auto* block_liveness = liveness->Get(&block)) {
+        stats_->max_live_registers = std::max(stats_->max_live_registers,
+                                              block_liveness->used_registers_);
+      }
+      for (auto& inst : block) {
+        AddInstruction(inst, block_weight, depth);
+      }
+    }
+  }
+
+ private:
+  void AddInstruction(const Instruction& inst, double weight, uint32_t depth) {
+    const SpvOp opcode = inst.opcode();
+    if (IsFree(inst)) return;
+    if (opcode == SpvOpControlBarrier || opcode == SpvOpMemoryBarrier) {
+      stats_->barriers += weight;
+    } else if (IsTextureOp(opcode)) {
+      stats_->texture_instructions += weight;
+    } else if (IsMemoryOp(opcode)) {
+      stats_->memory_instructions += weight;
+    } else if (spvOpcodeIsBlockTerminator(opcode) ||
+               opcode == SpvOpFunctionCall) {
+      stats_->control_instructions += weight;
+      if (IsDynamicBranch(inst)) stats_->dynamic_branches += weight;
+      if (opcode == SpvOpFunctionCall) {
+        Function* callee =
+            context_->GetFunction(inst.GetSingleWordInOperand(0));
+        if (callee != nullptr) AddFunction(callee, weight, depth + 1);
+      }
+    } else {
+      stats_->alu_instructions += weight;
+    }
+  }
+
+  // Returns true if |inst| is a branch or switch on a value that is not a
+  // constant.
+  bool IsDynamicBranch(const Instruction& inst) {
+    if (inst.opcode() != SpvOpBranchConditional &&
+        inst.opcode() != SpvOpSwitch) {
+      return false;
+    }
+    const Instruction* condition =
+        context_->get_def_use_mgr()->GetDef(inst.GetSingleWordInOperand(0));
+    return condition == nullptr || !spvOpcodeIsConstant(condition->opcode());
+  }
+
+  // Returns the number of times a block of |loop| is expected to run each
+  // time the outermost loop containing it is entered.
+  double GetLoopNestWeight(const Loop* loop) {
+    if (loop == nullptr) return 1;
+    auto it = loop_weights_.find(loop);
+    if (it != loop_weights_.end()) return it->second;
+
+    double trip_count = kUnknownTripCount;
+    const BasicBlock* condition = loop->FindConditionBlock();
+    const Instruction* induction =
+        condition ? loop->FindConditionVariable(condition) : nullptr;
+    size_t iterations = 0;
+    if (induction != nullptr &&
+        loop->FindNumberOfIterations(induction, &*condition->ctail(),
+                                     &iterations)) {
+      trip_count = static_cast<double>(iterations);
+    }
+    const double weight = trip_count * GetLoopNestWeight(loop->GetParent());
+    loop_weights_[loop] = weight;
+    return weight;
+  }
+
+  IRContext* context_;
+  EntryPointStats* stats_;
+  std::unordered_map<const Loop*, double> loop_weights_;
+};
+
+}  // namespace
+
+std::vector<EntryPointStats> ComputeEntryPointStats(IRContext* context) {
+  std::vector<EntryPointStats> all_stats;
+  for (auto& entry_point : context->module()->entry_points()) {
+    EntryPointStats stats;
+    stats.execution_model = entry_point.GetSingleWordInOperand(0);
+    stats.name = entry_point.GetInOperand(2).AsString();
+    Function* func =
+        context->GetFunction(entry_point.GetSingleWordInOperand(1));
+    if (func != nullptr) {
+      StatsBuilder(context, &stats).AddFunction(func, 1, 0);
+    }
+    all_stats.push_back(std::move(stats));
+  }
+  return all_stats;
+}
+
+}  // namespace opt
+}  // namespace spvtools
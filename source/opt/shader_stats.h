@@ -0,0 +1,55 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_SHADER_STATS_H_
+#define SOURCE_OPT_SHADER_STATS_H_
+
+#include <string>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+// Static estimates of the cost of running one entry point, meant to catch
+// performance regressions rather than to predict run times.  The instruction
+// counts cover the functions called by the entry point, and each instruction
+// is weighted by the number of times its block is expected to run per
+// invocation: the product of the trip counts of the loops containing it,
+// assuming 8 iterations for loops whose trip count is not known, and of the
+// weights of the calls leading to it.
+struct EntryPointStats {
+  std::string name;              // The name of the entry point.
+  uint32_t execution_model = 0;  // Its SpvExecutionModel.
+  double alu_instructions = 0;   // Instructions in none of the other groups.
+  double memory_instructions = 0;   // Loads, stores, copies and atomics.
+  double texture_instructions = 0;  // Image samples, fetches, reads, writes.
+  double control_instructions = 0;  // Block terminators and function calls.
+  double barriers = 0;              // Control and memory barriers.
+  // Conditional branches and switches on values that are not constants.
+  double dynamic_branches = 0;
+  // The largest number of registers used in a block, as estimated by
+  // |RegisterLiveness|.
+  size_t max_live_registers = 0;
+};
+
+// Returns the stats of each entry point of the module of |context|, in the
+// order of the OpEntryPoint instructions.
+std::vector<EntryPointStats> ComputeEntryPointStats(IRContext* context);
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_SHADER_STATS_H_
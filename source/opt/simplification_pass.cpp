@@ -14,11 +14,10 @@
 
 #include "source/opt/simplification_pass.h"
 
-#include <set>
-#include <unordered_set>
 #include <vector>
 
 #include "source/opt/fold.h"
+#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
@@ -33,17 +32,31 @@ Pass::Status SimplificationPass::Process() {
 }
 
 void SimplificationPass::AddNewOperands(
-    Instruction* folded_inst, std::unordered_set<Instruction*>* inst_seen,
+    Instruction* folded_inst, utils::BitVector* inst_seen,
     std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
   folded_inst->ForEachInId(
       [&inst_seen, &def_use_mgr, &work_list](uint32_t* iid) {
         Instruction* iid_inst = def_use_mgr->GetDef(*iid);
-        if (!inst_seen->insert(iid_inst).second) return;
+        if (inst_seen->Set(iid_inst->unique_id())) return;
         work_list->push_back(iid_inst);
       });
 }
 
+bool SimplificationPass::TrySimplify(const InstructionFolder& folder,
+                                     Instruction* inst) {
+  if (inst->opcode() == SpvOpCopyObject) {
+    return context()->get_decoration_mgr()->HaveSubsetOfDecorations(
+        inst->result_id(), inst->GetSingleWordInOperand(0));
+  }
+
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  if (def_use_mgr->IsMarkedUnchanged(inst)) return false;
+  if (folder.FoldInstruction(inst)) return true;
+  def_use_mgr->MarkUnchanged(inst);
+  return false;
+}
+
 bool SimplificationPass::SimplifyFunction(Function* function) {
   bool modified = false;
   // Phase 1: Traverse all instructions in dominance order.
@@ -52,11 +65,15 @@ bool SimplificationPass::SimplifyFunction(Function* function) {
   // only instructions whose inputs do not necessarily dominate the use, we keep
   // track of the OpPhi instructions already seen, and add them to the work list
   // for phase 2 when needed.
+  //
+  // The sets of instructions are indexed by unique id.  Instructions that an
+  // earlier run already tried and could not simplify are skipped, unless they
+  // or the definitions of their operands have changed since.
   std::vector<Instruction*> work_list;
-  std::unordered_set<Instruction*> process_phis;
-  std::unordered_set<Instruction*> inst_to_kill;
-  std::unordered_set<Instruction*> in_work_list;
-  std::unordered_set<Instruction*> inst_seen;
+  std::vector<Instruction*> inst_to_kill;
+  utils::BitVector process_phis;
+  utils::BitVector in_work_list;
+  utils::BitVector inst_seen;
   const InstructionFolder& folder = context()->get_instruction_folder();
 
   cfg()->ForEachBlockInReversePostOrder(
@@ -64,23 +81,19 @@ bool SimplificationPass::SimplifyFunction(Function* function) {
       [&modified, &process_phis, &work_list, &in_work_list, &inst_to_kill,
        &folder, &inst_seen, this](BasicBlock* bb) {
         for (Instruction* inst = &*bb->begin(); inst; inst = inst->NextNode()) {
-          inst_seen.insert(inst);
+          inst_seen.Set(inst->unique_id());
           if (inst->opcode() == SpvOpPhi) {
-            process_phis.insert(inst);
+            process_phis.Set(inst->unique_id());
           }
 
-          bool is_foldable_copy =
-              inst->opcode() == SpvOpCopyObject &&
-              context()->get_decoration_mgr()->HaveSubsetOfDecorations(
-                  inst->result_id(), inst->GetSingleWordInOperand(0));
-
-          if (is_foldable_copy || folder.FoldInstruction(inst)) {
+          if (TrySimplify(folder, inst)) {
             modified = true;
             context()->AnalyzeUses(inst);
             get_def_use_mgr()->ForEachUser(inst, [&work_list, &process_phis,
                                                   &in_work_list](
                                                      Instruction* use) {
-              if (process_phis.count(use) && in_work_list.insert(use).second) {
+              if (process_phis.Get(use->unique_id()) &&
+                  !in_work_list.Set(use->unique_id())) {
                 work_list.push_back(use);
               }
             });
@@ -98,11 +111,11 @@ bool SimplificationPass::SimplifyFunction(Function* function) {
                     }
                     return false;
                   });
-              inst_to_kill.insert(inst);
-              in_work_list.insert(inst);
+              inst_to_kill.push_back(inst);
+              in_work_list.Set(inst->unique_id());
             } else if (inst->opcode() == SpvOpNop) {
-              inst_to_kill.insert(inst);
-              in_work_list.insert(inst);
+              inst_to_kill.push_back(inst);
+              in_work_list.Set(inst->unique_id());
             }
           }
         }
@@ -113,21 +126,16 @@ bool SimplificationPass::SimplifyFunction(Function* function) {
   //          has already finished.
   for (size_t i = 0; i < work_list.size(); ++i) {
     Instruction* inst = work_list[i];
-    in_work_list.erase(inst);
-    inst_seen.insert(inst);
-
-    bool is_foldable_copy =
-        inst->opcode() == SpvOpCopyObject &&
-        context()->get_decoration_mgr()->HaveSubsetOfDecorations(
-            inst->result_id(), inst->GetSingleWordInOperand(0));
+    in_work_list.Clear(inst->unique_id());
+    inst_seen.Set(inst->unique_id());
 
-    if (is_foldable_copy || folder.FoldInstruction(inst)) {
+    if (TrySimplify(folder, inst)) {
       modified = true;
       context()->AnalyzeUses(inst);
       get_def_use_mgr()->ForEachUser(
           inst, [&work_list, &in_work_list](Instruction* use) {
             if (!use->IsDecoration() && use->opcode() != SpvOpName &&
-                in_work_list.insert(use).second) {
+                !in_work_list.Set(use->unique_id())) {
               work_list.push_back(use);
             }
           });
@@ -144,11 +152,11 @@ bool SimplificationPass::SimplifyFunction(Function* function) {
               }
               return false;
             });
-        inst_to_kill.insert(inst);
-        in_work_list.insert(inst);
+        inst_to_kill.push_back(inst);
+        in_work_list.Set(inst->unique_id());
       } else if (inst->opcode() == SpvOpNop) {
-        inst_to_kill.insert(inst);
-        in_work_list.insert(inst);
+        inst_to_kill.push_back(inst);
+        in_work_list.Set(inst->unique_id());
       }
     }
   }
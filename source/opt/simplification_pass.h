@@ -15,9 +15,13 @@
 #ifndef SOURCE_OPT_SIMPLIFICATION_PASS_H_
 #define SOURCE_OPT_SIMPLIFICATION_PASS_H_
 
+#include <vector>
+
+#include "source/opt/fold.h"
 #include "source/opt/function.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/pass.h"
+#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
@@ -34,7 +38,8 @@ class SimplificationPass : public Pass {
            IRContext::kAnalysisDecorations | IRContext::kAnalysisCombinators |
            IRContext::kAnalysisCFG | IRContext::kAnalysisDominatorAnalysis |
            IRContext::kAnalysisNameMap | IRContext::kAnalysisConstants |
-           IRContext::kAnalysisTypes;
+           IRContext::kAnalysisTypes | IRContext::kAnalysisReflection |
+           IRContext::kAnalysisCallGraph;
   }
 
  private:
@@ -43,12 +48,17 @@ class SimplificationPass : public Pass {
   // simplified.
   bool SimplifyFunction(Function* function);
 
+  // Returns true if |inst| was simplified in place by |folder|, or is an
+  // OpCopyObject that can be replaced by its operand.  Instructions that cannot
+  // be folded are marked unchanged in the def-use manager, so they are not
+  // tried again until they or the definitions of their operands change.
+  bool TrySimplify(const InstructionFolder& folder, Instruction* inst);
+
   // FactorAddMul can create |folded_inst| Mul of new Add. If Mul, push any Add
   // operand not in |seen_inst| into |worklist|. This is heavily restricted to
   // improve compile time but can be expanded for future simplifications which
   // simiarly create new operations.
-  void AddNewOperands(Instruction* folded_inst,
-                      std::unordered_set<Instruction*>* inst_seen,
+  void AddNewOperands(Instruction* folded_inst, utils::BitVector* inst_seen,
                       std::vector<Instruction*>* work_list);
 };
 
@@ -0,0 +1,285 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/slp_vectorize_pass.h"
+
+#include <utility>
+
+#include "source/opt/ir_builder.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const uint32_t kCompositeExtractCompositeIdInIdx = 0;
+const uint32_t kCompositeExtractFirstIndexInIdx = 1;
+const uint32_t kTypeVectorComponentTypeInIdx = 0;
+const uint32_t kTypeVectorCountInIdx = 1;
+
+// The deepest operation in a tree that is vectorized.
+const uint32_t kMaxTreeDepth = 16;
+
+// Returns true if |opcode| is a component-wise arithmetic operation that has
+// the same meaning on scalars and vectors.
+bool IsVectorizableOpcode(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpFNegate:
+    case SpvOpSNegate:
+    case SpvOpFAdd:
+    case SpvOpFSub:
+    case SpvOpFMul:
+    case SpvOpFDiv:
+    case SpvOpIAdd:
+    case SpvOpISub:
+    case SpvOpIMul:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+uint32_t SLPVectorizePass::LeafCost(Pack::Kind kind) {
+  switch (kind) {
+    case Pack::kExtract:
+    case Pack::kConstant:
+      return 0;
+    default:
+      // A shuffle or a composite construct.
+      return 1;
+  }
+}
+
+bool SLPVectorizePass::IsIsomorphicOperation(
+    const std::vector<Instruction*>& lanes, uint32_t component_type_id,
+    const BasicBlock* block) {
+  const SpvOp opcode = lanes[0]->opcode();
+  if (!IsVectorizableOpcode(opcode)) return false;
+  for (Instruction* inst : lanes) {
+    if (inst->opcode() != opcode || inst->type_id() != component_type_id ||
+        context()->get_instr_block(inst) != block) {
+      return false;
+    }
+    // Each lane must only feed its user in the tree, so that the scalar
+    // operation goes away.
+    if (get_def_use_mgr()->NumUses(inst) != 1) return false;
+    // The lanes could be decorated differently, e.g. with NoContraction.
+    if (!get_decoration_mgr()->GetDecorationsFor(inst->result_id(), false)
+             .empty()) {
+      return false;
+    }
+    for (uint32_t i = 0; i < inst->NumInOperands(); ++i) {
+      const Instruction* operand =
+          get_def_use_mgr()->GetDef(inst->GetSingleWordInOperand(i));
+      if (operand->type_id() != component_type_id) return false;
+    }
+  }
+  return true;
+}
+
+size_t SLPVectorizePass::BuildPack(const std::vector<uint32_t>& lanes,
+                                   uint32_t vector_type_id,
+                                   uint32_t component_type_id,
+                                   const BasicBlock* block, uint32_t depth,
+                                   std::vector<Pack>* packs) {
+  std::vector<Instruction*> lane_insts;
+  for (uint32_t id : lanes) {
+    lane_insts.push_back(get_def_use_mgr()->GetDef(id));
+  }
+
+  Pack pack;
+  pack.lanes = lanes;
+  pack.opcode = SpvOpNop;
+  pack.source = 0;
+
+  if (depth < kMaxTreeDepth &&
+      IsIsomorphicOperation(lane_insts, component_type_id, block)) {
+    pack.kind = Pack::kOperation;
+    pack.opcode = lane_insts[0]->opcode();
+    for (uint32_t i = 0; i < lane_insts[0]->NumInOperands(); ++i) {
+      std::vector<uint32_t> operand_lanes;
+      for (Instruction* inst : lane_insts) {
+        operand_lanes.push_back(inst->GetSingleWordInOperand(i));
+      }
+      pack.operands.push_back(BuildPack(operand_lanes, vector_type_id,
+                                        component_type_id, block, depth + 1,
+                                        packs));
+    }
+    packs->push_back(std::move(pack));
+    return packs->size() - 1;
+  }
+
+  pack.kind = Pack::kGather;
+  bool all_constants = true;
+  bool all_extracts = true;
+  for (Instruction* inst : lane_insts) {
+    if (!context()->get_constant_mgr()->FindDeclaredConstant(
+            inst->result_id())) {
+      all_constants = false;
+    }
+    if (inst->opcode() != SpvOpCompositeExtract || inst->NumInOperands() != 2) {
+      all_extracts = false;
+      continue;
+    }
+    const uint32_t source =
+        inst->GetSingleWordInOperand(kCompositeExtractCompositeIdInIdx);
+    if (pack.source == 0) pack.source = source;
+    if (source != pack.source ||
+        get_def_use_mgr()->GetDef(source)->type_id() != vector_type_id) {
+      all_extracts = false;
+    }
+  }
+
+  if (all_constants) {
+    pack.kind = Pack::kConstant;
+  } else if (all_extracts) {
+    pack.kind = Pack::kExtract;
+    for (uint32_t lane = 0; lane < lane_insts.size(); ++lane) {
+      const uint32_t component = lane_insts[lane]->GetSingleWordInOperand(
+          kCompositeExtractFirstIndexInIdx);
+      pack.components.push_back(component);
+      if (component != lane) pack.kind = Pack::kShuffle;
+    }
+  }
+  packs->push_back(std::move(pack));
+  return packs->size() - 1;
+}
+
+bool SLPVectorizePass::VectorizeConstruct(Instruction* construct) {
+  const Instruction* vector_type =
+      get_def_use_mgr()->GetDef(construct->type_id());
+  if (vector_type->opcode() != SpvOpTypeVector) return false;
+  const uint32_t component_type_id =
+      vector_type->GetSingleWordInOperand(kTypeVectorComponentTypeInIdx);
+  const uint32_t num_lanes =
+      vector_type->GetSingleWordInOperand(kTypeVectorCountInIdx);
+  if (construct->NumInOperands() != num_lanes) return false;
+
+  std::vector<uint32_t> lanes;
+  for (uint32_t i = 0; i < num_lanes; ++i) {
+    lanes.push_back(construct->GetSingleWordInOperand(i));
+  }
+
+  std::vector<Pack> packs;
+  BuildPack(lanes, construct->type_id(), component_type_id,
+            context()->get_instr_block(construct), 0, &packs);
+  if (packs.back().kind != Pack::kOperation) return false;
+
+  // Each vector operation replaces one scalar operation per lane, and the
+  // leaves that are not already vectors or constants need one instruction to
+  // be put together.
+  uint32_t savings = 0;
+  uint32_t cost = 0;
+  for (const Pack& pack : packs) {
+    if (pack.kind == Pack::kOperation) {
+      savings += num_lanes - 1;
+    } else {
+      cost += LeafCost(pack.kind);
+    }
+  }
+  if (savings <= cost) return false;
+
+  InstructionBuilder builder(
+      context(), construct,
+      IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping);
+  std::vector<uint32_t> vector_ids(packs.size(), 0);
+  for (size_t i = 0; i < packs.size(); ++i) {
+    const Pack& pack = packs[i];
+    switch (pack.kind) {
+      case Pack::kOperation: {
+        std::vector<uint32_t> operands;
+        for (size_t operand : pack.operands) {
+          operands.push_back(vector_ids[operand]);
+        }
+        vector_ids[i] =
+            builder.AddNaryOp(construct->type_id(), pack.opcode, operands)
+                ->result_id();
+        break;
+      }
+      case Pack::kExtract:
+        vector_ids[i] = pack.source;
+        break;
+      case Pack::kShuffle:
+        vector_ids[i] =
+            builder
+                .AddVectorShuffle(construct->type_id(), pack.source,
+                                  pack.source, pack.components)
+                ->result_id();
+        break;
+      case Pack::kConstant: {
+        analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+        const analysis::Constant* constant = const_mgr->GetConstant(
+            context()->get_type_mgr()->GetType(construct->type_id()),
+            pack.lanes);
+        if (constant) {
+          vector_ids[i] =
+              const_mgr->GetDefiningInstruction(constant, construct->type_id())
+                  ->result_id();
+          break;
+        }
+        vector_ids[i] =
+            builder.AddCompositeConstruct(construct->type_id(), pack.lanes)
+                ->result_id();
+        break;
+      }
+      case Pack::kGather:
+        vector_ids[i] =
+            builder.AddCompositeConstruct(construct->type_id(), pack.lanes)
+                ->result_id();
+        break;
+    }
+  }
+
+  context()->ReplaceAllUsesWith(construct->result_id(), vector_ids.back());
+  context()->KillInst(construct);
+
+  // The scalar operations were only used in the tree, so they are dead now.
+  // Kill the users before the values they use.
+  for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+    if (it->kind != Pack::kOperation) continue;
+    for (uint32_t lane : it->lanes) {
+      context()->KillInst(get_def_use_mgr()->GetDef(lane));
+    }
+  }
+  return true;
+}
+
+bool SLPVectorizePass::VectorizeFunction(Function* func) {
+  bool modified = false;
+  for (auto& bb : *func) {
+    for (auto ii = bb.begin(); ii != bb.end();) {
+      Instruction* inst = &*ii;
+      // |inst| is killed if it is replaced, and the new instructions are
+      // inserted before it.
+      ++ii;
+      if (inst->opcode() == SpvOpCompositeConstruct &&
+          VectorizeConstruct(inst)) {
+        modified = true;
+      }
+    }
+  }
+  return modified;
+}
+
+Pass::Status SLPVectorizePass::Process() {
+  bool modified = false;
+  for (auto& func : *get_module()) {
+    modified |= VectorizeFunction(&func);
+  }
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+}  // namespace opt
+}  // namespace spvtools
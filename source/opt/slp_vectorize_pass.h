@@ -0,0 +1,103 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_SLP_VECTORIZE_PASS_H_
+#define SOURCE_OPT_SLP_VECTORIZE_PASS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/module.h"
+#include "source/opt/pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class SLPVectorizePass : public Pass {
+ public:
+  const char* name() const override { return "slp-vectorize"; }
+  Status Process() override;
+
+  IRContext::Analysis GetPreservedAnalyses() override {
+    return IRContext::kAnalysisDefUse | IRContext::kAnalysisCFG |
+           IRContext::kAnalysisInstrToBlockMapping |
+           IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisDecorations |
+           IRContext::kAnalysisDominatorAnalysis | IRContext::kAnalysisNameMap |
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes;
+  }
+
+ private:
+  // A group of scalar values, one per lane of a vector, that is computed as a
+  // single vector value.
+  struct Pack {
+    enum Kind {
+      // The lanes are the same arithmetic operation, applied to the lanes of
+      // the packs in |operands|.
+      kOperation,
+      // The lanes are extracted, in order, from |source|.
+      kExtract,
+      // The lanes are extracted from |source| in the order of |components|.
+      kShuffle,
+      // The lanes are constants.
+      kConstant,
+      // The lanes are unrelated values that are put together with an
+      // OpCompositeConstruct.
+      kGather,
+    };
+
+    Kind kind;
+    std::vector<uint32_t> lanes;
+    SpvOp opcode;
+    std::vector<size_t> operands;
+    uint32_t source;
+    std::vector<uint32_t> components;
+  };
+
+  // Returns the number of instructions that computing |kind| as a vector
+  // value adds.
+  static uint32_t LeafCost(Pack::Kind kind);
+
+  // Adds to |packs| the packs that compute the scalar values |lanes| as a
+  // value of the vector type |vector_type_id|, operands first.  |block| is the
+  // block of the root of the tree, and |depth| the depth of |lanes| in it.
+  // Returns the index of the pack for |lanes|.
+  size_t BuildPack(const std::vector<uint32_t>& lanes, uint32_t vector_type_id,
+                   uint32_t component_type_id, const BasicBlock* block,
+                   uint32_t depth, std::vector<Pack>* packs);
+
+  // Returns true if the scalar instructions |lanes| can be replaced by a
+  // single vector operation: they all have the same supported opcode, their
+  // results and operands are of type |component_type_id|, they are in
+  // |block|, and each is used once.
+  bool IsIsomorphicOperation(const std::vector<Instruction*>& lanes,
+                             uint32_t component_type_id,
+                             const BasicBlock* block);
+
+  // Rewrites the tree of scalar operations feeding |construct|, an
+  // OpCompositeConstruct of a vector from its scalar components, into vector
+  // operations if the cost model says it is profitable.  Returns true if
+  // |construct| was replaced.
+  bool VectorizeConstruct(Instruction* construct);
+
+  // Vectorizes the trees feeding the vector constructions of |func|.  Returns
+  // true if |func| was modified.
+  bool VectorizeFunction(Function* func);
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_SLP_VECTORIZE_PASS_H_
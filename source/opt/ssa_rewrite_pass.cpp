@@ -168,9 +168,7 @@ uint32_t SSARewriter::AddPhiOperands(PhiCandidate* phi_candidate) {
          "Phi candidate already has arguments");
 
   bool found_0_arg = false;
-  for (uint32_t pred : pass_->cfg()->preds(phi_candidate->bb()->id())) {
-    BasicBlock* pred_bb = pass_->cfg()->block(pred);
-
+  for (uint32_t pred : block_preds_[BlockIndex(phi_candidate->bb())]) {
     // If |pred_bb| is not sealed, use %0 to indicate that
     // |phi_candidate| needs to be completed after the whole CFG has
     // been processed.
@@ -204,8 +202,8 @@ uint32_t SSARewriter::AddPhiOperands(PhiCandidate* phi_candidate) {
     // By making the argument %0, we make |phi_candidate| incomplete,
     // which will cause it to be completed after the whole CFG has
     // been scanned.
-    uint32_t arg_id = IsBlockSealed(pred_bb)
-                          ? GetReachingDef(phi_candidate->var_id(), pred_bb)
+    uint32_t arg_id = sealed_blocks_[pred]
+                          ? GetReachingDefAt(phi_candidate->var_id(), pred)
                           : 0;
     phi_candidate->phi_args().push_back(arg_id);
 
@@ -241,32 +239,46 @@ uint32_t SSARewriter::AddPhiOperands(PhiCandidate* phi_candidate) {
   return repl_id;
 }
 
-uint32_t SSARewriter::GetReachingDef(uint32_t var_id, BasicBlock* bb) {
-  // If |var_id| has a definition in |bb|, return it.
-  const auto& bb_it = defs_at_block_.find(bb);
-  if (bb_it != defs_at_block_.end()) {
-    const auto& current_defs = bb_it->second;
-    const auto& var_it = current_defs.find(var_id);
-    if (var_it != current_defs.end()) {
-      return var_it->second;
+void SSARewriter::NumberBlocks(Function* fp) {
+  for (auto& bb : *fp) {
+    block_index_[bb.id()] = static_cast<uint32_t>(blocks_.size());
+    blocks_.push_back(&bb);
+  }
+
+  block_preds_.resize(blocks_.size());
+  for (uint32_t block = 0; block < blocks_.size(); ++block) {
+    for (uint32_t pred : pass_->cfg()->preds(blocks_[block]->id())) {
+      block_preds_[block].push_back(BlockIndex(pass_->cfg()->block(pred)));
     }
   }
 
-  // Otherwise, look up the value for |var_id| in |bb|'s predecessors.
+  defs_at_block_.resize(blocks_.size());
+  sealed_blocks_.assign(blocks_.size(), false);
+}
+
+uint32_t SSARewriter::GetReachingDefAt(uint32_t var_id, uint32_t block) {
+  // If |var_id| has a definition in |block|, return it.
+  const auto& current_defs = defs_at_block_[block];
+  const auto& var_it = current_defs.find(var_id);
+  if (var_it != current_defs.end()) {
+    return var_it->second;
+  }
+
+  // Otherwise, look up the value for |var_id| in |block|'s predecessors.
   uint32_t val_id = 0;
-  auto& predecessors = pass_->cfg()->preds(bb->id());
+  const auto& predecessors = block_preds_[block];
   if (predecessors.size() == 1) {
-    // If |bb| has exactly one predecessor, we look for |var_id|'s definition
-    // there.
-    val_id = GetReachingDef(var_id, pass_->cfg()->block(predecessors[0]));
+    // If |block| has exactly one predecessor, we look for |var_id|'s
+    // definition there.
+    val_id = GetReachingDefAt(var_id, predecessors[0]);
   } else if (predecessors.size() > 1) {
     // If there is more than one predecessor, this is a join block which may
     // require a Phi instruction.  This will act as |var_id|'s current
     // definition to break potential cycles.
-    PhiCandidate& phi_candidate = CreatePhiCandidate(var_id, bb);
+    PhiCandidate& phi_candidate = CreatePhiCandidate(var_id, blocks_[block]);
 
-    // Set the value for |bb| to avoid an infinite recursion.
-    WriteVariable(var_id, bb, phi_candidate.result_id());
+    // Set the value for |block| to avoid an infinite recursion.
+    WriteVariableAt(var_id, block, phi_candidate.result_id());
     val_id = AddPhiOperands(&phi_candidate);
   }
 
@@ -279,16 +291,16 @@ uint32_t SSARewriter::GetReachingDef(uint32_t var_id, BasicBlock* bb) {
     }
   }
 
-  WriteVariable(var_id, bb, val_id);
+  WriteVariableAt(var_id, block, val_id);
 
   return val_id;
 }
 
 void SSARewriter::SealBlock(BasicBlock* bb) {
-  auto result = sealed_blocks_.insert(bb);
-  (void)result;
-  assert(result.second == true &&
+  uint32_t block = BlockIndex(bb);
+  assert(!sealed_blocks_[block] &&
          "Tried to seal the same basic block more than once.");
+  sealed_blocks_[block] = true;
 }
 
 void SSARewriter::ProcessStore(Instruction* inst, BasicBlock* bb) {
@@ -542,14 +554,13 @@ void SSARewriter::FinalizePhiCandidate(PhiCandidate* phi_candidate) {
          "Phi candidate should have arguments");
 
   uint32_t ix = 0;
-  for (uint32_t pred : pass_->cfg()->preds(phi_candidate->bb()->id())) {
-    BasicBlock* pred_bb = pass_->cfg()->block(pred);
+  for (uint32_t pred : block_preds_[BlockIndex(phi_candidate->bb())]) {
     uint32_t& arg_id = phi_candidate->phi_args()[ix++];
     if (arg_id == 0) {
-      // If |pred_bb| is still not sealed, it means it's unreachable. In this
+      // If |pred| is still not sealed, it means it's unreachable. In this
       // case, we just use Undef as an argument.
-      arg_id = IsBlockSealed(pred_bb)
-                   ? GetReachingDef(phi_candidate->var_id(), pred_bb)
+      arg_id = sealed_blocks_[pred]
+                   ? GetReachingDefAt(phi_candidate->var_id(), pred)
                    : pass_->GetUndefVal(phi_candidate->var_id());
     }
   }
@@ -590,6 +601,10 @@ Pass::Status SSARewriter::RewriteFunctionIntoSSA(Function* fp) {
   // Collect variables that can be converted into SSA IDs.
   pass_->CollectTargetVars(fp);
 
+  // Number the blocks, so that the walks up the CFG do not need to look up
+  // the blocks and their predecessors.
+  NumberBlocks(fp);
+
   // Generate all the SSA replacements and Phi candidates. This will
   // generate incomplete and trivial Phis.
   bool succeeded = pass_->cfg()->WhileEachBlockInReversePostOrder(
@@ -622,6 +637,7 @@ Pass::Status SSARewriter::RewriteFunctionIntoSSA(Function* fp) {
 Pass::Status SSARewritePass::Process() {
   Status status = Status::SuccessWithoutChange;
   for (auto& fn : *get_module()) {
+    if (context()->IsFunctionFilteredOut(&fn)) continue;
     status =
         CombineStatus(status, SSARewriter(this).RewriteFunctionIntoSSA(&fn));
     // Kill DebugDeclares for target variables.
@@ -15,10 +15,10 @@
 #ifndef SOURCE_OPT_SSA_REWRITE_PASS_H_
 #define SOURCE_OPT_SSA_REWRITE_PASS_H_
 
+#include <cassert>
 #include <queue>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -120,10 +120,22 @@ class SSARewriter {
     std::vector<uint32_t> users_;
   };
 
-  // Type used to keep track of store operations in each basic block.
-  typedef std::unordered_map<BasicBlock*,
-                             std::unordered_map<uint32_t, uint32_t>>
-      BlockDefsMap;
+  // Type used to keep track of store operations in each basic block.  It is
+  // indexed by the dense number that |NumberBlocks| gives to each block.
+  typedef std::vector<std::unordered_map<uint32_t, uint32_t>> BlockDefsMap;
+
+  // Numbers the basic blocks of |fp| densely, in function order, and records
+  // the numbers of the predecessors of each block.  This sizes the per-block
+  // tables (|defs_at_block_| and |sealed_blocks_|), so it must be called before
+  // scanning the function.
+  void NumberBlocks(Function* fp);
+
+  // Returns the dense number of basic block |bb|.
+  uint32_t BlockIndex(const BasicBlock* bb) const {
+    auto it = block_index_.find(bb->id());
+    assert(it != block_index_.end() && "Block is not in the function.");
+    return it->second;
+  }
 
   // Generates all the SSA rewriting decisions for basic block |bb|.  This
   // populates the Phi candidate table (|phi_candidate_|) and the load
@@ -135,7 +147,7 @@ class SSARewriter {
   void SealBlock(BasicBlock* bb);
 
   // Returns true if |bb| has been sealed.
-  bool IsBlockSealed(BasicBlock* bb) { return sealed_blocks_.count(bb) != 0; }
+  bool IsBlockSealed(BasicBlock* bb) { return sealed_blocks_[BlockIndex(bb)]; }
 
   // Returns the Phi candidate with result ID |id| if it exists in the table
   // |phi_candidates_|. If no such Phi candidate exists, it returns nullptr.
@@ -186,9 +198,14 @@ class SSARewriter {
   // Registers a definition for variable |var_id| in basic block |bb| with
   // value |val_id|.
   void WriteVariable(uint32_t var_id, BasicBlock* bb, uint32_t val_id) {
-    defs_at_block_[bb][var_id] = val_id;
+    WriteVariableAt(var_id, BlockIndex(bb), val_id);
+  }
+
+  // Same as |WriteVariable|, for the basic block numbered |block|.
+  void WriteVariableAt(uint32_t var_id, uint32_t block, uint32_t val_id) {
+    defs_at_block_[block][var_id] = val_id;
     if (auto* pc = GetPhiCandidate(val_id)) {
-      pc->AddUser(bb->id());
+      pc->AddUser(blocks_[block]->id());
     }
   }
 
@@ -210,7 +227,13 @@ class SSARewriter {
   //
   // It returns the value for |var_id| from the RHS of the current reaching
   // definition for |var_id|.
-  uint32_t GetReachingDef(uint32_t var_id, BasicBlock* bb);
+  uint32_t GetReachingDef(uint32_t var_id, BasicBlock* bb) {
+    return GetReachingDefAt(var_id, BlockIndex(bb));
+  }
+
+  // Same as |GetReachingDef|, for the basic block numbered |block|.  The walk
+  // up the predecessors only uses the dense block numbers.
+  uint32_t GetReachingDefAt(uint32_t var_id, uint32_t block);
 
   // Adds arguments to |phi_candidate| by getting the reaching definition of
   // |phi_candidate|'s variable on each of the predecessors of its basic
@@ -281,8 +304,18 @@ class SSARewriter {
   // is done to replace all uses of the original load ID with the value ID.
   std::unordered_map<uint32_t, uint32_t> load_replacement_;
 
-  // Set of blocks that have been sealed already.
-  std::unordered_set<BasicBlock*> sealed_blocks_;
+  // Blocks that have been sealed already, indexed by block number.
+  std::vector<bool> sealed_blocks_;
+
+  // The basic blocks of the function, indexed by block number.
+  std::vector<BasicBlock*> blocks_;
+
+  // Maps the label of each basic block of the function to its block number.
+  std::unordered_map<uint32_t, uint32_t> block_index_;
+
+  // The block numbers of the predecessors of each basic block, in the same
+  // order as |CFG::preds|.
+  std::vector<std::vector<uint32_t>> block_preds_;
 
   // Memory pass requesting the SSA rewriter.
   MemPass* pass_;
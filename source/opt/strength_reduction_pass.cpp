@@ -17,16 +17,21 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <memory>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "source/opt/def_use_manager.h"
+#include "source/opt/ir_builder.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/log.h"
+#include "source/opt/loop_descriptor.h"
 #include "source/opt/reflect.h"
+#include "source/opt/register_pressure.h"
 
 namespace {
 // Count the number of trailing zeros in the binary representation of
@@ -125,6 +130,175 @@ bool StrengthReductionPass::ReplaceMultiplyByPowerOf2(
   return modified;
 }
 
+bool StrengthReductionPass::ReduceMultipliesInLoops(Function* func) {
+  if (func->begin() == func->end()) return false;
+  LoopDescriptor& ld = *context()->GetLoopDescriptor(func);
+  if (ld.NumLoops() == 0) return false;
+
+  // Collect the candidates first, because reducing a multiply adds
+  // instructions to the blocks being scanned.
+  std::vector<Instruction*> multiplies;
+  for (auto& bb : *func) {
+    if (ld[bb.id()] == nullptr) continue;
+    for (auto& inst : bb) {
+      if (inst.opcode() == SpvOp::SpvOpIMul) multiplies.push_back(&inst);
+    }
+  }
+
+  reduced_ivs_.clear();
+  loop_pressure_.clear();
+  bool modified = false;
+  for (Instruction* mul : multiplies) {
+    if (ReduceMultiplyInLoop(ld, mul)) modified = true;
+  }
+  return modified;
+}
+
+bool StrengthReductionPass::ReduceMultiplyInLoop(const LoopDescriptor& ld,
+                                                 Instruction* mul) {
+  assert(mul->opcode() == SpvOp::SpvOpIMul &&
+         "Only works for multiplication of integers.");
+
+  // Currently only works on 32-bit integers.
+  if (mul->type_id() != int32_type_id_ && mul->type_id() != uint32_type_id_) {
+    return false;
+  }
+
+  analysis::DefUseManager* def_use_mgr = get_def_use_mgr();
+  for (uint32_t i = 0; i < 2; ++i) {
+    Instruction* iv = def_use_mgr->GetDef(mul->GetSingleWordInOperand(i));
+    Instruction* factor =
+        def_use_mgr->GetDef(mul->GetSingleWordInOperand(1 - i));
+    if (iv->opcode() != SpvOp::SpvOpPhi ||
+        factor->opcode() != SpvOp::SpvOpConstant) {
+      continue;
+    }
+
+    BasicBlock* header = context()->get_instr_block(iv);
+    Loop* loop = ld[header->id()];
+    if (loop == nullptr || loop->GetHeaderBlock() != header ||
+        !loop->IsInsideLoop(context()->get_instr_block(mul))) {
+      continue;
+    }
+
+    uint32_t init_id = 0;
+    Instruction* next = nullptr;
+    uint32_t step = 0;
+    if (!GetInductionStep(*loop, *iv, &init_id, &next, &step)) continue;
+
+    // A multiply by the same factor as one already reduced reuses its
+    // induction variable.
+    const auto key = std::make_tuple(
+        iv->result_id(), factor->GetSingleWordInOperand(0), mul->type_id());
+    auto reduced = reduced_ivs_.find(key);
+    if (reduced != reduced_ivs_.end()) {
+      context()->ReplaceAllUsesWith(mul->result_id(), reduced->second);
+      context()->KillInst(mul);
+      return true;
+    }
+
+    // Each new induction variable is live through the whole loop, so stop
+    // adding them once the loop would need too many registers.
+    size_t* pressure = GetLoopRegisterPressure(*loop);
+    if (*pressure >= kMaxLoopRegisterPressure) continue;
+
+    // |iv| * |factor| starts at |init_id| * |factor| and grows by
+    // |step| * |factor| on each iteration.  The arithmetic wraps the same way
+    // as the multiply would.
+    const IRContext::Analysis kFlags =
+        IRContext::kAnalysisDefUse | IRContext::kAnalysisInstrToBlockMapping;
+    // The pre-header of an inner loop can be the header of the outer loop,
+    // so the multiply goes before its merge instruction.
+    BasicBlock* pre_header = loop->GetPreHeaderBlock();
+    Instruction* insertion_point = pre_header->terminator();
+    Instruction* previous_node = insertion_point->PreviousNode();
+    if (previous_node && (previous_node->opcode() == SpvOpLoopMerge ||
+                          previous_node->opcode() == SpvOpSelectionMerge)) {
+      insertion_point = previous_node;
+    }
+    InstructionBuilder pre_header_builder(context(), insertion_point, kFlags);
+    Instruction* init = pre_header_builder.AddBinaryOp(
+        mul->type_id(), SpvOp::SpvOpIMul, init_id, factor->result_id());
+
+    // The value coming from the back edge is set once it has been created.
+    InstructionBuilder header_builder(context(), &*header->GetFirstNonPhi(),
+                                      kFlags);
+    Instruction* phi = header_builder.AddPhi(
+        mul->type_id(), {init->result_id(), pre_header->id(),
+                         init->result_id(), loop->GetLatchBlock()->id()});
+
+    analysis::ConstantManager* const_mgr = context()->get_constant_mgr();
+    const analysis::Constant* stride = const_mgr->GetConstant(
+        context()->get_type_mgr()->GetType(mul->type_id()),
+        {step * factor->GetSingleWordInOperand(0)});
+    InstructionBuilder next_builder(context(), next->NextNode(), kFlags);
+    Instruction* phi_next = next_builder.AddIAdd(
+        mul->type_id(), phi->result_id(),
+        const_mgr->GetDefiningInstruction(stride)->result_id());
+    phi->SetInOperand(2, {phi_next->result_id()});
+    def_use_mgr->AnalyzeInstUse(phi);
+    reduced_ivs_[key] = phi->result_id();
+    ++*pressure;
+
+    context()->ReplaceAllUsesWith(mul->result_id(), phi->result_id());
+    context()->KillInst(mul);
+    return true;
+  }
+  return false;
+}
+
+size_t* StrengthReductionPass::GetLoopRegisterPressure(const Loop& loop) {
+  auto it = loop_pressure_.find(&loop);
+  if (it == loop_pressure_.end()) {
+    RegisterLiveness::RegionRegisterLiveness liveness;
+    RegisterLiveness::EstimateLoopRegisterPressure(context(), loop, &liveness);
+    it = loop_pressure_.emplace(&loop, liveness.used_registers_).first;
+  }
+  return &it->second;
+}
+
+bool StrengthReductionPass::GetInductionStep(const Loop& loop,
+                                             const Instruction& iv,
+                                             uint32_t* init_id,
+                                             Instruction** next,
+                                             uint32_t* step) {
+  if (iv.type_id() != int32_type_id_ && iv.type_id() != uint32_type_id_) {
+    return false;
+  }
+
+  const BasicBlock* pre_header = loop.GetPreHeaderBlock();
+  const BasicBlock* latch = loop.GetLatchBlock();
+  if (pre_header == nullptr || latch == nullptr || iv.NumInOperands() != 4) {
+    return false;
+  }
+
+  uint32_t next_id = 0;
+  *init_id = 0;
+  for (uint32_t i = 0; i < 4; i += 2) {
+    uint32_t value_id = iv.GetSingleWordInOperand(i);
+    uint32_t pred_id = iv.GetSingleWordInOperand(i + 1);
+    if (pred_id == pre_header->id()) {
+      *init_id = value_id;
+    } else if (pred_id == latch->id()) {
+      next_id = value_id;
+    }
+  }
+  if (*init_id == 0 || next_id == 0) return false;
+
+  // The value from the back edge must be |iv| plus a constant.
+  *next = get_def_use_mgr()->GetDef(next_id);
+  if ((*next)->opcode() != SpvOp::SpvOpIAdd) return false;
+  for (uint32_t i = 0; i < 2; ++i) {
+    if ((*next)->GetSingleWordInOperand(i) != iv.result_id()) continue;
+    Instruction* step_inst =
+        get_def_use_mgr()->GetDef((*next)->GetSingleWordInOperand(1 - i));
+    if (step_inst->opcode() != SpvOp::SpvOpConstant) return false;
+    *step = step_inst->GetSingleWordInOperand(0);
+    return true;
+  }
+  return false;
+}
+
 void StrengthReductionPass::FindIntTypesAndConstants() {
   analysis::Integer int32(32, true);
   int32_type_id_ = context()->get_type_mgr()->GetId(&int32);
@@ -181,6 +355,7 @@ bool StrengthReductionPass::ScanFunctions() {
   // insert a new instruction.  I want an iterator.
   bool modified = false;
   for (auto& func : *get_module()) {
+    if (ReduceMultipliesInLoops(&func)) modified = true;
     for (auto& bb : func) {
       for (auto inst = bb.begin(); inst != bb.end(); ++inst) {
         switch (inst->opcode()) {
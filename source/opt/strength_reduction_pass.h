@@ -15,8 +15,13 @@
 #ifndef SOURCE_OPT_STRENGTH_REDUCTION_PASS_H_
 #define SOURCE_OPT_STRENGTH_REDUCTION_PASS_H_
 
+#include <map>
+#include <tuple>
+#include <unordered_map>
+
 #include "source/opt/def_use_manager.h"
 #include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
 #include "source/opt/module.h"
 #include "source/opt/pass.h"
 
@@ -34,6 +39,31 @@ class StrengthReductionPass : public Pass {
   // Returns true if something changed.
   bool ReplaceMultiplyByPowerOf2(BasicBlock::iterator*);
 
+  // Replaces the multiplications of a loop induction variable by a constant
+  // in the loops of |func| with a new induction variable, so that the loop
+  // adds to it on each iteration instead.  Returns true if something changed.
+  bool ReduceMultipliesInLoops(Function* func);
+
+  // Replaces the multiplication |mul| with a new induction variable if it
+  // multiplies the induction variable of a loop in |ld| that contains |mul|
+  // by a constant.  Multiplies of the same induction variable by the same
+  // constant share one new induction variable, and no new one is added to a
+  // loop whose register pressure reached |kMaxLoopRegisterPressure|.  Returns
+  // true if |mul| was replaced.
+  bool ReduceMultiplyInLoop(const LoopDescriptor& ld, Instruction* mul);
+
+  // Returns the estimated register pressure of |loop|, including the
+  // induction variables added to it so far.  The estimate is computed the
+  // first time it is requested for |loop|.
+  size_t* GetLoopRegisterPressure(const Loop& loop);
+
+  // Returns true if the phi |iv| in the header of |loop| is a 32-bit induction
+  // variable incremented by a constant on the back edge.  Sets |init_id| to
+  // the id of its initial value, |next| to the instruction incrementing it and
+  // |step| to the value of the increment.
+  bool GetInductionStep(const Loop& loop, const Instruction& iv,
+                        uint32_t* init_id, Instruction** next, uint32_t* step);
+
   // Scan the types and constants in the module looking for the the integer
   // types that we are
   // interested in.  The shift operation needs a small unsigned integer.  We
@@ -57,6 +87,16 @@ class StrengthReductionPass : public Pass {
   // We set the limit at 32 because a bit shift of a 32-bit integer does not
   // need a value larger than 32.
   uint32_t constant_ids_[33];
+
+  // Maps an induction variable, a constant factor and a type to the id of the
+  // induction variable that replaced their multiply in the current function.
+  std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> reduced_ivs_;
+
+  // Estimated register pressure of the loops of the current function.
+  std::unordered_map<const Loop*, size_t> loop_pressure_;
+
+  // The register pressure above which a loop gets no new induction variable.
+  static constexpr size_t kMaxLoopRegisterPressure = 64;
 };
 
 }  // namespace opt
@@ -27,6 +27,8 @@ class StripDebugInfoPass : public Pass {
  public:
   const char* name() const override { return "strip-debug"; }
   Status Process() override;
+
+  bool RemovesDebugLineInsts() const override { return true; }
 };
 
 }  // namespace opt
@@ -14,6 +14,8 @@
 
 #include "source/opt/struct_cfg_analysis.h"
 
+#include <algorithm>
+
 #include "source/opt/ir_context.h"
 
 namespace {
@@ -24,13 +26,17 @@ const uint32_t kContinueNodeIndex = 1;
 namespace spvtools {
 namespace opt {
 
-StructuredCFGAnalysis::StructuredCFGAnalysis(IRContext* ctx) : context_(ctx) {
+StructuredCFGAnalysis::StructuredCFGAnalysis(IRContext* ctx)
+    : context_(ctx),
+      is_shader_(
+          ctx->get_feature_mgr()->HasCapability(SpvCapabilityShader)) {
   // If this is not a shader, there are no merge instructions, and not
   // structured CFG to analyze.
-  if (!context_->get_feature_mgr()->HasCapability(SpvCapabilityShader)) {
+  if (!is_shader_) {
     return;
   }
 
+  bb_to_construct_.reserve(context_->module()->IdBound());
   for (auto& func : *context_->module()) {
     AddBlocksInFunction(&func);
   }
@@ -74,7 +80,7 @@ void StructuredCFGAnalysis::AddBlocksInFunction(Function* func) {
       state.back().cinfo.in_continue = true;
     }
 
-    bb_to_construct_.emplace(std::make_pair(block->id(), state.back().cinfo));
+    bb_to_construct_.insert({block->id(), state.back().cinfo});
 
     if (Instruction* merge_inst = block->GetMergeInst()) {
       TraversalInfo new_state;
@@ -112,6 +118,144 @@ void StructuredCFGAnalysis::AddBlocksInFunction(Function* func) {
   }
 }
 
+void StructuredCFGAnalysis::AnalyzeFunction(Function* func) {
+  for (auto& block : *func) {
+    bb_to_construct_.erase(block.id());
+    merge_blocks_.Clear(block.id());
+  }
+  AddBlocksInFunction(func);
+}
+
+void StructuredCFGAnalysis::AnalyzeModifiedFunctions() {
+  std::vector<uint32_t> function_ids;
+  function_ids.swap(modified_functions_);
+  for (uint32_t function_id : function_ids) {
+    if (Function* func = context_->GetFunction(function_id)) {
+      AnalyzeFunction(func);
+    }
+  }
+}
+
+void StructuredCFGAnalysis::ReplaceHeader(Function* func, uint32_t old_header,
+                                          uint32_t new_header) {
+  for (auto& block : *func) {
+    auto it = bb_to_construct_.find(block.id());
+    if (it == bb_to_construct_.end()) {
+      continue;
+    }
+    ConstructInfo& info = it->second;
+    if (info.containing_construct == old_header) {
+      info.containing_construct = new_header;
+    }
+    if (info.containing_loop == old_header) {
+      info.containing_loop = new_header;
+    }
+    if (info.containing_switch == old_header) {
+      info.containing_switch = new_header;
+    }
+  }
+}
+
+void StructuredCFGAnalysis::OnBlockSplit(BasicBlock* block,
+                                         BasicBlock* new_block) {
+  // The update must not analyze the modified functions: the CFG may not be
+  // up to date in the middle of an edit.
+  if (!is_shader_ || IsFunctionModified(block->GetParent())) {
+    return;
+  }
+
+  auto it = bb_to_construct_.find(block->id());
+  if (it == bb_to_construct_.end()) {
+    // |block| is not in the structured order, and neither is |new_block|.
+    return;
+  }
+  // The end of |block| is in the same constructs as its beginning.
+  const ConstructInfo info = it->second;
+
+  if (Instruction* merge_inst = new_block->GetMergeInst()) {
+    if (merge_inst->opcode() == SpvOpLoopMerge &&
+        merge_inst->GetSingleWordInOperand(kContinueNodeIndex) ==
+            block->id()) {
+      // The loop header is no longer its own continue target.
+      MarkFunctionModified(block->GetParent());
+      return;
+    }
+    // |new_block| is now the header of the construct headed by |block|.
+    ReplaceHeader(block->GetParent(), block->id(), new_block->id());
+  }
+  bb_to_construct_[new_block->id()] = info;
+}
+
+void StructuredCFGAnalysis::OnMergeWithSuccessor(BasicBlock* block,
+                                                 uint32_t succ_id) {
+  if (!is_shader_ || IsFunctionModified(block->GetParent())) {
+    return;
+  }
+
+  const uint32_t block_id = block->id();
+  auto succ_it = bb_to_construct_.find(succ_id);
+  if (bb_to_construct_.count(block_id) == 0 ||
+      succ_it == bb_to_construct_.end()) {
+    MarkFunctionModified(block->GetParent());
+    return;
+  }
+  const ConstructInfo succ_info = succ_it->second;
+
+  bool succ_is_continue = false;
+  if (succ_info.containing_loop != 0) {
+    Instruction* loop_merge =
+        context_->get_instr_block(succ_info.containing_loop)->GetMergeInst();
+    succ_is_continue =
+        loop_merge->GetSingleWordInOperand(kContinueNodeIndex) == succ_id;
+  }
+  Instruction* merge_inst = block->GetMergeInst();
+  if (succ_is_continue ||
+      (merge_inst != nullptr && merge_inst->opcode() == SpvOpLoopMerge &&
+       merge_inst->GetSingleWordInOperand(kMergeNodeIndex) == succ_id)) {
+    // Making |block| a continue target changes the continue construct, and
+    // removing a loop leaves its continue construct behind.
+    MarkFunctionModified(block->GetParent());
+    return;
+  }
+  if (merge_inst != nullptr &&
+      merge_inst->GetSingleWordInOperand(kMergeNodeIndex) == succ_id) {
+    // The selection construct headed by |block| is removed with its merge
+    // instruction, and contains no other block.
+    merge_blocks_.Clear(succ_id);
+  } else if (merge_blocks_.Get(succ_id)) {
+    // |block| becomes the merge block in place of |succ_id|.
+    bb_to_construct_.at(block_id) = succ_info;
+    merge_blocks_.Clear(succ_id);
+    merge_blocks_.Set(block_id);
+  }
+
+  if (context_->get_instr_block(succ_id)->GetMergeInst() != nullptr) {
+    // |block| becomes the header of the construct headed by |succ_id|.
+    bb_to_construct_.at(block_id) = succ_info;
+    ReplaceHeader(block->GetParent(), succ_id, block_id);
+  }
+  bb_to_construct_.erase(succ_id);
+}
+
+void StructuredCFGAnalysis::RemoveBlock(uint32_t bb_id) {
+  bb_to_construct_.erase(bb_id);
+}
+
+void StructuredCFGAnalysis::MarkFunctionModified(Function* func) {
+  if (!is_shader_) {
+    return;
+  }
+
+  if (!IsFunctionModified(func)) {
+    modified_functions_.push_back(func->result_id());
+  }
+}
+
+bool StructuredCFGAnalysis::IsFunctionModified(const Function* func) const {
+  return std::find(modified_functions_.begin(), modified_functions_.end(),
+                   func->result_id()) != modified_functions_.end();
+}
+
 uint32_t StructuredCFGAnalysis::ContainingConstruct(Instruction* inst) {
   uint32_t bb = context_->get_instr_block(inst)->id();
   return ContainingConstruct(bb);
@@ -194,11 +338,8 @@ bool StructuredCFGAnalysis::IsContinueBlock(uint32_t bb_id) {
 
 bool StructuredCFGAnalysis::IsInContainingLoopsContinueConstruct(
     uint32_t bb_id) {
-  auto it = bb_to_construct_.find(bb_id);
-  if (it == bb_to_construct_.end()) {
-    return false;
-  }
-  return it->second.in_continue;
+  const ConstructInfo* info = GetConstructInfo(bb_id);
+  return info ? info->in_continue : false;
 }
 
 bool StructuredCFGAnalysis::IsInContinueConstruct(uint32_t bb_id) {
@@ -212,6 +353,7 @@ bool StructuredCFGAnalysis::IsInContinueConstruct(uint32_t bb_id) {
 }
 
 bool StructuredCFGAnalysis::IsMergeBlock(uint32_t bb_id) {
+  if (!modified_functions_.empty()) AnalyzeModifiedFunctions();
   return merge_blocks_.Get(bb_id);
 }
 
@@ -15,11 +15,12 @@
 #ifndef SOURCE_OPT_STRUCT_CFG_ANALYSIS_H_
 #define SOURCE_OPT_STRUCT_CFG_ANALYSIS_H_
 
-#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "source/opt/function.h"
 #include "source/util/bit_vector.h"
+#include "source/util/id_map.h"
 
 namespace spvtools {
 namespace opt {
@@ -28,6 +29,13 @@ class IRContext;
 
 // An analysis that, for each basic block, finds the constructs in which it is
 // contained, so we can easily get headers and merge nodes.
+//
+// The constructs are found one function at a time.  The analysis can be kept
+// valid across the common edits of the CFG: splitting a block, merging a block
+// with its successor and removing blocks that are not part of any construct.
+// Any other change to the structured control flow of a function must be
+// reported with |MarkFunctionModified|, and the function is analyzed again the
+// next time the analysis is queried.
 class StructuredCFGAnalysis {
  public:
   explicit StructuredCFGAnalysis(IRContext* ctx);
@@ -36,11 +44,8 @@ class StructuredCFGAnalysis {
   // that contains |bb_id|.  Returns |0| if |bb_id| is not contained in any
   // merge construct.
   uint32_t ContainingConstruct(uint32_t bb_id) {
-    auto it = bb_to_construct_.find(bb_id);
-    if (it == bb_to_construct_.end()) {
-      return 0;
-    }
-    return it->second.containing_construct;
+    const ConstructInfo* info = GetConstructInfo(bb_id);
+    return info ? info->containing_construct : 0;
   }
 
   // Returns the id of the header of the innermost merge construct
@@ -62,11 +67,8 @@ class StructuredCFGAnalysis {
   // that contains |bb_id|.  Return |0| if |bb_id| is not contained in any loop
   // construct.
   uint32_t ContainingLoop(uint32_t bb_id) {
-    auto it = bb_to_construct_.find(bb_id);
-    if (it == bb_to_construct_.end()) {
-      return 0;
-    }
-    return it->second.containing_loop;
+    const ConstructInfo* info = GetConstructInfo(bb_id);
+    return info ? info->containing_loop : 0;
   }
 
   // Returns the id of the merge block of the innermost loop construct
@@ -90,11 +92,8 @@ class StructuredCFGAnalysis {
   // that contains |bb_id| as long as there is no intervening loop.  Returns |0|
   // if no such construct exists.
   uint32_t ContainingSwitch(uint32_t bb_id) {
-    auto it = bb_to_construct_.find(bb_id);
-    if (it == bb_to_construct_.end()) {
-      return 0;
-    }
-    return it->second.containing_switch;
+    const ConstructInfo* info = GetConstructInfo(bb_id);
+    return info ? info->containing_switch : 0;
   }
   // Returns the id of the merge block of the innermost switch construct
   // that contains |bb_id| as long as there is no intervening loop.  Return |0|
@@ -119,6 +118,25 @@ class StructuredCFGAnalysis {
   // a continue construct.
   std::unordered_set<uint32_t> FindFuncsCalledFromContinue();
 
+  // Updates the analysis for the split of |block| by
+  // |BasicBlock::SplitBasicBlock|, which moved the end of |block| to
+  // |new_block|.  Must be called after the split.
+  void OnBlockSplit(BasicBlock* block, BasicBlock* new_block);
+
+  // Updates the analysis for the merge of the block |succ_id| into |block|,
+  // its only predecessor, by |blockmergeutil::MergeWithSuccessor|.  Must be
+  // called before the blocks are merged.
+  void OnMergeWithSuccessor(BasicBlock* block, uint32_t succ_id);
+
+  // Removes the block |bb_id| from the analysis.  The block must not be the
+  // header, merge block or continue target of a construct that remains.
+  void RemoveBlock(uint32_t bb_id);
+
+  // Records that the structured control flow of |func| changed in a way that
+  // is not tracked by the analysis.  Its blocks are analyzed again on the next
+  // query.
+  void MarkFunctionModified(Function* func);
+
  private:
   // Struct used to hold the information for a basic block.
   // |containing_construct| is the header for the innermost containing
@@ -137,22 +155,50 @@ class StructuredCFGAnalysis {
   // |in_continue| is true of the block is in the continue construct for its
   // innermost containing loop.
   struct ConstructInfo {
-    uint32_t containing_construct;
-    uint32_t containing_loop;
-    uint32_t containing_switch;
-    bool in_continue;
+    uint32_t containing_construct = 0;
+    uint32_t containing_loop = 0;
+    uint32_t containing_switch = 0;
+    bool in_continue = false;
   };
 
+  // Returns the constructs containing |bb_id|, or nullptr if |bb_id| is
+  // unknown to the analysis.  Analyzes the modified functions first.
+  const ConstructInfo* GetConstructInfo(uint32_t bb_id) {
+    if (!modified_functions_.empty()) AnalyzeModifiedFunctions();
+    auto it = bb_to_construct_.find(bb_id);
+    if (it == bb_to_construct_.end()) {
+      return nullptr;
+    }
+    return &it->second;
+  }
+
   // Populates |bb_to_construct_| with the innermost containing merge and loop
   // constructs for each basic block in |func|.
   void AddBlocksInFunction(Function* func);
 
+  // Removes the blocks of |func| from the analysis, and adds them again.
+  void AnalyzeFunction(Function* func);
+
+  // Analyzes again the functions in |modified_functions_| that still exist.
+  void AnalyzeModifiedFunctions();
+
+  // Returns true if |func| is in |modified_functions_|.
+  bool IsFunctionModified(const Function* func) const;
+
+  // Replaces |old_header| by |new_header| in the constructs containing the
+  // blocks of |func|.
+  void ReplaceHeader(Function* func, uint32_t old_header, uint32_t new_header);
+
   IRContext* context_;
 
   // A map from a basic block to the headers of its inner most containing
   // constructs.
-  std::unordered_map<uint32_t, ConstructInfo> bb_to_construct_;
+  utils::IdMap<ConstructInfo> bb_to_construct_;
   utils::BitVector merge_blocks_;
+  // False if there is no structured CFG to analyze.
+  bool is_shader_;
+  // The ids of the functions to analyze again before the next query.
+  std::vector<uint32_t> modified_functions_;
 };
 
 }  // namespace opt
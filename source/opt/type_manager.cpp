@@ -23,6 +23,7 @@
 #include "source/opt/log.h"
 #include "source/opt/reflect.h"
 #include "source/util/make_unique.h"
+#include "source/util/memory_usage.h"
 
 namespace spvtools {
 namespace opt {
@@ -66,6 +67,8 @@ uint32_t TypeManager::GetId(const Type* type) const {
 }
 
 void TypeManager::AnalyzeTypes(const Module& module) {
+  id_to_type_.reserve(module.IdBound());
+
   // First pass through the constants, as some will be needed when traversing
   // the types in the next pass.
   for (const auto* inst : module.GetConstants()) {
@@ -437,11 +440,26 @@ uint32_t TypeManager::GetTypeInstruction(const Type* type) {
 
 uint32_t TypeManager::FindPointerToType(uint32_t type_id,
                                         SpvStorageClass storage_class) {
+  const uint64_t key = PointerKey(type_id, storage_class);
+  auto cached = pointer_to_type_cache_.find(key);
+  if (cached != pointer_to_type_cache_.end()) {
+    // The entries are not removed with their ids, so the pointer type must
+    // still be known for the entry to be used.
+    auto pointer = id_to_type_.find(cached->second);
+    if (pointer != id_to_type_.end() && pointer->second->AsPointer() &&
+        pointer->second->AsPointer()->storage_class() == storage_class) {
+      return cached->second;
+    }
+    pointer_to_type_cache_.erase(cached);
+  }
+
   Type* pointeeTy = GetType(type_id);
   Pointer pointerTy(pointeeTy, storage_class);
   if (pointeeTy->IsUniqueType(true)) {
     // Non-ambiguous type. Get the pointer type through the type manager.
-    return GetTypeInstruction(&pointerTy);
+    uint32_t resultId = GetTypeInstruction(&pointerTy);
+    if (resultId != 0) pointer_to_type_cache_[key] = resultId;
+    return resultId;
   }
 
   // Ambiguous type, do a linear search.
@@ -452,8 +470,10 @@ uint32_t TypeManager::FindPointerToType(uint32_t type_id,
         type_inst->GetSingleWordOperand(kSpvTypePointerTypeIdInIdx) ==
             type_id &&
         type_inst->GetSingleWordOperand(kSpvTypePointerStorageClass) ==
-            storage_class)
+            storage_class) {
+      pointer_to_type_cache_[key] = type_inst->result_id();
       return type_inst->result_id();
+    }
   }
 
   // Must create the pointer type.
@@ -466,6 +486,7 @@ uint32_t TypeManager::FindPointerToType(uint32_t type_id,
                        {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {type_id}}}));
   context()->AddType(std::move(type_inst));
   context()->get_type_mgr()->RegisterType(resultId, pointerTy);
+  pointer_to_type_cache_[key] = resultId;
   return resultId;
 }
 
@@ -1048,6 +1069,15 @@ void TypeManager::ReplaceType(Type* new_type, Type* original_type) {
   }
 }
 
+size_t TypeManager::MemoryUsage() const {
+  return utils::MemoryUsage(id_to_type_) + utils::MemoryUsage(type_to_id_) +
+         utils::MemoryUsage(type_pool_) + type_pool_.size() * sizeof(Type) +
+         utils::MemoryUsage(incomplete_types_) +
+         utils::MemoryUsage(id_to_incomplete_type_) +
+         utils::MemoryUsage(id_to_constant_inst_) +
+         utils::MemoryUsage(pointer_to_type_cache_);
+}
+
 }  // namespace analysis
 }  // namespace opt
 }  // namespace spvtools
@@ -23,6 +23,7 @@
 
 #include "source/opt/module.h"
 #include "source/opt/types.h"
+#include "source/util/id_map.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
@@ -70,7 +71,7 @@ struct CompareTypeUniquePointers {
 // A class for managing the SPIR-V type hierarchy.
 class TypeManager {
  public:
-  using IdToTypeMap = std::unordered_map<uint32_t, Type*>;
+  using IdToTypeMap = utils::IdMap<Type*>;
 
   // Constructs a type manager from the given |module|. All internal messages
   // will be communicated to the outside via the given message |consumer|.
@@ -112,6 +113,9 @@ class TypeManager {
   // Find pointer to type and storage in module, return its resultId.  If it is
   // not found, a new type is created, and its id is returned.  Returns 0 if the
   // type could not be created.
+  //
+  // Answers are remembered per (|type_id|, |storage_class|), so repeated
+  // queries for the same pair do not rehash or rescan the types.
   uint32_t FindPointerToType(uint32_t type_id, SpvStorageClass storage_class);
 
   // Registers |id| to |type|.
@@ -201,6 +205,11 @@ class TypeManager {
 
   uint32_t GetVoidTypeId() { return GetTypeInstruction(GetVoidType()); }
 
+  // Returns an approximation of the number of bytes of memory used by this
+  // manager, counting each type at the size of
+  // the |Type| base class.
+  size_t MemoryUsage() const;
+
  private:
   using TypeToIdMap = std::unordered_map<const Type*, uint32_t, HashTypePointer,
                                          CompareTypePointers>;
@@ -263,6 +272,13 @@ class TypeManager {
   // |new_type|.
   void ReplaceType(Type* new_type, Type* original_type);
 
+  // Returns the key of |pointer_to_type_cache_| for a pointer to |type_id| in
+  // |storage_class|.
+  static uint64_t PointerKey(uint32_t type_id, SpvStorageClass storage_class) {
+    return (static_cast<uint64_t>(type_id) << 32) |
+           static_cast<uint32_t>(storage_class);
+  }
+
   const MessageConsumer& consumer_;  // Message consumer.
   IRContext* context_;
   IdToTypeMap id_to_type_;  // Mapping from ids to their type representations.
@@ -276,6 +292,12 @@ class TypeManager {
                                        // for incomplete types.
 
   std::unordered_map<uint32_t, const Instruction*> id_to_constant_inst_;
+
+  // Maps a (pointee type id, storage class) pair, packed by |PointerKey|, to
+  // the id last returned by |FindPointerToType| for it.  Removing an id does
+  // not update it, so that |RemoveId| stays cheap; an entry whose pointer
+  // type has been removed is dropped when it is next looked up.
+  std::unordered_map<uint64_t, uint32_t> pointer_to_type_cache_;
 };
 
 }  // namespace analysis
@@ -62,6 +62,31 @@ bool CompareTwoVectors(const U32VecVec a, const U32VecVec b) {
   return true;
 }
 
+// Appends the words of |decorations| to |words| in a canonical order, so that
+// decoration lists that CompareTwoVectors deems identical contribute the same
+// words whatever order the decorations were added in.
+void AppendDecorationHashWords(const U32VecVec& decorations,
+                               std::vector<uint32_t>* words) {
+  if (decorations.size() <= 1) {
+    for (const auto& d : decorations) {
+      words->insert(words->end(), d.begin(), d.end());
+    }
+    return;
+  }
+  std::vector<const std::vector<uint32_t>*> sorted;
+  sorted.reserve(decorations.size());
+  for (const auto& d : decorations) {
+    sorted.push_back(&d);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::vector<uint32_t>* m, const std::vector<uint32_t>* n) {
+              return *m < *n;
+            });
+  for (const auto* d : sorted) {
+    words->insert(words->end(), d->begin(), d->end());
+  }
+}
+
 }  // anonymous namespace
 
 std::string Type::GetDecorationStr() const {
@@ -189,11 +214,7 @@ void Type::GetHashWords(std::vector<uint32_t>* words,
   }
 
   words->push_back(kind_);
-  for (const auto& d : decorations_) {
-    for (auto w : d) {
-      words->push_back(w);
-    }
-  }
+  AppendDecorationHashWords(decorations_, words);
 
   switch (kind_) {
 #define DeclareKindCase(type)                   \
@@ -516,11 +537,7 @@ void Struct::GetExtraHashWords(std::vector<uint32_t>* words,
   }
   for (const auto& pair : element_decorations_) {
     words->push_back(pair.first);
-    for (const auto& d : pair.second) {
-      for (auto w : d) {
-        words->push_back(w);
-      }
-    }
+    AppendDecorationHashWords(pair.second, words);
   }
 }
 
@@ -310,30 +310,32 @@ std::tuple<bool, bool, SpvScope> UpgradeMemoryModel::GetInstructionAttributes(
 
   bool is_coherent = false;
   bool is_volatile = false;
-  std::unordered_set<uint32_t> visited;
-  std::tie(is_coherent, is_volatile) =
-      TraceInstruction(context()->get_def_use_mgr()->GetDef(id),
-                       std::vector<uint32_t>(), &visited);
+  assert(trace_indices_.empty());
+  std::tie(is_coherent, is_volatile) = TraceInstruction(inst, &trace_indices_);
+  for (uint32_t visited_id : visited_ids_) {
+    visited_.Clear(visited_id);
+  }
+  visited_ids_.clear();
 
   return std::make_tuple(is_coherent, is_volatile, SpvScopeQueueFamilyKHR);
 }
 
 std::pair<bool, bool> UpgradeMemoryModel::TraceInstruction(
-    Instruction* inst, std::vector<uint32_t> indices,
-    std::unordered_set<uint32_t>* visited) {
-  auto iter = cache_.find(std::make_pair(inst->result_id(), indices));
-  if (iter != cache_.end()) {
-    return iter->second;
+    Instruction* inst, std::vector<uint32_t>* indices) {
+  const uint32_t id = inst->result_id();
+  const bool cacheable = indices->empty();
+  if (cacheable && id < trace_cache_.size() && (trace_cache_[id] & kTraced)) {
+    return std::make_pair((trace_cache_[id] & kCoherent) != 0,
+                          (trace_cache_[id] & kVolatile) != 0);
   }
 
-  if (!visited->insert(inst->result_id()).second) {
+  if (visited_.Set(id)) {
+    ++num_cycles_cut_;
     return std::make_pair(false, false);
   }
-
-  // Initialize the cache before |indices| is (potentially) modified.
-  auto& cached_result = cache_[std::make_pair(inst->result_id(), indices)];
-  cached_result.first = false;
-  cached_result.second = false;
+  visited_ids_.push_back(id);
+  const size_t num_cycles_cut = num_cycles_cut_;
+  const size_t num_indices = indices->size();
 
   bool is_coherent = false;
   bool is_volatile = false;
@@ -346,7 +348,7 @@ std::pair<bool, bool> UpgradeMemoryModel::TraceInstruction(
         bool type_coherent = false;
         bool type_volatile = false;
         std::tie(type_coherent, type_volatile) =
-            CheckType(inst->type_id(), indices);
+            CheckType(inst->type_id(), *indices);
         is_coherent |= type_coherent;
         is_volatile |= type_volatile;
       }
@@ -355,32 +357,25 @@ std::pair<bool, bool> UpgradeMemoryModel::TraceInstruction(
     case SpvOpInBoundsAccessChain:
       // Store indices in reverse order.
       for (uint32_t i = inst->NumInOperands() - 1; i > 0; --i) {
-        indices.push_back(inst->GetSingleWordInOperand(i));
+        indices->push_back(inst->GetSingleWordInOperand(i));
       }
       break;
     case SpvOpPtrAccessChain:
       // Store indices in reverse order. Skip the |Element| operand.
       for (uint32_t i = inst->NumInOperands() - 1; i > 1; --i) {
-        indices.push_back(inst->GetSingleWordInOperand(i));
+        indices->push_back(inst->GetSingleWordInOperand(i));
       }
       break;
     default:
       break;
   }
 
-  // No point searching further.
-  if (is_coherent && is_volatile) {
-    cached_result.first = true;
-    cached_result.second = true;
-    return std::make_pair(true, true);
-  }
-
   // Variables and function parameters are sources. Continue searching until we
-  // reach them.
-  if (inst->opcode() != SpvOpVariable &&
+  // reach them, unless there is no point searching further.
+  if (!(is_coherent && is_volatile) && inst->opcode() != SpvOpVariable &&
       inst->opcode() != SpvOpFunctionParameter) {
-    inst->ForEachInId([this, &is_coherent, &is_volatile, &indices,
-                       &visited](const uint32_t* id_ptr) {
+    inst->ForEachInId([this, &is_coherent, &is_volatile,
+                       indices](const uint32_t* id_ptr) {
       Instruction* op_inst = context()->get_def_use_mgr()->GetDef(*id_ptr);
       const analysis::Type* type =
           context()->get_type_mgr()->GetType(op_inst->type_id());
@@ -389,15 +384,22 @@ std::pair<bool, bool> UpgradeMemoryModel::TraceInstruction(
         bool operand_coherent = false;
         bool operand_volatile = false;
         std::tie(operand_coherent, operand_volatile) =
-            TraceInstruction(op_inst, indices, visited);
+            TraceInstruction(op_inst, indices);
         is_coherent |= operand_coherent;
         is_volatile |= operand_volatile;
       }
     });
   }
+  indices->resize(num_indices);
 
-  cached_result.first = is_coherent;
-  cached_result.second = is_volatile;
+  if (cacheable && num_cycles_cut_ == num_cycles_cut) {
+    if (id >= trace_cache_.size()) {
+      trace_cache_.resize(id + 1, 0);
+    }
+    trace_cache_[id] = static_cast<uint8_t>(kTraced |
+                                            (is_coherent ? kCoherent : 0) |
+                                            (is_volatile ? kVolatile : 0));
+  }
   return std::make_pair(is_coherent, is_volatile);
 }
 
@@ -15,25 +15,15 @@
 #ifndef LIBSPIRV_OPT_UPGRADE_MEMORY_MODEL_H_
 #define LIBSPIRV_OPT_UPGRADE_MEMORY_MODEL_H_
 
-#include <functional>
 #include <tuple>
+#include <vector>
 
 #include "pass.h"
+#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
 
-// Hashing functor for the memoized result store.
-struct CacheHash {
-  size_t operator()(
-      const std::pair<uint32_t, std::vector<uint32_t>>& item) const {
-    std::u32string to_hash;
-    to_hash.push_back(item.first);
-    for (auto i : item.second) to_hash.push_back(i);
-    return std::hash<std::u32string>()(to_hash);
-  }
-};
-
 // Upgrades the memory model from Logical GLSL450 to Logical VulkanKHR.
 //
 // This pass remove deprecated decorations (Volatile and Coherent) and replaces
@@ -74,10 +64,10 @@ class UpgradeMemoryModel : public Pass {
   std::tuple<bool, bool, SpvScope> GetInstructionAttributes(uint32_t id);
 
   // Traces |inst| to determine if it is coherent and/or volatile.
-  // |indices| tracks the access chain indices seen so far.
+  // |indices| tracks the access chain indices seen so far, in reverse order.
+  // It is restored to its original contents before returning.
   std::pair<bool, bool> TraceInstruction(Instruction* inst,
-                                         std::vector<uint32_t> indices,
-                                         std::unordered_set<uint32_t>* visited);
+                                         std::vector<uint32_t>* indices);
 
   // Return true if |inst| is decorated with |decoration|.
   // If |inst| is decorated by member decorations then either |value| must
@@ -139,11 +129,32 @@ class UpgradeMemoryModel : public Pass {
   // implied operands.
   uint32_t MemoryAccessNumWords(uint32_t mask);
 
-  // Caches the result of TraceInstruction. For a given result id and set of
-  // indices, stores whether that combination is coherent and/or volatile.
-  std::unordered_map<std::pair<uint32_t, std::vector<uint32_t>>,
-                     std::pair<bool, bool>, CacheHash>
-      cache_;
+  // Flags of the entries of |trace_cache_|.
+  enum TraceFlags : uint8_t {
+    kTraced = 1 << 0,
+    kCoherent = 1 << 1,
+    kVolatile = 1 << 2
+  };
+
+  // Caches the result of TraceInstruction when there are no indices, which is
+  // how the pointers of the memory instructions are traced.  Indexed by result
+  // id, each entry is a combination of TraceFlags.  The results of traces
+  // with indices are not cached; they only go as far as the variable or
+  // function parameter at the base of the access chains.
+  std::vector<uint8_t> trace_cache_;
+
+  // The result ids visited by the current trace, as a set and as a list, so
+  // that the set can be cleared quickly.
+  utils::BitVector visited_;
+  std::vector<uint32_t> visited_ids_;
+
+  // The number of times the current trace came back to an instruction it was
+  // already tracing.  The results of the instructions whose trace was cut
+  // short that way are not cached.
+  size_t num_cycles_cut_ = 0;
+
+  // The access chain indices of the current trace.
+  std::vector<uint32_t> trace_indices_;
 };
 }  // namespace opt
 }  // namespace spvtools
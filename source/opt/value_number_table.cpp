@@ -16,6 +16,7 @@
 
 #include <algorithm>
 
+#include "source/opcode.h"
 #include "source/opt/cfg.h"
 #include "source/opt/ir_context.h"
 
@@ -27,20 +28,123 @@ uint32_t ValueNumberTable::GetValueNumber(Instruction* inst) const {
          "inst must have a result id to get a value number.");
 
   // Check if this instruction already has a value.
-  auto result_id_to_val = id_to_value_.find(inst->result_id());
-  if (result_id_to_val != id_to_value_.end()) {
-    return result_id_to_val->second;
+  uint32_t value = FindValueNumber(inst->result_id());
+  if (value != 0) {
+    return value;
   }
-  return 0;
+
+  if (!numbered_global_values_) {
+    NumberGlobalValues();
+    value = FindValueNumber(inst->result_id());
+    if (value != 0) {
+      return value;
+    }
+  }
+
+  BasicBlock* block = context()->get_instr_block(inst);
+  if (block && numbered_functions_.insert(block->GetParent()).second) {
+    NumberFunction(block->GetParent());
+    value = FindValueNumber(inst->result_id());
+    if (value != 0) {
+      return value;
+    }
+  }
+
+  NumberAddedInstruction(inst);
+  return FindValueNumber(inst->result_id());
 }
 
 uint32_t ValueNumberTable::GetValueNumber(uint32_t id) const {
   return GetValueNumber(context()->get_def_use_mgr()->GetDef(id));
 }
 
-uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
+void ValueNumberTable::NumberAllValues() const {
+  if (!numbered_global_values_) {
+    NumberGlobalValues();
+  }
+  for (auto& func : *context()->module()) {
+    if (numbered_functions_.insert(&func).second) {
+      NumberFunction(&func);
+    }
+  }
+}
+
+void ValueNumberTable::RemoveInstruction(const Instruction* inst) {
+  uint32_t id = inst->result_id();
+  if (id == 0) {
+    return;
+  }
+  id_to_value_.erase(id);
+
+  auto id_to_key = id_to_key_.find(id);
+  if (id_to_key == id_to_key_.end()) {
+    return;
+  }
+
+  // The other instructions with the same key and decorations keep their value
+  // number, but new ones will get a new value number, because there is no
+  // other instruction known to have these decorations.
+  auto key_to_values = instruction_to_value_.find(*id_to_key->second);
+  id_to_key_.erase(id_to_key);
+  std::vector<std::pair<uint32_t, uint32_t>>& values = key_to_values->second;
+  values.erase(std::find_if(values.begin(), values.end(),
+                            [id](const std::pair<uint32_t, uint32_t>& value) {
+                              return value.first == id;
+                            }));
+  if (values.empty()) {
+    instruction_to_value_.erase(key_to_values);
+  }
+}
+
+uint32_t ValueNumberTable::FindValueNumber(uint32_t id) const {
+  auto id_to_value = id_to_value_.find(id);
+  if (id_to_value != id_to_value_.end()) {
+    return id_to_value->second;
+  }
+  return 0;
+}
+
+void ValueNumberTable::NumberAddedInstruction(Instruction* inst) const {
+  analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
+
+  // The instructions used by |inst| that need a value number are numbered
+  // first.  An instruction that uses one of the instructions waiting on it,
+  // which can only happen through a phi, sees it as having no value number, as
+  // a phi sees the values coming from a back edge when numbering a whole
+  // function.
+  std::vector<Instruction*> to_number = {inst};
+  std::unordered_set<const Instruction*> waiting = {inst};
+  while (!to_number.empty()) {
+    Instruction* current = to_number.back();
+    Instruction* unnumbered_def = nullptr;
+    current->WhileEachInId([this, def_use_mgr, &waiting,
+                            &unnumbered_def](const uint32_t* id) {
+      if (FindValueNumber(*id) != 0) {
+        return true;
+      }
+      Instruction* def = def_use_mgr->GetDef(*id);
+      if (def == nullptr || waiting.count(def)) {
+        return true;
+      }
+      unnumbered_def = def;
+      return false;
+    });
+
+    if (unnumbered_def != nullptr) {
+      to_number.push_back(unnumbered_def);
+      waiting.insert(unnumbered_def);
+      continue;
+    }
+
+    to_number.pop_back();
+    waiting.erase(current);
+    AssignValueNumber(current);
+  }
+}
+
+uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) const {
   // If it already has a value return that.
-  uint32_t value = GetValueNumber(inst);
+  uint32_t value = FindValueNumber(inst->result_id());
   if (value != 0) {
     return value;
   }
@@ -85,7 +189,7 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
   if (inst->opcode() == SpvOpCopyObject &&
       dec_mgr->HaveTheSameDecorations(inst->result_id(),
                                       inst->GetSingleWordInOperand(0))) {
-    value = GetValueNumber(inst->GetSingleWordInOperand(0));
+    value = FindValueNumber(inst->GetSingleWordInOperand(0));
     if (value != 0) {
       id_to_value_[inst->result_id()] = value;
       return value;
@@ -97,10 +201,10 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
   if (inst->opcode() == SpvOpPhi && inst->NumInOperands() > 0 &&
       dec_mgr->HaveTheSameDecorations(inst->result_id(),
                                       inst->GetSingleWordInOperand(0))) {
-    value = GetValueNumber(inst->GetSingleWordInOperand(0));
+    value = FindValueNumber(inst->GetSingleWordInOperand(0));
     if (value != 0) {
       for (uint32_t op = 2; op < inst->NumInOperands(); op += 2) {
-        if (value != GetValueNumber(inst->GetSingleWordInOperand(op))) {
+        if (value != FindValueNumber(inst->GetSingleWordInOperand(op))) {
           value = 0;
           break;
         }
@@ -114,41 +218,83 @@ uint32_t ValueNumberTable::AssignValueNumber(Instruction* inst) {
 
   // Replace all of the operands by their value number.  The sign bit will be
   // set to distinguish between an id and a value number.
-  Instruction value_ins(context(), inst->opcode(), inst->type_id(),
-                        inst->result_id(), {});
+  ValueKey key;
+  key.opcode = inst->opcode();
+  key.type_id = inst->type_id();
   for (uint32_t o = 0; o < inst->NumInOperands(); ++o) {
     const Operand& op = inst->GetInOperand(o);
+    if (o > 0 && spvOpcodeIsAccessChain(inst->opcode()) &&
+        AppendIndexConstant(op.words[0], &key.operands)) {
+      continue;
+    }
+    key.operands.push_back(op.type);
+    key.operands.push_back(static_cast<uint32_t>(op.words.size()));
     if (spvIsIdType(op.type)) {
       uint32_t id_value = op.words[0];
       auto use_id_to_val = id_to_value_.find(id_value);
       if (use_id_to_val != id_to_value_.end()) {
         id_value = (1 << 31) | use_id_to_val->second;
       }
-      value_ins.AddOperand(Operand(op.type, {id_value}));
+      key.operands.push_back(id_value);
     } else {
-      value_ins.AddOperand(Operand(op.type, op.words));
+      key.operands.insert(key.operands.end(), op.words.begin(),
+                          op.words.end());
     }
   }
 
   // TODO: Implement a normal form for opcodes that commute like integer
   // addition.  This will let us know that a+b is the same value as b+a.
 
-  // Otherwise, we check if this value has been computed before.
-  auto value_iterator = instruction_to_value_.find(value_ins);
-  if (value_iterator != instruction_to_value_.end()) {
-    value = id_to_value_[value_iterator->first.result_id()];
-    id_to_value_[inst->result_id()] = value;
-    return value;
+  // Otherwise, we check if this value has been computed before by an
+  // instruction with the same decorations.
+  auto key_to_values = instruction_to_value_.insert({std::move(key), {}}).first;
+  std::vector<std::pair<uint32_t, uint32_t>>& values = key_to_values->second;
+  for (const auto& id_and_value : values) {
+    if (dec_mgr->HaveTheSameDecorations(id_and_value.first,
+                                        inst->result_id())) {
+      value = id_and_value.second;
+      id_to_value_[inst->result_id()] = value;
+      return value;
+    }
   }
 
   // If not, assign it a new value number.
   value = TakeNextValueNumber();
   id_to_value_[inst->result_id()] = value;
-  instruction_to_value_[value_ins] = value;
+  values.push_back({inst->result_id(), value});
+  id_to_key_[inst->result_id()] = &key_to_values->first;
   return value;
 }
 
-void ValueNumberTable::BuildDominatorTreeValueNumberTable() {
+bool ValueNumberTable::AppendIndexConstant(
+    uint32_t id, std::vector<uint32_t>* operands) const {
+  const Instruction* def = context()->get_def_use_mgr()->GetDef(id);
+  if (def == nullptr || def->opcode() != SpvOpConstant) {
+    return false;
+  }
+  const analysis::Constant* constant =
+      context()->get_constant_mgr()->FindDeclaredConstant(id);
+  const analysis::IntConstant* int_constant =
+      constant ? constant->AsIntConstant() : nullptr;
+  if (int_constant == nullptr) {
+    return false;
+  }
+
+  // Indexes are read as integers of their width whatever their signedness,
+  // so the key only contains the width and the words of the value.  No other
+  // operand of an access chain is a literal, so these cannot be confused
+  // with the other operands.
+  const std::vector<uint32_t>& words = int_constant->words();
+  operands->push_back(SPV_OPERAND_TYPE_LITERAL_INTEGER);
+  operands->push_back(static_cast<uint32_t>(words.size() + 1));
+  operands->push_back(int_constant->type()->AsInteger()->width());
+  operands->insert(operands->end(), words.begin(), words.end());
+  return true;
+}
+
+void ValueNumberTable::NumberGlobalValues() const {
+  numbered_global_values_ = true;
+
   // First value number the headers.
   for (auto& inst : context()->annotations()) {
     if (inst.result_id() != 0) {
@@ -179,60 +325,35 @@ void ValueNumberTable::BuildDominatorTreeValueNumberTable() {
       AssignValueNumber(&inst);
     }
   }
+}
 
-  for (Function& func : *context()->module()) {
-    // For best results we want to traverse the code in reverse post order.
-    // This happens naturally because of the forward referencing rules.
-    for (BasicBlock& block : func) {
-      for (Instruction& inst : block) {
-        if (inst.result_id() != 0) {
-          AssignValueNumber(&inst);
-        }
+void ValueNumberTable::NumberFunction(Function* func) const {
+  // For best results we want to traverse the code in reverse post order.
+  // This happens naturally because of the forward referencing rules.
+  for (BasicBlock& block : *func) {
+    for (Instruction& inst : block) {
+      if (inst.result_id() != 0) {
+        AssignValueNumber(&inst);
       }
     }
   }
 }
 
-bool ComputeSameValue::operator()(const Instruction& lhs,
-                                  const Instruction& rhs) const {
-  if (lhs.result_id() == 0 || rhs.result_id() == 0) {
-    return false;
-  }
-
-  if (lhs.opcode() != rhs.opcode()) {
-    return false;
-  }
-
-  if (lhs.type_id() != rhs.type_id()) {
-    return false;
-  }
-
-  if (lhs.NumInOperands() != rhs.NumInOperands()) {
-    return false;
-  }
-
-  for (uint32_t i = 0; i < lhs.NumInOperands(); ++i) {
-    if (lhs.GetInOperand(i) != rhs.GetInOperand(i)) {
-      return false;
-    }
-  }
-
-  return lhs.context()->get_decoration_mgr()->HaveTheSameDecorations(
-      lhs.result_id(), rhs.result_id());
+bool ComputeSameValue::operator()(const ValueKey& lhs,
+                                  const ValueKey& rhs) const {
+  return lhs.opcode == rhs.opcode && lhs.type_id == rhs.type_id &&
+         lhs.operands == rhs.operands;
 }
 
-std::size_t ValueTableHash::operator()(const Instruction& inst) const {
+std::size_t ValueTableHash::operator()(const ValueKey& key) const {
   // We hash the opcode and in-operands, not the result, because we want
   // instructions that are the same except for the result to hash to the
   // same value.
   std::u32string h;
-  h.push_back(inst.opcode());
-  h.push_back(inst.type_id());
-  for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
-    const auto& opnd = inst.GetInOperand(i);
-    for (uint32_t word : opnd.words) {
-      h.push_back(word);
-    }
+  h.push_back(key.opcode);
+  h.push_back(key.type_id);
+  for (uint32_t word : key.operands) {
+    h.push_back(word);
   }
   return std::hash<std::u32string>()(h);
 }
@@ -17,25 +17,39 @@
 
 #include <cstdint>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "source/opt/instruction.h"
 
 namespace spvtools {
 namespace opt {
 
+class Function;
 class IRContext;
 
-// Returns true if the two instructions compute the same value.  Used by the
-// value number table to compare two instructions.
+// What the value number table knows about the value computed by an
+// instruction: its opcode, its type and its in-operands, with the ids that
+// have a value number replaced by that value number.
+struct ValueKey {
+  SpvOp opcode;
+  uint32_t type_id;
+  // For each in-operand, its type, its number of words and its words.
+  std::vector<uint32_t> operands;
+};
+
+// Returns true if the two keys are the same.  Two instructions with the same
+// key compute the same value if they also have the same decorations.
 class ComputeSameValue {
  public:
-  bool operator()(const Instruction& lhs, const Instruction& rhs) const;
+  bool operator()(const ValueKey& lhs, const ValueKey& rhs) const;
 };
 
 // The hash function used in the value number table.
 class ValueTableHash {
  public:
-  std::size_t operator()(const Instruction& inst) const;
+  std::size_t operator()(const ValueKey& key) const;
 };
 
 // This class implements the value number analysis.  It is using a hash-based
@@ -49,40 +63,87 @@ class ValueTableHash {
 // The main difference is that because we do not perform redundancy elimination
 // as we build the value number table, we do not have to deal with cleaning up
 // the scope.
+//
+// The table is built lazily: the global values are numbered on the first
+// query, and the instructions of a function on the first query for one of
+// them.  Instructions added afterwards are numbered when they are queried, and
+// killed instructions are removed with RemoveInstruction, so the table stays
+// valid through transformations that only add and remove instructions, or
+// that replace an id by one with the same value number.
 class ValueNumberTable {
  public:
-  ValueNumberTable(IRContext* ctx) : context_(ctx), next_value_number_(1) {
-    BuildDominatorTreeValueNumberTable();
-  }
+  ValueNumberTable(IRContext* ctx)
+      : context_(ctx),
+        next_value_number_(1),
+        numbered_global_values_(false) {}
 
   // Returns the value number of the value computed by |inst|.  |inst| must have
-  // a result id that will hold the computed value.  If no value number has been
+  // a result id that will hold the computed value.  If no value number can be
   // assigned to the result id, then the return value is 0.
   uint32_t GetValueNumber(Instruction* inst) const;
 
   // Returns the value number of the value contain in |id|.  Returns 0 if it
-  // has not been assigned a value number.
+  // cannot be assigned a value number.
   uint32_t GetValueNumber(uint32_t id) const;
 
+  // Numbers the global values and the instructions of every function now,
+  // instead of on their first query.  Labels are not numbered.
+  void NumberAllValues() const;
+
+  // Returns the value number already assigned to |id|, or 0 if there is none.
+  // Unlike GetValueNumber, never numbers anything: it only reads the table, so
+  // it may be called from several threads at the same time.
+  uint32_t FindValueNumber(uint32_t id) const;
+
+  // Forgets the value number of |inst|, which is about to be killed.
+  void RemoveInstruction(const Instruction* inst);
+
   IRContext* context() const { return context_; }
 
  private:
-  // Assigns a value number to every result id in the module.
-  void BuildDominatorTreeValueNumberTable();
+  // Assigns a value number to every result id in the global sections of the
+  // module.
+  void NumberGlobalValues() const;
+
+  // Assigns a value number to every result id in |func|.
+  void NumberFunction(Function* func) const;
+
+  // Assigns a value number to |inst|, which has been added after its function
+  // was numbered, and to the other such instructions it uses.
+  void NumberAddedInstruction(Instruction* inst) const;
 
   // Returns the new value number.
-  uint32_t TakeNextValueNumber() { return next_value_number_++; }
+  uint32_t TakeNextValueNumber() const { return next_value_number_++; }
 
   // Assigns a new value number to the result of |inst| if it does not already
   // have one.  Return the value number for |inst|.  |inst| must have a result
   // id.
-  uint32_t AssignValueNumber(Instruction* inst);
+  uint32_t AssignValueNumber(Instruction* inst) const;
+
+  // If |id| is an integer scalar constant, appends a representation of its
+  // value that does not depend on its signedness to |operands| and returns
+  // true.  Otherwise returns false.  Used for the indexes of access chains, so
+  // that indexing with |int 1| and |uint 1| gives the same value.
+  bool AppendIndexConstant(uint32_t id, std::vector<uint32_t>* operands) const;
 
-  std::unordered_map<Instruction, uint32_t, ValueTableHash, ComputeSameValue>
-      instruction_to_value_;
-  std::unordered_map<uint32_t, uint32_t> id_to_value_;
   IRContext* context_;
-  uint32_t next_value_number_;
+
+  // The table is filled in by the queries, which are logically const.
+  //
+  // For each key, the value number of the instructions with that key, for
+  // each set of decorations they can have.  Each set of decorations is
+  // represented by the result id of an instruction that has it.
+  mutable std::unordered_map<ValueKey,
+                             std::vector<std::pair<uint32_t, uint32_t>>,
+                             ValueTableHash, ComputeSameValue>
+      instruction_to_value_;
+  mutable std::unordered_map<uint32_t, uint32_t> id_to_value_;
+  // The result ids representing a set of decorations in
+  // |instruction_to_value_|, mapped to their key.
+  mutable std::unordered_map<uint32_t, const ValueKey*> id_to_key_;
+  mutable uint32_t next_value_number_;
+  mutable bool numbered_global_values_;
+  mutable std::unordered_set<const Function*> numbered_functions_;
 };
 
 }  // namespace opt
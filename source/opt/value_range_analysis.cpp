@@ -0,0 +1,253 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/value_range_analysis.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "source/opt/ir_context.h"
+#include "source/opt/loop_descriptor.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// Limits the depth of operands followed, which also breaks cycles through
+// phis.
+const uint32_t kMaxDepth = 8;
+
+// Returns the smallest signed value of a |width|-bit integer.
+int64_t MinSigned(uint32_t width) {
+  return width >= 64 ? std::numeric_limits<int64_t>::min()
+                     : -(int64_t(1) << (width - 1));
+}
+
+// Returns the largest signed value of a |width|-bit integer.
+int64_t MaxSigned(uint32_t width) {
+  return width >= 64 ? std::numeric_limits<int64_t>::max()
+                     : (int64_t(1) << (width - 1)) - 1;
+}
+
+}  // namespace
+
+bool ValueRangeAnalysis::GetSignedRange(const Instruction* inst,
+                                        const BasicBlock* use_block,
+                                        Range* range) {
+  bool use_dependent = false;
+  return ComputeRange(inst, use_block, kMaxDepth, range, &use_dependent);
+}
+
+bool ValueRangeAnalysis::IsInRange(const Instruction* inst,
+                                   const BasicBlock* use_block, int64_t min,
+                                   int64_t max) {
+  Range range;
+  return GetSignedRange(inst, use_block, &range) && range.min >= min &&
+         range.max <= max;
+}
+
+uint32_t ValueRangeAnalysis::GetIntegerWidth(const Instruction* inst) {
+  if (inst->type_id() == 0) return 0;
+  const analysis::Type* type =
+      context_->get_type_mgr()->GetType(inst->type_id());
+  const analysis::Integer* int_type = type ? type->AsInteger() : nullptr;
+  if (int_type == nullptr || int_type->width() > 64) return 0;
+  return int_type->width();
+}
+
+bool ValueRangeAnalysis::ComputeRange(const Instruction* inst,
+                                      const BasicBlock* use_block,
+                                      uint32_t depth, Range* range,
+                                      bool* use_dependent) {
+  auto cached = ranges_.find(inst->result_id());
+  if (cached != ranges_.end()) {
+    *range = cached->second;
+    return true;
+  }
+  bool dependent = false;
+  if (!ComputeOperationRange(inst, use_block, depth, range, &dependent))
+    return false;
+  if (dependent) {
+    *use_dependent = true;
+  } else {
+    ranges_[inst->result_id()] = *range;
+  }
+  return true;
+}
+
+bool ValueRangeAnalysis::ComputeOperationRange(const Instruction* inst,
+                                               const BasicBlock* use_block,
+                                               uint32_t depth, Range* range,
+                                               bool* use_dependent) {
+  const uint32_t width = GetIntegerWidth(inst);
+  if (width == 0 || depth == 0) return false;
+  analysis::DefUseManager* def_use_mgr = context_->get_def_use_mgr();
+  auto operand_range = [this, def_use_mgr, use_block, depth, use_dependent](
+                           const Instruction* user, uint32_t in_idx,
+                           Range* op_range) {
+    const Instruction* op_inst =
+        def_use_mgr->GetDef(user->GetSingleWordInOperand(in_idx));
+    return ComputeRange(op_inst, use_block, depth - 1, op_range,
+                        use_dependent);
+  };
+
+  if (const analysis::Constant* constant =
+          context_->get_constant_mgr()->GetConstantFromInst(inst)) {
+    if (!constant->AsIntConstant() && !constant->AsNullConstant())
+      return false;
+    range->min = range->max = constant->GetSignExtendedValue();
+    return true;
+  }
+
+  Range a;
+  Range b;
+  switch (inst->opcode()) {
+    case SpvOpCopyObject:
+      return operand_range(inst, 0, range);
+    case SpvOpBitwiseAnd: {
+      // Masking with a non-negative value gives a value between zero and the
+      // mask.
+      bool a_known = operand_range(inst, 0, &a) && a.min >= 0;
+      bool b_known = operand_range(inst, 1, &b) && b.min >= 0;
+      if (!a_known && !b_known) return false;
+      range->min = 0;
+      range->max = a_known && b_known ? std::min(a.max, b.max)
+                                      : (a_known ? a.max : b.max);
+      return true;
+    }
+    case SpvOpUMod:
+    case SpvOpSMod:
+      // With a positive divisor, the result is less than the divisor and,
+      // for SMod, has its sign.
+      if (!operand_range(inst, 1, &b) || b.min < 1) return false;
+      range->min = 0;
+      range->max = b.max - 1;
+      if (inst->opcode() == SpvOpUMod && operand_range(inst, 0, &a) &&
+          a.min >= 0)
+        range->max = std::min(range->max, a.max);
+      return true;
+    case SpvOpShiftRightLogical:
+    case SpvOpShiftRightArithmetic: {
+      if (!operand_range(inst, 1, &b) || b.min != b.max || b.min < 1 ||
+          b.min >= width)
+        return false;
+      const uint32_t shift = static_cast<uint32_t>(b.min);
+      if (operand_range(inst, 0, &a) &&
+          (a.min >= 0 || inst->opcode() == SpvOpShiftRightArithmetic)) {
+        range->min = a.min >> shift;
+        range->max = a.max >> shift;
+        return true;
+      }
+      if (inst->opcode() != SpvOpShiftRightLogical) return false;
+      range->min = 0;
+      range->max = int64_t((uint64_t(1) << (width - shift)) - 1);
+      return true;
+    }
+    case SpvOpUConvert:
+    case SpvOpSConvert: {
+      const Instruction* op_inst =
+          def_use_mgr->GetDef(inst->GetSingleWordInOperand(0));
+      const uint32_t op_width = GetIntegerWidth(op_inst);
+      if (op_width == 0 || op_width >= width) return false;
+      if (operand_range(inst, 0, &a) &&
+          (a.min >= 0 || inst->opcode() == SpvOpSConvert)) {
+        *range = a;
+        return true;
+      }
+      if (inst->opcode() != SpvOpUConvert) return false;
+      range->min = 0;
+      range->max = int64_t((uint64_t(1) << op_width) - 1);
+      return true;
+    }
+    case SpvOpIAdd:
+    case SpvOpISub: {
+      if (!operand_range(inst, 0, &a) || !operand_range(inst, 1, &b))
+        return false;
+      // Operand ranges come from the same width, so for widths below 64 these
+      // cannot overflow int64_t.
+      if (width >= 64) return false;
+      if (inst->opcode() == SpvOpIAdd) {
+        range->min = a.min + b.min;
+        range->max = a.max + b.max;
+      } else {
+        range->min = a.min - b.max;
+        range->max = a.max - b.min;
+      }
+      // Results that may wrap have no useful bounds.
+      return range->min >= MinSigned(width) && range->max <= MaxSigned(width);
+    }
+    case SpvOpSelect:
+      if (!operand_range(inst, 1, &a) || !operand_range(inst, 2, &b))
+        return false;
+      range->min = std::min(a.min, b.min);
+      range->max = std::max(a.max, b.max);
+      return true;
+    case SpvOpPhi: {
+      if (GetInductionRange(inst, use_block, range)) {
+        *use_dependent = true;
+        return true;
+      }
+      bool known = false;
+      for (uint32_t i = 0; i < inst->NumInOperands(); i += 2) {
+        if (!operand_range(inst, i, &a)) return false;
+        range->min = known ? std::min(range->min, a.min) : a.min;
+        range->max = known ? std::max(range->max, a.max) : a.max;
+        known = true;
+      }
+      return known;
+    }
+    default:
+      return false;
+  }
+}
+
+bool ValueRangeAnalysis::GetInductionRange(const Instruction* phi,
+                                           const BasicBlock* use_block,
+                                           Range* range) {
+  BasicBlock* header = context_->get_instr_block(phi->result_id());
+  if (header == nullptr || use_block == nullptr) return false;
+  const Function* function = header->GetParent();
+  if (function != function_ || function != use_block->GetParent())
+    return false;
+  Loop* loop = (*context_->GetLoopDescriptor(function))[header];
+  if (loop == nullptr || loop->GetHeaderBlock() != header ||
+      !loop->IsInsideLoop(use_block->id()))
+    return false;
+  BasicBlock* condition_block = loop->FindConditionBlock();
+  if (condition_block == nullptr ||
+      loop->FindConditionVariable(condition_block) != phi)
+    return false;
+  // The iteration count assumes the loop continues along the true branch.
+  const Instruction& branch = *condition_block->ctail();
+  const uint32_t continue_id = branch.GetSingleWordInOperand(1);
+  if (branch.GetSingleWordInOperand(2) != loop->GetMergeBlock()->id() ||
+      continue_id == header->id())
+    return false;
+  if (!context_->GetDominatorAnalysis(function)->Dominates(continue_id,
+                                                           use_block->id()))
+    return false;
+  size_t iterations = 0;
+  int64_t step = 0;
+  int64_t init = 0;
+  if (!loop->FindNumberOfIterations(phi, &branch, &iterations, &step, &init))
+    return false;
+  // The condition held for the first |iterations| values of |phi|.
+  const int64_t last = init + int64_t(iterations - 1) * step;
+  range->min = std::min(init, last);
+  range->max = std::max(init, last);
+  return true;
+}
+
+}  // namespace opt
+}  // namespace spvtools
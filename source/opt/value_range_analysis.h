@@ -0,0 +1,103 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_OPT_VALUE_RANGE_ANALYSIS_H_
+#define SOURCE_OPT_VALUE_RANGE_ANALYSIS_H_
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "source/opt/basic_block.h"
+#include "source/opt/function.h"
+#include "source/opt/instruction.h"
+
+namespace spvtools {
+namespace opt {
+
+class IRContext;
+
+// Computes conservative bounds on the values of the scalar integer
+// instructions of a function. Bounds are derived from constants, bit masks,
+// remainders, shifts, width conversions, additions, selects, phis, and the
+// induction variables of loops whose iteration count is known.
+//
+// The analysis is sparse: the range of an instruction is computed from the
+// ranges of its operands when first queried, and cached unless it depends on
+// where the instruction is used. It is maintained by the IRContext as
+// |kAnalysisValueRange|, and must be invalidated when the function's
+// instructions, dominators or loops change.
+class ValueRangeAnalysis {
+ public:
+  // An inclusive range of values.
+  struct Range {
+    int64_t min;
+    int64_t max;
+  };
+
+  ValueRangeAnalysis(IRContext* context, const Function* function)
+      : context_(context), function_(function) {}
+
+  // Returns true and sets |*range| to bounds on the value of |inst|,
+  // interpreted as a signed integer, wherever it is used in |use_block|.
+  // Returns false if no bounds are known. |inst| must be of scalar integer
+  // type at most 64 bits wide. |use_block| may be null, in which case only
+  // bounds holding throughout the function are returned.
+  bool GetSignedRange(const Instruction* inst, const BasicBlock* use_block,
+                      Range* range);
+
+  // Returns true if the value of |inst| is known to lie in [|min|, |max|]
+  // wherever it is used in |use_block|.
+  bool IsInRange(const Instruction* inst, const BasicBlock* use_block,
+                 int64_t min, int64_t max);
+
+  // Returns true if a range has been cached for |inst|.
+  bool HasRange(const Instruction* inst) const {
+    return ranges_.count(inst->result_id()) != 0;
+  }
+
+ private:
+  // Implements GetSignedRange, giving up after |depth| nested operands. Sets
+  // |*use_dependent| if the result depends on |use_block|.
+  bool ComputeRange(const Instruction* inst, const BasicBlock* use_block,
+                    uint32_t depth, Range* range, bool* use_dependent);
+
+  // Computes the range of |inst| from its operands, without the cache.
+  bool ComputeOperationRange(const Instruction* inst,
+                             const BasicBlock* use_block, uint32_t depth,
+                             Range* range, bool* use_dependent);
+
+  // Returns true and sets |*range| to the values taken in |use_block| by
+  // |phi|, if it is the induction variable controlling the exit of a loop
+  // with a known iteration count and |use_block| is only reached while the
+  // loop continues.
+  bool GetInductionRange(const Instruction* phi, const BasicBlock* use_block,
+                         Range* range);
+
+  // Returns the width of the integer type of |inst|, or 0 if it is not a
+  // scalar integer at most 64 bits wide.
+  uint32_t GetIntegerWidth(const Instruction* inst);
+
+  IRContext* context_;
+
+  // The function whose instructions are analysed.
+  const Function* function_;
+
+  // Map from result id to the range of the instruction wherever it is used.
+  std::unordered_map<uint32_t, Range> ranges_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // SOURCE_OPT_VALUE_RANGE_ANALYSIS_H_
@@ -14,8 +14,6 @@
 
 #include "source/opt/vector_dce.h"
 
-#include <utility>
-
 namespace spvtools {
 namespace opt {
 namespace {
@@ -28,21 +26,34 @@ const uint32_t kInsertCompositeIdInIdx = 1;
 
 Pass::Status VectorDCE::Process() {
   bool modified = false;
+  LiveComponentMap live_components;
   for (Function& function : *get_module()) {
-    modified |= VectorDCEFunction(&function);
+    modified |= VectorDCEFunction(&function, &live_components);
   }
   return (modified ? Status::SuccessWithChange : Status::SuccessWithoutChange);
 }
 
-bool VectorDCE::VectorDCEFunction(Function* function) {
-  LiveComponentMap live_components;
-  FindLiveComponents(function, &live_components);
-  return RewriteInstructions(function, live_components);
+bool VectorDCE::VectorDCEFunction(Function* function,
+                                  LiveComponentMap* live_components) {
+  // The rewrite of the previous functions may have added new ids.
+  live_components->resize(context()->module()->IdBound(), 0);
+  FindLiveComponents(function, live_components);
+  return RewriteInstructions(function, *live_components);
+}
+
+VectorDCE::ComponentMask VectorDCE::GetLiveComponents(
+    const Instruction* inst, const LiveComponentMap& live_components,
+    bool* known) {
+  const uint32_t id = inst->result_id();
+  const ComponentMask mask = id < live_components.size() ? live_components[id]
+                                                         : ComponentMask(0);
+  *known = (mask & kLiveComponentsKnown) != 0;
+  return mask & kAllComponentsLive;
 }
 
 void VectorDCE::FindLiveComponents(Function* function,
                                    LiveComponentMap* live_components) {
-  std::vector<WorkListItem> work_list;
+  std::vector<Instruction*> work_list;
 
   // Prime the work list.  We will assume that any instruction that does
   // not result in a vector is live.
@@ -57,37 +68,44 @@ void VectorDCE::FindLiveComponents(Function* function,
         }
         if (!HasVectorOrScalarResult(current_inst) ||
             !context()->IsCombinatorInstruction(current_inst)) {
-          MarkUsesAsLive(current_inst, all_components_live_, live_components,
+          MarkUsesAsLive(current_inst, kAllComponentsLive, live_components,
                          &work_list);
         }
       });
 
-  // Process the work list propagating liveness.
-  for (uint32_t i = 0; i < work_list.size(); i++) {
-    WorkListItem current_item = work_list[i];
-    Instruction* current_inst = current_item.instruction;
+  // Process the work list propagating liveness.  An instruction is in the
+  // work list at most once, and is processed with all of its components that
+  // are live by then.
+  while (!work_list.empty()) {
+    Instruction* current_inst = work_list.back();
+    work_list.pop_back();
+    ComponentMask& mask = (*live_components)[current_inst->result_id()];
+    mask &= ~kInWorkList;
+    const ComponentMask live_elements = mask & kAllComponentsLive;
 
     switch (current_inst->opcode()) {
       case SpvOpCompositeExtract:
-        MarkExtractUseAsLive(current_inst, current_item.components,
-                             live_components, &work_list);
+        MarkExtractUseAsLive(current_inst, live_elements, live_components,
+                             &work_list);
         break;
       case SpvOpCompositeInsert:
-        MarkInsertUsesAsLive(current_item, live_components, &work_list);
+        MarkInsertUsesAsLive(current_inst, live_elements, live_components,
+                             &work_list);
         break;
       case SpvOpVectorShuffle:
-        MarkVectorShuffleUsesAsLive(current_item, live_components, &work_list);
+        MarkVectorShuffleUsesAsLive(current_inst, live_elements,
+                                    live_components, &work_list);
         break;
       case SpvOpCompositeConstruct:
-        MarkCompositeContructUsesAsLive(current_item, live_components,
-                                        &work_list);
+        MarkCompositeContructUsesAsLive(current_inst, live_elements,
+                                        live_components, &work_list);
         break;
       default:
         if (current_inst->IsScalarizable()) {
-          MarkUsesAsLive(current_inst, current_item.components, live_components,
+          MarkUsesAsLive(current_inst, live_elements, live_components,
                          &work_list);
         } else {
-          MarkUsesAsLive(current_inst, all_components_live_, live_components,
+          MarkUsesAsLive(current_inst, kAllComponentsLive, live_components,
                          &work_list);
         }
         break;
@@ -96,167 +114,148 @@ void VectorDCE::FindLiveComponents(Function* function,
 }
 
 void VectorDCE::MarkExtractUseAsLive(const Instruction* current_inst,
-                                     const utils::BitVector& live_elements,
+                                     ComponentMask live_elements,
                                      LiveComponentMap* live_components,
-                                     std::vector<WorkListItem>* work_list) {
+                                     std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
   uint32_t operand_id =
       current_inst->GetSingleWordInOperand(kExtractCompositeIdInIdx);
   Instruction* operand_inst = def_use_mgr->GetDef(operand_id);
 
   if (HasVectorOrScalarResult(operand_inst)) {
-    WorkListItem new_item;
-    new_item.instruction = operand_inst;
-    if (current_inst->NumInOperands() < 2) {
-      new_item.components = live_elements;
-    } else {
-      new_item.components.Set(current_inst->GetSingleWordInOperand(1));
-    }
-    AddItemToWorkListIfNeeded(new_item, live_components, work_list);
+    ComponentMask components =
+        current_inst->NumInOperands() < 2
+            ? live_elements
+            : ComponentBit(current_inst->GetSingleWordInOperand(1));
+    AddItemToWorkListIfNeeded(operand_inst, components, live_components,
+                              work_list);
   }
 }
 
-void VectorDCE::MarkInsertUsesAsLive(
-    const VectorDCE::WorkListItem& current_item,
-    LiveComponentMap* live_components,
-    std::vector<VectorDCE::WorkListItem>* work_list) {
+void VectorDCE::MarkInsertUsesAsLive(const Instruction* current_inst,
+                                     ComponentMask live_elements,
+                                     LiveComponentMap* live_components,
+                                     std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
 
-  if (current_item.instruction->NumInOperands() > 2) {
-    uint32_t insert_position =
-        current_item.instruction->GetSingleWordInOperand(2);
+  if (current_inst->NumInOperands() > 2) {
+    const ComponentMask insert_position =
+        ComponentBit(current_inst->GetSingleWordInOperand(2));
 
     // Add the elements of the composite object that are used.
-    uint32_t operand_id = current_item.instruction->GetSingleWordInOperand(
-        kInsertCompositeIdInIdx);
+    uint32_t operand_id =
+        current_inst->GetSingleWordInOperand(kInsertCompositeIdInIdx);
     Instruction* operand_inst = def_use_mgr->GetDef(operand_id);
-
-    WorkListItem new_item;
-    new_item.instruction = operand_inst;
-    new_item.components = current_item.components;
-    new_item.components.Clear(insert_position);
-
-    AddItemToWorkListIfNeeded(new_item, live_components, work_list);
+    AddItemToWorkListIfNeeded(operand_inst, live_elements & ~insert_position,
+                              live_components, work_list);
 
     // Add the element being inserted if it is used.
-    if (current_item.components.Get(insert_position)) {
+    if (live_elements & insert_position) {
       uint32_t obj_operand_id =
-          current_item.instruction->GetSingleWordInOperand(
-              kInsertObjectIdInIdx);
+          current_inst->GetSingleWordInOperand(kInsertObjectIdInIdx);
       Instruction* obj_operand_inst = def_use_mgr->GetDef(obj_operand_id);
-      WorkListItem new_item_for_obj;
-      new_item_for_obj.instruction = obj_operand_inst;
-      new_item_for_obj.components.Set(0);
-      AddItemToWorkListIfNeeded(new_item_for_obj, live_components, work_list);
+      AddItemToWorkListIfNeeded(obj_operand_inst, ComponentBit(0),
+                                live_components, work_list);
     }
   } else {
     // If there are no indices, then this is a copy of the object being
     // inserted.
     uint32_t object_id =
-        current_item.instruction->GetSingleWordInOperand(kInsertObjectIdInIdx);
+        current_inst->GetSingleWordInOperand(kInsertObjectIdInIdx);
     Instruction* object_inst = def_use_mgr->GetDef(object_id);
-
-    WorkListItem new_item;
-    new_item.instruction = object_inst;
-    new_item.components = current_item.components;
-    AddItemToWorkListIfNeeded(new_item, live_components, work_list);
+    AddItemToWorkListIfNeeded(object_inst, live_elements, live_components,
+                              work_list);
   }
 }
 
 void VectorDCE::MarkVectorShuffleUsesAsLive(
-    const WorkListItem& current_item,
-    VectorDCE::LiveComponentMap* live_components,
-    std::vector<WorkListItem>* work_list) {
+    const Instruction* current_inst, ComponentMask live_elements,
+    LiveComponentMap* live_components, std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
 
-  WorkListItem first_operand;
-  first_operand.instruction =
-      def_use_mgr->GetDef(current_item.instruction->GetSingleWordInOperand(0));
-  WorkListItem second_operand;
-  second_operand.instruction =
-      def_use_mgr->GetDef(current_item.instruction->GetSingleWordInOperand(1));
+  Instruction* first_operand =
+      def_use_mgr->GetDef(current_inst->GetSingleWordInOperand(0));
+  Instruction* second_operand =
+      def_use_mgr->GetDef(current_inst->GetSingleWordInOperand(1));
+  ComponentMask first_components = 0;
+  ComponentMask second_components = 0;
 
   analysis::TypeManager* type_mgr = context()->get_type_mgr();
   analysis::Vector* first_type =
-      type_mgr->GetType(first_operand.instruction->type_id())->AsVector();
+      type_mgr->GetType(first_operand->type_id())->AsVector();
   uint32_t size_of_first_operand = first_type->element_count();
 
-  for (uint32_t in_op = 2; in_op < current_item.instruction->NumInOperands();
-       ++in_op) {
-    uint32_t index = current_item.instruction->GetSingleWordInOperand(in_op);
-    if (current_item.components.Get(in_op - 2)) {
+  for (uint32_t in_op = 2; in_op < current_inst->NumInOperands(); ++in_op) {
+    uint32_t index = current_inst->GetSingleWordInOperand(in_op);
+    if (live_elements & ComponentBit(in_op - 2)) {
       if (index < size_of_first_operand) {
-        first_operand.components.Set(index);
+        first_components |= ComponentBit(index);
       } else {
-        second_operand.components.Set(index - size_of_first_operand);
+        second_components |= ComponentBit(index - size_of_first_operand);
       }
     }
   }
 
-  AddItemToWorkListIfNeeded(first_operand, live_components, work_list);
-  AddItemToWorkListIfNeeded(second_operand, live_components, work_list);
+  AddItemToWorkListIfNeeded(first_operand, first_components, live_components,
+                            work_list);
+  AddItemToWorkListIfNeeded(second_operand, second_components,
+                            live_components, work_list);
 }
 
 void VectorDCE::MarkCompositeContructUsesAsLive(
-    VectorDCE::WorkListItem work_item,
-    VectorDCE::LiveComponentMap* live_components,
-    std::vector<VectorDCE::WorkListItem>* work_list) {
+    const Instruction* current_inst, ComponentMask live_elements,
+    LiveComponentMap* live_components, std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
   analysis::TypeManager* type_mgr = context()->get_type_mgr();
 
   uint32_t current_component = 0;
-  Instruction* current_inst = work_item.instruction;
   uint32_t num_in_operands = current_inst->NumInOperands();
   for (uint32_t i = 0; i < num_in_operands; ++i) {
     uint32_t id = current_inst->GetSingleWordInOperand(i);
     Instruction* op_inst = def_use_mgr->GetDef(id);
 
     if (HasScalarResult(op_inst)) {
-      WorkListItem new_work_item;
-      new_work_item.instruction = op_inst;
-      if (work_item.components.Get(current_component)) {
-        new_work_item.components.Set(0);
+      ComponentMask components = 0;
+      if (live_elements & ComponentBit(current_component)) {
+        components = ComponentBit(0);
       }
-      AddItemToWorkListIfNeeded(new_work_item, live_components, work_list);
+      AddItemToWorkListIfNeeded(op_inst, components, live_components,
+                                work_list);
       current_component++;
     } else {
       assert(HasVectorResult(op_inst));
-      WorkListItem new_work_item;
-      new_work_item.instruction = op_inst;
+      ComponentMask components = 0;
       uint32_t op_vector_size =
           type_mgr->GetType(op_inst->type_id())->AsVector()->element_count();
 
       for (uint32_t op_vector_idx = 0; op_vector_idx < op_vector_size;
            op_vector_idx++, current_component++) {
-        if (work_item.components.Get(current_component)) {
-          new_work_item.components.Set(op_vector_idx);
+        if (live_elements & ComponentBit(current_component)) {
+          components |= ComponentBit(op_vector_idx);
         }
       }
-      AddItemToWorkListIfNeeded(new_work_item, live_components, work_list);
+      AddItemToWorkListIfNeeded(op_inst, components, live_components,
+                                work_list);
     }
   }
 }
 
-void VectorDCE::MarkUsesAsLive(
-    Instruction* current_inst, const utils::BitVector& live_elements,
-    LiveComponentMap* live_components,
-    std::vector<VectorDCE::WorkListItem>* work_list) {
+void VectorDCE::MarkUsesAsLive(Instruction* current_inst,
+                               ComponentMask live_elements,
+                               LiveComponentMap* live_components,
+                               std::vector<Instruction*>* work_list) {
   analysis::DefUseManager* def_use_mgr = context()->get_def_use_mgr();
 
-  current_inst->ForEachInId([&work_list, &live_elements, this, live_components,
+  current_inst->ForEachInId([&work_list, live_elements, this, live_components,
                              def_use_mgr](uint32_t* operand_id) {
     Instruction* operand_inst = def_use_mgr->GetDef(*operand_id);
 
     if (HasVectorResult(operand_inst)) {
-      WorkListItem new_item;
-      new_item.instruction = operand_inst;
-      new_item.components = live_elements;
-      AddItemToWorkListIfNeeded(new_item, live_components, work_list);
+      AddItemToWorkListIfNeeded(operand_inst, live_elements, live_components,
+                                work_list);
     } else if (HasScalarResult(operand_inst)) {
-      WorkListItem new_item;
-      new_item.instruction = operand_inst;
-      new_item.components.Set(0);
-      AddItemToWorkListIfNeeded(new_item, live_components, work_list);
+      AddItemToWorkListIfNeeded(operand_inst, ComponentBit(0),
+                                live_components, work_list);
     }
   });
 }
@@ -306,14 +305,16 @@ bool VectorDCE::RewriteInstructions(
   // in |dead_dbg_value| to kill them once after the iteration.
   std::vector<Instruction*> dead_dbg_value;
 
-  function->ForEachInst([&modified, this, live_components,
+  function->ForEachInst([&modified, this, &live_components,
                          &dead_dbg_value](Instruction* current_inst) {
     if (!context()->IsCombinatorInstruction(current_inst)) {
       return;
     }
 
-    auto live_component = live_components.find(current_inst->result_id());
-    if (live_component == live_components.end()) {
+    bool known = false;
+    const ComponentMask live_component =
+        GetLiveComponents(current_inst, live_components, &known);
+    if (!known) {
       // If this instruction is not in live_components then it does not
       // produce a vector, or it is never referenced and ADCE will remove
       // it.  No point in trying to differentiate.
@@ -322,7 +323,7 @@ bool VectorDCE::RewriteInstructions(
 
     // If no element in the current instruction is used replace it with an
     // OpUndef.
-    if (live_component->second.Empty()) {
+    if (live_component == 0) {
       modified = true;
       MarkDebugValueUsesAsDead(current_inst, &dead_dbg_value);
       uint32_t undef_id = this->Type2Undef(current_inst->type_id());
@@ -334,8 +335,8 @@ bool VectorDCE::RewriteInstructions(
 
     switch (current_inst->opcode()) {
       case SpvOpCompositeInsert:
-        modified |= RewriteInsertInstruction(
-            current_inst, live_component->second, &dead_dbg_value);
+        modified |= RewriteInsertInstruction(current_inst, live_component,
+                                             &dead_dbg_value);
         break;
       case SpvOpCompositeConstruct:
         // TODO: The members that are not live can be replaced by an undef
@@ -352,7 +353,7 @@ bool VectorDCE::RewriteInstructions(
 }
 
 bool VectorDCE::RewriteInsertInstruction(
-    Instruction* current_inst, const utils::BitVector& live_components,
+    Instruction* current_inst, ComponentMask live_components,
     std::vector<Instruction*>* dead_dbg_value) {
   // If the value being inserted is not live, then we can skip the insert.
 
@@ -365,8 +366,9 @@ bool VectorDCE::RewriteInsertInstruction(
     return true;
   }
 
-  uint32_t insert_index = current_inst->GetSingleWordInOperand(2);
-  if (!live_components.Get(insert_index)) {
+  const ComponentMask insert_position =
+      ComponentBit(current_inst->GetSingleWordInOperand(2));
+  if (!(live_components & insert_position)) {
     MarkDebugValueUsesAsDead(current_inst, dead_dbg_value);
     context()->KillNamesAndDecorates(current_inst->result_id());
     uint32_t composite_id =
@@ -377,9 +379,7 @@ bool VectorDCE::RewriteInsertInstruction(
 
   // If the values already in the composite are not used, then replace it with
   // an undef.
-  utils::BitVector temp = live_components;
-  temp.Clear(insert_index);
-  if (temp.Empty()) {
+  if ((live_components & ~insert_position) == 0) {
     context()->ForgetUses(current_inst);
     uint32_t undef_id = Type2Undef(current_inst->type_id());
     current_inst->SetInOperand(kInsertCompositeIdInIdx, {undef_id});
@@ -400,18 +400,15 @@ void VectorDCE::MarkDebugValueUsesAsDead(
 }
 
 void VectorDCE::AddItemToWorkListIfNeeded(
-    WorkListItem work_item, VectorDCE::LiveComponentMap* live_components,
-    std::vector<WorkListItem>* work_list) {
-  Instruction* current_inst = work_item.instruction;
-  auto it = live_components->find(current_inst->result_id());
-  if (it == live_components->end()) {
-    live_components->emplace(
-        std::make_pair(current_inst->result_id(), work_item.components));
-    work_list->emplace_back(work_item);
-  } else {
-    if (it->second.Or(work_item.components)) {
-      work_list->emplace_back(work_item);
-    }
+    Instruction* inst, ComponentMask components,
+    LiveComponentMap* live_components, std::vector<Instruction*>* work_list) {
+  ComponentMask& mask = (*live_components)[inst->result_id()];
+  const ComponentMask new_mask = mask | components | kLiveComponentsKnown;
+  if (new_mask == mask) return;
+  mask = new_mask;
+  if (!(mask & kInWorkList)) {
+    mask |= kInWorkList;
+    work_list->push_back(inst);
   }
 }
 
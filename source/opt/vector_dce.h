@@ -15,36 +15,41 @@
 #ifndef SOURCE_OPT_VECTOR_DCE_H_
 #define SOURCE_OPT_VECTOR_DCE_H_
 
-#include <unordered_map>
 #include <vector>
 
 #include "source/opt/mem_pass.h"
-#include "source/util/bit_vector.h"
 
 namespace spvtools {
 namespace opt {
 
 class VectorDCE : public MemPass {
  private:
-  using LiveComponentMap = std::unordered_map<uint32_t, utils::BitVector>;
-
   // According to the SPEC the maximum size for a vector is 16.  See the data
   // rules in the universal validation rules (section 2.16.1).
   enum { kMaxVectorSize = 16 };
 
-  struct WorkListItem {
-    WorkListItem() : instruction(nullptr), components(kMaxVectorSize) {}
-
-    Instruction* instruction;
-    utils::BitVector components;
+  // The components of a vector, one bit per component, or of a scalar, as
+  // component 0.  The bits above the components hold the state of the
+  // instruction in the work list.
+  using ComponentMask = uint32_t;
+
+  enum : ComponentMask {
+    // All the components of a vector.
+    kAllComponentsLive = (1u << kMaxVectorSize) - 1,
+    // Set for the instructions whose live components are tracked.
+    kLiveComponentsKnown = 1u << kMaxVectorSize,
+    // Set while the instruction is in the work list.
+    kInWorkList = 1u << (kMaxVectorSize + 1),
   };
 
+  // The live components of the result of each instruction, indexed by result
+  // id.  The ids without kLiveComponentsKnown do not have a vector or scalar
+  // result, or are not used.  The ids of the functions are distinct, so the
+  // same map is used for all of them.
+  using LiveComponentMap = std::vector<ComponentMask>;
+
  public:
-  VectorDCE() : all_components_live_(kMaxVectorSize) {
-    for (uint32_t i = 0; i < kMaxVectorSize; i++) {
-      all_components_live_.Set(i);
-    }
-  }
+  VectorDCE() = default;
 
   const char* name() const override { return "vector-dce"; }
   Status Process() override;
@@ -54,25 +59,40 @@ class VectorDCE : public MemPass {
            IRContext::kAnalysisInstrToBlockMapping |
            IRContext::kAnalysisLoopAnalysis | IRContext::kAnalysisDecorations |
            IRContext::kAnalysisDominatorAnalysis | IRContext::kAnalysisNameMap |
-           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes;
+           IRContext::kAnalysisConstants | IRContext::kAnalysisTypes |
+           IRContext::kAnalysisReflection | IRContext::kAnalysisCallGraph;
   }
 
  private:
-  // Runs the vector dce pass on |function|.  Returns true if |function| was
+  // Runs the vector dce pass on |function|, using |live_components| to hold
+  // the live components of its instructions.  Returns true if |function| was
   // modified.
-  bool VectorDCEFunction(Function* function);
+  bool VectorDCEFunction(Function* function, LiveComponentMap* live_components);
 
   // Identifies the live components of the vectors that are results of
   // instructions in |function|.  The results are stored in |live_components|.
   void FindLiveComponents(Function* function,
                           LiveComponentMap* live_components);
 
-  // Rewrites instructions in |function| that are dead or partially dead.  If an
-  // instruction does not have an entry in |live_components|, then it is not
-  // changed.  Returns true if |function| was modified.
+  // Rewrites instructions in |function| that are dead or partially dead.  If
+  // the live components of an instruction are not known according to
+  // |live_components|, then it is not changed.  Returns true if |function| was
+  // modified.
   bool RewriteInstructions(Function* function,
                            const LiveComponentMap& live_components);
 
+  // Returns the live components of the result of |inst| according to
+  // |live_components|, and whether they are known in |known|.
+  static ComponentMask GetLiveComponents(
+      const Instruction* inst, const LiveComponentMap& live_components,
+      bool* known);
+
+  // Returns the mask of the single component |index|, or 0 if |index| is not
+  // a component of a vector, e.g. the undefined component of a shuffle.
+  static ComponentMask ComponentBit(uint32_t index) {
+    return index < kMaxVectorSize ? 1u << index : 0;
+  }
+
   // Makrs all DebugValue instructions that use |composite| for their values as
   // dead instructions by putting them into |dead_dbg_value|.
   void MarkDebugValueUsesAsDead(Instruction* composite,
@@ -88,7 +108,7 @@ class VectorDCE : public MemPass {
   // If the composite input to |current_inst| is not live, then it is replaced
   // by and OpUndef in |current_inst|.
   bool RewriteInsertInstruction(Instruction* current_inst,
-                                const utils::BitVector& live_components,
+                                ComponentMask live_components,
                                 std::vector<Instruction*>* dead_dbg_value);
 
   // Returns true if the result of |inst| is a vector or a scalar.
@@ -100,55 +120,54 @@ class VectorDCE : public MemPass {
   // Returns true if the result of |inst| is a vector.
   bool HasScalarResult(const Instruction* inst) const;
 
-  // Adds |work_item| to |work_list| if it is not already live according to
-  // |live_components|.  |live_components| is updated to indicate that
-  // |work_item| is now live.
-  void AddItemToWorkListIfNeeded(WorkListItem work_item,
+  // Adds the components |components| of the result of |inst| to the live
+  // components in |live_components|.  If any of them was not live, then |inst|
+  // is added to |work_list| unless it is already there.
+  void AddItemToWorkListIfNeeded(Instruction* inst, ComponentMask components,
                                  LiveComponentMap* live_components,
-                                 std::vector<WorkListItem>* work_list);
+                                 std::vector<Instruction*>* work_list);
 
   // Marks the components |live_elements| of the uses in |current_inst| as live
   // according to |live_components|. If they were not live before, then they are
   // added to |work_list|.
-  void MarkUsesAsLive(Instruction* current_inst,
-                      const utils::BitVector& live_elements,
+  void MarkUsesAsLive(Instruction* current_inst, ComponentMask live_elements,
                       LiveComponentMap* live_components,
-                      std::vector<WorkListItem>* work_list);
+                      std::vector<Instruction*>* work_list);
 
-  // Marks the uses in the OpVectorShuffle instruction in |current_item| as live
-  // based on the live components in |current_item|. If anything becomes live
+  // Marks the uses in the OpVectorShuffle instruction |current_inst| as live
+  // based on its live components |live_elements|. If anything becomes live
   // they are added to |work_list| and |live_components| is updated
   // accordingly.
-  void MarkVectorShuffleUsesAsLive(const WorkListItem& current_item,
-                                   VectorDCE::LiveComponentMap* live_components,
-                                   std::vector<WorkListItem>* work_list);
+  void MarkVectorShuffleUsesAsLive(const Instruction* current_inst,
+                                   ComponentMask live_elements,
+                                   LiveComponentMap* live_components,
+                                   std::vector<Instruction*>* work_list);
 
-  // Marks the uses in the OpCompositeInsert instruction in |current_item| as
-  // live based on the live components in |current_item|. If anything becomes
+  // Marks the uses in the OpCompositeInsert instruction |current_inst| as
+  // live based on its live components |live_elements|. If anything becomes
   // live they are added to |work_list| and |live_components| is updated
   // accordingly.
-  void MarkInsertUsesAsLive(const WorkListItem& current_item,
+  void MarkInsertUsesAsLive(const Instruction* current_inst,
+                            ComponentMask live_elements,
                             LiveComponentMap* live_components,
-                            std::vector<WorkListItem>* work_list);
+                            std::vector<Instruction*>* work_list);
 
   // Marks the uses in the OpCompositeExtract instruction |current_inst| as
   // live. If anything becomes live they are added to |work_list| and
   // |live_components| is updated accordingly.
   void MarkExtractUseAsLive(const Instruction* current_inst,
-                            const utils::BitVector& live_elements,
+                            ComponentMask live_elements,
                             LiveComponentMap* live_components,
-                            std::vector<WorkListItem>* work_list);
+                            std::vector<Instruction*>* work_list);
 
   // Marks the uses in the OpCompositeConstruct instruction |current_inst| as
-  // live. If anything becomes live they are added to |work_list| and
-  // |live_components| is updated accordingly.
-  void MarkCompositeContructUsesAsLive(WorkListItem work_item,
+  // live based on its live components |live_elements|. If anything becomes
+  // live they are added to |work_list| and |live_components| is updated
+  // accordingly.
+  void MarkCompositeContructUsesAsLive(const Instruction* current_inst,
+                                       ComponentMask live_elements,
                                        LiveComponentMap* live_components,
-                                       std::vector<WorkListItem>* work_list);
-
-  // A BitVector that can always be used to say that all components of a vector
-  // are live.
-  utils::BitVector all_components_live_;
+                                       std::vector<Instruction*>* work_list);
 };
 
 }  // namespace opt
@@ -23,6 +23,14 @@ namespace spvtools {
 
 void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
                         const spv_parsed_operand_t& operand) {
+  utils::TextBuffer text;
+  EmitNumericLiteral(&text, inst, operand);
+  out->write(text.data(), static_cast<std::streamsize>(text.size()));
+}
+
+void EmitNumericLiteral(utils::TextBuffer* out,
+                        const spv_parsed_instruction_t& inst,
+                        const spv_parsed_operand_t& operand) {
   if (operand.type != SPV_OPERAND_TYPE_LITERAL_INTEGER &&
       operand.type != SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER)
     return;
@@ -34,18 +42,18 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
   if (operand.num_words == 1) {
     switch (operand.number_kind) {
       case SPV_NUMBER_SIGNED_INT:
-        *out << int32_t(word);
+        out->AppendSigned(int32_t(word));
         break;
       case SPV_NUMBER_UNSIGNED_INT:
-        *out << word;
+        out->AppendUnsigned(word);
         break;
       case SPV_NUMBER_FLOATING:
         if (operand.number_bit_width == 16) {
-          *out << spvtools::utils::FloatProxy<spvtools::utils::Float16>(
-              uint16_t(word & 0xFFFF));
+          utils::AppendFloatProxy(
+              utils::FloatProxy<utils::Float16>(uint16_t(word & 0xFFFF)), out);
         } else {
           // Assume 32-bit floats.
-          *out << spvtools::utils::FloatProxy<float>(word);
+          utils::AppendFloatProxy(utils::FloatProxy<float>(word), out);
         }
         break;
       default:
@@ -57,14 +65,14 @@ void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
         uint64_t(word) | (uint64_t(inst.words[operand.offset + 1]) << 32);
     switch (operand.number_kind) {
       case SPV_NUMBER_SIGNED_INT:
-        *out << int64_t(bits);
+        out->AppendSigned(int64_t(bits));
         break;
       case SPV_NUMBER_UNSIGNED_INT:
-        *out << bits;
+        out->AppendUnsigned(bits);
         break;
       case SPV_NUMBER_FLOATING:
         // Assume only 64-bit floats.
-        *out << spvtools::utils::FloatProxy<double>(bits);
+        utils::AppendFloatProxy(utils::FloatProxy<double>(bits), out);
         break;
       default:
         break;
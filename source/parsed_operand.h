@@ -17,6 +17,7 @@
 
 #include <ostream>
 
+#include "source/util/text_buffer.h"
 #include "spirv-tools/libspirv.h"
 
 namespace spvtools {
@@ -28,6 +29,11 @@ namespace spvtools {
 void EmitNumericLiteral(std::ostream* out, const spv_parsed_instruction_t& inst,
                         const spv_parsed_operand_t& operand);
 
+// Like the above, but appends the representation to the text buffer |out|.
+void EmitNumericLiteral(utils::TextBuffer* out,
+                        const spv_parsed_instruction_t& inst,
+                        const spv_parsed_operand_t& operand);
+
 }  // namespace spvtools
 
 #endif  // SOURCE_PARSED_OPERAND_H_
@@ -26,11 +26,21 @@ std::string MergeBlocksReductionOpportunityFinder::GetName() const {
 std::vector<std::unique_ptr<ReductionOpportunity>>
 MergeBlocksReductionOpportunityFinder::GetAvailableOpportunities(
     opt::IRContext* context, uint32_t target_function) const {
+  return GetAvailableOpportunitiesInConstruct(context, target_function, 0);
+}
+
+std::vector<std::unique_ptr<ReductionOpportunity>>
+MergeBlocksReductionOpportunityFinder::GetAvailableOpportunitiesInConstruct(
+    opt::IRContext* context, uint32_t target_function,
+    uint32_t target_construct) const {
   std::vector<std::unique_ptr<ReductionOpportunity>> result;
 
   // Consider every block in every function.
   for (auto* function : GetTargetFunctions(context, target_function)) {
     for (auto& block : *function) {
+      if (!IsInTargetConstruct(context, function, block, target_construct)) {
+        continue;
+      }
       // See whether it is possible to merge this block with its successor.
       if (opt::blockmergeutil::CanMergeWithSuccessor(context, &block)) {
         // It is, so record an opportunity to do this.
@@ -33,6 +33,11 @@ class MergeBlocksReductionOpportunityFinder
   std::vector<std::unique_ptr<ReductionOpportunity>> GetAvailableOpportunities(
       opt::IRContext* context, uint32_t target_function) const final;
 
+  std::vector<std::unique_ptr<ReductionOpportunity>>
+  GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                       uint32_t target_function,
+                                       uint32_t target_construct) const final;
+
  private:
 };
 
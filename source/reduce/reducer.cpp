@@ -14,9 +14,13 @@
 
 #include "source/reduce/reducer.h"
 
+#include <algorithm>
 #include <cassert>
 #include <sstream>
+#include <thread>
+#include <unordered_map>
 
+#include "source/opt/build_module.h"
 #include "source/reduce/conditional_branch_to_simple_conditional_branch_opportunity_finder.h"
 #include "source/reduce/merge_blocks_reduction_opportunity_finder.h"
 #include "source/reduce/operand_to_const_reduction_opportunity_finder.h"
@@ -34,7 +38,8 @@
 namespace spvtools {
 namespace reduce {
 
-Reducer::Reducer(spv_target_env target_env) : target_env_(target_env) {}
+Reducer::Reducer(spv_target_env target_env)
+    : target_env_(target_env), interestingness_cache_(nullptr) {}
 
 Reducer::~Reducer() = default;
 
@@ -53,6 +58,14 @@ void Reducer::SetInterestingnessFunction(
   interestingness_function_ = std::move(interestingness_function);
 }
 
+void Reducer::SetInterestingnessCache(utils::InterestingnessCache* cache) {
+  interestingness_cache_ = cache;
+}
+
+void Reducer::SetProgressFunction(ProgressFunction progress_function) {
+  progress_function_ = std::move(progress_function);
+}
+
 Reducer::ReductionResultStatus Reducer::Run(
     std::vector<uint32_t>&& binary_in, std::vector<uint32_t>* binary_out,
     spv_const_reducer_options options,
@@ -75,20 +88,26 @@ Reducer::ReductionResultStatus Reducer::Run(
   }
 
   // Initial state should be interesting.
-  if (!interestingness_function_(current_binary, reductions_applied)) {
+  if (!IsInteresting(current_binary, reductions_applied)) {
     consumer_(SPV_MSG_INFO, nullptr, {},
               "Initial state was not interesting; stopping.");
     return Reducer::ReductionResultStatus::kInitialStateNotInteresting;
   }
 
+  // The module is parsed once; from then on it is kept alongside its binary,
+  // and each reduction step works on a copy of it.
+  std::unique_ptr<opt::IRContext> current_context = BuildModule(
+      target_env_, consumer_, current_binary.data(), current_binary.size());
+  assert(current_context && "A valid binary should be parsed successfully.");
+
   Reducer::ReductionResultStatus result =
       RunPasses(&passes_, options, validator_options, tools, &current_binary,
-                &reductions_applied);
+                &current_context, &reductions_applied);
 
   if (result == Reducer::ReductionResultStatus::kComplete) {
     // Cleanup passes.
     result = RunPasses(&cleanup_passes_, options, validator_options, tools,
-                       &current_binary, &reductions_applied);
+                       &current_binary, &current_context, &reductions_applied);
   }
 
   if (result == Reducer::ReductionResultStatus::kComplete) {
@@ -149,30 +168,125 @@ void Reducer::AddCleanupReductionPass(
       spvtools::MakeUnique<ReductionPass>(target_env_, std::move(finder)));
 }
 
+std::vector<bool> Reducer::EvaluateCandidates(
+    const std::vector<std::vector<uint32_t>>& candidates,
+    const std::vector<bool>& valid, uint32_t reductions_applied) {
+  std::vector<bool> result(candidates.size(), false);
+  if (candidates.size() == 1) {
+    result[0] =
+        valid[0] && IsInteresting(candidates[0], reductions_applied + 1);
+    return result;
+  }
+  // std::vector<bool> cannot be written to concurrently, so each worker
+  // records its verdict in a separate byte.
+  std::vector<char> verdicts(candidates.size(), 0);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (!valid[i]) {
+      continue;
+    }
+    workers.emplace_back([this, &candidates, &verdicts, i,
+                          reductions_applied]() {
+      verdicts[i] = IsInteresting(
+          candidates[i], reductions_applied + static_cast<uint32_t>(i) + 1);
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  for (size_t i = 0; i < candidates.size(); i++) {
+    result[i] = verdicts[i] != 0;
+  }
+  return result;
+}
+
+bool Reducer::IsInteresting(const std::vector<uint32_t>& binary,
+                            uint32_t counter) const {
+  if (!interestingness_cache_) {
+    return interestingness_function_(binary, counter);
+  }
+  const std::string digest = utils::InterestingnessCache::ComputeDigest(binary);
+  bool verdict;
+  if (!interestingness_cache_->Lookup(digest, &verdict)) {
+    verdict = interestingness_function_(binary, counter);
+    interestingness_cache_->Insert(digest, verdict);
+  }
+  return verdict;
+}
+
 bool Reducer::ReachedStepLimit(uint32_t current_step,
                                spv_const_reducer_options options) {
   return current_step >= options->step_limit;
 }
 
+bool Reducer::IsCancelled(spv_const_reducer_options options) {
+  return options->cancel && options->cancel(options->cancel_data);
+}
+
 Reducer::ReductionResultStatus Reducer::RunPasses(
     std::vector<std::unique_ptr<ReductionPass>>* passes,
     spv_const_reducer_options options, spv_validator_options validator_options,
     const SpirvTools& tools, std::vector<uint32_t>* current_binary,
+    std::unique_ptr<opt::IRContext>* current_context,
     uint32_t* const reductions_applied) {
   // Determines whether, on completing one round of reduction passes, it is
   // worthwhile trying a further round.
   bool another_round_worthwhile = true;
 
+  // The number of reduction steps that have succeeded so far; the module is
+  // unchanged for as long as this count is.
+  uint32_t num_successful_steps = 0;
+
+  // Maps each pass that last swept the whole module at its minimum granularity
+  // without success to the value of |num_successful_steps| at that time.  Such
+  // a pass is certain to fail again until the module changes, so it is skipped.
+  std::unordered_map<const ReductionPass*, uint32_t> pass_exhausted_at;
+
+  // Targeting a construct implicitly targets the function that contains it.
+  uint32_t target_function = options->target_function;
+  if (!target_function && options->target_construct) {
+    opt::Instruction* header_label =
+        (*current_context)->get_def_use_mgr()->GetDef(
+            options->target_construct);
+    if (header_label && header_label->opcode() == SpvOpLabel) {
+      target_function = (*current_context)
+                            ->get_instr_block(header_label)
+                            ->GetParent()
+                            ->result_id();
+    }
+  }
+
+  // Whether the reduction step limit has been reached, or the reduction has
+  // been cancelled.
+  bool cancelled = false;
+  auto must_stop = [reductions_applied, options, &cancelled]() {
+    cancelled = cancelled || IsCancelled(options);
+    return cancelled || ReachedStepLimit(*reductions_applied, options);
+  };
+
   // Apply round after round of reduction passes until we hit the reduction
-  // step limit, or deem that another round is not going to be worthwhile.
-  while (!ReachedStepLimit(*reductions_applied, options) &&
-         another_round_worthwhile) {
+  // step limit, are cancelled, or deem that another round is not going to be
+  // worthwhile.
+  while (!must_stop() && another_round_worthwhile) {
     // At the start of a round of reduction passes, assume another round will
     // not be worthwhile unless we find evidence to the contrary.
     another_round_worthwhile = false;
 
     // Iterate through the available passes.
     for (auto& pass : *passes) {
+      if (cancelled) break;
+      auto exhausted = pass_exhausted_at.find(pass.get());
+      if (exhausted != pass_exhausted_at.end() &&
+          exhausted->second == num_successful_steps) {
+        consumer_(SPV_MSG_INFO, nullptr, {},
+                  ("Skipping pass " + pass->GetName() +
+                   ": the module has not changed since it last failed.")
+                      .c_str());
+        continue;
+      }
+      const bool at_minimum_granularity = pass->ReachedMinimumGranularity();
+      bool pass_succeeded = false;
+
       // If this pass hasn't reached its minimum granularity then it's
       // worth eventually doing another round of reductions, in order to
       // try this pass at a finer granularity.
@@ -183,53 +297,86 @@ Reducer::ReductionResultStatus Reducer::RunPasses(
       consumer_(SPV_MSG_INFO, nullptr, {},
                 ("Trying pass " + pass->GetName() + ".").c_str());
       do {
-        auto maybe_result =
-            pass->TryApplyReduction(*current_binary, options->target_function);
-        if (maybe_result.empty()) {
+        // Speculatively produce several reduction steps at once, so that
+        // their interestingness can be evaluated concurrently.  The steps are
+        // then considered in order, exactly as if they had been produced one
+        // at a time, so that the outcome does not depend on |num_jobs|.
+        std::vector<std::unique_ptr<opt::IRContext>> candidate_contexts;
+        auto candidates = pass->TryApplyReductions(
+            **current_context, target_function, options->target_construct,
+            std::min(options->num_jobs,
+                     options->step_limit - *reductions_applied),
+            &candidate_contexts);
+        if (candidates.empty()) {
           // For this round, the pass has no more opportunities (chunks) to
           // apply, so move on to the next pass.
           consumer_(
               SPV_MSG_INFO, nullptr, {},
               ("Pass " + pass->GetName() + " did not make a reduction step.")
                   .c_str());
+          if (at_minimum_granularity && !pass_succeeded) {
+            pass_exhausted_at[pass.get()] = num_successful_steps;
+          }
           break;
         }
-        bool interesting = false;
-        std::stringstream stringstream;
-        (*reductions_applied)++;
-        stringstream << "Pass " << pass->GetName() << " made reduction step "
-                     << *reductions_applied << ".";
-        consumer_(SPV_MSG_INFO, nullptr, {}, (stringstream.str().c_str()));
-        if (!tools.Validate(&maybe_result[0], maybe_result.size(),
-                            validator_options)) {
-          // The reduction step went wrong and an invalid binary was produced.
-          // By design, this shouldn't happen; this is a safeguard to stop an
-          // invalid binary from being regarded as interesting.
-          consumer_(SPV_MSG_INFO, nullptr, {},
-                    "Reduction step produced an invalid binary.");
-          if (options->fail_on_validation_error) {
-            // In this mode, we fail, so we update the current binary so it is
-            // output for debugging.
-            *current_binary = std::move(maybe_result);
-            return Reducer::ReductionResultStatus::kStateInvalid;
+        std::vector<bool> valid;
+        for (auto& candidate : candidates) {
+          valid.push_back(tools.Validate(&candidate[0], candidate.size(),
+                                         validator_options));
+        }
+        std::vector<bool> interesting =
+            EvaluateCandidates(candidates, valid, *reductions_applied);
+        for (size_t i = 0; i < candidates.size(); i++) {
+          std::stringstream stringstream;
+          (*reductions_applied)++;
+          stringstream << "Pass " << pass->GetName() << " made reduction step "
+                       << *reductions_applied << ".";
+          consumer_(SPV_MSG_INFO, nullptr, {}, (stringstream.str().c_str()));
+          if (!valid[i]) {
+            // The reduction step went wrong and an invalid binary was
+            // produced. By design, this shouldn't happen; this is a safeguard
+            // to stop an invalid binary from being regarded as interesting.
+            consumer_(SPV_MSG_INFO, nullptr, {},
+                      "Reduction step produced an invalid binary.");
+            if (options->fail_on_validation_error) {
+              // In this mode, we fail, so we update the current binary so it
+              // is output for debugging.
+              *current_binary = std::move(candidates[i]);
+              return Reducer::ReductionResultStatus::kStateInvalid;
+            }
+          } else if (interesting[i]) {
+            // Success!  The binary produced by this reduction step is
+            // interesting, so make it the binary of interest henceforth, and
+            // note that it's worth doing another round of reduction passes.
+            // The remaining candidates were derived from the old binary, so
+            // they are discarded.
+            consumer_(SPV_MSG_INFO, nullptr, {}, "Reduction step succeeded.");
+            *current_binary = std::move(candidates[i]);
+            *current_context = std::move(candidate_contexts[i]);
+            if (progress_function_) {
+              progress_function_(*current_binary, *reductions_applied);
+            }
+            another_round_worthwhile = true;
+            num_successful_steps++;
+            pass_succeeded = true;
+          }
+          // We must call this before the next call to TryApplyReductions.
+          pass->NotifyInteresting(valid[i] && interesting[i]);
+          if (valid[i] && interesting[i]) {
+            break;
           }
-        } else if (interestingness_function_(maybe_result,
-                                             *reductions_applied)) {
-          // Success!  The binary produced by this reduction step is
-          // interesting, so make it the binary of interest henceforth, and
-          // note that it's worth doing another round of reduction passes.
-          consumer_(SPV_MSG_INFO, nullptr, {}, "Reduction step succeeded.");
-          *current_binary = std::move(maybe_result);
-          interesting = true;
-          another_round_worthwhile = true;
         }
-        // We must call this before the next call to TryApplyReduction.
-        pass->NotifyInteresting(interesting);
-        // Bail out if the reduction step limit has been reached.
-      } while (!ReachedStepLimit(*reductions_applied, options));
+        // Bail out if the reduction step limit has been reached, or the
+        // reduction has been cancelled.
+      } while (!must_stop());
     }
   }
 
+  if (cancelled) {
+    consumer_(SPV_MSG_INFO, nullptr, {}, "Reduction was cancelled; stopping.");
+    return Reducer::ReductionResultStatus::kCancelled;
+  }
+
   // Report whether reduction completed, or bailed out early due to reaching
   // the step limit.
   if (ReachedStepLimit(*reductions_applied, options)) {
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "source/reduce/reduction_pass.h"
+#include "source/util/interestingness_cache.h"
 #include "spirv-tools/libspirv.hpp"
 
 namespace spvtools {
@@ -38,6 +39,10 @@ class Reducer {
     // Returned when the fail-on-validation-error option is set and a
     // reduction step yields a state that fails validation.
     kStateInvalid,
+
+    // Returned when the cancellation function of the options stopped the
+    // reduction.  The output is the smallest interesting binary found.
+    kCancelled,
   };
 
   // The type for a function that will take a binary and return true if and
@@ -47,9 +52,20 @@ class Reducer {
   //
   // The notion of "interesting" depends on what properties of the binary or
   // tools that process the binary we are trying to maintain during reduction.
+  //
+  // If the reducer options ask for more than one job, the function is invoked
+  // from several threads at once and must be thread-safe.
   using InterestingnessFunction =
       std::function<bool(const std::vector<uint32_t>&, uint32_t)>;
 
+  // The type for a function that is told about each binary that becomes the
+  // best (smallest interesting) binary found so far, together with the number
+  // of reduction steps applied when it was found.  It is invoked on the
+  // thread that called Run, and should return quickly, e.g. by handing the
+  // binary to another thread if it is to be written out.
+  using ProgressFunction =
+      std::function<void(const std::vector<uint32_t>&, uint32_t)>;
+
   // Constructs an instance with the given target |target_env|, which is used to
   // decode the binary to be reduced later.
   //
@@ -79,6 +95,19 @@ class Reducer {
   void SetInterestingnessFunction(
       InterestingnessFunction interestingness_function);
 
+  // Sets a cache of interestingness verdicts, consulted before the
+  // interestingness function is invoked and updated with its results.  The
+  // cache is not owned, must outlive any call to Run, and may be shared with
+  // other reducers.  A null |cache|, the default, disables caching.
+  //
+  // Caching is only appropriate when the interestingness function gives the
+  // same verdict whenever it is invoked on the same binary.
+  void SetInterestingnessCache(utils::InterestingnessCache* cache);
+
+  // Sets the function that is told about each new best binary as reduction
+  // proceeds.  By default nothing is told.
+  void SetProgressFunction(ProgressFunction progress_function);
+
   // Adds all default reduction passes.
   void AddDefaultReductionPasses();
 
@@ -100,18 +129,39 @@ class Reducer {
                             spv_validator_options validator_options);
 
  private:
+  // Evaluates the interestingness function on each of the |candidates| that
+  // is |valid|, concurrently if there are several, and returns the verdicts.
+  // The i-th candidate is presented as reduction step
+  // |reductions_applied| + i + 1.
+  std::vector<bool> EvaluateCandidates(
+      const std::vector<std::vector<uint32_t>>& candidates,
+      const std::vector<bool>& valid, uint32_t reductions_applied);
+
+  // Returns the verdict of the interestingness function on |binary|, which is
+  // presented with |counter|, unless the verdict is already cached.
+  bool IsInteresting(const std::vector<uint32_t>& binary,
+                     uint32_t counter) const;
+
   static bool ReachedStepLimit(uint32_t current_step,
                                spv_const_reducer_options options);
 
+  // Returns true if the cancellation function of |options| says that the
+  // reduction should stop.
+  static bool IsCancelled(spv_const_reducer_options options);
+
   ReductionResultStatus RunPasses(
       std::vector<std::unique_ptr<ReductionPass>>* passes,
       spv_const_reducer_options options,
       spv_validator_options validator_options, const SpirvTools& tools,
-      std::vector<uint32_t>* current_binary, uint32_t* reductions_applied);
+      std::vector<uint32_t>* current_binary,
+      std::unique_ptr<opt::IRContext>* current_context,
+      uint32_t* reductions_applied);
 
   const spv_target_env target_env_;
   MessageConsumer consumer_;
   InterestingnessFunction interestingness_function_;
+  utils::InterestingnessCache* interestingness_cache_;
+  ProgressFunction progress_function_;
   std::vector<std::unique_ptr<ReductionPass>> passes_;
   std::vector<std::unique_ptr<ReductionPass>> cleanup_passes_;
 };
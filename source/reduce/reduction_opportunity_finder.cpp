@@ -30,5 +30,56 @@ std::vector<opt::Function*> ReductionOpportunityFinder::GetTargetFunctions(
   return result;
 }
 
+std::vector<std::unique_ptr<ReductionOpportunity>>
+ReductionOpportunityFinder::GetAvailableOpportunitiesInConstruct(
+    opt::IRContext* context, uint32_t target_function,
+    uint32_t /*unused*/) const {
+  return GetAvailableOpportunities(context, target_function);
+}
+
+bool ReductionOpportunityFinder::IsInTargetConstruct(
+    opt::IRContext* ir_context, opt::Function* function,
+    const opt::BasicBlock& block, uint32_t target_construct) {
+  if (!target_construct || block.id() == target_construct) {
+    return true;
+  }
+  if (ir_context->GetDominatorAnalysis(function)->IsReachable(&block)) {
+    // Walk outwards through the constructs enclosing the block.
+    auto* analysis = ir_context->GetStructuredCFGAnalysis();
+    for (uint32_t header = analysis->ContainingConstruct(block.id());
+         header != 0; header = analysis->ContainingConstruct(header)) {
+      if (header == target_construct) {
+        return true;
+      }
+    }
+    return false;
+  }
+  // Earlier reduction steps may have removed the header altogether.
+  auto* header_label =
+      ir_context->get_def_use_mgr()->GetDef(target_construct);
+  if (!header_label || header_label->opcode() != SpvOpLabel) {
+    return false;
+  }
+  auto* header = ir_context->get_instr_block(header_label);
+  if (!header || header->GetParent() != function) {
+    return false;
+  }
+  uint32_t merge_block_id = header->MergeBlockIdIfAny();
+  if (!merge_block_id) {
+    return false;
+  }
+  bool after_header = false;
+  for (auto& candidate : *function) {
+    if (candidate.id() == target_construct) {
+      after_header = true;
+    } else if (candidate.id() == merge_block_id) {
+      return false;
+    } else if (&candidate == &block) {
+      return after_header;
+    }
+  }
+  return false;
+}
+
 }  // namespace reduce
 }  // namespace spvtools
@@ -40,6 +40,17 @@ class ReductionOpportunityFinder {
   GetAvailableOpportunities(opt::IRContext* context,
                             uint32_t target_function) const = 0;
 
+  // As GetAvailableOpportunities, except that if |target_construct| is
+  // non-zero then, for finders able to do so, the opportunities are further
+  // restricted to those that modify blocks of the structured construct headed
+  // by the block with id |target_construct|, which must belong to
+  // |target_function| if it exists at all.  The default implementation ignores
+  // |target_construct|.
+  virtual std::vector<std::unique_ptr<ReductionOpportunity>>
+  GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                       uint32_t target_function,
+                                       uint32_t target_construct) const;
+
   // Provides a name for the finder.
   virtual std::string GetName() const = 0;
 
@@ -50,6 +61,17 @@ class ReductionOpportunityFinder {
   // This allows fuzzer passes to restrict attention to a single function.
   static std::vector<opt::Function*> GetTargetFunctions(
       opt::IRContext* ir_context, uint32_t target_function);
+
+  // Returns true if |target_construct| is zero, or if |block|, a block of
+  // |function|, is the block with id |target_construct| or is contained in the
+  // structured construct that this block heads, according to the structured
+  // CFG analysis.  An unreachable block, of which the analysis knows nothing,
+  // is regarded as contained in the construct if it appears after the header
+  // and before the construct's merge block in the layout of |function|.
+  static bool IsInTargetConstruct(opt::IRContext* ir_context,
+                                  opt::Function* function,
+                                  const opt::BasicBlock& block,
+                                  uint32_t target_construct);
 };
 
 }  // namespace reduce
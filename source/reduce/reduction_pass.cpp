@@ -32,9 +32,15 @@ std::vector<uint32_t> ReductionPass::TryApplyReduction(
   std::unique_ptr<opt::IRContext> context =
       BuildModule(target_env_, consumer_, binary.data(), binary.size());
   assert(context);
+  return TryApplyReduction(context.get(), target_function, 0);
+}
 
+std::vector<uint32_t> ReductionPass::TryApplyReduction(
+    opt::IRContext* context, uint32_t target_function,
+    uint32_t target_construct) {
   std::vector<std::unique_ptr<ReductionOpportunity>> opportunities =
-      finder_->GetAvailableOpportunities(context.get(), target_function);
+      finder_->GetAvailableOpportunitiesInConstruct(context, target_function,
+                                                    target_construct);
 
   // There is no point in having a granularity larger than the number of
   // opportunities, so reduce the granularity in this case.
@@ -65,6 +71,58 @@ std::vector<uint32_t> ReductionPass::TryApplyReduction(
   return result;
 }
 
+std::vector<std::vector<uint32_t>> ReductionPass::TryApplyReductions(
+    const std::vector<uint32_t>& binary, uint32_t target_function,
+    uint32_t max_candidates) {
+  // The binary is parsed once; each candidate is applied to a copy.
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(target_env_, consumer_, binary.data(), binary.size());
+  assert(context);
+  return TryApplyReductions(*context, target_function, 0, max_candidates,
+                            nullptr);
+}
+
+std::vector<std::vector<uint32_t>> ReductionPass::TryApplyReductions(
+    const opt::IRContext& context, uint32_t target_function,
+    uint32_t target_construct, uint32_t max_candidates,
+    std::vector<std::unique_ptr<opt::IRContext>>* candidate_contexts) {
+  std::vector<std::vector<uint32_t>> result;
+  const uint32_t initial_index = index_;
+  const uint32_t initial_consecutive_successes = consecutive_successes_;
+  while (result.size() < max_candidates) {
+    const uint32_t index = index_;
+    const uint32_t granularity = granularity_;
+    auto candidate_context = context.Clone();
+    auto candidate = TryApplyReduction(candidate_context.get(),
+                                       target_function, target_construct);
+    if (candidate.empty()) {
+      if (!result.empty()) {
+        // Only the caller can decide whether the round has really ended: one
+        // of the candidates already produced may turn out to be interesting.
+        index_ = index;
+        granularity_ = granularity;
+      }
+      break;
+    }
+    result.push_back(std::move(candidate));
+    if (candidate_contexts) {
+      // Drop any analyses built while applying the chunk, so that the module
+      // is in the same state as if it had been parsed from |candidate|.
+      candidate_context->InvalidateAnalysesExceptFor(
+          opt::IRContext::kAnalysisNone);
+      candidate_contexts->push_back(std::move(candidate_context));
+    }
+    // Speculate that the candidate will turn out to be uninteresting.
+    NotifyInteresting(false);
+  }
+  if (!result.empty()) {
+    // The caller replays the speculation through NotifyInteresting.
+    index_ = initial_index;
+    consecutive_successes_ = initial_consecutive_successes;
+  }
+  return result;
+}
+
 void ReductionPass::SetMessageConsumer(MessageConsumer consumer) {
   consumer_ = std::move(consumer);
 }
@@ -79,6 +137,16 @@ std::string ReductionPass::GetName() const { return finder_->GetName(); }
 void ReductionPass::NotifyInteresting(bool interesting) {
   if (!interesting) {
     index_ += granularity_;
+    consecutive_successes_ = 0;
+    return;
+  }
+  if (++consecutive_successes_ == kSuccessesBeforeGrowing) {
+    // The granularity is brought back down to the number of opportunities the
+    // next time they are computed, if it grows too large.
+    granularity_ = granularity_ > std::numeric_limits<uint32_t>::max() / 2
+                       ? std::numeric_limits<uint32_t>::max()
+                       : granularity_ * 2;
+    consecutive_successes_ = 0;
   }
 }
 
@@ -30,7 +30,9 @@ namespace reduce {
 // large chunks of reduction opportunities, iterating through available
 // opportunities at a given granularity.  When an iteration over available
 // opportunities completes, the granularity is reduced and iteration starts
-// again, until the minimum granularity is reached.
+// again, until the minimum granularity is reached.  After a run of successful
+// chunks the granularity is doubled again, since large chunks then seem likely
+// to succeed and each one saves many evaluations of interestingness.
 class ReductionPass {
  public:
   // Constructs a reduction pass with a given target environment, |target_env|,
@@ -40,7 +42,8 @@ class ReductionPass {
       : target_env_(target_env),
         finder_(std::move(finder)),
         index_(0),
-        granularity_(std::numeric_limits<uint32_t>::max()) {}
+        granularity_(std::numeric_limits<uint32_t>::max()),
+        consecutive_successes_(0) {}
 
   // Applies the reduction pass to the given binary by applying a "chunk" of
   // reduction opportunities. Returns the new binary if a chunk was applied; in
@@ -56,9 +59,38 @@ class ReductionPass {
   std::vector<uint32_t> TryApplyReduction(const std::vector<uint32_t>& binary,
                                           uint32_t target_function);
 
+  // Speculative variant of TryApplyReduction: returns up to |max_candidates|
+  // binaries, where the i-th binary is the one that TryApplyReduction would
+  // return if the binaries preceding it all turned out to be uninteresting.
+  // Before the next call the caller must invoke NotifyInteresting(false) for
+  // each candidate that precedes the first interesting one, followed by
+  // NotifyInteresting(true) for that candidate, if any.  Candidates following
+  // the first interesting one must be discarded.  Returns an empty vector if
+  // there are no more chunks left to apply, exactly as TryApplyReduction does.
+  std::vector<std::vector<uint32_t>> TryApplyReductions(
+      const std::vector<uint32_t>& binary, uint32_t target_function,
+      uint32_t max_candidates);
+
+  // As above, but applies the chunks to copies of |context|, which holds the
+  // module to be reduced, so that the module does not need to be parsed.  If
+  // |candidate_contexts| is not null, the module of each candidate is appended
+  // to it, so that the caller can carry on from the interesting candidate
+  // without parsing its binary either.
+  //
+  // If |target_construct| is non-zero, opportunities are further restricted to
+  // the structured construct headed by the block with id |target_construct|,
+  // to the extent that the pass's finder supports this; see
+  // ReductionOpportunityFinder::GetAvailableOpportunitiesInConstruct.
+  std::vector<std::vector<uint32_t>> TryApplyReductions(
+      const opt::IRContext& context, uint32_t target_function,
+      uint32_t target_construct, uint32_t max_candidates,
+      std::vector<std::unique_ptr<opt::IRContext>>* candidate_contexts);
+
   // Notifies the reduction pass whether the binary returned from
   // TryApplyReduction is interesting, so that the next call to
   // TryApplyReduction will avoid applying the same chunk of opportunities.
+  // After |kSuccessesBeforeGrowing| interesting results in a row, the
+  // granularity is doubled.
   void NotifyInteresting(bool interesting);
 
   // Sets a consumer to which relevant messages will be directed.
@@ -73,11 +105,22 @@ class ReductionPass {
   std::string GetName() const;
 
  private:
+  // Like the public TryApplyReduction, but applies the chunk to |context|,
+  // which holds the module to be reduced and is modified in place.
+  std::vector<uint32_t> TryApplyReduction(opt::IRContext* context,
+                                          uint32_t target_function,
+                                          uint32_t target_construct);
+
+  // The number of interesting chunks in a row after which the granularity is
+  // doubled.
+  static const uint32_t kSuccessesBeforeGrowing = 2;
+
   const spv_target_env target_env_;
   const std::unique_ptr<ReductionOpportunityFinder> finder_;
   MessageConsumer consumer_;
   uint32_t index_;
   uint32_t granularity_;
+  uint32_t consecutive_successes_;
 };
 
 }  // namespace reduce
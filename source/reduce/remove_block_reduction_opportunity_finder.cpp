@@ -26,12 +26,20 @@ std::string RemoveBlockReductionOpportunityFinder::GetName() const {
 std::vector<std::unique_ptr<ReductionOpportunity>>
 RemoveBlockReductionOpportunityFinder::GetAvailableOpportunities(
     opt::IRContext* context, uint32_t target_function) const {
+  return GetAvailableOpportunitiesInConstruct(context, target_function, 0);
+}
+
+std::vector<std::unique_ptr<ReductionOpportunity>>
+RemoveBlockReductionOpportunityFinder::GetAvailableOpportunitiesInConstruct(
+    opt::IRContext* context, uint32_t target_function,
+    uint32_t target_construct) const {
   std::vector<std::unique_ptr<ReductionOpportunity>> result;
 
   // Consider every block in every relevant function.
   for (auto* function : GetTargetFunctions(context, target_function)) {
     for (auto bi = function->begin(); bi != function->end(); ++bi) {
-      if (IsBlockValidOpportunity(context, function, &bi)) {
+      if (IsInTargetConstruct(context, function, *bi, target_construct) &&
+          IsBlockValidOpportunity(context, function, &bi)) {
         result.push_back(
             MakeUnique<RemoveBlockReductionOpportunity>(function, &*bi));
       }
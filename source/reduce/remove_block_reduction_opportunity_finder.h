@@ -36,6 +36,11 @@ class RemoveBlockReductionOpportunityFinder
   std::vector<std::unique_ptr<ReductionOpportunity>> GetAvailableOpportunities(
       opt::IRContext* context, uint32_t target_function) const final;
 
+  std::vector<std::unique_ptr<ReductionOpportunity>>
+  GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                       uint32_t target_function,
+                                       uint32_t target_construct) const final;
+
  private:
   // Returns true if the block |bi| in function |function| is a valid
   // opportunity according to various restrictions.
@@ -31,6 +31,13 @@ std::string RemoveSelectionReductionOpportunityFinder::GetName() const {
 std::vector<std::unique_ptr<ReductionOpportunity>>
 RemoveSelectionReductionOpportunityFinder::GetAvailableOpportunities(
     opt::IRContext* context, uint32_t target_function) const {
+  return GetAvailableOpportunitiesInConstruct(context, target_function, 0);
+}
+
+std::vector<std::unique_ptr<ReductionOpportunity>>
+RemoveSelectionReductionOpportunityFinder::GetAvailableOpportunitiesInConstruct(
+    opt::IRContext* context, uint32_t target_function,
+    uint32_t target_construct) const {
   // Get all loop merge and continue blocks so we can check for these later.
   std::unordered_set<uint32_t> merge_and_continue_blocks_from_loops;
   for (auto* function : GetTargetFunctions(context, target_function)) {
@@ -54,7 +61,9 @@ RemoveSelectionReductionOpportunityFinder::GetAvailableOpportunities(
   for (auto& function : *context->module()) {
     for (auto& block : function) {
       if (auto merge_instruction = block.GetMergeInst()) {
-        if (merge_instruction->opcode() == SpvOpSelectionMerge) {
+        if (merge_instruction->opcode() == SpvOpSelectionMerge &&
+            IsInTargetConstruct(context, &function, block,
+                                target_construct)) {
           if (CanOpSelectionMergeBeRemoved(
                   context, block, merge_instruction,
                   merge_and_continue_blocks_from_loops)) {
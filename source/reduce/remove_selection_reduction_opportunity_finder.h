@@ -35,6 +35,11 @@ class RemoveSelectionReductionOpportunityFinder
   std::vector<std::unique_ptr<ReductionOpportunity>> GetAvailableOpportunities(
       opt::IRContext* context, uint32_t target_function) const final;
 
+  std::vector<std::unique_ptr<ReductionOpportunity>>
+  GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                       uint32_t target_function,
+                                       uint32_t target_construct) const final;
+
   // Returns true if the OpSelectionMerge instruction |merge_instruction| in
   // block |header_block| can be removed.
   static bool CanOpSelectionMergeBeRemoved(
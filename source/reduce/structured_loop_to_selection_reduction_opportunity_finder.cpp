@@ -27,6 +27,14 @@ const uint32_t kContinueNodeIndex = 1;
 std::vector<std::unique_ptr<ReductionOpportunity>>
 StructuredLoopToSelectionReductionOpportunityFinder::GetAvailableOpportunities(
     opt::IRContext* context, uint32_t target_function) const {
+  return GetAvailableOpportunitiesInConstruct(context, target_function, 0);
+}
+
+std::vector<std::unique_ptr<ReductionOpportunity>>
+StructuredLoopToSelectionReductionOpportunityFinder::
+    GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                         uint32_t target_function,
+                                         uint32_t target_construct) const {
   std::vector<std::unique_ptr<ReductionOpportunity>> result;
 
   std::set<uint32_t> merge_block_ids;
@@ -48,6 +56,10 @@ StructuredLoopToSelectionReductionOpportunityFinder::GetAvailableOpportunities(
         continue;
       }
 
+      if (!IsInTargetConstruct(context, function, block, target_construct)) {
+        continue;
+      }
+
       uint32_t continue_block_id =
           loop_merge_inst->GetSingleWordOperand(kContinueNodeIndex);
 
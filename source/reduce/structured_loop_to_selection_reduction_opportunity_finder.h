@@ -48,6 +48,11 @@ class StructuredLoopToSelectionReductionOpportunityFinder
   std::vector<std::unique_ptr<ReductionOpportunity>> GetAvailableOpportunities(
       opt::IRContext* context, uint32_t target_function) const final;
 
+  std::vector<std::unique_ptr<ReductionOpportunity>>
+  GetAvailableOpportunitiesInConstruct(opt::IRContext* context,
+                                       uint32_t target_function,
+                                       uint32_t target_construct) const final;
+
  private:
 };
 
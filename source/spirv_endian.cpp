@@ -41,6 +41,20 @@ uint32_t spvFixWord(const uint32_t word, const spv_endianness_t endian) {
   return word;
 }
 
+void spvFixWords(const uint32_t* words, size_t num_words,
+                 const spv_endianness_t endian, uint32_t* result) {
+  if (spvIsHostEndian(endian)) {
+    if (words != result) memmove(result, words, num_words * sizeof(uint32_t));
+    return;
+  }
+  // A simple loop that compilers recognize as a byte swap, and vectorize.
+  for (size_t i = 0; i < num_words; ++i) {
+    const uint32_t word = words[i];
+    result[i] = (word & 0x000000ff) << 24 | (word & 0x0000ff00) << 8 |
+                (word & 0x00ff0000) >> 8 | (word & 0xff000000) >> 24;
+  }
+}
+
 uint64_t spvFixDoubleWord(const uint32_t low, const uint32_t high,
                           const spv_endianness_t endian) {
   return (uint64_t(spvFixWord(high, endian)) << 32) | spvFixWord(low, endian);
@@ -20,6 +20,12 @@
 // Converts a word in the specified endianness to the host native endianness.
 uint32_t spvFixWord(const uint32_t word, const spv_endianness_t endianness);
 
+// Converts the |num_words| words at |words|, in the specified endianness, to
+// the host native endianness, and writes them to |result|.  |result| may be
+// the same as |words|.
+void spvFixWords(const uint32_t* words, size_t num_words,
+                 const spv_endianness_t endianness, uint32_t* result);
+
 // Converts a pair of words in the specified endianness to the host native
 // endianness.
 uint64_t spvFixDoubleWord(const uint32_t low, const uint32_t high,
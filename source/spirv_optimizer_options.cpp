@@ -49,3 +49,14 @@ SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetPreserveSpecConstants(
     spv_optimizer_options options, bool val) {
   options->preserve_spec_constants_ = val;
 }
+
+SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetUseInstructionArena(
+    spv_optimizer_options options, bool val) {
+  options->use_instruction_arena_ = val;
+}
+
+SPIRV_TOOLS_EXPORT void spvOptimizerOptionsSetCancel(
+    spv_optimizer_options options, spv_cancel_fn cancel, void* user_data) {
+  options->cancel_ = cancel;
+  options->cancel_data_ = user_data;
+}
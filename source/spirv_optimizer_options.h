@@ -26,7 +26,10 @@ struct spv_optimizer_options_t {
         val_options_(),
         max_id_bound_(kDefaultMaxIdBound),
         preserve_bindings_(false),
-        preserve_spec_constants_(false) {}
+        preserve_spec_constants_(false),
+        use_instruction_arena_(false),
+        cancel_(nullptr),
+        cancel_data_(nullptr) {}
 
   // When true the validator will be run before optimizations are run.
   bool run_validator_;
@@ -45,5 +48,14 @@ struct spv_optimizer_options_t {
   // When true, all specialization constants within the module should be
   // preserved.
   bool preserve_spec_constants_;
+
+  // When true, the instructions of the module are allocated from an arena
+  // owned by the IR context.
+  bool use_instruction_arena_;
+
+  // The function that says whether the optimization should stop, and the
+  // data it is given.
+  spv_cancel_fn cancel_;
+  void* cancel_data_;
 };
 #endif  // SOURCE_SPIRV_OPTIMIZER_OPTIONS_H_
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -25,7 +26,11 @@ const uint32_t kDefaultStepLimit = 2500;
 spv_reducer_options_t::spv_reducer_options_t()
     : step_limit(kDefaultStepLimit),
       fail_on_validation_error(false),
-      target_function(0) {}
+      target_function(0),
+      target_construct(0),
+      num_jobs(1),
+      cancel(nullptr),
+      cancel_data(nullptr) {}
 
 SPIRV_TOOLS_EXPORT spv_reducer_options spvReducerOptionsCreate() {
   return new spv_reducer_options_t();
@@ -49,3 +54,20 @@ SPIRV_TOOLS_EXPORT void spvReducerOptionsSetTargetFunction(
     spv_reducer_options options, uint32_t target_function) {
   options->target_function = target_function;
 }
+
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetTargetConstruct(
+    spv_reducer_options options, uint32_t target_construct) {
+  options->target_construct = target_construct;
+}
+
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetNumJobs(spv_reducer_options options,
+                                                    uint32_t num_jobs) {
+  options->num_jobs = std::max(num_jobs, 1u);
+}
+
+SPIRV_TOOLS_EXPORT void spvReducerOptionsSetCancel(spv_reducer_options options,
+                                                   spv_cancel_fn cancel,
+                                                   void* user_data) {
+  options->cancel = cancel;
+  options->cancel_data = user_data;
+}
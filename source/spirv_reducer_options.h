@@ -33,6 +33,16 @@ struct spv_reducer_options_t {
 
   // See spvReducerOptionsSetTargetFunction.
   uint32_t target_function;
+
+  // See spvReducerOptionsSetTargetConstruct.
+  uint32_t target_construct;
+
+  // See spvReducerOptionsSetNumJobs.
+  uint32_t num_jobs;
+
+  // See spvReducerOptionsSetCancel.
+  spv_cancel_fn cancel;
+  void* cancel_data;
 };
 
 #endif  // SOURCE_SPIRV_REDUCER_OPTIONS_H_
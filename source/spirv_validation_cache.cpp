@@ -0,0 +1,181 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/spirv_validation_cache.h"
+
+#include <cassert>
+
+#include "source/spirv_validator_options.h"
+#include "source/util/text_buffer.h"
+
+namespace {
+
+// Computes two independent 64-bit hashes of a sequence of words.
+class KeyHasher {
+ public:
+  KeyHasher() : first_(0xcbf29ce484222325ull), second_(0x27d4eb2f165667c5ull) {}
+
+  // Adds |word| to the hashed sequence.
+  void Add(uint32_t word) {
+    first_ = (first_ ^ word) * 0x100000001b3ull;
+    second_ = Rotate(second_ ^ (word * 0xc2b2ae3d27d4eb4full)) *
+              0x9e3779b97f4a7c15ull;
+  }
+
+  // Returns the hexadecimal form of the two hashes.
+  std::string Digest() const {
+    spvtools::utils::TextBuffer digest;
+    digest.AppendHex(Finalize(first_), 16);
+    digest.AppendHex(Finalize(second_), 16);
+    return digest.str();
+  }
+
+ private:
+  static uint64_t Rotate(uint64_t value) {
+    return (value << 31) | (value >> 33);
+  }
+
+  // Mixes the bits of |value| so that every bit of the hash depends on every
+  // word of the sequence.
+  static uint64_t Finalize(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+  }
+
+  uint64_t first_;
+  uint64_t second_;
+};
+
+}  // namespace
+
+spv_validation_cache_t::spv_validation_cache_t(size_t capacity)
+    : capacity_(capacity),
+      backend_data_(nullptr),
+      backend_lookup_(nullptr),
+      backend_store_(nullptr) {}
+
+std::string spv_validation_cache_t::Key(spv_target_env env,
+                                        spv_const_validator_options options,
+                                        const uint32_t* words,
+                                        size_t num_words) {
+  assert(options && "Validator options object may not be Null");
+  KeyHasher hasher;
+  // Every option that changes the result of the validation must be hashed.
+  // The number of threads and the cache itself do not change it.
+  hasher.Add(static_cast<uint32_t>(env));
+  const validator_universal_limits_t& limits = options->universal_limits_;
+  hasher.Add(limits.max_struct_members);
+  hasher.Add(limits.max_struct_depth);
+  hasher.Add(limits.max_local_variables);
+  hasher.Add(limits.max_global_variables);
+  hasher.Add(limits.max_switch_branches);
+  hasher.Add(limits.max_function_args);
+  hasher.Add(limits.max_control_flow_nesting_depth);
+  hasher.Add(limits.max_access_chain_indexes);
+  hasher.Add(limits.max_id_bound);
+  hasher.Add(limits.max_instructions);
+  hasher.Add(limits.max_function_blocks);
+  hasher.Add(limits.max_memory_kib);
+  hasher.Add(options->relax_struct_store);
+  hasher.Add(options->relax_logical_pointer);
+  hasher.Add(options->relax_block_layout);
+  hasher.Add(options->uniform_buffer_standard_layout);
+  hasher.Add(options->scalar_block_layout);
+  hasher.Add(options->skip_block_layout);
+  hasher.Add(options->before_hlsl_legalization);
+  hasher.Add(static_cast<uint32_t>(options->profile));
+
+  hasher.Add(static_cast<uint32_t>(num_words));
+  hasher.Add(static_cast<uint32_t>(static_cast<uint64_t>(num_words) >> 32));
+  for (size_t i = 0; i < num_words; ++i) {
+    hasher.Add(words[i]);
+  }
+  return hasher.Digest();
+}
+
+bool spv_validation_cache_t::Contains(const std::string& key) {
+  spv_validation_cache_lookup_fn lookup;
+  void* backend_data;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      keys_.splice(keys_.begin(), keys_, it->second);
+      return true;
+    }
+    lookup = backend_lookup_;
+    backend_data = backend_data_;
+  }
+
+  // The backend is called without holding the mutex, so that a slow lookup
+  // does not delay the other users of the cache.
+  if (!lookup || !lookup(backend_data, key.c_str())) return false;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  InsertInMemory(key);
+  return true;
+}
+
+void spv_validation_cache_t::Insert(const std::string& key) {
+  spv_validation_cache_store_fn store;
+  void* backend_data;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    InsertInMemory(key);
+    store = backend_store_;
+    backend_data = backend_data_;
+  }
+  if (store) store(backend_data, key.c_str());
+}
+
+void spv_validation_cache_t::SetBackend(void* user_data,
+                                        spv_validation_cache_lookup_fn lookup,
+                                        spv_validation_cache_store_fn store) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  backend_data_ = user_data;
+  backend_lookup_ = lookup;
+  backend_store_ = store;
+}
+
+void spv_validation_cache_t::InsertInMemory(const std::string& key) {
+  const auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    keys_.splice(keys_.begin(), keys_, it->second);
+    return;
+  }
+  if (capacity_ == 0) return;
+  if (entries_.size() == capacity_) {
+    entries_.erase(keys_.back());
+    keys_.pop_back();
+  }
+  keys_.push_front(key);
+  entries_[key] = keys_.begin();
+}
+
+spv_validation_cache spvValidationCacheCreate(size_t capacity) {
+  return new spv_validation_cache_t(capacity);
+}
+
+void spvValidationCacheDestroy(spv_validation_cache cache) { delete cache; }
+
+void spvValidationCacheSetBackend(spv_validation_cache cache, void* user_data,
+                                  spv_validation_cache_lookup_fn lookup,
+                                  spv_validation_cache_store_fn store) {
+  assert(cache && "Validation cache object may not be Null");
+  cache->SetBackend(user_data, lookup, store);
+}
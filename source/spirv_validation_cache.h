@@ -0,0 +1,81 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_SPIRV_VALIDATION_CACHE_H_
+#define SOURCE_SPIRV_VALIDATION_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "spirv-tools/libspirv.h"
+
+// Remembers the modules that passed validation.  A module is identified by a
+// key computed from its words, the target environment and the validator
+// options.  The most recently used keys are kept in memory, and an optional
+// backend may keep them in a persistent store.  The cache may be used from
+// several threads at the same time.
+struct spv_validation_cache_t {
+  // Creates a cache that keeps up to |capacity| keys in memory.
+  explicit spv_validation_cache_t(size_t capacity);
+
+  // Returns the key identifying the validation of the |num_words| words at
+  // |words| for |env| with |options|.  The key is the hexadecimal form of a
+  // 128-bit hash, so two different modules get the same key with negligible
+  // probability.  It is not a cryptographic hash: the cache must not be shared
+  // with producers of modules that are not trusted.
+  static std::string Key(spv_target_env env,
+                         spv_const_validator_options options,
+                         const uint32_t* words, size_t num_words);
+
+  // Returns true if the module identified by |key| is known to be valid.
+  // Keys found in the backend are added to the memory of the cache.
+  bool Contains(const std::string& key);
+
+  // Records that the module identified by |key| is valid, in memory and in
+  // the backend.
+  void Insert(const std::string& key);
+
+  // Sets the functions the cache calls to look up and to store keys that are
+  // not in memory.  |user_data| is passed to both.  The functions may be
+  // called from several threads at the same time.  Null functions are not
+  // called.
+  void SetBackend(void* user_data, spv_validation_cache_lookup_fn lookup,
+                  spv_validation_cache_store_fn store);
+
+ private:
+  // Adds |key| to the memory of the cache as the most recently used key, and
+  // forgets the least recently used key if the memory is full.  The mutex
+  // must be held.
+  void InsertInMemory(const std::string& key);
+
+  const size_t capacity_;
+
+  // Guards the members below.
+  std::mutex mutex_;
+
+  // The keys in memory, from the most to the least recently used.
+  std::list<std::string> keys_;
+
+  // Maps each key in memory to its position in |keys_|.
+  std::unordered_map<std::string, std::list<std::string>::iterator> entries_;
+
+  void* backend_data_;
+  spv_validation_cache_lookup_fn backend_lookup_;
+  spv_validation_cache_store_fn backend_store_;
+};
+
+#endif  // SOURCE_SPIRV_VALIDATION_CACHE_H_
@@ -39,6 +39,12 @@ bool spvParseUniversalLimitsOptions(const char* s, spv_validator_limit* type) {
     *type = spv_validator_limit_max_access_chain_indexes;
   } else if (match("--max-id-bound")) {
     *type = spv_validator_limit_max_id_bound;
+  } else if (match("--max-instructions")) {
+    *type = spv_validator_limit_max_instructions;
+  } else if (match("--max-function-blocks")) {
+    *type = spv_validator_limit_max_function_blocks;
+  } else if (match("--max-memory-kib")) {
+    *type = spv_validator_limit_max_memory_kib;
   } else {
     // The command line option for this validator limit has not been added.
     // Therefore we return false.
@@ -48,6 +54,15 @@ bool spvParseUniversalLimitsOptions(const char* s, spv_validator_limit* type) {
   return true;
 }
 
+bool spvParseValidatorProfile(const char* s, spv_validator_profile* profile) {
+  if (s && 0 == strcmp(s, "structural")) {
+    *profile = spv_validator_profile_structural;
+    return true;
+  }
+  *profile = spv_validator_profile_full;
+  return s && 0 == strcmp(s, "full");
+}
+
 spv_validator_options spvValidatorOptionsCreate(void) {
   return new spv_validator_options_t;
 }
@@ -76,6 +91,9 @@ void spvValidatorOptionsSetUniversalLimit(spv_validator_options options,
     LIMIT(spv_validator_limit_max_access_chain_indexes,
           max_access_chain_indexes)
     LIMIT(spv_validator_limit_max_id_bound, max_id_bound)
+    LIMIT(spv_validator_limit_max_instructions, max_instructions)
+    LIMIT(spv_validator_limit_max_function_blocks, max_function_blocks)
+    LIMIT(spv_validator_limit_max_memory_kib, max_memory_kib)
 #undef LIMIT
   }
 }
@@ -115,3 +133,38 @@ void spvValidatorOptionsSetSkipBlockLayout(spv_validator_options options,
                                            bool val) {
   options->skip_block_layout = val;
 }
+
+void spvValidatorOptionsSetNumThreads(spv_validator_options options,
+                                      uint32_t num_threads) {
+  options->num_threads = num_threads;
+}
+
+void spvValidatorOptionsSetProfile(spv_validator_options options,
+                                   spv_validator_profile profile) {
+  options->profile = profile;
+}
+
+void spvValidatorOptionsSetStageReport(spv_validator_options options,
+                                       spv_validator_stage_report_fn report,
+                                       void* user_data) {
+  options->stage_report = report;
+  options->stage_report_data = user_data;
+}
+
+void spvValidatorOptionsSetCache(spv_validator_options options,
+                                 spv_validation_cache cache) {
+  options->cache = cache;
+}
+
+void spvValidatorOptionsSetCancel(spv_validator_options options,
+                                  spv_cancel_fn cancel, void* user_data) {
+  options->cancel = cancel;
+  options->cancel_data = user_data;
+}
+
+void spvValidatorOptionsSetExecutor(spv_validator_options options,
+                                    spv_executor_fn executor,
+                                    void* user_data) {
+  options->executor = executor;
+  options->executor_data = user_data;
+}
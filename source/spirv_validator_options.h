@@ -33,10 +33,14 @@ struct validator_universal_limits_t {
   uint32_t max_control_flow_nesting_depth{1023};
   uint32_t max_access_chain_indexes{255};
   uint32_t max_id_bound{0x3FFFFF};
+  uint32_t max_instructions{0xFFFFFFFF};
+  uint32_t max_function_blocks{0xFFFFFFFF};
+  uint32_t max_memory_kib{0xFFFFFFFF};
 };
 
 // Manages command line options passed to the SPIR-V Validator. New struct
-// members may be added for any new option.
+// members may be added for any new option.  Members that change the result of
+// the validation must also be hashed by spv_validation_cache_t::Key.
 struct spv_validator_options_t {
   spv_validator_options_t()
       : universal_limits_(),
@@ -46,7 +50,20 @@ struct spv_validator_options_t {
         uniform_buffer_standard_layout(false),
         scalar_block_layout(false),
         skip_block_layout(false),
-        before_hlsl_legalization(false) {}
+        before_hlsl_legalization(false),
+        num_threads(1),
+        profile(spv_validator_profile_full),
+        stage_report(nullptr),
+        stage_report_data(nullptr),
+        cache(nullptr),
+        cancel(nullptr),
+        cancel_data(nullptr),
+        executor(nullptr),
+        executor_data(nullptr) {}
+
+  // Returns true if the cancellation function says the validation should
+  // stop.
+  bool IsCancelled() const { return cancel && cancel(cancel_data); }
 
   validator_universal_limits_t universal_limits_;
   bool relax_struct_store;
@@ -56,6 +73,15 @@ struct spv_validator_options_t {
   bool scalar_block_layout;
   bool skip_block_layout;
   bool before_hlsl_legalization;
+  uint32_t num_threads;
+  spv_validator_profile profile;
+  spv_validator_stage_report_fn stage_report;
+  void* stage_report_data;
+  spv_validation_cache cache;
+  spv_cancel_fn cancel;
+  void* cancel_data;
+  spv_executor_fn executor;
+  void* executor_data;
 };
 
 #endif  // SOURCE_SPIRV_VALIDATOR_OPTIONS_H_
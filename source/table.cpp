@@ -16,7 +16,10 @@
 
 #include <utility>
 
-spv_context spvContextCreate(spv_target_env env) {
+namespace {
+
+// Returns true if |env| is a target environment with grammar tables.
+bool IsKnownTargetEnv(spv_target_env env) {
   switch (env) {
     case SPV_ENV_UNIVERSAL_1_0:
     case SPV_ENV_VULKAN_1_0:
@@ -42,25 +45,65 @@ spv_context spvContextCreate(spv_target_env env) {
     case SPV_ENV_UNIVERSAL_1_4:
     case SPV_ENV_UNIVERSAL_1_5:
     case SPV_ENV_VULKAN_1_2:
-      break;
+      return true;
     default:
-      return nullptr;
+      return false;
   }
+}
 
+// The grammar tables of a target environment.  |opcode_table| is null for
+// unknown environments.
+struct GrammarTables {
   spv_opcode_table opcode_table;
   spv_operand_table operand_table;
   spv_ext_inst_table ext_inst_table;
+};
+
+const uint32_t kNumTargetEnvs = SPV_ENV_VULKAN_1_2 + 1;
+
+// Returns the grammar tables of |env|, which must be less than
+// |kNumTargetEnvs|.  The tables of every environment are looked up once, so
+// that creating a context does not repeat the lookups.
+const GrammarTables& GetGrammarTables(spv_target_env env) {
+  struct AllTables {
+    GrammarTables tables[kNumTargetEnvs];
+  };
+  static const AllTables all = [] {
+    AllTables result = {};
+    for (uint32_t i = 0; i < kNumTargetEnvs; ++i) {
+      const spv_target_env target = static_cast<spv_target_env>(i);
+      if (!IsKnownTargetEnv(target)) continue;
+      GrammarTables& tables = result.tables[i];
+      spvOpcodeTableGet(&tables.opcode_table, target);
+      spvOperandTableGet(&tables.operand_table, target);
+      spvExtInstTableGet(&tables.ext_inst_table, target);
+    }
+    return result;
+  }();
+  return all.tables[env];
+}
+
+}  // namespace
 
-  spvOpcodeTableGet(&opcode_table, env);
-  spvOperandTableGet(&operand_table, env);
-  spvExtInstTableGet(&ext_inst_table, env);
+spv_context spvContextCreate(spv_target_env env) {
+  if (static_cast<uint32_t>(env) >= kNumTargetEnvs) return nullptr;
+  const GrammarTables& tables = GetGrammarTables(env);
+  if (tables.opcode_table == nullptr) return nullptr;
 
-  return new spv_context_t{env, opcode_table, operand_table, ext_inst_table,
-                           nullptr /* a null default consumer */};
+  return new spv_context_t{env, tables.opcode_table, tables.operand_table,
+                           tables.ext_inst_table,
+                           nullptr /* a null default consumer */,
+                           {nullptr, nullptr, nullptr} /* the global heap */};
 }
 
 void spvContextDestroy(spv_context context) { delete context; }
 
+void spvContextSetAllocator(spv_context context,
+                            const spv_allocator_t* allocator) {
+  context->allocator =
+      allocator ? *allocator : spv_allocator_t{nullptr, nullptr, nullptr};
+}
+
 void spvtools::SetContextMessageConsumer(spv_context context,
                                          spvtools::MessageConsumer consumer) {
   context->consumer = std::move(consumer);
@@ -15,6 +15,10 @@
 #ifndef SOURCE_TABLE_H_
 #define SOURCE_TABLE_H_
 
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
 #include "source/extensions.h"
 #include "source/latest_version_spirv_header.h"
 #include "spirv-tools/libspirv.hpp"
@@ -112,6 +116,9 @@ struct spv_context_t {
   const spv_operand_table operand_table;
   const spv_ext_inst_table ext_inst_table;
   spvtools::MessageConsumer consumer;
+  // The hooks allocating the objects returned to the user.  Null hooks stand
+  // for the global heap.
+  spv_allocator_t allocator;
 };
 
 namespace spvtools {
@@ -119,6 +126,48 @@ namespace spvtools {
 // Sets the message consumer to |consumer| in the given |context|. The original
 // message consumer will be overwritten.
 void SetContextMessageConsumer(spv_context context, MessageConsumer consumer);
+
+// Returns an array of |count| objects of type T for the user, allocated with
+// |allocator|.  Returns null if it cannot be allocated.
+template <typename T>
+T* NewOutputArray(const spv_allocator_t& allocator, size_t count) {
+  static_assert(std::is_trivial<T>::value, "output objects must be trivial");
+  if (!allocator.allocate) return new T[count];
+  return static_cast<T*>(allocator.allocate(allocator.user_data,
+                                            count * sizeof(T)));
+}
+
+// Returns a value-initialized object of type T for the user, allocated with
+// |allocator|.  Returns null if it cannot be allocated.
+template <typename T>
+T* NewOutput(const spv_allocator_t& allocator) {
+  static_assert(std::is_trivial<T>::value, "output objects must be trivial");
+  if (!allocator.allocate) return new T();
+  void* memory = allocator.allocate(allocator.user_data, sizeof(T));
+  return memory ? new (memory) T() : nullptr;
+}
+
+// Releases an array returned by NewOutputArray with the same |allocator|.
+template <typename T>
+void DeleteOutputArray(const spv_allocator_t& allocator, T* array) {
+  if (!allocator.deallocate) {
+    delete[] array;
+  } else if (array) {
+    void* memory = const_cast<void*>(static_cast<const void*>(array));
+    allocator.deallocate(allocator.user_data, memory);
+  }
+}
+
+// Releases an object returned by NewOutput with the same |allocator|.
+template <typename T>
+void DeleteOutput(const spv_allocator_t& allocator, T* object) {
+  if (!allocator.deallocate) {
+    delete object;
+  } else if (object) {
+    allocator.deallocate(allocator.user_data, object);
+  }
+}
+
 }  // namespace spvtools
 
 // Populates *table with entries for env.
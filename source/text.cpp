@@ -15,6 +15,7 @@
 #include "source/text.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
 #include <cstdio>
@@ -40,7 +41,10 @@
 #include "source/table.h"
 #include "source/text_handler.h"
 #include "source/util/bitutils.h"
+#include "source/util/make_unique.h"
+#include "source/util/parallel.h"
 #include "source/util/parse_number.h"
+#include "source/util/string_view.h"
 #include "spirv-tools/libspirv.h"
 
 bool spvIsValidIDCharacter(const char value) {
@@ -223,6 +227,9 @@ spv_result_t spvTextEncodeOperand(const spvtools::AssemblyGrammar& grammar,
       }
       const uint32_t id = context->spvNamedIdAssignOrGet(textValue);
       if (type == SPV_OPERAND_TYPE_TYPE_ID) pInst->resultTypeId = id;
+      if (context->isPlaceholderId(id)) {
+        context->recordPlaceholderWord(pInst->words.size());
+      }
       spvInstructionAddWord(pInst, id);
 
       // Set the extended instruction type.
@@ -539,9 +546,9 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
     context->setPosition(nextPosition);
     if (context->advance())
       return context->diagnostic() << "Expected '=', found end of stream.";
-    std::string equal_sign;
+    spvtools::utils::StringView equal_sign;
     error = context->getWord(&equal_sign, &nextPosition);
-    if ("=" != equal_sign)
+    if (spvtools::utils::StringView("=") != equal_sign)
       return context->diagnostic() << "'=' expected after result id.";
 
     // The <opcode> after the '=' sign.
@@ -593,6 +600,9 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
     expectedOperands.push_back(
         opcodeEntry->operandTypes[opcodeEntry->numTypes - i - 1]);
 
+  // The words of the operands share a buffer, which only grows when an operand
+  // is longer than all the previous ones.
+  std::string operandValue;
   while (!expectedOperands.empty()) {
     const spv_operand_type_t type = expectedOperands.back();
     expectedOperands.pop_back();
@@ -636,7 +646,6 @@ spv_result_t spvTextEncodeOpcode(const spvtools::AssemblyGrammar& grammar,
         }
       }
 
-      std::string operandValue;
       error = context->getWord(&operandValue, &nextPosition);
       if (error) return context->diagnostic(error) << "Internal Error";
 
@@ -726,13 +735,155 @@ spv_result_t GetNumericIds(const spvtools::AssemblyGrammar& grammar,
   return SPV_SUCCESS;
 }
 
-// Translates a given assembly language module into binary form.
-// If a diagnostic is generated, it is not yet marked as being
-// for a text-based input.
+// Writes to |pBinary| a binary allocated with |allocator|, which holds the
+// header for |bound| followed by |words|.
+spv_result_t NewBinary(const spvtools::AssemblyGrammar& grammar,
+                       const spv_allocator_t& allocator, uint32_t bound,
+                       const std::vector<uint32_t>& words,
+                       spv_binary* pBinary) {
+  const size_t totalSize = SPV_INDEX_INSTRUCTION + words.size();
+  uint32_t* data = spvtools::NewOutputArray<uint32_t>(allocator, totalSize);
+  if (!data) return SPV_ERROR_OUT_OF_MEMORY;
+  if (!words.empty()) {
+    memcpy(data + SPV_INDEX_INSTRUCTION, words.data(),
+           sizeof(uint32_t) * words.size());
+  }
+
+  if (auto error = SetHeader(grammar.target_env(), bound, data)) {
+    spvtools::DeleteOutputArray(allocator, data);
+    return error;
+  }
+
+  spv_binary binary = spvtools::NewOutput<spv_binary_t>(allocator);
+  if (!binary) {
+    spvtools::DeleteOutputArray(allocator, data);
+    return SPV_ERROR_OUT_OF_MEMORY;
+  }
+  binary->code = data;
+  binary->wordCount = totalSize;
+
+  *pBinary = binary;
+
+  return SPV_SUCCESS;
+}
+
+// Assembles the instructions of |context| from |begin| to |end| in the text,
+// a part of the text that starts and ends at instruction boundaries, and
+// appends their words to |words|.  Returns false if the instructions fail to
+// assemble, or if the last one does not end at |end|.
+bool AssemblePart(const spvtools::AssemblyGrammar& grammar,
+                  spvtools::AssemblyContext* context, size_t begin, size_t end,
+                  std::vector<uint32_t>* words) {
+  spv_position_t position = {};
+  position.index = begin;
+  context->setPosition(position);
+  while (context->position().index < end) {
+    spv_instruction_t inst;
+    context->setInstructionOffset(words->size());
+    if (spvTextEncodeOpcode(grammar, context, &inst)) return false;
+    words->insert(words->end(), inst.words.begin(), inst.words.end());
+    if (context->advance()) return true;
+  }
+  return context->position().index == end;
+}
+
+// Assembles |text| like spvTextToBinaryInternal, but with the functions of
+// the module spread over up to |num_threads| threads.  The instructions before
+// the first function, which define the types and extended instruction imports
+// the functions refer to, are assembled first.  The function boundaries are
+// found without assembling the functions, which are grouped into parts of
+// about the same size, and each part is assembled by its own context.  The ids
+// that are first seen in a part are given placeholder values, and then the
+// final values in the order of the parts, so the ids are numbered as by the
+// serial assembler, also when |ids_to_preserve| is not empty.
+//
+// Returns true and writes the words of the module, without the header, to
+// |words| and its id bound to |bound| on success.  Returns false without
+// emitting any message if the module cannot be assembled this way, for
+// example because it is invalid, or because a function defines a type.  The
+// caller should then assemble it serially, which reports the problem.
+bool AssembleInParallel(const spvtools::AssemblyGrammar& grammar,
+                        const spv_text text,
+                        const std::set<uint32_t>& ids_to_preserve,
+                        uint32_t num_threads, std::vector<uint32_t>* words,
+                        uint32_t* bound) {
+  using spvtools::AssemblyContext;
+  if (!ids_to_preserve.empty() &&
+      *ids_to_preserve.rbegin() >= AssemblyContext::kFirstPlaceholderId) {
+    return false;
+  }
+
+  // Any message means the serial assembler has to be run to report it.
+  std::atomic<bool> failed(false);
+  const spvtools::MessageConsumer consumer =
+      [&failed](spv_message_level_t, const char*, const spv_position_t&,
+                const char*) { failed = true; };
+  AssemblyContext context(text, consumer,
+                          std::set<uint32_t>(ids_to_preserve));
+
+  const std::vector<size_t> function_offsets = context.getFunctionOffsets();
+  if (function_offsets.size() < 2) return false;
+
+  // A few parts per thread let the threads that finish early take more.
+  const size_t max_parts =
+      std::min<size_t>(function_offsets.size(), size_t(num_threads) * 4);
+  const size_t part_length =
+      (text->length - function_offsets[0]) / max_parts + 1;
+  std::vector<size_t> part_offsets;
+  for (size_t offset : function_offsets) {
+    if (part_offsets.empty() || offset - part_offsets.back() >= part_length) {
+      part_offsets.push_back(offset);
+    }
+  }
+  const size_t num_parts = part_offsets.size();
+  part_offsets.push_back(text->length);
+
+  // Skip past whitespace and comments.
+  context.advance();
+  while (context.hasText() && context.position().index < part_offsets[0]) {
+    spv_instruction_t inst;
+    if (spvTextEncodeOpcode(grammar, &context, &inst)) return false;
+    words->insert(words->end(), inst.words.begin(), inst.words.end());
+    if (context.advance()) break;
+  }
+  if (failed || context.position().index != part_offsets[0]) return false;
+
+  std::vector<std::unique_ptr<AssemblyContext>> part_contexts(num_parts);
+  std::vector<std::vector<uint32_t>> part_words(num_parts);
+  std::atomic<size_t> next_part(0);
+  spvtools::utils::RunOnWorkers(
+      std::min<size_t>(num_threads, num_parts), nullptr, nullptr, [&]() {
+        for (size_t i = next_part++; !failed && i < num_parts;
+             i = next_part++) {
+          part_contexts[i] =
+              spvtools::MakeUnique<AssemblyContext>(text, consumer, &context);
+          if (!AssemblePart(grammar, part_contexts[i].get(), part_offsets[i],
+                            part_offsets[i + 1], &part_words[i])) {
+            failed = true;
+          }
+        }
+      });
+  if (failed) return false;
+
+  for (size_t i = 0; i < num_parts; ++i) {
+    if (!context.resolvePart(*part_contexts[i], &part_words[i])) return false;
+    part_contexts[i].reset();
+    words->insert(words->end(), part_words[i].begin(), part_words[i].end());
+    std::vector<uint32_t>().swap(part_words[i]);
+  }
+  *bound = context.getBound();
+  return true;
+}
+
+// Translates a given assembly language module into binary form, allocated
+// with |allocator|, on up to |num_threads| threads.  If a diagnostic is
+// generated, it is not yet marked as being for a text-based input.
 spv_result_t spvTextToBinaryInternal(const spvtools::AssemblyGrammar& grammar,
                                      const spvtools::MessageConsumer& consumer,
+                                     const spv_allocator_t& allocator,
                                      const spv_text text,
                                      const uint32_t options,
+                                     const uint32_t num_threads,
                                      spv_binary* pBinary) {
   // The ids in this set will have the same values both in source and binary.
   // All other ids will be generated by filling in the gaps.
@@ -745,6 +896,16 @@ spv_result_t spvTextToBinaryInternal(const spvtools::AssemblyGrammar& grammar,
     if (result != SPV_SUCCESS) return result;
   }
 
+  std::vector<uint32_t> words;
+  if (num_threads > 1 && text->str && grammar.isValid() && pBinary) {
+    uint32_t bound = 0;
+    if (AssembleInParallel(grammar, text, ids_to_preserve, num_threads, &words,
+                           &bound)) {
+      return NewBinary(grammar, allocator, bound, words, pBinary);
+    }
+    words.clear();
+  }
+
   spvtools::AssemblyContext context(text, consumer, std::move(ids_to_preserve));
 
   if (!text->str) return context.diagnostic() << "Missing assembly text.";
@@ -754,50 +915,21 @@ spv_result_t spvTextToBinaryInternal(const spvtools::AssemblyGrammar& grammar,
   }
   if (!pBinary) return SPV_ERROR_INVALID_POINTER;
 
-  std::vector<spv_instruction_t> instructions;
-
   // Skip past whitespace and comments.
   context.advance();
 
   while (context.hasText()) {
-    instructions.push_back({});
-    spv_instruction_t& inst = instructions.back();
+    spv_instruction_t inst;
 
     if (spvTextEncodeOpcode(grammar, &context, &inst)) {
       return SPV_ERROR_INVALID_TEXT;
     }
+    words.insert(words.end(), inst.words.begin(), inst.words.end());
 
     if (context.advance()) break;
   }
 
-  size_t totalSize = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    totalSize += inst.words.size();
-  }
-
-  uint32_t* data = new uint32_t[totalSize];
-  if (!data) return SPV_ERROR_OUT_OF_MEMORY;
-  uint64_t currentIndex = SPV_INDEX_INSTRUCTION;
-  for (auto& inst : instructions) {
-    memcpy(data + currentIndex, inst.words.data(),
-           sizeof(uint32_t) * inst.words.size());
-    currentIndex += inst.words.size();
-  }
-
-  if (auto error = SetHeader(grammar.target_env(), context.getBound(), data))
-    return error;
-
-  spv_binary binary = new spv_binary_t();
-  if (!binary) {
-    delete[] data;
-    return SPV_ERROR_OUT_OF_MEMORY;
-  }
-  binary->code = data;
-  binary->wordCount = totalSize;
-
-  *pBinary = binary;
-
-  return SPV_SUCCESS;
+  return NewBinary(grammar, allocator, context.getBound(), words, pBinary);
 }
 
 }  // anonymous namespace
@@ -827,7 +959,32 @@ spv_result_t spvTextToBinaryWithOptions(const spv_const_context context,
   spvtools::AssemblyGrammar grammar(&hijack_context);
 
   spv_result_t result = spvTextToBinaryInternal(
-      grammar, hijack_context.consumer, &text, options, pBinary);
+      grammar, hijack_context.consumer, hijack_context.allocator, &text,
+      options, 1, pBinary);
+  if (pDiagnostic && *pDiagnostic) (*pDiagnostic)->isTextSource = true;
+
+  return result;
+}
+
+spv_result_t spvTextToBinaryParallel(const spv_const_context context,
+                                     const char* input_text,
+                                     const size_t input_text_size,
+                                     const uint32_t options,
+                                     const uint32_t num_threads,
+                                     spv_binary* pBinary,
+                                     spv_diagnostic* pDiagnostic) {
+  spv_context_t hijack_context = *context;
+  if (pDiagnostic) {
+    *pDiagnostic = nullptr;
+    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
+  }
+
+  spv_text_t text = {input_text, input_text_size};
+  spvtools::AssemblyGrammar grammar(&hijack_context);
+
+  spv_result_t result = spvTextToBinaryInternal(
+      grammar, hijack_context.consumer, hijack_context.allocator, &text,
+      options, num_threads, pBinary);
   if (pDiagnostic && *pDiagnostic) (*pDiagnostic)->isTextSource = true;
 
   return result;
@@ -839,3 +996,11 @@ void spvTextDestroy(spv_text text) {
     delete text;
   }
 }
+
+void spvTextDestroyWithContext(const spv_const_context context,
+                               spv_text text) {
+  if (text) {
+    spvtools::DeleteOutputArray(context->allocator, text->str);
+    spvtools::DeleteOutput(context->allocator, text);
+  }
+}
@@ -61,37 +61,39 @@ spv_result_t advanceLine(spv_text text, spv_position position) {
 // parameters, its the users responsibility to ensure these are non null.
 spv_result_t advance(spv_text text, spv_position position) {
   // NOTE: Consume white space, otherwise don't advance.
-  if (position->index >= text->length) return SPV_END_OF_STREAM;
-  switch (text->str[position->index]) {
-    case '\0':
-      return SPV_END_OF_STREAM;
-    case ';':
-      if (spv_result_t error = advanceLine(text, position)) return error;
-      return advance(text, position);
-    case ' ':
-    case '\t':
-    case '\r':
-      position->column++;
-      position->index++;
-      return advance(text, position);
-    case '\n':
-      position->column = 0;
-      position->line++;
-      position->index++;
-      return advance(text, position);
-    default:
-      break;
+  while (true) {
+    if (position->index >= text->length) return SPV_END_OF_STREAM;
+    switch (text->str[position->index]) {
+      case '\0':
+        return SPV_END_OF_STREAM;
+      case ';':
+        if (spv_result_t error = advanceLine(text, position)) return error;
+        break;
+      case ' ':
+      case '\t':
+      case '\r':
+        position->column++;
+        position->index++;
+        break;
+      case '\n':
+        position->column = 0;
+        position->line++;
+        position->index++;
+        break;
+      default:
+        return SPV_SUCCESS;
+    }
   }
-  return SPV_SUCCESS;
 }
 
 // Fetches the next word from the given text stream starting from the given
-// *position. On success, writes the decoded word into *word and updates
-// *position to the location past the returned word.
+// *position. On success, writes a view of the word in the text into *word and
+// updates *position to the location past the returned word.
 //
 // A word ends at the next comment or whitespace.  However, double-quoted
 // strings remain intact, and a backslash always escapes the next character.
-spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
+spv_result_t getWord(spv_text text, spv_position position,
+                     utils::StringView* word) {
   if (!text->str || !text->length) return SPV_ERROR_INVALID_TEXT;
   if (!position) return SPV_ERROR_INVALID_POINTER;
 
@@ -103,7 +105,8 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
   // NOTE: Assumes first character is not white space!
   while (true) {
     if (position->index >= text->length) {
-      word->assign(text->str + start_index, text->str + position->index);
+      *word = utils::StringView(text->str + start_index,
+                                position->index - start_index);
       return SPV_SUCCESS;
     }
     const char ch = text->str[position->index];
@@ -122,7 +125,8 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
           if (escaping || quoting) break;
         // Fall through.
         case '\0': {  // NOTE: End of word found!
-          word->assign(text->str + start_index, text->str + position->index);
+          *word = utils::StringView(text->str + start_index,
+                                    position->index - start_index);
           return SPV_SUCCESS;
         }
         default:
@@ -136,6 +140,34 @@ spv_result_t getWord(spv_text text, spv_position position, std::string* word) {
   }
 }
 
+// Returns an estimate of the number of ids defined in |text|: the number of
+// lines starting with a '%', which are the instructions with a result id.
+size_t countResultIds(spv_text text) {
+  size_t count = 0;
+  bool line_start = true;
+  for (size_t i = 0; i < text->length; ++i) {
+    switch (text->str[i]) {
+      case '\0':
+        return count;
+      case '\n':
+        line_start = true;
+        break;
+      case ' ':
+      case '\t':
+      case '\r':
+        break;
+      case '%':
+        if (line_start) ++count;
+        line_start = false;
+        break;
+      default:
+        line_start = false;
+        break;
+    }
+  }
+  return count;
+}
+
 // Returns true if the characters in the text as position represent
 // the start of an Opcode.
 bool startsWithOp(spv_text text, spv_position position) {
@@ -155,18 +187,22 @@ const IdType kUnknownType = {0, false, IdTypeClass::kBottom};
 // This represents all of the data that is only valid for the duration of
 // a single compilation.
 uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
-  if (!ids_to_preserve_.empty()) {
+  const std::set<uint32_t>& ids_to_preserve =
+      parent_ ? parent_->ids_to_preserve_ : ids_to_preserve_;
+  if (!ids_to_preserve.empty()) {
     uint32_t id = 0;
     if (spvtools::utils::ParseNumber(textValue, &id)) {
-      if (ids_to_preserve_.find(id) != ids_to_preserve_.end()) {
+      if (ids_to_preserve.find(id) != ids_to_preserve.end()) {
         bound_ = std::max(bound_, id + 1);
         return id;
       }
     }
   }
 
-  const auto it = named_ids_.find(textValue);
+  const auto it = named_ids_.find(utils::StringView(textValue));
   if (it == named_ids_.end()) {
+    if (parent_) return assignPlaceholder(textValue);
+
     uint32_t id = next_id_++;
     if (!ids_to_preserve_.empty()) {
       while (ids_to_preserve_.find(id) != ids_to_preserve_.end()) {
@@ -174,7 +210,7 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
       }
     }
 
-    named_ids_.emplace(textValue, id);
+    named_ids_.emplace(saveName(textValue), id);
     bound_ = std::max(bound_, id + 1);
     return id;
   }
@@ -182,6 +218,91 @@ uint32_t AssemblyContext::spvNamedIdAssignOrGet(const char* textValue) {
   return it->second;
 }
 
+uint32_t AssemblyContext::assignPlaceholder(const char* textValue) {
+  const auto parent_it = parent_->named_ids_.find(utils::StringView(textValue));
+  if (parent_it != parent_->named_ids_.end()) return parent_it->second;
+
+  // The placeholders do not count towards the bound.  Their final values do,
+  // once the parent has given them.
+  const uint32_t id = next_id_++;
+  const utils::StringView name = saveName(textValue);
+  named_ids_.emplace(name, id);
+  placeholder_names_.push_back(name);
+  return id;
+}
+
+bool AssemblyContext::resolvePart(const AssemblyContext& part,
+                                  std::vector<uint32_t>* words) {
+  std::vector<uint32_t> ids;
+  ids.reserve(part.placeholder_names_.size());
+  for (const utils::StringView& name : part.placeholder_names_) {
+    // The saved names are null-terminated.
+    ids.push_back(spvNamedIdAssignOrGet(name.data()));
+  }
+  const auto resolve = [&part, &ids](uint32_t id) {
+    return part.isPlaceholderId(id) ? ids[id - kFirstPlaceholderId] : id;
+  };
+
+  for (size_t position : part.placeholder_words_) {
+    (*words)[position] = resolve((*words)[position]);
+  }
+  for (const auto& value_type : part.value_types_) {
+    const bool successfully_inserted =
+        value_types_
+            .emplace(resolve(value_type.first), resolve(value_type.second))
+            .second;
+    if (!successfully_inserted) return false;
+  }
+  bound_ = std::max(bound_, part.bound_);
+  return true;
+}
+
+std::vector<size_t> AssemblyContext::getFunctionOffsets() const {
+  std::vector<size_t> offsets;
+  spv_position_t position = {};
+  // The last two words, which start the instruction if they are "%id =".
+  utils::StringView words[2];
+  size_t word_offsets[2] = {0, 0};
+  while (spvtools::advance(text_, &position) == SPV_SUCCESS) {
+    const size_t offset = position.index;
+    utils::StringView word;
+    if (spvtools::getWord(text_, &position, &word) != SPV_SUCCESS ||
+        word.empty()) {
+      break;
+    }
+    if (word == "OpFunction") {
+      const bool has_result_id =
+          words[1] == "=" && !words[0].empty() && words[0][0] == '%';
+      offsets.push_back(has_result_id ? word_offsets[0] : offset);
+    }
+    words[0] = words[1];
+    word_offsets[0] = word_offsets[1];
+    words[1] = word;
+    word_offsets[1] = offset;
+  }
+  return offsets;
+}
+
+void AssemblyContext::reserveNamedIds() {
+  if (text_ && text_->str) named_ids_.reserve(countResultIds(text_));
+}
+
+utils::StringView AssemblyContext::saveName(utils::StringView name) {
+  const size_t size = name.size() + 1;  // With the null terminator.
+  if (size > name_block_space_) {
+    const size_t block_size = std::max<size_t>(kNameBlockSize, size);
+    name_blocks_.emplace_back(new char[block_size]);
+    name_block_next_ = name_blocks_.back().get();
+    name_block_space_ = block_size;
+  }
+  char* saved = name_block_next_;
+  memcpy(saved, name.data(), name.size());
+  saved[name.size()] = '\0';
+  name_block_next_ += size;
+  name_block_space_ -= size;
+  return utils::StringView(saved, name.size());
+}
+
 uint32_t AssemblyContext::getBound() const { return bound_; }
 
 spv_result_t AssemblyContext::advance() {
@@ -190,6 +311,14 @@ spv_result_t AssemblyContext::advance() {
 
 spv_result_t AssemblyContext::getWord(std::string* word,
                                       spv_position next_position) {
+  utils::StringView view;
+  if (spv_result_t error = getWord(&view, next_position)) return error;
+  word->assign(view.data(), view.size());
+  return SPV_SUCCESS;
+}
+
+spv_result_t AssemblyContext::getWord(utils::StringView* word,
+                                      spv_position next_position) {
   *next_position = current_position_;
   return spvtools::getWord(text_, next_position, word);
 }
@@ -203,14 +332,14 @@ bool AssemblyContext::isStartOfNewInst() {
   if (spvtools::advance(text_, &pos)) return false;
   if (spvtools::startsWithOp(text_, &pos)) return true;
 
-  std::string word;
+  utils::StringView word;
   pos = current_position_;
   if (spvtools::getWord(text_, &pos, &word)) return false;
   if ('%' != word.front()) return false;
 
   if (spvtools::advance(text_, &pos)) return false;
   if (spvtools::getWord(text_, &pos, &word)) return false;
-  if ("=" != word) return false;
+  if (utils::StringView("=") != word) return false;
 
   if (spvtools::advance(text_, &pos)) return false;
   if (spvtools::startsWithOp(text_, &pos)) return true;
@@ -320,6 +449,10 @@ spv_result_t AssemblyContext::binaryEncodeString(const char* value,
 
 spv_result_t AssemblyContext::recordTypeDefinition(
     const spv_instruction_t* pInst) {
+  // The parts of the text are assembled at the same time, so a part cannot
+  // define a type that the contexts of the later parts would have to see.
+  if (parent_) return diagnostic() << "Type defined in a part of the text";
+
   uint32_t value = pInst->words[1];
   if (types_.find(value) != types_.end()) {
     return diagnostic() << "Value " << value
@@ -344,6 +477,7 @@ spv_result_t AssemblyContext::recordTypeDefinition(
 IdType AssemblyContext::getTypeOfTypeGeneratingValue(uint32_t value) const {
   auto type = types_.find(value);
   if (type == types_.end()) {
+    if (parent_) return parent_->getTypeOfTypeGeneratingValue(value);
     return kUnknownType;
   }
   return std::get<1>(*type);
@@ -352,6 +486,7 @@ IdType AssemblyContext::getTypeOfTypeGeneratingValue(uint32_t value) const {
 IdType AssemblyContext::getTypeOfValueInstruction(uint32_t value) const {
   auto type_value = value_types_.find(value);
   if (type_value == value_types_.end()) {
+    if (parent_) return parent_->getTypeOfValueInstruction(value);
     return {0, false, IdTypeClass::kBottom};
   }
   return getTypeOfTypeGeneratingValue(std::get<1>(*type_value));
@@ -369,6 +504,9 @@ spv_result_t AssemblyContext::recordTypeIdForValue(uint32_t value,
 
 spv_result_t AssemblyContext::recordIdAsExtInstImport(
     uint32_t id, spv_ext_inst_type_t type) {
+  // Like the types, the imports must be seen by the later parts.
+  if (parent_) return diagnostic() << "Import defined in a part of the text";
+
   bool successfully_inserted = false;
   std::tie(std::ignore, successfully_inserted) =
       import_id_to_ext_inst_type_.insert(std::make_pair(id, type));
@@ -380,6 +518,7 @@ spv_result_t AssemblyContext::recordIdAsExtInstImport(
 spv_ext_inst_type_t AssemblyContext::getExtInstTypeForId(uint32_t id) const {
   auto type = import_id_to_ext_inst_type_.find(id);
   if (type == import_id_to_ext_inst_type_.end()) {
+    if (parent_) return parent_->getExtInstTypeForId(id);
     return SPV_EXT_INST_TYPE_NONE;
   }
   return std::get<1>(*type);
@@ -389,7 +528,8 @@ std::set<uint32_t> AssemblyContext::GetNumericIds() const {
   std::set<uint32_t> ids;
   for (const auto& kv : named_ids_) {
     uint32_t id;
-    if (spvtools::utils::ParseNumber(kv.first.c_str(), &id)) ids.insert(id);
+    // The saved names are null-terminated.
+    if (spvtools::utils::ParseNumber(kv.first.data(), &id)) ids.insert(id);
   }
   return ids;
 }
@@ -16,16 +16,19 @@
 #define SOURCE_TEXT_HANDLER_H_
 
 #include <iomanip>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "source/diagnostic.h"
 #include "source/instruction.h"
 #include "source/text.h"
+#include "source/util/string_view.h"
 #include "spirv-tools/libspirv.h"
 
 namespace spvtools {
@@ -127,7 +130,26 @@ class AssemblyContext {
         text_(text),
         bound_(1),
         next_id_(1),
-        ids_to_preserve_(std::move(ids_to_preserve)) {}
+        ids_to_preserve_(std::move(ids_to_preserve)) {
+    reserveNamedIds();
+  }
+
+  // Creates a context for a part of |text|, which is assembled after the
+  // instructions that |parent| has assembled, and without changing |parent|.
+  // The ids that |parent| has not seen are given placeholder values, which
+  // |parent| replaces with their final values in resolvePart.
+  AssemblyContext(spv_text text, const MessageConsumer& consumer,
+                  const AssemblyContext* parent)
+      : current_position_({}),
+        consumer_(consumer),
+        text_(text),
+        bound_(1),
+        next_id_(kFirstPlaceholderId),
+        parent_(parent) {}
+
+  // The placeholder ids of the contexts for a part of the text do not go below
+  // this value, so they cannot be mistaken for the ids of their parent.
+  enum : uint32_t { kFirstPlaceholderId = 0x80000000u };
 
   // Assigns a new integer value to the given text ID, or returns the previously
   // assigned integer value if the ID has been seen before.
@@ -136,6 +158,33 @@ class AssemblyContext {
   // Returns the largest largest numeric ID that has been assigned.
   uint32_t getBound() const;
 
+  // Returns true if |id| is a placeholder given by spvNamedIdAssignOrGet in
+  // a context for a part of the text.
+  bool isPlaceholderId(uint32_t id) const {
+    return parent_ != nullptr && id >= kFirstPlaceholderId;
+  }
+
+  // Sets the number of words assembled in this context before the current
+  // instruction, to which recordPlaceholderWord adds the index it is given.
+  void setInstructionOffset(size_t offset) { instruction_offset_ = offset; }
+
+  // Records that the word at |index| in the current instruction is a
+  // placeholder id, for resolvePart to replace.
+  void recordPlaceholderWord(size_t index) {
+    placeholder_words_.push_back(instruction_offset_ + index);
+  }
+
+  // Gives the ids first seen by |part| their values in this context, in the
+  // order |part| saw them, as if this context had assembled the text of |part|
+  // itself, and replaces the placeholders in |words|, the words assembled by
+  // |part|.  Returns false if |part| defines a value that has already been
+  // defined, which the serial assembler reports.
+  bool resolvePart(const AssemblyContext& part, std::vector<uint32_t>* words);
+
+  // Returns the offsets in the input text of the instructions that start a
+  // function, found by splitting the text into words without assembling it.
+  std::vector<size_t> getFunctionOffsets() const;
+
   // Advances position to point to the next word in the input stream.
   // Returns SPV_SUCCESS on success.
   spv_result_t advance();
@@ -144,6 +193,10 @@ class AssemblyContext {
   // the next location past the end of the word.
   spv_result_t getWord(std::string* word, spv_position next_position);
 
+  // Like the above, but sets word to a view of the next word in the input
+  // text, so the word is not copied.
+  spv_result_t getWord(utils::StringView* word, spv_position next_position);
+
   // Returns true if the next word in the input is the start of a new Opcode.
   bool startsWithOp();
 
@@ -239,14 +292,34 @@ class AssemblyContext {
   std::set<uint32_t> GetNumericIds() const;
 
  private:
-  // Maps ID names to their corresponding numerical ids.
-  using spv_named_id_table = std::unordered_map<std::string, uint32_t>;
+  // Maps ID names to their corresponding numerical ids.  The names are owned
+  // by |name_blocks_|.
+  using spv_named_id_table =
+      std::unordered_map<utils::StringView, uint32_t, utils::StringViewHash>;
   // Maps type-defining IDs to their IdType.
   using spv_id_to_type_map = std::unordered_map<uint32_t, IdType>;
   // Maps Ids to the id of their type.
   using spv_id_to_type_id = std::unordered_map<uint32_t, uint32_t>;
 
+  enum { kNameBlockSize = 4096 };
+
+  // Reserves room in |named_ids_| for the ids defined in the input text.
+  void reserveNamedIds();
+
+  // Returns a null-terminated copy of |name| that lives as long as this
+  // context.
+  utils::StringView saveName(utils::StringView name);
+
+  // Returns the id of |textValue| in |parent_|, or a new placeholder id if
+  // |parent_| has not seen it.
+  uint32_t assignPlaceholder(const char* textValue);
+
   spv_named_id_table named_ids_;
+  // The blocks of memory holding the names of |named_ids_|.  Names are
+  // appended to the last block until it is full.
+  std::vector<std::unique_ptr<char[]>> name_blocks_;
+  char* name_block_next_ = nullptr;  // Where to save the next name.
+  size_t name_block_space_ = 0;      // The room left in the last block.
   spv_id_to_type_map types_;
   spv_id_to_type_id value_types_;
   // Maps an extended instruction import Id to the extended instruction type.
@@ -257,6 +330,15 @@ class AssemblyContext {
   uint32_t bound_;
   uint32_t next_id_;
   std::set<uint32_t> ids_to_preserve_;
+
+  // The context that assembled the text before this part, or null if this
+  // context assembles the whole text.
+  const AssemblyContext* parent_ = nullptr;
+  // The names given placeholder ids, in the order of the ids.
+  std::vector<utils::StringView> placeholder_names_;
+  // The positions of the placeholder ids in the words of this part.
+  std::vector<size_t> placeholder_words_;
+  size_t instruction_offset_ = 0;
 };
 
 }  // namespace spvtools
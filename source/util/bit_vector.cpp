@@ -14,23 +14,23 @@
 
 #include "source/util/bit_vector.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
 namespace spvtools {
 namespace utils {
 
-void BitVector::ReportDensity(std::ostream& out) {
-  uint32_t count = 0;
-
+uint32_t BitVector::Count() const {
+  size_t count = 0;
   for (BitContainer e : bits_) {
-    while (e != 0) {
-      if ((e & 1) != 0) {
-        ++count;
-      }
-      e = e >> 1;
-    }
+    count += CountSetBits(e);
   }
+  return static_cast<uint32_t>(count);
+}
+
+void BitVector::ReportDensity(std::ostream& out) {
+  uint32_t count = Count();
 
   out << "count=" << count
       << ", total size (bytes)=" << bits_.size() * sizeof(BitContainer)
@@ -38,42 +38,59 @@ void BitVector::ReportDensity(std::ostream& out) {
       << (double)(bits_.size() * sizeof(BitContainer)) / (double)(count);
 }
 
+// The word loops below accumulate the changed bits instead of branching on
+// every word, so that the compiler can vectorize them.
+
 bool BitVector::Or(const BitVector& other) {
-  auto this_it = this->bits_.begin();
-  auto other_it = other.bits_.begin();
-  bool modified = false;
-
-  while (this_it != this->bits_.end() && other_it != other.bits_.end()) {
-    auto temp = *this_it | *other_it;
-    if (temp != *this_it) {
-      modified = true;
-      *this_it = temp;
-    }
-    ++this_it;
-    ++other_it;
+  const size_t common_size = std::min(bits_.size(), other.bits_.size());
+  BitContainer changed = 0;
+  for (size_t i = 0; i < common_size; ++i) {
+    BitContainer temp = bits_[i] | other.bits_[i];
+    changed |= temp ^ bits_[i];
+    bits_[i] = temp;
   }
+  bool modified = changed != 0;
 
-  if (other_it != other.bits_.end()) {
+  if (common_size < other.bits_.size()) {
     modified = true;
-    this->bits_.insert(this->bits_.end(), other_it, other.bits_.end());
+    bits_.insert(bits_.end(), other.bits_.begin() + common_size,
+                 other.bits_.end());
   }
 
   return modified;
 }
 
+bool BitVector::And(const BitVector& other) {
+  const size_t common_size = std::min(bits_.size(), other.bits_.size());
+  BitContainer changed = 0;
+  for (size_t i = 0; i < common_size; ++i) {
+    BitContainer temp = bits_[i] & other.bits_[i];
+    changed |= temp ^ bits_[i];
+    bits_[i] = temp;
+  }
+
+  // The bits past the end of |other| are 0 in |other|.
+  for (size_t i = common_size; i < bits_.size(); ++i) {
+    changed |= bits_[i];
+    bits_[i] = 0;
+  }
+
+  return changed != 0;
+}
+
+bool BitVector::AndNot(const BitVector& other) {
+  const size_t common_size = std::min(bits_.size(), other.bits_.size());
+  BitContainer changed = 0;
+  for (size_t i = 0; i < common_size; ++i) {
+    changed |= bits_[i] & other.bits_[i];
+    bits_[i] &= ~other.bits_[i];
+  }
+  return changed != 0;
+}
+
 std::ostream& operator<<(std::ostream& out, const BitVector& bv) {
   out << "{";
-  for (uint32_t i = 0; i < bv.bits_.size(); ++i) {
-    BitVector::BitContainer b = bv.bits_[i];
-    uint32_t j = 0;
-    while (b != 0) {
-      if (b & 1) {
-        out << ' ' << i * BitVector::kBitContainerSize + j;
-      }
-      ++j;
-      b = b >> 1;
-    }
-  }
+  bv.ForEachSetBit([&out](uint32_t i) { out << ' ' << i; });
   out << "}";
   return out;
 }
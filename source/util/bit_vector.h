@@ -19,6 +19,9 @@
 #include <iosfwd>
 #include <vector>
 
+#include "source/util/bitutils.h"
+#include "source/util/function_ref.h"
+
 namespace spvtools {
 namespace utils {
 
@@ -99,6 +102,21 @@ class BitVector {
     return true;
   }
 
+  // Returns the number of bits that are 1.
+  uint32_t Count() const;
+
+  // Calls |f| on the index of every bit that is 1, in increasing order.
+  void ForEachSetBit(FunctionRef<void(uint32_t)> f) const {
+    for (uint32_t i = 0; i < bits_.size(); ++i) {
+      BitContainer b = bits_[i];
+      while (b != 0) {
+        f(i * kBitContainerSize + CountTrailingZeros(b));
+        // Clear the lowest bit that is 1.
+        b &= b - 1;
+      }
+    }
+  }
+
   // Print a report on the densicy of the bit vector, number of 1 bits, number
   // of bytes, and average bytes for 1 bit, to |out|.
   void ReportDensity(std::ostream& out);
@@ -109,6 +127,14 @@ class BitVector {
   // |this|.  Return true if |this| changed.
   bool Or(const BitVector& that);
 
+  // Performs a bitwise-and operation on |this| and |that|, storing the result
+  // in |this|.  Return true if |this| changed.
+  bool And(const BitVector& that);
+
+  // Clears the bits of |this| that are set in |that|.  Return true if |this|
+  // changed.
+  bool AndNot(const BitVector& that);
+
  private:
   std::vector<BitContainer> bits_;
 };
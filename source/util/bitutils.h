@@ -97,6 +97,13 @@ template <typename T>
 size_t CountSetBits(T word) {
   static_assert(std::is_integral<T>::value,
                 "CountSetBits requires integer type");
+#if defined(__GNUC__)
+  if (sizeof(T) <= sizeof(unsigned long long)) {
+    using UnsignedT = typename std::make_unsigned<T>::type;
+    return static_cast<size_t>(__builtin_popcountll(
+        static_cast<unsigned long long>(static_cast<UnsignedT>(word))));
+  }
+#endif
   size_t count = 0;
   while (word) {
     word &= word - 1;
@@ -105,6 +112,22 @@ size_t CountSetBits(T word) {
   return count;
 }
 
+// Returns the number of '0' bits below the lowest '1' bit of |word|, which
+// must not be zero.
+inline uint32_t CountTrailingZeros(uint64_t word) {
+  assert(word != 0 && "The word must have a bit set");
+#if defined(__GNUC__)
+  return static_cast<uint32_t>(__builtin_ctzll(word));
+#else
+  uint32_t count = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++count;
+  }
+  return count;
+#endif
+}
+
 // Checks if the bit at the |position| is set to '1'.
 // Bits zero-indexed starting at the least significant bit.
 // |position| must be within the bit width of |T|.
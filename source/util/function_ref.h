@@ -0,0 +1,84 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_FUNCTION_REF_H_
+#define SOURCE_UTIL_FUNCTION_REF_H_
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace spvtools {
+namespace utils {
+
+template <typename Signature>
+class FunctionRef;
+
+// A reference to a callable object, such as a lambda, that is called with
+// |Args| and returns |R|.  Unlike std::function, it does not own or copy the
+// callable, so making one never allocates, and passing it costs two
+// pointers.  It is meant for the parameters of functions that call it before
+// they return, such as the visitors of the IR: the callable must outlive the
+// reference.
+//
+// Anything a std::function with the same signature accepts converts to it
+// implicitly, so a parameter of type FunctionRef accepts the same arguments
+// as one of type const std::function&.
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+  // True if |F| can be called with |Args| and its result converted to |R|.
+  template <typename F>
+  struct IsCompatible {
+    template <typename G>
+    static auto Test(int) -> decltype(
+        static_cast<R>(std::declval<G&>()(std::declval<Args>()...)),
+        std::true_type());
+    template <typename G>
+    static std::false_type Test(...);
+
+    static constexpr bool value = decltype(Test<F>(0))::value;
+  };
+
+ public:
+  template <typename F,
+            typename = typename std::enable_if<
+                !std::is_same<typename std::decay<F>::type,
+                              FunctionRef>::value &&
+                !std::is_function<
+                    typename std::remove_reference<F>::type>::value &&
+                IsCompatible<F>::value>::type>
+  FunctionRef(F&& callable)
+      : callable_(const_cast<void*>(
+            static_cast<const void*>(std::addressof(callable)))),
+        call_(&Call<typename std::remove_reference<F>::type>) {}
+
+  R operator()(Args... args) const {
+    return call_(callable_, std::forward<Args>(args)...);
+  }
+
+ private:
+  template <typename F>
+  static R Call(void* callable, Args... args) {
+    return static_cast<R>(
+        (*static_cast<F*>(callable))(std::forward<Args>(args)...));
+  }
+
+  void* callable_;
+  R (*call_)(void*, Args...);
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_FUNCTION_REF_H_
@@ -19,12 +19,14 @@
 #include <cctype>
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
 #include <iomanip>
 #include <limits>
 #include <sstream>
 #include <vector>
 
 #include "source/util/bitutils.h"
+#include "source/util/text_buffer.h"
 
 #ifndef __GNUC__
 #define GCC_VERSION 0
@@ -733,9 +735,9 @@ inline uint8_t get_nibble_from_character(int character) {
   return 0;
 }
 
-// Outputs the given HexFloat to the stream.
+// Appends the given HexFloat to |out|.
 template <typename T, typename Traits>
-std::ostream& operator<<(std::ostream& os, const HexFloat<T, Traits>& value) {
+void AppendHexFloat(const HexFloat<T, Traits>& value, TextBuffer* out) {
   using HF = HexFloat<T, Traits>;
   using uint_type = typename HF::uint_type;
   using int_type = typename HF::int_type;
@@ -788,22 +790,26 @@ std::ostream& operator<<(std::ostream& os, const HexFloat<T, Traits>& value) {
     --fraction_nibbles;
   }
 
-  const auto saved_flags = os.flags();
-  const auto saved_fill = os.fill();
-
-  os << sign << "0x" << (is_zero ? '0' : '1');
+  out->Append(sign);
+  out->Append("0x");
+  out->Append(is_zero ? '0' : '1');
   if (fraction_nibbles) {
     // Make sure to keep the leading 0s in place, since this is the fractional
     // part.
-    os << "." << std::setw(static_cast<int>(fraction_nibbles))
-       << std::setfill('0') << std::hex << fraction;
+    out->Append('.');
+    out->AppendHex(fraction, fraction_nibbles);
   }
-  os << "p" << std::dec << (int_exponent >= 0 ? "+" : "") << int_exponent;
-
-  os.flags(saved_flags);
-  os.fill(saved_fill);
+  out->Append('p');
+  if (int_exponent >= 0) out->Append('+');
+  out->AppendSigned(int_exponent);
+}
 
-  return os;
+// Outputs the given HexFloat to the stream.
+template <typename T, typename Traits>
+std::ostream& operator<<(std::ostream& os, const HexFloat<T, Traits>& value) {
+  TextBuffer text;
+  AppendHexFloat(value, &text);
+  return os.write(text.data(), static_cast<std::streamsize>(text.size()));
 }
 
 // Returns true if negate_value is true and the next character on the
@@ -1144,6 +1150,35 @@ inline std::ostream& operator<<<Float16>(std::ostream& os,
   return os;
 }
 
+// Appends the given FloatProxy to |out|, formatted as operator<< does on a
+// stream with default flags.
+template <typename T>
+void AppendFloatProxy(const FloatProxy<T>& value, TextBuffer* out) {
+  auto float_val = value.getAsFloat();
+  switch (std::fpclassify(float_val)) {
+    case FP_ZERO:
+    case FP_NORMAL: {
+      // Streams format floating point values as "%.*g" does, so this matches
+      // operator<< without going through a stream.
+      char text[64];
+      const int length =
+          std::snprintf(text, sizeof(text), "%.*g",
+                        std::numeric_limits<T>::max_digits10,
+                        static_cast<double>(float_val));
+      if (length > 0) out->Append(text, static_cast<size_t>(length));
+    } break;
+    default:
+      AppendHexFloat(HexFloat<FloatProxy<T>>(value), out);
+      break;
+  }
+}
+
+template <>
+inline void AppendFloatProxy<Float16>(const FloatProxy<Float16>& value,
+                                      TextBuffer* out) {
+  AppendHexFloat(HexFloat<FloatProxy<Float16>>(value), out);
+}
+
 }  // namespace utils
 }  // namespace spvtools
 
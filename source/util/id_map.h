@@ -0,0 +1,239 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_ID_MAP_H_
+#define SOURCE_UTIL_ID_MAP_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace spvtools {
+namespace utils {
+
+// The |IdMap| class is intended to be a drop-in replacement for
+// |std::unordered_map<uint32_t, T>| when the keys are SPIR-V ids or other
+// small positive integers, such as the unique ids of instructions. The values
+// are stored in a vector indexed by the id, so a lookup is a bounds check and
+// a single load.  Because id 0 is never a valid id, it is used to mark the
+// empty slots.
+//
+// The storage grows to cover the largest id inserted in the map.  Users that
+// know the id bound ahead of time should call |reserve| to avoid repeated
+// growth.
+//
+// Iterators visit the entries in increasing order of id, and remain valid
+// when the map grows.  References to the values do not.
+//
+// Note that only the public member functions from |std::unordered_map| that
+// are needed have been implemented.
+template <class T>
+class IdMap {
+ public:
+  using key_type = uint32_t;
+  using mapped_type = T;
+  // The |first| member of a value must not be modified.
+  using value_type = std::pair<uint32_t, T>;
+
+  template <class MapT, class ValueT>
+  class iterator_template {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ValueT;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ValueT*;
+    using reference = ValueT&;
+
+    iterator_template(MapT* map, uint32_t index) : map_(map), index_(index) {}
+
+    // Allows an iterator to be converted to a const_iterator.
+    template <class OtherMapT, class OtherValueT>
+    iterator_template(const iterator_template<OtherMapT, OtherValueT>& that)
+        : map_(that.map_), index_(that.index_) {}
+
+    reference operator*() const { return map_->slots_[index_]; }
+    pointer operator->() const { return &map_->slots_[index_]; }
+
+    iterator_template& operator++() {
+      index_ = map_->NextEntry(index_ + 1);
+      return *this;
+    }
+
+    iterator_template operator++(int) {
+      iterator_template old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const iterator_template& that) const {
+      return map_ == that.map_ && index_ == that.index_;
+    }
+    bool operator!=(const iterator_template& that) const {
+      return !(*this == that);
+    }
+
+   private:
+    template <class, class>
+    friend class iterator_template;
+    friend class IdMap;
+
+    MapT* map_;
+    uint32_t index_;
+  };
+
+  using iterator = iterator_template<IdMap, value_type>;
+  using const_iterator = iterator_template<const IdMap, const value_type>;
+
+  IdMap() : num_entries_(0) {}
+
+  iterator begin() { return iterator(this, NextEntry(0)); }
+  iterator end() { return iterator(this, kEndIndex); }
+  const_iterator begin() const { return const_iterator(this, NextEntry(0)); }
+  const_iterator end() const { return const_iterator(this, kEndIndex); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  bool empty() const { return num_entries_ == 0; }
+  size_t size() const { return num_entries_; }
+
+  // Returns the number of ids the storage has room for without growing.
+  size_t capacity() const { return slots_.capacity(); }
+
+  // Makes room for all of the ids less than |id_bound|.
+  void reserve(uint32_t id_bound) {
+    if (slots_.size() < id_bound) slots_.resize(id_bound);
+  }
+
+  void clear() {
+    slots_.clear();
+    num_entries_ = 0;
+  }
+
+  iterator find(uint32_t id) {
+    return Contains(id) ? iterator(this, id) : end();
+  }
+  const_iterator find(uint32_t id) const {
+    return Contains(id) ? const_iterator(this, id) : end();
+  }
+
+  size_t count(uint32_t id) const { return Contains(id) ? 1 : 0; }
+
+  T& at(uint32_t id) {
+    assert(Contains(id) && "Id is not in the map.");
+    return slots_[id].second;
+  }
+  const T& at(uint32_t id) const {
+    assert(Contains(id) && "Id is not in the map.");
+    return slots_[id].second;
+  }
+
+  // Returns the value for |id|, inserting a default value if there is none.
+  T& operator[](uint32_t id) { return Emplace(id).first->second; }
+
+  // Inserts |value| if there is no entry for its id.  Returns an iterator to
+  // the entry for the id, and whether the insertion took place.
+  std::pair<iterator, bool> insert(const value_type& value) {
+    auto result = Emplace(value.first);
+    if (result.second) result.first->second = value.second;
+    return result;
+  }
+  std::pair<iterator, bool> insert(value_type&& value) {
+    auto result = Emplace(value.first);
+    if (result.second) result.first->second = std::move(value.second);
+    return result;
+  }
+
+  // Removes the entry for |id|, if any.  Returns the number of entries
+  // removed.
+  size_t erase(uint32_t id) {
+    if (!Contains(id)) return 0;
+    slots_[id] = value_type();
+    --num_entries_;
+    return 1;
+  }
+
+  // Removes the entry at |pos|, and returns an iterator to the entry that
+  // follows it.
+  iterator erase(const_iterator pos) {
+    assert(pos.map_ == this && Contains(pos.index_));
+    uint32_t id = pos.index_;
+    slots_[id] = value_type();
+    --num_entries_;
+    return iterator(this, NextEntry(id + 1));
+  }
+
+  friend bool operator==(const IdMap& lhs, const IdMap& rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for (const auto& entry : lhs) {
+      auto it = rhs.find(entry.first);
+      if (it == rhs.end() || !(it->second == entry.second)) return false;
+    }
+    return true;
+  }
+  friend bool operator!=(const IdMap& lhs, const IdMap& rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  // The index of the iterators past the last entry.  It does not depend on
+  // the size of the storage, so that an end iterator remains valid when the
+  // map grows.
+  static constexpr uint32_t kEndIndex = std::numeric_limits<uint32_t>::max();
+
+  bool Contains(uint32_t id) const {
+    return id != 0 && id < slots_.size() && slots_[id].first == id;
+  }
+
+  // Returns the index of the first entry at or after |index|, or |kEndIndex|
+  // if there is none.
+  uint32_t NextEntry(uint32_t index) const {
+    for (; index < slots_.size(); ++index) {
+      if (slots_[index].first != 0) return index;
+    }
+    return kEndIndex;
+  }
+
+  // Creates an entry with a default value for |id| if there is none.  Returns
+  // an iterator to the entry, and whether it was created.
+  std::pair<iterator, bool> Emplace(uint32_t id) {
+    assert(id != 0 && id != kEndIndex && "Invalid id.");
+    if (id >= slots_.size()) {
+      // Grow geometrically so that inserting increasing ids, as they are
+      // created by |TakeNextId|, takes amortized constant time.
+      slots_.resize(std::max<size_t>(id + 1, 2 * slots_.size()));
+    }
+    bool inserted = false;
+    if (slots_[id].first == 0) {
+      slots_[id].first = id;
+      ++num_entries_;
+      inserted = true;
+    }
+    return {iterator(this, id), inserted};
+  }
+
+  std::vector<value_type> slots_;
+  size_t num_entries_;
+};
+
+template <class T>
+constexpr uint32_t IdMap<T>::kEndIndex;
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_ID_MAP_H_
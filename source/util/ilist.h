@@ -119,6 +119,10 @@ class IntrusiveList {
       list->sentinel_.next_node_ = &list->sentinel_;
       list->sentinel_.previous_node_ = &list->sentinel_;
 
+      for (NodeType* node = first_node; node != this->node_;
+           node = node->next_node_) {
+        node->OnInsertedInList(this->node_);
+      }
       return iterator(first_node);
     }
 
@@ -334,6 +338,11 @@ void IntrusiveList<NodeType>::Splice(iterator where,
   // Fixup other.
   first_prev->next_node_ = last.node_;
   last.node_->previous_node_ = first_prev;
+
+  for (NodeType* node = first.node_; node != where_next;
+       node = node->next_node_) {
+    node->OnInsertedInList(where_next);
+  }
 }
 
 template <class NodeType>
@@ -92,6 +92,13 @@ class IntrusiveNodeBase {
   // Returns true if |this| is the sentinel node of an empty list.
   bool IsEmptyList();
 
+  // Called by the list operations once |this| is linked into a list.  |next|
+  // is the first node after |this| that was already in place: the nodes
+  // between |this| and |next| were linked by the same operation, and are
+  // notified after |this|.  Node types that keep a state depending on their
+  // position in the list hide this with their own version.
+  void OnInsertedInList(NodeType* /* next */) {}
+
   // The pointers to the next and previous nodes in the list.
   // If the current node is not part of a list, then |next_node_| and
   // |previous_node_| are equal to |nullptr|.
@@ -179,6 +186,7 @@ inline void IntrusiveNodeBase<NodeType>::InsertBefore(NodeType* pos) {
   this->previous_node_ = pos->previous_node_;
   pos->previous_node_ = static_cast<NodeType*>(this);
   this->previous_node_->next_node_ = static_cast<NodeType*>(this);
+  static_cast<NodeType*>(this)->OnInsertedInList(pos);
 }
 
 template <class NodeType>
@@ -195,6 +203,7 @@ inline void IntrusiveNodeBase<NodeType>::InsertAfter(NodeType* pos) {
   this->next_node_ = pos->next_node_;
   pos->next_node_ = static_cast<NodeType*>(this);
   this->next_node_->previous_node_ = static_cast<NodeType*>(this);
+  static_cast<NodeType*>(this)->OnInsertedInList(this->next_node_);
 }
 
 template <class NodeType>
@@ -0,0 +1,95 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/interestingness_cache.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace spvtools {
+namespace utils {
+
+std::string InterestingnessCache::ComputeDigest(
+    const std::vector<uint32_t>& binary) {
+  // 64-bit FNV-1a, applied to whole words.
+  uint64_t fnv_hash = 14695981039346656037ULL;
+  // A multiply-xorshift hash, so that a collision in one hash is very unlikely
+  // to coincide with a collision in the other.
+  uint64_t mix_hash = 0x9E3779B97F4A7C15ULL;
+  for (uint32_t word : binary) {
+    fnv_hash = (fnv_hash ^ word) * 1099511628211ULL;
+    mix_hash = (mix_hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+    mix_hash ^= mix_hash >> 31;
+  }
+  std::stringstream stream;
+  stream << std::hex << std::setfill('0') << std::setw(8) << binary.size()
+         << std::setw(16) << fnv_hash << std::setw(16) << mix_hash;
+  return stream.str();
+}
+
+bool InterestingnessCache::Lookup(const std::string& digest, bool* verdict) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = verdicts_.find(digest);
+  if (it == verdicts_.end()) {
+    return false;
+  }
+  num_hits_++;
+  *verdict = it->second;
+  return true;
+}
+
+void InterestingnessCache::Insert(const std::string& digest, bool verdict) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  verdicts_[digest] = verdict;
+}
+
+size_t InterestingnessCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return verdicts_.size();
+}
+
+uint32_t InterestingnessCache::num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+bool InterestingnessCache::Load(std::istream* in) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string line;
+  while (std::getline(*in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::stringstream stream(line);
+    std::string digest;
+    int verdict;
+    std::string rest;
+    if (!(stream >> digest >> verdict) || (verdict != 0 && verdict != 1) ||
+        stream >> rest) {
+      return false;
+    }
+    verdicts_[digest] = verdict == 1;
+  }
+  return true;
+}
+
+void InterestingnessCache::Save(std::ostream* out) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& entry : verdicts_) {
+    *out << entry.first << " " << (entry.second ? 1 : 0) << "\n";
+  }
+}
+
+}  // namespace utils
+}  // namespace spvtools
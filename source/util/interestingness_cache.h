@@ -0,0 +1,85 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_INTERESTINGNESS_CACHE_H_
+#define SOURCE_UTIL_INTERESTINGNESS_CACHE_H_
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spvtools {
+namespace utils {
+
+// Remembers the verdict of an interestingness test for binaries that have
+// already been tested, so that a reducer or shrinker that arrives at the same
+// binary by a different route does not run the (typically expensive) test
+// again.  Binaries are identified by a digest of their words.
+//
+// The cache is only sound if the interestingness test is deterministic.
+//
+// All methods are thread-safe, so that the cache can be shared by concurrently
+// evaluated candidates.
+class InterestingnessCache {
+ public:
+  InterestingnessCache() : num_hits_(0) {}
+
+  // Disables copy/move constructor/assignment operations.
+  InterestingnessCache(const InterestingnessCache&) = delete;
+  InterestingnessCache(InterestingnessCache&&) = delete;
+  InterestingnessCache& operator=(const InterestingnessCache&) = delete;
+  InterestingnessCache& operator=(InterestingnessCache&&) = delete;
+
+  // Returns the digest by which |binary| is identified: the word count
+  // together with two independent 64-bit hashes of the words, as a string of
+  // hexadecimal digits.
+  static std::string ComputeDigest(const std::vector<uint32_t>& binary);
+
+  // If a verdict has been recorded for the binary with digest |digest|, stores
+  // it in |*verdict| and returns true.  Otherwise returns false.
+  bool Lookup(const std::string& digest, bool* verdict);
+
+  // Records |verdict| for the binary with digest |digest|, replacing any
+  // verdict that was already recorded.
+  void Insert(const std::string& digest, bool verdict);
+
+  // Returns the number of recorded verdicts.
+  size_t size() const;
+
+  // Returns the number of calls to Lookup that found a verdict.
+  uint32_t num_hits() const;
+
+  // Adds the verdicts written to |in| by Save to those already recorded.  The
+  // contents of several saved caches can be concatenated and loaded at once.
+  // Returns false, having loaded the verdicts that precede it, if a malformed
+  // line is encountered.
+  bool Load(std::istream* in);
+
+  // Writes all recorded verdicts to |out|, one "<digest> <0 or 1>" line per
+  // binary.
+  void Save(std::ostream* out) const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, bool> verdicts_;
+  uint32_t num_hits_;
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_INTERESTINGNESS_CACHE_H_
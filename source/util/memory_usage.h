@@ -0,0 +1,95 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_MEMORY_USAGE_H_
+#define SOURCE_UTIL_MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "source/util/id_map.h"
+#include "source/util/small_vector.h"
+
+namespace spvtools {
+namespace utils {
+
+// Each |MemoryUsage| function returns an approximation of the number of bytes
+// a container allocates on the heap, not counting the container object itself
+// or the memory its elements own.  The nodes of the node-based containers are
+// assumed to hold their value and as many pointers as the common standard
+// library implementations do; the allocator overhead is ignored.
+
+template <class T, class A>
+size_t MemoryUsage(const std::vector<T, A>& v) {
+  return v.capacity() * sizeof(T);
+}
+
+template <class T, size_t N>
+size_t MemoryUsage(const SmallVector<T, N>& v) {
+  return v.size() > N ? sizeof(std::vector<T>) + v.size() * sizeof(T) : 0;
+}
+
+template <class T>
+size_t MemoryUsage(const IdMap<T>& m) {
+  return m.capacity() * sizeof(typename IdMap<T>::value_type);
+}
+
+// Returns the bytes of a hash container |c|: its buckets, and a node per
+// element with the next pointer and the cached hash.
+template <class C>
+size_t HashContainerMemoryUsage(const C& c) {
+  return c.bucket_count() * sizeof(void*) +
+         c.size() * (sizeof(typename C::value_type) + 2 * sizeof(void*));
+}
+
+// Returns the bytes of a tree container |c|: a node per element with the
+// parent and child pointers and the color.
+template <class C>
+size_t TreeContainerMemoryUsage(const C& c) {
+  return c.size() * (sizeof(typename C::value_type) + 4 * sizeof(void*));
+}
+
+template <class K, class V, class H, class E, class A>
+size_t MemoryUsage(const std::unordered_map<K, V, H, E, A>& m) {
+  return HashContainerMemoryUsage(m);
+}
+
+template <class T, class H, class E, class A>
+size_t MemoryUsage(const std::unordered_set<T, H, E, A>& s) {
+  return HashContainerMemoryUsage(s);
+}
+
+template <class K, class V, class C, class A>
+size_t MemoryUsage(const std::map<K, V, C, A>& m) {
+  return TreeContainerMemoryUsage(m);
+}
+
+template <class K, class V, class C, class A>
+size_t MemoryUsage(const std::multimap<K, V, C, A>& m) {
+  return TreeContainerMemoryUsage(m);
+}
+
+template <class T, class C, class A>
+size_t MemoryUsage(const std::set<T, C, A>& s) {
+  return TreeContainerMemoryUsage(s);
+}
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_MEMORY_USAGE_H_
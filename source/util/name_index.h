@@ -0,0 +1,63 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_NAME_INDEX_H_
+#define SOURCE_UTIL_NAME_INDEX_H_
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "source/util/string_view.h"
+
+namespace spvtools {
+namespace utils {
+
+// An index of the names of the entries of a static table, such as the grammar
+// tables for opcodes, operands and extended instructions.  It maps each name to
+// the position of the first entry with that name, so looking up a name hashes
+// it once instead of comparing it with the name of every entry.
+//
+// The names are not copied, so they must outlive the index.  This holds for
+// the static tables this is meant for.
+class NameIndex {
+ public:
+  // Indexes the |name| members of the |count| entries starting at |entries|.
+  template <typename Entry>
+  NameIndex(const Entry* entries, size_t count) {
+    index_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      // |emplace| keeps the first of the entries with the same name.
+      index_.emplace(StringView(entries[i].name), i);
+    }
+  }
+
+  // Finds the first entry whose name is the |length| characters starting at
+  // |name|, which need not be null-terminated.  Returns true and writes the
+  // position of the entry to |position| if there is one.  Otherwise returns
+  // false.
+  bool Find(const char* name, size_t length, size_t* position) const {
+    auto it = index_.find(StringView(name, length));
+    if (it == index_.end()) return false;
+    *position = it->second;
+    return true;
+  }
+
+ private:
+  std::unordered_map<StringView, size_t, StringViewHash> index_;
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_NAME_INDEX_H_
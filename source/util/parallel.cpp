@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/parallel.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+// What the copies of the work that run on the tasks of an executor share.  It
+// is owned by the tasks as well as by |RunOnWorkers|, since a task may start
+// after |RunOnWorkers| has returned.
+struct WorkerState {
+  std::mutex mutex;
+  std::condition_variable finished;
+  // The work, which is null once the calling thread has finished its copy.
+  const std::function<void()>* work = nullptr;
+  // The number of tasks running a copy of the work.
+  size_t num_running = 0;
+};
+
+void RunWorkerTask(void* task_data) {
+  std::unique_ptr<std::shared_ptr<WorkerState>> owned_state(
+      static_cast<std::shared_ptr<WorkerState>*>(task_data));
+  WorkerState& state = **owned_state;
+  const std::function<void()>* work = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.work) return;
+    work = state.work;
+    ++state.num_running;
+  }
+  (*work)();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (--state.num_running == 0) state.finished.notify_all();
+}
+
+}  // namespace
+
+void RunOnWorkers(size_t num_workers, spv_executor_fn execute,
+                  void* execute_data, const std::function<void()>& work) {
+  if (num_workers <= 1) {
+    work();
+    return;
+  }
+
+  if (!execute) {
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < num_workers; ++i) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    return;
+  }
+
+  auto state = std::make_shared<WorkerState>();
+  state->work = &work;
+  for (size_t i = 1; i < num_workers; ++i) {
+    execute(execute_data, RunWorkerTask,
+            new std::shared_ptr<WorkerState>(state));
+  }
+  work();
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->work = nullptr;
+  state->finished.wait(lock, [&state]() { return state->num_running == 0; });
+}
+
+}  // namespace utils
+}  // namespace spvtools
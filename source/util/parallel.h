@@ -0,0 +1,65 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_PARALLEL_H_
+#define SOURCE_UTIL_PARALLEL_H_
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
+#include "spirv-tools/libspirv.h"
+
+namespace spvtools {
+namespace utils {
+
+// Runs |work| on the calling thread and on up to |num_workers| - 1 other
+// threads at the same time, and returns once every copy that started has
+// finished.  The other copies run on the tasks of |execute|, given
+// |execute_data|, if it is not null, and on new threads otherwise.
+//
+// A task that starts after the calling thread has finished its copy returns
+// at once, so that the calling thread never waits for a task still queued
+// behind it.  |work| must therefore share out its work between the copies as
+// they ask for it, for example by handing out indices from an atomic counter,
+// rather than give each copy a fixed part.
+void RunOnWorkers(size_t num_workers, spv_executor_fn execute,
+                  void* execute_data, const std::function<void()>& work);
+
+// Runs |f| on a task of |execute|, given |execute_data|, if it is not null,
+// and on a new thread otherwise, and returns the future of its result.
+template <typename T>
+std::future<T> RunAsync(spv_executor_fn execute, void* execute_data,
+                        std::function<T()> f) {
+  if (!execute) return std::async(std::launch::async, std::move(f));
+  std::unique_ptr<std::packaged_task<T()>> task(
+      new std::packaged_task<T()>(std::move(f)));
+  std::future<T> result = task->get_future();
+  execute(
+      execute_data,
+      [](void* task_data) {
+        std::unique_ptr<std::packaged_task<T()>> owned_task(
+            static_cast<std::packaged_task<T()>*>(task_data));
+        (*owned_task)();
+      },
+      task.release());
+  return result;
+}
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_PARALLEL_H_
@@ -15,9 +15,12 @@
 #ifndef SOURCE_UTIL_PARSE_NUMBER_H_
 #define SOURCE_UTIL_PARSE_NUMBER_H_
 
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <string>
 #include <tuple>
+#include <type_traits>
 
 #include "source/util/hex_float.h"
 #include "spirv-tools/libspirv.h"
@@ -160,12 +163,109 @@ bool CheckRangeAndIfHexThenSignExtend(T value, const NumberType& type,
   return true;
 }
 
+// Parses an integer of type T from |text| with the same rules as reading it
+// from an std::istringstream with std::setbase(0) in the "C" locale, but
+// without constructing a stream.  Leading white space is skipped, then an
+// optional sign is followed by an octal number with a leading 0, a hex number
+// with a leading 0x or 0X, or a decimal number.  A negative number read into
+// an unsigned type wraps around, as it does with a stream.  Returns false if
+// the text is not entirely a number or if the number is out of range.
+template <typename T>
+bool ParseInteger(const char* text, T* value_pointer) {
+  using UnsignedT = typename std::make_unsigned<T>::type;
+
+  const char* pos = text;
+  while (*pos == ' ' || (*pos >= '\t' && *pos <= '\r')) ++pos;
+
+  bool is_negative = false;
+  if (*pos == '+' || *pos == '-') {
+    is_negative = *pos == '-';
+    ++pos;
+  }
+
+  uint32_t base = 10;
+  if (pos[0] == '0') {
+    if (pos[1] == 'x' || pos[1] == 'X') {
+      base = 16;
+      pos += 2;
+    } else {
+      // The leading 0 is read as an octal digit.
+      base = 8;
+    }
+  }
+
+  // The largest magnitude that can be represented.
+  UnsignedT limit = std::numeric_limits<UnsignedT>::max();
+  if (std::is_signed<T>::value) {
+    limit = static_cast<UnsignedT>(std::numeric_limits<T>::max());
+    if (is_negative) ++limit;
+  }
+
+  UnsignedT magnitude = 0;
+  bool has_digits = false;
+  bool overflow = false;
+  for (;; ++pos) {
+    uint32_t digit;
+    if (*pos >= '0' && *pos <= '9') {
+      digit = *pos - '0';
+    } else if (*pos >= 'a' && *pos <= 'f') {
+      digit = *pos - 'a' + 10;
+    } else if (*pos >= 'A' && *pos <= 'F') {
+      digit = *pos - 'A' + 10;
+    } else {
+      break;
+    }
+    if (digit >= base) break;
+    has_digits = true;
+    if (magnitude > (limit - digit) / base) {
+      overflow = true;
+    } else {
+      magnitude = static_cast<UnsignedT>(magnitude * base + digit);
+    }
+  }
+
+  if (!has_digits || overflow || *pos != 0) return false;
+
+  if (!is_negative || magnitude == 0) {
+    *value_pointer = static_cast<T>(magnitude);
+  } else if (std::is_signed<T>::value) {
+    *value_pointer = static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+  } else {
+    *value_pointer = static_cast<T>(UnsignedT(0) - magnitude);
+  }
+  return true;
+}
+
+// Parses a numeric value of a given type from the given text.  The number
+// should take up the entire string, and should be within bounds for the target
+// type. On success, returns true and populates the object referenced by
+// value_pointer. On failure, returns false.
+//
+// This overload handles the integer types, without using a stream.
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value, bool>::type ParseNumber(
+    const char* text, T* value_pointer) {
+  static_assert(sizeof(T) > 1,
+                "Single-byte types are not supported in this parse method");
+
+  if (!text) return false;
+  bool ok = ParseInteger(text, value_pointer);
+
+  // ParseInteger wraps negative numbers around for unsigned types, so "-1"
+  // is parsed for uint16_t as 65535.  Reject it.
+  if (ok && text[0] == '-')
+    ok = !ClampToZeroIfUnsignedType<T>::Clamp(value_pointer);
+
+  return ok;
+}
+
 // Parses a numeric value of a given type from the given text.  The number
 // should take up the entire string, and should be within bounds for the target
 // type. On success, returns true and populates the object referenced by
 // value_pointer. On failure, returns false.
 template <typename T>
-bool ParseNumber(const char* text, T* value_pointer) {
+typename std::enable_if<!std::is_integral<T>::value, bool>::type ParseNumber(
+    const char* text, T* value_pointer) {
   // C++11 doesn't define std::istringstream(int8_t&), so calling this method
   // with a single-byte type leads to implementation-defined behaviour.
   // Similarly for uint8_t.
@@ -383,6 +383,16 @@ class SmallVector {
     }
   }
 
+  void reserve(size_t new_cap) {
+    if (!large_data_ && new_cap > small_size) {
+      MoveToLargeData();
+    }
+
+    if (large_data_) {
+      large_data_->reserve(new_cap);
+    }
+  }
+
   template <class... Args>
   void emplace_back(Args&&... args) {
     if (!large_data_ && size_ == small_size) {
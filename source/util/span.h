@@ -0,0 +1,72 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_SPAN_H_
+#define SOURCE_UTIL_SPAN_H_
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace spvtools {
+namespace utils {
+
+// A view of a contiguous sequence of |T| owned by someone else.  This is the
+// part of std::span the tools need, since they are built as C++11.
+template <typename T>
+class Span {
+ public:
+  using value_type = T;
+  using iterator = T*;
+  using const_iterator = T*;
+
+  Span() : data_(nullptr), size_(0) {}
+  Span(T* data, size_t size) : data_(data), size_(size) {}
+  template <size_t N>
+  Span(T (&values)[N]) : data_(values), size_(N) {}
+  template <typename U>
+  Span(const std::vector<U>& values)
+      : data_(values.data()), size_(values.size()) {}
+
+  T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator begin() const { return data_; }
+  iterator end() const { return data_ + size_; }
+  const_iterator cbegin() const { return data_; }
+  const_iterator cend() const { return data_ + size_; }
+
+  T& front() const {
+    assert(size_ > 0);
+    return data_[0];
+  }
+  T& back() const {
+    assert(size_ > 0);
+    return data_[size_ - 1];
+  }
+  T& operator[](size_t i) const {
+    assert(i < size_);
+    return data_[i];
+  }
+
+ private:
+  T* data_;
+  size_t size_;
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_SPAN_H_
@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_STRING_VIEW_H_
+#define SOURCE_UTIL_STRING_VIEW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace spvtools {
+namespace utils {
+
+// A view of a sequence of characters owned by someone else, which need not be
+// null-terminated.  This is the part of std::string_view the tools need, since
+// they are built as C++11.
+class StringView {
+ public:
+  StringView() : data_(nullptr), size_(0) {}
+  StringView(const char* data, size_t size) : data_(data), size_(size) {}
+  // Views the null-terminated string |str|, without its terminator.
+  StringView(const char* str) : data_(str), size_(std::strlen(str)) {}
+  StringView(const std::string& str) : data_(str.data()), size_(str.size()) {}
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+
+  char front() const { return data_[0]; }
+  char operator[](size_t i) const { return data_[i]; }
+
+  // Returns a copy of the viewed characters.
+  std::string str() const { return std::string(data_, size_); }
+
+  friend bool operator==(StringView lhs, StringView rhs) {
+    return lhs.size_ == rhs.size_ &&
+           (lhs.size_ == 0 ||
+            std::memcmp(lhs.data_, rhs.data_, lhs.size_) == 0);
+  }
+  friend bool operator!=(StringView lhs, StringView rhs) {
+    return !(lhs == rhs);
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+// The 32-bit FNV-1a hash of the viewed characters, for use in unordered
+// containers keyed by StringView.
+struct StringViewHash {
+  size_t operator()(StringView view) const {
+    uint32_t hash = 2166136261u;
+    for (char c : view) {
+      hash ^= static_cast<unsigned char>(c);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_STRING_VIEW_H_
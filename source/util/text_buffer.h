@@ -0,0 +1,119 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_UTIL_TEXT_BUFFER_H_
+#define SOURCE_UTIL_TEXT_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace spvtools {
+namespace utils {
+
+// An append-only buffer of text.  Unlike a std::ostream, it has no formatting
+// state, and numbers are formatted directly into the buffer, so appending to it
+// does not allocate unless the buffer has to grow.
+class TextBuffer {
+ public:
+  TextBuffer() = default;
+  TextBuffer(TextBuffer&&) = default;
+  TextBuffer& operator=(TextBuffer&&) = default;
+
+  // Appends the |length| characters starting at |text|.
+  void Append(const char* text, size_t length) { data_.append(text, length); }
+
+  // Appends the null-terminated string |text|.
+  void Append(const char* text) { Append(text, std::strlen(text)); }
+
+  // Appends |text|.
+  void Append(const std::string& text) { data_.append(text); }
+
+  // Appends the text of |other|.
+  void Append(const TextBuffer& other) { data_.append(other.data_); }
+
+  // Appends the character |c|.
+  void Append(char c) { data_.push_back(c); }
+
+  // Appends |count| copies of the character |c|.
+  void AppendRepeated(char c, size_t count) { data_.append(count, c); }
+
+  // Appends the decimal representation of |value|.
+  void AppendUnsigned(uint64_t value) {
+    char digits[kMaxDigits];
+    char* begin = digits + kMaxDigits;
+    do {
+      *--begin = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value);
+    Append(begin, static_cast<size_t>(digits + kMaxDigits - begin));
+  }
+
+  // Appends the decimal representation of |value|, with a leading '-' if it
+  // is negative.
+  void AppendSigned(int64_t value) {
+    if (value < 0) {
+      Append('-');
+      // Negate in unsigned arithmetic, which is also defined for the most
+      // negative value.
+      AppendUnsigned(0 - static_cast<uint64_t>(value));
+    } else {
+      AppendUnsigned(static_cast<uint64_t>(value));
+    }
+  }
+
+  // Appends the lower case hexadecimal representation of |value|, without a
+  // prefix, padded with leading zeros to at least |min_width| digits.
+  void AppendHex(uint64_t value, size_t min_width = 0) {
+    char digits[kMaxDigits];
+    char* begin = digits + kMaxDigits;
+    size_t width = 0;
+    do {
+      *--begin = "0123456789abcdef"[value & 0xf];
+      value >>= 4;
+      ++width;
+    } while (value);
+    if (width < min_width) AppendRepeated('0', min_width - width);
+    Append(begin, width);
+  }
+
+  // Ensures that |capacity| characters fit in the buffer without growing it.
+  void Reserve(size_t capacity) { data_.reserve(capacity); }
+
+  // Removes all the text, but keeps the storage for reuse.
+  void Clear() { data_.clear(); }
+
+  // Returns the text appended so far.  It is not null-terminated.
+  const char* data() const { return data_.data(); }
+
+  // Returns the number of characters appended so far.
+  size_t size() const { return data_.size(); }
+
+  bool empty() const { return data_.empty(); }
+
+  // Returns a copy of the text appended so far.
+  std::string str() const { return data_; }
+
+ private:
+  // Enough digits for any 64-bit value in base 10 or 16.
+  static const size_t kMaxDigits = 20;
+
+  std::string data_;
+};
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // SOURCE_UTIL_TEXT_BUFFER_H_
@@ -18,14 +18,86 @@
 
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <string>
 
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
 namespace spvtools {
 namespace utils {
+namespace {
+
+// The column headers of the hardware counters, indexed by the position of
+// their bit in HardwareCounter.
+const char* const kHardwareCounterNames[kNumHardwareCounters] = {
+    "instructions", "cache misses", "branch misses"};
+
+// Opens the hardware counter at |index| in HardwareCounter for the calling
+// thread, disabled.  Returns its file descriptor, or -1 if it is not
+// available.
+int OpenHardwareCounter(int index) {
+#if defined(__linux__) && defined(__NR_perf_event_open)
+  static const uint64_t kConfigs[kNumHardwareCounters] = {
+      PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES};
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = kConfigs[index];
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+  (void)index;
+  return -1;
+#endif
+}
+
+void CloseHardwareCounter(int fd) {
+#if defined(__linux__)
+  close(fd);
+#else
+  (void)fd;
+#endif
+}
 
-void PrintTimerDescription(std::ostream* out, bool measure_mem_usage) {
+void StartHardwareCounter(int fd) {
+#if defined(__linux__)
+  ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+  ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#else
+  (void)fd;
+#endif
+}
+
+// Stops the hardware counter |fd| and returns its value, or -1 if it cannot be
+// read.
+long StopHardwareCounter(int fd) {
+#if defined(__linux__)
+  ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  uint64_t value = 0;
+  if (read(fd, &value, sizeof(value)) != sizeof(value)) return -1;
+  return static_cast<long>(value);
+#else
+  (void)fd;
+  return -1;
+#endif
+}
+
+}  // namespace
+
+void PrintTimerDescription(std::ostream* out, bool measure_mem_usage,
+                           unsigned hardware_counters) {
   if (out) {
     *out << std::setw(30) << "PASS name" << std::setw(12) << "CPU time"
          << std::setw(12) << "WALL time" << std::setw(12) << "USR time"
@@ -33,13 +105,33 @@ void PrintTimerDescription(std::ostream* out, bool measure_mem_usage) {
     if (measure_mem_usage) {
       *out << std::setw(12) << "RSS delta" << std::setw(16) << "PGFault delta";
     }
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      if (hardware_counters & (1u << i)) {
+        *out << std::setw(16) << kHardwareCounterNames[i];
+      }
+    }
     *out << std::endl;
   }
 }
 
+Timer::~Timer() {
+  for (int i = 0; i < kNumHardwareCounters; ++i) {
+    if (counter_fds_[i] != -1) CloseHardwareCounter(counter_fds_[i]);
+  }
+}
+
+long Timer::HardwareCount(HardwareCounter counter) const {
+  for (int i = 0; i < kNumHardwareCounters; ++i) {
+    if (counter == (1 << i)) return counter_values_[i];
+  }
+  return -1;
+}
+
 // Do not change the order of invoking system calls. We want to make CPU/Wall
 // time correct as much as possible. Calling functions to get CPU/Wall time must
 // closely surround the target code of measuring.
+// The hardware counters are started last and stopped first for the same
+// reason.
 void Timer::Start() {
   if (report_stream_) {
     if (getrusage(RUSAGE_SELF, &usage_before_) == -1)
@@ -48,12 +140,23 @@ void Timer::Start() {
       usage_status_ |= kClockGettimeWalltimeFailed;
     if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_before_) == -1)
       usage_status_ |= kClockGettimeCPUtimeFailed;
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      if (!(hardware_counters_ & (1u << i))) continue;
+      if (counter_fds_[i] == -1) counter_fds_[i] = OpenHardwareCounter(i);
+      if (counter_fds_[i] != -1) StartHardwareCounter(counter_fds_[i]);
+    }
   }
 }
 
 // The order of invoking system calls is important with the same reason as
 // Timer::Start().
 void Timer::Stop() {
+  if (report_stream_) {
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      counter_values_[i] =
+          counter_fds_[i] == -1 ? -1 : StopHardwareCounter(counter_fds_[i]);
+    }
+  }
   if (report_stream_ && usage_status_ == kSucceeded) {
     if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_after_) == -1)
       usage_status_ |= kClockGettimeCPUtimeFailed;
@@ -93,6 +196,15 @@ void Timer::Report(const char* tag) {
                       << PageFault();
     }
   }
+
+  for (int i = 0; i < kNumHardwareCounters; ++i) {
+    if (!(hardware_counters_ & (1u << i))) continue;
+    const long count = HardwareCount(static_cast<HardwareCounter>(1 << i));
+    if (count < 0)
+      *report_stream_ << std::setw(16) << "n/a";
+    else
+      *report_stream_ << std::setw(16) << count;
+  }
   *report_stream_ << std::endl;
 }
 
@@ -17,6 +17,25 @@
 #ifndef SOURCE_UTIL_TIMER_H_
 #define SOURCE_UTIL_TIMER_H_
 
+namespace spvtools {
+namespace utils {
+
+// The hardware performance counters Timer can measure in addition to the
+// times, as bits of a mask.  They are read with perf_event_open() on Linux,
+// and are reported as unavailable elsewhere or when the kernel does not allow
+// them.
+enum HardwareCounter {
+  kHardwareCounterInstructions = 1 << 0,
+  kHardwareCounterCacheMisses = 1 << 1,
+  kHardwareCounterBranchMisses = 1 << 2,
+};
+
+// The number of hardware counters in HardwareCounter.
+constexpr int kNumHardwareCounters = 3;
+
+}  // namespace utils
+}  // namespace spvtools
+
 #if defined(SPIRV_TIMER_ENABLED)
 
 #include <sys/resource.h>
@@ -58,10 +77,11 @@ namespace utils {
 // Prints the description of resource types measured by Timer class. If |out| is
 // NULL, it does nothing. Otherwise, it prints resource types. The second is
 // optional and if it is true, the function also prints resource type fields
-// related to memory. Its default is false. In usual, this must be placed before
-// calling Timer::Report() to inform what those fields printed by
+// related to memory. Its default is false. The third is an optional mask of the
+// HardwareCounter fields to print, none by default. In usual, this must be
+// placed before calling Timer::Report() to inform what those fields printed by
 // Timer::Report() indicate.
-void PrintTimerDescription(std::ostream*, bool = false);
+void PrintTimerDescription(std::ostream*, bool = false, unsigned = 0);
 
 // Status of Timer. kGetrusageFailed means it failed in calling getrusage().
 // kClockGettimeWalltimeFailed means it failed in getting wall time when calling
@@ -78,8 +98,9 @@ enum UsageStatus {
 // utilization consists of CPU time (i.e., process time), WALL time (elapsed
 // time), USR time, SYS time, RSS delta, and the delta of the number of page
 // faults. RSS delta and the delta of the number of page faults are measured
-// only when |measure_mem_usage| given to the constructor is true. This class
-// should be used as the following example:
+// only when |measure_mem_usage| given to the constructor is true. The hardware
+// counters in the |hardware_counters| mask given to the constructor are
+// measured too. This class should be used as the following example:
 //
 //   spvtools::utils::Timer timer(std::cout);
 //   timer.Start();       // <-- set |usage_before_|, |wall_before_|,
@@ -93,21 +114,33 @@ enum UsageStatus {
 //                               std::cout.
 class Timer {
  public:
-  Timer(std::ostream* out, bool measure_mem_usage = false)
+  Timer(std::ostream* out, bool measure_mem_usage = false,
+        unsigned hardware_counters = 0)
       : report_stream_(out),
         usage_status_(kSucceeded),
-        measure_mem_usage_(measure_mem_usage) {}
+        measure_mem_usage_(measure_mem_usage),
+        hardware_counters_(hardware_counters) {
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      counter_fds_[i] = -1;
+      counter_values_[i] = -1;
+    }
+  }
+
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
 
   // Sets |usage_before_|, |wall_before_|, and |cpu_before_| as results of
   // getrusage(), clock_gettime() for the wall time, and clock_gettime() for the
-  // CPU time respectively. Note that this method erases all previous state of
-  // |usage_before_|, |wall_before_|, |cpu_before_|.
+  // CPU time respectively, and resets and starts the hardware counters. Note
+  // that this method erases all previous state of |usage_before_|,
+  // |wall_before_|, |cpu_before_|.
   virtual void Start();
 
-  // Sets |cpu_after_|, |wall_after_|, and |usage_after_| as results of
-  // clock_gettime() for the wall time, and clock_gettime() for the CPU time,
-  // getrusage() respectively. Note that this method erases all previous state
-  // of |cpu_after_|, |wall_after_|, |usage_after_|.
+  // Stops the hardware counters, and sets |cpu_after_|, |wall_after_|, and
+  // |usage_after_| as results of clock_gettime() for the wall time, and
+  // clock_gettime() for the CPU time, getrusage() respectively. Note that this
+  // method erases all previous state of |cpu_after_|, |wall_after_|,
+  // |usage_after_|.
   virtual void Stop();
 
   // If |report_stream_| is NULL, it does nothing. Otherwise, it prints the
@@ -166,7 +199,15 @@ class Timer {
            (usage_after_.ru_majflt - usage_before_.ru_majflt);
   }
 
-  virtual ~Timer() {}
+  // Returns the value of the hardware counter |counter| for a range of code
+  // execution.  If the counter was not requested or cannot be read on this
+  // system, it returns -1.
+  virtual long HardwareCount(HardwareCounter counter) const;
+
+  // Returns the mask of the hardware counters requested from this timer.
+  unsigned hardware_counters() const { return hardware_counters_; }
+
+  virtual ~Timer();
 
  private:
   // Returns the time gap between |from| and |to| in seconds.
@@ -222,6 +263,18 @@ class Timer {
   // If true, Timer reports the memory usage information too. Otherwise, Timer
   // reports only USR time, WALL time, SYS time.
   bool measure_mem_usage_;
+
+  // The mask of the hardware counters to measure and report.
+  unsigned hardware_counters_;
+
+  // The file descriptors of the hardware counters, indexed by the position of
+  // their bit in HardwareCounter, or -1 for those that are not open.  They are
+  // opened by the first call to Start().
+  int counter_fds_[kNumHardwareCounters];
+
+  // The values of the hardware counters read by Stop(), or -1 for those that
+  // could not be read.
+  long counter_values_[kNumHardwareCounters];
 };
 
 // The purpose of ScopedTimer is to measure the resource utilization for a
@@ -249,8 +302,9 @@ template <class TimerType>
 class ScopedTimer {
  public:
   ScopedTimer(std::ostream* out, const char* tag,
-              bool measure_mem_usage = false)
-      : timer(new TimerType(out, measure_mem_usage)), tag_(tag) {
+              bool measure_mem_usage = false, unsigned hardware_counters = 0)
+      : timer(new TimerType(out, measure_mem_usage, hardware_counters)),
+        tag_(tag) {
     timer->Start();
   }
 
@@ -293,14 +347,17 @@ class ScopedTimer {
 //
 class CumulativeTimer : public Timer {
  public:
-  CumulativeTimer(std::ostream* out, bool measure_mem_usage = false)
-      : Timer(out, measure_mem_usage),
+  CumulativeTimer(std::ostream* out, bool measure_mem_usage = false,
+                  unsigned hardware_counters = 0)
+      : Timer(out, measure_mem_usage, hardware_counters),
         cpu_time_(0),
         wall_time_(0),
         usr_time_(0),
         sys_time_(0),
         rss_(0),
-        pgfaults_(0) {}
+        pgfaults_(0) {
+    for (int i = 0; i < kNumHardwareCounters; ++i) counts_[i] = 0;
+  }
 
   // If we cannot get a resource usage because of failures, it sets -1 for the
   // resource usage.
@@ -336,6 +393,15 @@ class CumulativeTimer : public Timer {
       pgfaults_ += Timer::PageFault();
     else
       pgfaults_ = -1;
+
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      const long count =
+          Timer::HardwareCount(static_cast<HardwareCounter>(1 << i));
+      if (counts_[i] >= 0 && count >= 0)
+        counts_[i] += count;
+      else
+        counts_[i] = -1;
+    }
   }
 
   // Returns the cumulative CPU Time (i.e., process time) for a range of code
@@ -359,6 +425,15 @@ class CumulativeTimer : public Timer {
   // execution.
   long PageFault() const override { return pgfaults_; }
 
+  // Returns the cumulative value of the hardware counter |counter| for a range
+  // of code execution.
+  long HardwareCount(HardwareCounter counter) const override {
+    for (int i = 0; i < kNumHardwareCounters; ++i) {
+      if (counter == (1 << i)) return counts_[i];
+    }
+    return -1;
+  }
+
  private:
   // Variable to save the cumulative CPU time (i.e., process time).
   double cpu_time_;
@@ -377,6 +452,10 @@ class CumulativeTimer : public Timer {
 
   // Variable to save the cumulative delta of the number of page faults.
   long pgfaults_;
+
+  // Variables to save the cumulative values of the hardware counters, indexed
+  // by the position of their bit in HardwareCounter.
+  long counts_[kNumHardwareCounters];
 };
 
 }  // namespace utils
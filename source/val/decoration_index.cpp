@@ -0,0 +1,117 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/val/decoration_index.h"
+
+#include <algorithm>
+
+namespace spvtools {
+namespace val {
+
+const uint32_t DecorationIndex::kNoSlot;
+
+void DecorationIndex::Add(uint32_t id, const Decoration& dec) {
+  Entry& entry = GetOrCreateEntry(id);
+  const uint32_t position = static_cast<uint32_t>(entry.decorations.size());
+  entry.decorations.push_back(dec);
+  entry.kinds[dec.dec_type()].push_back(position);
+  if (dec.struct_member_index() != Decoration::kInvalidMember) {
+    const size_t member = static_cast<size_t>(dec.struct_member_index());
+    if (member >= entry.members.size()) entry.members.resize(member + 1);
+    entry.members[member].push_back(dec);
+  }
+}
+
+void DecorationIndex::AddUnique(uint32_t id, const Decoration& dec) {
+  if (const Entry* entry = FindEntry(id)) {
+    const auto kind = entry->kinds.find(dec.dec_type());
+    if (kind != entry->kinds.end()) {
+      for (uint32_t position : kind->second) {
+        if (entry->decorations[position] == dec) return;
+      }
+    }
+  }
+  Add(id, dec);
+}
+
+const std::vector<Decoration>& DecorationIndex::Get(uint32_t id) const {
+  const Entry* entry = FindEntry(id);
+  return entry ? entry->decorations : empty_;
+}
+
+const std::vector<Decoration>& DecorationIndex::GetForMember(
+    uint32_t id, uint32_t member_index) const {
+  const Entry* entry = FindEntry(id);
+  if (!entry || member_index >= entry->members.size()) return empty_;
+  return entry->members[member_index];
+}
+
+const Decoration* DecorationIndex::Find(uint32_t id,
+                                        SpvDecoration kind) const {
+  const Entry* entry = FindEntry(id);
+  if (!entry) return nullptr;
+  const auto it = entry->kinds.find(kind);
+  if (it == entry->kinds.end()) return nullptr;
+  return &entry->decorations[it->second.front()];
+}
+
+const Decoration* DecorationIndex::FindForMember(uint32_t id,
+                                                 uint32_t member_index,
+                                                 SpvDecoration kind) const {
+  for (const auto& dec : GetForMember(id, member_index)) {
+    if (dec.dec_type() == kind) return &dec;
+  }
+  return nullptr;
+}
+
+std::vector<uint32_t> DecorationIndex::DecoratedIds() const {
+  std::vector<uint32_t> ids;
+  ids.reserve(entries_.size());
+  for (uint32_t id = 0; id < slots_.size(); ++id) {
+    if (slots_[id] != kNoSlot) ids.push_back(id);
+  }
+  // Overflow ids are all above the dense ones.
+  const size_t num_dense = ids.size();
+  for (const auto& slot : overflow_slots_) ids.push_back(slot.first);
+  std::sort(ids.begin() + num_dense, ids.end());
+  return ids;
+}
+
+const DecorationIndex::Entry* DecorationIndex::FindEntry(uint32_t id) const {
+  uint32_t slot = kNoSlot;
+  if (id < slots_.size()) {
+    slot = slots_[id];
+  } else {
+    const auto it = overflow_slots_.find(id);
+    if (it != overflow_slots_.end()) slot = it->second;
+  }
+  return slot == kNoSlot ? nullptr : &entries_[slot];
+}
+
+DecorationIndex::Entry& DecorationIndex::GetOrCreateEntry(uint32_t id) {
+  uint32_t* slot = nullptr;
+  if (id < slots_.size()) {
+    slot = &slots_[id];
+  } else {
+    slot = &overflow_slots_.emplace(id, kNoSlot).first->second;
+  }
+  if (*slot == kNoSlot) {
+    *slot = static_cast<uint32_t>(entries_.size());
+    entries_.emplace_back();
+  }
+  return entries_[*slot];
+}
+
+}  // namespace val
+}  // namespace spvtools
@@ -0,0 +1,114 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SOURCE_VAL_DECORATION_INDEX_H_
+#define SOURCE_VAL_DECORATION_INDEX_H_
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "source/latest_version_spirv_header.h"
+#include "source/val/decoration.h"
+
+namespace spvtools {
+namespace val {
+
+// The decorations of every <id> in a module, indexed so that the questions
+// asked by the decoration and built-in checks are answered without scanning.
+//
+// Decorations are stored per <id> in the order they were added.  Ids below the
+// bound given to Reserve() are looked up through a dense table; larger ids,
+// which only occur in invalid modules, go through a hash map.  On top of that
+// the decorations of each <id> are bucketed by kind and, for member
+// decorations, by member index.
+//
+// References returned by the accessors stay valid while decorations are added
+// to other ids.
+class DecorationIndex {
+ public:
+  DecorationIndex() = default;
+  DecorationIndex(const DecorationIndex&) = delete;
+  DecorationIndex& operator=(const DecorationIndex&) = delete;
+
+  // Makes ids below |id_bound| use the dense table.
+  void Reserve(uint32_t id_bound) {
+    if (id_bound > slots_.size()) slots_.resize(id_bound, kNoSlot);
+  }
+
+  // Adds |dec| to the decorations of |id|.
+  void Add(uint32_t id, const Decoration& dec);
+
+  // Adds |dec| to the decorations of |id| unless |id| already has an equal
+  // decoration.
+  void AddUnique(uint32_t id, const Decoration& dec);
+
+  // Returns all the decorations of |id|, in the order they were added.
+  const std::vector<Decoration>& Get(uint32_t id) const;
+
+  // Returns the decorations of member |member_index| of the structure |id|.
+  const std::vector<Decoration>& GetForMember(uint32_t id,
+                                              uint32_t member_index) const;
+
+  // Returns true if |id|, or one of its members, is decorated with |kind|.
+  bool Has(uint32_t id, SpvDecoration kind) const {
+    return Find(id, kind) != nullptr;
+  }
+
+  // Returns the first decoration of |id|, or of one of its members, with the
+  // given |kind|.  Returns nullptr if there is none.
+  const Decoration* Find(uint32_t id, SpvDecoration kind) const;
+
+  // Returns the first decoration of member |member_index| of the structure
+  // |id| with the given |kind|.  Returns nullptr if there is none.
+  const Decoration* FindForMember(uint32_t id, uint32_t member_index,
+                                  SpvDecoration kind) const;
+
+  // Returns the ids that have at least one decoration, in increasing order.
+  std::vector<uint32_t> DecoratedIds() const;
+
+ private:
+  static const uint32_t kNoSlot = ~0u;
+
+  struct Entry {
+    // All the decorations of the id.
+    std::vector<Decoration> decorations;
+    // The positions in |decorations| of each kind of decoration.
+    std::unordered_map<uint32_t, std::vector<uint32_t>> kinds;
+    // The member decorations, by member index.
+    std::vector<std::vector<Decoration>> members;
+  };
+
+  // Returns the entry of |id|, or nullptr if |id| has no decorations.
+  const Entry* FindEntry(uint32_t id) const;
+
+  // Returns the entry of |id|, creating it if needed.
+  Entry& GetOrCreateEntry(uint32_t id);
+
+  // Returns the slot in |entries_| of each id, or kNoSlot.
+  std::vector<uint32_t> slots_;
+  // Slots of the ids that do not fit in |slots_|.
+  std::unordered_map<uint32_t, uint32_t> overflow_slots_;
+  // A deque so that growing it does not move the existing entries.
+  std::deque<Entry> entries_;
+
+  // Returned for ids and members without decorations.
+  const std::vector<Decoration> empty_;
+};
+
+}  // namespace val
+}  // namespace spvtools
+
+#endif  // SOURCE_VAL_DECORATION_INDEX_H_
@@ -305,14 +305,18 @@ int Function::GetBlockDepth(BasicBlock* bb) {
   }
   // Only calculate the depth if it's not already calculated.
   // This function uses memoization to avoid duplicate CFG depth calculations.
-  if (block_depth_.find(bb) != block_depth_.end()) {
-    return block_depth_[bb];
+  // The entry is 0 while the depth is being calculated, which ends the
+  // recursion if the depths of invalid blocks depend on each other.
+  auto inserted = block_depth_.emplace(bb, 0);
+  if (!inserted.second) {
+    return inserted.first->second;
   }
 
+  int depth = 0;
   BasicBlock* bb_dom = bb->immediate_dominator();
   if (!bb_dom || bb == bb_dom) {
     // This block has no dominator, so it's at depth 0.
-    block_depth_[bb] = 0;
+    depth = 0;
   } else if (bb->is_type(kBlockTypeContinue)) {
     // This rule must precede the rule for merge blocks in order to set up
     // depths correctly. If a block is both a merge and continue then the merge
@@ -330,25 +334,26 @@ int Function::GetBlockDepth(BasicBlock* bb) {
     // In such cases, the depth of the continue block is: 1 + depth of the
     // loop's dominator block.
     if (loop_header == bb) {
-      block_depth_[bb] = 1 + GetBlockDepth(bb_dom);
+      depth = 1 + GetBlockDepth(bb_dom);
     } else {
-      block_depth_[bb] = 1 + GetBlockDepth(loop_header);
+      depth = 1 + GetBlockDepth(loop_header);
     }
   } else if (bb->is_type(kBlockTypeMerge)) {
     // If this is a merge block, its depth is equal to the block before
     // branching.
     BasicBlock* header = merge_block_header_[bb];
     assert(header);
-    block_depth_[bb] = GetBlockDepth(header);
+    depth = GetBlockDepth(header);
   } else if (bb_dom->is_type(kBlockTypeSelection) ||
              bb_dom->is_type(kBlockTypeLoop)) {
     // The dominator of the given block is a header block. So, the nesting
     // depth of this block is: 1 + nesting depth of the header.
-    block_depth_[bb] = 1 + GetBlockDepth(bb_dom);
+    depth = 1 + GetBlockDepth(bb_dom);
   } else {
-    block_depth_[bb] = GetBlockDepth(bb_dom);
+    depth = GetBlockDepth(bb_dom);
   }
-  return block_depth_[bb];
+  block_depth_[bb] = depth;
+  return depth;
 }
 
 void Function::RegisterExecutionModelLimitation(SpvExecutionModel model,
@@ -224,6 +224,14 @@ class Function {
   bool CheckLimitations(const ValidationState_t& _, const Function* entry_point,
                         std::string* reason) const;
 
+  /// Returns true, and records |opcode|, if the limitations that only depend
+  /// on the opcode of the instructions with |opcode| have not been registered
+  /// for this function yet.  Lets a check register them once per function
+  /// instead of once per instruction.
+  bool RegisterOpcodeLimitations(SpvOp opcode) {
+    return opcodes_with_limitations_.insert(opcode).second;
+  }
+
   /// Returns true if the given execution model passes the limitations stored in
   /// execution_model_limitations_. Returns false otherwise and fills optional
   /// |reason| parameter.
@@ -236,7 +244,7 @@ class Function {
   }
 
   // Returns a set with ids of all functions called from this function.
-  const std::set<uint32_t> function_call_targets() const {
+  const std::set<uint32_t>& function_call_targets() const {
     return function_call_targets_;
   }
 
@@ -392,6 +400,9 @@ class Function {
 
   /// Stores ids of all functions called from this function.
   std::set<uint32_t> function_call_targets_;
+
+  /// The opcodes passed to RegisterOpcodeLimitations.
+  std::unordered_set<uint32_t> opcodes_with_limitations_;
 };
 
 }  // namespace val
@@ -15,13 +15,17 @@
 #include "source/val/validate.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "source/binary.h"
@@ -34,7 +38,10 @@
 #include "source/spirv_constant.h"
 #include "source/spirv_endian.h"
 #include "source/spirv_target_env.h"
+#include "source/spirv_validation_cache.h"
 #include "source/spirv_validator_options.h"
+#include "source/util/parallel.h"
+#include "source/util/span.h"
 #include "source/val/construct.h"
 #include "source/val/function.h"
 #include "source/val/instruction.h"
@@ -84,10 +91,25 @@ spv_result_t ProcessExtensions(void* user_data,
   return SPV_REQUESTED_TERMINATION;
 }
 
+// The number of instructions checked between two calls to the cancellation
+// function of the validator options.
+const size_t kInstructionsPerCancelCheck = 1024;
+
+// Returns SPV_ERROR_CANCELLED, and reports it, if the cancellation function of
+// the validator options of |_| says that the validation should stop.
+spv_result_t CheckCancelled(ValidationState_t& _) {
+  if (!_.options()->IsCancelled()) return SPV_SUCCESS;
+  return _.diag(SPV_ERROR_CANCELLED, nullptr)
+         << "The validation was cancelled.";
+}
+
 spv_result_t ProcessInstruction(void* user_data,
                                 const spv_parsed_instruction_t* inst) {
   ValidationState_t& _ = *(reinterpret_cast<ValidationState_t*>(user_data));
 
+  if (_.ordered_instructions().size() % kInstructionsPerCancelCheck == 0) {
+    if (auto error = CheckCancelled(_)) return error;
+  }
   auto* instruction = _.AddOrderedInstruction(inst);
   _.RegisterDebugInstruction(instruction);
 
@@ -171,10 +193,9 @@ spv_result_t ValidateEntryPointNamesUnique(ValidationState_t& _) {
 //
 // Additionally enforces that entry points for Vulkan and WebGPU should not have
 // recursion. And that entry names should be unique for WebGPU.
+// Expects the function to entry point mapping and the recursive entry points
+// of |_| to be computed.
 spv_result_t ValidateEntryPoints(ValidationState_t& _) {
-  _.ComputeFunctionToEntryPointMapping();
-  _.ComputeRecursiveEntryPoints();
-
   if (_.entry_points().empty() && !_.HasCapability(SpvCapabilityLinkage)) {
     return _.diag(SPV_ERROR_INVALID_BINARY, nullptr)
            << "No OpEntryPoint instruction was found. This is only allowed if "
@@ -209,6 +230,332 @@ spv_result_t ValidateEntryPoints(ValidationState_t& _) {
   return SPV_SUCCESS;
 }
 
+// Returns SPV_ERROR_BUDGET_EXCEEDED, and reports it to |consumer|, if the
+// module of |_| exceeds one of the budget limits of its validator options.
+// The limits are checked against the counts taken before the module is
+// parsed, so that a module that is too large fails before any work is done.
+spv_result_t CheckBudget(const ValidationState_t& _,
+                         const MessageConsumer& consumer) {
+  if (!_.ExceedsBudget()) return SPV_SUCCESS;
+
+  const validator_universal_limits_t& limits = _.options()->universal_limits_;
+  const spv_position_t position = {};
+  if (_.total_instructions() > limits.max_instructions) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_BUDGET_EXCEEDED)
+           << "The module has " << _.total_instructions()
+           << " instructions, more than the limit of "
+           << limits.max_instructions << ".";
+  }
+  if (_.max_function_blocks() > limits.max_function_blocks) {
+    return DiagnosticStream(position, consumer, "", SPV_ERROR_BUDGET_EXCEEDED)
+           << "A function of the module has " << _.max_function_blocks()
+           << " blocks, more than the limit of " << limits.max_function_blocks
+           << ".";
+  }
+  return DiagnosticStream(position, consumer, "", SPV_ERROR_BUDGET_EXCEEDED)
+         << "Validating the module needs at least "
+         << (_.EstimatedMemoryUse() + 1023) / 1024
+         << " KiB, more than the limit of " << limits.max_memory_kib << " KiB.";
+}
+
+// Runs |check| on the units of work numbered 0 to |count| - 1, on up to the
+// number of threads set in the validator options.  The diagnostics of the
+// units are reported in order, up to and including those of the first unit
+// that fails, whose error is returned.  As long as the checks of different
+// units do not depend on each other, these are the diagnostics of running the
+// checks one unit after the other.  If |costs| is not empty, it holds an
+// estimate of the cost of each unit, and the units that cost the most are
+// started first, so that a large unit started late does not keep the others
+// waiting.  The cancellation function of the validator options is called
+// before each unit.
+spv_result_t RunChecksInParallel(
+    ValidationState_t& _, size_t count,
+    const std::function<spv_result_t(size_t)>& check,
+    const std::vector<size_t>& costs = std::vector<size_t>()) {
+  const size_t num_workers = std::min<size_t>(_.options()->num_threads, count);
+  if (num_workers <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      if (auto error = CheckCancelled(_)) return error;
+      if (auto error = check(i)) return error;
+    }
+    return SPV_SUCCESS;
+  }
+
+  // The units in the order they are started.
+  std::vector<size_t> order(count);
+  std::iota(order.begin(), order.end(), size_t(0));
+  if (!costs.empty()) {
+    assert(costs.size() == count);
+    std::stable_sort(order.begin(), order.end(), [&costs](size_t a, size_t b) {
+      return costs[a] > costs[b];
+    });
+  }
+
+  std::vector<DiagnosticCollector> diagnostics(count);
+  std::vector<spv_result_t> results(count, SPV_SUCCESS);
+  std::atomic<size_t> next_unit(0);
+  // Units after the first one that failed so far do not need to be checked.
+  std::atomic<size_t> first_failure(count);
+  auto run_checks = [&]() {
+    for (size_t next = next_unit++; next < count; next = next_unit++) {
+      const size_t i = order[next];
+      if (i >= first_failure) continue;
+      DiagnosticCollector::Scope scope(&diagnostics[i]);
+      results[i] = CheckCancelled(_);
+      if (results[i] == SPV_SUCCESS) results[i] = check(i);
+      if (results[i] == SPV_SUCCESS) continue;
+      size_t failure = first_failure;
+      while (i < failure && !first_failure.compare_exchange_weak(failure, i)) {
+      }
+    }
+  };
+
+  utils::RunOnWorkers(num_workers, _.options()->executor,
+                      _.options()->executor_data, run_checks);
+
+  for (size_t i = 0; i < count; ++i) {
+    _.ReportDiagnostics(diagnostics[i]);
+    if (results[i] != SPV_SUCCESS) return results[i];
+  }
+  return SPV_SUCCESS;
+}
+
+// Calls the stage report function of the validator options of |_|, if it has
+// one, with |stage|, |seconds| and |num_instructions|.
+void ReportStage(const ValidationState_t& _, const char* stage, double seconds,
+                 size_t num_instructions) {
+  const spv_validator_options_t* options = _.options();
+  if (options->stage_report) {
+    options->stage_report(options->stage_report_data, stage, seconds,
+                          num_instructions);
+  }
+}
+
+// Reports the stages of the validation that check the whole module at once,
+// if the validator options of |_| have a stage report function.  A stage lasts
+// from its start to the start of the next one, or to the destruction of the
+// reporter, and is reported with the number of instructions of the module at
+// its end.
+class StageReporter {
+ public:
+  explicit StageReporter(const ValidationState_t& _) : _(_), stage_(nullptr) {}
+  ~StageReporter() { Finish(); }
+
+  // Finishes the current stage, if any, and starts |stage|.
+  void Start(const char* stage) {
+    Finish();
+    if (!_.options()->stage_report) return;
+    stage_ = stage;
+    start_ = std::chrono::steady_clock::now();
+  }
+
+  // Finishes the current stage, if any.
+  void Finish() {
+    if (!stage_) return;
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start_;
+    ReportStage(_, stage_, elapsed.count(), _.ordered_instructions().size());
+    stage_ = nullptr;
+  }
+
+ private:
+  const ValidationState_t& _;
+  const char* stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// A stage of the validation that checks the whole module, made of |num_units|
+// units of work that are checked by |check|.  A stage that checks the whole
+// module at once has a single unit, and no |unit_costs|.  Otherwise
+// |unit_costs| may point to an estimate of the cost of each unit, in
+// instructions.
+struct ModuleStage {
+  const char* stage;
+  size_t num_units;
+  std::function<spv_result_t(size_t)> check;
+  const std::vector<size_t>* unit_costs;
+};
+
+// Runs the units of all the |stages| with RunChecksInParallel, so that the
+// diagnostics are those of running the stages in order, one after the other.
+// The stages must neither depend on each other nor update the state of |_|
+// read by another stage.  The time of a stage is reported as the sum of the
+// times of its units, for the stages up to and including the first one that
+// fails.  A unit without a cost estimate is taken to cost as much as checking
+// every instruction of the module.
+spv_result_t RunStagesInParallel(ValidationState_t& _,
+                                 const std::vector<ModuleStage>& stages) {
+  // The stage and the unit of the stage of each unit of work.
+  std::vector<std::pair<size_t, size_t>> units;
+  std::vector<size_t> costs;
+  for (size_t stage = 0; stage < stages.size(); ++stage) {
+    const std::vector<size_t>* unit_costs = stages[stage].unit_costs;
+    for (size_t unit = 0; unit < stages[stage].num_units; ++unit) {
+      units.emplace_back(stage, unit);
+      costs.push_back(unit_costs ? (*unit_costs)[unit]
+                                 : _.ordered_instructions().size());
+    }
+  }
+
+  if (!_.options()->stage_report) {
+    return RunChecksInParallel(
+        _, units.size(),
+        [&](size_t i) { return stages[units[i].first].check(units[i].second); },
+        costs);
+  }
+
+  std::vector<double> seconds(units.size(), 0.0);
+  std::vector<spv_result_t> results(units.size(), SPV_SUCCESS);
+  const spv_result_t result =
+      RunChecksInParallel(_, units.size(), [&](size_t i) {
+        const auto start = std::chrono::steady_clock::now();
+        results[i] = stages[units[i].first].check(units[i].second);
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        seconds[i] = elapsed.count();
+        return results[i];
+      },
+      costs);
+
+  std::vector<double> stage_seconds(stages.size(), 0.0);
+  size_t num_reported = stages.size();
+  for (size_t i = 0; i < units.size(); ++i) {
+    stage_seconds[units[i].first] += seconds[i];
+    if (results[i] != SPV_SUCCESS) {
+      num_reported = units[i].first + 1;
+      break;
+    }
+  }
+  for (size_t stage = 0; stage < num_reported; ++stage) {
+    ReportStage(_, stages[stage].stage, stage_seconds[stage],
+                _.ordered_instructions().size());
+  }
+  return result;
+}
+
+// A check of individual instructions, and the name of the stage its time is
+// reported as.
+struct InstructionCheck {
+  const char* stage;
+  spv_result_t (*check)(ValidationState_t&, const Instruction*);
+};
+
+// The checks of the individual opcodes.  Keep these passes in the order they
+// appear in the SPIR-V specification sections to maintain test consistency.
+const InstructionCheck kOpcodeChecks[] = {
+    {"misc", MiscPass},
+    {"debug", DebugPass},
+    {"annotation", AnnotationPass},
+    {"extension", ExtensionPass},
+    {"mode-setting", ModeSettingPass},
+    {"type", TypePass},
+    {"constant", ConstantPass},
+    {"memory", MemoryPass},
+    {"function", FunctionPass},
+    {"image", ImagePass},
+    {"conversion", ConversionPass},
+    {"composites", CompositesPass},
+    {"arithmetics", ArithmeticsPass},
+    {"bitwise", BitwisePass},
+    {"logicals", LogicalsPass},
+    {"control-flow", ControlFlowPass},
+    {"derivatives", DerivativesPass},
+    {"atomics", AtomicsPass},
+    {"primitives", PrimitivesPass},
+    {"barriers", BarriersPass},
+    // Group
+    // Device-Side Enqueue
+    // Pipe
+    {"non-uniform", NonUniformPass},
+    {"literals", LiteralsPass},
+};
+
+// The checks of the individual opcodes in the structural profile: those of
+// the types, constants, functions and control flow instructions.
+const InstructionCheck kStructuralOpcodeChecks[] = {
+    {"type", TypePass},
+    {"constant", ConstantPass},
+    {"function", FunctionPass},
+    {"control-flow", ControlFlowPass},
+};
+
+// The checks that depend on the limitations registered by the checks of the
+// individual opcodes.
+const InstructionCheck kLimitationChecks[] = {
+    {"execution-limitations", ValidateExecutionLimitations},
+    {"small-type-uses", ValidateSmallTypeUses},
+};
+
+// The time spent in a check of individual instructions, and the number of
+// instructions it checked, which may be updated from several threads.
+struct InstructionCheckStats {
+  std::atomic<uint64_t> nanoseconds{0};
+  std::atomic<size_t> num_instructions{0};
+};
+
+// Runs |checks| on every instruction of the module, in order.  The
+// instructions before the first function are checked on the calling thread,
+// because their checks update the state of the whole module.  The checks of
+// the instructions of a function only update the state of that function, so
+// the functions are checked with RunChecksInParallel.  |function_starts| holds
+// the index of the first instruction of each function, followed by the number
+// of instructions, and |function_sizes| the number of instructions of each
+// function.
+spv_result_t CheckInstructions(ValidationState_t& _,
+                               const std::vector<size_t>& function_starts,
+                               const std::vector<size_t>& function_sizes,
+                               utils::Span<const InstructionCheck> checks) {
+  // The checks are only timed when they are reported.
+  std::vector<InstructionCheckStats> stats(
+      _.options()->stage_report ? checks.size() : 0);
+  const auto check_instruction = [&](const Instruction* inst) {
+    if (stats.empty()) {
+      for (const auto& check : checks) {
+        if (auto error = check.check(_, inst)) return error;
+      }
+      return SPV_SUCCESS;
+    }
+    for (size_t i = 0; i < checks.size(); ++i) {
+      const auto start = std::chrono::steady_clock::now();
+      const spv_result_t result = checks[i].check(_, inst);
+      const auto elapsed = std::chrono::steady_clock::now() - start;
+      stats[i].nanoseconds +=
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      ++stats[i].num_instructions;
+      if (result != SPV_SUCCESS) return result;
+    }
+    return SPV_SUCCESS;
+  };
+
+  const auto& instructions = _.ordered_instructions();
+  spv_result_t result = SPV_SUCCESS;
+  for (size_t i = 0; i < function_starts.front() && result == SPV_SUCCESS;
+       ++i) {
+    if (i % kInstructionsPerCancelCheck == 0) result = CheckCancelled(_);
+    if (result == SPV_SUCCESS) result = check_instruction(&instructions[i]);
+  }
+  if (result == SPV_SUCCESS) {
+    result = RunChecksInParallel(
+        _, function_starts.size() - 1, [&](size_t function) -> spv_result_t {
+          const size_t begin = function_starts[function];
+          for (size_t i = begin; i < function_starts[function + 1]; ++i) {
+            if (i > begin && (i - begin) % kInstructionsPerCancelCheck == 0) {
+              if (auto error = CheckCancelled(_)) return error;
+            }
+            if (auto error = check_instruction(&instructions[i])) return error;
+          }
+          return SPV_SUCCESS;
+        },
+        function_sizes);
+  }
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    ReportStage(_, checks[i].stage, stats[i].nanoseconds * 1e-9,
+                stats[i].num_instructions);
+  }
+  return result;
+}
+
 spv_result_t ValidateBinaryUsingContextAndValidationState(
     const spv_context_t& context, const uint32_t* words, const size_t num_words,
     spv_diagnostic* pDiagnostic, ValidationState_t* vstate) {
@@ -253,6 +600,11 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
            << vstate->options()->universal_limits_.max_id_bound << ".";
   }
 
+  if (auto error = CheckBudget(*vstate, context.consumer)) return error;
+
+  StageReporter stages(*vstate);
+  stages.Start("parse");
+
   // Look for OpExtension instructions and register extensions.
   // This parse should not produce any error messages. Hijack the context and
   // replace the message consumer so that we do not pollute any state in input
@@ -272,8 +624,13 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
     return error;
   }
 
+  stages.Start("inline-checks");
   std::vector<Instruction*> visited_entry_points;
+  size_t num_checked = 0;
   for (auto& instruction : vstate->ordered_instructions()) {
+    if (num_checked++ % kInstructionsPerCancelCheck == 0) {
+      if (auto error = CheckCancelled(*vstate)) return error;
+    }
     {
       // In order to do this work outside of Process Instruction we need to be
       // able to, briefly, de-const the instruction.
@@ -367,11 +724,35 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
            << "Missing OpFunctionEnd at end of module.";
 
   // Catch undefined forward references before performing further checks.
+  stages.Start("forward-decls");
   if (auto error = ValidateForwardDecls(*vstate)) return error;
 
+  // The functions are checked in parallel below, largest first.  Their
+  // number of instructions is the estimate of the cost of checking them.
+  std::vector<size_t> function_starts;
+  for (size_t i = 0; i < vstate->ordered_instructions().size(); ++i) {
+    if (vstate->ordered_instructions()[i].opcode() == SpvOpFunction) {
+      function_starts.push_back(i);
+    }
+  }
+  function_starts.push_back(vstate->ordered_instructions().size());
+  std::vector<size_t> function_sizes;
+  for (size_t i = 0; i + 1 < function_starts.size(); ++i) {
+    function_sizes.push_back(function_starts[i + 1] - function_starts[i]);
+  }
+  assert(function_sizes.size() == vstate->functions().size());
+
   // Calculate reachability after all the blocks are parsed, but early that it
   // can be relied on in subsequent pases.
-  ReachabilityPass(*vstate);
+  stages.Start("reachability");
+  if (auto error = RunChecksInParallel(
+          *vstate, vstate->functions().size(),
+          [vstate](size_t function) {
+            ReachabilityPass(*vstate, &vstate->functions()[function]);
+            return SPV_SUCCESS;
+          },
+          function_sizes))
+    return error;
 
   // ID usage needs be handled in its own iteration of the instructions,
   // between the two others. It depends on the first loop to have been
@@ -381,65 +762,74 @@ spv_result_t ValidateBinaryUsingContextAndValidationState(
   // It should also live after the forward declaration check, since it will
   // have problems with missing forward declarations, but give less useful error
   // messages.
+  stages.Start("id-uses");
   for (size_t i = 0; i < vstate->ordered_instructions().size(); ++i) {
+    if (i % kInstructionsPerCancelCheck == 0) {
+      if (auto error = CheckCancelled(*vstate)) return error;
+    }
     auto& instruction = vstate->ordered_instructions()[i];
     if (auto error = UpdateIdUse(*vstate, &instruction)) return error;
   }
 
   // Validate individual opcodes.
-  for (size_t i = 0; i < vstate->ordered_instructions().size(); ++i) {
-    auto& instruction = vstate->ordered_instructions()[i];
-
-    // Keep these passes in the order they appear in the SPIR-V specification
-    // sections to maintain test consistency.
-    if (auto error = MiscPass(*vstate, &instruction)) return error;
-    if (auto error = DebugPass(*vstate, &instruction)) return error;
-    if (auto error = AnnotationPass(*vstate, &instruction)) return error;
-    if (auto error = ExtensionPass(*vstate, &instruction)) return error;
-    if (auto error = ModeSettingPass(*vstate, &instruction)) return error;
-    if (auto error = TypePass(*vstate, &instruction)) return error;
-    if (auto error = ConstantPass(*vstate, &instruction)) return error;
-    if (auto error = MemoryPass(*vstate, &instruction)) return error;
-    if (auto error = FunctionPass(*vstate, &instruction)) return error;
-    if (auto error = ImagePass(*vstate, &instruction)) return error;
-    if (auto error = ConversionPass(*vstate, &instruction)) return error;
-    if (auto error = CompositesPass(*vstate, &instruction)) return error;
-    if (auto error = ArithmeticsPass(*vstate, &instruction)) return error;
-    if (auto error = BitwisePass(*vstate, &instruction)) return error;
-    if (auto error = LogicalsPass(*vstate, &instruction)) return error;
-    if (auto error = ControlFlowPass(*vstate, &instruction)) return error;
-    if (auto error = DerivativesPass(*vstate, &instruction)) return error;
-    if (auto error = AtomicsPass(*vstate, &instruction)) return error;
-    if (auto error = PrimitivesPass(*vstate, &instruction)) return error;
-    if (auto error = BarriersPass(*vstate, &instruction)) return error;
-    // Group
-    // Device-Side Enqueue
-    // Pipe
-    if (auto error = NonUniformPass(*vstate, &instruction)) return error;
+  stages.Finish();
+  const bool full_profile =
+      vstate->options()->profile == spv_validator_profile_full;
+  utils::Span<const InstructionCheck> opcode_checks = kOpcodeChecks;
+  if (!full_profile) opcode_checks = kStructuralOpcodeChecks;
+  if (auto error = CheckInstructions(*vstate, function_starts, function_sizes,
+                                     opcode_checks))
+    return error;
 
-    if (auto error = LiteralsPass(*vstate, &instruction)) return error;
-  }
+  // The entry points of the functions are read by the stages below, so they
+  // are computed before these run in parallel.
+  vstate->ComputeFunctionToEntryPointMapping();
+  vstate->ComputeRecursiveEntryPoints();
+
+  // The adjacency check validates the preconditions involving adjacent
+  // instructions. e.g. SpvOpPhi must only be preceeded by SpvOpLabel, SpvOpPhi,
+  // or SpvOpLine.  CFG checks are performed after the binary has been parsed
+  // and the CFGPass has collected information about the control flow; they
+  // only update the state of the function they check.
+  const auto module_stage =
+      [vstate](spv_result_t (*check)(ValidationState_t&)) {
+        return [vstate, check](size_t) { return check(*vstate); };
+      };
+  if (auto error = RunStagesInParallel(
+          *vstate,
+          {{"adjacency", 1, module_stage(ValidateAdjacency), nullptr},
+           {"entry-points", 1, module_stage(ValidateEntryPoints), nullptr},
+           {"cfg", vstate->functions().size(),
+            [vstate](size_t function) {
+              return PerformCfgChecks(*vstate,
+                                      &vstate->functions()[function]);
+            },
+            &function_sizes}}))
+    return error;
+  // The dominance check uses the dominators computed by the CFG checks.
+  stages.Start("dominance");
+  if (auto error = CheckCancelled(*vstate)) return error;
+  if (auto error = CheckIdDefinitionDominateUse(*vstate)) return error;
+  stages.Finish();
 
-  // Validate the preconditions involving adjacent instructions. e.g. SpvOpPhi
-  // must only be preceeded by SpvOpLabel, SpvOpPhi, or SpvOpLine.
-  if (auto error = ValidateAdjacency(*vstate)) return error;
+  // The remaining checks are not part of the structural profile.
+  if (!full_profile) return SPV_SUCCESS;
 
-  if (auto error = ValidateEntryPoints(*vstate)) return error;
-  // CFG checks are performed after the binary has been parsed
-  // and the CFGPass has collected information about the control flow
-  if (auto error = PerformCfgChecks(*vstate)) return error;
-  if (auto error = CheckIdDefinitionDominateUse(*vstate)) return error;
-  if (auto error = ValidateDecorations(*vstate)) return error;
-  if (auto error = ValidateInterfaces(*vstate)) return error;
+  // The uniform blocks and storage buffers registered by the decoration checks
+  // are only read by these checks.
   // TODO(dsinclair): Restructure ValidateBuiltins so we can move into the
   // for() above as it loops over all ordered_instructions internally.
-  if (auto error = ValidateBuiltIns(*vstate)) return error;
+  if (auto error = RunStagesInParallel(
+          *vstate,
+          {{"decorations", 1, module_stage(ValidateDecorations), nullptr},
+           {"interfaces", 1, module_stage(ValidateInterfaces), nullptr},
+           {"built-ins", 1, module_stage(ValidateBuiltIns), nullptr}}))
+    return error;
   // These checks must be performed after individual opcode checks because
   // those checks register the limitation checked here.
-  for (const auto& inst : vstate->ordered_instructions()) {
-    if (auto error = ValidateExecutionLimitations(*vstate, &inst)) return error;
-    if (auto error = ValidateSmallTypeUses(*vstate, &inst)) return error;
-  }
+  if (auto error = CheckInstructions(*vstate, function_starts, function_sizes,
+                                     kLimitationChecks))
+    return error;
 
   return SPV_SUCCESS;
 }
@@ -463,6 +853,29 @@ spv_result_t ValidateBinaryAndKeepValidationState(
       hijack_context, words, num_words, pDiagnostic, vstate->get());
 }
 
+spv_result_t ValidateWithOptionsAndKeepValidationState(
+    const spv_const_context context, spv_const_validator_options options,
+    const uint32_t* words, const size_t num_words, spv_diagnostic* pDiagnostic,
+    std::unique_ptr<ValidationState_t>* vstate) {
+  vstate->reset();
+  if (pDiagnostic) *pDiagnostic = nullptr;
+
+  // Modules the cache knows to be valid are not validated again.
+  std::string cache_key;
+  if (options->cache) {
+    cache_key = spv_validation_cache_t::Key(context->target_env, options,
+                                            words, num_words);
+    if (options->cache->Contains(cache_key)) return SPV_SUCCESS;
+  }
+
+  const spv_result_t result = ValidateBinaryAndKeepValidationState(
+      context, options, words, num_words, pDiagnostic, vstate);
+  if (options->cache && result == SPV_SUCCESS) {
+    options->cache->Insert(cache_key);
+  }
+  return result;
+}
+
 }  // namespace val
 }  // namespace spvtools
 
@@ -502,17 +915,7 @@ spv_result_t spvValidateWithOptions(const spv_const_context context,
                                     spv_const_validator_options options,
                                     const spv_const_binary binary,
                                     spv_diagnostic* pDiagnostic) {
-  spv_context_t hijack_context = *context;
-  if (pDiagnostic) {
-    *pDiagnostic = nullptr;
-    spvtools::UseDiagnosticAsMessageConsumer(&hijack_context, pDiagnostic);
-  }
-
-  // Create the ValidationState using the context.
-  spvtools::val::ValidationState_t vstate(&hijack_context, options,
-                                          binary->code, binary->wordCount,
-                                          kDefaultMaxNumOfWarnings);
-
-  return spvtools::val::ValidateBinaryUsingContextAndValidationState(
-      hijack_context, binary->code, binary->wordCount, pDiagnostic, &vstate);
+  std::unique_ptr<spvtools::val::ValidationState_t> vstate;
+  return spvtools::val::ValidateWithOptionsAndKeepValidationState(
+      context, options, binary->code, binary->wordCount, pDiagnostic, &vstate);
 }
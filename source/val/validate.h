@@ -29,6 +29,7 @@ namespace val {
 
 class ValidationState_t;
 class BasicBlock;
+class Function;
 class Instruction;
 
 /// A function that returns a vector of BasicBlocks given a BasicBlock. Used to
@@ -36,12 +37,16 @@ class Instruction;
 using get_blocks_func =
     std::function<const std::vector<BasicBlock*>*(const BasicBlock*)>;
 
-/// @brief Performs the Control Flow Graph checks
+/// @brief Performs the Control Flow Graph checks of a function
+///
+/// Only reads and updates the state of |function|, so the checks of different
+/// functions can run on different threads.
 ///
 /// @param[in] _ the validation state of the module
+/// @param[in] function the function to check
 ///
 /// @return SPV_SUCCESS if no errors are found. SPV_ERROR_INVALID_CFG otherwise
-spv_result_t PerformCfgChecks(ValidationState_t& _);
+spv_result_t PerformCfgChecks(ValidationState_t& _, Function* function);
 
 /// @brief Updates the use vectors of all instructions that can be referenced
 ///
@@ -197,8 +202,10 @@ spv_result_t FunctionPass(ValidationState_t& _, const Instruction* inst);
 /// Validates correctness of miscellaneous instructions.
 spv_result_t MiscPass(ValidationState_t& _, const Instruction* inst);
 
-/// Calculates the reachability of basic blocks.
-void ReachabilityPass(ValidationState_t& _);
+/// Calculates the reachability of the basic blocks of |function|.  Only the
+/// blocks of |function| are updated, so the functions of a module can be
+/// handled in parallel.
+void ReachabilityPass(ValidationState_t& _, Function* function);
 
 /// Validates execution limitations.
 ///
@@ -236,6 +243,16 @@ spv_result_t ValidateBinaryAndKeepValidationState(
     const uint32_t* words, const size_t num_words, spv_diagnostic* pDiagnostic,
     std::unique_ptr<ValidationState_t>* vstate);
 
+// Same as ValidateBinaryAndKeepValidationState, but like
+// spvValidateWithOptions it looks the module up in the validation cache of
+// |options| first, and records it there if it is valid.  If the cache already
+// knows the module to be valid, the module is not parsed, SPV_SUCCESS is
+// returned and |vstate| is left null.
+spv_result_t ValidateWithOptionsAndKeepValidationState(
+    const spv_const_context context, spv_const_validator_options options,
+    const uint32_t* words, const size_t num_words, spv_diagnostic* pDiagnostic,
+    std::unique_ptr<ValidationState_t>* vstate);
+
 }  // namespace val
 }  // namespace spvtools
 
@@ -498,7 +498,11 @@ class BuiltInsValidator {
   const std::vector<uint32_t>* entry_points_ = &no_entry_points;
 
   // Execution models with which the current function can be called.
-  std::set<SpvExecutionModel> execution_models_;
+  // The pointer either points to a vector owned by the validation state or to
+  // no_execution_models_. The pointer is guaranteed to never be null.
+  const std::vector<SpvExecutionModel> no_execution_models_;
+  const std::vector<SpvExecutionModel>* execution_models_ =
+      &no_execution_models_;
 };
 
 void BuiltInsValidator::Update(const Instruction& inst) {
@@ -507,15 +511,10 @@ void BuiltInsValidator::Update(const Instruction& inst) {
     // Entering a function.
     assert(function_id_ == 0);
     function_id_ = inst.id();
-    execution_models_.clear();
     entry_points_ = &_.FunctionEntryPoints(function_id_);
-    // Collect execution models from all entry points from which the current
-    // function can be called.
-    for (const uint32_t entry_point : *entry_points_) {
-      if (const auto* models = _.GetExecutionModels(entry_point)) {
-        execution_models_.insert(models->begin(), models->end());
-      }
-    }
+    // Execution models from all entry points from which the current function
+    // can be called.
+    execution_models_ = &_.FunctionExecutionModels(function_id_);
   }
 
   if (opcode == SpvOpFunctionEnd) {
@@ -523,7 +522,7 @@ void BuiltInsValidator::Update(const Instruction& inst) {
     assert(function_id_ != 0);
     function_id_ = 0;
     entry_points_ = &no_entry_points;
-    execution_models_.clear();
+    execution_models_ = &no_execution_models_;
   }
 }
 
@@ -897,7 +896,7 @@ spv_result_t BuiltInsValidator::ValidateNotCalledWithExecutionModel(
     const Instruction& referenced_inst,
     const Instruction& referenced_from_inst) {
   if (function_id_) {
-    if (execution_models_.count(execution_model)) {
+    if (_.FunctionHasExecutionModel(function_id_, execution_model)) {
       const char* execution_model_str = _.grammar().lookupOperandName(
           SPV_OPERAND_TYPE_EXECUTION_MODEL, execution_model);
       const char* built_in_str = _.grammar().lookupOperandName(
@@ -970,7 +969,7 @@ spv_result_t BuiltInsValidator::ValidateClipOrCullDistanceAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelFragment:
         case SpvExecutionModelVertex: {
@@ -1113,7 +1112,7 @@ spv_result_t BuiltInsValidator::ValidateFragCoordAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4210)
@@ -1174,7 +1173,7 @@ spv_result_t BuiltInsValidator::ValidateFragDepthAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4213)
@@ -1250,7 +1249,7 @@ spv_result_t BuiltInsValidator::ValidateFrontFacingAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4229)
@@ -1310,7 +1309,7 @@ spv_result_t BuiltInsValidator::ValidateHelperInvocationAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4239)
@@ -1370,7 +1369,7 @@ spv_result_t BuiltInsValidator::ValidateInvocationIdAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelTessellationControl &&
           execution_model != SpvExecutionModelGeometry) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
@@ -1431,7 +1430,7 @@ spv_result_t BuiltInsValidator::ValidateInstanceIndexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelVertex) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4263)
@@ -1491,7 +1490,7 @@ spv_result_t BuiltInsValidator::ValidatePatchVerticesAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelTessellationControl &&
           execution_model != SpvExecutionModelTessellationEvaluation) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
@@ -1553,7 +1552,7 @@ spv_result_t BuiltInsValidator::ValidatePointCoordAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4311)
@@ -1612,7 +1611,7 @@ spv_result_t BuiltInsValidator::ValidatePointSizeAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelVertex: {
           if (spv_result_t error = ValidateF32(
@@ -1729,7 +1728,7 @@ spv_result_t BuiltInsValidator::ValidatePositionAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelVertex: {
           if (spv_result_t error = ValidateF32Vec(
@@ -1816,7 +1815,7 @@ spv_result_t BuiltInsValidator::ValidatePositionAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelVertex: {
           if (spv_result_t error = ValidateF32Vec(
@@ -1939,7 +1938,7 @@ spv_result_t BuiltInsValidator::ValidatePrimitiveIdAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelFragment:
         case SpvExecutionModelTessellationControl:
@@ -2016,7 +2015,7 @@ spv_result_t BuiltInsValidator::ValidateSampleIdAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4354)
@@ -2076,7 +2075,7 @@ spv_result_t BuiltInsValidator::ValidateSampleMaskAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4357)
@@ -2138,7 +2137,7 @@ spv_result_t BuiltInsValidator::ValidateSamplePositionAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelFragment) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4360)
@@ -2199,7 +2198,7 @@ spv_result_t BuiltInsValidator::ValidateTessCoordAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelTessellationEvaluation) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4387)
@@ -2308,7 +2307,7 @@ spv_result_t BuiltInsValidator::ValidateTessLevelAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelTessellationControl:
         case SpvExecutionModelTessellationEvaluation: {
@@ -2387,7 +2386,7 @@ spv_result_t BuiltInsValidator::ValidateInstanceIdAtReference(
     const Instruction& referenced_inst,
     const Instruction& referenced_from_inst) {
   if (spvIsVulkanEnv(_.context()->target_env)) {
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelIntersectionNV:
         case SpvExecutionModelClosestHitNV:
@@ -2452,7 +2451,7 @@ spv_result_t BuiltInsValidator::ValidateLocalInvocationIndexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelGLCompute) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << "WebGPU spec allows BuiltIn VertexIndex to be used only "
@@ -2491,7 +2490,7 @@ spv_result_t BuiltInsValidator::ValidateVertexIndexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelVertex) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4398)
@@ -2613,7 +2612,7 @@ spv_result_t BuiltInsValidator::ValidateLayerOrViewportIndexAtReference(
           referenced_from_inst, std::placeholders::_1));
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       switch (execution_model) {
         case SpvExecutionModelGeometry:
         case SpvExecutionModelFragment:
@@ -2735,7 +2734,7 @@ spv_result_t BuiltInsValidator::ValidateComputeShaderI32Vec3InputAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       bool has_vulkan_model = execution_model == SpvExecutionModelGLCompute ||
                               execution_model == SpvExecutionModelTaskNV ||
                               execution_model == SpvExecutionModelMeshNV;
@@ -2832,7 +2831,7 @@ spv_result_t BuiltInsValidator::ValidateComputeI32InputAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       bool has_vulkan_model = execution_model == SpvExecutionModelGLCompute ||
                               execution_model == SpvExecutionModelTaskNV ||
                               execution_model == SpvExecutionModelMeshNV;
@@ -2981,7 +2980,7 @@ spv_result_t BuiltInsValidator::ValidateWorkgroupSizeAtReference(
     const Instruction& referenced_inst,
     const Instruction& referenced_from_inst) {
   if (spvIsVulkanOrWebGPUEnv(_.context()->target_env)) {
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelGLCompute) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4425)
@@ -3051,7 +3050,7 @@ spv_result_t BuiltInsValidator::ValidateBaseInstanceOrVertexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelVertex) {
         uint32_t vuid = (operand == SpvBuiltInBaseInstance) ? 4181 : 4184;
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
@@ -3117,7 +3116,7 @@ spv_result_t BuiltInsValidator::ValidateDrawIndexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model != SpvExecutionModelVertex &&
           execution_model != SpvExecutionModelMeshNV &&
           execution_model != SpvExecutionModelTaskNV) {
@@ -3184,7 +3183,7 @@ spv_result_t BuiltInsValidator::ValidateViewIndexAtReference(
              << " " << GetStorageClassDesc(referenced_from_inst);
     }
 
-    for (const SpvExecutionModel execution_model : execution_models_) {
+    for (const SpvExecutionModel execution_model : *execution_models_) {
       if (execution_model == SpvExecutionModelGLCompute) {
         return _.diag(SPV_ERROR_INVALID_DATA, &referenced_from_inst)
                << _.VkErrorID(4401) << "Vulkan spec allows BuiltIn "
@@ -3520,17 +3519,13 @@ spv_result_t BuiltInsValidator::ValidateSingleBuiltInAtDefinition(
 }
 
 spv_result_t BuiltInsValidator::ValidateBuiltInsAtDefinition() {
-  for (const auto& kv : _.id_decorations()) {
-    const uint32_t id = kv.first;
-    const auto& decorations = kv.second;
-    if (decorations.empty()) {
-      continue;
-    }
+  for (const uint32_t id : _.decorated_ids()) {
+    if (!_.HasDecoration(id, SpvDecorationBuiltIn)) continue;
 
     const Instruction* inst = _.FindDef(id);
     assert(inst);
 
-    for (const auto& decoration : kv.second) {
+    for (const auto& decoration : _.id_decorations(id)) {
       if (decoration.dec_type() != SpvDecorationBuiltIn) {
         continue;
       }
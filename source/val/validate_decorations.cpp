@@ -67,22 +67,36 @@ struct LayoutConstraints {
 using MemberConstraints = std::unordered_map<std::pair<uint32_t, uint32_t>,
                                              LayoutConstraints, PairHash>;
 
+// The layout rules that decide the base alignment of a type.  Relaxed block
+// layout only changes how offsets are checked, so it uses the alignments of
+// the standard rules.
+enum class LayoutRule : uint32_t { kStd140, kStd430, kScalar };
+
+// Layout information that only depends on the types, computed once per module
+// and shared by the checks of every block.  Without it, each block check would
+// walk the nested structs again for every member that contains them.
+struct LayoutCache {
+  // The layout constraints of the members of the structs in
+  // |constrained_structs|.
+  MemberConstraints constraints;
+  std::unordered_set<uint32_t> constrained_structs;
+  // The alignment of struct types, keyed by (struct id, layout rule).
+  std::unordered_map<std::pair<uint32_t, uint32_t>, uint32_t, PairHash>
+      struct_alignments;
+  // The size of struct types.
+  std::unordered_map<uint32_t, uint32_t> struct_sizes;
+};
+
 // Returns the array stride of the given array type.
 uint32_t GetArrayStride(uint32_t array_id, ValidationState_t& vstate) {
-  for (auto& decoration : vstate.id_decorations(array_id)) {
-    if (SpvDecorationArrayStride == decoration.dec_type()) {
-      return decoration.params()[0];
-    }
-  }
-  return 0;
+  const auto decoration =
+      vstate.FindDecoration(array_id, SpvDecorationArrayStride);
+  return decoration ? decoration->params()[0] : 0;
 }
 
 // Returns true if the given variable has a BuiltIn decoration.
 bool isBuiltInVar(uint32_t var_id, ValidationState_t& vstate) {
-  const auto& decorations = vstate.id_decorations(var_id);
-  return std::any_of(
-      decorations.begin(), decorations.end(),
-      [](const Decoration& d) { return SpvDecorationBuiltIn == d.dec_type(); });
+  return vstate.HasDecoration(var_id, SpvDecorationBuiltIn);
 }
 
 // Returns true if the given structure type has any members with BuiltIn
@@ -129,26 +143,20 @@ std::vector<uint32_t> getStructMembers(uint32_t struct_id, SpvOp type,
 // Returns whether the given structure is missing Offset decoration for any
 // member. Handles also nested structures.
 bool isMissingOffsetInStruct(uint32_t struct_id, ValidationState_t& vstate) {
-  std::vector<bool> hasOffset(getStructMembers(struct_id, vstate).size(),
-                              false);
+  const uint32_t num_members =
+      uint32_t(getStructMembers(struct_id, vstate).size());
   // Check offsets of member decorations
-  for (auto& decoration : vstate.id_decorations(struct_id)) {
-    if (SpvDecorationOffset == decoration.dec_type() &&
-        Decoration::kInvalidMember != decoration.struct_member_index()) {
-      hasOffset[decoration.struct_member_index()] = true;
+  for (uint32_t memberIdx = 0; memberIdx < num_members; ++memberIdx) {
+    if (!vstate.FindMemberDecoration(struct_id, memberIdx,
+                                     SpvDecorationOffset)) {
+      return true;
     }
   }
   // Check also nested structures
-  bool nestedStructsMissingOffset = false;
   for (auto id : getStructMembers(struct_id, SpvOpTypeStruct, vstate)) {
-    if (isMissingOffsetInStruct(id, vstate)) {
-      nestedStructsMissingOffset = true;
-      break;
-    }
+    if (isMissingOffsetInStruct(id, vstate)) return true;
   }
-  return nestedStructsMissingOffset ||
-         !std::all_of(hasOffset.begin(), hasOffset.end(),
-                      [](const bool b) { return b; });
+  return false;
 }
 
 // Rounds x up to the next alignment. Assumes alignment is a power of two.
@@ -161,10 +169,9 @@ uint32_t align(uint32_t x, uint32_t alignment) {
 // bytes.
 uint32_t getBaseAlignment(uint32_t member_id, bool roundUp,
                           const LayoutConstraints& inherited,
-                          MemberConstraints& constraints,
-                          ValidationState_t& vstate) {
+                          LayoutCache& cache, ValidationState_t& vstate) {
   const auto inst = vstate.FindDef(member_id);
-  const auto& words = inst->words();
+  const auto words = inst->words();
   // Minimal alignment is byte-aligned.
   uint32_t baseAlignment = 1;
   switch (inst->opcode()) {
@@ -175,8 +182,8 @@ uint32_t getBaseAlignment(uint32_t member_id, bool roundUp,
     case SpvOpTypeVector: {
       const auto componentId = words[2];
       const auto numComponents = words[3];
-      const auto componentAlignment = getBaseAlignment(
-          componentId, roundUp, inherited, constraints, vstate);
+      const auto componentAlignment =
+          getBaseAlignment(componentId, roundUp, inherited, cache, vstate);
       baseAlignment =
           componentAlignment * (numComponents == 3 ? 4 : numComponents);
       break;
@@ -184,16 +191,16 @@ uint32_t getBaseAlignment(uint32_t member_id, bool roundUp,
     case SpvOpTypeMatrix: {
       const auto column_type = words[2];
       if (inherited.majorness == kColumnMajor) {
-        baseAlignment = getBaseAlignment(column_type, roundUp, inherited,
-                                         constraints, vstate);
+        baseAlignment =
+            getBaseAlignment(column_type, roundUp, inherited, cache, vstate);
       } else {
         // A row-major matrix of C columns has a base alignment equal to the
         // base alignment of a vector of C matrix components.
         const auto num_columns = words[3];
         const auto component_inst = vstate.FindDef(column_type);
         const auto component_id = component_inst->words()[2];
-        const auto componentAlignment = getBaseAlignment(
-            component_id, roundUp, inherited, constraints, vstate);
+        const auto componentAlignment =
+            getBaseAlignment(component_id, roundUp, inherited, cache, vstate);
         baseAlignment =
             componentAlignment * (num_columns == 3 ? 4 : num_columns);
       }
@@ -201,21 +208,27 @@ uint32_t getBaseAlignment(uint32_t member_id, bool roundUp,
     case SpvOpTypeArray:
     case SpvOpTypeRuntimeArray:
       baseAlignment =
-          getBaseAlignment(words[2], roundUp, inherited, constraints, vstate);
+          getBaseAlignment(words[2], roundUp, inherited, cache, vstate);
       if (roundUp) baseAlignment = align(baseAlignment, 16u);
       break;
     case SpvOpTypeStruct: {
+      // The alignment of a struct does not depend on |inherited|.
+      const auto rule = roundUp ? LayoutRule::kStd140 : LayoutRule::kStd430;
+      const auto key = std::make_pair(member_id, uint32_t(rule));
+      const auto cached = cache.struct_alignments.find(key);
+      if (cached != cache.struct_alignments.end()) return cached->second;
       const auto members = getStructMembers(member_id, vstate);
       for (uint32_t memberIdx = 0, numMembers = uint32_t(members.size());
            memberIdx < numMembers; ++memberIdx) {
         const auto id = members[memberIdx];
         const auto& constraint =
-            constraints[std::make_pair(member_id, memberIdx)];
+            cache.constraints[std::make_pair(member_id, memberIdx)];
         baseAlignment = std::max(
             baseAlignment,
-            getBaseAlignment(id, roundUp, constraint, constraints, vstate));
+            getBaseAlignment(id, roundUp, constraint, cache, vstate));
       }
       if (roundUp) baseAlignment = align(baseAlignment, 16u);
+      cache.struct_alignments[key] = baseAlignment;
       break;
     }
     case SpvOpTypePointer:
@@ -230,9 +243,10 @@ uint32_t getBaseAlignment(uint32_t member_id, bool roundUp,
 }
 
 // Returns scalar alignment of a type.
-uint32_t getScalarAlignment(uint32_t type_id, ValidationState_t& vstate) {
+uint32_t getScalarAlignment(uint32_t type_id, LayoutCache& cache,
+                            ValidationState_t& vstate) {
   const auto inst = vstate.FindDef(type_id);
-  const auto& words = inst->words();
+  const auto words = inst->words();
   switch (inst->opcode()) {
     case SpvOpTypeInt:
     case SpvOpTypeFloat:
@@ -242,19 +256,23 @@ uint32_t getScalarAlignment(uint32_t type_id, ValidationState_t& vstate) {
     case SpvOpTypeArray:
     case SpvOpTypeRuntimeArray: {
       const auto compositeMemberTypeId = words[2];
-      return getScalarAlignment(compositeMemberTypeId, vstate);
+      return getScalarAlignment(compositeMemberTypeId, cache, vstate);
     }
     case SpvOpTypeStruct: {
+      const auto key = std::make_pair(type_id, uint32_t(LayoutRule::kScalar));
+      const auto cached = cache.struct_alignments.find(key);
+      if (cached != cache.struct_alignments.end()) return cached->second;
       const auto members = getStructMembers(type_id, vstate);
       uint32_t max_member_alignment = 1;
       for (uint32_t memberIdx = 0, numMembers = uint32_t(members.size());
            memberIdx < numMembers; ++memberIdx) {
         const auto id = members[memberIdx];
-        uint32_t member_alignment = getScalarAlignment(id, vstate);
+        uint32_t member_alignment = getScalarAlignment(id, cache, vstate);
         if (member_alignment > max_member_alignment) {
           max_member_alignment = member_alignment;
         }
       }
+      cache.struct_alignments[key] = max_member_alignment;
       return max_member_alignment;
     } break;
     case SpvOpTypePointer:
@@ -270,9 +288,9 @@ uint32_t getScalarAlignment(uint32_t type_id, ValidationState_t& vstate) {
 // Returns size of a struct member. Doesn't include padding at the end of struct
 // or array.  Assumes that in the struct case, all members have offsets.
 uint32_t getSize(uint32_t member_id, const LayoutConstraints& inherited,
-                 MemberConstraints& constraints, ValidationState_t& vstate) {
+                 LayoutCache& cache, ValidationState_t& vstate) {
   const auto inst = vstate.FindDef(member_id);
-  const auto& words = inst->words();
+  const auto words = inst->words();
   switch (inst->opcode()) {
     case SpvOpTypeInt:
     case SpvOpTypeFloat:
@@ -281,7 +299,7 @@ uint32_t getSize(uint32_t member_id, const LayoutConstraints& inherited,
       const auto componentId = words[2];
       const auto numComponents = words[3];
       const auto componentSize =
-          getSize(componentId, inherited, constraints, vstate);
+          getSize(componentId, inherited, cache, vstate);
       const auto size = componentSize * numComponents;
       return size;
     }
@@ -291,8 +309,7 @@ uint32_t getSize(uint32_t member_id, const LayoutConstraints& inherited,
       assert(SpvOpConstant == sizeInst->opcode());
       const uint32_t num_elem = sizeInst->words()[3];
       const uint32_t elem_type = words[2];
-      const uint32_t elem_size =
-          getSize(elem_type, inherited, constraints, vstate);
+      const uint32_t elem_size = getSize(elem_type, inherited, cache, vstate);
       // Account for gaps due to alignments in the first N-1 elements,
       // then add the size of the last element.
       const auto size =
@@ -312,29 +329,35 @@ uint32_t getSize(uint32_t member_id, const LayoutConstraints& inherited,
         const auto num_rows = component_inst->words()[3];
         const auto scalar_elem_type = component_inst->words()[2];
         const uint32_t scalar_elem_size =
-            getSize(scalar_elem_type, inherited, constraints, vstate);
+            getSize(scalar_elem_type, inherited, cache, vstate);
         return (num_rows - 1) * inherited.matrix_stride +
                num_columns * scalar_elem_size;
       }
     }
     case SpvOpTypeStruct: {
+      // The size of a struct does not depend on |inherited|.
+      const auto cached = cache.struct_sizes.find(member_id);
+      if (cached != cache.struct_sizes.end()) return cached->second;
       const auto& members = getStructMembers(member_id, vstate);
       if (members.empty()) return 0;
       const auto lastIdx = uint32_t(members.size() - 1);
       const auto& lastMember = members.back();
       uint32_t offset = 0xffffffff;
       // Find the offset of the last element and add the size.
-      for (auto& decoration : vstate.id_decorations(member_id)) {
-        if (SpvDecorationOffset == decoration.dec_type() &&
-            decoration.struct_member_index() == (int)lastIdx) {
+      for (auto& decoration : vstate.member_decorations(member_id, lastIdx)) {
+        if (SpvDecorationOffset == decoration.dec_type()) {
           offset = decoration.params()[0];
         }
       }
       // This check depends on the fact that all members have offsets.  This
       // has been checked earlier in the flow.
       assert(offset != 0xffffffff);
-      const auto& constraint = constraints[std::make_pair(lastMember, lastIdx)];
-      return offset + getSize(lastMember, constraint, constraints, vstate);
+      const auto& constraint =
+          cache.constraints[std::make_pair(lastMember, lastIdx)];
+      const uint32_t size =
+          offset + getSize(lastMember, constraint, cache, vstate);
+      cache.struct_sizes[member_id] = size;
+      return size;
     }
     case SpvOpTypePointer:
       return vstate.pointer_size_and_alignment();
@@ -353,9 +376,8 @@ uint32_t getSize(uint32_t member_id, const LayoutConstraints& inherited,
 // decorations placing its first byte at a non-integer multiple of 16.
 bool hasImproperStraddle(uint32_t id, uint32_t offset,
                          const LayoutConstraints& inherited,
-                         MemberConstraints& constraints,
-                         ValidationState_t& vstate) {
-  const auto size = getSize(id, inherited, constraints, vstate);
+                         LayoutCache& cache, ValidationState_t& vstate) {
+  const auto size = getSize(id, inherited, cache, vstate);
   const auto F = offset;
   const auto L = offset + size - 1;
   if (size <= 16) {
@@ -379,8 +401,7 @@ bool IsAlignedTo(uint32_t offset, uint32_t alignment) {
 // or row major-ness.
 spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
                          const char* decoration_str, bool blockRules,
-                         uint32_t incoming_offset,
-                         MemberConstraints& constraints,
+                         uint32_t incoming_offset, LayoutCache& cache,
                          ValidationState_t& vstate) {
   if (vstate.options()->skip_block_layout) return SPV_SUCCESS;
 
@@ -423,15 +444,9 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
   for (uint32_t memberIdx = 0, numMembers = uint32_t(members.size());
        memberIdx < numMembers; memberIdx++) {
     uint32_t offset = 0xffffffff;
-    for (auto& decoration : vstate.id_decorations(struct_id)) {
-      if (decoration.struct_member_index() == (int)memberIdx) {
-        switch (decoration.dec_type()) {
-          case SpvDecorationOffset:
-            offset = decoration.params()[0];
-            break;
-          default:
-            break;
-        }
+    for (auto& decoration : vstate.member_decorations(struct_id, memberIdx)) {
+      if (SpvDecorationOffset == decoration.dec_type()) {
+        offset = decoration.params()[0];
       }
     }
     member_offsets.push_back(
@@ -452,17 +467,17 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
     const auto offset = member_offset.offset;
     auto id = members[member_offset.member];
     const LayoutConstraints& constraint =
-        constraints[std::make_pair(struct_id, uint32_t(memberIdx))];
+        cache.constraints[std::make_pair(struct_id, uint32_t(memberIdx))];
     // Scalar layout takes precedence because it's more permissive, and implying
     // an alignment that divides evenly into the alignment that would otherwise
     // be used.
     const auto alignment =
         scalar_block_layout
-            ? getScalarAlignment(id, vstate)
-            : getBaseAlignment(id, blockRules, constraint, constraints, vstate);
+            ? getScalarAlignment(id, cache, vstate)
+            : getBaseAlignment(id, blockRules, constraint, cache, vstate);
     const auto inst = vstate.FindDef(id);
     const auto opcode = inst->opcode();
-    const auto size = getSize(id, constraint, constraints, vstate);
+    const auto size = getSize(id, constraint, cache, vstate);
     // Check offset.
     if (offset == 0xffffffff)
       return fail(memberIdx) << "is missing an Offset decoration";
@@ -471,7 +486,8 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
       // In relaxed block layout, the vector offset must be aligned to the
       // vector's scalar element type.
       const auto componentId = inst->words()[2];
-      const auto scalar_alignment = getScalarAlignment(componentId, vstate);
+      const auto scalar_alignment =
+          getScalarAlignment(componentId, cache, vstate);
       if (!IsAlignedTo(offset, scalar_alignment)) {
         return fail(memberIdx)
                << "at offset " << offset
@@ -492,7 +508,7 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
     if (!scalar_block_layout && relaxed_block_layout) {
       // Check improper straddle of vectors.
       if (SpvOpTypeVector == opcode &&
-          hasImproperStraddle(id, offset, constraint, constraints, vstate))
+          hasImproperStraddle(id, offset, constraint, cache, vstate))
         return fail(memberIdx)
                << "is an improperly straddling vector at offset " << offset;
     }
@@ -501,7 +517,7 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
     if (SpvOpTypeStruct == opcode &&
         SPV_SUCCESS != (recursive_status = checkLayout(
                             id, storage_class_str, decoration_str, blockRules,
-                            offset, constraints, vstate)))
+                            offset, cache, vstate)))
       return recursive_status;
     // Check matrix stride.
     if (SpvOpTypeMatrix == opcode) {
@@ -523,17 +539,16 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
       const auto element_inst = vstate.FindDef(typeId);
       // Check array stride.
       uint32_t array_stride = 0;
-      for (auto& decoration : vstate.id_decorations(array_inst->id())) {
-        if (SpvDecorationArrayStride == decoration.dec_type()) {
-          array_stride = decoration.params()[0];
-          if (array_stride == 0) {
-            return fail(memberIdx) << "contains an array with stride 0";
-          }
-          if (!IsAlignedTo(array_stride, array_alignment))
-            return fail(memberIdx)
-                   << "contains an array with stride " << decoration.params()[0]
-                   << " not satisfying alignment to " << alignment;
+      if (const auto decoration = vstate.FindDecoration(
+              array_inst->id(), SpvDecorationArrayStride)) {
+        array_stride = decoration->params()[0];
+        if (array_stride == 0) {
+          return fail(memberIdx) << "contains an array with stride 0";
         }
+        if (!IsAlignedTo(array_stride, array_alignment))
+          return fail(memberIdx)
+                 << "contains an array with stride " << array_stride
+                 << " not satisfying alignment to " << alignment;
       }
 
       bool is_int32 = false;
@@ -553,7 +568,7 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
         if (SpvOpTypeStruct == element_inst->opcode() &&
             SPV_SUCCESS != (recursive_status = checkLayout(
                                 typeId, storage_class_str, decoration_str,
-                                blockRules, next_offset, constraints, vstate)))
+                                blockRules, next_offset, cache, vstate)))
           return recursive_status;
         // If offsets accumulate up to a 16-byte multiple stop checking since
         // it will just repeat.
@@ -562,13 +577,14 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
 
       // Proceed to the element in case it is an array.
       array_inst = element_inst;
-      array_alignment = scalar_block_layout
-                            ? getScalarAlignment(array_inst->id(), vstate)
-                            : getBaseAlignment(array_inst->id(), blockRules,
-                                               constraint, constraints, vstate);
+      array_alignment =
+          scalar_block_layout
+              ? getScalarAlignment(array_inst->id(), cache, vstate)
+              : getBaseAlignment(array_inst->id(), blockRules, constraint,
+                                 cache, vstate);
 
       const auto element_size =
-          getSize(element_inst->id(), constraint, constraints, vstate);
+          getSize(element_inst->id(), constraint, cache, vstate);
       if (element_size > array_stride) {
         return fail(memberIdx)
                << "contains an array with stride " << array_stride
@@ -590,9 +606,7 @@ spv_result_t checkLayout(uint32_t struct_id, const char* storage_class_str,
 // nested structures.
 bool hasDecoration(uint32_t id, SpvDecoration decoration,
                    ValidationState_t& vstate) {
-  for (auto& dec : vstate.id_decorations(id)) {
-    if (decoration == dec.dec_type()) return true;
-  }
+  if (vstate.HasDecoration(id, decoration)) return true;
   if (SpvOpTypeStruct != vstate.FindDef(id)->opcode()) {
     return false;
   }
@@ -611,16 +625,9 @@ bool checkForRequiredDecoration(uint32_t struct_id, SpvDecoration decoration,
   for (size_t memberIdx = 0; memberIdx < members.size(); memberIdx++) {
     const auto id = members[memberIdx];
     if (type != vstate.FindDef(id)->opcode()) continue;
-    bool found = false;
-    for (auto& dec : vstate.id_decorations(id)) {
-      if (decoration == dec.dec_type()) found = true;
-    }
-    for (auto& dec : vstate.id_decorations(struct_id)) {
-      if (decoration == dec.dec_type() &&
-          (int)memberIdx == dec.struct_member_index()) {
-        found = true;
-      }
-    }
+    const bool found =
+        vstate.HasDecoration(id, decoration) ||
+        vstate.FindMemberDecoration(struct_id, uint32_t(memberIdx), decoration);
     if (!found) {
       return false;
     }
@@ -765,58 +772,56 @@ spv_result_t CheckDecorationsOfEntryPoints(ValidationState_t& vstate) {
       }
       // The LinkageAttributes Decoration cannot be applied to functions
       // targeted by an OpEntryPoint instruction
-      for (auto& decoration : vstate.id_decorations(entry_point)) {
-        if (SpvDecorationLinkageAttributes == decoration.dec_type()) {
-          const char* linkage_name =
-              reinterpret_cast<const char*>(&decoration.params()[0]);
-          return vstate.diag(SPV_ERROR_INVALID_BINARY,
-                             vstate.FindDef(entry_point))
-                 << "The LinkageAttributes Decoration (Linkage name: "
-                 << linkage_name << ") cannot be applied to function id "
-                 << entry_point
-                 << " because it is targeted by an OpEntryPoint instruction.";
-        }
+      if (const auto decoration = vstate.FindDecoration(
+              entry_point, SpvDecorationLinkageAttributes)) {
+        const char* linkage_name =
+            reinterpret_cast<const char*>(&decoration->params()[0]);
+        return vstate.diag(SPV_ERROR_INVALID_BINARY,
+                           vstate.FindDef(entry_point))
+               << "The LinkageAttributes Decoration (Linkage name: "
+               << linkage_name << ") cannot be applied to function id "
+               << entry_point
+               << " because it is targeted by an OpEntryPoint instruction.";
       }
     }
   }
   return SPV_SUCCESS;
 }
 
-// Load |constraints| with all the member constraints for structs contained
-// within the given array type.
-void ComputeMemberConstraintsForArray(MemberConstraints* constraints,
-                                      uint32_t array_id,
+// Load |cache| with all the member constraints for structs contained within
+// the given array type.
+void ComputeMemberConstraintsForArray(LayoutCache* cache, uint32_t array_id,
                                       const LayoutConstraints& inherited,
                                       ValidationState_t& vstate);
 
-// Load |constraints| with all the member constraints for the given struct,
-// and all its contained structs.
-void ComputeMemberConstraintsForStruct(MemberConstraints* constraints,
-                                       uint32_t struct_id,
+// Load |cache| with all the member constraints for the given struct, and all
+// its contained structs.  Structs already in |cache| are skipped: every block
+// is checked starting from the default constraints, so the result for a struct
+// is the same whichever block contains it.
+void ComputeMemberConstraintsForStruct(LayoutCache* cache, uint32_t struct_id,
                                        const LayoutConstraints& inherited,
                                        ValidationState_t& vstate) {
-  assert(constraints);
+  assert(cache);
+  if (!cache->constrained_structs.insert(struct_id).second) return;
   const auto& members = getStructMembers(struct_id, vstate);
   for (uint32_t memberIdx = 0, numMembers = uint32_t(members.size());
        memberIdx < numMembers; memberIdx++) {
     LayoutConstraints& constraint =
-        (*constraints)[std::make_pair(struct_id, memberIdx)];
+        cache->constraints[std::make_pair(struct_id, memberIdx)];
     constraint = inherited;
-    for (auto& decoration : vstate.id_decorations(struct_id)) {
-      if (decoration.struct_member_index() == (int)memberIdx) {
-        switch (decoration.dec_type()) {
-          case SpvDecorationRowMajor:
-            constraint.majorness = kRowMajor;
-            break;
-          case SpvDecorationColMajor:
-            constraint.majorness = kColumnMajor;
-            break;
-          case SpvDecorationMatrixStride:
-            constraint.matrix_stride = decoration.params()[0];
-            break;
-          default:
-            break;
-        }
+    for (auto& decoration : vstate.member_decorations(struct_id, memberIdx)) {
+      switch (decoration.dec_type()) {
+        case SpvDecorationRowMajor:
+          constraint.majorness = kRowMajor;
+          break;
+        case SpvDecorationColMajor:
+          constraint.majorness = kColumnMajor;
+          break;
+        case SpvDecorationMatrixStride:
+          constraint.matrix_stride = decoration.params()[0];
+          break;
+        default:
+          break;
       }
     }
 
@@ -827,12 +832,12 @@ void ComputeMemberConstraintsForStruct(MemberConstraints* constraints,
     switch (opcode) {
       case SpvOpTypeArray:
       case SpvOpTypeRuntimeArray:
-        ComputeMemberConstraintsForArray(constraints, member_type_id, inherited,
+        ComputeMemberConstraintsForArray(cache, member_type_id, inherited,
                                          vstate);
         break;
       case SpvOpTypeStruct:
-        ComputeMemberConstraintsForStruct(constraints, member_type_id,
-                                          inherited, vstate);
+        ComputeMemberConstraintsForStruct(cache, member_type_id, inherited,
+                                          vstate);
         break;
       default:
         break;
@@ -840,22 +845,20 @@ void ComputeMemberConstraintsForStruct(MemberConstraints* constraints,
   }
 }
 
-void ComputeMemberConstraintsForArray(MemberConstraints* constraints,
-                                      uint32_t array_id,
+void ComputeMemberConstraintsForArray(LayoutCache* cache, uint32_t array_id,
                                       const LayoutConstraints& inherited,
                                       ValidationState_t& vstate) {
-  assert(constraints);
+  assert(cache);
   auto elem_type_id = vstate.FindDef(array_id)->words()[2];
   const auto elem_type_inst = vstate.FindDef(elem_type_id);
   const auto opcode = elem_type_inst->opcode();
   switch (opcode) {
     case SpvOpTypeArray:
     case SpvOpTypeRuntimeArray:
-      ComputeMemberConstraintsForArray(constraints, elem_type_id, inherited,
-                                       vstate);
+      ComputeMemberConstraintsForArray(cache, elem_type_id, inherited, vstate);
       break;
     case SpvOpTypeStruct:
-      ComputeMemberConstraintsForStruct(constraints, elem_type_id, inherited,
+      ComputeMemberConstraintsForStruct(cache, elem_type_id, inherited,
                                         vstate);
       break;
     default:
@@ -866,8 +869,9 @@ void ComputeMemberConstraintsForArray(MemberConstraints* constraints,
 spv_result_t CheckDecorationsOfBuffers(ValidationState_t& vstate) {
   // Set of entry points that are known to use a push constant.
   std::unordered_set<uint32_t> uses_push_constant;
+  LayoutCache cache;
   for (const auto& inst : vstate.ordered_instructions()) {
-    const auto& words = inst.words();
+    const auto words = inst.words();
     if (SpvOpVariable == inst.opcode()) {
       const auto var_id = inst.id();
       // For storage class / decoration combinations, see Vulkan 14.5.4 "Offset
@@ -955,8 +959,7 @@ spv_result_t CheckDecorationsOfBuffers(ValidationState_t& vstate) {
         }
         // Struct requirement is checked on variables so just move on here.
         if (SpvOpTypeStruct != id_inst->opcode()) continue;
-        MemberConstraints constraints;
-        ComputeMemberConstraintsForStruct(&constraints, id, LayoutConstraints(),
+        ComputeMemberConstraintsForStruct(&cache, id, LayoutConstraints(),
                                           vstate);
         // Prepare for messages
         const char* sc_str =
@@ -1073,12 +1076,12 @@ spv_result_t CheckDecorationsOfBuffers(ValidationState_t& vstate) {
             } else if (blockRules &&
                        (SPV_SUCCESS != (recursive_status = checkLayout(
                                             id, sc_str, deco_str, true, 0,
-                                            constraints, vstate)))) {
+                                            cache, vstate)))) {
               return recursive_status;
             } else if (bufferRules &&
                        (SPV_SUCCESS != (recursive_status = checkLayout(
                                             id, sc_str, deco_str, false, 0,
-                                            constraints, vstate)))) {
+                                            cache, vstate)))) {
               return recursive_status;
             }
           }
@@ -1157,7 +1160,7 @@ spv_result_t CheckDecorationsCompatibility(ValidationState_t& vstate) {
   std::set<PerMemberKey> seen_per_member;
 
   for (const auto& inst : vstate.ordered_instructions()) {
-    const auto& words = inst.words();
+    const auto words = inst.words();
     if (SpvOpDecorate == inst.opcode()) {
       const auto id = words[1];
       const auto dec_type = static_cast<SpvDecoration>(words[2]);
@@ -1569,10 +1572,8 @@ spv_result_t CheckDecorationsFromDecoration(ValidationState_t& vstate) {
   // Some rules are only checked for shaders.
   const bool is_shader = vstate.HasCapability(SpvCapabilityShader);
 
-  for (const auto& kv : vstate.id_decorations()) {
-    const uint32_t id = kv.first;
-    const auto& decorations = kv.second;
-    if (decorations.empty()) continue;
+  for (const uint32_t id : vstate.decorated_ids()) {
+    const auto& decorations = vstate.id_decorations(id);
 
     const Instruction* inst = vstate.FindDef(id);
     assert(inst);
@@ -14,6 +14,10 @@
 
 #include "source/val/validate.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "source/val/function.h"
 #include "source/val/validation_state.h"
 
@@ -32,6 +36,16 @@ spv_result_t ValidateExecutionLimitations(ValidationState_t& _,
            << "Internal error: missing function id " << inst->id() << ".";
   }
 
+  // Check each execution model the function can be called with once, rather
+  // than once for every entry point calling it.  The models come sorted, so
+  // |incompatible_models| is sorted too.
+  std::vector<SpvExecutionModel> incompatible_models;
+  for (const auto model : _.FunctionExecutionModels(inst->id())) {
+    if (!func->IsCompatibleWithExecutionModel(model)) {
+      incompatible_models.push_back(model);
+    }
+  }
+
   for (uint32_t entry_id : _.FunctionEntryPoints(inst->id())) {
     const auto* models = _.GetExecutionModels(entry_id);
     if (models) {
@@ -41,6 +55,10 @@ spv_result_t ValidateExecutionLimitations(ValidationState_t& _,
                << entry_id << ".";
       }
       for (const auto model : *models) {
+        if (!std::binary_search(incompatible_models.begin(),
+                                incompatible_models.end(), model)) {
+          continue;
+        }
         std::string reason;
         if (!func->IsCompatibleWithExecutionModel(model, &reason)) {
           return _.diag(SPV_ERROR_INVALID_ID, inst)
@@ -28,6 +28,7 @@
 #include "source/latest_version_opencl_std_header.h"
 #include "source/opcode.h"
 #include "source/spirv_target_env.h"
+#include "source/util/function_ref.h"
 #include "source/val/instruction.h"
 #include "source/val/validate.h"
 #include "source/val/validation_state.h"
@@ -49,7 +50,7 @@ uint32_t GetSizeTBitWidth(const ValidationState_t& _) {
 spv_result_t ValidateOperandForDebugInfo(
     ValidationState_t& _, const std::string& operand_name,
     SpvOp expected_opcode, const Instruction* inst, uint32_t word_index,
-    const std::function<std::string()>& ext_inst_name) {
+    utils::FunctionRef<std::string()> ext_inst_name) {
   auto* operand = _.FindDef(inst->word(word_index));
   if (operand->opcode() != expected_opcode) {
     spv_opcode_desc desc = nullptr;
@@ -74,21 +75,55 @@ spv_result_t ValidateOperandForDebugInfo(
     if (result != SPV_SUCCESS) return result;                               \
   } while (0)
 
+// Returns the debug instruction type of the operand of a debug info
+// instruction |inst| at |word_index|, or OpenCLDebugInfo100InstructionsMax if
+// |inst| has no such operand or the operand is not an OpenCL.DebugInfo.100
+// instruction.
+OpenCLDebugInfo100Instructions GetDebugInfoOperandKind(
+    const ValidationState_t& _, const Instruction* inst, uint32_t word_index) {
+  if (inst->words().size() <= word_index) {
+    return OpenCLDebugInfo100InstructionsMax;
+  }
+  auto* debug_inst = _.FindDef(inst->word(word_index));
+  if (debug_inst->opcode() != SpvOpExtInst ||
+      debug_inst->ext_inst_type() != SPV_EXT_INST_TYPE_OPENCL_DEBUGINFO_100) {
+    return OpenCLDebugInfo100InstructionsMax;
+  }
+  return OpenCLDebugInfo100Instructions(debug_inst->word(4));
+}
+
 // True if the operand of a debug info instruction |inst| at |word_index|
 // satisifies |expectation| that is given as a function. Otherwise,
 // returns false.
 bool DoesDebugInfoOperandMatchExpectation(
     const ValidationState_t& _,
-    const std::function<bool(OpenCLDebugInfo100Instructions)>& expectation,
+    utils::FunctionRef<bool(OpenCLDebugInfo100Instructions)> expectation,
     const Instruction* inst, uint32_t word_index) {
-  if (inst->words().size() <= word_index) return false;
-  auto* debug_inst = _.FindDef(inst->word(word_index));
-  if (debug_inst->opcode() != SpvOpExtInst ||
-      debug_inst->ext_inst_type() != SPV_EXT_INST_TYPE_OPENCL_DEBUGINFO_100 ||
-      !expectation(OpenCLDebugInfo100Instructions(debug_inst->word(4)))) {
-    return false;
+  auto kind = GetDebugInfoOperandKind(_, inst, word_index);
+  return kind != OpenCLDebugInfo100InstructionsMax && expectation(kind);
+}
+
+// True if |kind| is one of the debug lexical scope instructions:
+// DebugCompilationUnit, DebugFunction, DebugLexicalBlock, or
+// DebugTypeComposite.
+bool IsDebugLexicalScope(OpenCLDebugInfo100Instructions kind) {
+  return kind == OpenCLDebugInfo100DebugCompilationUnit ||
+         kind == OpenCLDebugInfo100DebugFunction ||
+         kind == OpenCLDebugInfo100DebugLexicalBlock ||
+         kind == OpenCLDebugInfo100DebugTypeComposite;
+}
+
+// True if |kind| is one of the debug type instructions.  The template
+// parameter instructions count only if |allow_template_param| is true.
+bool IsDebugType(OpenCLDebugInfo100Instructions kind,
+                 bool allow_template_param) {
+  if (allow_template_param &&
+      (kind == OpenCLDebugInfo100DebugTypeTemplateParameter ||
+       kind == OpenCLDebugInfo100DebugTypeTemplateTemplateParameter)) {
+    return true;
   }
-  return true;
+  return OpenCLDebugInfo100DebugTypeBasic <= kind &&
+         kind <= OpenCLDebugInfo100DebugTypeTemplate;
 }
 
 // Check that the operand of a debug info instruction |inst| at |word_index|
@@ -97,17 +132,11 @@ bool DoesDebugInfoOperandMatchExpectation(
 spv_result_t ValidateDebugInfoOperand(
     ValidationState_t& _, const std::string& debug_inst_name,
     OpenCLDebugInfo100Instructions expected_debug_inst, const Instruction* inst,
-    uint32_t word_index, const std::function<std::string()>& ext_inst_name) {
-  std::function<bool(OpenCLDebugInfo100Instructions)> expectation =
-      [expected_debug_inst](OpenCLDebugInfo100Instructions dbg_inst) {
-        return dbg_inst == expected_debug_inst;
-      };
-  if (DoesDebugInfoOperandMatchExpectation(_, expectation, inst, word_index))
+    uint32_t word_index, utils::FunctionRef<std::string()> ext_inst_name) {
+  if (GetDebugInfoOperandKind(_, inst, word_index) == expected_debug_inst)
     return SPV_SUCCESS;
 
   spv_ext_inst_desc desc = nullptr;
-  _.grammar().lookupExtInst(SPV_EXT_INST_TYPE_OPENCL_DEBUGINFO_100,
-                            expected_debug_inst, &desc);
   if (_.grammar().lookupExtInst(SPV_EXT_INST_TYPE_OPENCL_DEBUGINFO_100,
                                 expected_debug_inst, &desc) != SPV_SUCCESS ||
       !desc) {
@@ -132,7 +161,7 @@ spv_result_t ValidateDebugInfoOperand(
 // is a result id of an debug info instruction with DebugTypeBasic.
 spv_result_t ValidateOperandBaseType(
     ValidationState_t& _, const Instruction* inst, uint32_t word_index,
-    const std::function<std::string()>& ext_inst_name) {
+    utils::FunctionRef<std::string()> ext_inst_name) {
   return ValidateDebugInfoOperand(_, "Base Type",
                                   OpenCLDebugInfo100DebugTypeBasic, inst,
                                   word_index, ext_inst_name);
@@ -145,15 +174,8 @@ spv_result_t ValidateOperandBaseType(
 spv_result_t ValidateOperandLexicalScope(
     ValidationState_t& _, const std::string& debug_inst_name,
     const Instruction* inst, uint32_t word_index,
-    const std::function<std::string()>& ext_inst_name) {
-  std::function<bool(OpenCLDebugInfo100Instructions)> expectation =
-      [](OpenCLDebugInfo100Instructions dbg_inst) {
-        return dbg_inst == OpenCLDebugInfo100DebugCompilationUnit ||
-               dbg_inst == OpenCLDebugInfo100DebugFunction ||
-               dbg_inst == OpenCLDebugInfo100DebugLexicalBlock ||
-               dbg_inst == OpenCLDebugInfo100DebugTypeComposite;
-      };
-  if (DoesDebugInfoOperandMatchExpectation(_, expectation, inst, word_index))
+    utils::FunctionRef<std::string()> ext_inst_name) {
+  if (IsDebugLexicalScope(GetDebugInfoOperandKind(_, inst, word_index)))
     return SPV_SUCCESS;
 
   return _.diag(SPV_ERROR_INVALID_DATA, inst)
@@ -168,20 +190,10 @@ spv_result_t ValidateOperandLexicalScope(
 spv_result_t ValidateOperandDebugType(
     ValidationState_t& _, const std::string& debug_inst_name,
     const Instruction* inst, uint32_t word_index,
-    const std::function<std::string()>& ext_inst_name,
+    utils::FunctionRef<std::string()> ext_inst_name,
     bool allow_template_param) {
-  std::function<bool(OpenCLDebugInfo100Instructions)> expectation =
-      [&allow_template_param](OpenCLDebugInfo100Instructions dbg_inst) {
-        if (allow_template_param &&
-            (dbg_inst == OpenCLDebugInfo100DebugTypeTemplateParameter ||
-             dbg_inst ==
-                 OpenCLDebugInfo100DebugTypeTemplateTemplateParameter)) {
-          return true;
-        }
-        return OpenCLDebugInfo100DebugTypeBasic <= dbg_inst &&
-               dbg_inst <= OpenCLDebugInfo100DebugTypeTemplate;
-      };
-  if (DoesDebugInfoOperandMatchExpectation(_, expectation, inst, word_index))
+  if (IsDebugType(GetDebugInfoOperandKind(_, inst, word_index),
+                  allow_template_param))
     return SPV_SUCCESS;
 
   return _.diag(SPV_ERROR_INVALID_DATA, inst)
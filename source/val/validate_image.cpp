@@ -1431,11 +1431,13 @@ spv_result_t ValidateImageRead(ValidationState_t& _, const Instruction* inst) {
              << "Image Dim SubpassData cannot be used with ImageSparseRead";
     }
 
-    _.function(inst->function()->id())
-        ->RegisterExecutionModelLimitation(
-            SpvExecutionModelFragment,
-            std::string("Dim SubpassData requires Fragment execution model: ") +
-                spvOpcodeString(opcode));
+    Function* function = _.function(inst->function()->id());
+    if (function->RegisterOpcodeLimitations(opcode)) {
+      function->RegisterExecutionModelLimitation(
+          SpvExecutionModelFragment,
+          std::string("Dim SubpassData requires Fragment execution model: ") +
+              spvOpcodeString(opcode));
+    }
   }
 
   if (_.GetIdOpcode(info.sampled_type) != SpvOpTypeVoid) {
@@ -1733,41 +1735,42 @@ spv_result_t ValidateImageQueryFormatOrOrder(ValidationState_t& _,
 
 spv_result_t ValidateImageQueryLod(ValidationState_t& _,
                                    const Instruction* inst) {
-  _.function(inst->function()->id())
-      ->RegisterExecutionModelLimitation(
-          [&](SpvExecutionModel model, std::string* message) {
-            if (model != SpvExecutionModelFragment &&
-                model != SpvExecutionModelGLCompute) {
-              if (message) {
-                *message = std::string(
-                    "OpImageQueryLod requires Fragment or GLCompute execution "
-                    "model");
-              }
-              return false;
+  Function* function = _.function(inst->function()->id());
+  if (function->RegisterOpcodeLimitations(inst->opcode())) {
+    function->RegisterExecutionModelLimitation(
+        [](SpvExecutionModel model, std::string* message) {
+          if (model != SpvExecutionModelFragment &&
+              model != SpvExecutionModelGLCompute) {
+            if (message) {
+              *message = std::string(
+                  "OpImageQueryLod requires Fragment or GLCompute execution "
+                  "model");
             }
-            return true;
-          });
-  _.function(inst->function()->id())
-      ->RegisterLimitation([](const ValidationState_t& state,
-                              const Function* entry_point,
-                              std::string* message) {
-        const auto* models = state.GetExecutionModels(entry_point->id());
-        const auto* modes = state.GetExecutionModes(entry_point->id());
-        if (models->find(SpvExecutionModelGLCompute) != models->end() &&
-            modes->find(SpvExecutionModeDerivativeGroupLinearNV) ==
-                modes->end() &&
-            modes->find(SpvExecutionModeDerivativeGroupQuadsNV) ==
-                modes->end()) {
-          if (message) {
-            *message = std::string(
-                "OpImageQueryLod requires DerivativeGroupQuadsNV "
-                "or DerivativeGroupLinearNV execution mode for GLCompute "
-                "execution model");
+            return false;
           }
-          return false;
+          return true;
+        });
+    function->RegisterLimitation([](const ValidationState_t& state,
+                                    const Function* entry_point,
+                                    std::string* message) {
+      const auto* models = state.GetExecutionModels(entry_point->id());
+      const auto* modes = state.GetExecutionModes(entry_point->id());
+      if (models->find(SpvExecutionModelGLCompute) != models->end() &&
+          modes->find(SpvExecutionModeDerivativeGroupLinearNV) ==
+              modes->end() &&
+          modes->find(SpvExecutionModeDerivativeGroupQuadsNV) ==
+              modes->end()) {
+        if (message) {
+          *message = std::string(
+              "OpImageQueryLod requires DerivativeGroupQuadsNV "
+              "or DerivativeGroupLinearNV execution mode for GLCompute "
+              "execution model");
         }
-        return true;
-      });
+        return false;
+      }
+      return true;
+    });
+  }
 
   const uint32_t result_type = inst->type_id();
   if (!_.IsFloatVectorType(result_type)) {
@@ -1889,46 +1892,49 @@ spv_result_t ValidateImageSparseTexelsResident(ValidationState_t& _,
 // Validates correctness of image instructions.
 spv_result_t ImagePass(ValidationState_t& _, const Instruction* inst) {
   const SpvOp opcode = inst->opcode();
+  // The limitations of the ImplicitLod instructions only depend on their
+  // opcode, so they are registered once per function and opcode.
   if (IsImplicitLod(opcode)) {
-    _.function(inst->function()->id())
-        ->RegisterExecutionModelLimitation([opcode](SpvExecutionModel model,
-                                                    std::string* message) {
-          if (model != SpvExecutionModelFragment &&
-              model != SpvExecutionModelGLCompute) {
-            if (message) {
-              *message =
-                  std::string(
-                      "ImplicitLod instructions require Fragment or GLCompute "
-                      "execution model: ") +
-                  spvOpcodeString(opcode);
-            }
-            return false;
-          }
-          return true;
-        });
-    _.function(inst->function()->id())
-        ->RegisterLimitation([opcode](const ValidationState_t& state,
-                                      const Function* entry_point,
-                                      std::string* message) {
-          const auto* models = state.GetExecutionModels(entry_point->id());
-          const auto* modes = state.GetExecutionModes(entry_point->id());
-          if (models->find(SpvExecutionModelGLCompute) != models->end() &&
-              modes->find(SpvExecutionModeDerivativeGroupLinearNV) ==
-                  modes->end() &&
-              modes->find(SpvExecutionModeDerivativeGroupQuadsNV) ==
-                  modes->end()) {
-            if (message) {
-              *message =
-                  std::string(
-                      "ImplicitLod instructions require DerivativeGroupQuadsNV "
-                      "or DerivativeGroupLinearNV execution mode for GLCompute "
-                      "execution model: ") +
-                  spvOpcodeString(opcode);
+    Function* function = _.function(inst->function()->id());
+    if (function->RegisterOpcodeLimitations(opcode)) {
+      function->RegisterExecutionModelLimitation(
+          [opcode](SpvExecutionModel model, std::string* message) {
+            if (model != SpvExecutionModelFragment &&
+                model != SpvExecutionModelGLCompute) {
+              if (message) {
+                *message =
+                    std::string(
+                        "ImplicitLod instructions require Fragment or "
+                        "GLCompute execution model: ") +
+                    spvOpcodeString(opcode);
+              }
+              return false;
             }
-            return false;
+            return true;
+          });
+      function->RegisterLimitation([opcode](const ValidationState_t& state,
+                                            const Function* entry_point,
+                                            std::string* message) {
+        const auto* models = state.GetExecutionModels(entry_point->id());
+        const auto* modes = state.GetExecutionModes(entry_point->id());
+        if (models->find(SpvExecutionModelGLCompute) != models->end() &&
+            modes->find(SpvExecutionModeDerivativeGroupLinearNV) ==
+                modes->end() &&
+            modes->find(SpvExecutionModeDerivativeGroupQuadsNV) ==
+                modes->end()) {
+          if (message) {
+            *message =
+                std::string(
+                    "ImplicitLod instructions require DerivativeGroupQuadsNV "
+                    "or DerivativeGroupLinearNV execution mode for GLCompute "
+                    "execution model: ") +
+                spvOpcodeString(opcode);
           }
-          return true;
-        });
+          return false;
+        }
+        return true;
+      });
+    }
   }
 
   switch (opcode) {
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "source/diagnostic.h"
 #include "source/spirv_constant.h"
 #include "source/spirv_target_env.h"
+#include "source/util/bit_vector.h"
 #include "source/val/function.h"
 #include "source/val/instruction.h"
 #include "source/val/validate.h"
@@ -102,12 +105,42 @@ spv_result_t check_interface_variable(ValidationState_t& _,
   return SPV_SUCCESS;
 }
 
+// Maps the id of a type to the number of locations it consumes.  The
+// interfaces of the entry points of a module often share their types, so they
+// are measured once for all of the entry points.
+using ConsumedLocationsCache = std::unordered_map<uint32_t, uint32_t>;
+
+// A set of combined location and component values.  Interfaces use few
+// locations, so the small values are kept in a bit vector.  Larger values,
+// which are most likely invalid, go to a hash set instead of growing the bit
+// vector.
+class LocationSet {
+ public:
+  // Adds |value| to the set.  Returns false if it was already there.
+  bool Insert(uint32_t value) {
+    if (value < kMaxDenseValue) return !dense_.Set(value);
+    return sparse_.insert(value).second;
+  }
+
+ private:
+  static const uint32_t kMaxDenseValue = 4096;
+
+  utils::BitVector dense_;
+  std::unordered_set<uint32_t> sparse_;
+};
+
 // This function assumes a base location has been determined already. As such
-// any further location decorations are invalid.
-// TODO: if this code turns out to be slow, there is an opportunity to cache
-// the result for a given type id.
+// any further location decorations are invalid.  The results are memoized in
+// |cache|.
 spv_result_t NumConsumedLocations(ValidationState_t& _, const Instruction* type,
+                                  ConsumedLocationsCache* cache,
                                   uint32_t* num_locations) {
+  auto cached = cache->find(type->id());
+  if (cached != cache->end()) {
+    *num_locations = cached->second;
+    return SPV_SUCCESS;
+  }
+
   *num_locations = 0;
   switch (type->opcode()) {
     case SpvOpTypeInt:
@@ -129,14 +162,14 @@ spv_result_t NumConsumedLocations(ValidationState_t& _, const Instruction* type,
       // Matrices consume locations equal to the underlying vector type for
       // each column.
       NumConsumedLocations(_, _.FindDef(type->GetOperandAs<uint32_t>(1)),
-                           num_locations);
+                           cache, num_locations);
       *num_locations *= type->GetOperandAs<uint32_t>(2);
       break;
     case SpvOpTypeArray: {
       // Arrays consume locations equal to the underlying type times the number
       // of elements in the vector.
       NumConsumedLocations(_, _.FindDef(type->GetOperandAs<uint32_t>(1)),
-                           num_locations);
+                           cache, num_locations);
       bool is_int = false;
       bool is_const = false;
       uint32_t value = 0;
@@ -158,7 +191,7 @@ spv_result_t NumConsumedLocations(ValidationState_t& _, const Instruction* type,
       for (uint32_t i = 1; i < type->operands().size(); ++i) {
         uint32_t member_locations = 0;
         if (auto error = NumConsumedLocations(
-                _, _.FindDef(type->GetOperandAs<uint32_t>(i)),
+                _, _.FindDef(type->GetOperandAs<uint32_t>(i)), cache,
                 &member_locations)) {
           return error;
         }
@@ -170,6 +203,7 @@ spv_result_t NumConsumedLocations(ValidationState_t& _, const Instruction* type,
       break;
   }
 
+  (*cache)[type->id()] = *num_locations;
   return SPV_SUCCESS;
 }
 
@@ -208,8 +242,8 @@ uint32_t NumConsumedComponents(ValidationState_t& _, const Instruction* type) {
 // 4 * location + component.
 spv_result_t GetLocationsForVariable(
     ValidationState_t& _, const Instruction* entry_point,
-    const Instruction* variable, std::unordered_set<uint32_t>* locations,
-    std::unordered_set<uint32_t>* output_index1_locations) {
+    const Instruction* variable, ConsumedLocationsCache* cache,
+    LocationSet* locations, LocationSet* output_index1_locations) {
   const bool is_fragment = entry_point->GetOperandAs<SpvExecutionModel>(0) ==
                            SpvExecutionModelFragment;
   const bool is_output =
@@ -341,7 +375,8 @@ spv_result_t GetLocationsForVariable(
 
     for (uint32_t array_idx = 0; array_idx < array_size; ++array_idx) {
       uint32_t num_locations = 0;
-      if (auto error = NumConsumedLocations(_, sub_type, &num_locations))
+      if (auto error =
+              NumConsumedLocations(_, sub_type, cache, &num_locations))
         return error;
 
       uint32_t num_components = NumConsumedComponents(_, sub_type);
@@ -357,7 +392,7 @@ spv_result_t GetLocationsForVariable(
       if (has_index && index == 1) locs = output_index1_locations;
 
       for (uint32_t i = start; i < end; ++i) {
-        if (!locs->insert(i).second) {
+        if (!locs->Insert(i)) {
           return _.diag(SPV_ERROR_INVALID_DATA, entry_point)
                  << "Entry-point has conflicting " << storage_class
                  << " location assignment at location " << i / 4
@@ -405,7 +440,7 @@ spv_result_t GetLocationsForVariable(
       location = where->second;
       auto member = _.FindDef(type->GetOperandAs<uint32_t>(i));
       uint32_t num_locations = 0;
-      if (auto error = NumConsumedLocations(_, member, &num_locations))
+      if (auto error = NumConsumedLocations(_, member, cache, &num_locations))
         return error;
 
       // If the component is not specified, it is assumed to be zero.
@@ -422,7 +457,7 @@ spv_result_t GetLocationsForVariable(
         end = location * 4 + component + num_components;
       }
       for (uint32_t l = start; l < end; ++l) {
-        if (!locations->insert(l).second) {
+        if (!locations->Insert(l)) {
           return _.diag(SPV_ERROR_INVALID_DATA, entry_point)
                  << "Entry-point has conflicting " << storage_class
                  << " location assignment at location " << l / 4
@@ -436,7 +471,8 @@ spv_result_t GetLocationsForVariable(
 }
 
 spv_result_t ValidateLocations(ValidationState_t& _,
-                               const Instruction* entry_point) {
+                               const Instruction* entry_point,
+                               ConsumedLocationsCache* cache) {
   // According to Vulkan 14.1 only the following execution models have
   // locations assigned.
   switch (entry_point->GetOperandAs<SpvExecutionModel>(0)) {
@@ -451,9 +487,9 @@ spv_result_t ValidateLocations(ValidationState_t& _,
   }
 
   // Locations are stored as a combined location and component values.
-  std::unordered_set<uint32_t> input_locations;
-  std::unordered_set<uint32_t> output_locations_index0;
-  std::unordered_set<uint32_t> output_locations_index1;
+  LocationSet input_locations;
+  LocationSet output_locations_index0;
+  LocationSet output_locations_index1;
   for (uint32_t i = 3; i < entry_point->operands().size(); ++i) {
     auto interface_id = entry_point->GetOperandAs<uint32_t>(i);
     auto interface_var = _.FindDef(interface_id);
@@ -466,8 +502,9 @@ spv_result_t ValidateLocations(ValidationState_t& _,
     auto locations = (storage_class == SpvStorageClassInput)
                          ? &input_locations
                          : &output_locations_index0;
-    if (auto error = GetLocationsForVariable(
-            _, entry_point, interface_var, locations, &output_locations_index1))
+    if (auto error =
+            GetLocationsForVariable(_, entry_point, interface_var, cache,
+                                    locations, &output_locations_index1))
       return error;
   }
 
@@ -487,9 +524,10 @@ spv_result_t ValidateInterfaces(ValidationState_t& _) {
   }
 
   if (spvIsVulkanEnv(_.context()->target_env)) {
+    ConsumedLocationsCache consumed_locations;
     for (auto& inst : _.ordered_instructions()) {
       if (inst.opcode() == SpvOpEntryPoint) {
-        if (auto error = ValidateLocations(_, &inst)) {
+        if (auto error = ValidateLocations(_, &inst, &consumed_locations)) {
           return error;
         }
       }
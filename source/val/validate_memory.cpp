@@ -78,8 +78,8 @@ bool HaveLayoutCompatibleMembers(ValidationState_t& _, const Instruction* type1,
          "type1 must be an OpTypeStruct instruction.");
   assert(type2->opcode() == SpvOpTypeStruct &&
          "type2 must be an OpTypeStruct instruction.");
-  const auto& type1_operands = type1->operands();
-  const auto& type2_operands = type2->operands();
+  const auto type1_operands = type1->operands();
+  const auto type2_operands = type2->operands();
   if (type1_operands.size() != type2_operands.size()) {
     return false;
   }
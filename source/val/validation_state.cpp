@@ -14,12 +14,16 @@
 
 #include "source/val/validation_state.h"
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <mutex>
 #include <stack>
 #include <utility>
 
 #include "source/opcode.h"
 #include "source/spirv_constant.h"
+#include "source/spirv_endian.h"
 #include "source/spirv_target_env.h"
 #include "source/val/basic_block.h"
 #include "source/val/construct.h"
@@ -30,6 +34,9 @@ namespace spvtools {
 namespace val {
 namespace {
 
+// The current diagnostic collector of each thread.
+thread_local DiagnosticCollector* current_collector = nullptr;
+
 bool IsInstructionInLayoutSection(ModuleLayoutSection layout, SpvOp op) {
   // See Section 2.4
   bool out = false;
@@ -140,26 +147,39 @@ bool IsInstructionInLayoutSection(ModuleLayoutSection layout, SpvOp op) {
   return out;
 }
 
-// Counts the number of instructions and functions in the file.
-spv_result_t CountInstructions(void* user_data,
-                               const spv_parsed_instruction_t* inst) {
-  ValidationState_t& _ = *(reinterpret_cast<ValidationState_t*>(user_data));
-  if (inst->opcode == SpvOpFunction) _.increment_total_functions();
-  _.increment_total_instructions();
-
-  return SPV_SUCCESS;
-}
-
-spv_result_t setHeader(void* user_data, spv_endianness_t, uint32_t,
-                       uint32_t version, uint32_t generator, uint32_t id_bound,
-                       uint32_t) {
-  ValidationState_t& vstate =
-      *(reinterpret_cast<ValidationState_t*>(user_data));
-  vstate.setIdBound(id_bound);
-  vstate.setGenerator(generator);
-  vstate.setVersion(version);
-
-  return SPV_SUCCESS;
+// Records the header of the module in |words| in |_|, and counts its
+// instructions, functions and operands.  Only the first word of each
+// instruction is read, so this is much cheaper than parsing the module.  The
+// number of operands is an upper bound, since an operand takes at least one
+// word.  Words that are not a module are left for the parser to report.
+void CountInstructions(ValidationState_t* _, const uint32_t* words,
+                       size_t num_words) {
+  const spv_const_binary_t binary = {words, num_words};
+  spv_endianness_t endian;
+  if (num_words < SPV_INDEX_INSTRUCTION ||
+      spvBinaryEndianness(&binary, &endian) != SPV_SUCCESS) {
+    return;
+  }
+  _->setVersion(spvFixWord(words[SPV_INDEX_VERSION_NUMBER], endian));
+  _->setGenerator(spvFixWord(words[SPV_INDEX_GENERATOR_NUMBER], endian));
+  _->setIdBound(spvFixWord(words[SPV_INDEX_BOUND], endian));
+
+  size_t function_blocks = 0;
+  for (size_t index = SPV_INDEX_INSTRUCTION; index < num_words;) {
+    uint16_t word_count = 0;
+    uint16_t opcode = 0;
+    spvOpcodeSplit(spvFixWord(words[index], endian), &word_count, &opcode);
+    if (word_count == 0 || word_count > num_words - index) break;
+    if (opcode == SpvOpFunction) {
+      _->increment_total_functions();
+      function_blocks = 0;
+    } else if (opcode == SpvOpLabel) {
+      _->update_max_function_blocks(++function_blocks);
+    }
+    _->increment_total_instructions();
+    _->add_total_operands(word_count - 1u);
+    index += word_count;
+  }
 }
 
 // Add features based on SPIR-V core version number.
@@ -174,8 +194,44 @@ void UpdateFeaturesBasedOnSpirvVersion(ValidationState_t::Feature* features,
   }
 }
 
+// Copies the |count| |values| to the last of |chunks| and returns where they
+// are, adding a chunk with room for at least |chunk_size| values when the last
+// one is full.
+template <typename T>
+const T* AppendToChunks(std::vector<std::vector<T>>* chunks, const T* values,
+                        size_t count, size_t chunk_size) {
+  if (count == 0) return nullptr;
+  if (chunks->empty() ||
+      chunks->back().capacity() - chunks->back().size() < count) {
+    chunks->emplace_back();
+    chunks->back().reserve(std::max(count, chunk_size));
+  }
+  std::vector<T>& chunk = chunks->back();
+  const size_t offset = chunk.size();
+  chunk.insert(chunk.end(), values, values + count);
+  return chunk.data() + offset;
+}
+
 }  // namespace
 
+DiagnosticCollector::Scope::Scope(DiagnosticCollector* collector)
+    : previous_(current_collector) {
+  current_collector = collector;
+}
+
+DiagnosticCollector::Scope::~Scope() { current_collector = previous_; }
+
+DiagnosticCollector* DiagnosticCollector::Current() {
+  return current_collector;
+}
+
+MessageConsumer DiagnosticCollector::consumer() {
+  return [this](spv_message_level_t level, const char* source,
+                const spv_position_t& position, const char* message) {
+    diagnostics_.push_back({level, source ? source : "", position, message});
+  };
+}
+
 ValidationState_t::ValidationState_t(const spv_const_context ctx,
                                      const spv_const_validator_options opt,
                                      const uint32_t* words,
@@ -218,23 +274,12 @@ ValidationState_t::ValidationState_t(const spv_const_context ctx,
   // Only attempt to count if we have words, otherwise let the other validation
   // fail and generate an error.
   if (num_words > 0) {
-    // Count the number of instructions in the binary.
-    // This parse should not produce any error messages. Hijack the context and
-    // replace the message consumer so that we do not pollute any state in input
-    // consumer.
-    spv_context_t hijacked_context = *ctx;
-    hijacked_context.consumer = [](spv_message_level_t, const char*,
-                                   const spv_position_t&, const char*) {};
-    spvBinaryParse(&hijacked_context, this, words, num_words, setHeader,
-                   CountInstructions,
-                   /* diagnostic = */ nullptr);
-    preallocateStorage();
+    CountInstructions(this, words, num_words);
+    // A module over the budget is rejected before it is parsed, so no storage
+    // is allocated for it.
+    if (!ExceedsBudget()) preallocateStorage();
   }
   UpdateFeaturesBasedOnSpirvVersion(&features_, version_);
-
-  friendly_mapper_ = spvtools::MakeUnique<spvtools::FriendlyNameMapper>(
-      context_, words_, num_words_);
-  name_mapper_ = friendly_mapper_->GetNameMapper();
 }
 
 void ValidationState_t::preallocateStorage() {
@@ -266,7 +311,17 @@ void ValidationState_t::AssignNameToId(uint32_t id, std::string name) {
 }
 
 std::string ValidationState_t::getIdName(uint32_t id) const {
-  const std::string id_name = name_mapper_(id);
+  // Id names only end up in diagnostics, which are dropped without a consumer.
+  if (!context_->consumer) return std::to_string(id);
+
+  // The names are only needed for diagnostics, so they are only computed when
+  // the first one is emitted.  Diagnostics may be emitted from several threads
+  // at the same time.
+  std::call_once(friendly_mapper_once_, [this]() {
+    friendly_mapper_ = spvtools::MakeUnique<spvtools::FriendlyNameMapper>(
+        context_, words_, num_words_);
+  });
+  const std::string id_name = friendly_mapper_->NameForId(id);
 
   std::stringstream out;
   out << id << "[%" << id_name << "]";
@@ -317,22 +372,44 @@ bool ValidationState_t::IsOpcodeInCurrentLayoutSection(SpvOp op) {
 
 DiagnosticStream ValidationState_t::diag(spv_result_t error_code,
                                          const Instruction* inst) {
-  if (error_code == SPV_WARNING) {
-    if (num_of_warnings_ == max_num_of_warnings_) {
-      DiagnosticStream({0, 0, 0}, context_->consumer, "", error_code)
-          << "Other warnings have been suppressed.\n";
-    }
-    if (num_of_warnings_ >= max_num_of_warnings_) {
-      return DiagnosticStream({0, 0, 0}, nullptr, "", error_code);
-    }
-    ++num_of_warnings_;
+  // Without a consumer the message would be dropped, so do not build it.
+  if (!context_->consumer) {
+    return DiagnosticStream({0, 0, 0}, nullptr, "", error_code);
+  }
+
+  // Warnings held by a collector are counted when they are reported.
+  DiagnosticCollector* collector = DiagnosticCollector::Current();
+  if (!collector && error_code == SPV_WARNING && !CountWarning()) {
+    return DiagnosticStream({0, 0, 0}, nullptr, "", error_code);
   }
 
   std::string disassembly;
   if (inst) disassembly = Disassemble(*inst);
 
-  return DiagnosticStream({0, 0, inst ? inst->LineNum() : 0},
-                          context_->consumer, disassembly, error_code);
+  const MessageConsumer& consumer =
+      collector ? collector->consumer() : context_->consumer;
+  return DiagnosticStream({0, 0, inst ? inst->LineNum() : 0}, consumer,
+                          disassembly, error_code);
+}
+
+void ValidationState_t::ReportDiagnostics(
+    const DiagnosticCollector& collector) {
+  if (!context_->consumer) return;
+  for (const auto& diagnostic : collector.diagnostics_) {
+    if (diagnostic.level == SPV_MSG_WARNING && !CountWarning()) continue;
+    context_->consumer(diagnostic.level, diagnostic.source.c_str(),
+                       diagnostic.position, diagnostic.message.c_str());
+  }
+}
+
+bool ValidationState_t::CountWarning() {
+  if (num_of_warnings_ == max_num_of_warnings_) {
+    DiagnosticStream({0, 0, 0}, context_->consumer, "", SPV_WARNING)
+        << "Other warnings have been suppressed.\n";
+  }
+  if (num_of_warnings_ >= max_num_of_warnings_) return false;
+  ++num_of_warnings_;
+  return true;
 }
 
 std::vector<Function>& ValidationState_t::functions() {
@@ -516,7 +593,18 @@ spv_result_t ValidationState_t::RegisterFunctionEnd() {
 
 Instruction* ValidationState_t::AddOrderedInstruction(
     const spv_parsed_instruction_t* inst) {
-  ordered_instructions_.emplace_back(inst);
+  spv_parsed_instruction_t stored = *inst;
+  // The parser only hands out words outside of the module when it converted
+  // them to the host endianness.
+  const std::less<const uint32_t*> less;
+  if (less(inst->words, words_) ||
+      less(words_ + num_words_, inst->words + inst->num_words)) {
+    stored.words = AppendToChunks(&instruction_words_, inst->words,
+                                  inst->num_words, num_words_);
+  }
+  stored.operands = AppendToChunks(&instruction_operands_, inst->operands,
+                                   inst->num_operands, total_operands_);
+  ordered_instructions_.emplace_back(&stored);
   ordered_instructions_.back().SetLineNum(ordered_instructions_.size());
   return &ordered_instructions_.back();
 }
@@ -550,7 +638,11 @@ void ValidationState_t::RegisterDebugInstruction(const Instruction* inst) {
 }
 
 void ValidationState_t::RegisterInstruction(Instruction* inst) {
-  if (inst->id()) all_definitions_.insert(std::make_pair(inst->id(), inst));
+  if (inst->id() &&
+      all_definitions_.insert(std::make_pair(inst->id(), inst)).second &&
+      spvOpcodeGeneratesType(inst->opcode())) {
+    SummarizeScalarTypes(inst);
+  }
 
   // If the instruction is using an OpTypeSampledImage as an operand, it should
   // be recorded. The validator will ensure that all usages of an
@@ -584,25 +676,89 @@ void ValidationState_t::RegisterSampledImageConsumer(uint32_t sampled_image_id,
 
 uint32_t ValidationState_t::getIdBound() const { return id_bound_; }
 
-void ValidationState_t::setIdBound(const uint32_t bound) { id_bound_ = bound; }
+uint64_t ValidationState_t::EstimatedMemoryUse() const {
+  return uint64_t(total_instructions_) * sizeof(Instruction) +
+         uint64_t(total_operands_) * sizeof(spv_parsed_operand_t) +
+         uint64_t(total_functions_) * sizeof(Function) +
+         uint64_t(id_bound_) * sizeof(Instruction*);
+}
+
+bool ValidationState_t::ExceedsBudget() const {
+  const validator_universal_limits_t& limits = options_->universal_limits_;
+  return total_instructions_ > limits.max_instructions ||
+         max_function_blocks_ > limits.max_function_blocks ||
+         EstimatedMemoryUse() > uint64_t(limits.max_memory_kib) * 1024;
+}
+
+void ValidationState_t::setIdBound(const uint32_t bound) {
+  id_bound_ = bound;
+  id_decorations_.Reserve(bound);
+}
 
 bool ValidationState_t::RegisterUniqueTypeDeclaration(const Instruction* inst) {
-  std::vector<uint32_t> key;
-  key.push_back(static_cast<uint32_t>(inst->opcode()));
-  for (size_t index = 0; index < inst->operands().size(); ++index) {
-    const spv_parsed_operand_t& operand = inst->operand(index);
+  return unique_type_declarations_.insert(inst).second;
+}
+
+namespace {
 
-    if (operand.type == SPV_OPERAND_TYPE_RESULT_ID) continue;
+// The words of a type declaration that identify the type it declares: the
+// words of all of its operands but the result id.  The operands cover all of
+// the words of the instruction except the first one.
+class TypeDeclarationKey {
+ public:
+  explicit TypeDeclarationKey(const Instruction* inst)
+      : words_(inst->words()), result_begin_(0), result_end_(0) {
+    for (const spv_parsed_operand_t& operand : inst->operands()) {
+      if (operand.type == SPV_OPERAND_TYPE_RESULT_ID) {
+        result_begin_ = operand.offset;
+        result_end_ = operand.offset + operand.num_words;
+        break;
+      }
+    }
+    assert(result_end_ <= words_.size());
+  }
 
-    const int words_begin = operand.offset;
-    const int words_end = words_begin + operand.num_words;
-    assert(words_end <= static_cast<int>(inst->words().size()));
+  size_t size() const {
+    return words_.size() - 1 - (result_end_ - result_begin_);
+  }
 
-    key.insert(key.end(), inst->words().begin() + words_begin,
-               inst->words().begin() + words_end);
+  uint32_t operator[](size_t index) const {
+    // Skip the first word, then the words of the result id.
+    size_t word = index + 1;
+    if (result_begin_ != 0 && word >= result_begin_) {
+      word += result_end_ - result_begin_;
+    }
+    return words_[word];
   }
 
-  return unique_type_declarations_.insert(std::move(key)).second;
+ private:
+  const std::vector<uint32_t>& words_;
+  size_t result_begin_;
+  size_t result_end_;
+};
+
+}  // namespace
+
+size_t ValidationState_t::TypeDeclarationHash::operator()(
+    const Instruction* inst) const {
+  const TypeDeclarationKey key(inst);
+  size_t hash = std::hash<uint32_t>()(inst->opcode());
+  for (size_t i = 0; i < key.size(); ++i) {
+    hash = hash * 31 + key[i];
+  }
+  return hash;
+}
+
+bool ValidationState_t::TypeDeclarationEqual::operator()(
+    const Instruction* lhs, const Instruction* rhs) const {
+  if (lhs->opcode() != rhs->opcode()) return false;
+  const TypeDeclarationKey lhs_key(lhs);
+  const TypeDeclarationKey rhs_key(rhs);
+  if (lhs_key.size() != rhs_key.size()) return false;
+  for (size_t i = 0; i < lhs_key.size(); ++i) {
+    if (lhs_key[i] != rhs_key[i]) return false;
+  }
+  return true;
 }
 
 uint32_t ValidationState_t::GetTypeId(uint32_t id) const {
@@ -1049,6 +1205,36 @@ void ValidationState_t::ComputeFunctionToEntryPointMapping() {
       }
     }
   }
+
+  // Number the execution models used by the module, so that the models of a
+  // function fit in a bit mask.
+  for (const auto& models : entry_point_to_execution_models_) {
+    for (const SpvExecutionModel model : models.second) {
+      execution_model_bits_.emplace(
+          model, static_cast<uint32_t>(execution_model_bits_.size()));
+    }
+  }
+
+  for (const auto& func : function_to_entry_points_) {
+    FunctionExecutionModelSet& model_set =
+        function_to_execution_models_[func.first];
+    for (const uint32_t entry_point : func.second) {
+      const auto models = entry_point_to_execution_models_.find(entry_point);
+      if (models == entry_point_to_execution_models_.end()) continue;
+      for (const SpvExecutionModel model : models->second) {
+        const uint32_t bit = execution_model_bits_[model];
+        if (bit < 64) {
+          if (model_set.mask & (uint64_t(1) << bit)) continue;
+          model_set.mask |= uint64_t(1) << bit;
+        } else if (std::find(model_set.models.begin(), model_set.models.end(),
+                             model) != model_set.models.end()) {
+          continue;
+        }
+        model_set.models.push_back(model);
+      }
+    }
+    std::sort(model_set.models.begin(), model_set.models.end());
+  }
 }
 
 void ValidationState_t::ComputeRecursiveEntryPoints() {
@@ -1094,6 +1280,28 @@ const std::vector<uint32_t>& ValidationState_t::FunctionEntryPoints(
   }
 }
 
+const std::vector<SpvExecutionModel>&
+ValidationState_t::FunctionExecutionModels(uint32_t func) const {
+  const auto iter = function_to_execution_models_.find(func);
+  if (iter == function_to_execution_models_.end()) {
+    return empty_execution_models_;
+  }
+  return iter->second.models;
+}
+
+bool ValidationState_t::FunctionHasExecutionModel(
+    uint32_t func, SpvExecutionModel model) const {
+  const auto iter = function_to_execution_models_.find(func);
+  if (iter == function_to_execution_models_.end()) return false;
+  const auto bit = execution_model_bits_.find(model);
+  if (bit == execution_model_bits_.end()) return false;
+  if (bit->second < 64) {
+    return (iter->second.mask & (uint64_t(1) << bit->second)) != 0;
+  }
+  const auto& models = iter->second.models;
+  return std::binary_search(models.begin(), models.end(), model);
+}
+
 std::set<uint32_t> ValidationState_t::EntryPointReferences(uint32_t id) const {
   std::set<uint32_t> referenced_entry_points;
   const auto inst = FindDef(id);
@@ -1221,10 +1429,89 @@ const Instruction* ValidationState_t::TracePointer(
   return base_ptr;
 }
 
+uint8_t ValidationState_t::ScalarTypeBit(SpvOp type, uint32_t width) {
+  if (type == SpvOpTypeInt) {
+    switch (width) {
+      case 8:
+        return kInt8Bit;
+      case 16:
+        return kInt16Bit;
+      case 32:
+        return kInt32Bit;
+      case 64:
+        return kInt64Bit;
+      default:
+        return 0;
+    }
+  }
+  if (type == SpvOpTypeFloat) {
+    switch (width) {
+      case 16:
+        return kFloat16Bit;
+      case 32:
+        return kFloat32Bit;
+      case 64:
+        return kFloat64Bit;
+      default:
+        return 0;
+    }
+  }
+  return 0;
+}
+
+void ValidationState_t::SummarizeScalarTypes(const Instruction* inst) {
+  // The bits of the registered type |id|.
+  const auto contained = [this](uint32_t id) -> uint8_t {
+    return id < contained_scalar_types_.size() ? contained_scalar_types_[id]
+                                               : 0;
+  };
+
+  uint8_t bits = kScalarTypesSummarized;
+  switch (inst->opcode()) {
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+      bits |= ScalarTypeBit(inst->opcode(), inst->GetOperandAs<uint32_t>(1u));
+      break;
+    case SpvOpTypeArray:
+    case SpvOpTypeRuntimeArray:
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+    case SpvOpTypeImage:
+    case SpvOpTypeSampledImage:
+    case SpvOpTypeCooperativeMatrixNV:
+      bits |= contained(inst->GetOperandAs<uint32_t>(1u));
+      break;
+    case SpvOpTypePointer:
+      if (!IsForwardPointer(inst->id())) {
+        bits |= contained(inst->GetOperandAs<uint32_t>(2u));
+      }
+      break;
+    case SpvOpTypeFunction:
+    case SpvOpTypeStruct:
+      for (uint32_t i = 1; i < inst->operands().size(); ++i) {
+        bits |= contained(inst->GetOperandAs<uint32_t>(i));
+      }
+      break;
+    default:
+      break;
+  }
+
+  if (inst->id() >= contained_scalar_types_.size()) {
+    contained_scalar_types_.resize(inst->id() + 1, 0);
+  }
+  contained_scalar_types_[inst->id()] = bits;
+}
+
 bool ValidationState_t::ContainsSizedIntOrFloatType(uint32_t id, SpvOp type,
                                                     uint32_t width) const {
   if (type != SpvOpTypeInt && type != SpvOpTypeFloat) return false;
 
+  const uint8_t bit = ScalarTypeBit(type, width);
+  if (bit && id < contained_scalar_types_.size() &&
+      (contained_scalar_types_[id] & kScalarTypesSummarized)) {
+    return (contained_scalar_types_[id] & bit) != 0;
+  }
+
   const auto inst = FindDef(id);
   if (!inst) return false;
 
@@ -17,6 +17,8 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <tuple>
@@ -33,6 +35,7 @@
 #include "source/spirv_definition.h"
 #include "source/spirv_validator_options.h"
 #include "source/val/decoration.h"
+#include "source/val/decoration_index.h"
 #include "source/val/function.h"
 #include "source/val/instruction.h"
 #include "spirv-tools/libspirv.h"
@@ -59,6 +62,47 @@ enum ModuleLayoutSection {
   kLayoutFunctionDefinitions    /// < Section 2.4 #11
 };
 
+/// Holds the diagnostics emitted by |ValidationState_t::diag| on a thread while
+/// the collector is current for it (see |Scope|), instead of sending them to
+/// the message consumer.  |ValidationState_t::ReportDiagnostics| sends them
+/// later, which lets checks run on several threads report their diagnostics
+/// in a deterministic order.
+class DiagnosticCollector {
+ public:
+  /// Makes a collector the current one of the calling thread for the lifetime
+  /// of the scope.
+  class Scope {
+   public:
+    explicit Scope(DiagnosticCollector* collector);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    DiagnosticCollector* previous_;
+  };
+
+  /// Returns the current collector of the calling thread, or nullptr if there
+  /// is none.
+  static DiagnosticCollector* Current();
+
+  /// Returns a consumer that adds the messages it receives to the collector.
+  MessageConsumer consumer();
+
+ private:
+  friend class ValidationState_t;
+
+  struct Diagnostic {
+    spv_message_level_t level;
+    std::string source;
+    spv_position_t position;
+    std::string message;
+  };
+
+  std::vector<Diagnostic> diagnostics_;
+};
+
 /// This class manages the state of the SPIR-V validation as it is being parsed.
 class ValidationState_t {
  public:
@@ -181,9 +225,31 @@ class ValidationState_t {
   /// Increments the total number of instructions in the file.
   void increment_total_instructions() { total_instructions_++; }
 
+  /// Adds |count| to the total number of operands in the file.
+  void add_total_operands(size_t count) { total_operands_ += count; }
+
   /// Increments the total number of functions in the file.
   void increment_total_functions() { total_functions_++; }
 
+  /// Records that a function of the file has at least |count| blocks.
+  void update_max_function_blocks(size_t count) {
+    max_function_blocks_ = std::max(max_function_blocks_, count);
+  }
+
+  /// Returns the total number of instructions in the file, and the largest
+  /// number of blocks of one of its functions, as counted before parsing.
+  size_t total_instructions() const { return total_instructions_; }
+  size_t max_function_blocks() const { return max_function_blocks_; }
+
+  /// Returns a lower bound of the memory, in bytes, the instructions and ids
+  /// of the file take in this state, as counted before parsing.
+  uint64_t EstimatedMemoryUse() const;
+
+  /// Returns true if the counts taken before parsing exceed one of the budget
+  /// limits of the validator options: the number of instructions, of blocks
+  /// of a function, or the estimated memory use.
+  bool ExceedsBudget() const;
+
   /// Allocates internal storage. Note, calling this will invalidate any
   /// pointers to |ordered_instructions_| or |module_functions_| and, hence,
   /// should only be called at the beginning of validation.
@@ -198,8 +264,16 @@ class ValidationState_t {
   /// Determines if the op instruction is part of the current section
   bool IsOpcodeInCurrentLayoutSection(SpvOp op);
 
+  /// Returns a stream for a diagnostic about |inst|.  The diagnostic goes to
+  /// the current DiagnosticCollector of the calling thread if there is one,
+  /// and to the message consumer of the context otherwise.
   DiagnosticStream diag(spv_result_t error_code, const Instruction* inst);
 
+  /// Sends the diagnostics held by |collector| to the message consumer of the
+  /// context, in the order they were emitted.  Warnings count towards the
+  /// limit on the number of warnings as if they were reported directly.
+  void ReportDiagnostics(const DiagnosticCollector& collector);
+
   /// Returns the function states
   std::vector<Function>& functions();
 
@@ -276,7 +350,8 @@ class ValidationState_t {
     return &it->second;
   }
 
-  /// Traverses call tree and computes function_to_entry_points_.
+  /// Traverses call tree and computes function_to_entry_points_ and
+  /// function_to_execution_models_.
   /// Note: called after fully parsing the binary.
   void ComputeFunctionToEntryPointMapping();
 
@@ -288,6 +363,19 @@ class ValidationState_t {
   /// Returns all the entry points that can call |func|.
   const std::vector<uint32_t>& FunctionEntryPoints(uint32_t func) const;
 
+  /// Returns the execution models of all the entry points that can call
+  /// |func|, in increasing order and without duplicates.
+  ///
+  /// Note: requires ComputeFunctionToEntryPointMapping to have been called.
+  const std::vector<SpvExecutionModel>& FunctionExecutionModels(
+      uint32_t func) const;
+
+  /// Returns true if |func| can be called from an entry point with the
+  /// execution model |model|.
+  ///
+  /// Note: requires ComputeFunctionToEntryPointMapping to have been called.
+  bool FunctionHasExecutionModel(uint32_t func, SpvExecutionModel model) const;
+
   /// Returns all the entry points that statically use |id|.
   ///
   /// Note: requires ComputeFunctionToEntryPointMapping to have been called.
@@ -372,10 +460,14 @@ class ValidationState_t {
   const AssemblyGrammar& grammar() const { return grammar_; }
 
   /// Inserts the instruction into the list of ordered instructions in the file.
+  /// Its words are referenced in place when they are in the module being
+  /// validated, which must then outlive the validation state, and copied
+  /// otherwise.  Its operands are copied.
   Instruction* AddOrderedInstruction(const spv_parsed_instruction_t* inst);
 
   /// Registers the instruction. This will add the instruction to the list of
-  /// definitions and register sampled image consumers.
+  /// definitions, register sampled image consumers and, for a type,
+  /// summarize the int and float types it contains.
   void RegisterInstruction(Instruction* inst);
 
   /// Registers the debug instruction information.
@@ -383,18 +475,13 @@ class ValidationState_t {
 
   /// Registers the decoration for the given <id>
   void RegisterDecorationForId(uint32_t id, const Decoration& dec) {
-    auto& dec_list = id_decorations_[id];
-    auto lb = std::find(dec_list.begin(), dec_list.end(), dec);
-    if (lb == dec_list.end()) {
-      dec_list.push_back(dec);
-    }
+    id_decorations_.AddUnique(id, dec);
   }
 
   /// Registers the list of decorations for the given <id>
   template <class InputIt>
   void RegisterDecorationsForId(uint32_t id, InputIt begin, InputIt end) {
-    std::vector<Decoration>& cur_decs = id_decorations_[id];
-    cur_decs.insert(cur_decs.end(), begin, end);
+    for (; begin != end; ++begin) id_decorations_.Add(id, *begin);
   }
 
   /// Registers the list of decorations for the given member of the given
@@ -403,33 +490,48 @@ class ValidationState_t {
   void RegisterDecorationsForStructMember(uint32_t struct_id,
                                           uint32_t member_index, InputIt begin,
                                           InputIt end) {
-    RegisterDecorationsForId(struct_id, begin, end);
-    for (auto& decoration : id_decorations_[struct_id]) {
+    for (; begin != end; ++begin) {
+      Decoration decoration = *begin;
       decoration.set_struct_member_index(member_index);
+      id_decorations_.Add(struct_id, decoration);
     }
   }
 
-  /// Returns all the decorations for the given <id>. If no decorations exist
-  /// for the <id>, it registers an empty vector for it in the map and
-  /// returns the empty vector.
-  std::vector<Decoration>& id_decorations(uint32_t id) {
-    return id_decorations_[id];
+  /// Returns all the decorations for the given <id>, or an empty vector if no
+  /// decorations exist for the <id>.  Does not modify the state, so it can be
+  /// called by checks running on several threads.
+  const std::vector<Decoration>& id_decorations(uint32_t id) const {
+    return id_decorations_.Get(id);
   }
 
-  // Returns const pointer to the internal decoration container.
-  const std::map<uint32_t, std::vector<Decoration>>& id_decorations() const {
-    return id_decorations_;
+  /// Returns the decorations of member <member_index> of the structure <id>.
+  const std::vector<Decoration>& member_decorations(
+      uint32_t id, uint32_t member_index) const {
+    return id_decorations_.GetForMember(id, member_index);
+  }
+
+  /// Returns the ids that have decorations, in increasing order.
+  std::vector<uint32_t> decorated_ids() const {
+    return id_decorations_.DecoratedIds();
   }
 
   /// Returns true if the given id <id> has the given decoration <dec>,
   /// otherwise returns false.
-  bool HasDecoration(uint32_t id, SpvDecoration dec) {
-    const auto& decorations = id_decorations_.find(id);
-    if (decorations == id_decorations_.end()) return false;
+  bool HasDecoration(uint32_t id, SpvDecoration dec) const {
+    return id_decorations_.Has(id, dec);
+  }
 
-    return std::any_of(
-        decorations->second.begin(), decorations->second.end(),
-        [dec](const Decoration& d) { return dec == d.dec_type(); });
+  /// Returns the first decoration <dec> of <id> or of one of its members, or
+  /// nullptr if there is none.
+  const Decoration* FindDecoration(uint32_t id, SpvDecoration dec) const {
+    return id_decorations_.Find(id, dec);
+  }
+
+  /// Returns the first decoration <dec> of member <member_index> of the
+  /// structure <id>, or nullptr if there is none.
+  const Decoration* FindMemberDecoration(uint32_t id, uint32_t member_index,
+                                         SpvDecoration dec) const {
+    return id_decorations_.FindForMember(id, member_index, dec);
   }
 
   /// Finds id's def, if it exists.  If found, returns the definition otherwise
@@ -577,7 +679,8 @@ class ValidationState_t {
   bool IsUnsignedIntCooperativeMatrixType(uint32_t id) const;
 
   // Returns true if |id| is a type id that contains |type| (or integer or
-  // floating point type) of |width| bits.
+  // floating point type) of |width| bits.  For the widths of 8, 16, 32 and 64
+  // bits of a registered type, this is a lookup in the summary of the type.
   bool ContainsSizedIntOrFloatType(uint32_t id, SpvOp type,
                                    uint32_t width) const;
   // Returns true if |id| is a type id that contains a 8- or 16-bit int or
@@ -721,6 +824,27 @@ class ValidationState_t {
  private:
   ValidationState_t(const ValidationState_t&);
 
+  /// The bits of |contained_scalar_types_|.
+  enum ScalarTypeBits : uint8_t {
+    kInt8Bit = 1 << 0,
+    kInt16Bit = 1 << 1,
+    kInt32Bit = 1 << 2,
+    kInt64Bit = 1 << 3,
+    kFloat16Bit = 1 << 4,
+    kFloat32Bit = 1 << 5,
+    kFloat64Bit = 1 << 6,
+    kScalarTypesSummarized = 1 << 7,
+  };
+
+  /// Returns the ScalarTypeBits of the int or float |type| of |width| bits,
+  /// or 0 if it has none.
+  static uint8_t ScalarTypeBit(SpvOp type, uint32_t width);
+
+  /// Records the int and float types the type |inst| contains in
+  /// |contained_scalar_types_|.  The types it refers to must have been
+  /// registered before.
+  void SummarizeScalarTypes(const Instruction* inst);
+
   const spv_const_context context_;
 
   /// Stores the Validator command line options. Must be a valid options object.
@@ -740,6 +864,10 @@ class ValidationState_t {
   size_t total_instructions_ = 0;
   /// The total number of functions in the binary.
   size_t total_functions_ = 0;
+  /// The total number of operands of the instructions in the binary.
+  size_t total_operands_ = 0;
+  /// The largest number of blocks of a function in the binary.
+  size_t max_function_blocks_ = 0;
 
   /// IDs which have been forward declared but have not been defined
   std::unordered_set<uint32_t> unresolved_forward_ids_;
@@ -772,6 +900,14 @@ class ValidationState_t {
   /// List of all instructions in the order they appear in the binary
   std::vector<Instruction> ordered_instructions_;
 
+  /// The storage of the words of the instructions that are not in the module
+  /// being validated, and of the operands of all the instructions.  Each
+  /// chunk is allocated once and never grows, so that the instructions can
+  /// point into it.  There is a single chunk unless the module has more
+  /// instructions than were counted when the state was created.
+  std::vector<std::vector<uint32_t>> instruction_words_;
+  std::vector<std::vector<spv_parsed_operand_t>> instruction_operands_;
+
   /// Instructions that can be referenced by Ids
   std::unordered_map<uint32_t, Instruction*> all_definitions_;
 
@@ -809,13 +945,29 @@ class ValidationState_t {
       struct_has_nested_blockorbufferblock_struct_;
 
   /// Stores the list of decorations for a given <id>
-  std::map<uint32_t, std::vector<Decoration>> id_decorations_;
+  DecorationIndex id_decorations_;
+
+  /// Hashes and compares type declarations by their opcode and the words of
+  /// their operands other than the result id, so that declarations of the
+  /// same type are equal.  The words are read from the instructions, so no
+  /// key is built.
+  struct TypeDeclarationHash {
+    size_t operator()(const Instruction* inst) const;
+  };
+  struct TypeDeclarationEqual {
+    bool operator()(const Instruction* lhs, const Instruction* rhs) const;
+  };
+
+  /// For each registered type id, the ScalarTypeBits of the int and float
+  /// types of 8, 16, 32 and 64 bits the type contains, as
+  /// ContainsSizedIntOrFloatType finds them, together with
+  /// kScalarTypesSummarized.  The ids of other instructions have no bits.
+  std::vector<uint8_t> contained_scalar_types_;
 
-  /// Stores type declarations which need to be unique (i.e. non-aggregates),
-  /// in the form [opcode, operand words], result_id is not stored.
-  /// Using ordered set to avoid the need for a vector hash function.
-  /// The size of this container is expected not to exceed double-digits.
-  std::set<std::vector<uint32_t>> unique_type_declarations_;
+  /// Stores type declarations which need to be unique (i.e. non-aggregates).
+  std::unordered_set<const Instruction*, TypeDeclarationHash,
+                     TypeDeclarationEqual>
+      unique_type_declarations_;
 
   AssemblyGrammar grammar_;
 
@@ -850,6 +1002,23 @@ class ValidationState_t {
   std::unordered_map<uint32_t, std::vector<uint32_t>> function_to_entry_points_;
   const std::vector<uint32_t> empty_ids_;
 
+  /// The execution models with which a function can be called.  |mask| has
+  /// the bit execution_model_bits_[model] set for each model in |models|.
+  struct FunctionExecutionModelSet {
+    uint64_t mask = 0;
+    std::vector<SpvExecutionModel> models;
+  };
+
+  /// Mapping function -> execution models of the entry points inside this
+  /// module which can (indirectly) call the function.
+  std::unordered_map<uint32_t, FunctionExecutionModelSet>
+      function_to_execution_models_;
+  const std::vector<SpvExecutionModel> empty_execution_models_;
+
+  /// The bit of each execution model used by the entry points in
+  /// FunctionExecutionModelSet::mask.
+  std::unordered_map<uint32_t, uint32_t> execution_model_bits_;
+
   // The IDs of types of pointers to Block-decorated structs in Uniform storage
   // class. This is populated at the start of ValidateDecorations.
   std::unordered_set<uint32_t> pointer_to_uniform_block_;
@@ -867,9 +1036,14 @@ class ValidationState_t {
   // TypePass.
   std::unordered_set<uint32_t> pointer_to_storage_image_;
 
-  /// Maps ids to friendly names.
-  std::unique_ptr<spvtools::FriendlyNameMapper> friendly_mapper_;
-  spvtools::NameMapper name_mapper_;
+  /// Maps ids to friendly names.  It is built by the first call to
+  /// |getIdName|, since it parses the whole module.
+  mutable std::unique_ptr<spvtools::FriendlyNameMapper> friendly_mapper_;
+  mutable std::once_flag friendly_mapper_once_;
+
+  /// Counts a warning against the limit on the number of warnings.  Returns
+  /// false if the warning should be suppressed.
+  bool CountWarning();
 
   /// Variables used to reduce the number of diagnostic messages.
   uint32_t num_of_warnings_;
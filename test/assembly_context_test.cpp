@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -73,5 +74,42 @@ INSTANTIATE_TEST_SUITE_P(
     }));
 // clang-format on
 
+TEST(AssemblyContextNamedIds, AssignsEachNameOnce) {
+  AutoText text("%1 = OpTypeVoid\n  %foo = OpFoo");
+  AssemblyContext context(text, nullptr);
+  const uint32_t foo = context.spvNamedIdAssignOrGet("foo");
+  const uint32_t one = context.spvNamedIdAssignOrGet("1");
+  EXPECT_NE(foo, one);
+  EXPECT_EQ(foo, context.spvNamedIdAssignOrGet(std::string("foo").c_str()));
+  EXPECT_EQ(one, context.spvNamedIdAssignOrGet("1"));
+  EXPECT_EQ(3u, context.getBound());
+}
+
+TEST(AssemblyContextNamedIds, KeepsLongNames) {
+  AssemblyContext context(AutoText(""), nullptr);
+  // Names longer than the blocks that hold them, mixed with short ones.
+  std::vector<std::string> names;
+  for (int i = 0; i < 10; ++i) {
+    names.push_back(std::string(1000 * i + 1, static_cast<char>('a' + i)));
+  }
+  std::vector<uint32_t> ids;
+  for (const auto& name : names) {
+    ids.push_back(context.spvNamedIdAssignOrGet(name.c_str()));
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    const std::string copy = names[i];
+    EXPECT_EQ(ids[i], context.spvNamedIdAssignOrGet(copy.c_str()));
+  }
+  EXPECT_EQ(names.size() + 1, context.getBound());
+}
+
+TEST(AssemblyContextNamedIds, GetNumericIds) {
+  AssemblyContext context(AutoText(""), nullptr);
+  context.spvNamedIdAssignOrGet("7");
+  context.spvNamedIdAssignOrGet("foo");
+  context.spvNamedIdAssignOrGet("12");
+  EXPECT_THAT(context.GetNumericIds(), Eq(std::set<uint32_t>{7, 12}));
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -0,0 +1,626 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the core SPIR-V Tools operations over a corpus of modules.
+//
+// Usage: spirv-tools-benchmarks [--target-env=<env>] [benchmark flags]
+//            [<module.spv|module.spvasm>...]
+//
+// Each operation is measured separately on each module.  Use the usual Google
+// Benchmark flags, e.g. --benchmark_format=json or --benchmark_out=<file>, to
+// select the benchmarks and the format of the results.
+//
+// The validator is also measured on synthetic modules that grow along a single
+// dimension, e.g. the number of functions or the depth of the CFG, so that the
+// complexity reported for each stage of the validation shows the stages that
+// scale worse than linearly.
+// Building the def-use analysis is measured the same way on large synthetic
+// modules, along with the memory it uses.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "source/opt/build_module.h"
+#include "source/opt/def_use_manager.h"
+#include "source/opt/ir_context.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "tools/io.h"
+
+namespace spvtools {
+namespace {
+
+struct CorpusModule {
+  std::string name;
+  std::vector<uint32_t> binary;
+  std::string text;
+};
+
+void IgnoreMessage(spv_message_level_t, const char*, const spv_position_t&,
+                   const char*) {}
+
+// Returns the name of the file at |path| without its directory and extension.
+std::string ModuleName(const std::string& path) {
+  size_t start = path.find_last_of("/\\");
+  start = (start == std::string::npos) ? 0 : start + 1;
+  size_t end = path.find_last_of('.');
+  if (end == std::string::npos || end < start) end = path.size();
+  return path.substr(start, end - start);
+}
+
+// Reads the module at |path|, either a binary or, if the name ends in
+// ".spvasm", its assembly.  Returns false if the module cannot be read.
+bool LoadModule(const std::string& path, spv_target_env env,
+                CorpusModule* module) {
+  SpirvTools tools(env);
+  tools.SetMessageConsumer(
+      [&path](spv_message_level_t, const char*, const spv_position_t&,
+              const char* message) {
+        fprintf(stderr, "error: %s: %s\n", path.c_str(), message);
+      });
+  module->name = ModuleName(path);
+  const std::string extension = ".spvasm";
+  if (path.size() > extension.size() &&
+      path.compare(path.size() - extension.size(), extension.size(),
+                   extension) == 0) {
+    std::vector<char> contents;
+    if (!ReadFile<char>(path.c_str(), "r", &contents)) return false;
+    module->text.assign(contents.begin(), contents.end());
+    return tools.Assemble(module->text, &module->binary);
+  }
+  if (!ReadFile<uint32_t>(path.c_str(), "rb", &module->binary)) return false;
+  return tools.Disassemble(module->binary, &module->text);
+}
+
+void BM_Assemble(benchmark::State& state, const CorpusModule* module,
+                 spv_target_env env) {
+  SpirvTools tools(env);
+  for (auto _ : state) {
+    std::vector<uint32_t> binary;
+    if (!tools.Assemble(module->text, &binary)) {
+      state.SkipWithError("Assembly failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(binary.data());
+  }
+  state.SetBytesProcessed(state.iterations() * module->text.size());
+}
+
+void BM_Disassemble(benchmark::State& state, const CorpusModule* module,
+                    spv_target_env env) {
+  SpirvTools tools(env);
+  for (auto _ : state) {
+    std::string text;
+    if (!tools.Disassemble(module->binary, &text)) {
+      state.SkipWithError("Disassembly failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(text.data());
+  }
+  state.SetBytesProcessed(state.iterations() * module->binary.size() *
+                          sizeof(uint32_t));
+}
+
+void BM_BinaryParse(benchmark::State& state, const CorpusModule* module,
+                    spv_target_env env) {
+  spv_context context = spvContextCreate(env);
+  for (auto _ : state) {
+    if (spvBinaryParse(context, nullptr, module->binary.data(),
+                       module->binary.size(), nullptr, nullptr,
+                       nullptr) != SPV_SUCCESS) {
+      state.SkipWithError("Parsing failed.");
+      break;
+    }
+  }
+  spvContextDestroy(context);
+  state.SetBytesProcessed(state.iterations() * module->binary.size() *
+                          sizeof(uint32_t));
+}
+
+void BM_Validate(benchmark::State& state, const CorpusModule* module,
+                 spv_target_env env) {
+  SpirvTools tools(env);
+  for (auto _ : state) {
+    if (!tools.Validate(module->binary)) {
+      state.SkipWithError("Validation failed.");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * module->binary.size() *
+                          sizeof(uint32_t));
+}
+
+// Adds the time of the validation |stage| to the map of stage names to
+// seconds at |user_data|.
+void AddStageTime(void* user_data, const char* stage, double seconds,
+                  size_t) {
+  (*static_cast<std::map<std::string, double>*>(user_data))[stage] += seconds;
+}
+
+// Validates |binary| while |state| runs, and reports the average time of each
+// stage of the validation as a counter named after the stage.
+void ValidateStages(benchmark::State& state,
+                    const std::vector<uint32_t>& binary, spv_target_env env) {
+  SpirvTools tools(env);
+  ValidatorOptions options;
+  std::map<std::string, double> stage_seconds;
+  options.SetStageReport(AddStageTime, &stage_seconds);
+  for (auto _ : state) {
+    if (!tools.Validate(binary.data(), binary.size(), options)) {
+      state.SkipWithError("Validation failed.");
+      break;
+    }
+  }
+  for (const auto& stage : stage_seconds) {
+    state.counters[stage.first] =
+        benchmark::Counter(stage.second, benchmark::Counter::kAvgIterations);
+  }
+  state.SetBytesProcessed(state.iterations() * binary.size() *
+                          sizeof(uint32_t));
+}
+
+void BM_ValidateStages(benchmark::State& state, const CorpusModule* module,
+                       spv_target_env env) {
+  ValidateStages(state, module->binary, env);
+}
+
+void BM_BuildModule(benchmark::State& state, const CorpusModule* module,
+                    spv_target_env env) {
+  for (auto _ : state) {
+    std::unique_ptr<opt::IRContext> context =
+        BuildModule(env, IgnoreMessage, module->binary.data(),
+                    module->binary.size());
+    if (!context) {
+      state.SkipWithError("Building the module failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(context.get());
+  }
+  state.SetBytesProcessed(state.iterations() * module->binary.size() *
+                          sizeof(uint32_t));
+}
+
+// Builds the def-use analysis of |binary| while |state| runs, in instructions
+// per second.  Only the analysis is timed, not the building of the module.
+// The memory used by the analysis is reported as the "DefUseBytes" counter,
+// and per instruction as "DefUseBytesPerInstruction".
+void BuildDefUse(benchmark::State& state, const std::vector<uint32_t>& binary,
+                 spv_target_env env) {
+  int64_t num_instructions = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<opt::IRContext> context =
+        BuildModule(env, IgnoreMessage, binary.data(), binary.size());
+    if (!context) {
+      state.SkipWithError("Building the module failed.");
+      break;
+    }
+    context->module()->ForEachInst(
+        [&num_instructions](opt::Instruction*) { ++num_instructions; });
+    state.ResumeTiming();
+
+    opt::analysis::DefUseManager def_use_mgr(context->module());
+    benchmark::DoNotOptimize(&def_use_mgr);
+  }
+  state.SetItemsProcessed(num_instructions);
+
+  // The analysis is the same on every iteration, so its memory is measured
+  // once, outside of the timed loop.
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(env, IgnoreMessage, binary.data(), binary.size());
+  if (!context) return;
+  int64_t module_instructions = 0;
+  context->module()->ForEachInst(
+      [&module_instructions](opt::Instruction*) { ++module_instructions; });
+  const double bytes = static_cast<double>(
+      opt::analysis::DefUseManager(context->module()).MemoryUsage());
+  state.counters["DefUseBytes"] = bytes;
+  if (module_instructions > 0) {
+    state.counters["DefUseBytesPerInstruction"] =
+        bytes / static_cast<double>(module_instructions);
+  }
+}
+
+void BM_BuildDefUse(benchmark::State& state, const CorpusModule* module,
+                    spv_target_env env) {
+  BuildDefUse(state, module->binary, env);
+}
+
+// Measures the rate at which the instruction folder goes over the
+// instructions in the functions of |module|, in instructions per second.
+void BM_FoldInstructions(benchmark::State& state, const CorpusModule* module,
+                         spv_target_env env) {
+  int64_t num_instructions = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<opt::IRContext> context =
+        BuildModule(env, IgnoreMessage, module->binary.data(),
+                    module->binary.size());
+    if (!context) {
+      state.SkipWithError("Building the module failed.");
+      break;
+    }
+    // Build the analyses the folder uses before measuring.
+    context->get_def_use_mgr();
+    context->get_constant_mgr();
+    const opt::InstructionFolder& folder = context->get_instruction_folder();
+    state.ResumeTiming();
+
+    for (opt::Function& function : *context->module()) {
+      function.ForEachInst(
+          [&folder, &num_instructions](opt::Instruction* inst) {
+            folder.FoldInstruction(inst);
+            ++num_instructions;
+          });
+    }
+  }
+  state.SetItemsProcessed(num_instructions);
+}
+
+void BM_Optimize(benchmark::State& state, const CorpusModule* module,
+                 spv_target_env env,
+                 std::function<void(Optimizer*)> register_passes) {
+  Optimizer optimizer(env);
+  register_passes(&optimizer);
+  OptimizerOptions options;
+  options.set_run_validator(false);
+  for (auto _ : state) {
+    std::vector<uint32_t> optimized;
+    if (!optimizer.Run(module->binary.data(), module->binary.size(),
+                       &optimized, options)) {
+      state.SkipWithError("Optimization failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(optimized.data());
+  }
+  state.SetBytesProcessed(state.iterations() * module->binary.size() *
+                          sizeof(uint32_t));
+}
+
+void RegisterBenchmarks(const CorpusModule* module, spv_target_env env) {
+  using BenchmarkFunction =
+      void (*)(benchmark::State&, const CorpusModule*, spv_target_env);
+  const std::pair<const char*, BenchmarkFunction> benchmarks[] = {
+      {"Assemble", BM_Assemble},
+      {"Disassemble", BM_Disassemble},
+      {"BinaryParse", BM_BinaryParse},
+      {"Validate", BM_Validate},
+      {"ValidateStages", BM_ValidateStages},
+      {"BuildModule", BM_BuildModule},
+      {"BuildDefUse", BM_BuildDefUse},
+      {"FoldInstructions", BM_FoldInstructions},
+  };
+  for (const auto& benchmark : benchmarks) {
+    benchmark::RegisterBenchmark(
+        (std::string(benchmark.first) + "/" + module->name).c_str(),
+        benchmark.second, module, env);
+  }
+
+  const std::pair<const char*, std::function<void(Optimizer*)>> recipes[] = {
+      {"Legalization",
+       [](Optimizer* optimizer) { optimizer->RegisterLegalizationPasses(); }},
+      {"Performance",
+       [](Optimizer* optimizer) { optimizer->RegisterPerformancePasses(); }},
+      {"Size", [](Optimizer* optimizer) { optimizer->RegisterSizePasses(); }},
+      {"LocalMultiStoreElim",
+       [](Optimizer* optimizer) {
+         optimizer->RegisterPass(CreateLocalMultiStoreElimPass());
+       }},
+      {"VulkanToWebGPU",
+       [](Optimizer* optimizer) {
+         optimizer->RegisterVulkanToWebGPUPasses();
+       }},
+      {"WebGPUToVulkan",
+       [](Optimizer* optimizer) {
+         optimizer->RegisterWebGPUToVulkanPasses();
+       }},
+  };
+  for (const auto& recipe : recipes) {
+    benchmark::RegisterBenchmark(
+        (std::string("Optimize") + recipe.first + "/" + module->name).c_str(),
+        BM_Optimize, module, env, recipe.second);
+  }
+}
+
+// Returns the assembly of a module with an entry point that calls |n| other
+// functions.
+std::string ManyFunctionsModule(int n) {
+  std::ostringstream text;
+  text << R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%main = OpFunction %void None %fn
+%main_entry = OpLabel
+)";
+  for (int i = 0; i < n; ++i) {
+    text << "%call_" << i << " = OpFunctionCall %void %f_" << i << "\n";
+  }
+  text << "OpReturn\nOpFunctionEnd\n";
+  for (int i = 0; i < n; ++i) {
+    text << "%f_" << i << " = OpFunction %void None %fn\n"
+         << "%f_entry_" << i << " = OpLabel\n"
+         << "%sum_" << i << " = OpIAdd %int %int_1 %int_1\n"
+         << "OpReturn\nOpFunctionEnd\n";
+  }
+  return text.str();
+}
+
+// Returns the assembly of a module with a function made of |n| nested
+// selections.
+std::string DeepCfgModule(int n) {
+  std::ostringstream text;
+  text << R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%main = OpFunction %void None %fn
+%header_0 = OpLabel
+)";
+  for (int i = 0; i < n; ++i) {
+    if (i > 0) text << "%header_" << i << " = OpLabel\n";
+    text << "OpSelectionMerge %merge_" << i << " None\n"
+         << "OpBranchConditional %true %header_" << i + 1 << " %merge_" << i
+         << "\n";
+  }
+  text << "%header_" << n << " = OpLabel\n"
+       << "OpBranch %merge_" << n - 1 << "\n";
+  for (int i = n - 1; i > 0; --i) {
+    text << "%merge_" << i << " = OpLabel\n"
+         << "OpBranch %merge_" << i - 1 << "\n";
+  }
+  text << "%merge_0 = OpLabel\nOpReturn\nOpFunctionEnd\n";
+  return text.str();
+}
+
+// Returns the assembly of a module with |n| uniform buffers, each with its
+// own descriptor set and binding decorations.
+std::string ManyDecorationsModule(int n) {
+  std::ostringstream text;
+  text << R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpDecorate %block Block
+OpMemberDecorate %block 0 Offset 0
+OpMemberDecorate %block 1 Offset 16
+)";
+  for (int i = 0; i < n; ++i) {
+    text << "OpDecorate %buffer_" << i << " DescriptorSet " << i / 16 << "\n"
+         << "OpDecorate %buffer_" << i << " Binding " << i % 16 << "\n";
+  }
+  text << R"(%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%block = OpTypeStruct %float %v4float
+%ptr_block = OpTypePointer Uniform %block
+)";
+  for (int i = 0; i < n; ++i) {
+    text << "%buffer_" << i << " = OpVariable %ptr_block Uniform\n";
+  }
+  text << R"(%main = OpFunction %void None %fn
+%main_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  return text.str();
+}
+
+// Returns the assembly of a module with |n| fragment entry points, each
+// writing its own output.
+std::string ManyEntryPointsModule(int n) {
+  std::ostringstream text;
+  text << "OpCapability Shader\nOpMemoryModel Logical GLSL450\n";
+  for (int i = 0; i < n; ++i) {
+    text << "OpEntryPoint Fragment %main_" << i << " \"main_" << i
+         << "\" %out_" << i << "\n";
+  }
+  for (int i = 0; i < n; ++i) {
+    text << "OpExecutionMode %main_" << i << " OriginUpperLeft\n";
+  }
+  for (int i = 0; i < n; ++i) {
+    text << "OpDecorate %out_" << i << " Location 0\n";
+  }
+  text << R"(%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%ptr_out = OpTypePointer Output %float
+)";
+  for (int i = 0; i < n; ++i) {
+    text << "%out_" << i << " = OpVariable %ptr_out Output\n";
+  }
+  for (int i = 0; i < n; ++i) {
+    text << "%main_" << i << " = OpFunction %void None %fn\n"
+         << "%main_entry_" << i << " = OpLabel\n"
+         << "OpStore %out_" << i << " %float_1\n"
+         << "OpReturn\nOpFunctionEnd\n";
+  }
+  return text.str();
+}
+
+// Returns the assembly of a module with |n| integer constants and |n| float
+// constants, like the lookup tables of generated shaders.
+std::string ManyConstantsModule(int n) {
+  std::ostringstream text;
+  text << R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%float = OpTypeFloat 32
+)";
+  for (int i = 0; i < n; ++i) {
+    text << "%int_" << i << " = OpConstant %int " << (i % 2 ? -i : i) << "\n"
+         << "%uint_" << i << " = OpConstant %uint " << std::showbase
+         << std::hex << i * 2654435761u << std::dec << std::noshowbase
+         << "\n"
+         << "%float_" << i << " = OpConstant %float "
+         << static_cast<float>(i) * 0.25f << "\n";
+  }
+  text << R"(%main = OpFunction %void None %fn
+%main_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  return text.str();
+}
+
+// Assembles the module returned by |generate| for the size given by the
+// range of |state|.
+void BM_AssembleSynthetic(benchmark::State& state,
+                          std::string (*generate)(int), spv_target_env env) {
+  SpirvTools tools(env);
+  const std::string text = generate(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    std::vector<uint32_t> binary;
+    if (!tools.Assemble(text, &binary)) {
+      state.SkipWithError("Assembly failed.");
+      break;
+    }
+    benchmark::DoNotOptimize(binary.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.SetComplexityN(state.range(0));
+}
+
+// Validates the module returned by |generate| for the size given by the
+// range of |state|, reporting the time of each stage of the validation.
+void BM_ValidateSynthetic(benchmark::State& state,
+                          std::string (*generate)(int), spv_target_env env) {
+  SpirvTools tools(env);
+  tools.SetMessageConsumer(IgnoreMessage);
+  std::vector<uint32_t> binary;
+  if (!tools.Assemble(generate(static_cast<int>(state.range(0))), &binary)) {
+    state.SkipWithError("Assembly failed.");
+    return;
+  }
+  ValidateStages(state, binary, env);
+  state.SetComplexityN(state.range(0));
+}
+
+// Builds the def-use analysis of the module returned by |generate| for the
+// size given by the range of |state|.
+void BM_BuildDefUseSynthetic(benchmark::State& state,
+                             std::string (*generate)(int),
+                             spv_target_env env) {
+  SpirvTools tools(env);
+  std::vector<uint32_t> binary;
+  if (!tools.Assemble(generate(static_cast<int>(state.range(0))), &binary)) {
+    state.SkipWithError("Assembly failed.");
+    return;
+  }
+  BuildDefUse(state, binary, env);
+  state.SetComplexityN(state.range(0));
+}
+
+void RegisterSyntheticBenchmarks(spv_target_env env) {
+  struct SyntheticModule {
+    const char* name;
+    std::string (*generate)(int);
+    int max_size;
+  };
+  // The depth of the CFG stays below the default limit of the validator on
+  // the nesting of the control flow.
+  const SyntheticModule modules[] = {
+      {"ManyFunctions", ManyFunctionsModule, 4096},
+      {"DeepCfg", DeepCfgModule, 1000},
+      {"ManyDecorations", ManyDecorationsModule, 4096},
+      {"ManyEntryPoints", ManyEntryPointsModule, 4096},
+  };
+  for (const auto& module : modules) {
+    benchmark::RegisterBenchmark(
+        (std::string("ValidateSynthetic/") + module.name).c_str(),
+        BM_ValidateSynthetic, module.generate, env)
+        ->RangeMultiplier(4)
+        ->Range(16, module.max_size)
+        ->Complexity();
+  }
+  benchmark::RegisterBenchmark("AssembleSynthetic/ManyConstants",
+                               BM_AssembleSynthetic, ManyConstantsModule, env)
+      ->RangeMultiplier(4)
+      ->Range(16, 16384)
+      ->Complexity();
+
+  // Modules large enough that the def-use analysis dominates, with many
+  // definitions and many uses of few ids, respectively.
+  const std::pair<const char*, std::string (*)(int)> def_use_modules[] = {
+      {"ManyConstants", ManyConstantsModule},
+      {"ManyFunctions", ManyFunctionsModule},
+  };
+  for (const auto& module : def_use_modules) {
+    benchmark::RegisterBenchmark(
+        (std::string("BuildDefUseSynthetic/") + module.first).c_str(),
+        BM_BuildDefUseSynthetic, module.second, env)
+        ->RangeMultiplier(4)
+        ->Range(16, 65536)
+        ->Complexity();
+  }
+}
+
+}  // namespace
+}  // namespace spvtools
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+
+  spv_target_env env = SPV_ENV_UNIVERSAL_1_5;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (0 == strncmp(arg, "--target-env=", 13)) {
+      if (!spvParseTargetEnv(arg + 13, &env)) {
+        fprintf(stderr, "error: Unrecognized target env: %s\n", arg + 13);
+        return 1;
+      }
+    } else if (arg[0] == '-') {
+      fprintf(stderr, "error: Unrecognized option: %s\n", arg);
+      return 1;
+    } else {
+      paths.push_back(arg);
+    }
+  }
+
+  // The benchmarks keep pointers to the modules, so they must not move.
+  std::vector<std::unique_ptr<spvtools::CorpusModule>> corpus;
+  for (const std::string& path : paths) {
+    corpus.emplace_back(new spvtools::CorpusModule());
+    if (!spvtools::LoadModule(path, env, corpus.back().get())) return 1;
+    spvtools::RegisterBenchmarks(corpus.back().get(), env);
+  }
+  spvtools::RegisterSyntheticBenchmarks(env);
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
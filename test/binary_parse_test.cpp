@@ -771,6 +771,13 @@ INSTANTIATE_TEST_SUITE_P(
              {spvOpcodeMake(2, SpvOpTypeBool), 1},
          }),
          "Id 1 is defined more than once"},
+        // Like the previous case, but with an Id that is outside of the bound.
+        {Concatenate({
+             ExpectedHeaderForBound(2),
+             {spvOpcodeMake(2, SpvOpTypeVoid), 100},
+             {spvOpcodeMake(2, SpvOpTypeBool), 100},
+         }),
+         "Id 100 is defined more than once"},
         {Concatenate({ExpectedHeaderForBound(3),
                       MakeInstruction(SpvOpExtInst, {2, 3, 100, 4, 5})}),
          "OpExtInst set Id 100 does not reference an OpExtInstImport result "
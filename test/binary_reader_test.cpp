@@ -0,0 +1,202 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "source/latest_version_spirv_header.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace {
+
+using ::testing::HasSubstr;
+
+const spv_target_env kEnv = SPV_ENV_UNIVERSAL_1_3;
+
+const char kModule[] = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpDecorate %int RelaxedPrecision
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+%int_0 = OpConstant %int 0
+%other = OpFunction %void None %fn
+%label = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+std::vector<uint32_t> Assemble(const std::string& text) {
+  std::vector<uint32_t> binary;
+  SpirvTools tools(kEnv);
+  EXPECT_TRUE(tools.Assemble(text, &binary,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS));
+  return binary;
+}
+
+std::vector<SpvOp> ReadOpcodes(BinaryReader* reader) {
+  std::vector<SpvOp> opcodes;
+  for (const spv_parsed_instruction_t& inst : *reader)
+    opcodes.push_back(static_cast<SpvOp>(inst.opcode));
+  return opcodes;
+}
+
+TEST(BinaryReader, ReadsHeader) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  ASSERT_TRUE(reader.ReadHeader());
+  EXPECT_EQ(binary[1], reader.version());
+  EXPECT_EQ(binary[2], reader.generator());
+  EXPECT_EQ(binary[3], reader.id_bound());
+  EXPECT_EQ(0u, reader.schema());
+  EXPECT_EQ(5u, reader.position());
+}
+
+TEST(BinaryReader, IteratesOverAllInstructions) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  EXPECT_EQ(std::vector<SpvOp>({SpvOpCapability, SpvOpMemoryModel,
+                                SpvOpEntryPoint, SpvOpDecorate, SpvOpTypeVoid,
+                                SpvOpTypeInt, SpvOpTypeFunction, SpvOpFunction,
+                                SpvOpLabel, SpvOpReturn, SpvOpFunctionEnd,
+                                SpvOpConstant, SpvOpFunction, SpvOpLabel,
+                                SpvOpReturn, SpvOpFunctionEnd}),
+            ReadOpcodes(&reader));
+  EXPECT_EQ(SPV_SUCCESS, reader.status());
+  EXPECT_EQ(binary.size(), reader.position());
+  EXPECT_FALSE(reader.Next());
+}
+
+TEST(BinaryReader, DecodesOperands) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  while (reader.Next() && reader.instruction().opcode != SpvOpTypeInt) {
+  }
+  const spv_parsed_instruction_t& inst = reader.instruction();
+  ASSERT_EQ(SpvOpTypeInt, inst.opcode);
+  EXPECT_EQ(binary[reader.instruction_offset() + 1], inst.result_id);
+  ASSERT_EQ(3u, inst.num_operands);
+  EXPECT_EQ(SPV_OPERAND_TYPE_RESULT_ID, inst.operands[0].type);
+  EXPECT_EQ(32u, inst.words[inst.operands[1].offset]);
+  EXPECT_EQ(&binary[reader.instruction_offset()], inst.words);
+}
+
+TEST(BinaryReader, StopsAtFirstFunction) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  uint32_t decorations = 0;
+  for (const spv_parsed_instruction_t& inst : reader) {
+    if (inst.opcode == SpvOpFunction) break;
+    if (inst.opcode == SpvOpDecorate) ++decorations;
+  }
+  EXPECT_EQ(1u, decorations);
+  EXPECT_EQ(SPV_SUCCESS, reader.status());
+  EXPECT_EQ(SpvOpFunction, reader.instruction().opcode);
+}
+
+TEST(BinaryReader, SkipsFunctions) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  std::vector<SpvOp> opcodes;
+  while (reader.Next()) {
+    opcodes.push_back(static_cast<SpvOp>(reader.instruction().opcode));
+    if (reader.instruction().opcode == SpvOpFunction)
+      EXPECT_TRUE(reader.SkipFunction());
+  }
+  EXPECT_EQ(SPV_SUCCESS, reader.status());
+  EXPECT_EQ(std::vector<SpvOp>({SpvOpCapability, SpvOpMemoryModel,
+                                SpvOpEntryPoint, SpvOpDecorate, SpvOpTypeVoid,
+                                SpvOpTypeInt, SpvOpTypeFunction, SpvOpFunction,
+                                SpvOpConstant, SpvOpFunction}),
+            opcodes);
+}
+
+TEST(BinaryReader, SkipFunctionWithoutFunctionEnd) {
+  const std::vector<uint32_t> binary = Assemble(R"(
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpReturn
+)");
+  BinaryReader reader(kEnv, binary);
+  std::string error;
+  reader.SetMessageConsumer([&error](spv_message_level_t, const char*,
+                                     const spv_position_t&,
+                                     const char* message) { error = message; });
+  EXPECT_FALSE(reader.SkipFunction());
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, reader.status());
+  EXPECT_THAT(error, HasSubstr("missing OpFunctionEnd"));
+  EXPECT_FALSE(reader.Next());
+}
+
+TEST(BinaryReader, SeeksToInstruction) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  std::vector<size_t> offsets;
+  while (reader.Next()) offsets.push_back(reader.instruction_offset());
+  ASSERT_EQ(16u, offsets.size());
+
+  // Seek back to the OpTypeVoid, and read it again.
+  ASSERT_TRUE(reader.Seek(offsets[4]));
+  ASSERT_TRUE(reader.Next());
+  EXPECT_EQ(SpvOpTypeVoid, reader.instruction().opcode);
+  EXPECT_EQ(offsets[5], reader.position());
+
+  // Seek to the end.
+  ASSERT_TRUE(reader.Seek(binary.size()));
+  EXPECT_FALSE(reader.Next());
+  EXPECT_EQ(SPV_SUCCESS, reader.status());
+}
+
+TEST(BinaryReader, SeekOutOfRange) {
+  const std::vector<uint32_t> binary = Assemble(kModule);
+  BinaryReader reader(kEnv, binary);
+  std::string error;
+  reader.SetMessageConsumer([&error](spv_message_level_t, const char*,
+                                     const spv_position_t&,
+                                     const char* message) { error = message; });
+  EXPECT_FALSE(reader.Seek(binary.size() + 1));
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, reader.status());
+  EXPECT_THAT(error, HasSubstr("Invalid word offset"));
+}
+
+TEST(BinaryReader, InvalidHeader) {
+  const std::vector<uint32_t> binary = {0x12345678, 0, 0};
+  BinaryReader reader(kEnv, binary);
+  EXPECT_FALSE(reader.ReadHeader());
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, reader.status());
+  EXPECT_TRUE(reader.begin() == reader.end());
+}
+
+TEST(BinaryReader, InvalidInstruction) {
+  std::vector<uint32_t> binary = Assemble(kModule);
+  // Make the OpCapability claim to be longer than the whole module.
+  binary[5] = (0xffffu << 16) | SpvOpCapability;
+  BinaryReader reader(kEnv, binary);
+  EXPECT_TRUE(reader.ReadHeader());
+  EXPECT_FALSE(reader.Next());
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, reader.status());
+}
+
+}  // namespace
+}  // namespace spvtools
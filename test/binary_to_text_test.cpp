@@ -19,6 +19,7 @@
 
 #include "gmock/gmock.h"
 #include "source/spirv_constant.h"
+#include "spirv-tools/libspirv.hpp"
 #include "test/test_fixture.h"
 #include "test/unit_spirv.h"
 
@@ -555,6 +556,124 @@ INSTANTIATE_TEST_SUITE_P(GeneratorStrings, GeneratorStringTest,
                              {65535, 32767, "Unknown(65535); 32767"},
                          }));
 
+// Disassembles |binary| with the given |options| on |num_threads| threads.
+std::string DisassembleParallel(const std::vector<uint32_t>& binary,
+                                uint32_t options, uint32_t num_threads) {
+  ScopedContext context(SPV_ENV_UNIVERSAL_1_3);
+  spv_text text = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_SUCCESS,
+            spvBinaryToTextParallel(context.context, binary.data(),
+                                    binary.size(), options, num_threads, &text,
+                                    &diagnostic));
+  EXPECT_EQ(nullptr, diagnostic);
+  std::string result = text ? std::string(text->str, text->length) : "";
+  spvTextDestroy(text);
+  spvDiagnosticDestroy(diagnostic);
+  return result;
+}
+
+using BinaryToTextParallelTest = ::testing::TestWithParam<uint32_t>;
+
+TEST_P(BinaryToTextParallelTest, SameTextAsSerial) {
+  const std::string input = R"(OpCapability Shader
+%ext = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpName %main "main"
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%int_0 = OpConstant %int 0
+%fn = OpTypeFunction %void
+%fn_float = OpTypeFunction %float %float
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpSelectionMerge %merge None
+OpSwitch %int_0 %merge 1 %case 2 %case
+%case = OpLabel
+%call = OpFunctionCall %float %abs %float_1
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+%abs = OpFunction %float None %fn_float
+%x = OpFunctionParameter %float
+%abs_entry = OpLabel
+%result = OpExtInst %float %ext FAbs %x
+OpReturnValue %result
+OpFunctionEnd
+%empty = OpFunction %void None %fn
+%empty_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  ASSERT_TRUE(tools.Assemble(input, &binary));
+
+  const uint32_t options = GetParam();
+  const std::string serial = DisassembleParallel(binary, options, 1);
+  ASSERT_FALSE(serial.empty());
+  for (uint32_t num_threads : {2u, 3u, 8u}) {
+    EXPECT_EQ(serial, DisassembleParallel(binary, options, num_threads))
+        << num_threads << " threads";
+  }
+
+  std::string text;
+  EXPECT_TRUE(tools.Disassemble(binary.data(), binary.size(), &text, options,
+                                /* num_threads = */ 4));
+  EXPECT_EQ(serial, text);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Options, BinaryToTextParallelTest,
+    ::testing::ValuesIn(std::vector<uint32_t>{
+        SPV_BINARY_TO_TEXT_OPTION_NONE, SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES,
+        SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+            SPV_BINARY_TO_TEXT_OPTION_INDENT |
+            SPV_BINARY_TO_TEXT_OPTION_SHOW_BYTE_OFFSET,
+        SPV_BINARY_TO_TEXT_OPTION_NO_HEADER | SPV_BINARY_TO_TEXT_OPTION_COLOR,
+        SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES |
+            SPV_BINARY_TO_TEXT_OPTION_COMMENT}));
+
+TEST(BinaryToTextParallel, NoFunctions) {
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  ASSERT_TRUE(tools.Assemble("OpCapability Shader\n", &binary));
+  EXPECT_EQ(DisassembleParallel(binary, SPV_BINARY_TO_TEXT_OPTION_NONE, 1),
+            DisassembleParallel(binary, SPV_BINARY_TO_TEXT_OPTION_NONE, 4));
+}
+
+TEST(BinaryToTextParallel, ReportsErrorsLikeSerial) {
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  ASSERT_TRUE(tools.Assemble(R"(%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+)",
+                             &binary));
+  // Truncate the OpFunctionEnd of the function.
+  binary.back() = (2u << 16) | SpvOpFunctionEnd;
+
+  ScopedContext context(SPV_ENV_UNIVERSAL_1_3);
+  spv_text text = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY,
+            spvBinaryToTextParallel(context.context, binary.data(),
+                                    binary.size(),
+                                    SPV_BINARY_TO_TEXT_OPTION_NONE, 4, &text,
+                                    &diagnostic));
+  ASSERT_NE(nullptr, diagnostic);
+  EXPECT_THAT(diagnostic->error, HasSubstr("OpFunctionEnd"));
+  spvTextDestroy(text);
+  spvDiagnosticDestroy(diagnostic);
+}
+
 // TODO(dneto): Test new instructions and enums in SPIR-V 1.3
 
 }  // namespace
@@ -295,5 +295,49 @@ TEST(CInterface, SpecifyConsumerSpecifyDiagnosticForValidating) {
   spvContextDestroy(context);
 }
 
+// Counts the allocations that are not released yet.
+struct CountingAllocator {
+  static void* Allocate(void* user_data, size_t size) {
+    ++static_cast<CountingAllocator*>(user_data)->live;
+    return ::operator new(size);
+  }
+  static void Deallocate(void* user_data, void* memory) {
+    --static_cast<CountingAllocator*>(user_data)->live;
+    ::operator delete(memory);
+  }
+
+  int live = 0;
+};
+
+TEST(CInterface, OutputsUseTheAllocatorOfTheContext) {
+  CountingAllocator counter;
+  const spv_allocator_t allocator = {&CountingAllocator::Allocate,
+                                     &CountingAllocator::Deallocate, &counter};
+  auto context = spvContextCreate(SPV_ENV_UNIVERSAL_1_1);
+  spvContextSetAllocator(context, &allocator);
+  const char input_text[] = "OpNop";
+
+  spv_binary binary = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvTextToBinary(context, input_text,
+                                         sizeof(input_text), &binary, nullptr));
+  EXPECT_EQ(2, counter.live);
+
+  spv_text text = nullptr;
+  ASSERT_EQ(SPV_SUCCESS, spvBinaryToText(context, binary->code,
+                                         binary->wordCount, 0, &text, nullptr));
+  EXPECT_EQ(4, counter.live);
+
+  spv_diagnostic diagnostic = nullptr;
+  spv_const_binary_t b{binary->code, binary->wordCount};
+  EXPECT_EQ(SPV_ERROR_INVALID_LAYOUT, spvValidate(context, &b, &diagnostic));
+  EXPECT_EQ(6, counter.live);
+
+  spvDiagnosticDestroyWithContext(context, diagnostic);
+  spvTextDestroyWithContext(context, text);
+  spvBinaryDestroyWithContext(context, binary);
+  EXPECT_EQ(0, counter.live);
+  spvContextDestroy(context);
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -0,0 +1,396 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/cfa.h"
+
+namespace spvtools {
+namespace {
+
+// A minimal basic block for exercising CFA.
+class Block {
+ public:
+  explicit Block(uint32_t id) : id_(id) {}
+
+  uint32_t id() const { return id_; }
+  const std::vector<Block*>* successors() const { return &successors_; }
+  const std::vector<Block*>* predecessors() const { return &predecessors_; }
+
+  void AddSuccessor(Block* block) {
+    successors_.push_back(block);
+    block->predecessors_.push_back(this);
+  }
+
+  void RemoveSuccessor(Block* block) {
+    successors_.erase(
+        std::find(successors_.begin(), successors_.end(), block));
+    block->predecessors_.erase(std::find(block->predecessors_.begin(),
+                                         block->predecessors_.end(), this));
+  }
+
+ private:
+  uint32_t id_;
+  std::vector<Block*> successors_;
+  std::vector<Block*> predecessors_;
+};
+
+// A graph of |num_blocks| blocks where block 0 is the entry.
+class Graph {
+ public:
+  explicit Graph(uint32_t num_blocks) {
+    for (uint32_t i = 0; i < num_blocks; ++i) blocks_.emplace_back(i);
+  }
+
+  void AddEdge(uint32_t from, uint32_t to) {
+    blocks_[from].AddSuccessor(&blocks_[to]);
+  }
+
+  void RemoveEdge(uint32_t from, uint32_t to) {
+    blocks_[from].RemoveSuccessor(&blocks_[to]);
+  }
+
+  Block* block(uint32_t id) { return &blocks_[id]; }
+
+  // Returns the blocks reachable from the entry, in postorder.
+  std::vector<const Block*> Postorder() {
+    std::vector<const Block*> postorder;
+    CFA<Block>::DepthFirstTraversal(
+        block(0), [](const Block* b) { return b->successors(); },
+        [](const Block*) {},
+        [&postorder](const Block* b) { postorder.push_back(b); },
+        [](const Block*, const Block*) {});
+    return postorder;
+  }
+
+  // Returns the immediate dominator id of each reachable block, computed by
+  // CFA<Block>::CalculateDominators.
+  std::vector<std::pair<uint32_t, uint32_t>> Dominators() {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    for (const auto& edge : CFA<Block>::CalculateDominators(
+             Postorder(), [](const Block* b) { return b->predecessors(); })) {
+      result.push_back({edge.first->id(), edge.second->id()});
+    }
+    return result;
+  }
+
+  // Returns the same as Dominators(), computed from the definition of
+  // dominance by iterating to a fixed point over sets of dominators.
+  std::vector<std::pair<uint32_t, uint32_t>> ReferenceDominators() {
+    const auto postorder = Postorder();
+    std::set<uint32_t> all;
+    for (const Block* b : postorder) all.insert(b->id());
+    std::vector<std::set<uint32_t>> doms(blocks_.size(), all);
+    doms[0] = {0};
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (auto it = postorder.rbegin() + 1; it != postorder.rend(); ++it) {
+        std::set<uint32_t> next = all;
+        for (const Block* pred : *(*it)->predecessors()) {
+          if (!all.count(pred->id())) continue;
+          std::set<uint32_t> meet;
+          for (uint32_t d : doms[pred->id()]) {
+            if (next.count(d)) meet.insert(d);
+          }
+          next.swap(meet);
+        }
+        next.insert((*it)->id());
+        if (next != doms[(*it)->id()]) {
+          doms[(*it)->id()].swap(next);
+          changed = true;
+        }
+      }
+    }
+    // The immediate dominator is the strict dominator with the most
+    // dominators of its own.
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    for (const Block* b : postorder) {
+      uint32_t idom = b->id();
+      for (uint32_t d : doms[b->id()]) {
+        if (d == b->id()) continue;
+        if (idom == b->id() || doms[d].size() > doms[idom].size()) idom = d;
+      }
+      result.push_back({b->id(), idom});
+    }
+    return result;
+  }
+
+ private:
+  std::vector<Block> blocks_;
+};
+
+// A dominator tree of a Graph, kept up to date with the incremental updates
+// of CFA<Block>.
+class DominatorTree {
+ public:
+  explicit DominatorTree(Graph* graph) : graph_(graph) { Recompute(); }
+
+  // Recomputes the tree from scratch.
+  void Recompute() {
+    idom_.clear();
+    for (const auto& edge : graph_->Dominators()) {
+      idom_[edge.first] =
+          edge.first == 0 ? nullptr : graph_->block(edge.second);
+    }
+    ComputeDepths();
+  }
+
+  bool Contains(uint32_t id) const { return idom_.count(id) != 0; }
+
+  // Adds the edge |from| -> |to| to the graph and updates the tree.
+  void InsertEdge(uint32_t from, uint32_t to) {
+    graph_->AddEdge(from, to);
+    if (!Contains(from)) return;
+    if (!Contains(to)) return Recompute();
+    Apply(CFA<Block>::DominatorsAfterEdgeInsertion(
+        graph_->block(from), graph_->block(to), Successors(), Dominator(),
+        Depth()));
+  }
+
+  // Removes the edge |from| -> |to| from the graph and updates the tree.
+  void DeleteEdge(uint32_t from, uint32_t to) {
+    graph_->RemoveEdge(from, to);
+    if (!Contains(from)) return;
+    std::vector<std::pair<Block*, Block*>> changes;
+    if (!CFA<Block>::DominatorsAfterEdgeDeletion(
+            graph_->block(from), graph_->block(to), Successors(),
+            [](const Block* b) { return b->predecessors(); }, Dominator(),
+            Depth(), &changes)) {
+      return Recompute();
+    }
+    Apply(changes);
+  }
+
+  // Returns the immediate dominator of each block in the tree, in the format
+  // of Graph::Dominators().
+  std::vector<std::pair<uint32_t, uint32_t>> Dominators() const {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    for (const Block* b : graph_->Postorder()) {
+      const Block* idom = idom_.at(b->id());
+      result.push_back({b->id(), idom ? idom->id() : b->id()});
+    }
+    return result;
+  }
+
+ private:
+  static std::function<const std::vector<Block*>*(const Block*)> Successors() {
+    return [](const Block* b) { return b->successors(); };
+  }
+
+  std::function<Block*(const Block*)> Dominator() const {
+    return [this](const Block* b) {
+      const auto it = idom_.find(b->id());
+      return it == idom_.end() ? nullptr : it->second;
+    };
+  }
+
+  std::function<size_t(const Block*)> Depth() const {
+    return [this](const Block* b) { return depth_.at(b->id()); };
+  }
+
+  void Apply(const std::vector<std::pair<Block*, Block*>>& changes) {
+    for (const auto& change : changes) {
+      idom_[change.first->id()] = change.second;
+    }
+    ComputeDepths();
+  }
+
+  void ComputeDepths() {
+    depth_.clear();
+    for (const auto& entry : idom_) {
+      size_t depth = 0;
+      for (const Block* b = entry.second; b; b = idom_.at(b->id())) ++depth;
+      depth_[entry.first] = depth;
+    }
+  }
+
+  Graph* graph_;
+  std::map<uint32_t, Block*> idom_;
+  std::map<uint32_t, size_t> depth_;
+};
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+TEST(CFATest, DominatorsOfDiamond) {
+  Graph g(4);
+  g.AddEdge(0, 1);
+  g.AddEdge(0, 2);
+  g.AddEdge(1, 3);
+  g.AddEdge(2, 3);
+
+  EXPECT_THAT(g.Dominators(),
+              ElementsAre(Pair(3, 0), Pair(1, 0), Pair(2, 0), Pair(0, 0)));
+}
+
+TEST(CFATest, DominatorsOfLoop) {
+  // 0 -> 1 (header) -> 2 (body) -> 3 (continue) -> 1, and 1 -> 4 (merge).
+  Graph g(5);
+  g.AddEdge(0, 1);
+  g.AddEdge(1, 2);
+  g.AddEdge(1, 4);
+  g.AddEdge(2, 3);
+  g.AddEdge(3, 1);
+
+  EXPECT_THAT(g.Dominators(), ElementsAre(Pair(3, 2), Pair(2, 1), Pair(4, 1),
+                                          Pair(1, 0), Pair(0, 0)));
+}
+
+TEST(CFATest, DominatorsIgnoreUnreachablePredecessors) {
+  Graph g(3);
+  g.AddEdge(0, 1);
+  g.AddEdge(2, 1);
+
+  EXPECT_THAT(g.Dominators(), ElementsAre(Pair(1, 0), Pair(0, 0)));
+}
+
+TEST(CFATest, DominatorsOfDeepChain) {
+  // A long chain must not exhaust the stack.
+  const uint32_t num_blocks = 20000;
+  Graph g(num_blocks);
+  for (uint32_t i = 1; i < num_blocks; ++i) g.AddEdge(i - 1, i);
+
+  const auto dominators = g.Dominators();
+  ASSERT_EQ(dominators.size(), num_blocks);
+  for (uint32_t i = 0; i + 1 < num_blocks; ++i) {
+    EXPECT_EQ(dominators[i].first, num_blocks - 1 - i);
+    EXPECT_EQ(dominators[i].second, num_blocks - 2 - i);
+  }
+  EXPECT_THAT(dominators.back(), Pair(0, 0));
+}
+
+TEST(CFATest, DominatorsMatchReferenceOnRandomGraphs) {
+  std::mt19937 rng(42);
+  for (uint32_t trial = 0; trial < 200; ++trial) {
+    const uint32_t num_blocks = 2 + rng() % 30;
+    const uint32_t num_edges = rng() % (3 * num_blocks);
+    Graph g(num_blocks);
+    for (uint32_t i = 0; i < num_edges; ++i) {
+      g.AddEdge(rng() % num_blocks, 1 + rng() % (num_blocks - 1));
+    }
+    EXPECT_EQ(g.Dominators(), g.ReferenceDominators()) << "trial " << trial;
+  }
+}
+
+TEST(CFATest, DensePostorderMatchesDepthFirstTraversal) {
+  std::mt19937 rng(3);
+  for (uint32_t trial = 0; trial < 100; ++trial) {
+    const uint32_t num_blocks = 2 + rng() % 30;
+    Graph g(num_blocks);
+    std::vector<std::vector<size_t>> succs(num_blocks);
+    for (uint32_t i = 0; i < 2 * num_blocks; ++i) {
+      const uint32_t from = rng() % num_blocks;
+      const uint32_t to = 1 + rng() % (num_blocks - 1);
+      g.AddEdge(from, to);
+      succs[from].push_back(to);
+    }
+    std::vector<size_t> expected;
+    for (const Block* b : g.Postorder()) expected.push_back(b->id());
+    EXPECT_EQ(CFA<Block>::Postorder(
+                  num_blocks, 0,
+                  [&succs](size_t i) -> const std::vector<size_t>& {
+                    return succs[i];
+                  }),
+              expected)
+        << "trial " << trial;
+  }
+}
+
+TEST(CFATest, EdgeInsertionUpdatesAffectedDominators) {
+  // 0 -> 1 -> 2 -> 3 -> 4, then 0 -> 3 makes 0 the dominator of 3 and 4.
+  Graph g(5);
+  for (uint32_t i = 1; i < 5; ++i) g.AddEdge(i - 1, i);
+  DominatorTree tree(&g);
+
+  tree.InsertEdge(0, 3);
+  EXPECT_THAT(tree.Dominators(),
+              ElementsAre(Pair(4, 3), Pair(3, 0), Pair(2, 1), Pair(1, 0),
+                          Pair(0, 0)));
+  EXPECT_EQ(tree.Dominators(), g.Dominators());
+}
+
+TEST(CFATest, EdgeDeletionRecomputesSubtree) {
+  // 0 -> 1 -> 3, 0 -> 2 -> 3 and 3 -> 4; removing 2 -> 3 leaves 1 as the
+  // only way to 3.
+  Graph g(5);
+  g.AddEdge(0, 1);
+  g.AddEdge(0, 2);
+  g.AddEdge(1, 3);
+  g.AddEdge(2, 3);
+  g.AddEdge(3, 4);
+  DominatorTree tree(&g);
+
+  tree.DeleteEdge(2, 3);
+  EXPECT_EQ(tree.Dominators(), g.Dominators());
+  EXPECT_THAT(tree.Dominators(), ::testing::Contains(Pair(3, 1)));
+}
+
+TEST(CFATest, IncrementalDominatorsMatchRecomputationOnRandomEdits) {
+  std::mt19937 rng(7);
+  for (uint32_t trial = 0; trial < 100; ++trial) {
+    const uint32_t num_blocks = 2 + rng() % 20;
+    Graph g(num_blocks);
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t i = 0; i < 2 * num_blocks; ++i) {
+      edges.push_back({rng() % num_blocks, 1 + rng() % (num_blocks - 1)});
+      g.AddEdge(edges.back().first, edges.back().second);
+    }
+    DominatorTree tree(&g);
+    for (uint32_t edit = 0; edit < 50; ++edit) {
+      if (edges.empty() || rng() % 2) {
+        edges.push_back({rng() % num_blocks, 1 + rng() % (num_blocks - 1)});
+        tree.InsertEdge(edges.back().first, edges.back().second);
+      } else {
+        const size_t index = rng() % edges.size();
+        const auto edge = edges[index];
+        edges.erase(edges.begin() + index);
+        tree.DeleteEdge(edge.first, edge.second);
+      }
+      ASSERT_EQ(tree.Dominators(), g.Dominators())
+          << "trial " << trial << " edit " << edit;
+    }
+  }
+}
+
+TEST(CFATest, DepthFirstTraversalFindsBackEdges) {
+  Graph g(4);
+  g.AddEdge(0, 1);
+  g.AddEdge(1, 2);
+  g.AddEdge(2, 1);
+  g.AddEdge(2, 3);
+  g.AddEdge(0, 3);
+  g.AddEdge(3, 3);
+
+  std::vector<std::pair<uint32_t, uint32_t>> back_edges;
+  CFA<Block>::DepthFirstTraversal(
+      g.block(0), [](const Block* b) { return b->successors(); },
+      [](const Block*) {}, [](const Block*) {},
+      [&back_edges](const Block* from, const Block* to) {
+        back_edges.push_back({from->id(), to->id()});
+      });
+
+  EXPECT_THAT(back_edges, ElementsAre(Pair(2, 1), Pair(3, 3)));
+}
+
+}  // namespace
+}  // namespace spvtools
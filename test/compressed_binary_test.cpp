@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "spirv-tools/libspirv.hpp"
+#include "test/unit_spirv.h"
+
+namespace spvtools {
+namespace {
+
+using ::testing::HasSubstr;
+
+const char kModule[] = R"(
+OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpDecorate %in Location 0
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%int_n1 = OpConstant %int -1
+%int_7 = OpConstant %int 7
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%x = OpLoad %int %in
+OpSelectionMerge %merge None
+OpSwitch %x %merge 7 %case -1 %case
+%case = OpLabel
+%abs = OpExtInst %int %1 SAbs %x
+OpBranch %merge
+%merge = OpLabel
+%phi = OpPhi %int %int_n1 %entry %abs %case
+OpStore %out %phi
+OpReturn
+OpFunctionEnd
+)";
+
+class CompressedBinaryTest : public ::testing::Test {
+ public:
+  CompressedBinaryTest() : tools_(SPV_ENV_UNIVERSAL_1_0) {
+    tools_.SetMessageConsumer(
+        [this](spv_message_level_t, const char*, const spv_position_t&,
+               const char* message) { messages_ += message; });
+  }
+
+ protected:
+  SpirvTools tools_;
+  std::string messages_;
+};
+
+TEST_F(CompressedBinaryTest, RoundTripsModule) {
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools_.Assemble(kModule, &binary));
+
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(tools_.Compress(binary, &compressed)) << messages_;
+  EXPECT_LT(compressed.size() * 2, binary.size() * sizeof(uint32_t));
+
+  std::vector<uint32_t> decompressed;
+  ASSERT_TRUE(tools_.Decompress(compressed, &decompressed)) << messages_;
+  EXPECT_EQ(binary, decompressed);
+}
+
+TEST_F(CompressedBinaryTest, RoundTripsWordsTheGrammarDoesNotDescribe) {
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools_.Assemble(kModule, &binary));
+  // An unknown opcode, and an OpName whose string is not terminated.
+  binary.insert(binary.end(), {4u << 16 | 0xfff0, 0xffffffff, 0, 0x80000000});
+  binary.insert(binary.end(), {3u << 16 | SpvOpName, 1, 0x61616161});
+
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(tools_.Compress(binary, &compressed)) << messages_;
+  std::vector<uint32_t> decompressed;
+  ASSERT_TRUE(tools_.Decompress(compressed, &decompressed)) << messages_;
+  EXPECT_EQ(binary, decompressed);
+}
+
+TEST_F(CompressedBinaryTest, RejectsInvalidModule) {
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools_.Assemble(kModule, &binary));
+  binary.push_back(2u << 16 | SpvOpNop);
+
+  std::vector<uint8_t> compressed;
+  EXPECT_FALSE(tools_.Compress(binary, &compressed));
+  EXPECT_THAT(messages_, HasSubstr("Invalid word count 2"));
+  EXPECT_TRUE(compressed.empty());
+}
+
+TEST_F(CompressedBinaryTest, RejectsCorruptData) {
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools_.Assemble(kModule, &binary));
+  std::vector<uint8_t> compressed;
+  ASSERT_TRUE(tools_.Compress(binary, &compressed)) << messages_;
+
+  std::vector<uint32_t> decompressed;
+  std::vector<uint8_t> truncated(compressed.begin(), compressed.end() - 1);
+  EXPECT_FALSE(tools_.Decompress(truncated, &decompressed));
+  EXPECT_THAT(messages_, HasSubstr("does not have the"));
+
+  messages_.clear();
+  std::vector<uint8_t> not_compressed(binary.size() * sizeof(uint32_t));
+  EXPECT_FALSE(tools_.Decompress(not_compressed, &decompressed));
+  EXPECT_THAT(messages_, HasSubstr("Not a compressed SPIR-V module."));
+  EXPECT_TRUE(decompressed.empty());
+}
+
+}  // namespace
+}  // namespace spvtools
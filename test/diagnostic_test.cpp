@@ -146,5 +146,24 @@ TEST(DiagnosticStream, DiagnosticFromLambdaReturnCanStillBeUsed) {
   EXPECT_THAT(messages.str(), Eq("FirstSecond"));
 }
 
+// Counts how many times it is written to a stream.
+struct CountedWrite {
+  int* count;
+};
+
+std::ostream& operator<<(std::ostream& out, const CountedWrite& value) {
+  ++*value.count;
+  return out;
+}
+
+TEST(DiagnosticStream, DoesNotFormatWithoutConsumer) {
+  int num_writes = 0;
+  spv_result_t value =
+      DiagnosticStream({}, nullptr, "", SPV_ERROR_INVALID_BINARY)
+      << "message" << CountedWrite{&num_writes};
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, value);
+  EXPECT_EQ(0, num_writes);
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -0,0 +1,120 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/available_instructions.h"
+
+#include "test/fuzz/fuzz_test_util.h"
+
+namespace spvtools {
+namespace fuzz {
+namespace {
+
+std::vector<uint32_t> GetAvailableIds(
+    const AvailableInstructions::AvailableBeforeInstruction& available) {
+  std::vector<uint32_t> result;
+  for (uint32_t i = 0; i < available.size(); i++) {
+    result.push_back(available[i]->result_id());
+  }
+  // Check that iterating the available instructions agrees with indexing
+  // them.
+  std::vector<uint32_t> visited;
+  available.ForEach([&visited](opt::Instruction* inst) {
+    visited.push_back(inst->result_id());
+  });
+  EXPECT_EQ(result, visited);
+  return result;
+}
+
+TEST(AvailableInstructionsTest, BasicTest) {
+  std::string shader = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeFloat 32
+          %7 = OpTypeBool
+          %8 = OpConstantTrue %7
+          %9 = OpConstant %6 1
+         %10 = OpTypeFunction %2 %6
+          %4 = OpFunction %2 None %3
+         %11 = OpLabel
+         %12 = OpFAdd %6 %9 %9
+               OpSelectionMerge %15 None
+               OpBranchConditional %8 %13 %14
+         %13 = OpLabel
+         %16 = OpFAdd %6 %12 %9
+               OpBranch %15
+         %14 = OpLabel
+         %17 = OpFAdd %6 %12 %12
+               OpBranch %15
+         %15 = OpLabel
+         %18 = OpFAdd %6 %12 %9
+               OpReturn
+         %19 = OpLabel
+         %20 = OpFAdd %6 %9 %9
+               OpReturn
+               OpFunctionEnd
+         %21 = OpFunction %2 None %10
+         %22 = OpFunctionParameter %6
+         %23 = OpLabel
+         %24 = OpFAdd %6 %22 %9
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  const auto consumer = nullptr;
+  const auto context = BuildModule(env, consumer, shader, kFuzzAssembleOption);
+  ASSERT_TRUE(IsValid(env, context.get()));
+
+  // Consider only instructions of type %6.
+  AvailableInstructions available_instructions(
+      context.get(), [](opt::IRContext* /*unused*/, opt::Instruction* inst) {
+        return inst->type_id() == 6;
+      });
+
+  auto get_available = [&available_instructions](opt::Instruction* inst) {
+    return GetAvailableIds(
+        available_instructions.GetAvailableBeforeInstruction(inst));
+  };
+  auto* def_use_mgr = context->get_def_use_mgr();
+
+  ASSERT_EQ(std::vector<uint32_t>({9}), get_available(def_use_mgr->GetDef(12)));
+  ASSERT_EQ(std::vector<uint32_t>({9, 12}),
+            get_available(def_use_mgr->GetDef(16)));
+  ASSERT_EQ(std::vector<uint32_t>({9, 12, 16}),
+            get_available(context->get_instr_block(13)->terminator()));
+  ASSERT_EQ(std::vector<uint32_t>({9, 12, 17}),
+            get_available(context->get_instr_block(14)->terminator()));
+  ASSERT_EQ(std::vector<uint32_t>({9, 12}),
+            get_available(def_use_mgr->GetDef(18)));
+  ASSERT_EQ(std::vector<uint32_t>({9, 12, 18}),
+            get_available(context->get_instr_block(15)->terminator()));
+  ASSERT_EQ(std::vector<uint32_t>({9, 22}),
+            get_available(def_use_mgr->GetDef(24)));
+  ASSERT_EQ(std::vector<uint32_t>({9, 22, 24}),
+            get_available(context->get_instr_block(23)->terminator()));
+
+  // Instructions in unreachable blocks are not indexed.
+  ASSERT_TRUE(available_instructions.IsIndexed(def_use_mgr->GetDef(18)));
+  ASSERT_FALSE(available_instructions.IsIndexed(def_use_mgr->GetDef(20)));
+}
+
+}  // namespace
+}  // namespace fuzz
+}  // namespace spvtools
@@ -149,6 +149,35 @@ TEST(EquivalenceRelationTest, DeterministicEquivalenceClassOrder) {
   }
 }
 
+TEST(EquivalenceRelationTest, VisitEquivalenceClass) {
+  EquivalenceRelation<uint32_t, UInt32Hash, UInt32Equals> relation;
+  for (uint32_t i = 0; i < 100; ++i) {
+    relation.Register(i);
+  }
+  for (uint32_t i = 3; i < 100; ++i) {
+    relation.MakeEquivalent(i, i % 3);
+  }
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(34u - (i % 3 == 0 ? 0u : 1u),
+              relation.GetEquivalenceClassSize(i));
+    std::vector<uint32_t> visited;
+    relation.ForEachInEquivalenceClass(
+        i, [&visited](const uint32_t* member) { visited.push_back(*member); });
+    ASSERT_EQ(ToUIntVector(relation.GetEquivalenceClass(i)), visited);
+    for (auto member : visited) {
+      ASSERT_EQ(i % 3, member % 3);
+    }
+    ASSERT_EQ(*relation.Find(&i), visited[0]);
+  }
+
+  // Merging two classes yields a class containing the members of both.
+  relation.MakeEquivalent(1, 2);
+  ASSERT_EQ(66u, relation.GetEquivalenceClassSize(95));
+  ASSERT_THAT(ToUIntVector(relation.GetEquivalenceClass(0)),
+              testing::SizeIs(34));
+}
+
 }  // namespace
 }  // namespace fuzz
 }  // namespace spvtools
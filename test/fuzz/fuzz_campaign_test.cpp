@@ -0,0 +1,223 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/fuzz_campaign.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "source/fuzz/pseudo_random_generator.h"
+#include "test/fuzz/fuzz_test_util.h"
+
+namespace spvtools {
+namespace fuzz {
+namespace {
+
+const std::string kRecipientShader = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %7 = OpTypePointer Function %6
+          %8 = OpConstant %6 0
+          %9 = OpConstant %6 10
+         %10 = OpConstant %6 1
+         %11 = OpTypeBool
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+         %12 = OpVariable %7 Function
+         %13 = OpVariable %7 Function
+               OpStore %12 %8
+               OpStore %13 %8
+               OpBranch %14
+         %14 = OpLabel
+               OpLoopMerge %16 %17 None
+               OpBranch %18
+         %18 = OpLabel
+         %19 = OpLoad %6 %12
+         %20 = OpSLessThan %11 %19 %9
+               OpBranchConditional %20 %15 %16
+         %15 = OpLabel
+         %21 = OpLoad %6 %13
+         %22 = OpIAdd %6 %21 %19
+               OpStore %13 %22
+               OpBranch %17
+         %17 = OpLabel
+         %23 = OpIAdd %6 %19 %10
+               OpStore %12 %23
+               OpBranch %14
+         %16 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+const std::string kDonorShader = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeFloat 32
+          %7 = OpTypeFunction %6 %6
+          %8 = OpConstant %6 2
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+         %12 = OpFunctionCall %6 %10 %8
+               OpReturn
+               OpFunctionEnd
+         %10 = OpFunction %6 None %7
+          %9 = OpFunctionParameter %6
+         %11 = OpLabel
+         %13 = OpFMul %6 %9 %8
+         %14 = OpFAdd %6 %13 %9
+               OpReturnValue %14
+               OpFunctionEnd
+  )";
+
+// The binary and the serialized transformations that a run produced.
+using RunOutput = std::pair<std::vector<uint32_t>, std::string>;
+
+// Performs a campaign of |num_runs| runs on |num_jobs| threads, starting from
+// seed |first_seed|, checking that every run completes and produces a valid
+// module.  Returns the outputs of the runs, by seed.
+std::map<uint32_t, RunOutput> RunCampaign(uint32_t first_seed,
+                                          uint32_t num_runs,
+                                          uint32_t num_jobs) {
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  SpirvTools tools(env);
+  std::vector<uint32_t> binary_in;
+  std::vector<std::vector<uint32_t>> donor_binaries(1);
+  EXPECT_TRUE(tools.Assemble(kRecipientShader, &binary_in,
+                             kFuzzAssembleOption));
+  EXPECT_TRUE(tools.Assemble(kDonorShader, &donor_binaries[0],
+                             kFuzzAssembleOption));
+  protobufs::FactSequence initial_facts;
+  spvtools::ValidatorOptions validator_options;
+
+  FuzzCampaign campaign(
+      env, kSilentConsumer, binary_in, initial_facts, donor_binaries,
+      [](uint32_t seed) { return MakeUnique<PseudoRandomGenerator>(seed); },
+      false, Fuzzer::RepeatedPassStrategy::kSimple, false, validator_options);
+  std::map<uint32_t, RunOutput> outputs;
+  EXPECT_TRUE(campaign.Run(
+      first_seed, num_runs, num_jobs,
+      [&outputs, &tools](uint32_t seed, Fuzzer::FuzzerResult&& result) {
+        EXPECT_EQ(Fuzzer::FuzzerResultStatus::kComplete, result.status);
+        EXPECT_TRUE(tools.Validate(result.transformed_binary));
+        EXPECT_EQ(0u, outputs.count(seed));
+        outputs[seed].first = std::move(result.transformed_binary);
+        result.applied_transformations.SerializeToString(
+            &outputs[seed].second);
+      }));
+  return outputs;
+}
+
+TEST(FuzzCampaignTest, RunsDoNotDependOnTheNumberOfJobs) {
+  const uint32_t kFirstSeed = 7;
+  const uint32_t kNumRuns = 6;
+  auto sequential_outputs = RunCampaign(kFirstSeed, kNumRuns, 1);
+  ASSERT_EQ(kNumRuns, sequential_outputs.size());
+  for (uint32_t seed = kFirstSeed; seed < kFirstSeed + kNumRuns; seed++) {
+    ASSERT_EQ(1u, sequential_outputs.count(seed));
+  }
+
+  // The same runs, spread over several threads and repeated, must give the
+  // same outputs.
+  ASSERT_EQ(sequential_outputs, RunCampaign(kFirstSeed, kNumRuns, 3));
+  ASSERT_EQ(sequential_outputs, RunCampaign(kFirstSeed, kNumRuns, 3));
+  ASSERT_EQ(sequential_outputs, RunCampaign(kFirstSeed, kNumRuns, 16));
+
+  // Different seeds give a different campaign.
+  ASSERT_NE(sequential_outputs, RunCampaign(kFirstSeed + 1, kNumRuns, 3));
+}
+
+TEST(FuzzCampaignTest, RunsMatchSingleFuzzerRuns) {
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  SpirvTools tools(env);
+  std::vector<uint32_t> binary_in;
+  std::vector<std::vector<uint32_t>> donor_binaries(1);
+  ASSERT_TRUE(tools.Assemble(kRecipientShader, &binary_in,
+                             kFuzzAssembleOption));
+  ASSERT_TRUE(tools.Assemble(kDonorShader, &donor_binaries[0],
+                             kFuzzAssembleOption));
+  protobufs::FactSequence initial_facts;
+  spvtools::ValidatorOptions validator_options;
+  std::vector<fuzzerutil::ModuleSupplier> donor_suppliers;
+  donor_suppliers.emplace_back([env]() {
+    return BuildModule(env, kSilentConsumer, kDonorShader,
+                       kFuzzAssembleOption);
+  });
+
+  // Each run of the campaign gives the result of fuzzing with its seed, and
+  // its listener is invoked on exactly the transformations of the run.
+  std::map<uint32_t, uint32_t> num_transformations_streamed;
+  const uint32_t kFirstSeed = 42;
+  const uint32_t kNumRuns = 4;
+  for (uint32_t seed = kFirstSeed; seed < kFirstSeed + kNumRuns; seed++) {
+    num_transformations_streamed[seed] = 0;
+  }
+  FuzzCampaign campaign(
+      env, kSilentConsumer, binary_in, initial_facts, donor_binaries,
+      [](uint32_t seed) { return MakeUnique<PseudoRandomGenerator>(seed); },
+      false, Fuzzer::RepeatedPassStrategy::kSimple, false, validator_options);
+  campaign.SetTransformationListenerFactory(
+      [&num_transformations_streamed](uint32_t seed) {
+        // The counters are created up front, so the workers never modify the
+        // map itself.
+        uint32_t* count = &num_transformations_streamed.at(seed);
+        return [count](const protobufs::Transformation& /*unused*/) {
+          (*count)++;
+        };
+      });
+  uint32_t num_runs_handled = 0;
+  ASSERT_TRUE(campaign.Run(
+      kFirstSeed, kNumRuns, 2,
+      [&](uint32_t seed, Fuzzer::FuzzerResult&& result) {
+        num_runs_handled++;
+        auto expected_result =
+            Fuzzer(env, kSilentConsumer, binary_in, initial_facts,
+                   donor_suppliers, MakeUnique<PseudoRandomGenerator>(seed),
+                   false, Fuzzer::RepeatedPassStrategy::kSimple, false,
+                   validator_options)
+                .Run();
+        ASSERT_EQ(Fuzzer::FuzzerResultStatus::kComplete,
+                  expected_result.status);
+        ASSERT_EQ(expected_result.transformed_binary,
+                  result.transformed_binary);
+        std::string expected_transformations;
+        std::string actual_transformations;
+        expected_result.applied_transformations.SerializeToString(
+            &expected_transformations);
+        result.applied_transformations.SerializeToString(
+            &actual_transformations);
+        ASSERT_EQ(expected_transformations, actual_transformations);
+        ASSERT_EQ(static_cast<uint32_t>(
+                      result.applied_transformations.transformation_size()),
+                  num_transformations_streamed.at(seed));
+      }));
+  ASSERT_EQ(kNumRuns, num_runs_handled);
+}
+
+}  // namespace
+}  // namespace fuzz
+}  // namespace spvtools
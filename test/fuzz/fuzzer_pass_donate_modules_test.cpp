@@ -2186,6 +2186,203 @@ TEST(FuzzerPassDonateModulesTest, HandlesOpPhisInMergeBlock) {
   ASSERT_TRUE(IsValid(env, recipient_context.get()));
 }
 
+const std::string kRecipientForCachedDonors = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+const std::string kFloatDonorForCachedDonors = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeFloat 32
+          %7 = OpTypeFunction %6 %6
+          %8 = OpConstant %6 2
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+         %12 = OpFunctionCall %6 %10 %8
+               OpReturn
+               OpFunctionEnd
+         %10 = OpFunction %6 None %7
+          %9 = OpFunctionParameter %6
+         %11 = OpLabel
+         %13 = OpFMul %6 %9 %8
+               OpReturnValue %13
+               OpFunctionEnd
+  )";
+
+const std::string kIntDonorForCachedDonors = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %7 = OpTypeFunction %6 %6
+          %8 = OpConstant %6 3
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+         %12 = OpFunctionCall %6 %10 %8
+               OpReturn
+               OpFunctionEnd
+         %10 = OpFunction %6 None %7
+          %9 = OpFunctionParameter %6
+         %11 = OpLabel
+         %13 = OpIMul %6 %9 %8
+               OpReturnValue %13
+               OpFunctionEnd
+  )";
+
+// Returns a supplier of the module given by |shader| that counts in
+// |num_calls| how many times it is called.
+fuzzerutil::ModuleSupplier MakeCountingSupplier(const std::string& shader,
+                                                uint32_t* num_calls) {
+  return [shader, num_calls]() {
+    (*num_calls)++;
+    return BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, shader,
+                       kFuzzAssembleOption);
+  };
+}
+
+// Returns true if and only if some instruction of a function of |ir_context|
+// has opcode |opcode|.
+bool HasInstructionWithOpcode(opt::IRContext* ir_context, SpvOp opcode) {
+  for (auto& function : *ir_context->module()) {
+    for (auto& block : function) {
+      for (auto& inst : block) {
+        if (inst.opcode() == opcode) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+TEST(FuzzerPassDonateModulesTest, CachedDonorGivesSameTransformations) {
+  // Applies a pass twice, the second time with the donor it kept from the
+  // first time, and applies two passes, the second one with a freshly
+  // supplied donor.  With the same random seed, the results must not differ.
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  const auto consumer = nullptr;
+  spvtools::ValidatorOptions validator_options;
+
+  const auto cached_context = BuildModule(
+      env, consumer, kRecipientForCachedDonors, kFuzzAssembleOption);
+  TransformationContext cached_transformation_context(
+      MakeUnique<FactManager>(cached_context.get()), validator_options);
+  PseudoRandomGenerator cached_prng(7);
+  FuzzerContext cached_fuzzer_context(&cached_prng, 100);
+  protobufs::TransformationSequence cached_transformations;
+  uint32_t num_cached_supplies = 0;
+  FuzzerPassDonateModules cached_pass(
+      cached_context.get(), &cached_transformation_context,
+      &cached_fuzzer_context, &cached_transformations,
+      {MakeCountingSupplier(kFloatDonorForCachedDonors,
+                            &num_cached_supplies)});
+  cached_pass.Apply();
+  cached_pass.Apply();
+
+  const auto fresh_context = BuildModule(
+      env, consumer, kRecipientForCachedDonors, kFuzzAssembleOption);
+  TransformationContext fresh_transformation_context(
+      MakeUnique<FactManager>(fresh_context.get()), validator_options);
+  PseudoRandomGenerator fresh_prng(7);
+  FuzzerContext fresh_fuzzer_context(&fresh_prng, 100);
+  protobufs::TransformationSequence fresh_transformations;
+  uint32_t num_fresh_supplies = 0;
+  for (uint32_t i = 0; i < 2; i++) {
+    FuzzerPassDonateModules fresh_pass(
+        fresh_context.get(), &fresh_transformation_context,
+        &fresh_fuzzer_context, &fresh_transformations,
+        {MakeCountingSupplier(kFloatDonorForCachedDonors,
+                              &num_fresh_supplies)});
+    fresh_pass.Apply();
+  }
+
+  // The donor is supplied once per pass, however many times it is donated.
+  ASSERT_EQ(1u, num_cached_supplies);
+  ASSERT_EQ(2u, num_fresh_supplies);
+
+  ASSERT_TRUE(IsValid(env, cached_context.get()));
+  ASSERT_LT(0, cached_transformations.transformation_size());
+  std::string cached_transformations_string;
+  std::string fresh_transformations_string;
+  cached_transformations.SerializeToString(&cached_transformations_string);
+  fresh_transformations.SerializeToString(&fresh_transformations_string);
+  ASSERT_EQ(fresh_transformations_string, cached_transformations_string);
+  ASSERT_TRUE(IsEqual(env, fresh_context.get(), cached_context.get()));
+}
+
+TEST(FuzzerPassDonateModulesTest, CachedDonorsDoNotOutliveTheirDonorList) {
+  // A pass keeps the donors of the list it was given only.  When a new pass is
+  // given another list, it must donate from that list, rather than reuse the
+  // donors kept by the previous pass.
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  const auto consumer = nullptr;
+  spvtools::ValidatorOptions validator_options;
+
+  const auto recipient_context = BuildModule(
+      env, consumer, kRecipientForCachedDonors, kFuzzAssembleOption);
+  TransformationContext transformation_context(
+      MakeUnique<FactManager>(recipient_context.get()), validator_options);
+  PseudoRandomGenerator prng(0);
+  FuzzerContext fuzzer_context(&prng, 100);
+  protobufs::TransformationSequence transformation_sequence;
+
+  uint32_t num_float_supplies = 0;
+  uint32_t num_int_supplies = 0;
+  {
+    FuzzerPassDonateModules fuzzer_pass(
+        recipient_context.get(), &transformation_context, &fuzzer_context,
+        &transformation_sequence,
+        {MakeCountingSupplier(kFloatDonorForCachedDonors,
+                              &num_float_supplies)});
+    fuzzer_pass.Apply();
+  }
+  ASSERT_EQ(1u, num_float_supplies);
+  ASSERT_TRUE(HasInstructionWithOpcode(recipient_context.get(), SpvOpFMul));
+  ASSERT_FALSE(HasInstructionWithOpcode(recipient_context.get(), SpvOpIMul));
+
+  {
+    FuzzerPassDonateModules fuzzer_pass(
+        recipient_context.get(), &transformation_context, &fuzzer_context,
+        &transformation_sequence,
+        {MakeCountingSupplier(kIntDonorForCachedDonors, &num_int_supplies)});
+    fuzzer_pass.Apply();
+  }
+  ASSERT_EQ(1u, num_float_supplies);
+  ASSERT_EQ(1u, num_int_supplies);
+  ASSERT_TRUE(HasInstructionWithOpcode(recipient_context.get(), SpvOpIMul));
+
+  // A pass given no donors donates nothing, whatever the earlier passes kept.
+  const auto num_transformations =
+      transformation_sequence.transformation_size();
+  FuzzerPassDonateModules(recipient_context.get(), &transformation_context,
+                          &fuzzer_context, &transformation_sequence, {})
+      .Apply();
+  ASSERT_EQ(num_transformations, transformation_sequence.transformation_size());
+  ASSERT_TRUE(IsValid(env, recipient_context.get()));
+}
+
 }  // namespace
 }  // namespace fuzz
 }  // namespace spvtools
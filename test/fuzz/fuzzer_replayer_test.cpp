@@ -1643,7 +1643,8 @@ void RunFuzzerAndReplayer(const std::string& shader,
   std::vector<Fuzzer::RepeatedPassStrategy> strategies{
       Fuzzer::RepeatedPassStrategy::kSimple,
       Fuzzer::RepeatedPassStrategy::kLoopedWithRecommendations,
-      Fuzzer::RepeatedPassStrategy::kRandomWithRecommendations};
+      Fuzzer::RepeatedPassStrategy::kRandomWithRecommendations,
+      Fuzzer::RepeatedPassStrategy::kAdaptive};
   uint32_t strategy_index = 0;
   for (uint32_t seed = initial_seed; seed < initial_seed + num_runs; seed++) {
     spvtools::ValidatorOptions validator_options;
@@ -994,7 +994,7 @@ void RunAndCheckShrinker(
   auto shrinker_result =
       Shrinker(target_env, kSilentConsumer, binary_in, initial_facts,
                transformation_sequence_in, interestingness_function, step_limit,
-               false, validator_options)
+               false, validator_options, 1)
           .Run();
 
   ASSERT_TRUE(Shrinker::ShrinkerResultStatus::kComplete ==
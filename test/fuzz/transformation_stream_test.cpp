@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/transformation_stream.h"
+
+#include <sstream>
+
+#include "source/fuzz/transformation_add_type_int.h"
+#include "source/fuzz/transformation_add_type_struct.h"
+#include "test/fuzz/fuzz_test_util.h"
+
+namespace spvtools {
+namespace fuzz {
+namespace {
+
+protobufs::TransformationSequence MakeSequence() {
+  protobufs::TransformationSequence sequence;
+  *sequence.add_transformation() =
+      TransformationAddTypeInt(10, 32, true).ToMessage();
+  // A struct with many members, so that its record needs a multi-byte size.
+  *sequence.add_transformation() =
+      TransformationAddTypeStruct(11, std::vector<uint32_t>(100, 10))
+          .ToMessage();
+  *sequence.add_transformation() =
+      TransformationAddTypeInt(12, 32, false).ToMessage();
+  return sequence;
+}
+
+std::string WriteSequence(const protobufs::TransformationSequence& sequence) {
+  std::stringstream stream;
+  TransformationStreamWriter writer(&stream);
+  for (auto& transformation : sequence.transformation()) {
+    EXPECT_TRUE(writer.Write(transformation));
+  }
+  return stream.str();
+}
+
+TEST(TransformationStreamTest, RoundTrip) {
+  const auto sequence = MakeSequence();
+  std::stringstream stream(WriteSequence(sequence));
+  ASSERT_TRUE(IsTransformationStream(&stream));
+
+  TransformationStreamReader reader(&stream);
+  for (auto& expected : sequence.transformation()) {
+    protobufs::Transformation transformation;
+    ASSERT_EQ(TransformationStreamReader::Status::kTransformationRead,
+              reader.Next(&transformation));
+    ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+        expected, transformation));
+  }
+  protobufs::Transformation transformation;
+  ASSERT_EQ(TransformationStreamReader::Status::kEndOfStream,
+            reader.Next(&transformation));
+}
+
+TEST(TransformationStreamTest, EmptyStream) {
+  std::stringstream stream(WriteSequence(protobufs::TransformationSequence()));
+  ASSERT_TRUE(IsTransformationStream(&stream));
+  protobufs::TransformationSequence sequence;
+  bool truncated = true;
+  ASSERT_TRUE(ReadTransformationStream(&stream, &sequence, &truncated));
+  ASSERT_FALSE(truncated);
+  ASSERT_EQ(0, sequence.transformation_size());
+}
+
+TEST(TransformationStreamTest, TruncatedStream) {
+  const auto sequence = MakeSequence();
+  const auto contents = WriteSequence(sequence);
+  // Drop part of the final record, as would happen if the writer crashed.
+  std::stringstream stream(contents.substr(0, contents.size() - 2));
+  protobufs::TransformationSequence read_sequence;
+  bool truncated = false;
+  ASSERT_TRUE(ReadTransformationStream(&stream, &read_sequence, &truncated));
+  ASSERT_TRUE(truncated);
+  ASSERT_EQ(2, read_sequence.transformation_size());
+  for (int i = 0; i < read_sequence.transformation_size(); i++) {
+    ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(
+        sequence.transformation(i), read_sequence.transformation(i)));
+  }
+}
+
+TEST(TransformationStreamTest, NotAStream) {
+  // A sequence serialized as a single protobuf message is not a stream.
+  std::string contents;
+  ASSERT_TRUE(MakeSequence().SerializeToString(&contents));
+  std::stringstream stream(contents);
+  ASSERT_FALSE(IsTransformationStream(&stream));
+  protobufs::TransformationSequence sequence;
+  bool truncated;
+  ASSERT_FALSE(ReadTransformationStream(&stream, &sequence, &truncated));
+}
+
+}  // namespace
+}  // namespace fuzz
+}  // namespace spvtools
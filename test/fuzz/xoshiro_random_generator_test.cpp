@@ -0,0 +1,75 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/fuzz/xoshiro_random_generator.h"
+
+#include "gtest/gtest.h"
+
+namespace spvtools {
+namespace fuzz {
+namespace {
+
+TEST(XoshiroRandomGeneratorTest, SameSeedGivesSameSequence) {
+  XoshiroRandomGenerator first(42);
+  XoshiroRandomGenerator second(42);
+  for (uint32_t i = 0; i < 1000; i++) {
+    ASSERT_EQ(first.RandomUint32(1000), second.RandomUint32(1000));
+    ASSERT_EQ(first.RandomUint64(1ull << 40), second.RandomUint64(1ull << 40));
+    ASSERT_EQ(first.RandomPercentage(), second.RandomPercentage());
+    ASSERT_EQ(first.RandomBool(), second.RandomBool());
+    ASSERT_EQ(first.RandomDouble(), second.RandomDouble());
+  }
+}
+
+TEST(XoshiroRandomGeneratorTest, DifferentSeedsGiveDifferentSequences) {
+  XoshiroRandomGenerator first(1);
+  XoshiroRandomGenerator second(2);
+  bool differ = false;
+  for (uint32_t i = 0; i < 100 && !differ; i++) {
+    differ = first.RandomUint32(UINT32_MAX) != second.RandomUint32(UINT32_MAX);
+  }
+  ASSERT_TRUE(differ);
+}
+
+TEST(XoshiroRandomGeneratorTest, ValuesAreInRange) {
+  XoshiroRandomGenerator generator(0);
+  std::vector<bool> percentages_seen(101, false);
+  bool seen_true = false;
+  bool seen_false = false;
+  for (uint32_t i = 0; i < 10000; i++) {
+    ASSERT_EQ(0, generator.RandomUint32(1));
+    ASSERT_LT(generator.RandomUint32(7), 7);
+    ASSERT_LT(generator.RandomUint64(3), 3);
+    const uint32_t percentage = generator.RandomPercentage();
+    ASSERT_LE(percentage, 100);
+    percentages_seen[percentage] = true;
+    const double value = generator.RandomDouble();
+    ASSERT_GE(value, 0.0);
+    ASSERT_LE(value, 1.0);
+    if (generator.RandomBool()) {
+      seen_true = true;
+    } else {
+      seen_false = true;
+    }
+  }
+  for (uint32_t percentage = 0; percentage <= 100; percentage++) {
+    ASSERT_TRUE(percentages_seen[percentage]);
+  }
+  ASSERT_TRUE(seen_true);
+  ASSERT_TRUE(seen_false);
+}
+
+}  // namespace
+}  // namespace fuzz
+}  // namespace spvtools
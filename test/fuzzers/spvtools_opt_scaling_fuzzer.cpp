@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Looks for the modules that make the performance passes do superlinear work.
+// The work of the passes is counted with Optimizer::SetWorkCounts rather than
+// timed, so that the findings do not depend on the machine.  A module is
+// reported when the work per instruction is larger than a linear pipeline
+// does on any reasonable module:
+//
+//  - If the SPVTOOLS_SCALING_FUZZER_OUTPUT_DIR environment variable names a
+//    directory, the module is written there, and fuzzing goes on.  The
+//    modules can be added to test/benchmarks/corpora as regression
+//    benchmarks.
+//  - Otherwise the fuzzer aborts, so that libFuzzer saves the module.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "spirv-tools/optimizer.hpp"
+
+namespace {
+
+// Modules smaller than this are not checked, since a fixed cost dominates
+// their work.
+const size_t kMinInstructions = 32;
+
+// Each pass builds its analyses about once per function, so building many
+// more analyses than there are instructions means that some analysis is
+// rebuilt in a loop over the instructions.
+const size_t kMaxAnalysisBuildsPerInstruction = 64;
+
+// Passes add or remove a few use records for the instructions they change, and
+// the def-use manager adds one for each operand when it is built.
+const size_t kMaxDefUseUpdatesPerInstruction = 4096;
+
+// Returns a name for |input| that does not depend on the run that found it.
+std::string FileName(const std::vector<uint32_t>& input) {
+  uint64_t hash = 14695981039346656037ull;
+  for (uint32_t word : input) {
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "scaling-%016llx.spv",
+           static_cast<unsigned long long>(hash));
+  return name;
+}
+
+void Report(const std::vector<uint32_t>& input,
+            const spvtools::Optimizer::WorkCounts& counts) {
+  fprintf(stderr,
+          "Superlinear work: %zu analysis builds and %zu def-use updates for "
+          "%zu instructions\n",
+          counts.analysis_builds, counts.def_use_updates, counts.instructions);
+  const char* dir = getenv("SPVTOOLS_SCALING_FUZZER_OUTPUT_DIR");
+  if (dir == nullptr) abort();
+  const std::string path = std::string(dir) + "/" + FileName(input);
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(input.data()),
+            static_cast<std::streamsize>(input.size() * sizeof(uint32_t)));
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  spvtools::Optimizer optimizer(SPV_ENV_UNIVERSAL_1_3);
+  optimizer.SetMessageConsumer([](spv_message_level_t, const char*,
+                                  const spv_position_t&, const char*) {});
+
+  std::vector<uint32_t> input;
+  input.resize(size >> 2);
+
+  size_t count = 0;
+  for (size_t i = 0; (i + 3) < size; i += 4) {
+    input[count++] = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16) |
+                     (data[i + 3]) << 24;
+  }
+
+  spvtools::Optimizer::WorkCounts counts;
+  optimizer.SetWorkCounts(&counts);
+  optimizer.RegisterPerformancePasses();
+  std::vector<uint32_t> output;
+  if (!optimizer.Run(input.data(), input.size(), &output)) return 0;
+
+  if (counts.instructions >= kMinInstructions &&
+      (counts.analysis_builds >
+           kMaxAnalysisBuildsPerInstruction * counts.instructions ||
+       counts.def_use_updates >
+           kMaxDefUseUpdatesPerInstruction * counts.instructions)) {
+    Report(input, counts);
+  }
+  return 0;
+}
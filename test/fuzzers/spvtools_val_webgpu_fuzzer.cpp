@@ -31,6 +31,10 @@ extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
                      (data[i + 3]) << 24;
   }
 
-  tools.Validate(input);
+  // Modules that would need more memory than the fuzzer should use are
+  // rejected before they are parsed.
+  spvtools::ValidatorOptions options;
+  options.SetUniversalLimit(spv_validator_limit_max_memory_kib, 256 * 1024);
+  tools.Validate(input.data(), input.size(), options);
   return 0;
 }
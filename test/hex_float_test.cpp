@@ -1325,6 +1325,40 @@ TEST(FloatProxy, Lowest) {
               Eq(std::numeric_limits<double>::lowest()));
 }
 
+TEST(FloatProxy, AppendMatchesStream) {
+  const std::vector<uint32_t> float_bits = {
+      0x00000000, 0x80000000, 0x3f800000, 0xbfc00000, 0x3eaaaaab,
+      0x7f7fffff, 0x00000001, 0x7f800000, 0xff800000, 0x7fc00001};
+  for (uint32_t bits : float_bits) {
+    std::ostringstream stream;
+    stream << FloatProxy<float>(bits);
+    TextBuffer text;
+    AppendFloatProxy(FloatProxy<float>(bits), &text);
+    EXPECT_THAT(text.str(), Eq(stream.str())) << bits;
+  }
+
+  const std::vector<uint64_t> double_bits = {
+      0x0000000000000000, 0x3ff0000000000001, 0xc00921fb54442d18,
+      0x0000000000000001, 0x7ff0000000000000, 0x7ff8000000000000};
+  for (uint64_t bits : double_bits) {
+    std::ostringstream stream;
+    stream << FloatProxy<double>(bits);
+    TextBuffer text;
+    AppendFloatProxy(FloatProxy<double>(bits), &text);
+    EXPECT_THAT(text.str(), Eq(stream.str())) << bits;
+  }
+
+  const std::vector<uint16_t> half_bits = {0x0000, 0x3c00, 0xc200, 0x0001,
+                                           0x7c00, 0x7e01};
+  for (uint16_t bits : half_bits) {
+    std::ostringstream stream;
+    stream << FloatProxy<Float16>(bits);
+    TextBuffer text;
+    AppendFloatProxy(FloatProxy<Float16>(bits), &text);
+    EXPECT_THAT(text.str(), Eq(stream.str())) << bits;
+  }
+}
+
 // TODO(awoloszyn): Add fp16 tests and HexFloatTraits.
 }  // namespace
 }  // namespace utils
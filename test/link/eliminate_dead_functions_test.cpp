@@ -0,0 +1,112 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/link/linker_fixture.h"
+
+namespace spvtools {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+using EliminateDeadFunctions = spvtest::LinkerTest;
+
+const char* const kMainBody = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpDecorate %foo LinkageAttributes "foo" Import
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%foo = OpFunction %void None %fn
+OpFunctionEnd
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%call = OpFunctionCall %void %foo
+OpReturn
+OpFunctionEnd
+)";
+
+const char* const kLibraryBody = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpName %foo "foo"
+OpName %bar "bar"
+OpName %helper "helper"
+OpDecorate %foo LinkageAttributes "foo" Export
+OpDecorate %bar LinkageAttributes "bar" Export
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%helper = OpFunction %void None %fn
+%helper_entry = OpLabel
+OpReturn
+OpFunctionEnd
+%foo = OpFunction %void None %fn
+%foo_entry = OpLabel
+%call = OpFunctionCall %void %helper
+OpReturn
+OpFunctionEnd
+%bar = OpFunction %void None %fn
+%bar_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(EliminateDeadFunctions, DisabledByDefault) {
+  spvtest::Binary linked_binary;
+  ASSERT_EQ(SPV_SUCCESS,
+            AssembleAndLink({kMainBody, kLibraryBody}, &linked_binary))
+      << GetErrorMessage();
+  std::string res_body;
+  EXPECT_EQ(SPV_SUCCESS, Disassemble(linked_binary, &res_body))
+      << GetErrorMessage();
+  EXPECT_THAT(res_body, HasSubstr("OpName %bar \"bar\""));
+}
+
+TEST_F(EliminateDeadFunctions, KeepsOnlyReachableFunctions) {
+  LinkerOptions options;
+  options.SetEliminateDeadFunctions(true);
+  spvtest::Binary linked_binary;
+  ASSERT_EQ(SPV_SUCCESS, AssembleAndLink({kMainBody, kLibraryBody},
+                                         &linked_binary, options))
+      << GetErrorMessage();
+  std::string res_body;
+  EXPECT_EQ(SPV_SUCCESS, Disassemble(linked_binary, &res_body))
+      << GetErrorMessage();
+  EXPECT_THAT(res_body, HasSubstr("OpName %foo \"foo\""));
+  EXPECT_THAT(res_body, HasSubstr("OpName %helper \"helper\""));
+  EXPECT_THAT(res_body, Not(HasSubstr("OpName %bar \"bar\"")));
+}
+
+TEST_F(EliminateDeadFunctions, LibraryKeepsExports) {
+  LinkerOptions options;
+  options.SetEliminateDeadFunctions(true);
+  options.SetCreateLibrary(true);
+  spvtest::Binary linked_binary;
+  ASSERT_EQ(SPV_SUCCESS, AssembleAndLink({kMainBody, kLibraryBody},
+                                         &linked_binary, options))
+      << GetErrorMessage();
+  std::string res_body;
+  EXPECT_EQ(SPV_SUCCESS, Disassemble(linked_binary, &res_body))
+      << GetErrorMessage();
+  EXPECT_THAT(res_body, HasSubstr("OpName %bar \"bar\""));
+}
+
+}  // namespace
+}  // namespace spvtools
@@ -82,6 +82,59 @@ class LinkerTest : public ::testing::Test {
     return spvtools::Link(context_, binaries, linked_binary, options);
   }
 
+  // Assembles each of the given strings into SPIR-V binaries before preparing
+  // them as |library|. SPV_ERROR_INVALID_TEXT is returned if the assembling
+  // failed for any of the input strings.
+  spv_result_t AssembleAndPrepareLibrary(
+      const std::vector<std::string>& bodies,
+      spvtools::PreparedLibrary* library,
+      spvtools::LinkerOptions options = spvtools::LinkerOptions()) {
+    spvtest::Binaries binaries(bodies.size());
+    for (size_t i = 0u; i < bodies.size(); ++i)
+      if (!tools_.Assemble(bodies[i], binaries.data() + i, assemble_options_))
+        return SPV_ERROR_INVALID_TEXT;
+
+    return spvtools::PrepareLibrary(context_, binaries, library, options);
+  }
+
+  // As AssembleAndLink, except that the given strings are linked against the
+  // prepared |library|.
+  spv_result_t AssembleAndLinkWithLibrary(
+      const spvtools::PreparedLibrary& library,
+      const std::vector<std::string>& bodies, spvtest::Binary* linked_binary,
+      spvtools::LinkerOptions options = spvtools::LinkerOptions()) {
+    if (!linked_binary) return SPV_ERROR_INVALID_POINTER;
+
+    spvtest::Binaries binaries(bodies.size());
+    for (size_t i = 0u; i < bodies.size(); ++i)
+      if (!tools_.Assemble(bodies[i], binaries.data() + i, assemble_options_))
+        return SPV_ERROR_INVALID_TEXT;
+
+    return spvtools::Link(context_, library, binaries, linked_binary, options);
+  }
+
+  // As AssembleAndLink, except that the given strings are loaded as modules
+  // before being linked, and that the result is kept loaded in
+  // |linked_module|.
+  spv_result_t AssembleLoadAndLink(
+      const std::vector<std::string>& bodies,
+      spvtools::LoadedModule* linked_module,
+      spvtools::LinkerOptions options = spvtools::LinkerOptions()) {
+    std::vector<spvtools::LoadedModule> modules(bodies.size());
+    std::vector<spvtools::LoadedModule*> module_ptrs;
+    for (size_t i = 0u; i < bodies.size(); ++i) {
+      spvtest::Binary binary;
+      if (!tools_.Assemble(bodies[i], &binary, assemble_options_))
+        return SPV_ERROR_INVALID_TEXT;
+      if (!modules[i].Load(SPV_ENV_UNIVERSAL_1_2, nullptr, binary.data(),
+                           binary.size()))
+        return SPV_ERROR_INVALID_BINARY;
+      module_ptrs.push_back(&modules[i]);
+    }
+
+    return spvtools::Link(context_, module_ptrs, linked_module, options);
+  }
+
   // Assembles and links a vector of SPIR-V bodies based on the |templateBody|.
   // Template arguments to be replaced are written as {a,b,...}.
   // SPV_ERROR_INVALID_TEXT is returned if the assembling failed for any of the
@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "test/link/linker_fixture.h"
+
+namespace spvtools {
+namespace {
+
+using ::testing::HasSubstr;
+using LoadedModuleTest = spvtest::LinkerTest;
+
+const char* const kExportBody = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Export
+%2 = OpTypeFloat 32
+%3 = OpConstant %2 42
+%1 = OpVariable %2 Uniform %3
+)";
+
+const char* const kImportBody = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Import
+%2 = OpTypeFloat 32
+%1 = OpVariable %2 Uniform
+%3 = OpVariable %2 Input
+)";
+
+TEST_F(LoadedModuleTest, LinksAsBinaries) {
+  LoadedModule linked_module;
+  ASSERT_EQ(SPV_SUCCESS,
+            AssembleLoadAndLink({kExportBody, kImportBody}, &linked_module))
+      << GetErrorMessage();
+  ASSERT_TRUE(linked_module.IsLoaded());
+
+  spvtest::Binary linked_binary;
+  ASSERT_TRUE(linked_module.ToBinary(&linked_binary));
+  spvtest::Binary expected_binary;
+  ASSERT_EQ(SPV_SUCCESS,
+            AssembleAndLink({kExportBody, kImportBody}, &expected_binary))
+      << GetErrorMessage();
+  EXPECT_EQ(expected_binary, linked_binary);
+}
+
+TEST_F(LoadedModuleTest, UnloadedModule) {
+  LoadedModule module;
+  LoadedModule linked_module;
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            Link(Context(SPV_ENV_UNIVERSAL_1_2), {&module}, &linked_module));
+  EXPECT_FALSE(linked_module.IsLoaded());
+}
+
+TEST_F(LoadedModuleTest, NoModules) {
+  LoadedModule linked_module;
+  EXPECT_EQ(SPV_ERROR_INVALID_BINARY, AssembleLoadAndLink({}, &linked_module));
+  EXPECT_THAT(GetErrorMessage(), HasSubstr("No modules were given."));
+}
+
+}  // namespace
+}  // namespace spvtools
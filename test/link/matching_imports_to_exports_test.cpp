@@ -57,6 +57,76 @@ OpDecorate %1 LinkageAttributes "foo" Export
   EXPECT_EQ(expected_res, res_body);
 }
 
+TEST_F(MatchingImportsToExports, SeveralThreads) {
+  const std::string body1 = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Import
+%2 = OpTypeFloat 32
+%1 = OpVariable %2 Uniform
+%3 = OpVariable %2 Input
+)";
+  const std::string body2 = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "bar" Import
+%2 = OpTypeFloat 32
+%1 = OpVariable %2 Uniform
+%3 = OpVariable %2 Private
+)";
+  const std::string body3 = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Export
+OpDecorate %4 LinkageAttributes "bar" Export
+%2 = OpTypeFloat 32
+%3 = OpConstant %2 42
+%1 = OpVariable %2 Uniform %3
+%4 = OpVariable %2 Uniform %3
+)";
+
+  spvtest::Binary sequential_binary;
+  EXPECT_EQ(SPV_SUCCESS,
+            AssembleAndLink({body1, body2, body3}, &sequential_binary))
+      << GetErrorMessage();
+
+  // Spreading the work over more threads than there are modules must not
+  // change the result.
+  for (uint32_t num_threads : {2u, 8u}) {
+    LinkerOptions options;
+    options.SetNumThreads(num_threads);
+    spvtest::Binary parallel_binary;
+    EXPECT_EQ(SPV_SUCCESS, AssembleAndLink({body1, body2, body3},
+                                           &parallel_binary, options))
+        << GetErrorMessage();
+    EXPECT_EQ(sequential_binary, parallel_binary);
+  }
+}
+
+TEST_F(MatchingImportsToExports, SingleThreadStopsAtFirstInvalidModule) {
+  // Two modules with the same invalid instruction, whose parsing would
+  // report the same diagnostic.
+  // clang-format off
+  const spvtest::Binary invalid = {
+      SpvMagicNumber,
+      0x00010000u,
+      SPV_GENERATOR_CODEPLAY,
+      1u,  // NOTE: Bound
+      0u,  // NOTE: Schema; reserved
+      0x0001ffffu  // An instruction with an unknown opcode.
+  };
+  // clang-format on
+  spvtest::Binary linked_binary;
+  LinkerOptions options;
+  options.SetNumThreads(1);
+  EXPECT_NE(SPV_SUCCESS, Link({invalid, invalid}, &linked_binary, options));
+
+  const std::string message = GetErrorMessage();
+  const std::string first_diagnostic = message.substr(0, message.find('\n'));
+  ASSERT_FALSE(first_diagnostic.empty());
+  EXPECT_EQ(message.find(first_diagnostic, first_diagnostic.size()),
+            std::string::npos)
+      << message;
+  EXPECT_THAT(message, HasSubstr("Failed to build a module out of 0."));
+}
+
 TEST_F(MatchingImportsToExports, NotALibraryExtraExports) {
   const std::string body = R"(
 OpCapability Linkage
@@ -0,0 +1,97 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/link/linker_fixture.h"
+
+namespace spvtools {
+namespace {
+
+using ::testing::HasSubstr;
+using PreparedLibraryTest = spvtest::LinkerTest;
+
+const char* const kLibraryBody = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Export
+%2 = OpTypeFloat 32
+%3 = OpConstant %2 42
+%1 = OpVariable %2 Uniform %3
+)";
+
+const char* const kModuleBody = R"(
+OpCapability Linkage
+OpDecorate %1 LinkageAttributes "foo" Import
+%2 = OpTypeFloat 32
+%1 = OpVariable %2 Uniform
+%3 = OpVariable %2 Input
+)";
+
+TEST_F(PreparedLibraryTest, LinkAgainstLibraryRepeatedly) {
+  PreparedLibrary library;
+  EXPECT_FALSE(library.IsPrepared());
+  ASSERT_EQ(SPV_SUCCESS, AssembleAndPrepareLibrary({kLibraryBody}, &library))
+      << GetErrorMessage();
+  EXPECT_TRUE(library.IsPrepared());
+
+  // The library was itself linked, so it carries its own OpModuleProcessed.
+  const std::string expected_res =
+      R"(OpModuleProcessed "Linked by SPIR-V Tools Linker"
+OpModuleProcessed "Linked by SPIR-V Tools Linker"
+%1 = OpTypeFloat 32
+%2 = OpConstant %1 42
+%3 = OpVariable %1 Uniform %2
+%4 = OpVariable %1 Input
+)";
+  SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+  for (int i = 0; i < 2; i++) {
+    spvtest::Binary linked_binary;
+    EXPECT_EQ(SPV_SUCCESS, AssembleAndLinkWithLibrary(library, {kModuleBody},
+                                                      &linked_binary))
+        << GetErrorMessage();
+    std::string res_body;
+    EXPECT_EQ(SPV_SUCCESS, Disassemble(linked_binary, &res_body))
+        << GetErrorMessage();
+    EXPECT_EQ(expected_res, res_body);
+  }
+}
+
+TEST_F(PreparedLibraryTest, LibraryKeepsExports) {
+  PreparedLibrary library;
+  ASSERT_EQ(SPV_SUCCESS, AssembleAndPrepareLibrary({kLibraryBody}, &library))
+      << GetErrorMessage();
+
+  spvtest::Binary linked_binary;
+  LinkerOptions options;
+  options.SetCreateLibrary(true);
+  EXPECT_EQ(SPV_SUCCESS,
+            AssembleAndLinkWithLibrary(library, {}, &linked_binary, options))
+      << GetErrorMessage();
+  std::string res_body;
+  EXPECT_EQ(SPV_SUCCESS, Disassemble(linked_binary, &res_body))
+      << GetErrorMessage();
+  EXPECT_THAT(res_body, HasSubstr("LinkageAttributes \"foo\" Export"));
+}
+
+TEST_F(PreparedLibraryTest, UnpreparedLibrary) {
+  PreparedLibrary library;
+  spvtest::Binary linked_binary;
+  EXPECT_EQ(SPV_ERROR_INVALID_POINTER,
+            AssembleAndLinkWithLibrary(library, {kModuleBody}, &linked_binary));
+  EXPECT_THAT(GetErrorMessage(), HasSubstr("The library was not prepared."));
+}
+
+}  // namespace
+}  // namespace spvtools
@@ -133,6 +133,12 @@ INSTANTIATE_TEST_SUITE_P(
         // numbers.
         {"OpName %1 \"2\" OpName %2 \"2\"", 1, "2"},
         {"OpName %1 \"2\" OpName %2 \"2\"", 2, "2_0"},
+        // The ids named by their number also take part in the uniqueness
+        // of the names, whether they are defined before or after the debug
+        // names.
+        {"%2 = OpString \"x\" OpName %1 \"2\"", 1, "2_0"},
+        {"%2 = OpString \"x\" OpName %1 \"2\"", 2, "2"},
+        {"OpName %1 \"2\" %2 = OpString \"x\"", 2, "2_0"},
         // Test uniqueness in the face of forward references
         // for Ids that don't already have friendly names.
         // In particular, the first OpDecorate assigns the name, and
@@ -32,8 +32,46 @@ TEST_P(GetTargetOpcodeTableGetTest, InvalidPointerTable) {
   ASSERT_EQ(SPV_ERROR_INVALID_POINTER, spvOpcodeTableGet(nullptr, GetParam()));
 }
 
+TEST_P(GetTargetOpcodeTableGetTest, ValueLookupFindsEveryOpcode) {
+  spv_opcode_table table;
+  ASSERT_EQ(SPV_SUCCESS, spvOpcodeTableGet(&table, GetParam()));
+  for (uint32_t i = 0; i < table->count; ++i) {
+    const SpvOp opcode = table->entries[i].opcode;
+    spv_opcode_desc entry = nullptr;
+    if (spvOpcodeTableValueLookup(GetParam(), table, opcode, &entry) ==
+        SPV_SUCCESS) {
+      EXPECT_EQ(opcode, entry->opcode);
+    }
+  }
+}
+
+TEST_P(GetTargetOpcodeTableGetTest, ValueLookupRejectsUnknownOpcode) {
+  spv_opcode_table table;
+  ASSERT_EQ(SPV_SUCCESS, spvOpcodeTableGet(&table, GetParam()));
+  spv_opcode_desc entry = nullptr;
+  EXPECT_EQ(SPV_ERROR_INVALID_LOOKUP,
+            spvOpcodeTableValueLookup(GetParam(), table,
+                                      static_cast<SpvOp>(0xffff), &entry));
+}
+
 INSTANTIATE_TEST_SUITE_P(OpcodeTableGet, GetTargetOpcodeTableGetTest,
                          ValuesIn(spvtest::AllTargetEnvironments()));
 
+TEST(OpcodeFixedIdOperandsTest, Classification) {
+  spv_opcode_table table;
+  ASSERT_EQ(SPV_SUCCESS, spvOpcodeTableGet(&table, SPV_ENV_UNIVERSAL_1_0));
+  auto fixed = [table](SpvOp opcode) {
+    spv_opcode_desc entry = nullptr;
+    EXPECT_EQ(SPV_SUCCESS, spvOpcodeTableValueLookup(SPV_ENV_UNIVERSAL_1_0,
+                                                     table, opcode, &entry));
+    return spvOpcodeHasFixedIdOperands(entry);
+  };
+  EXPECT_TRUE(fixed(SpvOpIAdd));
+  EXPECT_FALSE(fixed(SpvOpStore));  // Optional memory access.
+  EXPECT_TRUE(fixed(SpvOpReturn));
+  EXPECT_FALSE(fixed(SpvOpDecorate));
+  EXPECT_FALSE(fixed(SpvOpAccessChain));  // Variable indices.
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -0,0 +1,165 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/call_graph.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/ir_builder.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using ::testing::ElementsAre;
+
+// %1 calls %2 twice and %3, %2 calls %3, and %3 and %4 call each other.
+const std::string kModule = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+               OpExecutionMode %1 LocalSize 1 1 1
+          %5 = OpTypeVoid
+          %6 = OpTypeFunction %5
+          %1 = OpFunction %5 None %6
+         %10 = OpLabel
+         %11 = OpFunctionCall %5 %3
+         %12 = OpFunctionCall %5 %2
+         %13 = OpFunctionCall %5 %2
+               OpReturn
+               OpFunctionEnd
+          %2 = OpFunction %5 None %6
+         %20 = OpLabel
+         %21 = OpFunctionCall %5 %3
+               OpReturn
+               OpFunctionEnd
+          %3 = OpFunction %5 None %6
+         %30 = OpLabel
+         %31 = OpFunctionCall %5 %4
+               OpReturn
+               OpFunctionEnd
+          %4 = OpFunction %5 None %6
+         %40 = OpLabel
+         %41 = OpFunctionCall %5 %3
+               OpReturn
+               OpFunctionEnd
+)";
+
+std::unique_ptr<IRContext> BuildContext() {
+  return BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kModule,
+                     SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+}
+
+TEST(CallGraphTest, ListsCalleesAndCallers) {
+  std::unique_ptr<IRContext> context = BuildContext();
+  ASSERT_NE(nullptr, context);
+  CallGraph* call_graph = context->GetCallGraph();
+
+  EXPECT_THAT(call_graph->GetCallees(context->GetFunction(1)),
+              ElementsAre(3, 2));
+  EXPECT_THAT(call_graph->GetCallees(context->GetFunction(4)), ElementsAre(3));
+  EXPECT_THAT(call_graph->GetCallers(3), ElementsAre(1, 2, 4));
+  EXPECT_THAT(call_graph->GetCallers(1), ElementsAre());
+
+  std::vector<uint32_t> call_ids;
+  for (Instruction* call : call_graph->GetCallSites(context->GetFunction(1))) {
+    call_ids.push_back(call->result_id());
+  }
+  EXPECT_THAT(call_ids, ElementsAre(11, 12, 13));
+}
+
+TEST(CallGraphTest, FindsRecursionAndTopologicalOrder) {
+  std::unique_ptr<IRContext> context = BuildContext();
+  ASSERT_NE(nullptr, context);
+  CallGraph* call_graph = context->GetCallGraph();
+
+  const auto& components = call_graph->GetStronglyConnectedComponents();
+  ASSERT_EQ(3u, components.size());
+  EXPECT_THAT(components[0], ElementsAre(1));
+  EXPECT_THAT(components[1], ElementsAre(2));
+  EXPECT_EQ(2u, components[2].size());
+  EXPECT_EQ(1u, call_graph->GetFunctionsInTopologicalOrder()[0]);
+
+  EXPECT_TRUE(call_graph->HasRecursion());
+  EXPECT_FALSE(call_graph->IsRecursive(context->GetFunction(1)));
+  EXPECT_FALSE(call_graph->IsRecursive(context->GetFunction(2)));
+  EXPECT_TRUE(call_graph->IsRecursive(context->GetFunction(3)));
+  EXPECT_TRUE(context->GetFunction(4)->IsRecursive());
+}
+
+TEST(CallGraphTest, FollowsTheRemovalOfCalls) {
+  std::unique_ptr<IRContext> context = BuildContext();
+  ASSERT_NE(nullptr, context);
+  CallGraph* call_graph = context->GetCallGraph();
+  ASSERT_TRUE(call_graph->HasRecursion());
+
+  context->KillInst(context->get_def_use_mgr()->GetDef(41));
+  ASSERT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisCallGraph));
+  EXPECT_THAT(call_graph->GetCallees(context->GetFunction(4)), ElementsAre());
+  EXPECT_THAT(call_graph->GetCallers(3), ElementsAre(1, 2));
+  EXPECT_FALSE(call_graph->HasRecursion());
+
+  // Removing one of two calls to the same function keeps the edge.
+  context->KillInst(context->get_def_use_mgr()->GetDef(12));
+  EXPECT_THAT(call_graph->GetCallees(context->GetFunction(1)),
+              ElementsAre(3, 2));
+  EXPECT_TRUE(context->IsConsistent());
+}
+
+TEST(CallGraphTest, FollowsTheAdditionOfCalls) {
+  std::unique_ptr<IRContext> context = BuildContext();
+  ASSERT_NE(nullptr, context);
+  CallGraph* call_graph = context->GetCallGraph();
+
+  Function* function = context->GetFunction(2);
+  BasicBlock* block = &*function->begin();
+  InstructionBuilder builder(context.get(), &*block->tail(),
+                             IRContext::kAnalysisDefUse |
+                                 IRContext::kAnalysisInstrToBlockMapping);
+  builder.AddFunctionCall(5, 4, {});
+  ASSERT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisCallGraph));
+  EXPECT_THAT(call_graph->GetCallees(function), ElementsAre(3, 4));
+  EXPECT_THAT(call_graph->GetCallers(4), ElementsAre(2, 3));
+  EXPECT_TRUE(context->IsConsistent());
+}
+
+TEST(CallGraphTest, FollowsTheRemovalOfFunctions) {
+  std::unique_ptr<IRContext> context = BuildContext();
+  ASSERT_NE(nullptr, context);
+  CallGraph* call_graph = context->GetCallGraph();
+
+  // Remove the calls to %2, and then %2 itself.
+  context->KillInst(context->get_def_use_mgr()->GetDef(12));
+  context->KillInst(context->get_def_use_mgr()->GetDef(13));
+  for (auto iter = context->module()->begin(); iter != context->module()->end();
+       ++iter) {
+    if (iter->result_id() == 2) {
+      context->KillInst(&iter->DefInst());
+      iter.Erase();
+      break;
+    }
+  }
+  EXPECT_THAT(call_graph->GetCallees(context->GetFunction(1)), ElementsAre(3));
+  EXPECT_THAT(call_graph->GetCallers(3), ElementsAre(1, 4));
+  EXPECT_THAT(call_graph->GetCallers(2), ElementsAre());
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
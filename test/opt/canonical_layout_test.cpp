@@ -0,0 +1,177 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+class CanonicalLayoutTest : public PassTest<::testing::Test> {
+ protected:
+  void SetUp() override {
+    SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+    SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER);
+  }
+};
+
+TEST_F(CanonicalLayoutTest, PutsCalleesBeforeTheirCallers) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %10 "main"
+OpExecutionMode %10 OriginUpperLeft
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%10 = OpFunction %1 None %2
+%11 = OpLabel
+%12 = OpFunctionCall %1 %20
+OpReturn
+OpFunctionEnd
+%20 = OpFunction %1 None %2
+%21 = OpLabel
+%22 = OpFunctionCall %1 %30
+OpReturn
+OpFunctionEnd
+%30 = OpFunction %1 None %2
+%31 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  // The ids are numbered in the order of their definitions, so the entry
+  // point does not get the first id.
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %8 "main"
+OpExecutionMode %8 OriginUpperLeft
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpReturn
+OpFunctionEnd
+%5 = OpFunction %1 None %2
+%6 = OpLabel
+%7 = OpFunctionCall %1 %3
+OpReturn
+OpFunctionEnd
+%8 = OpFunction %1 None %2
+%9 = OpLabel
+%10 = OpFunctionCall %1 %5
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<CanonicalLayoutPass>(before, after, false, true);
+}
+
+TEST_F(CanonicalLayoutTest, KeepsDeclarationsFirst) {
+  const std::string before = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %20 LinkageAttributes "f" Import
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%20 = OpFunction %1 None %2
+OpFunctionEnd
+%10 = OpFunction %1 None %2
+%11 = OpLabel
+%12 = OpFunctionCall %1 %20
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %3 LinkageAttributes "f" Import
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+OpFunctionEnd
+%4 = OpFunction %1 None %2
+%5 = OpLabel
+%6 = OpFunctionCall %1 %3
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<CanonicalLayoutPass>(before, after, false, true);
+}
+
+TEST_F(CanonicalLayoutTest, PutsBlocksInStructuredOrder) {
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %10 "main"
+OpExecutionMode %10 OriginUpperLeft
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%10 = OpFunction %1 None %2
+%11 = OpLabel
+OpBranch %13
+%15 = OpLabel
+OpBranch %12
+%13 = OpLabel
+OpBranch %12
+%12 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  // The unreachable block stays, after the reachable ones.
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %3 "main"
+OpExecutionMode %3 OriginUpperLeft
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpBranch %5
+%5 = OpLabel
+OpBranch %6
+%6 = OpLabel
+OpReturn
+%7 = OpLabel
+OpBranch %6
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<CanonicalLayoutPass>(before, after, false, true);
+}
+
+TEST_F(CanonicalLayoutTest, LeavesCanonicalModuleUnchanged) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %3 "main"
+OpExecutionMode %3 OriginUpperLeft
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpBranch %5
+%5 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<CanonicalLayoutPass>(text, text, false, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -16,6 +16,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "source/opt/cfg_snapshot.h"
 #include "source/opt/ir_context.h"
 #include "test/opt/pass_fixture.h"
 #include "test/opt/pass_utils.h"
@@ -25,6 +26,7 @@ namespace opt {
 namespace {
 
 using ::testing::ContainerEq;
+using ::testing::ElementsAre;
 
 using CFGTest = PassTest<::testing::Test>;
 
@@ -200,6 +202,103 @@ OpFunctionEnd
                            ContainerEq(expected_result2)));
 }
 
+TEST_F(CFGTest, RebuildFunctionForgetsRemovedBlocks) {
+  const std::string test = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%main = OpFunction %void None %4
+%8 = OpLabel
+OpSelectionMerge %10 None
+OpBranchConditional %true %9 %10
+%9 = OpLabel
+OpBranch %10
+%10 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, test,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  Function* function = &*context->module()->begin();
+  CFG cfg(context->module());
+  EXPECT_TRUE(cfg.HasBlock(9));
+
+  // Make %8 branch to %10, and delete %9.
+  BasicBlock* entry = &*function->begin();
+  entry->GetMergeInst()->ToNop();
+  entry->terminator()->SetOpcode(SpvOpBranch);
+  entry->terminator()->SetInOperands({{SPV_OPERAND_TYPE_ID, {10}}});
+  for (auto bi = function->begin(); bi != function->end(); ++bi) {
+    if (bi->id() == 9) {
+      bi.Erase();
+      break;
+    }
+  }
+
+  cfg.RebuildFunction(function);
+  EXPECT_FALSE(cfg.HasBlock(9));
+  EXPECT_TRUE(cfg.HasBlock(10));
+  EXPECT_THAT(cfg.preds(10), ElementsAre(8));
+}
+
+TEST_F(CFGTest, SnapshotNumbersBlocksInReversePostOrder) {
+  const std::string test = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Vertex %main "main"
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%main = OpFunction %void None %4
+%8 = OpLabel
+OpSelectionMerge %10 None
+OpBranchConditional %true %9 %10
+%11 = OpLabel
+OpBranch %10
+%9 = OpLabel
+OpBranch %10
+%10 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, test,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+
+  const CFGSnapshot snapshot(*context->module()->begin());
+  ASSERT_EQ(snapshot.size(), 4u);
+  EXPECT_EQ(snapshot.num_reachable(), 3u);
+
+  // The reachable blocks come first in reverse post-order, then the
+  // unreachable %11.
+  std::vector<uint32_t> ids;
+  for (uint32_t i = 0; i < snapshot.size(); ++i) {
+    EXPECT_EQ(snapshot.index(snapshot.block(i)->id()), i);
+    ids.push_back(snapshot.block(i)->id());
+  }
+  EXPECT_THAT(ids, ElementsAre(8, 9, 10, 11));
+  EXPECT_FALSE(snapshot.IsReachable(snapshot.index(11)));
+  EXPECT_EQ(snapshot.index(12), CFGSnapshot::kInvalidIndex);
+  EXPECT_EQ(snapshot.ReversePostOrder().size(), 3u);
+
+  EXPECT_THAT(snapshot.successors(0), ElementsAre(1, 2));
+  EXPECT_THAT(snapshot.successors(2), ElementsAre());
+  EXPECT_THAT(snapshot.successors(3), ElementsAre(2));
+  // The predecessors are in function order.
+  EXPECT_THAT(snapshot.predecessors(2), ElementsAre(0, 3, 1));
+  EXPECT_THAT(snapshot.predecessors(0), ElementsAre());
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
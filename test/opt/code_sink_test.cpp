@@ -552,6 +552,123 @@ TEST_F(CodeSinkTest, DecorationOnLoad) {
   EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
 }
 
+TEST_F(CodeSinkTest, MoveChainIntoSelection) {
+  // Each instruction of the chain is only used by the next one, so sinking the
+  // last one lets all of the others follow it in the same visit of the block.
+  const std::string text = R"(
+;CHECK: OpFunction
+;CHECK: OpLabel
+;CHECK-NEXT: OpSelectionMerge [[merge_bb:%\w+]]
+;CHECK-NEXT: OpBranchConditional %true [[bb:%\w+]] [[merge_bb]]
+;CHECK: [[bb]] = OpLabel
+;CHECK-NEXT: [[ac:%\w+]] = OpAccessChain
+;CHECK-NEXT: [[ld:%\w+]] = OpLoad %uint [[ac]]
+;CHECK-NEXT: [[add:%\w+]] = OpIAdd %uint [[ld]] [[ld]]
+;CHECK-NEXT: [[mul:%\w+]] = OpIMul %uint [[add]] [[add]]
+;CHECK-NEXT: OpCopyObject %uint [[mul]]
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+       %void = OpTypeVoid
+       %bool = OpTypeBool
+       %true = OpConstantTrue %bool
+       %uint = OpTypeInt 32 0
+     %uint_0 = OpConstant %uint 0
+     %uint_4 = OpConstant %uint 4
+%_arr_uint_uint_4 = OpTypeArray %uint %uint_4
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+%_ptr_Uniform__arr_uint_uint_4 = OpTypePointer Uniform %_arr_uint_uint_4
+         %11 = OpVariable %_ptr_Uniform__arr_uint_uint_4 Uniform
+         %12 = OpTypeFunction %void
+          %1 = OpFunction %void None %12
+         %13 = OpLabel
+         %14 = OpAccessChain %_ptr_Uniform_uint %11 %uint_0
+         %15 = OpLoad %uint %14
+         %19 = OpIAdd %uint %15 %15
+         %20 = OpIMul %uint %19 %19
+               OpSelectionMerge %16 None
+               OpBranchConditional %true %17 %16
+         %17 = OpLabel
+         %18 = OpCopyObject %uint %20
+               OpBranch %16
+         %16 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<CodeSinkingPass>(text, true);
+}
+
+// Returns a module in which a load from a buffer block is only used in one
+// branch of a selection.  |entry_code| is added to the entry block after the
+// load, and |other_branch_code| to the branch that does not use the load.
+std::string ModuleWithLoadFromBufferBlock(
+    const std::string& entry_code, const std::string& other_branch_code) {
+  return R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint GLCompute %1 "main"
+               OpDecorate %_arr_uint_uint_4 BufferBlock
+               OpMemberDecorate %_arr_uint_uint_4 0 Offset 0
+       %void = OpTypeVoid
+       %bool = OpTypeBool
+       %true = OpConstantTrue %bool
+       %uint = OpTypeInt 32 0
+     %uint_0 = OpConstant %uint 0
+     %uint_4 = OpConstant %uint 4
+%mem_semantics = OpConstant %uint 0x42 ; Uniform memeory arquire
+%_arr_uint_uint_4 = OpTypeStruct %uint
+%_ptr_Uniform_uint = OpTypePointer Uniform %uint
+%_ptr_Uniform__arr_uint_uint_4 = OpTypePointer Uniform %_arr_uint_uint_4
+         %11 = OpVariable %_ptr_Uniform__arr_uint_uint_4 Uniform
+         %12 = OpTypeFunction %void
+          %1 = OpFunction %void None %12
+         %13 = OpLabel
+         %14 = OpAccessChain %_ptr_Uniform_uint %11 %uint_0
+         %15 = OpLoad %uint %14
+)" + entry_code +
+         R"(
+               OpSelectionMerge %16 None
+               OpBranchConditional %true %17 %20
+         %20 = OpLabel
+)" + other_branch_code +
+         R"(
+               OpBranch %16
+         %17 = OpLabel
+         %18 = OpCopyObject %uint %15
+               OpBranch %16
+         %16 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+}
+
+TEST_F(CodeSinkTest, SamePassOnSeveralModules) {
+  // The pass remembers which variables may be stored to, and whether there is
+  // a uniform memory barrier, while it runs.  Running the same pass on another
+  // module must not reuse what it found in the previous one, even though the
+  // ids are the same.
+  const std::string sinkable = ModuleWithLoadFromBufferBlock("", "");
+  const std::string with_store =
+      ModuleWithLoadFromBufferBlock("", "OpStore %14 %uint_0");
+  const std::string with_sync = ModuleWithLoadFromBufferBlock(
+      "OpMemoryBarrier %uint_4 %mem_semantics", "");
+
+  CodeSinkingPass pass;
+  auto run = [&pass](const std::string& text) {
+    std::unique_ptr<IRContext> context =
+        BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                    SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+    EXPECT_NE(nullptr, context);
+    return pass.Run(context.get());
+  };
+  EXPECT_EQ(Pass::Status::SuccessWithChange, run(sinkable));
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, run(with_store));
+  EXPECT_EQ(Pass::Status::SuccessWithChange, run(sinkable));
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, run(with_sync));
+  EXPECT_EQ(Pass::Status::SuccessWithChange, run(sinkable));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -104,6 +104,44 @@ TEST_F(ConstantManagerTest, GetDefiningInstructionIdOverflow) {
   EXPECT_EQ(inst, nullptr);
 }
 
+TEST_F(ConstantManagerTest, MapInstsSharesEqualConstants) {
+  const std::string text = R"(
+%1 = OpTypeInt 32 0
+%2 = OpConstant %1 7
+%3 = OpConstant %1 7
+%4 = OpConstant %1 8
+%5 = OpTypeVector %1 2
+%6 = OpConstantComposite %5 %2 %4
+%7 = OpConstantComposite %5 %3 %4
+  )";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(context, nullptr);
+  ConstantManager* const_mgr = context->get_constant_mgr();
+
+  EXPECT_EQ(const_mgr->FindDeclaredConstant(2),
+            const_mgr->FindDeclaredConstant(3));
+  EXPECT_NE(const_mgr->FindDeclaredConstant(2),
+            const_mgr->FindDeclaredConstant(4));
+  EXPECT_EQ(const_mgr->FindDeclaredConstant(6),
+            const_mgr->FindDeclaredConstant(7));
+
+  // Mapping the same instructions again finds the pooled constants.
+  const Constant* vec = const_mgr->FindDeclaredConstant(6);
+  size_t hash = vec->HashValue();
+  const_mgr->MapInsts(context->module()->GetConstants());
+  EXPECT_EQ(const_mgr->FindDeclaredConstant(7), vec);
+  EXPECT_EQ(vec->HashValue(), hash);
+
+  Type* int_type = context->get_type_mgr()->GetType(1);
+  IntConstant seven(int_type->AsInteger(), {7});
+  EXPECT_EQ(seven.HashValue(), const_mgr->FindDeclaredConstant(2)->HashValue());
+  EXPECT_EQ(const_mgr->FindConstant(&seven),
+            const_mgr->FindDeclaredConstant(2));
+}
+
 }  // namespace
 }  // namespace analysis
 }  // namespace opt
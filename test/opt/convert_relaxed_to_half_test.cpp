@@ -418,32 +418,30 @@ OpFunctionEnd
 %47 = OpAccessChain %_ptr_Uniform_float %_ %int_0
 %10 = OpLoad %float %47
 %55 = OpFConvert %half %10
-%56 = OpFConvert %half %float_0_100000001
-%14 = OpFAdd %half %55 %56
+%14 = OpFAdd %half %55 %54
 %16 = OpCompositeConstruct %v2half %13 %14
-%58 = OpFConvert %float %14
-%18 = OpImageSampleDrefImplicitLod %float %46 %16 %58
+%57 = OpFConvert %float %14
+%18 = OpImageSampleDrefImplicitLod %float %46 %16 %57
 %48 = OpLoad %27 %g_tTex1df4
 %49 = OpLoad %29 %g_sSamp
 %50 = OpSampledImage %31 %48 %49
-%59 = OpFConvert %half %12
-%60 = OpFConvert %half %float_0_200000003
-%15 = OpFMul %half %59 %60
+%58 = OpFConvert %half %12
+%59 = OpFConvert %half %float_0_200000003
+%15 = OpFMul %half %58 %59
 %51 = OpAccessChain %_ptr_Uniform_float %_ %int_1
 %17 = OpLoad %float %51
-%61 = OpFConvert %half %17
-%62 = OpFConvert %half %float_0_200000003
-%19 = OpFAdd %half %61 %62
+%60 = OpFConvert %half %17
+%19 = OpFAdd %half %60 %59
 %20 = OpCompositeConstruct %v2half %15 %19
-%63 = OpFConvert %float %19
-%21 = OpImageSampleDrefImplicitLod %float %50 %20 %63
-%64 = OpFConvert %half %18
-%65 = OpFConvert %half %21
-%22 = OpFAdd %half %64 %65
-%66 = OpFConvert %half %float_0_5
-%23 = OpFMul %half %22 %66
-%67 = OpFConvert %float %23
-OpStore %_entryPointOutput_Color %67
+%61 = OpFConvert %float %19
+%21 = OpImageSampleDrefImplicitLod %float %50 %20 %61
+%62 = OpFConvert %half %18
+%63 = OpFConvert %half %21
+%22 = OpFAdd %half %62 %63
+%64 = OpFConvert %half %float_0_5
+%23 = OpFMul %half %22 %64
+%65 = OpFConvert %float %23
+OpStore %_entryPointOutput_Color %65
 OpReturn
 OpFunctionEnd
 )";
@@ -1200,19 +1198,16 @@ OpFunctionEnd
 %82 = OpImageSampleImplicitLod %v4float %79 %65
 %97 = OpFConvert %v4half %82
 %84 = OpCompositeExtract %half %97 1
-%98 = OpFConvert %v4half %82
-%86 = OpCompositeExtract %half %98 2
-%99 = OpFConvert %v4half %82
-%88 = OpCompositeExtract %half %99 0
-%100 = OpFConvert %v4half %82
-%90 = OpCompositeExtract %half %100 3
+%86 = OpCompositeExtract %half %97 2
+%88 = OpCompositeExtract %half %97 0
+%90 = OpCompositeExtract %half %97 3
 %91 = OpCompositeConstruct %v4half %84 %86 %88 %90
 %92 = OpAccessChain %_ptr_Uniform_float %_ %int_0
 %93 = OpLoad %float %92
-%101 = OpFConvert %half %93
-%94 = OpVectorTimesScalar %v4half %91 %101
-%102 = OpFConvert %v4float %94
-OpStore %_entryPointOutput_Color %102
+%98 = OpFConvert %half %93
+%94 = OpVectorTimesScalar %v4half %91 %98
+%99 = OpFConvert %v4float %94
+OpStore %_entryPointOutput_Color %99
 OpReturn
 OpFunctionEnd
 )";
@@ -1298,19 +1293,19 @@ OpDecorate %42 RelaxedPrecision
 %34 = OpLoad %v3float %foo
 %36 = OpLoad %mat2v2float %bar
 ; CHECK: %48 = OpFConvert %v3half %34
-; CHECK: %49 = OpFConvert %v3half %34
+; CHECK-NOT: OpFConvert %v3half %34
 %41 = OpVectorShuffle %v2float %34 %34 0 1
 ; CHECK-NOT: %41 = OpVectorShuffle %v2float %34 %34 0 1
-; CHECK: %41 = OpVectorShuffle %v2half %48 %49 0 1
+; CHECK: %41 = OpVectorShuffle %v2half %48 %48 0 1
 %42 = OpMatrixTimesVector %v2float %36 %41
 ; CHECK-NOT: %42 = OpMatrixTimesVector %v2float %36 %41
-; CHECK: %55 = OpCompositeExtract %v2float %36 0
-; CHECK: %56 = OpFConvert %v2half %55
-; CHECK: %57 = OpCompositeExtract %v2float %36 1
-; CHECK: %58 = OpFConvert %v2half %57
-; CHECK: %59 = OpCompositeConstruct %mat2v2half %56 %58
-; CHECK: %52 = OpCopyObject %mat2v2float %36
-; CHECK: %42 = OpMatrixTimesVector %v2half %59 %41
+; CHECK: %54 = OpCompositeExtract %v2float %36 0
+; CHECK: %55 = OpFConvert %v2half %54
+; CHECK: %56 = OpCompositeExtract %v2float %36 1
+; CHECK: %57 = OpFConvert %v2half %56
+; CHECK: %58 = OpCompositeConstruct %mat2v2half %55 %57
+; CHECK: %51 = OpCopyObject %mat2v2float %36
+; CHECK: %42 = OpMatrixTimesVector %v2half %58 %41
 %43 = OpCompositeExtract %float %42 0
 %44 = OpCompositeExtract %float %42 1
 ; CHECK-NOT: %43 = OpCompositeExtract %float %42 0
@@ -1319,9 +1314,9 @@ OpDecorate %42 RelaxedPrecision
 ; CHECK: %44 = OpCompositeExtract %half %42 1
 %45 = OpCompositeConstruct %v3float %43 %44 %float_1
 ; CHECK-NOT: %45 = OpCompositeConstruct %v3float %43 %44 %float_1
-; CHECK: %53 = OpFConvert %float %43
-; CHECK: %54 = OpFConvert %float %44
-; CHECK: %45 = OpCompositeConstruct %v3float %53 %54 %float_1
+; CHECK: %52 = OpFConvert %float %43
+; CHECK: %53 = OpFConvert %float %44
+; CHECK: %45 = OpCompositeConstruct %v3float %52 %53 %float_1
 OpStore %res %45
 OpReturn
 OpFunctionEnd
@@ -1814,6 +1814,84 @@ OpFunctionEnd
   SinglePassRunAndMatch<CopyPropagateArrays>(before, false);
 }
 
+TEST_F(CopyPropArrayPassTest, PropagateSameArrayToTwoVariables) {
+  // The memory object of the construct is found for the first variable, and
+  // found again once the uses of the first variable have been rewritten.
+  const std::string before =
+      R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in_var_INDEX %out_var_SV_Target
+OpExecutionMode %main OriginUpperLeft
+OpSource HLSL 600
+OpDecorate %_arr_v4float_uint_4 ArrayStride 16
+OpMemberDecorate %type_MyCBuffer 0 Offset 0
+OpDecorate %type_MyCBuffer Block
+OpDecorate %in_var_INDEX Flat
+OpDecorate %in_var_INDEX Location 0
+OpDecorate %out_var_SV_Target Location 0
+OpDecorate %MyCBuffer DescriptorSet 0
+OpDecorate %MyCBuffer Binding 0
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%_arr_v4float_uint_4 = OpTypeArray %v4float %uint_4
+%type_MyCBuffer = OpTypeStruct %_arr_v4float_uint_4
+%_ptr_Uniform_type_MyCBuffer = OpTypePointer Uniform %type_MyCBuffer
+%void = OpTypeVoid
+%13 = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%_arr_v4float_uint_4_0 = OpTypeArray %v4float %uint_4
+%_ptr_Function__arr_v4float_uint_4_0 = OpTypePointer Function %_arr_v4float_uint_4_0
+%int_0 = OpConstant %int 0
+%_ptr_Uniform__arr_v4float_uint_4 = OpTypePointer Uniform %_arr_v4float_uint_4
+%_ptr_Function_v4float = OpTypePointer Function %v4float
+%MyCBuffer = OpVariable %_ptr_Uniform_type_MyCBuffer Uniform
+%in_var_INDEX = OpVariable %_ptr_Input_int Input
+%out_var_SV_Target = OpVariable %_ptr_Output_v4float Output
+; CHECK: OpFunction
+; CHECK: %35 = OpCompositeConstruct
+; CHECK-NEXT: [[first:%\w+]] = OpAccessChain %_ptr_Uniform__arr_v4float_uint_4 %MyCBuffer %int_0
+; CHECK-NEXT: OpStore %23 %35
+; CHECK-NEXT: [[second:%\w+]] = OpAccessChain %_ptr_Uniform__arr_v4float_uint_4 %MyCBuffer %int_0
+; CHECK-NEXT: OpStore %40 %35
+; CHECK: [[element1:%\w+]] = OpAccessChain %_ptr_Uniform_v4float [[first]] %24
+; CHECK: OpLoad %v4float [[element1]]
+; CHECK: [[element2:%\w+]] = OpAccessChain %_ptr_Uniform_v4float [[second]] %24
+; CHECK: OpLoad %v4float [[element2]]
+%main = OpFunction %void None %13
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function__arr_v4float_uint_4_0 Function
+%40 = OpVariable %_ptr_Function__arr_v4float_uint_4_0 Function
+%24 = OpLoad %int %in_var_INDEX
+%25 = OpAccessChain %_ptr_Uniform__arr_v4float_uint_4 %MyCBuffer %int_0
+%26 = OpLoad %_arr_v4float_uint_4 %25
+%27 = OpCompositeExtract %v4float %26 0
+%28 = OpCompositeExtract %v4float %26 1
+%29 = OpCompositeExtract %v4float %26 2
+%30 = OpCompositeExtract %v4float %26 3
+%35 = OpCompositeConstruct %_arr_v4float_uint_4_0 %27 %28 %29 %30
+OpStore %23 %35
+OpStore %40 %35
+%36 = OpAccessChain %_ptr_Function_v4float %23 %24
+%37 = OpLoad %v4float %36
+%41 = OpAccessChain %_ptr_Function_v4float %40 %24
+%42 = OpLoad %v4float %41
+%43 = OpFAdd %v4float %37 %42
+OpStore %out_var_SV_Target %43
+OpReturn
+OpFunctionEnd
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SetDisassembleOptions(SPV_BINARY_TO_TEXT_OPTION_NO_HEADER |
+                        SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES);
+  SinglePassRunAndMatch<CopyPropagateArrays>(before, false);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
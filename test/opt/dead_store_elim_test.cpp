@@ -0,0 +1,187 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using DeadStoreElimTest = PassTest<::testing::Test>;
+
+// Returns a compute shader whose entry point declares the function scope
+// struct %s and starts with |body|.  %wg is a workgroup int and %priv a private
+// int.
+std::string Shader(const std::string& body) {
+  return R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %main "main"
+OpName %callee "callee"
+OpName %s "s"
+OpName %wg "wg"
+OpName %priv "priv"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%uint_2 = OpConstant %uint 2
+%uint_264 = OpConstant %uint 264
+%bool_undef = OpUndef %bool
+%struct = OpTypeStruct %int %int
+%_ptr_Function_struct = OpTypePointer Function %struct
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Workgroup_int = OpTypePointer Workgroup %int
+%_ptr_Private_int = OpTypePointer Private %int
+%wg = OpVariable %_ptr_Workgroup_int Workgroup
+%priv = OpVariable %_ptr_Private_int Private
+%callee = OpFunction %void None %void_fn
+%callee_entry = OpLabel
+OpReturn
+OpFunctionEnd
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%s = OpVariable %_ptr_Function_struct Function
+)" + body +
+         "OpFunctionEnd\n";
+}
+
+TEST_F(DeadStoreElimTest, ForwardsStoreThroughAccessChainAcrossBlocks) {
+  const std::string check = R"(
+; CHECK: [[s0:%\w+]] = OpAccessChain %_ptr_Function_int %s %int_0
+; CHECK: OpStore [[s0]] %int_2
+; CHECK: OpLabel
+; CHECK: OpStore {{%\w+}} %int_1
+; CHECK: OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpStore %wg %int_2
+)";
+  const std::string body = R"(%s0 = OpAccessChain %_ptr_Function_int %s %int_0
+%s1 = OpAccessChain %_ptr_Function_int %s %int_1
+OpStore %s0 %int_2
+OpSelectionMerge %merge None
+OpBranchConditional %bool_undef %then %merge
+%then = OpLabel
+OpStore %s1 %int_1
+OpBranch %merge
+%merge = OpLabel
+%s0_again = OpAccessChain %_ptr_Function_int %s %int_0
+%x = OpLoad %int %s0_again
+OpStore %wg %x
+%y = OpLoad %int %s1
+OpStore %priv %y
+OpReturn
+)";
+  SinglePassRunAndMatch<DeadStoreElimPass>(check + Shader(body), true);
+}
+
+TEST_F(DeadStoreElimTest, ForwardsLoadToLoad) {
+  const std::string check = R"(
+; CHECK: [[x:%\w+]] = OpLoad %int %priv
+; CHECK-NOT: OpLoad
+; CHECK: [[sum:%\w+]] = OpIAdd %int [[x]] [[x]]
+; CHECK: OpStore %wg [[sum]]
+)";
+  const std::string body = R"(%x = OpLoad %int %priv
+OpStore %wg %x
+OpBranch %next
+%next = OpLabel
+%y = OpLoad %int %priv
+%sum = OpIAdd %int %x %y
+OpStore %wg %sum
+OpReturn
+)";
+  SinglePassRunAndMatch<DeadStoreElimPass>(check + Shader(body), true);
+}
+
+TEST_F(DeadStoreElimTest, RemovesOverwrittenWorkgroupStore) {
+  const std::string check = R"(
+; CHECK: OpLabel
+; CHECK-NOT: OpStore %wg %int_1
+; CHECK: OpStore %priv %int_0
+; CHECK: OpLabel
+; CHECK: OpStore %wg %int_2
+)";
+  const std::string body = R"(OpStore %wg %int_1
+OpSelectionMerge %merge None
+OpBranchConditional %bool_undef %then %merge
+%then = OpLabel
+OpStore %priv %int_0
+OpBranch %merge
+%merge = OpLabel
+OpStore %wg %int_2
+OpReturn
+)";
+  SinglePassRunAndMatch<DeadStoreElimPass>(check + Shader(body), true);
+}
+
+TEST_F(DeadStoreElimTest, KeepsStoreReadOnOnePath) {
+  const std::string text = Shader(R"(OpStore %wg %int_1
+OpSelectionMerge %merge None
+OpBranchConditional %bool_undef %then %merge
+%then = OpLabel
+%x = OpLoad %int %wg Volatile
+OpStore %priv %x
+OpBranch %merge
+%merge = OpLabel
+OpStore %wg %int_2
+OpReturn
+)");
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(DeadStoreElimTest, RemovesLocalStoreNeverRead) {
+  const std::string check = R"(
+; CHECK: OpLabel
+; CHECK-NOT: OpStore {{%\w+}} %int_2
+; CHECK: OpStore %priv %int_1
+; CHECK-NEXT: OpReturn
+)";
+  const std::string body = R"(%s0 = OpAccessChain %_ptr_Function_int %s %int_0
+OpStore %s0 %int_2
+OpStore %priv %int_1
+OpReturn
+)";
+  SinglePassRunAndMatch<DeadStoreElimPass>(check + Shader(body), true);
+}
+
+TEST_F(DeadStoreElimTest, CallsAndBarriersBlockForwarding) {
+  const std::string text = Shader(R"(OpStore %priv %int_1
+%call = OpFunctionCall %void %callee
+%x = OpLoad %int %priv
+OpStore %wg %int_1
+OpControlBarrier %uint_2 %uint_2 %uint_264
+%y = OpLoad %int %wg
+%sum = OpIAdd %int %x %y
+OpStore %priv %sum
+OpReturn
+)");
+  auto result = SinglePassRunAndDisassemble<DeadStoreElimPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
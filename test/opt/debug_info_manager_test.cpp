@@ -152,12 +152,7 @@ void main(float in_var_color : COLOR) {
   EXPECT_EQ(inlined_at->NumOperands(), kDebugInlinedAtOperandScopeIndex + 1);
 
   const uint32_t line_number = 77U;
-  Instruction line(context.get(), SpvOpLine);
-  line.SetInOperands({
-      {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {5U}},
-      {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {line_number}},
-      {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {0U}},
-  });
+  const DebugLine line{5U, line_number, 0U};
 
   inlined_at_id = manager.CreateDebugInlinedAt(&line, scope);
   inlined_at = manager.GetDebugInlinedAt(inlined_at_id);
@@ -609,6 +604,91 @@ void main(float in_var_color : COLOR) {
   EXPECT_FALSE(dbg_info_mgr->IsVariableDebugDeclared(100));
 }
 
+TEST(DebugInfoManager, ReplaceDebugScopeUses) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "OpenCL.DebugInfo.100"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main" %in_var_COLOR
+               OpExecutionMode %main OriginUpperLeft
+          %5 = OpString "ps.hlsl"
+         %14 = OpString "#line 1 \"ps.hlsl\"
+void main(float in_var_color : COLOR) {
+  float color = in_var_color;
+}
+"
+         %17 = OpString "float"
+         %21 = OpString "main"
+               OpName %in_var_COLOR "in.var.COLOR"
+               OpName %main "main"
+               OpDecorate %in_var_COLOR Location 0
+       %uint = OpTypeInt 32 0
+    %uint_32 = OpConstant %uint 32
+      %float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+       %void = OpTypeVoid
+         %27 = OpTypeFunction %void
+%in_var_COLOR = OpVariable %_ptr_Input_float Input
+         %15 = OpExtInst %void %1 DebugSource %5 %14
+         %16 = OpExtInst %void %1 DebugCompilationUnit 1 4 %15 HLSL
+         %18 = OpExtInst %void %1 DebugTypeBasic %17 %uint_32 Float
+         %20 = OpExtInst %void %1 DebugTypeFunction FlagIsProtected|FlagIsPrivate %18 %18
+         %22 = OpExtInst %void %1 DebugFunction %21 %20 %15 1 1 %16 %21 FlagIsProtected|FlagIsPrivate 1 %main
+         %23 = OpExtInst %void %1 DebugLexicalBlock %15 1 1 %22
+       %main = OpFunction %void None %27
+         %28 = OpLabel
+         %29 = OpExtInst %void %1 DebugScope %22
+         %31 = OpLoad %float %in_var_COLOR
+         %32 = OpLoad %float %in_var_COLOR
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  auto* dbg_info_mgr = context->get_debug_info_mgr();
+  auto* def_use_mgr = context->get_def_use_mgr();
+
+  // Replacing an id that is not a debug instruction leaves scopes alone.
+  context->ReplaceAllUsesWith(31, 32);
+  EXPECT_EQ(def_use_mgr->GetDef(32)->GetDebugScope().GetLexicalScope(), 22);
+
+  dbg_info_mgr->ReplaceAllUsesInDebugScopeWithPredicate(
+      22, 23, [](Instruction* inst) { return inst->result_id() == 31; });
+  EXPECT_EQ(def_use_mgr->GetDef(31)->GetDebugScope().GetLexicalScope(), 23);
+  EXPECT_EQ(def_use_mgr->GetDef(32)->GetDebugScope().GetLexicalScope(), 22);
+}
+
+TEST(DebugInfoManager, NoDebugInfoSection) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "OpenCL.DebugInfo.100"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+       %main = OpFunction %void None %3
+          %4 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  auto* dbg_info_mgr = context->get_debug_info_mgr();
+
+  EXPECT_EQ(dbg_info_mgr->GetDebugFunction(2), nullptr);
+  EXPECT_FALSE(dbg_info_mgr->IsVariableDebugDeclared(4));
+
+  // Debug instructions created later are still tracked.
+  Instruction* none = dbg_info_mgr->GetDebugInfoNone();
+  ASSERT_NE(none, nullptr);
+  EXPECT_EQ(dbg_info_mgr->GetDebugInfoNone(), none);
+}
+
 }  // namespace
 }  // namespace analysis
 }  // namespace opt
@@ -1504,6 +1504,59 @@ OpDecorateString %1 HlslSemanticGOOGLE "hello"
   EXPECT_FALSE(decoManager->HaveSubsetOfDecorations(1u, 2u));
   EXPECT_TRUE(decoManager->HaveSubsetOfDecorations(2u, 1u));
 }
+
+TEST_F(DecorationManagerTest, WhileEachDecorationThroughGroup) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Location 1
+OpDecorate %2 Restrict
+OpDecorate %2 Location 2
+%2 = OpDecorationGroup
+OpGroupDecorate %2 %1
+%uint = OpTypeInt 32 0
+%ptr = OpTypePointer Input %uint
+%1 = OpVariable %ptr Input
+)";
+  DecorationManager* decoManager = GetDecorationManager(spirv);
+  EXPECT_THAT(GetErrorMessage(), "");
+
+  std::vector<uint32_t> locations;
+  EXPECT_TRUE(decoManager->WhileEachDecoration(
+      1u, SpvDecorationLocation, [&locations](const Instruction& inst) {
+        locations.push_back(inst.GetSingleWordInOperand(2u));
+        return true;
+      }));
+  EXPECT_THAT(locations, std::vector<uint32_t>({1u, 2u}));
+
+  locations.clear();
+  EXPECT_FALSE(decoManager->WhileEachDecoration(
+      1u, SpvDecorationLocation, [&locations](const Instruction& inst) {
+        locations.push_back(inst.GetSingleWordInOperand(2u));
+        return false;
+      }));
+  EXPECT_THAT(locations, std::vector<uint32_t>({1u}));
+
+  EXPECT_TRUE(decoManager->WhileEachDecoration(
+      3u, SpvDecorationLocation, [](const Instruction&) { return false; }));
+}
+
+TEST_F(DecorationManagerTest, HaveTheSameDecorationsUndecoratedIds) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Restrict
+)";
+  DecorationManager* decoManager = GetDecorationManager(spirv);
+  EXPECT_THAT(GetErrorMessage(), "");
+  EXPECT_TRUE(decoManager->HaveTheSameDecorations(2u, 3u));
+  EXPECT_TRUE(decoManager->HaveTheSameDecorations(1u, 1u));
+  EXPECT_FALSE(decoManager->HaveTheSameDecorations(1u, 2u));
+  EXPECT_FALSE(decoManager->HaveTheSameDecorations(2u, 1u));
+}
+
 }  // namespace
 }  // namespace analysis
 }  // namespace opt
@@ -1711,6 +1711,50 @@ TEST_F(UpdateUsesTest, KeepOldUses) {
   UserEntry entry = {def, use};
   EXPECT_THAT(users, Contains(entry));
 }
+
+TEST_F(UpdateUsesTest, UsersVisitedInOrderWhileBeingRemoved) {
+  const std::vector<const char*> text = {
+      // clang-format off
+      "OpCapability Shader",
+      "OpMemoryModel Logical GLSL450",
+      "OpEntryPoint Vertex %main \"main\"",
+      "%void = OpTypeVoid",
+      "%4 = OpTypeFunction %void",
+      "%uint = OpTypeInt 32 0",
+      "%uint_5 = OpConstant %uint 5",
+      "%main = OpFunction %void None %4",
+      "%8 = OpLabel",
+      "%9 = OpIAdd %uint %uint_5 %uint_5",
+      "%10 = OpIAdd %uint %uint_5 %uint_5",
+      "%11 = OpIAdd %uint %uint_5 %uint_5",
+      "%12 = OpIAdd %uint %uint_5 %uint_5",
+      "OpReturn",
+      "OpFunctionEnd"
+      // clang-format on
+  };
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, JoinAllInsts(text),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+
+  DefUseManager* def_use_mgr = context->get_def_use_mgr();
+  Instruction* constant =
+      def_use_mgr->GetDef(def_use_mgr->GetDef(9)->GetSingleWordInOperand(0));
+  EXPECT_EQ(4u, def_use_mgr->NumUsers(constant));
+  EXPECT_EQ(8u, def_use_mgr->NumUses(constant));
+
+  // Removing users while iterating must neither skip nor repeat users.
+  std::vector<uint32_t> visited;
+  def_use_mgr->ForEachUser(constant,
+                           [&visited, def_use_mgr](Instruction* user) {
+                             visited.push_back(user->result_id());
+                             def_use_mgr->ClearInst(user);
+                           });
+  EXPECT_THAT(visited, ::testing::ElementsAre(9, 10, 11, 12));
+  EXPECT_EQ(0u, def_use_mgr->NumUsers(constant));
+}
+
 // clang-format on
 
 }  // namespace
@@ -254,6 +254,57 @@ TEST_F(DescriptorScalarReplacementTest, ExpandArrayOfSamplers) {
   SinglePassRunAndMatch<DescriptorScalarReplacement>(text, true);
 }
 
+TEST_F(DescriptorScalarReplacementTest, ReplacementBindingsDoNotCollide) {
+  // The second element of the array would take the binding of %MySampler, so
+  // it gets the next free binding instead.  The third element is never
+  // accessed, so it is not replaced.
+  const std::string text = R"(
+; CHECK: OpDecorate %MySampler Binding 1
+; CHECK: OpDecorate [[var1:%\w+]] DescriptorSet 0
+; CHECK: OpDecorate [[var1]] Binding 0
+; CHECK: OpDecorate [[var2:%\w+]] DescriptorSet 0
+; CHECK: OpDecorate [[var2]] Binding 2
+; CHECK-NOT: OpDecorate {{%\w+}} Binding
+; CHECK: OpLoad {{%\w+}} [[var1]]
+; CHECK: OpLoad {{%\w+}} [[var2]]
+; CHECK: OpLoad {{%\w+}} %MySampler
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+               OpSource HLSL 600
+               OpName %MySampler "MySampler"
+               OpDecorate %MySamplers DescriptorSet 0
+               OpDecorate %MySamplers Binding 0
+               OpDecorate %MySampler DescriptorSet 0
+               OpDecorate %MySampler Binding 1
+        %int = OpTypeInt 32 1
+      %int_0 = OpConstant %int 0
+      %int_1 = OpConstant %int 1
+       %uint = OpTypeInt 32 0
+     %uint_3 = OpConstant %uint 3
+%type_sampler = OpTypeSampler
+%_arr_type_sampler_uint_3 = OpTypeArray %type_sampler %uint_3
+%_ptr_UniformConstant__arr_type_sampler_uint_3 = OpTypePointer UniformConstant %_arr_type_sampler_uint_3
+       %void = OpTypeVoid
+         %26 = OpTypeFunction %void
+%_ptr_UniformConstant_type_sampler = OpTypePointer UniformConstant %type_sampler
+ %MySamplers = OpVariable %_ptr_UniformConstant__arr_type_sampler_uint_3 UniformConstant
+  %MySampler = OpVariable %_ptr_UniformConstant_type_sampler UniformConstant
+       %main = OpFunction %void None %26
+         %28 = OpLabel
+         %31 = OpAccessChain %_ptr_UniformConstant_type_sampler %MySamplers %int_0
+         %32 = OpLoad %type_sampler %31
+         %35 = OpAccessChain %_ptr_UniformConstant_type_sampler %MySamplers %int_1
+         %36 = OpLoad %type_sampler %35
+         %37 = OpLoad %type_sampler %MySampler
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  SinglePassRunAndMatch<DescriptorScalarReplacement>(text, true);
+}
+
 TEST_F(DescriptorScalarReplacementTest, ExpandArrayOfSSBOs) {
   // Tests the expansion of an SSBO.  Also check that an access chain with more
   // than 1 index is correctly handled.
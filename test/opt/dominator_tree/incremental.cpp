@@ -0,0 +1,244 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/dominator_analysis.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// The body of the function is appended to this header.  %20 is true.
+const std::string kHeader = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%bool = OpTypeBool
+%20 = OpConstantTrue %bool
+%main = OpFunction %void None %fn
+)";
+
+std::unique_ptr<IRContext> Build(const std::string& body) {
+  return BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr,
+                     kHeader + body + "OpFunctionEnd\n",
+                     SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+}
+
+// Makes |bb| branch to |targets|, which must be one or two block ids, and
+// updates the CFG accordingly.
+void SetBranch(IRContext* context, BasicBlock* bb,
+               const std::vector<uint32_t>& targets) {
+  CFG* cfg = context->cfg();
+  cfg->RemoveSuccessorEdges(bb);
+  Instruction* branch = bb->terminator();
+  if (targets.size() == 1) {
+    branch->SetOpcode(SpvOpBranch);
+    branch->SetInOperands({{SPV_OPERAND_TYPE_ID, {targets[0]}}});
+  } else {
+    branch->SetOpcode(SpvOpBranchConditional);
+    branch->SetInOperands({{SPV_OPERAND_TYPE_ID, {20}},
+                           {SPV_OPERAND_TYPE_ID, {targets[0]}},
+                           {SPV_OPERAND_TYPE_ID, {targets[1]}}});
+  }
+  context->UpdateDefUse(branch);
+  cfg->AddEdges(bb);
+}
+
+// Checks that |analysis| describes the same tree as an analysis of |f| built
+// from scratch.
+void ExpectSameAsRebuilt(IRContext* context, const Function* f,
+                         const DominatorAnalysisBase& analysis) {
+  DominatorAnalysisBase rebuilt(analysis.IsPostDominator());
+  rebuilt.InitializeTree(*context->cfg(), f);
+  for (const BasicBlock& a : *f) {
+    EXPECT_EQ(rebuilt.IsReachable(&a), analysis.IsReachable(&a)) << a.id();
+    const BasicBlock* expected = rebuilt.ImmediateDominator(&a);
+    const BasicBlock* actual = analysis.ImmediateDominator(&a);
+    EXPECT_EQ(expected ? expected->id() : 0, actual ? actual->id() : 0)
+        << a.id();
+    for (const BasicBlock& b : *f) {
+      EXPECT_EQ(rebuilt.Dominates(&a, &b), analysis.Dominates(&a, &b))
+          << a.id() << " " << b.id();
+    }
+  }
+}
+
+TEST(IncrementalDominatorTest, InsertEdge) {
+  std::unique_ptr<IRContext> context = Build(R"(
+%5 = OpLabel
+OpBranch %6
+%6 = OpLabel
+OpBranch %7
+%7 = OpLabel
+OpBranch %8
+%8 = OpLabel
+OpReturn
+)");
+  Function* f = &*context->module()->begin();
+  DominatorAnalysis* dominators = context->GetDominatorAnalysis(f);
+  PostDominatorAnalysis* post_dominators =
+      context->GetPostDominatorAnalysis(f);
+  EXPECT_EQ(dominators->ImmediateDominator(8)->id(), 7u);
+
+  BasicBlock* from = context->cfg()->block(5);
+  BasicBlock* to = context->cfg()->block(8);
+  SetBranch(context.get(), from, {6, 8});
+  dominators->InsertEdge(*context->cfg(), f, from, to);
+  post_dominators->InsertEdge(*context->cfg(), f, from, to);
+
+  EXPECT_EQ(dominators->ImmediateDominator(8)->id(), 5u);
+  EXPECT_EQ(post_dominators->ImmediateDominator(5)->id(), 8u);
+  ExpectSameAsRebuilt(context.get(), f, *dominators);
+  ExpectSameAsRebuilt(context.get(), f, *post_dominators);
+}
+
+TEST(IncrementalDominatorTest, DeleteEdge) {
+  std::unique_ptr<IRContext> context = Build(R"(
+%5 = OpLabel
+OpBranchConditional %20 %6 %7
+%6 = OpLabel
+OpBranch %8
+%7 = OpLabel
+OpBranch %8
+%8 = OpLabel
+OpBranch %9
+%9 = OpLabel
+OpReturn
+)");
+  Function* f = &*context->module()->begin();
+  DominatorAnalysis* dominators = context->GetDominatorAnalysis(f);
+  PostDominatorAnalysis* post_dominators =
+      context->GetPostDominatorAnalysis(f);
+  EXPECT_EQ(dominators->ImmediateDominator(8)->id(), 5u);
+
+  BasicBlock* from = context->cfg()->block(5);
+  BasicBlock* to = context->cfg()->block(7);
+  SetBranch(context.get(), from, {6});
+  dominators->DeleteEdge(*context->cfg(), f, from, to);
+  post_dominators->DeleteEdge(*context->cfg(), f, from, to);
+
+  EXPECT_FALSE(dominators->IsReachable(7));
+  EXPECT_EQ(dominators->ImmediateDominator(8)->id(), 6u);
+  EXPECT_EQ(post_dominators->ImmediateDominator(5)->id(), 6u);
+  ExpectSameAsRebuilt(context.get(), f, *dominators);
+  ExpectSameAsRebuilt(context.get(), f, *post_dominators);
+}
+
+TEST(IncrementalDominatorTest, DeleteEdgeInLoop) {
+  // Removing the edge %7 -> %8 leaves %6 -> %8 as the only way to %8, which
+  // stays reachable through the loop.
+  std::unique_ptr<IRContext> context = Build(R"(
+%5 = OpLabel
+OpBranch %6
+%6 = OpLabel
+OpLoopMerge %9 %8 None
+OpBranchConditional %20 %7 %8
+%7 = OpLabel
+OpBranchConditional %20 %8 %9
+%8 = OpLabel
+OpBranch %6
+%9 = OpLabel
+OpReturn
+)");
+  Function* f = &*context->module()->begin();
+  DominatorAnalysis* dominators = context->GetDominatorAnalysis(f);
+  PostDominatorAnalysis* post_dominators =
+      context->GetPostDominatorAnalysis(f);
+
+  BasicBlock* from = context->cfg()->block(7);
+  BasicBlock* to = context->cfg()->block(8);
+  SetBranch(context.get(), from, {9});
+  dominators->DeleteEdge(*context->cfg(), f, from, to);
+  post_dominators->DeleteEdge(*context->cfg(), f, from, to);
+
+  EXPECT_EQ(post_dominators->ImmediateDominator(7)->id(), 9u);
+  ExpectSameAsRebuilt(context.get(), f, *dominators);
+  ExpectSameAsRebuilt(context.get(), f, *post_dominators);
+}
+
+TEST(IncrementalDominatorTest, SplitLoopHeaderKeepsTreesValid) {
+  std::unique_ptr<IRContext> context = Build(R"(
+%5 = OpLabel
+OpBranch %10
+%10 = OpLabel
+OpLoopMerge %12 %11 None
+OpBranchConditional %20 %11 %12
+%11 = OpLabel
+OpBranch %10
+%12 = OpLabel
+OpReturn
+)");
+  Function* f = &*context->module()->begin();
+  DominatorAnalysis* dominators = context->GetDominatorAnalysis(f);
+  PostDominatorAnalysis* post_dominators =
+      context->GetPostDominatorAnalysis(f);
+
+  BasicBlock* new_header =
+      context->cfg()->SplitLoopHeader(context->cfg()->block(10));
+  ASSERT_NE(new_header, nullptr);
+
+  EXPECT_EQ(dominators->ImmediateDominator(new_header)->id(), 10u);
+  EXPECT_EQ(dominators->ImmediateDominator(11), new_header);
+  EXPECT_EQ(post_dominators->ImmediateDominator(10), new_header);
+  EXPECT_EQ(post_dominators->ImmediateDominator(11), new_header);
+  ExpectSameAsRebuilt(context.get(), f, *dominators);
+  ExpectSameAsRebuilt(context.get(), f, *post_dominators);
+}
+
+TEST(IncrementalDominatorTest, MergeBlocks) {
+  std::unique_ptr<IRContext> context = Build(R"(
+%5 = OpLabel
+OpBranchConditional %20 %6 %8
+%6 = OpLabel
+OpBranch %7
+%7 = OpLabel
+OpBranch %8
+%8 = OpLabel
+OpReturn
+)");
+  Function* f = &*context->module()->begin();
+  DominatorAnalysis* dominators = context->GetDominatorAnalysis(f);
+  PostDominatorAnalysis* post_dominators =
+      context->GetPostDominatorAnalysis(f);
+
+  // Merge %7 into %6 by hand.
+  BasicBlock* block = context->cfg()->block(6);
+  BasicBlock* merged = context->cfg()->block(7);
+  dominators->MergeBlocks(block, merged);
+  post_dominators->MergeBlocks(block, merged);
+  SetBranch(context.get(), block, {8});
+  context->cfg()->RemoveSuccessorEdges(merged);
+  context->cfg()->ForgetBlock(merged);
+  context->KillInst(merged->terminator());
+  context->KillInst(merged->GetLabelInst());
+  f->RemoveEmptyBlocks();
+
+  EXPECT_EQ(dominators->ImmediateDominator(6)->id(), 5u);
+  EXPECT_EQ(post_dominators->ImmediateDominator(6)->id(), 8u);
+  ExpectSameAsRebuilt(context.get(), f, *dominators);
+  ExpectSameAsRebuilt(context.get(), f, *post_dominators);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
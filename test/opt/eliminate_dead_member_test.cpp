@@ -1184,4 +1184,108 @@ TEST_F(EliminateDeadMemberTest, UpdateSpecConstOpInsert) {
   SinglePassRunAndMatch<opt::EliminateDeadMembersPass>(text, true);
 }
 
+TEST_F(EliminateDeadMemberTest, KeepMembersOfSeveralStoredNestedStructs) {
+  // %type_inner is reached through the stores of both outer structs, and each
+  // of them is stored twice.  All of their members must be kept, even though
+  // the walk of %type_inner is only done once.  Only the members of
+  // %type_other that are not used are removed.
+  const std::string text = R"(
+; CHECK: %type_inner = OpTypeStruct %float %float
+; CHECK: %type_outerA = OpTypeStruct %type_inner %float
+; CHECK: %type_outerB = OpTypeStruct %float %type_inner
+; CHECK: %type_other = OpTypeStruct %float{{$}}
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Vertex %main "main"
+               OpSource HLSL 600
+               OpName %type_inner "type_inner"
+               OpName %type_outerA "type_outerA"
+               OpName %type_outerB "type_outerB"
+               OpName %type_other "type_other"
+               OpName %main "main"
+       %uint = OpTypeInt 32 0
+     %uint_0 = OpConstant %uint 0
+      %float = OpTypeFloat 32
+ %type_inner = OpTypeStruct %float %float
+%type_outerA = OpTypeStruct %type_inner %float
+%type_outerB = OpTypeStruct %float %type_inner
+ %type_other = OpTypeStruct %float %float %float
+%_ptr_Uniform_type_outerA = OpTypePointer Uniform %type_outerA
+%_ptr_Uniform_type_outerB = OpTypePointer Uniform %type_outerB
+%_ptr_Uniform_type_other = OpTypePointer Uniform %type_other
+%_ptr_Uniform_float = OpTypePointer Uniform %float
+       %void = OpTypeVoid
+          %9 = OpTypeFunction %void
+         %a1 = OpVariable %_ptr_Uniform_type_outerA Uniform
+         %a2 = OpVariable %_ptr_Uniform_type_outerA Uniform
+         %b1 = OpVariable %_ptr_Uniform_type_outerB Uniform
+         %b2 = OpVariable %_ptr_Uniform_type_outerB Uniform
+      %other = OpVariable %_ptr_Uniform_type_other Uniform
+       %main = OpFunction %void None %9
+         %10 = OpLabel
+         %11 = OpLoad %type_outerA %a1
+               OpStore %a2 %11
+         %12 = OpLoad %type_outerB %b1
+               OpStore %b2 %12
+               OpStore %a1 %11
+               OpStore %b1 %12
+         %13 = OpAccessChain %_ptr_Uniform_float %other %uint_0
+         %14 = OpLoad %float %13
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<opt::EliminateDeadMembersPass>(text, true);
+}
+
+// Returns a module with a struct of three members, of which only the first
+// one is used, unless the whole struct is stored because |store_struct|
+// holds.
+std::string ModuleWithStruct(bool store_struct) {
+  return std::string(R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Vertex %main "main"
+               OpSource HLSL 600
+       %uint = OpTypeInt 32 0
+     %uint_0 = OpConstant %uint 0
+      %float = OpTypeFloat 32
+%type__Globals = OpTypeStruct %float %float %float
+%_ptr_Uniform_type__Globals = OpTypePointer Uniform %type__Globals
+%_ptr_Uniform_float = OpTypePointer Uniform %float
+       %void = OpTypeVoid
+          %9 = OpTypeFunction %void
+   %_Globals = OpVariable %_ptr_Uniform_type__Globals Uniform
+  %_Globals2 = OpVariable %_ptr_Uniform_type__Globals Uniform
+       %main = OpFunction %void None %9
+         %10 = OpLabel
+         %11 = OpLoad %type__Globals %_Globals
+         %12 = OpAccessChain %_ptr_Uniform_float %_Globals %uint_0
+         %13 = OpLoad %float %12
+)") + (store_struct ? "OpStore %_Globals2 %11\n" : "") +
+         R"(
+               OpReturn
+               OpFunctionEnd
+)";
+}
+
+TEST_F(EliminateDeadMemberTest, SamePassOnSeveralModules) {
+  // The pass remembers which members are used, and which structs it has
+  // walked, while it runs.  Running the same pass on another module must not
+  // reuse what it found in the previous one, even though the ids are the same.
+  opt::EliminateDeadMembersPass pass;
+  auto run = [&pass](bool store_struct) {
+    std::unique_ptr<opt::IRContext> context =
+        BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr,
+                    ModuleWithStruct(store_struct),
+                    SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+    EXPECT_NE(nullptr, context);
+    return pass.Run(context.get());
+  };
+  EXPECT_EQ(opt::Pass::Status::SuccessWithoutChange, run(true));
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, run(false));
+  EXPECT_EQ(opt::Pass::Status::SuccessWithoutChange, run(true));
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, run(false));
+}
+
 }  // namespace
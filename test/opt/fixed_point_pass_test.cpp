@@ -0,0 +1,95 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/fixed_point_pass.h"
+#include "source/util/make_unique.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using FixedPointPassTest = PassTest<::testing::Test>;
+
+// A pass that appends an OpNop to the debug1 section until the section holds
+// |limit| instructions.
+class AppendOpNopUntilPass : public Pass {
+ public:
+  AppendOpNopUntilPass(uint32_t limit, uint32_t* num_runs)
+      : limit_(limit), num_runs_(num_runs) {}
+
+  const char* name() const override { return "AppendOpNopUntil"; }
+  Status Process() override {
+    ++*num_runs_;
+    uint32_t size = 0;
+    for (auto it = context()->debug1_begin(); it != context()->debug1_end();
+         ++it) {
+      ++size;
+    }
+    if (size >= limit_) return Status::SuccessWithoutChange;
+    context()->AddDebug1Inst(MakeUnique<Instruction>(context()));
+    return Status::SuccessWithChange;
+  }
+
+ private:
+  uint32_t limit_;
+  uint32_t* num_runs_;
+};
+
+FixedPointPass::PassGroupFactory AppendOpNopUntil(uint32_t limit,
+                                                  uint32_t* num_runs) {
+  return [limit, num_runs]() {
+    std::vector<std::unique_ptr<Pass>> passes;
+    passes.push_back(MakeUnique<AppendOpNopUntilPass>(limit, num_runs));
+    return passes;
+  };
+}
+
+TEST_F(FixedPointPassTest, RunsUntilNoChange) {
+  const std::string text = "OpMemoryModel Logical GLSL450\n";
+  uint32_t num_runs = 0;
+  SinglePassRunAndCheck<FixedPointPass>(
+      text, text + "OpNop\nOpNop\nOpNop\n",
+      /* skip_nop = */ false, AppendOpNopUntil(3, &num_runs),
+      /* max_iterations = */ 10);
+  // Three runs add an OpNop and the last does not change anything.
+  EXPECT_EQ(4u, num_runs);
+}
+
+TEST_F(FixedPointPassTest, StopsAfterMaxIterations) {
+  const std::string text = "OpMemoryModel Logical GLSL450\n";
+  uint32_t num_runs = 0;
+  SinglePassRunAndCheck<FixedPointPass>(
+      text, text + "OpNop\nOpNop\n",
+      /* skip_nop = */ false, AppendOpNopUntil(3, &num_runs),
+      /* max_iterations = */ 2);
+  EXPECT_EQ(2u, num_runs);
+}
+
+TEST_F(FixedPointPassTest, NoChange) {
+  const std::string text = "OpMemoryModel Logical GLSL450\nOpNop\n";
+  uint32_t num_runs = 0;
+  SinglePassRunAndCheck<FixedPointPass>(
+      text, text, /* skip_nop = */ false, AppendOpNopUntil(1, &num_runs),
+      /* max_iterations = */ 10);
+  EXPECT_EQ(1u, num_runs);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -79,6 +79,53 @@ TEST_F(FoldSpecConstantOpAndCompositePassBasicTest, Basic) {
       builder.GetCode(), JoinAllInsts(expected), /* skip_nop = */ true);
 }
 
+// Spec constants that depend on each other are all folded in a single run of
+// the pass.
+TEST_F(FoldSpecConstantOpAndCompositePassBasicTest, FoldsChainInOneRun) {
+  AssemblyBuilder builder;
+  builder.AppendTypesConstantsGlobals({
+      // clang-format off
+        "%int = OpTypeInt 32 1",
+        "%const_int = OpConstant %int 1",
+        "%spec_add = OpSpecConstantOp %int IAdd %const_int %const_int",
+        "%spec_mul = OpSpecConstantOp %int IMul %spec_add %spec_add",
+        "%spec_sub = OpSpecConstantOp %int ISub %spec_mul %const_int",
+      // clang-format on
+  });
+
+  std::vector<const char*> expected = {
+      // clang-format off
+                    "OpCapability Shader",
+                    "OpCapability Float64",
+               "%1 = OpExtInstImport \"GLSL.std.450\"",
+                    "OpMemoryModel Logical GLSL450",
+                    "OpEntryPoint Vertex %main \"main\"",
+                    "OpName %void \"void\"",
+                    "OpName %main_func_type \"main_func_type\"",
+                    "OpName %main \"main\"",
+                    "OpName %main_func_entry_block \"main_func_entry_block\"",
+                    "OpName %int \"int\"",
+                    "OpName %const_int \"const_int\"",
+                    "OpName %spec_add \"spec_add\"",
+                    "OpName %spec_mul \"spec_mul\"",
+                    "OpName %spec_sub \"spec_sub\"",
+            "%void = OpTypeVoid",
+  "%main_func_type = OpTypeFunction %void",
+             "%int = OpTypeInt 32 1",
+       "%const_int = OpConstant %int 1",
+        "%spec_add = OpConstant %int 2",
+        "%spec_mul = OpConstant %int 4",
+        "%spec_sub = OpConstant %int 3",
+            "%main = OpFunction %void None %main_func_type",
+"%main_func_entry_block = OpLabel",
+                    "OpReturn",
+                    "OpFunctionEnd",
+      // clang-format on
+  };
+  SinglePassRunAndCheck<FoldSpecConstantOpAndCompositePass>(
+      builder.GetCode(), JoinAllInsts(expected), /* skip_nop = */ true);
+}
+
 // A test of skipping folding an instruction when the instruction result type
 // has decorations.
 TEST_F(FoldSpecConstantOpAndCompositePassBasicTest,
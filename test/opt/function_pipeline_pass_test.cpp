@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/aggressive_dead_code_elim_pass.h"
+#include "source/opt/function_pipeline_pass.h"
+#include "source/util/make_unique.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using FunctionPipelinePassTest = PassTest<::testing::Test>;
+
+// A pass that appends "<tag><function id>" to |log| for each function of the
+// entry point call trees that it processes.
+class LogFunctionsPass : public Pass {
+ public:
+  LogFunctionsPass(std::string tag, std::vector<std::string>* log)
+      : tag_(std::move(tag)), log_(log) {}
+
+  const char* name() const override { return "LogFunctions"; }
+  Status Process() override {
+    ProcessFunction pfn = [this](Function* fn) {
+      log_->push_back(tag_ + std::to_string(fn->result_id()));
+      return false;
+    };
+    context()->ProcessEntryPointCallTree(pfn);
+    return Status::SuccessWithoutChange;
+  }
+
+ private:
+  std::string tag_;
+  std::vector<std::string>* log_;
+};
+
+const std::string kTwoFunctions = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+          %1 = OpFunction %void None %3
+          %4 = OpLabel
+          %5 = OpFunctionCall %void %6
+               OpReturn
+               OpFunctionEnd
+          %6 = OpFunction %void None %3
+          %7 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+TEST_F(FunctionPipelinePassTest, RunsAllPassesOnOneFunctionAtATime) {
+  std::vector<std::string> log;
+  auto create_passes = [&log]() {
+    std::vector<std::unique_ptr<Pass>> passes;
+    passes.push_back(MakeUnique<LogFunctionsPass>("a", &log));
+    passes.push_back(MakeUnique<LogFunctionsPass>("b", &log));
+    return passes;
+  };
+  SinglePassRunAndCheck<FunctionPipelinePass>(
+      kTwoFunctions, kTwoFunctions, /* skip_nop = */ false, create_passes);
+  EXPECT_THAT(log, ::testing::ElementsAre("a1", "b1", "a6", "b6"));
+}
+
+TEST_F(FunctionPipelinePassTest, LeavesDeadGlobalsToTheWholeModule) {
+  // ADCE removes the dead load in the function, but not the variable, since
+  // it only sees one function.
+  const std::string text = R"(
+; CHECK: %priv = OpVariable %_ptr_Private_float Private
+; CHECK: OpLabel
+; CHECK-NOT: OpLoad
+; CHECK: OpReturn
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+      %float = OpTypeFloat 32
+%_ptr_Private_float = OpTypePointer Private %float
+       %priv = OpVariable %_ptr_Private_float Private
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+          %6 = OpLoad %float %priv
+               OpReturn
+               OpFunctionEnd
+)";
+
+  auto create_passes = []() {
+    std::vector<std::unique_ptr<Pass>> passes;
+    passes.push_back(MakeUnique<AggressiveDCEPass>());
+    return passes;
+  };
+  SinglePassRunAndMatch<FunctionPipelinePass>(text, true, create_passes);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,244 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/function_result_cache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/aggressive_dead_code_elim_pass.h"
+#include "source/opt/build_module.h"
+#include "source/opt/compact_ids_pass.h"
+#include "source/opt/function_pipeline_pass.h"
+#include "source/opt/ir_context.h"
+#include "source/opt/local_single_store_elim_pass.h"
+#include "source/opt/ssa_rewrite_pass.h"
+#include "source/util/make_unique.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+const spv_target_env kEnv = SPV_ENV_UNIVERSAL_1_3;
+
+std::vector<std::unique_ptr<Pass>> CreatePasses() {
+  std::vector<std::unique_ptr<Pass>> passes;
+  passes.push_back(MakeUnique<LocalSingleStoreElimPass>());
+  passes.push_back(MakeUnique<AggressiveDCEPass>());
+  passes.push_back(MakeUnique<SSARewritePass>());
+  return passes;
+}
+
+// Runs the passes of |CreatePasses| one function at a time on |text|, with
+// |cache| if it is not nullptr.  Returns the disassembly of the result with
+// compacted ids, or "" if the result is invalid.
+std::string RunPipeline(const std::string& text, FunctionResultCache* cache) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(kEnv, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  EXPECT_NE(context, nullptr) << text;
+  if (context == nullptr) return "";
+  context->set_function_cache(cache);
+  FunctionPipelinePass pipeline(CreatePasses, "test");
+  EXPECT_NE(pipeline.Run(context.get()), Pass::Status::Failure);
+  CompactIdsPass compact_ids;
+  compact_ids.Run(context.get());
+
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, /* skip_nop = */ true);
+  SpirvTools tools(kEnv);
+  std::string disassembly;
+  if (!tools.Validate(binary) ||
+      !tools.Disassemble(binary, &disassembly,
+                         SPV_BINARY_TO_TEXT_OPTION_NO_HEADER)) {
+    return "";
+  }
+  return disassembly;
+}
+
+// The library functions shared by the modules below.  %count needs a phi in
+// SSA form, so its result has ids that are new to the function.
+const std::string kLibrary = R"(
+%helper = OpFunction %float None %fn_float
+%x = OpFunctionParameter %float
+%helper_entry = OpLabel
+%v = OpVariable %_ptr_Function_float Function
+OpStore %v %x
+%a = OpLoad %float %v
+%product = OpFMul %float %a %a
+OpReturnValue %product
+OpFunctionEnd
+%count = OpFunction %int None %fn_int
+%n = OpFunctionParameter %int
+%count_entry = OpLabel
+%i = OpVariable %_ptr_Function_int Function
+OpStore %i %int_0
+OpBranch %header
+%header = OpLabel
+OpLoopMerge %merge %continue None
+OpBranch %cond
+%cond = OpLabel
+%iv = OpLoad %int %i
+%lt = OpSLessThan %bool %iv %n
+OpBranchConditional %lt %body %merge
+%body = OpLabel
+OpBranch %continue
+%continue = OpLabel
+%iv2 = OpLoad %int %i
+%next = OpIAdd %int %iv2 %int_1
+OpStore %i %next
+OpBranch %header
+%merge = OpLabel
+%result = OpLoad %int %i
+OpReturnValue %result
+OpFunctionEnd
+)";
+
+const std::string kTypes = R"(
+%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%float = OpTypeFloat 32
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%float_2 = OpConstant %float 2
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Function_float = OpTypePointer Function %float
+%fn_void = OpTypeFunction %void
+%fn_int = OpTypeFunction %int %int
+%fn_float = OpTypeFunction %float %float
+)";
+
+// A module that calls both library functions.
+const std::string kFirstModule = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpName %product "product"
+)" + kTypes + R"(
+%main = OpFunction %void None %fn_void
+%main_entry = OpLabel
+%c = OpFunctionCall %int %count %int_1
+%h = OpFunctionCall %float %helper %float_2
+OpReturn
+OpFunctionEnd
+)" + kLibrary;
+
+// Another module with the same library functions, other declarations before
+// them, and another entry point, so that all ids are different.
+const std::string kSecondModule = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %other_main "other_main"
+OpExecutionMode %other_main LocalSize 8 1 1
+OpName %i "i"
+%uint = OpTypeInt 32 0
+%uint_7 = OpConstant %uint 7
+%_ptr_Function_uint = OpTypePointer Function %uint
+)" + kTypes + R"(
+%other_main = OpFunction %void None %fn_void
+%other_entry = OpLabel
+%u = OpVariable %_ptr_Function_uint Function
+OpStore %u %uint_7
+%h = OpFunctionCall %float %helper %float_2
+%c = OpFunctionCall %int %count %int_0
+OpReturn
+OpFunctionEnd
+)" + kLibrary;
+
+TEST(FunctionResultCacheTest, ReplaysFunctionsInAnotherModule) {
+  FunctionResultCache cache;
+  const std::string first = RunPipeline(kFirstModule, &cache);
+  EXPECT_EQ(first, RunPipeline(kFirstModule, nullptr));
+  EXPECT_EQ(cache.size(), 3u);
+  EXPECT_EQ(cache.num_hits(), 0u);
+  EXPECT_EQ(cache.num_misses(), 3u);
+
+  // The library functions are replayed, and the result is the same as if the
+  // passes had run on them.
+  const std::string second = RunPipeline(kSecondModule, &cache);
+  EXPECT_NE(second, "");
+  EXPECT_EQ(second, RunPipeline(kSecondModule, nullptr));
+  EXPECT_EQ(cache.size(), 4u);
+  EXPECT_EQ(cache.num_hits(), 2u);
+  EXPECT_EQ(cache.num_misses(), 4u);
+
+  // The variable of %count is gone, and so is its name.
+  EXPECT_THAT(second, ::testing::HasSubstr("OpPhi"));
+  EXPECT_THAT(second, ::testing::Not(::testing::HasSubstr("OpName")));
+}
+
+TEST(FunctionResultCacheTest, TellsDecorationsApart) {
+  FunctionResultCache cache;
+  RunPipeline(kFirstModule, &cache);
+  EXPECT_EQ(cache.size(), 3u);
+
+  // The same module with a decorated multiplication in %helper.
+  std::string decorated = kFirstModule;
+  const std::string name = "OpName %product \"product\"\n";
+  decorated.replace(decorated.find(name), name.size(),
+                    name + "OpDecorate %product RelaxedPrecision\n");
+  const std::string result = RunPipeline(decorated, &cache);
+  EXPECT_EQ(result, RunPipeline(decorated, nullptr));
+  EXPECT_EQ(cache.size(), 4u);
+  EXPECT_EQ(cache.num_hits(), 2u);
+}
+
+TEST(FunctionResultCacheTest, TellsReachableFunctionsApart) {
+  // The passes leave %helper alone when it is not called.
+  std::string uncalled = kFirstModule;
+  const std::string call = "%h = OpFunctionCall %float %helper %float_2\n";
+  uncalled.erase(uncalled.find(call), call.size());
+  FunctionResultCache cache;
+  const std::string result = RunPipeline(uncalled, &cache);
+  EXPECT_EQ(result, RunPipeline(uncalled, nullptr));
+  EXPECT_THAT(result, ::testing::HasSubstr("OpVariable"));
+  EXPECT_EQ(cache.size(), 3u);
+
+  // Once it is called, %helper is not the same function any more.  Only
+  // %count is replayed.
+  EXPECT_EQ(RunPipeline(kFirstModule, &cache),
+            RunPipeline(kFirstModule, nullptr));
+  EXPECT_EQ(cache.size(), 5u);
+  EXPECT_EQ(cache.num_hits(), 1u);
+}
+
+TEST(FunctionResultCacheTest, SkipsFunctionsWithDebugLines) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+%file = OpString "file.comp"
+%void = OpTypeVoid
+%fn_void = OpTypeFunction %void
+%main = OpFunction %void None %fn_void
+%entry = OpLabel
+OpLine %file 1 1
+OpReturn
+OpFunctionEnd
+)";
+  FunctionResultCache cache;
+  EXPECT_NE(RunPipeline(text, &cache), "");
+  EXPECT_EQ(cache.size(), 0u);
+  EXPECT_EQ(cache.num_misses(), 0u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -591,6 +591,86 @@ TEST_F(GraphicsRobustAccessTest, ACArrayGeneralClamped) {
   }
 }
 
+TEST_F(GraphicsRobustAccessTest, ACArrayMaskedIndexUntouched) {
+  for (auto* ac : AccessChains()) {
+    std::ostringstream shaders;
+    shaders << ShaderPreambleAC({"i", "m"}) << TypesVoid() << TypesInt()
+            << TypesFloat() << R"(
+       %uint_200 = OpConstant %uint 200
+       %int_127 = OpConstant %int 127
+       %arr = OpTypeArray %float %uint_200
+       %var_ty = OpTypePointer Function %arr
+       %ptr_ty = OpTypePointer Function %float
+       %i = OpUndef %int
+       )" << MainPrefix() << R"(
+       ; CHECK-NOT: SClamp
+       %var = OpVariable %var_ty Function
+       %m = OpBitwiseAnd %int %i %int_127)"
+            << ACCheck(ac, "%m", "%m") << MainSuffix();
+    SinglePassRunAndMatch<GraphicsRobustAccessPass>(shaders.str(), true);
+  }
+}
+
+TEST_F(GraphicsRobustAccessTest, ACArrayLoopInductionIndexUntouched) {
+  for (auto* ac : AccessChains()) {
+    std::ostringstream shaders;
+    shaders << ShaderPreambleAC({"i"}) << TypesVoid() << TypesInt()
+            << TypesFloat() << R"(
+       %bool = OpTypeBool
+       %int_0 = OpConstant %int 0
+       %int_1 = OpConstant %int 1
+       %int_200 = OpConstant %int 200
+       %uint_200 = OpConstant %uint 200
+       %arr = OpTypeArray %float %uint_200
+       %var_ty = OpTypePointer Function %arr
+       %ptr_ty = OpTypePointer Function %float
+       )" << MainPrefix() << R"(
+       ; CHECK-NOT: SClamp
+       ; CHECK: %ac = )" << ac << R"( %ptr_ty %var %i
+       %var = OpVariable %var_ty Function
+       OpBranch %header
+       %header = OpLabel
+       %i = OpPhi %int %int_0 %entry %next %cont
+       OpLoopMerge %merge %cont None
+       %cond = OpSLessThan %bool %i %int_200
+       OpBranchConditional %cond %body %merge
+       %body = OpLabel
+       %ac = )" << ac << R"( %ptr_ty %var %i
+       OpBranch %cont
+       %cont = OpLabel
+       %next = OpIAdd %int %i %int_1
+       OpBranch %header
+       %merge = OpLabel
+       )" << MainSuffix();
+    SinglePassRunAndMatch<GraphicsRobustAccessPass>(shaders.str(), true);
+  }
+}
+
+TEST_F(GraphicsRobustAccessTest, ACArrayRepeatedIndexClampedOnce) {
+  for (auto* ac : AccessChains()) {
+    std::ostringstream shaders;
+    shaders << ShaderPreambleAC({"i", "ac2"}) << TypesVoid() << TypesInt()
+            << TypesFloat() << R"(
+       %uint_200 = OpConstant %uint 200
+       %arr = OpTypeArray %float %uint_200
+       %var_ty = OpTypePointer Function %arr
+       %ptr_ty = OpTypePointer Function %float
+       %i = OpUndef %int
+       )" << MainPrefix() << R"(
+       ; CHECK: OpLabel
+       ; CHECK: %[[clamp:\w+]] = OpExtInst %int {{%\w+}} SClamp %i
+       ; CHECK-NOT: SClamp
+       ; CHECK: %ac = )" << ac << R"( %ptr_ty %var %[[clamp]]
+       ; CHECK-NOT: SClamp
+       ; CHECK: %ac2 = )" << ac << R"( %ptr_ty %var %[[clamp]]
+       %var = OpVariable %var_ty Function
+       %ac = )" << ac << R"( %ptr_ty %var %i
+       %ac2 = )" << ac << R"( %ptr_ty %var %i
+       )" << MainSuffix();
+    SinglePassRunAndMatch<GraphicsRobustAccessPass>(shaders.str(), true);
+  }
+}
+
 TEST_F(GraphicsRobustAccessTest, ACArrayGeneralShortIndexUIntBoundsClamped) {
   // Index is signed short, array bounds overflows the index type.
   for (auto* ac : AccessChains()) {
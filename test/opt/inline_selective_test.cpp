@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InlineSelectiveTest = PassTest<::testing::Test>;
+
+// Returns a module whose entry point calls %callee twice, in a loop if
+// |in_loop| is true.  The first call passes |first_arg|, and the body of
+// %callee has |num_adds| additions followed by its return.  When |num_calls|
+// is 1, the second call is left out.
+std::string ModuleWithCalls(uint32_t num_adds, bool in_loop,
+                            const std::string& first_arg,
+                            uint32_t num_calls = 2) {
+  std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %callee "callee"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+%float = OpTypeFloat 32
+%float_fn = OpTypeFunction %float %float
+%float_1 = OpConstant %float 1
+%_ptr_Input_float = OpTypePointer Input %float
+%_ptr_Output_float = OpTypePointer Output %float
+%in = OpVariable %_ptr_Input_float Input
+%out = OpVariable %_ptr_Output_float Output
+%callee = OpFunction %float None %float_fn
+%x = OpFunctionParameter %float
+%callee_entry = OpLabel
+)";
+  std::string prev = "%x";
+  for (uint32_t i = 0; i < num_adds; ++i) {
+    std::string value = "%v" + std::to_string(i);
+    text += value + " = OpFAdd %float " + prev + " %float_1\n";
+    prev = value;
+  }
+  text += "OpReturnValue " + prev + "\nOpFunctionEnd\n";
+
+  text += R"(%main = OpFunction %void None %void_fn
+%main_entry = OpLabel
+)";
+  if (in_loop) {
+    text += R"(OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %main_entry %next %continue
+%cmp = OpSLessThan %bool %i %int_4
+OpLoopMerge %merge %continue None
+OpBranchConditional %cmp %body %merge
+%body = OpLabel
+)";
+  }
+  text += "%a = OpLoad %float %in\n";
+  text += "%c1 = OpFunctionCall %float %callee " + first_arg + "\n";
+  if (num_calls > 1) {
+    text += "%c2 = OpFunctionCall %float %callee %c1\n";
+  }
+  text += "OpStore %out %c1\n";
+  if (in_loop) {
+    text += R"(OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+)";
+  }
+  text += "OpReturn\nOpFunctionEnd\n";
+  return text;
+}
+
+const std::string kAllCallsInlined = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+)";
+
+const std::string kNoCallsInlined = R"(
+; CHECK: %main = OpFunction
+; CHECK: OpFunctionCall %float %callee
+; CHECK: OpFunctionCall %float %callee
+)";
+
+TEST_F(InlineSelectiveTest, InlinesSmallCalleeWithinBudget) {
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      kAllCallsInlined + ModuleWithCalls(1, false, "%a"), true, 100u);
+}
+
+TEST_F(InlineSelectiveTest, KeepsCallsThatExceedTheBudget) {
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      kNoCallsInlined + ModuleWithCalls(1, false, "%a"), true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, InlinesOnlyCallRegardlessOfSize) {
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      kAllCallsInlined + ModuleWithCalls(100, false, "%a", 1), true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, KeepsCallsToLargeCallee) {
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      kNoCallsInlined + ModuleWithCalls(50, false, "%a"), true, 1000u);
+}
+
+TEST_F(InlineSelectiveTest, InlinesLargerCalleeInLoop) {
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      kAllCallsInlined + ModuleWithCalls(50, true, "%a"), true, 1000u);
+}
+
+TEST_F(InlineSelectiveTest, InlinesLargerCalleeWithConstantArgument) {
+  // Only the first call has a constant argument.
+  const std::string check = R"(
+; CHECK: %main = OpFunction
+; CHECK-NOT: OpFunctionCall %float %callee %float_1
+; CHECK: OpFunctionCall %float %callee
+; CHECK-NOT: OpFunctionCall
+; CHECK: OpFunctionEnd
+)";
+  SinglePassRunAndMatch<InlineSelectivePass>(
+      check + ModuleWithCalls(45, false, "%float_1"), true, 1000u);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,103 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Block Profile Instrumentation Tests.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InstBlockProfileTest = PassTest<::testing::Test>;
+
+TEST_F(InstBlockProfileTest, CountsEveryBlockInModuleOrder) {
+  const std::string text = R"(
+; CHECK: OpExtension "SPV_KHR_storage_buffer_storage_class"
+; CHECK: OpDecorate [[buf_ty:%\w+]] Block
+; CHECK: OpDecorate [[buf:%\w+]] DescriptorSet 7
+; CHECK: OpDecorate [[buf]] Binding 4
+; CHECK: [[buf]] = OpVariable %_ptr_StorageBuffer_{{\w+}} StorageBuffer
+; CHECK: %main = OpFunction
+; CHECK-NEXT: %entry = OpLabel
+; CHECK-NEXT: %var = OpVariable
+; CHECK-NEXT: [[ptr0:%\w+]] = OpAccessChain %_ptr_StorageBuffer_uint [[buf]] %uint_1 %uint_0
+; CHECK-NEXT: OpAtomicIAdd %uint [[ptr0]] %uint_4 %uint_0 %uint_1
+; CHECK-NEXT: OpSelectionMerge %merge None
+; CHECK: %then = OpLabel
+; CHECK-NEXT: [[ptr1:%\w+]] = OpAccessChain %_ptr_StorageBuffer_uint [[buf]] %uint_1 %uint_1
+; CHECK-NEXT: OpAtomicIAdd %uint [[ptr1]] %uint_4 %uint_0 %uint_1
+; CHECK-NEXT: OpBranch %merge
+; CHECK: %merge = OpLabel
+; CHECK-NEXT: %phi = OpPhi
+; CHECK-NEXT: [[ptr2:%\w+]] = OpAccessChain %_ptr_StorageBuffer_uint [[buf]] %uint_1 %uint_2
+; CHECK-NEXT: OpAtomicIAdd %uint [[ptr2]] %uint_4 %uint_0 %uint_1
+; CHECK-NEXT: OpFunctionCall %void %foo
+; CHECK: %foo = OpFunction
+; CHECK-NEXT: %foo_entry = OpLabel
+; CHECK-NEXT: [[ptr3:%\w+]] = OpAccessChain %_ptr_StorageBuffer_uint [[buf]] %uint_1 %uint_3
+; CHECK-NEXT: OpAtomicIAdd %uint [[ptr3]] %uint_4 %uint_0 %uint_1
+; CHECK-NEXT: OpReturn
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%true = OpConstantTrue %bool
+%_ptr_Function_int = OpTypePointer Function %int
+%void_fn = OpTypeFunction %void
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%var = OpVariable %_ptr_Function_int Function
+OpSelectionMerge %merge None
+OpBranchConditional %true %then %merge
+%then = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%phi = OpPhi %int %int_0 %entry %int_1 %then
+OpStore %var %phi
+%call = OpFunctionCall %void %foo
+OpReturn
+OpFunctionEnd
+%foo = OpFunction %void None %void_fn
+%foo_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<InstBlockProfilePass>(text, true, 7u, 23u);
+}
+
+TEST_F(InstBlockProfileTest, NoFunctionsMeansNoChange) {
+  const std::string text = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+)";
+
+  auto result = SinglePassRunAndDisassemble<InstBlockProfilePass>(
+      text, /* skip_nop = */ true, /* do_validation = */ false, 7u, 23u);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -615,6 +615,99 @@ OpFunctionEnd
       true, 7u, 23u);
 }
 
+TEST_F(InstBuffAddrTest, CombineChecksOfSameBase) {
+  // Check that loads of two members through the same buffer reference in
+  // one block share a single search of the buffer table covering both.
+  //
+  // #version 450
+  // #extension GL_EXT_buffer_reference : enable
+  //
+  // layout(buffer_reference, std430) buffer blockType {
+  //   int x;
+  //   int y;
+  // };
+  //
+  // layout(std430) buffer rootBlock {
+  //   blockType root;
+  //   int sum;
+  // } r;
+  //
+  // void main()
+  // {
+  //   blockType b = r.root;
+  //   r.sum = b.x + b.y;
+  // }
+
+  const std::string text = R"(
+OpCapability Shader
+OpCapability PhysicalStorageBufferAddresses
+OpExtension "SPV_EXT_physical_storage_buffer"
+OpExtension "SPV_KHR_storage_buffer_storage_class"
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel PhysicalStorageBuffer64 GLSL450
+OpEntryPoint GLCompute %main "main"
+OpExecutionMode %main LocalSize 1 1 1
+OpSource GLSL 450
+OpSourceExtension "GL_EXT_buffer_reference"
+OpName %main "main"
+OpName %blockType "blockType"
+OpMemberName %blockType 0 "x"
+OpMemberName %blockType 1 "y"
+OpName %rootBlock "rootBlock"
+OpMemberName %rootBlock 0 "root"
+OpMemberName %rootBlock 1 "sum"
+OpName %r "r"
+OpMemberDecorate %blockType 0 Offset 0
+OpMemberDecorate %blockType 1 Offset 4
+OpDecorate %blockType Block
+OpMemberDecorate %rootBlock 0 Offset 0
+OpMemberDecorate %rootBlock 1 Offset 8
+OpDecorate %rootBlock Block
+OpDecorate %r DescriptorSet 0
+OpDecorate %r Binding 0
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+OpTypeForwardPointer %_ptr_PhysicalStorageBuffer_blockType PhysicalStorageBuffer
+%int = OpTypeInt 32 1
+%blockType = OpTypeStruct %int %int
+%_ptr_PhysicalStorageBuffer_blockType = OpTypePointer PhysicalStorageBuffer %blockType
+%rootBlock = OpTypeStruct %_ptr_PhysicalStorageBuffer_blockType %int
+%_ptr_StorageBuffer_rootBlock = OpTypePointer StorageBuffer %rootBlock
+%r = OpVariable %_ptr_StorageBuffer_rootBlock StorageBuffer
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%_ptr_StorageBuffer__ptr_PhysicalStorageBuffer_blockType = OpTypePointer StorageBuffer %_ptr_PhysicalStorageBuffer_blockType
+%_ptr_PhysicalStorageBuffer_int = OpTypePointer PhysicalStorageBuffer %int
+%_ptr_StorageBuffer_int = OpTypePointer StorageBuffer %int
+%main = OpFunction %void None %3
+%5 = OpLabel
+%16 = OpAccessChain %_ptr_StorageBuffer__ptr_PhysicalStorageBuffer_blockType %r %int_0
+%17 = OpLoad %_ptr_PhysicalStorageBuffer_blockType %16
+%18 = OpAccessChain %_ptr_PhysicalStorageBuffer_int %17 %int_0
+%19 = OpLoad %int %18 Aligned 16
+%20 = OpAccessChain %_ptr_PhysicalStorageBuffer_int %17 %int_1
+%21 = OpLoad %int %20 Aligned 4
+%22 = OpIAdd %int %19 %21
+%23 = OpAccessChain %_ptr_StorageBuffer_int %r %int_1
+OpStore %23 %22
+OpReturn
+OpFunctionEnd
+;CHECK: %main = OpFunction %void None %3
+;CHECK: [[uptr:%\w+]] = OpConvertPtrToU %ulong %18
+;CHECK: [[valid:%\w+]] = OpFunctionCall %bool {{%\w+}} [[uptr]] %uint_8
+;CHECK: OpBranchConditional [[valid]] {{%\w+}} {{%\w+}}
+;CHECK-NOT: OpFunctionCall %bool
+;CHECK: OpBranchConditional [[valid]] {{%\w+}} {{%\w+}}
+;CHECK-NOT: OpFunctionCall %bool
+;CHECK: OpReturn
+;CHECK: OpFunctionEnd
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SinglePassRunAndMatch<InstBuffAddrCheckPass>(text, true, 7u, 23u, false, 1u,
+                                               -1, true);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
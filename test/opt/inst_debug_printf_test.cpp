@@ -202,6 +202,77 @@ OpFunctionEnd
       defs + decorates + globals + main + output_func, true);
 }
 
+TEST_F(InstDebugPrintfTest, SubgroupStreamWrites) {
+  // Same shader as V4Float32, instrumented so that output buffer space is
+  // reserved once per subgroup.
+
+  const std::string text = R"(
+; CHECK: OpCapability GroupNonUniform
+; CHECK: OpCapability GroupNonUniformBallot
+OpCapability Shader
+OpExtension "SPV_KHR_non_semantic_info"
+%1 = OpExtInstImport "NonSemantic.DebugPrintf"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %2 "MainPs" %3 %4
+OpExecutionMode %2 OriginUpperLeft
+%5 = OpString "Color is %vn"
+OpDecorate %6 DescriptorSet 0
+OpDecorate %6 Binding 1
+OpDecorate %7 DescriptorSet 0
+OpDecorate %7 Binding 0
+OpDecorate %3 Location 0
+OpDecorate %4 Location 0
+%void = OpTypeVoid
+%9 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%v4float = OpTypeVector %float 4
+%13 = OpTypeImage %float 2D 0 0 0 1 Unknown
+%_ptr_UniformConstant_13 = OpTypePointer UniformConstant %13
+%6 = OpVariable %_ptr_UniformConstant_13 UniformConstant
+%15 = OpTypeSampler
+%_ptr_UniformConstant_15 = OpTypePointer UniformConstant %15
+%7 = OpVariable %_ptr_UniformConstant_15 UniformConstant
+%17 = OpTypeSampledImage %13
+%_ptr_Input_v2float = OpTypePointer Input %v2float
+%3 = OpVariable %_ptr_Input_v2float Input
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%4 = OpVariable %_ptr_Output_v4float Output
+%2 = OpFunction %void None %9
+%20 = OpLabel
+%21 = OpLoad %v2float %3
+%22 = OpLoad %13 %6
+%23 = OpLoad %15 %7
+%24 = OpSampledImage %17 %22 %23
+%25 = OpImageSampleImplicitLod %v4float %24 %21
+%26 = OpExtInst %void %1 1 %5 %25
+OpStore %4 %25
+OpReturn
+OpFunctionEnd
+; CHECK: [[ac:%\w+]] = OpAccessChain %_ptr_StorageBuffer_uint {{%\w+}} %uint_0
+; CHECK: [[ballot:%\w+]] = OpGroupNonUniformBallot %v4uint %uint_3 %true
+; CHECK: [[rank:%\w+]] = OpGroupNonUniformBallotBitCount %uint %uint_3 ExclusiveScan [[ballot]]
+; CHECK: [[count:%\w+]] = OpGroupNonUniformBallotBitCount %uint %uint_3 Reduce [[ballot]]
+; CHECK: [[total:%\w+]] = OpIMul %uint [[count]] %uint_12
+; CHECK: [[elect:%\w+]] = OpGroupNonUniformElect %bool %uint_3
+; CHECK: OpSelectionMerge [[join:%\w+]] None
+; CHECK: OpBranchConditional [[elect]] [[reserve:%\w+]] [[join]]
+; CHECK: [[reserve]] = OpLabel
+; CHECK: [[base:%\w+]] = OpAtomicIAdd %uint [[ac]] %uint_4 %uint_0 [[total]]
+; CHECK: OpBranch [[join]]
+; CHECK: [[join]] = OpLabel
+; CHECK: [[phi:%\w+]] = OpPhi %uint [[base]] [[reserve]] %uint_0 {{%\w+}}
+; CHECK: [[first:%\w+]] = OpGroupNonUniformBroadcastFirst %uint %uint_3 [[phi]]
+; CHECK: [[off:%\w+]] = OpIMul %uint [[rank]] %uint_12
+; CHECK: [[curr:%\w+]] = OpIAdd %uint [[first]] [[off]]
+; CHECK: {{%\w+}} = OpIAdd %uint [[curr]] %uint_12
+; CHECK-NOT: OpAtomicIAdd
+)";
+
+  SetTargetEnv(SPV_ENV_VULKAN_1_1);
+  SinglePassRunAndMatch<InstDebugPrintfPass>(text, true, 7u, 23u, true);
+}
+
 // TODO(greg-lunarg): Add tests to verify handling of these cases:
 //
 //   Compute shader
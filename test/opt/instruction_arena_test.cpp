@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "source/opt/build_module.h"
+#include "source/opt/instruction_arena.h"
+#include "source/opt/ir_context.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InstructionArenaTest = ::testing::Test;
+
+const char kShader[] = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+        %int = OpTypeInt 32 1
+      %int_1 = OpConstant %int 1
+       %main = OpFunction %void None %3
+          %6 = OpLabel
+          %7 = OpIAdd %int %int_1 %int_1
+               OpReturn
+               OpFunctionEnd
+)";
+
+std::vector<uint32_t> Assemble(const std::string& text) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(tools.Assemble(text, &binary));
+  return binary;
+}
+
+TEST_F(InstructionArenaTest, DisabledByDefault) {
+  std::vector<uint32_t> binary = Assemble(kShader);
+  std::unique_ptr<IRContext> context = BuildModule(
+      SPV_ENV_UNIVERSAL_1_2, nullptr, binary.data(), binary.size());
+  ASSERT_NE(nullptr, context);
+  EXPECT_EQ(nullptr, context->instruction_arena());
+}
+
+TEST_F(InstructionArenaTest, ModuleInstructionsComeFromArena) {
+  std::vector<uint32_t> binary = Assemble(kShader);
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, binary.data(), binary.size(),
+                  /* use_instruction_arena = */ true);
+  ASSERT_NE(nullptr, context);
+  InstructionArena* arena = context->instruction_arena();
+  ASSERT_NE(nullptr, arena);
+  EXPECT_GT(arena->num_live_objects(), 0u);
+  EXPECT_GT(arena->num_reserved_bytes(), 0u);
+  EXPECT_EQ(nullptr, InstructionArena::Current());
+
+  size_t num_live = arena->num_live_objects();
+  context->KillInst(context->get_def_use_mgr()->GetDef(7));
+  EXPECT_EQ(num_live - 1, arena->num_live_objects());
+}
+
+TEST_F(InstructionArenaTest, ScopesNest) {
+  InstructionArena outer;
+  InstructionArena inner;
+  {
+    InstructionArena::Scope outer_scope(&outer);
+    std::unique_ptr<Instruction> from_outer(new Instruction());
+    EXPECT_EQ(1u, outer.num_live_objects());
+    {
+      InstructionArena::Scope inner_scope(&inner);
+      std::unique_ptr<Instruction> from_inner(new Instruction());
+      EXPECT_EQ(1u, inner.num_live_objects());
+      {
+        InstructionArena::Scope heap_scope(nullptr);
+        std::unique_ptr<Instruction> from_heap(new Instruction());
+        EXPECT_EQ(1u, outer.num_live_objects());
+        EXPECT_EQ(1u, inner.num_live_objects());
+      }
+      EXPECT_EQ(&inner, InstructionArena::Current());
+    }
+    EXPECT_EQ(0u, inner.num_live_objects());
+    EXPECT_EQ(&outer, InstructionArena::Current());
+  }
+  EXPECT_EQ(0u, outer.num_live_objects());
+  EXPECT_EQ(nullptr, InstructionArena::Current());
+}
+
+TEST_F(InstructionArenaTest, FreedSlotsAreReused) {
+  InstructionArena arena;
+  InstructionArena::Scope scope(&arena);
+  Instruction* first = new Instruction();
+  delete first;
+  size_t reserved = arena.num_reserved_bytes();
+  Instruction* second = new Instruction();
+  EXPECT_EQ(reserved, arena.num_reserved_bytes());
+  EXPECT_EQ(1u, arena.num_live_objects());
+  delete second;
+  EXPECT_EQ(0u, arena.num_live_objects());
+}
+
+TEST_F(InstructionArenaTest, FreesToWhereTheStorageCameFrom) {
+  InstructionArena arena;
+  Instruction* from_heap = new Instruction();
+  Instruction* from_arena = nullptr;
+  {
+    InstructionArena::Scope scope(&arena);
+    from_arena = new Instruction();
+    EXPECT_EQ(1u, arena.num_live_objects());
+    // Freeing a heap instruction does not touch the current arena.
+    delete from_heap;
+    EXPECT_EQ(1u, arena.num_live_objects());
+  }
+  // An arena instruction goes back to its arena even with no current arena.
+  delete from_arena;
+  EXPECT_EQ(0u, arena.num_live_objects());
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
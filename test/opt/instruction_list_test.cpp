@@ -110,6 +110,70 @@ TEST(InstructionListTest, InsertBefore2) {
   EXPECT_THAT(output, ContainerEq(created_instructions));
 }
 
+// Expects IsBefore to hold for every pair of instructions of |list| in the
+// order of |expected|, and not in the opposite order.
+void ExpectOrder(InstructionList* list,
+                 const std::vector<Instruction*>& expected) {
+  for (size_t i = 0; i < expected.size(); ++i) {
+    for (size_t j = i + 1; j < expected.size(); ++j) {
+      EXPECT_TRUE(list->IsBefore(expected[i], expected[j])) << i << " " << j;
+      EXPECT_FALSE(list->IsBefore(expected[j], expected[i])) << j << " " << i;
+    }
+  }
+}
+
+// Inserting many instructions at the same place exhausts the room between
+// the numbers of their neighbours, so the list is numbered again.
+TEST(InstructionListTest, IsBeforeAfterInsertionsAtTheSamePlace) {
+  InstructionList list;
+  std::vector<Instruction*> expected;
+  for (int i = 0; i < 2; i++) {
+    std::unique_ptr<Instruction> inst(new Instruction());
+    expected.push_back(inst.get());
+    list.push_back(std::move(inst));
+  }
+  ExpectOrder(&list, expected);
+
+  for (int i = 0; i < 100; i++) {
+    Instruction* inst = new Instruction();
+    inst->InsertAfter(expected.front());
+    expected.insert(expected.begin() + 1, inst);
+    EXPECT_TRUE(list.IsBefore(expected.front(), inst));
+    EXPECT_TRUE(list.IsBefore(inst, expected[2]));
+  }
+  ExpectOrder(&list, expected);
+
+  // Moving an instruction takes its new place in the order.
+  expected.back()->InsertBefore(expected.front());
+  expected.insert(expected.begin(), expected.back());
+  expected.pop_back();
+  ExpectOrder(&list, expected);
+}
+
+TEST(InstructionListTest, IsBeforeAfterMovingAList) {
+  InstructionList list;
+  InstructionList other;
+  std::vector<Instruction*> expected;
+  std::vector<Instruction*> moved;
+  for (int i = 0; i < 40; i++) {
+    std::unique_ptr<Instruction> inst(new Instruction());
+    std::unique_ptr<Instruction> other_inst(new Instruction());
+    expected.push_back(inst.get());
+    moved.push_back(other_inst.get());
+    list.push_back(std::move(inst));
+    other.push_back(std::move(other_inst));
+  }
+  ExpectOrder(&list, expected);
+  ExpectOrder(&other, moved);
+
+  auto where = list.begin();
+  for (int i = 0; i < 20; i++) ++where;
+  where.MoveBefore(&other);
+  expected.insert(expected.begin() + 20, moved.begin(), moved.end());
+  EXPECT_TRUE(other.empty());
+  ExpectOrder(&list, expected);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,132 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using InstructionSchedulingTest = PassTest<::testing::Test>;
+
+// Returns a fragment shader whose entry point loads the int %a, then runs
+// |body|.
+std::string Shader(const std::string& body) {
+  return R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in_a %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in_a "in_a"
+OpName %out "out"
+OpName %a "a"
+OpName %s1 "s1"
+OpName %s2 "s2"
+OpName %s3 "s3"
+OpName %t1 "t1"
+OpName %t2 "t2"
+OpName %t3 "t3"
+OpName %u "u"
+OpName %v "v"
+OpDecorate %in_a Flat
+OpDecorate %in_a Location 0
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%int_3 = OpConstant %int 3
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in_a = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%a = OpLoad %int %in_a
+)" + body +
+         "OpReturn\nOpFunctionEnd\n";
+}
+
+// Computes |s1|, |s2| and |s3| before any of their uses.
+const std::string kSums = R"(%s1 = OpIAdd %int %a %int_1
+%s2 = OpIAdd %int %a %int_2
+%s3 = OpIAdd %int %a %int_3
+)";
+
+// Uses |s1|, |s2| and |s3| to compute |v|.
+const std::string kProducts = R"(%t1 = OpIMul %int %s1 %s1
+%t2 = OpIMul %int %s2 %s2
+%t3 = OpIMul %int %s3 %s3
+%u = OpIAdd %int %t1 %t2
+%v = OpIAdd %int %u %t3
+)";
+
+TEST_F(InstructionSchedulingTest, MovesDefinitionsNextToTheirUses) {
+  const std::string check = R"(
+; CHECK: %a = OpLoad %int %in_a
+; CHECK-NEXT: %s1 = OpIAdd %int %a %int_1
+; CHECK-NEXT: %t1 = OpIMul %int %s1 %s1
+; CHECK-NEXT: %s2 = OpIAdd %int %a %int_2
+; CHECK-NEXT: %t2 = OpIMul %int %s2 %s2
+; CHECK-NEXT: %u = OpIAdd %int %t1 %t2
+; CHECK-NEXT: %s3 = OpIAdd %int %a %int_3
+; CHECK-NEXT: %t3 = OpIMul %int %s3 %s3
+; CHECK-NEXT: %v = OpIAdd %int %u %t3
+; CHECK-NEXT: OpStore %out %v
+)";
+  SinglePassRunAndMatch<InstructionSchedulingPass>(
+      check + Shader(kSums + kProducts + "OpStore %out %v\n"), true);
+}
+
+TEST_F(InstructionSchedulingTest, KeepsLoadsAfterStores) {
+  const std::string check = R"(
+; CHECK: %v = OpIAdd %int %u %t3
+; CHECK: OpStore %out %int_0
+; CHECK-NEXT: [[load:%\w+]] = OpLoad %int %out
+; CHECK-NEXT: [[sum:%\w+]] = OpIAdd %int %v [[load]]
+; CHECK-NEXT: OpStore %out [[sum]]
+)";
+  const std::string body = kSums + R"(OpStore %out %int_0
+%load = OpLoad %int %out
+)" + kProducts + R"(%sum = OpIAdd %int %v %load
+OpStore %out %sum
+)";
+  SinglePassRunAndMatch<InstructionSchedulingPass>(check + Shader(body), true);
+}
+
+TEST_F(InstructionSchedulingTest, KeepsOrderThatIsNotImproved) {
+  const std::string body = R"(%s1 = OpIAdd %int %a %int_1
+%t1 = OpIMul %int %s1 %s1
+%s2 = OpIAdd %int %a %int_2
+%t2 = OpIMul %int %s2 %s2
+%u = OpIAdd %int %t1 %t2
+%s3 = OpIAdd %int %a %int_3
+%t3 = OpIMul %int %s3 %s3
+%v = OpIAdd %int %u %t3
+OpStore %out %v
+)";
+  const std::string text = Shader(body);
+  auto result = SinglePassRunAndDisassemble<InstructionSchedulingPass>(
+      text, true, true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -238,6 +238,26 @@ TEST(InstructionTest, OperandIterators) {
   EXPECT_EQ(SPV_OPERAND_TYPE_TYPE_ID, (*(inst.cbegin() + 2)).type);
 }
 
+TEST(InstructionTest, OperandsBeyondTheInlineOnes) {
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, nullptr);
+  Instruction inst(&context, kSampleParsedInstruction);
+  // Grow the operands past those the instruction holds in itself.
+  inst.AddOperand({SPV_OPERAND_TYPE_LITERAL_INTEGER, {5}});
+  inst.AddOperand({SPV_OPERAND_TYPE_LITERAL_INTEGER, {6}});
+  inst.InsertOperand(1, {SPV_OPERAND_TYPE_LITERAL_INTEGER, {7}});
+  std::vector<uint32_t> words;
+  for (const auto& operand : inst) words.push_back(operand.words[0]);
+  EXPECT_THAT(words, Eq(std::vector<uint32_t>{44, 7, 32, 1, 5, 6}));
+
+  inst.RemoveOperand(1);
+  inst.RemoveInOperand(2);
+  words.clear();
+  for (const auto& operand : inst) words.push_back(operand.words[0]);
+  EXPECT_THAT(words, Eq(std::vector<uint32_t>{44, 32, 1, 6}));
+  EXPECT_EQ(44u, inst.result_id());
+  EXPECT_EQ(32u, inst.GetSingleWordInOperand(0));
+}
+
 TEST(InstructionTest, ForInIdStandardIdTypes) {
   IRContext context(SPV_ENV_UNIVERSAL_1_2, nullptr);
   Instruction inst(&context, kSampleAccessChainInstruction);
@@ -299,6 +319,14 @@ TEST(InstructionTest, CloneDifferentContextDifferentUniqueId) {
   EXPECT_NE(other.unique_id(), clone->unique_id());
 }
 
+TEST(InstructionTest, CloneTakesOneUniqueId) {
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, nullptr);
+  Instruction inst(&context);
+  std::unique_ptr<Instruction> clone(inst.Clone(&context));
+  EXPECT_EQ(inst.unique_id() + 1, clone->unique_id());
+  EXPECT_EQ(clone->unique_id() + 1, context.TakeNextUniqueId());
+}
+
 TEST(InstructionTest, EqualsEqualsOperator) {
   IRContext context(SPV_ENV_UNIVERSAL_1_2, nullptr);
   Instruction i1(&context);
@@ -15,6 +15,7 @@
 #include "source/opt/ir_context.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -35,6 +36,7 @@ namespace {
 
 using Analysis = IRContext::Analysis;
 using ::testing::Each;
+using ::testing::ElementsAre;
 using ::testing::UnorderedElementsAre;
 
 class NoopPassPreservesNothing : public Pass {
@@ -223,6 +225,55 @@ TEST_F(IRContextTest, KillMemberName) {
   }
 }
 
+TEST_F(IRContextTest, KillInstsRemovesNamesAndDecorations) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpName %3 "dead_struct"
+               OpMemberName %3 0 "member"
+               OpName %4 "dead_constant"
+               OpName %5 "live_constant"
+               OpMemberDecorate %3 0 Offset 0
+               OpDecorate %3 Block
+               OpDecorate %5 SpecId 1
+          %6 = OpTypeFloat 32
+          %3 = OpTypeStruct %6
+          %7 = OpTypeInt 32 0
+          %4 = OpConstant %7 1
+          %5 = OpSpecConstant %7 2
+          %8 = OpTypeVoid
+          %9 = OpTypeFunction %8
+          %2 = OpFunction %8 None %9
+         %10 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+  context->InvalidateAnalyses(IRContext::kAnalysisDecorations);
+
+  const std::vector<Instruction*> dead = {def_use_mgr->GetDef(4),
+                                          def_use_mgr->GetDef(3)};
+  context->KillInsts(dead);
+
+  EXPECT_EQ(nullptr, def_use_mgr->GetDef(3));
+  EXPECT_EQ(nullptr, def_use_mgr->GetDef(4));
+  std::vector<uint32_t> named;
+  for (auto& inst : context->debugs2()) {
+    named.push_back(inst.GetSingleWordInOperand(0));
+  }
+  EXPECT_THAT(named, ElementsAre(5u));
+  std::vector<uint32_t> decorated;
+  for (auto& inst : context->annotations()) {
+    decorated.push_back(inst.GetSingleWordInOperand(0));
+  }
+  EXPECT_THAT(decorated, ElementsAre(5u));
+}
+
 TEST_F(IRContextTest, KillGroupDecoration) {
   const std::string text = R"(
                OpCapability Shader
@@ -281,6 +332,48 @@ TEST_F(IRContextTest, KillGroupDecoration) {
   EXPECT_EQ(inst, context->annotation_end());
 }
 
+TEST_F(IRContextTest, CloneIsIndependentCopy) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+               OpName %2 "main"
+               OpDecorate %8 RelaxedPrecision
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeInt 32 1
+          %6 = OpConstant %5 1
+          %2 = OpFunction %3 None %4
+          %7 = OpLabel
+          %8 = OpIAdd %5 %6 %6
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  std::vector<uint32_t> original_binary;
+  context->module()->ToBinary(&original_binary, false);
+
+  std::unique_ptr<IRContext> clone = context->Clone();
+  std::vector<uint32_t> clone_binary;
+  clone->module()->ToBinary(&clone_binary, false);
+  EXPECT_EQ(original_binary, clone_binary);
+  EXPECT_EQ(clone.get(), clone->module()->context());
+  EXPECT_EQ(clone.get(), clone->get_def_use_mgr()->GetDef(8)->context());
+
+  // Changing the clone leaves the original alone.
+  clone->KillDef(8);
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, false);
+  EXPECT_EQ(original_binary, binary);
+  EXPECT_NE(nullptr, context->get_def_use_mgr()->GetDef(8));
+  EXPECT_EQ(nullptr, clone->get_def_use_mgr()->GetDef(8));
+}
+
 TEST_F(IRContextTest, TakeNextUniqueIdIncrementing) {
   const uint32_t NUM_TESTS = 1000;
   IRContext localContext(SPV_ENV_UNIVERSAL_1_2, nullptr);
@@ -761,6 +854,57 @@ OpFunctionEnd)";
   EXPECT_EQ(next_id_bound, 0);
 }
 
+TEST_F(IRContextTest, IdRangeTestNearLimit) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpReturn
+OpFunctionEnd)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  uint32_t current_bound = context->module()->id_bound();
+  context->set_max_id_bound(current_bound + 3);
+  uint32_t first_id = context->TakeNextIdRange(2);
+  EXPECT_EQ(first_id, current_bound);
+  EXPECT_EQ(current_bound + 2, context->module()->id_bound());
+  first_id = context->TakeNextIdRange(2);
+  EXPECT_EQ(first_id, 0);
+  EXPECT_EQ(current_bound + 2, context->module()->id_bound());
+  first_id = context->TakeNextIdRange(1);
+  EXPECT_EQ(first_id, current_bound + 2);
+}
+
+TEST_F(IRContextTest, NumIdsRemaining) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpReturn
+OpFunctionEnd)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  uint32_t current_bound = context->module()->id_bound();
+  context->set_max_id_bound(current_bound + 3);
+  EXPECT_EQ(3u, context->NumIdsRemaining());
+  context->TakeNextIdRange(3);
+  EXPECT_EQ(0u, context->NumIdsRemaining());
+  context->set_max_id_bound(current_bound);
+  EXPECT_EQ(0u, context->NumIdsRemaining());
+}
+
 TEST_F(IRContextTest, IdBoundTestUIntMax) {
   const std::string text = R"(
 OpCapability Shader
@@ -1076,6 +1220,46 @@ OpFunctionEnd)";
   EXPECT_EQ(inst2->GetDebugInlinedAt(), 26);
 }
 
+TEST_F(IRContextTest, ReplaceManyIdsAtOnce) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpTypeFloat 32
+%4 = OpConstant %3 0
+%5 = OpConstant %3 1
+%6 = OpConstant %3 2
+%7 = OpConstant %3 3
+%8 = OpFunction %1 None %2
+%9 = OpLabel
+%10 = OpFAdd %3 %4 %5
+%11 = OpFMul %3 %4 %4
+OpReturn
+OpFunctionEnd)";
+
+  std::unique_ptr<IRContext> ctx =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  analysis::DefUseManager* def_use_mgr = ctx->get_def_use_mgr();
+
+  EXPECT_FALSE(ctx->ReplaceAllUsesWith({{4, 4}}));
+  EXPECT_TRUE(ctx->ReplaceAllUsesWith({{4, 6}, {5, 7}}));
+
+  Instruction* add = def_use_mgr->GetDef(10);
+  EXPECT_EQ(6u, add->GetSingleWordInOperand(0));
+  EXPECT_EQ(7u, add->GetSingleWordInOperand(1));
+  Instruction* mul = def_use_mgr->GetDef(11);
+  EXPECT_EQ(6u, mul->GetSingleWordInOperand(0));
+  EXPECT_EQ(6u, mul->GetSingleWordInOperand(1));
+
+  EXPECT_EQ(0u, def_use_mgr->NumUses(4));
+  EXPECT_EQ(0u, def_use_mgr->NumUses(5));
+  EXPECT_EQ(3u, def_use_mgr->NumUses(6));
+  EXPECT_EQ(1u, def_use_mgr->NumUses(7));
+}
+
 TEST_F(IRContextTest, AddDebugValueAfterReplaceUse) {
   const std::string text = R"(
 OpCapability Shader
@@ -1168,6 +1352,219 @@ OpFunctionEnd)";
   EXPECT_EQ(dbg_value->GetSingleWordOperand(kDebugValueOperandValueIndex), 7);
 }
 
+TEST_F(IRContextTest, ProcessFunctionsInParallel) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+         %2 = OpTypeVoid
+         %3 = OpTypeFunction %2
+         %4 = OpTypeInt 32 1
+         %5 = OpConstant %4 1
+         %1 = OpFunction %2 None %3
+        %10 = OpLabel
+        %11 = OpFunctionCall %2 %6
+        %12 = OpFunctionCall %2 %7
+        %13 = OpFunctionCall %2 %8
+               OpReturn
+               OpFunctionEnd
+         %6 = OpFunction %2 None %3
+        %20 = OpLabel
+        %21 = OpIAdd %4 %5 %5
+               OpReturn
+               OpFunctionEnd
+         %7 = OpFunction %2 None %3
+        %30 = OpLabel
+               OpReturn
+               OpFunctionEnd
+         %8 = OpFunction %2 None %3
+        %40 = OpLabel
+        %41 = OpIAdd %4 %5 %5
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  context->set_num_threads(4);
+
+  std::vector<uint32_t> applied;
+  IRContext::StagedProcessFunction remove_adds =
+      [&context, &applied](Function* function) -> std::function<bool()> {
+    // Only reads the module here; the def-use manager was built beforehand.
+    EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisDefUse));
+    std::vector<Instruction*> adds;
+    function->ForEachInst([&adds](Instruction* inst) {
+      if (inst->opcode() == SpvOpIAdd) adds.push_back(inst);
+    });
+    uint32_t id = function->result_id();
+    return [&context, &applied, adds, id]() {
+      applied.push_back(id);
+      for (Instruction* add : adds) context->KillInst(add);
+      return !adds.empty();
+    };
+  };
+
+  EXPECT_TRUE(context->ProcessFunctionsInParallel(remove_adds,
+                                                  IRContext::kAnalysisDefUse));
+  EXPECT_THAT(applied, ElementsAre(1, 6, 7, 8));
+  EXPECT_EQ(nullptr, context->get_def_use_mgr()->GetDef(21));
+  EXPECT_EQ(nullptr, context->get_def_use_mgr()->GetDef(41));
+
+  applied.clear();
+  EXPECT_FALSE(context->ProcessFunctionsInParallel(
+      remove_adds, IRContext::kAnalysisDefUse));
+  EXPECT_THAT(applied, ElementsAre(1, 6, 7, 8));
+}
+
+TEST_F(IRContextTest, ProcessFunctionsInParallelOnASaturatedExecutor) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+         %2 = OpTypeVoid
+         %3 = OpTypeFunction %2
+         %1 = OpFunction %2 None %3
+        %10 = OpLabel
+        %11 = OpFunctionCall %2 %6
+               OpReturn
+               OpFunctionEnd
+         %6 = OpFunction %2 None %3
+        %20 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  context->set_num_threads(4);
+
+  // The executor only queues the tasks, as a pool whose threads are all busy
+  // would, so the functions must be processed on the calling thread.
+  std::vector<std::pair<spv_task_fn, void*>> queued;
+  context->set_executor(
+      [](void* data, spv_task_fn task, void* task_data) {
+        static_cast<std::vector<std::pair<spv_task_fn, void*>>*>(data)
+            ->emplace_back(task, task_data);
+      },
+      &queued);
+
+  std::vector<uint32_t> processed;
+  IRContext::StagedProcessFunction record =
+      [&processed](Function* function) -> std::function<bool()> {
+    uint32_t id = function->result_id();
+    return [&processed, id]() {
+      processed.push_back(id);
+      return false;
+    };
+  };
+  EXPECT_FALSE(context->ProcessFunctionsInParallel(record,
+                                                   IRContext::kAnalysisNone));
+  EXPECT_THAT(processed, ElementsAre(1, 6));
+
+  // The tasks started late find nothing left to do.
+  EXPECT_FALSE(queued.empty());
+  for (auto& task : queued) task.first(task.second);
+  EXPECT_THAT(processed, ElementsAre(1, 6));
+}
+
+TEST_F(IRContextTest, InvalidateAnalysesOfOneFunction) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+         %2 = OpTypeVoid
+         %3 = OpTypeFunction %2
+         %4 = OpTypeBool
+         %5 = OpConstantTrue %4
+         %1 = OpFunction %2 None %3
+        %10 = OpLabel
+        %11 = OpFunctionCall %2 %6
+               OpReturn
+               OpFunctionEnd
+         %6 = OpFunction %2 None %3
+        %20 = OpLabel
+               OpSelectionMerge %22 None
+               OpBranchConditional %5 %21 %22
+        %21 = OpLabel
+               OpBranch %22
+        %22 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  Function* main = context->GetFunction(1);
+  Function* callee = context->GetFunction(6);
+  DominatorAnalysis* main_dominators = context->GetDominatorAnalysis(main);
+  context->GetDominatorAnalysis(callee);
+  EXPECT_THAT(context->cfg()->preds(22), ElementsAre(20, 21));
+
+  // Make %21 the only successor of %20.
+  Instruction* merge = context->get_def_use_mgr()->GetDef(20)->NextNode();
+  Instruction* terminator = context->KillInst(merge);
+  context->get_def_use_mgr()->EraseUseRecordsOfOperandIds(terminator);
+  terminator->SetOpcode(SpvOpBranch);
+  terminator->SetInOperands({{SPV_OPERAND_TYPE_ID, {21}}});
+  context->get_def_use_mgr()->AnalyzeInstUse(terminator);
+
+  context->InvalidateAnalyses(IRContext::kAnalysisCFG, callee);
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisCFG |
+                                        IRContext::kAnalysisDominatorAnalysis));
+  EXPECT_EQ(main_dominators, context->GetDominatorAnalysis(main));
+  EXPECT_THAT(context->cfg()->preds(22), ElementsAre(21));
+  EXPECT_TRUE(context->GetDominatorAnalysis(callee)->Dominates(21, 22));
+  EXPECT_FALSE(context->GetDominatorAnalysis(callee)->Dominates(22, 21));
+}
+
+TEST_F(IRContextTest, MemoryStatsCoverTheValidAnalyses) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %1 = OpFunction %2 None %3
+          %4 = OpLabel
+               OpBranch %5
+          %5 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  context->get_def_use_mgr();
+  context->GetDominatorAnalysis(context->GetFunction(1));
+  context->InvalidateAnalyses(IRContext::kAnalysisTypes);
+
+  auto measured = [&context]() {
+    std::map<Analysis, size_t> analyses;
+    IRContext::MemoryStats stats = context->GetMemoryStats();
+    size_t total = stats.module;
+    for (const auto& analysis : stats.analyses) {
+      analyses.insert(analysis);
+      total += analysis.second;
+    }
+    EXPECT_LT(0u, stats.module);
+    EXPECT_EQ(total, stats.Total());
+    return analyses;
+  };
+  std::map<Analysis, size_t> analyses = measured();
+  EXPECT_LT(0u, analyses[IRContext::kAnalysisDefUse]);
+  EXPECT_LT(0u, analyses[IRContext::kAnalysisCFG]);
+  EXPECT_LT(0u, analyses[IRContext::kAnalysisDominatorAnalysis]);
+  EXPECT_EQ(0u, analyses.count(IRContext::kAnalysisTypes));
+
+  context->InvalidateAnalyses(IRContext::kAnalysisDominatorAnalysis);
+  EXPECT_EQ(0u, measured().count(IRContext::kAnalysisDominatorAnalysis));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
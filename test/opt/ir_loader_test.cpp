@@ -1159,6 +1159,67 @@ TEST(IrBuilder, KeepLineDebugInfoBeforeFunctionEnd) {
   // clang-format on
 }
 
+TEST(IrBuilder, SkipLineDebugInfo) {
+  const std::string text =
+      // clang-format off
+               "OpCapability Shader\n"
+               "OpMemoryModel Logical GLSL450\n"
+          "%1 = OpString \"minimal.vert\"\n"
+               "OpLine %1 10 10\n"
+       "%void = OpTypeVoid\n"
+          "%3 = OpTypeFunction %void\n"
+          "%4 = OpFunction %void None %3\n"
+               "OpLine %1 1 1\n"
+               "OpNoLine\n"
+          "%5 = OpLabel\n"
+               "OpReturn\n"
+               "OpLine %1 2 2\n"
+               "OpFunctionEnd\n"
+               "OpLine %1 3 3\n";
+  // clang-format on
+  const std::string expected =
+      // clang-format off
+               "OpCapability Shader\n"
+               "OpMemoryModel Logical GLSL450\n"
+          "%1 = OpString \"minimal.vert\"\n"
+       "%void = OpTypeVoid\n"
+          "%3 = OpTypeFunction %void\n"
+          "%4 = OpFunction %void None %3\n"
+          "%5 = OpLabel\n"
+               "OpReturn\n"
+               "OpFunctionEnd\n";
+  // clang-format on
+
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> original_binary;
+  ASSERT_TRUE(t.Assemble(text, &original_binary));
+
+  std::unique_ptr<IRContext> context = BuildModule(
+      SPV_ENV_UNIVERSAL_1_1, nullptr, original_binary.data(),
+      original_binary.size(), /* use_instruction_arena = */ false,
+      /* skip_debug_line_insts = */ true);
+  ASSERT_NE(nullptr, context);
+  EXPECT_TRUE(context->module()->DroppedDebugLineInsts());
+
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, /* skip_nop = */ false);
+  std::string disassembled_text;
+  EXPECT_TRUE(t.Disassemble(binary, &disassembled_text));
+  EXPECT_EQ(expected, disassembled_text);
+}
+
+TEST(IrBuilder, SkipLineDebugInfoWithoutLines) {
+  SpirvTools t(SPV_ENV_UNIVERSAL_1_1);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(t.Assemble("OpCapability Shader\n", &binary));
+
+  std::unique_ptr<IRContext> context = BuildModule(
+      SPV_ENV_UNIVERSAL_1_1, nullptr, binary.data(), binary.size(),
+      /* use_instruction_arena = */ false, /* skip_debug_line_insts = */ true);
+  ASSERT_NE(nullptr, context);
+  EXPECT_FALSE(context->module()->DroppedDebugLineInsts());
+}
+
 TEST(IrBuilder, KeepModuleProcessedInRightPlace) {
   DoRoundTripCheck(
       // clang-format off
@@ -1301,6 +1362,59 @@ TEST(IrBuilder, UniqueIds) {
   });
 }
 
+TEST(IrBuilder, GetFirstNonPhi) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %1 "main"
+OpExecutionMode %1 OriginUpperLeft
+%2 = OpString "file.frag"
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%1 = OpFunction %void None %4
+%10 = OpLabel
+%11 = OpIAdd %int %int_0 %int_0
+OpBranch %20
+%20 = OpLabel
+%21 = OpPhi %int %int_0 %10
+%22 = OpPhi %int %11 %10
+%23 = OpIAdd %int %21 %22
+OpBranch %30
+%30 = OpLabel
+OpLine %2 1 1
+%31 = OpPhi %int %21 %20
+OpLine %2 2 1
+%32 = OpPhi %int %22 %20
+OpLine %2 3 1
+%33 = OpIAdd %int %31 %32
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+
+  // A block without phis starts with its first non-phi.
+  BasicBlock* no_phis = context->get_instr_block(10);
+  EXPECT_EQ(no_phis->begin(), no_phis->GetFirstNonPhi());
+  EXPECT_EQ(11u, no_phis->GetFirstNonPhi()->result_id());
+
+  BasicBlock* phis = context->get_instr_block(20);
+  EXPECT_EQ(23u, phis->GetFirstNonPhi()->result_id());
+  const BasicBlock* const_phis = phis;
+  EXPECT_EQ(23u, const_phis->GetFirstNonPhi()->result_id());
+
+  // The lines are attached to the instructions they precede, so they do not
+  // stop the walk over the phis.
+  BasicBlock* phis_with_lines = context->get_instr_block(30);
+  auto first_non_phi = phis_with_lines->GetFirstNonPhi();
+  EXPECT_EQ(33u, first_non_phi->result_id());
+  EXPECT_EQ(1u, first_non_phi->dbg_lines().size());
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,182 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using JumpThreadingTest = PassTest<::testing::Test>;
+
+// Returns a fragment shader whose entry point loads the ints %a and %b and
+// computes the bool %c, then runs |body|.
+std::string Shader(const std::string& body) {
+  return R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in_a %in_b %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %out "out"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpDecorate %in_a Flat
+OpDecorate %in_a Location 0
+OpDecorate %in_b Flat
+OpDecorate %in_b Location 1
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in_a = OpVariable %_ptr_Input_int Input
+%in_b = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%a = OpLoad %int %in_a
+%b = OpLoad %int %in_b
+%c = OpSLessThan %bool %a %b
+)" + body +
+         "OpReturn\nOpFunctionEnd\n";
+}
+
+TEST_F(JumpThreadingTest, FoldsNestedSelectionOnTheSameCondition) {
+  const std::string check = R"(
+; CHECK: [[true:%\w+]] = OpConstantTrue %bool
+; CHECK: OpBranchConditional %c
+; CHECK: OpBranchConditional [[true]]
+)";
+  const std::string body = R"(OpSelectionMerge %outer_merge None
+OpBranchConditional %c %outer_then %outer_merge
+%outer_then = OpLabel
+OpSelectionMerge %inner_merge None
+OpBranchConditional %c %inner_then %inner_merge
+%inner_then = OpLabel
+OpStore %out %a
+OpBranch %inner_merge
+%inner_merge = OpLabel
+OpBranch %outer_merge
+%outer_merge = OpLabel
+)";
+  SinglePassRunAndMatch<JumpThreadingPass>(check + Shader(body), true);
+}
+
+TEST_F(JumpThreadingTest, FusesSuccessiveSelections) {
+  const std::string check = R"(
+; CHECK: OpSelectionMerge [[merge:%\w+]] None
+; CHECK-NEXT: OpBranchConditional %c [[then:%\w+]] [[else:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK-NEXT: OpStore %out %a
+; CHECK-NEXT: OpBranch [[then2:%\w+]]
+; CHECK: [[else]] = OpLabel
+; CHECK-NEXT: OpStore %out %b
+; CHECK-NEXT: OpBranch [[else2:%\w+]]
+; CHECK-NOT: OpSelectionMerge
+; CHECK: [[then2]] = OpLabel
+; CHECK-NEXT: OpStore %out %b
+; CHECK-NEXT: OpBranch [[merge]]
+; CHECK: [[else2]] = OpLabel
+; CHECK-NEXT: OpStore %out %a
+; CHECK-NEXT: OpBranch [[merge]]
+; CHECK: [[merge]] = OpLabel
+)";
+  const std::string body = R"(OpSelectionMerge %merge1 None
+OpBranchConditional %c %then1 %else1
+%then1 = OpLabel
+OpStore %out %a
+OpBranch %merge1
+%else1 = OpLabel
+OpStore %out %b
+OpBranch %merge1
+%merge1 = OpLabel
+OpSelectionMerge %merge2 None
+OpBranchConditional %c %then2 %else2
+%then2 = OpLabel
+OpStore %out %b
+OpBranch %merge2
+%else2 = OpLabel
+OpStore %out %a
+OpBranch %merge2
+%merge2 = OpLabel
+)";
+  SinglePassRunAndMatch<JumpThreadingPass>(check + Shader(body), true);
+}
+
+TEST_F(JumpThreadingTest, FusesSelectionOnTheNegatedCondition) {
+  const std::string check = R"(
+; CHECK: OpBranchConditional %c [[then:%\w+]] [[else:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK-NEXT: OpBranch [[else2:%\w+]]
+; CHECK: [[else]] = OpLabel
+; CHECK-NEXT: OpBranch [[then2:%\w+]]
+; CHECK-NOT: OpLogicalNot
+; CHECK: [[then2]] = OpLabel
+; CHECK-NEXT: OpStore %out %a
+; CHECK: [[else2]] = OpLabel
+; CHECK-NEXT: OpStore %out %b
+)";
+  const std::string body = R"(OpSelectionMerge %merge1 None
+OpBranchConditional %c %then1 %else1
+%then1 = OpLabel
+OpBranch %merge1
+%else1 = OpLabel
+OpBranch %merge1
+%merge1 = OpLabel
+%not_c = OpLogicalNot %bool %c
+OpSelectionMerge %merge2 None
+OpBranchConditional %not_c %then2 %else2
+%then2 = OpLabel
+OpStore %out %a
+OpBranch %merge2
+%else2 = OpLabel
+OpStore %out %b
+OpBranch %merge2
+%merge2 = OpLabel
+)";
+  SinglePassRunAndMatch<JumpThreadingPass>(check + Shader(body), true);
+}
+
+TEST_F(JumpThreadingTest, KeepsSelectionWhoseHeaderComputesValues) {
+  const std::string body = R"(OpSelectionMerge %merge1 None
+OpBranchConditional %c %then1 %else1
+%then1 = OpLabel
+OpStore %out %a
+OpBranch %merge1
+%else1 = OpLabel
+OpStore %out %b
+OpBranch %merge1
+%merge1 = OpLabel
+%sum = OpIAdd %int %a %b
+OpSelectionMerge %merge2 None
+OpBranchConditional %c %then2 %merge2
+%then2 = OpLabel
+OpStore %out %sum
+OpBranch %merge2
+%merge2 = OpLabel
+)";
+  auto result = SinglePassRunAndDisassemble<JumpThreadingPass>(
+      Shader(body), true, true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "source/opt/build_module.h"
@@ -198,6 +200,76 @@ OpFunctionEnd
   SinglePassRunAndMatch<LocalRedundancyEliminationPass>(text, true);
 }
 
+// Returns the binary of |text| once local redundancy elimination runs on it
+// with up to |num_threads| threads.
+std::vector<uint32_t> EliminateLocalRedundancies(const std::string& text,
+                                                 uint32_t num_threads) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  EXPECT_NE(nullptr, context);
+  PassManager manager;
+  manager.SetNumThreads(num_threads);
+  manager.AddPass<LocalRedundancyEliminationPass>();
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(context.get()));
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, false);
+  return binary;
+}
+
+TEST_F(LocalRedundancyEliminationTest, SameResultOnSeveralThreads) {
+  std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_fn = OpTypeFunction %float %float
+%float_1 = OpConstant %float 1
+%main = OpFunction %void None %void_fn
+%main_entry = OpLabel
+)";
+  const uint32_t kNumFunctions = 8;
+  for (uint32_t i = 0; i < kNumFunctions; ++i) {
+    text += "%c" + std::to_string(i) + " = OpFunctionCall %float %f" +
+            std::to_string(i) + " %float_1\n";
+  }
+  text += "OpReturn\nOpFunctionEnd\n";
+  // Each function computes the same sums twice, with a name on the second
+  // ones, so that the names and uses of the redundant sums are updated.
+  for (uint32_t i = 0; i < kNumFunctions; ++i) {
+    const std::string f = "%f" + std::to_string(i);
+    text += f + " = OpFunction %float None %float_fn\n" + f +
+            "_x = OpFunctionParameter %float\n" + f + "_entry = OpLabel\n" +
+            f + "_a = OpFAdd %float " + f + "_x %float_1\n" + f +
+            "_b = OpFMul %float " + f + "_a " + f + "_a\n" + f +
+            "_c = OpFAdd %float " + f + "_x %float_1\n" + f +
+            "_d = OpFMul %float " + f + "_c " + f + "_c\n" + f +
+            "_e = OpFAdd %float " + f + "_b " + f + "_d\n" +
+            "OpReturnValue " + f + "_e\nOpFunctionEnd\n";
+    text.insert(text.find("%void = OpTypeVoid"),
+                "OpName " + f + "_c \"c\"\n");
+  }
+
+  const std::vector<uint32_t> serial = EliminateLocalRedundancies(text, 1);
+  EXPECT_EQ(serial, EliminateLocalRedundancies(text, 4));
+  EXPECT_EQ(serial, EliminateLocalRedundancies(text, kNumFunctions + 1));
+
+  // The second sum and product of each function are gone.
+  const std::string check = R"(
+; CHECK: OpName %main "main"
+; CHECK-NOT: OpName
+; CHECK: [[x:%\w+]] = OpFunctionParameter %float
+; CHECK-NEXT: OpLabel
+; CHECK-NEXT: [[a:%\w+]] = OpFAdd %float [[x]] %float_1
+; CHECK-NEXT: [[b:%\w+]] = OpFMul %float [[a]] [[a]]
+; CHECK-NEXT: OpFAdd %float [[b]] [[b]]
+)";
+  SinglePassRunAndMatch<LocalRedundancyEliminationPass>(check + text, false);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
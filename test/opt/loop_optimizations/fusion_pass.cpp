@@ -712,6 +712,317 @@ TEST_F(FusionPassTest, TooManyRegisters) {
   SinglePassRunAndMatch<LoopFusionPass>(text, true, 5);
 }
 
+// Same as SimpleFusion, except that the second loop has a pre-header of its
+// own after the merge block of the first loop.
+TEST_F(FusionPassTest, FusionAcrossSeparatingBlock) {
+  const std::string text = R"(
+; CHECK: OpPhi
+; CHECK: OpLoad
+; CHECK: OpStore
+; CHECK-NOT: OpPhi
+; CHECK: OpLoad
+; CHECK: OpStore
+
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource GLSL 440
+               OpName %4 "main"
+               OpName %8 "i"
+               OpName %23 "a"
+               OpName %34 "i"
+               OpName %42 "b"
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %7 = OpTypePointer Function %6
+          %9 = OpConstant %6 0
+         %16 = OpConstant %6 10
+         %17 = OpTypeBool
+         %19 = OpTypeInt 32 0
+         %20 = OpConstant %19 10
+         %21 = OpTypeArray %6 %20
+         %22 = OpTypePointer Function %21
+         %28 = OpConstant %6 2
+         %32 = OpConstant %6 1
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+          %8 = OpVariable %7 Function
+         %23 = OpVariable %22 Function
+         %34 = OpVariable %7 Function
+         %42 = OpVariable %22 Function
+               OpStore %8 %9
+               OpBranch %10
+         %10 = OpLabel
+         %51 = OpPhi %6 %9 %5 %33 %13
+               OpLoopMerge %12 %13 None
+               OpBranch %14
+         %14 = OpLabel
+         %18 = OpSLessThan %17 %51 %16
+               OpBranchConditional %18 %11 %12
+         %11 = OpLabel
+         %26 = OpAccessChain %7 %23 %51
+         %27 = OpLoad %6 %26
+         %29 = OpIMul %6 %27 %28
+         %30 = OpAccessChain %7 %23 %51
+               OpStore %30 %29
+               OpBranch %13
+         %13 = OpLabel
+         %33 = OpIAdd %6 %51 %32
+               OpStore %8 %33
+               OpBranch %10
+         %12 = OpLabel
+               OpBranch %60
+         %60 = OpLabel
+               OpStore %34 %9
+               OpBranch %35
+         %35 = OpLabel
+         %52 = OpPhi %6 %9 %60 %50 %38
+               OpLoopMerge %37 %38 None
+               OpBranch %39
+         %39 = OpLabel
+         %41 = OpSLessThan %17 %52 %16
+               OpBranchConditional %41 %36 %37
+         %36 = OpLabel
+         %45 = OpAccessChain %7 %23 %52
+         %46 = OpLoad %6 %45
+         %47 = OpIAdd %6 %46 %28
+         %48 = OpAccessChain %7 %42 %52
+               OpStore %48 %47
+               OpBranch %38
+         %38 = OpLabel
+         %50 = OpIAdd %6 %52 %32
+               OpStore %34 %50
+               OpBranch %35
+         %37 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  SinglePassRunAndMatch<LoopFusionPass>(text, true, 20);
+}
+
+// Same as ThreeLoopsFused, except that each loop after the first has a
+// pre-header of its own after the merge block of the previous loop.  The
+// fused loop is fused again with the third one.
+TEST_F(FusionPassTest, ThreeLoopsFusedAcrossSeparatingBlocks) {
+  const std::string text = R"(
+; CHECK: OpPhi
+; CHECK-NOT: OpPhi
+; CHECK: OpLoopMerge
+; CHECK-NOT: OpLoopMerge
+; CHECK: OpLoad
+; CHECK: OpStore
+; CHECK-NOT: OpPhi
+; CHECK: OpLoad
+; CHECK: OpStore
+; CHECK-NOT: OpPhi
+; CHECK: OpLoad
+; CHECK: OpStore
+; CHECK-NOT: OpLoopMerge
+
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource GLSL 440
+               OpName %4 "main"
+               OpName %8 "i"
+               OpName %23 "a"
+               OpName %25 "b"
+               OpName %34 "i"
+               OpName %42 "c"
+               OpName %52 "i"
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %7 = OpTypePointer Function %6
+          %9 = OpConstant %6 0
+         %16 = OpConstant %6 10
+         %17 = OpTypeBool
+         %19 = OpTypeInt 32 0
+         %20 = OpConstant %19 10
+         %21 = OpTypeArray %6 %20
+         %22 = OpTypePointer Function %21
+         %29 = OpConstant %6 1
+         %47 = OpConstant %6 2
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+          %8 = OpVariable %7 Function
+         %23 = OpVariable %22 Function
+         %25 = OpVariable %22 Function
+         %34 = OpVariable %7 Function
+         %42 = OpVariable %22 Function
+         %52 = OpVariable %7 Function
+               OpStore %8 %9
+               OpBranch %10
+         %10 = OpLabel
+         %68 = OpPhi %6 %9 %5 %33 %13
+               OpLoopMerge %12 %13 None
+               OpBranch %14
+         %14 = OpLabel
+         %18 = OpSLessThan %17 %68 %16
+               OpBranchConditional %18 %11 %12
+         %11 = OpLabel
+         %27 = OpAccessChain %7 %25 %68
+         %28 = OpLoad %6 %27
+         %30 = OpIAdd %6 %28 %29
+         %31 = OpAccessChain %7 %23 %68
+               OpStore %31 %30
+               OpBranch %13
+         %13 = OpLabel
+         %33 = OpIAdd %6 %68 %29
+               OpStore %8 %33
+               OpBranch %10
+         %12 = OpLabel
+               OpBranch %80
+         %80 = OpLabel
+               OpStore %34 %9
+               OpBranch %35
+         %35 = OpLabel
+         %69 = OpPhi %6 %9 %80 %51 %38
+               OpLoopMerge %37 %38 None
+               OpBranch %39
+         %39 = OpLabel
+         %41 = OpSLessThan %17 %69 %16
+               OpBranchConditional %41 %36 %37
+         %36 = OpLabel
+         %45 = OpAccessChain %7 %23 %69
+         %46 = OpLoad %6 %45
+         %48 = OpIAdd %6 %46 %47
+         %49 = OpAccessChain %7 %42 %69
+               OpStore %49 %48
+               OpBranch %38
+         %38 = OpLabel
+         %51 = OpIAdd %6 %69 %29
+               OpStore %34 %51
+               OpBranch %35
+         %37 = OpLabel
+               OpBranch %81
+         %81 = OpLabel
+               OpStore %52 %9
+               OpBranch %53
+         %53 = OpLabel
+         %70 = OpPhi %6 %9 %81 %67 %56
+               OpLoopMerge %55 %56 None
+               OpBranch %57
+         %57 = OpLabel
+         %59 = OpSLessThan %17 %70 %16
+               OpBranchConditional %59 %54 %55
+         %54 = OpLabel
+         %62 = OpAccessChain %7 %42 %70
+         %63 = OpLoad %6 %62
+         %64 = OpIAdd %6 %63 %16
+         %65 = OpAccessChain %7 %25 %70
+               OpStore %65 %64
+               OpBranch %56
+         %56 = OpLabel
+         %67 = OpIAdd %6 %70 %29
+               OpStore %52 %67
+               OpBranch %53
+         %55 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  SinglePassRunAndMatch<LoopFusionPass>(text, true, 20);
+}
+
+// Same as SimpleFusion, except that two blocks separate the merge block of the
+// first loop from the header of the second, so the block that follows the
+// merge block is not a loop header nor a pre-header, and the loops are not
+// adjacent.
+TEST_F(FusionPassTest, NotFusedAcrossTwoSeparatingBlocks) {
+  const std::string text = R"(
+; CHECK: OpLoopMerge
+; CHECK: OpLoopMerge
+
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource GLSL 440
+               OpName %4 "main"
+               OpName %8 "i"
+               OpName %23 "a"
+               OpName %34 "i"
+               OpName %42 "b"
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %7 = OpTypePointer Function %6
+          %9 = OpConstant %6 0
+         %16 = OpConstant %6 10
+         %17 = OpTypeBool
+         %19 = OpTypeInt 32 0
+         %20 = OpConstant %19 10
+         %21 = OpTypeArray %6 %20
+         %22 = OpTypePointer Function %21
+         %28 = OpConstant %6 2
+         %32 = OpConstant %6 1
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+          %8 = OpVariable %7 Function
+         %23 = OpVariable %22 Function
+         %34 = OpVariable %7 Function
+         %42 = OpVariable %22 Function
+               OpStore %8 %9
+               OpBranch %10
+         %10 = OpLabel
+         %51 = OpPhi %6 %9 %5 %33 %13
+               OpLoopMerge %12 %13 None
+               OpBranch %14
+         %14 = OpLabel
+         %18 = OpSLessThan %17 %51 %16
+               OpBranchConditional %18 %11 %12
+         %11 = OpLabel
+         %26 = OpAccessChain %7 %23 %51
+         %27 = OpLoad %6 %26
+         %29 = OpIMul %6 %27 %28
+         %30 = OpAccessChain %7 %23 %51
+               OpStore %30 %29
+               OpBranch %13
+         %13 = OpLabel
+         %33 = OpIAdd %6 %51 %32
+               OpStore %8 %33
+               OpBranch %10
+         %12 = OpLabel
+               OpBranch %60
+         %60 = OpLabel
+               OpStore %34 %9
+               OpBranch %61
+         %61 = OpLabel
+               OpBranch %35
+         %35 = OpLabel
+         %52 = OpPhi %6 %9 %61 %50 %38
+               OpLoopMerge %37 %38 None
+               OpBranch %39
+         %39 = OpLabel
+         %41 = OpSLessThan %17 %52 %16
+               OpBranchConditional %41 %36 %37
+         %36 = OpLabel
+         %45 = OpAccessChain %7 %23 %52
+         %46 = OpLoad %6 %45
+         %47 = OpIAdd %6 %46 %28
+         %48 = OpAccessChain %7 %42 %52
+               OpStore %48 %47
+               OpBranch %38
+         %38 = OpLabel
+         %50 = OpIAdd %6 %52 %32
+               OpStore %34 %50
+               OpBranch %35
+         %37 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  SinglePassRunAndMatch<LoopFusionPass>(text, true, 20);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
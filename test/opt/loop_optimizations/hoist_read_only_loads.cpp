@@ -0,0 +1,101 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/licm_pass.h"
+#include "test/opt/pass_fixture.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using PassClassTest = PassTest<::testing::Test>;
+
+// The loop reads a uniform buffer member, a push constant with a volatile
+// load, and a function variable that it also writes.  Only the load from the
+// uniform buffer is hoisted, along with the address computations.
+const std::string kLoadsInLoop = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+OpDecorate %ubo_type Block
+OpMemberDecorate %ubo_type 0 Offset 0
+OpDecorate %ubo DescriptorSet 0
+OpDecorate %ubo Binding 0
+OpDecorate %pc_type Block
+OpMemberDecorate %pc_type 0 Offset 0
+%void = OpTypeVoid
+%func = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%bool = OpTypeBool
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+%ubo_type = OpTypeStruct %int
+%pc_type = OpTypeStruct %int
+%_ptr_Uniform_ubo_type = OpTypePointer Uniform %ubo_type
+%_ptr_Uniform_int = OpTypePointer Uniform %int
+%_ptr_PushConstant_pc_type = OpTypePointer PushConstant %pc_type
+%_ptr_PushConstant_int = OpTypePointer PushConstant %int
+%_ptr_Function_int = OpTypePointer Function %int
+%ubo = OpVariable %_ptr_Uniform_ubo_type Uniform
+%pc = OpVariable %_ptr_PushConstant_pc_type PushConstant
+%main = OpFunction %void None %func
+%entry = OpLabel
+%local = OpVariable %_ptr_Function_int Function
+OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %next %continue
+OpLoopMerge %merge %continue None
+OpBranch %cond
+%cond = OpLabel
+%cmp = OpSLessThan %bool %i %int_10
+OpBranchConditional %cmp %body %merge
+%body = OpLabel
+%ubo_ptr = OpAccessChain %_ptr_Uniform_int %ubo %int_0
+%ubo_val = OpLoad %int %ubo_ptr
+%pc_ptr = OpAccessChain %_ptr_PushConstant_int %pc %int_0
+%pc_val = OpLoad %int %pc_ptr Volatile
+%local_val = OpLoad %int %local
+OpStore %local %ubo_val
+OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(PassClassTest, HoistReadOnlyLoads) {
+  const std::string checks = R"(
+; CHECK: %entry = OpLabel
+; CHECK: [[ubo_ptr:%\w+]] = OpAccessChain %_ptr_Uniform_int %ubo %int_0
+; CHECK-NEXT: OpLoad %int [[ubo_ptr]]
+; CHECK-NEXT: OpAccessChain %_ptr_PushConstant_int %pc %int_0
+; CHECK-NEXT: OpBranch %header
+; CHECK: %body = OpLabel
+; CHECK-NEXT: OpLoad %int {{%\w+}} Volatile
+; CHECK-NEXT: OpLoad %int %local
+)";
+
+  SinglePassRunAndMatch<LICMPass>(checks + kLoadsInLoop, true);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
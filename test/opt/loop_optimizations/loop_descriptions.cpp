@@ -416,6 +416,44 @@ TEST_F(PassClassTest, UnreachableMerge) {
   EXPECT_EQ(ld.NumLoops(), 1u);
 }
 
+TEST_F(PassClassTest, NoLoopHeaderSkipsDominatorAnalysis) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main"
+               OpExecutionMode %1 OriginUpperLeft
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %4 = OpTypeBool
+          %5 = OpConstantTrue %4
+          %1 = OpFunction %2 None %3
+          %6 = OpLabel
+               OpSelectionMerge %7 None
+               OpBranchConditional %5 %8 %7
+          %8 = OpLabel
+               OpBranch %7
+          %7 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_3, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  Module* module = context->module();
+  EXPECT_NE(nullptr, module) << "Assembling failed for shader:\n"
+                             << text << std::endl;
+  const Function* f = spvtest::GetFunction(module, 1);
+
+  IRContext::AnalysisBuildLog log;
+  context->set_analysis_build_log(&log);
+  EXPECT_EQ(context->GetLoopDescriptor(f)->NumLoops(), 0u);
+  context->set_analysis_build_log(nullptr);
+
+  ASSERT_EQ(log.size(), 1u);
+  EXPECT_EQ(log[0].analysis, IRContext::kAnalysisLoopAnalysis);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
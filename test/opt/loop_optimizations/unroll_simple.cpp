@@ -804,6 +804,20 @@ OpFunctionEnd
   EXPECT_TRUE(loop.FindNumberOfIterations(induction, &*condition->ctail(),
                                           &iterations));
   EXPECT_EQ(iterations, 3u);
+
+  // The trip count is computed once and kept until the loop changes.
+  const Loop::TripCountInfo& trip_count = loop.GetTripCountInfo();
+  EXPECT_EQ(trip_count.condition_block, condition);
+  EXPECT_EQ(trip_count.induction, induction);
+  EXPECT_EQ(trip_count.iterations, 3u);
+  EXPECT_EQ(trip_count.step, 2);
+  EXPECT_EQ(trip_count.init, 2);
+  EXPECT_EQ(&loop.GetTripCountInfo(), &trip_count);
+
+  loop.RemoveBasicBlock(condition->id());
+  EXPECT_EQ(loop.GetTripCountInfo().induction, nullptr);
+  loop.AddBasicBlock(condition);
+  EXPECT_EQ(loop.GetTripCountInfo().induction, induction);
 }
 
 /* Generated from
@@ -3401,6 +3415,132 @@ OpFunctionEnd
   SinglePassRunAndCheck<LoopUnroller>(shader, output, false);
 }
 
+// Returns the loop of SimpleFullyUnrollTest, without the Unroll loop control,
+// iterating |trip_count| times.
+std::string HeuristicUnrollShader(const std::string& trip_count,
+                                  const std::string& loop_control = "None") {
+  return R"(
+            OpCapability Shader
+            %1 = OpExtInstImport "GLSL.std.450"
+            OpMemoryModel Logical GLSL450
+            OpEntryPoint Fragment %2 "main" %3
+            OpExecutionMode %2 OriginUpperLeft
+            OpSource GLSL 330
+            OpName %2 "main"
+            OpName %5 "x"
+            OpName %3 "c"
+            OpDecorate %3 Location 0
+            %6 = OpTypeVoid
+            %7 = OpTypeFunction %6
+            %8 = OpTypeInt 32 1
+            %9 = OpTypePointer Function %8
+            %10 = OpConstant %8 0
+            %11 = OpConstant %8 )" +
+         trip_count + R"(
+            %12 = OpTypeBool
+            %13 = OpTypeFloat 32
+            %14 = OpTypeInt 32 0
+            %15 = OpConstant %14 4
+            %16 = OpTypeArray %13 %15
+            %17 = OpTypePointer Function %16
+            %18 = OpConstant %13 1
+            %19 = OpTypePointer Function %13
+            %20 = OpConstant %8 1
+            %21 = OpTypeVector %13 4
+            %22 = OpTypePointer Output %21
+            %3 = OpVariable %22 Output
+            %2 = OpFunction %6 None %7
+            %23 = OpLabel
+            %5 = OpVariable %17 Function
+            OpBranch %24
+            %24 = OpLabel
+            %35 = OpPhi %8 %10 %23 %34 %26
+            OpLoopMerge %25 %26 )" +
+         loop_control + R"(
+            OpBranch %27
+            %27 = OpLabel
+            %29 = OpSLessThan %12 %35 %11
+            OpBranchConditional %29 %30 %25
+            %30 = OpLabel
+            %32 = OpAccessChain %19 %5 %35
+            OpStore %32 %18
+            OpBranch %26
+            %26 = OpLabel
+            %34 = OpIAdd %8 %35 %20
+            OpBranch %24
+            %25 = OpLabel
+            OpReturn
+            OpFunctionEnd
+  )";
+}
+
+TEST_F(PassClassTest, HeuristicUnrollFullyUnrollsShortLoop) {
+  const std::string check = R"(
+; CHECK-NOT: OpLoopMerge
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+)";
+  SinglePassRunAndMatch<LoopUnroller>(check + HeuristicUnrollShader("4"),
+                                      false,
+                                      LoopUnroller::Heuristics{1000, 64});
+}
+
+TEST_F(PassClassTest, HeuristicUnrollPartiallyUnrollsLongLoop) {
+  // Fully unrolling 64 iterations is too large, so the body is copied up to
+  // the largest partial factor.
+  const std::string check = R"(
+; CHECK: OpLoopMerge {{%\w+}} {{%\w+}} DontUnroll
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+)";
+  SinglePassRunAndMatch<LoopUnroller>(check + HeuristicUnrollShader("64"),
+                                      false,
+                                      LoopUnroller::Heuristics{1000, 64});
+}
+
+TEST_F(PassClassTest, HeuristicUnrollRespectsGrowthBudget) {
+  const std::string check = R"(
+; CHECK: OpLoopMerge {{%\w+}} {{%\w+}} None
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+)";
+  SinglePassRunAndMatch<LoopUnroller>(check + HeuristicUnrollShader("4"),
+                                      false, LoopUnroller::Heuristics{0, 64});
+}
+
+TEST_F(PassClassTest, HeuristicUnrollRespectsRegisterPressure) {
+  // Each copy of the body needs its own induction value, which is more than
+  // one register allows.
+  const std::string check = R"(
+; CHECK: OpLoopMerge {{%\w+}} {{%\w+}} None
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+)";
+  SinglePassRunAndMatch<LoopUnroller>(check + HeuristicUnrollShader("4"),
+                                      false, LoopUnroller::Heuristics{1000, 1});
+}
+
+TEST_F(PassClassTest, HeuristicUnrollSkipsDontUnrollLoops) {
+  const std::string check = R"(
+; CHECK: OpLoopMerge {{%\w+}} {{%\w+}} DontUnroll
+; CHECK: OpStore
+; CHECK-NOT: OpStore
+)";
+  SinglePassRunAndMatch<LoopUnroller>(
+      check + HeuristicUnrollShader("4", "DontUnroll"), false,
+      LoopUnroller::Heuristics{1000, 64});
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
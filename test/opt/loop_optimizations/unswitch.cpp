@@ -962,6 +962,100 @@ TEST_F(UnswitchTest, DontUnswitchConstantCondition) {
   EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
 }
 
+// Returns a module whose loop has |num_conditions| selections, each on a
+// different invariant and uniform condition.
+std::string LoopWithInvariantConditions(uint32_t num_conditions) {
+  std::string globals;
+  std::string entry;
+  std::string body;
+  for (uint32_t k = 0; k < num_conditions; ++k) {
+    const std::string n = std::to_string(k);
+    const std::string next =
+        k + 1 < num_conditions ? "%body_" + std::to_string(k + 1) : "%latch";
+    globals += "%c_" + n + " = OpVariable %_ptr_UniformConstant_float "
+               "UniformConstant\n";
+    entry += "%ld_" + n + " = OpLoad %float %c_" + n + "\n";
+    entry += "%cond_" + n + " = OpFOrdEqual %bool %ld_" + n + " %float_0\n";
+    body += "%body_" + n + " = OpLabel\n";
+    body += "OpSelectionMerge " + next + " None\n";
+    body += "OpBranchConditional %cond_" + n + " %then_" + n + " " + next +
+            "\n";
+    body += "%then_" + n + " = OpLabel\n";
+    body += "OpStore %out %ld_" + n + "\n";
+    body += "OpBranch " + next + "\n";
+  }
+  return R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_10 = OpConstant %int 10
+%float = OpTypeFloat 32
+%float_0 = OpConstant %float 0
+%_ptr_UniformConstant_float = OpTypePointer UniformConstant %float
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+)" + globals +
+         R"(%main = OpFunction %void None %void_fn
+%entry = OpLabel
+)" + entry +
+         R"(OpBranch %header
+%header = OpLabel
+%i = OpPhi %int %int_0 %entry %next %continue
+OpLoopMerge %merge %continue None
+OpBranch %check
+%check = OpLabel
+%cmp = OpSLessThan %bool %i %int_10
+OpBranchConditional %cmp %body_0 %merge
+)" + body +
+         R"(%latch = OpLabel
+OpBranch %continue
+%continue = OpLabel
+%next = OpIAdd %int %i %int_1
+OpBranch %header
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+}
+
+// Returns the number of loops in |disassembly|.
+size_t CountLoops(const std::string& disassembly) {
+  size_t num_loops = 0;
+  for (size_t pos = disassembly.find("OpLoopMerge"); pos != std::string::npos;
+       pos = disassembly.find("OpLoopMerge", pos + 1)) {
+    ++num_loops;
+  }
+  return num_loops;
+}
+
+TEST_F(UnswitchTest, UnswitchAllConditionsWithinBudget) {
+  // Unswitching both conditions makes 3 copies of a loop of 24 instructions,
+  // which keeps the function of 34 instructions within 4 times its size.
+  auto result = SinglePassRunAndDisassemble<LoopUnswitchPass>(
+      LoopWithInvariantConditions(2), true, false);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, std::get<1>(result));
+  EXPECT_EQ(4u, CountLoops(std::get<0>(result)));
+}
+
+TEST_F(UnswitchTest, StopUnswitchingAtTheGrowthBudget) {
+  // Unswitching all 5 conditions would make 32 loops.  The function has 58
+  // instructions and the loop has 42, so the budget of 4 times the size of the
+  // function leaves room for 4 copies of the loop at most.
+  auto result = SinglePassRunAndDisassemble<LoopUnswitchPass>(
+      LoopWithInvariantConditions(5), true, false);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, std::get<1>(result));
+  const size_t num_loops = CountLoops(std::get<0>(result));
+  EXPECT_GT(num_loops, 1u);
+  EXPECT_LE(num_loops, 5u);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
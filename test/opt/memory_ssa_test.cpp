@@ -0,0 +1,312 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/memory_ssa.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/opt/assembly_builder.h"
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using MemorySSATest = PassTest<::testing::Test>;
+
+// The function to analyse is %2, for which instructions and blocks use
+// numeric ids.  %1 is a private variable.
+const std::string kPreamble = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %2 "main"
+OpExecutionMode %2 OriginUpperLeft
+%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%v2int = OpTypeVector %int 2
+%void_func = OpTypeFunction %void
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Function_v2int = OpTypePointer Function %v2int
+%_ptr_Private_int = OpTypePointer Private %int
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%bool_undef = OpUndef %bool
+%1 = OpVariable %_ptr_Private_int Private
+%callee = OpFunction %void None %void_func
+%callee_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+class MemorySSAFixture {
+ public:
+  explicit MemorySSAFixture(const std::string& text)
+      : context_(BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kPreamble + text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS)) {
+    memory_ssa_ = context_->GetMemorySSA(context_->GetFunction(2));
+  }
+
+  IRContext* context() { return context_.get(); }
+  MemorySSA* memory_ssa() { return memory_ssa_; }
+
+  BasicBlock* Block(uint32_t id) {
+    for (BasicBlock& bb : *context_->GetFunction(2)) {
+      if (bb.id() == id) return &bb;
+    }
+    return nullptr;
+  }
+
+  // Returns the |n|th store to |ptr_id| in the function.
+  Instruction* Store(uint32_t ptr_id, uint32_t n = 0) {
+    for (BasicBlock& bb : *context_->GetFunction(2)) {
+      for (Instruction& inst : bb) {
+        if (inst.opcode() == SpvOpStore &&
+            inst.GetSingleWordInOperand(0) == ptr_id && n-- == 0) {
+          return &inst;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  MemoryAccess* StoreAccess(uint32_t ptr_id, uint32_t n = 0) {
+    return memory_ssa_->GetAccess(Store(ptr_id, n));
+  }
+
+  MemoryAccess* LoadAccess(uint32_t load_id) {
+    return memory_ssa_->GetAccess(context_->get_def_use_mgr()->GetDef(load_id));
+  }
+
+ private:
+  std::unique_ptr<IRContext> context_;
+  MemorySSA* memory_ssa_;
+};
+
+TEST_F(MemorySSATest, StraightLine) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_int Function
+%5 = OpVariable %_ptr_Function_int Function
+OpStore %4 %int_0
+OpStore %5 %int_1
+%6 = OpLoad %int %4
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  MemorySSA* memory_ssa = f.memory_ssa();
+  EXPECT_EQ(memory_ssa,
+            f.context()->GetMemorySSA(f.context()->GetFunction(2)));
+  EXPECT_THAT(memory_ssa->storage_classes(),
+              ::testing::ElementsAre(SpvStorageClassFunction));
+
+  MemoryAccess* store_4 = f.StoreAccess(4);
+  MemoryAccess* store_5 = f.StoreAccess(5);
+  MemoryAccess* load = f.LoadAccess(6);
+  ASSERT_NE(store_4, nullptr);
+  ASSERT_NE(store_5, nullptr);
+  ASSERT_NE(load, nullptr);
+  EXPECT_TRUE(store_4->IsDef());
+  EXPECT_TRUE(load->IsUse());
+  EXPECT_EQ(store_4->defining_access(),
+            memory_ssa->GetLiveOnEntry(SpvStorageClassFunction));
+  EXPECT_EQ(store_5->defining_access(), store_4);
+  EXPECT_EQ(load->defining_access(), store_5);
+  EXPECT_EQ(load->version(), store_5->version());
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(load), store_4);
+  EXPECT_EQ(memory_ssa->GetExitAccess(f.Block(3), SpvStorageClassFunction),
+            store_5);
+  EXPECT_EQ(memory_ssa->GetLiveOnEntry(SpvStorageClassPrivate), nullptr);
+}
+
+TEST_F(MemorySSATest, PhiAtMerge) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_int Function
+OpStore %4 %int_0
+OpSelectionMerge %8 None
+OpBranchConditional %bool_undef %7 %8
+%7 = OpLabel
+OpStore %4 %int_1
+OpBranch %8
+%8 = OpLabel
+%9 = OpLoad %int %4
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  MemorySSA* memory_ssa = f.memory_ssa();
+  MemoryAccess* store_entry = f.StoreAccess(4, 0);
+  MemoryAccess* store_then = f.StoreAccess(4, 1);
+  EXPECT_EQ(memory_ssa->GetPhi(f.Block(3), SpvStorageClassFunction), nullptr);
+  EXPECT_EQ(memory_ssa->GetPhi(f.Block(7), SpvStorageClassFunction), nullptr);
+
+  MemoryAccess* phi = memory_ssa->GetPhi(f.Block(8), SpvStorageClassFunction);
+  ASSERT_NE(phi, nullptr);
+  EXPECT_TRUE(phi->IsPhi());
+  EXPECT_THAT(phi->incoming(),
+              ::testing::UnorderedElementsAre(std::make_pair(3u, store_entry),
+                                              std::make_pair(7u, store_then)));
+  EXPECT_EQ(store_then->defining_access(), store_entry);
+  EXPECT_EQ(f.LoadAccess(9)->defining_access(), phi);
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(f.LoadAccess(9)), phi);
+  EXPECT_THAT(store_entry->users(),
+              ::testing::UnorderedElementsAre(store_then, phi));
+}
+
+TEST_F(MemorySSATest, PhiAtLoopHeader) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_int Function
+OpBranch %5
+%5 = OpLabel
+%6 = OpLoad %int %4
+OpLoopMerge %8 %7 None
+OpBranchConditional %bool_undef %7 %8
+%7 = OpLabel
+OpStore %4 %6
+OpBranch %5
+%8 = OpLabel
+%9 = OpLoad %int %4
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  MemorySSA* memory_ssa = f.memory_ssa();
+  MemoryAccess* live_on_entry =
+      memory_ssa->GetLiveOnEntry(SpvStorageClassFunction);
+  MemoryAccess* store = f.StoreAccess(4);
+
+  MemoryAccess* phi = memory_ssa->GetPhi(f.Block(5), SpvStorageClassFunction);
+  ASSERT_NE(phi, nullptr);
+  EXPECT_THAT(phi->incoming(), ::testing::UnorderedElementsAre(
+                                   std::make_pair(3u, live_on_entry),
+                                   std::make_pair(7u, store)));
+  EXPECT_EQ(memory_ssa->GetPhi(f.Block(8), SpvStorageClassFunction), nullptr);
+  EXPECT_EQ(f.LoadAccess(6)->defining_access(), phi);
+  EXPECT_EQ(store->defining_access(), phi);
+  EXPECT_EQ(f.LoadAccess(9)->defining_access(), phi);
+}
+
+TEST_F(MemorySSATest, ClobberSkipsDisjointAccessChains) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_v2int Function
+%5 = OpAccessChain %_ptr_Function_int %4 %int_0
+%6 = OpAccessChain %_ptr_Function_int %4 %int_1
+OpStore %5 %int_0
+OpStore %6 %int_1
+%7 = OpLoad %int %5
+OpStore %1 %7
+%8 = OpFunctionCall %void %callee
+%9 = OpLoad %int %5
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  MemorySSA* memory_ssa = f.memory_ssa();
+  EXPECT_THAT(memory_ssa->storage_classes(),
+              ::testing::UnorderedElementsAre(SpvStorageClassFunction,
+                                              SpvStorageClassPrivate));
+  EXPECT_FALSE(memory_ssa->MayAlias(5, 6));
+  EXPECT_TRUE(memory_ssa->MayAlias(4, 6));
+
+  // The load of %5 is not clobbered by the store to %6, nor by the store to
+  // the private variable, which is in another chain.
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(f.LoadAccess(7)), f.StoreAccess(5));
+
+  // The call is a def in both chains, and clobbers everything.
+  Instruction* call = f.context()->get_def_use_mgr()->GetDef(8);
+  MemoryAccess* call_function =
+      memory_ssa->GetAccess(call, SpvStorageClassFunction);
+  MemoryAccess* call_private =
+      memory_ssa->GetAccess(call, SpvStorageClassPrivate);
+  ASSERT_NE(call_function, nullptr);
+  ASSERT_NE(call_private, nullptr);
+  EXPECT_EQ(call_private->defining_access(), f.StoreAccess(1));
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(f.LoadAccess(9)), call_function);
+}
+
+TEST_F(MemorySSATest, ClobberLooksThroughPhis) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_v2int Function
+%5 = OpAccessChain %_ptr_Function_int %4 %int_0
+%6 = OpAccessChain %_ptr_Function_int %4 %int_1
+OpStore %5 %int_0
+OpBranch %7
+%7 = OpLabel
+OpLoopMerge %9 %8 None
+OpBranchConditional %bool_undef %8 %9
+%8 = OpLabel
+OpStore %6 %int_1
+OpBranch %7
+%9 = OpLabel
+%10 = OpLoad %int %5
+%11 = OpLoad %int %6
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  MemorySSA* memory_ssa = f.memory_ssa();
+  MemoryAccess* phi = memory_ssa->GetPhi(f.Block(7), SpvStorageClassFunction);
+  ASSERT_NE(phi, nullptr);
+  EXPECT_EQ(f.LoadAccess(10)->defining_access(), phi);
+
+  // The store in the loop does not write %5, so the load of %5 after the loop
+  // reads the store before it.
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(f.LoadAccess(10)),
+            f.StoreAccess(5));
+  EXPECT_EQ(memory_ssa->GetClobberingAccess(f.LoadAccess(11)), phi);
+}
+
+TEST_F(MemorySSATest, InvalidatedWithTheCFG) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpVariable %_ptr_Function_int Function
+OpStore %4 %int_0
+OpReturn
+OpFunctionEnd
+)";
+
+  MemorySSAFixture f(text);
+  EXPECT_TRUE(f.context()->AreAnalysesValid(IRContext::kAnalysisMemorySSA));
+  f.context()->InvalidateAnalyses(IRContext::kAnalysisCFG);
+  EXPECT_FALSE(f.context()->AreAnalysesValid(IRContext::kAnalysisMemorySSA));
+
+  // It is rebuilt on demand.
+  MemorySSA* memory_ssa =
+      f.context()->GetMemorySSA(f.context()->GetFunction(2));
+  EXPECT_NE(memory_ssa->GetAccess(f.Store(4)), nullptr);
+  EXPECT_TRUE(f.context()->AreAnalysesValid(IRContext::kAnalysisMemorySSA));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
@@ -76,6 +76,34 @@ TEST(ModuleTest, ComputeIdBound) {
                 ->ComputeIdBound());
 }
 
+TEST(ModuleTest, GetBinarySize) {
+  std::unique_ptr<IRContext> context = BuildModule(
+      "%void = OpTypeVoid %fntype = OpTypeFunction %void "
+      "%f = OpFunction %void None %fntype %a = OpLabel OpNop OpReturn "
+      "OpFunctionEnd");
+
+  // The header, OpTypeVoid, OpTypeFunction, OpFunction, OpLabel, OpNop,
+  // OpReturn and OpFunctionEnd.
+  std::vector<uint32_t> binary;
+  context->module()->ToBinary(&binary, /* skip_nop = */ false);
+  EXPECT_EQ(binary.size(), context->module()->GetBinarySize(false));
+  EXPECT_EQ(5u + 2u + 3u + 5u + 2u + 1u + 1u + 1u, binary.size());
+
+  binary.clear();
+  context->module()->ToBinary(&binary, /* skip_nop = */ true);
+  EXPECT_EQ(binary.size(), context->module()->GetBinarySize(true));
+  EXPECT_EQ(5u + 2u + 3u + 5u + 2u + 1u + 1u, binary.size());
+}
+
+TEST(ModuleTest, ToBinaryAppends) {
+  std::unique_ptr<IRContext> context = BuildModule("%void = OpTypeVoid");
+  std::vector<uint32_t> binary = {42};
+  context->module()->ToBinary(&binary, /* skip_nop = */ true);
+  ASSERT_EQ(1u + context->module()->GetBinarySize(true), binary.size());
+  EXPECT_EQ(42u, binary[0]);
+  EXPECT_EQ(SpvMagicNumber, binary[1]);
+}
+
 TEST(ModuleTest, OstreamOperator) {
   const std::string text = R"(OpCapability Shader
 OpCapability Linkage
@@ -296,6 +324,40 @@ OpLine %5 1 1
   AssembleAndDisassemble(text);
 }
 
+TEST(ModuleTest, InstructionsShareTheirDebugLines) {
+  const std::string text = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%5 = OpString "file.ext"
+%void = OpTypeVoid
+%2 = OpTypeFunction %void
+%3 = OpFunction %void None %2
+%4 = OpLabel
+OpLine %5 1 0
+OpNop
+OpLine %5 1 0
+OpNop
+OpNoLine
+OpLine %5 2 3
+OpReturn
+OpFunctionEnd
+)";
+
+  AssembleAndDisassemble(text);
+
+  std::unique_ptr<IRContext> context = BuildModule(text);
+  BasicBlock& block = *context->module()->begin()->begin();
+  auto inst = block.begin();
+  const Instruction& first_nop = *inst++;
+  const Instruction& second_nop = *inst++;
+  const Instruction& ret = *inst;
+  EXPECT_EQ(&first_nop.dbg_lines(), &second_nop.dbg_lines());
+  EXPECT_THAT(ret.dbg_lines(),
+              Eq(std::vector<DebugLine>{{0, 0, 0}, {5, 2, 3}}));
+  // The empty sequence, the one of the OpNops and the one of the OpReturn.
+  EXPECT_EQ(context->debug_line_table().size(), 3u);
+}
+
 TEST(ModuleTest, NonSemanticInfoIteration) {
   const std::string text = R"(
 OpCapability Shader
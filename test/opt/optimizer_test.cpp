@@ -25,6 +25,8 @@ namespace opt {
 namespace {
 
 using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::Not;
 
 // Return a string that contains the minimum instructions needed to form
 // a valid module.  Other instructions can be appended to this string.
@@ -68,6 +70,101 @@ TEST(Optimizer, CanRunTransformingPassWithDistinctInputOutputVectors) {
   EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
 }
 
+TEST(Optimizer, CountsTheWorkOfThePasses) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%func = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%one = OpConstant %int 1
+%main = OpFunction %void None %func
+%entry = OpLabel
+%dead = OpIAdd %int %one %one
+OpReturn
+OpFunctionEnd
+)",
+                 &binary_in);
+
+  Optimizer::WorkCounts counts;
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.SetWorkCounts(&counts);
+  opt.RegisterPass(CreateAggressiveDCEPass());
+  std::vector<uint32_t> binary_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+  EXPECT_EQ(13u, counts.instructions);
+  EXPECT_LT(0u, counts.analysis_builds);
+  EXPECT_LT(0u, counts.def_use_updates);
+
+  // The counts are those of the last run only.
+  Optimizer null_opt(SPV_ENV_UNIVERSAL_1_0);
+  null_opt.SetWorkCounts(&counts);
+  null_opt.RegisterPass(CreateNullPass());
+  ASSERT_TRUE(null_opt.Run(binary_out.data(), binary_out.size(), &binary_in));
+  EXPECT_GT(13u, counts.instructions);
+  EXPECT_EQ(0u, counts.analysis_builds);
+  EXPECT_EQ(0u, counts.def_use_updates);
+}
+
+TEST(Optimizer, CanStripLineDebugInfoWhileLoading) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() +
+                     "%file = OpString \"file\"\n"
+                     "OpLine %file 1 1\n"
+                     "%void = OpTypeVoid\n"
+                     "OpNoLine\n",
+                 &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  std::vector<uint32_t> binary_out;
+  EXPECT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+
+  std::string disassembly;
+  tools.Disassemble(binary_out.data(), binary_out.size(), &disassembly);
+  EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, BuildsTheSameModuleFromTheValidatorParse) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() +
+                     "OpName %foo \"foo\"\n"
+                     "%file = OpString \"file\"\n"
+                     "OpLine %file 1 1\n"
+                     "%foo = OpTypeVoid\n"
+                     "OpNoLine\n"
+                     "%uint = OpTypeInt 32 0\n",
+                 &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  OptimizerOptions validated;
+  validated.set_run_validator(true);
+  OptimizerOptions unvalidated;
+  unvalidated.set_run_validator(false);
+
+  std::vector<uint32_t> validated_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &validated_out,
+                      validated));
+  std::vector<uint32_t> unvalidated_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &unvalidated_out,
+                      unvalidated));
+  EXPECT_THAT(validated_out, Eq(unvalidated_out));
+  EXPECT_THAT(validated_out, Eq(binary_in));
+
+  // An invalid module is still rejected.
+  std::vector<uint32_t> invalid;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n", &invalid);
+  std::vector<uint32_t> invalid_out;
+  EXPECT_FALSE(
+      opt.Run(invalid.data(), invalid.size(), &invalid_out, validated));
+}
+
 TEST(Optimizer, CanRunNullPassWithAliasedVectors) {
   SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
   std::vector<uint32_t> binary;
@@ -118,6 +215,66 @@ TEST(Optimizer, CanRunTransformingPassWithAliasedVectors) {
   EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
 }
 
+TEST(Optimizer, CanRunIntoCallerBuffer) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid",
+                 &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  std::vector<uint32_t> binary_out(binary_in.size(), 0);
+  size_t size = 0;
+  EXPECT_TRUE(opt.Run(binary_in.data(), binary_in.size(), binary_out.data(),
+                      binary_out.size(), &size, OptimizerOptions()));
+  EXPECT_LT(size, binary_in.size());
+
+  std::string disassembly;
+  tools.Disassemble(binary_out.data(), size, &disassembly);
+  EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, CanRunNullPassInPlaceIntoCallerBuffer) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  size_t size = 0;
+  EXPECT_TRUE(opt.Run(binary.data(), binary.size(), binary.data(),
+                      binary.size(), &size, OptimizerOptions()));
+  EXPECT_EQ(binary.size(), size);
+
+  std::string disassembly;
+  tools.Disassemble(binary.data(), size, &disassembly);
+  EXPECT_THAT(disassembly,
+              Eq(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, RunIntoTooSmallCallerBufferFails) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "%void = OpTypeVoid", &binary_in);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  std::string error;
+  opt.SetMessageConsumer([&error](spv_message_level_t, const char*,
+                                  const spv_position_t&, const char* message) {
+    error = message;
+  });
+  std::vector<uint32_t> binary_out(5, 0);
+  size_t size = 0;
+  EXPECT_FALSE(opt.Run(binary_in.data(), binary_in.size(), binary_out.data(),
+                       binary_out.size(), &size, OptimizerOptions()));
+  EXPECT_EQ(binary_in.size(), size);
+  EXPECT_THAT(error, Eq("The optimized binary needs " +
+                        std::to_string(binary_in.size()) +
+                        " words, but only 5 are available"));
+  EXPECT_THAT(binary_out, Eq(std::vector<uint32_t>(5, 0)));
+}
+
 TEST(Optimizer, CanValidateFlags) {
   Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
   EXPECT_FALSE(opt.FlagHasValidForm("bad-flag"));
@@ -762,6 +919,295 @@ OpFunctionEnd
       << "Was expecting the OpNop to have been removed.";
 }
 
+TEST(Optimizer, RunBatchOptimizesEachModule) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<std::vector<uint32_t>> binaries(3);
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid",
+                 &binaries[0]);
+  tools.Assemble(Header() + "OpName %bar \"bar\"\n%bar = OpTypeInt 32 0",
+                 &binaries[1]);
+  // Not a SPIR-V module.
+  binaries[2] = {0, 1, 2, 3, 4, 5};
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  ASSERT_TRUE(opt.RegisterPassFromFlag("--strip-debug"));
+  std::vector<std::vector<uint32_t>> optimized;
+  std::vector<bool> results;
+  ASSERT_TRUE(opt.RunBatch(binaries, &optimized, &results, OptimizerOptions(),
+                           /* num_threads = */ 2));
+  ASSERT_EQ(3u, optimized.size());
+  EXPECT_THAT(results, Eq(std::vector<bool>{true, true, false}));
+
+  std::string disassembly;
+  tools.Disassemble(optimized[0], &disassembly);
+  EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
+  tools.Disassemble(optimized[1], &disassembly);
+  EXPECT_THAT(disassembly, Eq(Header() + "%uint = OpTypeInt 32 0\n"));
+}
+
+TEST(Optimizer, RunBatchRequiresPassesRegisteredFromFlags) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<std::vector<uint32_t>> binaries(1);
+  tools.Assemble(Header(), &binaries[0]);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPerformancePasses();
+  opt.RegisterPass(CreateStripDebugInfoPass());
+  std::vector<std::vector<uint32_t>> optimized;
+  std::vector<bool> results;
+  EXPECT_FALSE(opt.RunBatch(binaries, &optimized, &results, OptimizerOptions(),
+                            /* num_threads = */ 1));
+}
+
+TEST(Optimizer, SetProfileKeepsCallsInColdBlocks) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+%void = OpTypeVoid
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%5 = OpTypeFunction %void
+%1 = OpFunction %void None %5
+%6 = OpLabel
+OpSelectionMerge %7 None
+OpBranchConditional %true %8 %7
+%8 = OpLabel
+%9 = OpFunctionCall %void %10
+OpBranch %7
+%7 = OpLabel
+%11 = OpFunctionCall %void %10
+OpReturn
+OpFunctionEnd
+%10 = OpFunction %void None %5
+%12 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  ASSERT_TRUE(tools.Assemble(text, &binary_in));
+
+  // Block %8 never executed.  The last count is ignored because block %7 is
+  // not in function %10.
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.SetProfile({{1, 8, 0}, {1, 7, 3}, {10, 7, 0}});
+  opt.RegisterPass(CreateInlineExhaustivePass());
+  std::vector<uint32_t> binary_out;
+  ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+
+  std::string disassembly;
+  tools.Disassemble(binary_out, &disassembly);
+  EXPECT_THAT(disassembly, HasSubstr("%9 = OpFunctionCall %void %10"));
+  EXPECT_THAT(disassembly, Not(HasSubstr("%11 = OpFunctionCall %void %10")));
+}
+
+TEST(Optimizer, SearchPassFlagsIsDeterministic) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%int_1 = OpConstant %int 1
+%5 = OpTypeFunction %void
+%1 = OpFunction %void None %5
+%6 = OpLabel
+%7 = OpIAdd %int %int_1 %int_1
+%8 = OpIAdd %int %7 %int_1
+OpReturn
+OpFunctionEnd
+)";
+
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  ASSERT_TRUE(tools.Assemble(text, &binary));
+
+  Optimizer::SearchOptions search_options;
+  search_options.num_rounds = 8;
+  search_options.candidates_per_round = 4;
+  std::vector<Optimizer::SearchResult> results(2);
+  for (uint32_t num_threads : {1u, 2u}) {
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+    search_options.num_threads = num_threads;
+    ASSERT_TRUE(opt.SearchPassFlags(binary.data(), binary.size(),
+                                    OptimizerOptions(), search_options,
+                                    &results[num_threads - 1]));
+  }
+
+  // The search starts from -O, which removes the dead additions, and it does
+  // not depend on the number of threads.
+  EXPECT_LE(results[0].cost, 12);
+  EXPECT_FALSE(results[0].flags.empty());
+  EXPECT_EQ(results[0].flags, results[1].flags);
+  EXPECT_EQ(results[0].binary, results[1].binary);
+  std::string disassembly;
+  tools.Disassemble(results[0].binary, &disassembly);
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpIAdd")));
+}
+
+TEST(Optimizer, SearchPassFlagsRequiresPassesRegisteredFromFlags) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble(Header(), &binary);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  Optimizer::SearchResult result;
+  EXPECT_FALSE(opt.SearchPassFlags(binary.data(), binary.size(),
+                                   OptimizerOptions(), {}, &result));
+}
+
+TEST(Optimizer, RunsOnLoadedModuleInPlace) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  tools.Assemble(Header() + "OpName %foo \"foo\"\n%foo = OpTypeVoid",
+                 &binary_in);
+
+  LoadedModule module;
+  EXPECT_FALSE(module.IsLoaded());
+  ASSERT_TRUE(module.Load(SPV_ENV_UNIVERSAL_1_0, nullptr, binary_in.data(),
+                          binary_in.size()));
+  EXPECT_TRUE(module.IsLoaded());
+
+  // Each optimizer sees the module left by the one before.
+  Optimizer strip(SPV_ENV_UNIVERSAL_1_0);
+  strip.RegisterPass(CreateStripDebugInfoPass());
+  EXPECT_TRUE(strip.Run(&module, OptimizerOptions()));
+  Optimizer null(SPV_ENV_UNIVERSAL_1_0);
+  null.RegisterPass(CreateNullPass());
+  EXPECT_TRUE(null.Run(&module, OptimizerOptions()));
+  EXPECT_TRUE(module.Validate(ValidatorOptions()));
+
+  std::vector<uint32_t> binary_out;
+  ASSERT_TRUE(module.ToBinary(&binary_out));
+  std::string disassembly;
+  tools.Disassemble(binary_out.data(), binary_out.size(), &disassembly);
+  EXPECT_THAT(disassembly, Eq(Header() + "%void = OpTypeVoid\n"));
+}
+
+TEST(Optimizer, RunOnUnloadedModuleFails) {
+  LoadedModule module;
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  EXPECT_FALSE(opt.Run(&module, OptimizerOptions()));
+  std::vector<uint32_t> binary;
+  EXPECT_FALSE(module.ToBinary(&binary));
+  EXPECT_FALSE(module.Validate(ValidatorOptions()));
+
+  const uint32_t not_spirv[] = {0, 1, 2, 3, 4, 5};
+  EXPECT_FALSE(module.Load(SPV_ENV_UNIVERSAL_1_0, nullptr, not_spirv, 6));
+  EXPECT_FALSE(module.IsLoaded());
+}
+
+TEST(SpecializationCache, SpecializesGenericModule) {
+  const std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main" %2
+OpExecutionMode %1 LocalSize 1 1 1
+OpDecorate %3 SpecId 0
+%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%_ptr_Output_int = OpTypePointer Output %int
+%2 = OpVariable %_ptr_Output_int Output
+%3 = OpSpecConstantFalse %bool
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%9 = OpTypeFunction %void
+%1 = OpFunction %void None %9
+%10 = OpLabel
+OpSelectionMerge %11 None
+OpBranchConditional %3 %12 %13
+%12 = OpLabel
+OpStore %2 %int_1
+OpBranch %11
+%13 = OpLabel
+OpStore %2 %int_2
+OpBranch %11
+%11 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary_in;
+  ASSERT_TRUE(tools.Assemble(text, &binary_in));
+
+  SpecializationCache cache(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> variant;
+  EXPECT_FALSE(cache.Specialize({}, &variant));
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateNullPass());
+  ASSERT_TRUE(cache.SetGenericModule(opt, binary_in.data(), binary_in.size(),
+                                     OptimizerOptions()));
+
+  std::string disassembly;
+  ASSERT_TRUE(cache.Specialize({{0, {1}}}, &variant));
+  tools.Disassemble(variant, &disassembly);
+  EXPECT_THAT(disassembly, HasSubstr("OpStore %2 %int_1"));
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpStore %2 %int_2")));
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpSpecConstant")));
+
+  // The generic module is not changed by the first variant.
+  ASSERT_TRUE(cache.Specialize({}, &variant));
+  tools.Disassemble(variant, &disassembly);
+  EXPECT_THAT(disassembly, Not(HasSubstr("OpStore %2 %int_1")));
+  EXPECT_THAT(disassembly, HasSubstr("OpStore %2 %int_2"));
+}
+
+TEST(FunctionCache, ReusesLegalizedFunctionsAcrossModules) {
+  const std::string body = R"(OpExecutionMode %main LocalSize 1 1 1
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%int_5 = OpConstant %int 5
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Output_int = OpTypePointer Output %int
+%out = OpVariable %_ptr_Output_int Output
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+%var = OpVariable %_ptr_Function_int Function
+OpStore %var %int_5
+%load = OpLoad %int %var
+OpStore %out %load
+OpReturn
+OpFunctionEnd
+)";
+  // The second module has other ids and another entry point name.
+  const std::string first = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main" %out
+)" + body;
+  const std::string second = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "other" %out
+%float = OpTypeFloat 32
+)" + body;
+
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  FunctionCache cache;
+  for (const std::string& text : {first, second}) {
+    std::vector<uint32_t> binary_in;
+    ASSERT_TRUE(tools.Assemble(text, &binary_in));
+    Optimizer opt(SPV_ENV_UNIVERSAL_1_3);
+    opt.RegisterLegalizationPasses().SetFunctionCache(&cache);
+    std::vector<uint32_t> binary_out;
+    ASSERT_TRUE(opt.Run(binary_in.data(), binary_in.size(), &binary_out));
+    EXPECT_TRUE(tools.Validate(binary_out));
+
+    std::string disassembly;
+    tools.Disassemble(binary_out, &disassembly);
+    EXPECT_THAT(disassembly, HasSubstr("OpStore %out %int_5"));
+    EXPECT_THAT(disassembly, Not(HasSubstr("OpVariable %_ptr_Function_int")));
+  }
+  EXPECT_EQ(cache.size(), 1u);
+  EXPECT_EQ(cache.num_misses(), 1u);
+  EXPECT_EQ(cache.num_hits(), 1u);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
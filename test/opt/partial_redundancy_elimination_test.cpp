@@ -0,0 +1,181 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using PartialRedundancyEliminationTest = PassTest<::testing::Test>;
+
+// Returns a fragment shader whose entry point loads the ints %a and %b and the
+// bool %c, then runs |body|.
+std::string Shader(const std::string& body) {
+  return R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in_a %in_b %in_c %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %out "out"
+OpName %a "a"
+OpName %b "b"
+OpDecorate %in_a Flat
+OpDecorate %in_a Location 0
+OpDecorate %in_b Flat
+OpDecorate %in_b Location 1
+OpDecorate %in_c Flat
+OpDecorate %in_c Location 2
+OpDecorate %out Location 0
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+%in_a = OpVariable %_ptr_Input_int Input
+%in_b = OpVariable %_ptr_Input_int Input
+%in_c = OpVariable %_ptr_Input_int Input
+%out = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%a = OpLoad %int %in_a
+%b = OpLoad %int %in_b
+%c_int = OpLoad %int %in_c
+%c = OpINotEqual %bool %c_int %int_0
+)" + body +
+         "OpReturn\nOpFunctionEnd\n";
+}
+
+TEST_F(PartialRedundancyEliminationTest, InsertsInOtherBranch) {
+  const std::string check = R"(
+; CHECK: OpBranchConditional {{%\w+}} [[then:%\w+]] [[else:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK: [[sum:%\w+]] = OpIAdd %int %a %b
+; CHECK: [[else]] = OpLabel
+; CHECK: [[sum2:%\w+]] = OpIAdd %int %a %b
+; CHECK-NEXT: OpBranch [[merge:%\w+]]
+; CHECK: [[merge]] = OpLabel
+; CHECK-NEXT: [[phi:%\w+]] = OpPhi %int [[sum]] [[then]] [[sum2]] [[else]]
+; CHECK-NOT: OpIAdd
+; CHECK: OpStore %out [[phi]]
+)";
+  const std::string body = R"(OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%sum = OpIAdd %int %a %b
+OpStore %out %sum
+OpBranch %merge
+%else = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%sum_again = OpIAdd %int %a %b
+OpStore %out %sum_again
+)";
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(check + Shader(body),
+                                                          true);
+}
+
+TEST_F(PartialRedundancyEliminationTest, MergesValuesOfBothBranches) {
+  const std::string check = R"(
+; CHECK: OpBranchConditional {{%\w+}} [[then:%\w+]] [[else:%\w+]]
+; CHECK: [[then]] = OpLabel
+; CHECK: [[sum:%\w+]] = OpIMul %int %a %b
+; CHECK: [[else]] = OpLabel
+; CHECK: [[sum2:%\w+]] = OpIMul %int %a %b
+; CHECK: OpLabel
+; CHECK-NEXT: [[phi:%\w+]] = OpPhi %int [[sum]] [[then]] [[sum2]] [[else]]
+; CHECK-NOT: OpIMul
+; CHECK: OpStore %out [[phi]]
+)";
+  const std::string body = R"(OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%x = OpIMul %int %a %b
+OpStore %out %x
+OpBranch %merge
+%else = OpLabel
+%y = OpIMul %int %a %b
+%z = OpIAdd %int %y %y
+OpStore %out %z
+OpBranch %merge
+%merge = OpLabel
+%w = OpIMul %int %a %b
+OpStore %out %w
+)";
+  SinglePassRunAndMatch<PartialRedundancyEliminationPass>(check + Shader(body),
+                                                          true);
+}
+
+TEST_F(PartialRedundancyEliminationTest, DoesNotInsertOnCriticalEdge) {
+  // The header branches to the merge directly, so the value cannot be added on
+  // that path only.
+  const std::string text = Shader(R"(OpSelectionMerge %merge None
+OpBranchConditional %c %then %merge
+%then = OpLabel
+%sum = OpIAdd %int %a %b
+OpStore %out %sum
+OpBranch %merge
+%merge = OpLabel
+%sum_again = OpIAdd %int %a %b
+OpStore %out %sum_again
+)");
+  auto result = SinglePassRunAndDisassemble<PartialRedundancyEliminationPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(PartialRedundancyEliminationTest, DoesNotUseOperandsOfTheMerge) {
+  const std::string text = Shader(R"(OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+%sum = OpIAdd %int %a %b
+OpStore %out %sum
+OpBranch %merge
+%else = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%phi = OpPhi %int %a %then %b %else
+%sum_again = OpIAdd %int %phi %b
+OpStore %out %sum_again
+)");
+  auto result = SinglePassRunAndDisassemble<PartialRedundancyEliminationPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(PartialRedundancyEliminationTest, KeepsUnavailableValues) {
+  // Nothing computes the value on the way to the merge.
+  const std::string text = Shader(R"(OpSelectionMerge %merge None
+OpBranchConditional %c %then %else
+%then = OpLabel
+OpBranch %merge
+%else = OpLabel
+OpBranch %merge
+%merge = OpLabel
+%sum = OpIAdd %int %a %b
+OpStore %out %sum
+)");
+  auto result = SinglePassRunAndDisassemble<PartialRedundancyEliminationPass>(
+      text, /* skip_nop = */ true, /* do_validation = */ true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
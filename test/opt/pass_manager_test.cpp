@@ -14,6 +14,7 @@
 
 #include <initializer_list>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -29,6 +30,8 @@ namespace {
 
 using spvtest::GetIdBound;
 using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::Not;
 
 // A null pass whose construtors accept arguments
 class NullPassWithArgs : public NullPass {
@@ -186,6 +189,367 @@ TEST(PassManager, RecomputeIdBoundAutomatically) {
   EXPECT_THAT(GetIdBound(*context.module()), Eq(201u));
 }
 
+// A pass that builds the def-use manager without changing the module.
+class UseDefUsePass : public Pass {
+ public:
+  const char* name() const override { return "UseDefUse"; }
+  Status Process() override {
+    get_def_use_mgr();
+    return Status::SuccessWithoutChange;
+  }
+};
+
+TEST(PassManager, JsonTimeReport) {
+  PassManager manager;
+  std::unique_ptr<Module> module(new Module());
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, std::move(module),
+                    manager.consumer());
+  std::ostringstream report;
+  manager.SetJsonTimeReport(&report);
+  manager.AddPass<UseDefUsePass>();
+  manager.AddPass<AppendOpNopPass>();
+  manager.Run(&context);
+
+  const std::string json = report.str();
+  EXPECT_THAT(json, HasSubstr("\"name\": \"UseDefUse\""));
+  EXPECT_THAT(json, HasSubstr("\"analysis_builds\": [{\"analysis\": "
+                              "\"def-use\", \"time\": "));
+  EXPECT_THAT(json, HasSubstr("\"changed\": false"));
+  EXPECT_THAT(json, HasSubstr("\"name\": \"AppendOpNop\""));
+  EXPECT_THAT(json, HasSubstr("\"instructions_before\": 0,\n"
+                              "      \"instructions_after\": 1,\n"
+                              "      \"changed\": true,\n"
+                              "      \"analysis_builds\": []"));
+  EXPECT_THAT(json, HasSubstr("\"memory\": {\"module\": "));
+  EXPECT_THAT(json, HasSubstr(", \"def-use\": "));
+}
+
+TEST(PassManager, TraceReport) {
+  PassManager manager;
+  std::unique_ptr<Module> module(new Module());
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, std::move(module),
+                    manager.consumer());
+  std::ostringstream trace;
+  manager.SetTraceReport(&trace);
+  manager.AddPass<UseDefUsePass>();
+  manager.AddPass<AppendOpNopPass>();
+  manager.Run(&context);
+
+  const std::string json = trace.str();
+  EXPECT_THAT(json, HasSubstr("{\"traceEvents\": ["));
+  EXPECT_THAT(json, HasSubstr("{\"name\": \"UseDefUse\", \"cat\": \"pass\", "
+                              "\"ph\": \"X\", \"ts\": "));
+  EXPECT_THAT(json, HasSubstr("{\"name\": \"def-use\", \"cat\": \"analysis\", "
+                              "\"ph\": \"X\", \"ts\": "));
+  EXPECT_THAT(json, HasSubstr("{\"name\": \"AppendOpNop\", \"cat\": \"pass\""));
+}
+
+// A pass that adds an OpNop to the first block of the last function.
+class AppendOpNopToLastFunctionPass : public Pass {
+ public:
+  const char* name() const override { return "AppendOpNopToLastFunction"; }
+  Status Process() override {
+    Function* last = nullptr;
+    for (auto& function : *get_module()) last = &function;
+    last->begin()->tail()->InsertBefore(
+        MakeUnique<Instruction>(context(), SpvOpNop));
+    return Status::SuccessWithChange;
+  }
+};
+
+TEST(PassManager, PrintChanged) {
+  const std::string text = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpReturn
+OpFunctionEnd
+%5 = OpFunction %1 None %2
+%6 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  PassManager manager;
+  std::ostringstream out;
+  manager.SetPrintChanged(&out);
+  manager.AddPass<NullPass>();
+  manager.AddPass<AppendOpNopToLastFunctionPass>();
+  manager.Run(context.get());
+
+  // The whole module is printed before the first pass.  The null pass does
+  // not change the module, and the other pass only changes the last function.
+  const std::string output = out.str();
+  EXPECT_THAT(output, HasSubstr("; IR before first pass\n"));
+  EXPECT_THAT(output, HasSubstr("%3 = OpFunction %1 None %2\n"));
+  EXPECT_THAT(output, Not(HasSubstr("pass null")));
+  EXPECT_THAT(output, HasSubstr("; IR after pass AppendOpNopToLastFunction, "
+                                "changed functions %5\n"
+                                "%5 = OpFunction %1 None %2\n"
+                                "%6 = OpLabel\n"
+                                "OpNop\n"
+                                "OpReturn\n"
+                                "OpFunctionEnd\n"));
+}
+
+// A pass that counts how many times it has run, without changing the module.
+class CountingPass : public Pass {
+ public:
+  explicit CountingPass(uint32_t* count) : count_(count) {}
+
+  const char* name() const override { return "Counting"; }
+  Status Process() override {
+    ++*count_;
+    return Status::SuccessWithoutChange;
+  }
+
+ private:
+  uint32_t* count_;
+};
+
+// A pass that builds the dominator trees of the functions without changing
+// the module.
+class UseDominatorsPass : public Pass {
+ public:
+  const char* name() const override { return "UseDominators"; }
+  Status Process() override {
+    for (auto& function : *get_module()) {
+      context()->GetDominatorAnalysis(&function);
+    }
+    return Status::SuccessWithoutChange;
+  }
+};
+
+TEST(PassManager, MaxMemoryDropsTheAnalysesOfTheFunctions) {
+  const std::string text = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%1 = OpTypeVoid
+%2 = OpTypeFunction %1
+%3 = OpFunction %1 None %2
+%4 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  std::string message;
+  PassManager manager;
+  manager.SetMessageConsumer(
+      [&message](spv_message_level_t, const char*, const spv_position_t&,
+                 const char* m) { message = m; });
+  manager.SetMaxMemory(1);
+  manager.AddPass<UseDominatorsPass>();
+  context->get_def_use_mgr();
+
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, manager.Run(context.get()));
+  EXPECT_FALSE(
+      context->AreAnalysesValid(IRContext::kAnalysisDominatorAnalysis));
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisDefUse));
+  EXPECT_THAT(message, HasSubstr("bytes after pass UseDominators, more than "
+                                 "the limit of 1 bytes"));
+}
+
+bool AlwaysCancel(void*) { return true; }
+
+TEST(PassManager, StopsWhenCancelled) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr,
+                  "OpMemoryModel Logical GLSL450");
+  std::string message;
+  PassManager manager;
+  manager.SetMessageConsumer(
+      [&message](spv_message_level_t, const char*, const spv_position_t&,
+                 const char* m) { message = m; });
+  manager.AddPass<NullPass>();
+  context->set_cancel(AlwaysCancel, nullptr);
+
+  EXPECT_EQ(Pass::Status::Failure, manager.Run(context.get()));
+  EXPECT_EQ("The optimization was cancelled before pass null", message);
+}
+
+TEST(PassManager, SkipUnchangedPasses) {
+  PassManager manager;
+  std::unique_ptr<Module> module(new Module());
+  IRContext context(SPV_ENV_UNIVERSAL_1_2, std::move(module),
+                    manager.consumer());
+  uint32_t count = 0;
+  manager.SetSkipUnchangedPasses(true);
+  manager.AddPass<CountingPass>(&count);
+  manager.AddPass<CountingPass>(&count);
+  manager.AddPass<UseDefUsePass>();
+  manager.AddPass<CountingPass>(&count);
+  manager.AddPass<AppendOpNopPass>();
+  manager.AddPass<CountingPass>(&count);
+  manager.Run(&context);
+  // The second and third runs are skipped, since the module has not changed
+  // since the first one.
+  EXPECT_EQ(2u, count);
+
+  count = 0;
+  manager.SetSkipUnchangedPasses(false);
+  manager.AddPass<CountingPass>(&count);
+  manager.AddPass<CountingPass>(&count);
+  manager.Run(&context);
+  EXPECT_EQ(2u, count);
+}
+
+TEST(PassManager, DoesNotSkipPassesWithOtherArguments) {
+  // %callee is called twice, so inlining it makes the module grow.
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_fn = OpTypeFunction %float %float
+%float_1 = OpConstant %float 1
+%callee = OpFunction %float None %float_fn
+%x = OpFunctionParameter %float
+%callee_entry = OpLabel
+%sum = OpFAdd %float %x %float_1
+OpReturnValue %sum
+OpFunctionEnd
+%main = OpFunction %void None %void_fn
+%main_entry = OpLabel
+%c1 = OpFunctionCall %float %callee %float_1
+%c2 = OpFunctionCall %float %callee %c1
+OpReturn
+OpFunctionEnd
+)";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ASSERT_NE(nullptr, context);
+  PassManager manager;
+  manager.SetSkipUnchangedPasses(true);
+  // No growth is allowed by the first pass, which changes nothing.  The
+  // second one must still run, since its budget is not the same.
+  manager.AddPass<InlineSelectivePass>(0u);
+  manager.AddPass<InlineSelectivePass>(100u);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(context.get()));
+
+  uint32_t num_calls = 0;
+  context->module()->ForEachInst([&num_calls](const Instruction* inst) {
+    if (inst->opcode() == SpvOpFunctionCall) ++num_calls;
+  });
+  EXPECT_EQ(0u, num_calls);
+}
+
+const char kFloatAddModule[] = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+OpExecutionMode %main OriginUpperLeft
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%main = OpFunction %void None %void_fn
+%main_entry = OpLabel
+%sum = OpFAdd %float %float_1 %float_1
+OpReturn
+OpFunctionEnd
+)";
+
+TEST(PassManager, DoesNotSkipRelaxFloatOpsAfterConvertToHalf) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kFloatAddModule);
+  ASSERT_NE(nullptr, context);
+  PassManager manager;
+  manager.SetSkipUnchangedPasses(true);
+  // Nothing is relaxed yet, so the first pass changes nothing.
+  manager.AddPass<ConvertToHalfPass>();
+  manager.AddPass<RelaxFloatOpsPass>();
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(context.get()));
+
+  uint32_t num_relaxed = 0;
+  for (const Instruction& inst : context->module()->annotations()) {
+    if (inst.opcode() == SpvOpDecorate &&
+        inst.GetSingleWordInOperand(1) == SpvDecorationRelaxedPrecision) {
+      ++num_relaxed;
+    }
+  }
+  EXPECT_GT(num_relaxed, 0u);
+}
+
+TEST(PassManager, DoesNotSkipPropagateLinesAfterEliminateDeadLines) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kFloatAddModule);
+  ASSERT_NE(nullptr, context);
+  PassManager manager;
+  manager.SetSkipUnchangedPasses(true);
+  // There are no line instructions to eliminate, but there are instructions
+  // to give one.
+  manager.AddPass<ProcessLinesPass>(kLinesEliminateDeadLines);
+  manager.AddPass<ProcessLinesPass>(kLinesPropagateLines);
+  EXPECT_EQ(Pass::Status::SuccessWithChange, manager.Run(context.get()));
+}
+
+// A pass that decorates an id that is not defined, which makes the module
+// invalid, and returns |status|.
+class InvalidatingPass : public Pass {
+ public:
+  explicit InvalidatingPass(Status status) : status_(status) {}
+
+  const char* name() const override { return "invalidating"; }
+  Status Process() override {
+    context()->AddAnnotationInst(MakeUnique<Instruction>(
+        context(), SpvOpDecorate, 0, 0,
+        std::initializer_list<Operand>{
+            {SPV_OPERAND_TYPE_ID, {99}},
+            {SPV_OPERAND_TYPE_DECORATION, {SpvDecorationRelaxedPrecision}}}));
+    return status_;
+  }
+
+ private:
+  Status status_;
+};
+
+const char kValidModule[] =
+    "OpCapability Shader\nOpCapability Linkage\n"
+    "OpMemoryModel Logical GLSL450\n";
+
+Pass::Status RunValidatingAfterAll(PassManager* manager) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, kValidModule);
+  ValidatorOptions options;
+  manager->SetMessageConsumer([](spv_message_level_t, const char*,
+                                 const spv_position_t&, const char*) {});
+  manager->SetValidateAfterAll(true);
+  manager->SetValidatorOptions(options);
+  return manager->Run(context.get());
+}
+
+TEST(PassManager, ValidateAfterAllChecksChangedModules) {
+  PassManager manager;
+  manager.AddPass<NullPass>();
+  manager.AddPass<InvalidatingPass>(Pass::Status::SuccessWithChange);
+  EXPECT_EQ(Pass::Status::Failure, RunValidatingAfterAll(&manager));
+}
+
+TEST(PassManager, ValidateAfterAllChecksTheFirstPass) {
+  PassManager manager;
+  manager.AddPass<InvalidatingPass>(Pass::Status::SuccessWithoutChange);
+  EXPECT_EQ(Pass::Status::Failure, RunValidatingAfterAll(&manager));
+}
+
+TEST(PassManager, ValidateAfterAllSkipsUnchangedModules) {
+  // The module is valid after the null pass.  The second pass claims not to
+  // change it, so it is not validated again.
+  PassManager manager;
+  manager.AddPass<NullPass>();
+  manager.AddPass<InvalidatingPass>(Pass::Status::SuccessWithoutChange);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange,
+            RunValidatingAfterAll(&manager));
+}
+
 }  // anonymous namespace
 }  // namespace opt
 }  // namespace spvtools
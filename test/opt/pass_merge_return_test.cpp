@@ -12,7 +12,11 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "spirv-tools/libspirv.hpp"
@@ -2567,6 +2571,69 @@ TEST_F(MergeReturnPassTest, ChainedPointerUsedAfterLoop) {
   SinglePassRunAndMatch<MergeReturnPass>(before, true);
 }
 
+TEST_F(MergeReturnPassTest, PreservesCFGAndDominators) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %4 = OpTypeFunction %void
+       %bool = OpTypeBool
+      %false = OpConstantFalse %bool
+       %main = OpFunction %void None %4
+          %6 = OpLabel
+               OpSelectionMerge %7 None
+               OpBranchConditional %false %8 %9
+          %8 = OpLabel
+               OpReturn
+          %9 = OpLabel
+               OpSelectionMerge %10 None
+               OpBranchConditional %false %11 %10
+         %11 = OpLabel
+               OpReturn
+         %10 = OpLabel
+               OpBranch %7
+          %7 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(context, nullptr);
+  Function* function = &*context->module()->begin();
+  context->GetDominatorAnalysis(function);
+
+  MergeReturnPass pass;
+  EXPECT_EQ(pass.Run(context.get()), Pass::Status::SuccessWithChange);
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisCFG));
+  EXPECT_TRUE(
+      context->AreAnalysesValid(IRContext::kAnalysisDominatorAnalysis));
+
+  // The recorded predecessors must match the rewritten function.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> real_preds;
+  for (BasicBlock& bb : *function) {
+    bb.ForEachSuccessorLabel([&bb, &real_preds](uint32_t succ) {
+      real_preds[succ].push_back(bb.id());
+    });
+  }
+  for (BasicBlock& bb : *function) {
+    std::vector<uint32_t> preds = context->cfg()->preds(bb.id());
+    std::vector<uint32_t>& real = real_preds[bb.id()];
+    std::sort(preds.begin(), preds.end());
+    std::sort(real.begin(), real.end());
+    EXPECT_EQ(preds, real) << "block " << bb.id();
+  }
+
+  // Every block must still be dominated by the entry block.
+  DominatorAnalysis* dom_tree = context->GetDominatorAnalysis(function);
+  for (BasicBlock& bb : *function) {
+    EXPECT_TRUE(dom_tree->Dominates(function->entry().get(), &bb));
+  }
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
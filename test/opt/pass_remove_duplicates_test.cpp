@@ -218,6 +218,44 @@ OpDecorate %1 GLSLPacked
   EXPECT_EQ(GetErrorMessage(), "");
 }
 
+TEST_F(RemoveDuplicatesTest, RepeatedDecorationsOnManyTargets) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Location 0
+OpDecorate %2 Location 0
+OpDecorate %1 Location 0
+OpDecorate %1 Location 1
+OpMemberDecorate %3 0 Offset 0
+OpDecorate %2 Location 0
+OpMemberDecorate %3 0 Offset 0
+OpMemberDecorate %3 1 Offset 0
+%4 = OpTypeInt 32 0
+%3 = OpTypeStruct %4 %4
+%5 = OpTypePointer Input %4
+%1 = OpVariable %5 Input
+%2 = OpVariable %5 Input
+)";
+  const std::string after = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %1 Location 0
+OpDecorate %2 Location 0
+OpDecorate %1 Location 1
+OpMemberDecorate %3 0 Offset 0
+OpMemberDecorate %3 1 Offset 0
+%4 = OpTypeInt 32 0
+%3 = OpTypeStruct %4 %4
+%5 = OpTypePointer Input %4
+%1 = OpVariable %5 Input
+%2 = OpVariable %5 Input
+)";
+
+  EXPECT_EQ(RunPass(spirv), after);
+  EXPECT_EQ(GetErrorMessage(), "");
+}
+
 TEST_F(RemoveDuplicatesTest, SameTypeAndDifferentName) {
   const std::string spirv = R"(
 OpCapability Shader
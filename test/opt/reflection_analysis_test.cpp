@@ -0,0 +1,163 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/reflection_analysis.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using ::testing::ElementsAre;
+
+const std::string kModule = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %1 "main" %2
+               OpExecutionMode %1 OriginUpperLeft
+               OpName %3 "ubos"
+               OpName %4 "count"
+               OpName %31 "block"
+               OpDecorate %3 DescriptorSet 0
+               OpDecorate %3 Binding 1
+               OpDecorate %6 Block
+               OpMemberDecorate %6 0 Offset 0
+               OpDecorate %4 SpecId 7
+               OpDecorate %2 Location 0
+               OpDecorate %30 DescriptorSet 1
+               OpDecorate %30 Binding 0
+         %30 = OpDecorationGroup
+               OpGroupDecorate %30 %7
+          %8 = OpTypeVoid
+          %9 = OpTypeFunction %8
+         %10 = OpTypeInt 32 0
+         %11 = OpConstant %10 4
+          %6 = OpTypeStruct %10
+         %12 = OpTypeArray %6 %11
+         %13 = OpTypePointer Uniform %12
+          %3 = OpVariable %13 Uniform
+         %14 = OpTypeRuntimeArray %6
+         %15 = OpTypePointer StorageBuffer %14
+          %7 = OpVariable %15 StorageBuffer
+         %16 = OpTypePointer PushConstant %6
+          %5 = OpVariable %16 PushConstant
+         %17 = OpTypeFloat 32
+         %18 = OpTypePointer Output %17
+          %2 = OpVariable %18 Output
+          %4 = OpSpecConstant %10 16
+          %1 = OpFunction %8 None %9
+         %31 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+std::unique_ptr<IRContext> BuildContext(std::vector<uint32_t>* binary) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_VULKAN_1_1, nullptr, kModule,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  if (context && binary) context->module()->ToBinary(binary, false);
+  return context;
+}
+
+TEST(ReflectionAnalysisTest, ListsResourcesEntryPointsAndSpecConstants) {
+  std::unique_ptr<IRContext> context = BuildContext(nullptr);
+  ASSERT_NE(nullptr, context);
+  ReflectionAnalysis* reflection = context->GetReflectionAnalysis();
+
+  ASSERT_EQ(3u, reflection->resources().size());
+  const ReflectedResource* ubos = reflection->GetResource(0, 1);
+  ASSERT_NE(nullptr, ubos);
+  EXPECT_EQ(3u, ubos->variable_id);
+  EXPECT_EQ(uint32_t(SpvStorageClassUniform), ubos->storage_class);
+  EXPECT_EQ(6u, ubos->type_id);
+  EXPECT_EQ(4u, ubos->array_size);
+  EXPECT_EQ("ubos", ubos->name);
+
+  // The binding of the storage buffers comes from a decoration group, and
+  // their number is not known.
+  const ReflectedResource* buffers = reflection->GetResource(7);
+  ASSERT_NE(nullptr, buffers);
+  EXPECT_EQ(buffers, reflection->GetResource(1, 0));
+  EXPECT_EQ(6u, buffers->type_id);
+  EXPECT_EQ(0u, buffers->array_size);
+
+  const ReflectedResource* push_constants = reflection->GetResource(5);
+  ASSERT_NE(nullptr, push_constants);
+  EXPECT_FALSE(push_constants->has_binding);
+  EXPECT_EQ(1u, push_constants->array_size);
+  EXPECT_EQ(nullptr, reflection->GetResource(2));
+
+  ASSERT_EQ(1u, reflection->entry_points().size());
+  const ReflectedEntryPoint& main = reflection->entry_points()[0];
+  EXPECT_EQ(1u, main.function_id);
+  EXPECT_EQ(uint32_t(SpvExecutionModelFragment), main.execution_model);
+  EXPECT_EQ("main", main.name);
+  EXPECT_THAT(main.interface_ids, ElementsAre(2));
+
+  const ReflectedSpecConstant* count = reflection->GetSpecConstant(7);
+  ASSERT_NE(nullptr, count);
+  EXPECT_EQ(4u, count->id);
+  EXPECT_EQ(10u, count->type_id);
+  EXPECT_THAT(count->default_value, ElementsAre(16));
+  EXPECT_EQ("count", count->name);
+  EXPECT_EQ(nullptr, reflection->GetSpecConstant(0));
+}
+
+TEST(ReflectionAnalysisTest, MatchesTheReflectionOfTheBinary) {
+  std::vector<uint32_t> binary;
+  std::unique_ptr<IRContext> context = BuildContext(&binary);
+  ASSERT_NE(nullptr, context);
+
+  SpirvTools tools(SPV_ENV_VULKAN_1_1);
+  ModuleReflection reflection;
+  ASSERT_TRUE(tools.Reflect(binary, &reflection));
+  EXPECT_EQ(context->GetReflectionAnalysis()->reflection(), reflection);
+
+  // Only the instructions before the functions are parsed.
+  binary.resize(binary.size() - 3);
+  ModuleReflection truncated;
+  EXPECT_TRUE(tools.Reflect(binary, &truncated));
+  EXPECT_EQ(reflection, truncated);
+
+  // |reflection| is left unchanged when the binary cannot be parsed.
+  binary.resize(3);
+  EXPECT_FALSE(tools.Reflect(binary, &reflection));
+  EXPECT_EQ(3u, reflection.resources.size());
+}
+
+TEST(ReflectionAnalysisTest, InvalidatedOnlyByReflectedChanges) {
+  std::unique_ptr<IRContext> context = BuildContext(nullptr);
+  ASSERT_NE(nullptr, context);
+  context->GetReflectionAnalysis();
+
+  // The name of a label is not reflected.
+  context->KillNamesAndDecorates(31);
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisReflection));
+
+  context->KillDef(5);
+  EXPECT_FALSE(context->AreAnalysesValid(IRContext::kAnalysisReflection));
+  EXPECT_EQ(2u, context->GetReflectionAnalysis()->resources().size());
+  EXPECT_EQ(nullptr, context->GetReflectionAnalysis()->GetResource(5));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
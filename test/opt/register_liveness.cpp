@@ -1317,6 +1317,74 @@ TEST_F(PassClassTest, RegisterLivenessWithUnreachableBlock) {
   liveness_analysis->Get(f);
 }
 
+TEST_F(PassClassTest, EstimateLoopRegisterPressure) {
+  const std::string text = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main" %3 %4
+               OpExecutionMode %2 OriginUpperLeft
+       %void = OpTypeVoid
+          %6 = OpTypeFunction %void
+        %int = OpTypeInt 32 1
+       %bool = OpTypeBool
+%_ptr_Input_int = OpTypePointer Input %int
+%_ptr_Output_int = OpTypePointer Output %int
+      %int_0 = OpConstant %int 0
+      %int_1 = OpConstant %int 1
+     %int_10 = OpConstant %int 10
+          %3 = OpVariable %_ptr_Input_int Input
+          %4 = OpVariable %_ptr_Output_int Output
+          %2 = OpFunction %void None %6
+         %10 = OpLabel
+         %11 = OpLoad %int %3
+               OpBranch %12
+         %12 = OpLabel
+         %13 = OpPhi %int %int_0 %10 %14 %15
+         %16 = OpPhi %int %int_0 %10 %17 %15
+         %18 = OpSLessThan %bool %13 %int_10
+               OpLoopMerge %30 %15 None
+               OpBranchConditional %18 %20 %30
+         %20 = OpLabel
+         %21 = OpIMul %int %16 %11
+         %17 = OpIAdd %int %21 %int_1
+               OpBranch %15
+         %15 = OpLabel
+         %14 = OpIAdd %int %13 %int_1
+               OpBranch %12
+         %30 = OpLabel
+               OpStore %4 %16
+               OpReturn
+               OpFunctionEnd
+  )";
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  Module* module = context->module();
+  EXPECT_NE(nullptr, module) << "Assembling failed for shader:\n"
+                             << text << std::endl;
+  Function* f = &*module->begin();
+  LoopDescriptor& ld = *context->GetLoopDescriptor(f);
+
+  RegisterLiveness::RegionRegisterLiveness loop_reg_pressure;
+  RegisterLiveness::EstimateLoopRegisterPressure(context.get(), *ld[12],
+                                                 &loop_reg_pressure);
+
+  std::unordered_set<uint32_t> live_in{
+      11,  // %11 = OpLoad %int %3
+      13,  // %13 = OpPhi %int %int_0 %10 %14 %15
+      16,  // %16 = OpPhi %int %int_0 %10 %17 %15
+  };
+  CompareSets(loop_reg_pressure.live_in_, live_in);
+
+  std::unordered_set<uint32_t> live_out{
+      16,  // %16 = OpPhi %int %int_0 %10 %17 %15
+  };
+  CompareSets(loop_reg_pressure.live_out_, live_out);
+
+  // %11, %13 and %16 are live throughout the loop, plus one temporary.
+  EXPECT_EQ(loop_reg_pressure.used_registers_, 4u);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
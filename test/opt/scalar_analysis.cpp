@@ -1216,6 +1216,137 @@ TEST_F(ScalarAnalysisTest, InductionWithVariantStep) {
   EXPECT_EQ(simplified_2->GetType(), SENode::CanNotCompute);
 }
 
+// Two sibling loops counting from 0 to 10. The second loop starts from
+// |start|, which is either the constant 0 (%9) or the induction variable of
+// the first loop (%35).
+std::string TwoLoopsModule(const std::string& start) {
+  return R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+          %6 = OpTypeInt 32 1
+          %9 = OpConstant %6 0
+         %16 = OpConstant %6 10
+         %17 = OpTypeBool
+         %27 = OpConstant %6 1
+         %28 = OpConstant %6 2
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+               OpBranch %10
+         %10 = OpLabel
+         %35 = OpPhi %6 %9 %5 %34 %13
+               OpLoopMerge %12 %13 None
+               OpBranch %14
+         %14 = OpLabel
+         %18 = OpSLessThan %17 %35 %16
+               OpBranchConditional %18 %11 %12
+         %11 = OpLabel
+               OpBranch %13
+         %13 = OpLabel
+         %34 = OpIAdd %6 %35 %27
+               OpBranch %10
+         %12 = OpLabel
+               OpBranch %40
+         %40 = OpLabel
+         %45 = OpPhi %6 )" +
+         start + R"( %12 %44 %43
+               OpLoopMerge %42 %43 None
+               OpBranch %46
+         %46 = OpLabel
+         %47 = OpSLessThan %17 %45 %16
+               OpBranchConditional %47 %41 %42
+         %41 = OpLabel
+               OpBranch %43
+         %43 = OpLabel
+         %44 = OpIAdd %6 %45 %27
+               OpBranch %40
+         %42 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+}
+
+TEST_F(ScalarAnalysisTest, ForgetLoopKeepsOtherLoops) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, TwoLoopsModule("%9"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  Function* f = spvtest::GetFunction(context->module(), 4);
+  LoopDescriptor& ld = *context->GetLoopDescriptor(f);
+  analysis::DefUseManager* def_use = context->get_def_use_mgr();
+  ScalarEvolutionAnalysis analysis{context.get()};
+
+  SENode* first = analysis.AnalyzeInstruction(def_use->GetDef(35));
+  SENode* second = analysis.AnalyzeInstruction(def_use->GetDef(45));
+  ASSERT_EQ(first->GetType(), SENode::RecurrentAddExpr);
+  ASSERT_EQ(second->GetType(), SENode::RecurrentAddExpr);
+  EXPECT_NE(first, second);
+
+  // Make the first loop count in steps of 2. The cached recurrence is stale
+  // until the loop is forgotten.
+  Instruction* step = def_use->GetDef(34);
+  step->SetInOperand(1, {28});
+  def_use->AnalyzeInstUse(step);
+  EXPECT_EQ(analysis.AnalyzeInstruction(def_use->GetDef(35)), first);
+
+  analysis.ForgetLoop(ld[10]);
+  SENode* new_first = analysis.AnalyzeInstruction(def_use->GetDef(35));
+  ASSERT_EQ(new_first->GetType(), SENode::RecurrentAddExpr);
+  EXPECT_EQ(new_first->AsSERecurrentNode()
+                ->GetCoefficient()
+                ->AsSEConstantNode()
+                ->FoldToSingleValue(),
+            2);
+  EXPECT_EQ(analysis.AnalyzeInstruction(def_use->GetDef(45)), second);
+}
+
+TEST_F(ScalarAnalysisTest, ForgetLoopDropsDependentRecurrences) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, TwoLoopsModule("%35"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  Function* f = spvtest::GetFunction(context->module(), 4);
+  LoopDescriptor& ld = *context->GetLoopDescriptor(f);
+  analysis::DefUseManager* def_use = context->get_def_use_mgr();
+  ScalarEvolutionAnalysis analysis{context.get()};
+
+  SENode* first = analysis.AnalyzeInstruction(def_use->GetDef(35));
+  SENode* second = analysis.AnalyzeInstruction(def_use->GetDef(45));
+  ASSERT_EQ(second->GetType(), SENode::RecurrentAddExpr);
+  EXPECT_EQ(second->AsSERecurrentNode()->GetOffset(), first);
+
+  // The second loop starts from the induction variable of the first one, so
+  // it has to be analysed again.
+  analysis.ForgetLoop(ld[10]);
+  SENode* new_first = analysis.AnalyzeInstruction(def_use->GetDef(35));
+  SENode* new_second = analysis.AnalyzeInstruction(def_use->GetDef(45));
+  EXPECT_NE(new_first, first);
+  EXPECT_NE(new_second, second);
+  ASSERT_EQ(new_second->GetType(), SENode::RecurrentAddExpr);
+  EXPECT_EQ(new_second->AsSERecurrentNode()->GetOffset(), new_first);
+}
+
+TEST_F(ScalarAnalysisTest, ContextInvalidatesWithLoopAnalysis) {
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, TwoLoopsModule("%9"),
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  Function* f = spvtest::GetFunction(context->module(), 4);
+  Loop* loop = (*context->GetLoopDescriptor(f))[10];
+
+  context->GetScalarEvolutionAnalysis();
+  context->ForgetScalarEvolutionOfLoop(loop);
+  EXPECT_TRUE(
+      context->AreAnalysesValid(IRContext::kAnalysisScalarEvolution));
+
+  context->InvalidateAnalyses(IRContext::kAnalysisLoopAnalysis, f);
+  EXPECT_FALSE(
+      context->AreAnalysesValid(IRContext::kAnalysisScalarEvolution));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
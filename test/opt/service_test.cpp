@@ -0,0 +1,157 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv-tools/service.hpp"
+
+namespace spvtools {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+std::vector<uint32_t> Assemble(const std::string& text) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(tools.Assemble(text, &binary));
+  return binary;
+}
+
+std::string Disassemble(const std::vector<uint32_t>& binary) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::string text;
+  EXPECT_TRUE(tools.Disassemble(binary, &text));
+  return text;
+}
+
+const char kHeader[] = R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+)";
+
+void WriteWord(std::ostream& out, uint32_t word) {
+  out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+}
+
+uint32_t ReadWord(std::istream& in) {
+  uint32_t word = 0;
+  in.read(reinterpret_cast<char*>(&word), sizeof(word));
+  return word;
+}
+
+void WriteRequest(std::ostream& out, const Service::Request& request) {
+  WriteWord(out, static_cast<uint32_t>(request.kind));
+  WriteWord(out, static_cast<uint32_t>(request.flags.size()));
+  for (const std::string& flag : request.flags) {
+    WriteWord(out, static_cast<uint32_t>(flag.size()));
+    out.write(flag.data(), flag.size());
+  }
+  WriteWord(out, static_cast<uint32_t>(request.binary.size()));
+  for (uint32_t word : request.binary) WriteWord(out, word);
+}
+
+Service::Response ReadResponse(std::istream& in) {
+  Service::Response response;
+  response.success = ReadWord(in) == 0;
+  response.messages.resize(ReadWord(in));
+  in.read(&response.messages[0], response.messages.size());
+  response.binary.resize(ReadWord(in));
+  for (uint32_t& word : response.binary) word = ReadWord(in);
+  return response;
+}
+
+TEST(Service, OptimizesWithTheFlagsOfTheRequest) {
+  Service service(SPV_ENV_UNIVERSAL_1_0, 1);
+  Service::Request request;
+  request.flags = {"--strip-debug"};
+  request.binary = Assemble(std::string(kHeader) +
+                            "OpName %foo \"foo\"\n%foo = OpTypeVoid\n");
+
+  Service::Response response = service.Process(request);
+  EXPECT_TRUE(response.success);
+  EXPECT_THAT(Disassemble(response.binary),
+              Eq(std::string(kHeader) + "%void = OpTypeVoid\n"));
+}
+
+TEST(Service, ReportsInvalidModules) {
+  Service service(SPV_ENV_UNIVERSAL_1_0, 1);
+  Service::Request request;
+  request.kind = Service::RequestKind::kValidate;
+  request.binary = Assemble(std::string(kHeader) + "OpName %foo \"foo\"\n");
+
+  Service::Response response = service.Process(request);
+  EXPECT_FALSE(response.success);
+  EXPECT_THAT(response.messages, HasSubstr("error:"));
+  EXPECT_TRUE(response.binary.empty());
+}
+
+TEST(Service, RejectsUnknownFlags) {
+  Service service(SPV_ENV_UNIVERSAL_1_0, 1);
+  Service::Request request;
+  request.flags = {"--not-a-pass"};
+  request.binary = Assemble(kHeader);
+
+  EXPECT_FALSE(service.Process(request).success);
+}
+
+TEST(Service, AnswersAStreamInOrder) {
+  Service service(SPV_ENV_UNIVERSAL_1_0, 4);
+  std::stringstream in;
+  const uint32_t kNumRequests = 16;
+  for (uint32_t i = 0; i < kNumRequests; ++i) {
+    Service::Request request;
+    if (i % 2) {
+      request.kind = Service::RequestKind::kValidate;
+      request.binary = Assemble(std::string(kHeader) + "OpName %foo \"foo\"\n");
+    } else {
+      request.binary = Assemble(std::string(kHeader) + "OpName %foo \"foo_" +
+                                std::to_string(i) + "\"\n%foo = OpTypeVoid\n");
+    }
+    WriteRequest(in, request);
+  }
+
+  std::stringstream out;
+  EXPECT_TRUE(service.Serve(in, out));
+  for (uint32_t i = 0; i < kNumRequests; ++i) {
+    Service::Response response = ReadResponse(out);
+    if (i % 2) {
+      EXPECT_FALSE(response.success);
+    } else {
+      EXPECT_TRUE(response.success) << response.messages;
+      EXPECT_THAT(Disassemble(response.binary),
+                  HasSubstr("\"foo_" + std::to_string(i) + "\""));
+    }
+  }
+  EXPECT_EQ(out.peek(), std::stringstream::traits_type::eof());
+}
+
+TEST(Service, FailsOnATruncatedStream) {
+  Service service(SPV_ENV_UNIVERSAL_1_0, 1);
+  std::stringstream in;
+  WriteWord(in, static_cast<uint32_t>(Service::RequestKind::kValidate));
+  WriteWord(in, 0);
+  WriteWord(in, 100);
+
+  std::stringstream out;
+  EXPECT_FALSE(service.Serve(in, out));
+  EXPECT_EQ(out.str(), "");
+}
+
+}  // namespace
+}  // namespace spvtools
@@ -0,0 +1,146 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/shader_stats.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+TEST(ShaderStatsTest, WeightsLoopsByTripCount) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %2 "main" %3
+OpExecutionMode %2 OriginUpperLeft
+OpDecorate %3 Location 0
+%6 = OpTypeVoid
+%7 = OpTypeFunction %6
+%8 = OpTypeInt 32 1
+%10 = OpConstant %8 0
+%11 = OpConstant %8 4
+%12 = OpTypeBool
+%13 = OpTypeFloat 32
+%14 = OpTypeInt 32 0
+%15 = OpConstant %14 4
+%16 = OpTypeArray %13 %15
+%17 = OpTypePointer Function %16
+%18 = OpConstant %13 1
+%19 = OpTypePointer Function %13
+%20 = OpConstant %8 1
+%21 = OpTypeVector %13 4
+%22 = OpTypePointer Output %21
+%3 = OpVariable %22 Output
+%2 = OpFunction %6 None %7
+%23 = OpLabel
+%5 = OpVariable %17 Function
+OpBranch %24
+%24 = OpLabel
+%35 = OpPhi %8 %10 %23 %34 %26
+OpLoopMerge %25 %26 None
+OpBranch %27
+%27 = OpLabel
+%29 = OpSLessThan %12 %35 %11
+OpBranchConditional %29 %30 %25
+%30 = OpLabel
+%32 = OpAccessChain %19 %5 %35
+OpStore %32 %18
+OpBranch %26
+%26 = OpLabel
+%34 = OpIAdd %8 %35 %20
+OpBranch %24
+%25 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  std::vector<EntryPointStats> all_stats = ComputeEntryPointStats(&*context);
+  ASSERT_EQ(1u, all_stats.size());
+
+  // The four blocks of the loop run once per iteration.
+  const EntryPointStats& stats = all_stats[0];
+  EXPECT_EQ("main", stats.name);
+  EXPECT_EQ(static_cast<uint32_t>(SpvExecutionModelFragment),
+            stats.execution_model);
+  EXPECT_EQ(12, stats.alu_instructions);
+  EXPECT_EQ(4, stats.memory_instructions);
+  EXPECT_EQ(0, stats.texture_instructions);
+  EXPECT_EQ(18, stats.control_instructions);
+  EXPECT_EQ(0, stats.barriers);
+  EXPECT_EQ(4, stats.dynamic_branches);
+  EXPECT_LT(0u, stats.max_live_registers);
+}
+
+TEST(ShaderStatsTest, CountsCalledFunctions) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+%uint = OpTypeInt 32 0
+%uint_2 = OpConstant %uint 2
+%uint_264 = OpConstant %uint 264
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%1 = OpFunction %void None %3
+%8 = OpLabel
+OpSelectionMerge %9 None
+OpBranchConditional %true %10 %9
+%10 = OpLabel
+%11 = OpFunctionCall %void %12
+OpBranch %9
+%9 = OpLabel
+%13 = OpFunctionCall %void %12
+OpReturn
+OpFunctionEnd
+%12 = OpFunction %void None %3
+%14 = OpLabel
+OpControlBarrier %uint_2 %uint_2 %uint_264
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  std::vector<EntryPointStats> all_stats = ComputeEntryPointStats(&*context);
+  ASSERT_EQ(1u, all_stats.size());
+
+  // The callee is counted once per call, and the branch on a constant is not
+  // dynamic.
+  const EntryPointStats& stats = all_stats[0];
+  EXPECT_EQ(static_cast<uint32_t>(SpvExecutionModelGLCompute),
+            stats.execution_model);
+  EXPECT_EQ(0, stats.alu_instructions);
+  EXPECT_EQ(2, stats.barriers);
+  EXPECT_EQ(7, stats.control_instructions);
+  EXPECT_EQ(0, stats.dynamic_branches);
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
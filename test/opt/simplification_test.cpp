@@ -360,6 +360,55 @@ OpFunctionEnd
   SinglePassRunAndMatch<SimplificationPass>(spirv, true);
 }
 
+TEST_F(SimplificationTest, RetriesOnlyInstructionsThatChanged) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %1 "main"
+OpExecutionMode %1 LocalSize 1 1 1
+%2 = OpTypeVoid
+%3 = OpTypeFunction %2
+%4 = OpTypeInt 32 1
+%5 = OpTypePointer Function %4
+%6 = OpConstant %4 0
+%1 = OpFunction %2 None %3
+%7 = OpLabel
+%8 = OpVariable %5 Function
+%9 = OpLoad %4 %8
+%10 = OpLoad %4 %8
+%11 = OpIAdd %4 %9 %10
+%12 = OpIMul %4 %9 %10
+OpStore %8 %11
+OpStore %8 %12
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_ASSEMBLER_OPTION_PRESERVE_NUMERIC_IDS);
+  ASSERT_NE(nullptr, context);
+  analysis::DefUseManager* def_use_mgr = context->get_def_use_mgr();
+
+  SimplificationPass first;
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, first.Run(context.get()));
+  Instruction* add = def_use_mgr->GetDef(11);
+  Instruction* mul = def_use_mgr->GetDef(12);
+  EXPECT_TRUE(def_use_mgr->IsMarkedUnchanged(add));
+  EXPECT_TRUE(def_use_mgr->IsMarkedUnchanged(mul));
+
+  // Replacing one operand of the add by a constant only invalidates the add.
+  add->SetInOperand(1, {6});
+  context->AnalyzeUses(add);
+  EXPECT_FALSE(def_use_mgr->IsMarkedUnchanged(add));
+  EXPECT_TRUE(def_use_mgr->IsMarkedUnchanged(mul));
+
+  SimplificationPass second;
+  EXPECT_EQ(Pass::Status::SuccessWithChange, second.Run(context.get()));
+  EXPECT_EQ(nullptr, def_use_mgr->GetDef(11));
+  EXPECT_TRUE(def_use_mgr->IsMarkedUnchanged(mul));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -0,0 +1,159 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "test/opt/pass_fixture.h"
+#include "test/opt/pass_utils.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+using SLPVectorizeTest = PassTest<::testing::Test>;
+
+// Returns a fragment shader whose entry point loads the vectors %a and %b,
+// extracts their components into %a0..%a3 and %b0..%b3, then runs |body|.
+std::string Shader(const std::string& body) {
+  std::string text = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in_a %in_b %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in_a "in_a"
+OpName %in_b "in_b"
+OpName %out "out"
+%void = OpTypeVoid
+%void_fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+%v2float = OpTypeVector %float 2
+%v4float = OpTypeVector %float 4
+%float_2 = OpConstant %float 2
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%in_a = OpVariable %_ptr_Input_v4float Input
+%in_b = OpVariable %_ptr_Input_v4float Input
+%out = OpVariable %_ptr_Output_v4float Output
+%main = OpFunction %void None %void_fn
+%entry = OpLabel
+%a = OpLoad %v4float %in_a
+%b = OpLoad %v4float %in_b
+)";
+  for (const char* vec : {"a", "b"}) {
+    for (int i = 0; i < 4; ++i) {
+      text += "%" + std::string(vec) + std::to_string(i) +
+              " = OpCompositeExtract %float %" + vec + " " +
+              std::to_string(i) + "\n";
+    }
+  }
+  return text + body + "OpReturn\nOpFunctionEnd\n";
+}
+
+TEST_F(SLPVectorizeTest, VectorizesComponentWiseAdd) {
+  const std::string check = R"(
+; CHECK: [[a:%\w+]] = OpLoad %v4float %in_a
+; CHECK: [[b:%\w+]] = OpLoad %v4float %in_b
+; CHECK-NOT: OpFAdd %float
+; CHECK: [[sum:%\w+]] = OpFAdd %v4float [[a]] [[b]]
+; CHECK-NOT: OpCompositeConstruct
+; CHECK: OpStore %out [[sum]]
+)";
+  const std::string body = R"(%s0 = OpFAdd %float %a0 %b0
+%s1 = OpFAdd %float %a1 %b1
+%s2 = OpFAdd %float %a2 %b2
+%s3 = OpFAdd %float %a3 %b3
+%v = OpCompositeConstruct %v4float %s0 %s1 %s2 %s3
+OpStore %out %v
+)";
+  SinglePassRunAndMatch<SLPVectorizePass>(check + Shader(body), true);
+}
+
+TEST_F(SLPVectorizeTest, ShufflesPermutedComponents) {
+  const std::string check = R"(
+; CHECK: [[a:%\w+]] = OpLoad %v4float %in_a
+; CHECK: [[b:%\w+]] = OpLoad %v4float %in_b
+; CHECK: [[shuffle:%\w+]] = OpVectorShuffle %v4float [[a]] [[a]] 3 2 1 0
+; CHECK: [[sum:%\w+]] = OpFAdd %v4float [[shuffle]] [[b]]
+; CHECK: OpStore %out [[sum]]
+)";
+  const std::string body = R"(%s0 = OpFAdd %float %a3 %b0
+%s1 = OpFAdd %float %a2 %b1
+%s2 = OpFAdd %float %a1 %b2
+%s3 = OpFAdd %float %a0 %b3
+%v = OpCompositeConstruct %v4float %s0 %s1 %s2 %s3
+OpStore %out %v
+)";
+  SinglePassRunAndMatch<SLPVectorizePass>(check + Shader(body), true);
+}
+
+TEST_F(SLPVectorizeTest, VectorizesTreeWithConstantOperands) {
+  const std::string check = R"(
+; CHECK: [[two:%\w+]] = OpConstantComposite %v4float %float_2 %float_2 %float_2 %float_2
+; CHECK: [[a:%\w+]] = OpLoad %v4float %in_a
+; CHECK: [[b:%\w+]] = OpLoad %v4float %in_b
+; CHECK: [[mul:%\w+]] = OpFMul %v4float [[a]] [[two]]
+; CHECK: [[sum:%\w+]] = OpFAdd %v4float [[mul]] [[b]]
+; CHECK: OpStore %out [[sum]]
+)";
+  const std::string body = R"(%m0 = OpFMul %float %a0 %float_2
+%m1 = OpFMul %float %a1 %float_2
+%m2 = OpFMul %float %a2 %float_2
+%m3 = OpFMul %float %a3 %float_2
+%s0 = OpFAdd %float %m0 %b0
+%s1 = OpFAdd %float %m1 %b1
+%s2 = OpFAdd %float %m2 %b2
+%s3 = OpFAdd %float %m3 %b3
+%v = OpCompositeConstruct %v4float %s0 %s1 %s2 %s3
+OpStore %out %v
+)";
+  SinglePassRunAndMatch<SLPVectorizePass>(check + Shader(body), true);
+}
+
+TEST_F(SLPVectorizeTest, KeepsScalarsWithOtherUses) {
+  const std::string check = R"(
+; CHECK-NOT: OpFAdd %v4float
+; CHECK: OpFAdd %float
+)";
+  const std::string body = R"(%s0 = OpFAdd %float %a0 %b0
+%s1 = OpFAdd %float %a1 %b1
+%s2 = OpFAdd %float %a2 %b2
+%s3 = OpFAdd %float %a3 %b3
+%v = OpCompositeConstruct %v4float %s0 %s1 %s2 %s3
+%w = OpCompositeConstruct %v4float %s0 %s0 %s0 %s0
+OpStore %out %v
+)";
+  auto result =
+      SinglePassRunAndMatch<SLPVectorizePass>(check + Shader(body), true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+TEST_F(SLPVectorizeTest, SkipsUnprofitableGathers) {
+  // Vectorizing saves one multiplication but needs two constructs for the
+  // operands.
+  const std::string check = R"(
+; CHECK-NOT: OpFMul %v2float
+; CHECK: OpFMul %float
+)";
+  const std::string body = R"(%m0 = OpFMul %float %a0 %b0
+%m1 = OpFMul %float %b1 %a1
+%v = OpCompositeConstruct %v2float %m0 %m1
+)";
+  auto result =
+      SinglePassRunAndMatch<SLPVectorizePass>(check + Shader(body), true);
+  EXPECT_EQ(Pass::Status::SuccessWithoutChange, std::get<1>(result));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
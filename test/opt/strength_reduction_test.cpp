@@ -433,6 +433,181 @@ TEST_F(StrengthReductionBasicTest, BasicTestMultipleReplacements) {
       /* skip_nop = */ true, /* do_validate = */ true);
 }
 
+// Test that the multiplication of a loop induction variable by a constant
+// becomes a new induction variable incremented by the product of the step and
+// the constant.
+TEST_F(StrengthReductionBasicTest, ReduceInductionVariableMultiply) {
+  const std::string text = R"(
+; CHECK: [[init:%\w+]] = OpIMul %int %int_0 %int_3
+; CHECK-NEXT: OpBranch [[header:%\w+]]
+; CHECK: [[header]] = OpLabel
+; CHECK-NEXT: [[i:%\w+]] = OpPhi %int %int_0 {{%\w+}} [[next:%\w+]] [[latch:%\w+]]
+; CHECK-NEXT: [[mul:%\w+]] = OpPhi %int [[init]] {{%\w+}} [[mul_next:%\w+]] [[latch]]
+; CHECK-NOT: OpIMul
+; CHECK: OpStore {{%\w+}} [[mul]]
+; CHECK: [[latch]] = OpLabel
+; CHECK-NEXT: [[next]] = OpIAdd %int [[i]] %int_1
+; CHECK-NEXT: [[mul_next]] = OpIAdd %int [[mul]] %int_3
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+        %int = OpTypeInt 32 1
+       %bool = OpTypeBool
+      %int_0 = OpConstant %int 0
+      %int_1 = OpConstant %int 1
+      %int_3 = OpConstant %int 3
+     %int_10 = OpConstant %int 10
+%_ptr_Function_int = OpTypePointer Function %int
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+        %var = OpVariable %_ptr_Function_int Function
+               OpBranch %6
+          %6 = OpLabel
+          %7 = OpPhi %int %int_0 %5 %8 %9
+               OpLoopMerge %10 %9 None
+               OpBranch %11
+         %11 = OpLabel
+         %12 = OpSLessThan %bool %7 %int_10
+               OpBranchConditional %12 %13 %10
+         %13 = OpLabel
+         %14 = OpIMul %int %7 %int_3
+               OpStore %var %14
+               OpBranch %9
+          %9 = OpLabel
+          %8 = OpIAdd %int %7 %int_1
+               OpBranch %6
+         %10 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, false);
+}
+
+// Test that the initial value of an induction variable added to an inner loop
+// whose pre-header is the header of the outer loop goes before the merge
+// instruction of that header.
+TEST_F(StrengthReductionBasicTest, ReduceMultiplyInNestedLoop) {
+  const std::string text = R"(
+; CHECK: OpPhi %int %int_0
+; CHECK-NEXT: [[init:%\w+]] = OpIMul %int %int_0 %int_3
+; CHECK-NEXT: OpLoopMerge
+; CHECK-NEXT: OpBranch [[header:%\w+]]
+; CHECK: [[header]] = OpLabel
+; CHECK-NEXT: [[j:%\w+]] = OpPhi %int %int_0 {{%\w+}} [[next:%\w+]] [[latch:%\w+]]
+; CHECK-NEXT: [[mul:%\w+]] = OpPhi %int [[init]] {{%\w+}} [[mul_next:%\w+]] [[latch]]
+; CHECK-NOT: OpIMul
+; CHECK: OpStore {{%\w+}} [[mul]]
+; CHECK: [[latch]] = OpLabel
+; CHECK-NEXT: [[next]] = OpIAdd %int [[j]] %int_1
+; CHECK-NEXT: [[mul_next]] = OpIAdd %int [[mul]] %int_3
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+        %int = OpTypeInt 32 1
+       %bool = OpTypeBool
+      %int_0 = OpConstant %int 0
+      %int_1 = OpConstant %int 1
+      %int_3 = OpConstant %int 3
+     %int_10 = OpConstant %int 10
+%_ptr_Function_int = OpTypePointer Function %int
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+        %var = OpVariable %_ptr_Function_int Function
+               OpBranch %6
+          %6 = OpLabel
+          %7 = OpPhi %int %int_0 %5 %8 %9
+               OpLoopMerge %10 %9 None
+               OpBranch %20
+         %20 = OpLabel
+         %21 = OpPhi %int %int_0 %6 %22 %23
+               OpLoopMerge %24 %23 None
+               OpBranch %11
+         %11 = OpLabel
+         %12 = OpSLessThan %bool %21 %int_10
+               OpBranchConditional %12 %13 %24
+         %13 = OpLabel
+         %14 = OpIMul %int %21 %int_3
+               OpStore %var %14
+               OpBranch %23
+         %23 = OpLabel
+         %22 = OpIAdd %int %21 %int_1
+               OpBranch %20
+         %24 = OpLabel
+               OpBranch %9
+          %9 = OpLabel
+          %8 = OpIAdd %int %7 %int_1
+         %25 = OpSLessThan %bool %8 %int_10
+               OpBranchConditional %25 %6 %10
+         %10 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, false);
+}
+
+// Test that multiplies of the same induction variable by the same constant
+// share one new induction variable.
+TEST_F(StrengthReductionBasicTest, ReuseReducedInductionVariable) {
+  const std::string text = R"(
+; CHECK: [[header:%\w+]] = OpLabel
+; CHECK-NEXT: OpPhi %int %int_0
+; CHECK-NEXT: [[mul:%\w+]] = OpPhi %int
+; CHECK-NOT: OpPhi
+; CHECK-NOT: OpIMul
+; CHECK: OpStore {{%\w+}} [[mul]]
+; CHECK-NEXT: OpStore {{%\w+}} [[mul]]
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+        %int = OpTypeInt 32 1
+       %bool = OpTypeBool
+      %int_0 = OpConstant %int 0
+      %int_1 = OpConstant %int 1
+      %int_3 = OpConstant %int 3
+     %int_10 = OpConstant %int 10
+%_ptr_Function_int = OpTypePointer Function %int
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+        %var = OpVariable %_ptr_Function_int Function
+               OpBranch %6
+          %6 = OpLabel
+          %7 = OpPhi %int %int_0 %5 %8 %9
+               OpLoopMerge %10 %9 None
+               OpBranch %11
+         %11 = OpLabel
+         %12 = OpSLessThan %bool %7 %int_10
+               OpBranchConditional %12 %13 %10
+         %13 = OpLabel
+         %14 = OpIMul %int %7 %int_3
+               OpStore %var %14
+         %15 = OpIMul %int %int_3 %7
+               OpStore %var %15
+               OpBranch %9
+          %9 = OpLabel
+          %8 = OpIAdd %int %7 %int_1
+               OpBranch %6
+         %10 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<StrengthReductionPass>(text, false);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
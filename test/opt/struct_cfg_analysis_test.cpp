@@ -17,6 +17,7 @@
 #include <string>
 
 #include "gmock/gmock.h"
+#include "source/opt/block_merge_util.h"
 #include "test/opt/assembly_builder.h"
 #include "test/opt/pass_fixture.h"
 #include "test/opt/pass_utils.h"
@@ -28,6 +29,37 @@ namespace {
 using StructCFGAnalysisTest = PassTest<::testing::Test>;
 using ::testing::UnorderedElementsAre;
 
+// Expects |analysis| to find the same constructs as a new analysis of the
+// module of |context|.
+void ExpectSameAsNewAnalysis(IRContext* context,
+                             StructuredCFGAnalysis* analysis) {
+  context->InvalidateAnalyses(IRContext::kAnalysisCFG);
+  StructuredCFGAnalysis expected(context);
+  for (auto& func : *context->module()) {
+    for (auto& bb : func) {
+      const uint32_t id = bb.id();
+      EXPECT_EQ(analysis->ContainingConstruct(id),
+                expected.ContainingConstruct(id))
+          << id;
+      EXPECT_EQ(analysis->ContainingLoop(id), expected.ContainingLoop(id))
+          << id;
+      EXPECT_EQ(analysis->ContainingSwitch(id), expected.ContainingSwitch(id))
+          << id;
+      EXPECT_EQ(analysis->IsInContainingLoopsContinueConstruct(id),
+                expected.IsInContainingLoopsContinueConstruct(id))
+          << id;
+      EXPECT_EQ(analysis->IsMergeBlock(id), expected.IsMergeBlock(id)) << id;
+    }
+  }
+}
+
+// Returns the iterator to the block |id| of |func|.
+Function::iterator FindBlock(Function* func, uint32_t id) {
+  auto bi = func->begin();
+  while (bi->id() != id) ++bi;
+  return bi;
+}
+
 TEST_F(StructCFGAnalysisTest, BBInSelection) {
   const std::string text = R"(
 OpCapability Shader
@@ -1526,6 +1558,138 @@ TEST_F(StructCFGAnalysisTest, SingleBlockLoop) {
 
   EXPECT_TRUE(analysis.IsInContinueConstruct(3));
 }
+
+TEST_F(StructCFGAnalysisTest, MergeHeaderIntoPredecessor) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%bool_undef = OpUndef %bool
+%void_func = OpTypeFunction %void
+%main = OpFunction %void None %void_func
+%1 = OpLabel
+OpSelectionMerge %6 None
+OpBranchConditional %bool_undef %2 %6
+%2 = OpLabel
+OpBranch %3
+%3 = OpLabel
+OpSelectionMerge %5 None
+OpBranchConditional %bool_undef %4 %5
+%4 = OpLabel
+OpBranch %5
+%5 = OpLabel
+OpBranch %6
+%6 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  StructuredCFGAnalysis* analysis = context->GetStructuredCFGAnalysis();
+  EXPECT_EQ(analysis->ContainingConstruct(4), 3);
+
+  Function* func = &*context->module()->begin();
+  blockmergeutil::MergeWithSuccessor(context.get(), func, FindBlock(func, 2));
+
+  // %2 is now the header of the inner selection.
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisStructuredCFG));
+  EXPECT_EQ(analysis->ContainingConstruct(2), 1);
+  EXPECT_EQ(analysis->ContainingConstruct(3), 0);
+  EXPECT_EQ(analysis->ContainingConstruct(4), 2);
+  EXPECT_EQ(analysis->MergeBlock(4), 5);
+  ExpectSameAsNewAnalysis(context.get(), analysis);
+}
+
+TEST_F(StructCFGAnalysisTest, MergeContinueTargetIntoPredecessor) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%bool_undef = OpUndef %bool
+%void_func = OpTypeFunction %void
+%main = OpFunction %void None %void_func
+%1 = OpLabel
+OpBranch %2
+%2 = OpLabel
+OpLoopMerge %5 %4 None
+OpBranchConditional %bool_undef %3 %5
+%3 = OpLabel
+OpBranch %4
+%4 = OpLabel
+OpBranch %2
+%5 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  StructuredCFGAnalysis* analysis = context->GetStructuredCFGAnalysis();
+  EXPECT_FALSE(analysis->IsInContinueConstruct(3));
+
+  Function* func = &*context->module()->begin();
+  blockmergeutil::MergeWithSuccessor(context.get(), func, FindBlock(func, 3));
+
+  // %3 is now the continue target.
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisStructuredCFG));
+  EXPECT_TRUE(analysis->IsContinueBlock(3));
+  EXPECT_TRUE(analysis->IsInContinueConstruct(3));
+  ExpectSameAsNewAnalysis(context.get(), analysis);
+}
+
+TEST_F(StructCFGAnalysisTest, SplitHeader) {
+  const std::string text = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main"
+%void = OpTypeVoid
+%bool = OpTypeBool
+%bool_undef = OpUndef %bool
+%void_func = OpTypeFunction %void
+%main = OpFunction %void None %void_func
+%1 = OpLabel
+%copy = OpCopyObject %bool %bool_undef
+OpSelectionMerge %3 None
+OpBranchConditional %copy %2 %3
+%2 = OpLabel
+OpBranch %3
+%3 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  StructuredCFGAnalysis* analysis = context->GetStructuredCFGAnalysis();
+  EXPECT_EQ(analysis->ContainingConstruct(2), 1);
+
+  BasicBlock* header = &*context->module()->begin()->begin();
+  const uint32_t new_id = context->TakeNextId();
+  BasicBlock* new_block = header->SplitBasicBlock(
+      context.get(), new_id, ++header->begin());
+  header->AddInstruction(MakeUnique<Instruction>(
+      context.get(), SpvOpBranch, 0, 0,
+      std::initializer_list<Operand>{{SPV_OPERAND_TYPE_ID, {new_id}}}));
+  context->set_instr_block(header->terminator(), header);
+  // The CFG does not know about |new_block|.
+  context->InvalidateAnalyses(IRContext::kAnalysisCFG);
+
+  // The merge instruction moved to |new_block|, which now heads the selection.
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisStructuredCFG));
+  EXPECT_EQ(analysis->ContainingConstruct(new_block->id()), 0);
+  EXPECT_EQ(analysis->ContainingConstruct(2), new_id);
+  EXPECT_EQ(analysis->MergeBlock(2), 3);
+  ExpectSameAsNewAnalysis(context.get(), analysis);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
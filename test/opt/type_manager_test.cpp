@@ -1168,6 +1168,42 @@ OpMemoryModel Logical GLSL450
   Match(text, context.get());
 }
 
+TEST(TypeManager, FindPointerToTypeRepeatedQuery) {
+  const std::string text = R"(
+OpCapability Shader
+OpCapability Kernel
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%uint = OpTypeInt 32 0
+%1 = OpTypeStruct %uint
+%2 = OpTypeStruct %uint
+%3 = OpTypePointer Function %2
+  )";
+
+  std::unique_ptr<IRContext> context =
+      BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text,
+                  SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  EXPECT_NE(context, nullptr);
+  TypeManager* type_mgr = context->get_type_mgr();
+
+  EXPECT_EQ(type_mgr->FindPointerToType(2, SpvStorageClassFunction), 3u);
+  EXPECT_EQ(type_mgr->FindPointerToType(2, SpvStorageClassFunction), 3u);
+
+  // A new pointer is created once, then reused.
+  uint32_t private_ptr = type_mgr->FindPointerToType(1, SpvStorageClassPrivate);
+  EXPECT_NE(private_ptr, 0u);
+  EXPECT_EQ(type_mgr->FindPointerToType(1, SpvStorageClassPrivate),
+            private_ptr);
+
+  // Killing the pointer makes the next query build a fresh one.
+  context->KillDef(3);
+  uint32_t new_ptr = type_mgr->FindPointerToType(2, SpvStorageClassFunction);
+  EXPECT_NE(new_ptr, 0u);
+  EXPECT_NE(new_ptr, 3u);
+  EXPECT_EQ(context->get_def_use_mgr()->GetDef(new_ptr)->opcode(),
+            SpvOpTypePointer);
+}
+
 }  // namespace
 }  // namespace analysis
 }  // namespace opt
@@ -383,6 +383,22 @@ TEST(Types, RemoveDecorations) {
   }
 }
 
+TEST(Types, DecorationOrderDoesNotAffectHash) {
+  Integer u32(32, false);
+  Struct a(std::vector<const Type*>{&u32, &u32});
+  a.AddDecoration({SpvDecorationBlock});
+  a.AddDecoration({SpvDecorationGLSLShared});
+  a.AddMemberDecoration(1, {SpvDecorationOffset, 4});
+  a.AddMemberDecoration(1, {SpvDecorationNonWritable});
+  Struct b(std::vector<const Type*>{&u32, &u32});
+  b.AddDecoration({SpvDecorationGLSLShared});
+  b.AddDecoration({SpvDecorationBlock});
+  b.AddMemberDecoration(1, {SpvDecorationNonWritable});
+  b.AddMemberDecoration(1, {SpvDecorationOffset, 4});
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(a.HashValue(), b.HashValue());
+}
+
 }  // namespace
 }  // namespace analysis
 }  // namespace opt
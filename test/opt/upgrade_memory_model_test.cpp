@@ -435,6 +435,105 @@ OpFunctionEnd
   SinglePassRunAndMatch<opt::UpgradeMemoryModel>(text, true);
 }
 
+TEST_F(UpgradeMemoryModelTest, PointerTracedFromSeveralAccesses) {
+  // The trace of %var and of its copy is cached by the first access; the
+  // later accesses must be upgraded exactly as the first ones, and the
+  // accesses to %other, interleaved with them, must stay untouched.
+  const std::string text = R"(
+; CHECK-NOT: OpDecorate
+; CHECK-DAG: [[var:%\w+]] = OpVariable {{%\w+}} Uniform
+; CHECK-DAG: [[other:%\w+]] = OpVariable {{%\w+}} Private
+; CHECK-DAG: [[scope:%\w+]] = OpConstant {{%\w+}} 5
+; CHECK: OpLoad {{%\w+}} [[var]] MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: [[copy:%\w+]] = OpCopyObject {{%\w+}} [[var]]
+; CHECK: OpLoad {{%\w+}} [[other]]{{$}}
+; CHECK: OpLoad {{%\w+}} [[copy]] MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: OpStore [[copy]] {{%\w+}} MakePointerAvailable|NonPrivatePointer [[scope]]
+; CHECK: OpStore [[other]] {{%\w+}}{{$}}
+; CHECK: OpLoad {{%\w+}} [[copy]] MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: OpStore [[var]] {{%\w+}} MakePointerAvailable|NonPrivatePointer [[scope]]
+; CHECK: OpLoad {{%\w+}} [[other]]{{$}}
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %var Coherent
+%void = OpTypeVoid
+%int = OpTypeInt 32 0
+%ptr_int_Uniform = OpTypePointer Uniform %int
+%ptr_int_Private = OpTypePointer Private %int
+%var = OpVariable %ptr_int_Uniform Uniform
+%other = OpVariable %ptr_int_Private Private
+%func_ty = OpTypeFunction %void
+%func = OpFunction %void None %func_ty
+%1 = OpLabel
+%ld1 = OpLoad %int %var
+%copy = OpCopyObject %ptr_int_Uniform %var
+%ld2 = OpLoad %int %other
+%ld3 = OpLoad %int %copy
+OpStore %copy %ld2
+OpStore %other %ld1
+%ld4 = OpLoad %int %copy
+OpStore %var %ld4
+%ld5 = OpLoad %int %other
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<opt::UpgradeMemoryModel>(text, true);
+}
+
+TEST_F(UpgradeMemoryModelTest, PointerTracedThroughCycleFromSeveralAccesses) {
+  // Tracing %ptr_next reaches itself through %phi, so that trace is cut short.
+  // Its partial result must not be reused for the later accesses, which must
+  // all still find the coherent parameter.
+  const std::string text = R"(
+; CHECK-NOT: OpDecorate {{%\w+}} Coherent
+; CHECK: [[scope:%\w+]] = OpConstant {{%\w+}} 5
+; CHECK: OpLoad {{%\w+}} {{%\w+}} MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: OpLoad {{%\w+}} {{%\w+}} MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: OpLoad {{%\w+}} {{%\w+}} MakePointerVisible|NonPrivatePointer [[scope]]
+; CHECK: OpStore {{%\w+}} {{%\w+}} MakePointerAvailable|NonPrivatePointer [[scope]]
+; CHECK: OpStore {{%\w+}} {{%\w+}} MakePointerAvailable|NonPrivatePointer [[scope]]
+OpCapability Shader
+OpCapability Linkage
+OpCapability VariablePointers
+OpExtension "SPV_KHR_variable_pointers"
+OpMemoryModel Logical GLSL450
+OpDecorate %param Coherent
+OpDecorate %param ArrayStride 4
+%void = OpTypeVoid
+%bool = OpTypeBool
+%int = OpTypeInt 32 0
+%int0 = OpConstant %int 0
+%int1 = OpConstant %int 1
+%int10 = OpConstant %int 10
+%ptr_int_StorageBuffer = OpTypePointer StorageBuffer %int
+%func_ty = OpTypeFunction %void %ptr_int_StorageBuffer
+%func = OpFunction %void None %func_ty
+%param = OpFunctionParameter %ptr_int_StorageBuffer
+%1 = OpLabel
+OpBranch %2
+%2 = OpLabel
+%phi = OpPhi %ptr_int_StorageBuffer %param %1 %ptr_next %2
+%iv = OpPhi %int %int0 %1 %inc %2
+%inc = OpIAdd %int %iv %int1
+%ptr_next = OpPtrAccessChain %ptr_int_StorageBuffer %phi %int1
+%ld1 = OpLoad %int %ptr_next
+%ld2 = OpLoad %int %phi
+%cmp = OpIEqual %bool %iv %int10
+OpLoopMerge %3 %2 None
+OpBranchConditional %cmp %3 %2
+%3 = OpLabel
+%ld3 = OpLoad %int %phi
+OpStore %ptr_next %ld1
+OpStore %phi %ld3
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<opt::UpgradeMemoryModel>(text, true);
+}
+
 TEST_F(UpgradeMemoryModelTest, CoherentStructElement) {
   const std::string text = R"(
 ; CHECK-NOT: OpMemberDecorate
@@ -0,0 +1,185 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/opt/value_range_analysis.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "source/opt/build_module.h"
+#include "source/opt/ir_context.h"
+
+namespace spvtools {
+namespace opt {
+namespace {
+
+// The function to analyse is %2, for which instructions and blocks use
+// numeric ids.  %1 is an unknown int.
+const std::string kPreamble = R"(
+OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %2 "main"
+OpExecutionMode %2 OriginUpperLeft
+%void = OpTypeVoid
+%bool = OpTypeBool
+%bool_true = OpConstantTrue %bool
+%int = OpTypeInt 32 1
+%uint = OpTypeInt 32 0
+%void_func = OpTypeFunction %void
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%int_10 = OpConstant %int 10
+%int_15 = OpConstant %int 15
+%int_n1 = OpConstant %int -1
+%uint_4 = OpConstant %uint 4
+%1 = OpUndef %int
+)";
+
+class ValueRangeFixture {
+ public:
+  explicit ValueRangeFixture(const std::string& text)
+      : context_(BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kPreamble + text,
+                             SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS)) {
+  }
+
+  IRContext* context() { return context_.get(); }
+
+  ValueRangeAnalysis* analysis() {
+    return context_->GetValueRangeAnalysis(context_->GetFunction(2));
+  }
+
+  // Returns the range of |id| where used in block |block_id|, or fails the
+  // test if it has none.
+  ValueRangeAnalysis::Range RangeOf(uint32_t id, uint32_t block_id) {
+    ValueRangeAnalysis::Range range = {0, 0};
+    EXPECT_TRUE(analysis()->GetSignedRange(
+        context_->get_def_use_mgr()->GetDef(id),
+        context_->get_instr_block(block_id), &range))
+        << "no range for %" << id;
+    return range;
+  }
+
+  bool HasRange(uint32_t id, uint32_t block_id) {
+    ValueRangeAnalysis::Range range;
+    return analysis()->GetSignedRange(context_->get_def_use_mgr()->GetDef(id),
+                                      context_->get_instr_block(block_id),
+                                      &range);
+  }
+
+ private:
+  std::unique_ptr<IRContext> context_;
+};
+
+TEST(ValueRangeAnalysisTest, Operations) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpBitwiseAnd %int %1 %int_15
+%5 = OpSMod %int %1 %int_10
+%6 = OpIAdd %int %4 %int_1
+%7 = OpISub %int %5 %4
+%8 = OpSelect %int %bool_true %4 %int_n1
+%9 = OpShiftRightLogical %int %1 %int_2
+%10 = OpBitcast %uint %1
+%11 = OpUMod %uint %10 %uint_4
+%12 = OpIAdd %int %1 %int_1
+OpReturn
+OpFunctionEnd
+)";
+
+  ValueRangeFixture f(text);
+  ValueRangeAnalysis::Range range = f.RangeOf(4, 3);
+  EXPECT_EQ(range.min, 0);
+  EXPECT_EQ(range.max, 15);
+  range = f.RangeOf(5, 3);
+  EXPECT_EQ(range.min, 0);
+  EXPECT_EQ(range.max, 9);
+  range = f.RangeOf(6, 3);
+  EXPECT_EQ(range.min, 1);
+  EXPECT_EQ(range.max, 16);
+  range = f.RangeOf(7, 3);
+  EXPECT_EQ(range.min, -15);
+  EXPECT_EQ(range.max, 9);
+  range = f.RangeOf(8, 3);
+  EXPECT_EQ(range.min, -1);
+  EXPECT_EQ(range.max, 15);
+  range = f.RangeOf(9, 3);
+  EXPECT_EQ(range.min, 0);
+  EXPECT_EQ(range.max, (int64_t(1) << 30) - 1);
+  range = f.RangeOf(11, 3);
+  EXPECT_EQ(range.min, 0);
+  EXPECT_EQ(range.max, 3);
+  // Unknown values, and additions which may wrap, have no range.
+  EXPECT_FALSE(f.HasRange(1, 3));
+  EXPECT_FALSE(f.HasRange(12, 3));
+}
+
+TEST(ValueRangeAnalysisTest, InductionVariable) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+OpBranch %4
+%4 = OpLabel
+%5 = OpPhi %int %int_0 %3 %6 %7
+OpLoopMerge %8 %7 None
+%9 = OpSLessThan %bool %5 %int_10
+OpBranchConditional %9 %10 %8
+%10 = OpLabel
+OpBranch %7
+%7 = OpLabel
+%6 = OpIAdd %int %5 %int_1
+OpBranch %4
+%8 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  ValueRangeFixture f(text);
+  // Inside the loop body the induction variable has not reached the bound.
+  ValueRangeAnalysis::Range range = f.RangeOf(5, 10);
+  EXPECT_EQ(range.min, 0);
+  EXPECT_EQ(range.max, 9);
+  range = f.RangeOf(6, 7);
+  EXPECT_EQ(range.min, 1);
+  EXPECT_EQ(range.max, 10);
+  // In the header and after the loop it may have.
+  EXPECT_FALSE(f.HasRange(5, 4));
+  EXPECT_FALSE(f.HasRange(5, 8));
+}
+
+TEST(ValueRangeAnalysisTest, InvalidatedWithDefUse) {
+  const std::string text = R"(
+%2 = OpFunction %void None %void_func
+%3 = OpLabel
+%4 = OpBitwiseAnd %int %1 %int_15
+OpReturn
+OpFunctionEnd
+)";
+
+  ValueRangeFixture f(text);
+  EXPECT_TRUE(f.HasRange(4, 3));
+  EXPECT_TRUE(f.context()->AreAnalysesValid(IRContext::kAnalysisValueRange));
+  f.context()->InvalidateAnalyses(IRContext::kAnalysisDefUse);
+  EXPECT_FALSE(f.context()->AreAnalysesValid(IRContext::kAnalysisValueRange));
+
+  // It is rebuilt on demand.
+  EXPECT_TRUE(f.HasRange(4, 3));
+  EXPECT_TRUE(f.context()->AreAnalysesValid(IRContext::kAnalysisValueRange));
+}
+
+}  // namespace
+}  // namespace opt
+}  // namespace spvtools
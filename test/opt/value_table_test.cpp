@@ -428,6 +428,43 @@ TEST_F(ValueTableTest, DifferentTypes) {
   EXPECT_NE(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst2));
 }
 
+TEST_F(ValueTableTest, AccessChainIndexSignedness) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeFloat 32
+          %6 = OpTypeInt 32 0
+          %7 = OpTypeInt 32 1
+          %8 = OpTypeStruct %5 %5
+          %9 = OpTypePointer Function %8
+         %10 = OpTypePointer Function %5
+         %11 = OpConstant %6 1
+         %12 = OpConstant %7 1
+         %13 = OpConstant %7 0
+          %2 = OpFunction %3 None %4
+         %14 = OpLabel
+         %15 = OpVariable %9 Function
+         %16 = OpAccessChain %10 %15 %11
+         %17 = OpAccessChain %10 %15 %12
+         %18 = OpAccessChain %10 %15 %13
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+  Instruction* inst1 = context->get_def_use_mgr()->GetDef(16);
+  Instruction* inst2 = context->get_def_use_mgr()->GetDef(17);
+  Instruction* inst3 = context->get_def_use_mgr()->GetDef(18);
+  EXPECT_EQ(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst2));
+  EXPECT_NE(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst3));
+}
+
 TEST_F(ValueTableTest, CopyObject) {
   const std::string text = R"(
                OpCapability Shader
@@ -827,6 +864,124 @@ TEST_F(ValueTableTest, DifferentDebugDeclareSameValue) {
   EXPECT_EQ(vtable.GetValueNumber(inst1), vtable.GetValueNumber(inst2));
 }
 
+// Adds a copy of |inst| with a new result id right after it.
+Instruction* AddCopyAfter(IRContext* context, Instruction* inst) {
+  std::unique_ptr<Instruction> copy(inst->Clone(context));
+  copy->SetResultId(context->TakeNextId());
+  Instruction* added = inst->NextNode()->InsertBefore(std::move(copy));
+  context->AnalyzeDefUse(added);
+  context->set_instr_block(added, context->get_instr_block(inst));
+  return added;
+}
+
+TEST_F(ValueTableTest, AddedInstructionSameValue) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeFloat 32
+          %6 = OpTypePointer Function %5
+          %2 = OpFunction %3 None %4
+          %7 = OpLabel
+          %8 = OpVariable %6 Function
+          %9 = OpLoad %5 %8
+         %10 = OpFAdd %5 %9 %9
+         %11 = OpFMul %5 %10 %10
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+  Instruction* add = context->get_def_use_mgr()->GetDef(10);
+  Instruction* mul = context->get_def_use_mgr()->GetDef(11);
+  uint32_t add_value = vtable.GetValueNumber(add);
+  uint32_t mul_value = vtable.GetValueNumber(mul);
+
+  // Build a copy of the multiplication using a copy of the addition, and query
+  // the multiplication first so that both are numbered on this query.
+  Instruction* new_add = AddCopyAfter(context.get(), add);
+  Instruction* new_mul = AddCopyAfter(context.get(), mul);
+  new_mul->SetInOperand(0, {new_add->result_id()});
+  new_mul->SetInOperand(1, {new_add->result_id()});
+  context->AnalyzeUses(new_mul);
+
+  EXPECT_EQ(vtable.GetValueNumber(new_mul), mul_value);
+  EXPECT_EQ(vtable.GetValueNumber(new_add), add_value);
+}
+
+TEST_F(ValueTableTest, KillInstKeepsTableValid) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeFloat 32
+          %6 = OpTypePointer Function %5
+          %2 = OpFunction %3 None %4
+          %7 = OpLabel
+          %8 = OpVariable %6 Function
+          %9 = OpLoad %5 %8
+         %10 = OpFAdd %5 %9 %9
+         %11 = OpFAdd %5 %9 %9
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable* vtable = context->GetValueNumberTable();
+  Instruction* inst1 = context->get_def_use_mgr()->GetDef(10);
+  uint32_t value = vtable->GetValueNumber(inst1);
+  EXPECT_EQ(vtable->GetValueNumber(11), value);
+
+  context->KillInst(context->get_def_use_mgr()->GetDef(11));
+  EXPECT_TRUE(context->AreAnalysesValid(IRContext::kAnalysisValueNumberTable));
+  EXPECT_EQ(vtable->GetValueNumber(AddCopyAfter(context.get(), inst1)), value);
+}
+
+TEST_F(ValueTableTest, FindValueNumberOnlyReadsTheTable) {
+  const std::string text = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %2 "main"
+               OpExecutionMode %2 OriginUpperLeft
+               OpSource GLSL 430
+          %3 = OpTypeVoid
+          %4 = OpTypeFunction %3
+          %5 = OpTypeFloat 32
+          %6 = OpTypePointer Function %5
+          %2 = OpFunction %3 None %4
+          %7 = OpLabel
+          %8 = OpVariable %6 Function
+          %9 = OpLoad %5 %8
+         %10 = OpFAdd %5 %9 %9
+         %11 = OpFAdd %5 %9 %9
+               OpReturn
+               OpFunctionEnd
+  )";
+  auto context = BuildModule(SPV_ENV_UNIVERSAL_1_2, nullptr, text);
+  ValueNumberTable vtable(context.get());
+
+  // Nothing is numbered until it is asked for.
+  EXPECT_EQ(0u, vtable.FindValueNumber(10));
+
+  // Numbering everything numbers the instructions of the functions, but not
+  // their labels, which a lookup must then skip.
+  vtable.NumberAllValues();
+  EXPECT_NE(0u, vtable.FindValueNumber(5));
+  EXPECT_NE(0u, vtable.FindValueNumber(10));
+  EXPECT_EQ(vtable.FindValueNumber(10), vtable.FindValueNumber(11));
+  EXPECT_EQ(0u, vtable.FindValueNumber(7));
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
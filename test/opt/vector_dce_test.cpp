@@ -1351,6 +1351,57 @@ OpFunctionEnd
   SinglePassRunAndMatch<VectorDCE>(text, true);
 }
 
+TEST_F(VectorDCETest, DeadInsertThroughShuffleWithUndefinedComponent) {
+  // The undefined component of the shuffle does not keep any component of its
+  // operands live, so the insert into component 1 is bypassed in both
+  // functions.
+  const std::string text = R"(
+; CHECK: OpFunction
+; CHECK: [[ld:%\w+]] = OpLoad %v4float %In0
+; CHECK: OpVectorShuffle %v4float [[ld]] [[ld]] 0 4294967295 4 4294967295
+; CHECK: OpFunction
+; CHECK: [[ld2:%\w+]] = OpLoad %v4float %In0
+; CHECK: OpVectorShuffle %v4float [[ld2]] [[ld2]] 4294967295 0 4 4294967295
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main" %In0 %OutColor
+               OpExecutionMode %main OriginUpperLeft
+               OpName %main "main"
+               OpName %In0 "In0"
+               OpName %OutColor "OutColor"
+               OpDecorate %In0 Location 0
+               OpDecorate %OutColor Location 0
+       %void = OpTypeVoid
+          %6 = OpTypeFunction %void
+      %float = OpTypeFloat 32
+    %float_1 = OpConstant %float 1
+    %v4float = OpTypeVector %float 4
+%_ptr_Input_v4float = OpTypePointer Input %v4float
+        %In0 = OpVariable %_ptr_Input_v4float Input
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+   %OutColor = OpVariable %_ptr_Output_v4float Output
+       %main = OpFunction %void None %6
+         %10 = OpLabel
+         %11 = OpLoad %v4float %In0
+         %12 = OpCompositeInsert %v4float %float_1 %11 1
+         %13 = OpVectorShuffle %v4float %12 %12 0 4294967295 4 4294967295
+               OpStore %OutColor %13
+         %14 = OpFunctionCall %void %other
+               OpReturn
+               OpFunctionEnd
+      %other = OpFunction %void None %6
+         %20 = OpLabel
+         %21 = OpLoad %v4float %In0
+         %22 = OpCompositeInsert %v4float %float_1 %21 1
+         %23 = OpVectorShuffle %v4float %22 %22 4294967295 0 4 4294967295
+               OpStore %OutColor %23
+               OpReturn
+               OpFunctionEnd
+)";
+
+  SinglePassRunAndMatch<VectorDCE>(text, true);
+}
+
 }  // namespace
 }  // namespace opt
 }  // namespace spvtools
@@ -161,6 +161,24 @@ TEST(ParseWideUnsignedIntegers, Sample) {
   EXPECT_FALSE(ParseNumber("-1", &u64));
 }
 
+// The integer syntax is the one of std::istream with std::setbase(0).
+TEST(ParseIntegerSyntax, Sample) {
+  int32_t i32;
+  EXPECT_TRUE(ParseNumber("+12", &i32));
+  EXPECT_EQ(12, i32);
+  EXPECT_TRUE(ParseNumber(" 12", &i32));
+  EXPECT_EQ(12, i32);
+  EXPECT_TRUE(ParseNumber("010", &i32));
+  EXPECT_EQ(8, i32);
+  EXPECT_TRUE(ParseNumber("0X1f", &i32));
+  EXPECT_EQ(31, i32);
+  EXPECT_FALSE(ParseNumber("12 ", &i32));
+  EXPECT_FALSE(ParseNumber("08", &i32));
+  EXPECT_FALSE(ParseNumber("0xg", &i32));
+  EXPECT_FALSE(ParseNumber("-", &i32));
+  EXPECT_FALSE(ParseNumber("1e3", &i32));
+}
+
 TEST(ParseFloat, Sample) {
   float f;
 
@@ -558,6 +558,130 @@ TEST(ReducerTest, ShaderReduceWhileDivReachable) {
   ASSERT_EQ(status, Reducer::ReductionResultStatus::kComplete);
 }
 
+TEST(ReducerTest, ParallelReductionMatchesSequentialReduction) {
+  SpirvTools t(kEnv);
+  std::vector<uint32_t> binary_in;
+  ASSERT_TRUE(
+      t.Assemble(kShaderWithLoopsDivAndMul, &binary_in, kReduceAssembleOption));
+
+  std::vector<std::vector<uint32_t>> binaries_out;
+  for (uint32_t num_jobs : {1u, 4u}) {
+    Reducer reducer(kEnv);
+    reducer.SetInterestingnessFunction(InterestingWhileSDivReachable);
+    reducer.AddDefaultReductionPasses();
+    reducer.SetMessageConsumer(kMessageConsumer);
+
+    std::vector<uint32_t> binary_out;
+    spvtools::ReducerOptions reducer_options;
+    reducer_options.set_step_limit(500);
+    reducer_options.set_fail_on_validation_error(true);
+    reducer_options.set_num_jobs(num_jobs);
+    spvtools::ValidatorOptions validator_options;
+
+    Reducer::ReductionResultStatus status =
+        reducer.Run(std::vector<uint32_t>(binary_in), &binary_out,
+                    reducer_options, validator_options);
+
+    ASSERT_EQ(status, Reducer::ReductionResultStatus::kComplete);
+    binaries_out.push_back(std::move(binary_out));
+  }
+
+  // Evaluating reduction steps concurrently must not change the outcome.
+  ASSERT_EQ(binaries_out[0], binaries_out[1]);
+}
+
+TEST(ReducerTest, StreamedReductionMatchesReduction) {
+  SpirvTools t(kEnv);
+  std::vector<uint32_t> binary_in;
+  ASSERT_TRUE(
+      t.Assemble(kShaderWithLoopsDivAndMul, &binary_in, kReduceAssembleOption));
+
+  // Reduces |binary_in| on |num_jobs| jobs, recording the binaries reported
+  // as progress if |streamed| holds.
+  auto reduce = [&binary_in](bool streamed, uint32_t num_jobs,
+                             std::vector<std::vector<uint32_t>>* progress,
+                             std::vector<uint32_t>* progress_steps) {
+    Reducer reducer(kEnv);
+    reducer.SetInterestingnessFunction(InterestingWhileSDivReachable);
+    reducer.AddDefaultReductionPasses();
+    reducer.SetMessageConsumer(kMessageConsumer);
+    if (streamed) {
+      reducer.SetProgressFunction(
+          [progress, progress_steps](const std::vector<uint32_t>& binary,
+                                     uint32_t reductions_applied) {
+            progress->push_back(binary);
+            progress_steps->push_back(reductions_applied);
+          });
+    }
+
+    std::vector<uint32_t> binary_out;
+    spvtools::ReducerOptions reducer_options;
+    reducer_options.set_step_limit(500);
+    reducer_options.set_fail_on_validation_error(true);
+    reducer_options.set_num_jobs(num_jobs);
+    spvtools::ValidatorOptions validator_options;
+    EXPECT_EQ(Reducer::ReductionResultStatus::kComplete,
+              reducer.Run(std::vector<uint32_t>(binary_in), &binary_out,
+                          reducer_options, validator_options));
+    return binary_out;
+  };
+
+  std::vector<std::vector<uint32_t>> unused_progress;
+  std::vector<uint32_t> unused_progress_steps;
+  const std::vector<uint32_t> expected =
+      reduce(false, 1, &unused_progress, &unused_progress_steps);
+  ASSERT_TRUE(unused_progress.empty());
+
+  for (uint32_t num_jobs : {1u, 4u}) {
+    std::vector<std::vector<uint32_t>> progress;
+    std::vector<uint32_t> progress_steps;
+    const std::vector<uint32_t> binary_out =
+        reduce(true, num_jobs, &progress, &progress_steps);
+
+    // Streaming the progress must not change the outcome, and the last binary
+    // streamed is the reduced binary.
+    ASSERT_EQ(expected, binary_out);
+    ASSERT_FALSE(progress.empty());
+    ASSERT_EQ(binary_out, progress.back());
+
+    // Each binary streamed is interesting, and is reported with a larger
+    // number of reductions applied than the binary before it.
+    for (uint32_t i = 0; i < progress.size(); i++) {
+      ASSERT_TRUE(InterestingWhileSDivReachable(progress[i], 0));
+      if (i > 0) {
+        ASSERT_LT(progress_steps[i - 1], progress_steps[i]);
+      }
+    }
+  }
+}
+
+TEST(ReducerTest, StopsWhenCancelled) {
+  Reducer reducer(kEnv);
+
+  reducer.SetInterestingnessFunction(InterestingWhileSDivReachable);
+  reducer.AddDefaultReductionPasses();
+  reducer.SetMessageConsumer(kMessageConsumer);
+
+  std::vector<uint32_t> binary_in;
+  SpirvTools t(kEnv);
+
+  ASSERT_TRUE(
+      t.Assemble(kShaderWithLoopsDivAndMul, &binary_in, kReduceAssembleOption));
+  std::vector<uint32_t> binary_out;
+  spvtools::Cancellation cancellation;
+  cancellation.Cancel();
+  spvtools::ReducerOptions reducer_options;
+  reducer_options.set_step_limit(500);
+  reducer_options.set_fail_on_validation_error(true);
+  reducer_options.set_cancellation(&cancellation);
+  spvtools::ValidatorOptions validator_options;
+
+  Reducer::ReductionResultStatus status = reducer.Run(
+      std::move(binary_in), &binary_out, reducer_options, validator_options);
+
+  ASSERT_EQ(status, Reducer::ReductionResultStatus::kCancelled);
+}
+
 // Computes an instruction count for each function in the module represented by
 // |binary|.
 std::unordered_map<uint32_t, uint32_t> GetFunctionInstructionCount(
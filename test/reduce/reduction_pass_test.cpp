@@ -0,0 +1,195 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/reduce/reduction_pass.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/opt/build_module.h"
+#include "source/reduce/reducer.h"
+#include "source/reduce/remove_unused_instruction_reduction_opportunity_finder.h"
+#include "source/util/make_unique.h"
+#include "test/reduce/reduce_test_util.h"
+
+namespace spvtools {
+namespace reduce {
+namespace {
+
+const spv_target_env kEnv = SPV_ENV_UNIVERSAL_1_3;
+
+// An opportunity that only counts how many times it is applied.
+class CountingOpportunity : public ReductionOpportunity {
+ public:
+  explicit CountingOpportunity(uint32_t* num_applied)
+      : num_applied_(num_applied) {}
+
+  bool PreconditionHolds() override { return true; }
+
+ protected:
+  void Apply() override { ++*num_applied_; }
+
+ private:
+  uint32_t* num_applied_;
+};
+
+// Finds |num_opportunities| counting opportunities in any module, so that the
+// size of each chunk the pass applies can be observed.
+class CountingFinder : public ReductionOpportunityFinder {
+ public:
+  CountingFinder(uint32_t num_opportunities, uint32_t* num_applied)
+      : num_opportunities_(num_opportunities), num_applied_(num_applied) {}
+
+  std::vector<std::unique_ptr<ReductionOpportunity>> GetAvailableOpportunities(
+      opt::IRContext*, uint32_t) const override {
+    std::vector<std::unique_ptr<ReductionOpportunity>> result;
+    for (uint32_t i = 0; i < num_opportunities_; ++i) {
+      result.push_back(MakeUnique<CountingOpportunity>(num_applied_));
+    }
+    return result;
+  }
+
+  std::string GetName() const override { return "CountingFinder"; }
+
+ private:
+  const uint32_t num_opportunities_;
+  uint32_t* num_applied_;
+};
+
+// Returns the size of the next chunk |pass| applies to |binary|, or 0 if the
+// round ended.
+uint32_t NextChunkSize(ReductionPass* pass, const std::vector<uint32_t>& binary,
+                       uint32_t* num_applied) {
+  *num_applied = 0;
+  if (pass->TryApplyReduction(binary, 0).empty()) {
+    return 0;
+  }
+  return *num_applied;
+}
+
+TEST(ReductionPassTest, GranularityAdaptsToTheResults) {
+  std::vector<uint32_t> binary;
+  SpirvTools t(kEnv);
+  ASSERT_TRUE(t.Assemble("OpCapability Shader\nOpCapability Linkage\n"
+                         "OpMemoryModel Logical GLSL450\n",
+                         &binary, kReduceAssembleOption));
+  uint32_t num_applied = 0;
+  ReductionPass pass(kEnv, MakeUnique<CountingFinder>(16, &num_applied));
+  pass.SetMessageConsumer(NopDiagnostic);
+
+  // The first chunk holds all the opportunities.  Each round that only fails
+  // halves the granularity.
+  EXPECT_EQ(16u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(false);
+  EXPECT_EQ(0u, NextChunkSize(&pass, binary, &num_applied));
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(false);
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(false);
+  EXPECT_EQ(0u, NextChunkSize(&pass, binary, &num_applied));
+
+  // Two successes in a row double the granularity.
+  EXPECT_EQ(4u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(true);
+  EXPECT_EQ(4u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(true);
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+
+  // A failure in between starts the count of successes again.
+  pass.NotifyInteresting(true);
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(false);
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(true);
+  EXPECT_EQ(8u, NextChunkSize(&pass, binary, &num_applied));
+  pass.NotifyInteresting(false);
+
+  // The round then ends with failures, so the granularity shrinks again, down
+  // to 1.
+  EXPECT_EQ(0u, NextChunkSize(&pass, binary, &num_applied));
+  EXPECT_FALSE(pass.ReachedMinimumGranularity());
+  EXPECT_EQ(4u, NextChunkSize(&pass, binary, &num_applied));
+  for (uint32_t granularity = 4; granularity > 1; granularity /= 2) {
+    for (uint32_t index = granularity; index < 16; index += granularity) {
+      pass.NotifyInteresting(false);
+      EXPECT_EQ(granularity, NextChunkSize(&pass, binary, &num_applied));
+    }
+    pass.NotifyInteresting(false);
+    EXPECT_EQ(0u, NextChunkSize(&pass, binary, &num_applied));
+    EXPECT_EQ(granularity / 2, NextChunkSize(&pass, binary, &num_applied));
+  }
+  EXPECT_TRUE(pass.ReachedMinimumGranularity());
+}
+
+// Returns true if |binary| defines an integer constant with value |value|.
+bool HasConstant(const std::vector<uint32_t>& binary, uint32_t value) {
+  std::unique_ptr<opt::IRContext> context =
+      BuildModule(kEnv, nullptr, binary.data(), binary.size());
+  if (!context) {
+    return false;
+  }
+  for (const auto& inst : context->types_values()) {
+    if (inst.opcode() == SpvOpConstant &&
+        inst.GetSingleWordInOperand(0) == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+TEST(ReductionPassTest, AdaptiveGranularityStillReachesAMinimalModule) {
+  // Every constant can be removed, except the one with value 7, which makes the
+  // module interesting.  Whichever way the granularity moves as chunks succeed
+  // and fail, no constant but that one may be left.
+  std::string original =
+      "OpCapability Shader\nOpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n%1 = OpTypeInt 32 1\n";
+  for (uint32_t value = 0; value < 32; ++value) {
+    original += "%" + std::to_string(value + 2) + " = OpConstant %1 " +
+                std::to_string(value) + "\n";
+  }
+  const std::string expected =
+      "OpCapability Shader\nOpCapability Linkage\n"
+      "OpMemoryModel Logical GLSL450\n%1 = OpTypeInt 32 1\n"
+      "%9 = OpConstant %1 7\n";
+
+  Reducer reducer(kEnv);
+  reducer.SetMessageConsumer(NopDiagnostic);
+  reducer.SetInterestingnessFunction(
+      [](const std::vector<uint32_t>& binary, uint32_t) -> bool {
+        return HasConstant(binary, 7);
+      });
+  reducer.AddReductionPass(
+      MakeUnique<RemoveUnusedInstructionReductionOpportunityFinder>(true));
+
+  std::vector<uint32_t> binary_in;
+  SpirvTools t(kEnv);
+  ASSERT_TRUE(t.Assemble(original, &binary_in, kReduceAssembleOption));
+  std::vector<uint32_t> binary_out;
+  spvtools::ReducerOptions reducer_options;
+  reducer_options.set_step_limit(500);
+  reducer_options.set_fail_on_validation_error(true);
+  spvtools::ValidatorOptions validator_options;
+
+  Reducer::ReductionResultStatus status = reducer.Run(
+      std::move(binary_in), &binary_out, reducer_options, validator_options);
+
+  ASSERT_EQ(status, Reducer::ReductionResultStatus::kComplete);
+  CheckEqual(kEnv, expected, binary_out);
+}
+
+}  // namespace
+}  // namespace reduce
+}  // namespace spvtools
@@ -353,6 +353,50 @@ TEST(RemoveBlockReductionPassTest, UnreachableBlocksWithInsideIdUses) {
   CheckEqual(env, after_op_0_again, context.get());
 }
 
+TEST(RemoveBlockReductionPassTest, TargetConstruct) {
+  // Neither %20 nor %21 is reachable, but only %20 lies between the header and
+  // the merge block of the selection headed by %5.
+  std::string shader = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+         %17 = OpTypeBool
+         %18 = OpConstantTrue %17
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+               OpSelectionMerge %12 None
+               OpBranchConditional %18 %11 %12
+         %11 = OpLabel
+               OpBranch %12
+         %20 = OpLabel
+               OpBranch %12
+         %12 = OpLabel
+               OpReturn
+         %21 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  const auto context = BuildModule(env, nullptr, shader, kReduceAssembleOption);
+  RemoveBlockReductionOpportunityFinder finder;
+  ASSERT_EQ(2, finder.GetAvailableOpportunitiesInConstruct(context.get(), 0, 0)
+                   .size());
+
+  auto ops = finder.GetAvailableOpportunitiesInConstruct(context.get(), 4, 5);
+  ASSERT_EQ(1, ops.size());
+  ASSERT_TRUE(ops[0]->PreconditionHolds());
+  ops[0]->TryToApply();
+  CheckValid(env, context.get());
+  ASSERT_EQ(nullptr, context->get_def_use_mgr()->GetDef(20));
+  ASSERT_NE(nullptr, context->get_def_use_mgr()->GetDef(21));
+}
+
 }  // namespace
 }  // namespace reduce
 }  // namespace spvtools
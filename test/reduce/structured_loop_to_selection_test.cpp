@@ -3623,6 +3623,66 @@ TEST(StructuredLoopToSelectionReductionPassTest,
   ASSERT_EQ(0, ops.size());
 }
 
+TEST(StructuredLoopToSelectionReductionPassTest, TargetConstruct) {
+  // The loop headed by %10 contains the loop headed by %30, and is followed by
+  // the loop headed by %40.
+  std::string shader = R"(
+               OpCapability Shader
+          %1 = OpExtInstImport "GLSL.std.450"
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %4 "main"
+               OpExecutionMode %4 OriginUpperLeft
+               OpSource ESSL 310
+          %2 = OpTypeVoid
+          %3 = OpTypeFunction %2
+         %17 = OpTypeBool
+         %18 = OpConstantTrue %17
+          %4 = OpFunction %2 None %3
+          %5 = OpLabel
+               OpBranch %10
+         %10 = OpLabel
+               OpLoopMerge %12 %13 None
+               OpBranchConditional %18 %30 %12
+         %30 = OpLabel
+               OpLoopMerge %32 %33 None
+               OpBranchConditional %18 %33 %32
+         %33 = OpLabel
+               OpBranch %30
+         %32 = OpLabel
+               OpBranch %13
+         %13 = OpLabel
+               OpBranch %10
+         %12 = OpLabel
+               OpBranch %40
+         %40 = OpLabel
+               OpLoopMerge %42 %43 None
+               OpBranchConditional %18 %43 %42
+         %43 = OpLabel
+               OpBranch %40
+         %42 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  const auto env = SPV_ENV_UNIVERSAL_1_3;
+  const auto context = BuildModule(env, nullptr, shader, kReduceAssembleOption);
+  StructuredLoopToSelectionReductionOpportunityFinder finder;
+  ASSERT_EQ(3, finder.GetAvailableOpportunitiesInConstruct(context.get(), 0, 0)
+                   .size());
+  ASSERT_EQ(2, finder.GetAvailableOpportunitiesInConstruct(context.get(), 4, 10)
+                   .size());
+  ASSERT_EQ(1, finder.GetAvailableOpportunitiesInConstruct(context.get(), 4, 30)
+                   .size());
+
+  auto ops = finder.GetAvailableOpportunitiesInConstruct(context.get(), 4, 40);
+  ASSERT_EQ(1, ops.size());
+  ASSERT_TRUE(ops[0]->PreconditionHolds());
+  ops[0]->TryToApply();
+  CheckValid(env, context.get());
+  ASSERT_EQ(nullptr, context->cfg()->block(40)->GetLoopMergeInst());
+  ASSERT_NE(nullptr, context->cfg()->block(10)->GetLoopMergeInst());
+}
+
 }  // namespace
 }  // namespace reduce
 }  // namespace spvtools
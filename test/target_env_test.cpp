@@ -34,6 +34,19 @@ TEST_P(TargetEnvTest, CreateContext) {
   spvContextDestroy(context);  // Avoid leaking
 }
 
+TEST_P(TargetEnvTest, ContextsShareGrammarTables) {
+  spv_target_env env = GetParam();
+  spv_context first = spvContextCreate(env);
+  spv_context second = spvContextCreate(env);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  EXPECT_EQ(first->opcode_table, second->opcode_table);
+  EXPECT_EQ(first->operand_table, second->operand_table);
+  EXPECT_EQ(first->ext_inst_table, second->ext_inst_table);
+  spvContextDestroy(first);
+  spvContextDestroy(second);
+}
+
 TEST_P(TargetEnvTest, ValidDescription) {
   const char* description = spvTargetEnvDescription(GetParam());
   ASSERT_NE(nullptr, description);
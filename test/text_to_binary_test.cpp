@@ -247,6 +247,138 @@ INSTANTIATE_TEST_SUITE_P(
         {"0x1.804p4", 0x00004e01},
     }));
 
+// Assembles |text| with the given |options| on |num_threads| threads, and
+// returns the binary and the diagnostic, if any.
+std::pair<std::vector<uint32_t>, std::string> AssembleParallel(
+    const std::string& text, uint32_t options, uint32_t num_threads) {
+  ScopedContext context(SPV_ENV_UNIVERSAL_1_3);
+  spv_binary binary = nullptr;
+  spv_diagnostic diagnostic = nullptr;
+  spvTextToBinaryParallel(context.context, text.data(), text.size(), options,
+                          num_threads, &binary, &diagnostic);
+  std::pair<std::vector<uint32_t>, std::string> result;
+  if (binary) {
+    result.first.assign(binary->code, binary->code + binary->wordCount);
+  }
+  if (diagnostic) result.second = diagnostic->error;
+  spvBinaryDestroy(binary);
+  spvDiagnosticDestroy(diagnostic);
+  return result;
+}
+
+using TextToBinaryParallelTest = ::testing::TestWithParam<uint32_t>;
+
+TEST_P(TextToBinaryParallelTest, SameBinaryAsSerial) {
+  // The ids of the functions are first seen in their own functions or in
+  // the functions before them, and some of the local ids are named before
+  // the first function.
+  const std::string input = R"(OpCapability Shader
+%ext = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint GLCompute %main "main"
+OpName %main "main"
+OpName %x "x ; OpFunction"
+OpDecorate %result RelaxedPrecision
+%void = OpTypeVoid
+%int = OpTypeInt 32 1
+%float = OpTypeFloat 32
+%float_1 = OpConstant %float 1
+%int_0 = OpConstant %int 0
+%fn = OpTypeFunction %void
+%fn_float = OpTypeFunction %float %float
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpSelectionMerge %merge None
+OpSwitch %int_0 %merge 1 %case 2 %case
+%case = OpLabel
+%call = OpFunctionCall %float %abs %float_1
+%20 = OpFunctionCall %float %abs %call
+OpBranch %merge
+%merge = OpLabel
+OpReturn
+OpFunctionEnd
+; OpFunction in a comment
+%abs = OpFunction %float None %fn_float
+%x = OpFunctionParameter %float
+%abs_entry = OpLabel
+%result = OpExtInst %float %ext FAbs %x
+%7 = OpFAdd %float %result %float_1
+OpReturnValue %7
+OpFunctionEnd
+%empty = OpFunction %void None %fn
+%empty_entry = OpLabel
+%selector = OpIAdd %int %int_0 %int_0
+OpSelectionMerge %empty_merge None
+OpSwitch %selector %empty_merge 3 %empty_merge
+%empty_merge = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  const uint32_t options = GetParam();
+  const auto serial = AssembleParallel(input, options, 1);
+  ASSERT_FALSE(serial.first.empty()) << serial.second;
+  for (uint32_t num_threads : {2u, 3u, 8u}) {
+    EXPECT_EQ(serial, AssembleParallel(input, options, num_threads))
+        << num_threads << " threads";
+  }
+
+  std::vector<uint32_t> binary;
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_3);
+  EXPECT_TRUE(tools.Assemble(input.data(), input.size(), &binary, options,
+                             /* num_threads = */ 4));
+  EXPECT_EQ(serial.first, binary);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Options, TextToBinaryParallelTest,
+    ::testing::ValuesIn(std::vector<uint32_t>{
+        SPV_TEXT_TO_BINARY_OPTION_NONE,
+        SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS}));
+
+TEST(TextToBinaryParallel, AssemblesSeriallyWhenAFunctionDefinesAType) {
+  const std::string input = R"(%void = OpTypeVoid
+%fn = OpTypeFunction %void
+%main = OpFunction %void None %fn
+%entry = OpLabel
+OpReturn
+OpFunctionEnd
+%int = OpTypeInt 32 0
+%int_7 = OpConstant %int 7
+%other = OpFunction %void None %fn
+%other_entry = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+  const auto serial =
+      AssembleParallel(input, SPV_TEXT_TO_BINARY_OPTION_NONE, 1);
+  ASSERT_FALSE(serial.first.empty()) << serial.second;
+  EXPECT_EQ(serial,
+            AssembleParallel(input, SPV_TEXT_TO_BINARY_OPTION_NONE, 4));
+}
+
+TEST(TextToBinaryParallel, ReportsErrorsLikeSerial) {
+  for (const std::string input : {
+           // Invalid text in the second function.
+           "%void = OpTypeVoid\n%fn = OpTypeFunction %void\n"
+           "%a = OpFunction %void None %fn\nOpFunctionEnd\n"
+           "%b = OpFunction %void None %fn\nOpBogus\nOpFunctionEnd\n",
+           // A value defined in both functions.
+           "%void = OpTypeVoid\n%int = OpTypeInt 32 0\n"
+           "%fn = OpTypeFunction %void\n"
+           "%a = OpFunction %void None %fn\n%v = OpUndef %int\n"
+           "OpFunctionEnd\n"
+           "%b = OpFunction %void None %fn\n%v = OpUndef %int\n"
+           "OpFunctionEnd\n",
+       }) {
+    const auto serial =
+        AssembleParallel(input, SPV_TEXT_TO_BINARY_OPTION_NONE, 1);
+    EXPECT_FALSE(serial.second.empty()) << input;
+    EXPECT_EQ(serial,
+              AssembleParallel(input, SPV_TEXT_TO_BINARY_OPTION_NONE, 4))
+        << input;
+  }
+}
+
 TEST(CreateContext, InvalidEnvironment) {
   spv_target_env env;
   std::memset(&env, 99, sizeof(env));
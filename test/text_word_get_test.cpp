@@ -250,5 +250,21 @@ TEST(TextWordGet, CRLF) {
   EXPECT_STREQ("d", word.c_str());
 }
 
+TEST(TextWordGet, ViewOfTheText) {
+  AutoText input("%abc = OpFoo");
+  AssemblyContext data(input, nullptr);
+  utils::StringView word;
+  spv_position_t pos = {};
+  ASSERT_EQ(SPV_SUCCESS, data.getWord(&word, &pos));
+  EXPECT_EQ(4u, pos.column);
+  EXPECT_EQ(input.str.data(), word.data());
+  EXPECT_EQ("%abc", word.str());
+  data.setPosition(pos);
+  data.advance();
+  ASSERT_EQ(SPV_SUCCESS, data.getWord(&word, &pos));
+  EXPECT_EQ(6u, pos.column);
+  EXPECT_EQ("=", word.str());
+}
+
 }  // namespace
 }  // namespace spvtools
@@ -26,14 +26,18 @@ namespace {
 // CPU/WALL/USR/SYS time, RSS delta, and the delta of the number of page faults.
 class MockTimer : public Timer {
  public:
-  MockTimer(std::ostream* out, bool measure_mem_usage = false)
-      : Timer(out, measure_mem_usage) {}
+  MockTimer(std::ostream* out, bool measure_mem_usage = false,
+            unsigned hardware_counters = 0)
+      : Timer(out, measure_mem_usage, hardware_counters) {}
   double CPUTime() override { return 0.019123; }
   double WallTime() override { return 0.019723; }
   double UserTime() override { return 0.012723; }
   double SystemTime() override { return 0.002723; }
   long RSS() const override { return 360L; }
   long PageFault() const override { return 3600L; }
+  long HardwareCount(HardwareCounter counter) const override {
+    return counter == kHardwareCounterInstructions ? 123456L : -1;
+  }
 };
 
 // This unit test checks whether the actual output of MockTimer::Report() is the
@@ -79,6 +83,27 @@ TEST(MockTimer, TestScopedTimer) {
       buf.str());
 }
 
+// This unit test checks that the requested hardware counters are reported
+// after the times, and that those that cannot be read are reported as "n/a".
+TEST(MockTimer, HardwareCounters) {
+  std::ostringstream buf;
+
+  const unsigned counters =
+      kHardwareCounterInstructions | kHardwareCounterBranchMisses;
+  PrintTimerDescription(&buf, false, counters);
+  {
+    ScopedTimer<MockTimer> scopedtimer(&buf, "CountersTest", false, counters);
+    // Do nothing.
+  }
+
+  EXPECT_EQ(
+      "                     PASS name    CPU time   WALL time    USR time"
+      "    SYS time    instructions   branch misses\n"
+      "                  CountersTest        0.02        0.02        0.01"
+      "        0.00          123456             n/a\n",
+      buf.str());
+}
+
 // A mock class to mimic CumulativeTimer class for a testing purpose. It has
 // fixed CPU/WALL/USR/SYS time, RSS delta, and the delta of the number of page
 // faults for each measurement (i.e., a pair of Start() and Stop()). If the
@@ -166,6 +166,7 @@ class TestPerformanceOptimizationPasses(expect.ValidObjectFile1_5,
       'loop-unroll',
       'eliminate-dead-branches',
       'redundancy-elimination',
+      'partial-redundancy-elimination',
       'combine-access-chains',
       'simplify-instructions',
       'scalar-replacement=100',
@@ -188,6 +189,8 @@ class TestPerformanceOptimizationPasses(expect.ValidObjectFile1_5,
       'eliminate-dead-branches',
       'merge-blocks',
       'simplify-instructions',
+      'schedule-instructions',
+      'canonical-layout',
   ]
   shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
   output = placeholder.TempFileName('output.spv')
@@ -403,3 +406,20 @@ class TestWebGPUToVulkanThenTargetEnvIsInvalid(expect.ReturnCodeIsNonZero, expec
 
   spirv_args = ['--webgpu-to-vulkan', '--target-env=opengl4.0']
   expected_error_substr = 'defines the target environment'
+
+@inside_spirv_testsuite('SpirvOptFlags')
+class TestBatchRequiresOutputDirectory(expect.ReturnCodeIsNonZero, expect.ErrorMessageSubstr):
+  """Tests --batch cannot be used without -o."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  spirv_args = ['--batch', shader]
+  expected_error_substr = '--batch requires -o <directory>'
+
+@inside_spirv_testsuite('SpirvOptFlags')
+class TestMoreThanOneInputNeedsBatch(expect.ReturnCodeIsNonZero, expect.ErrorMessageSubstr):
+  """Tests that only --batch accepts several inputs."""
+
+  shader = placeholder.FileSPIRVShader(empty_main_assembly(), '.spvasm')
+  output = placeholder.TempFileName('output.spv')
+  spirv_args = [shader, shader, '-o', output]
+  expected_error_substr = 'More than one input file specified'
@@ -159,6 +159,60 @@ TEST(BitVectorTest, SubsetOrTest) {
   EXPECT_FALSE(bvec1.Or(bvec2));
 }
 
+TEST(BitVectorTest, AndTest) {
+  BitVector bvec1;
+  bvec1.Set(3);
+  bvec1.Set(4);
+  bvec1.Set(10000);
+
+  BitVector bvec2;
+  bvec2.Set(2);
+  bvec2.Set(4);
+
+  // The bits past the end of |bvec2| are cleared too.
+  EXPECT_TRUE(bvec1.And(bvec2));
+  EXPECT_FALSE(bvec1.Get(2));
+  EXPECT_FALSE(bvec1.Get(3));
+  EXPECT_TRUE(bvec1.Get(4));
+  EXPECT_FALSE(bvec1.Get(10000));
+
+  // |And| returns false if |bvec1| does not change.
+  EXPECT_FALSE(bvec1.And(bvec2));
+}
+
+TEST(BitVectorTest, AndNotTest) {
+  BitVector bvec1;
+  bvec1.Set(3);
+  bvec1.Set(4);
+
+  BitVector bvec2;
+  bvec2.Set(4);
+  bvec2.Set(10000);
+
+  EXPECT_TRUE(bvec1.AndNot(bvec2));
+  EXPECT_TRUE(bvec1.Get(3));
+  EXPECT_FALSE(bvec1.Get(4));
+  EXPECT_FALSE(bvec1.Get(10000));
+
+  // |AndNot| returns false if |bvec1| does not change.
+  EXPECT_FALSE(bvec1.AndNot(bvec2));
+}
+
+TEST(BitVectorTest, CountAndForEachSetBit) {
+  BitVector bvec;
+  EXPECT_EQ(0u, bvec.Count());
+
+  std::vector<uint32_t> set_bits = {0, 3, 63, 64, 127, 10000};
+  for (uint32_t i : set_bits) {
+    bvec.Set(i);
+  }
+  EXPECT_EQ(set_bits.size(), bvec.Count());
+
+  std::vector<uint32_t> visited;
+  bvec.ForEachSetBit([&visited](uint32_t i) { visited.push_back(i); });
+  EXPECT_EQ(set_bits, visited);
+}
+
 }  // namespace
 }  // namespace utils
 }  // namespace spvtools
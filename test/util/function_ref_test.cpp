@@ -0,0 +1,93 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/function_ref.h"
+
+#include <cstdint>
+#include <functional>
+
+#include "gmock/gmock.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+// Returns the sum of |f| called with 1, 2 and 3.
+uint32_t SumOfCalls(FunctionRef<uint32_t(uint32_t)> f) {
+  return f(1) + f(2) + f(3);
+}
+
+// Has overloads like those of the IR visitors, which return the one chosen.
+struct Visitor {
+  const char* Visit(FunctionRef<void(uint32_t*)> f) {
+    uint32_t value = 0;
+    f(&value);
+    return "mutable";
+  }
+  const char* Visit(FunctionRef<void(const uint32_t*)> f) const {
+    const uint32_t value = 0;
+    f(&value);
+    return "const";
+  }
+};
+
+TEST(FunctionRefTest, CallsLambda) {
+  uint32_t calls = 0;
+  EXPECT_EQ(12u, SumOfCalls([&calls](uint32_t x) {
+              ++calls;
+              return x * 2;
+            }));
+  EXPECT_EQ(3u, calls);
+}
+
+TEST(FunctionRefTest, CallsStdFunction) {
+  const std::function<uint32_t(uint32_t)> square = [](uint32_t x) {
+    return x * x;
+  };
+  EXPECT_EQ(14u, SumOfCalls(square));
+}
+
+TEST(FunctionRefTest, CopiesReferToTheSameCallable) {
+  uint32_t calls = 0;
+  auto count = [&calls](uint32_t) {
+    ++calls;
+    return 0u;
+  };
+  FunctionRef<uint32_t(uint32_t)> ref = count;
+  FunctionRef<uint32_t(uint32_t)> copy = ref;
+  SumOfCalls(copy);
+  EXPECT_EQ(3u, calls);
+}
+
+TEST(FunctionRefTest, DiscardsResultForVoid) {
+  uint32_t last = 0;
+  FunctionRef<void(uint32_t)> ref = [&last](uint32_t x) {
+    last = x;
+    return true;
+  };
+  ref(7);
+  EXPECT_EQ(7u, last);
+}
+
+TEST(FunctionRefTest, SelectsOverloadLikeStdFunction) {
+  Visitor visitor;
+  const Visitor& const_visitor = visitor;
+  EXPECT_STREQ("mutable", visitor.Visit([](uint32_t* value) { *value = 1; }));
+  EXPECT_STREQ("mutable", visitor.Visit([](const uint32_t*) {}));
+  EXPECT_STREQ("const", const_visitor.Visit([](const uint32_t*) {}));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
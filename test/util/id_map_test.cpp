@@ -0,0 +1,142 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "source/util/id_map.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+using IdMapTest = ::testing::Test;
+
+TEST(IdMapTest, Empty) {
+  IdMap<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.end(), map.find(1));
+  EXPECT_EQ(0u, map.count(100));
+}
+
+TEST(IdMapTest, InsertAndFind) {
+  IdMap<int> map;
+  map[3] = 30;
+  EXPECT_TRUE(map.insert({10, 100}).second);
+  EXPECT_FALSE(map.insert({10, 200}).second);
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(30, map.at(3));
+  EXPECT_EQ(100, map.at(10));
+  EXPECT_EQ(1u, map.count(3));
+  EXPECT_EQ(0u, map.count(4));
+  EXPECT_EQ(map.end(), map.find(4));
+  EXPECT_EQ(map.end(), map.find(1000));
+
+  auto it = map.find(10);
+  ASSERT_NE(map.end(), it);
+  EXPECT_EQ(10u, it->first);
+  EXPECT_EQ(100, it->second);
+}
+
+TEST(IdMapTest, DefaultValue) {
+  IdMap<std::vector<uint32_t>> map;
+  EXPECT_TRUE(map[5].empty());
+  map[5].push_back(1);
+  EXPECT_EQ(1u, map.size());
+  EXPECT_EQ(std::vector<uint32_t>({1}), map.at(5));
+}
+
+TEST(IdMapTest, Erase) {
+  IdMap<int> map;
+  map[1] = 1;
+  map[2] = 2;
+  map[3] = 3;
+
+  EXPECT_EQ(1u, map.erase(2));
+  EXPECT_EQ(0u, map.erase(2));
+  EXPECT_EQ(0u, map.erase(1000));
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(0u, map.count(2));
+
+  auto next = map.erase(map.find(1));
+  ASSERT_NE(map.end(), next);
+  EXPECT_EQ(3u, next->first);
+  EXPECT_EQ(map.end(), map.erase(next));
+  EXPECT_TRUE(map.empty());
+
+  // The value of an erased entry is reset.
+  EXPECT_EQ(0, map[2]);
+}
+
+TEST(IdMapTest, IterateInIdOrder) {
+  IdMap<int> map;
+  map[7] = 70;
+  map[2] = 20;
+  map[5] = 50;
+
+  std::vector<std::pair<uint32_t, int>> entries(map.begin(), map.end());
+  EXPECT_THAT(entries, ::testing::ElementsAre(std::make_pair(2u, 20),
+                                              std::make_pair(5u, 50),
+                                              std::make_pair(7u, 70)));
+}
+
+TEST(IdMapTest, IteratorsSurviveGrowth) {
+  IdMap<int> map;
+  map.reserve(4);
+  map[2] = 20;
+  auto it = map.find(2);
+  auto end = map.end();
+
+  // Forces the storage to grow past the reserved size.
+  map[10000] = 1;
+
+  EXPECT_EQ(20, it->second);
+  ++it;
+  ASSERT_NE(end, it);
+  EXPECT_EQ(10000u, it->first);
+  ++it;
+  EXPECT_EQ(end, it);
+}
+
+TEST(IdMapTest, Clear) {
+  IdMap<int> map;
+  map[1] = 1;
+  map[200] = 2;
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(0u, map.count(200));
+}
+
+TEST(IdMapTest, Equality) {
+  IdMap<int> lhs;
+  IdMap<int> rhs;
+  lhs.reserve(100);
+  lhs[1] = 1;
+  lhs[50] = 2;
+  rhs[50] = 2;
+  EXPECT_FALSE(lhs == rhs);
+  rhs[1] = 1;
+  EXPECT_TRUE(lhs == rhs);
+  rhs[1] = 3;
+  EXPECT_TRUE(lhs != rhs);
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
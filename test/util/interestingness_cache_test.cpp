@@ -0,0 +1,86 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/interestingness_cache.h"
+
+#include <sstream>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+TEST(InterestingnessCacheTest, DigestDistinguishesBinaries) {
+  const std::string digest = InterestingnessCache::ComputeDigest({1, 2, 3});
+  EXPECT_EQ(digest, InterestingnessCache::ComputeDigest({1, 2, 3}));
+  EXPECT_NE(digest, InterestingnessCache::ComputeDigest({1, 3, 2}));
+  EXPECT_NE(digest, InterestingnessCache::ComputeDigest({1, 2, 3, 0}));
+  EXPECT_NE(InterestingnessCache::ComputeDigest({}),
+            InterestingnessCache::ComputeDigest({0}));
+}
+
+TEST(InterestingnessCacheTest, LookupAndInsert) {
+  InterestingnessCache cache;
+  const std::string a = InterestingnessCache::ComputeDigest({1, 2});
+  const std::string b = InterestingnessCache::ComputeDigest({3, 4});
+  bool verdict = false;
+  EXPECT_FALSE(cache.Lookup(a, &verdict));
+  cache.Insert(a, true);
+  cache.Insert(b, false);
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_TRUE(cache.Lookup(a, &verdict));
+  EXPECT_TRUE(verdict);
+  EXPECT_TRUE(cache.Lookup(b, &verdict));
+  EXPECT_FALSE(verdict);
+  EXPECT_EQ(2u, cache.num_hits());
+}
+
+TEST(InterestingnessCacheTest, SaveAndLoad) {
+  InterestingnessCache first;
+  first.Insert(InterestingnessCache::ComputeDigest({1}), true);
+  first.Insert(InterestingnessCache::ComputeDigest({2}), false);
+  InterestingnessCache second;
+  second.Insert(InterestingnessCache::ComputeDigest({3}), true);
+
+  // Saved caches can be concatenated and loaded together.
+  std::stringstream saved;
+  first.Save(&saved);
+  second.Save(&saved);
+  InterestingnessCache merged;
+  ASSERT_TRUE(merged.Load(&saved));
+  EXPECT_EQ(3u, merged.size());
+  bool verdict = false;
+  EXPECT_TRUE(
+      merged.Lookup(InterestingnessCache::ComputeDigest({2}), &verdict));
+  EXPECT_FALSE(verdict);
+  EXPECT_TRUE(
+      merged.Lookup(InterestingnessCache::ComputeDigest({3}), &verdict));
+  EXPECT_TRUE(verdict);
+}
+
+TEST(InterestingnessCacheTest, LoadRejectsMalformedLines) {
+  std::stringstream saved("00000001abc 1\nnot-a-verdict\n");
+  InterestingnessCache cache;
+  EXPECT_FALSE(cache.Load(&saved));
+  EXPECT_EQ(1u, cache.size());
+
+  std::stringstream bad_verdict("00000001abc 2\n");
+  EXPECT_FALSE(cache.Load(&bad_verdict));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,76 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/name_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+struct Entry {
+  const char* name;
+  int value;
+};
+
+const Entry kEntries[] = {
+    {"Shader", 1}, {"Kernel", 2}, {"ShaderLayer", 3}, {"Kernel", 4}, {"", 5}};
+
+TEST(NameIndex, FindsEntries) {
+  NameIndex index(kEntries, sizeof(kEntries) / sizeof(kEntries[0]));
+  size_t position = 0;
+  EXPECT_TRUE(index.Find("Shader", 6, &position));
+  EXPECT_EQ(0u, position);
+  EXPECT_TRUE(index.Find("ShaderLayer", 11, &position));
+  EXPECT_EQ(2u, position);
+  EXPECT_TRUE(index.Find("", 0, &position));
+  EXPECT_EQ(4u, position);
+}
+
+TEST(NameIndex, FindsFirstOfDuplicateNames) {
+  NameIndex index(kEntries, sizeof(kEntries) / sizeof(kEntries[0]));
+  size_t position = 0;
+  EXPECT_TRUE(index.Find("Kernel", 6, &position));
+  EXPECT_EQ(1u, position);
+}
+
+TEST(NameIndex, NameNeedNotBeNullTerminated) {
+  NameIndex index(kEntries, sizeof(kEntries) / sizeof(kEntries[0]));
+  size_t position = 0;
+  EXPECT_TRUE(index.Find("ShaderLayer", 6, &position));
+  EXPECT_EQ(0u, position);
+  EXPECT_TRUE(index.Find("Kernel Shader", 6, &position));
+  EXPECT_EQ(1u, position);
+}
+
+TEST(NameIndex, MissingNames) {
+  NameIndex index(kEntries, sizeof(kEntries) / sizeof(kEntries[0]));
+  size_t position = 42;
+  EXPECT_FALSE(index.Find("Shade", 5, &position));
+  EXPECT_FALSE(index.Find("Shaders", 7, &position));
+  EXPECT_FALSE(index.Find("shader", 6, &position));
+  EXPECT_EQ(42u, position);
+}
+
+TEST(NameIndex, EmptyTable) {
+  NameIndex index(static_cast<const Entry*>(nullptr), 0);
+  size_t position = 0;
+  EXPECT_FALSE(index.Find("Shader", 6, &position));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,122 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/parallel.h"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+// An executor that keeps the tasks until they are run by |RunAll|.
+class QueueExecutor {
+ public:
+  static void Execute(void* executor, spv_task_fn task, void* task_data) {
+    static_cast<QueueExecutor*>(executor)->tasks_.emplace_back(task,
+                                                               task_data);
+  }
+
+  void RunAll() {
+    for (auto& task : tasks_) task.first(task.second);
+    tasks_.clear();
+  }
+
+  size_t size() const { return tasks_.size(); }
+
+ private:
+  std::vector<std::pair<spv_task_fn, void*>> tasks_;
+};
+
+// An executor that runs each task on a new thread, joined by |JoinAll|.
+class ThreadExecutor {
+ public:
+  static void Execute(void* executor, spv_task_fn task, void* task_data) {
+    static_cast<ThreadExecutor*>(executor)->threads_.emplace_back(task,
+                                                                 task_data);
+  }
+
+  void JoinAll() {
+    for (auto& thread : threads_) thread.join();
+    threads_.clear();
+  }
+
+ private:
+  std::vector<std::thread> threads_;
+};
+
+// Returns work that counts the calls to it in |counts|, handing out the
+// indices of |counts| from |next|.
+std::function<void()> CountingWork(std::vector<std::atomic<int>>* counts,
+                                   std::atomic<size_t>* next) {
+  return [counts, next]() {
+    for (size_t i = (*next)++; i < counts->size(); i = (*next)++) {
+      ++(*counts)[i];
+    }
+  };
+}
+
+TEST(RunOnWorkersTest, RunsOnNewThreadsWithoutExecutor) {
+  std::vector<std::atomic<int>> counts(100);
+  std::atomic<size_t> next(0);
+  RunOnWorkers(4, nullptr, nullptr, CountingWork(&counts, &next));
+  for (const auto& count : counts) EXPECT_EQ(1, count);
+}
+
+TEST(RunOnWorkersTest, DoesNotWaitForTasksThatHaveNotStarted) {
+  std::vector<std::atomic<int>> counts(100);
+  std::atomic<size_t> next(0);
+  QueueExecutor executor;
+  RunOnWorkers(4, &QueueExecutor::Execute, &executor,
+               CountingWork(&counts, &next));
+  for (const auto& count : counts) EXPECT_EQ(1, count);
+
+  // The tasks that start late do nothing.
+  EXPECT_EQ(3u, executor.size());
+  executor.RunAll();
+  for (const auto& count : counts) EXPECT_EQ(1, count);
+}
+
+TEST(RunOnWorkersTest, RunsOnTheTasksOfTheExecutor) {
+  std::vector<std::atomic<int>> counts(10000);
+  std::atomic<size_t> next(0);
+  ThreadExecutor executor;
+  RunOnWorkers(4, &ThreadExecutor::Execute, &executor,
+               CountingWork(&counts, &next));
+  for (const auto& count : counts) EXPECT_EQ(1, count);
+  executor.JoinAll();
+}
+
+TEST(RunAsyncTest, RunsOnTheExecutor) {
+  QueueExecutor executor;
+  std::future<int> result = RunAsync<int>(&QueueExecutor::Execute, &executor,
+                                          []() { return 42; });
+  EXPECT_EQ(1u, executor.size());
+  executor.RunAll();
+  EXPECT_EQ(42, result.get());
+}
+
+TEST(RunAsyncTest, RunsOnANewThreadWithoutExecutor) {
+  std::future<int> result = RunAsync<int>(nullptr, nullptr, []() { return 7; });
+  EXPECT_EQ(7, result.get());
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
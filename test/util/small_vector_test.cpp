@@ -593,6 +593,26 @@ TEST(SmallVectorTest, Resize6) {
   EXPECT_EQ(vec, result);
 }
 
+TEST(SmallVectorTest, Reserve1) {
+  SmallVector<uint32_t, 4> vec = {0, 1};
+  SmallVector<uint32_t, 4> result = {0, 1, 2};
+
+  vec.reserve(4);
+  vec.push_back(2);
+  EXPECT_EQ(vec, result);
+}
+
+TEST(SmallVectorTest, Reserve2) {
+  SmallVector<uint32_t, 2> vec = {0, 1};
+  SmallVector<uint32_t, 2> result = {0, 1, 2, 3};
+
+  vec.reserve(4);
+  EXPECT_EQ(vec.size(), 2);
+  vec.push_back(2);
+  vec.push_back(3);
+  EXPECT_EQ(vec, result);
+}
+
 }  // namespace
 }  // namespace utils
 }  // namespace spvtools
@@ -0,0 +1,63 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "source/util/span.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(SpanTest, DefaultIsEmpty) {
+  Span<const uint32_t> span;
+  EXPECT_TRUE(span.empty());
+  EXPECT_EQ(0u, span.size());
+  EXPECT_EQ(span.begin(), span.end());
+}
+
+TEST(SpanTest, ViewsVector) {
+  const std::vector<uint32_t> words = {1, 2, 3};
+  Span<const uint32_t> span(words);
+  EXPECT_EQ(words.data(), span.data());
+  EXPECT_EQ(3u, span.size());
+  EXPECT_EQ(1u, span.front());
+  EXPECT_EQ(3u, span.back());
+  EXPECT_EQ(2u, span[1]);
+  EXPECT_THAT(std::vector<uint32_t>(span.cbegin() + 1, span.cend()),
+              ElementsAre(2, 3));
+}
+
+TEST(SpanTest, ViewsArray) {
+  const uint32_t words[] = {4, 5};
+  Span<const uint32_t> span(words);
+  EXPECT_EQ(words, span.data());
+  EXPECT_EQ(2u, span.size());
+}
+
+TEST(SpanTest, WritesThroughNonConstElements) {
+  uint32_t words[] = {1, 2, 3};
+  Span<uint32_t> span(words, 2);
+  for (auto& word : span) word *= 10;
+  EXPECT_THAT(words, ElementsAre(10, 20, 3));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "source/util/text_buffer.h"
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+using ::testing::Eq;
+
+TEST(TextBufferTest, Empty) {
+  TextBuffer text;
+  EXPECT_TRUE(text.empty());
+  EXPECT_EQ(0u, text.size());
+  EXPECT_THAT(text.str(), Eq(""));
+}
+
+TEST(TextBufferTest, AppendText) {
+  TextBuffer text;
+  text.Append("Op");
+  text.Append(std::string("Load"));
+  text.Append(' ');
+  text.Append("%12345", 3);
+  text.AppendRepeated(' ', 2);
+  text.AppendRepeated('x', 0);
+  EXPECT_FALSE(text.empty());
+  EXPECT_EQ(12u, text.size());
+  EXPECT_THAT(text.str(), Eq("OpLoad %12  "));
+}
+
+TEST(TextBufferTest, AppendOtherBuffer) {
+  TextBuffer first;
+  first.Append("a");
+  TextBuffer second;
+  second.Append("b");
+  first.Append(second);
+  EXPECT_THAT(first.str(), Eq("ab"));
+  EXPECT_THAT(second.str(), Eq("b"));
+}
+
+TEST(TextBufferTest, AppendUnsigned) {
+  TextBuffer text;
+  text.AppendUnsigned(0);
+  text.Append(' ');
+  text.AppendUnsigned(7);
+  text.Append(' ');
+  text.AppendUnsigned(1234567890);
+  text.Append(' ');
+  text.AppendUnsigned(std::numeric_limits<uint64_t>::max());
+  EXPECT_THAT(text.str(), Eq("0 7 1234567890 18446744073709551615"));
+}
+
+TEST(TextBufferTest, AppendSigned) {
+  TextBuffer text;
+  text.AppendSigned(0);
+  text.Append(' ');
+  text.AppendSigned(-1);
+  text.Append(' ');
+  text.AppendSigned(std::numeric_limits<int32_t>::min());
+  text.Append(' ');
+  text.AppendSigned(std::numeric_limits<int64_t>::min());
+  text.Append(' ');
+  text.AppendSigned(std::numeric_limits<int64_t>::max());
+  EXPECT_THAT(text.str(), Eq("0 -1 -2147483648 -9223372036854775808 "
+                             "9223372036854775807"));
+}
+
+TEST(TextBufferTest, AppendHex) {
+  TextBuffer text;
+  text.AppendHex(0);
+  text.Append(' ');
+  text.AppendHex(0xabc);
+  text.Append(' ');
+  text.AppendHex(0x14, 8);
+  text.Append(' ');
+  text.AppendHex(0x123456789, 4);
+  text.Append(' ');
+  text.AppendHex(std::numeric_limits<uint64_t>::max());
+  EXPECT_THAT(text.str(), Eq("0 abc 00000014 123456789 ffffffffffffffff"));
+}
+
+TEST(TextBufferTest, ClearAndMove) {
+  TextBuffer text;
+  text.Append("OpNop");
+  text.Clear();
+  EXPECT_TRUE(text.empty());
+  text.Append("OpReturn");
+
+  TextBuffer moved(std::move(text));
+  EXPECT_THAT(moved.str(), Eq("OpReturn"));
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,168 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the cache of valid modules.
+
+#include <set>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "source/spirv_validation_cache.h"
+#include "source/spirv_validator_options.h"
+#include "test/unit_spirv.h"
+#include "test/val/val_fixtures.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+using ValidateCache = spvtest::ValidateBase<bool>;
+
+const char kValidModule[] = R"(
+     OpCapability Shader
+     OpCapability Linkage
+     OpMemoryModel Logical GLSL450
+%int = OpTypeInt 32 0
+)";
+
+// Lacks the required OpMemoryModel instruction.
+const char kInvalidModule[] = R"(
+     OpCapability Shader
+     OpCapability Linkage
+%int = OpTypeInt 32 0
+)";
+
+// A backend that remembers the keys in a set, and counts its calls.
+class SetBackend : public ValidationCache::Backend {
+ public:
+  bool Contains(const std::string& key) override {
+    ++num_lookups;
+    return keys.count(key) != 0;
+  }
+  void Insert(const std::string& key) override { keys.insert(key); }
+
+  std::set<std::string> keys;
+  int num_lookups = 0;
+};
+
+std::string KeyOf(const spv_const_binary binary, spv_target_env env,
+                  spv_const_validator_options options) {
+  return spv_validation_cache_t::Key(env, options, binary->code,
+                                     binary->wordCount);
+}
+
+TEST_F(ValidateCache, KeysDependOnTheModuleTheEnvironmentAndTheOptions) {
+  CompileSuccessfully(kValidModule);
+  const std::string key =
+      KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_);
+  EXPECT_EQ(32u, key.size());
+  EXPECT_EQ(key, KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+  EXPECT_NE(key, KeyOf(get_const_binary(), SPV_ENV_VULKAN_1_0, options_));
+
+  spvValidatorOptionsSetNumThreads(options_, 4u);
+  EXPECT_EQ(key, KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+  spvValidatorOptionsSetRelaxBlockLayout(options_, true);
+  EXPECT_NE(key, KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+  spvValidatorOptionsSetRelaxBlockLayout(options_, false);
+  spvValidatorOptionsSetProfile(options_, spv_validator_profile_structural);
+  EXPECT_NE(key, KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+  spvValidatorOptionsSetProfile(options_, spv_validator_profile_full);
+
+  OverwriteAssembledBinary(get_const_binary()->wordCount - 1, 16);
+  EXPECT_NE(key, KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+}
+
+TEST_F(ValidateCache, ForgetsTheLeastRecentlyUsedKeys) {
+  ValidationCache cache(2);
+  spv_validation_cache c_cache = cache;
+  c_cache->Insert("a");
+  c_cache->Insert("b");
+  EXPECT_TRUE(c_cache->Contains("a"));
+  c_cache->Insert("c");
+  EXPECT_TRUE(c_cache->Contains("a"));
+  EXPECT_FALSE(c_cache->Contains("b"));
+  EXPECT_TRUE(c_cache->Contains("c"));
+}
+
+TEST_F(ValidateCache, AddsValidModules) {
+  ValidationCache cache(16);
+  spvValidatorOptionsSetCache(options_, cache);
+  CompileSuccessfully(kValidModule);
+  const spv_validation_cache c_cache = cache;
+  const std::string key =
+      KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_);
+
+  EXPECT_FALSE(c_cache->Contains(key));
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_TRUE(c_cache->Contains(key));
+  EXPECT_FALSE(c_cache->Contains(
+      KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_1, options_)));
+}
+
+TEST_F(ValidateCache, DoesNotAddInvalidModules) {
+  ValidationCache cache(16);
+  spvValidatorOptionsSetCache(options_, cache);
+  CompileSuccessfully(kInvalidModule);
+  const spv_validation_cache c_cache = cache;
+
+  EXPECT_NE(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_FALSE(c_cache->Contains(
+      KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_)));
+  // Validating again reports the same error.
+  const std::string diagnostic = getDiagnosticString();
+  EXPECT_NE(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_EQ(diagnostic, getDiagnosticString());
+}
+
+TEST_F(ValidateCache, SkipsModulesKnownToBeValid) {
+  // Recording an invalid module in the cache shows that the modules the cache
+  // knows are not validated.
+  ValidationCache cache(16);
+  CompileSuccessfully(kInvalidModule);
+  const spv_validation_cache c_cache = cache;
+  c_cache->Insert(KeyOf(get_const_binary(), SPV_ENV_UNIVERSAL_1_0, options_));
+
+  EXPECT_NE(SPV_SUCCESS, ValidateInstructions());
+  spvValidatorOptionsSetCache(options_, cache);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_EQ("", getDiagnosticString());
+  EXPECT_NE(SPV_SUCCESS, ValidateInstructions(SPV_ENV_UNIVERSAL_1_1));
+}
+
+TEST_F(ValidateCache, FallsBackToTheBackend) {
+  SetBackend backend;
+  {
+    ValidationCache cache(0);
+    cache.SetBackend(&backend);
+    spvValidatorOptionsSetCache(options_, cache);
+    CompileSuccessfully(kValidModule);
+    EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+    EXPECT_EQ(1, backend.num_lookups);
+    EXPECT_EQ(1u, backend.keys.size());
+  }
+
+  // A new cache finds the module in the backend, and keeps it in memory.
+  ValidationCache cache(16);
+  cache.SetBackend(&backend);
+  spvValidatorOptionsSetCache(options_, cache);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+  EXPECT_EQ(2, backend.num_lookups);
+  EXPECT_EQ(1u, backend.keys.size());
+  spvValidatorOptionsSetCache(options_, nullptr);
+}
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
@@ -0,0 +1,130 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the index of decorations kept by the validator.
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "source/val/decoration_index.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+TEST(DecorationIndex, EmptyForUndecoratedIds) {
+  DecorationIndex index;
+  index.Reserve(10);
+  EXPECT_TRUE(index.Get(3).empty());
+  EXPECT_TRUE(index.Get(1000).empty());
+  EXPECT_TRUE(index.GetForMember(3, 0).empty());
+  EXPECT_FALSE(index.Has(3, SpvDecorationBlock));
+  EXPECT_EQ(nullptr, index.Find(3, SpvDecorationBlock));
+  EXPECT_TRUE(index.DecoratedIds().empty());
+}
+
+TEST(DecorationIndex, KeepsDecorationsInOrder) {
+  DecorationIndex index;
+  index.Reserve(10);
+  index.Add(5, Decoration(SpvDecorationLocation, {2}));
+  index.Add(5, Decoration(SpvDecorationFlat));
+  index.Add(5, Decoration(SpvDecorationLocation, {3}));
+
+  const auto& decorations = index.Get(5);
+  ASSERT_EQ(3u, decorations.size());
+  EXPECT_EQ(SpvDecorationLocation, decorations[0].dec_type());
+  EXPECT_EQ(SpvDecorationFlat, decorations[1].dec_type());
+  EXPECT_EQ(SpvDecorationLocation, decorations[2].dec_type());
+
+  ASSERT_NE(nullptr, index.Find(5, SpvDecorationLocation));
+  EXPECT_EQ(std::vector<uint32_t>{2},
+            index.Find(5, SpvDecorationLocation)->params());
+  EXPECT_TRUE(index.Has(5, SpvDecorationFlat));
+  EXPECT_FALSE(index.Has(5, SpvDecorationBlock));
+}
+
+TEST(DecorationIndex, AddUniqueSkipsEqualDecorations) {
+  DecorationIndex index;
+  index.Reserve(10);
+  index.AddUnique(5, Decoration(SpvDecorationLocation, {2}));
+  index.AddUnique(5, Decoration(SpvDecorationLocation, {2}));
+  index.AddUnique(5, Decoration(SpvDecorationLocation, {3}));
+  index.AddUnique(5, Decoration(SpvDecorationOffset, {2}, 0));
+  index.AddUnique(5, Decoration(SpvDecorationOffset, {2}, 1));
+  index.AddUnique(5, Decoration(SpvDecorationOffset, {2}, 1));
+  EXPECT_EQ(4u, index.Get(5).size());
+}
+
+TEST(DecorationIndex, BucketsMemberDecorations) {
+  DecorationIndex index;
+  index.Reserve(10);
+  index.Add(7, Decoration(SpvDecorationBlock));
+  index.Add(7, Decoration(SpvDecorationOffset, {0}, 0));
+  index.Add(7, Decoration(SpvDecorationOffset, {16}, 2));
+  index.Add(7, Decoration(SpvDecorationRowMajor, {}, 2));
+
+  EXPECT_EQ(4u, index.Get(7).size());
+  EXPECT_EQ(1u, index.GetForMember(7, 0).size());
+  EXPECT_TRUE(index.GetForMember(7, 1).empty());
+  EXPECT_EQ(2u, index.GetForMember(7, 2).size());
+  EXPECT_TRUE(index.GetForMember(7, 3).empty());
+
+  const Decoration* offset = index.FindForMember(7, 2, SpvDecorationOffset);
+  ASSERT_NE(nullptr, offset);
+  EXPECT_EQ(std::vector<uint32_t>{16}, offset->params());
+  EXPECT_EQ(nullptr, index.FindForMember(7, 1, SpvDecorationOffset));
+  EXPECT_EQ(nullptr, index.FindForMember(7, 0, SpvDecorationBlock));
+  EXPECT_TRUE(index.Has(7, SpvDecorationRowMajor));
+}
+
+TEST(DecorationIndex, HandlesIdsOutsideTheReservedRange) {
+  DecorationIndex index;
+  index.Reserve(10);
+  index.Add(100, Decoration(SpvDecorationFlat));
+  index.Add(0xffffffff, Decoration(SpvDecorationOffset, {4}, 1));
+  index.Add(50, Decoration(SpvDecorationFlat));
+
+  EXPECT_TRUE(index.Has(100, SpvDecorationFlat));
+  EXPECT_TRUE(index.Has(50, SpvDecorationFlat));
+  EXPECT_NE(nullptr, index.FindForMember(0xffffffff, 1, SpvDecorationOffset));
+  EXPECT_FALSE(index.Has(99, SpvDecorationFlat));
+}
+
+TEST(DecorationIndex, ListsDecoratedIdsInIncreasingOrder) {
+  DecorationIndex index;
+  index.Reserve(10);
+  index.Add(200, Decoration(SpvDecorationFlat));
+  index.Add(8, Decoration(SpvDecorationFlat));
+  index.Add(2, Decoration(SpvDecorationFlat));
+  index.Add(20, Decoration(SpvDecorationFlat));
+  index.Add(8, Decoration(SpvDecorationNoPerspective));
+
+  EXPECT_EQ((std::vector<uint32_t>{2, 8, 20, 200}), index.DecoratedIds());
+}
+
+TEST(DecorationIndex, ReferencesSurviveAddingOtherIds) {
+  DecorationIndex index;
+  index.Reserve(4);
+  index.Add(1, Decoration(SpvDecorationFlat));
+  const std::vector<Decoration>& decorations = index.Get(1);
+  for (uint32_t id = 2; id < 1000; ++id) {
+    index.Add(id, Decoration(SpvDecorationFlat));
+  }
+  EXPECT_EQ(&decorations, &index.Get(1));
+  EXPECT_EQ(1u, decorations.size());
+}
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
@@ -2225,6 +2225,81 @@ TEST_F(ValidateDecorations, BlockArrayBaseAlignmentBad) {
           "member 1 at offset 8 is not aligned to 16"));
 }
 
+TEST_F(ValidateDecorations, NestedStructSharedByUniformAndBufferBlocksGood) {
+  // %S has a base alignment of 16 in the uniform block and of 4 in the
+  // buffer block.
+  std::string spirv = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Vertex %main "main"
+               OpSource GLSL 450
+               OpMemberDecorate %S 0 Offset 0
+               OpMemberDecorate %UBO 0 Offset 0
+               OpMemberDecorate %UBO 1 Offset 16
+               OpDecorate %UBO Block
+               OpMemberDecorate %SSBO 0 Offset 0
+               OpMemberDecorate %SSBO 1 Offset 4
+               OpDecorate %SSBO BufferBlock
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+      %float = OpTypeFloat 32
+          %S = OpTypeStruct %float
+        %UBO = OpTypeStruct %float %S
+       %SSBO = OpTypeStruct %float %S
+%_ptr_Uniform_UBO = OpTypePointer Uniform %UBO
+%_ptr_Uniform_SSBO = OpTypePointer Uniform %SSBO
+       %ubo = OpVariable %_ptr_Uniform_UBO Uniform
+      %ssbo = OpVariable %_ptr_Uniform_SSBO Uniform
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+}
+
+TEST_F(ValidateDecorations, NestedStructSharedByUniformAndBufferBlocksBad) {
+  // The buffer block is checked first.  The alignment it computes for %S must
+  // not be used for the uniform block.
+  std::string spirv = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Vertex %main "main"
+               OpSource GLSL 450
+               OpMemberDecorate %S 0 Offset 0
+               OpMemberDecorate %SSBO 0 Offset 0
+               OpMemberDecorate %SSBO 1 Offset 4
+               OpDecorate %SSBO BufferBlock
+               OpMemberDecorate %UBO 0 Offset 0
+               OpMemberDecorate %UBO 1 Offset 4
+               OpDecorate %UBO Block
+       %void = OpTypeVoid
+          %3 = OpTypeFunction %void
+      %float = OpTypeFloat 32
+          %S = OpTypeStruct %float
+       %SSBO = OpTypeStruct %float %S
+        %UBO = OpTypeStruct %float %S
+%_ptr_Uniform_SSBO = OpTypePointer Uniform %SSBO
+%_ptr_Uniform_UBO = OpTypePointer Uniform %UBO
+      %ssbo = OpVariable %_ptr_Uniform_SSBO Uniform
+       %ubo = OpVariable %_ptr_Uniform_UBO Uniform
+       %main = OpFunction %void None %3
+          %5 = OpLabel
+               OpReturn
+               OpFunctionEnd
+  )";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateAndRetrieveValidationState());
+  EXPECT_THAT(
+      getDiagnosticString(),
+      HasSubstr("decorated as Block for variable in Uniform storage class "
+                "must follow standard uniform buffer layout rules: member 1 "
+                "at offset 4 is not aligned to 16"));
+}
+
 TEST_F(ValidateDecorations, BlockArrayBaseAlignmentWithRelaxedLayoutStillBad) {
   // For uniform buffer, Array base alignment is 16, and ArrayStride
   // must be a multiple of 16.  This case uses relaxed block layout.  Relaxed
@@ -3799,6 +3799,30 @@ TEST_F(ValidateImage, ImplicitLodWrongExecutionModel) {
                         "GLCompute execution model"));
 }
 
+TEST_F(ValidateImage, ImplicitLodWrongExecutionModelReportedOncePerOpcode) {
+  const std::string body = R"(
+%img = OpLoad %type_image_f32_2d_0001 %uniform_image_f32_2d_0001
+%sampler = OpLoad %type_sampler %uniform_sampler
+%simg = OpSampledImage %type_sampled_image_f32_2d_0001 %img %sampler
+%res1 = OpImageSampleImplicitLod %f32vec4 %simg %f32vec2_hh
+%res2 = OpImageSampleImplicitLod %f32vec4 %simg %f32vec2_hh
+%res3 = OpImageSampleProjImplicitLod %f32vec4 %simg %f32vec3_hhh
+)";
+
+  CompileSuccessfully(GenerateShaderCode(body, "", "Vertex").c_str());
+  ASSERT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  const std::string diagnostic = getDiagnosticString();
+  const std::string message =
+      "ImplicitLod instructions require Fragment or GLCompute execution "
+      "model: ImageSampleImplicitLod\n";
+  const size_t first = diagnostic.find(message);
+  ASSERT_NE(std::string::npos, first);
+  EXPECT_EQ(std::string::npos, diagnostic.find(message, first + 1));
+  EXPECT_THAT(diagnostic, HasSubstr("ImplicitLod instructions require Fragment "
+                                    "or GLCompute execution model: "
+                                    "ImageSampleProjImplicitLod"));
+}
+
 TEST_F(ValidateImage, ImplicitLodComputeShaderDerivatives) {
   const std::string body = R"(
 %img = OpLoad %type_image_f32_2d_0001 %uniform_image_f32_2d_0001
@@ -143,6 +143,63 @@ TEST_F(ValidateLimits, IdBoundAtInMaxLimit) {
   ASSERT_EQ(SPV_SUCCESS, ValidateInstructions());
 }
 
+// A module with 3 + 2 + 8 = 13 instructions and a function of 3 blocks.
+const std::string kBudgetModule = header + R"(
+%void = OpTypeVoid
+%void_f = OpTypeFunction %void
+%func = OpFunction %void None %void_f
+%entry = OpLabel
+OpBranch %middle
+%middle = OpLabel
+OpBranch %exit
+%exit = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+TEST_F(ValidateLimits, InstructionsWithinBudget) {
+  CompileSuccessfully(kBudgetModule);
+  getValidatorOptions()->universal_limits_.max_instructions = 13;
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateLimits, InstructionsOverBudget) {
+  CompileSuccessfully(kBudgetModule);
+  getValidatorOptions()->universal_limits_.max_instructions = 12;
+  EXPECT_EQ(SPV_ERROR_BUDGET_EXCEEDED, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("The module has 13 instructions, more than the limit "
+                        "of 12."));
+}
+
+TEST_F(ValidateLimits, FunctionBlocksWithinBudget) {
+  CompileSuccessfully(kBudgetModule);
+  getValidatorOptions()->universal_limits_.max_function_blocks = 3;
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateLimits, FunctionBlocksOverBudget) {
+  CompileSuccessfully(kBudgetModule);
+  getValidatorOptions()->universal_limits_.max_function_blocks = 2;
+  EXPECT_EQ(SPV_ERROR_BUDGET_EXCEEDED, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("A function of the module has 3 blocks, more than the "
+                        "limit of 2."));
+}
+
+TEST_F(ValidateLimits, MemoryOverBudget) {
+  CompileSuccessfully(header);
+  // An id bound of 2^20 takes more than 1 MiB of memory for the ids alone.
+  OverwriteAssembledBinary(3, 1u << 20);
+  getValidatorOptions()->universal_limits_.max_memory_kib = 1024;
+  EXPECT_EQ(SPV_ERROR_BUDGET_EXCEEDED, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("KiB, more than the limit of 1024 KiB."));
+
+  getValidatorOptions()->universal_limits_.max_memory_kib = 1024 * 1024;
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
 TEST_F(ValidateLimits, StructNumMembersGood) {
   std::ostringstream spirv;
   spirv << header << R"(
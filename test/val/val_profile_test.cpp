@@ -0,0 +1,162 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the validator profiles.
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "test/unit_spirv.h"
+#include "test/val/val_fixtures.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+using ::testing::HasSubstr;
+
+using ValidateProfile = spvtest::ValidateBase<bool>;
+
+const char kHeader[] = R"(
+     OpCapability Shader
+     OpCapability Linkage
+     OpMemoryModel Logical GLSL450
+)";
+
+const char kTypes[] = R"(
+%void = OpTypeVoid
+  %fn = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+ %one = OpConstant %float 1
+%true = OpConstantTrue %bool
+)";
+
+TEST_F(ValidateProfile, ParseProfileNames) {
+  spv_validator_profile profile = spv_validator_profile_structural;
+  EXPECT_TRUE(spvParseValidatorProfile("full", &profile));
+  EXPECT_EQ(spv_validator_profile_full, profile);
+  EXPECT_TRUE(spvParseValidatorProfile("structural", &profile));
+  EXPECT_EQ(spv_validator_profile_structural, profile);
+  EXPECT_FALSE(spvParseValidatorProfile("fast", &profile));
+  EXPECT_EQ(spv_validator_profile_full, profile);
+  EXPECT_FALSE(spvParseValidatorProfile(nullptr, &profile));
+  EXPECT_EQ(spv_validator_profile_full, profile);
+}
+
+TEST_F(ValidateProfile, StructuralSkipsArithmeticChecks) {
+  const std::string spirv = std::string(kHeader) + kTypes + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+ %sum = OpIAdd %float %one %one
+     OpReturn
+     OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("Expected int scalar or vector type as Result Type"));
+
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateProfile, StructuralSkipsDecorationChecks) {
+  const std::string spirv = std::string(kHeader) + R"(
+     OpDecorate %float Block
+)" + kTypes;
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("Block decoration on a non-struct type"));
+
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_SUCCESS, ValidateInstructions());
+}
+
+TEST_F(ValidateProfile, StructuralChecksIds) {
+  const std::string spirv = std::string(kHeader) + kTypes + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+ %sum = OpFAdd %float %one %missing
+     OpReturn
+     OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(), HasSubstr("has not been defined"));
+}
+
+TEST_F(ValidateProfile, StructuralChecksTypes) {
+  const std::string spirv = std::string(kHeader) + kTypes + R"(
+%v5float = OpTypeVector %float 5
+)";
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("Illegal number of components (5) for TypeVector"));
+}
+
+TEST_F(ValidateProfile, StructuralChecksControlFlow) {
+  const std::string spirv = std::string(kHeader) + kTypes + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+     OpBranch %one
+     OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("'Target Label' operands for OpBranch must be the ID "
+                        "of an OpLabel instruction"));
+}
+
+TEST_F(ValidateProfile, StructuralChecksDominance) {
+  const std::string spirv = std::string(kHeader) + kTypes + R"(
+%main = OpFunction %void None %fn
+%entry = OpLabel
+     OpSelectionMerge %merge None
+     OpBranchConditional %true %then %merge
+%then = OpLabel
+ %sum = OpFAdd %float %one %one
+     OpBranch %merge
+%merge = OpLabel
+ %use = OpFAdd %float %sum %one
+     OpReturn
+     OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  EXPECT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+  EXPECT_THAT(getDiagnosticString(), HasSubstr("does not dominate its use"));
+}
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
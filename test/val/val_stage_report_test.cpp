@@ -0,0 +1,148 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for the reports of the validation stages.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "test/unit_spirv.h"
+#include "test/val/val_fixtures.h"
+
+namespace spvtools {
+namespace val {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+struct Stage {
+  std::string name;
+  double seconds;
+  size_t num_instructions;
+};
+
+class ValidateStageReport : public spvtest::ValidateBase<bool> {
+ public:
+  ValidateStageReport() {
+    spvValidatorOptionsSetStageReport(getValidatorOptions(), Record, &stages_);
+  }
+
+  std::vector<std::string> StageNames() const {
+    std::vector<std::string> names;
+    for (const auto& stage : stages_) names.push_back(stage.name);
+    return names;
+  }
+
+ protected:
+  static void Record(void* user_data, const char* stage, double seconds,
+                     size_t num_instructions) {
+    static_cast<std::vector<Stage>*>(user_data)->push_back(
+        {stage, seconds, num_instructions});
+  }
+
+  std::vector<Stage> stages_;
+};
+
+// 12 instructions.
+const char kModule[] = R"(
+     OpCapability Shader
+     OpCapability Linkage
+     OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+  %fn = OpTypeFunction %void
+%float = OpTypeFloat 32
+ %one = OpConstant %float 1
+%main = OpFunction %void None %fn
+%entry = OpLabel
+ %sum = OpFAdd %float %one %one
+     OpReturn
+     OpFunctionEnd
+)";
+
+TEST_F(ValidateStageReport, ReportsEveryStageInOrder) {
+  CompileSuccessfully(kModule);
+  ASSERT_EQ(SPV_SUCCESS, ValidateInstructions());
+
+  EXPECT_THAT(
+      StageNames(),
+      ElementsAre("parse", "inline-checks", "forward-decls", "reachability",
+                  "id-uses", "misc", "debug", "annotation", "extension",
+                  "mode-setting", "type", "constant", "memory", "function",
+                  "image", "conversion", "composites", "arithmetics",
+                  "bitwise", "logicals", "control-flow", "derivatives",
+                  "atomics", "primitives", "barriers", "non-uniform",
+                  "literals", "adjacency", "entry-points", "cfg", "dominance",
+                  "decorations", "interfaces", "built-ins",
+                  "execution-limitations", "small-type-uses"));
+  for (const auto& stage : stages_) {
+    EXPECT_EQ(12u, stage.num_instructions) << stage.name;
+    EXPECT_LE(0.0, stage.seconds) << stage.name;
+  }
+}
+
+TEST_F(ValidateStageReport, ReportsTheSameInstructionsOnSeveralThreads) {
+  CompileSuccessfully(kModule);
+  spvValidatorOptionsSetNumThreads(getValidatorOptions(), 4u);
+  ASSERT_EQ(SPV_SUCCESS, ValidateInstructions());
+
+  EXPECT_EQ(36u, stages_.size());
+  for (const auto& stage : stages_) {
+    EXPECT_EQ(12u, stage.num_instructions) << stage.name;
+  }
+}
+
+TEST_F(ValidateStageReport, ReportsTheStagesOfTheProfile) {
+  CompileSuccessfully(kModule);
+  spvValidatorOptionsSetProfile(getValidatorOptions(),
+                                spv_validator_profile_structural);
+  ASSERT_EQ(SPV_SUCCESS, ValidateInstructions());
+
+  EXPECT_THAT(StageNames(),
+              ElementsAre("parse", "inline-checks", "forward-decls",
+                          "reachability", "id-uses", "type", "constant",
+                          "function", "control-flow", "adjacency",
+                          "entry-points", "cfg", "dominance"));
+}
+
+TEST_F(ValidateStageReport, StopsAtTheStageThatFails) {
+  const std::string spirv = std::string(kModule) + R"(
+%other = OpFunction %void None %fn
+%label = OpLabel
+     OpBranch %missing
+     OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  ASSERT_EQ(SPV_ERROR_INVALID_ID, ValidateInstructions());
+
+  EXPECT_THAT(StageNames(),
+              ElementsAre("parse", "inline-checks", "forward-decls"));
+}
+
+bool AlwaysCancel(void*) { return true; }
+
+TEST_F(ValidateStageReport, StopsWhenCancelled) {
+  CompileSuccessfully(kModule);
+  spvValidatorOptionsSetCancel(getValidatorOptions(), AlwaysCancel, nullptr);
+  ASSERT_EQ(SPV_ERROR_CANCELLED, ValidateInstructions());
+
+  EXPECT_THAT(getDiagnosticString(),
+              HasSubstr("The validation was cancelled."));
+}
+
+}  // namespace
+}  // namespace val
+}  // namespace spvtools
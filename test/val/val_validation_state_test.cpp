@@ -15,6 +15,7 @@
 // Basic tests for the ValidationState_t datastructure.
 
 #include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "source/spirv_validator_options.h"
@@ -184,6 +185,57 @@ TEST_F(ValidationStateTest, CheckEntryPoints) {
             vstate_->FindDef(vstate_->entry_points()[0])->opcode());
 }
 
+// Tests that the execution models of a function are those of the entry points
+// that can reach it.
+TEST_F(ValidationStateTest, CheckFunctionExecutionModels) {
+  std::string spirv = std::string(kHeader) + R"(
+OpEntryPoint Fragment %1 "frag"
+OpEntryPoint GLCompute %2 "comp"
+OpExecutionMode %1 OriginUpperLeft
+OpExecutionMode %2 LocalSize 1 1 1
+%void = OpTypeVoid
+%void_f = OpTypeFunction %void
+%3 = OpFunction %void None %void_f
+%4 = OpLabel
+OpReturn
+OpFunctionEnd
+%5 = OpFunction %void None %void_f
+%6 = OpLabel
+%7 = OpFunctionCall %void %3
+OpReturn
+OpFunctionEnd
+%1 = OpFunction %void None %void_f
+%8 = OpLabel
+%9 = OpFunctionCall %void %3
+OpReturn
+OpFunctionEnd
+%2 = OpFunction %void None %void_f
+%10 = OpLabel
+%11 = OpFunctionCall %void %5
+OpReturn
+OpFunctionEnd
+)";
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+
+  using Models = std::vector<SpvExecutionModel>;
+  EXPECT_EQ((Models{SpvExecutionModelFragment, SpvExecutionModelGLCompute}),
+            vstate_->FunctionExecutionModels(3));
+  EXPECT_EQ(Models{SpvExecutionModelGLCompute},
+            vstate_->FunctionExecutionModels(5));
+  EXPECT_EQ(Models{SpvExecutionModelFragment},
+            vstate_->FunctionExecutionModels(1));
+  EXPECT_TRUE(vstate_->FunctionExecutionModels(4).empty());
+
+  EXPECT_TRUE(
+      vstate_->FunctionHasExecutionModel(3, SpvExecutionModelFragment));
+  EXPECT_TRUE(
+      vstate_->FunctionHasExecutionModel(5, SpvExecutionModelGLCompute));
+  EXPECT_FALSE(
+      vstate_->FunctionHasExecutionModel(5, SpvExecutionModelFragment));
+  EXPECT_FALSE(vstate_->FunctionHasExecutionModel(3, SpvExecutionModelVertex));
+}
+
 TEST_F(ValidationStateTest, CheckStructMemberLimitOption) {
   spvValidatorOptionsSetUniversalLimit(
       options_, spv_validator_limit_max_struct_members, 32000u);
@@ -232,6 +284,220 @@ TEST_F(ValidationStateTest, CheckAccessChainIndexesLimitOption) {
   EXPECT_EQ(100u, options_->universal_limits_.max_access_chain_indexes);
 }
 
+TEST_F(ValidationStateTest, ContainsSizedIntOrFloatTypeOfNestedTypes) {
+  const std::string spirv = R"(
+OpCapability Shader
+OpCapability Linkage
+OpCapability Int16
+OpCapability Float64
+OpMemoryModel Logical GLSL450
+%1 = OpTypeInt 16 1
+%2 = OpTypeFloat 64
+%3 = OpTypeVector %2 2
+%4 = OpTypeInt 32 0
+%5 = OpConstant %4 4
+%6 = OpTypeArray %1 %5
+%7 = OpTypeStruct %3 %6
+%8 = OpTypeStruct %7
+%9 = OpTypePointer Function %8
+%10 = OpTypeFunction %4 %9
+%11 = OpTypeFloat 32
+)";
+
+  CompileSuccessfully(spirv);
+  ASSERT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  EXPECT_TRUE(vstate_->ContainsSizedIntOrFloatType(8, SpvOpTypeInt, 16));
+  EXPECT_TRUE(vstate_->ContainsSizedIntOrFloatType(8, SpvOpTypeFloat, 64));
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(8, SpvOpTypeInt, 32));
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(8, SpvOpTypeFloat, 16));
+  EXPECT_TRUE(vstate_->ContainsSizedIntOrFloatType(10, SpvOpTypeInt, 32));
+  EXPECT_TRUE(vstate_->ContainsSizedIntOrFloatType(10, SpvOpTypeInt, 16));
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(6, SpvOpTypeFloat, 64));
+  EXPECT_TRUE(vstate_->ContainsSizedIntOrFloatType(11, SpvOpTypeFloat, 32));
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(11, SpvOpTypeInt, 32));
+  // Constants are not types.
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(5, SpvOpTypeInt, 32));
+  EXPECT_FALSE(vstate_->ContainsSizedIntOrFloatType(1, SpvOpTypeInt, 24));
+}
+
+TEST_F(ValidationStateTest, CheckNumThreadsOption) {
+  EXPECT_EQ(1u, options_->num_threads);
+  spvValidatorOptionsSetNumThreads(options_, 4u);
+  EXPECT_EQ(4u, options_->num_threads);
+}
+
+TEST_F(ValidationStateTest, CheckParallelNonRecursiveBodyGood) {
+  std::string spirv = std::string(kHeader) + kNonRecursiveBody;
+  spvValidatorOptionsSetNumThreads(options_, 4u);
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+}
+
+TEST_F(ValidationStateTest, CheckParallelReportsFirstError) {
+  // The second and the fourth functions are invalid.  Every number of threads
+  // reports the error in the second function.
+  std::string spirv = std::string(kHeader) + R"(
+%void   = OpTypeVoid
+%void_f = OpTypeFunction %void
+%int    = OpTypeInt 32 0
+%float  = OpTypeFloat 32
+%int_1  = OpConstant %int 1
+%float_1 = OpConstant %float 1
+%func_1 = OpFunction %void None %void_f
+%label_1 = OpLabel
+%add_1  = OpIAdd %int %int_1 %int_1
+          OpReturn
+          OpFunctionEnd
+%func_2 = OpFunction %void None %void_f
+%label_2 = OpLabel
+%add_2  = OpIAdd %float %float_1 %float_1
+          OpReturn
+          OpFunctionEnd
+%func_3 = OpFunction %void None %void_f
+%label_3 = OpLabel
+%add_3  = OpFAdd %float %float_1 %float_1
+          OpReturn
+          OpFunctionEnd
+%func_4 = OpFunction %void None %void_f
+%label_4 = OpLabel
+%add_4  = OpFAdd %int %int_1 %int_1
+          OpReturn
+          OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  const std::string serial_diagnostic = getDiagnosticString();
+  EXPECT_THAT(serial_diagnostic,
+              HasSubstr("Expected int scalar or vector type as Result Type"));
+
+  for (uint32_t num_threads : {2u, 3u, 4u, 8u}) {
+    spvValidatorOptionsSetNumThreads(options_, num_threads);
+    EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+    EXPECT_EQ(serial_diagnostic, getDiagnosticString());
+  }
+}
+
+TEST_F(ValidationStateTest, CheckParallelReportsFirstCfgError) {
+  // The blocks of the second function appear before their dominators.
+  std::string spirv = std::string(kHeader) + R"(
+%void   = OpTypeVoid
+%void_f = OpTypeFunction %void
+%func_1 = OpFunction %void None %void_f
+%entry_1 = OpLabel
+          OpBranch %exit_1
+%exit_1 = OpLabel
+          OpReturn
+          OpFunctionEnd
+%func_2 = OpFunction %void None %void_f
+%entry_2 = OpLabel
+          OpBranch %middle_2
+%exit_2 = OpLabel
+          OpReturn
+%middle_2 = OpLabel
+          OpBranch %exit_2
+          OpFunctionEnd
+%func_3 = OpFunction %void None %void_f
+%entry_3 = OpLabel
+          OpBranch %middle_3
+%exit_3 = OpLabel
+          OpReturn
+%middle_3 = OpLabel
+          OpBranch %exit_3
+          OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_CFG, ValidateInstructions());
+  const std::string serial_diagnostic = getDiagnosticString();
+  EXPECT_THAT(serial_diagnostic,
+              HasSubstr("appears in the binary before its dominator"));
+
+  spvValidatorOptionsSetNumThreads(options_, 3u);
+  EXPECT_EQ(SPV_ERROR_INVALID_CFG, ValidateInstructions());
+  EXPECT_EQ(serial_diagnostic, getDiagnosticString());
+}
+
+TEST_F(ValidationStateTest, CheckParallelReportsFirstErrorOfSmallFunction) {
+  // The larger second function is checked first on several threads, but the
+  // error of the smaller first function is still the one reported.
+  std::string large_body;
+  for (int i = 0; i < 32; ++i) {
+    large_body += "%large_" + std::to_string(i) +
+                  " = OpFAdd %float %float_1 %float_1\n";
+  }
+  std::string spirv = std::string(kHeader) + R"(
+%void   = OpTypeVoid
+%void_f = OpTypeFunction %void
+%int    = OpTypeInt 32 0
+%float  = OpTypeFloat 32
+%int_1  = OpConstant %int 1
+%float_1 = OpConstant %float 1
+%func_1 = OpFunction %void None %void_f
+%label_1 = OpLabel
+%add_1  = OpIAdd %float %float_1 %float_1
+          OpReturn
+          OpFunctionEnd
+%func_2 = OpFunction %void None %void_f
+%label_2 = OpLabel
+)" + large_body + R"(
+%add_2  = OpFAdd %int %int_1 %int_1
+          OpReturn
+          OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  const std::string serial_diagnostic = getDiagnosticString();
+  EXPECT_THAT(serial_diagnostic,
+              HasSubstr("Expected int scalar or vector type as Result Type"));
+
+  for (uint32_t num_threads : {2u, 4u}) {
+    spvValidatorOptionsSetNumThreads(options_, num_threads);
+    EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+    EXPECT_EQ(serial_diagnostic, getDiagnosticString());
+  }
+}
+
+TEST_F(ValidationStateTest, CheckParallelReportsFirstModuleStageError) {
+  // The adjacency check fails in the first function and the CFG checks fail
+  // in the second one.  The error of the adjacency check is reported first
+  // when these run one after the other, and so on every number of threads.
+  std::string spirv = std::string(kHeader) + R"(
+%void   = OpTypeVoid
+%void_f = OpTypeFunction %void
+%int    = OpTypeInt 32 0
+%int_1  = OpConstant %int 1
+%int_ptr = OpTypePointer Function %int
+%func_1 = OpFunction %void None %void_f
+%entry_1 = OpLabel
+%add_1  = OpIAdd %int %int_1 %int_1
+%var_1  = OpVariable %int_ptr Function
+          OpReturn
+          OpFunctionEnd
+%func_2 = OpFunction %void None %void_f
+%entry_2 = OpLabel
+          OpBranch %middle_2
+%exit_2 = OpLabel
+          OpReturn
+%middle_2 = OpLabel
+          OpBranch %exit_2
+          OpFunctionEnd
+)";
+
+  CompileSuccessfully(spirv);
+  EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+  const std::string serial_diagnostic = getDiagnosticString();
+  EXPECT_THAT(serial_diagnostic,
+              HasSubstr("All OpVariable instructions in a function must be"));
+
+  for (uint32_t num_threads : {2u, 3u, 4u, 8u}) {
+    spvValidatorOptionsSetNumThreads(options_, num_threads);
+    EXPECT_EQ(SPV_ERROR_INVALID_DATA, ValidateInstructions());
+    EXPECT_EQ(serial_diagnostic, getDiagnosticString());
+  }
+}
+
 TEST_F(ValidationStateTest, CheckNonRecursiveBodyGood) {
   std::string spirv = std::string(kHeader) + kNonRecursiveBody;
   CompileSuccessfully(spirv);
@@ -356,6 +622,42 @@ OpEntryPoint Vertex %func_1 "main"
                 "in WebGPU env.\n  %1 = OpFunction %void None %3\n"));
 }
 
+TEST_F(ValidationStateTest, InstructionWordsReferenceTheModule) {
+  CompileSuccessfully(std::string(kHeader) + kVoidFVoid);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+
+  const uint32_t* begin = get_const_binary()->code;
+  const uint32_t* end = begin + get_const_binary()->wordCount;
+  for (const auto& inst : vstate_->ordered_instructions()) {
+    EXPECT_LE(begin, inst.words().data());
+    EXPECT_GE(end, inst.words().data() + inst.words().size());
+    EXPECT_EQ(inst.words().size(), inst.c_inst().num_words);
+  }
+}
+
+TEST_F(ValidationStateTest, InstructionWordsOfSwappedModuleAreConverted) {
+  CompileSuccessfully(std::string(kHeader) + kVoidFVoid);
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+  std::vector<std::vector<uint32_t>> expected_words;
+  for (const auto& inst : vstate_->ordered_instructions()) {
+    expected_words.emplace_back(inst.words().begin(), inst.words().end());
+  }
+
+  const size_t num_words = get_const_binary()->wordCount;
+  for (uint32_t i = 0; i < num_words; ++i) {
+    const uint32_t word = get_const_binary()->code[i];
+    OverwriteAssembledBinary(i, (word >> 24) | ((word >> 8) & 0xff00) |
+                                    ((word << 8) & 0xff0000) | (word << 24));
+  }
+  EXPECT_EQ(SPV_SUCCESS, ValidateAndRetrieveValidationState());
+
+  std::vector<std::vector<uint32_t>> words;
+  for (const auto& inst : vstate_->ordered_instructions()) {
+    words.emplace_back(inst.words().begin(), inst.words().end());
+  }
+  EXPECT_EQ(expected_words, words);
+}
+
 }  // namespace
 }  // namespace val
 }  // namespace spvtools
@@ -44,6 +44,11 @@ Options:
                   starting with 1 and going up.
   --target-env    {%s}
                   Use specified environment.
+  --compress      Write the module in compressed form, which spirv-dis reads
+                  with its --compressed option.  See spvBinaryCompress.
+  --num-threads=<n>
+                  Assemble the functions of the module on up to <n> threads.
+                  The output is the same as with one thread.
 )",
       argv0, argv0, target_env_list.c_str());
 }
@@ -55,6 +60,8 @@ int main(int argc, char** argv) {
   const char* outFile = nullptr;
   uint32_t options = 0;
   spv_target_env target_env = kDefaultEnvironment;
+  bool compress = false;
+  uint32_t num_threads = 1;
   for (int argi = 1; argi < argc; ++argi) {
     if ('-' == argv[argi][0]) {
       switch (argv[argi][1]) {
@@ -91,6 +98,18 @@ int main(int argc, char** argv) {
             return 0;
           } else if (0 == strcmp(argv[argi], "--preserve-numeric-ids")) {
             options |= SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS;
+          } else if (0 == strcmp(argv[argi], "--compress")) {
+            compress = true;
+          } else if (0 == strncmp(argv[argi], "--num-threads=",
+                                  sizeof("--num-threads=") - 1)) {
+            const int threads =
+                atoi(argv[argi] + sizeof("--num-threads=") - 1);
+            if (threads < 1) {
+              fprintf(stderr, "error: Invalid number of threads '%s'\n",
+                      argv[argi]);
+              return 1;
+            }
+            num_threads = static_cast<uint32_t>(threads);
           } else if (0 == strcmp(argv[argi], "--target-env")) {
             if (argi + 1 < argc) {
               const auto env_str = argv[++argi];
@@ -134,21 +153,36 @@ int main(int argc, char** argv) {
   spv_binary binary;
   spv_diagnostic diagnostic = nullptr;
   spv_context context = spvContextCreate(target_env);
-  spv_result_t error = spvTextToBinaryWithOptions(
-      context, contents.data(), contents.size(), options, &binary, &diagnostic);
-  spvContextDestroy(context);
+  spv_result_t error =
+      spvTextToBinaryParallel(context, contents.data(), contents.size(),
+                              options, num_threads, &binary, &diagnostic);
   if (error) {
+    spvContextDestroy(context);
     spvDiagnosticPrint(diagnostic);
     spvDiagnosticDestroy(diagnostic);
     return error;
   }
 
-  if (!WriteFile<uint32_t>(outFile, "wb", binary->code, binary->wordCount)) {
-    spvBinaryDestroy(binary);
-    return 1;
+  bool written = false;
+  if (compress) {
+    spv_compressed_binary compressed = nullptr;
+    error = spvBinaryCompress(context, binary->code, binary->wordCount,
+                              &compressed, &diagnostic);
+    if (error) {
+      spvDiagnosticPrint(diagnostic);
+      spvDiagnosticDestroy(diagnostic);
+    } else {
+      written = WriteFile<uint8_t>(outFile, "wb", compressed->data,
+                                   compressed->size);
+    }
+    spvCompressedBinaryDestroy(context, compressed);
+  } else {
+    written =
+        WriteFile<uint32_t>(outFile, "wb", binary->code, binary->wordCount);
   }
-
+  spvContextDestroy(context);
   spvBinaryDestroy(binary);
 
-  return 0;
+  if (error) return error;
+  return written ? 0 : 1;
 }
@@ -16,6 +16,8 @@
 
 #include <cassert>
 #include <iostream>
+#include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -31,8 +33,13 @@ const char* kContinueStyle = "style=dotted";
 // a SPIR-V module.
 class DotConverter {
  public:
-  DotConverter(spvtools::NameMapper name_mapper, std::iostream* out)
-      : name_mapper_(std::move(name_mapper)), out_(*out) {}
+  // Only the functions named |function_name|, or the entry points of that
+  // name, are dumped, unless it is null.
+  DotConverter(spvtools::NameMapper name_mapper, const char* function_name,
+               std::ostream* out)
+      : name_mapper_(std::move(name_mapper)),
+        function_name_(function_name),
+        out_(*out) {}
 
   // Emits the graph preamble.
   void Begin() const {
@@ -53,11 +60,21 @@ class DotConverter {
   // Emits the Dot commands for the given instruction.
   spv_result_t HandleInstruction(const spv_parsed_instruction_t& inst);
 
+  // Returns the number of functions that were dumped.
+  uint32_t num_functions() const { return num_functions_; }
+
  private:
+  // Returns whether the function |function_id| is dumped.
+  bool IsSelected(uint32_t function_id) {
+    return !function_name_ || selected_entry_points_.count(function_id) ||
+           name_mapper_(function_id) == function_name_;
+  }
+
   // Ends processing for the current block, emitting its dot code.
-  void FlushBlock(const std::vector<uint32_t>& successors);
+  void FlushBlock();
 
-  // The ID of the current functio, or 0 if outside of a function.
+  // The ID of the current functio, or 0 if outside of a function or in a
+  // function that is not dumped.
   uint32_t current_function_id_ = 0;
 
   // The ID of the current basic block, or 0 if outside of a block.
@@ -71,48 +88,79 @@ class DotConverter {
   // The Id of the continue target block for this block if it exists, or 0
   // otherwise.
   uint32_t continue_target_ = 0;
+  // The successors of the current block, reused from block to block.
+  std::vector<uint32_t> successors_;
 
   // An object for mapping Ids to names.
   spvtools::NameMapper name_mapper_;
 
+  // The name of the functions to dump, or null to dump them all.
+  const char* function_name_;
+  // The functions that are entry points named |function_name_|.
+  std::unordered_set<uint32_t> selected_entry_points_;
+  // The number of functions dumped so far.
+  uint32_t num_functions_ = 0;
+
   // The output stream.
   std::ostream& out_;
 };
 
 spv_result_t DotConverter::HandleInstruction(
     const spv_parsed_instruction_t& inst) {
+  if (inst.opcode == SpvOpEntryPoint) {
+    const char* name = reinterpret_cast<const char*>(
+        inst.words + inst.operands[2].offset);
+    if (function_name_ && name == std::string(function_name_)) {
+      selected_entry_points_.insert(inst.words[inst.operands[1].offset]);
+    }
+    return SPV_SUCCESS;
+  }
+  if (inst.opcode == SpvOpFunction) {
+    if (!IsSelected(inst.result_id)) return SPV_SUCCESS;
+    current_function_id_ = inst.result_id;
+    seen_function_entry_block_ = false;
+    ++num_functions_;
+    out_ << "subgraph cluster_" << current_function_id_ << " {\n";
+    return SPV_SUCCESS;
+  }
+  // The instructions of the functions that are not dumped are skipped.
+  if (current_function_id_ == 0) return SPV_SUCCESS;
+
   switch (inst.opcode) {
-    case SpvOpFunction:
-      current_function_id_ = inst.result_id;
-      seen_function_entry_block_ = false;
-      break;
     case SpvOpFunctionEnd:
       current_function_id_ = 0;
+      // The function is complete, so it is handed to the stream right away.
+      out_ << "}\n";
+      out_.flush();
       break;
 
     case SpvOpLabel:
       current_block_id_ = inst.result_id;
+      successors_.clear();
       break;
 
     case SpvOpBranch:
-      FlushBlock({inst.words[1]});
+      successors_.push_back(inst.words[1]);
+      FlushBlock();
       break;
     case SpvOpBranchConditional:
-      FlushBlock({inst.words[2], inst.words[3]});
+      successors_.push_back(inst.words[2]);
+      successors_.push_back(inst.words[3]);
+      FlushBlock();
       break;
     case SpvOpSwitch: {
-      std::vector<uint32_t> successors{inst.words[2]};
+      successors_.push_back(inst.words[2]);
       for (size_t i = 3; i < inst.num_operands; i += 2) {
-        successors.push_back(inst.words[inst.operands[i].offset]);
+        successors_.push_back(inst.words[inst.operands[i].offset]);
       }
-      FlushBlock(successors);
+      FlushBlock();
     } break;
 
     case SpvOpKill:
     case SpvOpReturn:
     case SpvOpUnreachable:
     case SpvOpReturnValue:
-      FlushBlock({});
+      FlushBlock();
       break;
 
     case SpvOpLoopMerge:
@@ -128,7 +176,7 @@ spv_result_t DotConverter::HandleInstruction(
   return SPV_SUCCESS;
 }
 
-void DotConverter::FlushBlock(const std::vector<uint32_t>& successors) {
+void DotConverter::FlushBlock() {
   out_ << current_block_id_;
   if (!seen_function_entry_block_) {
     out_ << " [label=\"" << name_mapper_(current_block_id_) << "\nFn "
@@ -137,7 +185,7 @@ void DotConverter::FlushBlock(const std::vector<uint32_t>& successors) {
     out_ << " [label=\"" << name_mapper_(current_block_id_) << "\"];\n";
   }
 
-  for (auto successor : successors) {
+  for (auto successor : successors_) {
     out_ << current_block_id_ << " -> " << successor << ";\n";
   }
 
@@ -166,8 +214,8 @@ spv_result_t HandleInstruction(
 }  // anonymous namespace
 
 spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
-                         size_t num_words, std::iostream* out,
-                         spv_diagnostic* diagnostic) {
+                         size_t num_words, const char* function_name,
+                         std::ostream* out, spv_diagnostic* diagnostic) {
   // Invalid arguments return error codes, but don't necessarily generate
   // diagnostics.  These are programmer errors, not user errors.
   if (!diagnostic) return SPV_ERROR_INVALID_DIAGNOSTIC;
@@ -175,7 +223,7 @@ spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
   if (!grammar.isValid()) return SPV_ERROR_INVALID_TABLE;
 
   spvtools::FriendlyNameMapper friendly_mapper(context, words, num_words);
-  DotConverter converter(friendly_mapper.GetNameMapper(), out);
+  DotConverter converter(friendly_mapper.GetNameMapper(), function_name, out);
   converter.Begin();
   if (auto error = spvBinaryParse(context, &converter, words, num_words,
                                   nullptr, HandleInstruction, diagnostic)) {
@@ -183,5 +231,13 @@ spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
   }
   converter.End();
 
+  if (function_name && converter.num_functions() == 0) {
+    spv_position_t position = {};
+    const std::string message =
+        std::string("No function or entry point is named ") + function_name;
+    *diagnostic = spvDiagnosticCreate(&position, message.c_str());
+    return SPV_ERROR_INVALID_LOOKUP;
+  }
+
   return SPV_SUCCESS;
 }
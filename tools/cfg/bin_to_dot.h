@@ -15,14 +15,18 @@
 #ifndef TOOLS_CFG_BIN_TO_DOT_H_
 #define TOOLS_CFG_BIN_TO_DOT_H_
 
-#include <iostream>
+#include <ostream>
 
 #include "spirv-tools/libspirv.h"
 
 // Dumps the control flow graph for the given module to the output stream.
-// Returns SPV_SUCCESS on succes.
+// Each function is written as a subgraph as soon as it has been parsed, so the
+// graph is never held in memory.  If |function_name| is not null, only the
+// functions with that name, or that are entry points of that name, are
+// written, and it is an error if there are none.  Returns SPV_SUCCESS on
+// success.
 spv_result_t BinaryToDot(const spv_const_context context, const uint32_t* words,
-                         size_t num_words, std::iostream* out,
-                         spv_diagnostic* diagnostic);
+                         size_t num_words, const char* function_name,
+                         std::ostream* out, spv_diagnostic* diagnostic);
 
 #endif  // TOOLS_CFG_BIN_TO_DOT_H_
@@ -14,9 +14,9 @@
 
 #include <cstdio>
 #include <cstring>
-#include <sstream>
+#include <fstream>
+#include <iostream>
 #include <string>
-#include <vector>
 
 #include "spirv-tools/libspirv.h"
 #include "tools/cfg/bin_to_dot.h"
@@ -40,6 +40,11 @@ Options:
   -o <filename>   Set the output filename.
                   Output goes to standard output if this option is
                   not specified, or if the filename is "-".
+
+  --function=<name>
+                  Only show the functions named <name>, and the entry points
+                  named <name>.  Functions without a debug name are named
+                  by their id.
 )",
       argv0, argv0);
 }
@@ -49,6 +54,7 @@ static const auto kDefaultEnvironment = SPV_ENV_UNIVERSAL_1_5;
 int main(int argc, char** argv) {
   const char* inFile = nullptr;
   const char* outFile = nullptr;  // Stays nullptr if printing to stdout.
+  const char* function_name = nullptr;
 
   for (int argi = 1; argi < argc; ++argi) {
     if ('-' == argv[argi][0]) {
@@ -69,6 +75,9 @@ int main(int argc, char** argv) {
           if (0 == strcmp(argv[argi], "--help")) {
             print_usage(argv[0]);
             return 0;
+          } else if (0 == strncmp(argv[argi], "--function=",
+                                  sizeof("--function=") - 1)) {
+            function_name = argv[argi] + sizeof("--function=") - 1;
           } else if (0 == strcmp(argv[argi], "--version")) {
             printf("%s EXPERIMENTAL\n", spvSoftwareVersionDetailsString());
             printf("Target: %s\n",
@@ -103,22 +112,37 @@ int main(int argc, char** argv) {
   }
 
   // Read the input binary.
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  InputFile<uint32_t> contents;
+  if (!contents.Open(inFile)) return 1;
+
+  // The graph is written out as it is produced.
+  std::ofstream out_file;
+  const bool use_file = outFile && strcmp("-", outFile);
+  if (use_file) {
+    out_file.open(outFile);
+    if (!out_file) {
+      fprintf(stderr, "error: could not open file '%s'\n", outFile);
+      return 1;
+    }
+  }
+  std::ostream& out = use_file ? out_file : std::cout;
+
   spv_context context = spvContextCreate(kDefaultEnvironment);
   spv_diagnostic diagnostic = nullptr;
-
-  std::stringstream ss;
-  auto error =
-      BinaryToDot(context, contents.data(), contents.size(), &ss, &diagnostic);
+  auto error = BinaryToDot(context, contents.data(), contents.size(),
+                           function_name, &out, &diagnostic);
   if (error) {
     spvDiagnosticPrint(diagnostic);
     spvDiagnosticDestroy(diagnostic);
     spvContextDestroy(context);
     return error;
   }
-  std::string str = ss.str();
-  WriteFile(outFile, "w", str.data(), str.size());
+  out.flush();
+  if (!out) {
+    fprintf(stderr, "error: could not write the graph\n");
+    spvContextDestroy(context);
+    return 1;
+  }
 
   spvDiagnosticDestroy(diagnostic);
   spvContextDestroy(context);
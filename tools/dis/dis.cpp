@@ -18,6 +18,7 @@
 #endif
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -58,6 +59,14 @@ Options:
   --offsets       Show byte offsets for each instruction.
 
   --comment       Add comments to make reading easier
+
+  --compressed    The input is a compressed module, as written by
+                  spirv-as --compress.
+
+  --num-threads=<n>
+                  Disassemble the functions of the module on up to <n>
+                  threads.  The output is the same as with one thread.
+                  Ignored with --comment, and for colored output.
 )",
       argv0, argv0);
 }
@@ -82,6 +91,8 @@ int main(int argc, char** argv) {
   bool no_header = false;
   bool friendly_names = true;
   bool comments = false;
+  bool compressed = false;
+  uint32_t num_threads = 1;
 
   for (int argi = 1; argi < argc; ++argi) {
     if ('-' == argv[argi][0]) {
@@ -107,6 +118,8 @@ int main(int argc, char** argv) {
             force_color = true;
           } else if (0 == strcmp(argv[argi], "--comment")) {
             comments = true;
+          } else if (0 == strcmp(argv[argi], "--compressed")) {
+            compressed = true;
           } else if (0 == strcmp(argv[argi], "--no-indent")) {
             allow_indent = false;
           } else if (0 == strcmp(argv[argi], "--offsets")) {
@@ -115,6 +128,16 @@ int main(int argc, char** argv) {
             no_header = true;
           } else if (0 == strcmp(argv[argi], "--raw-id")) {
             friendly_names = false;
+          } else if (0 == strncmp(argv[argi], "--num-threads=",
+                                  sizeof("--num-threads=") - 1)) {
+            const int threads =
+                atoi(argv[argi] + sizeof("--num-threads=") - 1);
+            if (threads < 1) {
+              fprintf(stderr, "error: Invalid number of threads '%s'\n",
+                      argv[argi]);
+              return 1;
+            }
+            num_threads = static_cast<uint32_t>(threads);
           } else if (0 == strcmp(argv[argi], "--help")) {
             print_usage(argv[0]);
             return 0;
@@ -164,9 +187,6 @@ int main(int argc, char** argv) {
   if (comments) options |= SPV_BINARY_TO_TEXT_OPTION_COMMENT;
 
   if (!outFile || (0 == strcmp("-", outFile))) {
-    // Print to standard output.
-    options |= SPV_BINARY_TO_TEXT_OPTION_PRINT;
-
     if (color_is_possible && !force_no_color) {
       bool output_is_tty = true;
 #if defined(_POSIX_VERSION)
@@ -176,11 +196,19 @@ int main(int argc, char** argv) {
         options |= SPV_BINARY_TO_TEXT_OPTION_COLOR;
       }
     }
+
+    // Print to standard output.  Uncolored text disassembled on several
+    // threads is saved in memory and written out once it is complete.
+    if (num_threads == 1 || (options & SPV_BINARY_TO_TEXT_OPTION_COLOR)) {
+      options |= SPV_BINARY_TO_TEXT_OPTION_PRINT;
+    }
   }
 
-  // Read the input binary.
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  // Read the input binary.  A compressed module is decompressed in memory.
+  InputFile<uint32_t> contents;
+  InputFile<uint8_t> compressed_contents;
+  if (!(compressed ? compressed_contents.Open(inFile) : contents.Open(inFile)))
+    return 1;
 
   // If printing to standard output, then spvBinaryToText should
   // do the printing.  In particular, colour printing on Windows is
@@ -194,9 +222,21 @@ int main(int argc, char** argv) {
   spv_text* textOrNull = print_to_stdout ? nullptr : &text;
   spv_diagnostic diagnostic = nullptr;
   spv_context context = spvContextCreate(kDefaultEnvironment);
-  spv_result_t error =
-      spvBinaryToText(context, contents.data(), contents.size(), options,
-                      textOrNull, &diagnostic);
+  spv_binary decompressed = nullptr;
+  spv_result_t error = SPV_SUCCESS;
+  if (compressed) {
+    error = spvBinaryDecompress(context, compressed_contents.data(),
+                                compressed_contents.size(), &decompressed,
+                                &diagnostic);
+  }
+  if (!error) {
+    const uint32_t* words = compressed ? decompressed->code : contents.data();
+    const size_t num_words =
+        compressed ? decompressed->wordCount : contents.size();
+    error = spvBinaryToTextParallel(context, words, num_words, options,
+                                    num_threads, textOrNull, &diagnostic);
+  }
+  spvBinaryDestroy(decompressed);
   spvContextDestroy(context);
   if (error) {
     spvDiagnosticPrint(diagnostic);
@@ -12,26 +12,33 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <sstream>
 #include <string>
 
 #include "source/fuzz/force_render_red.h"
+#include "source/fuzz/fuzz_campaign.h"
 #include "source/fuzz/fuzzer.h"
 #include "source/fuzz/fuzzer_util.h"
 #include "source/fuzz/protobufs/spirvfuzz_protobufs.h"
 #include "source/fuzz/pseudo_random_generator.h"
 #include "source/fuzz/replayer.h"
 #include "source/fuzz/shrinker.h"
+#include "source/fuzz/transformation_stream.h"
+#include "source/fuzz/xoshiro_random_generator.h"
 #include "source/opt/build_module.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/log.h"
 #include "source/spirv_fuzzer_options.h"
+#include "source/util/interestingness_cache.h"
 #include "source/util/make_unique.h"
 #include "source/util/string_utils.h"
 #include "tools/io.h"
@@ -57,8 +64,29 @@ bool ExecuteCommand(const std::string& command) {
   return status == 0;
 }
 
+// The pseudo-random number generators that the fuzzer can be run with.
+enum class RandomGeneratorKind {
+  MT19937,
+  XOSHIRO256,
+};
+
+// Returns a generator of kind |kind| seeded with |seed|.
+std::unique_ptr<spvtools::fuzz::RandomGenerator> MakeRandomGenerator(
+    RandomGeneratorKind kind, uint32_t seed) {
+  switch (kind) {
+    case RandomGeneratorKind::XOSHIRO256:
+      return spvtools::MakeUnique<spvtools::fuzz::XoshiroRandomGenerator>(
+          seed);
+    case RandomGeneratorKind::MT19937:
+      break;
+  }
+  return spvtools::MakeUnique<spvtools::fuzz::PseudoRandomGenerator>(seed);
+}
+
 // Status and actions to perform after parsing command-line arguments.
 enum class FuzzActions {
+  CAMPAIGN,  // Run the fuzzer many times, with successive seeds, on a pool of
+             // worker threads.
   FORCE_RENDER_RED,  // Turn the shader into a form such that it is guaranteed
                      // to render a red image.
   FUZZ,    // Run the fuzzer to apply transformations in a randomized fashion.
@@ -82,6 +110,8 @@ USAGE: %s [options] <input.spv> -o <output.spv> \
   --donors=<donors.txt>
 USAGE: %s [options] <input.spv> -o <output.spv> \
   --shrink=<input.transformations> -- <interestingness_test> [args...]
+USAGE: %s [options] <input.spv> -o <output_directory> \
+  --donors=<donors.txt> --campaign=<num_runs>
 
 The SPIR-V binary is read from <input.spv>.  If <input.facts> is also present,
 facts about the SPIR-V binary are read from this file.
@@ -89,6 +119,15 @@ facts about the SPIR-V binary are read from this file.
 The transformed SPIR-V binary is written to <output.spv>.  Human-readable and
 binary representations of the transformations that were applied are written to
 <output.transformations_json> and <output.transformations>, respectively.
+With --stream-transformations, <output.transformations> is instead written as
+the fuzzer proceeds, in an append-only format that --replay and --shrink also
+accept; if the fuzzer crashes, the transformations applied so far survive.
+
+When passing --campaign=<num_runs>, the fuzzer is run <num_runs> times in one
+process, with seeds <seed>, <seed> + 1, and so on.  The runs share the input
+binary and the donor modules, which are read once.  Run <i> writes its
+results to <output_directory>/<seed + i>.spv, .transformations_json and
+.transformations.  <output_directory> must exist.
 
 When passing --shrink=<input.transformations> an <interestingness_test>
 must also be provided; this is the path to a script that returns 0 if and only
@@ -102,6 +141,10 @@ NOTE: The fuzzer is a work in progress.
 
 Options (in lexicographical order):
 
+  --campaign=
+               Unsigned 32-bit integer specifying how many fuzzer runs to
+               perform; see above.  The runs are spread over --jobs worker
+               threads.
   -h, --help
                Print this help.
   --donors=
@@ -130,6 +173,10 @@ Options (in lexicographical order):
                Useful for debugging spirv-fuzz.
   --repeated-pass-strategy=
                Available strategies are:
+               - adaptive: each enabled fuzzer pass is tried once, after which
+                 passes that have applied the most transformations per second
+                 are favored.  Per-pass statistics are printed at the end.
+                 The passes chosen depend on timing as well as on the seed.
                - looped (the default): a sequence of fuzzer passes is chosen at
                  the start of fuzzing, via randomly choosing enabled passes, and
                  augmenting these choices with fuzzer passes that it is
@@ -141,6 +188,18 @@ Options (in lexicographical order):
                  that was used previously.
                - simple: each time a fuzzer pass is requested, one is provided
                  at random from the set of enabled passes.
+  --jobs=
+               Unsigned 32-bit integer specifying the number of worker threads
+               of a --campaign, or how many shrink attempts to evaluate
+               concurrently with --shrink; the interestingness test must then
+               be safe to run several times at once.  The result of shrinking
+               is the same for any number of jobs.  The default is 1.
+  --random-generator=
+               Available generators are:
+               - mt19937 (the default): the Mersenne Twister.
+               - xoshiro256: xoshiro256**, which is faster.
+               Each generator is deterministic for a given --seed, but the two
+               produce different results for the same seed.
   --replay
                File from which to read a sequence of transformations to replay
                (instead of fuzzing)
@@ -162,6 +221,14 @@ Options (in lexicographical order):
   --shrink=
                File from which to read a sequence of transformations to shrink
                (instead of fuzzing)
+  --shrinker-interestingness-cache=
+               Specifies a file in which to remember the verdict of the
+               interestingness test for each binary it is run on, so that the
+               test is not run again on an identical binary.  Verdicts already
+               in the file are reused, so the same file can be given to a
+               restarted shrink; files from several shrinks can be
+               concatenated.  Only suitable if the interestingness test is
+               deterministic.  Ignored unless --shrink is used.
   --shrinker-step-limit=
                Unsigned 32-bit integer specifying maximum number of steps the
                shrinker will take before giving up.  Ignored unless --shrink
@@ -172,6 +239,10 @@ Options (in lexicographical order):
                extension will be added.  The default is "temp_", which will
                cause files like "temp_0001.spv" to be output to the current
                directory.  Ignored unless --shrink is used.
+  --stream-transformations
+               Write the binary representation of the transformations as
+               fuzzing proceeds, rather than once fuzzing has finished; see
+               above.  Ignored unless fuzzing.
   --version
                Display fuzzer version information.
 
@@ -183,7 +254,7 @@ Supported validator options are as follows. See `spirv-val --help` for details.
   --scalar-block-layout
   --skip-block-layout
 )",
-      program, program, program, program);
+      program, program, program, program, program);
 }
 
 // Message consumer for this tool.  Used to emit diagnostics during
@@ -204,7 +275,10 @@ FuzzStatus ParseFlags(
     std::vector<std::string>* interestingness_test,
     std::string* shrink_transformations_file,
     std::string* shrink_temp_file_prefix,
+    std::string* shrink_interestingness_cache_file,
     spvtools::fuzz::Fuzzer::RepeatedPassStrategy* repeated_pass_strategy,
+    uint32_t* num_campaign_runs, uint32_t* num_jobs,
+    bool* stream_transformations, RandomGeneratorKind* random_generator,
     spvtools::FuzzerOptions* fuzzer_options,
     spvtools::ValidatorOptions* validator_options) {
   uint32_t positional_arg_index = 0;
@@ -231,6 +305,14 @@ FuzzStatus ParseFlags(
           PrintUsage(argv[0]);
           return {FuzzActions::STOP, 1};
         }
+      } else if (0 == strncmp(cur_arg, "--campaign=",
+                              sizeof("--campaign=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        char* end = nullptr;
+        errno = 0;
+        *num_campaign_runs =
+            static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10));
+        assert(end != split_flag.second.c_str() && errno == 0);
       } else if (0 == strncmp(cur_arg, "--donors=", sizeof("--donors=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
         *donors_file = std::string(split_flag.second);
@@ -243,13 +325,39 @@ FuzzStatus ParseFlags(
       } else if (0 == strncmp(cur_arg, "--fuzzer-pass-validation",
                               sizeof("--fuzzer-pass-validation") - 1)) {
         fuzzer_options->enable_fuzzer_pass_validation();
+      } else if (0 == strncmp(cur_arg, "--jobs=", sizeof("--jobs=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        char* end = nullptr;
+        errno = 0;
+        *num_jobs = std::max(
+            1u,
+            static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10)));
+        assert(end != split_flag.second.c_str() && errno == 0);
+        fuzzer_options->set_shrinker_num_jobs(*num_jobs);
+      } else if (0 == strncmp(cur_arg, "--random-generator=",
+                              sizeof("--random-generator=") - 1)) {
+        std::string generator = spvtools::utils::SplitFlagArgs(cur_arg).second;
+        if (generator == "mt19937") {
+          *random_generator = RandomGeneratorKind::MT19937;
+        } else if (generator == "xoshiro256") {
+          *random_generator = RandomGeneratorKind::XOSHIRO256;
+        } else {
+          std::stringstream ss;
+          ss << "Unknown random generator '" << generator << "'" << std::endl;
+          ss << "Valid options are 'mt19937' and 'xoshiro256'.";
+          spvtools::Error(FuzzDiagnostic, nullptr, {}, ss.str().c_str());
+          return {FuzzActions::STOP, 1};
+        }
       } else if (0 == strncmp(cur_arg, "--replay=", sizeof("--replay=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
         *replay_transformations_file = std::string(split_flag.second);
       } else if (0 == strncmp(cur_arg, "--repeated-pass-strategy=",
                               sizeof("--repeated-pass-strategy=") - 1)) {
         std::string strategy = spvtools::utils::SplitFlagArgs(cur_arg).second;
-        if (strategy == "looped") {
+        if (strategy == "adaptive") {
+          *repeated_pass_strategy =
+              spvtools::fuzz::Fuzzer::RepeatedPassStrategy::kAdaptive;
+        } else if (strategy == "looped") {
           *repeated_pass_strategy = spvtools::fuzz::Fuzzer::
               RepeatedPassStrategy::kLoopedWithRecommendations;
         } else if (strategy == "random") {
@@ -262,7 +370,8 @@ FuzzStatus ParseFlags(
           std::stringstream ss;
           ss << "Unknown repeated pass strategy '" << strategy << "'"
              << std::endl;
-          ss << "Valid options are 'looped', 'random' and 'simple'.";
+          ss << "Valid options are 'adaptive', 'looped', 'random' and "
+                "'simple'.";
           spvtools::Error(FuzzDiagnostic, nullptr, {}, ss.str().c_str());
           return {FuzzActions::STOP, 1};
         }
@@ -289,6 +398,11 @@ FuzzStatus ParseFlags(
             static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10));
         assert(end != split_flag.second.c_str() && errno == 0);
         fuzzer_options->set_random_seed(seed);
+      } else if (0 == strncmp(cur_arg, "--shrinker-interestingness-cache=",
+                              sizeof("--shrinker-interestingness-cache=") -
+                                  1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        *shrink_interestingness_cache_file = std::string(split_flag.second);
       } else if (0 == strncmp(cur_arg, "--shrinker-step-limit=",
                               sizeof("--shrinker-step-limit=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
@@ -302,6 +416,8 @@ FuzzStatus ParseFlags(
                               sizeof("--shrinker-temp-file-prefix=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
         *shrink_temp_file_prefix = std::string(split_flag.second);
+      } else if (0 == strcmp(cur_arg, "--stream-transformations")) {
+        *stream_transformations = true;
       } else if (0 == strcmp(cur_arg, "--before-hlsl-legalization")) {
         validator_options->SetBeforeHlslLegalization(true);
       } else if (0 == strcmp(cur_arg, "--relax-logical-pointer")) {
@@ -382,6 +498,14 @@ FuzzStatus ParseFlags(
     return {FuzzActions::STOP, 1};
   }
 
+  if (*num_campaign_runs > 0 && (!replay_transformations_file->empty() ||
+                                 !shrink_transformations_file->empty())) {
+    spvtools::Error(FuzzDiagnostic, nullptr, {},
+                    "The --campaign argument is not compatible with --replay "
+                    "nor --shrink.");
+    return {FuzzActions::STOP, 1};
+  }
+
   if (!replay_transformations_file->empty() ||
       !shrink_transformations_file->empty()) {
     // Donors should not be provided when replaying or shrinking: they only make
@@ -420,6 +544,9 @@ FuzzStatus ParseFlags(
                     "Fuzzing requires that the --donors option is used.");
     return {FuzzActions::STOP, 1};
   }
+  if (*num_campaign_runs > 0) {
+    return {FuzzActions::CAMPAIGN, 0};
+  }
   return {FuzzActions::FUZZ, 0};
 }
 
@@ -429,8 +556,20 @@ bool ParseTransformations(
   std::ifstream transformations_stream;
   transformations_stream.open(transformations_file,
                               std::ios::in | std::ios::binary);
-  auto parse_success =
-      transformations->ParseFromIstream(&transformations_stream);
+  bool parse_success;
+  if (spvtools::fuzz::IsTransformationStream(&transformations_stream)) {
+    bool truncated;
+    parse_success = spvtools::fuzz::ReadTransformationStream(
+        &transformations_stream, transformations, &truncated);
+    if (parse_success && truncated) {
+      spvtools::Log(FuzzDiagnostic, SPV_MSG_WARNING, nullptr, {},
+                    ("Ignoring incomplete final transformation in file '" +
+                     transformations_file + "'")
+                        .c_str());
+    }
+  } else {
+    parse_success = transformations->ParseFromIstream(&transformations_stream);
+  }
   transformations_stream.close();
   if (!parse_success) {
     spvtools::Error(FuzzDiagnostic, nullptr, {},
@@ -493,6 +632,7 @@ bool Shrink(const spv_target_env& target_env,
             const spvtools::fuzz::protobufs::FactSequence& initial_facts,
             const std::string& shrink_transformations_file,
             const std::string& shrink_temp_file_prefix,
+            const std::string& shrink_interestingness_cache_file,
             const std::vector<std::string>& interestingness_command,
             std::vector<uint32_t>* binary_out,
             spvtools::fuzz::protobufs::TransformationSequence*
@@ -527,13 +667,40 @@ bool Shrink(const spv_target_env& target_env,
     return ExecuteCommand(command);
   };
 
-  auto shrink_result =
-      spvtools::fuzz::Shrinker(
-          target_env, spvtools::utils::CLIMessageConsumer, binary_in,
-          initial_facts, transformation_sequence, interestingness_function,
-          fuzzer_options->shrinker_step_limit,
-          fuzzer_options->replay_validation_enabled, validator_options)
-          .Run();
+  spvtools::fuzz::Shrinker shrinker(
+      target_env, spvtools::utils::CLIMessageConsumer, binary_in,
+      initial_facts, transformation_sequence, interestingness_function,
+      fuzzer_options->shrinker_step_limit,
+      fuzzer_options->replay_validation_enabled, validator_options,
+      fuzzer_options->shrinker_num_jobs);
+
+  spvtools::utils::InterestingnessCache interestingness_cache;
+  if (!shrink_interestingness_cache_file.empty()) {
+    // A missing file is not an error: it is created when shrinking finishes.
+    std::ifstream cache_in(shrink_interestingness_cache_file);
+    if (cache_in && !interestingness_cache.Load(&cache_in)) {
+      spvtools::Error(FuzzDiagnostic, nullptr, {},
+                      "Malformed interestingness cache file");
+      return false;
+    }
+    shrinker.SetInterestingnessCache(&interestingness_cache);
+  }
+
+  auto shrink_result = shrinker.Run();
+
+  if (!shrink_interestingness_cache_file.empty()) {
+    std::ofstream cache_out(shrink_interestingness_cache_file);
+    interestingness_cache.Save(&cache_out);
+    if (!cache_out) {
+      spvtools::Error(FuzzDiagnostic, nullptr, {},
+                      "Failed to write interestingness cache file");
+    }
+    std::stringstream strstr;
+    strstr << "The interestingness cache was used "
+           << interestingness_cache.num_hits() << " times.";
+    spvtools::utils::CLIMessageConsumer(SPV_MSG_INFO, nullptr, {},
+                                        strstr.str().c_str());
+  }
 
   *binary_out = std::move(shrink_result.transformed_binary);
   *transformations_applied = std::move(shrink_result.applied_transformations);
@@ -550,6 +717,8 @@ bool Fuzz(const spv_target_env& target_env,
           const spvtools::fuzz::protobufs::FactSequence& initial_facts,
           const std::string& donors,
           spvtools::fuzz::Fuzzer::RepeatedPassStrategy repeated_pass_strategy,
+          RandomGeneratorKind random_generator,
+          std::ostream* transformation_stream,
           std::vector<uint32_t>* binary_out,
           spvtools::fuzz::protobufs::TransformationSequence*
               transformations_applied) {
@@ -578,17 +747,30 @@ bool Fuzz(const spv_target_env& target_env,
         });
   }
 
-  auto fuzz_result =
-      spvtools::fuzz::Fuzzer(
-          target_env, message_consumer, binary_in, initial_facts,
-          donor_suppliers,
-          spvtools::MakeUnique<spvtools::fuzz::PseudoRandomGenerator>(
-              fuzzer_options->has_random_seed
-                  ? fuzzer_options->random_seed
-                  : static_cast<uint32_t>(std::random_device()())),
-          fuzzer_options->all_passes_enabled, repeated_pass_strategy,
-          fuzzer_options->fuzzer_pass_validation_enabled, validator_options)
-          .Run();
+  spvtools::fuzz::Fuzzer fuzzer(
+      target_env, message_consumer, binary_in, initial_facts, donor_suppliers,
+      MakeRandomGenerator(random_generator,
+                          fuzzer_options->has_random_seed
+                              ? fuzzer_options->random_seed
+                              : static_cast<uint32_t>(std::random_device()())),
+      fuzzer_options->all_passes_enabled, repeated_pass_strategy,
+      fuzzer_options->fuzzer_pass_validation_enabled, validator_options);
+  std::unique_ptr<spvtools::fuzz::TransformationStreamWriter> stream_writer;
+  if (transformation_stream) {
+    stream_writer = spvtools::MakeUnique<
+        spvtools::fuzz::TransformationStreamWriter>(transformation_stream);
+    fuzzer.SetTransformationListener(
+        [&stream_writer](
+            const spvtools::fuzz::protobufs::Transformation& transformation) {
+          stream_writer->Write(transformation);
+        });
+  }
+  auto fuzz_result = fuzzer.Run();
+  if (stream_writer && !stream_writer->good()) {
+    spvtools::Error(FuzzDiagnostic, nullptr, {},
+                    "Error writing out transformations binary");
+    return false;
+  }
   *binary_out = std::move(fuzz_result.transformed_binary);
   *transformations_applied = std::move(fuzz_result.applied_transformations);
   if (fuzz_result.status !=
@@ -599,6 +781,156 @@ bool Fuzz(const spv_target_env& target_env,
   return true;
 }
 
+// Writes binary and JSON representations of |transformations| to
+// <output_file_prefix>.transformations and
+// <output_file_prefix>.transformations_json, respectively.  The binary
+// representation is skipped if |write_binary| is false, which is the case when
+// it has been streamed as fuzzing proceeded.
+bool WriteTransformations(
+    const spvtools::fuzz::protobufs::TransformationSequence& transformations,
+    const std::string& output_file_prefix, bool write_binary) {
+  if (write_binary) {
+    std::ofstream transformations_file;
+    transformations_file.open(output_file_prefix + ".transformations",
+                              std::ios::out | std::ios::binary);
+    bool success = transformations.SerializeToOstream(&transformations_file);
+    transformations_file.close();
+    if (!success) {
+      spvtools::Error(FuzzDiagnostic, nullptr, {},
+                      "Error writing out transformations binary");
+      return false;
+    }
+  }
+
+  std::string json_string;
+  auto json_options = google::protobuf::util::JsonOptions();
+  json_options.add_whitespace = true;
+  auto json_generation_status = google::protobuf::util::MessageToJsonString(
+      transformations, &json_string, json_options);
+  if (json_generation_status != google::protobuf::util::Status::OK) {
+    spvtools::Error(FuzzDiagnostic, nullptr, {},
+                    "Error writing out transformations in JSON format");
+    return false;
+  }
+
+  std::ofstream transformations_json_file(output_file_prefix +
+                                          ".transformations_json");
+  transformations_json_file << json_string;
+  transformations_json_file.close();
+  return true;
+}
+
+// Runs the fuzzer |num_runs| times on |num_jobs| worker threads, writing the
+// results of each run to |output_directory|, streaming the transformations of
+// each run if |stream_transformations| holds.  The donors are read once and
+// shared by all runs.
+bool RunFuzzCampaign(
+    const spv_target_env& target_env, spv_const_fuzzer_options fuzzer_options,
+    spv_validator_options validator_options,
+    const std::vector<uint32_t>& binary_in,
+    const spvtools::fuzz::protobufs::FactSequence& initial_facts,
+    const std::string& donors,
+    spvtools::fuzz::Fuzzer::RepeatedPassStrategy repeated_pass_strategy,
+    RandomGeneratorKind random_generator, uint32_t num_runs, uint32_t num_jobs,
+    bool stream_transformations, const std::string& output_directory) {
+  std::ifstream donors_file(donors);
+  if (!donors_file) {
+    spvtools::Error(FuzzDiagnostic, nullptr, {}, "Error opening donors file");
+    return false;
+  }
+  std::vector<std::vector<uint32_t>> donor_binaries;
+  std::string donor_filename;
+  while (std::getline(donors_file, donor_filename)) {
+    donor_binaries.emplace_back();
+    if (!ReadFile<uint32_t>(donor_filename.c_str(), "rb",
+                            &donor_binaries.back())) {
+      return false;
+    }
+  }
+
+  const uint32_t first_seed =
+      fuzzer_options->has_random_seed
+          ? fuzzer_options->random_seed
+          : static_cast<uint32_t>(std::random_device()());
+
+  spvtools::fuzz::FuzzCampaign campaign(
+      target_env, spvtools::utils::CLIMessageConsumer, binary_in,
+      initial_facts, donor_binaries,
+      [random_generator](uint32_t seed) {
+        return MakeRandomGenerator(random_generator, seed);
+      },
+      fuzzer_options->all_passes_enabled, repeated_pass_strategy,
+      fuzzer_options->fuzzer_pass_validation_enabled, validator_options);
+
+  // The streams of the runs in progress, which are only accessed by the
+  // worker threads when a run starts and by the run handler when it finishes.
+  std::mutex streams_mutex;
+  std::map<uint32_t, std::unique_ptr<std::ofstream>> transformation_streams;
+  std::map<uint32_t,
+           std::unique_ptr<spvtools::fuzz::TransformationStreamWriter>>
+      stream_writers;
+  if (stream_transformations) {
+    campaign.SetTransformationListenerFactory(
+        [&](uint32_t seed) -> spvtools::fuzz::Fuzzer::TransformationListener {
+          auto stream = spvtools::MakeUnique<std::ofstream>(
+              output_directory + "/" + std::to_string(seed) +
+                  ".transformations",
+              std::ios::out | std::ios::binary);
+          auto writer =
+              spvtools::MakeUnique<spvtools::fuzz::TransformationStreamWriter>(
+                  stream.get());
+          spvtools::fuzz::TransformationStreamWriter* stream_writer =
+              writer.get();
+          std::lock_guard<std::mutex> lock(streams_mutex);
+          transformation_streams[seed] = std::move(stream);
+          stream_writers[seed] = std::move(writer);
+          return [stream_writer](
+                     const spvtools::fuzz::protobufs::Transformation&
+                         transformation) {
+            stream_writer->Write(transformation);
+          };
+        });
+  }
+
+  bool success = true;
+  if (!campaign.Run(
+          first_seed, num_runs, num_jobs,
+          [&](uint32_t seed,
+              spvtools::fuzz::Fuzzer::FuzzerResult&& fuzz_result) {
+            const std::string output_file_prefix =
+                output_directory + "/" + std::to_string(seed);
+            if (stream_transformations) {
+              std::lock_guard<std::mutex> lock(streams_mutex);
+              if (!stream_writers[seed]->good()) {
+                spvtools::Error(FuzzDiagnostic, nullptr, {},
+                                "Error writing out transformations binary");
+                success = false;
+              }
+              stream_writers.erase(seed);
+              transformation_streams.erase(seed);
+            }
+            if (fuzz_result.status !=
+                spvtools::fuzz::Fuzzer::FuzzerResultStatus::kComplete) {
+              std::stringstream ss;
+              ss << "Error running fuzzer with seed " << seed;
+              spvtools::Error(FuzzDiagnostic, nullptr, {}, ss.str().c_str());
+              return;
+            }
+            if (!WriteFile<uint32_t>((output_file_prefix + ".spv").c_str(),
+                                     "wb",
+                                     fuzz_result.transformed_binary.data(),
+                                     fuzz_result.transformed_binary.size()) ||
+                !WriteTransformations(fuzz_result.applied_transformations,
+                                      output_file_prefix,
+                                      !stream_transformations)) {
+              success = false;
+            }
+          })) {
+    success = false;
+  }
+  return success;
+}
+
 }  // namespace
 
 // Dumps |binary| to file |filename|. Useful for interactive debugging.
@@ -628,7 +960,12 @@ int main(int argc, const char** argv) {
   std::vector<std::string> interestingness_test;
   std::string shrink_transformations_file;
   std::string shrink_temp_file_prefix = "temp_";
+  std::string shrink_interestingness_cache_file;
   spvtools::fuzz::Fuzzer::RepeatedPassStrategy repeated_pass_strategy;
+  uint32_t num_campaign_runs = 0;
+  uint32_t num_jobs = 1;
+  bool stream_transformations = false;
+  RandomGeneratorKind random_generator = RandomGeneratorKind::MT19937;
 
   spvtools::FuzzerOptions fuzzer_options;
   spvtools::ValidatorOptions validator_options;
@@ -637,7 +974,9 @@ int main(int argc, const char** argv) {
       ParseFlags(argc, argv, &in_binary_file, &out_binary_file, &donors_file,
                  &replay_transformations_file, &interestingness_test,
                  &shrink_transformations_file, &shrink_temp_file_prefix,
-                 &repeated_pass_strategy, &fuzzer_options, &validator_options);
+                 &shrink_interestingness_cache_file, &repeated_pass_strategy,
+                 &num_campaign_runs, &num_jobs, &stream_transformations,
+                 &random_generator, &fuzzer_options, &validator_options);
 
   if (status.action == FuzzActions::STOP) {
     return status.code;
@@ -673,7 +1012,27 @@ int main(int argc, const char** argv) {
 
   spv_target_env target_env = kDefaultEnvironment;
 
+  // If not found, dot_pos will be std::string::npos, which can be used in
+  // substr to mean "the end of the string"; there is no need to check the
+  // result.
+  dot_pos = out_binary_file.rfind('.');
+  const std::string output_file_prefix = out_binary_file.substr(0, dot_pos);
+
+  // Streaming only applies when fuzzing; other modes produce their
+  // transformations all at once.
+  const bool transformations_streamed =
+      stream_transformations && status.action == FuzzActions::FUZZ;
+
   switch (status.action) {
+    case FuzzActions::CAMPAIGN:
+      // The runs of a campaign write their own outputs.
+      return RunFuzzCampaign(target_env, fuzzer_options, validator_options,
+                             binary_in, initial_facts, donors_file,
+                             repeated_pass_strategy, random_generator,
+                             num_campaign_runs, num_jobs,
+                             stream_transformations, out_binary_file)
+                 ? 0
+                 : 1;
     case FuzzActions::FORCE_RENDER_RED:
       if (!spvtools::fuzz::ForceRenderRed(target_env, validator_options,
                                           binary_in, initial_facts,
@@ -681,13 +1040,20 @@ int main(int argc, const char** argv) {
         return 1;
       }
       break;
-    case FuzzActions::FUZZ:
+    case FuzzActions::FUZZ: {
+      std::ofstream transformation_stream;
+      if (transformations_streamed) {
+        transformation_stream.open(output_file_prefix + ".transformations",
+                                   std::ios::out | std::ios::binary);
+      }
       if (!Fuzz(target_env, fuzzer_options, validator_options, binary_in,
-                initial_facts, donors_file, repeated_pass_strategy, &binary_out,
-                &transformations_applied)) {
+                initial_facts, donors_file, repeated_pass_strategy,
+                random_generator,
+                transformations_streamed ? &transformation_stream : nullptr,
+                &binary_out, &transformations_applied)) {
         return 1;
       }
-      break;
+    } break;
     case FuzzActions::REPLAY:
       if (!Replay(target_env, fuzzer_options, validator_options, binary_in,
                   initial_facts, replay_transformations_file, &binary_out,
@@ -703,7 +1069,8 @@ int main(int argc, const char** argv) {
       }
       if (!Shrink(target_env, fuzzer_options, validator_options, binary_in,
                   initial_facts, shrink_transformations_file,
-                  shrink_temp_file_prefix, interestingness_test, &binary_out,
+                  shrink_temp_file_prefix, shrink_interestingness_cache_file,
+                  interestingness_test, &binary_out,
                   &transformations_applied)) {
         return 1;
       }
@@ -720,38 +1087,10 @@ int main(int argc, const char** argv) {
   }
 
   if (status.action != FuzzActions::FORCE_RENDER_RED) {
-    // If not found, dot_pos will be std::string::npos, which can be used in
-    // substr to mean "the end of the string"; there is no need to check the
-    // result.
-    dot_pos = out_binary_file.rfind('.');
-    std::string output_file_prefix = out_binary_file.substr(0, dot_pos);
-    std::ofstream transformations_file;
-    transformations_file.open(output_file_prefix + ".transformations",
-                              std::ios::out | std::ios::binary);
-    bool success =
-        transformations_applied.SerializeToOstream(&transformations_file);
-    transformations_file.close();
-    if (!success) {
-      spvtools::Error(FuzzDiagnostic, nullptr, {},
-                      "Error writing out transformations binary");
-      return 1;
-    }
-
-    std::string json_string;
-    auto json_options = google::protobuf::util::JsonOptions();
-    json_options.add_whitespace = true;
-    auto json_generation_status = google::protobuf::util::MessageToJsonString(
-        transformations_applied, &json_string, json_options);
-    if (json_generation_status != google::protobuf::util::Status::OK) {
-      spvtools::Error(FuzzDiagnostic, nullptr, {},
-                      "Error writing out transformations in JSON format");
+    if (!WriteTransformations(transformations_applied, output_file_prefix,
+                              !transformations_streamed)) {
       return 1;
     }
-
-    std::ofstream transformations_json_file(output_file_prefix +
-                                            ".transformations_json");
-    transformations_json_file << json_string;
-    transformations_json_file.close();
   }
 
   return 0;
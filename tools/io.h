@@ -20,6 +20,18 @@
 #include <cstring>
 #include <vector>
 
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 // Appends the content from the file named as |filename| to |data|, assuming
 // each element in the file is of type |T|. The file is opened with the given
 // |mode|. If |filename| is nullptr or "-", reads from the standard input, but
@@ -59,6 +71,143 @@ bool ReadFile(const char* filename, const char* mode, std::vector<T>* data) {
   return true;
 }
 
+// The contents of a binary file, as an array of elements of type |T|.  Where
+// the platform allows it, a regular file is mapped into memory, so that its
+// contents are used in place instead of being copied into a buffer.  Other
+// files, such as the standard input, are read with ReadFile.
+template <typename T>
+class InputFile {
+ public:
+  InputFile() = default;
+  InputFile(const InputFile&) = delete;
+  InputFile& operator=(const InputFile&) = delete;
+  ~InputFile() { Unmap(); }
+
+  // Maps or reads the file named as |filename|.  If |filename| is nullptr or
+  // "-", reads from the standard input.  If any error occurs, writes error
+  // messages to standard error and returns false.
+  bool Open(const char* filename);
+
+  // Returns the elements of the file.  They are only valid until the file is
+  // closed.
+  const T* data() const { return mapped_ ? mapped_ : buffer_.data(); }
+
+  // Returns the number of elements in the file.
+  size_t size() const { return mapped_ ? mapped_size_ : buffer_.size(); }
+
+ private:
+  // Maps the regular file named as |filename| if possible.  Returns false
+  // without writing an error message otherwise, in which case the file should
+  // be read with ReadFile, which reports the errors.  Sets |corrupt| if the
+  // file size is not a multiple of the size of |T|.
+  bool Map(const char* filename, bool* corrupt);
+
+  // Unmaps the file if it is mapped.
+  void Unmap();
+
+  const T* mapped_ = nullptr;  // The mapped elements, if mapped.
+  size_t mapped_size_ = 0;     // The number of mapped elements.
+  std::vector<T> buffer_;      // The elements read, if not mapped.
+};
+
+template <typename T>
+bool InputFile<T>::Open(const char* filename) {
+  Unmap();
+  buffer_.clear();
+  const bool use_file = filename && strcmp("-", filename);
+  bool corrupt = false;
+  if (use_file && Map(filename, &corrupt)) return true;
+  if (corrupt) {
+    fprintf(stderr,
+            "error: file size should be a multiple of %zd; file '%s' corrupt\n",
+            sizeof(T), filename);
+    return false;
+  }
+  return ReadFile<T>(filename, "rb", &buffer_);
+}
+
+#if defined(_WIN32)
+template <typename T>
+bool InputFile<T>::Map(const char* filename, bool* corrupt) {
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER file_size;
+  if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &file_size) ||
+      file_size.QuadPart == 0 ||
+      static_cast<uint64_t>(file_size.QuadPart) > SIZE_MAX) {
+    CloseHandle(file);
+    return false;
+  }
+  const size_t bytes = static_cast<size_t>(file_size.QuadPart);
+  if (bytes % sizeof(T)) {
+    CloseHandle(file);
+    *corrupt = true;
+    return false;
+  }
+  // The view keeps the mapping and the file open until it is unmapped.
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (!mapping) return false;
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view) return false;
+  mapped_ = static_cast<const T*>(view);
+  mapped_size_ = bytes / sizeof(T);
+  return true;
+}
+
+template <typename T>
+void InputFile<T>::Unmap() {
+  if (!mapped_) return;
+  UnmapViewOfFile(mapped_);
+  mapped_ = nullptr;
+  mapped_size_ = 0;
+}
+#elif defined(__unix__) || defined(__APPLE__)
+template <typename T>
+bool InputFile<T>::Map(const char* filename, bool* corrupt) {
+  const int fd = open(filename, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) ||
+      file_stat.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  const size_t bytes = static_cast<size_t>(file_stat.st_size);
+  if (bytes % sizeof(T)) {
+    close(fd);
+    *corrupt = true;
+    return false;
+  }
+  // The mapping keeps the file open until it is unmapped.
+  void* map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+  mapped_ = static_cast<const T*>(map);
+  mapped_size_ = bytes / sizeof(T);
+  return true;
+}
+
+template <typename T>
+void InputFile<T>::Unmap() {
+  if (!mapped_) return;
+  munmap(const_cast<T*>(mapped_), mapped_size_ * sizeof(T));
+  mapped_ = nullptr;
+  mapped_size_ = 0;
+}
+#else
+template <typename T>
+bool InputFile<T>::Map(const char*, bool*) {
+  return false;
+}
+
+template <typename T>
+void InputFile<T>::Unmap() {}
+#endif
+
 // Writes the given |data| into the file named as |filename| using the given
 // |mode|, assuming |data| is an array of |count| elements of type |T|. If
 // |filename| is nullptr or "-", writes to standard output. If any error occurs,
@@ -39,6 +39,8 @@ Options:
   --create-library        Link the binaries into a library, keeping all exported symbols.
   --allow-partial-linkage Allow partial linkage by accepting imported symbols to be unresolved.
   --verify-ids            Verify that IDs in the resulting modules are truly unique.
+  --eliminate-dead-functions
+                          Remove functions that cannot be reached from an entry point, or from an export when creating a library.
   --version               Display linker version information
   --target-env            {%s}
                           Use validation rules from the specified environment.
@@ -77,6 +79,8 @@ int main(int argc, char** argv) {
         options.SetVerifyIds(true);
       } else if (0 == strcmp(cur_arg, "--allow-partial-linkage")) {
         options.SetAllowPartialLinkage(true);
+      } else if (0 == strcmp(cur_arg, "--eliminate-dead-functions")) {
+        options.SetEliminateDeadFunctions(true);
       } else if (0 == strcmp(cur_arg, "--version")) {
         printf("%s\n", spvSoftwareVersionDetailsString());
         // TODO(dneto): Add OpenCL 2.2 at least.
@@ -119,9 +123,13 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  std::vector<std::vector<uint32_t>> contents(inFiles.size());
+  std::vector<InputFile<uint32_t>> contents(inFiles.size());
+  std::vector<const uint32_t*> binaries(inFiles.size());
+  std::vector<size_t> binary_sizes(inFiles.size());
   for (size_t i = 0u; i < inFiles.size(); ++i) {
-    if (!ReadFile<uint32_t>(inFiles[i], "rb", &contents[i])) return 1;
+    if (!contents[i].Open(inFiles[i])) return 1;
+    binaries[i] = contents[i].data();
+    binary_sizes[i] = contents[i].size();
   }
 
   const spvtools::MessageConsumer consumer = [](spv_message_level_t level,
@@ -150,7 +158,8 @@ int main(int argc, char** argv) {
   context.SetMessageConsumer(consumer);
 
   std::vector<uint32_t> linkingResult;
-  spv_result_t status = Link(context, contents, &linkingResult, options);
+  spv_result_t status = Link(context, binaries.data(), binary_sizes.data(),
+                             binaries.size(), &linkingResult, options);
 
   if (!WriteFile<uint32_t>(outFile, "wb", linkingResult.data(),
                            linkingResult.size()))
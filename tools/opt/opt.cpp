@@ -13,21 +13,33 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #include "source/opt/log.h"
 #include "source/spirv_target_env.h"
 #include "source/util/string_utils.h"
 #include "spirv-tools/libspirv.hpp"
 #include "spirv-tools/optimizer.hpp"
+#include "spirv-tools/service.hpp"
 #include "tools/io.h"
+#include "tools/util/batch.h"
 #include "tools/util/cli_consumer.h"
 
 namespace {
@@ -40,6 +52,34 @@ struct OptStatus {
   int code;
 };
 
+// The settings of the --search mode.
+struct SearchSettings {
+  bool enabled = false;
+  // The command that computes the cost of a candidate, if not empty.
+  std::string cost_command;
+  spvtools::Optimizer::SearchOptions options;
+};
+
+// The settings of the flags that spirv-opt handles itself rather than passing
+// them to the optimizer.
+struct ToolSettings {
+  bool print_stats = false;
+  SearchSettings search;
+  // Whether to serve requests from standard input rather than optimize a file.
+  bool server = false;
+  uint32_t server_threads = 1;
+  spv_target_env target_env = SPV_ENV_UNIVERSAL_1_5;
+  // Whether to optimize all the inputs, and how many at the same time.
+  bool batch = false;
+  uint32_t num_jobs = 1;
+  // Whether the inputs of --batch share a cache of function results.
+  bool function_cache = false;
+  // The inputs after the first one, which only --batch accepts.
+  std::vector<std::string> extra_inputs;
+  // The file to write the Chrome trace of the passes to, if any.
+  const char* trace_file = nullptr;
+};
+
 // Message consumer for this tool.  Used to emit diagnostics during
 // initialization and setup. Note that |source| and |position| are irrelevant
 // here because we are still not processing a SPIR-V input file.
@@ -98,26 +138,40 @@ void PrintUsage(const char* program) {
       R"(%s - Optimize a SPIR-V binary file.
 
 USAGE: %s [options] [<input>] -o <output>
+       %s [options] --batch [-j <n>] <path> ... -o <directory>
 
 The SPIR-V binary is read from <input>. If no file is specified,
 or if <input> is "-", then the binary is read from standard input.
 if <output> is "-", then the optimized output is written to
 standard output.
 
+With --batch, each <path> is a file to optimize or a directory whose files
+ending in ".spv" are optimized, and each optimized module is written to the
+file of the same name in <directory>.  The messages of each file are
+preceded by its name, and the files that failed are listed at the end.
+
 NOTE: The optimizer is a work in progress.
 
 Options (in lexicographical order):)",
-      program, program);
+      program, program, program);
   printf(R"(
   --amd-ext-to-khr
                Replaces the extensions VK_AMD_shader_ballot, VK_AMD_gcn_shader,
                and VK_AMD_shader_trinary_minmax with equivalent code using core
                instructions and capabilities.)");
   printf(R"(
+  --batch
+               Optimize all the inputs, see above.)");
+  printf(R"(
   --before-hlsl-legalization
                Forwards this option to the validator.  See the validator help
                for details.)");
   printf(R"(
+  --canonical-layout
+               Order the functions so that callees come before their callers,
+               put the blocks of each function in structured order, and
+               renumber the result ids in the order of their definitions.)");
+  printf(R"(
   --ccp
                Apply the conditional constant propagation transform.  This will
                propagate constant values throughout the program, and simplify
@@ -196,6 +250,12 @@ Options (in lexicographical order):)",
                unused stores to vector components, that are not removed by
                aggressive dead code elimination.)");
   printf(R"(
+  --eliminate-dead-stores
+               Forwards stored values to loads of the same memory, and deletes
+               stores that are overwritten before being read. Works through
+               access chains and across blocks, on function scope, private and
+               workgroup memory.)");
+  printf(R"(
   --eliminate-dead-variables
                Deletes module scope variables that are not referenced.)");
   printf(R"(
@@ -234,6 +294,13 @@ Options (in lexicographical order):)",
                Freeze the values of specialization constants to their default
                values.)");
   printf(R"(
+  --function-cache
+               With --batch, optimize the functions found in several inputs
+               once.  The passes that run one function at a time, such as
+               those in the middle of the legalization passes, reuse their
+               results for the functions they have already seen in another
+               input, up to a renumbering of the ids.)");
+  printf(R"(
   --graphics-robust-access
                Clamp indices used to access buffers and internal composite
                values, providing guarantees that satisfy Vulkan's
@@ -251,6 +318,20 @@ Options (in lexicographical order):)",
                functions. Currently does not inline calls to functions with
                early return in a loop.)");
   printf(R"(
+  --inline-entry-points-selective[=<n>]
+               Inline the function calls in entry point call tree functions
+               that are worth their cost: calls with opaque arguments or
+               results, the only call to a function, and calls to small
+               functions, with a higher size limit in loops and for constant
+               arguments.  The inlined calls grow the module by at most <n>
+               percent.  The default is 20.)");
+  printf(R"(
+  --jump-threading
+               Thread the value of a selection condition into later
+               selections on the same condition: nested selections get a
+               constant condition, and back-to-back selections are fused into
+               one.)");
+  printf(R"(
   --legalize-hlsl
                Runs a series of optimizations that attempts to take SPIR-V
                generated by an HLSL front-end and generates legal Vulkan SPIR-V.
@@ -295,6 +376,12 @@ Options (in lexicographical order):)",
                additional non-0 integer argument to set the unroll factor, or
                how many times a loop body should be duplicated)");
   printf(R"(
+  --loop-unroll-heuristic[=<n>]
+               Unrolls the loops not marked with the DontUnroll flag by a
+               factor chosen for each loop from its size, trip count and
+               estimated register pressure.  The unrolled loops grow the
+               module by at most <n> percent.  The default is 25.)");
+  printf(R"(
   --loop-peeling
                Execute few first (respectively last) iterations before
                (respectively after) the loop if it can elide some branches.)");
@@ -310,6 +397,14 @@ Options (in lexicographical order):)",
                default is the minimum value for this limit, 0x3FFFFF.  See
                section 2.17 of the Spir-V specification.)");
   printf(R"(
+  --max-memory=<megabytes>
+               Keep the memory used by the module and its analyses under
+               the given number of megabytes between passes, by dropping the
+               analyses cached for each function, such as dominator trees and
+               loop descriptors, after a pass that exceeds it.  A warning is
+               printed if that is not enough.  The memory is an estimate
+               from the sizes of the data structures.)");
+  printf(R"(
   --merge-blocks
                Join two blocks into a single block if the second has the
                first as its only predecessor. Performed only on entry point
@@ -335,6 +430,12 @@ Options (in lexicographical order):)",
                the loop on each branch of the conditional and adjusting each
                copy of the loop.)");
   printf(R"(
+  --num-threads=<n>
+               Allows the passes that support it, such as
+               --local-redundancy-elimination, to process up to <n> functions
+               at the same time.  The output does not depend on <n>.  The
+               default is 1.)");
+  printf(R"(
   -O
                Optimize for performance. Apply a sequence of transformations
                in an attempt to improve the performance of the generated
@@ -383,6 +484,11 @@ Options (in lexicographical order):)",
                --merge-blocks followed by all the transformations implied by
                -O.)");
   printf(R"(
+  --partial-redundancy-elimination
+               Looks for instructions in merge blocks whose value is already
+               computed on some of the paths reaching them. Computes it on the
+               other paths as well, and replaces the instruction with a phi.)");
+  printf(R"(
   --preserve-bindings
                Ensure that the optimizer preserves all bindings declared within
                the module, even when those bindings are unused.)");
@@ -395,6 +501,21 @@ Options (in lexicographical order):)",
                Print SPIR-V assembly to standard error output before each pass
                and after the last pass.)");
   printf(R"(
+  --print-changed
+               Print SPIR-V assembly to standard error output before the first
+               pass, and then, after each pass that changes the module, only
+               the functions it changed, preceded by the module-level
+               instructions if it changed any of them.  It is much faster
+               than --print-all on large modules.)");
+  printf(R"(
+  --print-stats
+               Print static cost estimates of each entry point of the
+               optimized module to standard output: the number of ALU,
+               memory, texture and control instructions, barriers and
+               branches on non-constant values, each weighted by the expected
+               trip counts of its loops, and the largest number of registers
+               estimated to be live in a block.)");
+  printf(R"(
   --private-to-local
                Change the scope of private variables that are used in a single
                function to that function.)");
@@ -447,6 +568,52 @@ Options (in lexicographical order):)",
                be replaced.  0 means there is no limit.  The default value is
                100.)");
   printf(R"(
+  --schedule-instructions
+               Reorder the instructions in each basic block to lower the number
+               of values live at the same time.  Memory accesses and barriers
+               keep their order.)");
+  printf(R"(
+  --search
+               Search for the pass flags that give the lowest cost for the
+               input module instead of running the given ones.  The search
+               starts from the given flags, or from -O if there are none, and
+               tries random changes to them for a number of rounds.  The
+               module optimized with the best flags is written to the output
+               file, and the best flags are printed to standard output.)");
+  printf(R"(
+  --search-cost=<cost>
+               The cost minimized by --search.  <cost> is one of
+               instructions, the number of instructions of the module, or
+               register-pressure, the largest estimate of the number of values
+               live in a block.  The default is instructions.)");
+  printf(R"(
+  --search-cost-command=<command>
+               Use an external command as the cost of --search.  For each
+               candidate module, <command> is run with the name of a file
+               holding the module appended, and must print the cost as a
+               number to standard output.)");
+  printf(R"(
+  --search-rounds=<n>
+               The number of rounds of --search.  The default is 16.)");
+  printf(R"(
+  --search-threads=<n>
+               The number of candidates --search evaluates at the same time.
+               The default is 1.)");
+  printf(R"(
+  --server
+               Instead of optimizing a file, serve requests read from standard
+               input and write their responses to standard output until the
+               input ends, so that a build does not start spirv-opt for every
+               module.  A request either optimizes a module with the flags it
+               holds, or validates it; see include/spirv-tools/service.hpp for
+               their format.  The flags of the command line that set the
+               target environment and the validator options apply to all
+               requests.)");
+  printf(R"(
+  --server-threads=<n>
+               The number of requests --server handles at the same time.  The
+               default is 1.)");
+  printf(R"(
   --set-spec-const-default-value "<spec id>:<default value> ..."
                Set the default values of the specialization constants with
                <spec id>:<default value> pairs specified in a double-quoted
@@ -459,6 +626,11 @@ Options (in lexicographical order):)",
                Will simplify all instructions in the function as much as
                possible.)");
   printf(R"(
+  --slp-vectorize
+               Rewrites vectors built from scalars that are computed by the
+               same arithmetic operations into vector arithmetic, when that
+               removes more instructions than it adds.)");
+  printf(R"(
   --skip-block-layout
                Forwards this option to the validator.  See the validator help
                for details.)");
@@ -470,6 +642,11 @@ Options (in lexicographical order):)",
                pattern that cannot be converted into legal WebGPU, so this
                conversion may not succeed.)");
   printf(R"(
+  --skip-unchanged-passes
+               Skips a pass when a pass with the same name has already run
+               without changing the module, and no pass has changed the
+               module since.)");
+  printf(R"(
   --skip-validation
                Will not validate the SPIR-V before optimizing.  If the SPIR-V
                is invalid, the optimizer may fail or generate incorrect code.
@@ -501,7 +678,29 @@ Options (in lexicographical order):)",
                systems. This option is the same as -ftime-report in GCC. It
                prints CPU/WALL/USR/SYS time (and RSS if possible), but note that
                USR/SYS time are returned by getrusage() and can have a small
-               error.)");
+               error.  It is followed by the approximate memory used by the
+               module and by each analysis after each pass.)");
+  printf(R"(
+  --time-report-counters=<counter>[,<counter>...]
+               Add the given hardware performance counters of each pass to
+               the report of --time-report.  The counters are
+               "instructions", "cache-misses" and "branch-misses".  They are
+               read with perf_event_open() on Linux, and are shown as "n/a"
+               where they are not available.)");
+  printf(R"(
+  --time-report=json
+               Print a JSON report to standard error output with, for each
+               pass, its wall and CPU time, RSS delta, the number of
+               instructions before and after it, the analyses it had to build
+               and how long each took, whether it changed the module, and the
+               approximate memory used by the module and each analysis after
+               it.)");
+  printf(R"(
+  --trace=<file>
+               Write a trace of the passes to <file> in the Chrome trace
+               event format, with the analyses each pass built nested in its
+               span.  The trace can be viewed in chrome://tracing or
+               Perfetto.)");
   printf(R"(
   --upgrade-memory-model
                Upgrades the Logical GLSL450 memory model to Logical VulkanKHR.
@@ -562,6 +761,10 @@ Options (in lexicographical order):)",
   -h, --help
                Print this help.)");
   printf(R"(
+  -j <n>
+               Optimize up to <n> files of --batch at the same time.  The
+               default is 1.)");
+  printf(R"(
   --version
                Display optimizer version information.
 )");
@@ -617,20 +820,22 @@ OptStatus ParseFlags(int argc, const char** argv,
                      spvtools::Optimizer* optimizer, const char** in_file,
                      const char** out_file,
                      spvtools::ValidatorOptions* validator_options,
-                     spvtools::OptimizerOptions* optimizer_options);
+                     spvtools::OptimizerOptions* optimizer_options,
+                     ToolSettings* tool_settings);
 
 // Parses and handles the -Oconfig flag. |prog_name| contains the name of
 // the spirv-opt binary (used to build a new argv vector for the recursive
 // invocation to ParseFlags). |opt_flag| contains the -Oconfig=FILENAME flag.
-// |optimizer|, |in_file|, |out_file|, |validator_options|, and
-// |optimizer_options| are as in ParseFlags.
+// |optimizer|, |in_file|, |out_file|, |validator_options|,
+// |optimizer_options| and |tool_settings| are as in ParseFlags.
 //
 // This returns the same OptStatus instance returned by ParseFlags.
 OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
                            spvtools::Optimizer* optimizer, const char** in_file,
                            const char** out_file,
                            spvtools::ValidatorOptions* validator_options,
-                           spvtools::OptimizerOptions* optimizer_options) {
+                           spvtools::OptimizerOptions* optimizer_options,
+                           ToolSettings* tool_settings) {
   std::vector<std::string> flags;
   flags.push_back(prog_name);
 
@@ -653,9 +858,9 @@ OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
     new_argv[i] = flags[i].c_str();
   }
 
-  auto ret_val =
-      ParseFlags(static_cast<int>(flags.size()), new_argv, optimizer, in_file,
-                 out_file, validator_options, optimizer_options);
+  auto ret_val = ParseFlags(static_cast<int>(flags.size()), new_argv,
+                            optimizer, in_file, out_file, validator_options,
+                            optimizer_options, tool_settings);
   delete[] new_argv;
   return ret_val;
 }
@@ -705,14 +910,16 @@ std::string CanonicalizeFlag(const char** argv, int argc, int* argi) {
 // Optimizer instance used to optimize the program.
 //
 // On return, this function stores the name of the input program in |in_file|.
-// The name of the output file in |out_file|. The return value indicates whether
+// The name of the output file in |out_file|. The flags handled by spirv-opt
+// itself are stored in |tool_settings|. The return value indicates whether
 // optimization should continue and a status code indicating an error or
 // success.
 OptStatus ParseFlags(int argc, const char** argv,
                      spvtools::Optimizer* optimizer, const char** in_file,
                      const char** out_file,
                      spvtools::ValidatorOptions* validator_options,
-                     spvtools::OptimizerOptions* optimizer_options) {
+                     spvtools::OptimizerOptions* optimizer_options,
+                     ToolSettings* tool_settings) {
   std::vector<std::string> pass_flags;
   bool target_env_set = false;
   bool vulkan_to_webgpu_set = false;
@@ -739,14 +946,26 @@ OptStatus ParseFlags(int argc, const char** argv,
         if (!*in_file) {
           *in_file = cur_arg;
         } else {
+          tool_settings->extra_inputs.push_back(cur_arg);
+        }
+      } else if (0 == strcmp(cur_arg, "--batch")) {
+        tool_settings->batch = true;
+      } else if (0 == strcmp(cur_arg, "--function-cache")) {
+        tool_settings->function_cache = true;
+      } else if (0 == strncmp(cur_arg, "-j", 2)) {
+        const char* jobs = cur_arg[2] ? cur_arg + 2 : nullptr;
+        if (!jobs && argi + 1 < argc) jobs = argv[++argi];
+        const int num_jobs = jobs ? atoi(jobs) : 0;
+        if (num_jobs < 1) {
           spvtools::Error(opt_diagnostic, nullptr, {},
-                          "More than one input file specified");
+                          "The number of jobs of -j must be at least 1");
           return {OPT_STOP, 1};
         }
+        tool_settings->num_jobs = static_cast<uint32_t>(num_jobs);
       } else if (0 == strncmp(cur_arg, "-Oconfig=", sizeof("-Oconfig=") - 1)) {
-        OptStatus status =
-            ParseOconfigFlag(argv[0], cur_arg, optimizer, in_file, out_file,
-                             validator_options, optimizer_options);
+        OptStatus status = ParseOconfigFlag(
+            argv[0], cur_arg, optimizer, in_file, out_file, validator_options,
+            optimizer_options, tool_settings);
         if (status.action != OPT_CONTINUE) {
           return status;
         }
@@ -754,12 +973,91 @@ OptStatus ParseFlags(int argc, const char** argv,
         optimizer_options->set_run_validator(false);
       } else if (0 == strcmp(cur_arg, "--print-all")) {
         optimizer->SetPrintAll(&std::cerr);
+      } else if (0 == strcmp(cur_arg, "--print-changed")) {
+        optimizer->SetPrintChanged(&std::cerr);
       } else if (0 == strcmp(cur_arg, "--preserve-bindings")) {
         optimizer_options->set_preserve_bindings(true);
       } else if (0 == strcmp(cur_arg, "--preserve-spec-constants")) {
         optimizer_options->set_preserve_spec_constants(true);
+      } else if (0 == strcmp(cur_arg, "--skip-unchanged-passes")) {
+        optimizer->SetSkipUnchangedPasses(true);
+      } else if (0 == strcmp(cur_arg, "--print-stats")) {
+        tool_settings->print_stats = true;
+      } else if (0 == strcmp(cur_arg, "--search")) {
+        tool_settings->search.enabled = true;
+      } else if (0 == strcmp(cur_arg, "--search-cost=instructions")) {
+        tool_settings->search.options.cost =
+            spvtools::Optimizer::SearchCost::kInstructionCount;
+      } else if (0 == strcmp(cur_arg, "--search-cost=register-pressure")) {
+        tool_settings->search.options.cost =
+            spvtools::Optimizer::SearchCost::kRegisterPressure;
+      } else if (0 == strncmp(cur_arg, "--search-cost-command=",
+                              sizeof("--search-cost-command=") - 1)) {
+        tool_settings->search.cost_command =
+            spvtools::utils::SplitFlagArgs(cur_arg).second;
+        tool_settings->search.options.cost =
+            spvtools::Optimizer::SearchCost::kCustom;
+      } else if (0 == strncmp(cur_arg, "--search-rounds=",
+                              sizeof("--search-rounds=") - 1)) {
+        auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        int num_rounds = atoi(split_flag.second.c_str());
+        if (num_rounds < 1) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "The number of search rounds must be at least 1");
+          return {OPT_STOP, 1};
+        }
+        tool_settings->search.options.num_rounds =
+            static_cast<uint32_t>(num_rounds);
+      } else if (0 == strncmp(cur_arg, "--search-threads=",
+                              sizeof("--search-threads=") - 1)) {
+        auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        int num_threads = atoi(split_flag.second.c_str());
+        if (num_threads < 1) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "The number of search threads must be at least 1");
+          return {OPT_STOP, 1};
+        }
+        tool_settings->search.options.num_threads =
+            static_cast<uint32_t>(num_threads);
+      } else if (0 == strcmp(cur_arg, "--server")) {
+        tool_settings->server = true;
+      } else if (0 == strncmp(cur_arg, "--server-threads=",
+                              sizeof("--server-threads=") - 1)) {
+        auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        int num_threads = atoi(split_flag.second.c_str());
+        if (num_threads < 1) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "The number of server threads must be at least 1");
+          return {OPT_STOP, 1};
+        }
+        tool_settings->server_threads = static_cast<uint32_t>(num_threads);
       } else if (0 == strcmp(cur_arg, "--time-report")) {
         optimizer->SetTimeReport(&std::cerr);
+      } else if (0 == strncmp(cur_arg, "--time-report-counters=",
+                              sizeof("--time-report-counters=") - 1)) {
+        uint32_t counters = 0;
+        std::istringstream names(
+            spvtools::utils::SplitFlagArgs(cur_arg).second);
+        std::string name;
+        while (std::getline(names, name, ',')) {
+          if (name == "instructions") {
+            counters |= spvtools::Optimizer::kTimeReportInstructions;
+          } else if (name == "cache-misses") {
+            counters |= spvtools::Optimizer::kTimeReportCacheMisses;
+          } else if (name == "branch-misses") {
+            counters |= spvtools::Optimizer::kTimeReportBranchMisses;
+          } else {
+            spvtools::Error(
+                opt_diagnostic, nullptr, {},
+                ("Unknown hardware counter '" + name + "'").c_str());
+            return {OPT_STOP, 1};
+          }
+        }
+        optimizer->SetTimeReportCounters(counters);
+      } else if (0 == strcmp(cur_arg, "--time-report=json")) {
+        optimizer->SetJsonTimeReport(&std::cerr);
+      } else if (0 == strncmp(cur_arg, "--trace=", sizeof("--trace=") - 1)) {
+        tool_settings->trace_file = cur_arg + sizeof("--trace=") - 1;
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         validator_options->SetRelaxStructStore(true);
       } else if (0 == strncmp(cur_arg, "--max-id-bound=",
@@ -779,6 +1077,26 @@ OptStatus ParseFlags(int argc, const char** argv,
         optimizer_options->set_max_id_bound(max_id_bound);
         validator_options->SetUniversalLimit(spv_validator_limit_max_id_bound,
                                              max_id_bound);
+      } else if (0 == strncmp(cur_arg, "--max-memory=",
+                              sizeof("--max-memory=") - 1)) {
+        auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        int megabytes = atoi(split_flag.second.c_str());
+        if (megabytes < 1) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "The memory limit must be at least 1 megabyte");
+          return {OPT_STOP, 1};
+        }
+        optimizer->SetMaxMemory(static_cast<size_t>(megabytes) << 20);
+      } else if (0 == strncmp(cur_arg, "--num-threads=",
+                              sizeof("--num-threads=") - 1)) {
+        auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        int num_threads = atoi(split_flag.second.c_str());
+        if (num_threads < 1) {
+          spvtools::Error(opt_diagnostic, nullptr, {},
+                          "The number of threads must be at least 1");
+          return {OPT_STOP, 1};
+        }
+        optimizer->SetNumThreads(static_cast<uint32_t>(num_threads));
       } else if (0 == strncmp(cur_arg,
                               "--target-env=", sizeof("--target-env=") - 1)) {
         target_env_set = true;
@@ -803,6 +1121,7 @@ OptStatus ParseFlags(int argc, const char** argv,
           return {OPT_STOP, 1};
         }
         optimizer->SetTargetEnv(target_env);
+        tool_settings->target_env = target_env;
       } else if (0 == strcmp(cur_arg, "--vulkan-to-webgpu")) {
         vulkan_to_webgpu_set = true;
         if (target_env_set) {
@@ -820,6 +1139,7 @@ OptStatus ParseFlags(int argc, const char** argv,
         }
 
         optimizer->SetTargetEnv(SPV_ENV_VULKAN_1_1);
+        tool_settings->target_env = SPV_ENV_VULKAN_1_1;
         optimizer->RegisterVulkanToWebGPUPasses();
       } else if (0 == strcmp(cur_arg, "--webgpu-to-vulkan")) {
         webgpu_to_vulkan_set = true;
@@ -838,6 +1158,7 @@ OptStatus ParseFlags(int argc, const char** argv,
         }
 
         optimizer->SetTargetEnv(SPV_ENV_WEBGPU_0);
+        tool_settings->target_env = SPV_ENV_WEBGPU_0;
         optimizer->RegisterWebGPUToVulkanPasses();
       } else if (0 == strcmp(cur_arg, "--validate-after-all")) {
         optimizer->SetValidateAfterAll(true);
@@ -868,9 +1189,7 @@ OptStatus ParseFlags(int argc, const char** argv,
       if (!*in_file) {
         *in_file = cur_arg;
       } else {
-        spvtools::Error(opt_diagnostic, nullptr, {},
-                        "More than one input file specified");
-        return {OPT_STOP, 1};
+        tool_settings->extra_inputs.push_back(cur_arg);
       }
     }
   }
@@ -882,6 +1201,96 @@ OptStatus ParseFlags(int argc, const char** argv,
   return {OPT_CONTINUE, 0};
 }
 
+// Returns the cost that |command| prints for the module |binary|, which is
+// written to a file whose name is made from |out_file| and |id|.  Returns
+// infinity if the command does not print a cost.
+double RunCostCommand(const std::string& command, const char* out_file,
+                      size_t id, const std::vector<uint32_t>& binary) {
+  const std::string file_name =
+      std::string(out_file) + ".search-" + std::to_string(id);
+  if (!WriteFile<uint32_t>(file_name.c_str(), "wb", binary.data(),
+                           binary.size())) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  double cost = std::numeric_limits<double>::infinity();
+  const std::string command_line = command + " \"" + file_name + "\"";
+#if defined(_WIN32)
+  FILE* output = _popen(command_line.c_str(), "r");
+#else
+  FILE* output = popen(command_line.c_str(), "r");
+#endif
+  if (output != nullptr) {
+    if (fscanf(output, "%lf", &cost) != 1) {
+      cost = std::numeric_limits<double>::infinity();
+    }
+#if defined(_WIN32)
+    _pclose(output);
+#else
+    pclose(output);
+#endif
+  }
+  std::remove(file_name.c_str());
+  return cost;
+}
+
+// Searches for the best pass flags for the |binary_size| words of |binary|
+// with the settings in |search_settings|, starting from the flags of
+// |optimizer|.  Prints the best flags to standard output and writes the module
+// they produce to |optimized_binary|.  Returns false if the search fails.
+bool SearchPassFlags(const uint32_t* binary, size_t binary_size,
+                     const spvtools::OptimizerOptions& optimizer_options,
+                     const char* out_file, SearchSettings* search_settings,
+                     const spvtools::Optimizer& optimizer,
+                     std::vector<uint32_t>* optimized_binary) {
+  std::atomic<size_t> next_id(0);
+  if (!search_settings->cost_command.empty()) {
+    const std::string& command = search_settings->cost_command;
+    search_settings->options.custom_cost =
+        [&command, out_file, &next_id](const std::vector<uint32_t>& module) {
+          return RunCostCommand(command, out_file, next_id++, module);
+        };
+  }
+
+  spvtools::Optimizer::SearchResult result;
+  if (!optimizer.SearchPassFlags(binary, binary_size, optimizer_options,
+                                 search_settings->options, &result)) {
+    return false;
+  }
+
+  printf("cost: %g\nflags:", result.cost);
+  for (const auto& flag : result.flags) {
+    printf(" %s", flag.c_str());
+  }
+  printf("\n");
+  *optimized_binary = std::move(result.binary);
+  return true;
+}
+
+// Prints the stats of each entry point of the module |binary| to standard
+// output.  Returns false if the module cannot be built.
+bool PrintStats(const spvtools::Optimizer& optimizer,
+                const std::vector<uint32_t>& binary) {
+  std::vector<spvtools::Optimizer::EntryPointStats> all_stats;
+  if (!optimizer.ComputeEntryPointStats(binary.data(), binary.size(),
+                                        &all_stats)) {
+    return false;
+  }
+  for (const auto& stats : all_stats) {
+    printf("entry point \"%s\" (execution model %u):\n", stats.name.c_str(),
+           stats.execution_model);
+    printf("  alu instructions: %g\n", stats.alu_instructions);
+    printf("  memory instructions: %g\n", stats.memory_instructions);
+    printf("  texture instructions: %g\n", stats.texture_instructions);
+    printf("  control instructions: %g\n", stats.control_instructions);
+    printf("  barriers: %g\n", stats.barriers);
+    printf("  dynamic branches: %g\n", stats.dynamic_branches);
+    printf("  max live registers: %u\n",
+           static_cast<unsigned>(stats.max_live_registers));
+  }
+  return true;
+}
+
 }  // namespace
 
 int main(int argc, const char** argv) {
@@ -895,32 +1304,144 @@ int main(int argc, const char** argv) {
 
   spvtools::ValidatorOptions validator_options;
   spvtools::OptimizerOptions optimizer_options;
-  OptStatus status = ParseFlags(argc, argv, &optimizer, &in_file, &out_file,
-                                &validator_options, &optimizer_options);
+  ToolSettings tool_settings;
+  OptStatus status =
+      ParseFlags(argc, argv, &optimizer, &in_file, &out_file,
+                 &validator_options, &optimizer_options, &tool_settings);
   optimizer_options.set_validator_options(validator_options);
 
   if (status.action == OPT_STOP) {
     return status.code;
   }
 
+  if (!tool_settings.batch && !tool_settings.extra_inputs.empty()) {
+    spvtools::Error(opt_diagnostic, nullptr, {},
+                    "More than one input file specified");
+    return 1;
+  }
+
+  if (tool_settings.batch) {
+    if (out_file == nullptr) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      "--batch requires -o <directory>");
+      return 1;
+    }
+    if (tool_settings.search.enabled || tool_settings.server ||
+        tool_settings.print_stats || tool_settings.trace_file) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      "--batch cannot be used with --search, --server, "
+                      "--print-stats or --trace");
+      return 1;
+    }
+
+    std::vector<std::string> inputs;
+    if (in_file) inputs.push_back(in_file);
+    inputs.insert(inputs.end(), tool_settings.extra_inputs.begin(),
+                  tool_settings.extra_inputs.end());
+    std::vector<std::string> files;
+    if (!spvtools::utils::ExpandBatchInputs(inputs, ".spv", &files)) {
+      return 1;
+    }
+    std::unordered_map<std::string, std::string> outputs;
+    std::unordered_set<std::string> names;
+    for (const std::string& file : files) {
+      const std::string name = spvtools::utils::BaseName(file);
+      if (!names.insert(name).second) {
+        spvtools::Error(opt_diagnostic, nullptr, {},
+                        ("Two inputs would be written to " + name).c_str());
+        return 1;
+      }
+      outputs[file] = std::string(out_file) + "/" + name;
+    }
+
+    spvtools::FunctionCache function_cache;
+    const size_t num_failed = spvtools::utils::ProcessBatch(
+        "spirv-opt", files, tool_settings.num_jobs,
+        [&](const std::string& file, std::string* messages) {
+          // A pass can only be run once, so each file gets an optimizer of
+          // its own, set up by the same flags.  The options are shared.
+          spvtools::Optimizer file_optimizer(target_env);
+          file_optimizer.SetMessageConsumer(
+              spvtools::utils::CaptureCLIMessages(file, messages));
+          if (tool_settings.function_cache) {
+            file_optimizer.SetFunctionCache(&function_cache);
+          }
+          const char* unused_in_file = nullptr;
+          const char* unused_out_file = nullptr;
+          spvtools::ValidatorOptions unused_validator_options;
+          spvtools::OptimizerOptions unused_optimizer_options;
+          ToolSettings unused_tool_settings;
+          ParseFlags(argc, argv, &file_optimizer, &unused_in_file,
+                     &unused_out_file, &unused_validator_options,
+                     &unused_optimizer_options, &unused_tool_settings);
+
+          InputFile<uint32_t> input;
+          if (!input.Open(file.c_str())) return false;
+          std::vector<uint32_t> binary;
+          return file_optimizer.Run(input.data(), input.size(), &binary,
+                                    optimizer_options) &&
+                 WriteFile<uint32_t>(outputs.at(file).c_str(), "wb",
+                                     binary.data(), binary.size());
+        });
+    return num_failed != 0;
+  }
+
+  if (tool_settings.server) {
+    if (in_file || out_file || !optimizer.GetPassNames().empty()) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      "--server takes its modules and passes from its "
+                      "requests, not from the command line");
+      return 1;
+    }
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    spvtools::Service service(tool_settings.target_env,
+                              tool_settings.server_threads);
+    service.SetValidatorOptions(validator_options);
+    service.SetOptimizerOptions(optimizer_options);
+    return service.Serve(std::cin, std::cout) ? 0 : 1;
+  }
+
   if (out_file == nullptr) {
     spvtools::Error(opt_diagnostic, nullptr, {}, "-o required");
     return 1;
   }
 
-  std::vector<uint32_t> binary;
-  if (!ReadFile<uint32_t>(in_file, "rb", &binary)) {
+  InputFile<uint32_t> input;
+  if (!input.Open(in_file)) {
     return 1;
   }
 
-  // By using the same vector as input and output, we save time in the case
-  // that there was no change.
-  bool ok =
-      optimizer.Run(binary.data(), binary.size(), &binary, optimizer_options);
+  std::ofstream trace;
+  if (tool_settings.trace_file) {
+    trace.open(tool_settings.trace_file);
+    if (!trace) {
+      spvtools::Error(opt_diagnostic, nullptr, {},
+                      (std::string("Could not open trace file ") +
+                       tool_settings.trace_file)
+                          .c_str());
+      return 1;
+    }
+    optimizer.SetTraceReport(&trace);
+  }
+
+  std::vector<uint32_t> binary;
+  bool ok = tool_settings.search.enabled
+                ? SearchPassFlags(input.data(), input.size(),
+                                  optimizer_options, out_file,
+                                  &tool_settings.search, optimizer, &binary)
+                : optimizer.Run(input.data(), input.size(), &binary,
+                                optimizer_options);
 
   if (!WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())) {
     return 1;
   }
 
+  if (ok && tool_settings.print_stats) {
+    ok = PrintStats(optimizer, binary);
+  }
+
   return ok ? 0 : 1;
 }
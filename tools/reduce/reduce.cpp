@@ -14,15 +14,23 @@
 
 #include <cassert>
 #include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 
 #include "source/opt/build_module.h"
 #include "source/opt/ir_context.h"
 #include "source/opt/log.h"
 #include "source/reduce/reducer.h"
 #include "source/spirv_reducer_options.h"
+#include "source/util/interestingness_cache.h"
 #include "source/util/string_utils.h"
 #include "tools/io.h"
 #include "tools/util/cli_consumer.h"
@@ -47,6 +55,89 @@ bool ExecuteCommand(const std::string& command) {
   return status == 0;
 }
 
+// Execute a command using the shell, writing |binary| to its standard input.
+// Returns true if and only if the command's exit status was 0.
+bool ExecuteCommandWithInput(const std::string& command,
+                             const std::vector<uint32_t>& binary) {
+#if defined(_WIN32)
+  FILE* pipe = _popen(command.c_str(), "wb");
+#else
+  FILE* pipe = popen(command.c_str(), "w");
+#endif
+  if (pipe == nullptr) {
+    return false;
+  }
+  // The command may exit without reading all of its input; what to make of
+  // that is up to the command, so a short write is not treated as an error.
+  fwrite(binary.data(), sizeof(uint32_t), binary.size(), pipe);
+#if defined(_WIN32)
+  return _pclose(pipe) == 0;
+#else
+  return pclose(pipe) == 0;
+#endif
+}
+
+// Writes binaries to a file on a background thread, so that reduction does not
+// wait for the file system.  Only the most recently published binary is kept:
+// a binary that is superseded before it could be written is never written.
+class ProgressWriter {
+ public:
+  explicit ProgressWriter(std::string filename)
+      : filename_(std::move(filename)),
+        has_pending_(false),
+        finished_(false),
+        thread_([this]() { Run(); }) {}
+
+  // Writes out any binary that is still pending before returning.
+  ~ProgressWriter() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      finished_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+  }
+
+  // Schedules |binary| to be written, replacing any binary not yet written.
+  void Publish(const std::vector<uint32_t>& binary) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ = binary;
+      has_pending_ = true;
+    }
+    condition_.notify_one();
+  }
+
+ private:
+  void Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      condition_.wait(lock, [this]() { return has_pending_ || finished_; });
+      if (!has_pending_) {
+        return;
+      }
+      std::vector<uint32_t> binary = std::move(pending_);
+      has_pending_ = false;
+      lock.unlock();
+      if (!WriteFile<uint32_t>(filename_.c_str(), "wb", binary.data(),
+                               binary.size())) {
+        std::cerr << "Failed to write progress file " << filename_
+                  << std::endl;
+      }
+      lock.lock();
+    }
+  }
+
+  const std::string filename_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<uint32_t> pending_;
+  bool has_pending_;
+  bool finished_;
+  // Declared last, so that the thread starts once the other members exist.
+  std::thread thread_;
+};
+
 // Status and actions to perform after parsing command-line arguments.
 enum ReduceActions { REDUCE_CONTINUE, REDUCE_STOP };
 
@@ -100,9 +191,38 @@ Options (in lexicographical order):
                SPIR-V module that fails to validate.
   -h, --help
                Print this help.
+  --interestingness-cache=
+               Specifies a file in which to remember the verdict of the
+               interestingness test for each binary it is run on, so that the
+               test is not run again on an identical binary.  Verdicts already
+               in the file are reused, so the same file can be given to a
+               restarted reduction; files from several reductions can be
+               concatenated.  Only suitable if the interestingness test is
+               deterministic.
+  --interestingness-stdin
+               Pass each binary to the interestingness test on its standard
+               input, instead of writing it to a temporary file whose path is
+               passed as an argument.  No temporary files are written.
+  --jobs=
+               32-bit unsigned integer specifying how many reduction steps to
+               evaluate concurrently; the interestingness test must then be
+               safe to run several times at once.  The result of reduction is
+               the same for any number of jobs.  The default is 1.
+  --progress-file=
+               Specifies a file to which the best binary found so far is
+               written each time reduction makes progress.  The file is
+               written in the background, so reduction does not wait for it;
+               when reduction finishes, it holds the reduced binary.
   --step-limit=
                32-bit unsigned integer specifying maximum number of steps the
                reducer will take before giving up.
+  --target-construct=
+               32-bit unsigned integer specifying the id of a block that heads
+               a structured selection or loop in the input module.  Passes
+               that remove, merge or restructure blocks will only consider
+               blocks in this construct, and all other changes are restricted
+               to the function containing it.  If 0 is specified (the default)
+               then no particular construct is targeted.
   --target-function=
                32-bit unsigned integer specifying the id of a function in the
                input module.  The reducer will restrict attention to this
@@ -147,6 +267,9 @@ ReduceStatus ParseFlags(int argc, const char** argv,
                         std::string* out_binary_file,
                         std::vector<std::string>* interestingness_test,
                         std::string* temp_file_prefix,
+                        std::string* interestingness_cache_file,
+                        bool* interestingness_via_stdin,
+                        std::string* progress_file,
                         spvtools::ReducerOptions* reducer_options,
                         spvtools::ValidatorOptions* validator_options) {
   uint32_t positional_arg_index = 0;
@@ -169,6 +292,24 @@ ReduceStatus ParseFlags(int argc, const char** argv,
           PrintUsage(argv[0]);
           return {REDUCE_STOP, 1};
         }
+      } else if (0 == strncmp(cur_arg, "--interestingness-cache=",
+                              sizeof("--interestingness-cache=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        *interestingness_cache_file = std::string(split_flag.second);
+      } else if (0 == strcmp(cur_arg, "--interestingness-stdin")) {
+        *interestingness_via_stdin = true;
+      } else if (0 == strncmp(cur_arg, "--progress-file=",
+                              sizeof("--progress-file=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        *progress_file = std::string(split_flag.second);
+      } else if (0 == strncmp(cur_arg, "--jobs=", sizeof("--jobs=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        char* end = nullptr;
+        errno = 0;
+        const auto num_jobs =
+            static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10));
+        assert(end != split_flag.second.c_str() && errno == 0);
+        reducer_options->set_num_jobs(num_jobs);
       } else if (0 == strncmp(cur_arg,
                               "--step-limit=", sizeof("--step-limit=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
@@ -178,6 +319,15 @@ ReduceStatus ParseFlags(int argc, const char** argv,
             static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10));
         assert(end != split_flag.second.c_str() && errno == 0);
         reducer_options->set_step_limit(step_limit);
+      } else if (0 == strncmp(cur_arg, "--target-construct=",
+                              sizeof("--target-construct=") - 1)) {
+        const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
+        char* end = nullptr;
+        errno = 0;
+        const auto target_construct =
+            static_cast<uint32_t>(strtol(split_flag.second.c_str(), &end, 10));
+        assert(end != split_flag.second.c_str() && errno == 0);
+        reducer_options->set_target_construct(target_construct);
       } else if (0 == strncmp(cur_arg, "--target-function=",
                               sizeof("--target-function=") - 1)) {
         const auto split_flag = spvtools::utils::SplitFlagArgs(cur_arg);
@@ -269,6 +419,9 @@ int main(int argc, const char** argv) {
   std::string out_binary_file;
   std::vector<std::string> interestingness_test;
   std::string temp_file_prefix = "temp_";
+  std::string interestingness_cache_file;
+  bool interestingness_via_stdin = false;
+  std::string progress_file;
 
   spv_target_env target_env = kDefaultEnvironment;
   spvtools::ReducerOptions reducer_options;
@@ -276,7 +429,9 @@ int main(int argc, const char** argv) {
 
   ReduceStatus status = ParseFlags(
       argc, argv, &in_binary_file, &out_binary_file, &interestingness_test,
-      &temp_file_prefix, &reducer_options, &validator_options);
+      &temp_file_prefix, &interestingness_cache_file,
+      &interestingness_via_stdin, &progress_file, &reducer_options,
+      &validator_options);
 
   if (status.action == REDUCE_STOP) {
     return status.code;
@@ -297,21 +452,57 @@ int main(int argc, const char** argv) {
   }
   std::string interestingness_command_joined = joined.str();
 
-  reducer.SetInterestingnessFunction(
-      [interestingness_command_joined, temp_file_prefix](
-          std::vector<uint32_t> binary, uint32_t reductions_applied) -> bool {
-        std::stringstream ss;
-        ss << temp_file_prefix << std::setw(4) << std::setfill('0')
-           << reductions_applied << ".spv";
-        const auto spv_file = ss.str();
-        const std::string command =
-            interestingness_command_joined + " " + spv_file;
-        auto write_file_succeeded =
-            WriteFile(spv_file.c_str(), "wb", &binary[0], binary.size());
-        (void)(write_file_succeeded);
-        assert(write_file_succeeded);
-        return ExecuteCommand(command);
-      });
+  if (interestingness_via_stdin) {
+#if !defined(_WIN32)
+    // A test that exits without reading all of its input must not take the
+    // reducer down with it.
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    reducer.SetInterestingnessFunction(
+        [interestingness_command_joined](const std::vector<uint32_t>& binary,
+                                         uint32_t) -> bool {
+          return ExecuteCommandWithInput(interestingness_command_joined,
+                                         binary);
+        });
+  } else {
+    reducer.SetInterestingnessFunction(
+        [interestingness_command_joined, temp_file_prefix](
+            std::vector<uint32_t> binary, uint32_t reductions_applied) -> bool {
+          std::stringstream ss;
+          ss << temp_file_prefix << std::setw(4) << std::setfill('0')
+             << reductions_applied << ".spv";
+          const auto spv_file = ss.str();
+          const std::string command =
+              interestingness_command_joined + " " + spv_file;
+          auto write_file_succeeded =
+              WriteFile(spv_file.c_str(), "wb", &binary[0], binary.size());
+          (void)(write_file_succeeded);
+          assert(write_file_succeeded);
+          return ExecuteCommand(command);
+        });
+  }
+
+  std::unique_ptr<ProgressWriter> progress_writer;
+  if (!progress_file.empty()) {
+    progress_writer.reset(new ProgressWriter(progress_file));
+    ProgressWriter* writer = progress_writer.get();
+    reducer.SetProgressFunction(
+        [writer](const std::vector<uint32_t>& binary, uint32_t) {
+          writer->Publish(binary);
+        });
+  }
+
+  spvtools::utils::InterestingnessCache interestingness_cache;
+  if (!interestingness_cache_file.empty()) {
+    // A missing file is not an error: it is created when reduction finishes.
+    std::ifstream cache_in(interestingness_cache_file);
+    if (cache_in && !interestingness_cache.Load(&cache_in)) {
+      spvtools::Error(ReduceDiagnostic, nullptr, {},
+                      "Malformed interestingness cache file");
+      return 1;
+    }
+    reducer.SetInterestingnessCache(&interestingness_cache);
+  }
 
   reducer.AddDefaultReductionPasses();
 
@@ -345,10 +536,51 @@ int main(int argc, const char** argv) {
     }
   }
 
+  const uint32_t target_construct = (*reducer_options).target_construct;
+  if (target_construct) {
+    // A target construct was specified; check that its header exists, heads a
+    // structured construct, and lies in the target function if there is one.
+    std::unique_ptr<spvtools::opt::IRContext> context = spvtools::BuildModule(
+        kDefaultEnvironment, spvtools::utils::CLIMessageConsumer,
+        binary_in.data(), binary_in.size());
+    auto* header_label = context->get_def_use_mgr()->GetDef(target_construct);
+    bool found_target_construct = false;
+    if (header_label && header_label->opcode() == SpvOpLabel) {
+      auto* header = context->get_instr_block(header_label);
+      found_target_construct =
+          header->GetMergeInst() != nullptr &&
+          (!target_function ||
+           header->GetParent()->result_id() == target_function);
+    }
+    if (!found_target_construct) {
+      std::stringstream strstr;
+      strstr << "Target construct with header id " << target_construct
+             << " was requested, but no such construct was found in the "
+                "target function; stopping.";
+      spvtools::utils::CLIMessageConsumer(SPV_MSG_ERROR, nullptr, {},
+                                          strstr.str().c_str());
+      return 1;
+    }
+  }
+
   std::vector<uint32_t> binary_out;
   const auto reduction_status = reducer.Run(std::move(binary_in), &binary_out,
                                             reducer_options, validator_options);
 
+  if (!interestingness_cache_file.empty()) {
+    std::ofstream cache_out(interestingness_cache_file);
+    interestingness_cache.Save(&cache_out);
+    if (!cache_out) {
+      spvtools::Error(ReduceDiagnostic, nullptr, {},
+                      "Failed to write interestingness cache file");
+    }
+    std::stringstream strstr;
+    strstr << "The interestingness cache was used "
+           << interestingness_cache.num_hits() << " times.";
+    spvtools::utils::CLIMessageConsumer(SPV_MSG_INFO, nullptr, {},
+                                        strstr.str().c_str());
+  }
+
   // Always try to write the output file, even if the reduction failed.
   if (!WriteFile<uint32_t>(out_binary_file.c_str(), "wb", binary_out.data(),
                            binary_out.size())) {
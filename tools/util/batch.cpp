@@ -0,0 +1,182 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tools/util/batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace spvtools {
+namespace utils {
+namespace {
+
+bool EndsWith(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Sets |is_directory| to whether |path| names a directory.  Returns false if
+// |path| names nothing.
+bool IsDirectory(const std::string& path, bool* is_directory) {
+#if defined(_WIN32)
+  DWORD attributes = GetFileAttributesA(path.c_str());
+  if (attributes == INVALID_FILE_ATTRIBUTES) return false;
+  *is_directory = (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) return false;
+  *is_directory = S_ISDIR(info.st_mode);
+#endif
+  return true;
+}
+
+// Appends to |names| the names of the entries of the directory |path|.
+bool ListDirectory(const std::string& path, std::vector<std::string>* names) {
+#if defined(_WIN32)
+  WIN32_FIND_DATAA entry;
+  HANDLE find = FindFirstFileA((path + "\\*").c_str(), &entry);
+  if (find == INVALID_HANDLE_VALUE) return false;
+  do {
+    if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+      names->push_back(entry.cFileName);
+    }
+  } while (FindNextFileA(find, &entry));
+  FindClose(find);
+#else
+  DIR* dir = opendir(path.c_str());
+  if (!dir) return false;
+  while (struct dirent* entry = readdir(dir)) {
+    bool is_directory = false;
+    const std::string name = entry->d_name;
+    if (IsDirectory(path + "/" + name, &is_directory) && !is_directory) {
+      names->push_back(name);
+    }
+  }
+  closedir(dir);
+#endif
+  return true;
+}
+
+}  // namespace
+
+bool ExpandBatchInputs(const std::vector<std::string>& paths,
+                       const std::string& suffix,
+                       std::vector<std::string>* files) {
+  for (const std::string& path : paths) {
+    bool is_directory = false;
+    if (!IsDirectory(path, &is_directory)) {
+      fprintf(stderr, "error: file does not exist '%s'\n", path.c_str());
+      return false;
+    }
+    if (!is_directory) {
+      files->push_back(path);
+      continue;
+    }
+
+    std::vector<std::string> names;
+    if (!ListDirectory(path, &names)) {
+      fprintf(stderr, "error: could not read directory '%s'\n", path.c_str());
+      return false;
+    }
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names) {
+      if (EndsWith(name, suffix)) files->push_back(path + "/" + name);
+    }
+  }
+  return true;
+}
+
+std::string BaseName(const std::string& path) {
+  const size_t separator = path.find_last_of("/\\");
+  return separator == std::string::npos ? path : path.substr(separator + 1);
+}
+
+MessageConsumer CaptureCLIMessages(const std::string& file,
+                                   std::string* messages) {
+  return [file, messages](spv_message_level_t level, const char*,
+                          const spv_position_t& position,
+                          const char* message) {
+    const char* prefix = nullptr;
+    switch (level) {
+      case SPV_MSG_FATAL:
+      case SPV_MSG_INTERNAL_ERROR:
+      case SPV_MSG_ERROR:
+        prefix = "error";
+        break;
+      case SPV_MSG_WARNING:
+        prefix = "warning";
+        break;
+      case SPV_MSG_INFO:
+        prefix = "info";
+        break;
+      default:
+        return;
+    }
+    std::ostringstream line;
+    line << file << ": " << prefix << ": line " << position.index << ": "
+         << message << "\n";
+    messages->append(line.str());
+  };
+}
+
+size_t ProcessBatch(const char* tool, const std::vector<std::string>& files,
+                    uint32_t num_threads, const BatchFileProcessor& process) {
+  // Each file writes only its own element, so only the output is locked.
+  std::vector<char> succeeded(files.size(), 0);
+  std::mutex output_mutex;
+  std::atomic<size_t> next_file(0);
+  auto process_files = [&]() {
+    for (size_t i = next_file++; i < files.size(); i = next_file++) {
+      std::string messages;
+      succeeded[i] = process(files[i], &messages);
+      if (!messages.empty()) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        fputs(messages.c_str(), stderr);
+      }
+    }
+  };
+
+  const size_t num_workers =
+      std::min<size_t>(std::max(num_threads, 1u), files.size());
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; ++i) workers.emplace_back(process_files);
+  process_files();
+  for (std::thread& worker : workers) worker.join();
+
+  const size_t num_failed =
+      static_cast<size_t>(std::count(succeeded.begin(), succeeded.end(), 0));
+  fprintf(stderr, "%s: %zu of %zu files failed\n", tool, num_failed,
+          files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!succeeded[i]) fprintf(stderr, "  %s\n", files[i].c_str());
+  }
+  return num_failed;
+}
+
+}  // namespace utils
+}  // namespace spvtools
@@ -0,0 +1,63 @@
+// Copyright (c) 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TOOLS_UTIL_BATCH_H_
+#define TOOLS_UTIL_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvtools {
+namespace utils {
+
+// Appends to |files| the files named by |paths|.  A path that names a
+// directory stands for the files of that directory whose names end in
+// |suffix|, in the order of their names; subdirectories are not searched.
+// Returns false and writes an error to standard error if a path cannot be
+// read.
+bool ExpandBatchInputs(const std::vector<std::string>& paths,
+                       const std::string& suffix,
+                       std::vector<std::string>* files);
+
+// Returns the part of |path| after its last directory separator.
+std::string BaseName(const std::string& path);
+
+// Returns a message consumer that appends the messages it receives to
+// |messages|, in the format of CLIMessageConsumer preceded by |file|.
+MessageConsumer CaptureCLIMessages(const std::string& file,
+                                   std::string* messages);
+
+// Processes one file of a batch: returns whether it succeeded, and appends
+// the messages to show for it to |messages|.  Called from several threads at
+// the same time.
+using BatchFileProcessor =
+    std::function<bool(const std::string& file, std::string* messages)>;
+
+// Calls |process| on each of |files|, on up to |num_threads| threads.  The
+// messages of a file are written to standard error as one block when it is
+// done, and are followed, once all files are done, by the number and the
+// names of the files that failed, preceded by |tool|.  Returns the number of
+// files that failed.
+size_t ProcessBatch(const char* tool, const std::vector<std::string>& files,
+                    uint32_t num_threads, const BatchFileProcessor& process);
+
+}  // namespace utils
+}  // namespace spvtools
+
+#endif  // TOOLS_UTIL_BATCH_H_
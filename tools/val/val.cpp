@@ -14,30 +14,103 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "source/spirv_target_env.h"
 #include "source/spirv_validator_options.h"
+#include "source/table.h"
 #include "spirv-tools/libspirv.hpp"
 #include "tools/io.h"
+#include "tools/util/batch.h"
 #include "tools/util/cli_consumer.h"
 
+// Records the keys of the valid modules as empty files in a directory.
+class DirectoryCacheBackend : public spvtools::ValidationCache::Backend {
+ public:
+  explicit DirectoryCacheBackend(const char* directory)
+      : directory_(directory) {}
+
+  bool Contains(const std::string& key) override {
+    FILE* file = fopen(Path(key).c_str(), "rb");
+    if (!file) return false;
+    fclose(file);
+    return true;
+  }
+
+  void Insert(const std::string& key) override {
+    if (FILE* file = fopen(Path(key).c_str(), "wb")) fclose(file);
+  }
+
+ private:
+  std::string Path(const std::string& key) const {
+    return directory_ + "/" + key;
+  }
+
+  const std::string directory_;
+};
+
+// Where the validation stages are reported.
+struct StageReports {
+  // Whether to print each stage to standard error output.
+  bool print = false;
+  // The stream to write the Chrome trace of the stages to, if any.
+  std::ofstream* trace = nullptr;
+  // The number of stages reported so far, and the sum of their wall times in
+  // seconds.
+  size_t num_stages = 0;
+  double elapsed = 0;
+};
+
+// Prints the wall time and the number of instructions of a validation stage to
+// standard error output, and appends an event for it to the trace.  The
+// stages run one after the other, so each trace event starts where the
+// previous one ended.
+void ReportStage(void* user_data, const char* stage, double seconds,
+                 size_t num_instructions) {
+  StageReports* reports = static_cast<StageReports*>(user_data);
+  if (reports->print) {
+    fprintf(stderr, "%-24s %12.6f %12zu\n", stage, seconds, num_instructions);
+  }
+  if (reports->trace) {
+    *reports->trace << (reports->num_stages ? "," : "") << "\n    {\"name\": \""
+                    << stage << "\", \"cat\": \"validation\", \"ph\": \"X\""
+                    << ", \"ts\": " << reports->elapsed * 1e6
+                    << ", \"dur\": " << seconds * 1e6
+                    << ", \"pid\": 0, \"tid\": 0"
+                    << ", \"args\": {\"instructions\": " << num_instructions
+                    << "}}";
+    ++reports->num_stages;
+    reports->elapsed += seconds;
+  }
+}
+
 void print_usage(char* argv0) {
   std::string target_env_list = spvTargetEnvList(36, 105);
   printf(
       R"(%s - Validate a SPIR-V binary file.
 
 USAGE: %s [options] [<filename>]
+       %s [options] --batch [-j <n>] <path> ...
 
 The SPIR-V binary is read from <filename>. If no file is specified,
 or if the filename is "-", then the binary is read from standard input.
 
+With --batch, each <path> is a file to validate or a directory whose files
+ending in ".spv" are validated.  The messages of each file are preceded by
+its name, and the files that failed are listed at the end.
+
 NOTE: The validator is a work in progress.
 
 Options:
   -h, --help                       Print this help.
+  --batch                          Validate all the files given, see above.
+  -j <n>                           Validate up to <n> files of --batch at the same time.
   --max-struct-members             <maximum number of structure members allowed>
   --max-struct-depth               <maximum allowed nesting depth of structures>
   --max-local-variables            <maximum number of local variables allowed>
@@ -47,6 +120,9 @@ Options:
   --max-control-flow-nesting-depth <maximum Control Flow nesting depth allowed>
   --max-access-chain-indexes       <maximum number of indexes allowed to use for Access Chain instructions>
   --max-id-bound                   <maximum value for the id bound>
+  --max-instructions               <maximum number of instructions of the module>
+  --max-function-blocks            <maximum number of blocks of a function>
+  --max-memory-kib                 <maximum estimated memory for validating the module, in KiB>
   --relax-logical-pointer          Allow allocating an object of a pointer type and returning
                                    a pointer value from a function in logical addressing mode
   --relax-block-layout             Enable VK_KHR_relaxed_block_layout when checking standard
@@ -65,15 +141,32 @@ Options:
                                    members.
   --before-hlsl-legalization       Allows code patterns that are intended to be
                                    fixed by spirv-opt's legalization passes.
+  --num-threads=<n>                Check the function bodies on up to <n> threads.
+                                   The diagnostics are the same as with one thread.
+  --profile=<name>                 Run the checks of the named profile: "full", the
+                                   default, or "structural", which only checks what
+                                   is needed to safely process the module.
+  --time-report                    Print the wall time and the number of instructions of
+                                   each validation stage to standard error output.
+  --trace=<file>                   Write the validation stages to <file> in the Chrome trace
+                                   event format, for viewing in chrome://tracing or Perfetto.
+  --validation-cache=<dir>         Remember the valid modules in the existing directory
+                                   <dir>, and skip validating them again with the same
+                                   target environment and options.
   --version                        Display validator version information.
   --target-env                     {%s}
                                    Use validation rules from the specified environment.
 )",
-      argv0, argv0, target_env_list.c_str());
+      argv0, argv0, argv0, target_env_list.c_str());
 }
 
 int main(int argc, char** argv) {
-  const char* inFile = nullptr;
+  std::vector<std::string> inputs;
+  const char* cache_directory = nullptr;
+  const char* trace_file = nullptr;
+  bool time_report = false;
+  bool batch = false;
+  uint32_t num_jobs = 1;
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_5;
   spvtools::ValidatorOptions options;
   bool continue_processing = true;
@@ -153,28 +246,57 @@ int main(int argc, char** argv) {
         options.SetSkipBlockLayout(true);
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         options.SetRelaxStructStore(true);
-      } else if (0 == cur_arg[1]) {
-        // Setting a filename of "-" to indicate stdin.
-        if (!inFile) {
-          inFile = cur_arg;
+      } else if (0 == strncmp(cur_arg, "--num-threads=",
+                              sizeof("--num-threads=") - 1)) {
+        const int threads = atoi(cur_arg + sizeof("--num-threads=") - 1);
+        if (threads < 1) {
+          fprintf(stderr, "error: Invalid number of threads '%s'\n", cur_arg);
+          continue_processing = false;
+          return_code = 1;
         } else {
-          fprintf(stderr, "error: More than one input file specified\n");
+          options.SetNumThreads(static_cast<uint32_t>(threads));
+        }
+      } else if (0 == strncmp(cur_arg, "--profile=",
+                              sizeof("--profile=") - 1)) {
+        spv_validator_profile profile;
+        if (spvParseValidatorProfile(cur_arg + sizeof("--profile=") - 1,
+                                     &profile)) {
+          options.SetProfile(profile);
+        } else {
+          fprintf(stderr, "error: Unknown validator profile '%s'\n", cur_arg);
           continue_processing = false;
           return_code = 1;
         }
+      } else if (0 == strcmp(cur_arg, "--time-report")) {
+        time_report = true;
+      } else if (0 == strncmp(cur_arg, "--trace=", sizeof("--trace=") - 1)) {
+        trace_file = cur_arg + sizeof("--trace=") - 1;
+      } else if (0 == strncmp(cur_arg, "--validation-cache=",
+                              sizeof("--validation-cache=") - 1)) {
+        cache_directory = cur_arg + sizeof("--validation-cache=") - 1;
+      } else if (0 == strcmp(cur_arg, "--batch")) {
+        batch = true;
+      } else if (0 == strncmp(cur_arg, "-j", 2)) {
+        const char* jobs = cur_arg[2] ? cur_arg + 2 : nullptr;
+        if (!jobs && argi + 1 < argc) jobs = argv[++argi];
+        const int num = jobs ? atoi(jobs) : 0;
+        if (num < 1) {
+          fprintf(stderr, "error: Invalid number of jobs for -j\n");
+          continue_processing = false;
+          return_code = 1;
+        } else {
+          num_jobs = static_cast<uint32_t>(num);
+        }
+      } else if (0 == cur_arg[1]) {
+        // Setting a filename of "-" to indicate stdin.
+        inputs.push_back(cur_arg);
       } else {
         print_usage(argv[0]);
         continue_processing = false;
         return_code = 1;
       }
     } else {
-      if (!inFile) {
-        inFile = cur_arg;
-      } else {
-        fprintf(stderr, "error: More than one input file specified\n");
-        continue_processing = false;
-        return_code = 1;
-      }
+      inputs.push_back(cur_arg);
     }
   }
 
@@ -183,13 +305,78 @@ int main(int argc, char** argv) {
     return return_code;
   }
 
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  if (!batch && inputs.size() > 1) {
+    fprintf(stderr, "error: More than one input file specified\n");
+    return 1;
+  }
+
+  // Only the module being validated needs to be kept in memory.
+  spvtools::ValidationCache cache(1);
+  std::unique_ptr<DirectoryCacheBackend> cache_backend;
+  if (cache_directory) {
+    cache_backend.reset(new DirectoryCacheBackend(cache_directory));
+    cache.SetBackend(cache_backend.get());
+    options.SetCache(cache);
+  }
+
+  StageReports stage_reports;
+  std::ofstream trace;
+  if (time_report) {
+    fprintf(stderr, "%-24s %12s %12s\n", "stage", "wall time(s)",
+            "instructions");
+    stage_reports.print = true;
+  }
+  if (trace_file) {
+    if (batch) {
+      fprintf(stderr, "error: --trace cannot be used with --batch\n");
+      return 1;
+    }
+    trace.open(trace_file);
+    if (!trace) {
+      fprintf(stderr, "error: Could not open trace file %s\n", trace_file);
+      return 1;
+    }
+    trace << "{\"traceEvents\": [";
+    stage_reports.trace = &trace;
+  }
+  if (time_report || trace_file) {
+    options.SetStageReport(ReportStage, &stage_reports);
+  }
+
+  if (batch) {
+    std::vector<std::string> files;
+    if (!spvtools::utils::ExpandBatchInputs(inputs, ".spv", &files)) return 1;
+
+    // The files share one context, each with a copy that reports to the
+    // consumer of the file.
+    spv_context context = spvContextCreate(target_env);
+    const size_t num_failed = spvtools::utils::ProcessBatch(
+        "spirv-val", files, num_jobs,
+        [context, &options](const std::string& file, std::string* messages) {
+          InputFile<uint32_t> contents;
+          if (!contents.Open(file.c_str())) return false;
+          spv_context_t file_context = *context;
+          file_context.consumer =
+              spvtools::utils::CaptureCLIMessages(file, messages);
+          spv_const_binary_t binary = {contents.data(), contents.size()};
+          return spvValidateWithOptions(&file_context, options, &binary,
+                                        nullptr) == SPV_SUCCESS;
+        });
+    spvContextDestroy(context);
+    return num_failed != 0;
+  }
+
+  InputFile<uint32_t> contents;
+  if (!contents.Open(inputs.empty() ? nullptr : inputs[0].c_str())) return 1;
 
   spvtools::SpirvTools tools(target_env);
   tools.SetMessageConsumer(spvtools::utils::CLIMessageConsumer);
 
   bool succeed = tools.Validate(contents.data(), contents.size(), options);
 
+  if (trace_file) {
+    trace << "\n]}" << std::endl;
+  }
+
   return !succeed;
 }